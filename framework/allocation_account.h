@@ -0,0 +1,121 @@
+﻿/*
+* Copyright [2025] [Yue Liu]
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/**
+ * @file allocation_account.h
+ * @brief [框架内部] 按插件的内存 / CPU 记账：z3y::AllocationAccount 与 z3y::internal::AccountingAllocator。
+ * @author Yue Liu
+ * @date 2025
+ *
+ * @details
+ * [受众：框架维护者]
+ *
+ * 启用 `PluginManagerOptions::enable_memory_accounting` 后，管理器为每个插件建立一个账户，
+ * 并在调用该插件的工厂与 `Initialize()` 期间把它设为当前线程的 *记账作用域*：
+ * - `internal::MakeComponent` 发现作用域非空时改用 `std::allocate_shared` + `AccountingAllocator`，
+ * 对象与控制块的字节数记入账户，对象释放时再扣除 (账户由分配器共享持有，插件卸载后仍有效)。
+ * - 作用域内建立的订阅 (通常在 `Initialize()` 中) 记入同一账户。
+ * - 作用域内获取的分级内存池资源 (`IAllocatorService::GetPoolResource`) 把之后经由它的分配记入同一账户。
+ *
+ * 未启用时作用域始终为空，`MakeComponent` 只多一次函数调用。
+ * 插件内部自行 `new` 的内存不在统计范围内。
+ *
+ * 启用 `PluginManagerOptions::enable_cpu_accounting` 后，同一账户还累计线程 CPU 时间：
+ * - 记入该账户的订阅，其每次回调消耗的 CPU 时间 (无论在哪个线程上执行)。
+ * - 插件组件的 `Initialize()` / `Shutdown()` 消耗的 CPU 时间。
+ * 宿主直接调用服务方法不经过框架，无法归属。
+ */
+
+#pragma once
+
+#ifndef Z3Y_FRAMEWORK_ALLOCATION_ACCOUNT_H_
+#define Z3Y_FRAMEWORK_ALLOCATION_ACCOUNT_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include "framework/z3y_framework_api.h"
+
+namespace z3y {
+
+    /**
+     * @struct AllocationAccount
+     * @brief 一个插件的内存账户。只做计数，不持有内存。
+     */
+    struct AllocationAccount {
+        std::atomic<int64_t> component_bytes{ 0 };     //!< 存活组件实例 (含 shared_ptr 控制块) 的字节数
+        std::atomic<int64_t> component_count{ 0 };     //!< 存活组件实例数
+        std::atomic<int64_t> subscription_bytes{ 0 };  //!< 存活订阅条目的字节数
+        std::atomic<int64_t> subscription_count{ 0 };  //!< 存活订阅数
+        std::atomic<int64_t> pool_bytes{ 0 };          //!< 从插件的分级内存池视图借出的字节数 (`IAllocatorService`)
+        std::atomic<int64_t> pool_allocations{ 0 };    //!< 累计从该视图分配的次数
+
+        bool cpu_accounting = false;                   //!< 是否累计 CPU 时间 (建立账户时确定，之后只读)
+        std::atomic<uint64_t> callback_cpu_ns{ 0 };    //!< 累计回调 CPU 时间
+        std::atomic<uint64_t> callback_calls{ 0 };     //!< 累计回调次数
+        std::atomic<uint64_t> lifecycle_cpu_ns{ 0 };   //!< 累计 Initialize / Shutdown CPU 时间
+        std::atomic<uint64_t> lifecycle_calls{ 0 };    //!< 累计 Initialize / Shutdown 次数
+    };
+
+    namespace internal {
+        /**
+         * @brief [内部] 当前线程的记账作用域 (由管理器在调用工厂 / Initialize 期间设置)。
+         * @return 未启用记账或不在作用域内时为空。
+         */
+        Z3Y_FRAMEWORK_API std::shared_ptr<AllocationAccount> CurrentAllocationAccount() noexcept;
+
+        /**
+         * @class AccountingAllocator
+         * @brief 把分配的字节数记入账户的分配器 (供 `std::allocate_shared` 使用)。
+         */
+        template <typename T>
+        class AccountingAllocator {
+        public:
+            using value_type = T;
+
+            explicit AccountingAllocator(std::shared_ptr<AllocationAccount> account) noexcept
+                : account_(std::move(account)) {}
+            template <typename U>
+            AccountingAllocator(const AccountingAllocator<U>& other) noexcept : account_(other.account_) {}
+
+            T* allocate(size_t n) {
+                T* p = std::allocator<T>().allocate(n);
+                account_->component_bytes.fetch_add(static_cast<int64_t>(n * sizeof(T)), std::memory_order_relaxed);
+                account_->component_count.fetch_add(1, std::memory_order_relaxed);
+                return p;
+            }
+
+            void deallocate(T* p, size_t n) noexcept {
+                account_->component_bytes.fetch_sub(static_cast<int64_t>(n * sizeof(T)), std::memory_order_relaxed);
+                account_->component_count.fetch_sub(1, std::memory_order_relaxed);
+                std::allocator<T>().deallocate(p, n);
+            }
+
+            template <typename U>
+            bool operator==(const AccountingAllocator<U>& other) const noexcept { return account_ == other.account_; }
+            template <typename U>
+            bool operator!=(const AccountingAllocator<U>& other) const noexcept { return account_ != other.account_; }
+
+        private:
+            template <typename U> friend class AccountingAllocator;
+            std::shared_ptr<AllocationAccount> account_;
+        };
+    }  // namespace internal
+
+}  // namespace z3y
+
+#endif  // Z3Y_FRAMEWORK_ALLOCATION_ACCOUNT_H_
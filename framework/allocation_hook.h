@@ -0,0 +1,67 @@
+﻿/*
+* Copyright [2025] [Yue Liu]
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/**
+ * @file allocation_hook.h
+ * @brief 全局堆分配钩子：`operator new` 替换层 (z3y_alloc_interposer) 与分析器之间的汇合点。
+ * @author Yue Liu
+ * @date 2025
+ *
+ * @details
+ * [受众：宿主开发者 和 分析工具开发者]
+ *
+ * 框架本身不替换 `operator new`。宿主把可选目标 `z3y_alloc_interposer` 链接进可执行文件后，
+ * 进程内的每次 `operator new` 都调用一次 `ReportAllocation(bytes)`；没有安装钩子时只多一次原子读。
+ * Profiler 插件的 `System.Profiler.AllocationTracking` 开关安装钩子，把分配计入当前作用域的节点。
+ *
+ * \code{.cmake}
+ * target_link_libraries(my_host PRIVATE z3y_plugin_manager z3y_alloc_interposer)
+ * \endcode
+ *
+ * [约定]
+ * - 钩子在分配路径上同步执行，不得抛出异常；钩子内部再次分配不会递归上报。
+ * - Linux / macOS 上替换对整个进程生效 (含动态加载的插件)；Windows 上每个 DLL 自带
+ *   `operator new`，替换只覆盖链接了它的可执行文件本身。
+ */
+
+#pragma once
+
+#ifndef Z3Y_FRAMEWORK_ALLOCATION_HOOK_H_
+#define Z3Y_FRAMEWORK_ALLOCATION_HOOK_H_
+
+#include <cstddef>  // 用于 size_t
+#include "framework/z3y_framework_api.h"
+
+namespace z3y {
+
+    /** @brief 堆分配钩子。可在任意线程上并发调用。 */
+    using AllocationHook = void (*)(size_t bytes, void* context);
+
+    /**
+     * @brief 安装 (或以 nullptr 卸下) 全局堆分配钩子。
+     * @details 返回前等待进行中的旧钩子调用全部结束，之后不会再有调用进入旧的 `context`。
+     */
+    Z3Y_FRAMEWORK_API void SetAllocationHook(AllocationHook hook, void* context);
+
+    /** @brief 当前是否安装了堆分配钩子。 */
+    Z3Y_FRAMEWORK_API bool IsAllocationHookInstalled() noexcept;
+
+    /** @brief 把一次分配交给当前钩子 (由 z3y_alloc_interposer 调用)；没有钩子时什么都不做。 */
+    Z3Y_FRAMEWORK_API void ReportAllocation(size_t bytes) noexcept;
+
+}  // namespace z3y
+
+#endif  // Z3Y_FRAMEWORK_ALLOCATION_HOOK_H_
@@ -54,6 +54,19 @@
  *
  * [优点]
  * 插件开发者无需编写 `z3yPluginInit` 函数。他们只需要在实现类的 `.cpp` 文件顶部添加一个宏即可。
+ *
+ * [声明式事件处理函数 (Z3Y_EVENT_HANDLER)]
+ * 与组件同生命周期的订阅不必在 `Initialize()` 中逐个 `SubscribeGlobal`：
+ * 每个 `Z3Y_EVENT_HANDLER` 生成一条 `static constexpr EventHandlerEntry` 和一个注册任务，
+ * 入口函数把同一个类的条目并入它的注册，形成该类的处理函数表。
+ * 管理器在每个实例 `Initialize()` 之后按表一次性订阅 (每个 EventId 只复制一次订阅列表)，
+ * 并通过 `ComponentDetails::event_handlers` 公开。
+ *
+ * [静态链接模式 (Z3Y_STATIC_PLUGINS)]
+ * 所有插件位于同一个映像中，不能再依赖“每个 DSO 一份”的列表与同名的 `z3yPluginInit`：
+ * - 注册列表与入口函数都按 `Z3Y_STATIC_PLUGIN_NAME` (由 `z3y_add_plugin()` 传入) 命名。
+ * - `AutoRegistrar` 是侵入式链表节点，只保存一个函数指针，构造时挂到本插件的链表尾部 (无堆分配)。
+ * 宿主的用法见 `static_plugin.h`。
  */
 
 #pragma once
@@ -61,17 +74,60 @@
 #ifndef Z3Y_FRAMEWORK_AUTO_REGISTRATION_H_
 #define Z3Y_FRAMEWORK_AUTO_REGISTRATION_H_
 
+#include <algorithm>   // 用于 std::stable_sort
 #include <functional>  // 用于 std::function, std::move
 #include <memory>      // 用于 std::shared_ptr
 #include <type_traits> // 用于 std::move
+#include <utility>     // 用于 std::pair
 #include <vector>      // 用于 std::vector
 #include "framework/i_plugin_registry.h"  // 依赖 IPluginRegistry
 #include "framework/plugin_registration.h"  // 依赖 RegisterComponent
+#include "framework/static_plugin.h"  // 依赖 Z3Y_STATIC_PLUGIN_INIT
 
 namespace z3y {
     namespace internal {
         // [受众：框架维护者]
 
+#if defined(Z3Y_STATIC_PLUGINS)
+#ifndef Z3Y_STATIC_PLUGIN_NAME
+        // 未通过 z3y_add_plugin() 构建的目标 (例如宿主自身) 共用这个名字
+#define Z3Y_STATIC_PLUGIN_NAME z3y_unnamed_plugin
+#endif
+        struct AutoRegistrar;
+
+        /** @brief [内部] 一个插件的注册链表。常量初始化，先于任何 AutoRegistrar 的构造可用。 */
+        struct StaticRegisterList {
+            const AutoRegistrar* head = nullptr;
+            const AutoRegistrar** tail = &head;
+        };
+
+        /** @brief [内部] 本插件的注册链表访问函数名 (按插件名区分)。 */
+#define Z3Y_STATIC_REGISTER_LIST Z3Y_STATIC_CONCAT(GetStaticRegisterList_, Z3Y_STATIC_PLUGIN_NAME)
+
+        inline StaticRegisterList& Z3Y_STATIC_REGISTER_LIST() {
+            static StaticRegisterList list;
+            return list;
+        }
+
+        /**
+         * @brief [内部] 自动注册辅助结构体 (静态链接模式)：本身就是链表节点。
+         * @details 注册宏传入的是无捕获 lambda，隐式转换为函数指针。
+         */
+        struct AutoRegistrar {
+            using Func = void (*)(IPluginRegistry*);
+
+            AutoRegistrar(Func f) : func(f) {
+                StaticRegisterList& list = Z3Y_STATIC_REGISTER_LIST();
+                *list.tail = this;
+                list.tail = &next;
+            }
+            AutoRegistrar(const AutoRegistrar&) = delete;
+            AutoRegistrar& operator=(const AutoRegistrar&) = delete;
+
+            const Func func;
+            const AutoRegistrar* next = nullptr;
+        };
+#else
         // (类型别名，用于存储“注册任务”的函数)
         using RegistryFunc = std::function<void(IPluginRegistry*)>;
 
@@ -82,8 +138,16 @@ namespace z3y {
          * 使用“Meyers Singleton” (静态局部变量)，
          * 保证线程安全和初始化顺序。
          *
+         * [POSIX 注意]
+         * 该列表必须是 *每个 DSO 一份*。在 ELF 平台上 inline 函数的静态局部变量
+         * 默认全局可见，会被宿主或其他已加载的模块“符号合并”，
+         * 导致插件之间共享同一个列表 (重复注册)。因此这里显式标记为 hidden。
+         *
          * @return `std::vector<RegistryFunc>` 的引用。
          */
+#if defined(__GNUC__) && !defined(_WIN32)
+        __attribute__((visibility("hidden")))
+#endif
         inline std::vector<RegistryFunc>& GetGlobalRegisterList() {
             static std::vector<RegistryFunc> g_list;
             return g_list;
@@ -100,6 +164,65 @@ namespace z3y {
                 GetGlobalRegisterList().push_back(std::move(func));
             }
         };
+#endif
+
+        /**
+         * @brief [内部] 收集注册任务产生的全部注册，再通过一次 `RegisterComponents` 提交。
+         *
+         * [设计思想]
+         * 注册任务仍然面向 `IPluginRegistry*` 编写 (调用 `z3y::RegisterComponent` 等)，
+         * 入口函数把这个收集器交给它们，从而在不改变任务写法的前提下合并成一批。
+         */
+        class BatchingRegistry : public IPluginRegistry {
+        public:
+            void RegisterComponent(ClassId clsid, FactoryFunction factory, bool is_singleton,
+                const std::string& alias, InterfaceDescriptorSpan implemented_interfaces,
+                bool is_default) override {
+                batch_.push_back({ clsid, std::move(factory), is_singleton, alias,
+                    implemented_interfaces, is_default, false });
+            }
+
+            void RegisterPooledComponent(ClassId clsid, FactoryFunction factory, const std::string& alias,
+                InterfaceDescriptorSpan implemented_interfaces, bool is_default) override {
+                batch_.push_back({ clsid, std::move(factory), false, alias,
+                    implemented_interfaces, is_default, true });
+            }
+
+            void RegisterComponents(std::vector<ComponentRegistration> registrations) override {
+                for (auto& reg : registrations) batch_.push_back(std::move(reg));
+            }
+
+            void RegisterEventHandler(ClassId clsid, const EventHandlerEntry& handler) override {
+                handlers_.emplace_back(clsid, handler);
+            }
+
+            /**
+             * @brief 把收集到的注册一次性提交给 `target`。
+             * @details 事件处理函数并入同一批中对应类的注册 (注册任务的先后顺序不限)；
+             * 本批中没有对应注册的，在整批提交之后逐条转给 `target`。
+             */
+            void CommitTo(IPluginRegistry* target) {
+                std::vector<std::pair<ClassId, EventHandlerEntry>> orphans;
+                for (const auto& [clsid, handler] : handlers_) {
+                    auto it = std::find_if(batch_.begin(), batch_.end(),
+                        [clsid = clsid](const ComponentRegistration& reg) { return reg.clsid == clsid; });
+                    if (it != batch_.end()) it->event_handlers.push_back(handler);
+                    else orphans.emplace_back(clsid, handler);
+                }
+                for (auto& reg : batch_) {
+                    std::stable_sort(reg.event_handlers.begin(), reg.event_handlers.end(),
+                        [](const EventHandlerEntry& a, const EventHandlerEntry& b) { return a.event_id < b.event_id; });
+                }
+                if (!batch_.empty()) target->RegisterComponents(std::move(batch_));
+                for (const auto& [clsid, handler] : orphans) target->RegisterEventHandler(clsid, handler);
+                batch_.clear();
+                handlers_.clear();
+            }
+
+        private:
+            std::vector<ComponentRegistration> batch_;
+            std::vector<std::pair<ClassId, EventHandlerEntry>> handlers_;
+        };
 
         /**
          * @def Z3Y_AUTO_CONCAT_INNER(a, b)
@@ -146,11 +269,33 @@ namespace z3y {
   static z3y::internal::AutoRegistrar Z3Y_AUTO_CONCAT(                  \
       s_auto_reg_at_line_,                                              \
       __LINE__)( /* [受众：框架维护者] 创建一个唯一的静态变量名 */ \
-                 [=](z3y::IPluginRegistry* r) {                         \
+                 [](z3y::IPluginRegistry* r) {                          \
                    /* [受众：框架维护者] 任务 lambda：调用模板辅助函数 */ \
                    z3y::RegisterComponent<ClassName>(r, Alias, IsDefault); \
                  });
 
+     /**
+      * @def Z3Y_AUTO_REGISTER_POOLED_COMPONENT
+      * @brief [插件开发者核心] 自动注册一个池化的瞬态组件。
+      *
+      * [受众：插件开发者 (实现插件)]
+      *
+      * 与 `Z3Y_AUTO_REGISTER_COMPONENT` 相同，但释放的实例不会被析构，而是回到池中供下次
+      * `z3y::CreateInstance` 复用。`Initialize()` 只在首次构造时调用；
+      * 实现类可以提供 `void OnRecycle()` 在回池前重置自身状态。
+      *
+      * @param ClassName    要注册的类名。
+      * @param Alias        注册的别名。
+      * @param IsDefault    是否为默认实现 (`true` 或 `false`)。
+      * @param MaxIdle      池中最多保留的空闲实例数。
+      */
+#define Z3Y_AUTO_REGISTER_POOLED_COMPONENT(ClassName, Alias, IsDefault, MaxIdle) \
+  static z3y::internal::AutoRegistrar Z3Y_AUTO_CONCAT(                  \
+      s_auto_reg_at_line_,                                              \
+      __LINE__)([](z3y::IPluginRegistry* r) {                           \
+                   z3y::RegisterPooledComponent<ClassName>(r, Alias, IsDefault, MaxIdle); \
+                 });
+
      /**
       * @def Z3Y_AUTO_REGISTER_SERVICE
       * @brief [插件开发者核心] 自动注册一个单例服务 (Service)。
@@ -183,11 +328,48 @@ namespace z3y {
   static z3y::internal::AutoRegistrar Z3Y_AUTO_CONCAT(                  \
       s_auto_reg_at_line_,                                              \
       __LINE__)( /* [受众：框架维护者] 创建一个唯一的静态变量名 */ \
-                 [=](z3y::IPluginRegistry* r) {                         \
+                 [](z3y::IPluginRegistry* r) {                          \
                    /* [受众：框架维护者] 任务 lambda：调用模板辅助函数 */ \
                    z3y::RegisterService<ClassName>(r, Alias, IsDefault); \
                  });
 
+       /**
+        * @def Z3Y_EVENT_HANDLER
+        * @brief [插件开发者核心] 声明一个与组件实例同生命周期的全局事件处理函数。
+        *
+        * [受众：插件开发者 (实现插件)]
+        *
+        * 在实现类的 `.cpp` 文件的全局作用域使用，与 `Z3Y_AUTO_REGISTER_...` 并列 (先后不限)。
+        * 该类的每个实例在 `Initialize()` 返回后自动订阅 `EventType`，实例释放后订阅随之失效，
+        * 无需保存 `Connection`。等价于在 `Initialize()` 末尾调用
+        * `bus->SubscribeGlobal<EventType>(shared_from_this(), Method)` 且不保留连接。
+        *
+        * @param ClassName    实现类 (必须已用 `Z3Y_AUTO_REGISTER_...` 注册)。
+        * @param EventType    事件类型。
+        * @param Method       成员函数指针，签名为 `void (ClassName::*)(const EventType&)`。
+        *
+        * @example
+        * \code{.cpp}
+        * Z3Y_AUTO_REGISTER_SERVICE(z3y::demo::Station, "Demo.Station", true);
+        * Z3Y_EVENT_HANDLER(z3y::demo::Station, z3y::demo::FrameEvent, &z3y::demo::Station::OnFrame);
+        * \endcode
+        */
+#define Z3Y_EVENT_HANDLER(ClassName, EventType, Method) \
+  Z3Y_EVENT_HANDLER_EX(ClassName, EventType, Method, z3y::ConnectionType::kDirect)
+
+       /**
+        * @def Z3Y_EVENT_HANDLER_EX
+        * @brief [插件开发者核心] 同 `Z3Y_EVENT_HANDLER`，但指定连接类型 (例如 `kQueued`)。
+        */
+#define Z3Y_EVENT_HANDLER_EX(ClassName, EventType, Method, Type)          \
+  static z3y::internal::AutoRegistrar Z3Y_AUTO_CONCAT(                  \
+      s_auto_reg_at_line_,                                              \
+      __LINE__)([](z3y::IPluginRegistry* r) {                           \
+                   static constexpr z3y::EventHandlerEntry kEntry =     \
+                       z3y::internal::MakeEventHandler<ClassName, EventType, Method>(Type); \
+                   r->RegisterEventHandler(ClassName::kClsid, kEntry);  \
+                 });
+
       /**
        * @def Z3Y_DEFINE_PLUGIN_ENTRY
        * @brief [插件开发者核心]
@@ -202,7 +384,10 @@ namespace z3y {
        * [功能]
        * 此宏会为你生成 `z3yPluginInit` C 函数，宿主程序会调用此函数。
        * 该函数会遍历并执行所有由 `Z3Y_AUTO_REGISTER_...`
-       * 宏在本项目中注册的任务。
+       * 宏在本项目中注册的任务，并把它们产生的注册合并为一次 `RegisterComponents` 调用。
+       *
+       * 静态链接模式下生成的是 `z3yPluginInit_<Z3Y_STATIC_PLUGIN_NAME>`，由宿主经
+       * `Z3Y_IMPORT_STATIC_PLUGIN` / `PluginManager::LoadStaticPlugins` 调用。
        *
        * @example
        * \code{.cpp}
@@ -212,17 +397,34 @@ namespace z3y {
        * Z3Y_DEFINE_PLUGIN_ENTRY
        * \endcode
        */
+#if defined(Z3Y_STATIC_PLUGINS)
+#define Z3Y_DEFINE_PLUGIN_ENTRY                                               \
+  extern "C" void Z3Y_STATIC_PLUGIN_INIT(Z3Y_STATIC_PLUGIN_NAME)(z3y::IPluginRegistry* registry) \
+  {                                                                           \
+    if (!registry) {                                                          \
+      return;                                                                 \
+    }                                                                         \
+    z3y::internal::BatchingRegistry batch;                                    \
+    for (const auto* node = z3y::internal::Z3Y_STATIC_REGISTER_LIST().head; node; node = node->next) { \
+      node->func(&batch);                                                     \
+    }                                                                         \
+    batch.CommitTo(registry);                                                 \
+  }
+#else
 #define Z3Y_DEFINE_PLUGIN_ENTRY                                            \
   extern "C" Z3Y_PLUGIN_API void z3yPluginInit(z3y::IPluginRegistry* registry) \
   {                                                                           \
     if (!registry) {                                                          \
       return;                                                                 \
     }                                                                         \
-    /* [受众：框架维护者] 遍历全局列表并执行所有注册任务 */ \
+    /* [受众：框架维护者] 遍历全局列表并执行所有注册任务 (先收集，再整批提交) */ \
+    z3y::internal::BatchingRegistry batch;                                    \
     for (const auto& reg_func : z3y::internal::GetGlobalRegisterList()) {     \
-      reg_func(registry);                                                     \
+      reg_func(&batch);                                                       \
     }                                                                         \
+    batch.CommitTo(registry);                                                 \
   }
+#endif
 
 }  // namespace z3y
 
@@ -43,6 +43,8 @@
 #define Z3Y_FRAMEWORK_CLASS_ID_H_
 
 #include <cstdint>  // 用于 uint64_t, C++11
+#include <string>
+#include <string_view>
 
 namespace z3y {
 
@@ -102,6 +104,13 @@ namespace z3y {
                 : Fnv1aHashRt(str + 1,
                     (hash ^ static_cast<uint64_t>(*str)) * kFnvPrime);
         }
+
+        /** @brief [内部] 与 `Fnv1aHashRt` 结果相同的迭代版本，用于 `std::string_view` (不要求 '\0' 结尾)。 */
+        constexpr uint64_t Fnv1aHashView(std::string_view str) {
+            uint64_t hash = kFnvOffsetBasis;
+            for (char c : str) hash = (hash ^ static_cast<uint64_t>(c)) * kFnvPrime;
+            return hash;
+        }
     }  // namespace internal
 
     /**
@@ -124,6 +133,36 @@ namespace z3y {
             : internal::Fnv1aHashRt(str);
     }
 
+    /** @brief `ConstexprHash` 的 `std::string_view` 重载，结果与 C 字符串版本一致。 */
+    constexpr ClassId ConstexprHash(std::string_view str) {
+        return str.empty() ? 0 : internal::Fnv1aHashView(str);
+    }
+
+    /**
+     * @struct Alias
+     * @brief [受众：插件开发者] 组件别名的查找键：名字 + 预先计算好的哈希。
+     *
+     * @details
+     * 所有按别名查找的 API (`GetService<T>(alias)` 等) 都接受 `Alias`，
+     * 可以直接传入字符串字面量、`std::string` 或 `std::string_view`，查找过程 *不分配内存*。
+     * 对高频调用点，可以把别名声明为 `constexpr` 常量，哈希在编译期就已算好：
+     * \code{.cpp}
+     * static constexpr z3y::Alias kProfilerAlias{ "System.Profiler" };
+     * auto profiler = z3y::GetService<IProfilerService>(kProfilerAlias);
+     * \endcode
+     *
+     * @warning `Alias` 只引用 (不复制) 名字，不要让它比源字符串活得更久。
+     */
+    struct Alias {
+        std::string_view name;  //!< 别名文本
+        uint64_t hash;          //!< `ConstexprHash(name)`
+
+        constexpr Alias(const char* alias)
+            : name(alias ? std::string_view(alias) : std::string_view()), hash(ConstexprHash(name)) {}
+        constexpr Alias(std::string_view alias) : name(alias), hash(ConstexprHash(alias)) {}
+        Alias(const std::string& alias) : name(alias), hash(ConstexprHash(name)) {}
+    };
+
 }  // namespace z3y
 
 #endif  // Z3Y_FRAMEWORK_CLASS_ID_H_
\ No newline at end of file
@@ -0,0 +1,127 @@
+﻿/*
+* Copyright [2025] [Yue Liu]
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/**
+ * @file component_pool.h
+ * @brief [框架内部] 池化瞬态组件的对象池 z3y::ComponentPool。
+ * @author Yue Liu
+ * @date 2025
+ *
+ * @details
+ * [受众：框架维护者]
+ *
+ * 对于构造代价高、又被频繁 `CreateInstance` / 释放的组件 (例如缓冲区、解析器)，
+ * 每次都 `make_shared` + `Initialize()` + 析构是浪费的。
+ *
+ * `ComponentPool` 被注册为这类组件的工厂：
+ * - 取出时优先复用空闲对象，只有池空时才 `new` 并调用 *一次* `Initialize()`。
+ * - 返回的 `PluginPtr` 带有自定义删除器：最后一个引用释放时，对象不会被析构，
+ * 而是调用可选的 `OnRecycle()` 钩子 (重置状态) 后放回池中。
+ * - 池满 (`max_idle`)、`OnRecycle()` 抛出异常，或池本身已销毁 (插件已卸载) 时才真正删除对象。
+ *
+ * 注意：每次取出仍会分配一个新的 shared_ptr 控制块 (对象本身被复用)。
+ *
+ * @see z3y::RegisterPooledComponent, Z3Y_AUTO_REGISTER_POOLED_COMPONENT
+ */
+
+#pragma once
+
+#ifndef Z3Y_FRAMEWORK_COMPONENT_POOL_H_
+#define Z3Y_FRAMEWORK_COMPONENT_POOL_H_
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "framework/i_component.h"
+
+namespace z3y {
+    namespace internal {
+        /** @brief 检测 `T` 是否声明了 `void OnRecycle()`。 */
+        template <typename T, typename = void>
+        struct HasOnRecycle : std::false_type {};
+        template <typename T>
+        struct HasOnRecycle<T, std::void_t<decltype(std::declval<T&>().OnRecycle())>> : std::true_type {};
+    }  // namespace internal
+
+    /**
+     * @class ComponentPool
+     * @brief 单个 ClassId 的空闲对象池。线程安全。
+     * @tparam ImplClass 组件实现类。可选地提供 `void OnRecycle()`，在对象回池前被调用。
+     */
+    template <typename ImplClass>
+    class ComponentPool : public std::enable_shared_from_this<ComponentPool<ImplClass>> {
+    public:
+        /** @brief 默认最多保留的空闲对象数。 */
+        static constexpr size_t kDefaultMaxIdle = 64;
+
+        explicit ComponentPool(size_t max_idle = kDefaultMaxIdle) : max_idle_(max_idle) {}
+        ComponentPool(const ComponentPool&) = delete;
+        ComponentPool& operator=(const ComponentPool&) = delete;
+
+        /**
+         * @brief 取出一个已初始化的对象 (作为 `FactoryFunction` 使用)。
+         * @details 新建对象的 `Initialize()` 在这里调用，因此注册时框架会跳过它。
+         */
+        PluginPtr<IComponent> Acquire() {
+            std::unique_ptr<ImplClass> obj;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (!idle_.empty()) {
+                    obj = std::move(idle_.back());
+                    idle_.pop_back();
+                }
+            }
+            if (!obj) {
+                obj = std::make_unique<ImplClass>();
+                obj->Initialize();
+            }
+            std::weak_ptr<ComponentPool> weak_pool = this->shared_from_this();
+            return std::shared_ptr<ImplClass>(obj.release(), [weak_pool](ImplClass* p) {
+                if (auto pool = weak_pool.lock()) pool->Recycle(std::unique_ptr<ImplClass>(p));
+                else delete p;
+                });
+        }
+
+        /** @brief 当前空闲对象数。 */
+        [[nodiscard]] size_t IdleCount() const {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return idle_.size();
+        }
+
+    private:
+        void Recycle(std::unique_ptr<ImplClass> obj) {
+            if constexpr (internal::HasOnRecycle<ImplClass>::value) {
+                try {
+                    obj->OnRecycle();
+                } catch (...) {
+                    return;  // 状态无法重置，直接销毁
+                }
+            }
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (idle_.size() < max_idle_) idle_.push_back(std::move(obj));
+        }
+
+        const size_t max_idle_;
+        mutable std::mutex mutex_;
+        std::vector<std::unique_ptr<ImplClass>> idle_;
+    };
+
+}  // namespace z3y
+
+#endif  // Z3Y_FRAMEWORK_COMPONENT_POOL_H_
@@ -22,7 +22,7 @@
  *
  * @details
  * **文件作用：**
- * 此文件定义了 `Connection` 和 `ScopedConnection` 两个类。
+ * 此文件定义了 `Connection`、`ScopedConnection` 和 `EventConnectionGroup` 三个类。
  * 它们是用户与事件系统交互的凭证。当你订阅一个事件时，系统不会直接返回指针，
  * 而是返回一个 `Connection` 对象。你必须持有它，才能维持订阅，或者用它来取消订阅。
  *
@@ -35,6 +35,11 @@
  * 本文件中的 `Connection` 类实现了一种“原子票据”机制。
  * 只有持有有效票据的连接，回调才会被允许执行。断开连接等于“撕毁票据”，
  * 这是一个原子操作，瞬间对所有线程可见，从而彻底杜绝上述竞争条件。
+ *
+ * **内存布局：**
+ * 票据连同断开时需要的信息 (总线、订阅者、事件 ID、发送者) 放在框架池化的 *票据槽* 中，
+ * 由侵入式引用计数管理。`Connection` 本身只是一个指向槽的指针：订阅不再单独分配票据，
+ * 上万个连接的界面插件也只需为每个连接付出一个指针。
  */
 
 #pragma once
@@ -44,6 +49,9 @@
 
 #include <memory>       // 用于 std::shared_ptr, std::weak_ptr
 #include <atomic>       // 用于 std::atomic (核心线程安全机制)
+#include <cstddef>      // 用于 size_t
+#include <utility>      // 用于 std::move
+#include <vector>       // 用于 EventConnectionGroup
 #include "framework/class_id.h"
 #include "framework/z3y_framework_api.h"
 
@@ -57,6 +65,10 @@ namespace z3y {
 
     class IEventBus;
 
+    namespace internal {
+        struct ConnectionSlot;  // [内部] 池化的票据槽，定义在框架核心库内
+    }  // namespace internal
+
     /**
      * @class Connection
      * @brief 事件订阅的“句柄” (Handle)。代表一个活动的事件监听关系。
@@ -90,10 +102,11 @@ namespace z3y {
          *
          * **设计思想 (原子撕票)：**
          * 这是一个线程安全的操作。它会做两件事：
-         * 1. **逻辑断开**：将内部共享的 `active_token_` (原子布尔值) 设置为 false。
+         * 1. **逻辑断开**：将票据槽中与 EventBus 共享的原子票据设置为 false。
          * 这是一个极快原子操作。一旦执行，即使 EventBus 那个线程正好拿到了回调函数准备执行，
          * 它在执行前检查这个 Token 时也会失败，从而放弃执行。
-         * 2. **物理清理**：通知 EventBus 从内部的 `std::vector` 或 `std::map` 中移除这个记录，释放内存。
+         * 2. **物理清理**：通知 EventBus 登记一次惰性 GC (O(1))。
+         * 记录会在稍后的 GC 批处理中被移除，断开本身不复制、不扫描订阅列表。
          */
         void Disconnect();
 
@@ -124,51 +137,32 @@ namespace z3y {
          */
         Connection& operator=(Connection&& other) noexcept;
 
+        /**
+         * @brief 析构函数：放弃对票据槽的引用，但 **不会** 断开连接。
+         * @details 订阅继续有效，直到订阅者销毁或调用 `Unsubscribe`。需要自动断开请使用 `ScopedConnection`。
+         */
+        ~Connection();
+
     private:
         // 友元声明：只允许 EventBus 和 PluginManager 创建有效的 Connection
         friend class IEventBus;
         friend class PluginManager;
+        friend class EventConnectionGroup;
 
         /**
          * @brief 私有构造函数 (用户无法调用)。
-         *
-         * @param bus 事件总线的弱引用 (防止 Connection 反向持有 Bus 导致循环引用)。
-         * @param subscriber 订阅者对象的弱引用 (用于校验订阅者是否还活着)。
-         * @param event_id 订阅的事件 ID。
-         * @param sender_key (可选) 关注的发送者 ID。
-         * @param active_token [关键] 共享的原子票据。
+         * @param adopted 票据槽，接管调用者已经为它取得的一个引用。
          */
-        Connection(std::weak_ptr<IEventBus> bus, std::weak_ptr<void> subscriber,
-            EventId event_id, std::weak_ptr<void> sender_key,
-            std::shared_ptr<std::atomic<bool>> active_token);
-
-        /** @brief 保存 EventBus 的弱引用，以便在 Disconnect 时通知它。 */
-        std::weak_ptr<IEventBus> bus_;
-
-        /** @brief 保存订阅者的弱引用。 */
-        std::weak_ptr<void> subscriber_;
-
-        /** @brief 记录订阅的是哪个事件，用于在 map 中查找。 */
-        EventId event_id_ = 0;
-
-        /** @brief 记录关注的是哪个发送者 (如果是 Sender 模式)。 */
-        std::weak_ptr<void> sender_key_;
-
-        /** @brief 本地标记，表示此 Connection 对象是否持有连接。 */
-        std::atomic<bool> is_connected_{ false };
+        explicit Connection(internal::ConnectionSlot* adopted) noexcept : slot_(adopted) {}
 
         /**
-         * @brief [核心] 共享原子票据。
+         * @brief [核心] 票据槽。
          * @details
-         * 这是一个 `shared_ptr`，指向堆上的一个 `atomic<bool>`。
-         * - Connection 持有一份。
-         * - EventBus 内部的订阅列表中也持有一份。
-         *
-         * 当我们需要断开时，只要把这个 bool 设为 false。
-         * 因为是共享内存，EventBus 那边看到的值也会立马变成 false。
-         * 这就是解决多线程竞争的神器。
+         * 槽中的原子票据与 EventBus 订阅列表里的记录共享：
+         * 断开时只要把它设为 false，EventBus 那边立即可见。
+         * 句柄持有槽的一个引用，槽在句柄存在期间不会被回收，因此断开时读取槽中的信息是安全的。
          */
-        std::shared_ptr<std::atomic<bool>> active_token_;
+        internal::ConnectionSlot* slot_ = nullptr;
     };
 
     /**
@@ -230,6 +224,61 @@ namespace z3y {
         Connection conn_;
     };
 
+    /**
+     * @class EventConnectionGroup
+     * @brief 一组连接的集合，可以一次性全部断开 (析构时自动断开)。
+     *
+     * @details
+     * 适合订阅成百上千个事件的对象 (例如界面面板)：逐个 `Disconnect` 会为每个连接各登记一次 GC，
+     * 而 `DisconnectAll` 先撕掉全部票据，再按总线把所有待回收的列表一次性登记，
+     * 由一轮 GC 批处理在同一次持锁中把它们全部移除。
+     *
+     * \code{.cpp}
+     * class Panel : public std::enable_shared_from_this<Panel> {
+     *     z3y::EventConnectionGroup connections_;
+     *     void Bind(IEventBus& bus) {
+     *         for (auto* field : fields_) connections_ += bus.SubscribeToSender<ValueChangedEvent>(field, ...);
+     *     }
+     * };  // Panel 销毁时一次断开全部
+     * \endcode
+     * @note 与 `Connection` 一样，同一个组不应被多个线程同时修改。
+     */
+    class Z3Y_FRAMEWORK_API EventConnectionGroup {
+    public:
+        EventConnectionGroup() = default;
+        ~EventConnectionGroup() { DisconnectAll(); }
+
+        EventConnectionGroup(const EventConnectionGroup&) = delete;
+        EventConnectionGroup& operator=(const EventConnectionGroup&) = delete;
+        EventConnectionGroup(EventConnectionGroup&& other) noexcept = default;
+        EventConnectionGroup& operator=(EventConnectionGroup&& other) noexcept {
+            if (this != &other) {
+                DisconnectAll();
+                connections_ = std::move(other.connections_);
+            }
+            return *this;
+        }
+
+        /** @brief 接管一个连接。空连接被忽略。 */
+        void Add(Connection connection);
+
+        /** @brief 同 `Add`。 */
+        EventConnectionGroup& operator+=(Connection connection) {
+            Add(std::move(connection));
+            return *this;
+        }
+
+        /** @brief 断开组内全部连接并清空。 */
+        void DisconnectAll();
+
+        /** @brief 组内的连接数 (包括已被其他途径断开的)。 */
+        [[nodiscard]] size_t Size() const { return connections_.size(); }
+        [[nodiscard]] bool Empty() const { return connections_.empty(); }
+
+    private:
+        std::vector<Connection> connections_;
+    };
+
 }  // namespace z3y
 
 #ifdef _MSC_VER
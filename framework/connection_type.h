@@ -33,6 +33,8 @@
 #ifndef Z3Y_FRAMEWORK_CONNECTION_TYPE_H_
 #define Z3Y_FRAMEWORK_CONNECTION_TYPE_H_
 
+#include <cstddef>
+
 namespace z3y {
 
     /**
@@ -69,9 +71,48 @@ namespace z3y {
          * 适合处理需要几毫秒或可能与其他插件交互的回调 (例如日志记录)。
          * - 缺点：有轻微的延迟 (取决于队列负载)。
          */
-        kQueued
+        kQueued,
+
+        /**
+         * @brief 合并队列连接 (异步，只保留最新值)。
+         *
+         * 与 `kQueued` 一样在工作线程上执行，但每个订阅 *最多只有一个* 待投递事件：
+         * 若该订阅上一次的事件尚未被派发，新事件会 *替换* 它的负载，而不是再排一个任务。
+         * 回调执行时总是看到最新的一次 Fire。
+         *
+         * [使用时机]
+         * - 状态类事件 (配置变更、进度、最新读数等)，中间值没有意义。
+         * - 发布频率远高于订阅者处理能力时，可以把队列占用限制为 O(订阅者数)。
+         *
+         * **[注意]**
+         * 中间的事件会被丢弃，回调次数 <= Fire 次数。不要用于每次都必须处理的命令/消息类事件。
+         * 合并以“订阅”为单位：同一 EventId 的全局订阅与各个发送者的定向订阅互不合并。
+         */
+        kQueuedCoalesced
+    };
+
+    /**
+     * @enum EventPriority
+     * @brief 异步 (kQueued / kQueuedCoalesced) 回调的优先级通道。
+     *
+     * @details
+     * 每个派发线程为每个优先级维护一条独立的队列，总是先排空更高的通道。
+     * 同一订阅的回调仍严格按发布顺序执行；不同优先级之间不保证相对顺序。
+     * 积压超限时按 `EventQueueOverflowPolicy` 丢弃的回调不再执行，但丢弃不会改变其余回调的先后
+     * (kDropOldest 只给被丢弃的任务立墓碑，不移动队列中的其它任务)。
+     * 对 kDirect 订阅没有影响。
+     *
+     * **[注意]** 调度是严格优先的：如果 kRealtime 通道持续满载，低优先级通道会被饿死。
+     */
+    enum class EventPriority {
+        kRealtime,    //!< 延迟敏感 (告警、控制信号)。应保持低频、回调短小。
+        kNormal,      //!< 默认。
+        kBackground,  //!< 遥测、统计等低价值事件。框架内部的 GC 任务也在此通道。
     };
 
+    /** @brief 优先级通道数量。 */
+    inline constexpr size_t kEventPriorityCount = 3;
+
 }  // namespace z3y
 
 #endif  // Z3Y_FRAMEWORK_CONNECTION_TYPE_H_
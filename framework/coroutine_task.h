@@ -0,0 +1,537 @@
+﻿/*
+* Copyright [2025] [Yue Liu]
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/**
+ * @file coroutine_task.h
+ * @brief [可选] C++20 协程支持：`z3y::Task<T>` 与框架的 awaitable。
+ * @author Yue Liu
+ * @date 2025
+ *
+ * @details
+ * [受众：插件开发者]
+ *
+ * 多步的异步流程如果用嵌套的 kQueued 回调来写，每一步都要分配闭包，还要在派发线程上来回转一次。
+ * 这里把这些步骤写成可挂起的状态机：
+ * - `Task<T>`：惰性协程，首次被 `co_await` 时才开始执行；结束时通过对称转移直接恢复等待者，不经过任何线程。
+ * - `co_await Schedule(executor)`：切换到共享执行器 (或任意 `IEventExecutor`，如串行队列) 上继续执行。
+ * - `co_await ScheduleAfter(executor, delay)`：延迟一段时间后在执行器上继续。
+ * - `co_await NextEvent<TEvent>(bus)`：挂起直到下一个 `TEvent` 发布，返回事件的副本。
+ * 以 kDirect 订阅，默认在发布者线程上直接恢复，中间没有线程切换。
+ * - `co_await AwaitRequest<TReq, TResp>(bus, req)`：发出请求 (见 `IEventBus::Request`)，返回回复；
+ * 失败时 `RequestError` 从 `co_await` 处抛出。默认在完成它的线程上恢复。
+ * - `co_await GetServiceAsync<T>(executor, clsid)`：在执行器上获取 (必要时初始化) 服务。
+ * - `Spawn(task, on_done)`：从普通函数里启动一个顶层协程。
+ *
+ * \code{.cpp}
+ * z3y::Task<void> Pipeline(z3y::PluginPtr<z3y::IEventBus> bus, z3y::PluginPtr<z3y::IExecutorService> ex) {
+ *     auto frame = co_await z3y::NextEvent<FrameReadyEvent>(bus);  // 发布者线程
+ *     co_await z3y::Schedule(ex, z3y::TaskPriority::kLow);         // 切到线程池
+ *     Analyze(frame);
+ * }
+ * z3y::Spawn(Pipeline(bus, ex), [](std::exception_ptr e) { ... });
+ * \endcode
+ *
+ * [启用方式]
+ * 框架本身按 C++17 编译，此头文件只在编译器开启协程 (C++20) 时生效，此时 `Z3Y_HAS_COROUTINES` 为 1。
+ * 在 CMake 中打开 `Z3Y_ENABLE_COROUTINES` 即可让整个工程改用 C++20。
+ *
+ * [生命周期]
+ * - 挂起在 `Schedule` 上的协程，如果它的任务被执行器丢弃 (框架销毁、卸载插件)，会被恢复一次并在
+ * `co_await` 处抛出 `TaskCancelled`，因此帧不会泄漏，RAII 对象都能正常析构。
+ * - 挂起在 `NextEvent` 上的协程持有一个订阅；帧被销毁 (例如外层 `Task` 被丢弃) 时订阅自动断开。
+ * 事件总线销毁时不会恢复它，需要由调用方保证在卸载前让等待结束。
+ * - 挂起在 `AwaitRequest` 上的协程总会被回复或超时恢复；帧提前销毁后迟到的回复直接丢弃。
+ * 不设超时 (timeout <= 0) 时，处理者不回复协程就一直挂起。
+ * - 协程的参数按值保存。不要以引用方式传入会比协程先销毁的对象。
+ */
+
+#pragma once
+
+#ifndef Z3Y_FRAMEWORK_COROUTINE_TASK_H_
+#define Z3Y_FRAMEWORK_COROUTINE_TASK_H_
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#define Z3Y_HAS_COROUTINES 1
+#else
+#define Z3Y_HAS_COROUTINES 0
+#endif
+
+#if Z3Y_HAS_COROUTINES
+
+#include <atomic>        // 用于 NextEvent 的状态机
+#include <chrono>        // 用于 ScheduleAfter
+#include <coroutine>     // 用于 std::coroutine_handle
+#include <exception>     // 用于 std::exception_ptr
+#include <functional>    // 用于 std::function
+#include <memory>        // 用于 std::shared_ptr
+#include <mutex>         // 用于 NextEvent 的连接保护
+#include <optional>      // 用于保存返回值与事件副本
+#include <stdexcept>     // 用于 TaskCancelled
+#include <utility>       // 用于 std::exchange
+#include "framework/connection.h"          // 依赖 Connection
+#include "framework/event_executor.h"      // 依赖 IEventExecutor
+#include "framework/i_event_bus.h"         // 依赖 IEventBus
+#include "framework/i_executor_service.h"  // 依赖 IExecutorService
+#include "framework/z3y_service_locator.h" // 依赖 GetService
+
+namespace z3y {
+
+    /**
+     * @class TaskCancelled
+     * @brief 协程等待的执行器任务被丢弃 (或执行器已停止) 时，从 `co_await` 处抛出。
+     */
+    class TaskCancelled : public std::runtime_error {
+    public:
+        using std::runtime_error::runtime_error;
+    };
+
+    template <typename T = void>
+    class Task;
+
+    namespace detail {
+
+        /** @brief 所有 Task promise 的公共部分：等待者与异常。 */
+        struct TaskPromiseBase {
+            std::coroutine_handle<> continuation_;
+            std::exception_ptr error_;
+
+            /** @brief 结束时直接转移到等待者；没有等待者就停在这里，由 Task 负责销毁帧。 */
+            struct FinalAwaiter {
+                bool await_ready() const noexcept { return false; }
+                template <typename TPromise>
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<TPromise> self) noexcept {
+                    std::coroutine_handle<> next = self.promise().continuation_;
+                    return next ? next : std::noop_coroutine();
+                }
+                void await_resume() const noexcept {}
+            };
+
+            std::suspend_always initial_suspend() const noexcept { return {}; }
+            FinalAwaiter final_suspend() const noexcept { return {}; }
+            void unhandled_exception() noexcept { error_ = std::current_exception(); }
+        };
+
+        template <typename T>
+        struct TaskPromise : TaskPromiseBase {
+            std::optional<T> value_;
+
+            Task<T> get_return_object() noexcept;
+            template <typename U>
+            void return_value(U&& value) { value_.emplace(std::forward<U>(value)); }
+            T TakeResult() {
+                if (error_) std::rethrow_exception(error_);
+                return std::move(*value_);
+            }
+        };
+
+        template <>
+        struct TaskPromise<void> : TaskPromiseBase {
+            Task<void> get_return_object() noexcept;
+            void return_void() const noexcept {}
+            void TakeResult() const {
+                if (error_) std::rethrow_exception(error_);
+            }
+        };
+
+    }  // namespace detail
+
+    /**
+     * @class Task
+     * @brief 惰性、只可移动的协程返回类型。
+     * @details 帧归 Task 对象所有，Task 析构时销毁帧。只能被 `co_await` 一次 (右值)，
+     * 异常在 `co_await` 处重新抛出。不要 `co_await` 默认构造的空 Task。
+     */
+    template <typename T>
+    class [[nodiscard]] Task {
+    public:
+        using promise_type = detail::TaskPromise<T>;
+        using Handle = std::coroutine_handle<promise_type>;
+
+        Task() noexcept = default;
+        explicit Task(Handle handle) noexcept : handle_(handle) {}
+        Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+        Task& operator=(Task&& other) noexcept {
+            if (this != &other) {
+                if (handle_) handle_.destroy();
+                handle_ = std::exchange(other.handle_, {});
+            }
+            return *this;
+        }
+        Task(const Task&) = delete;
+        Task& operator=(const Task&) = delete;
+        ~Task() {
+            if (handle_) handle_.destroy();
+        }
+
+        /** @brief 协程是否已经运行结束 (空 Task 视为已结束)。 */
+        [[nodiscard]] bool IsReady() const noexcept { return !handle_ || handle_.done(); }
+
+        auto operator co_await() && noexcept {
+            struct Awaiter {
+                Handle handle;
+                bool await_ready() const noexcept { return handle.done(); }
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<> caller) noexcept {
+                    handle.promise().continuation_ = caller;
+                    return handle;  // 对称转移：在当前线程上直接开始执行子协程
+                }
+                T await_resume() { return handle.promise().TakeResult(); }
+            };
+            return Awaiter{ handle_ };
+        }
+
+    private:
+        Handle handle_;
+    };
+
+    namespace detail {
+
+        template <typename T>
+        Task<T> TaskPromise<T>::get_return_object() noexcept {
+            return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+        }
+
+        inline Task<void> TaskPromise<void>::get_return_object() noexcept {
+            return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+        }
+
+        /** @brief Spawn 使用的自销毁协程：立即开始，结束时释放自己的帧。 */
+        struct DetachedTask {
+            struct promise_type {
+                DetachedTask get_return_object() const noexcept { return {}; }
+                std::suspend_never initial_suspend() const noexcept { return {}; }
+                std::suspend_never final_suspend() const noexcept { return {}; }
+                void return_void() const noexcept {}
+                void unhandled_exception() const noexcept { std::terminate(); }
+            };
+        };
+
+        /**
+         * @brief 投递到执行器的恢复令牌。
+         * @details 正常执行时恢复协程；如果任务没有执行就被销毁 (执行器丢弃了它)，
+         * 先标记取消再恢复，让协程在 `co_await` 处收到 `TaskCancelled` 并正常展开。
+         */
+        class ResumeToken {
+        public:
+            ResumeToken(std::coroutine_handle<> handle, bool* cancelled) noexcept
+                : handle_(handle), cancelled_(cancelled) {}
+            ResumeToken(const ResumeToken&) = delete;
+            ResumeToken& operator=(const ResumeToken&) = delete;
+            ~ResumeToken() {
+                if (handle_) {
+                    *cancelled_ = true;
+                    std::exchange(handle_, {}).resume();
+                }
+            }
+
+            void Resume() {
+                if (handle_) std::exchange(handle_, {}).resume();
+            }
+            void Release() noexcept { handle_ = {}; }
+
+        private:
+            std::coroutine_handle<> handle_;
+            bool* cancelled_;
+        };
+
+        inline DetachedTask SpawnImpl(Task<void> task, std::function<void(std::exception_ptr)> on_done) {
+            std::exception_ptr error;
+            try {
+                co_await std::move(task);
+            } catch (...) {
+                error = std::current_exception();
+            }
+            if (on_done) {
+                on_done(error);
+            } else if (error) {
+                std::rethrow_exception(error);  // 没人接收的异常：与 std::thread 一样终止
+            }
+        }
+
+    }  // namespace detail
+
+    /**
+     * @brief 启动一个顶层协程。它立即在当前线程上运行到第一个挂起点。
+     * @param on_done 结束时调用 (在协程最后所在的线程上)，参数为异常或空；
+     * 不提供时，协程以异常结束会调用 `std::terminate`。
+     */
+    inline void Spawn(Task<void> task, std::function<void(std::exception_ptr)> on_done = nullptr) {
+        detail::SpawnImpl(std::move(task), std::move(on_done));
+    }
+
+    /**
+     * @class ScheduleAwaiter
+     * @brief `Schedule` / `ScheduleAfter` 返回的 awaitable：把协程的后续部分投递到执行器上。
+     */
+    class ScheduleAwaiter {
+    public:
+        ScheduleAwaiter(PluginPtr<IExecutorService> service, TaskPriority priority,
+            std::chrono::nanoseconds delay, bool delayed)
+            : service_(std::move(service)), priority_(priority), delay_(delay), delayed_(delayed) {
+            if (!service_) throw std::invalid_argument("z3y::Schedule: executor is null");
+        }
+        explicit ScheduleAwaiter(std::shared_ptr<IEventExecutor> queue) : queue_(std::move(queue)) {
+            if (!queue_) throw std::invalid_argument("z3y::Schedule: executor is null");
+        }
+
+        bool await_ready() const noexcept { return false; }
+
+        bool await_suspend(std::coroutine_handle<> handle) {
+            auto token = std::make_shared<detail::ResumeToken>(handle, &cancelled_);
+            auto resume = [token] { token->Resume(); };
+            // 投递成功后协程可能已在别的线程恢复：从这里开始不能再访问 this
+            if (queue_) {
+                queue_->Post(std::move(resume));
+                return true;
+            }
+            bool posted = delayed_ ? service_->PostDelayed(delay_, std::move(resume), priority_) != 0
+                : service_->Post(std::move(resume), priority_);
+            if (!posted) {
+                token->Release();
+                cancelled_ = true;
+            }
+            return posted;
+        }
+
+        void await_resume() const {
+            if (cancelled_) throw TaskCancelled("z3y: scheduled coroutine was cancelled by its executor");
+        }
+
+    private:
+        PluginPtr<IExecutorService> service_;
+        std::shared_ptr<IEventExecutor> queue_;
+        TaskPriority priority_ = TaskPriority::kNormal;
+        std::chrono::nanoseconds delay_{ 0 };
+        bool delayed_ = false;
+        bool cancelled_ = false;
+    };
+
+    /** @brief 在共享执行器上继续执行。执行器已停止时抛出 `TaskCancelled`。 */
+    [[nodiscard]] inline ScheduleAwaiter Schedule(PluginPtr<IExecutorService> executor,
+        TaskPriority priority = TaskPriority::kNormal) {
+        return ScheduleAwaiter(std::move(executor), priority, std::chrono::nanoseconds(0), false);
+    }
+
+    /** @brief 在任意 `IEventExecutor` (例如 `GetSerialQueue` 返回的串行队列) 上继续执行。 */
+    [[nodiscard]] inline ScheduleAwaiter Schedule(std::shared_ptr<IEventExecutor> executor) {
+        return ScheduleAwaiter(std::move(executor));
+    }
+
+    /** @brief `delay` 之后在共享执行器上继续执行 (基于 `PostDelayed`)。 */
+    [[nodiscard]] inline ScheduleAwaiter ScheduleAfter(PluginPtr<IExecutorService> executor,
+        std::chrono::nanoseconds delay, TaskPriority priority = TaskPriority::kNormal) {
+        return ScheduleAwaiter(std::move(executor), priority, delay, true);
+    }
+
+    /**
+     * @class NextEventAwaiter
+     * @brief `NextEvent` 返回的 awaitable：订阅一次 `TEvent`，收到后断开并恢复协程。
+     */
+    template <typename TEvent>
+    class NextEventAwaiter {
+    public:
+        NextEventAwaiter(PluginPtr<IEventBus> bus, PluginPtr<IComponent> sender,
+            std::shared_ptr<IEventExecutor> resume_on)
+            : bus_(std::move(bus)), sender_(std::move(sender)), waiter_(std::make_shared<Waiter>()) {
+            if (!bus_) throw std::invalid_argument("z3y::NextEvent: event bus is null");
+            waiter_->resume_on = std::move(resume_on);
+        }
+        NextEventAwaiter(NextEventAwaiter&&) noexcept = default;
+        NextEventAwaiter(const NextEventAwaiter&) = delete;
+        NextEventAwaiter& operator=(const NextEventAwaiter&) = delete;
+        NextEventAwaiter& operator=(NextEventAwaiter&&) = delete;
+
+        /** @brief 帧被销毁时 (无论是否收到事件) 断开订阅，迟到的事件不会再恢复它。 */
+        ~NextEventAwaiter() {
+            if (!waiter_) return;
+            waiter_->state.store(kAbandoned, std::memory_order_release);
+            std::lock_guard<std::mutex> lock(waiter_->mutex);
+            waiter_->connection.Disconnect();
+        }
+
+        bool await_ready() const noexcept { return false; }
+
+        void await_suspend(std::coroutine_handle<> handle) {
+            std::shared_ptr<Waiter> waiter = waiter_;
+            waiter->handle = handle;
+            // 订阅返回前事件就可能在别的线程发布并恢复了协程：连接只存进 waiter，
+            // await_resume 要先拿到同一把锁才会断开它
+            std::lock_guard<std::mutex> lock(waiter->mutex);
+            waiter->connection = sender_
+                ? bus_->template SubscribeToSender<TEvent>(sender_, waiter, &Waiter::OnEvent)
+                : bus_->template SubscribeGlobal<TEvent>(waiter, &Waiter::OnEvent);
+        }
+
+        TEvent await_resume() {
+            {
+                std::lock_guard<std::mutex> lock(waiter_->mutex);
+                waiter_->connection.Disconnect();
+            }
+            return std::move(*waiter_->event);
+        }
+
+    private:
+        enum : int { kWaiting = 0, kFired = 1, kAbandoned = 2 };
+
+        struct Waiter : std::enable_shared_from_this<Waiter> {
+            std::atomic<int> state{ kWaiting };
+            std::optional<TEvent> event;
+            std::coroutine_handle<> handle;
+            std::shared_ptr<IEventExecutor> resume_on;
+            std::mutex mutex;
+            Connection connection;
+
+            void OnEvent(const TEvent& e) {
+                int expected = kWaiting;
+                // 并发发布时只有第一个事件生效
+                if (!state.compare_exchange_strong(expected, kFired, std::memory_order_acq_rel)) return;
+                event.emplace(e);
+                if (resume_on) {
+                    std::coroutine_handle<> h = handle;
+                    resume_on->Post([h] { h.resume(); });
+                } else {
+                    handle.resume();
+                }
+            }
+        };
+
+        PluginPtr<IEventBus> bus_;
+        PluginPtr<IComponent> sender_;
+        std::shared_ptr<Waiter> waiter_;
+    };
+
+    /**
+     * @brief 挂起直到下一个全局 `TEvent` 发布，返回它的副本 (`TEvent` 必须可拷贝)。
+     * @param resume_on 为空时在发布者线程上直接恢复；否则把恢复投递到该执行器。
+     */
+    template <typename TEvent>
+    [[nodiscard]] NextEventAwaiter<TEvent> NextEvent(PluginPtr<IEventBus> bus,
+        std::shared_ptr<IEventExecutor> resume_on = nullptr) {
+        return NextEventAwaiter<TEvent>(std::move(bus), nullptr, std::move(resume_on));
+    }
+
+    /** @brief 同上，但只等待 `sender` 发出的 `TEvent`。 */
+    template <typename TEvent>
+    [[nodiscard]] NextEventAwaiter<TEvent> NextEvent(PluginPtr<IEventBus> bus, PluginPtr<IComponent> sender,
+        std::shared_ptr<IEventExecutor> resume_on = nullptr) {
+        if (!sender) throw std::invalid_argument("z3y::NextEvent: sender is null");
+        return NextEventAwaiter<TEvent>(std::move(bus), std::move(sender), std::move(resume_on));
+    }
+
+    /**
+     * @class RequestAwaiter
+     * @brief `AwaitRequest` 返回的 awaitable：发出请求，回复 (或失败) 到达时恢复协程。
+     */
+    template <typename TReq, typename TResp>
+    class RequestAwaiter {
+    public:
+        RequestAwaiter(PluginPtr<IEventBus> bus, TReq request, std::chrono::nanoseconds timeout,
+            std::shared_ptr<IEventExecutor> resume_on)
+            : bus_(std::move(bus)), request_(std::move(request)), timeout_(timeout),
+            waiter_(std::make_shared<Waiter>()) {
+            if (!bus_) throw std::invalid_argument("z3y::AwaitRequest: event bus is null");
+            waiter_->resume_on = std::move(resume_on);
+        }
+        RequestAwaiter(RequestAwaiter&&) noexcept = default;
+        RequestAwaiter(const RequestAwaiter&) = delete;
+        RequestAwaiter& operator=(const RequestAwaiter&) = delete;
+        RequestAwaiter& operator=(RequestAwaiter&&) = delete;
+
+        /** @brief 帧被销毁时标记放弃，迟到的回复不会再恢复它。 */
+        ~RequestAwaiter() {
+            if (waiter_) waiter_->state.store(kAbandoned, std::memory_order_release);
+        }
+
+        bool await_ready() const noexcept { return false; }
+
+        bool await_suspend(std::coroutine_handle<> handle) {
+            std::shared_ptr<Waiter> waiter = waiter_;
+            waiter->handle = handle;
+            bus_->template RequestAsync<TReq, TResp>(std::move(request_), timeout_,
+                [waiter](TResp* response, std::exception_ptr error) { waiter->OnDone(response, std::move(error)); });
+            int expected = kPending;
+            if (waiter->state.compare_exchange_strong(expected, kSuspended, std::memory_order_acq_rel)) return true;
+            // 请求已同步完成 (kDirect 处理者或立即失败)：没有指定执行器时直接继续，不挂起
+            if (!waiter->resume_on) return false;
+            waiter->resume_on->Post([handle] { handle.resume(); });
+            return true;
+        }
+
+        TResp await_resume() {
+            if (waiter_->error) std::rethrow_exception(waiter_->error);
+            return std::move(*waiter_->response);
+        }
+
+    private:
+        enum : int { kPending = 0, kSuspended = 1, kDone = 2, kAbandoned = 3 };
+
+        struct Waiter {
+            std::atomic<int> state{ kPending };
+            std::optional<TResp> response;
+            std::exception_ptr error;
+            std::coroutine_handle<> handle;
+            std::shared_ptr<IEventExecutor> resume_on;
+
+            void OnDone(TResp* r, std::exception_ptr e) {
+                if (r) response.emplace(std::move(*r));
+                else error = std::move(e);
+                int expected = kPending;
+                // await_suspend 还没返回：由它决定是否挂起
+                if (state.compare_exchange_strong(expected, kDone, std::memory_order_acq_rel)) return;
+                if (expected != kSuspended ||
+                    !state.compare_exchange_strong(expected, kDone, std::memory_order_acq_rel)) {
+                    return;  // 帧已销毁
+                }
+                if (resume_on) {
+                    std::coroutine_handle<> h = handle;
+                    resume_on->Post([h] { h.resume(); });
+                } else {
+                    handle.resume();
+                }
+            }
+        };
+
+        PluginPtr<IEventBus> bus_;
+        TReq request_;
+        std::chrono::nanoseconds timeout_;
+        std::shared_ptr<Waiter> waiter_;
+    };
+
+    /**
+     * @brief 发出请求并挂起到回复到达，返回回复 (失败时抛出 `RequestError` 或处理者的异常)。
+     * @param resume_on 为空时在完成请求的线程上恢复 (处理者线程或定时器线程)；否则投递到该执行器。
+     */
+    template <typename TReq, typename TResp>
+    [[nodiscard]] RequestAwaiter<TReq, TResp> AwaitRequest(PluginPtr<IEventBus> bus, TReq request,
+        std::chrono::nanoseconds timeout = IEventBus::kDefaultRequestTimeout,
+        std::shared_ptr<IEventExecutor> resume_on = nullptr) {
+        return RequestAwaiter<TReq, TResp>(std::move(bus), std::move(request), timeout, std::move(resume_on));
+    }
+
+    /**
+     * @brief 在执行器上获取服务，服务的 `Initialize()` 不会阻塞调用协程所在的线程。
+     * @details 协程之后在执行器线程上继续。获取失败时 `PluginException` 从 `co_await` 处抛出。
+     */
+    template <typename T>
+    Task<PluginPtr<T>> GetServiceAsync(PluginPtr<IExecutorService> executor, ClassId clsid) {
+        co_await Schedule(std::move(executor), TaskPriority::kHigh);
+        co_return GetService<T>(clsid);
+    }
+
+}  // namespace z3y
+
+#endif  // Z3Y_HAS_COROUTINES
+
+#endif  // Z3Y_FRAMEWORK_COROUTINE_TASK_H_
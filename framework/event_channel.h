@@ -0,0 +1,136 @@
+﻿/*
+* Copyright [2025] [Yue Liu]
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/**
+ * @file event_channel.h
+ * @brief 类型化事件通道 `z3y::EventChannel<TEvent>`：绕过全局订阅表的高频发布路径。
+ * @author Yue Liu
+ * @date 2025
+ *
+ * @details
+ * [受众：插件开发者 (高频事件)]
+ *
+ * `FireGlobal<TEvent>` 每次发布都要取事件槽号 (函数内静态变量)、做一次 `IsGlobalSlotSubscribed`
+ * 预检 (一次虚调用 + 一次 RCU 读临界区)，再进入 `FireGlobalRefImpl` (又一次虚调用 + 读临界区)，
+ * 并按订阅的连接类型逐个分支。对每秒数十万次的事件 (行情、传感器采样)，这些固定开销占了大头。
+ *
+ * 通道在总线上为 TEvent 建一份 *自己的* 订阅数组，只接受同步 (kDirect) 订阅：
+ * - `GetChannel<TEvent>()` 只在取通道时解析一次槽号，句柄直接指向总线内的通道状态；
+ * - `Fire` 只有一次虚调用、一次 RCU 读临界区，不查表、不预检，通道订阅者的循环里没有连接类型分支；
+ * - 断开仍然是 `Connection` 撕票 + 惰性 GC，追踪钩子照常收到 kDirectCallStart / kDirectCallEnd。
+ *
+ * **与总线互通：**
+ * - 通道订阅者同样会收到 `FireGlobal<TEvent>` (以及批量发布的逐个事件)；
+ * - `Fire` 之后，同一事件的 `SubscribeGlobal` / 事件族订阅者照常收到 (包括 kQueued)；
+ * - 保留事件的 `Fire` 按 `FireGlobal` 处理 (需要先在堆上保存最新值)。
+ * 通道订阅者与总线订阅者之间的先后顺序不作保证。
+ *
+ * \code{.cpp}
+ * class Ticker : public std::enable_shared_from_this<Ticker> {
+ *     z3y::EventChannel<QuoteEvent> quotes_;
+ *     void Bind(z3y::IEventBus& bus) { quotes_ = bus.GetChannel<QuoteEvent>(); }
+ *     void OnTick(double price) { quotes_.Fire(QuoteEvent{ price }); }
+ * };
+ * // 订阅者
+ * connection_ = bus->GetChannel<QuoteEvent>().Subscribe(shared_from_this(), &Chart::OnQuote);
+ * \endcode
+ */
+
+#pragma once
+
+#ifndef Z3Y_FRAMEWORK_EVENT_CHANNEL_H_
+#define Z3Y_FRAMEWORK_EVENT_CHANNEL_H_
+
+#include <memory>       // 用于 std::shared_ptr
+#include <type_traits>  // 用于 std::is_base_of_v
+#include <utility>      // 用于 std::forward
+#include "framework/i_event_bus.h"
+
+namespace z3y {
+
+    /**
+     * @class EventChannel
+     * @brief TEvent 的类型化发布/订阅句柄 (由 `IEventBus::GetChannel` 取得)。
+     *
+     * @details
+     * 句柄只有两个指针，可以随意拷贝；默认构造的句柄为空 (`Fire` 什么也不做)。
+     * 句柄不延长总线的生命周期：总线销毁后不得再使用。
+     */
+    template <typename TEvent>
+    class EventChannel {
+        static_assert(std::is_base_of_v<Event, TEvent>, "TEvent must derive from z3y::Event");
+        // kQueued 总线订阅者需要把栈上的事件拷贝到堆上
+        static_assert(std::is_copy_constructible_v<TEvent>, "EventChannel requires a copy-constructible TEvent");
+
+    public:
+        EventChannel() noexcept = default;
+
+        /** @brief 句柄是否已绑定到某条总线。 */
+        explicit operator bool() const noexcept { return core_ != nullptr; }
+
+        /**
+         * @brief 订阅本通道 (同步回调，在 `Fire` / `FireGlobal` 的调用线程上执行)。
+         * @param subscriber 订阅者对象。**必须继承自 enable_shared_from_this**。
+         * @param callback 成员函数指针 (如 &MyPlugin::OnQuote)，或可以 `(TSubscriber*, const TEvent&)` 调用的对象。
+         * @note 需要异步投递时请使用 `IEventBus::SubscribeGlobal`，它同样收到本通道发布的事件。
+         */
+        template <typename TSubscriber, typename TCallback>
+        [[nodiscard]]
+        Connection Subscribe(std::shared_ptr<TSubscriber> subscriber, TCallback&& callback) const {
+            static_assert(std::is_base_of_v<std::enable_shared_from_this<TSubscriber>, TSubscriber>,
+                "Subscriber must inherit from std::enable_shared_from_this");
+            EventDelegate delegate = EventDelegate::Bind<TSubscriber, TEvent>(std::forward<TCallback>(callback));
+            return bus_->SubscribeChannelImpl(core_, subscriber, std::move(delegate));
+        }
+
+        /**
+         * @brief 发布事件。`event` 只在本次调用期间被引用，只有存在 kQueued 总线订阅者时才会被拷贝。
+         */
+        void Fire(const TEvent& event) const {
+            if (!core_) return;
+            if constexpr (detail::IsRetainedEvent<TEvent>::value) {
+                bus_->template FireGlobal<TEvent>(event);
+            } else {
+                bus_->FireChannelImpl(core_, event, &detail::PromoteEvent<TEvent>);
+            }
+        }
+
+        /** @brief 就地构造并发布事件 (与 `FireGlobal<TEvent>(args...)` 对应)。 */
+        template <typename... Args>
+        void Emit(Args&&... args) const {
+            Fire(TEvent(std::forward<Args>(args)...));
+        }
+
+    private:
+        friend class IEventBus;
+
+        EventChannel(IEventBus* bus, internal::EventChannelCore* core) noexcept : bus_(bus), core_(core) {}
+
+        IEventBus* bus_ = nullptr;
+        internal::EventChannelCore* core_ = nullptr;
+    };
+
+    template <typename TEvent>
+    EventChannel<TEvent> IEventBus::GetChannel() {
+        static_assert(std::is_base_of_v<Event, TEvent>, "TEvent must derive from z3y::Event");
+        // 先解析槽号：它同时登记事件族，事件族订阅者因此也能收到通道发布的事件
+        (void)GlobalSlotOf<TEvent>();
+        return EventChannel<TEvent>(this, GetChannelImpl(TEvent::kEventId));
+    }
+
+}  // namespace z3y
+
+#endif  // Z3Y_FRAMEWORK_EVENT_CHANNEL_H_
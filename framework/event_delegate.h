@@ -0,0 +1,275 @@
+﻿/*
+* Copyright [2025] [Yue Liu]
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/**
+ * @file event_delegate.h
+ * @brief [内部] 订阅回调的存储类型 z3y::EventDelegate，以及订阅过滤谓词 z3y::EventFilter。
+ * @author Yue Liu
+ * @date 2025
+ *
+ * @details
+ * [受众：框架维护者]
+ *
+ * **问题：**
+ * 原实现把用户回调包两层：先用 lambda 捕获 `weak_sub`，再装进 `std::function<void(const Event&)>`。
+ * 每次投递都要经过 `std::function` 的间接调用，再在 lambda 里 `weak_sub.lock()` 一次
+ * (而派发循环在此之前已经检查过一次 `expired()`)。
+ *
+ * **方案：**
+ * `EventDelegate` 是一个带内联小缓冲区的可调用对象，签名为 `void(void* subscriber, const Event&)`：
+ * - 订阅者指针由派发循环在 *唯一一次* 固定 (pin) 之后传入，回调内部不再检查存活。
+ * - 成员函数指针与小型 lambda 直接存放在内联缓冲区中，只有超大的可调用对象才落到堆上。
+ * - 调用时只有一次经由函数指针的间接调用，事件类型的向下转换在其中内联完成。
+ */
+
+#pragma once
+
+#ifndef Z3Y_FRAMEWORK_EVENT_DELEGATE_H_
+#define Z3Y_FRAMEWORK_EVENT_DELEGATE_H_
+
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include "framework/class_id.h"  // 依赖 ClassId
+
+namespace z3y {
+
+    struct Event;
+    struct EventBatchView;
+
+    /**
+     * @class EventDelegate
+     * @brief 类型擦除的订阅回调：`(订阅者裸指针, 事件) -> void`。
+     * @details 可拷贝 (订阅列表是写时复制的)。默认构造的实例为空，调用空实例是未定义行为。
+     */
+    class EventDelegate {
+    public:
+        /** @brief 内联缓冲区大小。足以容纳任何成员函数指针 (含 MSVC 虚继承的情形)。 */
+        static constexpr size_t kInlineSize = 4 * sizeof(void*);
+
+        EventDelegate() noexcept = default;
+
+        /**
+         * @brief 把 `callback` 绑定为 `TSubscriber` 对 `TEvent` 的处理函数。
+         * @param callback 成员函数指针，或任何可以 `std::invoke(cb, TSubscriber*, const TEvent&)` 的对象。
+         */
+        template <typename TSubscriber, typename TEvent, typename TCallback>
+        static EventDelegate Bind(TCallback&& callback) {
+            using Fn = std::decay_t<TCallback>;
+            EventDelegate delegate;
+            if constexpr (IsInline<Fn>()) {
+                ::new (static_cast<void*>(&delegate.storage_)) Fn(std::forward<TCallback>(callback));
+            } else {
+                Fn* heap = new Fn(std::forward<TCallback>(callback));
+                std::memcpy(&delegate.storage_, &heap, sizeof(heap));
+            }
+            delegate.ops_ = &kOps<TSubscriber, TEvent, Fn>;
+            return delegate;
+        }
+
+        EventDelegate(const EventDelegate& other) : ops_(other.ops_) {
+            if (!ops_) return;
+            if (ops_->copy) ops_->copy(&other.storage_, &storage_);
+            else std::memcpy(&storage_, &other.storage_, kInlineSize);
+        }
+
+        EventDelegate(EventDelegate&& other) noexcept : ops_(other.ops_) {
+            if (!ops_) return;
+            if (ops_->move) ops_->move(&other.storage_, &storage_);
+            else std::memcpy(&storage_, &other.storage_, kInlineSize);
+            other.ops_ = nullptr;
+        }
+
+        EventDelegate& operator=(const EventDelegate& other) {
+            if (this != &other) {
+                EventDelegate copy(other);
+                *this = std::move(copy);
+            }
+            return *this;
+        }
+
+        EventDelegate& operator=(EventDelegate&& other) noexcept {
+            if (this != &other) {
+                Reset();
+                ops_ = other.ops_;
+                if (ops_) {
+                    if (ops_->move) ops_->move(&other.storage_, &storage_);
+                    else std::memcpy(&storage_, &other.storage_, kInlineSize);
+                    other.ops_ = nullptr;
+                }
+            }
+            return *this;
+        }
+
+        ~EventDelegate() { Reset(); }
+
+        explicit operator bool() const noexcept { return ops_ != nullptr; }
+
+        /** @brief 回调是否期望收到 `EventBatchView` (由 `SubscribeGlobalBatch` 绑定)。 */
+        [[nodiscard]] bool ReceivesBatch() const noexcept { return ops_ && ops_->batch; }
+
+        /**
+         * @brief 订阅者的组件 CLSID (绑定时从 `TSubscriber::kClsid` 取得)。
+         * @details 订阅者不是框架组件 (没有 `kClsid`) 时为 0。慢回调报告据此定位插件。
+         */
+        [[nodiscard]] ClassId SubscriberClassId() const noexcept { return ops_ ? ops_->clsid : 0; }
+
+        /**
+         * @brief 调用回调。
+         * @param subscriber 已被调用者固定 (持有强引用) 的订阅者对象。
+         */
+        void operator()(void* subscriber, const Event& e) const {
+            ops_->invoke(&storage_, subscriber, e);
+        }
+
+    private:
+        /** @brief 每个 (订阅者, 事件, 可调用对象) 组合一张静态操作表。copy/move/destroy 为空表示可按位处理。 */
+        struct Ops {
+            void (*invoke)(const void* storage, void* subscriber, const Event& e);
+            void (*copy)(const void* src, void* dst);
+            void (*move)(void* src, void* dst) noexcept;
+            void (*destroy)(void* storage) noexcept;
+            bool batch;  //!< TEvent 是否为 EventBatchView
+            ClassId clsid; //!< TSubscriber::kClsid (没有时为 0)
+        };
+
+        template <typename T, typename = void>
+        struct SubscriberClassIdOf : std::integral_constant<ClassId, 0> {};
+        template <typename T>
+        struct SubscriberClassIdOf<T, std::void_t<decltype(T::kClsid)>> : std::integral_constant<ClassId, T::kClsid> {};
+
+        using Storage = std::aligned_storage_t<kInlineSize, alignof(std::max_align_t)>;
+
+        template <typename Fn>
+        static constexpr bool IsInline() {
+            return sizeof(Fn) <= kInlineSize && alignof(Fn) <= alignof(std::max_align_t) &&
+                std::is_nothrow_move_constructible_v<Fn>;
+        }
+
+        template <typename Fn>
+        static Fn& Target(void* storage) {
+            if constexpr (IsInline<Fn>()) {
+                return *std::launder(static_cast<Fn*>(storage));
+            } else {
+                Fn* heap;
+                std::memcpy(&heap, storage, sizeof(heap));
+                return *heap;
+            }
+        }
+
+        template <typename TSubscriber, typename TEvent, typename Fn>
+        static void Invoke(const void* storage, void* subscriber, const Event& e) {
+            std::invoke(Target<Fn>(const_cast<void*>(storage)),
+                static_cast<TSubscriber*>(subscriber), static_cast<const TEvent&>(e));
+        }
+
+        template <typename Fn>
+        static void Copy(const void* src, void* dst) {
+            const Fn& from = Target<Fn>(const_cast<void*>(src));
+            if constexpr (IsInline<Fn>()) {
+                ::new (dst) Fn(from);
+            } else {
+                Fn* heap = new Fn(from);
+                std::memcpy(dst, &heap, sizeof(heap));
+            }
+        }
+
+        template <typename Fn>
+        static void Move(void* src, void* dst) noexcept {
+            if constexpr (IsInline<Fn>()) {
+                Fn& from = Target<Fn>(src);
+                ::new (dst) Fn(std::move(from));
+                from.~Fn();
+            } else {
+                std::memcpy(dst, src, sizeof(Fn*));  // 只转移堆指针
+            }
+        }
+
+        template <typename Fn>
+        static void Destroy(void* storage) noexcept {
+            if constexpr (IsInline<Fn>()) {
+                Target<Fn>(storage).~Fn();
+            } else {
+                delete &Target<Fn>(storage);
+            }
+        }
+
+        template <typename Fn>
+        static constexpr bool kBitwise = IsInline<Fn>() && std::is_trivially_copyable_v<Fn>;
+
+        template <typename TSubscriber, typename TEvent, typename Fn>
+        static constexpr Ops kOps = {
+            &Invoke<TSubscriber, TEvent, Fn>,
+            kBitwise<Fn> ? nullptr : &Copy<Fn>,
+            kBitwise<Fn> ? nullptr : &Move<Fn>,
+            kBitwise<Fn> ? nullptr : &Destroy<Fn>,
+            std::is_same_v<TEvent, EventBatchView>,
+            SubscriberClassIdOf<std::remove_cv_t<TSubscriber>>::value,
+        };
+
+        void Reset() noexcept {
+            if (ops_ && ops_->destroy) ops_->destroy(&storage_);
+            ops_ = nullptr;
+        }
+
+        const Ops* ops_ = nullptr;
+        Storage storage_;
+    };
+
+    /**
+     * @class EventFilter
+     * @brief 订阅时给出的过滤谓词：`(事件) -> bool`，由派发循环在发布线程上、入队之前求值。
+     * @details 谓词对象只在订阅时分配一次，订阅列表的各个写时复制副本共享它；
+     * 求值只有一次经由函数指针的间接调用。默认构造的实例为空，表示不过滤。
+     */
+    class EventFilter {
+    public:
+        EventFilter() noexcept = default;
+
+        /** @brief 把 `predicate` 绑定为 `TEvent` 的过滤谓词 (可以 `std::invoke(pred, const TEvent&)`，返回可转换为 bool 的值)。 */
+        template <typename TEvent, typename TPredicate>
+        static EventFilter Bind(TPredicate&& predicate) {
+            using Fn = std::decay_t<TPredicate>;
+            EventFilter filter;
+            filter.target_ = std::make_shared<const Fn>(std::forward<TPredicate>(predicate));
+            filter.invoke_ = &Invoke<TEvent, Fn>;
+            return filter;
+        }
+
+        explicit operator bool() const noexcept { return invoke_ != nullptr; }
+
+        /** @brief 求值。调用空实例是未定义行为。 */
+        bool operator()(const Event& e) const {
+            return invoke_(target_.get(), e);
+        }
+
+    private:
+        template <typename TEvent, typename Fn>
+        static bool Invoke(const void* target, const Event& e) {
+            return static_cast<bool>(std::invoke(*static_cast<const Fn*>(target), static_cast<const TEvent&>(e)));
+        }
+
+        std::shared_ptr<const void> target_;
+        bool (*invoke_)(const void* target, const Event& e) = nullptr;
+    };
+
+}  // namespace z3y
+
+#endif  // Z3Y_FRAMEWORK_EVENT_DELEGATE_H_
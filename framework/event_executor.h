@@ -0,0 +1,76 @@
+﻿/*
+* Copyright [2025] [Yue Liu]
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/**
+ * @file event_executor.h
+ * @brief 定义可插拔的事件执行器接口 z3y::IEventExecutor。
+ * @author Yue Liu
+ * @date 2025
+ *
+ * @details
+ * [受众：插件开发者]
+ *
+ * 默认情况下 `kQueued` 回调在框架的派发线程上执行。如果订阅者需要在 *自己的* 线程上处理事件
+ * (例如 Qt 的 GUI 线程、视觉插件的处理线程、某个 strand)，以前只能在 kDirect 回调里再转投一次。
+ *
+ * 现在可以在订阅时传入一个执行器：事件会被直接投递给它，不再经过框架的派发线程。
+ * \code{.cpp}
+ * class QtExecutor : public z3y::IEventExecutor {
+ * public:
+ *     explicit QtExecutor(QObject* context) : context_(context) {}
+ *     void Post(std::function<void()> task) override {
+ *         QMetaObject::invokeMethod(context_, std::move(task), Qt::QueuedConnection);
+ *     }
+ * private:
+ *     QObject* context_;
+ * };
+ *
+ * conn_ = bus->SubscribeGlobal<MyEvent>(subscriber, &Sub::OnEvent, std::make_shared<QtExecutor>(this));
+ * \endcode
+ *
+ * @see IEventBus::SubscribeGlobal
+ */
+
+#pragma once
+
+#ifndef Z3Y_FRAMEWORK_EVENT_EXECUTOR_H_
+#define Z3Y_FRAMEWORK_EVENT_EXECUTOR_H_
+
+#include <functional>
+
+namespace z3y {
+
+    /**
+     * @class IEventExecutor
+     * @brief 接收异步事件投递的执行器 (线程、strand、GUI 事件循环……)。
+     *
+     * @details
+     * - `Post` 会在 **发布者线程** 上被调用，可能来自多个线程并发，必须线程安全，且不应阻塞。
+     * - 任务应当按投递顺序执行，框架依赖这一点保证同一订阅的事件顺序。
+     * - 执行器可以丢弃任务 (例如已经关闭)；任务在框架或订阅者销毁之后才执行也是安全的，
+     * 它会发现连接已失效并直接返回。
+     */
+    class IEventExecutor {
+    public:
+        virtual ~IEventExecutor() = default;
+
+        /** @brief 安排 `task` 在执行器的线程上执行。 */
+        virtual void Post(std::function<void()> task) = 0;
+    };
+
+}  // namespace z3y
+
+#endif  // Z3Y_FRAMEWORK_EVENT_EXECUTOR_H_
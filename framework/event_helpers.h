@@ -16,7 +16,7 @@
 
 /**
  * @file event_helpers.h
- * @brief 提供 `Z3Y_DEFINE_EVENT` 宏，用于简化事件结构定义。
+ * @brief 提供 `Z3Y_DEFINE_EVENT` 系列宏，用于简化事件结构定义。
  * @author Yue Liu
  * @date 2025-06-21
  * @copyright Copyright (c) 2025 Yue Liu
@@ -70,4 +70,120 @@
    */                                                                         \
   static constexpr const char* kName = #ClassName;
 
+ /**
+  * @def Z3Y_DEFINE_POOLED_EVENT
+  * @brief [高级] 与 `Z3Y_DEFINE_EVENT` 相同，但额外声明该事件使用对象池构造。
+  *
+  * [使用时机]
+  * 适用于体积小、发布频率极高 (例如每帧一次) 的事件。
+  * 稳态下 `FireGlobal` / `FireToSender` 不再调用全局 `operator new`，
+  * 详见 `framework/event_pool.h`。
+  *
+  * @example
+  * \code{.cpp}
+  * struct FrameTriggerEvent : public z3y::Event {
+  * Z3Y_DEFINE_POOLED_EVENT(FrameTriggerEvent, "frame-trigger-event-uuid")
+  *
+  * uint64_t frame_index;
+  * FrameTriggerEvent(uint64_t idx) : frame_index(idx) {}
+  * };
+  * \endcode
+  */
+#define Z3Y_DEFINE_POOLED_EVENT(ClassName, UuidString)                        \
+  Z3Y_DEFINE_EVENT(ClassName, UuidString)                                     \
+  /** \
+   * @brief 标记该事件使用对象池 (由 Z3Y_DEFINE_POOLED_EVENT 宏定义)。 \
+   */                                                                         \
+  static constexpr bool kPooled = true;
+
+/**
+ * @def Z3Y_DEFINE_EVENT_IN_FAMILY
+ * @brief 与 `Z3Y_DEFINE_EVENT` 相同，但额外声明事件所属的 *事件族* (分层主题)。
+ *
+ * [使用时机]
+ * 监控、日志类插件希望一次订阅一整类事件，而不是逐个订阅几十个 EventId。
+ * 事件族以 `/` 分隔层级，`IEventBus::SubscribeFamily("vision")` 会收到
+ * `"vision"`、`"vision/camera"`、`"vision/camera/frame"` 等族下的所有事件，
+ * 但不会收到 `"visionary"` 下的事件。
+ *
+ * @example
+ * \code{.cpp}
+ * struct FrameGrabbedEvent : public z3y::Event {
+ * Z3Y_DEFINE_EVENT_IN_FAMILY(FrameGrabbedEvent, "frame-grabbed-event-uuid", "vision/camera")
+ * };
+ * \endcode
+ */
+#define Z3Y_DEFINE_EVENT_IN_FAMILY(ClassName, UuidString, FamilyString)       \
+  Z3Y_DEFINE_EVENT(ClassName, UuidString)                                     \
+  /** \
+   * @brief 事件所属的事件族 (由 Z3Y_DEFINE_EVENT_IN_FAMILY 宏定义)。 \
+   */                                                                         \
+  static constexpr const char* kEventFamily = FamilyString;
+
+/**
+ * @def Z3Y_DEFINE_SERIALIZABLE_EVENT
+ * @brief 与 `Z3Y_DEFINE_EVENT` 相同，但额外声明该事件可以序列化，能经 `IpcEventBridge` 跨进程传递。
+ *
+ * [使用时机]
+ * 需要把事件转发给另一个进程 (例如隔离运行第三方插件的子宿主) 时。
+ * 事件必须提供一对成员 (`EventWriter` / `EventReader` 见 `framework/event_serialization.h`)：
+ * - `void Serialize(z3y::EventWriter& w) const;`
+ * - `static ClassName Deserialize(z3y::EventReader& r);`
+ *
+ * @example
+ * \code{.cpp}
+ * struct DefectFoundEvent : public z3y::Event {
+ * Z3Y_DEFINE_SERIALIZABLE_EVENT(DefectFoundEvent, "defect-found-event-uuid")
+ *
+ * uint32_t station = 0;
+ * std::string label;
+ * void Serialize(z3y::EventWriter& w) const { w.Write(station); w.WriteString(label); }
+ * static DefectFoundEvent Deserialize(z3y::EventReader& r) {
+ *     DefectFoundEvent e; e.station = r.Read<uint32_t>(); e.label = r.ReadString(); return e;
+ * }
+ * };
+ * \endcode
+ */
+#define Z3Y_DEFINE_SERIALIZABLE_EVENT(ClassName, UuidString)                  \
+  Z3Y_DEFINE_EVENT(ClassName, UuidString)                                     \
+  /** \
+   * @brief 标记该事件可以序列化 (由 Z3Y_DEFINE_SERIALIZABLE_EVENT 宏定义)。 \
+   */                                                                         \
+  static constexpr bool kSerializable = true;
+
+/**
+ * @def Z3Y_DEFINE_RETAINED_EVENT
+ * @brief 与 `Z3Y_DEFINE_EVENT` 相同，但额外声明该事件是 *保留事件* (last-value cache)。
+ *
+ * [使用时机]
+ * 描述“当前状态”的事件 (连接状态、当前配方、设备就绪等)。总线为每个 EventId
+ * (`FireToSender` 时为每个 EventId + 发送者) 保留最后一次发布的实例；之后才订阅的
+ * 面板或插件在订阅时立刻收到这份最新值，无需再调用 `GetAllConfigs` 之类的全量查询重建状态。
+ *
+ * 保留只是一个编译期标记 (`kRetained`)，也可以与其他宏组合，
+ * 在结构体中自行写 `static constexpr bool kRetained = true;`。
+ * 详见 `IEventBus::FireGlobal` 与 `IEventBus::GetRetained`。
+ *
+ * [注意]
+ * 保留值由总线持有，而事件类型可能定义在插件中：卸载某个插件时，动态类型来自该插件的
+ * 保留值 (以及该插件中已销毁的发送者的条目) 会被丢弃，其余模块发布的保留值保持不变；
+ * `UnloadAllPlugins` 丢弃全部保留值。被丢弃的状态需要由它的拥有者重新发布。事件族订阅 (`SubscribeFamily`) 不会收到补发。
+ *
+ * @example
+ * \code{.cpp}
+ * struct CameraStateEvent : public z3y::Event {
+ * Z3Y_DEFINE_RETAINED_EVENT(CameraStateEvent, "camera-state-event-uuid")
+ *
+ * bool online = false;
+ * explicit CameraStateEvent(bool o) : online(o) {}
+ * };
+ * \endcode
+ */
+#define Z3Y_DEFINE_RETAINED_EVENT(ClassName, UuidString)                      \
+  Z3Y_DEFINE_EVENT(ClassName, UuidString)                                     \
+  /** \
+   * @brief 标记该事件保留最后一次发布的值 (由 Z3Y_DEFINE_RETAINED_EVENT 宏定义)。 \
+   */                                                                         \
+  static constexpr bool kRetained = true;
+
 #endif  // Z3Y_FRAMEWORK_EVENT_HELPERS_H_
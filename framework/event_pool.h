@@ -0,0 +1,254 @@
+﻿/*
+* Copyright [2025] [Yue Liu]
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/**
+ * @file event_pool.h
+ * @brief [高级] 事件对象池：让高频事件的发布不再访问全局堆分配器。
+ * @author Yue Liu
+ * @date 2025
+ *
+ * @details
+ * [受众：插件开发者 (高频事件) / 框架维护者]
+ *
+ * **问题：**
+ * `FireGlobal<TEvent>` 默认使用 `std::make_shared<TEvent>` 构造事件。
+ * 对于每帧都要触发的微小事件 (例如相机触发信号)，每次都 `malloc/free` 一次，
+ * 在多线程下会明显争用全局分配器。
+ *
+ * **方案：**
+ * 使用 `Z3Y_DEFINE_POOLED_EVENT` 定义的事件，会改用
+ * `std::allocate_shared<TEvent>(EventPoolAllocator)` 构造。
+ * - 引用计数 (控制块) 与事件对象位于 *同一块* 内存中 (侵入式布局)，
+ * 因此对外仍然是普通的 `PluginPtr<TEvent>`，ABI 与订阅者代码完全不变。
+ * - 内存块按大小分级缓存在空闲链表中，稳态下 Fire 只是“从链表取一个块 / 还一个块”。
+ *
+ * @note 池是 *按模块 (DSO) 独立* 的：每个插件内联实例化自己的池。
+ * 事件被哪个模块构造，就由该模块的分配器回收 (分配器被保存在控制块中)。
+ */
+
+#pragma once
+
+#ifndef Z3Y_FRAMEWORK_EVENT_POOL_H_
+#define Z3Y_FRAMEWORK_EVENT_POOL_H_
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace z3y {
+
+    /**
+     * @struct EventPoolStats
+     * @brief 当前模块内所有事件池的累计统计 (用于压测与诊断)。
+     */
+    struct EventPoolStats {
+        size_t heap_allocations = 0;  //!< 池中没有空闲块、不得不向全局堆申请的次数
+        size_t pool_hits = 0;         //!< 直接复用空闲块的次数
+    };
+
+    namespace detail {
+
+        /** @brief [内部] 当前模块的全局计数器。 */
+        struct EventPoolCounters {
+            std::atomic<size_t> heap_allocations{ 0 };
+            std::atomic<size_t> pool_hits{ 0 };
+
+            static EventPoolCounters& Instance() {
+                static EventPoolCounters counters;
+                return counters;
+            }
+        };
+
+        /**
+         * @class EventBlockPool
+         * @brief [内部] 固定大小内存块的空闲链表。
+         *
+         * @details
+         * 每个 (大小, 对齐) 组合一个实例，分两级缓存：
+         * 1. **线程本地缓存** (最多 `kLocalCachedBlocks` 个)：kDirect 场景下分配与释放
+         * 发生在同一线程，完全无锁。
+         * 2. **共享空闲链表** (最多 `kMaxCachedBlocks` 个)：承接跨线程释放
+         * (例如 kQueued 事件在派发线程上释放)，超出部分直接归还给全局堆。
+         *
+         * 实例被有意泄漏 (never destroyed)：派发线程可能在静态析构阶段
+         * 仍在释放最后一批事件，必须保证池在此时依然可用。
+         */
+        template <size_t kSize, size_t kAlign>
+        class EventBlockPool {
+        public:
+            static constexpr size_t kMaxCachedBlocks = 1024;
+            static constexpr size_t kLocalCachedBlocks = 64;
+
+            static EventBlockPool& Instance() {
+                static EventBlockPool* instance = new EventBlockPool();
+                return *instance;
+            }
+
+            void* Allocate() {
+                LocalCache& local = Local();
+                if (local.head) {
+                    Block* block = local.head;
+                    local.head = block->next;
+                    --local.count;
+                    EventPoolCounters::Instance().pool_hits.fetch_add(1, std::memory_order_relaxed);
+                    return block;
+                }
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    if (free_list_) {
+                        Block* block = free_list_;
+                        free_list_ = block->next;
+                        --cached_;
+                        EventPoolCounters::Instance().pool_hits.fetch_add(1, std::memory_order_relaxed);
+                        return block;
+                    }
+                }
+                EventPoolCounters::Instance().heap_allocations.fetch_add(1, std::memory_order_relaxed);
+                return new Block;
+            }
+
+            void Deallocate(void* p) {
+                Block* block = static_cast<Block*>(p);
+                LocalCache& local = Local();
+                if (local.count < kLocalCachedBlocks) {
+                    block->next = local.head;
+                    local.head = block;
+                    ++local.count;
+                    return;
+                }
+                ReleaseShared(block);
+            }
+
+        private:
+            union Block {
+                Block* next;
+                alignas(kAlign) unsigned char storage[kSize];
+            };
+
+            /** @brief 线程退出时把本地缓存的块交还共享链表。 */
+            struct LocalCache {
+                Block* head = nullptr;
+                size_t count = 0;
+                ~LocalCache() {
+                    while (head) {
+                        Block* next = head->next;
+                        Instance().ReleaseShared(head);
+                        head = next;
+                    }
+                }
+            };
+
+            static LocalCache& Local() {
+                thread_local LocalCache cache;
+                return cache;
+            }
+
+            void ReleaseShared(Block* block) {
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    if (cached_ < kMaxCachedBlocks) {
+                        block->next = free_list_;
+                        free_list_ = block;
+                        ++cached_;
+                        return;
+                    }
+                }
+                delete block;
+            }
+
+            EventBlockPool() = default;
+
+            std::mutex mutex_;
+            Block* free_list_ = nullptr;
+            size_t cached_ = 0;
+        };
+
+        /** @brief [内部] 检测事件是否通过 `Z3Y_DEFINE_POOLED_EVENT` 声明为池化。 */
+        template <typename T, typename = void>
+        struct IsPooledEvent : std::false_type {};
+
+        template <typename T>
+        struct IsPooledEvent<T, std::void_t<decltype(T::kPooled)>>
+            : std::bool_constant<T::kPooled> {};
+
+    }  // namespace detail
+
+    /**
+     * @class EventPoolAllocator
+     * @brief 供 `std::allocate_shared` 使用的池化分配器。
+     *
+     * @details
+     * `allocate_shared` 会把它 rebind 到内部“控制块 + 对象”的合并类型，
+     * 因此实际缓存的是整块内存，一次 Fire 对应一次取块、一次还块。
+     */
+    template <typename T>
+    class EventPoolAllocator {
+    public:
+        using value_type = T;
+
+        EventPoolAllocator() noexcept = default;
+        template <typename U>
+        EventPoolAllocator(const EventPoolAllocator<U>&) noexcept {}
+
+        T* allocate(size_t n) {
+            if (n != 1) return std::allocator<T>().allocate(n);
+            return static_cast<T*>(detail::EventBlockPool<sizeof(T), alignof(T)>::Instance().Allocate());
+        }
+
+        void deallocate(T* p, size_t n) noexcept {
+            if (n != 1) {
+                std::allocator<T>().deallocate(p, n);
+                return;
+            }
+            detail::EventBlockPool<sizeof(T), alignof(T)>::Instance().Deallocate(p);
+        }
+
+        template <typename U>
+        bool operator==(const EventPoolAllocator<U>&) const noexcept { return true; }
+        template <typename U>
+        bool operator!=(const EventPoolAllocator<U>&) const noexcept { return false; }
+    };
+
+    /**
+     * @brief 构造一个事件对象。
+     * @details 池化事件走 `EventPoolAllocator`，普通事件保持 `std::make_shared`。
+     * `IEventBus::FireGlobal` / `FireToSender` 内部即使用此函数。
+     */
+    template <typename TEvent, typename... Args>
+    std::shared_ptr<TEvent> MakeEvent(Args&&... args) {
+        if constexpr (detail::IsPooledEvent<TEvent>::value) {
+            return std::allocate_shared<TEvent>(EventPoolAllocator<TEvent>(), std::forward<Args>(args)...);
+        } else {
+            return std::make_shared<TEvent>(std::forward<Args>(args)...);
+        }
+    }
+
+    /** @brief 读取当前模块 (DSO) 内事件池的累计统计。 */
+    inline EventPoolStats GetEventPoolStats() {
+        auto& counters = detail::EventPoolCounters::Instance();
+        EventPoolStats stats;
+        stats.heap_allocations = counters.heap_allocations.load(std::memory_order_relaxed);
+        stats.pool_hits = counters.pool_hits.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+}  // namespace z3y
+
+#endif  // Z3Y_FRAMEWORK_EVENT_POOL_H_
@@ -0,0 +1,292 @@
+﻿/*
+* Copyright [2025] [Yue Liu]
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/**
+ * @file event_recorder.h
+ * @brief [高级] 事件录制器 `EventRecorder` 与按原节奏回放的 `EventReplayer`。
+ * @author Yue Liu
+ * @date 2025
+ *
+ * @details
+ * [受众：宿主开发者 / 性能测试]
+ *
+ * 合成负载很难反映现场的真实流量 (突发、类型配比、负载大小)。录制器把选定的全局事件连同时间戳
+ * 写入一个紧凑的二进制文件，回放器再把它们按 1 倍速、N 倍速或尽可能快地重新 `FireGlobal` 到
+ * 某个 `PluginManager` 的总线上，从而得到基于真实流量的、可重复的吞吐量基准。
+ *
+ * - `Record<TEvent>()` 以 kDirect 订阅 `TEvent`，在发布线程上记下时间戳与事件 ID；
+ * 用 `Z3Y_DEFINE_SERIALIZABLE_EVENT` 声明的事件还会通过 `Serialize` 记下负载，其余事件只记 ID。
+ * - 写入先进入内存缓冲，攒够 `flush_bytes` 后在锁外追加到文件，发布线程不会逐条做系统调用。
+ * - 回放前整个文件被读入内存，回放循环中不做任何 I/O。
+ * - `EventReplayer::Register<TEvent>()` 注册还原方式：可序列化事件用 `Deserialize`，
+ * 其余事件必须可默认构造 (只还原“发生过”这一事实)。未注册的 ID 可选地以通用的
+ * `event::ReplayedEvent` 发布 (携带原始 ID 与负载字节)，供不了解具体类型的工具统计或转发。
+ *
+ * \code{.cpp}
+ * // 现场：录制
+ * std::string err;
+ * auto recorder = z3y::EventRecorder::Create("line3.z3yrec", bus, err);
+ * recorder->Record<FrameReadyEvent>();
+ * recorder->Record<DefectFoundEvent>();
+ * ...
+ * recorder->Stop();
+ *
+ * // 实验室：以 4 倍速回放
+ * auto replayer = z3y::EventReplayer::Open("line3.z3yrec", bus, err);
+ * replayer->Register<FrameReadyEvent>();
+ * replayer->Register<DefectFoundEvent>();
+ * z3y::ReplayOptions options;
+ * options.speed = 4.0;
+ * z3y::ReplayStats stats = replayer->Run(options);
+ * \endcode
+ *
+ * [文件格式] (小端)
+ * - 头部 24 字节：魔数 `"Z3YEVREC"`、u32 版本、u32 保留、u64 录制开始时刻 (Unix 纳秒)。
+ * - 每条记录：varint 距上一条的纳秒数、u64 事件 ID、varint (负载长度 + 1，0 表示无负载)、负载字节。
+ * 进程崩溃后留下的文件同样可以回放，末尾未写完的记录会被忽略。
+ *
+ * [注意]
+ * - 只录制全局事件。`FireToSender` 的发送者是进程内的对象地址，无法跨进程重现。
+ * - 录制的是 `FireGlobal` 的调用时刻 (发布线程上、在其他 kDirect 订阅者之前或之后取决于订阅顺序)。
+ * - `Register` 注册的还原函数位于调用方模块中：回放器必须在该模块卸载之前销毁。
+ */
+
+#pragma once
+
+#ifndef Z3Y_FRAMEWORK_EVENT_RECORDER_H_
+#define Z3Y_FRAMEWORK_EVENT_RECORDER_H_
+
+#include <cstddef>     // 用于 size_t
+#include <cstdint>     // 用于 uint64_t
+#include <filesystem>  // 用于 std::filesystem::path
+#include <memory>      // 用于 std::unique_ptr
+#include <string>      // 用于 std::string
+#include <type_traits>
+#include "framework/connection.h"           // 依赖 Connection
+#include "framework/event_helpers.h"        // 依赖 Z3Y_DEFINE_EVENT
+#include "framework/event_serialization.h"  // 依赖 EventWriter / EventReader
+#include "framework/i_event_bus.h"          // 依赖 IEventBus
+#include "framework/z3y_framework_api.h"    // Z3Y_FRAMEWORK_API 导出
+
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable : 4251)
+#endif
+
+namespace z3y {
+
+    namespace event {
+
+        /**
+         * @struct ReplayedEvent
+         * @brief 回放时遇到未注册还原方式的事件 ID 时发布的通用事件 (需开启 `ReplayOptions::raw_fallback`)。
+         */
+        struct ReplayedEvent : public Event {
+            Z3Y_DEFINE_EVENT(ReplayedEvent, "z3y-event-replayed-raw-E0000006");
+
+            //! 录制时的事件 ID
+            EventId original_id_ = 0;
+            //! 录制时刻 (相对录制开始的纳秒数)
+            uint64_t recorded_ns_ = 0;
+            //! 录制时是否带有负载 (只有可序列化事件才有)
+            bool has_payload_ = false;
+            //! 负载字节 (`Serialize` 的输出)
+            std::string payload_;
+
+            ReplayedEvent(EventId id, uint64_t recorded_ns, bool has_payload, std::string payload)
+                : original_id_(id), recorded_ns_(recorded_ns),
+                has_payload_(has_payload), payload_(std::move(payload)) {
+            }
+        };
+
+    }  // namespace event
+
+    /**
+     * @struct EventRecorderStats
+     * @brief 录制统计 (见 `EventRecorder::GetStats`)。
+     */
+    struct EventRecorderStats {
+        uint64_t recorded_events = 0;  //!< 已录制的事件数
+        uint64_t payload_bytes = 0;    //!< 其中负载字节的合计
+        uint64_t written_bytes = 0;    //!< 已写入文件的字节数 (含文件头)
+        uint64_t write_failures = 0;   //!< 写文件失败的次数 (失败的缓冲被丢弃)
+    };
+
+    /**
+     * @class EventRecorder
+     * @brief 把选定的全局事件录制到文件。
+     */
+    class Z3Y_FRAMEWORK_API EventRecorder {
+    public:
+        /** @brief 缓冲攒够多少字节后写入文件。 */
+        static constexpr size_t kDefaultFlushBytes = size_t(256) << 10;
+
+        /**
+         * @brief 创建 (覆盖) 录制文件并写入文件头。
+         * @return 失败时返回 nullptr，原因写入 `out_error_message`。
+         */
+        [[nodiscard]] static std::unique_ptr<EventRecorder> Create(const std::filesystem::path& path,
+            PluginPtr<IEventBus> bus, std::string& out_error_message, size_t flush_bytes = kDefaultFlushBytes);
+
+        /** @brief 等价于 `Stop()`。 */
+        ~EventRecorder();
+        EventRecorder(const EventRecorder&) = delete;
+        EventRecorder& operator=(const EventRecorder&) = delete;
+
+        /** @brief 开始录制 `TEvent`。重复调用只订阅一次；`Stop` 之后调用无效。 */
+        template <typename TEvent>
+        void Record() {
+            if (!BeginRecord(TEvent::kEventId)) return;
+            auto sink = std::make_shared<RecordSink<TEvent>>(this);
+            Connection conn = bus_->SubscribeGlobal<TEvent>(sink, &RecordSink<TEvent>::OnEvent);
+            AddSink(std::move(sink), std::move(conn));
+        }
+
+        /** @brief 把缓冲写入文件。@return 写入失败时返回 false。 */
+        bool Flush();
+
+        /** @brief 断开所有订阅、写出剩余缓冲并关闭文件。可重复调用。 */
+        void Stop();
+
+        [[nodiscard]] EventRecorderStats GetStats() const;
+
+    private:
+        struct Impl;
+
+        /** @brief 以 kDirect 订阅被录制事件的接收者。 */
+        template <typename TEvent>
+        class RecordSink : public std::enable_shared_from_this<RecordSink<TEvent>> {
+        public:
+            explicit RecordSink(EventRecorder* recorder) : recorder_(recorder) {}
+            void OnEvent(const TEvent& e) {
+                if constexpr (IsSerializableEvent<TEvent>::value) {
+                    thread_local EventWriter writer;
+                    writer.Clear();
+                    e.Serialize(writer);
+                    recorder_->Append(TEvent::kEventId, writer.Buffer().data(), writer.Size(), true);
+                } else {
+                    (void)e;
+                    recorder_->Append(TEvent::kEventId, nullptr, 0, false);
+                }
+            }
+
+        private:
+            EventRecorder* recorder_;
+        };
+
+        EventRecorder(std::unique_ptr<Impl> impl, PluginPtr<IEventBus> bus);
+
+        bool BeginRecord(EventId event_id);
+        void AddSink(std::shared_ptr<void> sink, Connection connection);
+        void Append(EventId event_id, const void* payload, size_t size, bool has_payload);
+
+        PluginPtr<IEventBus> bus_;
+        std::unique_ptr<Impl> impl_;
+    };
+
+    /**
+     * @struct ReplayOptions
+     * @brief `EventReplayer::Run` 的参数。
+     */
+    struct ReplayOptions {
+        //! 回放速度：1 为原速，N 为 N 倍速，0 (或负数) 为不等待、尽可能快
+        double speed = 1.0;
+        //! 整个录制重复回放的次数 (每轮从头按相同节奏开始)
+        uint32_t repeat = 1;
+        //! 未注册的事件 ID 是否以 `event::ReplayedEvent` 发布 (否则只计入 unknown_events)
+        bool raw_fallback = false;
+    };
+
+    /**
+     * @struct ReplayStats
+     * @brief 一次 `Run` 的统计。
+     */
+    struct ReplayStats {
+        uint64_t replayed_events = 0;   //!< 按注册类型还原并发布的事件数
+        uint64_t raw_events = 0;        //!< 以 `event::ReplayedEvent` 发布的事件数
+        uint64_t unknown_events = 0;    //!< 未注册且未发布的事件数
+        uint64_t decode_failures = 0;   //!< 还原或发布时抛出异常的事件数
+        uint64_t recorded_ns = 0;       //!< 录制本身跨越的时长 (单轮)
+        uint64_t elapsed_ns = 0;        //!< 回放实际耗时 (所有轮次)
+        uint64_t max_lag_ns = 0;        //!< 相对计划时刻的最大落后 (仅限速回放时有意义)
+
+        /** @brief 实际发布速率 (事件/秒)。 */
+        [[nodiscard]] double EventsPerSecond() const {
+            return elapsed_ns == 0 ? 0.0 : double(replayed_events + raw_events) * 1e9 / double(elapsed_ns);
+        }
+    };
+
+    /**
+     * @class EventReplayer
+     * @brief 把 `EventRecorder` 录下的文件重新发布到总线上。
+     */
+    class Z3Y_FRAMEWORK_API EventReplayer {
+    public:
+        /**
+         * @brief 读入整个录制文件并校验文件头。
+         * @return 文件不存在或不是录制文件时返回 nullptr，原因写入 `out_error_message`。
+         */
+        [[nodiscard]] static std::unique_ptr<EventReplayer> Open(const std::filesystem::path& path,
+            PluginPtr<IEventBus> bus, std::string& out_error_message);
+
+        ~EventReplayer();
+        EventReplayer(const EventReplayer&) = delete;
+        EventReplayer& operator=(const EventReplayer&) = delete;
+
+        /** @brief 注册 `TEvent` 的还原方式。重复注册以最后一次为准。 */
+        template <typename TEvent>
+        void Register() {
+            if constexpr (IsSerializableEvent<TEvent>::value) {
+                AddDecoder(TEvent::kEventId, [](IEventBus& bus, EventReader& reader) {
+                    bus.FireGlobal<TEvent>(TEvent::Deserialize(reader));
+                    });
+            } else {
+                static_assert(std::is_default_constructible_v<TEvent>,
+                    "EventReplayer::Register requires a serializable or default-constructible event");
+                AddDecoder(TEvent::kEventId, [](IEventBus& bus, EventReader&) {
+                    bus.FireGlobal<TEvent>();
+                    });
+            }
+        }
+
+        /** @brief 按 `options` 回放，阻塞到结束。发布在调用线程上进行。 */
+        ReplayStats Run(const ReplayOptions& options = ReplayOptions());
+
+        /** @brief 录制开始时刻 (Unix 纳秒，来自文件头)。 */
+        [[nodiscard]] uint64_t GetStartTimeNs() const;
+
+        /** @brief 文件中完整记录的条数。 */
+        [[nodiscard]] uint64_t GetEventCount() const;
+
+    private:
+        using Decoder = void (*)(IEventBus&, EventReader&);
+        struct Impl;
+
+        EventReplayer(std::unique_ptr<Impl> impl, PluginPtr<IEventBus> bus);
+
+        void AddDecoder(EventId event_id, Decoder decoder);
+
+        PluginPtr<IEventBus> bus_;
+        std::unique_ptr<Impl> impl_;
+    };
+
+}  // namespace z3y
+
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+#endif  // Z3Y_FRAMEWORK_EVENT_RECORDER_H_
@@ -0,0 +1,174 @@
+﻿/*
+* Copyright [2025] [Yue Liu]
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/**
+ * @file event_request.h
+ * @brief 事件总线请求/应答 (`IEventBus::Request`) 的错误类型与类型擦除的请求状态。
+ * @author Yue Liu
+ * @date 2025
+ *
+ * @details
+ * [受众：插件开发者 (请求/应答)]
+ *
+ * 请求就是一个普通的 `Z3Y_DEFINE_EVENT` 事件，总线按它的 `kEventId` 找到唯一的处理者，
+ * 处理者的返回值直接写回请求者的 future (或回调)，不经过订阅快照，也不会再发布一次事件。
+ * 回复、超时、失败三者谁先到谁生效 (`RequestStateBase::TryClaim`)，其余的被丢弃。
+ */
+
+#pragma once
+
+#ifndef Z3Y_FRAMEWORK_EVENT_REQUEST_H_
+#define Z3Y_FRAMEWORK_EVENT_REQUEST_H_
+
+#include <atomic>       // 用于 std::atomic
+#include <exception>    // 用于 std::exception_ptr
+#include <functional>   // 用于 std::function
+#include <future>       // 用于 std::promise / std::future
+#include <memory>       // 用于 std::shared_ptr
+#include <optional>     // 用于 std::optional
+#include <stdexcept>    // 用于 std::runtime_error
+#include <string>       // 用于 std::string
+#include <typeinfo>     // 用于 typeid
+#include <utility>      // 用于 std::move
+
+namespace z3y {
+
+    struct Event;
+
+    /** @brief 请求失败的原因。 */
+    enum class RequestErrorCode {
+        kNoHandler,     //!< 该请求类型当前没有处理者
+        kTimeout,       //!< 在超时时间内没有收到回复
+        kHandlerGone,   //!< 请求排队期间处理者已断开或被销毁
+        kTypeMismatch,  //!< 处理者返回的类型与请求者期待的 TResp 不一致
+        kRejected       //!< 执行器已停止或丢弃了请求任务，请求没有执行
+    };
+
+    /**
+     * @class RequestError
+     * @brief 请求没有得到回复时，从 `future.get()` (或回调的 error) 中抛出。
+     * @details 处理者自己抛出的异常原样传给请求者，不会被包装成 RequestError。
+     */
+    class RequestError : public std::runtime_error {
+    public:
+        RequestError(RequestErrorCode code, const std::string& what)
+            : std::runtime_error(what), code_(code) {}
+
+        [[nodiscard]] RequestErrorCode code() const noexcept { return code_; }
+
+    private:
+        RequestErrorCode code_;
+    };
+
+    namespace detail {
+        /**
+         * @class RequestStateBase
+         * @brief [内部] 一次请求的类型擦除状态，由请求者创建，总线与处理者共享。
+         */
+        class RequestStateBase {
+        public:
+            virtual ~RequestStateBase() = default;
+
+            /** @brief 请求事件本身 (处理者侧按具体类型读取)。 */
+            [[nodiscard]] virtual const Event& RequestEvent() const noexcept = 0;
+
+            /** @brief 请求者期待的回复类型 (`typeid(TResp).name()`)，总线据此拒绝类型不符的处理者。 */
+            [[nodiscard]] virtual const char* ResponseType() const noexcept = 0;
+
+            /** @brief 取得完成权。回复、超时、失败只有第一个拿到它的生效。 */
+            [[nodiscard]] bool TryClaim() noexcept { return !completed_.exchange(true, std::memory_order_acq_rel); }
+
+            [[nodiscard]] bool IsCompleted() const noexcept { return completed_.load(std::memory_order_acquire); }
+
+            /**
+             * @brief 以异常结束请求。
+             * @return 请求已经完成 (回复或超时先到) 时返回 false，error 被丢弃。
+             */
+            bool Fail(std::exception_ptr error) {
+                if (!TryClaim()) return false;
+                FailClaimed(std::move(error));
+                return true;
+            }
+
+        protected:
+            /** @brief 已取得完成权后把异常交给请求者。 */
+            virtual void FailClaimed(std::exception_ptr error) = 0;
+
+        private:
+            std::atomic<bool> completed_{ false };
+        };
+
+        /**
+         * @class RequestState
+         * @brief [内部] `RequestStateBase` 的具体类型：持有请求事件和 promise (或完成回调)。
+         */
+        template <typename TReq, typename TResp>
+        class RequestState final : public RequestStateBase {
+        public:
+            /** @brief 完成回调：成功时 response 非空、error 为空；失败时相反。 */
+            using Callback = std::function<void(TResp* response, std::exception_ptr error)>;
+
+            explicit RequestState(TReq request) : request_(std::move(request)) { promise_.emplace(); }
+            RequestState(TReq request, Callback callback)
+                : request_(std::move(request)), callback_(std::move(callback)) {}
+
+            /** @brief 没有任何一方完成就被释放 (请求任务被执行器丢弃) 时，以 kRejected 结束。 */
+            ~RequestState() override {
+                if (!TryClaim()) return;
+                try {
+                    FailClaimed(std::make_exception_ptr(
+                        RequestError(RequestErrorCode::kRejected, "z3y: request was dropped before it ran")));
+                } catch (...) {
+                    // 析构中不能再抛出；完成回调自己的异常在这里丢弃
+                }
+            }
+
+            [[nodiscard]] const Event& RequestEvent() const noexcept override { return request_; }
+            [[nodiscard]] const char* ResponseType() const noexcept override { return typeid(TResp).name(); }
+            [[nodiscard]] const TReq& Request() const noexcept { return request_; }
+
+            /** @brief 只对 future 版本有效，且只能调用一次。 */
+            [[nodiscard]] std::future<TResp> GetFuture() { return promise_->get_future(); }
+
+            /** @brief 写入回复。请求已经超时或失败时丢弃。 */
+            void Reply(TResp response) {
+                if (!TryClaim()) return;
+                if (callback_) callback_(&response, nullptr);
+                else promise_->set_value(std::move(response));
+            }
+
+        protected:
+            void FailClaimed(std::exception_ptr error) override {
+                if (callback_) callback_(nullptr, std::move(error));
+                else promise_->set_exception(std::move(error));
+            }
+
+        private:
+            TReq request_;
+            std::optional<std::promise<TResp>> promise_;
+            Callback callback_;
+        };
+
+        /**
+         * @brief [内部] 处理者调用器：用处理者对象执行请求并写回回复。
+         * @details 由 `HandleRequests` 在处理者所在模块中生成；调用前总线已核对过回复类型。
+         */
+        using RequestInvoker = std::function<void(const std::shared_ptr<void>& handler, RequestStateBase& state)>;
+    }  // namespace detail
+
+}  // namespace z3y
+
+#endif  // Z3Y_FRAMEWORK_EVENT_REQUEST_H_
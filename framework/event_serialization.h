@@ -0,0 +1,153 @@
+﻿/*
+* Copyright [2025] [Yue Liu]
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/**
+ * @file event_serialization.h
+ * @brief 可序列化事件的读写器 `EventWriter` / `EventReader` 与 `IsSerializableEvent` 特征。
+ * @author Yue Liu
+ * @date 2025
+ *
+ * @details
+ * [受众：插件开发者 (跨进程事件)]
+ *
+ * 格式刻意保持最简单：按成员顺序紧密排列的原始字节，不带字段名、不做字节序转换。
+ * 两端必须是同一台机器上用同一份事件定义编译的进程 (这正是 `IpcEventBridge` 的场景)。
+ * 字符串与字节块前面有 32 位长度。读越界时抛出 `std::out_of_range`，桥接器会丢弃该事件并计数。
+ */
+
+#pragma once
+
+#ifndef Z3Y_FRAMEWORK_EVENT_SERIALIZATION_H_
+#define Z3Y_FRAMEWORK_EVENT_SERIALIZATION_H_
+
+#include <cstddef>      // 用于 size_t
+#include <cstdint>      // 用于 uint32_t
+#include <cstring>      // 用于 std::memcpy
+#include <stdexcept>    // 用于 std::out_of_range
+#include <string>       // 用于 std::string
+#include <string_view>  // 用于 std::string_view
+#include <type_traits>  // 用于 std::is_trivially_copyable_v
+
+namespace z3y {
+
+    /**
+     * @class EventWriter
+     * @brief 把事件成员追加到一段连续字节中。
+     */
+    class EventWriter {
+    public:
+        /** @brief 写入一个可平凡拷贝的值 (整数、浮点、枚举、POD 结构体)。 */
+        template <typename T>
+        void Write(const T& value) {
+            static_assert(std::is_trivially_copyable_v<T>, "EventWriter::Write requires a trivially copyable type");
+            WriteRaw(&value, sizeof(T));
+        }
+
+        /** @brief 写入带 32 位长度前缀的字符串。 */
+        void WriteString(std::string_view str) { WriteBytes(str.data(), str.size()); }
+
+        /** @brief 写入带 32 位长度前缀的字节块。 */
+        void WriteBytes(const void* data, size_t size) {
+            Write(static_cast<uint32_t>(size));
+            WriteRaw(data, size);
+        }
+
+        /** @brief 不带长度前缀地追加原始字节。 */
+        void WriteRaw(const void* data, size_t size) {
+            buffer_.append(static_cast<const char*>(data), size);
+        }
+
+        [[nodiscard]] const std::string& Buffer() const noexcept { return buffer_; }
+        [[nodiscard]] size_t Size() const noexcept { return buffer_.size(); }
+
+        /** @brief 清空内容但保留容量，便于同一线程反复使用。 */
+        void Clear() noexcept { buffer_.clear(); }
+
+    private:
+        std::string buffer_;
+    };
+
+    /**
+     * @class EventReader
+     * @brief 按写入顺序读回事件成员。不拥有数据，数据须在读取期间有效。
+     */
+    class EventReader {
+    public:
+        EventReader(const void* data, size_t size) noexcept
+            : data_(static_cast<const char*>(data)), size_(size) {}
+
+        /** @throws std::out_of_range 剩余字节不足。 */
+        template <typename T>
+        [[nodiscard]] T Read() {
+            static_assert(std::is_trivially_copyable_v<T>, "EventReader::Read requires a trivially copyable type");
+            T value;
+            ReadRaw(&value, sizeof(T));
+            return value;
+        }
+
+        /** @throws std::out_of_range 剩余字节不足。 */
+        [[nodiscard]] std::string ReadString() {
+            const uint32_t size = Read<uint32_t>();
+            Require(size);
+            std::string str(data_ + pos_, size);
+            pos_ += size;
+            return str;
+        }
+
+        /**
+         * @brief 读取带长度前缀的字节块，返回指向原数据的视图 (不拷贝)。
+         * @throws std::out_of_range 剩余字节不足。
+         */
+        [[nodiscard]] std::string_view ReadBytes() {
+            const uint32_t size = Read<uint32_t>();
+            Require(size);
+            std::string_view view(data_ + pos_, size);
+            pos_ += size;
+            return view;
+        }
+
+        /** @throws std::out_of_range 剩余字节不足。 */
+        void ReadRaw(void* out, size_t size) {
+            Require(size);
+            std::memcpy(out, data_ + pos_, size);
+            pos_ += size;
+        }
+
+        [[nodiscard]] size_t Remaining() const noexcept { return size_ - pos_; }
+
+    private:
+        void Require(size_t size) const {
+            if (size > size_ - pos_) throw std::out_of_range("z3y::EventReader: truncated event payload");
+        }
+
+        const char* data_;
+        size_t size_;
+        size_t pos_ = 0;
+    };
+
+    /**
+     * @brief 判断事件是否用 `Z3Y_DEFINE_SERIALIZABLE_EVENT` 声明 (与 `kPooled` 的检测方式相同)。
+     */
+    template <typename T, typename = void>
+    struct IsSerializableEvent : std::false_type {};
+
+    template <typename T>
+    struct IsSerializableEvent<T, std::void_t<decltype(T::kSerializable)>>
+        : std::bool_constant<T::kSerializable> {};
+
+}  // namespace z3y
+
+#endif  // Z3Y_FRAMEWORK_EVENT_SERIALIZATION_H_
@@ -0,0 +1,375 @@
+﻿/*
+* Copyright [2025] [Yue Liu]
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/**
+ * @file event_window.h
+ * @brief 事件总线上的窗口聚合算子 `z3y::EventWindow`：按时间窗口汇总一个数值字段，只发布摘要事件。
+ * @author Yue Liu
+ * @date 2025
+ *
+ * @details
+ * [受众：插件开发者 (统计、监控类订阅者)]
+ *
+ * 很多订阅者只是在统计速率、计数或均值 (例如每分钟缺陷数)，却要为每个事件执行一次回调。
+ * `EventWindow` 挂接到 TEvent 的通道上 (同步回调，只做一次加锁累加)，按窗口计算所选数值字段的
+ * count / sum / min / max / mean 与分位数，窗口结束时发布一个摘要事件；下游只订阅摘要事件，
+ * 回调次数从“每个事件一次”降到“每个窗口一次”。
+ * - **滚动窗口** (`step` 为 0)：每个 `window` 发布一次，窗口互不重叠；
+ * - **滑动窗口** (`step` 整除 `window`)：每个 `step` 发布一次，覆盖最近的 `window`。
+ *   内部按 `step` 分片累加，滑动时只合并分片，不保留原始样本。
+ * - 分位数使用相对误差有界的对数分桶 (默认 1%)，内存只与数值的动态范围有关，与事件数无关。
+ *
+ * 摘要事件由使用者定义 (继承 `EventWindowSummary`)，每个窗口算子一种类型，订阅方式与普通事件相同：
+ * \code{.cpp}
+ * struct DefectRateEvent : z3y::EventWindowSummary {
+ *     Z3Y_DEFINE_EVENT(DefectRateEvent, "defect-rate-event-uuid")
+ * };
+ * z3y::EventWindowOptions options;
+ * options.window = std::chrono::minutes(1);
+ * options.percentiles = { 0.5, 0.99 };
+ * window_ = z3y::EventWindow<DefectFoundEvent, DefectRateEvent>::Attach(bus, timers, options,
+ *     [](const DefectFoundEvent& e) { return e.area; });
+ * // 下游：每分钟一次
+ * conn_ = bus->SubscribeGlobal<DefectRateEvent>(shared_from_this(), &Dashboard::OnDefectRate);
+ * \endcode
+ *
+ * [生命周期]
+ * 算子由返回的 `shared_ptr` 持有；释放或 `Detach()` 后不再订阅、不再发布。
+ * 定时器与订阅只持有弱引用。插件必须在 `Shutdown()` 中 `Detach()` (与其他定时器相同)。
+ */
+
+#pragma once
+
+#ifndef Z3Y_FRAMEWORK_EVENT_WINDOW_H_
+#define Z3Y_FRAMEWORK_EVENT_WINDOW_H_
+
+#include <algorithm>    // 用于 std::min, std::max
+#include <chrono>       // 用于 std::chrono
+#include <cmath>        // 用于 std::log, std::exp, std::isnan
+#include <cstddef>      // 用于 size_t
+#include <cstdint>      // 用于 uint64_t
+#include <functional>   // 用于 std::function
+#include <limits>       // 用于 std::numeric_limits
+#include <memory>       // 用于 std::shared_ptr, std::enable_shared_from_this
+#include <mutex>        // 用于 std::mutex
+#include <stdexcept>    // 用于 std::invalid_argument
+#include <type_traits>  // 用于 std::is_base_of_v
+#include <utility>      // 用于 std::move
+#include <vector>       // 用于 std::vector
+#include "framework/connection.h"       // 依赖 Connection
+#include "framework/event_channel.h"    // 依赖 EventChannel
+#include "framework/i_event_bus.h"      // 依赖 IEventBus, Event
+#include "framework/i_timer_service.h"  // 依赖 ITimerService
+
+namespace z3y {
+
+    /**
+     * @struct EventWindowOptions
+     * @brief 窗口聚合算子的参数。
+     */
+    struct EventWindowOptions {
+        /** @brief 窗口长度。 */
+        std::chrono::nanoseconds window = std::chrono::seconds(60);
+        /** @brief 滑动步长。0 表示滚动窗口 (等于 window)；非 0 时必须整除 window。 */
+        std::chrono::nanoseconds step = std::chrono::nanoseconds(0);
+        /** @brief 需要计算的分位数 (0..1，如 0.5、0.99)。为空时不维护分桶，每个事件只做四次累加。 */
+        std::vector<double> percentiles;
+        /** @brief 分位数的相对误差上界。 */
+        double relative_accuracy = 0.01;
+        /** @brief 窗口内没有事件时是否仍然发布 (count 为 0，其余字段为 0)。 */
+        bool emit_empty = false;
+    };
+
+    /**
+     * @struct EventWindowSummary
+     * @brief 一个窗口的汇总结果。摘要事件类型必须继承它并使用 `Z3Y_DEFINE_EVENT`。
+     * @details 时间为 `steady_clock` 纳秒。字段值为 NaN 的事件不计入任何统计。
+     */
+    struct EventWindowSummary : public Event {
+        uint64_t window_start_ns = 0;  //!< 窗口起点 (滑动窗口在刚挂接时可能短于 window)
+        uint64_t window_end_ns = 0;    //!< 窗口终点
+        uint64_t count = 0;            //!< 事件数
+        double sum = 0.0;              //!< 字段之和
+        double min = 0.0;              //!< 最小值 (count 为 0 时为 0)
+        double max = 0.0;              //!< 最大值 (count 为 0 时为 0)
+        double mean = 0.0;             //!< 均值 (count 为 0 时为 0)
+        std::vector<double> percentiles;  //!< 与 `EventWindowOptions::percentiles` 一一对应
+    };
+
+    namespace detail {
+
+        /**
+         * @class WindowQuantileSketch
+         * @brief 相对误差有界的对数分桶 (DDSketch 的简化版)：第 k 桶覆盖 (γ^(k-1), γ^k]。
+         * @details 正数、负数 (按绝对值) 各一组稠密桶数组，按需向两端扩展；合并即逐桶相加。
+         */
+        class WindowQuantileSketch {
+        public:
+            explicit WindowQuantileSketch(double relative_accuracy = 0.01) {
+                const double a = std::min(std::max(relative_accuracy, 1e-6), 0.5);
+                gamma_ = (1.0 + a) / (1.0 - a);
+                inv_log_gamma_ = 1.0 / std::log(gamma_);
+            }
+
+            void Add(double value) {
+                if (value > kMinIndexable) positive_.Add(KeyOf(value), 1);
+                else if (value < -kMinIndexable) negative_.Add(KeyOf(-value), 1);
+                else ++zeros_;
+            }
+
+            void Merge(const WindowQuantileSketch& other) {
+                positive_.Merge(other.positive_);
+                negative_.Merge(other.negative_);
+                zeros_ += other.zeros_;
+            }
+
+            void Clear() {
+                positive_.Clear();
+                negative_.Clear();
+                zeros_ = 0;
+            }
+
+            /** @brief 第 q 分位数 (count 为 Add 的总次数，必须大于 0)。 */
+            [[nodiscard]] double Quantile(double q, uint64_t count) const {
+                q = std::min(std::max(q, 0.0), 1.0);
+                const uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(count - 1));
+                uint64_t seen = 0;
+                // 负数：绝对值大的在前
+                for (size_t i = negative_.bins.size(); i-- > 0;) {
+                    seen += negative_.bins[i];
+                    if (seen > rank) return -ValueOf(negative_.offset + static_cast<int>(i));
+                }
+                seen += zeros_;
+                if (seen > rank) return 0.0;
+                for (size_t i = 0; i < positive_.bins.size(); ++i) {
+                    seen += positive_.bins[i];
+                    if (seen > rank) return ValueOf(positive_.offset + static_cast<int>(i));
+                }
+                return positive_.bins.empty() ? 0.0 : ValueOf(positive_.offset + static_cast<int>(positive_.bins.size()) - 1);
+            }
+
+        private:
+            static constexpr double kMinIndexable = 1e-300;
+
+            struct Store {
+                std::vector<uint64_t> bins;
+                int offset = 0;  //!< bins[0] 对应的桶号
+
+                void Add(int key, uint64_t n) {
+                    if (bins.empty()) {
+                        bins.assign(1, 0);
+                        offset = key;
+                    } else if (key < offset) {
+                        bins.insert(bins.begin(), static_cast<size_t>(offset - key), 0);
+                        offset = key;
+                    } else if (key - offset >= static_cast<int>(bins.size())) {
+                        bins.resize(static_cast<size_t>(key - offset) + 1, 0);
+                    }
+                    bins[static_cast<size_t>(key - offset)] += n;
+                }
+
+                void Merge(const Store& other) {
+                    for (size_t i = 0; i < other.bins.size(); ++i) {
+                        if (other.bins[i]) Add(other.offset + static_cast<int>(i), other.bins[i]);
+                    }
+                }
+
+                void Clear() {
+                    // 保留容量：下一个窗口的数值范围通常相同
+                    std::fill(bins.begin(), bins.end(), 0);
+                }
+            };
+
+            [[nodiscard]] int KeyOf(double abs_value) const {
+                return static_cast<int>(std::ceil(std::log(abs_value) * inv_log_gamma_));
+            }
+
+            /** @brief 桶的代表值：使桶内任何值的相对误差都不超过 relative_accuracy。 */
+            [[nodiscard]] double ValueOf(int key) const {
+                return 2.0 * std::pow(gamma_, key) / (gamma_ + 1.0);
+            }
+
+            double gamma_ = 1.0;
+            double inv_log_gamma_ = 1.0;
+            Store positive_;
+            Store negative_;
+            uint64_t zeros_ = 0;
+        };
+
+        /** @brief 一个步长分片的累加值。 */
+        struct WindowPane {
+            uint64_t start_ns = 0;
+            uint64_t count = 0;
+            double sum = 0.0;
+            double min = std::numeric_limits<double>::infinity();
+            double max = -std::numeric_limits<double>::infinity();
+            WindowQuantileSketch sketch;
+        };
+
+        inline uint64_t WindowNowNs() {
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count());
+        }
+
+    }  // namespace detail
+
+    /**
+     * @class EventWindow
+     * @brief 挂接在 TEvent 上的窗口聚合算子，每个窗口发布一次 TSummary。
+     * @tparam TEvent 被聚合的事件类型。
+     * @tparam TSummary 摘要事件类型 (继承 `EventWindowSummary`)。
+     *
+     * @details
+     * 事件回调在发布线程上执行，各线程竞争同一把互斥锁，临界区只有几次累加 (有分位数时再加一次 log)。
+     * 窗口由定时器服务按 `step` 推进，摘要在定时器回调中锁外发布。
+     */
+    template <typename TEvent, typename TSummary>
+    class EventWindow : public std::enable_shared_from_this<EventWindow<TEvent, TSummary>> {
+        static_assert(std::is_base_of_v<Event, TEvent>, "TEvent must derive from z3y::Event");
+        static_assert(std::is_base_of_v<EventWindowSummary, TSummary>, "TSummary must derive from z3y::EventWindowSummary");
+
+    public:
+        /** @brief 从事件中取出被聚合的数值。 */
+        using FieldSelector = std::function<double(const TEvent&)>;
+
+        /**
+         * @brief 创建算子并开始聚合。
+         * @throws std::invalid_argument window 不为正、step 不整除 window、field 为空。
+         */
+        [[nodiscard]] static std::shared_ptr<EventWindow> Attach(const PluginPtr<IEventBus>& bus,
+            const PluginPtr<ITimerService>& timers, const EventWindowOptions& options, FieldSelector field) {
+            if (!bus || !timers) throw std::invalid_argument("EventWindow requires an event bus and a timer service");
+            auto self = std::shared_ptr<EventWindow>(new EventWindow(bus, timers, options, std::move(field)));
+            std::weak_ptr<EventWindow> weak = self;
+            self->timer_ = timers->StartPeriodic(options.step.count() > 0 ? options.step : options.window,
+                [weak]() { if (auto strong = weak.lock()) strong->Advance(); });
+            self->connection_ = bus->GetChannel<TEvent>().Subscribe(self, &EventWindow::OnEvent);
+            return self;
+        }
+
+        ~EventWindow() { Detach(); }
+
+        EventWindow(const EventWindow&) = delete;
+        EventWindow& operator=(const EventWindow&) = delete;
+
+        /** @brief 停止订阅与定时器。正在累加的窗口被丢弃。可重复调用。 */
+        void Detach() {
+            connection_.Disconnect();
+            if (timers_ && timer_) timers_->StopTimer(timer_);
+            timer_ = 0;
+        }
+
+        /**
+         * @brief 立即结束当前步长分片并发布一次摘要 (定时器到期时调用的就是它)。
+         * @details 也可以由使用者在定时器之外驱动，例如按帧计数推进窗口，此时把 window 设得足够大即可。
+         */
+        void Advance() {
+            TSummary summary;
+            if (!CloseCurrentPane(summary)) return;
+            if (auto bus = bus_.lock()) bus->template FireGlobal<TSummary>(std::move(summary));
+        }
+
+    private:
+        EventWindow(const PluginPtr<IEventBus>& bus, const PluginPtr<ITimerService>& timers,
+            const EventWindowOptions& options, FieldSelector field)
+            : bus_(bus), timers_(timers), field_(std::move(field)), percentiles_(options.percentiles),
+            emit_empty_(options.emit_empty) {
+            const auto step = options.step.count() > 0 ? options.step : options.window;
+            if (options.window.count() <= 0 || options.window.count() % step.count() != 0) {
+                throw std::invalid_argument("EventWindow step must be positive and divide the window");
+            }
+            if (!field_) throw std::invalid_argument("EventWindow requires a field selector");
+            const size_t pane_count = static_cast<size_t>(options.window.count() / step.count());
+            panes_.assign(pane_count, detail::WindowPane{ 0, 0, 0.0, std::numeric_limits<double>::infinity(),
+                -std::numeric_limits<double>::infinity(), detail::WindowQuantileSketch(options.relative_accuracy) });
+            merged_sketch_ = detail::WindowQuantileSketch(options.relative_accuracy);
+            panes_[0].start_ns = detail::WindowNowNs();
+        }
+
+        void OnEvent(const TEvent& event) {
+            const double value = field_(event);
+            if (std::isnan(value)) return;
+            std::lock_guard<std::mutex> lock(mutex_);
+            detail::WindowPane& pane = panes_[current_];
+            ++pane.count;
+            pane.sum += value;
+            pane.min = std::min(pane.min, value);
+            pane.max = std::max(pane.max, value);
+            if (!percentiles_.empty()) pane.sketch.Add(value);
+        }
+
+        /** @brief 合并最近 window 内的分片得到摘要，然后开启下一个分片。窗口为空且不发布空窗口时返回 false。 */
+        bool CloseCurrentPane(TSummary& out) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            const uint64_t now = detail::WindowNowNs();
+            EventWindowSummary& summary = out;
+            summary.window_end_ns = now;
+            summary.window_start_ns = now;
+            summary.min = std::numeric_limits<double>::infinity();
+            summary.max = -std::numeric_limits<double>::infinity();
+            if (!percentiles_.empty()) merged_sketch_.Clear();
+            for (const detail::WindowPane& pane : panes_) {
+                if (pane.start_ns == 0) continue;  // 刚挂接的滑动窗口：还没轮到的分片
+                summary.window_start_ns = std::min(summary.window_start_ns, pane.start_ns);
+                if (pane.count == 0) continue;
+                summary.count += pane.count;
+                summary.sum += pane.sum;
+                summary.min = std::min(summary.min, pane.min);
+                summary.max = std::max(summary.max, pane.max);
+                if (!percentiles_.empty()) merged_sketch_.Merge(pane.sketch);
+            }
+            if (summary.count == 0) {
+                summary.min = summary.max = 0.0;
+                summary.percentiles.assign(percentiles_.size(), 0.0);
+            } else {
+                summary.mean = summary.sum / static_cast<double>(summary.count);
+                summary.percentiles.reserve(percentiles_.size());
+                for (double q : percentiles_) {
+                    // 分桶的代表值可能略微越过真实的极值
+                    const double value = merged_sketch_.Quantile(q, summary.count);
+                    summary.percentiles.push_back(std::min(std::max(value, summary.min), summary.max));
+                }
+            }
+
+            // 下一个分片覆盖最旧的那个
+            current_ = (current_ + 1) % panes_.size();
+            detail::WindowPane& next = panes_[current_];
+            next.start_ns = now;
+            next.count = 0;
+            next.sum = 0.0;
+            next.min = std::numeric_limits<double>::infinity();
+            next.max = -std::numeric_limits<double>::infinity();
+            if (!percentiles_.empty()) next.sketch.Clear();
+            return summary.count != 0 || emit_empty_;
+        }
+
+        std::weak_ptr<IEventBus> bus_;
+        PluginPtr<ITimerService> timers_;
+        FieldSelector field_;
+        const std::vector<double> percentiles_;
+        const bool emit_empty_;
+        Connection connection_;
+        TimerId timer_ = 0;
+
+        std::mutex mutex_;
+        std::vector<detail::WindowPane> panes_;  //!< 环形：panes_[current_] 正在累加
+        size_t current_ = 0;
+        detail::WindowQuantileSketch merged_sketch_;  //!< 合并用的临时分桶 (复用容量)
+    };
+
+}  // namespace z3y
+
+#endif  // Z3Y_FRAMEWORK_EVENT_WINDOW_H_
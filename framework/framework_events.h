@@ -46,6 +46,7 @@
 #define Z3Y_FRAMEWORK_FRAMEWORK_EVENTS_H_
 
 #include <string>                       // 用于 std::string
+#include <vector>                       // 用于 std::vector
 #include "framework/class_id.h"         // 依赖 ClassId
 #include "framework/event_helpers.h"    // 依赖 Z3Y_DEFINE_EVENT
 #include "framework/i_event_bus.h"      // 依赖 Event
@@ -93,6 +94,26 @@ namespace z3y {
             }
         };
 
+        /**
+         * @struct PluginUnloadEvent
+         * @brief 当一个插件被 `PluginManager::UnloadPlugin` 单独卸载后触发的事件。
+         * @details 这是一个全局广播事件。触发时插件的组件已从注册表移除，库也已卸载。
+         */
+        struct PluginUnloadEvent : public Event {
+            //! 定义事件的元数据 (ID 和 Name)
+            Z3Y_DEFINE_EVENT(PluginUnloadEvent,
+                "z3y-event-plugin-unload-E0000005");
+
+            //! 被卸载的插件的完整路径
+            std::string plugin_path_;
+            //! 随之移除的全部 ClassId
+            std::vector<ClassId> clsids_;
+
+            PluginUnloadEvent(std::string path, std::vector<ClassId> clsids)
+                : plugin_path_(std::move(path)), clsids_(std::move(clsids)) {
+            }
+        };
+
         // --- 2. 组件注册事件 ---
 
         /**
@@ -126,6 +147,27 @@ namespace z3y {
             }
         };
 
+        /**
+         * @struct ComponentsRegisteredEvent
+         * @brief 一批组件 (通常是一个插件的全部组件) 被一次性发布后触发的合并事件。
+         * @details 这是一个全局广播事件，每批只触发一次；
+         * 只关心“注册表变了”的订阅者应优先订阅它，而不是逐个组件的 `ComponentRegisterEvent`。
+         */
+        struct ComponentsRegisteredEvent : public Event {
+            //! 定义事件的元数据 (ID 和 Name)
+            Z3Y_DEFINE_EVENT(ComponentsRegisteredEvent,
+                "z3y-event-components-registered-E0000004");
+
+            //! 来源插件的完整路径 (运行期手动注册时为空)
+            std::string plugin_path_;
+            //! 本批发布的全部 ClassId (按注册顺序)
+            std::vector<ClassId> clsids_;
+
+            ComponentsRegisteredEvent(std::string path, std::vector<ClassId> clsids)
+                : plugin_path_(std::move(path)), clsids_(std::move(clsids)) {
+            }
+        };
+
     }  // namespace event
 }  // namespace z3y
 
@@ -0,0 +1,159 @@
+﻿/*
+* Copyright [2025] [Yue Liu]
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/**
+ * @file i_allocator_service.h
+ * @brief 定义框架共享的小对象分配服务 IAllocatorService：线程帧内存 (arena) 与分级内存池。
+ * @author Yue Liu
+ * @date 2025
+ *
+ * @details
+ * [受众：插件开发者 (按帧处理的任务) 和 框架使用者]
+ *
+ * 每帧处理流程往往要分配大量短命的小对象 (临时数组、字符串、中间结果)，全部经过全局分配器，
+ * 多线程下争用明显。`IAllocatorService` 以标准 `std::pmr::memory_resource` 的形式提供两类内存：
+ * - **线程帧内存** (`GetThreadArena`)：每个线程一个单调递增的 arena，分配只是移动指针，释放什么也不做；
+ * 用 `FrameArenaScope` 圈定一帧，作用域结束时一次性回收这段时间内的全部分配 (内存块留给下一帧复用)。
+ * - **分级内存池** (`GetPoolResource`)：线程安全的按大小分级池 (`std::pmr::synchronized_pool_resource`)，
+ * 可以跨线程释放，适合生命周期跨帧的小对象。在插件 `Initialize()` 中获取的资源记到该插件名下
+ * (需要 `PluginManagerOptions::enable_memory_accounting`，见 `IPluginQuery::GetPluginMemoryUsage`)。
+ *
+ * \code{.cpp}
+ * auto alloc = z3y::GetService<z3y::IAllocatorService>(z3y::clsid::kAllocator);
+ * void OnFrame(const FrameReadyEvent& e) {
+ *     z3y::FrameArenaScope frame(*alloc);
+ *     std::pmr::vector<Blob> blobs(frame.Resource());   // 本帧的临时数据
+ *     std::pmr::string label(frame.Resource());
+ *     Detect(e.pixels, blobs);
+ * }   // 作用域结束：blobs / label 占用的内存全部回收
+ * \endcode
+ *
+ * `PluginManagerOptions::framework_pool_allocations` 让框架自身的热点容器 (订阅列表快照、
+ * 异步派发任务的闭包) 也改用分级内存池。
+ *
+ * [约定]
+ * - 线程帧内存只能在获取它的线程上使用；作用域结束后，其中的对象必须已经析构 (或无需析构)。
+ * - 两类内存都属于框架：`PluginManager` 销毁时分级内存池整体释放，从中分配的对象不得比框架活得更久。
+ */
+
+#pragma once
+
+#ifndef Z3Y_FRAMEWORK_I_ALLOCATOR_SERVICE_H_
+#define Z3Y_FRAMEWORK_I_ALLOCATOR_SERVICE_H_
+
+#include <cstddef>          // 用于 size_t
+#include <cstdint>          // 用于 uint64_t
+#include <memory_resource>  // 用于 std::pmr::memory_resource
+#include "framework/class_id.h"           // 依赖 ClassId
+#include "framework/i_component.h"        // 依赖 IComponent
+#include "framework/interface_helpers.h"  // 依赖 Z3Y_DEFINE_INTERFACE
+
+namespace z3y {
+
+    /**
+     * @brief `IAllocatorService` 服务的全局唯一 ClassId。
+     */
+    namespace clsid {
+        constexpr ClassId kAllocator =
+            ConstexprHash("z3y-core-allocator-SERVICE-UUID");
+    }  // namespace clsid
+
+    /**
+     * @struct ArenaMark
+     * @brief 线程帧内存的位置标记 (见 `IAllocatorService::MarkThreadArena`)。
+     * @details 由服务填写，调用方只应原样交还给 `RewindThreadArena`。
+     */
+    struct ArenaMark {
+        uint64_t arena = 0;   //!< 所属 arena 的编号 (0 = 无效标记)
+        size_t block = 0;     //!< 当前内存块序号
+        size_t offset = 0;    //!< 块内偏移
+        size_t used = 0;      //!< 标记时已使用的字节数
+    };
+
+    /**
+     * @struct AllocatorStats
+     * @brief 分配服务的运行统计快照 (见 `IAllocatorService::GetAllocatorStats`)。
+     */
+    struct AllocatorStats {
+        size_t arena_threads = 0;          //!< 拥有线程帧内存的存活线程数
+        size_t arena_reserved_bytes = 0;   //!< 线程帧内存持有的内存块总字节数
+        size_t arena_used_bytes = 0;       //!< 线程帧内存当前已使用的字节数
+        size_t arena_peak_bytes = 0;       //!< 单个线程帧内存曾达到的最大使用量
+        uint64_t arena_rewinds = 0;        //!< 累计回收 (作用域结束) 次数
+        size_t pool_bytes = 0;             //!< 正从分级内存池借出的字节数 (含框架自身)
+        uint64_t pool_allocations = 0;     //!< 累计从分级内存池分配的次数
+        size_t pool_upstream_bytes = 0;    //!< 分级内存池向系统申请的字节数
+        size_t framework_bytes = 0;        //!< 其中框架热点容器借出的字节数 (`framework_pool_allocations`)
+    };
+
+    /**
+     * @class IAllocatorService
+     * @brief 框架共享的小对象分配服务。除特别说明外，所有函数都是线程安全的。
+     */
+    class IAllocatorService : public virtual IComponent {
+    public:
+        Z3Y_DEFINE_INTERFACE(IAllocatorService, "z3y-core-IAllocatorService-IID-A0000007", 1, 0)
+
+        /**
+         * @brief 调用线程的线程帧内存 (首次调用时创建)。
+         * @details 返回的资源只能在本线程上分配；`deallocate` 是空操作，内存由 `RewindThreadArena` 统一回收。
+         */
+        [[nodiscard]] virtual std::pmr::memory_resource* GetThreadArena() = 0;
+
+        /** @brief 记录调用线程的线程帧内存当前位置。 */
+        [[nodiscard]] virtual ArenaMark MarkThreadArena() = 0;
+
+        /**
+         * @brief 把调用线程的线程帧内存回退到 `mark`，其后的分配全部作废 (内存块保留复用)。
+         * @details 默认构造的标记表示回退到起点。其他线程或已失效 arena 的标记被忽略。
+         */
+        virtual void RewindThreadArena(const ArenaMark& mark = {}) = 0;
+
+        /**
+         * @brief 线程安全的分级内存池。
+         * @details 在插件的工厂或 `Initialize()` 中调用 (且启用了内存记账) 时，返回记到该插件名下的资源；
+         * 否则返回不记账的共享资源。返回的指针在 `PluginManager` 销毁前一直有效。
+         */
+        [[nodiscard]] virtual std::pmr::memory_resource* GetPoolResource() = 0;
+
+        /** @brief 运行统计。 */
+        [[nodiscard]] virtual AllocatorStats GetAllocatorStats() const = 0;
+    };
+
+    /**
+     * @class FrameArenaScope
+     * @brief 圈定一帧：析构时把调用线程的线程帧内存回退到构造时的位置。
+     * @details 可以嵌套；必须在同一个线程上构造与析构。
+     */
+    class FrameArenaScope {
+    public:
+        explicit FrameArenaScope(IAllocatorService& service)
+            : service_(service), mark_(service.MarkThreadArena()) {}
+        ~FrameArenaScope() { service_.RewindThreadArena(mark_); }
+        FrameArenaScope(const FrameArenaScope&) = delete;
+        FrameArenaScope& operator=(const FrameArenaScope&) = delete;
+
+        /** @brief 本帧使用的内存资源 (即调用线程的线程帧内存)。 */
+        [[nodiscard]] std::pmr::memory_resource* Resource() const { return service_.GetThreadArena(); }
+
+    private:
+        IAllocatorService& service_;
+        ArenaMark mark_;
+    };
+
+}  // namespace z3y
+
+#endif  // Z3Y_FRAMEWORK_I_ALLOCATOR_SERVICE_H_
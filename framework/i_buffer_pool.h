@@ -0,0 +1,196 @@
+﻿/*
+* Copyright [2025] [Yue Liu]
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/**
+ * @file i_buffer_pool.h
+ * @brief 定义框架共享的大块缓冲区池接口 IBufferPool 与引用计数句柄 BufferRef。
+ * @author Yue Liu
+ * @date 2025
+ *
+ * @details
+ * [受众：插件开发者 (视觉等大负载事件) 和 框架使用者]
+ *
+ * 事件本身是普通 C++ 对象，携带图像帧时要么把几 MB 的数据拷进事件结构体，要么各插件自己发明共享方式。
+ * `IBufferPool` 提供按大小分级缓存的大块内存：
+ * - 小于一页的级别按缓存行 (64 字节) 对齐，一页及以上按页对齐；
+ * - 可选透明大页 (`PluginManagerOptions::buffer_pool_huge_pages`，仅 Linux)；
+ * - 句柄 `BufferRef` 是侵入式引用计数：拷贝只加计数，移动不触碰原子变量。
+ * 最后一个引用释放时，缓冲区经由分配它的池 (框架核心库内的代码) 回收，与在哪个插件里释放无关。
+ *
+ * \code{.cpp}
+ * struct FrameReadyEvent : z3y::Event {
+ *     Z3Y_DEFINE_EVENT(FrameReadyEvent, "...");
+ *     z3y::BufferRef pixels;
+ *     explicit FrameReadyEvent(z3y::BufferRef p) : pixels(std::move(p)) {}
+ * };
+ * auto pool = z3y::GetService<z3y::IBufferPool>(z3y::clsid::kBufferPool);
+ * z3y::BufferRef frame = pool->AcquireBuffer(width * height);
+ * camera.CopyInto(frame.Data(), frame.Size());
+ * bus->FireGlobal<FrameReadyEvent>(std::move(frame));  // kQueued 订阅者拿到的是同一块内存
+ * \endcode
+ *
+ * [约定]
+ * 缓冲区发布后应视为只读：多个句柄共享同一块内存，框架不做任何同步。
+ * 池的缓存随 `PluginManager` 销毁而释放；仍被持有的缓冲区在最后一个引用释放时直接归还系统。
+ */
+
+#pragma once
+
+#ifndef Z3Y_FRAMEWORK_I_BUFFER_POOL_H_
+#define Z3Y_FRAMEWORK_I_BUFFER_POOL_H_
+
+#include <atomic>   // 用于引用计数
+#include <cstddef>  // 用于 size_t, std::byte
+#include <cstdint>  // 用于 uint16_t, uint32_t, uint64_t
+#include <utility>  // 用于 std::exchange
+#include "framework/class_id.h"           // 依赖 ClassId
+#include "framework/i_component.h"        // 依赖 IComponent
+#include "framework/interface_helpers.h"  // 依赖 Z3Y_DEFINE_INTERFACE
+
+namespace z3y {
+
+    /**
+     * @brief `IBufferPool` 服务的全局唯一 ClassId。
+     */
+    namespace clsid {
+        constexpr ClassId kBufferPool =
+            ConstexprHash("z3y-core-bufferpool-SERVICE-UUID");
+    }  // namespace clsid
+
+    /**
+     * @struct BufferHeader
+     * @brief [内部] 缓冲区控制块。布局属于框架 ABI，插件只应通过 `BufferRef` 访问。
+     * @details 控制块与数据分开存放，数据起始地址才能严格按页对齐。
+     * 控制块和它的数据块一起缓存在池中，稳态下获取缓冲区不做任何堆分配。
+     */
+    struct BufferHeader {
+        std::atomic<uint32_t> refs{ 0 };
+        uint16_t size_class = 0;                        //!< 池内部的级别编号
+        uint16_t flags = 0;                             //!< 池内部标记 (例如数据块来自大页映射)
+        void (*release)(BufferHeader*) noexcept = nullptr;  //!< 最后一个引用释放时调用 (由池提供)
+        void* owner = nullptr;                          //!< 分配它的池
+        std::byte* data = nullptr;
+        size_t capacity = 0;                            //!< 可用字节数 (级别大小)
+        size_t size = 0;                                //!< 申请时的字节数，可用 `SetSize` 调整
+    };
+
+    /**
+     * @class BufferRef
+     * @brief 池化缓冲区的引用计数句柄。
+     * @details 拷贝 = 原子加一；移动 = 交换指针；析构 = 原子减一，归零时交还给池。
+     * 默认构造的句柄为空。可以放进事件、跨线程传递、跨插件释放。
+     */
+    class BufferRef {
+    public:
+        BufferRef() noexcept = default;
+
+        /** @brief [内部] 接管一个引用计数已为 1 的控制块。由池调用。 */
+        explicit BufferRef(BufferHeader* adopted) noexcept : header_(adopted) {}
+
+        BufferRef(const BufferRef& other) noexcept : header_(other.header_) {
+            if (header_) header_->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+        BufferRef(BufferRef&& other) noexcept : header_(std::exchange(other.header_, nullptr)) {}
+        BufferRef& operator=(const BufferRef& other) noexcept {
+            if (this != &other) {
+                BufferRef copy(other);
+                std::swap(header_, copy.header_);
+            }
+            return *this;
+        }
+        BufferRef& operator=(BufferRef&& other) noexcept {
+            if (this != &other) {
+                Reset();
+                header_ = std::exchange(other.header_, nullptr);
+            }
+            return *this;
+        }
+        ~BufferRef() { Reset(); }
+
+        /** @brief 放弃引用；如果是最后一个，缓冲区回到池中。 */
+        void Reset() noexcept {
+            BufferHeader* header = std::exchange(header_, nullptr);
+            if (header && header->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                header->release(header);
+            }
+        }
+
+        [[nodiscard]] std::byte* Data() noexcept { return header_ ? header_->data : nullptr; }
+        [[nodiscard]] const std::byte* Data() const noexcept { return header_ ? header_->data : nullptr; }
+        [[nodiscard]] size_t Size() const noexcept { return header_ ? header_->size : 0; }
+        [[nodiscard]] size_t Capacity() const noexcept { return header_ ? header_->capacity : 0; }
+
+        /**
+         * @brief 调整有效字节数 (不超过 `Capacity()`)。
+         * @details 作用于所有共享者，只应在发布之前调用。
+         * @return 超出容量时返回 false，大小不变。
+         */
+        bool SetSize(size_t size) noexcept {
+            if (!header_ || size > header_->capacity) return false;
+            header_->size = size;
+            return true;
+        }
+
+        /** @brief 当前共享者数量 (诊断用，读取时可能已经变化)。 */
+        [[nodiscard]] uint32_t UseCount() const noexcept {
+            return header_ ? header_->refs.load(std::memory_order_relaxed) : 0;
+        }
+
+        explicit operator bool() const noexcept { return header_ != nullptr; }
+
+    private:
+        BufferHeader* header_ = nullptr;
+    };
+
+    /**
+     * @struct BufferPoolStats
+     * @brief 缓冲区池的运行统计快照 (见 `IBufferPool::GetBufferPoolStats`)。
+     */
+    struct BufferPoolStats {
+        size_t cached_buffers = 0;       //!< 池中空闲的缓冲区数
+        size_t cached_bytes = 0;         //!< 空闲缓冲区占用的字节数
+        size_t outstanding_buffers = 0;  //!< 正被持有的缓冲区数
+        size_t outstanding_bytes = 0;    //!< 正被持有的缓冲区容量之和
+        uint64_t acquires = 0;           //!< 累计 AcquireBuffer 次数
+        uint64_t pool_hits = 0;          //!< 其中直接复用空闲缓冲区的次数
+        uint64_t huge_page_buffers = 0;  //!< 累计以大页方式申请的缓冲区数
+    };
+
+    /**
+     * @class IBufferPool
+     * @brief 框架共享的大块缓冲区池。所有函数都是线程安全的。
+     */
+    class IBufferPool : public virtual IComponent {
+    public:
+        Z3Y_DEFINE_INTERFACE(IBufferPool, "z3y-core-IBufferPool-IID-A0000005", 1, 0)
+
+        /**
+         * @brief 取得一块至少 `size` 字节的缓冲区 (内容未初始化)。
+         * @details 向上取整到 2 的幂级别 (最小 256 字节)。超过最大级别 (256 MB) 的请求单独分配，不进入缓存。
+         * @throws std::bad_alloc 内存不足。
+         */
+        [[nodiscard]] virtual BufferRef AcquireBuffer(size_t size) = 0;
+
+        /** @brief 运行统计。 */
+        [[nodiscard]] virtual BufferPoolStats GetBufferPoolStats() const = 0;
+
+        /** @brief 把所有空闲缓冲区归还系统 (例如一批大任务结束后)。 */
+        virtual void TrimBufferPool() = 0;
+    };
+
+}  // namespace z3y
+
+#endif  // Z3Y_FRAMEWORK_I_BUFFER_POOL_H_
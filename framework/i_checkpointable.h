@@ -0,0 +1,95 @@
+﻿/*
+* Copyright [2025] [Yue Liu]
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/**
+ * @file i_checkpointable.h
+ * @brief 定义单例服务可选实现的热状态检查点接口 ICheckpointable。
+ * @author Yue Liu
+ * @date 2025
+ *
+ * @details
+ * [受众：插件开发者 和 框架使用者]
+ *
+ * 有些服务的 `Initialize()` 要花很长时间重建内部状态 (标定表、索引、预热缓存)。
+ * 宿主调用 `PluginManager::SetCheckpointDirectory` 后，实现了 `ICheckpointable` 的单例：
+ * - 在 `Shutdown()` 之前被要求 `SaveCheckpoint`，结果写入 `<目录>/<clsid>.z3yckpt`；
+ * - 下次进程启动、首次构造该单例时，在工厂返回之后、`Initialize()` 之前收到 `RestoreCheckpoint`，
+ *   数据直接来自检查点文件的只读内存映射 (不经过额外的读取与拷贝)。
+ *
+ * 以下任一项与保存时不同，检查点即视为过期，直接删除而不交给服务：
+ * `GetCheckpointVersion()`、组件实现的任一接口的版本 (`InterfaceVersion`)、来源插件文件 (大小 + 修改时间)。
+ * 文件损坏 (校验和不符) 或 `RestoreCheckpoint` 返回 false 时同样删除，服务按冷启动处理。
+ *
+ * \code{.cpp}
+ * class CalibrationService : public z3y::PluginImpl<CalibrationService, ICalibration, z3y::ICheckpointable> {
+ *     uint32_t GetCheckpointVersion() const override { return 3; }
+ *     bool SaveCheckpoint(std::vector<uint8_t>& out) override { table_.SerializeTo(out); return true; }
+ *     bool RestoreCheckpoint(const uint8_t* data, size_t size) override {
+ *         restored_ = table_.Deserialize(data, size);
+ *         return restored_;
+ *     }
+ *     void Initialize() override { if (!restored_) table_.Rebuild(); }  // 冷启动才重建
+ * };
+ * \endcode
+ *
+ * [约定]
+ * 两个函数都在框架的生命周期线程上调用，不会与 `Initialize()` / `Shutdown()` 并发。
+ * `RestoreCheckpoint` 的 data 只在调用期间有效，需要保留的内容必须复制出来。
+ * 检查点只是加速手段：服务在任何情况下都必须能够冷启动。
+ */
+
+#pragma once
+
+#ifndef Z3Y_FRAMEWORK_I_CHECKPOINTABLE_H_
+#define Z3Y_FRAMEWORK_I_CHECKPOINTABLE_H_
+
+#include <cstddef>  // 用于 size_t
+#include <cstdint>  // 用于 uint8_t, uint32_t
+#include <vector>   // 用于 std::vector
+#include "framework/i_component.h"        // 依赖 IComponent
+#include "framework/interface_helpers.h"  // 依赖 Z3Y_DEFINE_INTERFACE
+
+namespace z3y {
+
+    /**
+     * @class ICheckpointable
+     * @brief 可把热状态保存到检查点、并在下次启动时恢复的单例服务。
+     * @note 只对单例服务生效；瞬态组件实现本接口不会被调用。
+     */
+    class ICheckpointable : public virtual IComponent {
+    public:
+        Z3Y_DEFINE_INTERFACE(ICheckpointable, "z3y-core-ICheckpointable-IID-A0000008", 1, 0)
+
+        /** @brief 状态格式的版本。序列化格式改变时递增，旧检查点随之作废。 */
+        [[nodiscard]] virtual uint32_t GetCheckpointVersion() const = 0;
+
+        /**
+         * @brief 把当前状态序列化到 out (在 `Shutdown()` 之前调用)。
+         * @return false 表示本次不保存 (已有的旧检查点同时删除)。
+         */
+        virtual bool SaveCheckpoint(std::vector<uint8_t>& out) = 0;
+
+        /**
+         * @brief 从检查点恢复状态 (在工厂返回之后、`Initialize()` 之前调用)。
+         * @param data 检查点内容 (只读映射，仅在调用期间有效)。
+         * @return false 表示内容不可用：检查点被删除，服务按冷启动初始化。
+         */
+        virtual bool RestoreCheckpoint(const uint8_t* data, size_t size) = 0;
+    };
+
+}  // namespace z3y
+
+#endif  // Z3Y_FRAMEWORK_I_CHECKPOINTABLE_H_
@@ -145,8 +145,9 @@ namespace z3y {
          *
          * [使用时机]
          * 这是执行清理操作（例如记录日志、释放对其他服务的强引用）的安全位置。
-         * PluginManager 保证以 LIFO (后进先出)
-         * 的顺序调用 `Shutdown()`，确保依赖关系正确解除。
+         * PluginManager 按依赖关系调用 `Shutdown()`：在 `Initialize()` 中获取的服务
+         * 一定在本服务 `Shutdown()` 返回之后才会 `Shutdown()`；其余按库加载的逆序 (LIFO)。
+         * 宿主开启 `PluginManagerOptions::shutdown_threads` 后，彼此独立的服务可能在其他线程上并行 `Shutdown()`。
          *
          * [注意]
          * 在此函数中调用 `z3y::TryGetService` (noexcept API)
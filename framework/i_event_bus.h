@@ -33,6 +33,7 @@
  * **通信模式：**
  * - **Global (全局)**: 喊话模式。发布者大喊一声，所有感兴趣的人都能听到。
  * - **Sender (单播)**: 专线模式。订阅者只关心“张三”发出的消息，不关心“李四”发出的同类型消息。
+ * - **Request (请求/应答)**: 点对点调用。请求只交给唯一的处理者，回复直接写回请求者的 future。
  */
 
 #pragma once
@@ -40,15 +41,26 @@
 #ifndef Z3Y_FRAMEWORK_I_EVENT_BUS_H_
 #define Z3Y_FRAMEWORK_I_EVENT_BUS_H_
 
+#include <chrono>
+#include <cstdint>
 #include <functional>
+#include <future>
 #include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
 #include <typeindex>
 #include <utility>
+#include <vector>
 #include "framework/class_id.h"
 #include "framework/connection_type.h"
 #include "framework/i_component.h"
 #include "framework/interface_helpers.h"
 #include "framework/connection.h"
+#include "framework/event_delegate.h"
+#include "framework/event_executor.h"
+#include "framework/event_pool.h"
+#include "framework/event_request.h"
 
 namespace z3y {
 
@@ -73,6 +85,180 @@ namespace z3y {
         virtual ~Event() = default;
     };
 
+    /**
+     * @brief 事件“提升”函数：把一个栈上的事件拷贝为可跨线程存活的共享对象。
+     * @details 由 `FireGlobal` / `FireToSender` 为每种事件类型自动生成，
+     * 只有在订阅快照中存在 kQueued 订阅者时才会被调用。
+     */
+    using EventPromoter = PluginPtr<Event>(*)(const Event&);
+
+    /**
+     * @brief 事件槽号：EventId 在进程内对应的稠密小整数下标。
+     * @details 首次使用某事件类型时由框架分配，此后在整个进程生命周期内不变。
+     * `FireGlobal<TEvent>` 把它缓存在函数局部静态变量中，发布时直接按下标寻址，
+     * 无需哈希或查表。
+     */
+    using EventSlotIndex = uint32_t;
+
+    namespace detail {
+        /** @brief [内部] `EventPromoter` 的模板实现。 */
+        template <typename TEvent>
+        PluginPtr<Event> PromoteEvent(const Event& e) {
+            return MakeEvent<TEvent>(static_cast<const TEvent&>(e));
+        }
+    }  // namespace detail
+
+    /**
+     * @struct EventBatchView
+     * @brief [内部] 一批同类型事件的类型擦除视图 (由 `FireGlobalBatch` 构造)。
+     *
+     * @details
+     * 批订阅者 (`SubscribeGlobalBatch`) 的回调总是收到一个视图：
+     * - `FireGlobalBatch` 发布时，视图指向发布者的整个数组 (`array` + `count`)；
+     * - 普通 `FireGlobal` 发布时，视图只包含这一个事件 (`single`)。
+     * 插件代码请使用类型安全的 `EventBatch<TEvent>`，不要直接访问本结构。
+     */
+    struct EventBatchView : Event {
+        const Event* single = nullptr;  //!< 单个事件 (非空时忽略 array/count)
+        const void* array = nullptr;    //!< 指向 TEvent 数组
+        size_t count = 0;
+        const Event& (*element)(const void* array, size_t index) = nullptr; //!< 取第 index 个元素
+        PluginPtr<Event> (*promote)(const EventBatchView& view) = nullptr;  //!< 把整批拷贝到堆上
+        EventPromoter promote_element = nullptr;                            //!< 把单个元素拷贝到堆上
+
+        [[nodiscard]] size_t size() const { return single ? 1 : count; }
+        [[nodiscard]] const Event& At(size_t index) const { return single ? *single : element(array, index); }
+    };
+
+    /**
+     * @class EventBatch
+     * @brief 批订阅者收到的一批事件 (只读，仅在回调期间有效)。
+     *
+     * \code{.cpp}
+     * void OnLines(const z3y::EventBatch<LineEvent>& lines) {
+     *     for (const LineEvent& line : lines) { ... }
+     * }
+     * \endcode
+     */
+    template <typename TEvent>
+    class EventBatch {
+    public:
+        class Iterator {
+        public:
+            Iterator(const EventBatch* batch, size_t index) : batch_(batch), index_(index) {}
+            const TEvent& operator*() const { return (*batch_)[index_]; }
+            Iterator& operator++() { ++index_; return *this; }
+            bool operator!=(const Iterator& other) const { return index_ != other.index_; }
+        private:
+            const EventBatch* batch_;
+            size_t index_;
+        };
+
+        explicit EventBatch(const EventBatchView& view) : view_(&view) {}
+
+        [[nodiscard]] size_t size() const { return view_->size(); }
+        [[nodiscard]] bool empty() const { return size() == 0; }
+        const TEvent& operator[](size_t index) const {
+            return view_->single ? static_cast<const TEvent&>(*view_->single)
+                : static_cast<const TEvent*>(view_->array)[index];
+        }
+        Iterator begin() const { return Iterator(this, 0); }
+        Iterator end() const { return Iterator(this, size()); }
+
+    private:
+        const EventBatchView* view_;
+    };
+
+    namespace detail {
+        /** @brief [内部] 检测事件是否通过 `Z3Y_DEFINE_EVENT_IN_FAMILY` 声明了事件族。 */
+        template <typename T, typename = void>
+        struct HasEventFamily : std::false_type {};
+
+        template <typename T>
+        struct HasEventFamily<T, std::void_t<decltype(T::kEventFamily)>> : std::true_type {};
+
+        /** @brief [内部] 事件所属的事件族，未声明时为 nullptr。 */
+        template <typename TEvent>
+        constexpr const char* EventFamilyOf() {
+            if constexpr (HasEventFamily<TEvent>::value) return TEvent::kEventFamily;
+            else return nullptr;
+        }
+
+        /** @brief [内部] 检测事件是否声明为保留事件 (`Z3Y_DEFINE_RETAINED_EVENT` 或自行定义的 `kRetained`)。 */
+        template <typename T, typename = void>
+        struct IsRetainedEvent : std::false_type {};
+
+        template <typename T>
+        struct IsRetainedEvent<T, std::void_t<decltype(T::kRetained)>> : std::bool_constant<T::kRetained> {};
+
+        /** @brief [内部] `EventBatchView::element` 的模板实现。 */
+        template <typename TEvent>
+        const Event& BatchElement(const void* array, size_t index) {
+            return static_cast<const TEvent*>(array)[index];
+        }
+
+        /** @brief [内部] 拥有存储的批事件 (kQueued 订阅者跨线程持有)。 */
+        template <typename TEvent>
+        struct OwnedEventBatch : EventBatchView {
+            explicit OwnedEventBatch(const EventBatchView& view) {
+                storage.reserve(view.size());
+                for (size_t i = 0; i < view.size(); ++i) storage.push_back(static_cast<const TEvent&>(view.At(i)));
+                array = storage.data();
+                count = storage.size();
+                element = view.element;
+                promote = view.promote;
+                promote_element = view.promote_element;
+            }
+            std::vector<TEvent> storage;
+        };
+
+        /** @brief [内部] `EventBatchView::promote` 的模板实现。 */
+        template <typename TEvent>
+        PluginPtr<Event> PromoteBatch(const EventBatchView& view) {
+            return std::make_shared<OwnedEventBatch<TEvent>>(view);
+        }
+    }  // namespace detail
+
+    namespace detail {
+        /** @brief [内部] `MatchField` 的谓词：字段等于给定值。 */
+        template <typename TOwner, typename TField>
+        struct FieldEqualsFilter {
+            TField TOwner::* field;
+            TField value;
+            bool operator()(const TOwner& e) const { return e.*field == value; }
+        };
+
+        /** @brief [内部] `MatchPrefix` 的谓词：字符串字段以给定前缀开头。 */
+        template <typename TOwner>
+        struct FieldPrefixFilter {
+            std::string TOwner::* field;
+            std::string prefix;
+            bool operator()(const TOwner& e) const { return (e.*field).compare(0, prefix.size(), prefix) == 0; }
+        };
+    }  // namespace detail
+
+    /**
+     * @brief 按字段过滤：只接收 `e.*field == value` 的事件 (例如只关心某个相机 ID)。
+     * @details 用于 `SubscribeGlobalFiltered` / `SubscribeToSenderFiltered`。
+     */
+    template <typename TOwner, typename TField, typename TValue>
+    detail::FieldEqualsFilter<TOwner, TField> MatchField(TField TOwner::* field, TValue&& value) {
+        return { field, TField(std::forward<TValue>(value)) };
+    }
+
+    /** @brief 按字符串前缀过滤：只接收 `e.*field` 以 `prefix` 开头的事件 (例如配置路径 "Camera.")。 */
+    template <typename TOwner>
+    detail::FieldPrefixFilter<TOwner> MatchPrefix(std::string TOwner::* field, std::string prefix) {
+        return { field, std::move(prefix) };
+    }
+
+    template <typename TEvent>
+    class EventChannel;
+
+    namespace internal {
+        struct EventChannelCore;  // [内部] 通道状态，定义在框架核心库内
+    }  // namespace internal
+
     /**
      * @class IEventBus
      * @brief 事件总线接口。提供发布-订阅功能。
@@ -80,7 +266,9 @@ namespace z3y {
     class IEventBus : public virtual IComponent {
     public:
         // 定义接口 ID
-        Z3Y_DEFINE_INTERFACE(IEventBus, "z3y-core-IEventBus-IID-A0000002", 1, 0)
+        // 2.0: SubscribeGlobalImpl / SubscribeToSenderImpl 的签名 (优先级等参数) 与虚表布局 (ReleaseConnection 等)
+        // 都已改变，按 1.x 构建的插件在版本检查时即被拒绝
+        Z3Y_DEFINE_INTERFACE(IEventBus, "z3y-core-IEventBus-IID-A0000002", 2, 0)
 
             virtual ~IEventBus() = default;
 
@@ -98,34 +286,89 @@ namespace z3y {
          * @param subscriber 订阅者对象的 shared_ptr。**必须继承自 enable_shared_from_this**。
          * @param callback 回调函数指针 (如 &MyPlugin::OnEvent)。
          * @param type 连接类型 (默认 kDirect)。
+         * @param priority 异步回调的优先级通道 (默认 kNormal，kDirect 时忽略)。
          * @return Connection 对象，用于断开连接。
          *
-         * @note 这是一个模板包装器，它会自动提取事件 ID，并将成员函数转换为 lambda，
-         * 然后调用底层的 `SubscribeGlobalImpl`。
+         * @note 这是一个模板包装器，它会自动提取事件 ID，并将成员函数绑定为 `EventDelegate`，
+         * 然后调用底层的 `SubscribeGlobalImpl`。订阅者的存活检查由派发循环统一完成。
          */
         template <typename TEvent, typename TSubscriber, typename TCallback>
         [[nodiscard]]
         Connection SubscribeGlobal(std::shared_ptr<TSubscriber> subscriber,
             TCallback&& callback,
-            ConnectionType type = ConnectionType::kDirect) {
+            ConnectionType type = ConnectionType::kDirect,
+            EventPriority priority = EventPriority::kNormal) {
             // 编译期检查：确保类型正确
             static_assert(std::is_base_of_v<Event, TEvent>, "TEvent must derive from z3y::Event");
             static_assert(std::is_base_of_v<std::enable_shared_from_this<TSubscriber>, TSubscriber>,
                 "Subscriber must inherit from std::enable_shared_from_this");
 
             EventId event_id = TEvent::kEventId;
-            std::weak_ptr<TSubscriber> weak_sub = subscriber;
-
-            // 构造类型擦除的包装器
-            // 在调用用户回调前，先 lock() 弱引用，确保对象还活着
-            std::function<void(const Event&)> wrapper =
-                [weak_sub, cb = std::forward<TCallback>(callback)](const Event& e) {
-                if (auto sub = weak_sub.lock()) {
-                    std::invoke(cb, sub.get(), static_cast<const TEvent&>(e));
-                }
-                };
 
-            return SubscribeGlobalImpl(event_id, subscriber, std::move(wrapper), type);
+            // 构造类型擦除的回调 (成员函数指针直接存放在内联缓冲区中)
+            EventDelegate delegate = EventDelegate::Bind<TSubscriber, TEvent>(std::forward<TCallback>(callback));
+
+            return SubscribeGlobalImpl(event_id, subscriber, std::move(delegate), type, priority, nullptr, EventFilter());
+        }
+
+        /**
+         * @brief 订阅全局事件，并在指定的执行器上接收 (不经过框架派发线程)。
+         *
+         * @param executor 事件投递的目标，见 `IEventExecutor`。传入 `IExecutorService::MakeStrand()`
+         * 时回调在共享线程池上按本订阅 (或共享该 strand 的一组订阅) 串行执行，不同 strand 之间并行。
+         * @param type 只能是 kQueued 或 kQueuedCoalesced (默认 kQueued)。
+         * @throws std::invalid_argument executor 为空或 type 为 kDirect。
+         */
+        template <typename TEvent, typename TSubscriber, typename TCallback>
+        [[nodiscard]]
+        Connection SubscribeGlobal(std::shared_ptr<TSubscriber> subscriber,
+            TCallback&& callback,
+            std::shared_ptr<IEventExecutor> executor,
+            ConnectionType type = ConnectionType::kQueued) {
+            static_assert(std::is_base_of_v<Event, TEvent>, "TEvent must derive from z3y::Event");
+            static_assert(std::is_base_of_v<std::enable_shared_from_this<TSubscriber>, TSubscriber>,
+                "Subscriber must inherit from std::enable_shared_from_this");
+            CheckExecutorArgs(executor, type);
+
+            EventDelegate delegate = EventDelegate::Bind<TSubscriber, TEvent>(std::forward<TCallback>(callback));
+            return SubscribeGlobalImpl(TEvent::kEventId, subscriber, std::move(delegate), type,
+                EventPriority::kNormal, std::move(executor), EventFilter());
+        }
+
+        /**
+         * @brief 订阅全局事件，只接收满足 `filter` 的那些。
+         *
+         * @details
+         * 谓词在 *发布线程* 上、入队之前求值：被过滤掉的事件不会拷贝到堆上、不会入队，
+         * 也不会唤醒派发线程。因此谓词必须廉价、无副作用且线程安全 (不同发布线程可能同时调用它)；
+         * 抛出异常等同于返回 false，并计入该订阅的异常统计。
+         * 批量发布时谓词逐个事件求值：kQueued 订阅者在执行时会对批中元素再求值一次。
+         *
+         * @param filter 可以 `filter(const TEvent&)` 调用、返回 bool 的对象；
+         * 常见的按字段过滤见 `MatchField` / `MatchPrefix`。
+         *
+         * \code{.cpp}
+         * // 只关心 "Camera." 下的配置项
+         * conn_ = bus->SubscribeGlobalFiltered<ConfigChangedEvent>(shared_from_this(), &Panel::OnConfig,
+         *     z3y::MatchPrefix(&ConfigChangedEvent::path, "Camera."), z3y::ConnectionType::kQueued);
+         * \endcode
+         */
+        template <typename TEvent, typename TSubscriber, typename TCallback, typename TFilter>
+        [[nodiscard]]
+        Connection SubscribeGlobalFiltered(std::shared_ptr<TSubscriber> subscriber,
+            TCallback&& callback,
+            TFilter&& filter,
+            ConnectionType type = ConnectionType::kDirect,
+            EventPriority priority = EventPriority::kNormal) {
+            static_assert(std::is_base_of_v<Event, TEvent>, "TEvent must derive from z3y::Event");
+            static_assert(std::is_base_of_v<std::enable_shared_from_this<TSubscriber>, TSubscriber>,
+                "Subscriber must inherit from std::enable_shared_from_this");
+            static_assert(std::is_invocable_r_v<bool, std::decay_t<TFilter>&, const TEvent&>,
+                "filter must be callable as bool(const TEvent&)");
+
+            EventDelegate delegate = EventDelegate::Bind<TSubscriber, TEvent>(std::forward<TCallback>(callback));
+            return SubscribeGlobalImpl(TEvent::kEventId, subscriber, std::move(delegate), type, priority, nullptr,
+                EventFilter::Bind<TEvent>(std::forward<TFilter>(filter)));
         }
 
         /**
@@ -133,22 +376,162 @@ namespace z3y {
          *
          * @tparam TEvent 事件类型。
          * @tparam Args 构造事件所需的参数。
+         *
+         * @note 保留事件 (`Z3Y_DEFINE_RETAINED_EVENT`) 即使没有订阅者也会构造到堆上，
+         * 替换总线保留的上一份实例；之后的 `SubscribeGlobal` 在订阅时立刻收到它
+         * (按订阅的连接类型投递：kDirect 在订阅调用内同步回调，其余进入订阅者的异步通道)。
+         * 订阅与发布并发时，最新值可能被投递两次，但不会丢失。
          */
         template <typename TEvent, typename... Args>
         void FireGlobal(Args&&... args) {
             static_assert(std::is_base_of_v<Event, TEvent>, "TEvent must derive from z3y::Event");
             EventId event_id = TEvent::kEventId;
+            const EventSlotIndex slot = GlobalSlotOf<TEvent>();
 
+            if constexpr (detail::IsRetainedEvent<TEvent>::value) {
+                // 先保留再派发：与订阅并发时宁可重复，不会漏掉
+                PluginPtr<TEvent> event_ptr = MakeEvent<TEvent>(std::forward<Args>(args)...);
+                RetainEventImpl(event_id, std::weak_ptr<void>(), event_ptr);
+                if (this->IsGlobalSlotSubscribed(slot)) FireGlobalImpl(event_id, std::move(event_ptr));
+                return;
+            }
             // 性能优化：如果没有人订阅这个事件，就不构造对象了
-            if (!this->IsGlobalSubscribed(event_id)) {
+            if (!this->IsGlobalSlotSubscribed(slot)) {
+                return;
+            }
+            if constexpr (std::is_copy_constructible_v<TEvent>) {
+                // 快速路径：事件构造在栈上，按引用派发给 kDirect 订阅者；
+                // 只有存在 kQueued 订阅者时，实现层才会拷贝一份到堆上。
+                const TEvent event(std::forward<Args>(args)...);
+                FireGlobalRefImpl(event_id, slot, event, &detail::PromoteEvent<TEvent>);
+            } else {
+                // 构造事件对象 (池化事件不访问全局堆，见 event_pool.h)
+                PluginPtr<TEvent> event_ptr = MakeEvent<TEvent>(std::forward<Args>(args)...);
+                // 转发给实现层
+                FireGlobalImpl(event_id, event_ptr);
+            }
+        }
+
+        /**
+         * @brief 订阅全局事件的 *批量* 形式：每次发布只回调一次，收到整批事件。
+         *
+         * @details
+         * - `FireGlobalBatch` 发布 N 个事件时，回调只执行一次，参数包含全部 N 个事件；
+         * - 普通 `FireGlobal` 发布时，回调收到只含一个事件的批。
+         * 回调签名：`void OnBatch(const z3y::EventBatch<TEvent>& batch)`。
+         * `batch` 只在回调期间有效 (kQueued 时指向框架持有的拷贝)。
+         *
+         * @param type 连接类型 (默认 kDirect)。kQueuedCoalesced 按 kQueued 处理。
+         */
+        template <typename TEvent, typename TSubscriber, typename TCallback>
+        [[nodiscard]]
+        Connection SubscribeGlobalBatch(std::shared_ptr<TSubscriber> subscriber,
+            TCallback callback,
+            ConnectionType type = ConnectionType::kDirect,
+            EventPriority priority = EventPriority::kNormal) {
+            static_assert(std::is_base_of_v<Event, TEvent>, "TEvent must derive from z3y::Event");
+            static_assert(std::is_copy_constructible_v<TEvent>, "Batched events must be copy constructible");
+            static_assert(std::is_base_of_v<std::enable_shared_from_this<TSubscriber>, TSubscriber>,
+                "Subscriber must inherit from std::enable_shared_from_this");
+            if (type == ConnectionType::kQueuedCoalesced) type = ConnectionType::kQueued;
+
+            EventDelegate delegate = EventDelegate::Bind<TSubscriber, EventBatchView>(
+                [callback](TSubscriber* self, const EventBatchView& view) {
+                    std::invoke(callback, self, EventBatch<TEvent>(view));
+                });
+            return SubscribeGlobalImpl(TEvent::kEventId, subscriber, std::move(delegate), type, priority, nullptr, EventFilter());
+        }
+
+        /**
+         * @brief 订阅一个事件族 (分层主题前缀) 下的所有全局事件。
+         *
+         * @details
+         * 事件族由 `Z3Y_DEFINE_EVENT_IN_FAMILY` 声明。订阅 `"vision"` 会收到族为 `"vision"`
+         * 以及 `"vision/..."` 的所有事件，包括订阅之后才首次发布的事件类型。
+         * 订阅时即展开为各 EventId 的订阅列表，发布时的开销与普通订阅相同 (不做模式匹配)。
+         *
+         * 回调签名：`void OnAny(const z3y::Event& e)`，可以用 `dynamic_cast` 或 `typeid(e)`
+         * 区分具体事件类型。只对全局广播生效，`FireToSender` 不会投递给事件族订阅。
+         *
+         * @param family 事件族前缀，不能为空。末尾的 `/` 会被忽略。
+         * @throws std::invalid_argument family 为空。
+         */
+        template <typename TSubscriber, typename TCallback>
+        [[nodiscard]]
+        Connection SubscribeFamily(std::shared_ptr<TSubscriber> subscriber,
+            const char* family,
+            TCallback&& callback,
+            ConnectionType type = ConnectionType::kDirect,
+            EventPriority priority = EventPriority::kNormal) {
+            static_assert(std::is_base_of_v<std::enable_shared_from_this<TSubscriber>, TSubscriber>,
+                "Subscriber must inherit from std::enable_shared_from_this");
+            EventDelegate delegate = EventDelegate::Bind<TSubscriber, Event>(std::forward<TCallback>(callback));
+            return SubscribeFamilyImpl(family, subscriber, std::move(delegate), type, priority);
+        }
+
+        /**
+         * @brief 一次发布一批同类型全局事件。
+         *
+         * @details
+         * 与循环调用 `FireGlobal` 语义相同 (每个订阅者按顺序看到每个事件)，但订阅列表只读取一次、
+         * 追踪埋点只记录一次；kQueued 订阅者每个派发线程只入队一个任务，
+         * 批订阅者 (`SubscribeGlobalBatch`) 只回调一次。
+         *
+         * @param events 指向 count 个连续事件。调用返回后即可释放 (需要时框架会拷贝)。
+         */
+        template <typename TEvent>
+        void FireGlobalBatch(const TEvent* events, size_t count) {
+            static_assert(std::is_base_of_v<Event, TEvent>, "TEvent must derive from z3y::Event");
+            static_assert(std::is_copy_constructible_v<TEvent>, "Batched events must be copy constructible");
+            const EventSlotIndex slot = GlobalSlotOf<TEvent>();
+            if constexpr (detail::IsRetainedEvent<TEvent>::value) {
+                // 保留整批中的最后一个
+                if (count != 0) RetainEventImpl(TEvent::kEventId, std::weak_ptr<void>(), MakeEvent<TEvent>(events[count - 1]));
+            }
+            if (count == 0 || !this->IsGlobalSlotSubscribed(slot)) {
                 return;
             }
-            // 构造事件对象
-            PluginPtr<TEvent> event_ptr = std::make_shared<TEvent>(std::forward<Args>(args)...);
-            // 转发给实现层
-            FireGlobalImpl(event_id, event_ptr);
+            EventBatchView view;
+            view.array = events;
+            view.count = count;
+            view.element = &detail::BatchElement<TEvent>;
+            view.promote = &detail::PromoteBatch<TEvent>;
+            view.promote_element = &detail::PromoteEvent<TEvent>;
+            FireGlobalBatchImpl(TEvent::kEventId, slot, view);
+        }
+
+        /** @brief `FireGlobalBatch` 的 vector 便捷重载。 */
+        template <typename TEvent>
+        void FireGlobalBatch(const std::vector<TEvent>& events) {
+            FireGlobalBatch(events.data(), events.size());
+        }
+
+        /**
+         * @brief 取得保留事件 TEvent 最后一次全局发布的实例 (没有时返回 nullptr)。
+         * @details 供只想读一次当前状态、不需要后续通知的调用者使用。
+         */
+        template <typename TEvent>
+        [[nodiscard]] std::shared_ptr<const TEvent> GetRetained() const {
+            static_assert(detail::IsRetainedEvent<TEvent>::value, "TEvent must be a retained event");
+            return std::static_pointer_cast<const TEvent>(GetRetainedImpl(TEvent::kEventId, std::weak_ptr<void>()));
+        }
+
+        /** @brief 丢弃保留事件 TEvent 的全局最新值 (例如它描述的状态已不再成立)。 */
+        template <typename TEvent>
+        void ClearRetained() {
+            static_assert(detail::IsRetainedEvent<TEvent>::value, "TEvent must be a retained event");
+            ClearRetainedImpl(TEvent::kEventId, std::weak_ptr<void>());
         }
 
+        /**
+         * @brief 取得 TEvent 的类型化通道 (定义见 `event_channel.h`)。
+         * @details 通道自带订阅数组，`EventChannel::Fire` 不经过全局订阅表的查找与预检；
+         * 与 `SubscribeGlobal` / `FireGlobal` 互通。每条总线、每个事件类型只有一个通道，
+         * 返回的句柄在总线存活期间有效，应取一次后长期持有。
+         */
+        template <typename TEvent>
+        [[nodiscard]] EventChannel<TEvent> GetChannel();
+
         // =========================================================================
         // 2. 特定发布者订阅 (Sender-Specific)
         // =========================================================================
@@ -159,33 +542,72 @@ namespace z3y {
          * @param sender 我只关心这个对象发出的事件。
          * @param subscriber 我是订阅者。
          * @param callback 我的回调函数。
+         * @param priority 异步回调的优先级通道 (默认 kNormal)。
          */
         template <typename TEvent, typename TSubscriber, typename TCallback>
         [[nodiscard]]
         Connection SubscribeToSender(PluginPtr<IComponent> sender,
             std::shared_ptr<TSubscriber> subscriber,
             TCallback&& callback,
-            ConnectionType type = ConnectionType::kDirect) {
+            ConnectionType type = ConnectionType::kDirect,
+            EventPriority priority = EventPriority::kNormal) {
             static_assert(std::is_base_of_v<Event, TEvent>, "TEvent must derive from z3y::Event");
             static_assert(std::is_base_of_v<std::enable_shared_from_this<TSubscriber>, TSubscriber>,
                 "Subscriber must inherit from std::enable_shared_from_this");
 
             EventId event_id = TEvent::kEventId;
-            std::weak_ptr<TSubscriber> weak_sub = subscriber;
 
-            std::function<void(const Event&)> wrapper =
-                [weak_sub, cb = std::forward<TCallback>(callback)](const Event& e) {
-                if (auto sub = weak_sub.lock()) {
-                    std::invoke(cb, sub.get(), static_cast<const TEvent&>(e));
-                }
-                };
+            EventDelegate delegate = EventDelegate::Bind<TSubscriber, TEvent>(std::forward<TCallback>(callback));
 
-            return SubscribeToSenderImpl(event_id, subscriber, sender, std::move(wrapper), type);
+            return SubscribeToSenderImpl(event_id, subscriber, sender, std::move(delegate), type, priority, nullptr, EventFilter());
+        }
+
+        /**
+         * @brief 订阅特定发送者的事件，并在指定的执行器上接收。参数含义同执行器版 `SubscribeGlobal`。
+         */
+        template <typename TEvent, typename TSubscriber, typename TCallback>
+        [[nodiscard]]
+        Connection SubscribeToSender(PluginPtr<IComponent> sender,
+            std::shared_ptr<TSubscriber> subscriber,
+            TCallback&& callback,
+            std::shared_ptr<IEventExecutor> executor,
+            ConnectionType type = ConnectionType::kQueued) {
+            static_assert(std::is_base_of_v<Event, TEvent>, "TEvent must derive from z3y::Event");
+            static_assert(std::is_base_of_v<std::enable_shared_from_this<TSubscriber>, TSubscriber>,
+                "Subscriber must inherit from std::enable_shared_from_this");
+            CheckExecutorArgs(executor, type);
+
+            EventDelegate delegate = EventDelegate::Bind<TSubscriber, TEvent>(std::forward<TCallback>(callback));
+            return SubscribeToSenderImpl(TEvent::kEventId, subscriber, sender, std::move(delegate), type,
+                EventPriority::kNormal, std::move(executor), EventFilter());
+        }
+
+        /**
+         * @brief 订阅特定发送者的事件，只接收满足 `filter` 的那些。谓词的求值规则同 `SubscribeGlobalFiltered`。
+         */
+        template <typename TEvent, typename TSubscriber, typename TCallback, typename TFilter>
+        [[nodiscard]]
+        Connection SubscribeToSenderFiltered(PluginPtr<IComponent> sender,
+            std::shared_ptr<TSubscriber> subscriber,
+            TCallback&& callback,
+            TFilter&& filter,
+            ConnectionType type = ConnectionType::kDirect,
+            EventPriority priority = EventPriority::kNormal) {
+            static_assert(std::is_base_of_v<Event, TEvent>, "TEvent must derive from z3y::Event");
+            static_assert(std::is_base_of_v<std::enable_shared_from_this<TSubscriber>, TSubscriber>,
+                "Subscriber must inherit from std::enable_shared_from_this");
+            static_assert(std::is_invocable_r_v<bool, std::decay_t<TFilter>&, const TEvent&>,
+                "filter must be callable as bool(const TEvent&)");
+
+            EventDelegate delegate = EventDelegate::Bind<TSubscriber, TEvent>(std::forward<TCallback>(callback));
+            return SubscribeToSenderImpl(TEvent::kEventId, subscriber, sender, std::move(delegate), type, priority,
+                nullptr, EventFilter::Bind<TEvent>(std::forward<TFilter>(filter)));
         }
 
         /**
          * @brief 作为特定发送者发布事件。
          * @param sender "我" 是谁。
+         * @note 保留事件按 (EventId, 发送者) 各保留一份，发送者销毁后随之失效。
          */
         template <typename TEvent, typename... Args>
         void FireToSender(PluginPtr<IComponent> sender, Args&&... args) {
@@ -194,26 +616,134 @@ namespace z3y {
             EventId event_id = TEvent::kEventId;
             std::weak_ptr<void> weak_sender_id = sender;
 
+            if constexpr (detail::IsRetainedEvent<TEvent>::value) {
+                PluginPtr<TEvent> event_ptr = MakeEvent<TEvent>(std::forward<Args>(args)...);
+                RetainEventImpl(event_id, weak_sender_id, event_ptr);
+                if (this->IsSenderSubscribed(weak_sender_id, event_id)) {
+                    FireToSenderImpl(std::move(weak_sender_id), event_id, std::move(event_ptr));
+                }
+                return;
+            }
             // 性能优化：检查是否有针对"我"的订阅
             if (!this->IsSenderSubscribed(weak_sender_id, event_id)) {
                 return;
             }
-            PluginPtr<TEvent> event_ptr = std::make_shared<TEvent>(std::forward<Args>(args)...);
-            FireToSenderImpl(std::move(weak_sender_id), event_id, event_ptr);
+            if constexpr (std::is_copy_constructible_v<TEvent>) {
+                const TEvent event(std::forward<Args>(args)...);
+                FireToSenderRefImpl(weak_sender_id, event_id, event, &detail::PromoteEvent<TEvent>);
+            } else {
+                PluginPtr<TEvent> event_ptr = MakeEvent<TEvent>(std::forward<Args>(args)...);
+                FireToSenderImpl(std::move(weak_sender_id), event_id, event_ptr);
+            }
+        }
+
+        /** @brief 取得 `sender` 最后一次发布的保留事件 TEvent (没有时返回 nullptr)。 */
+        template <typename TEvent>
+        [[nodiscard]] std::shared_ptr<const TEvent> GetRetained(const PluginPtr<IComponent>& sender) const {
+            static_assert(detail::IsRetainedEvent<TEvent>::value, "TEvent must be a retained event");
+            return std::static_pointer_cast<const TEvent>(GetRetainedImpl(TEvent::kEventId, sender));
+        }
+
+        /** @brief 丢弃 `sender` 的保留事件 TEvent。 */
+        template <typename TEvent>
+        void ClearRetained(const PluginPtr<IComponent>& sender) {
+            static_assert(detail::IsRetainedEvent<TEvent>::value, "TEvent must be a retained event");
+            ClearRetainedImpl(TEvent::kEventId, sender);
         }
 
         // =========================================================================
-        // 3. 状态查询与清理
+        // 3. 请求/应答 (Request / Reply)
+        // =========================================================================
+
+        /** @brief `Request` 的默认超时时间。 */
+        static constexpr std::chrono::milliseconds kDefaultRequestTimeout{ 5000 };
+
+        /**
+         * @brief 注册 TReq 请求的处理者。每种请求同一时间只能有一个处理者。
+         *
+         * @tparam TReq 请求类型，必须是 `Z3Y_DEFINE_EVENT` 定义的事件。
+         * @param handler 处理者对象。总线只持有弱引用，对象销毁后请求失败为 kNoHandler。
+         * @param method 处理函数，返回值就是回复。抛出的异常原样传给请求者。
+         * @param type kDirect：在请求者线程上同步执行 (此时超时无法打断处理函数)；
+         *             kQueued：投递到共享执行器，多个请求可以并发执行。
+         * @throws std::logic_error 该请求已经有一个仍然有效的处理者。
+         * @throws std::invalid_argument type 为 kQueuedCoalesced (请求不能被合并)。
+         */
+        template <typename TReq, typename TSubscriber, typename TResp>
+        [[nodiscard]]
+        Connection HandleRequests(std::shared_ptr<TSubscriber> handler,
+            TResp(TSubscriber::* method)(const TReq&),
+            ConnectionType type = ConnectionType::kQueued) {
+            static_assert(std::is_base_of_v<Event, TReq>, "TReq must derive from z3y::Event");
+            if (type == ConnectionType::kQueuedCoalesced) {
+                throw std::invalid_argument("z3y: request handlers cannot be kQueuedCoalesced");
+            }
+            return RegisterRequestHandlerImpl(TReq::kEventId, handler,
+                MakeRequestInvoker<TReq, TSubscriber, TResp>(method), typeid(TResp).name(), type, nullptr);
+        }
+
+        /**
+         * @brief 同上，但处理函数在指定的执行器上运行。
+         * @details 并发度由执行器决定：传入串行队列 (`IExecutorService::GetSerialQueue`)
+         * 时同一处理者的请求按到达顺序逐个执行，处理函数无需加锁。
+         * @throws std::invalid_argument executor 为空。
+         */
+        template <typename TReq, typename TSubscriber, typename TResp>
+        [[nodiscard]]
+        Connection HandleRequests(std::shared_ptr<TSubscriber> handler,
+            TResp(TSubscriber::* method)(const TReq&),
+            std::shared_ptr<IEventExecutor> executor) {
+            static_assert(std::is_base_of_v<Event, TReq>, "TReq must derive from z3y::Event");
+            CheckExecutorArgs(executor, ConnectionType::kQueued);
+            return RegisterRequestHandlerImpl(TReq::kEventId, handler,
+                MakeRequestInvoker<TReq, TSubscriber, TResp>(method), typeid(TResp).name(),
+                ConnectionType::kQueued, std::move(executor));
+        }
+
+        /**
+         * @brief 发出请求，返回回复的 future。
+         * @param timeout 超时时间；<= 0 表示不设超时。
+         * @details 失败 (没有处理者、超时、处理者已断开等) 时 `get()` 抛出 `RequestError`。
+         */
+        template <typename TReq, typename TResp>
+        [[nodiscard]]
+        std::future<TResp> Request(TReq request, std::chrono::nanoseconds timeout = kDefaultRequestTimeout) {
+            static_assert(std::is_base_of_v<Event, TReq>, "TReq must derive from z3y::Event");
+            auto state = std::make_shared<detail::RequestState<TReq, TResp>>(std::move(request));
+            std::future<TResp> future = state->GetFuture();
+            SendRequestImpl(TReq::kEventId, std::move(state), timeout);
+            return future;
+        }
+
+        /**
+         * @brief 发出请求，完成时调用 `on_done(TResp* response, std::exception_ptr error)`。
+         * @details 回调在完成它的线程上执行：处理者线程 (回复)、定时器线程 (超时)
+         * 或请求者线程 (立即失败)。协程版本见 `coroutine_task.h` 中的 `AwaitRequest`。
+         */
+        template <typename TReq, typename TResp, typename TCallback>
+        void RequestAsync(TReq request, std::chrono::nanoseconds timeout, TCallback&& on_done) {
+            static_assert(std::is_base_of_v<Event, TReq>, "TReq must derive from z3y::Event");
+            auto state = std::make_shared<detail::RequestState<TReq, TResp>>(std::move(request),
+                typename detail::RequestState<TReq, TResp>::Callback(std::forward<TCallback>(on_done)));
+            SendRequestImpl(TReq::kEventId, std::move(state), timeout);
+        }
+
+        // =========================================================================
+        // 4. 状态查询与清理
         // =========================================================================
 
         /**
          * @brief [查询] 检查是否有任何活动的全局订阅。
          * @details 这是一个“无锁读”或极低开销的操作。建议在 Fire 之前调用。
+         * @note 结果可能滞后：`Disconnect` / `Unsubscribe` 只撕票 (回调立即停止)，
+         * 订阅列表要到下一轮 GC 压缩后才移除该项，在此之前可能仍返回 true (假阳性)。
+         * 不要用它判断断开是否已生效。
          */
         [[nodiscard]] virtual bool IsGlobalSubscribed(EventId event_id) const = 0;
 
         /**
          * @brief [查询] 检查是否有针对特定发布者的订阅。
+         * @note 与 IsGlobalSubscribed 相同，断开后到下一轮 GC 之前可能仍返回 true。
          */
         [[nodiscard]] virtual bool IsSenderSubscribed(
             const std::weak_ptr<void>& sender_id, EventId event_id) const = 0;
@@ -231,23 +761,151 @@ namespace z3y {
             const std::weak_ptr<void>& sender_key = std::weak_ptr<void>()) = 0;
 
     protected:
+        /** @brief 执行器版订阅的参数检查。 */
+        static void CheckExecutorArgs(const std::shared_ptr<IEventExecutor>& executor, ConnectionType type) {
+            if (!executor) throw std::invalid_argument("z3y: executor must not be null");
+            if (type == ConnectionType::kDirect) {
+                throw std::invalid_argument("z3y: executor subscriptions must be kQueued or kQueuedCoalesced");
+            }
+        }
+
+        /** @brief 生成 `HandleRequests` 的处理者调用器 (在处理者所在模块中实例化)。 */
+        template <typename TReq, typename TSubscriber, typename TResp>
+        static detail::RequestInvoker MakeRequestInvoker(TResp(TSubscriber::* method)(const TReq&)) {
+            return [method](const std::shared_ptr<void>& handler, detail::RequestStateBase& state) {
+                auto& typed = static_cast<detail::RequestState<TReq, TResp>&>(state);
+                typed.Reply((static_cast<TSubscriber*>(handler.get())->*method)(typed.Request()));
+                };
+        }
+
         // --- 纯虚实现接口 (Implementation Detail) ---
         // 真正的逻辑在 PluginManager 中实现
 
+        /** @param filter 非空时在发布线程上先求值，返回 false 的事件不会投递 (也不会入队)。 */
         [[nodiscard]] virtual Connection SubscribeGlobalImpl(
             EventId event_id, std::weak_ptr<void> sub,
-            std::function<void(const Event&)> cb,
-            ConnectionType connection_type) = 0;
+            EventDelegate cb,
+            ConnectionType connection_type, EventPriority priority,
+            std::shared_ptr<IEventExecutor> executor, EventFilter filter) = 0;
 
         virtual void FireGlobalImpl(EventId event_id, PluginPtr<Event> e_ptr) = 0;
 
+        /** @brief [事件族订阅] 见 `SubscribeFamily`。返回的 Connection 以事件族 ID 记录。 */
+        [[nodiscard]] virtual Connection SubscribeFamilyImpl(
+            const char* family, std::weak_ptr<void> sub,
+            EventDelegate cb,
+            ConnectionType connection_type, EventPriority priority) = 0;
+
         [[nodiscard]] virtual Connection SubscribeToSenderImpl(
             EventId event_id, std::weak_ptr<void> sub_id,
-            std::weak_ptr<void> sender_id, std::function<void(const Event&)> cb,
-            ConnectionType connection_type) = 0;
+            std::weak_ptr<void> sender_id, EventDelegate cb,
+            ConnectionType connection_type, EventPriority priority,
+            std::shared_ptr<IEventExecutor> executor, EventFilter filter) = 0;
 
         virtual void FireToSenderImpl(const std::weak_ptr<void>& sender_id,
             EventId event_id, PluginPtr<Event> e_ptr) = 0;
+
+        /**
+         * @brief [同步快速路径] 按引用发布全局事件。
+         * @param event_id 事件 ID (用于追踪与 GC)。
+         * @param slot 事件槽号 (见 `GlobalSlotOf`)，与 event_id 一一对应。
+         * @param e 位于调用者栈上的事件，仅在本次调用期间有效。
+         * @param promote 存在 kQueued 订阅者时，用于把 `e` 拷贝到堆上。
+         */
+        virtual void FireGlobalRefImpl(EventId event_id, EventSlotIndex slot, const Event& e, EventPromoter promote) = 0;
+
+        /**
+         * @brief 为 EventId 分配 (或查找) 进程级稳定的槽号。
+         * @param family 事件所属的事件族 (可为 nullptr)，首次解析时登记到事件族索引中。
+         */
+        [[nodiscard]] virtual EventSlotIndex ResolveEventSlot(EventId event_id, const char* family) = 0;
+
+        /** @brief 按槽号检查是否有活动的全局订阅 (无锁、无哈希)。 */
+        [[nodiscard]] virtual bool IsGlobalSlotSubscribed(EventSlotIndex slot) const = 0;
+
+        /**
+         * @brief 取得 TEvent 的槽号。
+         * @details 每个事件类型 (在每个模块内) 只解析一次，之后直接返回缓存值。
+         */
+        template <typename TEvent>
+        EventSlotIndex GlobalSlotOf() {
+            static const EventSlotIndex slot = ResolveEventSlot(TEvent::kEventId, detail::EventFamilyOf<TEvent>());
+            return slot;
+        }
+
+        /**
+         * @brief [批量发布] 见 `FireGlobalBatch`。
+         * @param batch 位于调用者栈上的视图 (array + count)，仅在本次调用期间有效。
+         */
+        virtual void FireGlobalBatchImpl(EventId event_id, EventSlotIndex slot, const EventBatchView& batch) = 0;
+
+        /** @brief [同步快速路径] 按引用发布特定发送者事件。参数含义同 `FireGlobalRefImpl`。 */
+        virtual void FireToSenderRefImpl(const std::weak_ptr<void>& sender_id,
+            EventId event_id, const Event& e, EventPromoter promote) = 0;
+
+        /**
+         * @brief [请求/应答] 登记请求处理者。见 `HandleRequests`。
+         * @param response_type 处理者的回复类型名，用于核对请求者期待的类型。
+         * @param executor 非空时处理函数投递到该执行器，否则按 type 执行。
+         */
+        [[nodiscard]] virtual Connection RegisterRequestHandlerImpl(
+            EventId request_id, std::weak_ptr<void> handler,
+            detail::RequestInvoker invoker, const char* response_type,
+            ConnectionType type, std::shared_ptr<IEventExecutor> executor) = 0;
+
+        /**
+         * @brief [请求/应答] 把请求交给唯一的处理者。
+         * @details 任何失败都通过 `state->Fail` 报告给请求者，本函数本身不抛出。
+         */
+        virtual void SendRequestImpl(EventId request_id,
+            std::shared_ptr<detail::RequestStateBase> state,
+            std::chrono::nanoseconds timeout) = 0;
+
+        /**
+         * @brief [保留事件] 替换 (EventId, 发送者) 的最新值。`sender_id` 为空表示全局。
+         * @details 只保存，不派发；随后的订阅者在订阅时收到它。发送者已销毁时忽略。
+         */
+        virtual void RetainEventImpl(EventId event_id, const std::weak_ptr<void>& sender_id, PluginPtr<Event> e_ptr) = 0;
+
+        /** @brief [保留事件] 读取最新值。见 `GetRetained`。 */
+        [[nodiscard]] virtual PluginPtr<Event> GetRetainedImpl(EventId event_id, const std::weak_ptr<void>& sender_id) const = 0;
+
+        /** @brief [保留事件] 丢弃最新值。见 `ClearRetained`。 */
+        virtual void ClearRetainedImpl(EventId event_id, const std::weak_ptr<void>& sender_id) = 0;
+
+        template <typename> friend class EventChannel;
+
+        /**
+         * @brief [EventChannel 专用] 取得 (必要时创建) 事件的通道状态。
+         * @details 通道状态归总线所有，地址在总线存活期间不变。
+         */
+        [[nodiscard]] virtual internal::EventChannelCore* GetChannelImpl(EventId event_id) = 0;
+
+        /** @brief [EventChannel 专用] 向通道自己的订阅数组追加一个同步订阅。 */
+        [[nodiscard]] virtual Connection SubscribeChannelImpl(internal::EventChannelCore* channel,
+            std::weak_ptr<void> sub, EventDelegate cb) = 0;
+
+        /**
+         * @brief [EventChannel 专用] 先投递给通道订阅者，再投递给同一事件的其他全局 / 事件族订阅者。
+         * @param promote 存在 kQueued 总线订阅者时，用于把 `e` 拷贝到堆上。
+         */
+        virtual void FireChannelImpl(internal::EventChannelCore* channel, const Event& e, EventPromoter promote) = 0;
+
+        friend class Connection;
+        friend class EventConnectionGroup;
+
+        /**
+         * @brief [Connection 专用] 连接已撕票 (票据置为 false) 后调用。
+         * @details 不复制、不扫描订阅列表：只登记惰性 GC，由 GC 批处理统一做物理删除。
+         * 撕票本身已经保证回调不会再执行。
+         */
+        virtual void ReleaseConnection(EventId event_id, const std::weak_ptr<void>& sender_key) = 0;
+
+        /**
+         * @brief [EventConnectionGroup 专用] 一批连接已撕票后调用：元素为 (事件 ID, 发送者)。
+         * @details 与逐个 `ReleaseConnection` 等价，但所有列表只登记一次、只调度一轮 GC。
+         */
+        virtual void ReleaseConnections(const std::vector<std::pair<EventId, std::weak_ptr<void>>>& released) = 0;
     };
 
     namespace clsid {
@@ -0,0 +1,171 @@
+﻿/*
+* Copyright [2025] [Yue Liu]
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/**
+ * @file i_executor_service.h
+ * @brief 定义框架共享的任务执行器接口 IExecutorService。
+ * @author Yue Liu
+ * @date 2025
+ *
+ * @details
+ * [受众：插件开发者 和 框架使用者]
+ *
+ * 以前每个子系统都自己起线程 (配置落盘线程、各插件的临时线程……)，彼此不协调，
+ * 合起来很容易让核数超额订阅。`IExecutorService` 是由框架统一持有的一组工作线程：
+ * - `Post`：投递一次性任务，按三档优先级调度；
+ * - `PostDelayed` / `CancelTimer`：延迟任务 (定时器)，到期后按其优先级入队；
+ * - `GetSerialQueue`：按名字取得一个串行队列 (strand)。同名队列的任务严格按投递顺序、
+ * 一次一个地在线程池上执行。它同时也是 `IEventExecutor`，可以直接传给事件订阅，
+ * 让 kQueued 回调在池上串行执行而不必另起线程。
+ * - `MakeStrand`：创建一个匿名、由调用者持有的 strand。给每个订阅者 (或一组需要互斥的订阅) 一个，
+ * 同一 strand 上的回调按顺序、互不重入；不同 strand 在池上并行，插件代码里不需要任何互斥锁。
+ *
+ * \code{.cpp}
+ * auto executor = z3y::GetService<z3y::IExecutorService>(z3y::clsid::kExecutor);
+ * executor->Post([] { RebuildIndex(); }, z3y::TaskPriority::kLow);
+ * auto strand = executor->GetSerialQueue("vision.results");
+ * conn_ = bus->SubscribeGlobal<ResultEvent>(self, &Sink::OnResult, strand);
+ *
+ * // 订阅者自己的 strand：两个回调共享状态，但永远不会同时执行
+ * strand_ = executor->MakeStrand();
+ * conns_.push_back(bus->SubscribeGlobal<FrameEvent>(self, &Sink::OnFrame, strand_));
+ * conns_.push_back(bus->SubscribeGlobal<ResetEvent>(self, &Sink::OnReset, strand_));
+ * \endcode
+ *
+ * [生命周期]
+ * 线程数由 `PluginManagerOptions::executor_threads` 决定，随 `PluginManager` 创建与销毁。
+ * 销毁时正在执行的任务会执行完，尚未开始的任务与定时器直接丢弃。
+ * 插件在 `Shutdown()` 中必须取消自己的定时器并等待自己投递的任务结束，
+ * 否则任务可能在插件库卸载之后才执行。
+ *
+ * [注意]
+ * - 调度是严格优先的：kHigh 持续满载时低优先级任务会被饿死。
+ * - 任务不应长时间阻塞，更不能在池内同步等待另一个池任务 (线程耗尽时会死锁)。
+ * - 任务抛出的异常被框架捕获，转交 `PluginManager::SetExceptionHandler` 设置的处理器。
+ */
+
+#pragma once
+
+#ifndef Z3Y_FRAMEWORK_I_EXECUTOR_SERVICE_H_
+#define Z3Y_FRAMEWORK_I_EXECUTOR_SERVICE_H_
+
+#include <chrono>      // 用于 std::chrono::nanoseconds
+#include <cstddef>     // 用于 size_t
+#include <cstdint>     // 用于 uint64_t
+#include <functional>  // 用于 std::function
+#include <memory>      // 用于 std::shared_ptr
+#include <string>      // 用于 std::string
+#include "framework/class_id.h"           // 依赖 ClassId
+#include "framework/event_executor.h"     // 依赖 IEventExecutor
+#include "framework/i_component.h"        // 依赖 IComponent
+#include "framework/interface_helpers.h"  // 依赖 Z3Y_DEFINE_INTERFACE
+
+namespace z3y {
+
+    /**
+     * @brief `IExecutorService` 服务的全局唯一 ClassId。
+     */
+    namespace clsid {
+        constexpr ClassId kExecutor =
+            ConstexprHash("z3y-core-executor-SERVICE-UUID");
+    }  // namespace clsid
+
+    /**
+     * @enum TaskPriority
+     * @brief 执行器任务的优先级。总是先取更高优先级的任务，同一优先级内先进先出。
+     */
+    enum class TaskPriority {
+        kHigh,    //!< 延迟敏感的短任务
+        kNormal,  //!< 默认
+        kLow,     //!< 后台整理、统计等可以等待的任务
+    };
+
+    /** @brief 优先级数量。 */
+    inline constexpr size_t kTaskPriorityCount = 3;
+
+    /** @brief 定时器句柄。0 表示无效 (投递失败)。 */
+    using TimerId = uint64_t;
+
+    /**
+     * @struct ExecutorStats
+     * @brief 执行器的运行统计快照 (见 `IExecutorService::GetExecutorStats`)。
+     * @details 各字段分别读取，彼此之间不保证严格一致。
+     */
+    struct ExecutorStats {
+        size_t worker_count = 0;     //!< 工作线程数
+        size_t queued_tasks = 0;     //!< 已就绪、等待执行的任务数 (不含未到期的定时器)
+        size_t active_tasks = 0;     //!< 正在执行的任务数
+        size_t pending_timers = 0;   //!< 尚未到期的定时器数
+        size_t serial_queues = 0;    //!< 已创建的具名串行队列数
+        uint64_t executed_tasks = 0; //!< 累计执行完毕的任务数 (含抛出异常的)
+        uint64_t failed_tasks = 0;   //!< 其中抛出异常的任务数
+        uint64_t max_queue_wait_ns = 0; //!< 任务从就绪到开始执行的最长等待
+    };
+
+    /**
+     * @class IExecutorService
+     * @brief 框架共享的线程池。所有函数都是线程安全的，可以在任务内部再次调用。
+     */
+    class IExecutorService : public virtual IComponent {
+    public:
+        Z3Y_DEFINE_INTERFACE(IExecutorService, "z3y-core-IExecutorService-IID-A0000004", 1, 0)
+
+        /**
+         * @brief 投递一个任务。
+         * @return 执行器已停止 (框架正在销毁) 时返回 false，任务被丢弃。
+         */
+        virtual bool Post(std::function<void()> task,
+            TaskPriority priority = TaskPriority::kNormal) = 0;
+
+        /**
+         * @brief 投递一个延迟任务：`delay` 之后按 `priority` 入队。
+         * @return 定时器句柄，可用于 `CancelTimer`；执行器已停止时返回 0。
+         */
+        virtual TimerId PostDelayed(std::chrono::nanoseconds delay,
+            std::function<void()> task,
+            TaskPriority priority = TaskPriority::kNormal) = 0;
+
+        /**
+         * @brief 取消一个尚未到期的定时器。
+         * @return true 表示任务不会执行；false 表示它已经到期入队、正在或已经执行 (或句柄无效)。
+         */
+        virtual bool CancelTimer(TimerId timer) = 0;
+
+        /**
+         * @brief 取得 (必要时创建) 一个具名串行队列。
+         * @details 同名返回同一个队列，队列常驻到框架销毁。投递到队列的任务以 `kNormal`
+         * 优先级在池上执行，同一时刻最多一个在执行，且严格按投递顺序。
+         */
+        [[nodiscard]] virtual std::shared_ptr<IEventExecutor> GetSerialQueue(
+            const std::string& name) = 0;
+
+        /**
+         * @brief 创建一个匿名 strand：语义与 `GetSerialQueue` 相同，但不登记名字，随最后一个引用释放。
+         * @details 投递端无锁，创建与空闲时不占用任何线程，适合每个订阅者各持一个。
+         * 任务由取到它的任意工作线程执行，按投递顺序、同一时刻最多一个。
+         */
+        [[nodiscard]] virtual std::shared_ptr<IEventExecutor> MakeStrand() = 0;
+
+        /** @brief 工作线程数。 */
+        [[nodiscard]] virtual size_t GetWorkerCount() const = 0;
+
+        /** @brief 运行统计。写侧只有 relaxed 原子操作与队列锁内的计数。 */
+        [[nodiscard]] virtual ExecutorStats GetExecutorStats() const = 0;
+    };
+
+}  // namespace z3y
+
+#endif  // Z3Y_FRAMEWORK_I_EXECUTOR_SERVICE_H_
@@ -45,9 +45,13 @@
 #ifndef Z3Y_FRAMEWORK_I_PLUGIN_QUERY_H_
 #define Z3Y_FRAMEWORK_I_PLUGIN_QUERY_H_
 
+#include <cstddef>  // 用于 size_t
+#include <cstdint>  // 用于 uint64_t
+#include <memory>   // 用于 std::shared_ptr
 #include <string>   // 用于 std::string
 #include <vector>   // 用于 std::vector
 #include "framework/class_id.h"         // 依赖 ClassId, InterfaceId
+#include "framework/connection_type.h"  // 依赖 ConnectionType
 #include "framework/i_component.h"      // 依赖 IComponent
 #include "framework/interface_helpers.h"  // 依赖 Z3Y_DEFINE_INTERFACE
 
@@ -83,6 +87,71 @@ namespace z3y {
         InterfaceVersion version;  //!< 接口的版本 (vMajor.vMinor)
     };
 
+    /**
+     * @struct InterfaceDescriptor
+     * @brief [数据结构] `InterfaceDetails` 的编译期形式。
+     * @details 由 `PluginImpl::GetInterfaceDescriptors()` 以 `static constexpr` 数组提供，
+     * 名称指向插件模块内的字符串常量，只在插件加载期间有效。
+     */
+    struct InterfaceDescriptor {
+        InterfaceId iid;
+        const char* name;
+        InterfaceVersion version;
+    };
+
+    /**
+     * @struct InterfaceDescriptorSpan
+     * @brief [数据结构] 一段连续 `InterfaceDescriptor` 的只读视图 (C++17 没有 std::span)。
+     */
+    struct InterfaceDescriptorSpan {
+        const InterfaceDescriptor* data = nullptr;
+        size_t size = 0;
+
+        [[nodiscard]] const InterfaceDescriptor* begin() const { return data; }
+        [[nodiscard]] const InterfaceDescriptor* end() const { return data + size; }
+    };
+
+    /**
+     * @class InterfaceList
+     * @brief [数据结构] 组件实现的接口列表。
+     * @details 注册时由框架从插件的描述符数组生成一次 (名称复制到框架持有的内存，
+     * 插件卸载后仍然有效)，之后注册表、快照与所有查询结果共享同一份只读数组：
+     * 复制本对象只增加引用计数，不分配内存。用法与只读的 `std::vector<InterfaceDetails>` 相同。
+     */
+    class InterfaceList {
+    public:
+        InterfaceList() = default;
+        explicit InterfaceList(std::vector<InterfaceDetails> items)
+            : items_(std::make_shared<const std::vector<InterfaceDetails>>(std::move(items))) {}
+
+        /** @brief 从插件的描述符数组生成 (注册时调用一次)。 */
+        static InterfaceList FromDescriptors(InterfaceDescriptorSpan descriptors) {
+            std::vector<InterfaceDetails> items;
+            items.reserve(descriptors.size);
+            for (const auto& d : descriptors) items.push_back(InterfaceDetails{ d.iid, d.name, d.version });
+            return InterfaceList(std::move(items));
+        }
+
+        [[nodiscard]] const InterfaceDetails* begin() const { return items_ ? items_->data() : nullptr; }
+        [[nodiscard]] const InterfaceDetails* end() const { return begin() + size(); }
+        [[nodiscard]] size_t size() const { return items_ ? items_->size() : 0; }
+        [[nodiscard]] bool empty() const { return size() == 0; }
+        [[nodiscard]] const InterfaceDetails& operator[](size_t i) const { return (*items_)[i]; }
+
+    private:
+        std::shared_ptr<const std::vector<InterfaceDetails>> items_;
+    };
+
+    /**
+     * @struct EventHandlerDetails
+     * @brief [数据结构] 组件以 `Z3Y_EVENT_HANDLER` 声明的一个事件处理函数。
+     */
+    struct EventHandlerDetails {
+        EventId event_id;                 //!< 订阅的事件
+        std::string event_name;           //!< 事件名
+        ConnectionType connection_type;   //!< 连接类型
+    };
+
     /**
      * @struct ComponentDetails
      * @brief [数据结构] 描述一个已注册的组件/服务的详细信息。
@@ -93,8 +162,77 @@ namespace z3y {
         bool is_singleton;           //!< 是服务 (true) 还是组件 (false)
         std::string source_plugin_path;  //!< 加载此组件的插件 DLL/SO 的完整路径
         bool is_registered_as_default;  //!< 是否被注册为至少一个接口的“默认”实现
-        std::vector<InterfaceDetails>
-            implemented_interfaces;  //!< 此组件实现的所有接口的列表
+        InterfaceList implemented_interfaces;  //!< 此组件实现的所有接口的列表 (各副本共享)
+        std::vector<EventHandlerDetails> event_handlers;  //!< 声明式事件处理函数 (每个实例创建时自动订阅)
+    };
+
+    /**
+     * @struct PluginLoadTiming
+     * @brief [数据结构] 一个插件的加载耗时分解 (纳秒，单调时钟)。
+     */
+    struct PluginLoadTiming {
+        std::string plugin_path;      //!< 插件路径
+        uint64_t start_ns = 0;        //!< 开始加载的时间点 (steady_clock)
+        uint64_t load_library_ns = 0; //!< dlopen / LoadLibraryExW：符号重定位 + 静态初始化 (含 AutoRegistrar)
+        uint64_t entry_point_ns = 0;  //!< z3yPluginInit：执行注册列表 (注册只被收集)
+        uint64_t commit_ns = 0;       //!< 在注册表写锁内校验并发布 (含等锁时间)
+        uint64_t event_ns = 0;        //!< ComponentRegisterEvent 的扇出
+        uint32_t thread_index = 0;    //!< 执行加载的线程编号 (进程内从 1 开始)
+        size_t component_count = 0;   //!< 发布的组件数
+        bool success = false;         //!< 是否加载成功
+        bool deferred = false;        //!< 命中清单缓存：只注册了延迟条目，没有加载库
+    };
+
+    /**
+     * @struct ServiceInitTiming
+     * @brief [数据结构] 一个单例服务首次构造的耗时。
+     */
+    struct ServiceInitTiming {
+        ClassId clsid = 0;            //!< 服务 CLSID
+        std::string alias;            //!< 服务别名
+        uint64_t start_ns = 0;        //!< 开始构造的时间点 (steady_clock)
+        uint64_t init_ns = 0;         //!< 工厂 + Initialize() 的耗时 (含其依赖的初始化)
+        uint32_t thread_index = 0;    //!< 执行初始化的线程编号
+        bool success = false;         //!< 是否构造成功
+    };
+
+    /**
+     * @struct StartupReport
+     * @brief [数据结构] 启动耗时报告：插件按加载顺序，服务按开始构造的时间排序。
+     */
+    struct StartupReport {
+        std::vector<PluginLoadTiming> plugins;
+        std::vector<ServiceInitTiming> services;
+    };
+
+    /**
+     * @struct PluginMemoryUsage
+     * @brief [数据结构] 一个插件当前占用的、经框架记账的内存。
+     * @details 只统计由框架工厂构造的组件实例、插件建立的订阅，以及插件经由框架分级内存池的分配；
+     * 插件内部自行分配的内存不在其中。
+     */
+    struct PluginMemoryUsage {
+        std::string plugin_path;        //!< 插件路径
+        int64_t component_bytes = 0;    //!< 存活组件实例 (含控制块) 的字节数
+        int64_t live_components = 0;    //!< 存活组件实例数 (含单例)
+        int64_t subscription_bytes = 0; //!< 存活订阅条目的字节数
+        int64_t subscriptions = 0;      //!< 存活订阅数
+        int64_t pool_bytes = 0;         //!< 从分级内存池 (`IAllocatorService::GetPoolResource`) 借出的字节数
+        int64_t pool_allocations = 0;   //!< 累计从分级内存池分配的次数
+    };
+
+    /**
+     * @struct PluginCpuUsage
+     * @brief [数据结构] 一个插件累计消耗的、经框架记账的线程 CPU 时间。
+     * @details 只统计插件订阅的事件回调与其组件的构造 / `Initialize()` / `Shutdown()`；
+     * 宿主或其他插件直接调用它的服务方法不经过框架，不在其中。嵌套回调的时间同时计入外层。
+     */
+    struct PluginCpuUsage {
+        std::string plugin_path;        //!< 插件路径
+        uint64_t callback_cpu_ns = 0;   //!< 累计事件回调 CPU 时间 (纳秒)
+        uint64_t callback_calls = 0;    //!< 累计事件回调次数
+        uint64_t lifecycle_cpu_ns = 0;  //!< 累计构造 / Initialize / Shutdown CPU 时间 (纳秒)
+        uint64_t lifecycle_calls = 0;   //!< 累计构造 / Initialize / Shutdown 次数
     };
 
     /**
@@ -121,7 +259,7 @@ namespace z3y {
      */
     class IPluginQuery : public virtual IComponent {
     public:
-        Z3Y_DEFINE_INTERFACE(IPluginQuery, "z3y-core-IPluginQuery-IID-A0000003", 1, 0)
+        Z3Y_DEFINE_INTERFACE(IPluginQuery, "z3y-core-IPluginQuery-IID-A0000003", 1, 3)
 
             /**
              * @brief 获取当前注册在框架中的 *所有* 组件和服务的详细信息。
@@ -171,6 +309,25 @@ namespace z3y {
          */
         [[nodiscard]] virtual std::vector<ComponentDetails> GetComponentsFromPlugin(
             const std::string& plugin_path) const = 0;
+
+        /**
+         * @brief [v1.1] 获取启动耗时报告：每个插件的加载阶段耗时，以及已构造单例的初始化耗时。
+         * @details 记录自上次 `UnloadAllPlugins()` 起累积；可通过 `PluginManager::DumpStartupTrace` 导出为 Chrome Trace。
+         */
+        [[nodiscard]] virtual StartupReport GetStartupReport() const = 0;
+
+        /**
+         * @brief [v1.2] 获取每个插件的内存占用 (按插件路径排序)。
+         * @details 仅当宿主以 `PluginManagerOptions::enable_memory_accounting` 启动时有数据，否则返回空列表。
+         */
+        [[nodiscard]] virtual std::vector<PluginMemoryUsage> GetPluginMemoryUsage() const = 0;
+
+        /**
+         * @brief [v1.3] 获取每个插件累计的 CPU 时间 (按插件路径排序)。
+         * @details 仅当宿主以 `PluginManagerOptions::enable_cpu_accounting` 启动时有数据，否则返回空列表。
+         * 计数只增不减，两次读取之差即为这段时间的消耗。
+         */
+        [[nodiscard]] virtual std::vector<PluginCpuUsage> GetPluginCpuUsage() const = 0;
     };
 
 }  // namespace z3y
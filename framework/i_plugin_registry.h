@@ -42,6 +42,7 @@
  * 宏自动完成：
  * - `Z3Y_AUTO_REGISTER_SERVICE(...)`
  * - `Z3Y_AUTO_REGISTER_COMPONENT(...)`
+ * - `Z3Y_EVENT_HANDLER(...)`
  * - `Z3Y_DEFINE_PLUGIN_ENTRY`
  */
 
@@ -51,9 +52,12 @@
 #define Z3Y_FRAMEWORK_I_PLUGIN_REGISTRY_H_
 
 #include <functional>  // 用于 std::function
+#include <memory>      // 用于 std::shared_ptr
 #include <string>      // 用于 std::string
 #include <vector>      // 用于 std::vector
-#include "framework/class_id.h"       // 依赖 ClassId
+#include "framework/class_id.h"       // 依赖 ClassId, EventId
+#include "framework/connection_type.h"  // 依赖 ConnectionType
+#include "framework/event_delegate.h"   // 依赖 EventDelegate
 #include "framework/i_component.h"    // 依赖 PluginPtr, IComponent
 #include "framework/i_plugin_query.h" // 依赖 InterfaceDetails
 
@@ -94,6 +98,47 @@ namespace z3y {
   */
     using FactoryFunction = std::function<PluginPtr<IComponent>()>;
 
+    /**
+     * @brief 无状态工厂的函数指针形式。
+     *
+     * [受众：框架维护者]
+     *
+     * `plugin_registration.h` 生成的工厂都是无状态的，并以该函数指针类型装入 `FactoryFunction`。
+     * `PluginManager` 在注册时识别出这种情形并单独保存指针，
+     * 此后 `CreateInstance` 只需复制一个指针，而不必在锁内拷贝 `std::function`。
+     */
+    using FactoryFunctionPtr = PluginPtr<IComponent> (*)();
+
+    /**
+     * @struct EventHandlerEntry
+     * @brief [框架内部] 一条声明式事件处理函数 (由 `Z3Y_EVENT_HANDLER` 生成的编译期常量)。
+     * @details 组件每创建一个实例 (`Initialize()` 之后)，管理器就按这些条目为它订阅全局事件；
+     * 订阅随实例释放失效。函数指针与名称都指向插件模块内部，只在插件加载期间有效。
+     */
+    struct EventHandlerEntry {
+        EventId event_id;                 //!< 订阅的事件
+        const char* event_name;           //!< 事件名 (`TEvent::kName`，供内省)
+        ConnectionType connection_type;   //!< 连接类型
+        EventDelegate (*bind)();          //!< 生成绑定到实现类成员函数的回调
+        std::shared_ptr<void> (*subscriber)(const PluginPtr<IComponent>& instance);  //!< 实例 -> 实现类指针
+    };
+
+    /**
+     * @struct ComponentRegistration
+     * @brief [框架内部] 一条组件注册 (`IPluginRegistry::RegisterComponents` 的元素)。
+     * @details 字段含义与 `RegisterComponent` / `RegisterPooledComponent` 的参数一一对应。
+     */
+    struct ComponentRegistration {
+        ClassId clsid;
+        FactoryFunction factory;
+        bool is_singleton;
+        std::string alias;
+        InterfaceDescriptorSpan implemented_interfaces;
+        bool is_default = false;
+        bool factory_initializes = false;  //!< 工厂返回已初始化的对象 (池化组件)
+        std::vector<EventHandlerEntry> event_handlers;  //!< 声明式事件处理函数 (按 event_id 排序)
+    };
+
     /**
      * @class IPluginRegistry
      * @brief [框架内部] 插件注册器接口。
@@ -126,8 +171,9 @@ namespace z3y {
          * 组件的唯一别名字符串 (例如 "Demo.Logger.Default")。
          * 如果为空，则不注册别名。
          * @param[in] implemented_interfaces
-         * 一个 `InterfaceDetails` 列表 (由
-         * `PluginImpl::GetInterfaceDetails()` 自动提供)。
+         * 编译期生成的接口描述符数组 (由
+         * `PluginImpl::GetInterfaceDescriptors()` 自动提供)。
+         * 只在本次调用 (或本次插件加载) 期间有效，框架注册时自行复制一份。
          * @param[in] is_default (默认为 `false`)
          * - `true`: 标记这个实现为它所实现的 *所有* 接口的“默认”实现。
          * (允许使用者通过 `GetDefaultService<IDemoLogger>()` 来获取它)。
@@ -136,8 +182,41 @@ namespace z3y {
         virtual void RegisterComponent(
             ClassId clsid, FactoryFunction factory, bool is_singleton,
             const std::string& alias,
-            std::vector<InterfaceDetails> implemented_interfaces,
+            InterfaceDescriptorSpan implemented_interfaces,
             bool is_default = false) = 0;
+
+        /**
+         * @brief [框架内部] 注册一个池化的瞬态组件。
+         *
+         * [受众：框架维护者]
+         * 由 `z3y::RegisterPooledComponent` 调用。与 `RegisterComponent(..., false, ...)` 相同，
+         * 唯一区别是 `factory` 返回的对象 *已经初始化* (可能是从池中复用的)，
+         * `CreateInstance` 不会再对它调用 `Initialize()`。
+         */
+        virtual void RegisterPooledComponent(
+            ClassId clsid, FactoryFunction factory, const std::string& alias,
+            InterfaceDescriptorSpan implemented_interfaces,
+            bool is_default = false) = 0;
+
+        /**
+         * @brief [框架内部] 一次注册多个组件。
+         *
+         * [受众：框架维护者]
+         * 由 `Z3Y_DEFINE_PLUGIN_ENTRY` 生成的入口函数调用：整批在一次写锁内校验并发布
+         * (任一冲突则整批不注册并抛出)，并只触发一次 `event::ComponentsRegisteredEvent`。
+         */
+        virtual void RegisterComponents(std::vector<ComponentRegistration> registrations) = 0;
+
+        /**
+         * @brief [框架内部] 为已注册的组件追加一条声明式事件处理函数。
+         *
+         * [受众：框架维护者]
+         * 由 `Z3Y_EVENT_HANDLER` 生成的注册任务调用。入口函数的收集器会把它们并入同一插件的
+         * `ComponentRegistration::event_handlers`，只有找不到对应注册时才转给管理器。
+         * 之后创建的实例才会订阅，已存在的实例不受影响。
+         * @throws std::runtime_error `clsid` 尚未注册。
+         */
+        virtual void RegisterEventHandler(ClassId clsid, const EventHandlerEntry& handler) = 0;
     };
 
 }  // namespace z3y
@@ -0,0 +1,177 @@
+﻿/*
+* Copyright [2025] [Yue Liu]
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/**
+ * @file i_timer_service.h
+ * @brief 定义框架共享的定时器服务接口 ITimerService (分层时间轮)。
+ * @author Yue Liu
+ * @date 2025
+ *
+ * @details
+ * [受众：插件开发者 和 框架使用者]
+ *
+ * 周期性工作以前要么自己起线程 `sleep_for` 循环，要么依赖 Qt 定时器。`ITimerService`
+ * 是框架持有的分层时间轮，由共享执行器 (`IExecutorService`) 驱动，不占用额外线程：
+ * - `StartOneShot` / `StartPeriodic` / `StartDeadline`：一次性、周期与绝对截止时间三种定时器；
+ * - `RestartTimer`：重新计时 (看门狗、每帧超时)，`StopTimer`：取消。都是 O(1)；
+ * - `FireGlobalAfter` / `FireGlobalEvery`：到期时发布事件，而不是执行回调。
+ *
+ * 时间轮按 `PluginManagerOptions::timer_tick` (默认 1 ms) 取整：定时器不会提前触发，最多推迟一个刻度。
+ * 同一刻度到期的所有定时器只唤醒一次，投递到共享执行器的回调按优先级合并成一个任务。
+ * `TimerOptions::slack` 允许再推迟一段时间，让到期时间相近的定时器对齐到同一刻度，进一步减少唤醒。
+ *
+ * \code{.cpp}
+ * auto timers = z3y::GetService<z3y::ITimerService>(z3y::clsid::kTimerService);
+ * heartbeat_ = timers->StartPeriodic(std::chrono::seconds(1), [this] { SendHeartbeat(); });
+ * watchdog_ = timers->StartOneShot(std::chrono::milliseconds(40), [this] { OnFrameTimeout(); });
+ * timers->RestartTimer(watchdog_, std::chrono::milliseconds(40));  // 每收到一帧就重新计时
+ * z3y::FireGlobalAfter(*timers, bus, std::chrono::milliseconds(500), SettleEvent{});
+ * \endcode
+ *
+ * [生命周期]
+ * 与共享执行器一致：插件在 `Shutdown()` 中必须停止自己的定时器；卸载全部插件时框架清空时间轮。
+ * `StopTimer` 返回后，已经到期并投递出去的那一次回调仍可能执行。
+ * 周期回调执行得比周期还慢时，相邻两次可能并发执行；需要串行时把 `TimerOptions::executor` 设为串行队列。
+ */
+
+#pragma once
+
+#ifndef Z3Y_FRAMEWORK_I_TIMER_SERVICE_H_
+#define Z3Y_FRAMEWORK_I_TIMER_SERVICE_H_
+
+#include <chrono>      // 用于 std::chrono
+#include <cstddef>     // 用于 size_t
+#include <cstdint>     // 用于 uint64_t
+#include <functional>  // 用于 std::function
+#include <memory>      // 用于 std::shared_ptr
+#include <utility>     // 用于 std::move
+#include "framework/class_id.h"             // 依赖 ClassId
+#include "framework/event_executor.h"       // 依赖 IEventExecutor
+#include "framework/i_component.h"          // 依赖 IComponent
+#include "framework/i_event_bus.h"          // 依赖 IEventBus (FireGlobalAfter)
+#include "framework/i_executor_service.h"   // 依赖 TaskPriority, TimerId
+#include "framework/interface_helpers.h"    // 依赖 Z3Y_DEFINE_INTERFACE
+
+namespace z3y {
+
+    /**
+     * @brief `ITimerService` 服务的全局唯一 ClassId。
+     */
+    namespace clsid {
+        constexpr ClassId kTimerService =
+            ConstexprHash("z3y-core-timer-SERVICE-UUID");
+    }  // namespace clsid
+
+    /**
+     * @struct TimerOptions
+     * @brief 定时器的可选参数。
+     */
+    struct TimerOptions {
+        /** @brief 回调在共享执行器上的优先级 (指定了 executor 时忽略)。 */
+        TaskPriority priority = TaskPriority::kNormal;
+
+        /**
+         * @brief 允许推迟的最长时间 (默认 0)。
+         * @details 到期刻度向上对齐到不超过 slack 的 2 的幂个刻度，到期时间相近的定时器因此落在同一刻度。
+         */
+        std::chrono::nanoseconds slack{ 0 };
+
+        /** @brief 非空时回调投递到该执行器 (例如 `GetSerialQueue` 的串行队列)，否则投递到共享执行器。 */
+        std::shared_ptr<IEventExecutor> executor;
+    };
+
+    /**
+     * @struct TimerServiceStats
+     * @brief 定时器服务的运行统计快照 (见 `ITimerService::GetTimerStats`)。
+     */
+    struct TimerServiceStats {
+        size_t active_timers = 0;       //!< 尚未到期 (或周期性) 的定时器数
+        uint64_t started_timers = 0;    //!< 累计启动的定时器数
+        uint64_t fired_timers = 0;      //!< 累计触发次数 (周期定时器每次都计)
+        uint64_t wakeups = 0;           //!< 时间轮被执行器唤醒的次数 (合并效果 = fired / wakeups)
+        uint64_t cascaded_timers = 0;   //!< 从高层轮降级到低层轮的次数
+        uint64_t tick_ns = 0;           //!< 时间轮刻度
+    };
+
+    /**
+     * @class ITimerService
+     * @brief 框架共享的定时器服务。所有函数都是线程安全的，可以在定时器回调中调用。
+     * @details 这里的 `TimerId` 只对本服务有效，与 `IExecutorService::PostDelayed` 的句柄互不相通。
+     */
+    class ITimerService : public virtual IComponent {
+    public:
+        Z3Y_DEFINE_INTERFACE(ITimerService, "z3y-core-ITimerService-IID-A0000006", 1, 0)
+
+        /**
+         * @brief 启动一次性定时器：`delay` 之后执行 `callback`。
+         * @return 定时器句柄；callback 为空时返回 0。
+         */
+        virtual TimerId StartOneShot(std::chrono::nanoseconds delay,
+            std::function<void()> callback, const TimerOptions& options = {}) = 0;
+
+        /**
+         * @brief 启动周期定时器：每隔 `period` 执行一次，直到 `StopTimer`。
+         * @details 按计划时间推进 (不累计漂移)；落后超过一个周期时跳过错过的次数，不补发。
+         */
+        virtual TimerId StartPeriodic(std::chrono::nanoseconds period,
+            std::function<void()> callback, const TimerOptions& options = {}) = 0;
+
+        /** @brief 启动截止时间定时器：在 `deadline` (已过去则尽快) 执行一次。 */
+        virtual TimerId StartDeadline(std::chrono::steady_clock::time_point deadline,
+            std::function<void()> callback, const TimerOptions& options = {}) = 0;
+
+        /**
+         * @brief 把定时器的下一次到期改为从现在起 `delay` 之后 (周期不变)。
+         * @return 定时器已触发 (一次性)、已停止或句柄无效时返回 false。
+         */
+        virtual bool RestartTimer(TimerId timer, std::chrono::nanoseconds delay) = 0;
+
+        /**
+         * @brief 停止定时器。
+         * @return true 表示此后不会再有新的触发；false 表示它已经触发 (一次性) 或句柄无效。
+         */
+        virtual bool StopTimer(TimerId timer) = 0;
+
+        /** @brief 运行统计。 */
+        [[nodiscard]] virtual TimerServiceStats GetTimerStats() const = 0;
+    };
+
+    /**
+     * @brief 在 `delay` 之后发布一次全局事件 `event` (事件必须可拷贝)。
+     * @details 定时器只持有事件总线的弱引用。
+     */
+    template <typename TEvent>
+    TimerId FireGlobalAfter(ITimerService& timers, const PluginPtr<IEventBus>& bus,
+        std::chrono::nanoseconds delay, TEvent event, const TimerOptions& options = {}) {
+        std::weak_ptr<IEventBus> weak_bus = bus;
+        return timers.StartOneShot(delay, [weak_bus, event = std::move(event)]() {
+            if (auto strong_bus = weak_bus.lock()) strong_bus->template FireGlobal<TEvent>(event);
+            }, options);
+    }
+
+    /** @brief 每隔 `period` 发布一次全局事件 `event` 的副本，直到 `StopTimer`。 */
+    template <typename TEvent>
+    TimerId FireGlobalEvery(ITimerService& timers, const PluginPtr<IEventBus>& bus,
+        std::chrono::nanoseconds period, TEvent event, const TimerOptions& options = {}) {
+        std::weak_ptr<IEventBus> weak_bus = bus;
+        return timers.StartPeriodic(period, [weak_bus, event = std::move(event)]() {
+            if (auto strong_bus = weak_bus.lock()) strong_bus->template FireGlobal<TEvent>(event);
+            }, options);
+    }
+
+}  // namespace z3y
+
+#endif  // Z3Y_FRAMEWORK_I_TIMER_SERVICE_H_
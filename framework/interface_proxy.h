@@ -0,0 +1,158 @@
+﻿/*
+* Copyright [2025] [Yue Liu]
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/**
+ * @file interface_proxy.h
+ * @brief 接口调用拦截代理：`GetService<T>` / `CreateInstance<T>` 返回转发到真实对象的代理。
+ * @author Yue Liu
+ * @date 2025
+ *
+ * @details
+ * [受众：宿主开发者 (剖析无法插桩的第三方插件)]
+ *
+ * 在接口定义之后 (全局命名空间) 用描述宏列出接口的全部虚函数，即生成一个实现该接口的代理类：
+ *
+ * \code{.cpp}
+ * class IDemoSimple : public virtual z3y::IComponent {
+ * public:
+ *   Z3Y_DEFINE_INTERFACE(IDemoSimple, "z3y-demo-IDemoSimple-IID-...", 1, 0)
+ *   virtual std::string GetSimpleString() = 0;
+ *   virtual int Add(int a, int b) const = 0;
+ * };
+ *
+ * Z3Y_INTERFACE_PROXY_BEGIN(IDemoSimple, z3y::interfaces::profiler::ProxyCallTimer)
+ *   Z3Y_PROXY_METHOD(std::string, GetSimpleString, (), ())
+ *   Z3Y_PROXY_CONST_METHOD(int, Add, (int a, int b), (a, b))
+ * Z3Y_INTERFACE_PROXY_END()
+ * \endcode
+ *
+ * 拦截按接口名 (`T::kName`) 或 ClassId / 组件别名开启 (`PluginManager::SetCallInterception`，
+ * Profiler 插件的 `System.Profiler.InterceptedCalls`)。命中时 `GetService<T>` / `TryGetService<T>` /
+ * `CreateInstance<T>` 返回代理，每次调用先构造一个 `CallScope` 再转发给真实对象。
+ *
+ * - **零开销**：没有描述宏的接口在编译期跳过；有描述宏但未开启任何拦截时只多一次 relaxed 原子读。
+ * - `CallScope` 须提供可由 `(接口名, 方法名, 文件, 行号)` 构造的嵌套类型 `Site` (每个方法一个静态实例)，
+ *   以及以 `Site&` 构造的 RAII 构造函数。`NullCallScope` 什么都不做。
+ *
+ * [约定]
+ * - 描述宏必须与接口定义放在同一个头文件里 (或任何使用该接口的翻译单元都会包含的头文件)，
+ *   否则不同翻译单元看到的 `GetService<T>` 不一致。
+ * - 必须列出接口 (含基接口) 的全部纯虚函数，否则代理类是抽象类，编译失败。
+ *   返回类型含逗号时先用 `using` 起别名。
+ * - 代理只代表请求的接口 T：把它 `PluginCast` 到其他接口得到的是真实对象 (不计时)。
+ * - 每次获取都会新建一个代理，因此开启拦截后同一单例两次 `GetService` 的指针不再相同。
+ */
+
+#pragma once
+
+#ifndef Z3Y_FRAMEWORK_INTERFACE_PROXY_H_
+#define Z3Y_FRAMEWORK_INTERFACE_PROXY_H_
+
+#include <memory>
+#include <utility>
+
+#include "framework/class_id.h"
+#include "framework/i_component.h"
+
+namespace z3y {
+
+    /**
+     * @brief 接口的代理描述。主模板表示"没有代理"，由 `Z3Y_INTERFACE_PROXY_BEGIN` 特化。
+     */
+    template <typename T>
+    struct InterfaceProxyTraits {
+        static constexpr bool kAvailable = false;
+    };
+
+    /** @brief 不做任何事的调用作用域 (只需要拦截、不需要计时时使用)。 */
+    struct NullCallScope {
+        struct Site {
+            Site(const char*, const char*, const char*, int) noexcept {}
+        };
+        explicit NullCallScope(Site&) noexcept {}
+    };
+
+    /**
+     * @brief [内部] 代理类的公共部分：持有真实对象，接口查询对 T 返回代理自身，其余转发。
+     */
+    template <typename T>
+    class InterfaceProxyBase : public T {
+    public:
+        explicit InterfaceProxyBase(PluginPtr<T> target) : target_(std::move(target)) {}
+
+        void* QueryInterfaceRaw(InterfaceId iid, uint32_t major, uint32_t minor,
+            InstanceError& out_result) override {
+            // 版本检查交给真实对象
+            void* real = target_->QueryInterfaceRaw(iid, major, minor, out_result);
+            if (real && iid == T::kIid) return static_cast<T*>(this);
+            return real;
+        }
+
+    protected:
+        PluginPtr<T> target_;
+    };
+
+}  // namespace z3y
+
+/**
+ * @def Z3Y_INTERFACE_PROXY_BEGIN
+ * @brief 开始描述 Interface 的代理 (在全局命名空间使用)。
+ * @param Interface 接口的完整类名。
+ * @param CallScope 每次调用的作用域类型 (见文件说明)。
+ */
+#define Z3Y_INTERFACE_PROXY_BEGIN(Interface, CallScope)                         \
+  namespace z3y {                                                               \
+  template <>                                                                   \
+  struct InterfaceProxyTraits<Interface> {                                      \
+    static constexpr bool kAvailable = true;                                    \
+    class Proxy final : public InterfaceProxyBase<Interface> {                  \
+     public:                                                                    \
+      using Proxied = Interface;                                                \
+      using Scope = CallScope;                                                  \
+      using InterfaceProxyBase<Interface>::InterfaceProxyBase;
+
+/** @brief 代理一个方法的函数体：静态调用点 + 作用域 + 转发。 */
+#define Z3Y_PROXY_FORWARD_BODY(Name, Args)                                      \
+  {                                                                             \
+    static Scope::Site z3y_proxy_site(Proxied::kName, #Name, __FILE__,          \
+                                      __LINE__);                                \
+    Scope z3y_proxy_scope(z3y_proxy_site);                                      \
+    return this->target_->Name Args;                                            \
+  }
+
+/**
+ * @def Z3Y_PROXY_METHOD
+ * @brief 代理一个非 const 虚函数。
+ * @param Params 带括号的形参表，如 `(int a, const std::string& b)`。
+ * @param Args   带括号的实参表，如 `(a, b)`。
+ */
+#define Z3Y_PROXY_METHOD(Ret, Name, Params, Args) \
+  Ret Name Params override Z3Y_PROXY_FORWARD_BODY(Name, Args)
+
+/** @brief 代理一个 const 虚函数 (参数同 `Z3Y_PROXY_METHOD`)。 */
+#define Z3Y_PROXY_CONST_METHOD(Ret, Name, Params, Args) \
+  Ret Name Params const override Z3Y_PROXY_FORWARD_BODY(Name, Args)
+
+/** @brief 结束代理描述。 */
+#define Z3Y_INTERFACE_PROXY_END()                                               \
+    };                                                                          \
+    static PluginPtr<Proxy::Proxied> Wrap(PluginPtr<Proxy::Proxied> target) {   \
+      return std::make_shared<Proxy>(std::move(target));                        \
+    }                                                                           \
+  };                                                                            \
+  }
+
+#endif  // Z3Y_FRAMEWORK_INTERFACE_PROXY_H_
@@ -0,0 +1,189 @@
+﻿/*
+* Copyright [2025] [Yue Liu]
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/**
+ * @file ipc_event_bridge.h
+ * @brief [高级] 基于共享内存的跨进程事件桥 `IpcEventBridge`。
+ * @author Yue Liu
+ * @date 2025
+ *
+ * @details
+ * [受众：宿主开发者 (隔离运行第三方插件)]
+ *
+ * 事件总线只在进程内工作。要把容易崩溃的第三方插件放进子进程隔离，又不想牺牲性能，
+ * 可以在两个进程里各建一个桥，选定的事件类型会在两边的总线之间转发：
+ * - 每个方向一个共享内存环形缓冲区 (单生产者/单消费者，记录按 8 字节对齐，读端直接在共享内存上反序列化)；
+ * - 本进程内多个发布线程通过一把互斥锁串行写入，因此跨进程只有一个生产者；
+ * - 接收线程自适应退避 (自旋 → 让出 → 短睡眠)，空闲时几乎不占 CPU；
+ * - 两边依旧使用普通的 `SubscribeGlobal` / `FireGlobal`：`Export<TEvent>()` 以 kDirect 订阅本地事件并写入环，
+ * `Import<TEvent>()` 在接收线程上把对端事件还原后 `FireGlobal`。
+ *
+ * 只有用 `Z3Y_DEFINE_SERIALIZABLE_EVENT` 声明的事件才能桥接 (见 `framework/event_serialization.h`)。
+ * 被导入的事件不会再被任何桥导出，两端同时 Export + Import 同一类型也不会来回打转。
+ *
+ * \code{.cpp}
+ * // 宿主进程
+ * std::string err;
+ * auto bridge = z3y::IpcEventBridge::Create("vision-sandbox", bus, err);
+ * bridge->Export<InspectRequestEvent>();
+ * bridge->Import<DefectFoundEvent>();
+ * LaunchChildHost("--ipc-bridge=vision-sandbox");
+ *
+ * // 子宿主进程
+ * auto bridge = z3y::IpcEventBridge::Open("vision-sandbox", bus, err);
+ * bridge->Import<InspectRequestEvent>();
+ * bridge->Export<DefectFoundEvent>();
+ * \endcode
+ *
+ * [注意]
+ * - 环满时新事件被丢弃并计入 `dropped_events` (不阻塞发布者)。单个事件不能超过环容量的一半。
+ * - `Import` 注册的还原函数位于调用方模块中：桥必须在该模块卸载之前销毁。
+ * - 崩溃的一端不会清理共享内存里的连接标记；`IsPeerAttached` 只反映对端是否正常打开且尚未关闭。
+ */
+
+#pragma once
+
+#ifndef Z3Y_FRAMEWORK_IPC_EVENT_BRIDGE_H_
+#define Z3Y_FRAMEWORK_IPC_EVENT_BRIDGE_H_
+
+#include <cstddef>   // 用于 size_t
+#include <cstdint>   // 用于 uint64_t
+#include <memory>    // 用于 std::unique_ptr
+#include <string>    // 用于 std::string
+#include <type_traits>
+#include "framework/connection.h"           // 依赖 Connection
+#include "framework/event_serialization.h"  // 依赖 EventWriter / EventReader
+#include "framework/i_event_bus.h"          // 依赖 IEventBus
+#include "framework/z3y_framework_api.h"    // Z3Y_FRAMEWORK_API 导出
+
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable : 4251)
+#endif
+
+namespace z3y {
+
+    /**
+     * @struct IpcBridgeStats
+     * @brief 桥的运行统计 (见 `IpcEventBridge::GetStats`)。
+     */
+    struct IpcBridgeStats {
+        uint64_t sent_events = 0;        //!< 写入发送环的事件数
+        uint64_t received_events = 0;    //!< 从接收环取出并成功发布的事件数
+        uint64_t dropped_events = 0;     //!< 因发送环已满或事件过大而丢弃的事件数
+        uint64_t unknown_events = 0;     //!< 收到但本端没有 Import 的事件数
+        uint64_t decode_failures = 0;    //!< 反序列化或发布时抛出异常的事件数
+        size_t send_ring_used_bytes = 0; //!< 发送环中尚未被对端取走的字节数
+    };
+
+    /**
+     * @class IpcEventBridge
+     * @brief 一对进程之间的事件桥。创建者一端用 `Create`，另一端用 `Open`。
+     */
+    class Z3Y_FRAMEWORK_API IpcEventBridge {
+    public:
+        /** @brief 每个方向的默认环容量。 */
+        static constexpr size_t kDefaultRingBytes = size_t(4) << 20;
+
+        /**
+         * @brief [创建者] 新建名为 `name` 的共享内存段并开始接收。
+         * @param name 只能包含字母、数字、'-'、'_'、'.'。同名段已存在时失败。
+         * @param ring_bytes 每个方向的环容量，向上取整到 2 的幂 (最小 64 KB)。
+         * @return 失败时返回 nullptr，原因写入 `out_error_message`。
+         */
+        [[nodiscard]] static std::unique_ptr<IpcEventBridge> Create(const std::string& name,
+            PluginPtr<IEventBus> bus, std::string& out_error_message, size_t ring_bytes = kDefaultRingBytes);
+
+        /**
+         * @brief [对端] 打开由 `Create` 建立的段并开始接收。
+         * @return 段不存在、格式不符或已有对端时返回 nullptr。
+         */
+        [[nodiscard]] static std::unique_ptr<IpcEventBridge> Open(const std::string& name,
+            PluginPtr<IEventBus> bus, std::string& out_error_message);
+
+        /** @brief 断开所有导出订阅、停止接收线程并解除映射 (创建者同时删除段名)。 */
+        ~IpcEventBridge();
+        IpcEventBridge(const IpcEventBridge&) = delete;
+        IpcEventBridge& operator=(const IpcEventBridge&) = delete;
+
+        /** @brief 把本地发布的 `TEvent` 转发给对端。重复调用只导出一次。 */
+        template <typename TEvent>
+        void Export() {
+            static_assert(IsSerializableEvent<TEvent>::value,
+                "IpcEventBridge::Export requires an event declared with Z3Y_DEFINE_SERIALIZABLE_EVENT");
+            if (!BeginExport(TEvent::kEventId)) return;
+            auto sink = std::make_shared<ExportSink<TEvent>>(this);
+            Connection conn = bus_->SubscribeGlobal<TEvent>(sink, &ExportSink<TEvent>::OnEvent);
+            AddExport(std::move(sink), std::move(conn));
+        }
+
+        /** @brief 把对端发来的 `TEvent` 在本地 `FireGlobal`。重复调用只注册一次。 */
+        template <typename TEvent>
+        void Import() {
+            static_assert(IsSerializableEvent<TEvent>::value,
+                "IpcEventBridge::Import requires an event declared with Z3Y_DEFINE_SERIALIZABLE_EVENT");
+            AddImport(TEvent::kEventId, [](IEventBus& bus, EventReader& reader) {
+                bus.FireGlobal<TEvent>(TEvent::Deserialize(reader));
+                });
+        }
+
+        /** @brief 对端是否已打开且尚未关闭。 */
+        [[nodiscard]] bool IsPeerAttached() const;
+
+        [[nodiscard]] IpcBridgeStats GetStats() const;
+
+    private:
+        using Decoder = void (*)(IEventBus&, EventReader&);
+        struct Impl;
+
+        /** @brief 以 kDirect 订阅本地事件的接收者：序列化后写入发送环。 */
+        template <typename TEvent>
+        class ExportSink : public std::enable_shared_from_this<ExportSink<TEvent>> {
+        public:
+            explicit ExportSink(IpcEventBridge* bridge) : bridge_(bridge) {}
+            void OnEvent(const TEvent& e) {
+                if (IsDispatchingImported()) return;
+                thread_local EventWriter writer;
+                writer.Clear();
+                e.Serialize(writer);
+                bridge_->Send(TEvent::kEventId, writer.Buffer().data(), writer.Size());
+            }
+
+        private:
+            IpcEventBridge* bridge_;
+        };
+
+        IpcEventBridge(std::unique_ptr<Impl> impl, PluginPtr<IEventBus> bus);
+
+        /** @brief 当前线程是否正在发布某个桥导入的事件 (导入的事件不再导出)。 */
+        static bool IsDispatchingImported() noexcept;
+
+        bool BeginExport(EventId event_id);
+        void AddExport(std::shared_ptr<void> sink, Connection connection);
+        void AddImport(EventId event_id, Decoder decoder);
+        void Send(EventId event_id, const void* payload, size_t size);
+
+        PluginPtr<IEventBus> bus_;
+        std::unique_ptr<Impl> impl_;
+    };
+
+}  // namespace z3y
+
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+#endif  // Z3Y_FRAMEWORK_IPC_EVENT_BRIDGE_H_
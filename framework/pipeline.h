@@ -0,0 +1,310 @@
+﻿/*
+* Copyright [2025] [Yue Liu]
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/**
+ * @file pipeline.h
+ * @brief [高级] 数据流管线 `z3y::Pipeline`：由组件充当的处理阶段，阶段之间以有界通道相连。
+ * @author Yue Liu
+ * @date 2025
+ *
+ * @details
+ * [受众：插件开发者 / 宿主开发者 (批量处理、视觉检测等多级流水线)]
+ *
+ * 以前的多级处理靠事件链拼起来：上一级 Fire，下一级以 kQueued 订阅。事件队列不设上限，
+ * 下游一慢，积压就无声地增长，直到内存耗尽。`Pipeline` 把各级显式地连成一条管线：
+ * - 每个阶段是一个实现 `IPipelineStage` 的组件，`Process` 处理一个条目，经 `PipelineEmitter`
+ *   向下一级发出零个、一个或多个条目 (过滤 / 变换 / 拆分)；最后一级发出的条目交给 `sink`。
+ * - 每个阶段前面有一个容量为 `capacity` 的通道。下一级的通道满了，本级就停止取新条目
+ *   (背压)；第一级满了，`Push` 阻塞 (或 `TryPush` 返回 false)，压力最终传回生产者。
+ * - 每个阶段最多 `parallelism` 个任务同时在 `IExecutorService` 上执行，不另起线程。
+ *   按 ClassId 创建的阶段每个并行任务一个实例，`Process` 不需要自己加锁。
+ * - `GetStats` 给出每个阶段的通道深度、吞吐与忙碌时间，用来找出瓶颈阶段。
+ *
+ * \code{.cpp}
+ * z3y::PipelineOptions options;
+ * options.name = "Inspection";
+ * options.stages = {
+ *     { "Decode", clsid::kJpegDecoder, 4, 16 },   // 名字、ClassId、并行度、通道容量
+ *     { "Detect", clsid::kDefectDetector, 2, 8 },
+ *     { "Report", clsid::kResultWriter, 1, 32 },
+ * };
+ * options.sink = [](z3y::PipelineItem item) { Archive(*item.As<Verdict>()); };
+ * std::string err;
+ * auto pipeline = z3y::Pipeline::Create(std::move(options), executor, err);
+ * for (auto& frame : camera) pipeline->Push(z3y::PipelineItem::Make<Frame>(std::move(frame)));
+ * pipeline->Wait();  // 等全部条目流出最后一级
+ * \endcode
+ *
+ * [Profiler]
+ * 安装了管线追踪钩子 (`SetPipelineTraceHook`，Profiler 插件的 `System.Profiler.PipelineHook`) 时，
+ * 每个 `Push` 的条目是一帧：进入管线 (`kItemBegin`)、每一级处理的前后 (`kStageStart` / `kStageEnd`)，
+ * 以及它和它派生出的全部条目都离开管线 (`kItemEnd`) 各上报一次，可以直接映射到 Profiler 的
+ * 异步帧 (ASYNC_BEGIN / ATTACH / COMMIT)。没有钩子时只多一次原子读。
+ *
+ * [注意]
+ * - 条目负载是 `shared_ptr<void>`，类型由相邻两级约定，`As<T>()` 不做检查。
+ * - 只有通道是严格有界的：一次 `Process` 发出的多个条目在下一级满时暂存在本级 (此时本级不再取新条目)，
+ *   所以最坏情况下每级额外多出 “并行度 × 单个条目的最大扇出” 个条目。
+ * - `Process` 抛出的异常被捕获，该条目计入 `failed` 并丢弃，管线继续运行。
+ * - 阶段任务持有管线的内部状态，不会访问已销毁的 `Pipeline`；但 `Pipeline` 必须在
+ *   `PluginManager` (执行器与阶段组件所在的库) 销毁之前销毁。
+ */
+
+#pragma once
+
+#ifndef Z3Y_FRAMEWORK_PIPELINE_H_
+#define Z3Y_FRAMEWORK_PIPELINE_H_
+
+#include <chrono>      // 用于 std::chrono::nanoseconds
+#include <cstddef>     // 用于 size_t
+#include <cstdint>     // 用于 uint64_t
+#include <exception>   // 用于 std::exception_ptr
+#include <functional>  // 用于 std::function
+#include <memory>      // 用于 std::shared_ptr, std::unique_ptr
+#include <string>      // 用于 std::string
+#include <utility>     // 用于 std::forward
+#include <vector>      // 用于 std::vector
+#include "framework/class_id.h"             // 依赖 ClassId
+#include "framework/i_component.h"          // 依赖 IComponent
+#include "framework/i_executor_service.h"   // 依赖 IExecutorService, TaskPriority
+#include "framework/interface_helpers.h"    // 依赖 Z3Y_DEFINE_INTERFACE
+#include "framework/z3y_framework_api.h"    // Z3Y_FRAMEWORK_API 导出
+
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable : 4251)
+#endif
+
+namespace z3y {
+
+    /**
+     * @struct PipelineItem
+     * @brief 在管线中流动的一个条目。
+     */
+    struct PipelineItem {
+        //! 负载。类型由相邻两级约定
+        std::shared_ptr<void> data;
+        //! `Push` 时由管线按进入顺序编号 (从 1 开始)；`Emit` 的条目为 0 时继承正在处理的条目的编号
+        uint64_t sequence = 0;
+
+        /** @brief 以 `T` 构造一个负载。 */
+        template <typename T, typename... Args>
+        [[nodiscard]] static PipelineItem Make(Args&&... args) {
+            PipelineItem item;
+            item.data = std::make_shared<T>(std::forward<Args>(args)...);
+            return item;
+        }
+
+        /** @brief 按 `T` 访问负载 (不检查类型)；没有负载时返回 nullptr。 */
+        template <typename T>
+        [[nodiscard]] T* As() const { return static_cast<T*>(data.get()); }
+    };
+
+    /**
+     * @class PipelineEmitter
+     * @brief `Process` 向下一级发出条目的出口。只在 `Process` 调用期间有效。
+     */
+    class PipelineEmitter {
+    public:
+        virtual void Emit(PipelineItem item) = 0;
+
+    protected:
+        ~PipelineEmitter() = default;
+    };
+
+    /**
+     * @class IPipelineStage
+     * @brief 管线的一个处理阶段。
+     */
+    class IPipelineStage : public virtual IComponent {
+    public:
+        Z3Y_DEFINE_INTERFACE(IPipelineStage, "z3y-core-IPipelineStage-IID-A0000009", 1, 0)
+
+        /**
+         * @brief 处理一个条目，经 `out` 发出零个或多个条目。
+         * @details 在执行器的工作线程上调用。同一实例同一时刻只被一个任务调用，
+         * 除非它以 `PipelineStageSpec::instance` 共享给了并行度大于 1 的阶段。
+         */
+        virtual void Process(PipelineItem& item, PipelineEmitter& out) = 0;
+    };
+
+    /**
+     * @struct PipelineStageSpec
+     * @brief 一个阶段的配置。`instance` 与 `clsid` 二选一，`instance` 优先。
+     */
+    struct PipelineStageSpec {
+        //! 阶段名 (统计与 Profiler 节点名)
+        std::string name;
+        //! 按 ClassId 为每个并行任务各创建一个实例 (`CreateInstance`)
+        ClassId clsid = 0;
+        //! 最多同时执行的任务数
+        size_t parallelism = 1;
+        //! 本阶段输入通道的容量
+        size_t capacity = 64;
+        //! 所有并行任务共享的现成实例；并行度大于 1 时 `Process` 必须线程安全
+        PluginPtr<IPipelineStage> instance;
+    };
+
+    /**
+     * @struct PipelineOptions
+     * @brief `Pipeline::Create` 的参数。
+     */
+    struct PipelineOptions {
+        //! 管线名 (Profiler 的帧名)
+        std::string name = "Pipeline";
+        //! 各阶段，按处理顺序排列 (至少一个)
+        std::vector<PipelineStageSpec> stages;
+        //! 最后一级发出的条目。在执行器的工作线程上调用，可并发；为空时丢弃。抛出的异常以空阶段名交给 error_handler
+        std::function<void(PipelineItem item)> sink;
+        //! `Process` 抛出异常时的通知 (阶段名与异常)；为空时只计数
+        std::function<void(const std::string& stage, std::exception_ptr error)> error_handler;
+        //! 阶段任务的优先级
+        TaskPriority priority = TaskPriority::kNormal;
+    };
+
+    /**
+     * @struct PipelineStageStats
+     * @brief 一个阶段的运行统计 (见 `Pipeline::GetStats`)。各字段分别读取，彼此不保证严格一致。
+     */
+    struct PipelineStageStats {
+        std::string name;
+        size_t parallelism = 0;
+        size_t capacity = 0;
+        size_t queue_depth = 0;          //!< 输入通道中的条目数
+        size_t max_queue_depth = 0;      //!< 输入通道的最大深度
+        size_t stalled_items = 0;        //!< 因下一级已满而暂存在本级的条目数
+        size_t active_workers = 0;       //!< 已投递或正在执行的任务数
+        uint64_t processed = 0;          //!< 处理完毕的条目数 (含抛出异常的)
+        uint64_t emitted = 0;            //!< 发出的条目数
+        uint64_t failed = 0;             //!< `Process` 抛出异常的次数
+        uint64_t backpressure_stalls = 0;  //!< 发出时下一级已满的次数
+        uint64_t busy_ns = 0;            //!< `Process` 的累计耗时
+        uint64_t queue_wait_ns = 0;      //!< 条目在输入通道中的累计等待
+    };
+
+    /**
+     * @struct PipelineStats
+     * @brief 整条管线的运行统计。
+     */
+    struct PipelineStats {
+        uint64_t pushed = 0;     //!< 被接受的 `Push` 数
+        uint64_t delivered = 0;  //!< 交给 `sink` 的条目数
+        uint64_t dropped = 0;    //!< 因异常或执行器已停止而丢弃的条目数
+        uint64_t in_flight = 0;  //!< 仍在管线中的条目数
+        uint64_t elapsed_ns = 0; //!< 自创建以来的时长
+        std::vector<PipelineStageStats> stages;
+
+        /** @brief 某一级的吞吐 (条目/秒)。 */
+        [[nodiscard]] double ItemsPerSecond(size_t stage) const {
+            return elapsed_ns == 0 || stage >= stages.size() ? 0.0 :
+                double(stages[stage].processed) * 1e9 / double(elapsed_ns);
+        }
+    };
+
+    /**
+     * @class Pipeline
+     * @brief 由有界通道连接的多级处理管线。所有函数都是线程安全的。
+     */
+    class Z3Y_FRAMEWORK_API Pipeline {
+    public:
+        /**
+         * @brief 创建管线并为各阶段准备实例。
+         * @return 参数无效或阶段组件创建失败时返回 nullptr，原因写入 `out_error_message`。
+         */
+        [[nodiscard]] static std::unique_ptr<Pipeline> Create(PipelineOptions options,
+            PluginPtr<IExecutorService> executor, std::string& out_error_message);
+
+        /** @brief 等价于 `Close()` + `Wait()`。 */
+        ~Pipeline();
+        Pipeline(const Pipeline&) = delete;
+        Pipeline& operator=(const Pipeline&) = delete;
+
+        /**
+         * @brief 送入一个条目；第一级通道已满时阻塞到有空位。
+         * @return 管线已关闭时返回 false。
+         */
+        bool Push(PipelineItem item);
+
+        /** @brief 同 `Push`，最多等待 `timeout`。@return 超时或已关闭时返回 false。 */
+        bool PushFor(PipelineItem item, std::chrono::nanoseconds timeout);
+
+        /** @brief 不等待：第一级通道已满或已关闭时返回 false。 */
+        bool TryPush(PipelineItem item);
+
+        /** @brief 不再接受新条目 (已在管线中的条目照常处理)。唤醒阻塞中的 `Push`。 */
+        void Close();
+
+        /** @brief 阻塞到管线中没有条目 (不必先 `Close`)。不能在阶段任务或 `sink` 中调用。 */
+        void Wait();
+
+        /** @brief 同 `Wait`，最多等待 `timeout`。@return 管线已空时返回 true。 */
+        bool WaitFor(std::chrono::nanoseconds timeout);
+
+        [[nodiscard]] PipelineStats GetStats() const;
+
+    private:
+        struct Impl;
+        explicit Pipeline(std::shared_ptr<Impl> impl);
+
+        std::shared_ptr<Impl> impl_;  // 阶段任务同样持有它
+    };
+
+    /**
+     * @enum PipelineTracePoint
+     * @brief 管线追踪钩子的上报点。
+     */
+    enum class PipelineTracePoint {
+        kItemBegin,   //!< 条目被 `Push` 接受 (生产者线程)
+        kStageStart,  //!< 某一级开始处理该帧的一个条目 (工作线程)
+        kStageEnd,    //!< 同一线程上，这一级处理完毕
+        kItemEnd,     //!< 该条目及其派生的全部条目都已离开管线 (任意线程)
+    };
+
+    /**
+     * @struct PipelineTraceSample
+     * @brief 一次管线追踪上报。字符串只在调用期间有效。
+     */
+    struct PipelineTraceSample {
+        PipelineTracePoint point = PipelineTracePoint::kItemBegin;
+        const char* pipeline = nullptr;  //!< 管线名
+        const char* stage = nullptr;     //!< 阶段名 (kItemBegin / kItemEnd 为 nullptr)
+        uint32_t stage_index = 0;
+        uint64_t frame_id = 0;           //!< 帧号：最高位为 1，进程内唯一
+        uint64_t wait_ns = 0;            //!< kStageStart / kStageEnd：条目在输入通道中的等待
+        uint64_t busy_ns = 0;            //!< kStageEnd：`Process` 的耗时
+        size_t queue_depth = 0;          //!< kStageStart：取走条目后输入通道的深度
+    };
+
+    /** @brief 管线追踪钩子。可在任意线程上并发调用。 */
+    using PipelineTraceHook = void (*)(const PipelineTraceSample& sample, void* context);
+
+    /**
+     * @brief 安装 (或以 nullptr 卸下) 全局管线追踪钩子。
+     * @details 返回前等待进行中的旧钩子调用全部结束。只有安装钩子之后 `Push` 的条目会被追踪；
+     * 卸下之前已开始的帧仍会上报 kItemEnd (交给新钩子，没有钩子时丢弃)。
+     */
+    Z3Y_FRAMEWORK_API void SetPipelineTraceHook(PipelineTraceHook hook, void* context);
+
+    /** @brief 当前是否安装了管线追踪钩子 (一次原子读)。 */
+    Z3Y_FRAMEWORK_API bool IsPipelineTraceHookInstalled() noexcept;
+
+}  // namespace z3y
+
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+#endif  // Z3Y_FRAMEWORK_PIPELINE_H_
@@ -56,6 +56,37 @@
 
 namespace z3y {
 
+    /**
+     * @brief [核心 API] 借用式转换：返回裸接口指针，不增加引用计数。
+     *
+     * [受众：框架维护者 和 热路径调用者]
+     * 适用于调用方 *已经* 持有 `component` 的强引用、只在当前作用域内使用结果的场景，
+     * 省去 `PluginPtr` 别名构造的一次原子递增/递减。
+     * 返回的指针与 `component` 同生命周期，**不要**保存它。
+     *
+     * @tparam T 目标接口类型。
+     * @param[in] component 来源组件 (可以为空)。
+     * @param[out] out_result 详细的转换结果。
+     * @return 成功返回 `T*`，失败返回 `nullptr`。
+     */
+    template <typename T>
+    T* PluginCastNoRef(IComponent* component, InstanceError& out_result) {
+        if (!component) {
+            // 传入的指针为空
+            out_result = InstanceError::kErrorInternal;
+            return nullptr;
+        }
+        // (T::kIid, T::kVersionMajor, T::kVersionMinor 由 Z3Y_DEFINE_INTERFACE 宏提供)
+        return static_cast<T*>(component->QueryInterfaceRaw(
+            T::kIid, T::kVersionMajor, T::kVersionMinor, out_result));
+    }
+
+    /** @brief `PluginCastNoRef` 的便捷重载：从智能指针借用 (不复制它)。 */
+    template <typename T, typename U>
+    T* PluginCastNoRef(const PluginPtr<U>& component_interface, InstanceError& out_result) {
+        return PluginCastNoRef<T>(static_cast<IComponent*>(component_interface.get()), out_result);
+    }
+
     // --- [受众：框架维护者] 内部实现 ---
     namespace internal {
         /**
@@ -67,23 +98,13 @@ namespace z3y {
          * @return 成功则返回 `PluginPtr<T>`，失败则返回 `nullptr`。
          */
         template <typename T>
-        PluginPtr<T> PluginCastImpl(PluginPtr<IComponent> component,
+        PluginPtr<T> PluginCastImpl(const PluginPtr<IComponent>& component,
             InstanceError& out_result) {
-            if (!component) {
-                // 传入的指针为空
-                out_result = InstanceError::kErrorInternal;
-                return nullptr;
-            }
-
-            // 1. [核心] 调用 IComponent 的虚函数。
-            // (T::kIid, T::kVersionMajor, T::kVersionMinor
-            // 由 Z3Y_DEFINE_INTERFACE 宏提供)
-            void* interface_ptr = component->QueryInterfaceRaw(
-                T::kIid, T::kVersionMajor, T::kVersionMinor,
-                out_result);
+            // 1. [核心] 调用 IComponent 的虚函数 (见 PluginCastNoRef)。
+            T* interface_ptr = PluginCastNoRef<T>(component.get(), out_result);
 
             if (!interface_ptr) {
-                // 2. 查询失败 (out_result 已被 QueryInterfaceRaw 填充)
+                // 2. 查询失败 (out_result 已被填充)
                 return nullptr;
             }
 
@@ -99,7 +120,7 @@ namespace z3y {
             // a. 返回的指针是正确的 `T*` 类型。
             // b. 原始的 `IComponent`
             // 实例的生命周期被正确管理，不会提前析构。
-            return PluginPtr<T>(component, static_cast<T*>(interface_ptr));
+            return PluginPtr<T>(component, interface_ptr);
         }
     }  // namespace internal
 
@@ -128,7 +149,7 @@ namespace z3y {
      * \endcode
      */
     template <typename T>
-    PluginPtr<T> PluginCast(PluginPtr<IComponent> component,
+    PluginPtr<T> PluginCast(const PluginPtr<IComponent>& component,
         InstanceError& out_result) {
         // [受众：框架维护者]
         // `if constexpr` 用于处理 `PluginCast<IComponent>`
@@ -157,15 +178,13 @@ namespace z3y {
      * @return 成功则返回 `PluginPtr<T>`，失败则返回 `nullptr`。
      */
     template <typename T, typename U>
-    PluginPtr<T> PluginCast(PluginPtr<U> component_interface,
+    PluginPtr<T> PluginCast(const PluginPtr<U>& component_interface,
         InstanceError& out_result) {
         // [受众：框架维护者]
-        // 1. 先安全地 `static_pointer_cast` 回 IComponent
-        PluginPtr<IComponent> base_component =
-            std::static_pointer_cast<IComponent>(component_interface);
-
-        // 2. 再调用 IComponent -> T 的标准转换
-        return PluginCast<T>(base_component, out_result);
+        // 借用查询，成功后只做一次别名构造 (共享 component_interface 的控制块)
+        T* interface_ptr = PluginCastNoRef<T>(component_interface, out_result);
+        if (!interface_ptr) return nullptr;
+        return PluginPtr<T>(component_interface, interface_ptr);
     }
 
 }  // namespace z3y
@@ -27,7 +27,7 @@
  * 这是插件实现者 *最核心* 的工具之一。
  * 它使用“奇异递归模板模式”(CRTP)，为你的实现类
  * *自动生成* `IComponent::QueryInterfaceRaw` 和
- * `GetInterfaceDetails` 这两个最复杂的函数。
+ * `GetInterfaceDescriptors` 这两个最复杂的函数。
  *
  * [使用方法]
  * 你的实现类 (例如 `DemoLoggerService`) 必须：
@@ -38,12 +38,15 @@
  * [受众：框架维护者]
  * 此类利用 C++17 的 `if constexpr` 和模板元编程，
  * 遍历 `Interfaces...` 参数包，
- * 自动为 `QueryInterfaceRaw` 生成 IID 和版本检查的 `if` 链，
- * 并为 `GetInterfaceDetails` 自动收集所有接口的元数据。
+ * 在编译期为 `QueryInterfaceRaw` 生成一张按 IID 排序的接口表 (二分查找)，
+ * 并为 `GetInterfaceDescriptors` 自动收集所有接口的元数据。
  *
  * `static_assert`
  * 检查（例如 `CheckHasClsid`）用于在编译期向插件开发者提供清晰的错误信息，
  * 提醒他们使用 `Z3Y_DEFINE_COMPONENT_ID` 等宏。
+ *
+ * `DirectPluginImpl` 是同一套机制的非虚继承版本，供 `final` 且不需要菱形继承的实现类使用
+ * (同模块内配合 `GetLocalService<Impl>()` 直接调用具体类型)。
  */
 
 #pragma once
@@ -51,6 +54,10 @@
 #ifndef Z3Y_FRAMEWORK_PLUGIN_IMPL_H_
 #define Z3Y_FRAMEWORK_PLUGIN_IMPL_H_
 
+#include <algorithm>      // 用于 std::lower_bound
+#include <array>          // 用于编译期接口表
+#include <cstddef>
+#include <cstdint>        // 用于 std::uintptr_t
 #include <memory>         // 用于 std::enable_shared_from_this
 #include <type_traits>    // 用于 SFINAE, std::is_base_of_v (C++17)
 #include <vector>         // 用于 std::vector
@@ -61,6 +68,242 @@
 
 namespace z3y {
 
+    namespace internal {
+
+#if defined(_WIN32)
+#define Z3Y_MODULE_LOCAL
+#else
+#define Z3Y_MODULE_LOCAL __attribute__((visibility("hidden")))
+#endif
+
+        /**
+         * @brief [内部] 模块锚点：每个模块 (可执行文件 / 插件库) 各有一份，地址互不相同。
+         * @details 非 const，避免链接器把它与其他常量合并。静态链接模式下全程序只有一份。
+         */
+        Z3Y_MODULE_LOCAL inline char g_module_anchor = 0;
+
+        /**
+         * @brief [内部] `GetLocalService<ImplClass>()` 使用的伪 IID。
+         * @details 由实现类的 CLSID 与 *当前模块* 的锚点地址混合而成：只有与调用方位于同一模块的实现
+         * 才会算出相同的值，从而把 `this` 作为 `ImplClass*` 交出；其他模块中的实例一律视为未实现。
+         */
+        template <typename ImplClass>
+        inline InterfaceId LocalImplKey() noexcept {
+            return ImplClass::kClsid ^ static_cast<InterfaceId>(reinterpret_cast<std::uintptr_t>(&g_module_anchor));
+        }
+
+        /**
+         * @class ComponentInterfaceTable
+         * @brief [内部] `PluginImpl` 与 `DirectPluginImpl` 共用的编译期检查、接口表与元数据收集。
+         */
+        template <typename ImplClass, typename... Interfaces>
+        class ComponentInterfaceTable {
+            // --- [受众：框架维护者] 编译期静态断言 (SFINAE 和 C++17 模板元编程) ---
+            // 以下代码在编译期运行，用于向插件开发者提供清晰的错误信息，
+            // 告诉他们忘记了哪个宏。
+
+            /**
+             * @brief [内部] C++17 SFINAE
+             * 检查：类型 T 是否定义了 `kClsid` 成员。
+             */
+            template <typename T, typename = std::void_t<>>
+            struct has_kClsid : std::false_type {};
+            template <typename T>
+            struct has_kClsid<T, std::void_t<decltype(T::kClsid)>> : std::true_type {};
+
+        public:
+            /**
+             * @brief [内部] 编译期检查 `ImplClass` 是否正确使用了 `Z3Y_DEFINE_COMPONENT_ID`。
+             */
+            template <typename T = ImplClass>
+            static constexpr bool CheckHasClsid() {
+                static_assert(has_kClsid<T>::value,
+                    "ImplClass must define 'static constexpr z3y::ClassId "
+                    "kClsid'. (Hint: Use Z3Y_DEFINE_COMPONENT_ID macro inside "
+                    "your class)");
+                if constexpr (has_kClsid<T>::value) {
+                    static_assert(
+                        std::is_same_v<decltype(T::kClsid), const ClassId>,
+                        "'kClsid' must be of type 'const z3y::ClassId'. (Hint: Use "
+                        "Z3Y_DEFINE_COMPONENT_ID macro)");
+                }
+                return true;
+            }
+
+            /**
+             * @brief [内部]
+             * 编译期递归检查 `Interfaces...` 包中的所有接口
+             * 是否正确使用了 `Z3Y_DEFINE_INTERFACE`。
+             */
+            template <typename First, typename... Rest>
+            static constexpr bool AllDeriveFromIComponent() {
+                // 1. 必须继承自 IComponent
+                static_assert(std::is_base_of_v<IComponent, First>,
+                    "Template parameter pack 'Interfaces...' must all derive "
+                    "from z3y::IComponent.");
+                // 2. 必须定义 kIid (Z3Y_DEFINE_INTERFACE)
+                static_assert(
+                    std::is_same_v<decltype(First::kIid), const InterfaceId>,
+                    "Interface 'First' must define 'static constexpr "
+                    "z3y::InterfaceId kIid'. (Hint: Use Z3Y_DEFINE_INTERFACE)");
+                // 3. 必须定义 kName (Z3Y_DEFINE_INTERFACE)
+                static_assert(
+                    std::is_same_v<decltype(First::kName), const char* const>,
+                    "Interface 'First' must define 'static constexpr const "
+                    "char* kName'. (Hint: Use Z3Y_DEFINE_INTERFACE)");
+                // 4. 必须定义 kVersionMajor (Z3Y_DEFINE_INTERFACE)
+                static_assert(
+                    std::is_same_v<decltype(First::kVersionMajor), const uint32_t>,
+                    "Interface 'First' must define 'static constexpr const "
+                    "uint32_t kVersionMajor'. (Hint: Use Z3Y_DEFINE_INTERFACE)");
+                // 5. 必须定义 kVersionMinor (Z3Y_DEFINE_INTERFACE)
+                static_assert(
+                    std::is_same_v<decltype(First::kVersionMinor), const uint32_t>,
+                    "Interface 'First' must define 'static constexpr const "
+                    "uint32_t kVersionMinor'. (Hint: Use Z3Y_DEFINE_INTERFACE)");
+
+                // 递归检查包的剩余部分
+                if constexpr (sizeof...(Rest) > 0) {
+                    return AllDeriveFromIComponent<Rest...>();
+                }
+                return true;
+            }
+
+            /** @brief [内部] 编译期检查：`Interfaces...` 中没有任何一个接口是另一个的基类 (不需要菱形继承)。 */
+            template <typename I>
+            static constexpr bool IsBaseOfNoOther() {
+                return (0 + ... + static_cast<int>(std::is_base_of_v<I, Interfaces>)) == 1;
+            }
+            static constexpr bool NoInterfaceDerivesFromAnother() {
+                return (true && ... && IsBaseOfNoOther<Interfaces>());
+            }
+
+            /** @brief [内部] 编译期触发对 ImplClass 和 Interfaces... 的静态断言检查。 */
+            static constexpr bool CheckAll() {
+                [[maybe_unused]] constexpr bool check_clsid = CheckHasClsid();
+                if constexpr (sizeof...(Interfaces) > 0) {
+                    [[maybe_unused]] constexpr bool check_iids =
+                        AllDeriveFromIComponent<Interfaces...>();
+                }
+                return true;
+            }
+
+        private:
+            /**
+             * @brief [内部] 接口表的一项：IID、实现的版本，以及把 `ImplClass*` 转换为该接口指针的函数。
+             *
+             * [受众：框架维护者]
+             * `PluginImpl` 的接口都是虚基类，`this` 到接口的偏移取决于最终派生类型，无法在编译期写成常量，
+             * 因此每项保存一个 (内联展开的) 转换函数，而不是偏移量。
+             */
+            struct InterfaceEntry {
+                InterfaceId iid;
+                uint32_t major;
+                uint32_t minor;
+                void* (*cast)(ImplClass* self);
+            };
+
+            template <typename I>
+            static void* CastTo(ImplClass* self) {
+                return static_cast<I*>(self);
+            }
+
+            static constexpr size_t kInterfaceCount = sizeof...(Interfaces) + 1;
+
+            /**
+             * @brief [内部] 编译期生成按 IID 升序排列的接口表 (IComponent 自身也在表中)。
+             * @details 插入排序：C++17 的 `std::sort` 不是 constexpr，而接口数量很小。
+             */
+            static constexpr std::array<InterfaceEntry, kInterfaceCount> BuildInterfaceTable() {
+                std::array<InterfaceEntry, kInterfaceCount> table = { {
+                    InterfaceEntry{ IComponent::kIid, IComponent::kVersionMajor, IComponent::kVersionMinor,
+                        &CastTo<IComponent> },
+                    InterfaceEntry{ Interfaces::kIid, Interfaces::kVersionMajor, Interfaces::kVersionMinor,
+                        &CastTo<Interfaces> }... } };
+                for (size_t i = 1; i < kInterfaceCount; ++i) {
+                    const InterfaceEntry entry = table[i];
+                    size_t j = i;
+                    for (; j > 0 && table[j - 1].iid > entry.iid; --j) table[j] = table[j - 1];
+                    table[j] = entry;
+                }
+                return table;
+            }
+
+            /** @brief [内部] 编译期检查：同一个 IID 不能在 `Interfaces...` 中出现两次。 */
+            static constexpr bool HasUniqueIids(const std::array<InterfaceEntry, kInterfaceCount>& table) {
+                for (size_t i = 1; i < kInterfaceCount; ++i) {
+                    if (table[i - 1].iid == table[i].iid) return false;
+                }
+                return true;
+            }
+
+            /** @brief [内部] 一个接口的编译期描述符。 */
+            template <typename I>
+            static constexpr InterfaceDescriptor DescriptorOf() {
+                return InterfaceDescriptor{ I::kIid, I::kName,
+                    InterfaceVersion{ I::kVersionMajor, I::kVersionMinor } };
+            }
+
+        public:
+            /**
+             * @brief `QueryInterfaceRaw` 的实现：在编译期生成的有序接口表
+             * (`IComponent` 自身 + `Interfaces...`) 中二分查找 IID，再检查版本。
+             * @details 表中没有的 IID 再与 `LocalImplKey<ImplClass>()` 比较 (见 `GetLocalService`)。
+             * 调用时 ImplClass 已是完整类型。
+             */
+            static void* Query(ImplClass* self, InterfaceId iid, uint32_t major, uint32_t minor,
+                InstanceError& out_result) {
+                [[maybe_unused]] constexpr bool checked = CheckAll();
+
+                // 接口表在编译期生成 (在函数体内定义，此时 ImplClass 已是完整类型)
+                static constexpr std::array<InterfaceEntry, kInterfaceCount> kTable = BuildInterfaceTable();
+                static_assert(HasUniqueIids(kTable), "Interfaces... must not list the same interface twice.");
+
+                // 1. 按 IID 二分查找
+                const auto it = std::lower_bound(kTable.begin(), kTable.end(), iid,
+                    [](const InterfaceEntry& entry, InterfaceId key) { return entry.iid < key; });
+                if (it == kTable.end() || it->iid != iid) {
+                    // 同模块的具体类型查询 (GetLocalService)
+                    if (iid == LocalImplKey<ImplClass>()) {
+                        out_result = InstanceError::kSuccess;
+                        return self;
+                    }
+                    // [失败] 未找到
+                    out_result = InstanceError::kErrorInterfaceNotImpl;
+                    return nullptr;
+                }
+
+                // 2. [版本检查] 主版本必须一致
+                if (it->major != major) {
+                    out_result = InstanceError::kErrorVersionMajorMismatch;
+                    return nullptr;
+                }
+
+                // 3. [版本检查] 插件实现的次版本必须 >= 宿主期望的版本
+                if (it->minor < minor) {
+                    out_result = InstanceError::kErrorVersionMinorTooLow;
+                    return nullptr;
+                }
+
+                // 4. [成功] IID 和版本均兼容
+                out_result = InstanceError::kSuccess;
+                return it->cast(self);
+            }
+
+            /**
+             * @brief `GetInterfaceDescriptors` 的实现：每个 ImplClass 一份 `static constexpr` 数组
+             * (IComponent 自身在前，其后按 `Interfaces...` 的声明顺序)，运行时不构造任何容器。
+             */
+            static InterfaceDescriptorSpan Descriptors() {
+                [[maybe_unused]] constexpr bool checked = CheckAll();
+                static constexpr std::array<InterfaceDescriptor, kInterfaceCount> kDescriptors = { {
+                    DescriptorOf<IComponent>(), DescriptorOf<Interfaces>()... } };
+                return InterfaceDescriptorSpan{ kDescriptors.data(), kDescriptors.size() };
+            }
+        };
+
+    }  // namespace internal
+
     /**
      * @class PluginImpl
      * @brief [插件开发者核心] CRTP 模板基类，用于自动实现 IComponent。
@@ -95,203 +338,31 @@ namespace z3y {
      * *和* `IDemoLogger`。
      * 这样，`QueryInterfaceRaw` 才能被自动地正确生成，
      * 以响应对 *两个* 接口的查询。
+     *
+     * 不需要这种菱形继承的组件可以改用 `DirectPluginImpl` (接口为非虚基类)。
      */
     template <typename ImplClass, typename... Interfaces>
     class PluginImpl : public virtual IComponent,
         public std::enable_shared_from_this<ImplClass>,
         public virtual Interfaces... {
+        using Table = internal::ComponentInterfaceTable<ImplClass, Interfaces...>;
+
     public:
         // [受众：框架维护者]
         // kClsid 由 ImplClass 通过 Z3Y_DEFINE_COMPONENT_ID 提供
         // static constexpr ClassId kClsid = ImplClass::kClsid;
 
-    private:
-        // --- [受众：框架维护者] 编译期静态断言 (SFINAE 和 C++17 模板元编程) ---
-        // 以下代码在编译期运行，用于向插件开发者提供清晰的错误信息，
-        // 告诉他们忘记了哪个宏。
-
-        /**
-         * @brief [内部] C++17 SFINAE
-         * 检查：类型 T 是否定义了 `kClsid` 成员。
-         */
-        template <typename T, typename = std::void_t<>>
-        struct has_kClsid : std::false_type {};
-        template <typename T>
-        struct has_kClsid<T, std::void_t<decltype(T::kClsid)>> : std::true_type {};
-
-        /**
-         * @brief [内部] 编译期检查 `ImplClass` 是否正确使用了 `Z3Y_DEFINE_COMPONENT_ID`。
-         */
-        template <typename T = ImplClass>
-        static constexpr bool CheckHasClsid() {
-            static_assert(has_kClsid<T>::value,
-                "ImplClass must define 'static constexpr z3y::ClassId "
-                "kClsid'. (Hint: Use Z3Y_DEFINE_COMPONENT_ID macro inside "
-                "your class)");
-            if constexpr (has_kClsid<T>::value) {
-                static_assert(
-                    std::is_same_v<decltype(T::kClsid), const ClassId>,
-                    "'kClsid' must be of type 'const z3y::ClassId'. (Hint: Use "
-                    "Z3Y_DEFINE_COMPONENT_ID macro)");
-            }
-            return true;
-        }
-
-        /**
-         * @brief [内部]
-         * 编译期递归检查 `Interfaces...` 包中的所有接口
-         * 是否正确使用了 `Z3Y_DEFINE_INTERFACE`。
-         */
-        template <typename First, typename... Rest>
-        static constexpr bool AllDeriveFromIComponent() {
-            // 1. 必须继承自 IComponent
-            static_assert(std::is_base_of_v<IComponent, First>,
-                "Template parameter pack 'Interfaces...' must all derive "
-                "from z3y::IComponent.");
-            // 2. 必须定义 kIid (Z3Y_DEFINE_INTERFACE)
-            static_assert(
-                std::is_same_v<decltype(First::kIid), const InterfaceId>,
-                "Interface 'First' must define 'static constexpr "
-                "z3y::InterfaceId kIid'. (Hint: Use Z3Y_DEFINE_INTERFACE)");
-            // 3. 必须定义 kName (Z3Y_DEFINE_INTERFACE)
-            static_assert(
-                std::is_same_v<decltype(First::kName), const char* const>,
-                "Interface 'First' must define 'static constexpr const "
-                "char* kName'. (Hint: Use Z3Y_DEFINE_INTERFACE)");
-            // 4. 必须定义 kVersionMajor (Z3Y_DEFINE_INTERFACE)
-            static_assert(
-                std::is_same_v<decltype(First::kVersionMajor), const uint32_t>,
-                "Interface 'First' must define 'static constexpr const "
-                "uint32_t kVersionMajor'. (Hint: Use Z3Y_DEFINE_INTERFACE)");
-            // 5. 必须定义 kVersionMinor (Z3Y_DEFINE_INTERFACE)
-            static_assert(
-                std::is_same_v<decltype(First::kVersionMinor), const uint32_t>,
-                "Interface 'First' must define 'static constexpr const "
-                "uint32_t kVersionMinor'. (Hint: Use Z3Y_DEFINE_INTERFACE)");
-
-            // 递归检查包的剩余部分
-            if constexpr (sizeof...(Rest) > 0) {
-                return AllDeriveFromIComponent<Rest...>();
-            }
-            return true;
-        }
-
-        /**
-         * @brief [内部] `QueryInterfaceRaw` 的递归模板实现。
-         *
-         * [受众：框架维护者]
-         * 这是模板元编程的核心。编译器会为 `Interfaces...` 包中的每个接口
-         * 实例化一个 `if (iid == First::kIid)` 检查。
-         *
-         * @param[in] iid 正在查询的接口 ID。
-         * @param[in] host_major 宿主期望的主版本。
-         * @param[in] host_minor 宿主期望的次版本。
-         * @param[out] out_result 详细错误码。
-         * @return `void*` 指针或 `nullptr`。
-         */
-        template <typename First, typename... Rest>
-        void* QueryRecursive(InterfaceId iid, uint32_t host_major,
-            uint32_t host_minor, InstanceError& out_result) {
-            // 1. 检查 IID 是否匹配当前接口
-            if (iid == First::kIid) {
-                const uint32_t my_major = First::kVersionMajor;
-                const uint32_t my_minor = First::kVersionMinor;
-
-                // 2. [版本检查] 检查主版本
-                if (my_major != host_major) {
-                    out_result = InstanceError::kErrorVersionMajorMismatch;
-                    return nullptr;
-                }
-
-                // 3. [版本检查] 检查次版本
-                //    (插件实现的版本 my_minor 必须 >= 宿主期望的版本 host_minor)
-                if (my_minor < host_minor) {
-                    out_result = InstanceError::kErrorVersionMinorTooLow;
-                    return nullptr;
-                }
-
-                // 4. [成功] IID 和版本均兼容
-                out_result = InstanceError::kSuccess;
-                // 关键：将 `this` (类型为 `PluginImpl*`)
-                // 1. static_cast 到 `ImplClass*` (派生类)
-                // 2. 再 static_cast 到 `First*` (目标接口)
-                // 这是安全的，因为 C++ 保证 `ImplClass` 继承自 `First`
-                return static_cast<First*>(static_cast<ImplClass*>(this));
-            }
-
-            // 5. [递归] IID 不匹配，继续检查包中的下一个接口
-            if constexpr (sizeof...(Rest) > 0) {
-                return QueryRecursive<Rest...>(iid, host_major, host_minor, out_result);
-            }
-
-            // 6. [失败] 遍历完所有接口，未找到
-            out_result = InstanceError::kErrorInterfaceNotImpl;
-            return nullptr;
-        }
-
-        /**
-         * @brief [内部] `GetInterfaceDetails` 的递归模板实现。
-         */
-        template <typename First, typename... Rest>
-        static void CollectDetailsRecursive(
-            std::vector<InterfaceDetails>& details) {
-            // 收集当前接口的元数据
-            details.push_back(InterfaceDetails{
-                First::kIid,
-                First::kName,
-                InterfaceVersion{First::kVersionMajor, First::kVersionMinor} });
-
-            // 递归收集包的剩余部分
-            if constexpr (sizeof...(Rest) > 0) {
-                CollectDetailsRecursive<Rest...>(details);
-            }
-        }
-
-    public:
         /**
          * @brief [框架核心] 重写 IComponent::QueryInterfaceRaw。
          *
          * [受众：框架维护者]
-         * 此函数由框架自动实现，它按以下顺序检查 IID：
-         * 1. 是否是 `IComponent` 自身？
-         * 2. (递归) 是否是 `Interfaces...` 包中的任意一个？
+         * 此函数由框架自动实现：在编译期生成的有序接口表
+         * (`IComponent` 自身 + `Interfaces...`) 中二分查找 IID，再检查版本。
          */
         void* QueryInterfaceRaw(InterfaceId iid, uint32_t major, uint32_t minor,
             InstanceError& out_result) override {
-            // [编译期] 触发对 ImplClass 和 Interfaces... 的静态断言检查
-            [[maybe_unused]] constexpr bool check_clsid = CheckHasClsid();
-            if constexpr (sizeof...(Interfaces) > 0) {
-                [[maybe_unused]] constexpr bool check_iids =
-                    AllDeriveFromIComponent<Interfaces...>();
-            }
-
-            // 1. 检查 IID 是否是 IComponent 本身
-            if (iid == IComponent::kIid) {
-                const uint32_t my_major = IComponent::kVersionMajor;
-                const uint32_t my_minor = IComponent::kVersionMinor;
-
-                if (my_major != major) {
-                    out_result = InstanceError::kErrorVersionMajorMismatch;
-                    return nullptr;
-                }
-                if (my_minor < minor) {
-                    out_result = InstanceError::kErrorVersionMinorTooLow;
-                    return nullptr;
-                }
-
-                out_result = InstanceError::kSuccess;
-                // 转换到 IComponent 基类
-                return static_cast<IComponent*>(static_cast<ImplClass*>(this));
-            }
-
-            // 2. [递归] 检查 Interfaces... 包
-            if constexpr (sizeof...(Interfaces) > 0) {
-                return QueryRecursive<Interfaces...>(iid, major, minor, out_result);
-            }
-
-            // 3. [失败] 未找到
-            out_result = InstanceError::kErrorInterfaceNotImpl;
-            return nullptr;
+            // 先 static_cast 到 `ImplClass*` (派生类)，接口表再从它转换到目标接口
+            return Table::Query(static_cast<ImplClass*>(this), iid, major, minor, out_result);
         }
 
         /**
@@ -329,28 +400,65 @@ namespace z3y {
          * 此静态函数由 `RegisterComponent`
          * (在 `auto_registration.h` 中) 自动调用，
          * 用于向 PluginManager 报告此组件实现了哪些接口。
+         * 返回的是编译期生成的常量数组的视图，调用本身不分配内存。
          */
-        static std::vector<InterfaceDetails> GetInterfaceDetails() {
-            // [编译期] 再次触发静态断言
-            [[maybe_unused]] constexpr bool check_clsid = CheckHasClsid();
-            if constexpr (sizeof...(Interfaces) > 0) {
-                [[maybe_unused]] constexpr bool check_iids =
-                    AllDeriveFromIComponent<Interfaces...>();
-            }
+        static InterfaceDescriptorSpan GetInterfaceDescriptors() {
+            return Table::Descriptors();
+        }
+    };
 
-            std::vector<InterfaceDetails> details;
+    /**
+     * @class DirectPluginImpl
+     * @brief [插件开发者] `PluginImpl` 的非虚继承版本：接口是普通 (非虚) 基类。
+     *
+     * @details
+     * `PluginImpl` 以 `public virtual Interfaces...` 继承接口，每次经接口指针调用都要经过
+     * 调整 `this` 的虚基类 thunk。接口列表中没有继承关系 (不需要菱形继承) 时可以改用本类：
+     * 接口子对象的偏移在编译期确定，调用少一次间接跳转。
+     *
+     * 要求 (编译期检查)：
+     * - `ImplClass` 必须声明为 `final`。编译器据此把经 `ImplClass*` 的虚函数调用直接内联，
+     * 配合 `GetLocalService<ImplClass>()` 可以完全绕开虚调用。
+     * - `Interfaces...` 中任何一个接口都不能是另一个的基类 (那种情况请继续使用 `PluginImpl`)。
+     *
+     * 对外行为 (QueryInterface、接口元数据、注册方式) 与 `PluginImpl` 完全相同。
+     *
+     * @example
+     * \code{.cpp}
+     * class FastLogger final : public z3y::DirectPluginImpl<FastLogger, ILogger> {
+     * public:
+     * Z3Y_DEFINE_COMPONENT_ID(...)
+     * void Log(...) override;
+     * };
+     * \endcode
+     */
+    template <typename ImplClass, typename... Interfaces>
+    class DirectPluginImpl : public virtual IComponent,
+        public std::enable_shared_from_this<ImplClass>,
+        public Interfaces... {
+        using Table = internal::ComponentInterfaceTable<ImplClass, Interfaces...>;
+
+    public:
+        /** @brief [框架核心] 重写 IComponent::QueryInterfaceRaw (与 `PluginImpl` 相同)。 */
+        void* QueryInterfaceRaw(InterfaceId iid, uint32_t major, uint32_t minor,
+            InstanceError& out_result) override {
+            static_assert(std::is_final_v<ImplClass>,
+                "DirectPluginImpl: ImplClass must be declared 'final'.");
+            static_assert(Table::NoInterfaceDerivesFromAnother(),
+                "DirectPluginImpl: an interface in Interfaces... derives from another one. "
+                "(Hint: use z3y::PluginImpl for diamond inheritance)");
+            return Table::Query(static_cast<ImplClass*>(this), iid, major, minor, out_result);
+        }
 
-            // 1. 自动添加 IComponent 自身
-            details.push_back(InterfaceDetails{
-                IComponent::kIid,
-                IComponent::kName,
-                InterfaceVersion{IComponent::kVersionMajor, IComponent::kVersionMinor} });
+        /** @brief [框架核心] 重写 IComponent::Initialize() (默认为空)。 */
+        void Initialize() override {}
 
-            // 2. [递归] 自动收集 Interfaces... 包中的所有接口
-            if constexpr (sizeof...(Interfaces) > 0) {
-                CollectDetailsRecursive<Interfaces...>(details);
-            }
-            return details;
+        /** @brief [框架核心] 重写 IComponent::Shutdown() (默认为空)。 */
+        void Shutdown() override {}
+
+        /** @brief [框架核心] 获取此实现类所支持的所有接口的元数据 (见 `PluginImpl::GetInterfaceDescriptors`)。 */
+        static InterfaceDescriptorSpan GetInterfaceDescriptors() {
+            return Table::Descriptors();
         }
     };
 
@@ -26,7 +26,8 @@
  * `PluginManager` 负责管理整个系统的方方面面：加载插件、管理服务单例、分发事件、提供反射查询等。
  *
  * **设计模式：**
- * 1. **单例模式 (Singleton)**: 全局只有一个 PluginManager 实例。
+ * 1. **单例模式 (Singleton)**: 全局只有一个默认 PluginManager 实例。需要彼此隔离的多条业务线时，
+ * 可以另外创建独立实例 (`PluginManagerOptions::isolated`)，通过 `PluginManagerScope` 绑定到线程。
  * 2. **Pimpl 惯用法**: 使用 `std::unique_ptr<PluginManagerPimpl> pimpl_` 隐藏了所有复杂的成员变量。
  * 这样做的好处是：当框架内部数据结构改变时，不需要重新编译所有使用了这个头文件的插件（ABI 兼容性）。
  */
@@ -36,12 +37,18 @@
 #ifndef Z3Y_FRAMEWORK_PLUGIN_MANAGER_H_
 #define Z3Y_FRAMEWORK_PLUGIN_MANAGER_H_
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <filesystem>
 #include <functional>
 #include <memory>
 #include <mutex>
 #include <optional>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
  // 引入所有需要的辅助头文件
@@ -49,12 +56,20 @@
 #include "framework/connection.h"
 #include "framework/connection_type.h"
 #include "framework/framework_events.h"
+#include "framework/i_allocator_service.h"
+#include "framework/i_buffer_pool.h"
+#include "framework/i_checkpointable.h"
 #include "framework/i_event_bus.h"
+#include "framework/i_executor_service.h"
 #include "framework/i_plugin_query.h"
+#include "framework/i_timer_service.h"
 #include "framework/i_plugin_registry.h"
+#include "framework/interface_proxy.h"
 #include "framework/plugin_cast.h"
 #include "framework/plugin_exceptions.h"
 #include "framework/plugin_impl.h"
+#include "framework/static_plugin.h"
+#include "framework/thread_placement.h"
 #include "framework/z3y_framework_api.h"
 
 #ifdef _MSC_VER
@@ -66,6 +81,9 @@ namespace z3y {
 
     // 前向声明 Pimpl 结构体，具体定义在 .cpp 文件中
     struct PluginManagerPimpl;
+    struct PendingRegistration;
+    struct PluginLoadJob;
+    struct PluginFileInfo;
 
     /**
      * @enum EventTracePoint
@@ -77,24 +95,381 @@ namespace z3y {
         kQueuedEntry,        //!< 异步模式：任务被放入队列
         kQueuedExecuteStart, //!< 异步模式：工作线程取出了任务，准备执行
         kQueuedExecuteEnd,   //!< 异步模式：任务执行完毕
+        kQueuedDropped,      //!< 异步模式：队列已满，任务按溢出策略被丢弃 (在投递线程上触发)
+        kDirectCallEnd,      //!< 同步模式：回调函数返回 (含抛出异常)
     };
 
-    /** @brief 追踪钩子函数类型。允许用户注册一个函数来监听上述埋点。 */
+    /**
+     * @brief 追踪钩子函数类型。允许用户注册一个函数来监听上述埋点。
+     * @details 第三个参数是相关订阅者的地址 (kDirectCallStart / kDirectCallEnd / kQueuedEntry)，其余埋点为 nullptr。
+     */
     using EventTraceHook = std::function<void(EventTracePoint, EventId, void*, const char*)>;
 
+    /**
+     * @struct EventTraceRecord
+     * @brief 内置追踪记录器的一条记录 (见 `PluginManager::StartEventTraceRecording`)。
+     */
+    struct EventTraceRecord {
+        uint64_t timestamp_ns = 0;       //!< steady_clock 时间戳
+        EventId event_id = 0;
+        EventTracePoint point = EventTracePoint::kEventFired;
+        uint32_t thread_index = 0;       //!< 记录线程的序号 (按首次记录的先后编号)
+        std::uintptr_t subscriber = 0;   //!< 相关订阅者的地址，无则为 0
+        uint32_t queue_depth = 0;        //!< 埋点时目标派发线程的积压任务数
+    };
+
+    /**
+     * @struct LatencyHistogram
+     * @brief 耗时直方图 (纳秒)。第 i 个桶统计落在 [2^i, 2^(i+1)) 纳秒内的样本 (桶 0 含 0)。
+     */
+    struct LatencyHistogram {
+        static constexpr size_t kBuckets = 40;  //!< 最后一个桶兜底 (约 9 分钟以上)
+
+        uint64_t buckets[kBuckets] = {};
+        uint64_t count = 0;
+        uint64_t total_ns = 0;
+        uint64_t max_ns = 0;
+
+        /** @brief 样本所在的桶号。 */
+        static size_t BucketOf(uint64_t ns) {
+            size_t bucket = 0;
+            while (ns > 1 && bucket + 1 < kBuckets) { ns >>= 1; ++bucket; }
+            return bucket;
+        }
+
+        /**
+         * @brief 近似分位数 (返回所在桶的上界)。
+         * @param q 0.0 ~ 1.0，例如 0.99。
+         */
+        [[nodiscard]] uint64_t PercentileNs(double q) const {
+            if (count == 0) return 0;
+            const auto target = static_cast<uint64_t>(q * static_cast<double>(count - 1)) + 1;
+            uint64_t seen = 0;
+            for (size_t i = 0; i < kBuckets; ++i) {
+                seen += buckets[i];
+                if (seen >= target) return (i + 1 < 64) ? std::min<uint64_t>((uint64_t{ 1 } << (i + 1)) - 1, max_ns) : max_ns;
+            }
+            return max_ns;
+        }
+    };
+
+    /**
+     * @struct SubscriberDispatchMetrics
+     * @brief 单个订阅 (订阅者 + 事件) 的回调统计。
+     */
+    struct SubscriberDispatchMetrics {
+        std::uintptr_t subscriber = 0;  //!< 订阅者对象地址
+        EventId event_id = 0;
+        ConnectionType connection_type = ConnectionType::kDirect;
+        LatencyHistogram callback_time; //!< 回调执行耗时 (kDirect 仅在 `event_metrics_time_direct_calls` 开启时统计)
+        uint64_t exceptions = 0;        //!< 回调抛出的异常数
+        ClassId subscriber_clsid = 0;   //!< 订阅者的组件 CLSID (订阅者不是组件时为 0)
+        uint64_t average_ns = 0;        //!< 回调耗时的滑动平均 (kDirect 仅在计时开启时统计，见 `event_slow_handler_threshold`)
+        uint64_t max_ns = 0;            //!< 回调耗时的最大值
+        uint64_t slow_calls = 0;        //!< 超过慢回调阈值的次数
+        bool demoted = false;           //!< kDirect 订阅是否已被看门狗降级为异步投递
+    };
+
+    /**
+     * @struct SlowEventHandlerReport
+     * @brief 慢回调看门狗的报告 (见 `PluginManagerOptions::event_slow_handler_threshold`)。
+     */
+    struct SlowEventHandlerReport {
+        EventId event_id = 0;
+        std::uintptr_t subscriber = 0;  //!< 订阅者对象地址
+        ClassId subscriber_clsid = 0;   //!< 订阅者的组件 CLSID (订阅者不是组件时为 0)
+        std::string plugin_path;        //!< 注册该组件的插件路径 (未知或由宿主注册时为空)
+        ConnectionType connection_type = ConnectionType::kDirect; //!< 订阅时的连接类型
+        uint64_t duration_ns = 0;       //!< 本次回调耗时
+        uint64_t average_ns = 0;        //!< 该订阅回调耗时的滑动平均 (含本次)
+        uint64_t max_ns = 0;            //!< 该订阅回调耗时的最大值 (含本次)
+        uint64_t slow_calls = 0;        //!< 该订阅超过阈值的累计次数 (含本次)
+        bool demoted = false;           //!< 该 kDirect 订阅是否已被降级为异步投递 (可能正是本次触发的)
+    };
+
+    /**
+     * @struct EventDispatchMetrics
+     * @brief 事件派发的运行指标快照 (见 `PluginManager::GetEventDispatchMetrics`)。
+     * @details 各字段分别读取，彼此之间不保证严格一致。
+     */
+    struct EventDispatchMetrics {
+        size_t queue_depth = 0;       //!< 所有派发线程当前积压的任务总数
+        size_t queue_high_water = 0;  //!< 单个派发线程曾经达到的最大积压
+        std::vector<size_t> worker_queue_depth;  //!< 每个派发线程当前的积压
+        size_t dropped_tasks = 0;     //!< 同 `GetEventQueueDropCount()`
+        uint64_t exceptions = 0;      //!< 回调抛出并被框架捕获的异常总数 (含未知类型)
+        uint64_t unknown_exceptions = 0; //!< 其中非 std::exception 的数量
+        std::unordered_map<EventId, LatencyHistogram> queue_latency; //!< 每个 EventId 从入队到开始执行的延迟
+        std::vector<SubscriberDispatchMetrics> subscribers; //!< 当前仍在订阅表中的订阅
+    };
+
+    /**
+     * @struct ServiceWarmUpResult
+     * @brief 单个单例服务的预热结果 (见 `PluginManager::WarmUpServices`)。
+     */
+    struct ServiceWarmUpResult {
+        ClassId clsid = 0;
+        std::string alias;
+        InstanceError error = InstanceError::kSuccess; //!< 构造或 Initialize 失败时的错误码
+        uint64_t init_ns = 0;   //!< 工厂 + Initialize 的耗时 (包含期间被连带初始化的依赖)
+        std::vector<ClassId> dependencies; //!< Initialize 期间通过 GetService 获取的其他单例
+    };
+
+    /**
+     * @struct ServiceWarmUpReport
+     * @brief `PluginManager::WarmUpServices` 的汇总报告。
+     */
+    struct ServiceWarmUpReport {
+        std::vector<ServiceWarmUpResult> services;
+        size_t threads = 0;     //!< 实际使用的线程数
+        uint64_t total_ns = 0;  //!< 预热总耗时 (墙钟)
+    };
+
+    /**
+     * @struct RegistrySnapshot
+     * @brief 注册表的不可变快照 (见 `PluginManager::GetRegistrySnapshot`)。
+     *
+     * @details
+     * 快照一旦发布就不会再被修改，可以在任意线程上无锁遍历，持有多久都可以。
+     * 组件详情以 `shared_ptr<const ComponentDetails>` 共享：它在注册时创建一次，
+     * 之后每个版本的快照只复制指针，不复制字符串和接口列表。
+     */
+    struct RegistrySnapshot {
+        using ComponentPtr = std::shared_ptr<const ComponentDetails>;
+
+        uint64_t version = 0;  //!< 注册表版本；每次注册、回滚或清空后递增
+        std::vector<ComponentPtr> components;  //!< 所有组件 (顺序不确定)
+        std::unordered_map<ClassId, ComponentPtr> by_clsid;
+        std::unordered_map<InterfaceId, std::vector<ComponentPtr>> by_interface; //!< 接口 -> 实现者 (按注册顺序)
+        std::unordered_map<std::string, std::vector<ComponentPtr>> by_plugin;    //!< 插件路径 -> 组件 (按注册顺序)
+
+        /** @brief 按 CLSID 查找；不存在返回 nullptr。 */
+        [[nodiscard]] const ComponentDetails* Find(ClassId clsid) const {
+            auto it = by_clsid.find(clsid);
+            return it == by_clsid.end() ? nullptr : it->second.get();
+        }
+
+        /** @brief 实现了 `iid` 的组件；没有则返回空列表。 */
+        [[nodiscard]] const std::vector<ComponentPtr>& FindImplementing(InterfaceId iid) const {
+            static const std::vector<ComponentPtr> kEmpty;
+            auto it = by_interface.find(iid);
+            return it == by_interface.end() ? kEmpty : it->second;
+        }
+    };
+
+    /**
+     * @enum EventQueueOverflowPolicy
+     * @brief 异步派发队列达到 `event_queue_max_pending` 时的处理策略。
+     * @details 与 spdlog 异步日志的 `async_overflow_policy` 对应
+     * (block / overrun_oldest / discard_new)。
+     */
+    enum class EventQueueOverflowPolicy {
+        kBlock,       //!< 阻塞发布者，直到派发线程腾出空间 (派发线程自身的 Fire 不阻塞，避免自锁)
+        kDropOldest,  //!< 丢弃队列中最旧的可丢弃任务，为新任务腾出空间
+        kDropNewest,  //!< 丢弃新任务，发布者立即返回
+    };
+
+    /**
+     * @enum PluginSymbolBinding
+     * @brief 插件库的符号绑定策略：在启动延迟与首次调用延迟之间取舍。
+     * @details
+     * - POSIX：对应 `dlopen` 的 `RTLD_NOW` / `RTLD_LAZY` (均带 `RTLD_LOCAL`)。
+     * - Windows：导入表总是在 `LoadLibraryExW` 时绑定，运行期没有对应的开关；
+     * 延迟绑定需要在插件自己的链接选项中使用 `/DELAYLOAD:<dependency>.dll`，此设置在 Windows 上不起作用。
+     */
+    enum class PluginSymbolBinding {
+        kEager,  //!< 加载时解析全部未定义符号 (缺失的符号让加载立即失败)
+        kLazy,   //!< 函数符号在首次调用时才解析 (缺失的符号在调用时才暴露)
+    };
+
+    /**
+     * @struct PluginManagerOptions
+     * @brief [宿主专用] 框架启动参数。传给 `PluginManager::Create()`。
+     *
+     * @details
+     * 所有字段都有安全的默认值，默认构造即等价于旧版 `Create()` 的行为。
+     */
+    struct PluginManagerOptions {
+        /**
+         * @brief 异步 (kQueued) 事件派发工作线程数量。
+         * @details
+         * - 1 (默认): 单线程事件循环，所有 kQueued 回调严格串行。
+         * - N > 1: 启动 N 个派发线程。订阅按“订阅者身份”分片到固定线程，
+         * 因此 **同一订阅者** 收到的事件依然保持发布顺序，不同订阅者之间可以并行。
+         * - 0: 使用 `std::thread::hardware_concurrency()`。
+         */
+        size_t event_dispatch_threads = 1;
+
+        /**
+         * @brief 每个派发线程无锁环形队列的容量 (向上取整为 2 的幂)。
+         * @details 环满时任务会进入有序的溢出区，不会丢失，只是退化为加锁路径。
+         */
+        size_t event_queue_capacity = 16384;
+
+        /**
+         * @brief 每个派发线程最多积压的任务数 (环形区 + 溢出区)。
+         * @details 0 (默认) 表示不限制，与旧版行为一致。
+         * 超出时按 `event_queue_overflow_policy` 处理，每丢弃一个任务都会以
+         * `EventTracePoint::kQueuedDropped` 通知追踪钩子，累计值见 `GetEventQueueDropCount()`。
+         */
+        size_t event_queue_max_pending = 0;
+
+        /** @brief 队列积压达到上限时的策略。仅当 `event_queue_max_pending > 0` 时生效。 */
+        EventQueueOverflowPolicy event_queue_overflow_policy = EventQueueOverflowPolicy::kBlock;
+
+        /**
+         * @brief 高优先级事件。
+         * @details 这些事件的投递不受积压上限约束：既不会被丢弃，也不会阻塞发布者。
+         * 框架内部的 GC 任务始终按此方式处理。
+         */
+        std::unordered_set<EventId> event_queue_priority_events;
+
+        /**
+         * @brief 每轮 GC 批处理的时间预算。
+         * @details 惰性 GC 在派发线程上批量清理失效订阅，每轮持有订阅表写锁的时间
+         * 大致不超过该值 (至少处理一项)；剩余项留到下一轮。
+         */
+        std::chrono::microseconds gc_pass_budget{ 1000 };
+
+        /**
+         * @brief 是否为 kDirect 回调计时。
+         * @details 异步回调的计时始终开启；kDirect 回调计时会在每次投递上增加两次时钟读取，默认关闭。
+         */
+        bool event_metrics_time_direct_calls = false;
+
+        /**
+         * @brief 慢回调看门狗的阈值 (默认 100 ms)。
+         * @details 任何事件回调 (kDirect 与异步) 执行超过该值时，以订阅者的 EventId、CLSID 与插件路径
+         * 通知 `PluginManager::SetSlowEventHandlerCallback` 设置的回调 (未设置时写到 std::cerr)。
+         * 开启时每次 kDirect 投递多两次时钟读取 (与 `event_metrics_time_direct_calls` 共用)；设为 0 关闭看门狗。
+         */
+        std::chrono::nanoseconds event_slow_handler_threshold = std::chrono::milliseconds(100);
+
+        /**
+         * @brief kDirect 订阅累计超过阈值多少次后被降级为异步投递 (默认 0，不降级)。
+         * @details 降级后该订阅改由派发线程执行 (与 kQueued 相同，按订阅者分片)，发布线程不再被它阻塞；
+         * 降级不可撤销，直到重新订阅。没有派发线程或属于类型化通道的订阅只报告、不降级。
+         */
+        size_t event_slow_handler_demote_after = 0;
+
+        /** @brief 插件库的默认符号绑定策略。 */
+        PluginSymbolBinding plugin_symbol_binding = PluginSymbolBinding::kEager;
+
+        /**
+         * @brief 按插件覆盖符号绑定策略。
+         * @details 键为插件的文件名 (不含目录，例如 `"libplugin_vision_x64.so"`)。
+         */
+        std::unordered_map<std::string, PluginSymbolBinding> plugin_symbol_binding_overrides;
+
+        /**
+         * @brief 是否按插件统计组件与订阅占用的内存 (见 `IPluginQuery::GetPluginMemoryUsage`)。
+         * @details 启用后由框架工厂 (`MakeComponent`) 构造的组件改用记账分配器，默认关闭。
+         */
+        bool enable_memory_accounting = false;
+
+        /**
+         * @brief 是否按插件统计事件回调与 `Initialize()` / `Shutdown()` 消耗的线程 CPU 时间
+         * (见 `IPluginQuery::GetPluginCpuUsage`)。
+         * @details 每次回调多读两次线程 CPU 时钟，默认关闭。
+         * 与 `enable_memory_accounting` 共用插件账户：只启用本项时组件同样改用记账分配器，但不报告内存用量。
+         */
+        bool enable_cpu_accounting = false;
+
+        /**
+         * @brief 共享执行器 (`IExecutorService`) 的工作线程数。
+         * @details 0 (默认) 表示 `std::thread::hardware_concurrency()` (至少 2)。
+         * 线程在第一次投递任务时才创建。
+         */
+        size_t executor_threads = 0;
+
+        /**
+         * @brief 缓冲区池 (`IBufferPool`) 最多缓存多少字节的空闲缓冲区 (默认 256 MB)。
+         * @details 超出部分在释放时直接归还系统。设为 0 相当于关闭缓存。
+         */
+        size_t buffer_pool_max_cached_bytes = size_t(256) << 20;
+
+        /**
+         * @brief 缓冲区池对 ≥ 2 MB 的缓冲区尝试使用大页 (默认关闭)。
+         * @details Linux 为透明大页建议 (MADV_HUGEPAGE)；Windows 需要 SeLockMemoryPrivilege。申请失败时自动退回普通内存。
+         */
+        bool buffer_pool_huge_pages = false;
+
+        /**
+         * @brief 框架自身的热点容器改用分配服务 (`IAllocatorService`) 的分级内存池 (默认关闭)。
+         * @details 包括订阅列表快照 (每次订阅变化写时复制一份) 与异步派发任务的闭包 (每次 kQueued 投递一个)。
+         * 占用计入 `AllocatorStats::framework_bytes`。
+         */
+        bool framework_pool_allocations = false;
+
+        /**
+         * @brief 定时器服务 (`ITimerService`) 时间轮的刻度 (默认 1 ms，最小 1 us)。
+         * @details 定时器到期时间向上取整到刻度；刻度越粗，唤醒越少、精度越低。
+         */
+        std::chrono::nanoseconds timer_tick = std::chrono::milliseconds(1);
+
+        /**
+         * @brief 各类线程的放置策略 (角色名 -> 策略，见 framework/thread_placement.h)。
+         * @details 框架线程使用 `thread_role::k*` 中的角色名；插件线程通过 `PlaceCurrentThread` 查询自己的角色。
+         * 未列出的角色不做任何修改 (默认)。
+         */
+        std::unordered_map<std::string, ThreadPlacement> thread_placements;
+
+        /**
+         * @brief 卸载全部插件时并行执行单例 `Shutdown()` 的线程数。
+         * @details 无论取值如何，Shutdown 都按依赖图进行：单例在 Initialize 期间获取的其他单例
+         * 会等它 Shutdown 之后才 Shutdown；彼此独立的服务按库的逆序取出。
+         * - 1 (默认): 在调用线程上串行执行。
+         * - N > 1: 彼此独立的服务在 N 个临时线程上并行 Shutdown。
+         * - 0: 使用 `std::thread::hardware_concurrency()`。
+         */
+        size_t shutdown_threads = 1;
+
+        /**
+         * @brief 单个服务 `Shutdown()` 的超时 (默认 0，一直等待)。
+         * @details 超时后不再等待它：依赖它的顺序约束随即解除，超时以异常处理器上报，
+         * 执行它的线程被分离。此时插件库保持加载 (它的代码可能仍在执行)。
+         */
+        std::chrono::milliseconds shutdown_service_timeout{ 0 };
+
+        /**
+         * @brief 快速退出：卸载全部插件时仍调用 Shutdown 并清空注册表，但不 dlclose / FreeLibrary (默认关闭)。
+         * @details 用于进程即将退出的场景，省去插件库的静态析构与解除映射，由操作系统回收。
+         * 之后再次加载同一插件会复用仍在内存中的库。
+         */
+        bool shutdown_skip_library_unload = false;
+
+        /**
+         * @brief 创建独立实例 (默认关闭)。
+         * @details 独立实例不发布为全局默认实例，可与默认实例及其他独立实例在同一进程中并存，
+         * 各自拥有注册表、事件派发线程、共享执行器与定时器，互不争用框架锁。
+         * - 全局服务定位函数 (`z3y::GetDefaultService` 等) 经 `GetActiveInstance()` 找到当前线程
+         * 绑定的实例：独立实例自己的派发线程、执行器线程与目录监视线程在启动时绑定到它；
+         * 插件入口函数、单例构造与 `Initialize` 期间也临时绑定到它。
+         * - 其他线程访问独立实例的服务前用 `PluginManagerScope` 绑定。
+         * - 由 `PluginManager::Destroy(manager)` 销毁。
+         * @warning 持有进程级状态的插件 (例如安装全局钩子的 Profiler) 只应加载到一个实例中。
+         */
+        bool isolated = false;
+    };
+
     /**
      * @class PluginManager
      * @brief 框架总管。
      *
      * @details
-     * 这个类继承了三个接口：
+     * 这个类继承了七个接口：
      * 1. `IPluginRegistry`: 提供给插件的入口函数使用，用于注册组件。
      * 2. `IEventBus`: 提供事件订阅和发布功能。
      * 3. `IPluginQuery`: 提供查询当前系统状态的功能。
+     * 4. `IExecutorService`: 框架共享的线程池 (优先级任务、定时器、具名串行队列)。
+     * 5. `IBufferPool`: 框架共享的大块缓冲区池 (事件零拷贝携带图像等大负载)。
+     * 6. `ITimerService`: 框架共享的定时器 (分层时间轮，由共享执行器驱动)。
+     * 7. `IAllocatorService`: 框架共享的小对象分配服务 (线程帧内存、分级内存池)。
      */
     class Z3Y_FRAMEWORK_API PluginManager
         : public IPluginRegistry,
-        public PluginImpl<PluginManager, IEventBus, IPluginQuery> {
+        public PluginImpl<PluginManager, IEventBus, IPluginQuery, IExecutorService, IBufferPool,
+        ITimerService, IAllocatorService> {
     public:
         // 定义 PluginManager 自己的组件 ID
         Z3Y_DEFINE_COMPONENT_ID("z3y-core-plugin-manager-IMPL-UUID")
@@ -102,6 +477,7 @@ namespace z3y {
     private:
         /** @brief Pimpl 指针。所有私有数据成员都藏在这里面。 */
         std::unique_ptr<PluginManagerPimpl> pimpl_;
+        friend class PluginManagerScope;  // 进入作用域时读取实例的线程绑定编号
 
     public:
         using LibHandle = void*; // 动态库句柄 (Windows HMODULE / Linux void*)
@@ -110,21 +486,73 @@ namespace z3y {
         virtual ~PluginManager();
 
         /**
-         * @brief 获取当前的单例指针。
+         * @brief 获取当前线程使用的框架实例。
+         * @details 线程被 `PluginManagerScope` (或独立实例的内部线程) 绑定时返回绑定的实例，
+         * 否则返回全局默认实例。
          * @return 如果框架已销毁，可能返回 nullptr。
          */
         [[nodiscard]] static std::shared_ptr<PluginManager> GetActiveInstance();
 
         /**
-         * @brief [宿主专用] 启动框架。创建单例。
+         * @brief 服务注册表的全局代数 (generation)。
+         * @details 创建/销毁框架、注册组件、回滚注册、卸载插件时递增 (从不为 0)。
+         * `ServiceHandle` 用它与 `GetThreadBindingId()` 判断线程本地缓存是否过期：
+         * 两者都不变，缓存的服务就仍然有效。切换线程绑定不会递增代数。
+         */
+        [[nodiscard]] static const std::atomic<uint64_t>& GetServiceGeneration() noexcept;
+
+        /**
+         * @brief 当前线程绑定的实例编号 (未绑定、跟随默认实例时为 0)。
+         * @details `PluginManagerScope` 与独立实例的内部绑定只改变本线程的编号，
+         * 因此线程本地缓存应同时以服务代数和此编号为键。编号在进程内不复用。
+         * 返回的引用指向调用线程自己的变量：可以缓存在同一线程的 thread_local 中，不要跨线程读取。
+         */
+        [[nodiscard]] static const uint64_t& GetThreadBindingId() noexcept;
+
+        /**
+         * @brief [宿主专用] 启动框架。创建单例 (`options.isolated` 时创建独立实例)。
+         * @param options 启动参数 (派发线程数等)，默认值与旧版行为一致。
+         * @throws std::runtime_error 默认实例已存在时再创建默认实例。
          */
-        [[nodiscard]] static std::shared_ptr<PluginManager> Create();
+        [[nodiscard]] static std::shared_ptr<PluginManager> Create(
+            const PluginManagerOptions& options = PluginManagerOptions());
+
+        /** @brief 查询实际运行的异步派发线程数量。 */
+        [[nodiscard]] size_t GetEventDispatchThreadCount() const;
+
+        /** @brief 查询因队列溢出而被丢弃的异步任务累计数量。 */
+        [[nodiscard]] size_t GetEventQueueDropCount() const;
+
+        /**
+         * @brief 获取事件派发的运行指标：队列深度与水位、入队延迟直方图、订阅者耗时、异常计数。
+         * @details 指标常驻开启，写侧只有 relaxed 原子操作。本函数会短暂持有订阅表写锁。
+         */
+        [[nodiscard]] EventDispatchMetrics GetEventDispatchMetrics() const;
+
+        /** @brief 清零累计指标 (水位、直方图、异常计数)。当前队列深度不受影响。 */
+        void ResetEventDispatchMetrics();
+
+        /**
+         * @brief 查询某个线程角色的放置策略 (来自 `PluginManagerOptions::thread_placements`)。
+         * @return 未配置时返回 nullptr。指针在框架实例销毁前有效。
+         */
+        [[nodiscard]] const ThreadPlacement* FindThreadPlacement(std::string_view role) const;
 
         /**
          * @brief [宿主专用] 关闭框架。销毁单例。
          */
         static void Destroy();
 
+        /**
+         * @brief [宿主专用] 销毁指定实例 (默认实例等同于 `Destroy()`)，并清空调用方的引用。
+         * @details 独立实例先卸载全部插件 (服务 Shutdown、注册表清空)，其余线程释放各自的引用后
+         * 随即析构 (停止派发线程与执行器)。
+         */
+        static void Destroy(std::shared_ptr<PluginManager>& manager);
+
+        /** @brief 是否为独立实例 (`PluginManagerOptions::isolated`)。 */
+        [[nodiscard]] bool IsIsolated() const noexcept;
+
         // 禁用拷贝和移动
         PluginManager(const PluginManager&) = delete;
         PluginManager& operator=(const PluginManager&) = delete;
@@ -136,12 +564,64 @@ namespace z3y {
          * @param dir 目录路径。
          * @param recursive 是否递归子目录。
          * @param init_func_name 插件入口函数名 (默认 "z3yPluginInit")。
+         * @param threads 并行加载的线程数。1 (默认) 为串行；0 表示使用 `std::thread::hardware_concurrency()`。
          * @return 失败的插件列表 (文件名: 错误信息)。
+         *
+         * @details
+         * 文件按路径排序后处理，结果与线程数无关：
+         * 1. **准备** (可并行)：加载库、解析入口函数，并执行入口函数。入口函数中的注册只记录到本次加载的上下文中。
+         * 2. **提交** (按路径顺序串行)：每个插件的全部注册在一次写锁内校验并发布。
+         * 任何冲突都会使该插件整体不可见并被卸载，其他线程不会看到“注册了一半”的插件。
+         *
+         * @note 入口函数执行期间，本插件注册的组件尚未发布，不能在其中 `GetService` 自身的组件。
          */
         [[nodiscard]] std::vector<std::string> LoadPluginsFromDirectory(
             const std::filesystem::path& dir, bool recursive = true,
+            const std::string& init_func_name = "z3yPluginInit", size_t threads = 1);
+
+        /**
+         * @brief 启用插件清单缓存 (传入空路径关闭)。
+         *
+         * @details
+         * 启用后，`LoadPluginsFromDirectory` 会把每个插件注册的组件 (ClassId、别名、接口) 写入 `cache_file`，
+         * 以文件路径 + 大小 + 修改时间为键。下次启动时，未变化的插件不再加载，只注册 *延迟条目*：
+         * 内省查询立即可用，库在第一次 `GetService` / `CreateInstance` 命中其组件时才真正加载。
+         *
+         * @note 延迟插件的入口函数在首次使用时执行；若届时加载失败或不再注册该组件，
+         * 请求会以 `kErrorFactoryFailed` 失败。
+         */
+        void SetPluginManifestCache(const std::filesystem::path& cache_file);
+
+        /**
+         * @brief 启用单例热状态检查点 (传入空路径关闭)。
+         *
+         * @details
+         * 启用后，实现了 `ICheckpointable` 的单例在 `Shutdown()` 之前 (`UnloadPlugin` / `UnloadAllPlugins` /
+         * 销毁管理器时) 把状态保存到 `dir`；下次首次构造时在 `Initialize()` 之前从检查点恢复。
+         * 状态版本、接口版本或插件文件变化后的检查点会被丢弃 (详见 framework/i_checkpointable.h)。
+         * 保存与恢复中的异常和写文件失败都交给异常处理器，不影响服务本身的生命周期。
+         */
+        void SetCheckpointDirectory(const std::filesystem::path& dir);
+
+        /**
+         * @brief 开始监视插件目录：新放入的插件由后台线程增量加载。
+         * @param dir 要监视的目录 (不递归子目录)。
+         * @return 已在监视、目录无法监视或平台不支持 (目前仅 Linux 与 Windows) 时返回 false。
+         *
+         * @details
+         * 只处理发生变化的文件，不会重新扫描整个目录；加载走 `LoadPlugin` 的同一路径，
+         * 注册表只在提交时短暂加写锁，不阻塞查找。结果通过 `event::PluginLoadSuccessEvent` /
+         * `event::PluginLoadFailureEvent` 报告 (在监视线程上触发)。已加载的文件被覆盖时不会自动重载，
+         * 请使用 `ReloadPlugin`。
+         *
+         * @note 建议先写到临时文件名再重命名进目录，避免加载到写了一半的文件。
+         */
+        [[nodiscard]] bool StartPluginDirectoryWatch(const std::filesystem::path& dir,
             const std::string& init_func_name = "z3yPluginInit");
 
+        /** @brief 停止目录监视并等待后台线程退出 (正在进行的加载会先完成)。未在监视时为空操作。 */
+        void StopPluginDirectoryWatch();
+
         /**
          * @brief 加载单个插件。
          * @param file_path 插件路径。
@@ -152,17 +632,151 @@ namespace z3y {
             const std::filesystem::path& file_path, std::string& out_error_message,
             const std::string& init_func_name = "z3yPluginInit");
 
+        /**
+         * @brief 加载一个静态链接进宿主的插件 (不经过 dlopen 与符号查找)。
+         * @param plugin 插件表项 (通常来自 `Z3Y_STATIC_PLUGIN(name)`)。
+         * @param out_error_message 输出错误信息。
+         * @return 成功 (或此前已加载) 返回 true。
+         *
+         * @details 与 `LoadPlugin` 相同：入口函数的注册先收集，再在一次写锁内校验并发布，
+         * 同样触发 `PluginLoadSuccessEvent` / `PluginLoadFailureEvent` 并记入启动报告。
+         * 组件的来源路径为 `"static:<name>"`。静态插件只随 `UnloadAllPlugins()` 清理。
+         * @see static_plugin.h
+         */
+        [[nodiscard]] bool LoadStaticPlugin(const StaticPluginEntry& plugin, std::string& out_error_message);
+
+        /**
+         * @brief 按表中顺序加载一组静态链接的插件。
+         * @return 失败的插件列表 (插件名: 错误信息)。
+         */
+        [[nodiscard]] std::vector<std::string> LoadStaticPlugins(const StaticPluginEntry* plugins, size_t count);
+
+        /** @brief `LoadStaticPlugins` 的数组版本 (配合 `constexpr` 插件表使用)。 */
+        template <size_t N>
+        [[nodiscard]] std::vector<std::string> LoadStaticPlugins(const StaticPluginEntry (&plugins)[N]) {
+            return LoadStaticPlugins(plugins, N);
+        }
+
         /**
          * @brief 卸载所有插件。安全清理资源的入口。
          */
         void UnloadAllPlugins();
 
-        /** @brief 设置调试用的事件追踪钩子。 */
+        /**
+         * @brief 单独卸载一个插件，其余插件、单例与订阅保持不变。
+         * @param file_path 插件路径 (与加载时使用的路径一致)。
+         * @param out_error_message 输出错误信息。
+         * @return 插件未加载，或在派发线程上调用时返回 false。
+         *
+         * @details
+         * 按以下顺序进行：
+         * 1. 让 ServiceHandle 缓存失效，并逆序 Shutdown 该插件已构造的单例。
+         * 2. 移除这些单例的全部订阅，等待正在进行的 Fire 离开订阅表，再排空各派发线程中已入队的任务。
+         * 3. 在一次写锁内移除该插件的组件、别名、默认实现与接口索引，然后卸载库。
+         * 完成后触发 `event::PluginUnloadEvent`。
+         *
+         * @warning 调用方必须先释放自己持有的、来自该插件的组件实例与订阅者对象：
+         * 库卸载后它们的代码已不存在。
+         */
+        [[nodiscard]] bool UnloadPlugin(const std::filesystem::path& file_path, std::string& out_error_message);
+
+        /**
+         * @brief 热重载：`UnloadPlugin` 之后重新 `LoadPlugin` (可以是磁盘上已更新的版本)。
+         * @return 卸载或加载任一步失败时返回 false。
+         */
+        [[nodiscard]] bool ReloadPlugin(const std::filesystem::path& file_path, std::string& out_error_message,
+            const std::string& init_func_name = "z3yPluginInit");
+
+        /**
+         * @brief 预热：并行地立即构造所有已注册、尚未初始化的单例服务。
+         * @param threads 使用的线程数；0 表示 `std::thread::hardware_concurrency()`。
+         * @return 每个服务的初始化耗时、错误码和发现的依赖。
+         *
+         * @details
+         * 单例默认在第一次 `GetService` 时才构造，首个请求线程会承担全部初始化开销
+         * (例如打开日志 sink、读取配置)。宿主可以在加载插件之后、进入业务循环之前调用本函数。
+         *
+         * 依赖顺序由单例自身的 `std::call_once` 保证：若 A 的 `Initialize` 调用了
+         * `GetService<B>()`，而 B 正在另一线程上初始化，A 会等待 B 完成。
+         * 只要依赖关系无环 (串行初始化本来就要求无环)，并行预热不会引入死锁。
+         * 已经初始化过的服务不会重复构造，报告中给出的是其首次初始化的耗时。
+         * 构造失败的服务按 `GetService` 的语义缓存失败结果，不会抛出。
+         */
+        ServiceWarmUpReport WarmUpServices(size_t threads = 0);
+
+        /**
+         * @brief 获取注册表的不可变快照。
+         * @details 注册表未变化时只是一次原子读 (返回同一个快照)。注册表变化后，
+         * 第一个调用者在注册表读锁下重建快照 (只复制指针)，之后的调用者直接复用。
+         * `GetAllComponents` / `FindComponentsImplementing` / `GetComponentsFromPlugin`
+         * 也基于它实现，不再在复制详情期间持有注册表锁。
+         */
+        [[nodiscard]] std::shared_ptr<const RegistrySnapshot> GetRegistrySnapshot() const;
+
+        /**
+         * @brief 设置调试用的事件追踪钩子。
+         * @details 未设置钩子且未开启记录器时，每个埋点只是一次原子读 + 一个分支。
+         * 钩子可以在任意线程上随时替换；替换前已经开始的调用仍会使用旧钩子完成。
+         */
         void SetEventTraceHook(EventTraceHook hook);
 
+        /**
+         * @brief 开启 / 关闭接口调用拦截 (代理描述见 framework/interface_proxy.h)。
+         * @param name 接口名 (`T::kName`，拦截所有组件的该接口) 或组件别名 (拦截该组件的所有接口)。
+         * @details 只影响之后的 `GetService` / `TryGetService` / `CreateInstance`，已经发出的指针不变。
+         */
+        void SetCallInterception(const std::string& name, bool enabled);
+
+        /** @brief 按 ClassId 开启 / 关闭拦截：该组件所有带代理描述的接口都返回代理。 */
+        void SetCallInterception(const ClassId& clsid, bool enabled);
+
+        /** @brief 是否有任何拦截规则生效。模板 API 在返回前读取一次 (relaxed)。 */
+        [[nodiscard]] static const std::atomic<bool>& IsCallInterceptionActive() noexcept;
+
+        /**
+         * @brief 当前派发线程上正在执行的异步任务从入队到开始执行等待了多少纳秒。
+         * @details 供追踪钩子在 `kQueuedExecuteStart` / `kQueuedExecuteEnd` 埋点内读取；
+         * 其他线程、其他时刻返回 0。
+         */
+        [[nodiscard]] static uint64_t GetCurrentEventTaskWaitNs() noexcept;
+
+        /**
+         * @brief 开启内置的二进制追踪记录器。
+         * @param per_thread_capacity 每个线程保留的最近记录数 (向上取整为 2 的幂)。
+         * @details 每个线程写自己的无锁环形缓冲区，开销远低于钩子。可以与 `SetEventTraceHook` 同时使用。
+         */
+        void StartEventTraceRecording(size_t per_thread_capacity = 65536);
+
+        /** @brief 停止记录。已有记录保留，直到下一次 `StartEventTraceRecording`。 */
+        void StopEventTraceRecording();
+
+        /** @brief 取出本轮记录，按时间排序。可以在记录期间调用。 */
+        [[nodiscard]] std::vector<EventTraceRecord> GetEventTraceRecords() const;
+
+        /**
+         * @brief 把本轮记录写成 Chrome Trace / Perfetto 可读的 JSON 文件。
+         * @return 文件无法打开时返回 false。
+         */
+        bool DumpEventTrace(const std::filesystem::path& path) const;
+
+        /**
+         * @brief 把启动耗时报告 (`IPluginQuery::GetStartupReport`) 写成 Chrome Trace / Perfetto 可读的 JSON 文件。
+         * @details 每个插件的各加载阶段、每个单例的首次构造各对应一个区间，按执行线程分行。
+         * @return 文件无法打开时返回 false。
+         */
+        bool DumpStartupTrace(const std::filesystem::path& path) const;
+
         /** @brief 设置“带外”(Out-of-Band) 异常处理器。处理异步回调中抛出的异常。 */
         void SetExceptionHandler(ExceptionCallback handler);
 
+        using SlowEventHandlerCallback = std::function<void(const SlowEventHandlerReport&)>;
+
+        /**
+         * @brief 设置慢回调看门狗的报告回调 (见 `PluginManagerOptions::event_slow_handler_threshold`)。
+         * @details 在执行慢回调的线程上、该回调返回之后同步调用；传入空函数恢复默认 (写到 std::cerr)。
+         */
+        void SetSlowEventHandlerCallback(SlowEventHandlerCallback callback);
+
         // --- IEventBus 接口的公共部分 ---
         // 允许外界查询某个事件是否有订阅者 (用于优化性能)
         [[nodiscard]] bool IsGlobalSubscribed(EventId event_id) const override;
@@ -177,8 +791,14 @@ namespace z3y {
         // 供 z3yPluginInit 调用
         void RegisterComponent(ClassId clsid, FactoryFunction factory,
             bool is_singleton, const std::string& alias,
-            std::vector<InterfaceDetails> implemented_interfaces,
+            InterfaceDescriptorSpan implemented_interfaces,
             bool is_default) override;
+        void RegisterPooledComponent(ClassId clsid, FactoryFunction factory,
+            const std::string& alias,
+            InterfaceDescriptorSpan implemented_interfaces,
+            bool is_default) override;
+        void RegisterComponents(std::vector<ComponentRegistration> registrations) override;
+        void RegisterEventHandler(ClassId clsid, const EventHandlerEntry& handler) override;
 
         // --- IEventBus 接口实现 ---
         void Unsubscribe(std::shared_ptr<void> subscriber) override;
@@ -189,19 +809,47 @@ namespace z3y {
         // 这些是 IEventBus 定义的底层操作，PluginManager 负责具体实现逻辑
         [[nodiscard]] Connection SubscribeGlobalImpl(
             EventId event_id, std::weak_ptr<void> sub,
-            std::function<void(const Event&)> cb,
-            ConnectionType connection_type) override;
+            EventDelegate cb,
+            ConnectionType connection_type, EventPriority priority,
+            std::shared_ptr<IEventExecutor> executor, EventFilter filter) override;
 
         void FireGlobalImpl(EventId event_id, PluginPtr<Event> e_ptr) override;
+        void FireGlobalRefImpl(EventId event_id, EventSlotIndex slot, const Event& e, EventPromoter promote) override;
+        void FireGlobalBatchImpl(EventId event_id, EventSlotIndex slot, const EventBatchView& batch) override;
+        [[nodiscard]] Connection SubscribeFamilyImpl(
+            const char* family, std::weak_ptr<void> sub,
+            EventDelegate cb,
+            ConnectionType connection_type, EventPriority priority) override;
+        [[nodiscard]] EventSlotIndex ResolveEventSlot(EventId event_id, const char* family) override;
+        [[nodiscard]] bool IsGlobalSlotSubscribed(EventSlotIndex slot) const override;
+        void ReleaseConnection(EventId event_id, const std::weak_ptr<void>& sender_key) override;
+        void ReleaseConnections(const std::vector<std::pair<EventId, std::weak_ptr<void>>>& released) override;
+        [[nodiscard]] internal::EventChannelCore* GetChannelImpl(EventId event_id) override;
+        [[nodiscard]] Connection SubscribeChannelImpl(internal::EventChannelCore* channel,
+            std::weak_ptr<void> sub, EventDelegate cb) override;
+        void FireChannelImpl(internal::EventChannelCore* channel, const Event& e, EventPromoter promote) override;
 
         [[nodiscard]] Connection SubscribeToSenderImpl(
             EventId event_id, std::weak_ptr<void> sub_id,
-            std::weak_ptr<void> sender_id, std::function<void(const Event&)> cb,
-            ConnectionType connection_type) override;
+            std::weak_ptr<void> sender_id, EventDelegate cb,
+            ConnectionType connection_type, EventPriority priority,
+            std::shared_ptr<IEventExecutor> executor, EventFilter filter) override;
 
         virtual void FireToSenderImpl(const std::weak_ptr<void>& sender_id,
             EventId event_id,
             PluginPtr<Event> e_ptr) override;
+        void FireToSenderRefImpl(const std::weak_ptr<void>& sender_id, EventId event_id,
+            const Event& e, EventPromoter promote) override;
+        void RetainEventImpl(EventId event_id, const std::weak_ptr<void>& sender_id, PluginPtr<Event> e_ptr) override;
+        [[nodiscard]] PluginPtr<Event> GetRetainedImpl(EventId event_id, const std::weak_ptr<void>& sender_id) const override;
+        void ClearRetainedImpl(EventId event_id, const std::weak_ptr<void>& sender_id) override;
+        [[nodiscard]] Connection RegisterRequestHandlerImpl(
+            EventId request_id, std::weak_ptr<void> handler,
+            detail::RequestInvoker invoker, const char* response_type,
+            ConnectionType type, std::shared_ptr<IEventExecutor> executor) override;
+        void SendRequestImpl(EventId request_id,
+            std::shared_ptr<detail::RequestStateBase> state,
+            std::chrono::nanoseconds timeout) override;
 
         // --- IPluginQuery 接口实现 ---
         [[nodiscard]] std::vector<ComponentDetails> GetAllComponents() const override;
@@ -210,13 +858,66 @@ namespace z3y {
         [[nodiscard]] std::vector<ComponentDetails> FindComponentsImplementing(InterfaceId iid) const override;
         [[nodiscard]] std::vector<std::string> GetLoadedPluginFiles() const override;
         [[nodiscard]] std::vector<ComponentDetails> GetComponentsFromPlugin(const std::string& plugin_path) const override;
+        [[nodiscard]] StartupReport GetStartupReport() const override;
+        [[nodiscard]] std::vector<PluginMemoryUsage> GetPluginMemoryUsage() const override;
+        [[nodiscard]] std::vector<PluginCpuUsage> GetPluginCpuUsage() const override;
+
+        // --- IExecutorService 接口实现 ---
+        bool Post(std::function<void()> task, TaskPriority priority = TaskPriority::kNormal) override;
+        TimerId PostDelayed(std::chrono::nanoseconds delay, std::function<void()> task,
+            TaskPriority priority = TaskPriority::kNormal) override;
+        bool CancelTimer(TimerId timer) override;
+        [[nodiscard]] std::shared_ptr<IEventExecutor> GetSerialQueue(const std::string& name) override;
+        [[nodiscard]] std::shared_ptr<IEventExecutor> MakeStrand() override;
+        [[nodiscard]] size_t GetWorkerCount() const override;
+        [[nodiscard]] ExecutorStats GetExecutorStats() const override;
+
+        // --- IBufferPool 接口实现 ---
+        [[nodiscard]] BufferRef AcquireBuffer(size_t size) override;
+        [[nodiscard]] BufferPoolStats GetBufferPoolStats() const override;
+        void TrimBufferPool() override;
+
+        // --- IAllocatorService 接口实现 ---
+        [[nodiscard]] std::pmr::memory_resource* GetThreadArena() override;
+        [[nodiscard]] ArenaMark MarkThreadArena() override;
+        void RewindThreadArena(const ArenaMark& mark = {}) override;
+        [[nodiscard]] std::pmr::memory_resource* GetPoolResource() override;
+        [[nodiscard]] AllocatorStats GetAllocatorStats() const override;
+
+        // --- ITimerService 接口实现 ---
+        TimerId StartOneShot(std::chrono::nanoseconds delay,
+            std::function<void()> callback, const TimerOptions& options = {}) override;
+        TimerId StartPeriodic(std::chrono::nanoseconds period,
+            std::function<void()> callback, const TimerOptions& options = {}) override;
+        TimerId StartDeadline(std::chrono::steady_clock::time_point deadline,
+            std::function<void()> callback, const TimerOptions& options = {}) override;
+        bool RestartTimer(TimerId timer, std::chrono::nanoseconds delay) override;
+        bool StopTimer(TimerId timer) override;
+        [[nodiscard]] TimerServiceStats GetTimerStats() const override;
 
     private:
         // --- 内部核心逻辑 ---
+        void RegisterComponentImpl(ClassId clsid, FactoryFunction factory, bool is_singleton,
+            const std::string& alias, InterfaceList implemented_interfaces,
+            bool is_default, bool factory_initializes);
         [[nodiscard]] PluginPtr<IComponent> CreateInstanceImpl(const ClassId& clsid);
         [[nodiscard]] PluginPtr<IComponent> GetServiceImpl(const ClassId& clsid);
-        [[nodiscard]] std::optional<ClassId> GetClsidFromAlias(const std::string& alias) const;
+        [[nodiscard]] PluginPtr<IComponent> TryGetServiceImpl(const ClassId& clsid, InstanceError& out_error);
+        [[nodiscard]] std::optional<ClassId> GetClsidFromAlias(Alias alias) const;
         [[nodiscard]] std::optional<ClassId> GetDefaultClsidImpl(InterfaceId iid);
+        [[nodiscard]] bool ShouldInterceptCalls(const ClassId& clsid, const char* interface_name) const;
+
+        // 命中拦截规则时把 obj 换成 T 的代理；T 没有代理描述时整段在编译期消失
+        template <typename T>
+        [[nodiscard]] PluginPtr<T> InterceptCalls(const ClassId& clsid, PluginPtr<T> obj) const {
+            if constexpr (InterfaceProxyTraits<T>::kAvailable) {
+                static const std::atomic<bool>& active = IsCallInterceptionActive();
+                if (obj && active.load(std::memory_order_relaxed) && ShouldInterceptCalls(clsid, T::kName)) {
+                    return InterfaceProxyTraits<T>::Wrap(std::move(obj));
+                }
+            }
+            return obj;
+        }
 
         // 访问 Pimpl 的辅助函数
         PluginManagerPimpl* GetImpl() { return pimpl_.get(); }
@@ -226,22 +927,40 @@ namespace z3y {
         [[nodiscard]] bool LoadPluginInternal(const std::filesystem::path& file_path,
             const std::string& init_func_name,
             std::string& out_error_message);
+        void PreparePluginLoad(PluginLoadJob& job, const std::string& init_func_name); // 可并行：加载库并执行入口
+        [[nodiscard]] bool CommitPluginLoad(PluginLoadJob& job, std::string& out_error_message); // 串行：发布注册
+        [[nodiscard]] bool CommitDeferredPlugin(PluginLoadJob& job, const std::string& init_func_name,
+            std::string& out_error_message); // 按清单注册延迟条目
+        void LoadDeferredPlugin(const ClassId& clsid); // clsid 是延迟条目时，加载其所属的库
+        // 在一次写锁内校验并发布一批注册 (handle 非空时同时登记该库及其文件身份)。
+        // 冲突时抛出 std::runtime_error 且不做任何修改；该库已被并发的另一次加载提交时返回 false。
+        [[nodiscard]] bool CommitRegistrations(const std::string& plugin_path, LibHandle handle,
+            std::vector<PendingRegistration>& batch, PluginLoadTiming* timing = nullptr,
+            const PluginFileInfo* file_info = nullptr);
         [[nodiscard]] bool IsPluginFile(const std::filesystem::path& path) const;
 
         // --- 异步循环与 GC ---
-        void EventLoop(); // 工作线程入口
-        void ScheduleGC(EventId event_id); // 调度 GC
-        void PerformGC(EventId event_id);  // 执行 GC
+        void EventLoop(size_t worker_index); // 工作线程入口 (每个派发线程一个)
+        void StartEventWorkers(size_t worker_count, size_t queue_capacity); // 启动派发线程池
+        void StopEventWorkers(); // 停止并 join 所有派发线程
+        void DrainEventWorkers(); // 等待所有派发线程执行完此刻之前已入队的任务
+        void ScheduleGC(EventId event_id); // 标记某全局事件待 GC
+        void ScheduleSenderGC(std::uintptr_t sender_key); // 标记某发送者订阅表待 GC
+        void ScheduleGCPassLocked(); // 确保有一个 GC 批处理任务在排队 (需持有 gc_status_mutex_)
+        void PerformGCPass();        // 执行一轮 GC 批处理
 
-        void RollbackRegistrations(const std::vector<ClassId>& clsid_list); // 加载失败回滚
         void ClearAllRegistries(); // 彻底清理
 
         // --- 平台抽象层 (PAL) ---
         // 隔离 Windows/Linux API 差异
-        [[nodiscard]] LibHandle PlatformLoadLibrary(const std::filesystem::path& path);
+        [[nodiscard]] LibHandle PlatformLoadLibrary(const std::filesystem::path& path, PluginSymbolBinding binding);
         [[nodiscard]] void* PlatformGetFunction(LibHandle handle, const char* func_name);
         void PlatformUnloadLibrary(LibHandle handle);
+        [[nodiscard]] bool PlatformAddressInLibrary(LibHandle handle, const void* address); // 地址是否位于该库的映像中
         void PlatformSpecificLibraryUnload();
+        [[nodiscard]] bool PlatformOpenDirectoryWatch(const std::filesystem::path& dir);
+        [[nodiscard]] bool PlatformWaitDirectoryChanges(std::vector<std::filesystem::path>& out_files); // 被唤醒停止时返回 false
+        void PlatformWakeDirectoryWatch();
 
     public:
         // --- 模板便捷 API (User Friendly) ---
@@ -249,9 +968,9 @@ namespace z3y {
 
         // 通过别名创建组件实例
         template <typename T>
-        [[nodiscard]] PluginPtr<T> CreateInstance(const std::string& alias) {
+        [[nodiscard]] PluginPtr<T> CreateInstance(Alias alias) {
             std::optional<ClassId> clsid = GetClsidFromAlias(alias);
-            if (!clsid) throw PluginException(InstanceError::kErrorAliasNotFound, "Alias '" + alias + "' not found.");
+            if (!clsid) throw PluginException(InstanceError::kErrorAliasNotFound, "Alias '" + std::string(alias.name) + "' not found.");
             return CreateInstance<T>(*clsid);
         }
 
@@ -260,16 +979,16 @@ namespace z3y {
         [[nodiscard]] PluginPtr<T> CreateInstance(const ClassId& clsid) {
             auto base_obj = CreateInstanceImpl(clsid);
             InstanceError cast_result = InstanceError::kSuccess;
-            PluginPtr<T> out_ptr = PluginCast<T>(base_obj, cast_result);
+            T* raw = PluginCastNoRef<T>(base_obj.get(), cast_result);
             if (cast_result != InstanceError::kSuccess) throw PluginException(cast_result, "PluginCast failed.");
-            return out_ptr;
+            return InterceptCalls<T>(clsid, PluginPtr<T>(base_obj, raw));
         }
 
         // 通过别名获取单例服务
         template <typename T>
-        [[nodiscard]] PluginPtr<T> GetService(const std::string& alias) {
+        [[nodiscard]] PluginPtr<T> GetService(Alias alias) {
             std::optional<ClassId> clsid = GetClsidFromAlias(alias);
-            if (!clsid) throw PluginException(InstanceError::kErrorAliasNotFound, "Alias '" + alias + "' not found.");
+            if (!clsid) throw PluginException(InstanceError::kErrorAliasNotFound, "Alias '" + std::string(alias.name) + "' not found.");
             return GetService<T>(*clsid);
         }
 
@@ -278,9 +997,9 @@ namespace z3y {
         [[nodiscard]] PluginPtr<T> GetService(const ClassId& clsid) {
             auto base_obj = GetServiceImpl(clsid);
             InstanceError cast_result = InstanceError::kSuccess;
-            PluginPtr<T> out_ptr = PluginCast<T>(base_obj, cast_result);
+            T* raw = PluginCastNoRef<T>(base_obj.get(), cast_result);
             if (cast_result != InstanceError::kSuccess) throw PluginException(cast_result, "PluginCast failed for cached service.");
-            return out_ptr;
+            return InterceptCalls<T>(clsid, PluginPtr<T>(base_obj, raw));
         }
 
         // 获取默认的单例服务
@@ -292,6 +1011,35 @@ namespace z3y {
             return GetService<T>(*default_clsid);
         }
 
+        // --- 非抛出查找 (失败时返回 nullptr 并写入 out_error，不经过异常) ---
+
+        // 通过 CLSID 获取单例服务 (非抛出)
+        template <typename T>
+        [[nodiscard]] PluginPtr<T> TryGetService(const ClassId& clsid, InstanceError& out_error) {
+            auto base_obj = TryGetServiceImpl(clsid, out_error);
+            if (!base_obj) return nullptr;
+            T* raw = PluginCastNoRef<T>(base_obj.get(), out_error);
+            if (!raw) return nullptr;
+            return InterceptCalls<T>(clsid, PluginPtr<T>(base_obj, raw));
+        }
+
+        // 通过别名获取单例服务 (非抛出)
+        template <typename T>
+        [[nodiscard]] PluginPtr<T> TryGetService(Alias alias, InstanceError& out_error) {
+            std::optional<ClassId> clsid = GetClsidFromAlias(alias);
+            if (!clsid) { out_error = InstanceError::kErrorAliasNotFound; return nullptr; }
+            return TryGetService<T>(*clsid, out_error);
+        }
+
+        // 获取默认的单例服务 (非抛出)
+        template <typename T>
+        [[nodiscard]] PluginPtr<T> TryGetDefaultService(InstanceError& out_error) {
+            static_assert(std::is_base_of_v<IComponent, T>, "T must derive from IComponent");
+            std::optional<ClassId> default_clsid = GetDefaultClsidImpl(T::kIid);
+            if (!default_clsid) { out_error = InstanceError::kErrorAliasNotFound; return nullptr; }
+            return TryGetService<T>(*default_clsid, out_error);
+        }
+
         // 创建默认的组件实例
         template <typename T>
         [[nodiscard]] PluginPtr<T> CreateDefaultInstance() {
@@ -302,6 +1050,43 @@ namespace z3y {
         }
     };
 
+    /**
+     * @class PluginManagerScope
+     * @brief [宿主专用] 在作用域内把当前线程绑定到指定的框架实例 (可嵌套)。
+     *
+     * @details
+     * 绑定期间 `PluginManager::GetActiveInstance()` 及所有全局服务定位函数都解析到该实例，
+     * 析构时恢复之前的绑定。进入 / 退出只改变本线程的绑定编号 (`ServiceHandle` 缓存键的一部分)，
+     * 不递增全局服务代数，其他线程的缓存不受影响；本线程在切换后的首次查找会重新解析。
+     * 实例销毁后，仍处于绑定中的线程得到 nullptr，不会退回默认实例。
+     *
+     * @example
+     * \code{.cpp}
+     * PluginManagerOptions options;
+     * options.isolated = true;
+     * auto lane = z3y::PluginManager::Create(options);
+     * std::thread worker([lane] {
+     *     z3y::PluginManagerScope scope(lane);
+     *     auto codec = z3y::GetDefaultService<ICodec>();  // 来自 lane
+     * });
+     * \endcode
+     */
+    class Z3Y_FRAMEWORK_API PluginManagerScope {
+    public:
+        explicit PluginManagerScope(const std::shared_ptr<PluginManager>& manager);
+        /** @brief 按弱引用绑定 (框架内部在实例析构期间使用)。 */
+        explicit PluginManagerScope(std::weak_ptr<PluginManager> manager);
+        ~PluginManagerScope();
+
+        PluginManagerScope(const PluginManagerScope&) = delete;
+        PluginManagerScope& operator=(const PluginManagerScope&) = delete;
+
+    private:
+        std::weak_ptr<PluginManager> previous_;
+        bool previous_bound_ = false;
+        uint64_t previous_id_ = 0;
+    };
+
 }  // namespace z3y
 
 #ifdef _MSC_VER
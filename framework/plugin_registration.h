@@ -34,7 +34,7 @@
  * 它们封装了调用 `IPluginRegistry::RegisterComponent` 所需的两个关键步骤：
  * 1. **工厂创建 (Factory)**: 自动创建一个 `std::make_shared<ImplClass>`
  * 的 lambda 函数 (即 `FactoryFunction`)。
- * 2. **接口详情 (Details)**: 自动调用 `ImplClass::GetInterfaceDetails()`
+ * 2. **接口详情 (Details)**: 自动调用 `ImplClass::GetInterfaceDescriptors()`
  * (该静态函数由 `PluginImpl` 基类提供) 来获取元数据。
  */
 
@@ -45,12 +45,53 @@
 
 #include <memory>    // 用于 std::make_shared
 #include <string>    // 用于 std::string
+#include <type_traits>  // 用于 std::is_invocable_v
 #include <vector>    // 用于 std::vector
+#include "framework/allocation_account.h"  // 依赖 AccountingAllocator
+#include "framework/event_delegate.h"  // 依赖 EventDelegate
+#include "framework/component_pool.h"  // 依赖 ComponentPool
 #include "framework/i_plugin_registry.h"  // 依赖 IPluginRegistry
 #include "framework/plugin_impl.h"  // 依赖 PluginImpl (为了
- // ImplClass::GetInterfaceDetails)
+ // ImplClass::GetInterfaceDescriptors)
 
 namespace z3y {
+    namespace internal {
+        /**
+         * @brief [框架内部] 无状态工厂：`make_shared` 把控制块与对象放在同一次分配中。
+         * @details 以函数指针 (`FactoryFunctionPtr`) 形式注册，使管理器可以绕开 `std::function`。
+         */
+        template <typename ImplClass>
+        PluginPtr<IComponent> MakeComponent() {
+            // 启用内存记账时，管理器在调用工厂期间设置作用域
+            if (auto account = CurrentAllocationAccount()) {
+                return std::allocate_shared<ImplClass>(AccountingAllocator<ImplClass>(std::move(account)));
+            }
+            return std::make_shared<ImplClass>();
+        }
+
+        /** @brief [框架内部] 把 `Method` 绑定为 `ImplClass` 对 `TEvent` 的回调。 */
+        template <typename ImplClass, typename TEvent, auto Method>
+        EventDelegate BindEventHandler() {
+            return EventDelegate::Bind<ImplClass, TEvent>(Method);
+        }
+
+        /** @brief [框架内部] 取得实例的实现类指针 (回调按实现类调用成员函数)。 */
+        template <typename ImplClass>
+        std::shared_ptr<void> EventHandlerSubscriber(const PluginPtr<IComponent>& instance) {
+            return std::dynamic_pointer_cast<ImplClass>(instance);
+        }
+
+        /** @brief [框架内部] 生成一条 `EventHandlerEntry` (编译期常量)。 */
+        template <typename ImplClass, typename TEvent, auto Method>
+        constexpr EventHandlerEntry MakeEventHandler(ConnectionType type) {
+            static_assert(std::is_base_of_v<Event, TEvent>, "TEvent must derive from z3y::Event");
+            static_assert(std::is_invocable_v<decltype(Method), ImplClass*, const TEvent&>,
+                "Method must be callable as (ImplClass*, const TEvent&)");
+            return EventHandlerEntry{ TEvent::kEventId, TEvent::kName, type,
+                &BindEventHandler<ImplClass, TEvent, Method>, &EventHandlerSubscriber<ImplClass> };
+        }
+    }  // namespace internal
+
     /**
      * @brief [框架内部] 注册一个瞬态组件 (Component) 的模板辅助函数。
      *
@@ -62,18 +103,41 @@ namespace z3y {
     template <typename ImplClass>
     void RegisterComponent(IPluginRegistry* registry, const std::string& alias = "",
         bool is_default = false) {
-        // 1. 自动创建工厂 lambda
-        FactoryFunction factory = []() -> PluginPtr<IComponent> {
-            return std::make_shared<ImplClass>();
-            };
+        // 1. 无状态工厂 (以函数指针形式存放)
+        FactoryFunction factory = static_cast<FactoryFunctionPtr>(&internal::MakeComponent<ImplClass>);
 
         // 2. 自动调用 ImplClass 的静态函数 (该函数由 PluginImpl 基类提供)
         registry->RegisterComponent(ImplClass::kClsid, std::move(factory),
             false,  // is_singleton = false
-            alias, ImplClass::GetInterfaceDetails(),
+            alias, ImplClass::GetInterfaceDescriptors(),
             is_default);
     }
 
+    /**
+     * @brief [框架内部] 注册一个池化瞬态组件的模板辅助函数。
+     *
+     * @details 释放的实例经 `OnRecycle()` (若有) 重置后回到池中，供下一次 `CreateInstance` 复用。
+     * `Initialize()` 只在对象首次构造时调用一次。
+     *
+     * @tparam ImplClass 要注册的组件实现类。
+     * @param[in] registry `z3yPluginInit` 提供的 `IPluginRegistry` 指针。
+     * @param[in] alias 组件的可选别名。
+     * @param[in] is_default 是否将其标记为默认实现。
+     * @param[in] max_idle 池中最多保留的空闲实例数。
+     */
+    template <typename ImplClass>
+    void RegisterPooledComponent(IPluginRegistry* registry, const std::string& alias = "",
+        bool is_default = false, size_t max_idle = ComponentPool<ImplClass>::kDefaultMaxIdle) {
+        // 池由工厂持有，注册表清空 (插件卸载) 时随工厂一起销毁
+        auto pool = std::make_shared<ComponentPool<ImplClass>>(max_idle);
+        FactoryFunction factory = [pool]() -> PluginPtr<IComponent> {
+            return pool->Acquire();
+            };
+
+        registry->RegisterPooledComponent(ImplClass::kClsid, std::move(factory),
+            alias, ImplClass::GetInterfaceDescriptors(), is_default);
+    }
+
     /**
      * @brief [框架内部] 注册一个单例服务 (Service) 的模板辅助函数。
      *
@@ -85,15 +149,13 @@ namespace z3y {
     template <typename ImplClass>
     void RegisterService(IPluginRegistry* registry, const std::string& alias = "",
         bool is_default = false) {
-        // 1. 自动创建工厂 lambda
-        FactoryFunction factory = []() -> PluginPtr<IComponent> {
-            return std::make_shared<ImplClass>();
-            };
+        // 1. 无状态工厂 (以函数指针形式存放)
+        FactoryFunction factory = static_cast<FactoryFunctionPtr>(&internal::MakeComponent<ImplClass>);
 
         // 2. 自动调用 ImplClass 的静态函数
         registry->RegisterComponent(ImplClass::kClsid, std::move(factory),
             true,  // is_singleton = true
-            alias, ImplClass::GetInterfaceDetails(),
+            alias, ImplClass::GetInterfaceDescriptors(),
             is_default);
     }
 
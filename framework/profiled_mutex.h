@@ -0,0 +1,212 @@
+﻿/*
+* Copyright [2025] [Yue Liu]
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/**
+ * @file profiled_mutex.h
+ * @brief 可插桩的互斥量包装 (`ProfiledMutex`) 与锁竞争采样钩子。
+ * @author Yue Liu
+ * @date 2025
+ *
+ * @details
+ * [受众：框架维护者 和 排查锁竞争的宿主开发者]
+ *
+ * 框架内部的热点锁 (`registry_mutex_`、`subscriber_map_mutex_`、配置字典的分片锁、spdlog 插件的 `provider_lock_`)
+ * 声明为 `ProfiledMutex<std::mutex>` / `ProfiledMutex<std::shared_mutex>`，用法与被包装的互斥量完全相同：
+ *
+ * \code{.cpp}
+ * mutable z3y::ProfiledMutex<std::shared_mutex> registry_mutex_{ "PluginManager.registry" };
+ * std::shared_lock lock(registry_mutex_);
+ * \endcode
+ *
+ * - **关闭 `Z3Y_LOCK_PROFILING` (默认)**：`ProfiledMutex<M>` 直接继承 `M`，只多一个忽略名字的构造函数，
+ *   大小与代码生成和裸互斥量一致。
+ * - **开启 `Z3Y_LOCK_PROFILING`** (CMake 选项，向所有使用者公开同名宏)：安装了采样钩子时，
+ *   每次独占加锁在解锁时上报一条 `LockContentionSample` (等待时间 + 持有时间 + 加锁调用点)，
+ *   共享加锁在获得锁时上报等待时间；没有钩子时只多一次原子读。
+ *
+ * 钩子由 `SetLockProfileHook` 全局安装 (Profiler 插件的 `System.Profiler.LockContention` 开关)，
+ * 与 PluginManager 实例无关：插件自己的锁在框架重建期间同样可以上报。
+ *
+ * [约定]
+ * 调用点取自 `lock()` 的返回地址：`std::lock_guard` 等的构造函数被内联时即为加锁所在的函数，
+ * 调试构建下可能只指向锁守卫的构造函数。
+ */
+
+#pragma once
+
+#ifndef Z3Y_FRAMEWORK_PROFILED_MUTEX_H_
+#define Z3Y_FRAMEWORK_PROFILED_MUTEX_H_
+
+#include <cstdint>  // 用于 uint64_t
+#include "framework/z3y_framework_api.h"
+
+#ifdef Z3Y_LOCK_PROFILING
+#include <chrono>  // 用于计时
+#if defined(_MSC_VER)
+#include <intrin.h>  // _ReturnAddress
+#define Z3Y_LOCK_CALLER() _ReturnAddress()
+#define Z3Y_LOCK_NOINLINE __declspec(noinline)
+#else
+#define Z3Y_LOCK_CALLER() __builtin_return_address(0)
+#define Z3Y_LOCK_NOINLINE __attribute__((noinline))
+#endif
+#endif
+
+namespace z3y {
+
+    /**
+     * @struct LockContentionSample
+     * @brief 一次加锁的采样。
+     */
+    struct LockContentionSample {
+        const char* lock_name = nullptr;  //!< 锁名 (声明时给出的字符串字面量)
+        const void* call_site = nullptr;  //!< 加锁调用点 (返回地址)
+        uint64_t wait_ns = 0;             //!< 等待获得锁的时间；未发生竞争时为 0
+        uint64_t hold_ns = 0;             //!< 持有锁的时间；共享加锁为 0
+        bool contended = false;           //!< 第一次尝试是否失败
+        bool shared = false;              //!< 是否为共享 (读) 加锁
+    };
+
+    /** @brief 锁竞争采样钩子。可在任意线程上并发调用，调用期间上报线程持有的锁可能尚未释放。 */
+    using LockProfileHook = void (*)(const LockContentionSample& sample, void* context);
+
+    /** @brief 本次构建是否开启了 `Z3Y_LOCK_PROFILING` (未开启时 `ProfiledMutex` 从不上报)。 */
+#ifdef Z3Y_LOCK_PROFILING
+    inline constexpr bool kLockProfilingCompiled = true;
+#else
+    inline constexpr bool kLockProfilingCompiled = false;
+#endif
+
+    /**
+     * @brief 安装 (或以 nullptr 卸下) 全局锁竞争采样钩子。
+     * @details 返回前等待进行中的旧钩子调用全部结束，之后不会再有调用进入旧的 `context`。
+     * 钩子内部再次加锁不会递归上报。
+     */
+    Z3Y_FRAMEWORK_API void SetLockProfileHook(LockProfileHook hook, void* context);
+
+    /** @brief 当前是否安装了采样钩子 (一次原子读)。 */
+    Z3Y_FRAMEWORK_API bool IsLockProfileHookInstalled() noexcept;
+
+    /** @brief 把一条采样交给当前钩子；没有钩子时什么都不做。 */
+    Z3Y_FRAMEWORK_API void ReportLockSample(const LockContentionSample& sample) noexcept;
+
+#ifdef Z3Y_LOCK_PROFILING
+
+    /**
+     * @class ProfiledMutex
+     * @brief 上报等待 / 持有时间的互斥量包装。满足 Lockable (以及 `Mutex` 支持时的 SharedLockable)。
+     * @tparam Mutex 被包装的互斥量 (`std::mutex`、`std::shared_mutex` 等)。
+     */
+    template <typename Mutex>
+    class ProfiledMutex {
+    public:
+        explicit ProfiledMutex(const char* name) noexcept : name_(name) {}
+        ProfiledMutex(const ProfiledMutex&) = delete;
+        ProfiledMutex& operator=(const ProfiledMutex&) = delete;
+
+        Z3Y_LOCK_NOINLINE void lock() {
+            if (!IsLockProfileHookInstalled()) {
+                mutex_.lock();
+                acquired_ns_ = 0;
+                return;
+            }
+            const uint64_t start = NowNs();
+            const bool contended = !mutex_.try_lock();
+            if (contended) mutex_.lock();
+            // 成员只能在获得锁之后写入：等待期间它们仍属于当前持有者
+            contended_ = contended;
+            acquired_ns_ = NowNs();
+            wait_ns_ = acquired_ns_ - start;
+            call_site_ = Z3Y_LOCK_CALLER();
+        }
+
+        bool try_lock() {
+            if (!mutex_.try_lock()) return false;
+            acquired_ns_ = 0;  // 不计入：try_lock 失败的调用方不会等待
+            return true;
+        }
+
+        void unlock() {
+            if (acquired_ns_ == 0) {
+                mutex_.unlock();
+                return;
+            }
+            // 解锁前拷贝：解锁之后成员立刻可能被下一个持有者改写
+            LockContentionSample sample;
+            sample.lock_name = name_;
+            sample.call_site = call_site_;
+            sample.wait_ns = wait_ns_;
+            sample.contended = contended_;
+            sample.hold_ns = NowNs() - acquired_ns_;
+            acquired_ns_ = 0;
+            mutex_.unlock();
+            ReportLockSample(sample);
+        }
+
+        Z3Y_LOCK_NOINLINE void lock_shared() {
+            if (!IsLockProfileHookInstalled()) {
+                mutex_.lock_shared();
+                return;
+            }
+            LockContentionSample sample;
+            sample.lock_name = name_;
+            sample.call_site = Z3Y_LOCK_CALLER();
+            sample.shared = true;
+            const uint64_t start = NowNs();
+            sample.contended = !mutex_.try_lock_shared();
+            if (sample.contended) mutex_.lock_shared();
+            sample.wait_ns = NowNs() - start;
+            ReportLockSample(sample);
+        }
+
+        bool try_lock_shared() { return mutex_.try_lock_shared(); }
+        void unlock_shared() { mutex_.unlock_shared(); }
+
+        /** @brief 声明时给出的锁名。 */
+        const char* name() const noexcept { return name_; }
+
+    private:
+        static uint64_t NowNs() noexcept {
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count());
+        }
+
+        Mutex mutex_;
+        const char* const name_;
+        // 以下字段只由持有独占锁的线程读写
+        uint64_t acquired_ns_ = 0;  //!< 获得锁的时刻；0 表示本次不上报
+        uint64_t wait_ns_ = 0;
+        const void* call_site_ = nullptr;
+        bool contended_ = false;
+    };
+
+#else
+
+    /**
+     * @class ProfiledMutex
+     * @brief 未开启 `Z3Y_LOCK_PROFILING` 时即为 `Mutex` 本身，锁名被忽略。
+     */
+    template <typename Mutex>
+    class ProfiledMutex : public Mutex {
+    public:
+        constexpr explicit ProfiledMutex(const char*) noexcept {}
+    };
+
+#endif  // Z3Y_LOCK_PROFILING
+
+}  // namespace z3y
+
+#endif  // Z3Y_FRAMEWORK_PROFILED_MUTEX_H_
@@ -0,0 +1,93 @@
+﻿/*
+* Copyright [2025] [Yue Liu]
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/**
+ * @file static_plugin.h
+ * @brief 静态链接插件：z3y::StaticPluginEntry 与 Z3Y_IMPORT_STATIC_PLUGIN / Z3Y_STATIC_PLUGIN 宏。
+ * @author Yue Liu
+ * @date 2025
+ *
+ * @details
+ * [受众：框架使用者 (嵌入式宿主)]
+ *
+ * 以 `-DZ3Y_STATIC_PLUGINS=ON` 配置时，框架核心库构建为静态库，`z3y_add_plugin()` 把插件构建为
+ * OBJECT 库并直接链接进宿主。此时不再有 dlopen、符号查找，也不再为每个插件构造注册任务的 `std::vector`：
+ * - 每个插件的 `Z3Y_DEFINE_PLUGIN_ENTRY` 生成一个普通的 C 函数 `z3yPluginInit_<插件名>`
+ * (插件名由 CMake 通过 `Z3Y_STATIC_PLUGIN_NAME` 传入)。
+ * - `Z3Y_AUTO_REGISTER_...` 只把一个静态节点挂到本插件的侵入式链表上 (无堆分配)。
+ * - 宿主用 `constexpr` 表列出要启用的插件，再交给 `PluginManager::LoadStaticPlugins`：
+ *
+ * \code{.cpp}
+ * Z3Y_IMPORT_STATIC_PLUGIN(plugin_demo_core_services)
+ * Z3Y_IMPORT_STATIC_PLUGIN(plugin_spdlog_logger)
+ *
+ * static constexpr z3y::StaticPluginEntry kStaticPlugins[] = {
+ *     Z3Y_STATIC_PLUGIN(plugin_demo_core_services),
+ *     Z3Y_STATIC_PLUGIN(plugin_spdlog_logger),
+ * };
+ *
+ * auto failures = manager->LoadStaticPlugins(kStaticPlugins);
+ * \endcode
+ *
+ * 静态插件的组件以 `"static:<插件名>"` 作为来源路径 (`ComponentDetails::source_plugin_path`)。
+ */
+
+#pragma once
+
+#ifndef Z3Y_FRAMEWORK_STATIC_PLUGIN_H_
+#define Z3Y_FRAMEWORK_STATIC_PLUGIN_H_
+
+namespace z3y {
+
+    class IPluginRegistry;
+
+    /**
+     * @struct StaticPluginEntry
+     * @brief 静态链接插件表中的一项。可以在 `constexpr` 数组中构造。
+     */
+    struct StaticPluginEntry {
+        const char* name;                     //!< 插件名 (与 Z3Y_STATIC_PLUGIN_NAME 一致)
+        void (*init)(IPluginRegistry*);       //!< 插件入口 (z3yPluginInit_<name>)
+    };
+
+    /** @brief 静态插件来源路径的前缀。 */
+    inline constexpr const char kStaticPluginPathPrefix[] = "static:";
+
+}  // namespace z3y
+
+/** @brief [内部] 宏拼接辅助。 */
+#define Z3Y_STATIC_CONCAT_INNER(a, b) a##b
+/** @brief [内部] 宏拼接辅助 (先展开参数)。 */
+#define Z3Y_STATIC_CONCAT(a, b) Z3Y_STATIC_CONCAT_INNER(a, b)
+
+/** @brief [内部] 静态插件 `name` 的入口函数名。 */
+#define Z3Y_STATIC_PLUGIN_INIT(name) Z3Y_STATIC_CONCAT(z3yPluginInit_, name)
+
+/**
+ * @def Z3Y_IMPORT_STATIC_PLUGIN
+ * @brief [宿主] 声明一个静态链接进来的插件的入口 (在全局作用域使用)。
+ */
+#define Z3Y_IMPORT_STATIC_PLUGIN(name) \
+  extern "C" void Z3Y_STATIC_PLUGIN_INIT(name)(z3y::IPluginRegistry* registry);
+
+/**
+ * @def Z3Y_STATIC_PLUGIN
+ * @brief [宿主] 构造 `StaticPluginEntry` (须先 `Z3Y_IMPORT_STATIC_PLUGIN(name)`)。
+ */
+#define Z3Y_STATIC_PLUGIN(name) \
+  z3y::StaticPluginEntry{ #name, &Z3Y_STATIC_PLUGIN_INIT(name) }
+
+#endif  // Z3Y_FRAMEWORK_STATIC_PLUGIN_H_
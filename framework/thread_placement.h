@@ -0,0 +1,130 @@
+﻿/*
+* Copyright [2025] [Yue Liu]
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/**
+ * @file thread_placement.h
+ * @brief 框架线程的放置策略 (CPU 集合、NUMA 节点、调度优先级) 与 NUMA 拓扑查询。
+ * @author Yue Liu
+ * @date 2025
+ *
+ * @details
+ * [受众：宿主开发者 和 拥有后台线程的插件开发者]
+ *
+ * 多路服务器上，线程由操作系统随意调度时，事件队列、缓冲区池等共享结构会在插槽之间来回迁移缓存行。
+ * 宿主可以通过 `PluginManagerOptions::thread_placements` 为每一类框架线程 (按“角色”名) 指定放置策略：
+ *
+ * \code{.cpp}
+ * z3y::PluginManagerOptions options;
+ * options.event_dispatch_threads = 8;
+ * z3y::ThreadPlacement dispatch;
+ * dispatch.numa_nodes = { 0, 1 };     // 派发线程 0,2,4,6 在节点 0；1,3,5,7 在节点 1
+ * dispatch.pin_each_thread = true;    // 每个线程独占所在节点上的一个 CPU
+ * options.thread_placements[z3y::thread_role::kEventDispatch] = dispatch;
+ * options.thread_placements["spdlog.backend"].priority = z3y::ThreadPriority::kLow;
+ * \endcode
+ *
+ * 框架自己的线程 (派发线程、共享执行器、目录监视、跨进程事件桥) 在启动时自动应用对应角色的策略；
+ * 事件派发线程的队列在放置之后才在该线程上构造，内存按首次写入落在线程所在的节点上。
+ * 插件的后台线程在线程入口调用 `PlaceCurrentThread("<角色名>", 线程序号)` 即可遵守同一份配置。
+ *
+ * [约定]
+ * 放置是尽力而为的：请求的 CPU 不存在、超出进程允许的集合、或提升优先级缺少权限时，
+ * 相应的函数返回 false，线程保持原样继续运行。macOS 不支持绑定 CPU。
+ */
+
+#pragma once
+
+#ifndef Z3Y_FRAMEWORK_THREAD_PLACEMENT_H_
+#define Z3Y_FRAMEWORK_THREAD_PLACEMENT_H_
+
+#include <cstddef>      // 用于 size_t
+#include <string_view>  // 用于角色名
+#include <vector>       // 用于 CPU / 节点列表
+#include "framework/z3y_framework_api.h"
+
+namespace z3y {
+
+    /** @brief 线程调度优先级。 */
+    enum class ThreadPriority {
+        kDefault,   //!< 不修改
+        kLow,       //!< 低于普通线程 (Linux: nice 10；Windows: BELOW_NORMAL)
+        kHigh,      //!< 高于普通线程 (Linux: nice -5，需要 CAP_SYS_NICE；Windows: ABOVE_NORMAL)
+        kRealtime,  //!< 实时调度 (Linux: SCHED_FIFO，需要权限；Windows: TIME_CRITICAL)
+    };
+
+    /**
+     * @struct ThreadPlacement
+     * @brief 一类线程的放置策略。默认构造 = 不做任何修改。
+     * @details 对一个线程池，第 `i` 个线程 (从 0 开始) 的候选 CPU 按以下顺序确定：
+     * 1. `numa_nodes` 非空时取节点 `numa_nodes[i % numa_nodes.size()]` 的 CPU；
+     * 2. `cpus` 非空时与上一步取交集 (没有节点限制时直接使用 `cpus`)；
+     * 3. `pin_each_thread` 时只保留候选中的一个：同一节点上的线程依次分到不同的 CPU。
+     */
+    struct ThreadPlacement {
+        std::vector<int> cpus;          //!< 允许运行的逻辑 CPU 编号；空 = 不限制
+        std::vector<int> numa_nodes;    //!< 线程轮流分配到的 NUMA 节点；空 = 不限制
+        bool pin_each_thread = false;   //!< 每个线程只绑定到一个 CPU
+        ThreadPriority priority = ThreadPriority::kDefault;
+        int realtime_priority = 10;     //!< `kRealtime` 时的 SCHED_FIFO 优先级 (1 ~ 99)
+
+        /** @brief 是否什么都不修改。 */
+        [[nodiscard]] bool IsDefault() const noexcept {
+            return cpus.empty() && numa_nodes.empty() && priority == ThreadPriority::kDefault;
+        }
+    };
+
+    /**
+     * @brief 框架线程的角色名 (`PluginManagerOptions::thread_placements` 的键)。
+     * @details 插件的后台线程使用 "<插件>.<线程>" 形式的名字，例如 "spdlog.backend"、"config.notify"。
+     */
+    namespace thread_role {
+        inline constexpr const char* kEventDispatch = "z3y.event_dispatch";   //!< 事件派发线程 (序号 = 派发线程下标)
+        inline constexpr const char* kExecutor = "z3y.executor";              //!< 共享执行器 (IExecutorService) 的工作线程
+        inline constexpr const char* kDirectoryWatch = "z3y.directory_watch"; //!< 插件目录监视线程
+        inline constexpr const char* kIpcReceiver = "z3y.ipc_receiver";       //!< 跨进程事件桥的接收线程
+    }  // namespace thread_role
+
+    /**
+     * @brief 对调用线程应用放置策略。
+     * @param thread_index 调用线程在其线程池中的序号 (见 `ThreadPlacement`)。
+     * @return 全部设置都生效时返回 true；任何一项失败返回 false (其余项仍会尝试)。
+     */
+    Z3Y_FRAMEWORK_API bool ApplyThreadPlacement(const ThreadPlacement& placement, size_t thread_index = 0);
+
+    /**
+     * @brief 按当前框架实例配置的角色策略放置调用线程。
+     * @return 没有框架实例或该角色未配置时返回 true (无需放置)；否则同 `ApplyThreadPlacement`。
+     */
+    Z3Y_FRAMEWORK_API bool PlaceCurrentThread(std::string_view role, size_t thread_index = 0);
+
+    /** @brief NUMA 节点数 (至少为 1；拓扑不可读时视为单节点)。 */
+    [[nodiscard]] Z3Y_FRAMEWORK_API size_t GetNumaNodeCount() noexcept;
+
+    /** @brief 某个节点上的逻辑 CPU 编号 (升序)。节点不存在时返回空。 */
+    [[nodiscard]] Z3Y_FRAMEWORK_API std::vector<int> GetNumaNodeCpus(size_t node);
+
+    /** @brief 调用线程当前所在的逻辑 CPU；平台不支持时返回 -1。 */
+    [[nodiscard]] Z3Y_FRAMEWORK_API int GetCurrentCpu() noexcept;
+
+    /**
+     * @brief 调用线程当前所在的 NUMA 节点 (未知时为 0)。
+     * @details 开销为一次 vDSO 调用加一次查表，适合按批次 (而不是按对象) 选择节点分片。
+     */
+    [[nodiscard]] Z3Y_FRAMEWORK_API size_t GetCurrentNumaNode() noexcept;
+
+}  // namespace z3y
+
+#endif  // Z3Y_FRAMEWORK_THREAD_PLACEMENT_H_
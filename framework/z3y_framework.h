@@ -58,4 +58,19 @@
 
 #include "framework/z3y_utils.h"
 
+// 6. 可选的协程支持 (仅在 C++20 下生效，见 Z3Y_HAS_COROUTINES)
+#include "framework/coroutine_task.h"
+
+// 7. 跨进程事件桥 (显式创建后才生效)
+#include "framework/ipc_event_bridge.h"
+
+// 8. 事件录制与回放 (显式创建后才生效)
+#include "framework/event_recorder.h"
+
+// 9. 事件窗口聚合算子 (显式挂接后才生效)
+#include "framework/event_window.h"
+
+// 10. 数据流管线 (显式创建后才生效)
+#include "framework/pipeline.h"
+
 #endif  // Z3Y_FRAMEWORK_H_
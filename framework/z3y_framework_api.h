@@ -39,6 +39,8 @@
  * 4. 此时 `Z3Y_FRAMEWORK_API` 变为 `dllimport`，
  * 导入 `PluginManager` 等类。
  *
+ * 5. 静态链接模式 (`Z3Y_STATIC_PLUGINS`) 下核心库是静态库，`Z3Y_FRAMEWORK_API` 为空。
+ *
  * [受众：插件开发者 和 框架使用者]
  * 你永远不需要关心此文件。它由框架头文件自动包含。
  */
@@ -48,7 +50,10 @@
 #ifndef Z3Y_FRAMEWORK_API_H_
 #define Z3Y_FRAMEWORK_API_H_
 
-#ifdef _WIN32
+#if defined(Z3Y_STATIC_PLUGINS)
+ // 静态链接：没有 DLL 边界
+#define Z3Y_FRAMEWORK_API
+#elif defined(_WIN32)
  // 平台是 Windows
 
  // Z3Y_PLUGIN_MANAGER_AS_DLL 是由 z3y_plugin_manager 自己的 CMakeLists.txt 定义的。
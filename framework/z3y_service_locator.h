@@ -47,8 +47,9 @@
  *
  * [受众：框架维护者]
  * 此文件中的所有函数都是 `inline` 的。
- * 它们内部调用 `PluginManager::GetActiveInstance()` 来获取全局的 `PluginManager`
- * 单例， 然后调用该实例的模板成员函数 (例如 `manager->GetDefaultService<T>()`)。
+ * 它们内部调用 `PluginManager::GetActiveInstance()` 来获取当前线程使用的 `PluginManager`
+ * (全局默认实例，或 `PluginManagerScope` 绑定的独立实例)，
+ * 然后调用该实例的模板成员函数 (例如 `manager->GetDefaultService<T>()`)。
  */
 
 #pragma once
@@ -56,6 +57,7 @@
 #ifndef Z3Y_FRAMEWORK_SERVICE_LOCATOR_H_
 #define Z3Y_FRAMEWORK_SERVICE_LOCATOR_H_
 
+#include <atomic>
 #include <utility>  // 用于 std::pair, std::forward
 #include "framework/i_event_bus.h"   // 依赖 IEventBus (用于事件辅助函数)
 #include "framework/plugin_exceptions.h"  // 依赖 PluginException, InstanceError
@@ -105,7 +107,7 @@ namespace z3y {
      * @throws PluginException 如果别名未找到、CLSID 不是服务、或类型转换失败。
      */
     template <typename T>
-    [[nodiscard]] inline PluginPtr<T> GetService(const std::string& alias) {
+    [[nodiscard]] inline PluginPtr<T> GetService(Alias alias) {
         auto manager = PluginManager::GetActiveInstance();
         if (!manager) {
             throw PluginException(InstanceError::kErrorInternal,
@@ -155,7 +157,7 @@ namespace z3y {
      * @throws PluginException 如果别名未找到、CLSID 不是组件、或类型转换失败。
      */
     template <typename T>
-    [[nodiscard]] inline PluginPtr<T> CreateInstance(const std::string& alias) {
+    [[nodiscard]] inline PluginPtr<T> CreateInstance(Alias alias) {
         auto manager = PluginManager::GetActiveInstance();
         if (!manager) {
             throw PluginException(InstanceError::kErrorInternal,
@@ -226,7 +228,8 @@ namespace z3y {
     template <typename TEvent, typename TSubscriber, typename TCallback>
     [[nodiscard]] inline Connection SubscribeGlobalEvent(
         std::shared_ptr<TSubscriber> subscriber, TCallback&& callback,
-        ConnectionType type = ConnectionType::kDirect) {
+        ConnectionType type = ConnectionType::kDirect,
+        EventPriority priority = EventPriority::kNormal) {
         auto manager = PluginManager::GetActiveInstance();
         if (!manager) {
             throw PluginException(InstanceError::kErrorInternal,
@@ -235,7 +238,7 @@ namespace z3y {
         // [受众：框架维护者] 订阅是关键操作，必须获取 EventBus
         auto bus = manager->GetService<IEventBus>(clsid::kEventBus);
         return bus->SubscribeGlobal<TEvent>(subscriber,
-            std::forward<TCallback>(callback), type);
+            std::forward<TCallback>(callback), type, priority);
     }
 
     /**
@@ -261,6 +264,132 @@ namespace z3y {
         }
     }
 
+    // --- [API 1.5: 缓存句柄 (热路径)] ---
+
+    /**
+     * @class ServiceHandle
+     * @brief [热路径 API] 带线程本地缓存的默认服务查找。
+     *
+     * [受众：插件开发者]
+     * `GetDefaultService<T>()` 每次都要经过：全局单例锁 -> 复制 Manager 的 shared_ptr ->
+     * 两次注册表读锁 -> `std::call_once` -> `QueryInterfaceRaw` 虚调用链。
+     * 对于每个作用域都要取一次服务的场景 (性能剖析、日志宏)，这些开销远大于真正的工作。
+     *
+     * `ServiceHandle<T>::TryGet()` 把查找结果缓存在当前线程中，并用
+     * `PluginManager::GetServiceGeneration()` 与本线程的绑定编号判断缓存是否过期：
+     * 命中时只有一次 relaxed 原子读和一次本线程变量的读取。
+     *
+     * \code{.cpp}
+     * if (auto* profiler = z3y::ServiceHandle<IProfilerService>::TryGet()) {
+     *     profiler->AcquireNode();
+     * }
+     * \endcode
+     *
+     * @warning 返回的是 **非拥有** 的裸指针：它在注册表代数改变 (卸载插件、销毁框架) 之前有效，
+     * 只应在当前调用中临时使用，不要保存。需要长期持有请使用 `GetDefaultService`。
+     *
+     * [受众：框架维护者]
+     * 缓存只有一个代数和一个裸指针，是平凡可析构的：线程退出时不会触碰可能已卸载的插件代码
+     * (这正是跨 DLL `inline thread_local` 持有 shared_ptr 的危险所在)。
+     * “未找到” 的结果同样会被缓存，直到下一次注册表变化。
+     */
+    template <typename T>
+    class ServiceHandle {
+    public:
+        /** @brief 获取默认服务；不存在 (或框架未激活) 时返回 nullptr。不抛出异常。 */
+        [[nodiscard]] static T* TryGet() noexcept {
+            static const std::atomic<uint64_t>& generation = PluginManager::GetServiceGeneration();
+            Cache& cache = ThreadCache();
+            const uint64_t current = generation.load(std::memory_order_relaxed);
+            // 代数从不为 0：首次调用在第一个比较处返回 false，binding_id 此时尚未设置
+            if (cache.generation == current && cache.binding == *cache.binding_id) return cache.service;
+            return Refresh(cache, current);
+        }
+
+        /**
+         * @brief 获取默认服务的引用。
+         * @throws PluginException 服务不存在时抛出 (错误码与 `GetDefaultService` 一致)。
+         */
+        [[nodiscard]] static T& Get() {
+            if (T* service = TryGet()) return *service;
+            throw PluginException(ThreadCache().error, "ServiceHandle: default service unavailable.");
+        }
+
+    private:
+        struct Cache {
+            uint64_t generation = 0;  //!< 0 表示从未查找过
+            uint64_t binding = 0;     //!< 查找时本线程绑定的实例编号
+            const uint64_t* binding_id = nullptr;  //!< 本线程的绑定编号变量 (首次查找时取得)
+            T* service = nullptr;
+            InstanceError error = InstanceError::kErrorInternal;
+        };
+
+        static Cache& ThreadCache() noexcept {
+            static thread_local Cache cache;
+            return cache;
+        }
+
+        /** @brief 慢路径：走一次完整查找。代数在查找 *之前* 读取，查找期间若有变化，下次会再查。 */
+        static T* Refresh(Cache& cache, uint64_t current) noexcept {
+            cache.binding_id = &PluginManager::GetThreadBindingId();
+            cache.binding = *cache.binding_id;
+            auto manager = PluginManager::GetActiveInstance();
+            PluginPtr<T> service;
+            InstanceError error = InstanceError::kErrorInternal;
+            if (manager) {
+                try {
+                    error = InstanceError::kSuccess;
+                    service = manager->TryGetDefaultService<T>(error);
+                } catch (...) {
+                    error = InstanceError::kErrorInternal;
+                }
+            }
+            cache.service = service.get();  // 单例由注册表持有，代数不变期间一直存活
+            cache.error = error;
+            cache.generation = current;
+            return cache.service;
+        }
+    };
+
+    /**
+     * @brief [插件开发者] 获取 *同一模块* 中实现的单例服务的具体类型指针。
+     *
+     * @details
+     * 同一插件内的组件互相调用时，经 `PluginPtr<IInterface>` 的每次调用都是一次虚调用
+     * (`PluginImpl` 还要再经过虚基类 thunk)。如果服务的实现类就在调用方所在的模块里，
+     * 本函数直接返回 `PluginPtr<Impl>`：`Impl` 声明为 `final` (例如使用 `DirectPluginImpl`) 时，
+     * 编译器可以把对它的调用去虚化并内联。
+     *
+     * 服务按 `Impl::kClsid` 查找；实例位于其他模块 (例如另一个插件注册了同一个 CLSID 的实现)
+     * 时返回 nullptr，调用方应退回接口指针。与 `TryGet...` 一样不抛出异常。
+     *
+     * @tparam Impl 服务的实现类 (`PluginImpl` 或 `DirectPluginImpl` 的派生类)。
+     * @return 同一模块中的实例；服务不存在、构造失败或不在本模块时返回 nullptr。
+     *
+     * @example
+     * \code{.cpp}
+     * // 在同一插件的另一个组件中
+     * if (auto cache = z3y::GetLocalService<FrameCache>()) {
+     *     cache->Touch(id);  // FrameCache 为 final：直接调用，可内联
+     * }
+     * \endcode
+     */
+    template <typename Impl>
+    [[nodiscard]] inline PluginPtr<Impl> GetLocalService() noexcept {
+        auto manager = PluginManager::GetActiveInstance();
+        if (!manager) return nullptr;
+        try {
+            InstanceError err = InstanceError::kSuccess;
+            PluginPtr<IComponent> service = manager->TryGetService<IComponent>(Impl::kClsid, err);
+            if (!service) return nullptr;
+            void* self = service->QueryInterfaceRaw(internal::LocalImplKey<Impl>(), 0, 0, err);
+            if (!self) return nullptr;
+            return PluginPtr<Impl>(std::move(service), static_cast<Impl*>(self));
+        } catch (...) {
+            return nullptr;
+        }
+    }
+
     // --- [API 2: 非抛出 (noexcept API)] ---
     // (适用于清理、析构函数和可选依赖)
 
@@ -298,8 +427,11 @@ namespace z3y {
         }
         try {
             // [受众：框架维护者]
-            // 内部仍然调用 *抛出* 版本，但将其捕获并转换为错误码。
-            return { manager->GetDefaultService<T>(), InstanceError::kSuccess };
+            // 走 Manager 的非抛出查找：服务缺失时直接返回错误码，不付出 throw/catch 的代价。
+            // (try 只兜底分配失败等意外异常)
+            InstanceError err = InstanceError::kSuccess;
+            auto service = manager->TryGetDefaultService<T>(err);
+            return { std::move(service), err };
         } catch (const PluginException& e) {
             return { nullptr, e.GetError() };
         } catch (...) {
@@ -316,13 +448,15 @@ namespace z3y {
      */
     template <typename T>
     [[nodiscard]] inline std::pair<PluginPtr<T>, InstanceError> TryGetService(
-        const std::string& alias) noexcept {
+        Alias alias) noexcept {
         auto manager = PluginManager::GetActiveInstance();
         if (!manager) {
             return { nullptr, InstanceError::kErrorInternal };
         }
         try {
-            return { manager->GetService<T>(alias), InstanceError::kSuccess };
+            InstanceError err = InstanceError::kSuccess;
+            auto service = manager->TryGetService<T>(alias, err);
+            return { std::move(service), err };
         } catch (const PluginException& e) {
             return { nullptr, e.GetError() };
         } catch (...) {
@@ -345,7 +479,9 @@ namespace z3y {
             return { nullptr, InstanceError::kErrorInternal };
         }
         try {
-            return { manager->GetService<T>(clsid), InstanceError::kSuccess };
+            InstanceError err = InstanceError::kSuccess;
+            auto service = manager->TryGetService<T>(clsid, err);
+            return { std::move(service), err };
         } catch (const PluginException& e) {
             return { nullptr, e.GetError() };
         } catch (...) {
@@ -384,7 +520,7 @@ namespace z3y {
      */
     template <typename T>
     [[nodiscard]] inline std::pair<PluginPtr<T>, InstanceError> TryCreateInstance(
-        const std::string& alias) noexcept {
+        Alias alias) noexcept {
         auto manager = PluginManager::GetActiveInstance();
         if (!manager) {
             return { nullptr, InstanceError::kErrorInternal };
@@ -473,7 +609,8 @@ namespace z3y {
     [[nodiscard]] inline std::pair<Connection, InstanceError>
         TrySubscribeGlobalEvent(std::shared_ptr<TSubscriber> subscriber,
             TCallback&& callback,
-            ConnectionType type = ConnectionType::kDirect) noexcept {
+            ConnectionType type = ConnectionType::kDirect,
+            EventPriority priority = EventPriority::kNormal) noexcept {
         auto manager = PluginManager::GetActiveInstance();
         if (!manager) {
             return { z3y::Connection{}, InstanceError::kErrorInternal };
@@ -484,7 +621,7 @@ namespace z3y {
                 return { z3y::Connection{}, InstanceError::kErrorInternal };
             }
             return { bus->SubscribeGlobal<TEvent>(
-                        subscriber, std::forward<TCallback>(callback), type),
+                        subscriber, std::forward<TCallback>(callback), type, priority),
                     InstanceError::kSuccess };
         } catch (const PluginException& e) {
             return { z3y::Connection{}, e.GetError() };
@@ -87,6 +87,12 @@
  * (销毁`PluginManager` 自身，停止 `EventLoop` 线程)
  *
  *
+ * [soak 模式]
+ * `host_console_demo --soak [选项]` 在第 5 步之后用 `RunSoak` 代替第 6 ~ 7 步：
+ * 按固定速率长时间驱动已加载的插件，并周期性打印吞吐、耗时分位数、RSS 与各容器规模
+ * (见 soak_runner.h)。清理步骤不变。
+ *
+ *
  * [设计总结]
  * 这种设计使得 `main.cpp` 非常简洁，
  * 并且与所有具体的“功能” 插件
@@ -99,8 +105,9 @@
 // 2. 包含宿主 *唯一* 依赖的业务接口
 #include "interfaces_demo/i_demo_runner.h"
 #include "interfaces_demo/i_demo_logger.h"
-// 3. 包含宿主自己的事件监听器
+// 3. 包含宿主自己的事件监听器与 soak 模式
 #include "host_event_listener.h"
+#include "soak_runner.h"
 
 // 4. C++ StdLib
 #include <filesystem>  // [C++17]
@@ -148,6 +155,18 @@ int main(int argc, char* argv[]) {
     std::cout << "--- z3y C++ Plugin Framework Host Demo (Modular) ---"
         << std::endl;
 
+    // soak 模式的参数在创建框架之前校验，写错时直接退出
+    const bool soak_mode = z3y::demo::IsSoakRequested(argc, argv);
+    z3y::demo::SoakOptions soak_options;
+    if (soak_mode) {
+        std::string soak_error;
+        if (!z3y::demo::ParseSoakOptions(argc, argv, soak_options, soak_error)) {
+            std::cerr << "[Host] " << soak_error << "\n" << z3y::demo::SoakUsage();
+            return 2;
+        }
+    }
+    int exit_code = 0;
+
     // 1. [核心] 顶层 try...catch 块
     try {
         // 2. [启动] 创建 PluginManager
@@ -183,39 +202,44 @@ int main(int argc, char* argv[]) {
 
         std::cout << "[Host] All plugins loaded." << std::endl;
 
-        // 7. [核心] 获取“Demo日志”服务
-        std::cout << "\n[Host] Getting Demo Logger Service..." << std::endl;
-        auto logger = z3y::GetDefaultService<z3y::demo::IDemoLogger>();
-        logger->Log("Host acquired demo logger service!");
+        if (soak_mode) {
+            // [soak] 替代演示流程；返回前已释放所有服务引用
+            exit_code = z3y::demo::RunSoak(soak_options);
+        } else {
+            // 7. [核心] 获取“Demo日志”服务
+            std::cout << "\n[Host] Getting Demo Logger Service..." << std::endl;
+            auto logger = z3y::GetDefaultService<z3y::demo::IDemoLogger>();
+            logger->Log("Host acquired demo logger service!");
 
-        // 8. [核心] 获取“Demo执行”服务
-        std::cout << "\n[Host] Getting Demo Runner Service..." << std::endl;
-        z3y::PluginPtr<z3y::demo::IDemoRunner> demo_runner;
+            // 8. [核心] 获取“Demo执行”服务
+            std::cout << "\n[Host] Getting Demo Runner Service..." << std::endl;
+            z3y::PluginPtr<z3y::demo::IDemoRunner> demo_runner;
 
-        try {
-            // [设计]
-            // 宿主只依赖 `IDemoRunner` 的“默认” 实现。
-            demo_runner = z3y::GetDefaultService<z3y::demo::IDemoRunner>();
-        } catch (const z3y::PluginException& e) {
-            // [健壮性]
-            // 如果 `IDemoRunner` (核心业务) 都获取失败，
-            // 这是一个致命错误，程序无法继续。
-            logger->Log("[Host] [FATAL] Failed to get required IDemoRunner service: " + std::string(e.what()));
-            manager.reset();  // 触发析构
-            return 1;
-        }
+            try {
+                // [设计]
+                // 宿主只依赖 `IDemoRunner` 的“默认” 实现。
+                demo_runner = z3y::GetDefaultService<z3y::demo::IDemoRunner>();
+            } catch (const z3y::PluginException& e) {
+                // [健壮性]
+                // 如果 `IDemoRunner` (核心业务) 都获取失败，
+                // 这是一个致命错误，程序无法继续。
+                logger->Log("[Host] [FATAL] Failed to get required IDemoRunner service: " + std::string(e.what()));
+                manager.reset();  // 触发析构
+                return 1;
+            }
 
-        // 9. [核心] 执行所有模块化测试
-        std::cout << "\n[Host] Telling Demo Runner to execute all demo modules..."
-            << std::endl;
-        demo_runner->RunAllDemos();
-        std::cout << "[Host] Demo Runner finished." << std::endl;
+            // 9. [核心] 执行所有模块化测试
+            std::cout << "\n[Host] Telling Demo Runner to execute all demo modules..."
+                << std::endl;
+            demo_runner->RunAllDemos();
+            std::cout << "[Host] Demo Runner finished." << std::endl;
 
-        // 10. [!! 关键：安全清理 !!]
-        std::cout << "\n[Host] Releasing services..." << std::endl;
-        // a. 释放对插件服务的`PluginPtr` 引用 (LIFO 顺序)
-        demo_runner.reset();
-        logger.reset();
+            // 10. [!! 关键：安全清理 !!]
+            std::cout << "\n[Host] Releasing services..." << std::endl;
+            // a. 释放对插件服务的`PluginPtr` 引用 (LIFO 顺序)
+            demo_runner.reset();
+            logger.reset();
+        }
         // b. 释放监听器
         host_listener.reset();
 
@@ -255,5 +279,5 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
-    return 0;
+    return exit_code;
 }
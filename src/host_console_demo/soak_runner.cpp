@@ -0,0 +1,557 @@
+﻿/*
+* Copyright [2025] [Yue Liu]
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/**
+ * @file soak_runner.cpp
+ * @brief [宿主] soak 模式的实现 (见 soak_runner.h)。
+ */
+
+#include "soak_runner.h"
+
+#include "framework/z3y_framework.h"
+#include "interfaces_core/i_config_service.h"
+#include "interfaces_core/i_log_service.h"
+#include "interfaces_core/z3y_log_macros.h"
+#include "interfaces_profiler/i_profiler_service.h"
+#include "interfaces_profiler/profiler_macros.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <psapi.h>
+#elif defined(__linux__)
+#include <unistd.h>
+#endif
+
+namespace z3y {
+    namespace demo {
+        namespace {
+
+            using Clock = std::chrono::steady_clock;
+            using z3y::interfaces::core::IConfigService;
+            using z3y::interfaces::core::ILogger;
+            using z3y::interfaces::core::ILogManagerService;
+            using z3y::interfaces::profiler::IProfilerService;
+
+            constexpr const char* kConfigPath = "Soak.Counter";
+
+            std::atomic<bool> g_stop{ false };
+            void OnInterrupt(int) { g_stop.store(true); }
+
+            /** @brief soak 专用事件，只在宿主内发布与订阅。 */
+            struct SoakEvent : public z3y::Event {
+                Z3Y_DEFINE_EVENT(SoakEvent, "z3y-host-soak-evt-001");
+                uint64_t seq;
+                explicit SoakEvent(uint64_t s) : seq(s) {}
+            };
+
+            /** @brief SoakEvent 的 kQueued 订阅者，只计数。 */
+            class SoakEventSink : public std::enable_shared_from_this<SoakEventSink> {
+            public:
+                std::atomic<uint64_t> received{ 0 };
+                void OnEvent(const SoakEvent&) {
+                    received.fetch_add(1, std::memory_order_relaxed);
+                }
+            };
+
+            /**
+             * @brief 一类定速负载：一个驱动线程按 rate 调用 op，记录每次调用的耗时。
+             * @details op 返回 false 计为失败 (例如服务查找失败)。
+             */
+            class Workload {
+            public:
+                struct Window {
+                    LatencyHistogram hist;
+                    uint64_t failures = 0;
+                    uint64_t lag = 0;
+                };
+
+                Workload(std::string name, double rate, std::function<bool()> op)
+                    : name_(std::move(name)), rate_(rate), op_(std::move(op)) {}
+                ~Workload() { Stop(); }
+
+                void Start() { thread_ = std::thread(&Workload::Run, this); }
+                void Stop() {
+                    stop_.store(true);
+                    if (thread_.joinable()) thread_.join();
+                }
+
+                /** @brief 取走本报告周期的统计并清零。 */
+                Window TakeWindow() {
+                    std::lock_guard lock(mutex_);
+                    Window out = window_;
+                    window_ = Window{};
+                    return out;
+                }
+
+                const std::string& name() const { return name_; }
+
+            private:
+                void Run() {
+                    const auto start = Clock::now();
+                    // 落后超过 1 秒的部分不再追赶，计入 lag
+                    const auto backlog_cap = static_cast<uint64_t>(std::max(1.0, rate_));
+                    uint64_t issued = 0;
+                    while (!stop_.load(std::memory_order_relaxed)) {
+                        const double elapsed =
+                            std::chrono::duration<double>(Clock::now() - start).count();
+                        const auto due = static_cast<uint64_t>(elapsed * rate_);
+                        if (due > issued + backlog_cap) {
+                            std::lock_guard lock(mutex_);
+                            window_.lag += due - issued - backlog_cap;
+                            issued = due - backlog_cap;
+                        }
+                        for (; issued < due && !stop_.load(std::memory_order_relaxed); ++issued) {
+                            const auto t0 = Clock::now();
+                            const bool ok = op_();
+                            const auto ns = static_cast<uint64_t>(
+                                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                    Clock::now() - t0).count());
+                            std::lock_guard lock(mutex_);
+                            auto& hist = window_.hist;
+                            ++hist.buckets[LatencyHistogram::BucketOf(ns)];
+                            ++hist.count;
+                            hist.total_ns += ns;
+                            hist.max_ns = std::max(hist.max_ns, ns);
+                            if (!ok) ++window_.failures;
+                        }
+                        // 睡到下一次到期，最长 10ms (保证及时响应停止)
+                        const double next_s = static_cast<double>(issued + 1) / rate_;
+                        const double wait_s = std::clamp(
+                            next_s - std::chrono::duration<double>(Clock::now() - start).count(),
+                            0.0, 0.010);
+                        std::this_thread::sleep_for(std::chrono::duration<double>(wait_s));
+                    }
+                }
+
+                std::string name_;
+                double rate_;
+                std::function<bool()> op_;
+                std::atomic<bool> stop_{ false };
+                std::thread thread_;
+                std::mutex mutex_;
+                Window window_;
+            };
+
+            /** @brief 一次采样得到的进程与各容器规模。 */
+            struct ContainerSnapshot {
+                uint64_t rss_bytes = 0;
+                size_t subscribers = 0;
+                size_t queue_depth = 0;
+                size_t queue_high_water = 0;
+                size_t framework_bytes = 0;
+                size_t pool_bytes = 0;
+                bool has_profiler = false;
+                uint64_t profiler_nodes = 0;
+                uint64_t profiler_node_bytes = 0;
+                uint64_t profiler_histograms = 0;
+                uint64_t profiler_keyed_roots = 0;
+                bool has_logger = false;
+                uint64_t loggers = 0;
+                uint64_t log_queued = 0;
+                uint64_t log_capacity = 0;
+                uint64_t log_dropped = 0;
+            };
+
+            /** @brief 当前进程的常驻内存 (字节)；不支持的平台返回 0。 */
+            uint64_t ReadRssBytes() {
+#ifdef _WIN32
+                PROCESS_MEMORY_COUNTERS counters{};
+                if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+                    return counters.WorkingSetSize;
+                }
+                return 0;
+#elif defined(__linux__)
+                std::ifstream statm("/proc/self/statm");
+                uint64_t total_pages = 0, resident_pages = 0;
+                if (!(statm >> total_pages >> resident_pages)) return 0;
+                return resident_pages * static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+#else
+                return 0;
+#endif
+            }
+
+            ContainerSnapshot SampleContainers() {
+                ContainerSnapshot snap;
+                snap.rss_bytes = ReadRssBytes();
+                if (auto manager = PluginManager::GetActiveInstance()) {
+                    const EventDispatchMetrics metrics = manager->GetEventDispatchMetrics();
+                    snap.subscribers = metrics.subscribers.size();
+                    snap.queue_depth = metrics.queue_depth;
+                    snap.queue_high_water = metrics.queue_high_water;
+                    // 分配统计只能经由 IAllocatorService 读取 (PluginManager 上为受保护成员)
+                    auto alloc = z3y::GetService<IAllocatorService>(clsid::kAllocator);
+                    const AllocatorStats stats = alloc->GetAllocatorStats();
+                    snap.framework_bytes = stats.framework_bytes;
+                    snap.pool_bytes = stats.pool_bytes;
+                }
+                if (auto [profiler, err] = z3y::TryGetDefaultService<IProfilerService>();
+                    err == InstanceError::kSuccess && profiler) {
+                    const auto mem = profiler->GetMemoryStats();
+                    snap.has_profiler = true;
+                    snap.profiler_nodes = mem.nodes_in_use;
+                    snap.profiler_node_bytes = mem.node_bytes;
+                    snap.profiler_histograms = mem.histograms;
+                    snap.profiler_keyed_roots = mem.keyed_roots;
+                }
+                if (auto [log_mgr, err] = z3y::TryGetDefaultService<ILogManagerService>();
+                    err == InstanceError::kSuccess && log_mgr) {
+                    const auto stats = log_mgr->GetQueueStats();
+                    snap.has_logger = true;
+                    snap.loggers = stats.loggers;
+                    snap.log_queued = stats.queued;
+                    snap.log_capacity = stats.capacity;
+                    snap.log_dropped = stats.overrun + stats.discarded;
+                }
+                return snap;
+            }
+
+            std::string FormatNs(uint64_t ns) {
+                char buf[32];
+                if (ns < 1000) {
+                    std::snprintf(buf, sizeof(buf), "%lluns", static_cast<unsigned long long>(ns));
+                } else if (ns < 1000000) {
+                    std::snprintf(buf, sizeof(buf), "%.1fus", static_cast<double>(ns) / 1e3);
+                } else {
+                    std::snprintf(buf, sizeof(buf), "%.2fms", static_cast<double>(ns) / 1e6);
+                }
+                return buf;
+            }
+
+            std::string FormatBytes(uint64_t bytes) {
+                char buf[32];
+                if (bytes < 1024 * 1024) {
+                    std::snprintf(buf, sizeof(buf), "%.1fKiB", static_cast<double>(bytes) / 1024.0);
+                } else {
+                    std::snprintf(buf, sizeof(buf), "%.1fMiB",
+                        static_cast<double>(bytes) / (1024.0 * 1024.0));
+                }
+                return buf;
+            }
+
+            /** @brief 带符号的增长量，用于结束时的对比。 */
+            std::string FormatDelta(uint64_t before, uint64_t after) {
+                const long long delta =
+                    static_cast<long long>(after) - static_cast<long long>(before);
+                return (delta > 0 ? "+" : "") + std::to_string(delta);
+            }
+
+            void PrintContainers(const ContainerSnapshot& snap) {
+                std::cout << "  containers: rss=" << FormatBytes(snap.rss_bytes)
+                    << " subscribers=" << snap.subscribers
+                    << " event_queue=" << snap.queue_depth
+                    << " (high water " << snap.queue_high_water << ")"
+                    << " framework_pool=" << FormatBytes(snap.framework_bytes)
+                    << " pool=" << FormatBytes(snap.pool_bytes) << "\n";
+                if (snap.has_profiler) {
+                    std::cout << "              profiler_nodes=" << snap.profiler_nodes
+                        << " (" << FormatBytes(snap.profiler_node_bytes) << ")"
+                        << " histograms=" << snap.profiler_histograms
+                        << " keyed_roots=" << snap.profiler_keyed_roots << "\n";
+                }
+                if (snap.has_logger) {
+                    std::cout << "              loggers=" << snap.loggers
+                        << " log_queue=" << snap.log_queued << "/" << snap.log_capacity
+                        << " log_dropped=" << snap.log_dropped << "\n";
+                }
+            }
+
+            /** @brief 模拟一段有两个阶段的周期任务。 */
+            void ProfiledStep(uint64_t seq) {
+                Z3Y_PROFILE_ROOT("Soak_Step", 10000, 0.0);
+                volatile uint64_t sink = seq;
+                {
+                    Z3Y_PROFILE_NAMED("Soak_Prepare");
+                    for (int i = 0; i < 64; ++i) sink = sink * 31 + i;
+                }
+                {
+                    Z3Y_PROFILE_NAMED("Soak_Compute");
+                    for (int i = 0; i < 256; ++i) sink = sink * 131 + i;
+                }
+            }
+
+            /** @brief 生成只写文件的日志配置 (soak 日志量大，写控制台会淹没报告)。 */
+            std::string WriteDefaultLogConfig(const std::filesystem::path& dir) {
+                const std::filesystem::path path = dir / "soak_logger_config.json";
+                std::ofstream out(path);
+                out << R"({
+    "global_settings": {
+        "format_pattern": "[%Y-%m-%d %H:%M:%S.%e] [%n] [%l] %v",
+        "async_queue_size": 8192,
+        "flush_interval_seconds": 1
+    },
+    "sinks": {
+        "soak_file": {
+            "type": "rotating_file_sink",
+            "base_name": "soak.log",
+            "max_size": 10485760,
+            "max_files": 3,
+            "level": "info"
+        }
+    },
+    "default_rule": {
+        "sinks": ["soak_file"]
+    }
+})";
+                return out ? path.string() : std::string();
+            }
+
+            bool ParseRate(const std::string& text, double& value) {
+                char* end = nullptr;
+                const double parsed = std::strtod(text.c_str(), &end);
+                if (end == text.c_str() || *end != '\0' || !(parsed >= 0.0)) return false;
+                value = parsed;
+                return true;
+            }
+
+        }  // namespace
+
+        bool IsSoakRequested(int argc, char* argv[]) {
+            for (int i = 1; i < argc; ++i) {
+                if (std::string(argv[i]) == "--soak") return true;
+            }
+            return false;
+        }
+
+        const char* SoakUsage() {
+            return "Usage: host_console_demo --soak [--duration-s=N] [--report-s=N]\n"
+                "         [--event-rate=N] [--lookup-rate=N] [--config-rate=N]\n"
+                "         [--log-rate=N] [--profile-rate=N] [--log-config=PATH]\n"
+                "  Rates are operations per second (0 disables a workload).\n"
+                "  --duration-s=0 runs until Ctrl+C.\n";
+        }
+
+        bool ParseSoakOptions(int argc, char* argv[], SoakOptions& options,
+            std::string& error) {
+            struct RateFlag {
+                const char* name;
+                double* value;
+            };
+            const RateFlag flags[] = {
+                {"--duration-s", &options.duration_s},
+                {"--report-s", &options.report_s},
+                {"--event-rate", &options.event_rate},
+                {"--lookup-rate", &options.lookup_rate},
+                {"--config-rate", &options.config_rate},
+                {"--log-rate", &options.log_rate},
+                {"--profile-rate", &options.profile_rate},
+            };
+            for (int i = 1; i < argc; ++i) {
+                const std::string arg = argv[i];
+                if (arg == "--soak") continue;
+                const size_t eq = arg.find('=');
+                const std::string key = arg.substr(0, eq);
+                const std::string value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+                if (key == "--log-config") {
+                    options.log_config = value;
+                    continue;
+                }
+                auto it = std::find_if(std::begin(flags), std::end(flags),
+                    [&key](const RateFlag& f) { return key == f.name; });
+                if (it == std::end(flags)) {
+                    error = "unknown option: " + arg;
+                    return false;
+                }
+                if (!ParseRate(value, *it->value)) {
+                    error = "invalid value for " + key + ": '" + value + "'";
+                    return false;
+                }
+            }
+            if (options.report_s <= 0.0) {
+                error = "--report-s must be positive";
+                return false;
+            }
+            return true;
+        }
+
+        int RunSoak(const SoakOptions& options) {
+            g_stop.store(false);
+            const auto previous_handler = std::signal(SIGINT, OnInterrupt);
+            const std::filesystem::path exe_dir = z3y::utils::GetExecutableDir();
+
+            // 1. 准备各负载依赖的服务 (缺失的插件对应的负载跳过)
+            auto [log_mgr, log_err] = z3y::TryGetDefaultService<ILogManagerService>();
+            PluginPtr<ILogger> logger;
+            if (log_err == InstanceError::kSuccess && log_mgr) {
+                const std::string log_config = options.log_config.empty()
+                    ? WriteDefaultLogConfig(exe_dir)
+                    : options.log_config;
+                const std::string log_dir = (exe_dir / "logs").string();
+                if (!log_mgr->InitializeService(log_config, log_dir)) {
+                    std::cerr << "[Soak] Logger initialization failed (" << log_config
+                        << "), logging to console." << std::endl;
+                }
+                logger = log_mgr->GetLogger("Soak");
+            }
+
+            PluginPtr<IConfigService> config;
+            if (auto [svc, err] = z3y::TryGetDefaultService<IConfigService>();
+                err == InstanceError::kSuccess && svc) {
+                config = svc;
+                // 独立的存储文件，不覆盖演示用的配置
+                config->SetStoragePath((exe_dir / "soak_config.json").string());
+                config->Builder<int>(kConfigPath).Default(0).RegisterOnly();
+            }
+
+            auto bus = z3y::GetService<IEventBus>(clsid::kEventBus);
+            auto sink = std::make_shared<SoakEventSink>();
+            ScopedConnection event_conn = bus->SubscribeGlobal<SoakEvent>(
+                sink, &SoakEventSink::OnEvent, ConnectionType::kQueued);
+
+            // 2. 组装负载
+            std::vector<std::unique_ptr<Workload>> workloads;
+            std::atomic<uint64_t> event_seq{ 0 };
+            std::atomic<uint64_t> config_seq{ 0 };
+            std::atomic<uint64_t> log_seq{ 0 };
+            std::atomic<uint64_t> profile_seq{ 0 };
+            auto add = [&](const char* name, double rate, std::function<bool()> op,
+                bool available) {
+                if (rate <= 0.0) return;
+                if (!available) {
+                    std::cout << "[Soak] Skipping '" << name << "': service not loaded."
+                        << std::endl;
+                    return;
+                }
+                workloads.push_back(std::make_unique<Workload>(name, rate, std::move(op)));
+            };
+            add("events", options.event_rate, [&] {
+                bus->FireGlobal<SoakEvent>(event_seq.fetch_add(1));
+                return true;
+            }, true);
+            add("lookups", options.lookup_rate, [] {
+                auto [svc, err] = z3y::TryGetDefaultService<IConfigService>();
+                return err == InstanceError::kSuccess && svc;
+            }, config != nullptr);
+            add("config", options.config_rate, [&] {
+                return config->SetValue(kConfigPath,
+                    static_cast<int64_t>(config_seq.fetch_add(1) % 1000000));
+            }, config != nullptr);
+            add("logs", options.log_rate, [&] {
+                Z3Y_LOG_INFO(logger, "soak tick {}", log_seq.fetch_add(1));
+                return true;
+            }, logger != nullptr);
+            add("profile", options.profile_rate, [&] {
+                ProfiledStep(profile_seq.fetch_add(1));
+                return true;
+            }, true);
+
+            std::cout << "\n[Soak] Running " << workloads.size() << " workloads, report every "
+                << options.report_s << "s, ";
+            if (options.duration_s > 0.0) {
+                std::cout << options.duration_s << "s total" << std::endl;
+            } else {
+                std::cout << "until Ctrl+C" << std::endl;
+            }
+
+            const ContainerSnapshot baseline = SampleContainers();
+            for (auto& w : workloads) w->Start();
+
+            // 3. 报告循环
+            const auto start = Clock::now();
+            auto next_report = start;
+            uint64_t last_received = 0;
+            const auto report_period = std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>(options.report_s));
+            ContainerSnapshot first_report{};
+            bool has_first_report = false;
+            ContainerSnapshot last{};
+            while (!g_stop.load()) {
+                next_report += report_period;
+                const auto deadline = options.duration_s > 0.0
+                    ? start + std::chrono::duration_cast<Clock::duration>(
+                        std::chrono::duration<double>(options.duration_s))
+                    : Clock::time_point::max();
+                const auto wake = std::min(next_report, deadline);
+                while (!g_stop.load() && Clock::now() < wake) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                }
+                const bool finished = g_stop.load() || Clock::now() >= deadline;
+
+                const double window_s = std::chrono::duration<double>(report_period).count();
+                const double uptime_s = std::chrono::duration<double>(Clock::now() - start).count();
+                char head[64];
+                std::snprintf(head, sizeof(head), "[Soak] t=%.0fs", uptime_s);
+                std::cout << "\n" << head << "\n";
+                for (auto& w : workloads) {
+                    const Workload::Window win = w->TakeWindow();
+                    char line[128];
+                    std::snprintf(line, sizeof(line), "  %-8s %10.1f/s", w->name().c_str(),
+                        static_cast<double>(win.hist.count) / window_s);
+                    std::cout << line << "  p50=" << FormatNs(win.hist.PercentileNs(0.5))
+                        << " p99=" << FormatNs(win.hist.PercentileNs(0.99))
+                        << " max=" << FormatNs(win.hist.max_ns);
+                    if (win.failures) std::cout << " failures=" << win.failures;
+                    if (win.lag) std::cout << " lag=" << win.lag;
+                    std::cout << "\n";
+                }
+                const uint64_t received = sink->received.load();
+                std::cout << "  delivered " << (received - last_received)
+                    << " queued events\n";
+                last_received = received;
+                last = SampleContainers();
+                PrintContainers(last);
+                std::cout << std::flush;
+                // 第一次报告时各缓存已经热身，以它作为增长对比的起点
+                if (!has_first_report) {
+                    first_report = last;
+                    has_first_report = true;
+                }
+                if (finished) break;
+            }
+
+            // 4. 停止并打印增长 (相对第一次报告)
+            for (auto& w : workloads) w->Stop();
+            workloads.clear();
+            const ContainerSnapshot& from = has_first_report ? first_report : baseline;
+            std::cout << "\n[Soak] Growth since first report: rss "
+                << FormatDelta(from.rss_bytes, last.rss_bytes) << " bytes, subscribers "
+                << FormatDelta(from.subscribers, last.subscribers) << ", framework_pool "
+                << FormatDelta(from.framework_bytes, last.framework_bytes) << " bytes";
+            if (last.has_profiler) {
+                std::cout << ", profiler_nodes "
+                    << FormatDelta(from.profiler_nodes, last.profiler_nodes);
+            }
+            if (last.has_logger) {
+                std::cout << ", loggers " << FormatDelta(from.loggers, last.loggers);
+            }
+            std::cout << std::endl;
+
+            // 5. 释放从插件取得的一切，交还 main 做卸载
+            event_conn.Disconnect();
+            bus.reset();
+            config.reset();
+            logger.reset();
+            if (log_mgr) log_mgr->Flush();
+            log_mgr.reset();
+            std::signal(SIGINT, previous_handler);
+            return 0;
+        }
+
+    }  // namespace demo
+}  // namespace z3y
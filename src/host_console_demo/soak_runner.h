@@ -0,0 +1,85 @@
+﻿/*
+* Copyright [2025] [Yue Liu]
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/**
+ * @file soak_runner.h
+ * @brief [宿主] 压测 / 长稳 (soak) 模式：按固定速率驱动已加载的插件。
+ *
+ * @details
+ * [受众：框架维护者 (性能与内存回归)]
+ *
+ * `host_console_demo --soak [选项]` 不再运行演示，而是为每类负载启动一个定速线程：
+ * - events：向本模块定义的 SoakEvent 发布事件 (一个 kQueued 订阅者计数)；
+ * - lookups：按默认别名查找 IConfigService；
+ * - config：写入 `Soak.Counter`；
+ * - logs：向名为 "Soak" 的 Logger 写 Info 日志；
+ * - profile：执行一个带两个子阶段的 Z3Y_PROFILE_ROOT。
+ *
+ * 每个报告周期打印各负载的吞吐与 p50 / p99 / max 耗时 (调用方视角)，
+ * 以及 RSS 和各容器的规模：订阅表、事件队列积压、分析器节点、Logger 缓存、日志队列、
+ * 框架内存池。结束时打印这些规模相对预热后的增长，用来发现无界增长的表。
+ *
+ * 速率为 0 的负载不启动；对应插件没有加载的负载自动跳过。
+ * 速率跟不上时不追赶超过 1 秒的积压，落下的次数记为 lag。
+ */
+
+#ifndef Z3Y_HOST_CONSOLE_DEMO_SOAK_RUNNER_H_
+#define Z3Y_HOST_CONSOLE_DEMO_SOAK_RUNNER_H_
+
+#include <string>
+
+namespace z3y {
+    namespace demo {
+
+        /**
+         * @brief soak 模式的命令行参数。速率单位均为 次/秒。
+         */
+        struct SoakOptions {
+            double duration_s = 0.0;    //!< --duration-s   运行时长，0 表示直到 Ctrl+C
+            double report_s = 10.0;     //!< --report-s     报告周期
+            double event_rate = 1000.0;  //!< --event-rate
+            double lookup_rate = 1000.0; //!< --lookup-rate
+            double config_rate = 50.0;   //!< --config-rate
+            double log_rate = 200.0;     //!< --log-rate
+            double profile_rate = 500.0; //!< --profile-rate
+            //! --log-config  日志配置文件；为空时生成一份只写文件的配置，避免刷屏
+            std::string log_config;
+        };
+
+        /** @brief 命令行中是否带有 `--soak`。 */
+        bool IsSoakRequested(int argc, char* argv[]);
+
+        /**
+         * @brief 解析 `--soak` 之外的 soak 参数 (`--name=value` 形式)。
+         * @return false 时 error 给出原因。
+         */
+        bool ParseSoakOptions(int argc, char* argv[], SoakOptions& options,
+            std::string& error);
+
+        /** @brief 参数说明，用于解析失败时打印。 */
+        const char* SoakUsage();
+
+        /**
+         * @brief 运行 soak 直到时长用完或收到 Ctrl+C。
+         * @details 须在插件加载之后、卸载之前调用；返回前释放所有从插件取得的服务。
+         * @return 进程退出码 (0 = 正常结束)。
+         */
+        int RunSoak(const SoakOptions& options);
+
+    }  // namespace demo
+}  // namespace z3y
+
+#endif  // Z3Y_HOST_CONSOLE_DEMO_SOAK_RUNNER_H_
@@ -20,13 +20,20 @@
 #ifndef Z3Y_CONFIG_TYPES_H_
 #define Z3Y_CONFIG_TYPES_H_
 
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <functional>
 #include <map>
 #include <memory>
 #include <string>
+#include <type_traits>
 #include <variant>
 #include <vector>
 
+#include <nlohmann/json.hpp>
+
 #include "framework/z3y_define_impl.h"
 
 namespace z3y {
@@ -61,21 +68,130 @@ enum class WidgetType {
   kCustom         /**< 自定义UI逃生舱：交由前台注册的闭包工厂进行专属渲染 */
 };
 
+/**
+ * @brief 把 ConfigValue 渲染为 JSON 文本 (monostate 为 "null")，与落盘文件的格式一致。
+ */
+inline std::string ConfigValueToJsonText(const ConfigValue& value) {
+  return std::visit(
+      [](const auto& v) -> std::string {
+        using T = std::decay_t<decltype(v)>;
+        if constexpr (std::is_same_v<T, std::monostate>) {
+          return "null";
+        } else {
+          return nlohmann::json(v).dump();
+        }
+      },
+      value);
+}
+
 /**
  * @brief 配置变更审计事件 (Audit Trail Event)
  * @details
  * 当配置被合法修改并实质生效时，将由 ConfigService 广播此事件。
  * 日志插件或云端同步插件可以订阅 "System.Config.Changed" 主题，
  * 将此事件持久化到防篡改数据库中，实现企业级操作留痕。
+ * - 新旧值以强类型、共享只读的形式携带，拷贝事件 (kQueued 订阅) 不复制值本身；
+ * 需要文本时调用 OldValueJson / NewValueJson 按需渲染。
+ * - 一次事务 (ApplyChanges、ActivateOverlay、ReloadFromFile) 的全部变更经
+ * FireGlobalBatch 一次发布：逐条订阅者照常收到每一条，
+ * SubscribeGlobalBatch 订阅者每个事务只回调一次。
+ * - 没有任何订阅者时服务不构造事件。
  */
 struct ConfigChangedEvent : public z3y::Event {
   Z3Y_DEFINE_EVENT(ConfigChangedEvent, "z3y-evt-ConfigChangedEvent-001");
   std::string path;      /**< 被修改的配置路径 (如 "Camera.Exposure") */
-  std::string old_value; /**< 修改前的旧值 (已序列化为 JSON 字符串形式) */
-  std::string new_value; /**< 修改后的新值 (已序列化为 JSON 字符串形式) */
+  std::shared_ptr<const ConfigValue> old_value; /**< 修改前的旧值 */
+  std::shared_ptr<const ConfigValue> new_value; /**< 修改后的新值 */
   std::string
       operator_role;     /**< 发起修改的操作人角色 (如 "Admin", "Operator") */
-  uint64_t timestamp_ms; /**< 修改发生时的毫秒级系统时间戳 */
+  uint64_t timestamp_ms = 0; /**< 修改发生时的毫秒级系统时间戳 */
+
+  /** @brief 旧值的 JSON 文本 (如 "100"、"\"auto\"")。 */
+  std::string OldValueJson() const {
+    return old_value ? ConfigValueToJsonText(*old_value) : "null";
+  }
+  /** @brief 新值的 JSON 文本。 */
+  std::string NewValueJson() const {
+    return new_value ? ConfigValueToJsonText(*new_value) : "null";
+  }
+};
+
+/**
+ * @brief 监视参数的无锁值单元 (SchemaMetadata::is_monitor，见 IConfigService::GetMonitorCell)。
+ * @details
+ * 采集线程以 kHz 频率刷新的运行状态 (进度、温度、计数) 不值得每次都走节点写锁、
+ * 审计事件与事件总线。监视参数的值只存放在这个单元里：写入方 Publish 一次原子存储，
+ * 界面按自己的刷新率比较 Version，变了才 Load。
+ * - 只支持 int64 / double / bool，类型在注册时由默认值确定，Publish 按该类型转换。
+ * - 值与版本各是一个 64 位原子量：读者可能看到比版本号更新的值，但不会读到撕裂的值。
+ * - Publish 不做 Min/Max 校验、不触发订阅回调与 ConfigChangedEvent，也不落盘。
+ */
+class ConfigMonitorCell {
+ public:
+  /** @param initial 初始值，其类型即单元的类型 (必须是 int64 / double / bool)。 */
+  explicit ConfigMonitorCell(const ConfigValue& initial)
+      : tag_(static_cast<uint8_t>(initial.index())) {
+    PublishValue(initial);
+    version_.store(0, std::memory_order_relaxed);
+  }
+
+  /** @brief 与 ConfigValue::index() 相同的类型序号。 */
+  size_t index() const noexcept { return tag_; }
+
+  /** @brief 发布一个数值 (整数、浮点或 bool)，按单元的类型转换后存储。 */
+  template <typename T, typename = std::enable_if_t<std::is_arithmetic_v<T>>>
+  void Publish(T value) noexcept {
+    if (tag_ == 2) {
+      Store(static_cast<double>(value));
+    } else if (tag_ == 3) {
+      Store(uint64_t{value != T{}});
+    } else {
+      Store(static_cast<uint64_t>(static_cast<int64_t>(value)));
+    }
+  }
+  /** @brief 发布一个 ConfigValue；不是标量时忽略并返回 false。 */
+  bool PublishValue(const ConfigValue& value) noexcept {
+    if (const auto* v = std::get_if<int64_t>(&value)) {
+      Publish(*v);
+    } else if (const auto* v = std::get_if<double>(&value)) {
+      Publish(*v);
+    } else if (const auto* v = std::get_if<bool>(&value)) {
+      Publish(*v);
+    } else {
+      return false;
+    }
+    return true;
+  }
+
+  /** @brief 每次 Publish 加一 (构造后为 0)，读者据此跳过没有变化的单元。 */
+  uint64_t Version() const noexcept { return version_.load(std::memory_order_acquire); }
+
+  /** @brief 当前值。 */
+  ConfigValue Load() const noexcept {
+    const uint64_t bits = bits_.load(std::memory_order_acquire);
+    if (tag_ == 2) {
+      double d;
+      std::memcpy(&d, &bits, sizeof(d));
+      return d;
+    }
+    if (tag_ == 3) return bits != 0;
+    return static_cast<int64_t>(bits);
+  }
+
+ private:
+  void Store(double value) noexcept {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    Store(bits);
+  }
+  void Store(uint64_t bits) noexcept {
+    bits_.store(bits, std::memory_order_release);
+    version_.fetch_add(1, std::memory_order_release);
+  }
+
+  const uint8_t tag_;
+  std::atomic<uint64_t> bits_{0};
+  std::atomic<uint64_t> version_{0};
 };
 
 /**
@@ -133,6 +249,10 @@ struct SchemaMetadata {
       false; /**< @brief 是否只读 (UI 显示为禁用状态，通常用于监控状态) */
   bool requires_restart =
       false; /**< @brief 修改后是否需要重启软件才能生效 (UI 负责弹窗提示) */
+  bool is_monitor =
+      false; /**< @brief 是否为高频监视参数：值存放在 ConfigMonitorCell 中，界面定时拉取 */
+  bool is_volatile =
+      false; /**< @brief 是否为易失参数：修改不进修改历史、不落盘，启动时也不认领文件中的旧值 */
 
   /**
    * @brief 自定义高级校验器 (Custom Validator Callback)
@@ -148,6 +268,129 @@ struct SchemaMetadata {
   std::string custom_args;
 };
 
+/**
+ * @brief 配置落盘策略 (IConfigService::SetPersistencePolicy)。
+ * @details
+ * 后台线程负责落盘，业务线程从不等待 IO。本结构决定“攒多久写一次”以及
+ * “写完是否强制刷到物理介质”。需要确认数据已落盘时调用 IConfigService::Flush。
+ */
+struct ConfigPersistencePolicy {
+  /** @brief 防抖窗口：最后一次修改后安静这么久才落盘，连续拖动滑动条只写一次。 */
+  uint32_t debounce_ms = 500;
+  /** @brief 最大延迟：首个未落盘修改最多等待这么久，持续修改也不会无限推迟。 */
+  uint32_t max_latency_ms = 2000;
+  /**
+   * @brief 是否在重命名前 fsync / FlushFileBuffers 临时文件，并在重命名后同步目录。
+   * 关闭后写盘更快，但断电可能丢失最近的修改甚至得到空文件。
+   */
+  bool fsync = true;
+  /**
+   * @brief 组提交：不做防抖，后台线程空闲时立即提交；提交过程中到达的所有路径的
+   * 修改合并进下一次提交。延迟约等于一次写盘 (+fsync) 的耗时。
+   */
+  bool group_commit = false;
+};
+
+/**
+ * @brief 后台落盘的运行统计 (见 IConfigService::GetPersistenceStats)。
+ * @details 耗时从拿到 IO 锁开始计，到日志追加 / 快照写入 (含 fsync) 结束为止。
+ */
+struct ConfigPersistenceStats {
+  uint64_t commits = 0;          ///< 成功的提交次数
+  uint64_t failures = 0;         ///< 写盘失败的次数 (失败后下一次改写完整快照)
+  uint64_t snapshot_writes = 0;  ///< 以完整快照 (而不是追加日志) 落盘的次数
+  double last_commit_ms = 0.0;   ///< 最近一次提交的耗时
+  double avg_commit_ms = 0.0;    ///< 全部提交的平均耗时
+  double max_commit_ms = 0.0;    ///< 单次提交的最大耗时
+  uint64_t external_reloads = 0;  ///< 文件监视检测到外部修改并增量应用的次数
+  uint64_t external_ignored = 0;  ///< 文件监视事件中内容与上一份文件相同 (如自身写盘) 而跳过的次数
+};
+
+/**
+ * @brief 修改历史的保留策略 (IConfigService::SetHistoryPolicy)。
+ * @details 服务在内存中保留最近 capacity 条修改 (环形缓冲，满后淘汰最旧的)。
+ * spill_path 非空时，被淘汰的记录由后台提交任务以 JSON Lines 追加到该文件，供离线归档。
+ */
+struct ConfigHistoryPolicy {
+  size_t capacity = 4096;  ///< 内存中保留的记录条数，0 表示关闭修改历史
+  std::string spill_path;  ///< 淘汰记录的追加文件，为空时直接丢弃
+};
+
+/**
+ * @brief 修改历史查询条件 (IConfigService::QueryHistory)。
+ * @details 按路径与时间两个索引定位，不扫描整个缓冲。
+ */
+struct ConfigHistoryQuery {
+  std::string path;             ///< 只查该路径；为空时查全部路径
+  uint64_t from_ms = 0;         ///< 起始时间戳 (含)，毫秒
+  uint64_t to_ms = UINT64_MAX;  ///< 结束时间戳 (含)，毫秒
+  size_t limit = 0;             ///< 最多返回最近的多少条，0 表示不限
+};
+
+/**
+ * @brief 一条修改历史 (按时间先后排列)。
+ * @details 新旧值与节点共享不可变缓冲，大数组不复制。
+ */
+struct ConfigHistoryRecord {
+  uint64_t sequence = 0;      ///< 全局递增序号，可据此增量拉取
+  uint64_t timestamp_ms = 0;  ///< 修改生效的毫秒时间戳 (单调不减)
+  std::string path;
+  std::string operator_role;
+  std::shared_ptr<const ConfigValue> old_value;
+  std::shared_ptr<const ConfigValue> new_value;
+};
+
+/**
+ * @brief 共享内存只读视图的发布参数 (IConfigService::PublishSharedView)。
+ * @details 区域大小在发布时一次确定：键槽数取 max_entries 两倍以上的 2 的幂，
+ * 键名与字符串 / 数组内容分别放在 key_bytes、data_bytes 大小的两个区里。
+ */
+struct ConfigSharedViewOptions {
+  std::string name;                   ///< 区域名 (1~64 个 [A-Za-z0-9-_.] 字符)，读者按此打开
+  uint32_t max_entries = 4096;        ///< 最多发布的键数
+  uint32_t key_bytes = 256 * 1024;    ///< 键名区大小
+  uint32_t data_bytes = 1024 * 1024;  ///< 字符串与数组内容区大小
+};
+
+/**
+ * @brief 共享视图的统计 (发布端与读者读的是同一个区域头)。
+ */
+struct ConfigSharedViewStats {
+  uint64_t generation = 0;          ///< 修改代数：每发布一次修改加一
+  uint32_t entries = 0;             ///< 已发布的键数
+  uint32_t max_entries = 0;
+  uint64_t data_used = 0;           ///< 内容区已分配字节数 (值变长时旧块不回收)
+  uint64_t data_bytes = 0;
+  uint64_t dropped = 0;             ///< 键槽、键名区或内容区不足而未能发布的修改次数
+  bool publisher_attached = false;  ///< 发布端仍在发布 (发布进程崩溃时不会清除)
+};
+
+/**
+ * @brief 导航索引中的一个二级分组：只有计数，不含任何参数数据。
+ */
+struct ConfigSubgroupSummary {
+  std::string subgroup_key;     ///< 二级分组名 (可能为空)
+  uint32_t visible_count = 0;   ///< 非隐藏参数数
+  uint32_t advanced_count = 0;  ///< 其中 is_advanced 的参数数
+};
+
+/**
+ * @brief 导航索引中的一个分组 (IConfigService::GetGroupIndex)。
+ */
+struct ConfigGroupSummary {
+  std::string group_key;
+  std::vector<ConfigSubgroupSummary> subgroups;  ///< 按名称排序，只含有非隐藏参数的二级分组
+};
+
+/**
+ * @brief 导航树上的一个参数节点：路径、显示名键与高级标记，不复制元数据与值。
+ */
+struct ConfigNavEntry {
+  std::string path;
+  std::string name_key;
+  bool is_advanced = false;
+};
+
 /**
  * @brief 自动管理配置订阅生命周期的 RAII 保护伞。
  * * @details
@@ -0,0 +1,299 @@
+﻿/*
+ * Copyright [2025] [Yue Liu]
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file i_config_replication.h
+ * @brief [核心接口] 多节点配置复制接口 IConfigReplicator (plugin_config_replication)。
+ * @author Yue Liu
+ * @date 2025
+ *
+ * @details
+ * [设计思想]
+ * 同一产线的多台工控机共享一部分配置 (按路径前缀选定)。复制器监听本机的
+ * `ConfigChangedEvent`，只把实际变化的键作为增量发给其它节点；传输复用
+ * `INetEventBridge` (TCP 断线重连 / UDP 组播、批量、背压)，带宽与修改量成正比。
+ *
+ * - **版本向量**：每个被复制的键带一个 {节点 → 计数} 向量。本机修改时把自己的分量推进到
+ * 本机的单调计数 (以启动时的微秒时钟为起点，重启后仍然递增)。
+ * - **合并**：收到的版本被本地版本覆盖 (≤) 时丢弃；覆盖本地版本时应用；两者并发时按
+ * `ReplicaConflictPolicy` 决定胜者 (时间戳或角色优先级，最后以节点 ID 打破平局)，
+ * 所有节点的判定相同，最终收敛到同一个值。
+ * - **反熵同步**：`RequestSync` 广播本节点见过的每个节点的最大计数 (摘要)，其它节点只回送
+ * 摘要之后的版本；`full = true` 时回送全部带版本的键。新节点加入、组播丢包后调用即可补齐。
+ * - **回环抑制**：应用远端修改时线程局部标记置位，由此产生的 `ConfigChangedEvent`
+ * (包括其它订阅者在回调中连锁写入的键) 不再发出，各节点会各自推导。
+ *
+ * [使用示例]
+ * \code{.cpp}
+ * auto bridge = z3y::CreateDefaultInstance<INetEventBridge>();
+ * auto replicator = z3y::CreateDefaultInstance<IConfigReplicator>();
+ * ConfigReplicationOptions options;
+ * options.path_prefixes = {"Recipe.", "Camera."};
+ * std::string err;
+ * replicator->Start(options, bridge, err);   // 登记复制事件的 Export / Import
+ * bridge->ListenTcp("0.0.0.0", 47200, err);
+ * bridge->ConnectTcp("cell-2:47200", err);
+ * replicator->RequestSync();                 // 连接建立后补齐离线期间的修改
+ * \endcode
+ *
+ * [约束]
+ * 远端修改通过 `IConfigService::ApplyChanges` 以发起方的操作者角色写入，照常经过
+ * 本机 Schema 校验；本机未注册的键、校验失败的值被拒绝并计数，不记入版本，
+ * 之后的同步会再次送达。版本表只在内存中，重启后从对端同步恢复。
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "framework/event_helpers.h"
+#include "framework/event_serialization.h"
+#include "framework/z3y_define_interface.h"
+#include "interfaces_core/config_types.h"
+#include "interfaces_core/i_net_event_bridge.h"
+
+namespace z3y {
+namespace interfaces {
+namespace core {
+
+/**
+ * @brief 并发修改 (版本向量互不覆盖) 时的胜负规则。
+ */
+enum class ReplicaConflictPolicy : uint8_t {
+  kLatestTimestamp,  ///< 修改时间戳较新的一方胜出
+  kRolePriority,     ///< role_priority 中排名靠前的角色胜出，同级再比时间戳
+};
+
+/**
+ * @struct ConfigReplicationOptions
+ * @brief 复制器参数，在 `Start` 时传入。
+ */
+struct ConfigReplicationOptions {
+  uint64_t node_id = 0;                    ///< 节点标识，0 表示随机生成
+  std::vector<std::string> path_prefixes;  ///< 只复制以这些前缀开头的键，空表示全部
+  ReplicaConflictPolicy conflict_policy = ReplicaConflictPolicy::kLatestTimestamp;
+  std::vector<std::string> role_priority;  ///< kRolePriority 时的角色排名 (靠前者优先，未列出的最低)
+  size_t max_delta_bytes = 1200;           ///< 单个增量事件的大致上限 (默认可放进一个组播数据报)
+};
+
+/**
+ * @struct ConfigReplicationStats
+ * @brief 运行统计 (各计数器独立读取，彼此不保证严格一致)。
+ */
+struct ConfigReplicationStats {
+  uint64_t local_changes = 0;         ///< 发出的本机修改 (键) 数
+  uint64_t delta_events_sent = 0;     ///< 发出的增量事件数 (含同步回送)
+  uint64_t remote_received = 0;       ///< 收到的远端键版本数
+  uint64_t remote_applied = 0;        ///< 覆盖本地版本或在冲突中胜出而写入的键数
+  uint64_t remote_stale = 0;          ///< 已被本地版本覆盖 (重复或过期) 而丢弃的键数
+  uint64_t conflicts_local_won = 0;   ///< 并发修改中本地值胜出的次数
+  uint64_t remote_rejected = 0;       ///< 本机未注册或校验失败而拒绝的键数
+  uint64_t sync_requests_served = 0;  ///< 回应过的同步请求数
+  uint64_t sync_entries_sent = 0;     ///< 为同步请求回送的键数
+};
+
+/**
+ * @struct ConfigReplicaEntry
+ * @brief 一个键的一次版本 (增量事件的元素)。
+ */
+struct ConfigReplicaEntry {
+  std::string path;
+  ConfigValue value;
+  std::vector<std::pair<uint64_t, uint64_t>> version;  ///< {节点, 计数}，按节点升序
+  uint64_t timestamp_ms = 0;  ///< 胜出修改的时间戳
+  uint64_t origin = 0;        ///< 胜出修改的发起节点
+  std::string operator_role;  ///< 胜出修改的操作者角色
+};
+
+/** @brief [内部] 按 ConfigValue 的下标写出值 (字符串与数组带长度前缀)。 */
+inline void WriteReplicaValue(z3y::EventWriter& w, const ConfigValue& value) {
+  w.Write(static_cast<uint8_t>(value.index()));
+  std::visit(
+      [&w](const auto& v) {
+        using T = std::decay_t<decltype(v)>;
+        if constexpr (std::is_same_v<T, std::monostate>) {
+        } else if constexpr (std::is_same_v<T, std::string>) {
+          w.WriteString(v);
+        } else if constexpr (std::is_same_v<T, std::vector<std::string>>) {
+          w.Write(static_cast<uint32_t>(v.size()));
+          for (const auto& s : v) w.WriteString(s);
+        } else if constexpr (std::is_same_v<T, std::vector<int64_t>> ||
+                             std::is_same_v<T, std::vector<double>>) {
+          w.WriteBytes(v.data(), v.size() * sizeof(typename T::value_type));
+        } else {
+          w.Write(v);
+        }
+      },
+      value);
+}
+
+/** @brief [内部] 读取 WriteReplicaValue 写出的数值数组。 */
+template <typename T>
+std::vector<T> ReadReplicaArray(z3y::EventReader& r) {
+  const std::string_view bytes = r.ReadBytes();
+  if (bytes.size() % sizeof(T) != 0) {
+    throw std::out_of_range("z3y::ReadReplicaValue: truncated array");
+  }
+  std::vector<T> v(bytes.size() / sizeof(T));
+  if (!v.empty()) std::memcpy(v.data(), bytes.data(), bytes.size());
+  return v;
+}
+
+/** @brief [内部] WriteReplicaValue 的逆操作。@throws std::out_of_range 数据截断或下标非法。 */
+inline ConfigValue ReadReplicaValue(z3y::EventReader& r) {
+  switch (r.Read<uint8_t>()) {
+    case 0: return std::monostate{};
+    case 1: return r.Read<int64_t>();
+    case 2: return r.Read<double>();
+    case 3: return r.Read<bool>();
+    case 4: return r.ReadString();
+    case 5: return ReadReplicaArray<int64_t>(r);
+    case 6: return ReadReplicaArray<double>(r);
+    case 7: {
+      std::vector<std::string> v(r.Read<uint32_t>());
+      for (auto& s : v) s = r.ReadString();
+      return v;
+    }
+    default:
+      throw std::out_of_range("z3y::ReadReplicaValue: unknown value type");
+  }
+}
+
+/**
+ * @brief 节点之间传递的增量：本机修改、或对同步请求的回送。
+ * @details target 非 0 时只有该节点处理 (回送给请求者)。
+ */
+struct ConfigReplicaDeltaEvent : public z3y::Event {
+  Z3Y_DEFINE_SERIALIZABLE_EVENT(ConfigReplicaDeltaEvent, "z3y-evt-ConfigReplicaDelta-001");
+  uint64_t sender = 0;
+  uint64_t target = 0;
+  std::vector<ConfigReplicaEntry> entries;
+
+  void Serialize(z3y::EventWriter& w) const {
+    w.Write(sender);
+    w.Write(target);
+    w.Write(static_cast<uint32_t>(entries.size()));
+    for (const auto& e : entries) {
+      w.WriteString(e.path);
+      WriteReplicaValue(w, e.value);
+      w.Write(static_cast<uint32_t>(e.version.size()));
+      for (const auto& component : e.version) {
+        w.Write(component.first);
+        w.Write(component.second);
+      }
+      w.Write(e.timestamp_ms);
+      w.Write(e.origin);
+      w.WriteString(e.operator_role);
+    }
+  }
+  static ConfigReplicaDeltaEvent Deserialize(z3y::EventReader& r) {
+    ConfigReplicaDeltaEvent evt;
+    evt.sender = r.Read<uint64_t>();
+    evt.target = r.Read<uint64_t>();
+    evt.entries.resize(r.Read<uint32_t>());
+    for (auto& e : evt.entries) {
+      e.path = r.ReadString();
+      e.value = ReadReplicaValue(r);
+      e.version.resize(r.Read<uint32_t>());
+      for (auto& component : e.version) {
+        component.first = r.Read<uint64_t>();
+        component.second = r.Read<uint64_t>();
+      }
+      e.timestamp_ms = r.Read<uint64_t>();
+      e.origin = r.Read<uint64_t>();
+      e.operator_role = r.ReadString();
+    }
+    return evt;
+  }
+};
+
+/**
+ * @brief 反熵同步请求：请求者见过的每个节点的最大计数 (摘要)。
+ * @details summary 为空表示全量同步。
+ */
+struct ConfigReplicaSyncRequestEvent : public z3y::Event {
+  Z3Y_DEFINE_SERIALIZABLE_EVENT(ConfigReplicaSyncRequestEvent,
+                                "z3y-evt-ConfigReplicaSyncRequest-001");
+  uint64_t sender = 0;
+  std::vector<std::pair<uint64_t, uint64_t>> summary;  ///< {节点, 最大计数}，按节点升序
+
+  void Serialize(z3y::EventWriter& w) const {
+    w.Write(sender);
+    w.Write(static_cast<uint32_t>(summary.size()));
+    for (const auto& component : summary) {
+      w.Write(component.first);
+      w.Write(component.second);
+    }
+  }
+  static ConfigReplicaSyncRequestEvent Deserialize(z3y::EventReader& r) {
+    ConfigReplicaSyncRequestEvent evt;
+    evt.sender = r.Read<uint64_t>();
+    evt.summary.resize(r.Read<uint32_t>());
+    for (auto& component : evt.summary) {
+      component.first = r.Read<uint64_t>();
+      component.second = r.Read<uint64_t>();
+    }
+    return evt;
+  }
+};
+
+/**
+ * @class IConfigReplicator
+ * @brief [插件使用] 多节点配置复制器。
+ *
+ * @section User 使用者指南
+ * - 每次 CreateInstance 得到一个独立的复制器 (别名 "Config.Replicator")，通常每个进程一个。
+ * - 远端修改在桥的网络线程上写入本机配置，配置回调照常在该线程执行。
+ * - 复制器必须在配置服务与桥之前释放 (或先 `Stop`)。
+ */
+class IConfigReplicator : public virtual IComponent {
+ public:
+  Z3Y_DEFINE_INTERFACE(IConfigReplicator, "z3y-core-IConfigReplicator-v1", 1, 0);
+
+  /**
+   * @brief 开始复制：订阅本机配置修改与复制事件。
+   * @param bridge 非空时在其上登记两种复制事件的 Export / Import；为空时只在本机事件总线上
+   * 收发 (由调用方自行转发)。
+   * @return 已在运行、找不到配置服务或事件总线时返回 false 并写入 out_error。
+   */
+  virtual bool Start(const ConfigReplicationOptions& options,
+                     PluginPtr<INetEventBridge> bridge, std::string& out_error) = 0;
+
+  /** @brief 停止复制 (断开订阅，保留版本表)。 */
+  virtual void Stop() = 0;
+
+  /** @brief 广播同步请求。@param full 为 true 时要求回送全部带版本的键。 */
+  virtual void RequestSync(bool full = false) = 0;
+
+  /** @brief 本节点的 ID (Start 之后有效)。 */
+  virtual uint64_t GetNodeId() const = 0;
+
+  virtual ConfigReplicationStats GetStats() const = 0;
+};
+
+}  // namespace core
+}  // namespace interfaces
+}  // namespace z3y
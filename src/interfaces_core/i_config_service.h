@@ -22,13 +22,19 @@
 #ifndef Z3Y_I_CONFIG_SERVICE_H_
 #define Z3Y_I_CONFIG_SERVICE_H_
 
+#include <atomic>
+#include <future>
 #include <memory>
+#include <mutex>
 #include <stdexcept>
 #include <string>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 #include "config_types.h"
+#include "framework/connection_type.h"
+#include "framework/event_executor.h"
 #include "framework/i_component.h"
 
 namespace z3y {
@@ -130,6 +136,257 @@ inline T FromConfigValue(const ConfigValue& val, const T& fallback) {
   }
 }
 
+/**
+ * @brief 不可变快照单元：单写多读，读者无锁访问当前快照 (ConfigHandle / ConfigBlock 共用)。
+ * @details 发布方在 writer_mutex 内换上新快照；被替换的快照在没有读者时随下一次发布释放。
+ */
+template <typename T>
+struct ConfigSnapshotCell {
+  std::atomic<const T*> current{nullptr};
+  mutable std::atomic<uint32_t> readers{0};
+  std::mutex writer_mutex;  ///< 串行化发布，同时保护 owned / retired
+  std::unique_ptr<const T> owned;
+  std::vector<std::unique_ptr<const T>> retired;
+
+  explicit ConfigSnapshotCell(T initial)
+      : owned(std::make_unique<const T>(std::move(initial))) {
+    current.store(owned.get());
+  }
+  /** @brief 发布方读取当前快照 (须持有 writer_mutex)。 */
+  const T& Load() const { return *owned; }
+  void Publish(T next) {
+    auto fresh = std::make_unique<const T>(std::move(next));
+    current.store(fresh.get());
+    retired.push_back(std::move(owned));
+    owned = std::move(fresh);
+    // 交换之后读者计数为 0：之后进入的读者只会看到新快照
+    if (readers.load() == 0) retired.clear();
+  }
+  /** @brief 以 const T& 调用 fn：进出一次读者计数，中间一次原子指针读。 */
+  template <typename Fn>
+  decltype(auto) Read(Fn&& fn) const {
+    struct ReaderGuard {
+      std::atomic<uint32_t>& readers;
+      ~ReaderGuard() { readers.fetch_sub(1); }
+    } guard{readers};
+    readers.fetch_add(1);
+    return std::forward<Fn>(fn)(*current.load());
+  }
+};
+
+/**
+ * @brief 强类型配置句柄：热路径上无锁、无哈希、无内存分配地读取配置当前值。
+ * @tparam T 配置项的强类型，与 Builder<T> / Subscribe<T> 一致。
+ * @details
+ * GetValueSafe 每次调用都要哈希路径、取两把共享锁并拷贝整个 ConfigValue，
+ * 不适合逐帧读取的算法参数。句柄在获取时订阅一次，配置变化时由写入方线程
+ * 把新值转换为 T 并发布：
+ * - 不超过 8 字节的平凡类型 (整数、浮点、bool、枚举) 存在 std::atomic<T> 中，
+ * Get() 是一次原子读。
+ * - 其它类型 (字符串、数组) 发布为不可变快照，Read() 以 const T& 交给回调，
+ * 读者只在一个原子计数上进出；被替换的快照在没有读者时随下一次发布释放。
+ *
+ * 句柄内含订阅连接 (同 ScopedConnection)，可移动不可复制，析构即退订。
+ * 类型不匹配的新值被忽略，句柄保持上一个值。
+ *
+ * @code
+ * auto exposure = config->Builder<int>("Camera.Exposure").Default(1000).BindHandle();
+ * // 采集线程，每帧：
+ * camera.SetExposure(exposure.Get());
+ * @endcode
+ */
+template <typename T>
+class ConfigHandle {
+  static constexpr bool kAtomicValue =
+      std::is_trivially_copyable_v<T> && sizeof(T) <= sizeof(uint64_t);
+
+ public:
+  ConfigHandle() = default;
+
+  /**
+   * @brief 订阅 path 并读取当前值。业务侧无需手动构造，请通过
+   * ConfigBuilder::BindHandle 或 IConfigService::SubscribeHandle 获取。
+   * @param fallback 路径尚未注册 (占位节点) 时的初始值。
+   */
+  ConfigHandle(IConfigService* service, std::string path, T fallback);
+
+  ConfigHandle(ConfigHandle&&) noexcept = default;
+  ConfigHandle& operator=(ConfigHandle&&) noexcept = default;
+
+  /** @brief 是否已绑定到配置项 (默认构造的句柄为空)。 */
+  bool IsValid() const noexcept { return state_ != nullptr; }
+
+  /**
+   * @brief 读取当前值。
+   * @note 平凡类型为一次原子读；字符串、数组会拷贝一份，热路径请用 Read()。
+   *       空句柄返回 T{}。
+   */
+  T Get() const {
+    if (!state_) return T{};
+    if constexpr (kAtomicValue) {
+      return state_->value.load(std::memory_order_acquire);
+    } else {
+      return Read([](const T& value) { return value; });
+    }
+  }
+
+  /**
+   * @brief 以 const T& 调用 fn 并返回其结果，全程不加锁、不拷贝。
+   * @warning 引用只在 fn 执行期间有效，不要保存到外面。空句柄不可调用。
+   */
+  template <typename Fn>
+  decltype(auto) Read(Fn&& fn) const {
+    if constexpr (kAtomicValue) {
+      const T value = state_->value.load(std::memory_order_acquire);
+      return std::forward<Fn>(fn)(value);
+    } else {
+      return state_->Read(std::forward<Fn>(fn));
+    }
+  }
+
+ private:
+  struct AtomicState {
+    std::atomic<T> value;
+    std::mutex writer_mutex;  ///< 串行化发布，保证最后一次发布读到的是最新值
+
+    explicit AtomicState(T initial) : value(initial) {}
+    T Load() const { return value.load(std::memory_order_relaxed); }
+    void Publish(T next) { value.store(next, std::memory_order_release); }
+  };
+
+  using State = std::conditional_t<kAtomicValue, AtomicState, ConfigSnapshotCell<T>>;
+
+  /** @brief 在发布锁内重新读取配置当前值并发布 (订阅回调与初始化共用)。 */
+  static void Refresh(State& state, IConfigService* service,
+                      const std::string& path);
+
+  std::shared_ptr<State> state_;
+  ScopedConnection connection_;  ///< 后于 state_ 声明，析构时先退订
+};
+
+template <typename S>
+class ConfigBlockBuilder;
+
+/**
+ * @brief 参数块：把一组相关配置按路径绑定到结构体 S 的成员，整体发布为不可变快照。
+ * @tparam S 参数结构体 (可复制)，成员类型与各路径的 Builder<T> 一致。
+ * @details
+ * 算法每帧开头读取几十上百个参数时，逐个 ConfigHandle 读取既慢，又可能读到
+ * “一半旧、一半新”的组合。参数块在任一成员变化时，由写入方线程重新读取全部
+ * 成员、组装一份新的 S 并整体发布；读者每帧 Read() 一次，只做一次原子指针读。
+ * - 一次 BatchUpdater 事务修改多个成员时，第一个回调就已读到事务的全部新值，
+ * 其余回调发现值已在快照中，不再重复组装。
+ * - 尚未注册 (占位) 的路径与类型不匹配的值保持成员原值。
+ * - Version() 每次发布加一，读者可据此判断参数是否变化 (如重建查找表)。
+ *
+ * 参数块内含全部成员的订阅连接，可移动不可复制，析构即退订。
+ *
+ * @code
+ * struct BlobParams { int min_area = 0; double threshold = 0.5; std::string mode; };
+ * auto params = config->Block<BlobParams>()
+ *                   .Field("Blob.MinArea", &BlobParams::min_area)
+ *                   .Field("Blob.Threshold", &BlobParams::threshold)
+ *                   .Field("Blob.Mode", &BlobParams::mode)
+ *                   .Bind();
+ * // 算法线程，每帧：
+ * params.Read([&](const BlobParams& p) { Detect(image, p); });
+ * @endcode
+ */
+template <typename S>
+class ConfigBlock {
+ public:
+  ConfigBlock() = default;
+  ConfigBlock(ConfigBlock&&) noexcept = default;
+  ConfigBlock& operator=(ConfigBlock&&) noexcept = default;
+
+  /** @brief 是否已绑定 (默认构造的参数块为空)。 */
+  bool IsValid() const noexcept { return state_ != nullptr; }
+
+  /**
+   * @brief 以 const S& 调用 fn 并返回其结果，全程不加锁、不拷贝。
+   * @warning 引用只在 fn 执行期间有效，不要保存到外面。空参数块不可调用。
+   */
+  template <typename Fn>
+  decltype(auto) Read(Fn&& fn) const {
+    return state_->cell.Read(std::forward<Fn>(fn));
+  }
+
+  /** @brief 拷贝一份当前快照。空参数块返回 S{}。 */
+  S Get() const {
+    if (!state_) return S{};
+    return Read([](const S& value) { return value; });
+  }
+
+  /** @brief 已发布的快照数 (绑定时的首次发布计为 1)。空参数块返回 0。 */
+  uint64_t Version() const noexcept {
+    return state_ ? state_->version.load(std::memory_order_acquire) : 0;
+  }
+
+ private:
+  friend class ConfigBlockBuilder<S>;
+
+  /** @brief 一个成员的绑定：路径与“把 ConfigValue 写入成员”的转换。 */
+  struct FieldBinding {
+    std::string path;
+    std::function<void(S&, const ConfigValue&)> assign;
+  };
+
+  struct State {
+    ConfigSnapshotCell<S> cell;
+    std::vector<FieldBinding> fields;
+    std::vector<ConfigValue> sources;  ///< 当前快照由哪些值组装而成 (writer_mutex 保护)
+    std::atomic<uint64_t> version{0};
+
+    explicit State(S initial) : cell(std::move(initial)) {}
+  };
+
+  /**
+   * @brief 在发布锁内重新读取全部成员并发布。
+   * @param changed 触发的成员下标与新值；值已在当前快照中时跳过 (同一事务的后续回调)。
+   *        changed 为 nullptr 时无条件组装 (绑定时)。
+   */
+  static void Refresh(State& state, IConfigService* service, size_t index,
+                      const ConfigValue* changed);
+
+  std::shared_ptr<State> state_;
+  ScopedConnection connection_;  ///< 后于 state_ 声明，析构时先退订
+};
+
+/**
+ * @brief ConfigBlock 的构建器：逐个声明成员与路径，最后 Bind()。
+ * @details 通过 IConfigService::Block<S> 获取。只绑定路径，不注册节点：
+ * 参数本身仍由其所属模块通过 Builder / SchemaBatch 注册，先后顺序不限。
+ */
+template <typename S>
+class ConfigBlockBuilder {
+ public:
+  ConfigBlockBuilder(IConfigService* service, S initial)
+      : service_(service), initial_(std::move(initial)) {}
+
+  /**
+   * @brief 把 path 绑定到成员 member。
+   * @tparam M 成员类型，转换规则与 Builder<M> / GetValueSafe<M> 相同。
+   */
+  template <typename M>
+  ConfigBlockBuilder& Field(std::string path, M S::*member) {
+    fields_.push_back({std::move(path), [member](S& target, const ConfigValue& value) {
+                         target.*member = FromConfigValue<M>(value, target.*member);
+                       }});
+    return *this;
+  }
+
+  /**
+   * @brief 终结操作：订阅全部成员、组装并发布第一份快照。
+   * @details 调用方须保存返回的参数块，析构即退订。
+   */
+  [[nodiscard]] ConfigBlock<S> Bind();
+
+ private:
+  IConfigService* service_;
+  S initial_;
+  std::vector<typename ConfigBlock<S>::FieldBinding> fields_;
+};
+
 /**
  * @brief 核心语法糖：提供 Fluent API 链式调用的配置构建器。
  * @tparam T 此节点存储的数据类型，例如 int, double, std::string
@@ -140,6 +397,8 @@ inline T FromConfigValue(const ConfigValue& val, const T& fallback) {
 template <typename T>
 class ConfigBuilder {
  public:
+  using ValueType = T; /**< 节点的强类型 (供 SchemaBatch 推导回调类型) */
+
   /**
    * @brief 构建器构造函数。业务侧无需手动实例化，请通过
    * IConfigService::Builder<T> 获取。
@@ -223,6 +482,24 @@ class ConfigBuilder {
     meta_.read_only = is_read_only;
     return *this;
   }
+  /**
+   * @brief 声明为高频监视参数：值存放在无锁的 ConfigMonitorCell 中 (见 GetMonitorCell)。
+   * @details 只支持 int64 / double / bool。写入不触发订阅回调、审计事件，也不落盘；
+   * 界面只读显示，并以自己的刷新率轮询当前可见的控件。
+   */
+  ConfigBuilder& Monitor(bool is_monitor = true) {
+    meta_.is_monitor = is_monitor;
+    return *this;
+  }
+  /**
+   * @brief 声明为易失的运行时参数 (状态、计数等不需要保存的值)。
+   * @details 修改照常校验、回调并广播审计事件，但不记入修改历史、不触发落盘，
+   * 也不出现在配置文件与导出的配方中；每次启动都从默认值开始。
+   */
+  ConfigBuilder& Volatile(bool is_volatile = true) {
+    meta_.is_volatile = is_volatile;
+    return *this;
+  }
   ConfigBuilder& Permission(const std::string& token) {
     meta_.permission_token = token;
     return *this;
@@ -262,6 +539,19 @@ class ConfigBuilder {
     return *this;
   }
 
+  /**
+   * @brief 指定 Bind 回调的投递方式 (默认 kDirect，在修改者线程同步执行)。
+   * @param type kQueued / kQueuedCoalesced 时回调在 executor 线程执行，
+   * kQueuedCoalesced 只投递最新值。Bind 时的初始回填仍在当前线程同步执行。
+   * @param executor 为空时使用配置服务自带的派发线程。
+   */
+  ConfigBuilder& Delivery(ConnectionType type,
+                          std::shared_ptr<IEventExecutor> executor = nullptr) {
+    delivery_type_ = type;
+    delivery_executor_ = std::move(executor);
+    return *this;
+  }
+
   /**
    * @brief 注入自定义的复杂业务校验逻辑 (图灵完备防线)
    * @param val_fn 业务端编写的 Lambda 表达式，接收当前强类型 T，返回
@@ -304,11 +594,22 @@ class ConfigBuilder {
    */
   [[nodiscard]] ScopedConnection Bind(std::function<void(const T&)> callback);
 
+  /**
+   * @brief 终结操作：注册到后台并返回无锁读取的强类型句柄。
+   * @details 适用于逐帧读取的高频参数，详见 ConfigHandle。
+   * 调用方须保存句柄，句柄析构即退订。
+   */
+  [[nodiscard]] ConfigHandle<T> BindHandle();
+
  private:
+  friend class SchemaBatch;  // 批量注册时移走 path_ / meta_ / default_val_
+
   IConfigService* service_; /**< 后台服务指针 */
   std::string path_; /**< 配置路径 */
   SchemaMetadata meta_; /**< 正在构建的模式数据 */
   ConfigValue default_val_; /**< 暂存的默认值 */
+  ConnectionType delivery_type_ = ConnectionType::kDirect; /**< Bind 回调的投递方式 */
+  std::shared_ptr<IEventExecutor> delivery_executor_; /**< 排队投递的目标执行器 */
 };
 
 /**
@@ -320,6 +621,14 @@ struct ConfigSnapshot {
   ConfigValue default_value;  // [修复] 加入默认值，支撑细粒度UI重置
 };
 
+/**
+ * @brief 批量修改中的一项 (IConfigService::ApplyChanges 的输入元素)。
+ */
+struct ConfigChange {
+  std::string path;  /**< 目标配置路径 */
+  ConfigValue value; /**< 新值 */
+};
+
 /**
  * @brief 事务性批量更新器 (Transaction Updater)。
  * @details
@@ -337,7 +646,13 @@ class BatchUpdater {
    */
   template <typename T>
   BatchUpdater& Set(const std::string& path, T value) {
-    changes_[path] = ToConfigValue(value);
+    changes_.push_back({path, ToConfigValue(value)});
+    return *this;
+  }
+
+  /** @brief 预留暂存区容量 (配方切换一次设置成千上万项时避免反复扩容)。 */
+  BatchUpdater& Reserve(size_t count) {
+    changes_.reserve(count);
     return *this;
   }
 
@@ -351,7 +666,87 @@ class BatchUpdater {
 
  private:
   IConfigService* service_;
-  std::map<std::string, ConfigValue> changes_; /**< 修改暂存表 */
+  std::vector<ConfigChange> changes_; /**< 修改暂存区 (同一路径多次 Set 以最后一次为准) */
+};
+
+/**
+ * @brief 批量注册中的一项 (IConfigService::RegisterSchemas 的输入元素)。
+ */
+struct SchemaRegistration {
+  std::string path;           /**< 配置路径 */
+  SchemaMetadata meta;        /**< 模式元数据 */
+  ConfigValue default_value;  /**< 默认值 (决定节点类型) */
+  /** 类型安全包装后的回调；为空表示只注册 (等同 RegisterOnly) */
+  std::function<void(const ConfigValue&)> callback;
+  ConnectionType delivery_type = ConnectionType::kDirect; /**< 回调的投递方式 */
+  std::shared_ptr<IEventExecutor> delivery_executor;      /**< 排队投递的目标执行器 */
+};
+
+/**
+ * @brief 批量注册器：把插件启动期的一整组 Builder 一次提交给后台。
+ * @details
+ * 逐个 Bind 时，每一项都要单独认领孤儿数据 (复制一份 JSON)、单独取分片锁、
+ * 再单独订阅。插件一次注册上千个参数时，SchemaBatch 把它们合并为一次提交：
+ * 孤儿数据在一次加锁内整批移出 (不复制)，每个分片只加一次独占锁，
+ * 数量较多时类型反演与校验并行执行。
+ * 每一项的语义与逐个 Bind / RegisterOnly 相同：注册、以当前值回填一次、再订阅。
+ * * 【使用范例】
+ * @code
+ * auto batch = config_service->CreateSchemaBatch();
+ * batch.Bind(config_service->Builder<int>("Camera.Exposure").Default(1000),
+ *            [this](int val) { UpdateExposure(val); });
+ * batch.RegisterOnly(config_service->Builder<bool>("Camera.Trigger").Default(false));
+ * connections_ += batch.Commit();
+ * @endcode
+ */
+class SchemaBatch {
+ public:
+  explicit SchemaBatch(IConfigService* service) : service_(service) {}
+
+  /** @brief 预留容量 (一次注册成千上万项时避免反复扩容)。 */
+  SchemaBatch& Reserve(size_t count) {
+    items_.reserve(count);
+    return *this;
+  }
+
+  /**
+   * @brief 加入一项只注册、不监听的配置 (等同 ConfigBuilder::RegisterOnly)。
+   * @note builder 的内容被移入暂存区，之后不能再对它调用终结操作。
+   */
+  template <typename T>
+  SchemaBatch& RegisterOnly(ConfigBuilder<T>& builder);
+  template <typename T>
+  SchemaBatch& RegisterOnly(ConfigBuilder<T>&& builder) {
+    return RegisterOnly(builder);
+  }
+
+  /**
+   * @brief 加入一项注册并绑定回调的配置 (等同 ConfigBuilder::Bind)。
+   * @note builder 的内容被移入暂存区，之后不能再对它调用终结操作。
+   */
+  template <typename T>
+  SchemaBatch& Bind(ConfigBuilder<T>& builder,
+                    std::function<void(const typename ConfigBuilder<T>::ValueType&)> callback);
+  template <typename T>
+  SchemaBatch& Bind(ConfigBuilder<T>&& builder,
+                    std::function<void(const typename ConfigBuilder<T>::ValueType&)> callback) {
+    return Bind(builder, std::move(callback));
+  }
+
+  /** @brief 已加入、尚未提交的项数。 */
+  size_t Size() const { return items_.size(); }
+
+  /**
+   * @brief 整批提交到后台，并清空暂存区。
+   * @return 覆盖本批全部订阅的连接句柄，**调用方必须保存**，析构即整批退订。
+   * @throws std::logic_error / std::invalid_argument 与 RegisterSchema 相同
+   * (路径重复注册或类型不一致)，此时本批不注册任何一项。
+   */
+  [[nodiscard]] ScopedConnection Commit();
+
+ private:
+  IConfigService* service_;
+  std::vector<SchemaRegistration> items_; /**< 暂存区 */
 };
 
 /**
@@ -359,7 +754,7 @@ class BatchUpdater {
  */
 class IConfigService : public virtual z3y::IComponent {
  public:
-  Z3Y_DEFINE_INTERFACE(IConfigService, "z3y-core-IConfigService-v1", 1, 0);
+  Z3Y_DEFINE_INTERFACE(IConfigService, "z3y-core-IConfigService-v1", 1, 11);
 
  public:
   virtual ~IConfigService() = default;
@@ -389,6 +784,39 @@ class IConfigService : public virtual z3y::IComponent {
   [[nodiscard]] ScopedConnection Subscribe(
       const std::string& path, std::function<void(const T&)> callback);
 
+  /**
+   * @brief 指定投递方式订阅配置项。
+   * @param type kDirect 与上面的重载相同；kQueued 每次变化都在 executor 线程回调；
+   * kQueuedCoalesced 尚未执行的投递只保留最新值，慢订阅者不会拖慢 UI 滑动条。
+   * @param executor 回调执行的线程 (如 Qt GUI 线程)。为空时使用配置服务自带的
+   * 派发线程；kDirect 时必须为空。
+   * @note 退订后尚未执行的排队投递被丢弃，但正在执行的回调不会被等待。
+   * @since 1.2
+   */
+  template <typename T>
+  [[nodiscard]] ScopedConnection Subscribe(
+      const std::string& path, std::function<void(const T&)> callback,
+      ConnectionType type, std::shared_ptr<IEventExecutor> executor = nullptr);
+
+  /**
+   * @brief 获取已存在 (或尚未注册) 配置项的无锁读取句柄。
+   * @param fallback 路径尚未注册时句柄的初始值，注册后自动切换为真实值。
+   */
+  template <typename T>
+  [[nodiscard]] ConfigHandle<T> SubscribeHandle(const std::string& path,
+                                                T fallback = T{}) {
+    return ConfigHandle<T>(this, path, std::move(fallback));
+  }
+
+  /**
+   * @brief 创建参数块构建器：把一组配置绑定到结构体 S 的成员，整体读取 (见 ConfigBlock)。
+   * @param initial 成员的初始值 (对应路径尚未注册时保持此值)。
+   */
+  template <typename S>
+  [[nodiscard]] ConfigBlockBuilder<S> Block(S initial = S{}) {
+    return ConfigBlockBuilder<S>(this, std::move(initial));
+  }
+
   /**
    * @brief 裸写接口：向某个路径下发一个新值。
    * @param path 目标路径。
@@ -399,11 +827,30 @@ class IConfigService : public virtual z3y::IComponent {
   virtual bool SetValue(const std::string& path, const ConfigValue& value,
                         const std::string& operator_role = "") = 0;
 
+  /**
+   * @brief 异步写入：放入免锁队列后立即返回，由配置服务的写入线程执行 SetValue。
+   * @details 调用线程不校验、不取节点锁、不执行回调、不构造审计事件，适合实时采集线程
+   * 发布状态值。队列中尚未执行的同一路径写入只执行最后一次 (合并)；同一线程发往同一路径
+   * 的写入按顺序生效，不同路径按各自最后一次写入的先后执行。
+   * kDirect 订阅者的回调在写入线程上执行。
+   * @return 写入执行后兑现，结果与 SetValue 相同 (被合并的写入取最终那一次的结果)；
+   * 服务已关闭时为 false。不关心结果时直接丢弃即可。
+   * @since 1.13
+   */
+  virtual std::future<bool> SetValueAsync(const std::string& path, ConfigValue value,
+                                          const std::string& operator_role = "") = 0;
+
   /**
    * @brief 启动一个修改事务。
    */
   virtual BatchUpdater CreateBatch() { return BatchUpdater(this); }
 
+  /**
+   * @brief 启动一次批量注册 (插件启动期一次注册大量参数时使用)。
+   * @since 1.6
+   */
+  SchemaBatch CreateSchemaBatch() { return SchemaBatch(this); }
+
   /**
    * @brief 底层批量修改接口，建议通过 BatchUpdater 进行调用。
    */
@@ -411,6 +858,18 @@ class IConfigService : public virtual z3y::IComponent {
       const std::map<std::string, ConfigValue>& changes,
       const std::string& operator_role = "") = 0;
 
+  /**
+   * @brief 扁平数组形式的批量修改接口 (BatchUpdater::Commit 走这里)。
+   * @details 语义与 ApplyBatch 相同：任一路径不存在或校验失败则整体不生效。
+   * 同一路径出现多次时以最后一项为准。调用方无需先构造 std::map，
+   * 适合配方切换这类一次修改成千上万项的场景。
+   * @return 错误信息列表，为空表示全部生效。
+   * @since 1.3
+   */
+  virtual std::vector<std::string> ApplyChanges(
+      const std::vector<ConfigChange>& changes,
+      const std::string& operator_role = "") = 0;
+
   /**
    * @brief 动态更新枚举类型下拉框的元数据选项（支持热更新）
    * @param path 目标配置路径
@@ -431,7 +890,34 @@ class IConfigService : public virtual z3y::IComponent {
    */
   template <typename T>
   T GetValueSafe(const std::string& path, T fallback_value = T{}) const {
-    return FromConfigValue<T>(GetValue(path), fallback_value);
+    if constexpr (is_std_vector_v<T> || std::is_same_v<T, std::string>) {
+      // 字符串与数组：共享读取当前缓冲，只在转换为 T 时拷贝一次
+      const std::shared_ptr<const ConfigValue> value = GetValueShared(path);
+      return value ? FromConfigValue<T>(*value, fallback_value) : fallback_value;
+    } else {
+      return FromConfigValue<T>(GetValue(path), fallback_value);
+    }
+  }
+
+  /**
+   * @brief 以共享只读的形式读取字符串 / 数组配置，不拷贝元素。
+   * @tparam T ConfigValue 的可选类型之一：std::string、std::vector<int64_t>、
+   * std::vector<double> 或 std::vector<std::string>。
+   * @return 指向当前值的不可变缓冲；路径不存在或类型不符时返回 nullptr。
+   * 之后的修改整体换上新缓冲，已取得的指针内容不变，持有期间始终有效。
+   *
+   * @code
+   * auto table = config->GetShared<std::vector<double>>("Camera.Calibration");
+   * if (table) Apply(table->data(), table->size());  // 一万个元素也不拷贝
+   * @endcode
+   */
+  template <typename T>
+  std::shared_ptr<const T> GetShared(const std::string& path) const {
+    std::shared_ptr<const ConfigValue> value = GetValueShared(path);
+    if (!value) return nullptr;
+    const T* typed = std::get_if<T>(value.get());
+    if (!typed) return nullptr;
+    return std::shared_ptr<const T>(std::move(value), typed);
   }
 
   /**
@@ -443,6 +929,16 @@ class IConfigService : public virtual z3y::IComponent {
     return SetValue(path, ToConfigValue(value), operator_role);
   }
 
+  /**
+   * @brief 强类型异步赋值快捷接口 (见 SetValueAsync)。
+   * @since 1.13
+   */
+  template <typename T>
+  std::future<bool> SetValueSafeAsync(const std::string& path, T value,
+                                      const std::string& operator_role = "") {
+    return SetValueAsync(path, ToConfigValue(value), operator_role);
+  }
+
   /**
    * @brief 框架底层防坠网机制：获取服务的存活令牌。
    * @details 通过 weak_ptr，ScopedConnection
@@ -461,7 +957,8 @@ class IConfigService : public virtual z3y::IComponent {
    * @brief 从持久化配置文件中强制重新加载配置。
    * * @details
    * 这是一个重量级的状态对齐接口，通常用于：
-   * 1. 运维人员在后台手动修改了 config.json 后，通过指令通知系统重新加载。
+   * 1. 运维人员在后台手动修改了 config.json 后，通过指令通知系统重新加载
+   *    (开启 SetFileWatch 后自动增量应用，无需手动调用)。
    * 2. 多进程架构中，收到外部配置变更信号时同步内存状态。
    * * 【执行逻辑】：
    * - 解析磁盘上的 JSON 文件。
@@ -515,6 +1012,43 @@ class IConfigService : public virtual z3y::IComponent {
   virtual bool ImportFromFile(const std::string& source_path,
                               bool apply_immediately = true) = 0;
 
+  /**
+   * @brief 预编译一个具名配方覆盖层 (同名则替换)。
+   * @details 在此时完成路径解析与全部校验，值以紧凑格式保存。只有校验全部通过才登记；
+   * 之后 ActivateOverlay 不再解析 JSON、不再查字典，只比较并写入与当前值不同的节点。
+   * 同一路径出现多次时以最后一项为准。
+   * @param operator_role 校验与激活时使用的操作者角色。
+   * @return 错误信息列表，为空表示已登记。
+   * @since 1.4
+   */
+  virtual std::vector<std::string> PrepareOverlay(
+      const std::string& name, const std::vector<ConfigChange>& values,
+      const std::string& operator_role = "") = 0;
+
+  /**
+   * @brief 从配方文件 ({"路径": 值, ...}，与 ExportToFile 格式相同) 预编译覆盖层。
+   * @details JSON 只在此处解析一次，按各节点的默认值类型转换。文件中出现未注册的路径视为错误。
+   * @since 1.4
+   */
+  virtual std::vector<std::string> PrepareOverlayFromFile(
+      const std::string& name, const std::string& source_path,
+      const std::string& operator_role = "") = 0;
+
+  /**
+   * @brief 激活覆盖层：一次事务写入全部与当前值不同的节点，只通知这些节点的订阅者。
+   * @details 预编译之后 Schema 被修改过的节点 (如 UpdateEnumSchema) 会重新校验，
+   * 任一失败则整体不生效。
+   * @return 错误信息列表，为空表示切换成功。
+   * @since 1.4
+   */
+  virtual std::vector<std::string> ActivateOverlay(const std::string& name) = 0;
+
+  /** @brief 删除覆盖层。@return false 表示没有这个名字。@since 1.4 */
+  virtual bool RemoveOverlay(const std::string& name) = 0;
+
+  /** @brief 当前已预编译的覆盖层名字 (按字典序)。@since 1.4 */
+  virtual std::vector<std::string> GetOverlayNames() const = 0;
+
   /**
    * @brief 获取系统中当前所有已注册的非隐藏分组名称。
    * @return 所有唯一的 GroupKey 列表。用于 UI 自动创建顶层 Tab 页签。
@@ -533,6 +1067,97 @@ class IConfigService : public virtual z3y::IComponent {
   virtual std::map<std::string, ConfigSnapshot> GetConfigsByGroup(
       const std::string& group_key) const = 0;
 
+  /**
+   * @brief 分组 / 二级分组的轻量索引 (只有名字与计数)，用于构建导航树的骨架。
+   * @details 直接读取注册时维护的分组索引，不碰任何节点锁，也不复制快照；
+   * 只含有非隐藏参数的分组与二级分组，均按名称排序，不含 GroupKey 为空的参数。
+   * @since 1.10
+   */
+  virtual std::vector<ConfigGroupSummary> GetGroupIndex() const = 0;
+
+  /**
+   * @brief 一个二级分组下的非隐藏参数 (按路径排序)：只有路径、显示名键与高级标记。
+   * @details 供导航树在节点展开时按需填充子节点。
+   * @since 1.10
+   */
+  virtual std::vector<ConfigNavEntry> GetSubgroupEntries(
+      const std::string& group_key, const std::string& subgroup_key) const = 0;
+
+  /**
+   * @brief 设置后台落盘策略 (防抖窗口、最大延迟、fsync、组提交)，立即生效。
+   * @since 1.1
+   */
+  virtual void SetPersistencePolicy(const ConfigPersistencePolicy& policy) = 0;
+
+  /**
+   * @brief 等待调用之前的所有修改落盘完成 (策略开启 fsync 时即已刷到物理介质)。
+   * @details 跳过剩余的防抖等待，立即唤醒后台线程提交。适用于自升级、关机前。
+   * @param timeout_ms 最长等待时间。
+   * @return 全部修改已持久化返回 true；超时或写盘失败返回 false。
+   * @since 1.1
+   */
+  virtual bool Flush(uint32_t timeout_ms = 5000) = 0;
+
+  /**
+   * @brief 读取后台落盘的统计 (提交 / 失败次数与单次提交耗时)。
+   * @details 后台线程以 relaxed 原子写入，读取不加锁；各字段分别读取，彼此不保证严格一致。
+   * @since 1.5
+   */
+  virtual ConfigPersistenceStats GetPersistenceStats() const = 0;
+
+  /**
+   * @brief 开启 / 关闭对配置文件外部修改的监视 (Linux inotify / Windows ReadDirectoryChangesW)。
+   * @details
+   * 运维手工编辑或部署新的 config.json 后无需再调用 ReloadFromFile：
+   * - 与最近一次落盘 (或上一次被应用) 的文件内容相同 (长度与哈希一致) 的事件被忽略，
+   *   服务自己的原子重命名写盘因此不会触发重载。
+   * - 内容不同时流式比对每个键的值与上一份文件，只对真正被改动的键做类型反演、
+   *   校验与回调；未改动的键即使与内存不同 (例如尚在变更日志里) 也保持原状。
+   * - 半截文件 (语法错误) 被跳过，等待下一次写入事件。
+   * 回调在监视线程上执行，审计事件的操作者为 "System_FileWatch"。
+   * @param debounce_ms 最后一个文件事件之后安静多久才处理，编辑器连续保存只处理一次。
+   * @return 开启时平台不支持或目录无法监视返回 false；关闭总是返回 true。
+   * @since 1.7
+   */
+  virtual bool SetFileWatch(bool enabled, uint32_t debounce_ms = 200) = 0;
+
+  /**
+   * @brief 设置修改历史的保留条数与淘汰记录的追加文件，立即生效。
+   * @details 默认在内存中保留最近 4096 条修改，不写文件。
+   * @since 1.9
+   */
+  virtual void SetHistoryPolicy(const ConfigHistoryPolicy& policy) = 0;
+
+  /**
+   * @brief 查询修改历史 (“上一个班次改了什么”)。
+   * @details 每次实际改变了值的写入 (SetValue、事务、配方、重载、文件监视) 都会留下一条，
+   * 与审计事件一一对应，但不依赖事件总线的订阅者。按路径或时间范围查询只访问命中的记录。
+   * @return 按序号升序的记录；超出保留条数的旧记录只存在于追加文件中。
+   * @since 1.9
+   */
+  virtual std::vector<ConfigHistoryRecord> QueryHistory(
+      const ConfigHistoryQuery& query) const = 0;
+
+  /**
+   * @brief 把全部配置的当前值发布到命名共享内存，同机其它进程经 IConfigSharedView 只读访问。
+   * @details 多个工作进程不再各自解析 config.json、各自保存一份。发布后每次实际修改
+   * (SetValue、事务、配方、重载、文件监视) 都在节点锁内同步写入区域，读者不取锁。
+   * 监视参数 (Builder::Monitor) 不发布。
+   * @return 名称非法、已在发布或创建共享内存失败 (同名区域已存在) 时返回 false 并写入 out_error。
+   * @since 1.12
+   */
+  virtual bool PublishSharedView(const ConfigSharedViewOptions& options,
+                                 std::string& out_error) = 0;
+
+  /**
+   * @brief 停止发布并删除区域名。已打开的读者保留映射，读到的值停留在停止时刻。
+   * @since 1.12
+   */
+  virtual void StopSharedView() = 0;
+
+  /** @brief 发布端的区域统计 (未发布时为全 0)。@since 1.12 */
+  virtual ConfigSharedViewStats GetSharedViewStats() const = 0;
+
   // ---------------- 以下为底层设施接口（业务层一般不需要直接调用）----------------
 
   /** @brief 注册配置节点 (Builder 底层调用的方法) */
@@ -540,15 +1165,53 @@ class IConfigService : public virtual z3y::IComponent {
                               const SchemaMetadata& meta,
                               const ConfigValue& default_val) = 0;
 
+  /**
+   * @brief 批量注册配置节点 (SchemaBatch::Commit 底层调用的方法)。
+   * @details 每一项依次完成注册、以当前值调用一次 callback、订阅 callback，
+   * 与逐个 RegisterSchema + InternalSubscribeWithDelivery 等价。
+   * items 中的 callback 与 delivery_executor 会被移走，其余字段保持不变。
+   * @return 与 items 一一对应的订阅 ID，没有 callback 的项为 0。
+   * @throws std::logic_error / std::invalid_argument 路径重复或类型不一致时，
+   * 不注册任何一项；回调抛出的异常在撤销本批已建立的订阅后原样抛出。
+   * @since 1.6
+   */
+  virtual std::vector<uint64_t> RegisterSchemas(std::vector<SchemaRegistration>& items) = 0;
+
   /** @brief 内部绑定订阅回调机制 */
   virtual uint64_t InternalSubscribe(
       const std::string& path, std::function<void(const ConfigValue&)> cb) = 0;
 
+  /**
+   * @brief 内部绑定带投递方式的订阅回调 (kDirect 且 executor 为空时等同 InternalSubscribe)。
+   * @throws std::invalid_argument kDirect 搭配了非空 executor。
+   * @since 1.2
+   */
+  virtual uint64_t InternalSubscribeWithDelivery(
+      const std::string& path, std::function<void(const ConfigValue&)> cb,
+      ConnectionType type, std::shared_ptr<IEventExecutor> executor) = 0;
+
   /** @brief 内部解绑订阅回调机制 */
   virtual void InternalUnsubscribe(const std::string& path, uint64_t cb_id) = 0;
 
   /** @brief 原生获取底层值接口 */
   virtual ConfigValue GetValue(const std::string& path) const = 0;
+
+  /**
+   * @brief 共享读取底层值 (GetShared 底层调用的方法)。
+   * @details 字符串与数组直接返回节点持有的不可变缓冲 (只增加引用计数)；
+   * 标量每次包装一份。路径不存在时返回 nullptr。
+   * @since 1.8
+   */
+  virtual std::shared_ptr<const ConfigValue> GetValueShared(const std::string& path) const = 0;
+
+  /**
+   * @brief 取得监视参数 (Builder::Monitor) 的无锁值单元。
+   * @details 采集线程持有单元后直接 Publish，不再查字典、不取任何锁；
+   * 界面按 Version 判断是否需要刷新。经 SetValue 写入的值通过校验后同样存入单元。
+   * @return 路径不存在或不是监视参数时返回 nullptr。
+   * @since 1.11
+   */
+  virtual std::shared_ptr<ConfigMonitorCell> GetMonitorCell(const std::string& path) const = 0;
 };
 
 // ============================================================================
@@ -634,7 +1297,8 @@ ScopedConnection ConfigBuilder<T>::Bind(
   auto wrapper_cb = CreateTypeSafeWrapper<T>(path_, std::move(callback));
   wrapper_cb(service_->GetValue(path_));
 
-  uint64_t id = service_->InternalSubscribe(path_, wrapper_cb);
+  uint64_t id = service_->InternalSubscribeWithDelivery(
+      path_, wrapper_cb, delivery_type_, delivery_executor_);
   std::weak_ptr<void> alive = service_->GetAliveToken();
 
   return ScopedConnection([service = service_, p = path_, id, alive]() {
@@ -657,13 +1321,160 @@ ScopedConnection IConfigService::Subscribe(
   });
 }
 
+template <typename T>
+ScopedConnection IConfigService::Subscribe(
+    const std::string& path, std::function<void(const T&)> callback,
+    ConnectionType type, std::shared_ptr<IEventExecutor> executor) {
+  auto wrapper_cb = CreateTypeSafeWrapper<T>(path, std::move(callback));
+  uint64_t id = InternalSubscribeWithDelivery(path, wrapper_cb, type, std::move(executor));
+  std::weak_ptr<void> alive = GetAliveToken();
+  return ScopedConnection([this, p = path, id, alive]() {
+    if (auto token = alive.lock()) {
+      InternalUnsubscribe(p, id);
+    }
+  });
+}
+
 template <typename T>
 void ConfigBuilder<T>::RegisterOnly() {
   service_->RegisterSchema(path_, meta_, default_val_);
 }
 
+template <typename T>
+ConfigHandle<T> ConfigBuilder<T>::BindHandle() {
+  service_->RegisterSchema(path_, meta_, default_val_);
+  return ConfigHandle<T>(service_, path_, FromConfigValue<T>(default_val_, T{}));
+}
+
+template <typename T>
+ConfigHandle<T>::ConfigHandle(IConfigService* service, std::string path,
+                              T fallback)
+    : state_(std::make_shared<State>(std::move(fallback))) {
+  // 先订阅再读取：订阅之后的任何修改都会再触发一次 Refresh
+  uint64_t id = service->InternalSubscribe(
+      path, [state = state_, service, path](const ConfigValue&) {
+        Refresh(*state, service, path);
+      });
+  Refresh(*state_, service, path);
+  std::weak_ptr<void> alive = service->GetAliveToken();
+  connection_ = ScopedConnection([service, path, id, alive]() {
+    if (auto token = alive.lock()) {
+      service->InternalUnsubscribe(path, id);
+    }
+  });
+}
+
+template <typename T>
+void ConfigHandle<T>::Refresh(State& state, IConfigService* service,
+                              const std::string& path) {
+  // 回调的参数可能已被更晚的修改取代，锁内重新读取，最后一次发布总是最新值
+  std::lock_guard<std::mutex> lock(state.writer_mutex);
+  if constexpr (kAtomicValue) {
+    const ConfigValue current = service->GetValue(path);
+    if (std::holds_alternative<std::monostate>(current)) return;
+    state.Publish(FromConfigValue<T>(current, state.Load()));
+  } else {
+    // 字符串与数组共享读取节点缓冲，只在转换为 T 时拷贝一次
+    const std::shared_ptr<const ConfigValue> current = service->GetValueShared(path);
+    if (!current || std::holds_alternative<std::monostate>(*current)) return;
+    state.Publish(FromConfigValue<T>(*current, state.Load()));
+  }
+}
+
+template <typename S>
+ConfigBlock<S> ConfigBlockBuilder<S>::Bind() {
+  ConfigBlock<S> block;
+  auto state = std::make_shared<typename ConfigBlock<S>::State>(std::move(initial_));
+  state->fields = std::move(fields_);
+  state->sources.resize(state->fields.size());
+  block.state_ = state;
+
+  // 先订阅再读取：订阅之后的任何修改都会再触发一次 Refresh
+  std::vector<std::pair<std::string, uint64_t>> subscriptions;
+  subscriptions.reserve(state->fields.size());
+  for (size_t i = 0; i < state->fields.size(); ++i) {
+    const std::string& path = state->fields[i].path;
+    uint64_t id = service_->InternalSubscribe(
+        path, [state, service = service_, i](const ConfigValue& value) {
+          ConfigBlock<S>::Refresh(*state, service, i, &value);
+        });
+    subscriptions.emplace_back(path, id);
+  }
+  ConfigBlock<S>::Refresh(*state, service_, 0, nullptr);
+
+  std::weak_ptr<void> alive = service_->GetAliveToken();
+  block.connection_ = ScopedConnection(
+      [service = service_, subs = std::move(subscriptions), alive]() {
+        if (auto token = alive.lock()) {
+          for (const auto& sub : subs) service->InternalUnsubscribe(sub.first, sub.second);
+        }
+      });
+  return block;
+}
+
+template <typename S>
+void ConfigBlock<S>::Refresh(State& state, IConfigService* service, size_t index,
+                             const ConfigValue* changed) {
+  std::lock_guard<std::mutex> lock(state.cell.writer_mutex);
+  if (changed && state.sources[index] == *changed) return;
+  S next = state.cell.Load();
+  for (size_t i = 0; i < state.fields.size(); ++i) {
+    // 回调的参数可能已被更晚的修改取代，锁内重新读取全部成员
+    ConfigValue current = service->GetValue(state.fields[i].path);
+    if (std::holds_alternative<std::monostate>(current)) continue;
+    state.fields[i].assign(next, current);
+    state.sources[i] = std::move(current);
+  }
+  state.cell.Publish(std::move(next));
+  state.version.fetch_add(1, std::memory_order_release);
+}
+
 inline std::vector<std::string> BatchUpdater::Commit(const std::string& role) {
-  return service_->ApplyBatch(changes_, role);
+  return service_->ApplyChanges(changes_, role);
+}
+
+template <typename T>
+SchemaBatch& SchemaBatch::RegisterOnly(ConfigBuilder<T>& builder) {
+  SchemaRegistration item;
+  item.path = std::move(builder.path_);
+  item.meta = std::move(builder.meta_);
+  item.default_value = std::move(builder.default_val_);
+  items_.push_back(std::move(item));
+  return *this;
+}
+
+template <typename T>
+SchemaBatch& SchemaBatch::Bind(
+    ConfigBuilder<T>& builder,
+    std::function<void(const typename ConfigBuilder<T>::ValueType&)> callback) {
+  SchemaRegistration item;
+  item.path = std::move(builder.path_);
+  item.meta = std::move(builder.meta_);
+  item.default_value = std::move(builder.default_val_);
+  item.callback = CreateTypeSafeWrapper<T>(item.path, std::move(callback));
+  item.delivery_type = builder.delivery_type_;
+  item.delivery_executor = std::move(builder.delivery_executor_);
+  items_.push_back(std::move(item));
+  return *this;
+}
+
+inline ScopedConnection SchemaBatch::Commit() {
+  std::vector<SchemaRegistration> items = std::move(items_);
+  items_.clear();
+  const std::vector<uint64_t> ids = service_->RegisterSchemas(items);
+
+  std::vector<std::pair<std::string, uint64_t>> subscriptions;
+  for (size_t i = 0; i < ids.size(); ++i) {
+    if (ids[i] != 0) subscriptions.emplace_back(std::move(items[i].path), ids[i]);
+  }
+  if (subscriptions.empty()) return ScopedConnection();
+  std::weak_ptr<void> alive = service_->GetAliveToken();
+  return ScopedConnection(
+      [service = service_, subs = std::move(subscriptions), alive]() {
+        if (auto token = alive.lock()) {
+          for (const auto& sub : subs) service->InternalUnsubscribe(sub.first, sub.second);
+        }
+      });
 }
 }  // namespace core
 }  // namespace interfaces
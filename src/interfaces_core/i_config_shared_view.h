@@ -0,0 +1,135 @@
+﻿/*
+ * Copyright [2025] [Yue Liu]
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file i_config_shared_view.h
+ * @brief [核心接口] 共享内存配置只读视图 IConfigSharedView (plugin_config_manager)。
+ * @author Yue Liu
+ * @date 2025
+ *
+ * @details
+ * [设计思想]
+ * 同一台机器上的多个工作进程需要同一份参数。由一个进程的配置服务调用
+ * `IConfigService::PublishSharedView` 把当前值发布到命名共享内存，其余进程打开视图直接读取：
+ * 不再各自解析 config.json，也不再各自保存一份。
+ *
+ * - **读取**：按路径哈希在共享内存的键槽里探测，每个槽一把序列锁 (seqlock)。
+ * 标量直接从映射中读出，字符串与数组拷出后校验序列号，与发布端的写入并发时自动重试，不取任何锁。
+ * - **变化通知**：每次修改使修改代数 (generation) 加一。`WaitForChange` 在 Linux 上以跨进程
+ * futex 等待，发布端只在有等待者时唤醒；其它平台以 1ms 间隔轮询。
+ * `GetChangedSince` 列出某一代数之后改变过的键。
+ *
+ * [使用示例]
+ * \code{.cpp}
+ * // 主进程
+ * ConfigSharedViewOptions options;
+ * options.name = "line-3";
+ * std::string err;
+ * config->PublishSharedView(options, err);
+ *
+ * // 工作进程
+ * auto view = z3y::CreateDefaultInstance<IConfigSharedView>();
+ * view->Open("line-3", err);
+ * double exposure = 0.0;
+ * view->TryGet<double>("Camera.Exposure", exposure);
+ * uint64_t seen = view->GetGeneration();
+ * seen = view->WaitForChange(seen, 1000);  // 有修改或超时返回
+ * \endcode
+ *
+ * [约束]
+ * - 视图只读。修改仍须经发布进程的 IConfigService (校验、权限、审计、落盘都在那里)。
+ * - 区域大小在发布时确定；键槽、键名区或内容区用尽后，新键不再发布，放不下的新值
+ * 使该键读作空值，二者都计入 `dropped`。
+ * - `Open` / `Close` 不得与读取并发；读取之间可以任意并发。
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "framework/z3y_define_interface.h"
+#include "interfaces_core/config_types.h"
+
+namespace z3y {
+namespace interfaces {
+namespace core {
+
+/**
+ * @class IConfigSharedView
+ * @brief [插件使用] 打开另一进程发布的配置共享内存，只读访问。
+ *
+ * @section User 使用者指南
+ * - 每次 CreateInstance 得到一个独立的视图 (别名 "Config.SharedView")，通常每个进程一个。
+ * - 发布端停止 (`StopSharedView`) 后，已打开的视图仍可读取停止时刻的值，
+ * `GetStats().publisher_attached` 变为 false；发布端重新发布后须重新 `Open`。
+ */
+class IConfigSharedView : public virtual IComponent {
+ public:
+  Z3Y_DEFINE_INTERFACE(IConfigSharedView, "z3y-core-IConfigSharedView-v1", 1, 0);
+
+  /**
+   * @brief 打开名为 name 的共享视图 (已打开时先关闭原来的)。
+   * @return 区域不存在、版本不符或布局损坏时返回 false 并写入 out_error。
+   */
+  virtual bool Open(const std::string& name, std::string& out_error) = 0;
+
+  /** @brief 解除映射。 */
+  virtual void Close() = 0;
+
+  virtual bool IsOpen() const = 0;
+
+  /**
+   * @brief 读取 path 的当前值。
+   * @return 未打开、路径未发布或值未能发布时返回 false。
+   */
+  virtual bool TryGetValue(const std::string& path, ConfigValue& out) const = 0;
+
+  /** @brief 同 TryGetValue，读不到时返回 std::monostate。 */
+  virtual ConfigValue GetValue(const std::string& path) const = 0;
+
+  /** @brief 按类型读取：类型与发布的值不一致时返回 false。 */
+  template <typename T>
+  bool TryGet(const std::string& path, T& out) const {
+    ConfigValue value;
+    if (!TryGetValue(path, value)) return false;
+    T* typed = std::get_if<T>(&value);
+    if (!typed) return false;
+    out = std::move(*typed);
+    return true;
+  }
+
+  /** @brief 当前修改代数 (未打开时为 0)。 */
+  virtual uint64_t GetGeneration() const = 0;
+
+  /**
+   * @brief 等待修改代数离开 seen_generation。
+   * @return 最新的修改代数；超时返回时等于 seen_generation。
+   */
+  virtual uint64_t WaitForChange(uint64_t seen_generation, uint32_t timeout_ms) const = 0;
+
+  /** @brief 在 generation 之后改变过 (或新发布) 的键，顺序不定。 */
+  virtual std::vector<std::string> GetChangedSince(uint64_t generation) const = 0;
+
+  virtual ConfigSharedViewStats GetStats() const = 0;
+};
+
+}  // namespace core
+}  // namespace interfaces
+}  // namespace z3y
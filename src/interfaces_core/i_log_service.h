@@ -34,6 +34,8 @@
 
 #pragma once
 
+#include <cstdint>
+#include <functional>
 #include <string>
 
 #include "framework/z3y_define_interface.h"
@@ -61,6 +63,47 @@ struct LogSourceLocation {
   const char* function_name;
 };
 
+/**
+ * @enum LogArgType
+ * @brief 延迟格式化参数的类型标签。
+ */
+enum class LogArgType : uint32_t {
+  Int64,
+  UInt64,
+  Double,
+  Bool,
+  Char,
+  Pointer,
+  String,  ///< str + size，调用返回前由实现拷贝
+};
+
+/**
+ * @struct LogArg
+ * @brief [ABI 安全] 延迟格式化的单个参数 (16 字节，平凡可拷贝)。
+ * @details 通常由 Z3Y_LOG_DEFERRED_* 宏自动生成，不需要手工填写。
+ */
+struct LogArg {
+  LogArgType type;
+  uint32_t size;  ///< 仅 String 有效：字节数
+  union {
+    int64_t i64;
+    uint64_t u64;
+    double f64;
+    const void* ptr;
+    const char* str;
+  };
+};
+
+/**
+ * @struct LogField
+ * @brief [ABI 安全] 结构化日志的一个字段 (24 字节，平凡可拷贝)。
+ * @details key **必须具有静态生命周期** (字符串字面量)。通常由 Z3Y_LOG_KV 生成。
+ */
+struct LogField {
+  const char* key;
+  LogArg value;
+};
+
 /**
  * @class ILogger
  * @brief [插件使用] 日志记录器接口。
@@ -74,7 +117,7 @@ struct LogSourceLocation {
  */
 class ILogger : public virtual IComponent {
  public:
-  Z3Y_DEFINE_INTERFACE(ILogger, "z3y-core-ILogger-IID-L0000002", 1, 0);
+  Z3Y_DEFINE_INTERFACE(ILogger, "z3y-core-ILogger-IID-L0000002", 1, 3);
 
   /**
    * @brief [高频] 检查指定日志级别是否启用。
@@ -94,6 +137,43 @@ class ILogger : public virtual IComponent {
    */
   virtual void Log(const LogSourceLocation& loc, LogLevel level,
                    const char* message) = 0;
+
+  /**
+   * @brief [v1.1][高频] 提交一条延迟格式化的日志。
+   * @details 调用线程只把格式串指针与参数值拷入线程私有的环形缓冲区，
+   * `fmt` 格式化在日志后台线程上进行。String 参数的内容在返回前已被拷贝；
+   * 时间戳与线程 ID 取自调用时刻。与 `Log` 提交的日志之间不保证先后顺序。
+   * 强烈建议使用 `Z3Y_LOG_DEFERRED_...` 宏。
+   *
+   * @param format fmt 语法的格式串。**必须具有静态生命周期** (字符串字面量)。
+   * @param args 参数数组 (arg_count 为 0 时可为 nullptr)。
+   */
+  virtual void LogDeferred(const LogSourceLocation& loc, LogLevel level,
+                           const char* format, const LogArg* args,
+                           uint32_t arg_count) = 0;
+
+  /**
+   * @brief [v1.2][高频] 限流 / 去重关口，在 IsEnabled 之后、格式化之前调用。
+   * @details 未配置限流时只做一次原子读取并返回 true。返回 false 表示这条日志被
+   * 限流丢弃，调用方不应再格式化或提交。被丢弃的条数会在同一调用点 (或 Logger)
+   * 下一条放行的日志之前以一条提示日志报告。`Z3Y_LOG_...` 宏会自动调用。
+   */
+  virtual bool Admit(const LogSourceLocation& loc, LogLevel level) noexcept = 0;
+
+  /**
+   * @brief [v1.3][高频] 提交一条结构化日志：消息模板 + 带类型的具名字段。
+   * @details 调用线程只把模板指针与字段值按二进制拷入线程环 (与 LogDeferred 相同)，
+   * 后台线程按 Sink 分别输出：文本 Sink 得到渲染后的消息 (模板中的 `{key}` 换成字段值，
+   * 模板未引用的字段以 ` key=value` 追加)；`"format": "json"` 的文件 Sink 写 JSON Lines；
+   * mmap_binary_sink 在记录中附带二进制字段；观察者从 LogRecord (version >= 3)
+   * 的 fields 取得原始类型的字段。强烈建议使用 `Z3Y_LOG_STRUCTURED_...` 宏。
+   *
+   * @param message_template fmt 语法、以字段名作占位符的模板。**必须具有静态生命周期**。
+   * @param fields 字段数组 (field_count 为 0 时可为 nullptr)。
+   */
+  virtual void LogStructured(const LogSourceLocation& loc, LogLevel level,
+                             const char* message_template, const LogField* fields,
+                             uint32_t field_count) = 0;
 };
 
 /**
@@ -120,12 +200,68 @@ struct LogRecord {
   LogLevel level;       // 日志等级
   int32_t line_number;  // 行号
 
-  // [预留扩展区]
-  uint64_t reserved[4];  // 预留 32 字节，总计 88 字节，完美对齐
-};
+  // [version >= 2] 不含结尾 '\0' 的长度，可直接构造 string_view
+  uint32_t logger_name_length;
+  uint32_t message_length;
+
+  // [version >= 3] 结构化日志 (LogStructured) 的字段，其它日志为 nullptr / 0。
+  // 字段与其中的字符串同 message 一样仅在回调期间有效。
+  const LogField* fields;
+  uint32_t field_count;
+  uint32_t reserved;             // 预留
+  const char* message_template;  // 消息模板 (静态字符串)；非结构化日志为 nullptr
+};                               // 总计 88 字节
 
 using LogObserverCallback = std::function<void(const LogRecord&)>;
 
+/**
+ * @brief [ABI 安全] 批量观察者一次收到的日志批次。
+ * @details records 及其指向的所有字符串由日志系统持有，仅在回调期间有效。
+ */
+struct LogBatch {
+  uint32_t struct_size;      // 必须是 sizeof(LogBatch)
+  uint32_t version;          // 结构体版本号
+  const LogRecord* records;  // 按到达顺序排列
+  uint64_t count;            // records 的条数
+  uint64_t dropped;  // 自上一批以来因缓冲区满而丢弃的条数
+};
+
+using LogBatchObserverCallback = std::function<void(const LogBatch&)>;
+
+/**
+ * @brief 批量观察者的投递参数。
+ */
+struct LogBatchOptions {
+  uint32_t interval_ms = 50;   // 最长攒批时间；到时即投递 (有数据时)
+  uint32_t max_batch = 1024;   // 攒够这么多条立即投递
+  uint32_t capacity = 16384;   // 两次投递之间最多缓存的条数，超出后丢弃新日志并计数
+};
+
+/**
+ * @brief 日志限流参数 (配置项 rules[].rate_limit，或运行时 SetRateLimit)。
+ * @details per_second 与 dedup_window_ms 均为 0 表示不限流。
+ */
+struct LogRateLimit {
+  uint32_t per_second = 0;       // 令牌桶速率 (条/秒)，0 = 不限速
+  uint32_t burst = 0;            // 桶容量，0 = 与 per_second 相同
+  bool per_call_site = false;    // true: 每个调用点 (文件 + 行号) 各一个桶；false: 整个 Logger 一个桶
+  uint32_t dedup_window_ms = 0;  // 去重窗口：同一调用点在窗口内只放行第一条，0 = 不去重
+};
+
+/**
+ * @brief 异步写入队列的运行统计 (见 ILogManagerService::GetQueueStats)。
+ * @details 全局线程池与所有具名线程池 (thread_pools) 的合计；network_sink 的发送队列
+ * 计入 queued / capacity，其丢弃 (队列满或发送失败) 计入 discarded。
+ */
+struct LogQueueStats {
+  uint64_t queued = 0;     // 当前积压在队列中的条数
+  uint64_t capacity = 0;   // 队列总容量 (async_queue_size 与各线程池 queue_size 之和)
+  uint64_t overrun = 0;    // overrun_oldest 策略下被挤掉的旧日志累计条数
+  uint64_t discarded = 0;  // discard_new 策略下被丢弃的新日志累计条数
+  uint32_t pools = 0;      // 参与统计的线程池个数
+  uint64_t loggers = 0;    // [v3.4] 已缓存的 Logger 个数 (按名称创建后常驻，用于发现名称泄漏)
+};
+
 /**
  * @class ILogManagerService
  * @brief [核心服务] 日志系统管理器。
@@ -138,7 +274,7 @@ using LogObserverCallback = std::function<void(const LogRecord&)>;
 class ILogManagerService : public virtual IComponent {
  public:
   Z3Y_DEFINE_INTERFACE(ILogManagerService,
-                       "z3y-core-ILogManagerService-IID-L0000003", 3, 0);
+                       "z3y-core-ILogManagerService-IID-L0000003", 3, 4);
 
   /**
    * @brief [宿主调用] 初始化日志系统。
@@ -181,9 +317,37 @@ class ILogManagerService : public virtual IComponent {
                               LogObserverCallback callback) = 0;
 
   /**
-   * @brief 移除观察者
+   * @brief 移除观察者 (逐条或批量观察者均可)。
+   * @details 返回前等待该观察者正在执行的回调结束。不可在回调内部调用。
    */
   virtual void RemoveLogObserver(const std::string& observer_name) = 0;
+
+  /**
+   * @brief [v3.1] 注册批量日志观察者。
+   * @details 日志先拷贝进观察者自己的缓冲区，由专门的投递线程按 options 攒批后
+   * 一次回调一批，适合把日志转交到 GUI 线程的日志查看器。
+   * 与逐条观察者共用名字空间，用 RemoveLogObserver 注销。
+   * @param callback 运行在投递线程上 (不是 GUI 线程，也不是写日志的线程)。
+   */
+  virtual void AddLogBatchObserver(const std::string& observer_name,
+                                   LogBatchObserverCallback callback,
+                                   const LogBatchOptions& options) = 0;
+
+  /**
+   * @brief [v3.2][运维调用] 动态设置某个前缀下 Logger 的限流参数。
+   * @details 与 SetLevel 相同：覆盖配置文件中 Rule 的 rate_limit，立即作用于已有
+   * Logger，并持久化到之后新创建的匹配 Logger。传入默认构造的 LogRateLimit 即解除限流。
+   */
+  virtual void SetRateLimit(const std::string& name_prefix,
+                            const LogRateLimit& limit) = 0;
+
+  /**
+   * @brief [v3.3][运维调用] 读取异步队列的积压与丢弃统计。
+   * @details 每个线程池的队列只短暂加锁读取计数，不影响写日志的线程；
+   * 各线程池分别读取，合计值彼此不保证严格一致。未初始化时全部为 0。
+   * [v3.4] 同时给出 Logger 缓存的大小。
+   */
+  virtual LogQueueStats GetQueueStats() = 0;
 };
 
 }  // namespace core
@@ -0,0 +1,210 @@
+﻿/*
+ * Copyright [2025] [Yue Liu]
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file i_net_event_bridge.h
+ * @brief [核心接口] 跨主机事件桥接口 INetEventBridge (plugin_net_event_bridge)。
+ * @author Yue Liu
+ * @date 2025
+ *
+ * @details
+ * [设计思想]
+ * 在不同主机上的 `PluginManager` 之间转发选定的事件，两端依旧使用普通的
+ * `SubscribeGlobal` / `FireGlobal`。事件必须用 `Z3Y_DEFINE_SERIALIZABLE_EVENT` 声明，
+ * 其 `Serialize` / `Deserialize` 就是线上的二进制格式 (见 `framework/event_serialization.h`)。
+ *
+ * - **订阅感知**：每个节点把自己 `Import` 的事件 ID 集合通告给对端。`Export` 只登记类型，
+ * 直到有远端真正导入该事件时才在本地总线上订阅；因此本地 `IsGlobalSubscribed` 对远端订阅同样成立，
+ * 没有远端订阅的事件既不序列化也不占用网络。`IsRemoteSubscribed` 可单独查询远端部分。
+ * - **批量**：发布线程只把事件追加到每个对端的批缓冲区；网络线程每次醒来把积攒的事件合并为一帧发送。
+ * - **传输**：TCP (`ListenTcp` / `ConnectTcp`，断线自动重连) 或 IPv4 UDP 组播 (`JoinMulticast`，
+ * 订阅集合周期性重发，超时作废)。
+ * - **背压**：TCP 对端积压超过 `max_pending_bytes` 时，发布线程最多等待 `backpressure_timeout_ms`，
+ * 仍无空间则丢弃并计数；组播不可靠，积压时直接丢弃。
+ *
+ * [使用示例]
+ * \code{.cpp}
+ * // 每次 CreateInstance 得到一个独立的桥 (别名 "System.NetEventBridge")
+ * auto bridge = z3y::CreateDefaultInstance<INetEventBridge>();
+ * bridge->Export<InspectResultEvent>();
+ * bridge->Import<RecipeChangedEvent>();
+ * std::string err;
+ * bridge->ListenTcp("0.0.0.0", 47100, err);
+ * bridge->ConnectTcp("cell-2:47100", err);
+ * \endcode
+ *
+ * [编码契约]
+ * 帧头与记录头按本机字节序写入，所有节点须为小端平台 (x86 / ARM)。
+ * 被导入的事件不会再被导出，多个节点互相 Export + Import 同一事件也不会来回转发。
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "framework/connection.h"
+#include "framework/event_serialization.h"
+#include "framework/i_event_bus.h"
+#include "framework/z3y_define_interface.h"
+
+namespace z3y {
+namespace interfaces {
+namespace core {
+
+/**
+ * @struct NetBridgeOptions
+ * @brief 事件桥参数，须在第一次 Listen / Connect / Join 之前通过 `Configure` 设置。
+ */
+struct NetBridgeOptions {
+  uint64_t node_id = 0;                   ///< 节点标识，0 表示随机生成 (组播据此忽略自己发出的帧)
+  size_t max_batch_bytes = 64 * 1024;     ///< TCP 单帧最多合并的事件字节数
+  size_t max_pending_bytes = 4 << 20;     ///< 每个 TCP 对端允许积压的字节数
+  int backpressure_timeout_ms = 100;      ///< 积压已满时发布线程最多等待的时间，0 表示直接丢弃
+  int reconnect_interval_ms = 1000;       ///< ConnectTcp 目标断开后的重连间隔
+  int multicast_announce_ms = 1000;       ///< 组播订阅集合的重发周期 (3 个周期未收到即作废)
+  int multicast_ttl = 1;                  ///< 组播 TTL (1 表示不出本网段)
+};
+
+/**
+ * @struct NetBridgeStats
+ * @brief 运行统计 (各计数器独立读取，彼此不保证严格一致)。
+ */
+struct NetBridgeStats {
+  uint64_t sent_events = 0;      ///< 写入至少一个对端批缓冲区的事件数
+  uint64_t sent_frames = 0;      ///< 发出的事件帧 (批) 数
+  uint64_t received_events = 0;  ///< 收到并成功发布的事件数
+  uint64_t received_frames = 0;  ///< 收到的事件帧数
+  uint64_t dropped_events = 0;   ///< 因背压或事件过大而丢弃的 (事件, 对端) 数
+  uint64_t unknown_events = 0;   ///< 收到但本端没有 Import 的事件数
+  uint64_t decode_failures = 0;  ///< 反序列化或发布时抛出异常的事件数
+  uint32_t connected_peers = 0;  ///< 当前已连接的 TCP 对端数
+};
+
+/**
+ * @class INetEventBridge
+ * @brief [插件使用] 跨主机事件桥。
+ *
+ * @section User 使用者指南
+ * - 先 `Configure` (可选)，再登记 `Export` / `Import`，最后 Listen / Connect / Join。
+ * 登记可以随时追加，新的 Import 会立即通告给所有对端。
+ * - `Import` 的事件在桥的网络线程上 `FireGlobal`。
+ * - `Export` / `Import` 登记的函数位于调用方模块中：桥必须在该模块卸载前 `Stop` 或释放。
+ */
+class INetEventBridge : public virtual IComponent {
+ public:
+  Z3Y_DEFINE_INTERFACE(INetEventBridge, "z3y-core-INetEventBridge-v1", 1, 0);
+
+  /** @brief [内部] 在本地总线上订阅某个导出事件，返回连接并通过 out_sink 交出接收者。 */
+  using ExportSubscribeFn = Connection (*)(IEventBus& bus, INetEventBridge& bridge,
+                                           std::shared_ptr<void>& out_sink);
+  /** @brief [内部] 把一条记录还原为事件并在本地总线上发布。 */
+  using ImportDecodeFn = void (*)(IEventBus& bus, EventReader& reader);
+
+  /** @brief 登记导出事件：有远端导入时才订阅本地总线并转发。 */
+  template <typename TEvent>
+  void Export() {
+    static_assert(IsSerializableEvent<TEvent>::value,
+                  "INetEventBridge::Export requires an event declared with "
+                  "Z3Y_DEFINE_SERIALIZABLE_EVENT");
+    RegisterExport(TEvent::kEventId, &SubscribeExport<TEvent>);
+  }
+
+  /** @brief 登记导入事件，并向所有对端通告订阅。 */
+  template <typename TEvent>
+  void Import() {
+    static_assert(IsSerializableEvent<TEvent>::value,
+                  "INetEventBridge::Import requires an event declared with "
+                  "Z3Y_DEFINE_SERIALIZABLE_EVENT");
+    RegisterImport(TEvent::kEventId, [](IEventBus& bus, EventReader& reader) {
+      bus.FireGlobal<TEvent>(TEvent::Deserialize(reader));
+    });
+  }
+
+  /** @brief 设置参数；网络线程启动后调用无效并返回 false。 */
+  virtual bool Configure(const NetBridgeOptions& options) = 0;
+
+  /**
+   * @brief 在 bind_address:port 上监听 TCP 连接 (可多次调用监听多个端口)。
+   * @param port 0 表示由系统分配。
+   * @return 实际监听的端口；失败返回 0 并写入 out_error。
+   */
+  virtual uint16_t ListenTcp(const std::string& bind_address, uint16_t port,
+                             std::string& out_error) = 0;
+
+  /**
+   * @brief 连接 "host:port" 上的另一个桥；连接在后台建立，断开后按间隔自动重连。
+   * @return 目标无法解析时返回 false。
+   */
+  virtual bool ConnectTcp(const std::string& target, std::string& out_error) = 0;
+
+  /**
+   * @brief 加入 IPv4 组播组 "group:port" 收发事件。
+   * @param interface_address 本机网卡地址，空表示由系统选择。
+   */
+  virtual bool JoinMulticast(const std::string& group_target,
+                             const std::string& interface_address,
+                             std::string& out_error) = 0;
+
+  /** @brief 停止网络线程、关闭所有连接并撤销导出订阅 (登记的 Export / Import 保留)。 */
+  virtual void Stop() = 0;
+
+  /** @brief 是否有任何对端导入了该事件。 */
+  virtual bool IsRemoteSubscribed(EventId event_id) const = 0;
+
+  virtual NetBridgeStats GetStats() const = 0;
+
+  /** @brief [内部] Export 的类型擦除实现。 */
+  virtual void RegisterExport(EventId event_id, ExportSubscribeFn subscribe) = 0;
+  /** @brief [内部] Import 的类型擦除实现。 */
+  virtual void RegisterImport(EventId event_id, ImportDecodeFn decode) = 0;
+  /** @brief [内部] 把一条已序列化的事件交给所有订阅了它的对端。 */
+  virtual void SendEvent(EventId event_id, const void* payload, size_t size) = 0;
+  /** @brief [内部] 当前线程是否正在发布某个桥导入的事件 (导入的事件不再导出)。 */
+  virtual bool IsDispatchingImported() const noexcept = 0;
+
+ private:
+  template <typename TEvent>
+  class ExportSink
+      : public std::enable_shared_from_this<ExportSink<TEvent>> {
+   public:
+    explicit ExportSink(INetEventBridge* bridge) : bridge_(bridge) {}
+    void OnEvent(const TEvent& e) {
+      if (bridge_->IsDispatchingImported()) return;
+      thread_local EventWriter writer;
+      writer.Clear();
+      e.Serialize(writer);
+      bridge_->SendEvent(TEvent::kEventId, writer.Buffer().data(), writer.Size());
+    }
+
+   private:
+    INetEventBridge* bridge_;
+  };
+
+  template <typename TEvent>
+  static Connection SubscribeExport(IEventBus& bus, INetEventBridge& bridge,
+                                    std::shared_ptr<void>& out_sink) {
+    auto sink = std::make_shared<ExportSink<TEvent>>(&bridge);
+    out_sink = sink;
+    return bus.SubscribeGlobal<TEvent>(sink, &ExportSink<TEvent>::OnEvent);
+  }
+};
+
+}  // namespace core
+}  // namespace interfaces
+}  // namespace z3y
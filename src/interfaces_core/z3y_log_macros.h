@@ -24,6 +24,8 @@
  * 1. **自动上下文捕获**: 利用编译器内置宏 (`__FILE__`, `__LINE__`) 自动填充位置信息。
  * 2. **零开销检查**: 在宏展开层面进行 `IsEnabled` 检查。如果日志级别未开启，后续的 `fmt::format` 格式化代码根本不会执行。
  * 3. **类型安全**: 集成 `{fmt}` 库，提供类型安全的字符串格式化。
+ * 4. **延迟格式化**: `Z3Y_LOG_DEFERRED_*` 只在调用线程拷贝参数值，格式化交给日志后台线程。
+ * 5. **结构化日志**: `Z3Y_LOG_STRUCTURED_*` 提交 "模板 + 具名字段"，字段以原始类型到达 JSON / 二进制 Sink 与观察者。
  *
  * [依赖说明]
  * 包含此头文件会引入 `<spdlog/fmt/fmt.h>`。这意味着使用此宏的插件编译时需要链接 fmt 库 (通常由 interfaces_core 传递依赖)。
@@ -34,6 +36,10 @@
 #include "interfaces_core/i_log_service.h"
 #include <spdlog/fmt/fmt.h> // 引入 fmt 库支持格式化
 
+#include <string>
+#include <string_view>
+#include <type_traits>
+
  // --- [内部] 跨平台函数名获取宏 ---
  // 不同编译器对函数名的宏定义不同，这里进行统一适配。
 #if defined(_MSC_VER)
@@ -65,13 +71,15 @@ namespace z3y {
               * 使用 do-while(0) 惯用法，确保宏在 if-else 语句中行为正确且不会引入多余的分号。
               * 1. 检查 logger_ptr 是否有效。
               * 2. 调用 IsEnabled 检查级别 (Short-circuit evaluation)。
-              * 3. 如果通过，执行 fmt::format 格式化。
-              * 4. 调用虚函数 Log 提交。
+              * 3. 调用 Admit 做限流 / 去重 (未配置时恒为 true)。
+              * 4. 如果通过，执行 fmt::format 格式化。
+              * 5. 调用虚函数 Log 提交。
               */
-#define Z3Y_LOG_IMPL(logger_ptr, level, format_str, ...) \
+#define Z3Y_LOG_IMPL(logger_ptr, level, ...) \
         do { \
-            if ((logger_ptr) && (logger_ptr)->IsEnabled(level)) { \
-                std::string formatted_msg = fmt::format(format_str, __VA_ARGS__); \
+            if ((logger_ptr) && (logger_ptr)->IsEnabled(level) && \
+                (logger_ptr)->Admit(Z3Y_LOG_SOURCE_LOCATION(), level)) { \
+                std::string formatted_msg = fmt::format(__VA_ARGS__); \
                 (logger_ptr)                                        \
                   ->Log(Z3Y_LOG_SOURCE_LOCATION(), level,         \
                         formatted_msg.c_str()); \
@@ -98,6 +106,150 @@ namespace z3y {
                 #define Z3Y_LOG_FATAL(logger_ptr, ...) Z3Y_LOG_IMPL(logger_ptr, z3y::interfaces::core::LogLevel::Fatal, __VA_ARGS__)
                 ///@}
 
+            namespace detail {
+
+            /**
+             * @brief [内部] 把一个参数值打包成 LogArg (延迟格式化用)。
+             * @details 只接受平凡可拷贝的值与字符串；枚举按底层整数输出。
+             * 字符串只记录指针与长度，内容由 ILogger::LogDeferred 在返回前拷贝。
+             */
+            template <typename T>
+            inline LogArg MakeLogArg(const T& v) noexcept {
+                LogArg a{};
+                using D = std::decay_t<T>;
+                if constexpr (std::is_same_v<D, bool>) {
+                    a.type = LogArgType::Bool; a.u64 = v ? 1 : 0;
+                } else if constexpr (std::is_same_v<D, char>) {
+                    a.type = LogArgType::Char; a.u64 = static_cast<unsigned char>(v);
+                } else if constexpr (std::is_enum_v<D>) {
+                    return MakeLogArg(static_cast<std::underlying_type_t<D>>(v));
+                } else if constexpr (std::is_integral_v<D> && std::is_signed_v<D>) {
+                    a.type = LogArgType::Int64; a.i64 = static_cast<int64_t>(v);
+                } else if constexpr (std::is_integral_v<D>) {
+                    a.type = LogArgType::UInt64; a.u64 = static_cast<uint64_t>(v);
+                } else if constexpr (std::is_floating_point_v<D>) {
+                    a.type = LogArgType::Double; a.f64 = static_cast<double>(v);
+                } else if constexpr (std::is_same_v<D, const char*> || std::is_same_v<D, char*>) {
+                    const char* p = v ? v : "(null)";
+                    a.type = LogArgType::String; a.str = p;
+                    a.size = static_cast<uint32_t>(std::char_traits<char>::length(p));
+                } else if constexpr (std::is_same_v<D, std::string> || std::is_same_v<D, std::string_view>) {
+                    a.type = LogArgType::String; a.str = v.data();
+                    a.size = static_cast<uint32_t>(v.size());
+                } else if constexpr (std::is_pointer_v<D> || std::is_null_pointer_v<D>) {
+                    a.type = LogArgType::Pointer; a.ptr = static_cast<const void*>(v);
+                } else {
+                    static_assert(sizeof(D) == 0,
+                        "Z3Y_LOG_DEFERRED_*: unsupported argument type; "
+                        "use Z3Y_LOG_* or convert it to a number / string first");
+                }
+                return a;
+            }
+
+            /**
+             * @brief [内部] 延迟格式化的提交入口。
+             * @details format 限定为字符数组引用：后台线程格式化时仍会读取它，
+             * 只有字符串字面量才能保证生命周期。
+             */
+            template <typename LoggerPtr, size_t N, typename... Args>
+            inline void LogDeferred(const LoggerPtr& logger, const LogSourceLocation& loc,
+                                    LogLevel level, const char (&format)[N],
+                                    const Args&... args) {
+                const LogArg packed[sizeof...(Args) + 1] = {MakeLogArg(args)..., LogArg{}};
+                logger->LogDeferred(loc, level, format, packed,
+                                    static_cast<uint32_t>(sizeof...(Args)));
+            }
+
+            /** @brief [内部] 构造一个结构化字段 (键限定为字符串字面量)。 */
+            template <size_t N, typename T>
+            inline LogField MakeLogField(const char (&key)[N], const T& value) noexcept {
+                return LogField{key, MakeLogArg(value)};
+            }
+
+            /** @brief [内部] 结构化日志的提交入口 (模板与延迟格式化的格式串一样须为字面量)。 */
+            template <typename LoggerPtr, size_t N, typename... Fields>
+            inline void LogStructured(const LoggerPtr& logger, const LogSourceLocation& loc,
+                                      LogLevel level, const char (&message_template)[N],
+                                      const Fields&... fields) {
+                static_assert((std::is_same_v<Fields, LogField> && ...),
+                              "Z3Y_LOG_STRUCTURED_*: fields must be Z3Y_LOG_KV(key, value)");
+                const LogField packed[sizeof...(Fields) + 1] = {fields..., LogField{}};
+                logger->LogStructured(loc, level, message_template, packed,
+                                      static_cast<uint32_t>(sizeof...(Fields)));
+            }
+
+            }  // namespace detail
+
+             /**
+              * @brief [内部] 延迟格式化日志宏实现核心。
+              * @details 与 Z3Y_LOG_IMPL 相同先检查 IsEnabled；通过后只拷贝参数值，
+              * fmt::format 在日志后台线程执行。格式串必须是字符串字面量。
+              */
+#define Z3Y_LOG_DEFERRED_IMPL(logger_ptr, level, ...) \
+        do { \
+            if ((logger_ptr) && (logger_ptr)->IsEnabled(level) && \
+                (logger_ptr)->Admit(Z3Y_LOG_SOURCE_LOCATION(), level)) { \
+                z3y::interfaces::core::detail::LogDeferred( \
+                    (logger_ptr), Z3Y_LOG_SOURCE_LOCATION(), level, __VA_ARGS__); \
+            } \
+        } while(0)
+
+             /**
+              * @name 延迟格式化日志宏 (高频路径)
+              * @brief 用法与 Z3Y_LOG_* 相同，调用线程不做格式化。
+              * @details 参数限于数值、bool、char、指针、枚举与字符串
+              * (const char* / std::string / std::string_view)，其它类型编译期报错。
+              * 格式串写错在编译期不报错，后台格式化失败时输出带 "[format error]" 的原始格式串。
+              *
+              * @example
+              * Z3Y_LOG_DEFERRED_DEBUG(logger, "frame {} score={:.3f} cam={}", frame_id, score, cam_name);
+              */
+               ///@{
+                #define Z3Y_LOG_DEFERRED_TRACE(logger_ptr, ...) Z3Y_LOG_DEFERRED_IMPL(logger_ptr, z3y::interfaces::core::LogLevel::Trace, __VA_ARGS__)
+                #define Z3Y_LOG_DEFERRED_DEBUG(logger_ptr, ...) Z3Y_LOG_DEFERRED_IMPL(logger_ptr, z3y::interfaces::core::LogLevel::Debug, __VA_ARGS__)
+                #define Z3Y_LOG_DEFERRED_INFO(logger_ptr, ...)  Z3Y_LOG_DEFERRED_IMPL(logger_ptr, z3y::interfaces::core::LogLevel::Info,  __VA_ARGS__)
+                #define Z3Y_LOG_DEFERRED_WARN(logger_ptr, ...)  Z3Y_LOG_DEFERRED_IMPL(logger_ptr, z3y::interfaces::core::LogLevel::Warn,  __VA_ARGS__)
+                #define Z3Y_LOG_DEFERRED_ERROR(logger_ptr, ...) Z3Y_LOG_DEFERRED_IMPL(logger_ptr, z3y::interfaces::core::LogLevel::Error, __VA_ARGS__)
+                #define Z3Y_LOG_DEFERRED_FATAL(logger_ptr, ...) Z3Y_LOG_DEFERRED_IMPL(logger_ptr, z3y::interfaces::core::LogLevel::Fatal, __VA_ARGS__)
+                ///@}
+
+             /**
+              * @brief 结构化日志的一个字段。key 为字符串字面量，value 的类型限制与延迟格式化参数相同。
+              */
+#define Z3Y_LOG_KV(key, value) z3y::interfaces::core::detail::MakeLogField(key, value)
+
+             /**
+              * @brief [内部] 结构化日志宏实现核心 (检查与 Z3Y_LOG_IMPL 相同)。
+              */
+#define Z3Y_LOG_STRUCTURED_IMPL(logger_ptr, level, ...) \
+        do { \
+            if ((logger_ptr) && (logger_ptr)->IsEnabled(level) && \
+                (logger_ptr)->Admit(Z3Y_LOG_SOURCE_LOCATION(), level)) { \
+                z3y::interfaces::core::detail::LogStructured( \
+                    (logger_ptr), Z3Y_LOG_SOURCE_LOCATION(), level, __VA_ARGS__); \
+            } \
+        } while(0)
+
+             /**
+              * @name 结构化日志宏
+              * @brief 第一个参数之后是模板，其后是任意个 Z3Y_LOG_KV 字段。
+              * @details 模板以字段名作占位符 (可带 fmt 格式说明)；模板未引用的字段在文本输出中以
+              * ` key=value` 追加。日志分析应读取 JSON / 二进制输出或观察者的字段，而不是解析文本。
+              *
+              * @example
+              * Z3Y_LOG_STRUCTURED_INFO(logger, "order {order} filled at {price:.2f}",
+              *                         Z3Y_LOG_KV("order", order_id), Z3Y_LOG_KV("price", price),
+              *                         Z3Y_LOG_KV("venue", venue_name));
+              */
+               ///@{
+                #define Z3Y_LOG_STRUCTURED_TRACE(logger_ptr, ...) Z3Y_LOG_STRUCTURED_IMPL(logger_ptr, z3y::interfaces::core::LogLevel::Trace, __VA_ARGS__)
+                #define Z3Y_LOG_STRUCTURED_DEBUG(logger_ptr, ...) Z3Y_LOG_STRUCTURED_IMPL(logger_ptr, z3y::interfaces::core::LogLevel::Debug, __VA_ARGS__)
+                #define Z3Y_LOG_STRUCTURED_INFO(logger_ptr, ...)  Z3Y_LOG_STRUCTURED_IMPL(logger_ptr, z3y::interfaces::core::LogLevel::Info,  __VA_ARGS__)
+                #define Z3Y_LOG_STRUCTURED_WARN(logger_ptr, ...)  Z3Y_LOG_STRUCTURED_IMPL(logger_ptr, z3y::interfaces::core::LogLevel::Warn,  __VA_ARGS__)
+                #define Z3Y_LOG_STRUCTURED_ERROR(logger_ptr, ...) Z3Y_LOG_STRUCTURED_IMPL(logger_ptr, z3y::interfaces::core::LogLevel::Error, __VA_ARGS__)
+                #define Z3Y_LOG_STRUCTURED_FATAL(logger_ptr, ...) Z3Y_LOG_STRUCTURED_IMPL(logger_ptr, z3y::interfaces::core::LogLevel::Fatal, __VA_ARGS__)
+                ///@}
+
         } // namespace core
     } // namespace interfaces
 } // namespace z3y
@@ -0,0 +1,456 @@
+﻿/**
+ * @file fleet_snapshot.h
+ * @brief 机群级 Profiler 汇总：增量快照的二进制编码与跨进程汇总器。
+ * * @details
+ * 【面向使用者】
+ * 指标导出插件配置 `System.Metrics.FleetTarget` 后，每次刷新把各节点路径自上一次发送
+ * 以来的增量（调用次数、耗时、数值累加、直方图桶）编码成 UDP 数据报发给汇总端
+ * （tool_profile_fleet，或用 FleetAggregator 自己写的服务）。汇总端按节点路径合并各进程的树，
+ * 直方图逐桶相加后得到机群分位数，并标出 p99 明显高于机群中位数的机器：
+ * \code{.cpp}
+ * FleetAggregator fleet;
+ * fleet.Ingest(datagram);  // 收到的每个数据报
+ * for (const FleetPathSummary& row : fleet.Summarize()) {
+ *   // row.percentiles 为机群分位数，row.machines 中 outlier 为 true 的是离群机器
+ * }
+ * \endcode
+ * * 【面向维护者】
+ * 1. **增量编码**：计数只发送相对上一次的差值（LEB128 变长整数），本周期没有新调用的路径
+ * 不发送；同一数据报内路径与上一条记录共享前缀，只写后缀。每个数据报可以单独解码。
+ * 2. **可合并**：直方图使用 ReportNode::histogram 的规范单位（Timer 为纳秒，Value 为
+ * kValueScale 定点值），与各机器的时钟频率无关；精度不同时按桶中点重新分桶。
+ * 3. **丢包**：UDP 不重传。每个数据报带 (会话, 序号)，汇总端按序号空洞统计丢失数；
+ * 丢失的增量不会补发，该机器的累计值会偏小，精确总数以机器自己的 /metrics 为准。
+ * 进程重启后会话号变化，序号重新计数。
+ * 4. FleetEncoder / FleetAggregator 都不加锁，由调用方串行使用。
+ */
+
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "profiler_types.h"
+
+namespace z3y::interfaces::profiler::fleet {
+
+constexpr char kFleetMagic[4] = {'Z', '3', 'F', 'L'};
+constexpr uint8_t kFleetVersion = 1;
+/// 一个数据报的上限：以太网 MTU 1500 减去 IP/UDP 头，避免分片
+constexpr size_t kFleetMaxDatagram = 1432;
+
+/**
+ * @brief 一个节点路径的统计。发送端保存累计值，数据报中携带的是增量。
+ */
+struct FleetSeries {
+  NodeType type = NodeType::Timer;
+  uint64_t count = 0;     ///< 调用 / 发生次数
+  uint64_t total_ns = 0;  ///< 耗时（Timer / Linear）
+  int64_t sum_fixed = 0;  ///< 数值累加 × kValueScale（Value）
+  uint32_t histogram_bits = 0;             ///< 直方图精度，histogram 为空时无意义
+  std::map<uint32_t, uint64_t> histogram;  ///< 桶下标 -> 次数
+};
+
+/// 按节点路径 ("Root/Child/Leaf") 索引
+using FleetSeriesMap = std::map<std::string, FleetSeries>;
+
+/** @brief 解码后的一个数据报。 */
+struct FleetDatagram {
+  std::string node;       ///< 发送端的机器名
+  uint64_t session = 0;   ///< 发送端启动时生成，重启后变化
+  uint64_t sequence = 0;  ///< 会话内从 0 起的数据报序号
+  std::vector<std::pair<std::string, FleetSeries>> records;  ///< 各路径的增量
+};
+
+namespace detail {
+
+inline void PutVarint(std::string& out, uint64_t v) {
+  while (v >= 0x80) {
+    out += static_cast<char>((v & 0x7F) | 0x80);
+    v >>= 7;
+  }
+  out += static_cast<char>(v);
+}
+
+inline bool GetVarint(std::string_view& in, uint64_t& v) {
+  v = 0;
+  for (uint32_t shift = 0; shift < 64 && !in.empty(); shift += 7) {
+    const auto byte = static_cast<uint8_t>(in.front());
+    in.remove_prefix(1);
+    v |= static_cast<uint64_t>(byte & 0x7F) << shift;
+    if (!(byte & 0x80)) return true;
+  }
+  return false;
+}
+
+inline uint64_t ZigZag(int64_t v) {
+  return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63);
+}
+
+inline int64_t UnZigZag(uint64_t v) {
+  return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+}
+
+inline bool IsTimed(NodeType type) {
+  return type == NodeType::Timer || type == NodeType::Linear;
+}
+
+/** @brief 把 src_bits 精度的桶累加到 dst_bits 精度的直方图（精度不同时按中点重新分桶）。 */
+inline void AddBuckets(std::map<uint32_t, uint64_t>& dst, uint32_t dst_bits,
+                       const std::map<uint32_t, uint64_t>& src, uint32_t src_bits) {
+  for (const auto& [index, c] : src) {
+    const uint32_t target =
+        dst_bits == src_bits
+            ? index
+            : static_cast<uint32_t>(LogHistogram::IndexOf(
+                  dst_bits, LogHistogram::MidpointOf(src_bits, index)));
+    dst[target] += c;
+  }
+}
+
+/** @brief 把 src 累加进 dst；dst 还没有直方图时沿用 src 的精度。 */
+inline void MergeSeries(FleetSeries& dst, const FleetSeries& src) {
+  dst.type = src.type;
+  dst.count += src.count;
+  dst.total_ns += src.total_ns;
+  dst.sum_fixed += src.sum_fixed;
+  if (src.histogram.empty()) return;
+  if (dst.histogram.empty()) dst.histogram_bits = src.histogram_bits;
+  AddBuckets(dst.histogram, dst.histogram_bits, src.histogram, src.histogram_bits);
+}
+
+/** @brief 稀疏直方图的分位数，换算为毫秒（Timer）或数值本身（Value）；没有样本时返回 0。 */
+inline double Percentile(const FleetSeries& s, double q) {
+  uint64_t total = 0;
+  for (const auto& bucket : s.histogram) total += bucket.second;
+  if (total == 0) return 0.0;
+  uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(total) + 0.5);
+  rank = std::min(std::max<uint64_t>(rank, 1), total);
+  uint64_t seen = 0;
+  uint64_t mid = 0;
+  for (const auto& [index, c] : s.histogram) {
+    mid = LogHistogram::MidpointOf(s.histogram_bits, index);
+    seen += c;
+    if (seen >= rank) break;
+  }
+  return IsTimed(s.type) ? static_cast<double>(mid) / 1.0e6
+                         : static_cast<double>(mid) / AggregatorNode::kValueScale;
+}
+
+/** @brief 单次平均耗时（毫秒）或平均数值。 */
+inline double Mean(const FleetSeries& s) {
+  if (s.count == 0) return 0.0;
+  const double total =
+      IsTimed(s.type) ? static_cast<double>(s.total_ns) / 1.0e6
+                      : static_cast<double>(s.sum_fixed) / AggregatorNode::kValueScale;
+  return total / static_cast<double>(s.count);
+}
+
+}  // namespace detail
+
+/**
+ * @brief 解码一个数据报。
+ * @return 魔数、版本或内容不合法时返回 false（out 的内容此时不可用）。
+ */
+inline bool DecodeFleetDatagram(std::string_view in, FleetDatagram& out) {
+  using detail::GetVarint;
+  out = FleetDatagram{};
+  if (in.size() < 5 || in.substr(0, 4) != std::string_view(kFleetMagic, 4) ||
+      static_cast<uint8_t>(in[4]) != kFleetVersion) {
+    return false;
+  }
+  in.remove_prefix(5);
+  uint64_t node_len = 0;
+  if (!GetVarint(in, node_len) || node_len > in.size()) return false;
+  out.node.assign(in.data(), static_cast<size_t>(node_len));
+  in.remove_prefix(static_cast<size_t>(node_len));
+  if (!GetVarint(in, out.session) || !GetVarint(in, out.sequence)) return false;
+
+  std::string path;
+  while (!in.empty()) {
+    uint64_t shared = 0, suffix = 0;
+    if (!GetVarint(in, shared) || !GetVarint(in, suffix) || shared > path.size() ||
+        suffix > in.size()) {
+      return false;
+    }
+    path.resize(static_cast<size_t>(shared));
+    path.append(in.data(), static_cast<size_t>(suffix));
+    in.remove_prefix(static_cast<size_t>(suffix));
+    if (in.empty()) return false;
+
+    FleetSeries s;
+    const auto head = static_cast<uint8_t>(in.front());
+    in.remove_prefix(1);
+    if ((head & 0x0F) > static_cast<uint8_t>(NodeType::Linear) ||
+        (head >> 4) > LogHistogram::kMaxPrecisionBits) {
+      return false;
+    }
+    s.type = static_cast<NodeType>(head & 0x0F);
+    s.histogram_bits = head >> 4;
+    uint64_t v = 0;
+    if (!GetVarint(in, s.count)) return false;
+    if (detail::IsTimed(s.type)) {
+      if (!GetVarint(in, s.total_ns)) return false;
+    } else if (s.type == NodeType::Value) {
+      if (!GetVarint(in, v)) return false;
+      s.sum_fixed = detail::UnZigZag(v);
+    }
+    uint64_t buckets = 0;
+    if (!GetVarint(in, buckets)) return false;
+    const size_t limit = LogHistogram::BucketCount(s.histogram_bits);
+    uint64_t index = 0;
+    for (uint64_t b = 0; b < buckets; ++b) {
+      uint64_t step = 0, c = 0;
+      if (!GetVarint(in, step) || !GetVarint(in, c)) return false;
+      index += step;
+      if (index >= limit) return false;
+      s.histogram[static_cast<uint32_t>(index)] += c;
+    }
+    out.records.emplace_back(path, std::move(s));
+  }
+  return true;
+}
+
+/**
+ * @brief 发送端：把累计值序列编码为相对上一次的增量数据报。
+ */
+class FleetEncoder {
+ public:
+  FleetEncoder(std::string node, uint64_t session)
+      : node_(std::move(node)), session_(session) {}
+
+  const std::string& GetNode() const { return node_; }
+
+  /**
+   * @brief 编码 current 相对上一次 Encode 的增量。
+   * @details 调用次数变小的路径（Profiler 被重载、累计值重新开始）以当前值为新基准，
+   * 当前值整体作为增量发送。单条记录超过 max_datagram 时独占一个数据报。
+   * @return 若干个数据报；没有新数据时为空。
+   */
+  std::vector<std::string> Encode(const FleetSeriesMap& current,
+                                  size_t max_datagram = kFleetMaxDatagram) {
+    std::vector<std::string> datagrams;
+    std::string packet;
+    std::string last_path;
+    std::string record;
+    for (const auto& [path, s] : current) {
+      const FleetSeries* base = nullptr;
+      if (auto it = previous_.find(path); it != previous_.end()) base = &it->second;
+      if (base && s.count < base->count) base = nullptr;
+      if (base ? s.count == base->count : s.count == 0) continue;
+
+      EncodeRecord(path, last_path, s, base, record);
+      if (!packet.empty() && packet.size() + record.size() > max_datagram) {
+        datagrams.push_back(std::move(packet));
+        packet.clear();
+        last_path.clear();
+        EncodeRecord(path, last_path, s, base, record);
+      }
+      if (packet.empty()) packet = Header();
+      packet += record;
+      last_path = path;
+    }
+    if (!packet.empty()) datagrams.push_back(std::move(packet));
+    previous_ = current;
+    return datagrams;
+  }
+
+ private:
+  std::string Header() {
+    std::string out(kFleetMagic, 4);
+    out += static_cast<char>(kFleetVersion);
+    detail::PutVarint(out, node_.size());
+    out += node_;
+    detail::PutVarint(out, session_);
+    detail::PutVarint(out, sequence_++);
+    return out;
+  }
+
+  static void EncodeRecord(const std::string& path, const std::string& last_path,
+                           const FleetSeries& s, const FleetSeries* base,
+                           std::string& out) {
+    using detail::PutVarint;
+    out.clear();
+    size_t shared = 0;
+    const size_t limit = std::min(path.size(), last_path.size());
+    while (shared < limit && path[shared] == last_path[shared]) ++shared;
+    PutVarint(out, shared);
+    PutVarint(out, path.size() - shared);
+    out.append(path, shared, std::string::npos);
+    out += static_cast<char>(static_cast<uint8_t>(s.type) |
+                             static_cast<uint8_t>(s.histogram_bits << 4));
+    PutVarint(out, s.count - (base ? base->count : 0));
+    if (detail::IsTimed(s.type)) {
+      const uint64_t before = base ? base->total_ns : 0;
+      PutVarint(out, s.total_ns > before ? s.total_ns - before : 0);
+    } else if (s.type == NodeType::Value) {
+      PutVarint(out, detail::ZigZag(s.sum_fixed - (base ? base->sum_fixed : 0)));
+    }
+    // 精度变化后旧桶不可比，整段重发当前直方图
+    const bool same_bits = base && base->histogram_bits == s.histogram_bits;
+    std::vector<std::pair<uint32_t, uint64_t>> buckets;
+    for (const auto& [index, c] : s.histogram) {
+      uint64_t before = 0;
+      if (same_bits) {
+        if (auto it = base->histogram.find(index); it != base->histogram.end()) {
+          before = it->second;
+        }
+      }
+      if (c > before) buckets.emplace_back(index, c - before);
+    }
+    PutVarint(out, buckets.size());
+    uint32_t previous_index = 0;
+    for (const auto& [index, c] : buckets) {
+      PutVarint(out, index - previous_index);
+      PutVarint(out, c);
+      previous_index = index;
+    }
+  }
+
+  std::string node_;
+  uint64_t session_;
+  uint64_t sequence_ = 0;
+  FleetSeriesMap previous_;  ///< 上一次 Encode 的累计值（增量的基准）
+};
+
+/** @brief 某台机器在一个路径上的统计。 */
+struct FleetMachineRow {
+  std::string node;
+  uint64_t count = 0;
+  double mean = 0.0;  ///< 单次平均耗时（毫秒）/ 平均数值
+  double p99 = 0.0;   ///< 没有直方图时等于 mean
+  bool outlier = false;
+};
+
+/** @brief 一个路径的机群汇总。 */
+struct FleetPathSummary {
+  std::string path;
+  NodeType type = NodeType::Timer;
+  uint64_t count = 0;      ///< 全机群的调用 / 发生次数
+  double total_ms = 0.0;   ///< 全机群累计耗时（Timer / Linear）
+  double sum_value = 0.0;  ///< 全机群数值累加（Value）
+  bool has_percentiles = false;
+  std::array<double, 4> percentiles{};  ///< 合并直方图的 p50 / p95 / p99 / p999
+  double median_p99 = 0.0;              ///< 各机器 p99 的中位数（离群判断的基准）
+  std::vector<FleetMachineRow> machines;  ///< 按 p99 降序
+};
+
+/** @brief 某台机器的接收状态。 */
+struct FleetMachineStatus {
+  std::string node;
+  uint64_t datagrams = 0;  ///< 收到的数据报
+  uint64_t lost = 0;       ///< 按序号空洞推断的丢失数（迟到的数据报会抵消）
+  uint64_t restarts = 0;   ///< 会话号变化的次数
+};
+
+/**
+ * @brief 汇总端：按路径与机器累加增量，输出机群分位数与离群机器。
+ */
+class FleetAggregator {
+ public:
+  /** @brief 解码并累加一个数据报；格式不合法时计入 GetMalformed 并返回 false。 */
+  bool Ingest(std::string_view datagram) {
+    FleetDatagram decoded;
+    if (!DecodeFleetDatagram(datagram, decoded)) {
+      ++malformed_;
+      return false;
+    }
+    Apply(decoded);
+    return true;
+  }
+
+  void Apply(const FleetDatagram& datagram) {
+    Machine& m = machines_[datagram.node];
+    if (m.datagrams == 0 || m.session != datagram.session) {
+      if (m.datagrams != 0) ++m.restarts;
+      m.session = datagram.session;
+      m.next_sequence = datagram.sequence + 1;
+    } else if (datagram.sequence >= m.next_sequence) {
+      m.lost += datagram.sequence - m.next_sequence;
+      m.next_sequence = datagram.sequence + 1;
+    } else if (m.lost > 0) {
+      --m.lost;  // 乱序迟到，填上之前记下的空洞
+    }
+    ++m.datagrams;
+    for (const auto& [path, delta] : datagram.records) {
+      detail::MergeSeries(paths_[path][datagram.node], delta);
+    }
+  }
+
+  /**
+   * @brief 生成各路径的机群汇总（按路径排序）。
+   * @param outlier_ratio 机器 p99 超过各机器 p99 中位数的该倍数时记为离群；
+   * 只有一台机器的路径不做判断。
+   */
+  std::vector<FleetPathSummary> Summarize(double outlier_ratio = 2.0) const {
+    static constexpr double kQuantiles[4] = {0.50, 0.95, 0.99, 0.999};
+    std::vector<FleetPathSummary> rows;
+    rows.reserve(paths_.size());
+    for (const auto& [path, per_machine] : paths_) {
+      FleetSeries fleet;
+      FleetPathSummary& row = rows.emplace_back();
+      row.path = path;
+      std::vector<double> p99s;
+      for (const auto& [node, s] : per_machine) {
+        detail::MergeSeries(fleet, s);
+        FleetMachineRow& machine = row.machines.emplace_back();
+        machine.node = node;
+        machine.count = s.count;
+        machine.mean = detail::Mean(s);
+        machine.p99 = s.histogram.empty() ? machine.mean : detail::Percentile(s, 0.99);
+        p99s.push_back(machine.p99);
+      }
+      row.type = fleet.type;
+      row.count = fleet.count;
+      row.total_ms = static_cast<double>(fleet.total_ns) / 1.0e6;
+      row.sum_value = static_cast<double>(fleet.sum_fixed) / AggregatorNode::kValueScale;
+      if (!fleet.histogram.empty() && fleet.type != NodeType::Event) {
+        row.has_percentiles = true;
+        for (size_t q = 0; q < 4; ++q) {
+          row.percentiles[q] = detail::Percentile(fleet, kQuantiles[q]);
+        }
+      }
+      std::sort(p99s.begin(), p99s.end());
+      row.median_p99 = p99s[(p99s.size() - 1) / 2];
+      for (FleetMachineRow& machine : row.machines) {
+        machine.outlier = row.machines.size() > 1 && row.median_p99 > 0.0 &&
+                          machine.p99 > row.median_p99 * outlier_ratio;
+      }
+      std::sort(row.machines.begin(), row.machines.end(),
+                [](const FleetMachineRow& a, const FleetMachineRow& b) {
+                  return a.p99 > b.p99;
+                });
+    }
+    return rows;
+  }
+
+  std::vector<FleetMachineStatus> GetMachines() const {
+    std::vector<FleetMachineStatus> out;
+    for (const auto& [node, m] : machines_) {
+      out.push_back({node, m.datagrams, m.lost, m.restarts});
+    }
+    return out;
+  }
+
+  uint64_t GetMalformed() const { return malformed_; }
+
+ private:
+  struct Machine {
+    uint64_t session = 0;
+    uint64_t next_sequence = 0;
+    uint64_t datagrams = 0;
+    uint64_t lost = 0;
+    uint64_t restarts = 0;
+  };
+
+  std::map<std::string, Machine> machines_;
+  std::map<std::string, std::map<std::string, FleetSeries>> paths_;  ///< 路径 -> 机器 -> 累计
+  uint64_t malformed_ = 0;
+};
+
+}  // namespace z3y::interfaces::profiler::fleet
@@ -0,0 +1,44 @@
+﻿/**
+ * @file i_metrics_exporter.h
+ * @brief 性能指标导出插件（plugin_metrics_exporter）的纯虚接口定义。
+ * * @details
+ * 【面向使用者】
+ * 加载 plugin_metrics_exporter 后，Profiler 的数据会按 `System.Metrics.IntervalMs`
+ * 周期性地转换为时序指标：
+ * - `System.Metrics.HttpPort` > 0 时，在该端口提供 OpenMetrics 文本 (`GET /metrics`)，
+ * 可直接被 Prometheus 抓取；
+ * - `System.Metrics.StatsdTarget` 为 "host:port" 时，按 UDP 批量推送 StatsD 行。
+ * 业务代码不需要改动，现有的 Z3Y_PROFILE_ROOT / Z3Y_PROFILE / Z3Y_PROFILE_VALUE 探针即是数据源。
+ * 本接口只在需要手动触发刷新或直接读取文本时使用（例如测试、嵌入自己的 HTTP 服务）。
+ */
+
+#pragma once
+#include <cstdint>
+#include <string>
+
+#include "framework/i_component.h"
+#include "framework/z3y_define_interface.h"
+
+namespace z3y::interfaces::profiler {
+
+/**
+ * @brief 指标导出服务对外提供的接口规范。
+ */
+class IMetricsExporter : public virtual z3y::IComponent {
+ public:
+  Z3Y_DEFINE_INTERFACE(IMetricsExporter, "z3y-core-IMetricsExporter-v1", 1, 0);
+
+  /**
+   * @brief 立即拍一次快照并重建指标（StatsD 开启时顺带推送一次）。
+   * @details 后台线程按周期自动调用；手动调用不会打乱周期。
+   */
+  virtual void Refresh() = 0;
+
+  /** @brief 最近一次刷新得到的 OpenMetrics 文本，与 HTTP `/metrics` 的响应相同。 */
+  virtual std::string RenderOpenMetrics() const = 0;
+
+  /** @brief HTTP 端点实际监听的端口；未开启或监听失败时为 0。 */
+  virtual uint16_t GetHttpPort() const = 0;
+};
+
+}  // namespace z3y::interfaces::profiler
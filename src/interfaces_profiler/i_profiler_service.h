@@ -11,8 +11,13 @@
  */
 
 #pragma once
+#include <memory>
+#include <string>
+#include <vector>
+
 #include "framework/i_component.h"
 #include "framework/z3y_define_interface.h"
+#include "profiler_report.h"
 #include "profiler_types.h"
 
 namespace z3y::interfaces::profiler {
@@ -22,7 +27,7 @@ namespace z3y::interfaces::profiler {
  */
 class IProfilerService : public virtual z3y::IComponent {
  public:
-  Z3Y_DEFINE_INTERFACE(IProfilerService, "z3y-core-IProfilerService-v2", 2, 0);
+  Z3Y_DEFINE_INTERFACE(IProfilerService, "z3y-core-IProfilerService-v2", 2, 15);
 
   /**
    * @brief 检查当前性能分析器是否处于启用状态。
@@ -89,6 +94,187 @@ class IProfilerService : public virtual z3y::IComponent {
    * @param frame_id 需要结束的帧 ID。
    */
   virtual void AsyncCommit(uint64_t frame_id) = 0;
+
+  /**
+   * @brief [v2.1] 注册一个结构化报告接收器。
+   * @details 之后的每份报告都会以 ProfileReport 快照的形式，在后台线程上投递给它
+   * （与文本日志并行）。重复注册同一个对象无效果。
+   */
+  virtual void AddReportSink(std::shared_ptr<IProfilerReportSink> sink) = 0;
+
+  /** @brief [v2.1] 注销接收器。返回后不会再有新的回调开始。 */
+  virtual void RemoveReportSink(const std::shared_ptr<IProfilerReportSink>& sink) = 0;
+
+  /**
+   * @brief [v2.1] 阻塞直到已提交的报告全部输出（文本日志与所有 Sink）。
+   * @details 报告的格式化在后台线程进行，需要读取报告结果的代码（例如测试）应先调用它。
+   */
+  virtual void FlushReports() = 0;
+
+  /**
+   * @brief [v2.2] 登记一个探针并写回它的 probe_key。
+   * @details 由宏在探针首次于本服务实例下执行时调用，业务代码无需直接使用。
+   * 同一位置（文件、行号、名字）的探针总是得到同一个下标。
+   * @return 新的 probe_key。
+   */
+  virtual uint64_t RegisterProbe(ProfileNodeData* data) = 0;
+
+  /**
+   * @brief [v2.2] 按名字 / 源文件 / 模块启用或禁用一批探针。
+   * @details 规则会被保留，之后才首次执行（或之后才加载的模块中）的探针同样适用；
+   * 后设置的规则覆盖先设置的规则。只翻转服务内部的位图，探针热路径不变。
+   * @return 当前已登记的探针中命中该规则的个数。
+   */
+  virtual size_t SetProbesEnabled(ProbeMatch match, const std::string& pattern,
+                                  bool enabled) = 0;
+
+  /** @brief [v2.2] 列出全部已登记的探针。 */
+  virtual std::vector<ProbeInfo> GetProbes() const = 0;
+
+  /**
+   * @brief [v2.3] 为当前线程的影子栈扩容（容量翻倍）。
+   * @details 由宏在影子栈已满时调用。存储由服务分配，线程退出时由服务释放。
+   * @return false 表示已达 ProfilerThreadState::kMaxStackDepth，
+   * 本次溢出会计入下一份报告的 depth_overflows。
+   */
+  virtual bool GrowShadowStack(ProfilerThreadState* state) = 0;
+
+  /**
+   * @brief [v2.3] 为当前线程新建一个独立根节点，并登记到 state->thread_roots。
+   * @details 由 Z3Y_PROFILE_ROOT 在本线程首次执行某个根探针时调用。
+   * @return 新的根节点；节点池耗尽时返回 nullptr。
+   */
+  virtual AggregatorNode* AcquireThreadRoot(ProfilerThreadState* state,
+                                            ProfileNodeData* data) = 0;
+
+  /** @brief [v2.4] 查询 Profiler 自身的内存占用（节点池、直方图）。 */
+  virtual ProfilerMemoryStats GetMemoryStats() const = 0;
+
+  /**
+   * @brief [v2.5] 确保节点挂有冷数据块（数值统计 + 标签），并返回它。
+   * @details 由宏在节点第一次记录数值或绑定标签时调用。已挂上时直接返回原有的块；
+   * 并发调用同一节点只会分配一块。块归服务所有，随节点一起复用。
+   */
+  virtual NodeColdStats* AttachColdStats(AggregatorNode* node) = 0;
+
+  /**
+   * @brief [v2.6] 取得采样模式的累计结果（System.Profiler.SamplingHz > 0 时有效）。
+   * @param max_symbols symbols 列表最多保留的项数（按样本数取前 N）。
+   * @details 地址到模块 / 符号的解析在调用线程上完成，开销与不同地址的数量成正比，
+   * 不要在热路径上调用。修改采样频率会开始新的会话并清空之前的样本。
+   */
+  virtual SamplingProfile GetSamplingProfile(size_t max_symbols) const = 0;
+
+  /**
+   * @brief [v2.7] 读取当前线程的硬件性能计数器（累计值）。
+   * @details 由 Z3Y_PROFILE_ROOT 在作用域的开始与结束各调用一次。计数器组在每个线程
+   * 第一次调用时打开，线程退出时关闭。
+   * @return false 表示未开启 System.Profiler.HardwareCounters，或平台 / 权限不支持。
+   */
+  virtual bool ReadHardwareCounters(HardwareCounterSample& out) = 0;
+
+  /** @brief [v2.7] 把一个作用域的计数器增量累加到节点上（挂在节点的冷数据中）。 */
+  virtual void RecordHardwareCounters(AggregatorNode* node,
+                                      const HardwareCounterSample& delta) = 0;
+
+  /**
+   * @brief [v2.8] 为所有线程的独立根节点 (Z3Y_PROFILE_ROOT) 各拍一份快照，不重置数据。
+   * @details 供指标导出等需要实时读数的组件周期性调用。快照中的计数是自该根节点上一次
+   * 输出报告（周期 / SLA 触发后清零）以来的累计值；已输出的部分通过 IProfilerReportSink 获得。
+   * 异步流 (ASYNC_BEGIN) 的根节点生命周期只有一帧，不在其中；开启 System.Profiler.EventBusHook
+   * 后，事件总线的共享根节点 "EventBus" 也在其中。
+   */
+  virtual std::vector<ProfileReport> SnapshotLiveRoots() = 0;
+
+  /**
+   * @brief [v2.9] 收集异步流的跨线程追踪事件（System.Profiler.TraceRingSize > 0 时有效）。
+   * @details 用 WriteChromeTrace 输出后可在 Perfetto / chrome://tracing 中查看每帧经过的
+   * 线程与阶段之间的排队时间。
+   * @param clear 为 true 时收集后清空各线程的缓冲区。
+   */
+  virtual TraceCapture CollectTrace(bool clear) = 0;
+
+  /**
+   * @brief [v2.10] 驻留一个字符串，返回它的编号，供 Z3Y_PROFILE_TAG_ID 使用。
+   * @details 相同内容总是得到同一个编号；字符串由服务拷贝保存，报告时再解析回文本。
+   * 编号只在本服务实例内有效。内部加锁，应在初始化时驻留一次后缓存编号，不要每次调用。
+   * @return 从 1 开始的编号；text 为空或驻留表已满时返回 0（报告中显示为 "(other)"）。
+   */
+  virtual uint32_t InternTagString(const char* text) = 0;
+
+  /**
+   * @brief [v2.11] 取得调用点 site 下键 key 的分组根节点，并登记为它的写入者。
+   * @details 由 Z3Y_PROFILE_ROOT_KEYED 调用。每个 (site, key) 一棵独立的树，所有线程共享；
+   * 查找无锁，只有新键才加锁插入。分组数达到 System.Profiler.KeyedRootCapacity 时
+   * 先输出并淘汰最久未用的分组。
+   * @param[out] handle 交给 EndKeyedRoot 的句柄。
+   * @return 根节点；Profiler 未启用、或每个分组都正被使用而无法淘汰时返回 nullptr。
+   */
+  virtual AggregatorNode* BeginKeyedRoot(ProfileNodeData* site, uint64_t key,
+                                         uint32_t* handle) = 0;
+
+  /**
+   * @brief [v2.11] 结束一次分组根作用域：计数、按周期 / SLA 出报告，并注销写入者。
+   * @details 调用前由宏把本次耗时累加到根节点上（与 SubmitRootForCheck 相同）。
+   */
+  virtual void EndKeyedRoot(uint32_t handle, uint32_t period, double sla_ms) = 0;
+
+  /**
+   * @brief [v2.12] 框架锁的竞争排名（System.Profiler.LockContention 开启期间持续累积）。
+   * @details 每项是一把锁在一个加锁调用点上的统计，按累计等待时间降序排列；同一批数据也以
+   * "Locks" 根节点计入聚合树（见 SnapshotLiveRoots / 周期报告）。框架未以 Z3Y_LOCK_PROFILING
+   * 构建时为空。
+   * @param max_entries 最多返回的条目数，0 表示不限。
+   */
+  virtual std::vector<LockContentionEntry> GetLockContention(
+      size_t max_entries) const = 0;
+
+  /**
+   * @brief [v2.13] 记录节拍根 (Z3Y_PROFILE_ROOT_PACED) 的一帧。
+   * @details 由宏在作用域结束、SubmitRootForCheck 之前调用，只用于本线程的独立根。
+   * 统计相邻两帧开始时刻的间隔与抖动，并按帧记下各直接子节点的耗时，
+   * 随该根的下一份报告输出（ProfileReport::pacing）。
+   * @param cadence_ms 期望的帧间隔（毫秒）。
+   * @param start_ticks / end_ticks 本帧作用域的开始与结束时刻（ProfilerClock）。
+   */
+  virtual void RecordPacedFrame(AggregatorNode* root, double cadence_ms,
+                                uint64_t start_ticks, uint64_t end_ticks) = 0;
+
+  /**
+   * @brief [v2.14] 为当前线程取得飞行记录器的环，写入 state->flight_ring / flight_ring_session。
+   * @details 由宏在会话号变化（开启或改容量）后第一次记录时调用。飞行记录器关闭时
+   * flight_ring 置空。线程退出后它的环留给之后的新线程复用。
+   */
+  virtual void AcquireFlightRing(ProfilerThreadState* state) = 0;
+
+  /**
+   * @brief [v2.14] 立即冻结飞行记录器：把各线程环中最近 System.Profiler.FlightRecorderWindowMs
+   * 内的作用域记录拷贝成一份 FlightRecording（SLA 超时时服务会自动冻结，每个窗口至多一次）。
+   * @return false 表示飞行记录器未开启。
+   */
+  virtual bool FreezeFlightRecorder(const std::string& reason) = 0;
+
+  /**
+   * @brief [v2.14] 取走已冻结的记录（最多保留最近 8 份），按冻结顺序排列。
+   * @details 可用 WriteChromeTrace(os, recording.trace) 输出为时间线。
+   */
+  virtual std::vector<FlightRecording> TakeFlightRecordings() = 0;
+
+  /**
+   * @brief [v2.15] 提交一段已在设备队列上打好首尾标记的区间（由 Z3Y_PROFILE_DEVICE 调用）。
+   * @details 不阻塞：设备轮询线程稍后解析出设备耗时，记入 "Devices" 根下的
+   * 设备名 / 探针名节点，追踪开启时另在设备轨道上输出区间。标记的所有权随之移交给服务。
+   * @param host_begin_ticks 打首标记之前的主机时刻（ProfilerClock），用于对齐时钟。
+   */
+  virtual void SubmitDeviceSpan(std::shared_ptr<IDeviceTimestampSource> source,
+                                ProfileNodeData* data, uint64_t begin_marker,
+                                uint64_t end_marker, uint64_t host_begin_ticks) = 0;
+
+  /**
+   * @brief [v2.15] 等待已提交的设备区间全部解析，最多等 timeout_ms 毫秒。
+   * @return 仍未解析的区间数（0 表示全部记入）。
+   */
+  virtual size_t FlushDeviceSpans(uint32_t timeout_ms) = 0;
 };
 
 }  // namespace z3y::interfaces::profiler
@@ -0,0 +1,12 @@
+﻿/**
+ * @file perfetto_track_storage.cpp
+ * @brief Perfetto track event 类别的静态存储。
+ * @details
+ * 仅在 Z3Y_PROFILE_PERFETTO=1 时由 interfaces_profiler 作为 INTERFACE 源文件
+ * 注入每个链接它的目标；每个模块（宿主 / 插件）持有各自的一份类别注册表。
+ */
+#include "interfaces_profiler/profiler_backend.h"
+
+#if Z3Y_PROFILE_PERFETTO
+PERFETTO_TRACK_EVENT_STATIC_STORAGE_IN_NAMESPACE(z3y_perfetto);
+#endif
@@ -0,0 +1,234 @@
+﻿/**
+ * @file profiler_backend.h
+ * @brief Z3Y_PROFILE* 宏的编译期后端选择：内置聚合器、Tracy、Perfetto，可同时开启。
+ * * @details
+ * 【面向使用者】
+ * 同一套宏可以同时送进外部时间线工具，业务代码不需要重新插桩。后端由 CMake 选项决定
+ * （向所有链接 interfaces_profiler 的目标公开同名宏，整个工程保持一致）：
+ * - `Z3Y_PROFILE_AGGREGATOR`（默认 ON）：内置聚合树、SLA 报告、IProfilerReportSink。
+ * - `Z3Y_PROFILE_TRACY`：每个作用域同时是一个 Tracy zone（`find_package(Tracy)`，
+ *   链接 `Tracy::TracyClient`，请以共享库方式构建 TracyClient，让所有插件共用一个实例）。
+ * - `Z3Y_PROFILE_PERFETTO`：每个作用域同时是一个 Perfetto track event，类别为 "z3y"
+ *   （`Z3Y_PERFETTO_SDK_DIR` 指向 SDK 的 perfetto.h / perfetto.cc）。
+ *
+ * 宏与外部事件的对应关系：
+ * | 宏                         | Tracy                    | Perfetto                          |
+ * |----------------------------|--------------------------|-----------------------------------|
+ * | PROFILE / NAMED / ROOT / LINEAR | zone                | TRACE_EVENT 切片                  |
+ * | NEXT                       | 消息（步骤分界）         | 即时事件                          |
+ * | VALUE                      | TracyPlot                | TRACE_COUNTER                     |
+ * | EVENT                      | 消息                     | 即时事件                          |
+ * | TAG*                       | 消息 "键: 值"            | 即时事件，键值作为参数            |
+ * | ASYNC_BEGIN / COMMIT       | 消息 "名字 #id"          | 以 id 为轨道的异步切片            |
+ * | ASYNC_ATTACH               | 消息                     | 带 flow (id) 的即时事件           |
+ *
+ * Perfetto 的类别存储每个模块（EXE / DLL / SO）一份：开启后 interfaces_profiler 会把
+ * perfetto_track_storage.cpp 编进每个链接它的目标。每个模块在 `perfetto::Tracing::Initialize`
+ * 之后调用一次 `z3y::interfaces::profiler::RegisterPerfettoTrackEvents()`；插件模块之间
+ * 互相独立，推荐使用系统后端 (traced) 统一收集。
+ *
+ * 【面向维护者】
+ * 这里只定义 `Z3Y_PROF_EXT_*` 适配宏，profiler_macros.h 把它们与聚合器部分拼在一起。
+ * 作用域类的适配宏展开为声明语句（变量名带 __LINE__），不得另开语句块，否则 zone 会提前结束。
+ * 没有外部后端时全部展开为 `static_cast<void>(0)`，与原来的宏完全等价。
+ */
+
+#pragma once
+
+#ifndef Z3Y_PROFILE_AGGREGATOR
+#define Z3Y_PROFILE_AGGREGATOR 1
+#endif
+#ifndef Z3Y_PROFILE_TRACY
+#define Z3Y_PROFILE_TRACY 0
+#endif
+#ifndef Z3Y_PROFILE_PERFETTO
+#define Z3Y_PROFILE_PERFETTO 0
+#endif
+
+#if Z3Y_PROFILE_TRACY || Z3Y_PROFILE_PERFETTO
+#include <cstdint>
+#include <cstdio>  // std::snprintf
+#endif
+
+#if Z3Y_PROFILE_TRACY
+#include <tracy/Tracy.hpp>
+#endif
+
+#if Z3Y_PROFILE_PERFETTO
+#include <perfetto.h>
+
+PERFETTO_DEFINE_CATEGORIES_IN_NAMESPACE(
+    z3y_perfetto,
+    perfetto::Category("z3y").SetDescription("Z3Y_PROFILE* probes"));
+
+namespace z3y::interfaces::profiler {
+/**
+ * @brief 登记本模块的 "z3y" 类别。每个模块在 perfetto::Tracing::Initialize 之后调用一次。
+ */
+inline void RegisterPerfettoTrackEvents() { z3y_perfetto::TrackEvent::Register(); }
+}  // namespace z3y::interfaces::profiler
+
+/** 让随后的 TRACE_EVENT 使用 z3y_perfetto 的类别（块作用域的命名空间别名，可重复声明） */
+#define Z3Y_PROF_PERFETTO_NS() \
+  PERFETTO_USE_CATEGORIES_FROM_NAMESPACE_SCOPED(z3y_perfetto)
+#endif
+
+namespace z3y::interfaces::profiler::backend {
+#if Z3Y_PROFILE_TRACY
+/** @brief 以 "键: 值" 的形式发一条 Tracy 消息（截断到 128 字节，不分配）。 */
+inline void TracyTag(const char* key, const char* value) {
+  char text[128];
+  const int len = std::snprintf(text, sizeof(text), "%s: %s", key ? key : "",
+                                value ? value : "");
+  if (len > 0) {
+    TracyMessage(text, static_cast<size_t>(len) < sizeof(text)
+                           ? static_cast<size_t>(len)
+                           : sizeof(text) - 1);
+  }
+}
+
+inline void TracyTagInt(const char* key, int64_t value) {
+  char text[96];
+  const int len = std::snprintf(text, sizeof(text), "%s: %lld", key ? key : "",
+                                static_cast<long long>(value));
+  if (len > 0) TracyMessage(text, static_cast<size_t>(len) < sizeof(text)
+                                      ? static_cast<size_t>(len)
+                                      : sizeof(text) - 1);
+}
+
+/** @brief 发一条静态文本消息（text 必须是字符串字面量，Tracy 只保存指针）。 */
+inline void TracyMark(const char* text) { TracyMessageL(text); }
+
+/** @brief 记录一个绘图点（name 必须是字符串字面量）。 */
+inline void TracyValue(const char* name, double value) { TracyPlot(name, value); }
+
+/** @brief 异步流的阶段标记："名字 #id"。 */
+inline void TracyAsyncMark(const char* what, uint64_t id) {
+  char text[96];
+  const int len = std::snprintf(text, sizeof(text), "%s #%llu", what,
+                                static_cast<unsigned long long>(id));
+  if (len > 0) TracyMessage(text, static_cast<size_t>(len) < sizeof(text)
+                                      ? static_cast<size_t>(len)
+                                      : sizeof(text) - 1);
+}
+#endif
+}  // namespace z3y::interfaces::profiler::backend
+
+// --- 作用域 (展开为声明，随所在作用域结束) ---
+#if Z3Y_PROFILE_TRACY
+#define Z3Y_PROF_TRACY_SCOPE_FUNC() ZoneNamed(Z3Y_PROF_CAT(_tz, __LINE__), true)
+#define Z3Y_PROF_TRACY_SCOPE(name) \
+  ZoneNamedN(Z3Y_PROF_CAT(_tz, __LINE__), "" name "", true)
+#else
+#define Z3Y_PROF_TRACY_SCOPE_FUNC() static_cast<void>(0)
+#define Z3Y_PROF_TRACY_SCOPE(name) static_cast<void>(0)
+#endif
+
+#if Z3Y_PROFILE_PERFETTO
+#define Z3Y_PROF_PERFETTO_SCOPE_FUNC() \
+  Z3Y_PROF_PERFETTO_NS();              \
+  TRACE_EVENT("z3y", perfetto::StaticString{__FUNCTION__})
+#define Z3Y_PROF_PERFETTO_SCOPE(name) \
+  Z3Y_PROF_PERFETTO_NS();             \
+  TRACE_EVENT("z3y", "" name "")
+#else
+#define Z3Y_PROF_PERFETTO_SCOPE_FUNC() static_cast<void>(0)
+#define Z3Y_PROF_PERFETTO_SCOPE(name) static_cast<void>(0)
+#endif
+
+#define Z3Y_PROF_EXT_SCOPE_FUNC() \
+  Z3Y_PROF_TRACY_SCOPE_FUNC();    \
+  Z3Y_PROF_PERFETTO_SCOPE_FUNC()
+#define Z3Y_PROF_EXT_SCOPE(name) \
+  Z3Y_PROF_TRACY_SCOPE(name);    \
+  Z3Y_PROF_PERFETTO_SCOPE(name)
+
+// --- 单点事件 (void 表达式，可与聚合器部分组成逗号表达式) ---
+#if Z3Y_PROFILE_TRACY
+// 经由内联函数调用：Tracy 的宏在未定义 TRACY_ENABLE 时展开为空，不能放进逗号表达式
+#define Z3Y_PROF_TRACY_MARK(name) \
+  z3y::interfaces::profiler::backend::TracyMark("" name "")
+#define Z3Y_PROF_TRACY_VALUE(name, val)             \
+  z3y::interfaces::profiler::backend::TracyValue( \
+      "" name "", static_cast<double>(val))
+#define Z3Y_PROF_TRACY_TAG(k, v) \
+  z3y::interfaces::profiler::backend::TracyTag(k, v)
+#define Z3Y_PROF_TRACY_TAG_INT(k, v) \
+  z3y::interfaces::profiler::backend::TracyTagInt(k, static_cast<int64_t>(v))
+#define Z3Y_PROF_TRACY_ASYNC(what, id)              \
+  z3y::interfaces::profiler::backend::TracyAsyncMark( \
+      what, static_cast<uint64_t>(id))
+#else
+#define Z3Y_PROF_TRACY_MARK(name) static_cast<void>(0)
+#define Z3Y_PROF_TRACY_VALUE(name, val) static_cast<void>(0)
+#define Z3Y_PROF_TRACY_TAG(k, v) static_cast<void>(0)
+#define Z3Y_PROF_TRACY_TAG_INT(k, v) static_cast<void>(0)
+#define Z3Y_PROF_TRACY_ASYNC(what, id) static_cast<void>(0)
+#endif
+
+#if Z3Y_PROFILE_PERFETTO
+// TRACE_EVENT_* 是语句：包进立即调用的 lambda，才能与聚合器部分组成逗号表达式
+#define Z3Y_PROF_PERFETTO_MARK(name)        \
+  [&] {                                     \
+    Z3Y_PROF_PERFETTO_NS();                 \
+    TRACE_EVENT_INSTANT("z3y", "" name ""); \
+  }()
+#define Z3Y_PROF_PERFETTO_VALUE(name, val)                      \
+  [&] {                                                         \
+    Z3Y_PROF_PERFETTO_NS();                                     \
+    TRACE_COUNTER("z3y", "" name "", static_cast<double>(val)); \
+  }()
+#define Z3Y_PROF_PERFETTO_TAG(k, v)                            \
+  [&] {                                                        \
+    Z3Y_PROF_PERFETTO_NS();                                    \
+    TRACE_EVENT_INSTANT("z3y", "Tag", "key", k, "value", v);   \
+  }()
+#define Z3Y_PROF_PERFETTO_TAG_INT(k, v)                   \
+  [&] {                                                   \
+    Z3Y_PROF_PERFETTO_NS();                               \
+    TRACE_EVENT_INSTANT("z3y", "Tag", "key", k, "value",  \
+                        static_cast<int64_t>(v));         \
+  }()
+#define Z3Y_PROF_PERFETTO_ASYNC_BEGIN(name, id)                    \
+  [&] {                                                            \
+    Z3Y_PROF_PERFETTO_NS();                                        \
+    const auto z3y_flow_id = static_cast<uint64_t>(id);            \
+    TRACE_EVENT_BEGIN("z3y", "" name "", perfetto::Track(z3y_flow_id), \
+                      perfetto::Flow::ProcessScoped(z3y_flow_id)); \
+  }()
+#define Z3Y_PROF_PERFETTO_ASYNC_ATTACH(id)                         \
+  [&] {                                                            \
+    Z3Y_PROF_PERFETTO_NS();                                        \
+    TRACE_EVENT_INSTANT(                                           \
+        "z3y", "AsyncAttach",                                      \
+        perfetto::Flow::ProcessScoped(static_cast<uint64_t>(id))); \
+  }()
+#define Z3Y_PROF_PERFETTO_ASYNC_COMMIT(id)                                  \
+  [&] {                                                                     \
+    Z3Y_PROF_PERFETTO_NS();                                                 \
+    TRACE_EVENT_END("z3y", perfetto::Track(static_cast<uint64_t>(id)));     \
+  }()
+#else
+#define Z3Y_PROF_PERFETTO_MARK(name) static_cast<void>(0)
+#define Z3Y_PROF_PERFETTO_VALUE(name, val) static_cast<void>(0)
+#define Z3Y_PROF_PERFETTO_TAG(k, v) static_cast<void>(0)
+#define Z3Y_PROF_PERFETTO_TAG_INT(k, v) static_cast<void>(0)
+#define Z3Y_PROF_PERFETTO_ASYNC_BEGIN(name, id) static_cast<void>(0)
+#define Z3Y_PROF_PERFETTO_ASYNC_ATTACH(id) static_cast<void>(0)
+#define Z3Y_PROF_PERFETTO_ASYNC_COMMIT(id) static_cast<void>(0)
+#endif
+
+#define Z3Y_PROF_EXT_MARK(name) \
+  (Z3Y_PROF_TRACY_MARK(name), Z3Y_PROF_PERFETTO_MARK(name))
+#define Z3Y_PROF_EXT_VALUE(name, val) \
+  (Z3Y_PROF_TRACY_VALUE(name, val), Z3Y_PROF_PERFETTO_VALUE(name, val))
+#define Z3Y_PROF_EXT_TAG(k, v) \
+  (Z3Y_PROF_TRACY_TAG(k, v), Z3Y_PROF_PERFETTO_TAG(k, v))
+#define Z3Y_PROF_EXT_TAG_INT(k, v) \
+  (Z3Y_PROF_TRACY_TAG_INT(k, v), Z3Y_PROF_PERFETTO_TAG_INT(k, v))
+#define Z3Y_PROF_EXT_ASYNC_BEGIN(name, id) \
+  (Z3Y_PROF_TRACY_ASYNC("" name "", id), Z3Y_PROF_PERFETTO_ASYNC_BEGIN(name, id))
+#define Z3Y_PROF_EXT_ASYNC_ATTACH(id) \
+  (Z3Y_PROF_TRACY_ASYNC("AsyncAttach", id), Z3Y_PROF_PERFETTO_ASYNC_ATTACH(id))
+#define Z3Y_PROF_EXT_ASYNC_COMMIT(id) \
+  (Z3Y_PROF_TRACY_ASYNC("AsyncCommit", id), Z3Y_PROF_PERFETTO_ASYNC_COMMIT(id))
@@ -0,0 +1,88 @@
+﻿/**
+ * @file profiler_clock.h
+ * @brief 探针使用的低开销时钟源（TSC / 通用计时器）。
+ * * @details
+ * 【面向使用者】
+ * 你不需要直接使用本文件，`Z3Y_PROFILE()` 等宏会自动使用它。
+ * * 【面向维护者】
+ * `std::chrono::steady_clock::now()` 在 Linux 上要经过 vDSO，在 Windows 上是
+ * `QueryPerformanceCounter`，再加上每次作用域退出时的 double 换算，
+ * 对内层循环里的探针来说太贵了。这里直接读取硬件计数器：
+ * - x86/x64：`rdtsc`（现代 CPU 的 invariant TSC 频率恒定，且各核同步）。
+ * - AArch64：`cntvct_el0`，频率直接从 `cntfrq_el0` 读取，无需校准。
+ * - 其他平台：退化为 steady_clock 纳秒。
+ * 探针只累加原始 tick，生成报告时才调用 `TicksToMs` 换算。
+ * x86 的频率在首次换算时用 steady_clock 校准一次（约 5ms，只发生在生成报告的线程上）。
+ */
+
+#pragma once
+#include <chrono>
+#include <cstdint>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define Z3Y_PROFILER_CLOCK_TSC 1
+#elif (defined(__GNUC__) || defined(__clang__)) && \
+    (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define Z3Y_PROFILER_CLOCK_TSC 1
+#elif (defined(__GNUC__) || defined(__clang__)) && defined(__aarch64__)
+#define Z3Y_PROFILER_CLOCK_CNTVCT 1
+#endif
+
+namespace z3y::interfaces::profiler {
+
+/**
+ * @brief 探针时钟。`Now()` 返回原始 tick，只能与同一时钟的 tick 相减。
+ */
+struct ProfilerClock {
+  /** @brief 读取当前 tick（热路径：一条指令）。 */
+  static inline uint64_t Now() noexcept {
+#if defined(Z3Y_PROFILER_CLOCK_TSC)
+    return __rdtsc();
+#elif defined(Z3Y_PROFILER_CLOCK_CNTVCT)
+    uint64_t ticks;
+    __asm__ volatile("mrs %0, cntvct_el0" : "=r"(ticks));
+    return ticks;
+#else
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch())
+            .count());
+#endif
+  }
+
+  /** @brief 每毫秒的 tick 数（首次调用时确定，之后为常量）。 */
+  static inline double TicksPerMs() noexcept {
+    static const double ticks_per_ms = Calibrate();
+    return ticks_per_ms;
+  }
+
+  /** @brief 把 tick 差值换算为毫秒（报告路径）。 */
+  static inline double TicksToMs(uint64_t ticks) noexcept {
+    return static_cast<double>(ticks) / TicksPerMs();
+  }
+
+ private:
+  static double Calibrate() noexcept {
+#if defined(Z3Y_PROFILER_CLOCK_TSC)
+    using Clock = std::chrono::steady_clock;
+    const auto t0 = Clock::now();
+    const uint64_t c0 = Now();
+    auto t1 = t0;
+    while (t1 - t0 < std::chrono::milliseconds(5)) t1 = Clock::now();
+    const uint64_t c1 = Now();
+    const double ms =
+        std::chrono::duration<double, std::milli>(t1 - t0).count();
+    return ms > 0 ? static_cast<double>(c1 - c0) / ms : 1e6;
+#elif defined(Z3Y_PROFILER_CLOCK_CNTVCT)
+    uint64_t freq;
+    __asm__ volatile("mrs %0, cntfrq_el0" : "=r"(freq));
+    return static_cast<double>(freq) / 1000.0;
+#else
+    return 1e6;  // 纳秒
+#endif
+  }
+};
+
+}  // namespace z3y::interfaces::profiler
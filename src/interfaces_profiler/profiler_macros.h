@@ -17,14 +17,25 @@
  * 如果你试图传入动态字符串，编译器会直接报错制止你！这是为了防止严重的内存悬空崩溃。
  * 如果你想传动态流水号，请使用 `Z3Y_PROFILE_TAG("SerialID",
  * dyn_str.c_str());`。
+ * - 发布版本想彻底去掉探针：在包含本头文件之前（或在编译选项里）定义
+ * `Z3Y_PROFILE_LEVEL`：0 全部编译为空；1 只保留 ROOT / TAG / LINEAR / ASYNC
+ * 等粗粒度探针；2（默认）全部保留。
+ * - 运行时按探针名 / 源文件 / 模块启停：`IProfilerService::SetProbesEnabled`。
+ * - 同一套宏可以同时送进 Tracy / Perfetto 的时间线（编译期选择，见 profiler_backend.h）；
+ *   `Z3Y_PROFILE_AGGREGATOR=0` 时只保留外部后端。
  * * 【面向维护者 - 架构剖析】
  * 本文件的核心难点在于 `FindOrCreateNode`
  * 的双重检查锁（DCL）设计，以及服务跨界指针 的生命周期获取。
+ * 每个探针只调用一次 `CurrentProfiler()`：命中线程缓存时只有一次 relaxed 原子读
+ * (框架的服务代数)，之后全程使用取到的服务指针；析构时再比较一次代数判断服务是否仍然存活。
  */
 
 #pragma once
-#include <chrono>
+#include <atomic>
 #include <cstring>  // std::memcpy, std::strlen
+#include <memory>
+#include <string>
+#include <utility>
 
 // 引入平台特定的内联汇编指令头文件，用于 _mm_pause 缓解自旋锁烧核
 #if defined(_MSC_VER) || defined(__INTEL_COMPILER)
@@ -35,34 +46,88 @@
 
 #include "framework/z3y_service_locator.h"
 #include "i_profiler_service.h"
+#include "profiler_backend.h"
 
 namespace z3y::interfaces::profiler {
 
 /**
- * @brief 从 ServiceLocator 中极速获取当前线程的上下文状态缓存。
+ * @brief 当前线程看到的 Profiler：服务指针、本线程状态，以及它们所属的纪元。
+ * @details `epoch` 即框架的服务代数：代数不变，服务与线程状态就一定仍然存活。
+ * `binding` 记下查找时本线程绑定的框架实例，切换实例 (`PluginManagerScope`) 后重新查找。
+ */
+struct ProfilerContext {
+  IProfilerService* service = nullptr;
+  ProfilerThreadState* state = nullptr;
+  uint64_t epoch = 0;  //!< 0 表示从未查找过 (服务代数从不为 0)
+  uint64_t service_id = 0;
+  uint64_t binding = 0;                  //!< 查找时本线程绑定的实例编号
+  const uint64_t* binding_id = nullptr;  //!< 本线程的绑定编号变量 (首次查找时取得)
+};
+
+/** @brief 当前纪元 (一次 relaxed 原子读)。与探针构造时记下的纪元比较，判断服务是否被卸载或重载。 */
+inline uint64_t ProfilerEpoch() noexcept {
+  static const std::atomic<uint64_t>& generation =
+      z3y::PluginManager::GetServiceGeneration();
+  return generation.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief 极速获取当前线程的 Profiler 上下文。
  * @details
  * 传统跨 DLL 的 inline thread_local 极其危险，极易在卸载时产生段错误。
- * 这里使用了一个极尽巧妙的设计：缓存当前 Service 的内存地址
- * (`cached_service_id`)。 只要服务没有被卸载重装（地址不变），就可以绕过沉重的
- * Locator 查询，实现 O(1) 性能逼近。
- */
-inline ProfilerThreadState* GetThreadState() {
-  static thread_local ProfilerThreadState* cached_state = nullptr;
-  static thread_local uint64_t cached_service_id = 0;
-
-  if (auto [svc, err] = z3y::TryGetDefaultService<IProfilerService>();
-      err == z3y::InstanceError::kSuccess) {
-    auto current_id = svc->GetInstanceId();
-    if (cached_service_id != current_id) {
-      cached_state = svc->GetOrCreateThreadState();
-      cached_service_id = current_id;
+ * 这里的缓存只有裸指针与整数 (平凡可析构)，并以服务代数与线程绑定编号为键：
+ * 命中时只有一次原子读与一次本线程变量的读取；代数变化后才重新查找服务，且只有服务实例变化 (`GetInstanceId`)
+ * 时才重新获取线程状态。
+ */
+inline const ProfilerContext& CurrentProfiler() noexcept {
+  static thread_local ProfilerContext ctx;
+  const uint64_t epoch = ProfilerEpoch();
+  if (ctx.epoch == epoch && ctx.binding == *ctx.binding_id) return ctx;
+
+  if (auto* svc = z3y::ServiceHandle<IProfilerService>::TryGet()) {
+    const uint64_t id = svc->GetInstanceId();
+    if (ctx.service_id != id || !ctx.state) {
+      ctx.state = svc->GetOrCreateThreadState();
+      ctx.service_id = id;
     }
-    return cached_state;
+    ctx.service = svc;
+  } else {
+    ctx = ProfilerContext{};
   }
+  ctx.epoch = epoch;
+  ctx.binding_id = &z3y::PluginManager::GetThreadBindingId();
+  ctx.binding = *ctx.binding_id;
+  return ctx;
+}
+
+/** @brief 获取当前线程的状态缓存 (服务不存在时为 nullptr)。 */
+inline ProfilerThreadState* GetThreadState() { return CurrentProfiler().state; }
 
-  cached_state = nullptr;
-  cached_service_id = 0;
-  return nullptr;
+/**
+ * @brief 探针当前是否启用：读取服务启用位图中的一位。
+ * @details 只有探针首次在本服务实例下执行（probe_key 的标签与线程状态不符）时
+ * 才调用 RegisterProbe 登记；之后的启停只是服务内的位图翻转，热路径不受影响。
+ * 调用方保证 svc 与 tls 非空。
+ */
+inline bool ProbeEnabled(IProfilerService* svc, ProfilerThreadState* tls,
+                         ProfileNodeData* data) {
+  uint64_t key = data->probe_key.load(std::memory_order_relaxed);
+  if (static_cast<uint32_t>(key >> 32) != tls->probe_tag) {
+    key = svc->RegisterProbe(data);
+  }
+  const auto index = static_cast<uint32_t>(key);
+  return (tls->probe_bits[index >> 6].load(std::memory_order_relaxed) >>
+          (index & 63)) &
+         1u;
+}
+
+/**
+ * @brief 确保影子栈还能再压入一层。
+ * @details 容量足够时只有一次比较；否则交给服务扩容。
+ * @return false 表示已达深度上限，调用方放弃记录本层。
+ */
+inline bool ReserveStackSlot(IProfilerService* svc, ProfilerThreadState* tls) {
+  return tls->stack_depth < tls->stack_capacity || svc->GrowShadowStack(tls);
 }
 
 /**
@@ -76,31 +141,55 @@ inline void ResetProfilerCache() {
   }
 }
 
+/**
+ * @brief 取得当前统计节点的冷数据块（没有时向服务申请）。不在被统计的作用域内时返回 nullptr。
+ */
+inline NodeColdStats* CurrentTagStats() {
+  const ProfilerContext& ctx = CurrentProfiler();
+  auto* tls = ctx.state;
+  if (!tls || !tls->current_root || tls->stack_depth == 0) return nullptr;
+  auto* node = tls->shadow_stack[tls->stack_depth - 1];
+  if (!node) return nullptr;
+  NodeColdStats* stats = node->cold.load(std::memory_order_acquire);
+  return stats ? stats : ctx.service->AttachColdStats(node);
+}
+
 /**
  * @brief 内部调用函数：向当前的 Profiler 上下文绑定一个附加属性标签。
  * @param k 键名（必须静态）
  * @param v 键值（允许动态，会被强制执行最大长度的栈复制）
  */
 inline void AddTagInternal(const char* k, const char* v) {
-  if (auto* tls = GetThreadState();
-      tls && tls->current_root && tls->stack_depth > 0) {
-    auto* node = tls->shadow_stack[tls->stack_depth - 1];
-    if (node && node->tag_count < 2) {
-      auto& tag = node->tags[node->tag_count++];
-      tag.key = k;
-      if (v) {
-        // 【修复 MSVC 警告】：使用 strlen + memcpy 替代 strncpy，
-        // 不仅屏蔽了 C4996 警告，而且在编译器底层有极强的 intrinsic
-        // 汇编级优化，速度极快
-        size_t len = std::strlen(v);
-        if (len >= sizeof(tag.value)) {
-          len = sizeof(tag.value) - 1;
-        }
-        std::memcpy(tag.value, v, len);
-        tag.value[len] = '\0';
-      }
-    }
+  if (NodeColdStats* stats = CurrentTagStats()) stats->AddTag(k, v);
+}
+
+/**
+ * @brief 内部调用函数：为当前统计节点的类型化标签值计数一次（不拷贝字符串）。
+ * @param k 键名（必须静态）
+ */
+inline void AddTagValueInternal(const char* k, TagValueKind kind,
+                                uint64_t value) {
+  if (NodeColdStats* stats = CurrentTagStats()) {
+    stats->CountTagValue(k, kind, value);
+  }
+}
+
+/**
+ * @brief 内部调用函数：以驻留字符串为值计数一次。
+ * @details 驻留编号按服务实例缓存在调用点的静态变量里（高 32 位是服务的 probe_tag，
+ * 与 ProbeEnabled 的做法相同）：每个调用点在每个服务实例下只驻留一次，之后只读缓存。
+ */
+inline void AddTagNameInternal(const char* k, const char* text,
+                               std::atomic<uint64_t>& cache) {
+  const ProfilerContext& ctx = CurrentProfiler();
+  if (!ctx.state || !ctx.state->current_root) return;
+  uint64_t cached = cache.load(std::memory_order_relaxed);
+  if (static_cast<uint32_t>(cached >> 32) != ctx.state->probe_tag) {
+    cached = (uint64_t{ctx.state->probe_tag} << 32) |
+             ctx.service->InternTagString(text);
+    cache.store(cached, std::memory_order_relaxed);
   }
+  AddTagValueInternal(k, TagValueKind::Interned, static_cast<uint32_t>(cached));
 }
 
 /**
@@ -112,10 +201,44 @@ inline void AddTagInternal(const char* k, const char* v) {
  * 步骤三：【二次校验】再次获取自旋锁！重新遍历链表。因为在步骤二去申请内存的时间缝隙里，别的线程
  * 可能已经抢先把同样名字的节点挂上去了。如果有，则退还自己申请的，借用已存在的；如果没有，
  * 才真正将其插入链表尾部。
+ * 线程独占的父节点 (`thread_owned`) 不存在并发挂载，直接走无锁路径。
+ * 传入 `tls` 时先查本线程的 (parent, data) 直接映射缓存：重复进入同一个作用域时
+ * 无锁、O(1) 命中，不再随父节点的子节点数量线性变慢。
+ * 缓存条目记下查找当时 (持锁) 的 `child_epoch`，父节点的子链表被回收后自动失效。
  */
-inline AggregatorNode* FindOrCreateNode(ProfileNodeData* data,
-                                        AggregatorNode* parent) {
-  if (!parent) return nullptr;
+inline AggregatorNode* FindOrCreateNode(IProfilerService* svc,
+                                        ProfileNodeData* data,
+                                        AggregatorNode* parent,
+                                        ProfilerThreadState* tls = nullptr) {
+  if (!parent || !svc) return nullptr;
+
+  ProfilerThreadState::ChildCacheEntry* entry = nullptr;
+  if (tls) {
+    entry = &tls->child_cache[ProfilerThreadState::ChildCacheSlot(parent, data)];
+    if (entry->parent == parent && entry->data == data &&
+        entry->epoch == parent->child_epoch.load(std::memory_order_acquire)) {
+      return entry->child;
+    }
+  }
+  auto remember = [&](AggregatorNode* child, uint32_t epoch) {
+    if (entry) *entry = {parent, data, child, epoch};
+    return child;
+  };
+
+  if (parent->thread_owned) {
+    const uint32_t epoch = parent->child_epoch.load(std::memory_order_relaxed);
+    AggregatorNode** link = &parent->first_child;
+    for (; *link; link = &(*link)->next_sibling) {
+      if ((*link)->static_info == data) return remember(*link, epoch);
+    }
+    AggregatorNode* new_node = svc->AcquireNode();
+    if (!new_node) return nullptr;
+    new_node->static_info = data;
+    new_node->parent = parent;
+    new_node->thread_owned = true;
+    *link = new_node;
+    return remember(new_node, epoch);
+  }
 
   // 第一步：自旋锁保护并引入 CPU Pause 防止死锁争用导致该核 100% 负载降频
   while (parent->lock.test_and_set(std::memory_order_acquire)) {
@@ -125,12 +248,13 @@ inline AggregatorNode* FindOrCreateNode(ProfileNodeData* data,
     __asm__ volatile("yield");
 #endif
   }
+  uint32_t epoch = parent->child_epoch.load(std::memory_order_relaxed);
   AggregatorNode* child = parent->first_child;
   AggregatorNode* last_child = nullptr;
   while (child) {
     if (child->static_info == data) {
       parent->lock.clear(std::memory_order_release);
-      return child;
+      return remember(child, epoch);
     }
     last_child = child;
     child = child->next_sibling;
@@ -138,11 +262,7 @@ inline AggregatorNode* FindOrCreateNode(ProfileNodeData* data,
 
   parent->lock.clear(std::memory_order_release);
 
-  AggregatorNode* new_node = nullptr;
-  if (auto [svc, err] = z3y::TryGetDefaultService<IProfilerService>();
-      err == z3y::InstanceError::kSuccess) {
-    new_node = svc->AcquireNode();
-  }
+  AggregatorNode* new_node = svc->AcquireNode();
   // 遇到防爆上限或底层禁用的情况，优雅降级，返回空从而静默放弃记录
   if (!new_node) return nullptr;
 
@@ -157,16 +277,14 @@ inline AggregatorNode* FindOrCreateNode(ProfileNodeData* data,
     __asm__ volatile("yield");
 #endif
   }
+  epoch = parent->child_epoch.load(std::memory_order_relaxed);
   child = parent->first_child;
   last_child = nullptr;
   while (child) {
     if (child->static_info == data) {
       parent->lock.clear(std::memory_order_release);
-      if (auto [svc, err] = z3y::TryGetDefaultService<IProfilerService>();
-          err == z3y::InstanceError::kSuccess) {
-        svc->ReleaseNodeTree(new_node);  // 被其他抢先，退货防泄漏
-      }
-      return child;
+      svc->ReleaseNodeTree(new_node);  // 被其他抢先，退货防泄漏
+      return remember(child, epoch);
     }
     last_child = child;
     child = child->next_sibling;
@@ -179,7 +297,29 @@ inline AggregatorNode* FindOrCreateNode(ProfileNodeData* data,
     parent->first_child = new_node;
   }
   parent->lock.clear(std::memory_order_release);
-  return new_node;
+  return remember(new_node, epoch);
+}
+
+/**
+ * @brief 飞行记录器：记下一次作用域进入。
+ * @details 关闭时只多一次 relaxed 读；会话号变化后第一次调用才向服务取本线程的环。
+ */
+inline void FlightScopeBegin(IProfilerService* svc, ProfilerThreadState* tls,
+                             const ProfileNodeData* data, uint64_t ticks) {
+  if (!tls->flight_session) return;
+  const uint64_t session = tls->flight_session->load(std::memory_order_relaxed);
+  if (session == 0) return;
+  if (tls->flight_ring_session != session) svc->AcquireFlightRing(tls);
+  if (tls->flight_ring) tls->flight_ring->Push(data, true, ticks);
+}
+
+/** @brief 飞行记录器：记下一次作用域退出（会话已变化时丢弃，不再取环）。 */
+inline void FlightScopeEnd(ProfilerThreadState* tls, const ProfileNodeData* data,
+                           uint64_t ticks) {
+  if (tls->flight_ring &&
+      tls->flight_session->load(std::memory_order_relaxed) == tls->flight_ring_session) {
+    tls->flight_ring->Push(data, false, ticks);
+  }
 }
 
 /**
@@ -189,49 +329,37 @@ inline AggregatorNode* FindOrCreateNode(ProfileNodeData* data,
 class ScopedTimer {
  public:
   ScopedTimer(ProfileNodeData* static_data)
-      : node_(nullptr), tls_state_(nullptr), service_id_(0) {
-    // [新增] 在构造时记录获取到的服务实例 ID
-    if (auto [svc, err] = z3y::TryGetDefaultService<IProfilerService>();
-        err == z3y::InstanceError::kSuccess) {
-      service_id_ = svc->GetInstanceId();
-    }
-    tls_state_ = GetThreadState();
-    if (!static_data->enabled.load(std::memory_order_relaxed) || !tls_state_ ||
-        !tls_state_->current_root)
+      : node_(nullptr), tls_state_(nullptr), epoch_(0) {
+    // 一次查找：记下服务所属的纪元，析构时据此判断服务是否仍然存活
+    const ProfilerContext& ctx = CurrentProfiler();
+    epoch_ = ctx.epoch;
+    tls_state_ = ctx.state;
+    if (!tls_state_ || !tls_state_->current_root ||
+        !ProbeEnabled(ctx.service, tls_state_, static_data))
       return;
 
-    // 栈保护屏障。超过 128 层直接放弃分析，进入优雅降级，防止一切越界和失步
-    if (tls_state_->stack_depth >= 128) {
-      return;
-    }
+    // 栈保护屏障。超过深度上限直接放弃本层，进入优雅降级，防止一切越界和失步
+    if (!ReserveStackSlot(ctx.service, tls_state_)) return;
 
     AggregatorNode* parent =
         tls_state_->stack_depth > 0
             ? tls_state_->shadow_stack[tls_state_->stack_depth - 1]
             : tls_state_->current_root;
-    node_ = FindOrCreateNode(static_data, parent);
+    node_ = FindOrCreateNode(ctx.service, static_data, parent, tls_state_);
     if (node_) {
       tls_state_->shadow_stack[tls_state_->stack_depth++] = node_;
-      start_ts_ = std::chrono::steady_clock::now();
+      start_ticks_ = ProfilerClock::Now();
+      FlightScopeBegin(ctx.service, tls_state_, static_data, start_ticks_);
     }
   }
   ~ScopedTimer() {
     if (!node_) return;
-    // [修改] 析构时必须强制校验当前服务的实例
-    // ID，如果不匹配说明遭遇了热重载，立刻放弃访问野指针
-    if (auto [svc, err] = z3y::TryGetDefaultService<IProfilerService>();
-        err != z3y::InstanceError::kSuccess ||
-        svc->GetInstanceId() != service_id_) {
-      return;
-    }
-    double ms = std::chrono::duration<double, std::milli>(
-                    std::chrono::steady_clock::now() - start_ts_)
-                    .count();
-    node_->call_count.fetch_add(1, std::memory_order_relaxed);
-    uint64_t ns = static_cast<uint64_t>(ms * 1000000.0);
-    node_->total_time_ns.fetch_add(ns, std::memory_order_relaxed);
-    AtomicUpdateMax(node_->max_time_ms_bits, ms);
-    AtomicUpdateMin(node_->min_time_ms_bits, ms);
+    // [修改] 析构时必须强制校验纪元，
+    // 如果不匹配说明服务可能遭遇了热重载，立刻放弃访问野指针
+    if (ProfilerEpoch() != epoch_) return;
+    const uint64_t end_ticks = ProfilerClock::Now();
+    node_->RecordTicks(end_ticks - start_ticks_);
+    FlightScopeEnd(tls_state_, node_->static_info, end_ticks);
     if (tls_state_->stack_depth > 0) {
       tls_state_->stack_depth--;
     }
@@ -240,8 +368,54 @@ class ScopedTimer {
  private:
   AggregatorNode* node_;
   ProfilerThreadState* tls_state_;
-  std::chrono::steady_clock::time_point start_ts_;
-  uint64_t service_id_;
+  uint64_t start_ticks_ = 0;
+  uint64_t epoch_;
+};
+
+/**
+ * @brief 设备区间：构造与析构时各在设备队列上打一个时间戳标记，交给服务异步解析。
+ * @details 主机侧耗时由同一个宏里的 ScopedTimer 记录；这里只负责打标记，
+ * 不等待设备，也不要求处在 ROOT 之内。
+ */
+class ScopedDeviceTimer {
+ public:
+  ScopedDeviceTimer(ProfileNodeData* static_data,
+                    std::shared_ptr<IDeviceTimestampSource> source) {
+    const ProfilerContext& ctx = CurrentProfiler();
+    epoch_ = ctx.epoch;
+    if (!source || !ctx.state || !ProbeEnabled(ctx.service, ctx.state, static_data)) {
+      return;
+    }
+    // 先读主机时钟再打标记：设备时刻总不早于它，服务据此估计时钟偏移
+    host_begin_ticks_ = ProfilerClock::Now();
+    begin_marker_ = source->Mark();
+    if (!begin_marker_) return;
+    service_ = ctx.service;
+    data_ = static_data;
+    source_ = std::move(source);
+  }
+  ~ScopedDeviceTimer() {
+    if (!begin_marker_) return;
+    const uint64_t end_marker =
+        ProfilerEpoch() == epoch_ ? source_->Mark() : 0;
+    if (!end_marker) {
+      source_->Release(begin_marker_);
+      return;
+    }
+    service_->SubmitDeviceSpan(std::move(source_), data_, begin_marker_,
+                               end_marker, host_begin_ticks_);
+  }
+
+  ScopedDeviceTimer(const ScopedDeviceTimer&) = delete;
+  ScopedDeviceTimer& operator=(const ScopedDeviceTimer&) = delete;
+
+ private:
+  IProfilerService* service_ = nullptr;
+  ProfileNodeData* data_ = nullptr;
+  std::shared_ptr<IDeviceTimestampSource> source_;
+  uint64_t begin_marker_ = 0;
+  uint64_t host_begin_ticks_ = 0;
+  uint64_t epoch_ = 0;
 };
 
 /**
@@ -249,121 +423,116 @@ class ScopedTimer {
  */
 class LinearManager {
  public:
-  LinearManager(ProfileNodeData* total_data) : service_id_(0) {
-    if (auto [svc, err] = z3y::TryGetDefaultService<IProfilerService>();
-        err == z3y::InstanceError::kSuccess) {
-      service_id_ = svc->GetInstanceId();
-    }
-    tls_state_ = GetThreadState();
-    // 增加 128 层屏障，防止未入栈却被强行出栈
+  LinearManager(ProfileNodeData* total_data) {
+    const ProfilerContext& ctx = CurrentProfiler();
+    service_ = ctx.service;
+    epoch_ = ctx.epoch;
+    tls_state_ = ctx.state;
+    // 深度屏障，防止未入栈却被强行出栈
     if (!tls_state_ || !tls_state_->current_root ||
-        tls_state_->stack_depth >= 128)
+        !ProbeEnabled(service_, tls_state_, total_data) ||
+        !ReserveStackSlot(service_, tls_state_))
       return;
 
     AggregatorNode* parent =
         tls_state_->stack_depth > 0
             ? tls_state_->shadow_stack[tls_state_->stack_depth - 1]
             : tls_state_->current_root;
-    total_node_ = FindOrCreateNode(total_data, parent);
+    total_node_ = FindOrCreateNode(service_, total_data, parent, tls_state_);
     if (total_node_) {
-      if (tls_state_->stack_depth < 128) {  // [新增]
-        tls_state_->shadow_stack[tls_state_->stack_depth++] = total_node_;
-      }
-      start_total_ = std::chrono::steady_clock::now();
+      tls_state_->shadow_stack[tls_state_->stack_depth++] = total_node_;
+      start_total_ = ProfilerClock::Now();
+      FlightScopeBegin(service_, tls_state_, total_data, start_total_);
     }
   }
 
   void Next(ProfileNodeData* step_data) {
-    // 如果总节点为空(被拦截)，或恰好达到栈顶，拒绝操作
-    if (!total_node_ || tls_state_->stack_depth >= 128) return;
-    if (auto [svc, err] = z3y::TryGetDefaultService<IProfilerService>();
-        err != z3y::InstanceError::kSuccess ||
-        svc->GetInstanceId() != service_id_)
-      return;
-    auto now = std::chrono::steady_clock::now();
+    // 如果总节点为空(被拦截)，拒绝操作
+    if (!total_node_) return;
+    if (ProfilerEpoch() != epoch_) return;
+    const uint64_t now = ProfilerClock::Now();
     CloseStep(current_step_node_, start_step_, now);
+    current_step_node_ = nullptr;
+    // 上一步已出栈；只有确实拿到栈位的步骤才会入栈，CloseStep 的出栈与之一一对应
+    if (!ProbeEnabled(service_, tls_state_, step_data) ||
+        !ReserveStackSlot(service_, tls_state_))
+      return;
 
-    current_step_node_ = FindOrCreateNode(step_data, total_node_);
+    current_step_node_ =
+        FindOrCreateNode(service_, step_data, total_node_, tls_state_);
     if (current_step_node_) {
-      if (tls_state_->stack_depth < 128) {  // [新增]
-        tls_state_->shadow_stack[tls_state_->stack_depth++] =
-            current_step_node_;
-      }
+      tls_state_->shadow_stack[tls_state_->stack_depth++] = current_step_node_;
       start_step_ = now;
+      FlightScopeBegin(service_, tls_state_, step_data, now);
     }
   }
 
   ~LinearManager() {
     if (!total_node_) return;
-    if (auto [svc, err] = z3y::TryGetDefaultService<IProfilerService>();
-        err != z3y::InstanceError::kSuccess ||
-        svc->GetInstanceId() != service_id_)
-      return;
-    auto now = std::chrono::steady_clock::now();
+    if (ProfilerEpoch() != epoch_) return;
+    const uint64_t now = ProfilerClock::Now();
     CloseStep(current_step_node_, start_step_, now);
     CloseStep(total_node_, start_total_, now);
   }
 
  private:
-  inline void CloseStep(AggregatorNode* node,
-                        std::chrono::steady_clock::time_point start_time,
-                        std::chrono::steady_clock::time_point end_time) {
+  inline void CloseStep(AggregatorNode* node, uint64_t start_ticks,
+                        uint64_t end_ticks) {
     if (!node) return;
     if (tls_state_->stack_depth > 0) {
       tls_state_->stack_depth--;
     }
-    double ms = std::chrono::duration<double, std::milli>(end_time - start_time)
-                    .count();
-    node->call_count.fetch_add(1, std::memory_order_relaxed);
-    uint64_t ns = static_cast<uint64_t>(ms * 1000000.0);
-    node->total_time_ns.fetch_add(ns, std::memory_order_relaxed);
-    AtomicUpdateMax(node->max_time_ms_bits, ms);
-    AtomicUpdateMin(node->min_time_ms_bits, ms);
+    node->RecordTicks(end_ticks - start_ticks);
+    FlightScopeEnd(tls_state_, node->static_info, end_ticks);
   }
 
   ProfilerThreadState* tls_state_ = nullptr;
   AggregatorNode* total_node_ = nullptr;
   AggregatorNode* current_step_node_ = nullptr;
-  std::chrono::steady_clock::time_point start_total_, start_step_;
-  uint64_t service_id_;
+  uint64_t start_total_ = 0, start_step_ = 0;
+  IProfilerService* service_ = nullptr;
+  uint64_t epoch_ = 0;
 };
 
 /**
  * @brief 直接记录一条度量指标的便捷函数（数值或单次事件）。
  */
 inline void RecordMetric(ProfileNodeData* data, double value) {
-  auto* tls = GetThreadState();
-  if (!tls || !tls->current_root || tls->stack_depth == 0) return;
+  const ProfilerContext& ctx = CurrentProfiler();
+  auto* tls = ctx.state;
+  if (!tls || !tls->current_root || tls->stack_depth == 0 ||
+      !ProbeEnabled(ctx.service, tls, data))
+    return;
   AggregatorNode* parent = tls->shadow_stack[tls->stack_depth - 1];
-  if (auto* node = FindOrCreateNode(data, parent)) {
-    node->call_count.fetch_add(1, std::memory_order_relaxed);  // [修复]
-
-    // [修复] 使用 CAS 原语进行无锁浮点数累加和极值更新
-    AtomicAddDouble(node->sum_value_bits, value);
-    AtomicUpdateMax(node->max_value_bits, value);
-    AtomicUpdateMin(node->min_value_bits, value);
+  if (auto* node = FindOrCreateNode(ctx.service, data, parent, tls)) {
+    // 事件只计次数；数值节点首次记录时才挂冷数据块
+    if (data->type == NodeType::Value &&
+        !node->cold.load(std::memory_order_relaxed)) {
+      ctx.service->AttachColdStats(node);
+    }
+    node->RecordValue(value);
   }
 }
 
 /**
  * @brief 初始化局部的独立分析根节点。
  * @details 适用于独立的后台常驻线程，它的析构函数会直接将数据推送到 Logger（即
- * SubmitRootForCheck）。
+ * SubmitRootForCheck）。cadence_ms 大于 0 时为节拍根，另外统计帧间隔（见 RecordPacedFrame）。
  */
 class ScopedRoot {
  public:
-  ScopedRoot(ProfileNodeData* static_data, uint32_t period, double sla_ms)
-      : period_(period), sla_ms_(sla_ms), service_id_(0) {
-    if (auto [svc, err] = z3y::TryGetDefaultService<IProfilerService>();
-        err == z3y::InstanceError::kSuccess) {
-      service_id_ = svc->GetInstanceId();
-    }
-    tls_state_ = GetThreadState();
+  ScopedRoot(ProfileNodeData* static_data, uint32_t period, double sla_ms,
+             double cadence_ms = 0.0)
+      : period_(period), sla_ms_(sla_ms), cadence_ms_(cadence_ms), epoch_(0) {
+    const ProfilerContext& ctx = CurrentProfiler();
+    service_ = ctx.service;
+    epoch_ = ctx.epoch;
+    tls_state_ = ctx.state;
     if (!tls_state_) return;
 
-    if (auto [svc, err] = z3y::TryGetDefaultService<IProfilerService>();
-        err == z3y::InstanceError::kSuccess) {
-      if (!svc->IsEnabled()) return;
+    if (auto* svc = service_) {
+      if (!svc->IsEnabled() || !ProbeEnabled(svc, tls_state_, static_data))
+        return;
 
       for (size_t i = 0; i < tls_state_->thread_root_count; ++i) {
         if (tls_state_->thread_roots[i]->static_info == static_data) {
@@ -372,23 +541,16 @@ class ScopedRoot {
         }
       }
 
-      if (!root_node_) {
-        root_node_ = svc->AcquireNode();
-        if (root_node_) {
-          root_node_->static_info = static_data;
-          if (tls_state_->thread_root_count < 64) {
-            tls_state_->thread_roots[tls_state_->thread_root_count++] =
-                root_node_;
-          }
-        }
-      }
+      if (!root_node_) root_node_ = svc->AcquireThreadRoot(tls_state_, static_data);
     }
 
     if (root_node_) {
       tls_state_->current_root = root_node_;
       tls_state_->stack_depth = 1;
       tls_state_->shadow_stack[0] = root_node_;
-      start_ts_ = std::chrono::steady_clock::now();
+      has_counters_ = service_->ReadHardwareCounters(start_counters_);
+      start_ticks_ = ProfilerClock::Now();
+      FlightScopeBegin(service_, tls_state_, static_data, start_ticks_);
     }
   }
 
@@ -396,31 +558,101 @@ class ScopedRoot {
     if (!root_node_ || !tls_state_) return;
     // [新增] 必须把服务存活性校验提到最前面！因为下面紧跟着就要解引用
     // root_node_
-    if (auto [svc, err] = z3y::TryGetDefaultService<IProfilerService>();
-        err != z3y::InstanceError::kSuccess ||
-        svc->GetInstanceId() != service_id_) {
+    if (ProfilerEpoch() != epoch_) return;
+    const uint64_t end_ticks = ProfilerClock::Now();
+    const uint64_t ticks = end_ticks - start_ticks_;
+    // 先记退出：SLA 超时在 SubmitRootForCheck 中冻结飞行记录器，冻结结果要包含这一帧的结束
+    FlightScopeEnd(tls_state_, root_node_->static_info, end_ticks);
+    root_node_->total_ticks.fetch_add(ticks, std::memory_order_relaxed);
+    if (root_node_->histogram) root_node_->histogram->Record(ticks);
+    HardwareCounterSample end_counters;
+    if (has_counters_ && service_->ReadHardwareCounters(end_counters)) {
+      for (size_t i = 0; i < kHardwareCounterCount; ++i) {
+        end_counters[i] -= start_counters_[i];
+      }
+      service_->RecordHardwareCounters(root_node_, end_counters);
+    }
+    if (cadence_ms_ > 0.0) {
+      service_->RecordPacedFrame(root_node_, cadence_ms_, start_ticks_, end_ticks);
+    }
+    service_->SubmitRootForCheck(root_node_, period_, sla_ms_);
+    tls_state_->current_root = nullptr;
+    tls_state_->stack_depth = 0;
+  }
+
+ private:
+  AggregatorNode* root_node_ = nullptr;
+  ProfilerThreadState* tls_state_ = nullptr;
+  uint32_t period_;
+  double sla_ms_;
+  double cadence_ms_;  ///< 节拍根的期望帧间隔，0 表示普通根
+  uint64_t start_ticks_ = 0;
+  IProfilerService* service_ = nullptr;
+  uint64_t epoch_;
+  bool has_counters_ = false;              ///< 开始时是否读到了硬件计数器
+  HardwareCounterSample start_counters_;  ///< 作用域开始时的计数器读数
+};
+
+/**
+ * @brief 分组根作用域 (Z3Y_PROFILE_ROOT_KEYED)：同一个调用点按键拆成多棵独立的树。
+ * @details 与 ScopedRoot 的区别只在根节点的来源：按 (调用点, 键) 从服务的分组表取得，
+ * 所有线程共享同一个键的根；析构时交还服务计数并注销写入者。
+ */
+class ScopedKeyedRoot {
+ public:
+  ScopedKeyedRoot(ProfileNodeData* static_data, uint64_t key, uint32_t period,
+                  double sla_ms)
+      : period_(period), sla_ms_(sla_ms) {
+    const ProfilerContext& ctx = CurrentProfiler();
+    service_ = ctx.service;
+    epoch_ = ctx.epoch;
+    tls_state_ = ctx.state;
+    if (!tls_state_ || !service_ || !service_->IsEnabled() ||
+        !ProbeEnabled(service_, tls_state_, static_data)) {
       return;
     }
-    double ms = std::chrono::duration<double, std::milli>(
-                    std::chrono::steady_clock::now() - start_ts_)
-                    .count();
-    uint64_t ns = static_cast<uint64_t>(ms * 1000000.0);
-    root_node_->total_time_ns.fetch_add(ns, std::memory_order_relaxed);
-    if (auto [svc, err] = z3y::TryGetDefaultService<IProfilerService>();
-        err == z3y::InstanceError::kSuccess) {
-      svc->SubmitRootForCheck(root_node_, period_, sla_ms_);
+    root_node_ = service_->BeginKeyedRoot(static_data, key, &handle_);
+    if (root_node_) {
+      tls_state_->current_root = root_node_;
+      tls_state_->stack_depth = 1;
+      tls_state_->shadow_stack[0] = root_node_;
+      has_counters_ = service_->ReadHardwareCounters(start_counters_);
+      start_ticks_ = ProfilerClock::Now();
+      FlightScopeBegin(service_, tls_state_, static_data, start_ticks_);
+    }
+  }
+
+  ~ScopedKeyedRoot() {
+    if (!root_node_ || ProfilerEpoch() != epoch_) return;
+    const uint64_t end_ticks = ProfilerClock::Now();
+    FlightScopeEnd(tls_state_, root_node_->static_info, end_ticks);
+    root_node_->total_ticks.fetch_add(end_ticks - start_ticks_, std::memory_order_relaxed);
+    HardwareCounterSample end_counters;
+    if (has_counters_ && service_->ReadHardwareCounters(end_counters)) {
+      for (size_t i = 0; i < kHardwareCounterCount; ++i) {
+        end_counters[i] -= start_counters_[i];
+      }
+      service_->RecordHardwareCounters(root_node_, end_counters);
     }
     tls_state_->current_root = nullptr;
     tls_state_->stack_depth = 0;
+    service_->EndKeyedRoot(handle_, period_, sla_ms_);
   }
 
+  ScopedKeyedRoot(const ScopedKeyedRoot&) = delete;
+  ScopedKeyedRoot& operator=(const ScopedKeyedRoot&) = delete;
+
  private:
   AggregatorNode* root_node_ = nullptr;
   ProfilerThreadState* tls_state_ = nullptr;
+  IProfilerService* service_ = nullptr;
   uint32_t period_;
   double sla_ms_;
-  std::chrono::steady_clock::time_point start_ts_;
-  uint64_t service_id_;
+  uint32_t handle_ = 0;
+  uint64_t start_ticks_ = 0;
+  uint64_t epoch_ = 0;
+  bool has_counters_ = false;
+  HardwareCounterSample start_counters_;
 };
 }  // namespace z3y::interfaces::profiler
 
@@ -428,17 +660,73 @@ class ScopedRoot {
 #define Z3Y_PROF_CAT_INNER(a, b) a##b
 #define Z3Y_PROF_CAT(a, b) Z3Y_PROF_CAT_INNER(a, b)
 
+/**
+ * @def Z3Y_PROFILE_LEVEL
+ * @brief 编译期探针级别。0：全部编译为空；1：只保留 ROOT / TAG / LINEAR / NEXT /
+ * ASYNC_*；2（默认）：全部保留。
+ * @details 被编译掉的宏不求值参数，但仍检查名字是字符串字面量，并以 sizeof
+ * 引用其余参数，避免业务代码出现未使用变量的警告。
+ */
+#ifndef Z3Y_PROFILE_LEVEL
+#define Z3Y_PROFILE_LEVEL 2
+#endif
+
+/** 被编译掉的宏：引用但不求值参数 */
+#define Z3Y_PROF_UNUSED(x) static_cast<void>(sizeof(x))
+#define Z3Y_PROF_NAME_ONLY(name) static_cast<void>("" name "")
+
+namespace z3y::interfaces::profiler {
+
+/**
+ * @brief 接口代理的调用作用域（`Z3Y_INTERFACE_PROXY_BEGIN` 的 CallScope，见 framework/interface_proxy.h）。
+ * @details 每个被代理的方法一个 "接口::方法" 计时节点，与 Z3Y_PROFILE_NAMED 相同，
+ * 只在调用线程处于 ROOT 之内时记录；节点名保存在调用方模块的静态 Site 中。
+ * 拦截由 `System.Profiler.InterceptedCalls` 开启，不用改动被剖析的插件。
+ */
+class ProxyCallTimer {
+ public:
+#if Z3Y_PROFILE_LEVEL >= 2 && Z3Y_PROFILE_AGGREGATOR
+  struct Site {
+    Site(const char* interface_name, const char* method, const char* file, int line)
+        : name(std::string(interface_name) + "::" + method),
+          data{name.c_str(), file, static_cast<uint32_t>(line), NodeType::Timer} {}
+    std::string name;
+    ProfileNodeData data;
+  };
+  explicit ProxyCallTimer(Site& site) : timer_(&site.data) {}
+
+ private:
+  ScopedTimer timer_;
+#else
+  struct Site {
+    Site(const char*, const char*, const char*, int) noexcept {}
+  };
+  explicit ProxyCallTimer(Site&) noexcept {}
+#endif
+};
+
+}  // namespace z3y::interfaces::profiler
+
 /**
  * @def Z3Y_PROFILE
  * @brief 最常规的探针注入方式。自动将当前函数名称（__FUNCTION__）作为记录名字。
  * @details 将本行代码插入函数起始位置，通过 RAII 机制，函数退出时自动结算耗时。
  */
+#if Z3Y_PROFILE_LEVEL >= 2
+#if Z3Y_PROFILE_AGGREGATOR
 #define Z3Y_PROFILE()                                             \
+  Z3Y_PROF_EXT_SCOPE_FUNC();                                      \
   static z3y::interfaces::profiler::ProfileNodeData Z3Y_PROF_CAT( \
       s_n, __LINE__){__FUNCTION__, __FILE__, __LINE__,            \
                      z3y::interfaces::profiler::NodeType::Timer}; \
   z3y::interfaces::profiler::ScopedTimer Z3Y_PROF_CAT(            \
       _t, __LINE__)(&Z3Y_PROF_CAT(s_n, __LINE__))
+#else
+#define Z3Y_PROFILE() Z3Y_PROF_EXT_SCOPE_FUNC()
+#endif
+#else
+#define Z3Y_PROFILE() static_cast<void>(0)
+#endif
 
 /**
  * @def Z3Y_PROFILE_NAMED
@@ -449,110 +737,342 @@ class ScopedRoot {
  * 目的是为了在物理编译期，彻底掐死任何尝试传入 `std::string`、`sprintf(char*)`
  * 等 动态临时指针的企图（它们会导致静默引发极其致命的悬空指针段错误崩溃）。
  */
+#if Z3Y_PROFILE_LEVEL >= 2
+#if Z3Y_PROFILE_AGGREGATOR
 #define Z3Y_PROFILE_NAMED(name)                                   \
+  Z3Y_PROF_EXT_SCOPE(name);                                       \
   static z3y::interfaces::profiler::ProfileNodeData Z3Y_PROF_CAT( \
       s_n, __LINE__){"" name "", __FILE__, __LINE__,              \
                      z3y::interfaces::profiler::NodeType::Timer}; \
   z3y::interfaces::profiler::ScopedTimer Z3Y_PROF_CAT(            \
       _t, __LINE__)(&Z3Y_PROF_CAT(s_n, __LINE__))
+#else
+#define Z3Y_PROFILE_NAMED(name) Z3Y_PROF_EXT_SCOPE(name)
+#endif
+#else
+#define Z3Y_PROFILE_NAMED(name) Z3Y_PROF_NAME_ONLY(name)
+#endif
+
+/**
+ * @def Z3Y_PROFILE_DEVICE
+ * @brief 同时记录主机与设备耗时的作用域：作用域内提交到 source 队列上的设备工作
+ * （CUDA kernel、OpenCL 命令等）的执行时间，由后台轮询异步记入 "Devices" 根。
+ * @details 主机侧与 Z3Y_PROFILE_NAMED 相同；source 为 std::shared_ptr<IDeviceTimestampSource>。
+ * @code
+ * Z3Y_PROFILE_DEVICE("Conv_Kernel", stream_timer);
+ * conv_kernel<<<grid, block, 0, stream>>>(...);
+ * @endcode
+ */
+#if Z3Y_PROFILE_LEVEL >= 2
+#if Z3Y_PROFILE_AGGREGATOR
+#define Z3Y_PROFILE_DEVICE(name, source)                               \
+  Z3Y_PROFILE_NAMED(name);                                             \
+  z3y::interfaces::profiler::ScopedDeviceTimer Z3Y_PROF_CAT(_d, __LINE__)( \
+      &Z3Y_PROF_CAT(s_n, __LINE__), source)
+#else
+#define Z3Y_PROFILE_DEVICE(name, source) \
+  Z3Y_PROF_EXT_SCOPE(name);              \
+  Z3Y_PROF_UNUSED(source)
+#endif
+#else
+#define Z3Y_PROFILE_DEVICE(name, source) \
+  (Z3Y_PROF_NAME_ONLY(name), Z3Y_PROF_UNUSED(source))
+#endif
 
 /**
  * @def Z3Y_PROFILE_ROOT
  * @brief 注册一个独立树的根结点。常用于后台死循环 Worker 的外层，定期生成报告。
  */
+#if Z3Y_PROFILE_LEVEL >= 1
+#if Z3Y_PROFILE_AGGREGATOR
 #define Z3Y_PROFILE_ROOT(name, period, sla)                            \
+  Z3Y_PROF_EXT_SCOPE(name);                                            \
   static z3y::interfaces::profiler::ProfileNodeData Z3Y_PROF_CAT(      \
       s_r, __LINE__){"" name "", __FILE__, __LINE__,                   \
                      z3y::interfaces::profiler::NodeType::Timer};      \
   z3y::interfaces::profiler::ScopedRoot Z3Y_PROF_CAT(_root, __LINE__)( \
       &Z3Y_PROF_CAT(s_r, __LINE__), period, sla)
+#else
+#define Z3Y_PROFILE_ROOT(name, period, sla) \
+  Z3Y_PROF_EXT_SCOPE(name);                 \
+  (Z3Y_PROF_UNUSED(period), Z3Y_PROF_UNUSED(sla))
+#endif
+#else
+#define Z3Y_PROFILE_ROOT(name, period, sla) \
+  (Z3Y_PROF_NAME_ONLY(name), Z3Y_PROF_UNUSED(period), Z3Y_PROF_UNUSED(sla))
+#endif
+
+/**
+ * @def Z3Y_PROFILE_ROOT_PACED
+ * @brief 按固定节拍运行的循环的根（相机触发、控制周期）：在 ROOT 之外统计帧间隔与抖动。
+ * @details cadence_ms 是期望的帧间隔。报告中多出帧间隔的最小 / 平均 / 最大值、抖动直方图、
+ * 晚于 cadence_ms * (1 + System.Profiler.PacingTolerancePercent / 100) 的次数，
+ * 以及间隔最长的几帧各阶段（直接子节点）的耗时，用来判断是哪一步拖慢了节拍。
+ */
+#if Z3Y_PROFILE_LEVEL >= 1
+#if Z3Y_PROFILE_AGGREGATOR
+#define Z3Y_PROFILE_ROOT_PACED(name, period, sla, cadence_ms)            \
+  Z3Y_PROF_EXT_SCOPE(name);                                              \
+  static z3y::interfaces::profiler::ProfileNodeData Z3Y_PROF_CAT(        \
+      s_r, __LINE__){"" name "", __FILE__, __LINE__,                     \
+                     z3y::interfaces::profiler::NodeType::Timer};        \
+  z3y::interfaces::profiler::ScopedRoot Z3Y_PROF_CAT(_root, __LINE__)(   \
+      &Z3Y_PROF_CAT(s_r, __LINE__), period, sla,                         \
+      static_cast<double>(cadence_ms))
+#else
+#define Z3Y_PROFILE_ROOT_PACED(name, period, sla, cadence_ms) \
+  Z3Y_PROF_EXT_SCOPE(name);                                   \
+  (Z3Y_PROF_UNUSED(period), Z3Y_PROF_UNUSED(sla), Z3Y_PROF_UNUSED(cadence_ms))
+#endif
+#else
+#define Z3Y_PROFILE_ROOT_PACED(name, period, sla, cadence_ms)          \
+  (Z3Y_PROF_NAME_ONLY(name), Z3Y_PROF_UNUSED(period), Z3Y_PROF_UNUSED(sla), \
+   Z3Y_PROF_UNUSED(cadence_ms))
+#endif
+
+/**
+ * @def Z3Y_PROFILE_ROOT_KEYED / Z3Y_PROFILE_ROOT_KEYED_ID
+ * @brief 按业务键分组的独立根：同一个调用点的每个键（配方号、相机通道……）各出一份报告。
+ * @details key 是整数；`_ID` 版本传入 IProfilerService::InternTagString 的编号，
+ * 报告中的根名显示为原字符串。同时存在的键数受 System.Profiler.KeyedRootCapacity 限制，
+ * 超出时淘汰最久未用的键（淘汰前输出它尚未报告的数据）。
+ */
+#if Z3Y_PROFILE_LEVEL >= 1 && Z3Y_PROFILE_AGGREGATOR
+#define Z3Y_PROFILE_ROOT_KEYED(name, key, period, sla)                       \
+  Z3Y_PROF_EXT_SCOPE(name);                                                  \
+  static z3y::interfaces::profiler::ProfileNodeData Z3Y_PROF_CAT(            \
+      s_rk, __LINE__){"" name "", __FILE__, __LINE__,                        \
+                      z3y::interfaces::profiler::NodeType::Timer};           \
+  z3y::interfaces::profiler::ScopedKeyedRoot Z3Y_PROF_CAT(_root, __LINE__)(  \
+      &Z3Y_PROF_CAT(s_rk, __LINE__),                                         \
+      static_cast<uint64_t>(key) &                                           \
+          ~z3y::interfaces::profiler::kKeyedRootInternedKey,                 \
+      period, sla)
+#define Z3Y_PROFILE_ROOT_KEYED_ID(name, id, period, sla)                     \
+  Z3Y_PROF_EXT_SCOPE(name);                                                  \
+  static z3y::interfaces::profiler::ProfileNodeData Z3Y_PROF_CAT(            \
+      s_rk, __LINE__){"" name "", __FILE__, __LINE__,                        \
+                      z3y::interfaces::profiler::NodeType::Timer};           \
+  z3y::interfaces::profiler::ScopedKeyedRoot Z3Y_PROF_CAT(_root, __LINE__)(  \
+      &Z3Y_PROF_CAT(s_rk, __LINE__),                                         \
+      z3y::interfaces::profiler::kKeyedRootInternedKey |                     \
+          static_cast<uint32_t>(id),                                         \
+      period, sla)
+#elif Z3Y_PROFILE_LEVEL >= 1
+#define Z3Y_PROFILE_ROOT_KEYED(name, key, period, sla)                       \
+  Z3Y_PROF_EXT_SCOPE(name);                                                  \
+  (Z3Y_PROF_UNUSED(key), Z3Y_PROF_UNUSED(period), Z3Y_PROF_UNUSED(sla))
+#define Z3Y_PROFILE_ROOT_KEYED_ID(name, id, period, sla)                     \
+  Z3Y_PROF_EXT_SCOPE(name);                                                  \
+  (Z3Y_PROF_UNUSED(id), Z3Y_PROF_UNUSED(period), Z3Y_PROF_UNUSED(sla))
+#else
+#define Z3Y_PROFILE_ROOT_KEYED(name, key, period, sla)                 \
+  (Z3Y_PROF_NAME_ONLY(name), Z3Y_PROF_UNUSED(key), Z3Y_PROF_UNUSED(period), \
+   Z3Y_PROF_UNUSED(sla))
+#define Z3Y_PROFILE_ROOT_KEYED_ID(name, id, period, sla)               \
+  (Z3Y_PROF_NAME_ONLY(name), Z3Y_PROF_UNUSED(id), Z3Y_PROF_UNUSED(period), \
+   Z3Y_PROF_UNUSED(sla))
+#endif
+
+/** 聚合器部分的单点记录（Z3Y_PROFILE_AGGREGATOR=0 时编译为空，只保留外部后端） */
+#if Z3Y_PROFILE_AGGREGATOR
+#define Z3Y_PROF_AGG_TAG(k, v) z3y::interfaces::profiler::AddTagInternal(k, v)
+#define Z3Y_PROF_AGG_TAG_VALUE(k, kind, bits)           \
+  z3y::interfaces::profiler::AddTagValueInternal(       \
+      k, z3y::interfaces::profiler::TagValueKind::kind, bits)
+#define Z3Y_PROF_AGG_TAG_NAME(k, text)                              \
+  static std::atomic<uint64_t> Z3Y_PROF_CAT(s_tn, __LINE__){0};     \
+  z3y::interfaces::profiler::AddTagNameInternal(                    \
+      k, "" text "", Z3Y_PROF_CAT(s_tn, __LINE__))
+#else
+#define Z3Y_PROF_AGG_TAG(k, v) static_cast<void>(0)
+#define Z3Y_PROF_AGG_TAG_VALUE(k, kind, bits) static_cast<void>(0)
+#define Z3Y_PROF_AGG_TAG_NAME(k, text) static_cast<void>(0)
+#endif
 
 /**
  * @def Z3Y_PROFILE_TAG
  * @brief
  * 将当前的上下文状态（如业务流水号、错误码）作为标示追加到当前统计节点上。
  */
-#define Z3Y_PROFILE_TAG(k, v) z3y::interfaces::profiler::AddTagInternal(k, v)
+#if Z3Y_PROFILE_LEVEL >= 1
+#define Z3Y_PROFILE_TAG(k, v) (Z3Y_PROF_AGG_TAG(k, v), Z3Y_PROF_EXT_TAG(k, v))
+#else
+#define Z3Y_PROFILE_TAG(k, v) (Z3Y_PROF_UNUSED(k), Z3Y_PROF_UNUSED(v))
+#endif
+
+/**
+ * @def Z3Y_PROFILE_TAG_INT / Z3Y_PROFILE_TAG_ENUM / Z3Y_PROFILE_TAG_NAME / Z3Y_PROFILE_TAG_ID
+ * @brief 为当前统计节点记录一个 8 字节的类型化标签，报告按值分别计数（如每个相机编号各多少次）。
+ * @details 适用于高频作用域：记录时只有几次原子操作，不拷贝字符串。
+ * - `Z3Y_PROFILE_TAG_INT(k, v)`：有符号整数。
+ * - `Z3Y_PROFILE_TAG_ENUM(k, v)`：枚举值，按整数输出。
+ * - `Z3Y_PROFILE_TAG_NAME(k, "text")`：字符串字面量，每个调用点只驻留一次。
+ * - `Z3Y_PROFILE_TAG_ID(k, id)`：事先用 IProfilerService::InternTagString 驻留得到的编号。
+ */
+#if Z3Y_PROFILE_LEVEL >= 1
+#define Z3Y_PROFILE_TAG_INT(k, v)                                         \
+  (Z3Y_PROF_AGG_TAG_VALUE(k, Integer,                                     \
+                          static_cast<uint64_t>(static_cast<int64_t>(v))), \
+   Z3Y_PROF_EXT_TAG_INT(k, v))
+#define Z3Y_PROFILE_TAG_ENUM(k, v)                                        \
+  (Z3Y_PROF_AGG_TAG_VALUE(k, Enum,                                        \
+                          static_cast<uint64_t>(static_cast<int64_t>(v))), \
+   Z3Y_PROF_EXT_TAG_INT(k, v))
+#define Z3Y_PROFILE_TAG_NAME(k, text) \
+  do {                                \
+    Z3Y_PROF_AGG_TAG_NAME(k, text);   \
+    Z3Y_PROF_EXT_TAG(k, "" text "");  \
+  } while (0)
+#define Z3Y_PROFILE_TAG_ID(k, id)                                         \
+  (Z3Y_PROF_AGG_TAG_VALUE(                                                \
+       k, Interned, static_cast<uint64_t>(static_cast<uint32_t>(id))),    \
+   Z3Y_PROF_EXT_TAG_INT(k, static_cast<uint32_t>(id)))
+#else
+#define Z3Y_PROFILE_TAG_INT(k, v) (Z3Y_PROF_UNUSED(k), Z3Y_PROF_UNUSED(v))
+#define Z3Y_PROFILE_TAG_ENUM(k, v) (Z3Y_PROF_UNUSED(k), Z3Y_PROF_UNUSED(v))
+#define Z3Y_PROFILE_TAG_NAME(k, text) \
+  (Z3Y_PROF_UNUSED(k), Z3Y_PROF_NAME_ONLY(text))
+#define Z3Y_PROFILE_TAG_ID(k, id) (Z3Y_PROF_UNUSED(k), Z3Y_PROF_UNUSED(id))
+#endif
 
 /**
  * @def Z3Y_PROFILE_LINEAR
  * @brief 开启一个扁平的链式线性流程。
  */
+#if Z3Y_PROFILE_LEVEL >= 1 && Z3Y_PROFILE_AGGREGATOR
 #define Z3Y_PROFILE_LINEAR(name)                                    \
+  Z3Y_PROF_EXT_SCOPE(name);                                         \
   static z3y::interfaces::profiler::ProfileNodeData Z3Y_PROF_CAT(   \
       s_ln, __LINE__){"" name "", __FILE__, __LINE__,               \
                       z3y::interfaces::profiler::NodeType::Linear}; \
   z3y::interfaces::profiler::LinearManager _z3y_linear_mgr(         \
       &Z3Y_PROF_CAT(s_ln, __LINE__))
+#elif Z3Y_PROFILE_LEVEL >= 1
+#define Z3Y_PROFILE_LINEAR(name) Z3Y_PROF_EXT_SCOPE(name)
+#else
+#define Z3Y_PROFILE_LINEAR(name) Z3Y_PROF_NAME_ONLY(name)
+#endif
 
 /**
  * @def Z3Y_PROFILE_NEXT
  * @brief 线性流程向下推进一步。结束上一步统计，开启当前新统计。
  */
+#if Z3Y_PROFILE_LEVEL >= 1 && Z3Y_PROFILE_AGGREGATOR
 #define Z3Y_PROFILE_NEXT(name)                                     \
   static z3y::interfaces::profiler::ProfileNodeData Z3Y_PROF_CAT(  \
       s_nx, __LINE__){"" name "", __FILE__, __LINE__,              \
                       z3y::interfaces::profiler::NodeType::Timer}; \
-  _z3y_linear_mgr.Next(&Z3Y_PROF_CAT(s_nx, __LINE__))
+  _z3y_linear_mgr.Next(&Z3Y_PROF_CAT(s_nx, __LINE__));             \
+  Z3Y_PROF_EXT_MARK(name)
+#elif Z3Y_PROFILE_LEVEL >= 1
+#define Z3Y_PROFILE_NEXT(name) Z3Y_PROF_EXT_MARK(name)
+#else
+#define Z3Y_PROFILE_NEXT(name) Z3Y_PROF_NAME_ONLY(name)
+#endif
 
 /**
  * @def Z3Y_PROFILE_VALUE
  * @brief 记录一项自定义数值量（如 CPU
  * 温度、丢帧数量）。底层会对该数值自动求平均和极值。
  */
+#if Z3Y_PROFILE_LEVEL >= 2 && Z3Y_PROFILE_AGGREGATOR
 #define Z3Y_PROFILE_VALUE(name, val)                                        \
   {                                                                         \
+    Z3Y_PROF_EXT_VALUE(name, val);                                          \
     static z3y::interfaces::profiler::ProfileNodeData Z3Y_PROF_CAT(         \
         s_val, __LINE__){"" name "", __FILE__, __LINE__,                    \
                          z3y::interfaces::profiler::NodeType::Value};       \
     z3y::interfaces::profiler::RecordMetric(&Z3Y_PROF_CAT(s_val, __LINE__), \
                                             static_cast<double>(val));      \
   }
+#elif Z3Y_PROFILE_LEVEL >= 2
+#define Z3Y_PROFILE_VALUE(name, val) Z3Y_PROF_EXT_VALUE(name, val)
+#else
+#define Z3Y_PROFILE_VALUE(name, val) \
+  (Z3Y_PROF_NAME_ONLY(name), Z3Y_PROF_UNUSED(val))
+#endif
 
 /**
  * @def Z3Y_PROFILE_EVENT
  * @brief 记录单次触发性事件的发生（类似于埋点）。在报告中仅累加触发次数。
  */
+#if Z3Y_PROFILE_LEVEL >= 2 && Z3Y_PROFILE_AGGREGATOR
 #define Z3Y_PROFILE_EVENT(name)                                             \
   {                                                                         \
+    Z3Y_PROF_EXT_MARK(name);                                                \
     static z3y::interfaces::profiler::ProfileNodeData Z3Y_PROF_CAT(         \
         s_evt, __LINE__){"" name "", __FILE__, __LINE__,                    \
                          z3y::interfaces::profiler::NodeType::Event};       \
     z3y::interfaces::profiler::RecordMetric(&Z3Y_PROF_CAT(s_evt, __LINE__), \
                                             1.0);                           \
   }
+#elif Z3Y_PROFILE_LEVEL >= 2
+#define Z3Y_PROFILE_EVENT(name) Z3Y_PROF_EXT_MARK(name)
+#else
+#define Z3Y_PROFILE_EVENT(name) Z3Y_PROF_NAME_ONLY(name)
+#endif
 
 /**
  * @def Z3Y_PROFILE_ASYNC_BEGIN
  * @brief 【异步多线程调度器使用】在一组跨线程处理流程之初创建槽位并绑定。
  */
-#define Z3Y_PROFILE_ASYNC_BEGIN(name, id, period, sla)                  \
-  if (auto [svc, err] = z3y::TryGetDefaultService<                      \
-          z3y::interfaces::profiler::IProfilerService>();               \
-      err == z3y::InstanceError::kSuccess) {                            \
-    if (svc->IsEnabled()) svc->AsyncBegin("" name "", id, period, sla); \
-  }
+#if Z3Y_PROFILE_LEVEL >= 1 && Z3Y_PROFILE_AGGREGATOR
+#define Z3Y_PROFILE_ASYNC_BEGIN(name, id, period, sla)                    \
+  do {                                                                    \
+    Z3Y_PROF_EXT_ASYNC_BEGIN(name, id);                                   \
+    if (auto* svc =                                                       \
+            z3y::interfaces::profiler::CurrentProfiler().service) {       \
+      if (svc->IsEnabled())                                               \
+        svc->AsyncBegin("" name "", id, period, sla);                     \
+    }                                                                     \
+  } while (0)
+#elif Z3Y_PROFILE_LEVEL >= 1
+#define Z3Y_PROFILE_ASYNC_BEGIN(name, id, period, sla)                    \
+  (Z3Y_PROF_EXT_ASYNC_BEGIN(name, id), Z3Y_PROF_UNUSED(period),           \
+   Z3Y_PROF_UNUSED(sla))
+#else
+#define Z3Y_PROFILE_ASYNC_BEGIN(name, id, period, sla) \
+  (Z3Y_PROF_NAME_ONLY(name), Z3Y_PROF_UNUSED(id), Z3Y_PROF_UNUSED(period), \
+   Z3Y_PROF_UNUSED(sla))
+#endif
 
 /**
  * @def Z3Y_PROFILE_ASYNC_ATTACH
  * @brief 【异步 Worker 线程使用】将所在线程当下的性能剖析栈“挂靠”回指定的
  * Frame_ID 主分析槽位上。
  */
-#define Z3Y_PROFILE_ASYNC_ATTACH(id)                      \
-  if (auto [svc, err] = z3y::TryGetDefaultService<        \
-          z3y::interfaces::profiler::IProfilerService>(); \
-      err == z3y::InstanceError::kSuccess) {              \
-    if (svc->IsEnabled()) svc->AsyncAttach(id);           \
-  }
+#if Z3Y_PROFILE_LEVEL >= 1 && Z3Y_PROFILE_AGGREGATOR
+#define Z3Y_PROFILE_ASYNC_ATTACH(id)                                    \
+  do {                                                                  \
+    Z3Y_PROF_EXT_ASYNC_ATTACH(id);                                      \
+    if (auto* svc =                                                     \
+            z3y::interfaces::profiler::CurrentProfiler().service) {     \
+      if (svc->IsEnabled()) svc->AsyncAttach(id);                       \
+    }                                                                   \
+  } while (0)
+#elif Z3Y_PROFILE_LEVEL >= 1
+#define Z3Y_PROFILE_ASYNC_ATTACH(id) Z3Y_PROF_EXT_ASYNC_ATTACH(id)
+#else
+#define Z3Y_PROFILE_ASYNC_ATTACH(id) Z3Y_PROF_UNUSED(id)
+#endif
 
 /**
  * @def Z3Y_PROFILE_ASYNC_COMMIT
  * @brief
  * 【异步生命周期收尾处使用】当这一帧的完整处理已经结束，结算并提交报告，同时腾出槽位。
  */
-#define Z3Y_PROFILE_ASYNC_COMMIT(id)                      \
-  if (auto [svc, err] = z3y::TryGetDefaultService<        \
-          z3y::interfaces::profiler::IProfilerService>(); \
-      err == z3y::InstanceError::kSuccess) {              \
-    if (svc->IsEnabled()) svc->AsyncCommit(id);           \
-  }
+#if Z3Y_PROFILE_LEVEL >= 1 && Z3Y_PROFILE_AGGREGATOR
+#define Z3Y_PROFILE_ASYNC_COMMIT(id)                                    \
+  do {                                                                  \
+    Z3Y_PROF_EXT_ASYNC_COMMIT(id);                                      \
+    if (auto* svc =                                                     \
+            z3y::interfaces::profiler::CurrentProfiler().service) {     \
+      if (svc->IsEnabled()) svc->AsyncCommit(id);                       \
+    }                                                                   \
+  } while (0)
+#elif Z3Y_PROFILE_LEVEL >= 1
+#define Z3Y_PROFILE_ASYNC_COMMIT(id) Z3Y_PROF_EXT_ASYNC_COMMIT(id)
+#else
+#define Z3Y_PROFILE_ASYNC_COMMIT(id) Z3Y_PROF_UNUSED(id)
+#endif
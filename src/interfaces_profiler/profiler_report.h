@@ -0,0 +1,530 @@
+﻿/**
+ * @file profiler_report.h
+ * @brief 结构化性能报告：快照数据结构、可插拔的报告接收器与序列化工具。
+ * * @details
+ * 【面向使用者】
+ * 默认情况下报告以文本形式写入 "System.Profiler" 日志。如果你需要把报告送进
+ * 火焰图、监控平台或自己的看板，实现一个 IProfilerReportSink 并注册即可：
+ * \code{.cpp}
+ * class FlameSink : public z3y::interfaces::profiler::IProfilerReportSink {
+ *   void OnReport(const ProfileReport& r) override {
+ *     std::ofstream out("profile.folded", std::ios::app);
+ *     z3y::interfaces::profiler::WriteCollapsedStacks(out, r);
+ *   }
+ * };
+ * profiler->AddReportSink(std::make_shared<FlameSink>());
+ * \endcode
+ * * 【面向维护者】
+ * 触发报告的业务线程只负责把聚合树拍平成 ProfileReport（先序遍历、一维数组，
+ * 只拷贝数值与名字），随后交给 Profiler 的后台线程；文本格式化、日志写入与
+ * 所有 Sink 回调都在后台线程执行。名字会被深拷贝，因为探针所在的插件可能在
+ * 报告输出之前就被卸载。
+ */
+
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "profiler_types.h"
+
+namespace z3y::interfaces::profiler {
+
+/**
+ * @brief 类型化标签 (Z3Y_PROFILE_TAG_INT 等) 的一个值及其出现次数。
+ */
+struct TagValueStat {
+  std::string key;     ///< 标签的键
+  std::string value;   ///< 值的文本（整数 / 枚举按十进制，驻留字符串解析回原文）
+  uint64_t count = 0;  ///< 该值被记录的次数
+};
+
+/**
+ * @brief 报告中的一个节点（聚合树拍平后的先序序列中的一项）。
+ */
+struct ReportNode {
+  std::string name;                 ///< 节点名称
+  std::string file;                 ///< 探针所在源文件（动态节点可能为空）
+  uint32_t line = 0;                ///< 探针所在行号
+  NodeType type = NodeType::Timer;  ///< 节点类型
+  uint32_t depth = 0;               ///< 在树中的深度（根为 0）
+  int32_t parent = -1;              ///< 父节点在 ProfileReport::nodes 中的下标，根为 -1
+  uint64_t count = 0;               ///< 调用 / 发生次数
+
+  double total_ms = 0.0;  ///< 累计耗时（Timer / Linear）
+  double min_ms = 0.0;    ///< 单次最小耗时
+  double max_ms = 0.0;    ///< 单次最大耗时
+
+  double sum_value = 0.0;  ///< 数值累加（Value）
+  double max_value = 0.0;  ///< 数值最大值（Value）
+
+  bool has_percentiles = false;  ///< 节点是否挂有直方图
+  /// p50 / p95 / p99 / p999。Timer 为毫秒，Value 为数值本身的单位
+  std::array<double, 4> percentiles{};
+  /// 直方图精度（LogHistogram 的 precision_bits），0 表示 histogram 为空
+  uint32_t histogram_bits = 0;
+  /// 非空桶（桶下标, 次数），按下标升序。Timer 以纳秒、Value 以 kValueScale 定点值分桶，
+  /// 与本机时钟频率无关，不同进程的同名节点可以直接逐桶相加
+  std::vector<std::pair<uint32_t, uint64_t>> histogram;
+
+  std::vector<std::pair<std::string, std::string>> tags;  ///< 上下文标签
+  /// 类型化标签的按值计数：同一个键的值相邻，键内按次数降序
+  std::vector<TagValueStat> tag_values;
+  uint64_t tag_value_overflow = 0;  ///< 超出每节点槽位上限、未单独计数的记录次数
+
+  /// 读到硬件计数器的作用域次数；0 表示该节点没有计数器数据
+  uint64_t hw_samples = 0;
+  HardwareCounterSample hw_counters{};  ///< 各计数器的累计增量（按 HardwareCounter 下标）
+
+  /// 作用域自身（不含子节点）的堆分配次数与字节数（System.Profiler.AllocationTracking）
+  uint64_t alloc_count = 0;
+  uint64_t alloc_bytes = 0;
+};
+
+/**
+ * @brief 节拍根的一帧：从它开始到下一帧开始的间隔，以及这段时间花在了哪里。
+ */
+struct PacedFrame {
+  uint64_t frame = 0;        ///< 帧序号（该根开始节拍统计以来，从 1 起）
+  double interval_ms = 0.0;  ///< 本帧开始到下一帧开始的间隔
+  double frame_ms = 0.0;     ///< 本帧作用域自身的耗时
+  double gap_ms = 0.0;       ///< 本帧结束到下一帧开始的空档（作用域外的等待 / 调度延迟）
+  /// 本帧各直接子节点的耗时（毫秒），按耗时降序
+  std::vector<std::pair<std::string, double>> stages;
+};
+
+/**
+ * @brief 节拍根 (Z3Y_PROFILE_ROOT_PACED) 的帧间隔统计，cadence_ms 为 0 表示不是节拍根。
+ * @details 间隔是相邻两帧开始时刻之差。偏离节拍超过 tolerance 的晚到记为一次 deadline miss。
+ */
+struct FramePacing {
+  static constexpr size_t kJitterBuckets = 8;
+  /// 抖动直方图的上界（|间隔 - 节拍| / 节拍），最后一桶为 100% 及以上
+  static constexpr std::array<double, kJitterBuckets - 1> kJitterBounds = {
+      0.01, 0.02, 0.05, 0.10, 0.25, 0.50, 1.00};
+  static constexpr size_t kMaxWorstFrames = 8;  ///< 保留的最差帧数
+
+  double cadence_ms = 0.0;    ///< 期望的帧间隔
+  double tolerance = 0.0;     ///< 允许的晚到比例（System.Profiler.PacingTolerancePercent）
+  uint64_t intervals = 0;     ///< 测到的间隔数
+  uint64_t deadline_misses = 0;  ///< 间隔超过 cadence_ms * (1 + tolerance) 的次数
+  double min_interval_ms = 0.0;
+  double mean_interval_ms = 0.0;
+  double max_interval_ms = 0.0;
+  double jitter_rms_ms = 0.0;  ///< 间隔相对节拍的均方根偏差
+  std::array<uint64_t, kJitterBuckets> jitter_histogram{};  ///< 按 kJitterBounds 分桶的次数
+  std::vector<PacedFrame> worst_frames;  ///< 间隔最长的帧，按间隔降序
+};
+
+/**
+ * @brief 一份完整的性能报告快照。
+ */
+struct ProfileReport {
+  std::string reason;             ///< 触发原因（SLA 超时 / 周期）
+  double root_ms = 0.0;           ///< 根节点累计耗时，用于计算占比
+  /// 每次探针计入父节点的开销（纳秒，已从 total_ms 中扣除）。0 表示未做补偿
+  double probe_overhead_ns = 0.0;
+  double probe_self_ns = 0.0;  ///< 每次探针计入自身节点的开销（纳秒，已扣除）
+  /// 自上一份报告以来，因超过影子栈深度上限而未记录的探针次数（全部线程）
+  uint64_t depth_overflows = 0;
+  std::vector<ReportNode> nodes;  ///< 先序排列，nodes[0] 为根
+  FramePacing pacing;             ///< 节拍根的帧间隔统计（其他根为空）
+};
+
+/**
+ * @brief 采样模式下一个模块（EXE / DLL / SO）的样本统计。
+ */
+struct SampledModule {
+  std::string name;        ///< 模块文件名；无法归属的地址计入 "[unknown]"
+  bool is_plugin = false;  ///< 是否为 PluginManager 已加载的插件
+  uint64_t samples = 0;    ///< 命中该模块的样本数
+};
+
+/**
+ * @brief 采样模式下一个函数（或无符号地址）的样本统计。
+ */
+struct SampledSymbol {
+  std::string module;    ///< 所在模块的文件名
+  std::string symbol;    ///< 导出符号名；查不到时为模块内偏移 "+0x..."
+  uint64_t samples = 0;  ///< 命中该函数的样本数
+};
+
+/**
+ * @brief 采样模式下一个线程的样本统计。
+ */
+struct SampledThread {
+  uint64_t thread_id = 0;  ///< 系统线程 ID
+  std::string name;        ///< 线程名（Linux 读自 /proc，查不到时为空）
+  uint64_t samples = 0;    ///< 该线程上的样本数
+};
+
+/**
+ * @brief 采样分析结果（System.Profiler.SamplingHz 开启后持续累积）。
+ * @details 与插桩报告互补：不需要 Z3Y_PROFILE* 宏，覆盖框架自身的工作线程
+ * （事件循环、配置线程、spdlog 异步线程等）与插件创建的线程。
+ * 各列表均按样本数降序排列。
+ */
+struct SamplingProfile {
+  uint32_t rate_hz = 0;          ///< 当前采样频率，0 表示采样未开启
+  uint64_t total_samples = 0;    ///< 本次采样会话累计的样本数
+  uint64_t dropped_samples = 0;  ///< 采样缓冲区已满而丢弃的样本数
+  std::vector<SampledModule> modules;
+  std::vector<SampledSymbol> symbols;  ///< 最多 max_symbols 项
+  std::vector<SampledThread> threads;
+};
+
+/**
+ * @brief 锁竞争报告的一项：一把锁在一个加锁调用点上的累计统计。
+ * @details 数据来自框架的 ProfiledMutex（需以 Z3Y_LOCK_PROFILING 构建，并开启
+ * System.Profiler.LockContention）。共享加锁只有等待时间。
+ */
+struct LockContentionEntry {
+  std::string lock_name;      ///< 锁名（如 "PluginManager.registry_mutex_"）
+  std::string module;         ///< 调用点所在模块的文件名
+  std::string symbol;         ///< 调用点所在函数；查不到时为模块内偏移 "+0x..."
+  uint64_t acquisitions = 0;  ///< 加锁次数
+  uint64_t contended = 0;     ///< 其中第一次尝试失败、需要等待的次数
+  double total_wait_ms = 0.0;
+  double max_wait_ms = 0.0;
+  double total_hold_ms = 0.0;
+  double max_hold_ms = 0.0;
+};
+
+/** @brief 追踪事件的种类（System.Profiler.TraceRingSize > 0 时记录）。 */
+enum class TracePhase : uint8_t {
+  FrameBegin,  ///< ASYNC_BEGIN：帧进入流水线
+  StageBegin,  ///< ASYNC_ATTACH：某个线程开始处理这一帧
+  StageEnd,    ///< 该线程 ASYNC_COMMIT（或改挂到别的帧）
+  FrameEnd,    ///< 最后一个引用提交，帧离开流水线
+  ScopeBegin,  ///< 飞行记录器 / 设备区间：进入一个探针作用域（name 为探针名，frame_id 为 0）
+  ScopeEnd,    ///< 飞行记录器 / 设备区间：离开探针作用域
+  TrackName,   ///< 设备轨道的名字（thread_id 为轨道 ID，name 为设备名）
+};
+
+/**
+ * @brief 一条异步流追踪事件。同一 frame_id 的事件按时间串起来就是这一帧在各线程间的路径。
+ */
+struct TraceEvent {
+  double timestamp_us = 0.0;  ///< 自追踪开启以来的微秒数
+  uint64_t frame_id = 0;
+  uint64_t thread_id = 0;     ///< 系统线程 ID
+  TracePhase phase = TracePhase::FrameBegin;
+  std::string name;           ///< 帧名（ASYNC_BEGIN 的 name）
+};
+
+/**
+ * @brief 追踪事件的一次收集结果，按时间升序排列。
+ * @details 每个线程一个环形缓冲区，写满后覆盖最旧的事件，覆盖掉的条数计入 overwritten。
+ */
+struct TraceCapture {
+  std::vector<TraceEvent> events;
+  uint64_t overwritten = 0;
+};
+
+/**
+ * @brief 飞行记录器的一次冻结结果（SLA 超时或 FreezeFlightRecorder 触发）。
+ * @details trace 只含 ScopeBegin / ScopeEnd，时间戳以窗口起点为 0；窗口开始前已进入的
+ * 作用域只有 ScopeEnd。overwritten 为冻结时正被覆盖、因而丢弃的记录数。
+ */
+struct FlightRecording {
+  uint64_t sequence = 0;   ///< 本服务实例内第几次冻结（从 1 开始）
+  std::string reason;      ///< 触发原因（SLA 报告的 reason 或调用方给出的文本）
+  double window_ms = 0.0;  ///< 冻结的时间窗口（System.Profiler.FlightRecorderWindowMs）
+  TraceCapture trace;
+};
+
+/**
+ * @brief 报告接收器。
+ * @details `OnReport` 在 Profiler 的后台线程上被串行调用，不得长时间阻塞；
+ * 抛出的异常会被捕获并丢弃。
+ */
+class IProfilerReportSink {
+ public:
+  virtual ~IProfilerReportSink() = default;
+  virtual void OnReport(const ProfileReport& report) = 0;
+};
+
+namespace detail {
+inline void WriteJsonString(std::ostream& os, const std::string& s) {
+  static const char kHex[] = "0123456789abcdef";
+  os << '"';
+  for (unsigned char c : s) {
+    if (c == '"' || c == '\\') {
+      os << '\\' << static_cast<char>(c);
+    } else if (c < 0x20) {
+      os << "\\u00" << kHex[c >> 4] << kHex[c & 0xF];
+    } else {
+      os << static_cast<char>(c);
+    }
+  }
+  os << '"';
+}
+
+inline const char* NodeTypeName(NodeType type) {
+  switch (type) {
+    case NodeType::Timer: return "timer";
+    case NodeType::Value: return "value";
+    case NodeType::Event: return "event";
+    case NodeType::Linear: return "linear";
+  }
+  return "unknown";
+}
+}  // namespace detail
+
+/**
+ * @brief 以嵌套 JSON 树的形式输出报告（每个节点含 children 数组）。
+ */
+inline void WriteJson(std::ostream& os, const ProfileReport& report) {
+  os << "{\"reason\":";
+  detail::WriteJsonString(os, report.reason);
+  os << ",\"root_ms\":" << report.root_ms
+     << ",\"probe_overhead_ns\":" << report.probe_overhead_ns
+     << ",\"probe_self_ns\":" << report.probe_self_ns
+     << ",\"depth_overflows\":" << report.depth_overflows;
+  if (report.pacing.cadence_ms > 0.0) {
+    const FramePacing& p = report.pacing;
+    os << ",\"pacing\":{\"cadence_ms\":" << p.cadence_ms
+       << ",\"tolerance\":" << p.tolerance << ",\"intervals\":" << p.intervals
+       << ",\"deadline_misses\":" << p.deadline_misses
+       << ",\"min_interval_ms\":" << p.min_interval_ms
+       << ",\"mean_interval_ms\":" << p.mean_interval_ms
+       << ",\"max_interval_ms\":" << p.max_interval_ms
+       << ",\"jitter_rms_ms\":" << p.jitter_rms_ms << ",\"jitter_histogram\":[";
+    for (size_t b = 0; b < p.jitter_histogram.size(); ++b) {
+      if (b) os << ',';
+      os << p.jitter_histogram[b];
+    }
+    os << "],\"worst_frames\":[";
+    for (size_t f = 0; f < p.worst_frames.size(); ++f) {
+      const PacedFrame& frame = p.worst_frames[f];
+      if (f) os << ',';
+      os << "{\"frame\":" << frame.frame << ",\"interval_ms\":" << frame.interval_ms
+         << ",\"frame_ms\":" << frame.frame_ms << ",\"gap_ms\":" << frame.gap_ms
+         << ",\"stages\":{";
+      for (size_t t = 0; t < frame.stages.size(); ++t) {
+        if (t) os << ',';
+        detail::WriteJsonString(os, frame.stages[t].first);
+        os << ':' << frame.stages[t].second;
+      }
+      os << "}}";
+    }
+    os << "]}";
+  }
+  os << ",\"tree\":";
+  if (report.nodes.empty()) {
+    os << "null}";
+    return;
+  }
+  uint32_t open = 0;         // 已打开但未闭合的 children 层数
+  bool first_in_list = true;  // 当前节点是否为所在 children 数组的第一项
+  for (size_t i = 0; i < report.nodes.size(); ++i) {
+    const ReportNode& n = report.nodes[i];
+    // 回退到当前节点的父层：闭合更深的节点
+    while (open > n.depth) {
+      os << "]}";
+      --open;
+    }
+    if (!first_in_list) os << ',';
+    first_in_list = false;
+    os << "{\"name\":";
+    detail::WriteJsonString(os, n.name);
+    os << ",\"type\":\"" << detail::NodeTypeName(n.type)
+       << "\",\"count\":" << n.count;
+    if (n.type == NodeType::Value) {
+      os << ",\"sum\":" << n.sum_value << ",\"max\":" << n.max_value;
+    } else if (n.type != NodeType::Event) {
+      os << ",\"total_ms\":" << n.total_ms << ",\"min_ms\":" << n.min_ms
+         << ",\"max_ms\":" << n.max_ms;
+    }
+    if (n.has_percentiles) {
+      os << ",\"p50\":" << n.percentiles[0] << ",\"p95\":" << n.percentiles[1]
+         << ",\"p99\":" << n.percentiles[2] << ",\"p999\":" << n.percentiles[3];
+    }
+    if (!n.tags.empty()) {
+      os << ",\"tags\":{";
+      for (size_t t = 0; t < n.tags.size(); ++t) {
+        if (t) os << ',';
+        detail::WriteJsonString(os, n.tags[t].first);
+        os << ':';
+        detail::WriteJsonString(os, n.tags[t].second);
+      }
+      os << '}';
+    }
+    if (!n.tag_values.empty() || n.tag_value_overflow > 0) {
+      os << ",\"tag_values\":[";
+      for (size_t t = 0; t < n.tag_values.size(); ++t) {
+        if (t) os << ',';
+        os << "{\"key\":";
+        detail::WriteJsonString(os, n.tag_values[t].key);
+        os << ",\"value\":";
+        detail::WriteJsonString(os, n.tag_values[t].value);
+        os << ",\"count\":" << n.tag_values[t].count << '}';
+      }
+      os << "],\"tag_value_overflow\":" << n.tag_value_overflow;
+    }
+    if (n.hw_samples > 0) {
+      os << ",\"hw\":{\"samples\":" << n.hw_samples
+         << ",\"instructions\":" << n.hw_counters[0]
+         << ",\"cycles\":" << n.hw_counters[1]
+         << ",\"cache_misses\":" << n.hw_counters[2]
+         << ",\"branch_misses\":" << n.hw_counters[3] << '}';
+    }
+    if (n.alloc_count > 0) {
+      os << ",\"alloc\":{\"count\":" << n.alloc_count
+         << ",\"bytes\":" << n.alloc_bytes << '}';
+    }
+    if (!n.file.empty()) {
+      os << ",\"file\":";
+      detail::WriteJsonString(os, n.file);
+      os << ",\"line\":" << n.line;
+    }
+    const bool has_children =
+        i + 1 < report.nodes.size() && report.nodes[i + 1].depth > n.depth;
+    if (has_children) {
+      os << ",\"children\":[";
+      ++open;
+      first_in_list = true;
+    } else {
+      os << '}';
+    }
+  }
+  while (open > 0) {
+    os << "]}";
+    --open;
+  }
+  os << "}";
+}
+
+/**
+ * @brief 以火焰图折叠栈格式（Brendan Gregg collapsed stacks）输出耗时节点。
+ * @details 每行 `root;child;leaf <自身耗时微秒>`，可直接交给 flamegraph.pl /
+ * speedscope / inferno。自身耗时 = 节点耗时 - 子耗时节点耗时之和（截断为 0）。
+ */
+inline void WriteCollapsedStacks(std::ostream& os,
+                                 const ProfileReport& report) {
+  const size_t n = report.nodes.size();
+  std::vector<double> child_ms(n, 0.0);
+  for (size_t i = 1; i < n; ++i) {
+    const ReportNode& node = report.nodes[i];
+    if (node.parent >= 0 && node.type != NodeType::Value &&
+        node.type != NodeType::Event) {
+      child_ms[static_cast<size_t>(node.parent)] += node.total_ms;
+    }
+  }
+  std::vector<const std::string*> path;
+  for (size_t i = 0; i < n; ++i) {
+    const ReportNode& node = report.nodes[i];
+    path.resize(node.depth);
+    path.push_back(&node.name);
+    if (node.type == NodeType::Value || node.type == NodeType::Event) continue;
+    double self_ms = node.total_ms - child_ms[i];
+    if (self_ms <= 0.0) continue;
+    for (size_t d = 0; d < path.size(); ++d) {
+      if (d) os << ';';
+      os << *path[d];
+    }
+    os << ' ' << static_cast<uint64_t>(self_ms * 1000.0 + 0.5) << '\n';
+  }
+}
+
+/**
+ * @brief 以 Chrome Trace Event 格式（JSON）输出追踪事件，可直接拖进 Perfetto / chrome://tracing。
+ * @details 每个阶段是处理线程上的一个 B/E 区间；同一帧的各阶段用 flow 事件 (s/t/f，
+ * id = frame_id) 连成箭头，箭头之间的空档就是帧在阶段之间排队等待的时间。
+ * 帧的完整生命周期另以异步区间 (b/e) 输出。环形缓冲区覆盖掉 StageBegin 后遗留的
+ * StageEnd 会被跳过，尚未结束的阶段只输出 B（查看器会延伸到时间轴末尾）。
+ * 飞行记录与设备区间的 ScopeBegin / ScopeEnd 同样输出为 B/E，窗口之前进入的作用域的 E 被跳过；
+ * TrackName 输出为 thread_name 元数据，给设备轨道命名。
+ */
+inline void WriteChromeTrace(std::ostream& os, const TraceCapture& trace) {
+  // 时间戳是微秒：定点输出保留到纳秒，默认 6 位有效数字在几秒之后就会丢精度
+  const std::ios_base::fmtflags saved_flags = os.flags();
+  const std::streamsize saved_precision = os.precision(3);
+  os.setf(std::ios_base::fixed, std::ios_base::floatfield);
+  os << "{\"displayTimeUnit\":\"ms\",\"otherData\":{\"overwritten\":"
+     << trace.overwritten << "},\"traceEvents\":[";
+  struct OpenSpans {
+    uint64_t thread_id;
+    uint32_t stages;  ///< 未闭合的阶段数
+    uint32_t scopes;  ///< 未闭合的作用域数（飞行记录）
+  };
+  std::vector<OpenSpans> open_spans;
+  bool first = true;
+  auto event = [&](const char* ph, const TraceEvent& e) {
+    if (!first) os << ',';
+    first = false;
+    os << "{\"ph\":\"" << ph << "\",\"pid\":1,\"tid\":" << e.thread_id
+       << ",\"ts\":" << e.timestamp_us << ",\"name\":";
+    detail::WriteJsonString(os, e.name);
+  };
+  auto flow = [&](const char* ph, const TraceEvent& e) {
+    event(ph, e);
+    os << ",\"cat\":\"frame\",\"id\":" << e.frame_id;
+    if (ph[0] != 's') os << ",\"bp\":\"e\"";
+    os << '}';
+  };
+  for (const TraceEvent& e : trace.events) {
+    auto it = std::find_if(open_spans.begin(), open_spans.end(),
+                           [&](const auto& p) { return p.thread_id == e.thread_id; });
+    if (it == open_spans.end()) {
+      open_spans.push_back({e.thread_id, 0u, 0u});
+      it = open_spans.end() - 1;
+    }
+    switch (e.phase) {
+      case TracePhase::FrameBegin:
+        event("b", e);
+        os << ",\"cat\":\"frame\",\"id\":" << e.frame_id << '}';
+        event("X", e);  // 零长度锚点，flow 起点绑定在它上面
+        os << ",\"dur\":0,\"args\":{\"frame_id\":" << e.frame_id << "}}";
+        flow("s", e);
+        break;
+      case TracePhase::StageBegin:
+        ++it->stages;
+        event("B", e);
+        os << ",\"args\":{\"frame_id\":" << e.frame_id << "}}";
+        flow("t", e);
+        break;
+      case TracePhase::StageEnd:
+        if (it->stages == 0) break;
+        --it->stages;
+        event("E", e);
+        os << '}';
+        break;
+      case TracePhase::FrameEnd:
+        event("X", e);
+        os << ",\"dur\":0,\"args\":{\"frame_id\":" << e.frame_id << "}}";
+        flow("f", e);
+        event("e", e);
+        os << ",\"cat\":\"frame\",\"id\":" << e.frame_id << '}';
+        break;
+      case TracePhase::ScopeBegin:
+        ++it->scopes;
+        event("B", e);
+        os << '}';
+        break;
+      case TracePhase::ScopeEnd:
+        if (it->scopes == 0) break;  // 进入发生在窗口之前
+        --it->scopes;
+        event("E", e);
+        os << '}';
+        break;
+      case TracePhase::TrackName:
+        if (!first) os << ',';
+        first = false;
+        os << "{\"ph\":\"M\",\"pid\":1,\"tid\":" << e.thread_id
+           << ",\"name\":\"thread_name\",\"args\":{\"name\":";
+        detail::WriteJsonString(os, e.name);
+        os << "}}";
+        break;
+    }
+  }
+  os << "]}";
+  os.flags(saved_flags);
+  os.precision(saved_precision);
+}
+
+}  // namespace z3y::interfaces::profiler
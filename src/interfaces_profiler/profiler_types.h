@@ -17,6 +17,15 @@
 #include <array>
 #include <atomic>
 #include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+
+#if defined(_MSC_VER)
+#include <intrin.h>  // _BitScanReverse64
+#endif
+
+#include "profiler_clock.h"
 
 namespace z3y::interfaces::profiler {
 // [新增] 辅助原语：无锁双精度浮点数 CAS 更新最大值
@@ -49,6 +58,21 @@ inline void AtomicUpdateMin(std::atomic<uint64_t>& target, double val) {
   }
 }
 
+// 辅助原语：无锁整数最大 / 最小值 (耗时以原始 tick 记录)
+inline void AtomicUpdateMaxU64(std::atomic<uint64_t>& target, uint64_t val) {
+  uint64_t prev = target.load(std::memory_order_relaxed);
+  while (val > prev &&
+         !target.compare_exchange_weak(prev, val, std::memory_order_relaxed)) {
+  }
+}
+
+inline void AtomicUpdateMinU64(std::atomic<uint64_t>& target, uint64_t val) {
+  uint64_t prev = target.load(std::memory_order_relaxed);
+  while (val < prev &&
+         !target.compare_exchange_weak(prev, val, std::memory_order_relaxed)) {
+  }
+}
+
 inline void AtomicAddDouble(std::atomic<uint64_t>& target, double val) {
   uint64_t prev_bits = target.load(std::memory_order_relaxed);
   while (true) {
@@ -64,6 +88,126 @@ inline void AtomicAddDouble(std::atomic<uint64_t>& target, double val) {
   }
 }
 
+/**
+ * @brief HDR 风格的对数分桶直方图，用于给出 p50/p95/p99/p999。
+ * * @details
+ * 【面向维护者】
+ * 每个 2 的幂区间再均分为 `2^precision_bits` 个子桶，相对误差不超过
+ * `2^-precision_bits`；小于 `2^precision_bits` 的值逐个精确计数。
+ * 桶数为 `(65 - bits) << bits`（bits=2 时 252 个桶，约 2KB）。
+ * 记录只有一次 relaxed fetch_add；各桶彼此独立，合并即逐桶相加。
+ * 直方图由 Service 在分配节点时按配置挂上，未开启时节点上为空指针，探针零额外开销。
+ */
+class LogHistogram {
+ public:
+  static constexpr uint32_t kMaxPrecisionBits = 4;  ///< 最高精度（约 6% 相对误差）
+
+  explicit LogHistogram(uint32_t precision_bits)
+      : bits_(precision_bits < kMaxPrecisionBits ? precision_bits
+                                                 : kMaxPrecisionBits),
+        buckets_(new std::atomic<uint64_t>[BucketCount(bits_)]) {
+    Reset();
+  }
+
+  uint32_t GetPrecisionBits() const { return bits_; }
+
+  static size_t BucketCount(uint32_t bits) {
+    return static_cast<size_t>(65 - bits) << bits;
+  }
+
+  /** @brief 记录一个样本（允许多线程并发）。 */
+  void Record(uint64_t v) {
+    buckets_[BucketOf(v)].fetch_add(1, std::memory_order_relaxed);
+  }
+
+  /** @brief 记录一个样本（调用方保证只有本线程写入，见 AggregatorNode::thread_owned）。 */
+  void RecordOwned(uint64_t v) {
+    auto& bucket = buckets_[BucketOf(v)];
+    bucket.store(bucket.load(std::memory_order_relaxed) + 1,
+                 std::memory_order_relaxed);
+  }
+
+  /** @brief 把 other 的计数累加进来（精度不同时忽略）。 */
+  void Merge(const LogHistogram& other) {
+    if (other.bits_ != bits_) return;
+    for (size_t i = 0, n = BucketCount(bits_); i < n; ++i) {
+      if (uint64_t c = other.buckets_[i].load(std::memory_order_relaxed)) {
+        buckets_[i].fetch_add(c, std::memory_order_relaxed);
+      }
+    }
+  }
+
+  void Reset() {
+    for (size_t i = 0, n = BucketCount(bits_); i < n; ++i) {
+      buckets_[i].store(0, std::memory_order_relaxed);
+    }
+  }
+
+  /** @brief 第 index 个桶的计数（index < BucketCount(GetPrecisionBits())）。 */
+  uint64_t BucketValue(size_t index) const {
+    return buckets_[index].load(std::memory_order_relaxed);
+  }
+
+  /** @brief 样本 v 在精度 bits 下所属的桶。跨进程合并直方图时用它按同一规则分桶。 */
+  static size_t IndexOf(uint32_t bits, uint64_t v) {
+    if (v < (uint64_t{1} << bits)) return static_cast<size_t>(v);
+    const uint32_t octave = HighestBit(v);
+    const uint64_t sub = (v >> (octave - bits)) - (uint64_t{1} << bits);
+    return (static_cast<size_t>(octave - bits + 1) << bits) +
+           static_cast<size_t>(sub);
+  }
+
+  /** @brief 精度 bits 下第 index 个桶的中点。 */
+  static uint64_t MidpointOf(uint32_t bits, size_t index) {
+    if (index < (size_t{1} << bits)) return index;
+    const uint32_t shift = static_cast<uint32_t>(index >> bits) - 1;
+    const uint64_t sub = index & ((size_t{1} << bits) - 1);
+    const uint64_t lower = ((uint64_t{1} << bits) + sub) << shift;
+    return lower + ((uint64_t{1} << shift) >> 1);
+  }
+
+  /**
+   * @brief 计算分位数。
+   * @param q 分位 (0, 1]，例如 0.99。
+   * @return 命中桶的中点；没有样本时返回 0。
+   */
+  uint64_t Percentile(double q) const {
+    const size_t n = BucketCount(bits_);
+    uint64_t total = 0;
+    for (size_t i = 0; i < n; ++i) {
+      total += buckets_[i].load(std::memory_order_relaxed);
+    }
+    if (total == 0) return 0;
+    uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(total) + 0.5);
+    if (rank < 1) rank = 1;
+    if (rank > total) rank = total;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < n; ++i) {
+      seen += buckets_[i].load(std::memory_order_relaxed);
+      if (seen >= rank) return BucketMid(i);
+    }
+    return BucketMid(n - 1);
+  }
+
+ private:
+  static uint32_t HighestBit(uint64_t v) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse64(&index, v);
+    return static_cast<uint32_t>(index);
+#else
+    return 63u - static_cast<uint32_t>(__builtin_clzll(v));
+#endif
+  }
+
+  size_t BucketOf(uint64_t v) const { return IndexOf(bits_, v); }
+
+  uint64_t BucketMid(size_t index) const { return MidpointOf(bits_, index); }
+
+  const uint32_t bits_;
+  std::unique_ptr<std::atomic<uint64_t>[]> buckets_;
+};
+
 /**
  * @brief 性能分析节点的类型枚举。
  * * @details
@@ -85,16 +229,63 @@ enum class NodeType {
  * 这是一个在编译期或首次执行时初始化的静态结构。它的生命周期与宿主程序一致。
  * 将静态信息（名字、行号、文件）与动态指标（耗时、次数）分离，是为了在多线程
  * 并发拷贝和查找时，减少需要对比的内存大小，实现 O(1) 级别的静态地址指针匹配。
+ * 探针在某个服务实例下首次执行时向服务登记，拿到启用位图中的一位（probe_key）；
+ * 之后按探针 / 文件 / 模块启停只翻转服务内的位图，不再写探针本身。
  */
 struct ProfileNodeData {
   const char* name;  ///< 节点名称（强制要求为字符串字面量常量，防悬空指针）
   const char* file;  ///< 节点所在源文件路径（由 __FILE__ 宏自动生成）
   uint32_t line;     ///< 节点所在代码行号（由 __LINE__ 宏自动生成）
   NodeType type;     ///< 节点的类型标识
-  std::atomic<bool> enabled{
-      true};  ///< 动态启停开关，允许在运行时通过配置动态关闭某个特定的探针
+  /// 登记键：高 32 位为服务注册表标签（0 表示尚未登记），低 32 位为位图下标
+  std::atomic<uint64_t> probe_key{0};
+};
+
+/**
+ * @brief 探针的匹配方式（用于 IProfilerService::SetProbesEnabled）。
+ */
+enum class ProbeMatch {
+  Name,    ///< 探针名完全相同
+  File,    ///< 源文件路径以给定字符串结尾（如 "vision_pipeline.cpp"）
+  Module,  ///< 探针所在模块（EXE / DLL / SO）的文件名包含给定字符串
+};
+
+/**
+ * @brief 一个已登记探针的描述。字符串均为拷贝，与探针所在模块的生命周期无关。
+ */
+struct ProbeInfo {
+  std::string name;    ///< 探针名
+  std::string file;    ///< 源文件路径
+  uint32_t line = 0;   ///< 行号
+  NodeType type = NodeType::Timer;
+  std::string module;  ///< 所在模块的文件名
+  bool enabled = true;  ///< 当前是否启用
 };
 
+/**
+ * @brief Profiler 自身的内存占用（近似值，各字段独立读取）。
+ */
+struct ProfilerMemoryStats {
+  uint64_t node_slabs = 0;         ///< 常驻的节点块数（已交还给操作系统的块不计）
+  uint64_t node_bytes = 0;         ///< 常驻节点块占用的字节数（块整体计入）
+  uint64_t nodes_carved = 0;       ///< 常驻块中已切出的节点数（在用 + 空闲）
+  uint64_t nodes_free_global = 0;  ///< 全局空闲栈中的节点数（不含各线程缓存）
+  uint64_t histograms = 0;         ///< 挂在节点上的分位数直方图个数
+  uint64_t cold_blocks = 0;        ///< 已分配的冷数据块数（数值统计 + 标签）
+  uint64_t cold_bytes = 0;         ///< 冷数据块占用的字节数
+  uint64_t keyed_roots = 0;           ///< 在用的分组根数（Z3Y_PROFILE_ROOT_KEYED）
+  uint64_t keyed_root_evictions = 0;  ///< 因分组数达到上限而被淘汰 (LRU) 的分组根数
+  uint64_t node_budget_bytes = 0;     ///< 节点内存预算（System.Profiler.NodeMemoryBudgetMB）
+  uint64_t nodes_in_use = 0;          ///< 在用节点数（近似：切出 - 全局空闲，线程缓存计为在用）
+  uint64_t node_slabs_released = 0;   ///< 累计交还给操作系统的节点块数
+  uint64_t node_acquire_failures = 0; ///< 因预算耗尽而未能分配的节点数（对应的路径未被记录）
+  uint64_t budget_evictions = 0;      ///< 内存压力下提前换代（输出并回收）的根数
+  bool memory_pressure = false;       ///< 当前是否处于内存压力状态（根结束时提前换代）
+};
+
+/// 分组根的键带有该位时，低 32 位是 InternTagString 的编号，报告中显示为原字符串
+constexpr uint64_t kKeyedRootInternedKey = uint64_t{1} << 63;
+
 /**
  * @brief 动态上下文标签数据。
  * * @details
@@ -106,12 +297,161 @@ struct ProfileNodeData {
  * value 数组设定为 32 字节。这是为了在不分配堆内存（不使用
  * std::string）的情况下， 能够容纳绝大多数工业场景的序列号或异常状态码。避免
  * malloc 是零开销 Profiler 的底线。
+ * 槽位由 NodeColdStats::tag_count 的 CAS 认领，value 拷贝完成后才以 release 语义发布 key，
+ * 读者只认 key 非空的槽位。
  */
 struct TagData {
-  const char* key = nullptr;  ///< 标签的键（静态指针）
+  std::atomic<const char*> key{nullptr};  ///< 标签的键（静态指针），非空表示槽位已写完
   char value[32] = {0};  ///< 标签的值（预分配栈上内存，安全深拷贝，防止 UAF）
 };
 
+/**
+ * @brief 类型化标签值的种类。
+ */
+enum class TagValueKind : uint8_t {
+  Integer,   ///< 有符号整数（Z3Y_PROFILE_TAG_INT）
+  Enum,      ///< 枚举值，按整数输出（Z3Y_PROFILE_TAG_ENUM）
+  Interned,  ///< 驻留字符串的编号（Z3Y_PROFILE_TAG_NAME / Z3Y_PROFILE_TAG_ID）
+};
+
+/**
+ * @brief 按值计数的类型化标签槽位。
+ * * @details
+ * 【面向维护者】
+ * 值只有 8 字节，记录时不拷贝字符串：字符串先由 Service 驻留成编号，报告时才解析回文本。
+ * 同一节点上 (key, kind, value) 相同的记录落在同一个槽位，只累加次数，
+ * 报告据此给出每个值（如每个相机编号）各出现了多少次，而不是只保留最先写入的一个。
+ */
+struct TagValueCount {
+  std::atomic<const char*> key{nullptr};  ///< 标签的键（静态指针），非空表示槽位已发布
+  uint64_t value = 0;                     ///< 整数 / 枚举值（按位保存）或驻留编号
+  TagValueKind kind = TagValueKind::Integer;
+  std::atomic<uint64_t> count{0};  ///< 该值被记录的次数
+};
+
+/**
+ * @brief 硬件性能计数器（System.Profiler.HardwareCounters 开启时由 ROOT 作用域读取）。
+ */
+enum class HardwareCounter : uint32_t {
+  Instructions,  ///< 退休的指令数
+  Cycles,        ///< CPU 周期数
+  CacheMisses,   ///< 末级缓存 (LLC) 未命中次数
+  BranchMisses,  ///< 分支预测失败次数
+};
+constexpr size_t kHardwareCounterCount = 4;
+/// 一次读取的全部计数器（按 HardwareCounter 下标），只统计用户态
+using HardwareCounterSample = std::array<uint64_t, kHardwareCounterCount>;
+
+/**
+ * @brief 聚合节点的冷数据：数值统计与上下文标签。
+ * * @details
+ * 【面向维护者】
+ * 绝大多数节点是只关心次数与耗时的 Timer，从不打标签也不记录数值。
+ * 这部分字段 (~420 字节) 因此从 AggregatorNode 中拆出，只有 Value
+ * 节点和打过标签的节点才由 Service 按需分配一块（`IProfilerService::AttachColdStats`）。
+ * 冷数据块归 Service 的旁路表所有，挂上后随节点一起在池中复用，直到 Service 析构。
+ */
+struct NodeColdStats {
+  NodeColdStats() { Reset(); }
+  NodeColdStats(const NodeColdStats&) = delete;
+  NodeColdStats& operator=(const NodeColdStats&) = delete;
+
+  std::atomic<uint64_t> sum_value_bits{0}; ///< 数值型节点的累加值
+  std::atomic<uint64_t> max_value_bits{0}; ///< 数值型节点的历史最大值
+  std::atomic<uint64_t> min_value_bits{0}; ///< 数值型节点的历史最小值
+
+  static constexpr size_t kTagValueSlots = 8;  ///< 每个节点可分别计数的类型化标签值个数
+
+  std::array<TagData, 2>
+      tags{};  ///< 绑定的上下文标签数组（硬上限 2 个）
+  std::atomic<size_t> tag_count{0};  ///< 已认领的标签槽位数（可能尚未发布完）
+
+  std::array<TagValueCount, kTagValueSlots> tag_values{};  ///< 类型化标签的按值计数
+  std::atomic<uint32_t> tag_value_count{0};  ///< 已认领的 tag_values 槽位数
+  std::atomic<uint64_t> tag_value_overflow{0};  ///< 槽位用尽后未能单独计数的记录次数
+
+  /// 各作用域累计的硬件计数器增量（按 HardwareCounter 下标）
+  std::array<std::atomic<uint64_t>, kHardwareCounterCount> hw_counters{};
+  std::atomic<uint64_t> hw_samples{0};  ///< 读到了硬件计数器的作用域次数
+
+  /** @brief 恢复到未记录任何数值、未绑定标签的状态。 */
+  void Reset() {
+    double zero = 0.0, max_init = 999999.0, min_init = -999999.0;
+    uint64_t zero_bits, max_init_bits, min_init_bits;
+    std::memcpy(&zero_bits, &zero, sizeof(double));
+    std::memcpy(&max_init_bits, &max_init, sizeof(double));
+    std::memcpy(&min_init_bits, &min_init, sizeof(double));
+
+    sum_value_bits.store(zero_bits, std::memory_order_relaxed);
+    max_value_bits.store(min_init_bits, std::memory_order_relaxed);
+    min_value_bits.store(max_init_bits, std::memory_order_relaxed);
+    for (auto& tag : tags) tag.key.store(nullptr, std::memory_order_relaxed);
+    tag_count.store(0, std::memory_order_relaxed);
+    for (auto& slot : tag_values) {
+      slot.key.store(nullptr, std::memory_order_relaxed);
+      slot.count.store(0, std::memory_order_relaxed);
+    }
+    tag_value_count.store(0, std::memory_order_relaxed);
+    tag_value_overflow.store(0, std::memory_order_relaxed);
+    for (auto& counter : hw_counters) counter.store(0, std::memory_order_relaxed);
+    hw_samples.store(0, std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief 绑定一个字符串标签（最多 2 个，之后的被忽略）。
+   * @details 先 CAS 认领槽位再拷贝 value，最后发布 key：并发打标签的线程不会写到同一个槽位。
+   */
+  void AddTag(const char* key, const char* value) {
+    size_t slot = tag_count.load(std::memory_order_relaxed);
+    do {
+      if (slot >= tags.size()) return;
+    } while (!tag_count.compare_exchange_weak(slot, slot + 1,
+                                              std::memory_order_relaxed));
+    TagData& tag = tags[slot];
+    size_t len = value ? std::strlen(value) : 0;
+    if (len >= sizeof(tag.value)) len = sizeof(tag.value) - 1;
+    if (len) std::memcpy(tag.value, value, len);
+    tag.value[len] = '\0';
+    tag.key.store(key ? key : "", std::memory_order_release);
+  }
+
+  /**
+   * @brief 为类型化标签值累加 n 次计数。已有相同 (key, kind, value) 的槽位时只做一次 fetch_add。
+   * @details 新值先 CAS 认领 tag_value_count 的下标，写入 value / kind / count 后发布 key；
+   * 两个线程同时认领同一个新值时会各占一个槽位，由报告合并。槽位用尽后计入 tag_value_overflow。
+   */
+  void CountTagValue(const char* key, TagValueKind kind, uint64_t value,
+                     uint64_t n = 1) {
+    if (!key) key = "";
+    uint32_t claimed = tag_value_count.load(std::memory_order_acquire);
+    for (;;) {
+      for (uint32_t i = 0; i < claimed && i < kTagValueSlots; ++i) {
+        TagValueCount& slot = tag_values[i];
+        if (slot.key.load(std::memory_order_acquire) == key &&
+            slot.kind == kind && slot.value == value) {
+          slot.count.fetch_add(n, std::memory_order_relaxed);
+          return;
+        }
+      }
+      if (claimed >= kTagValueSlots) {
+        tag_value_overflow.fetch_add(n, std::memory_order_relaxed);
+        return;
+      }
+      if (tag_value_count.compare_exchange_weak(claimed, claimed + 1,
+                                                std::memory_order_acq_rel,
+                                                std::memory_order_acquire)) {
+        TagValueCount& slot = tag_values[claimed];
+        slot.value = value;
+        slot.kind = kind;
+        slot.count.store(n, std::memory_order_relaxed);
+        slot.key.store(key, std::memory_order_release);
+        return;
+      }
+      // 别的线程抢先认领了下标（可能正是同一个值）：重新扫描
+    }
+  }
+};
+
 /**
  * @brief 核心聚合节点结构体（LCRS 多叉树节点）。
  * * @details
@@ -124,6 +464,11 @@ struct TagData {
  * 右兄弟(`next_sibling`)的设计。这不仅打破了子节点数量的硬限制，还大幅压缩了结构体体积。
  * 3. **微型自旋锁**：`lock` 用于在多线程向同一个 AsyncRoot
  * 挂载子节点时，保护树的拓扑结构不被撕裂。
+ * 4. **线程独占子树**：`thread_owned` 为 true 的节点只会被一个线程写入
+ * (分片聚合模式下的影子树)，指标更新退化为普通的 relaxed load/store，
+ * 挂载子节点也不再加锁；子节点在创建时继承父节点的该标志。
+ * 5. **冷热分离**：树遍历只读第一条 Cache Line 的拓扑字段，探针只写第二条的
+ * 次数 / 耗时 / 分配计数；数值统计与标签放在按需分配的 NodeColdStats 中，整个节点 128 字节。
  */
 struct alignas(64) AggregatorNode {
   // === L1 Cache Line 1: 拓扑结构与生命周期 (极少修改) ===
@@ -135,58 +480,145 @@ struct alignas(64) AggregatorNode {
 
   std::atomic_flag lock =
       ATOMIC_FLAG_INIT;  ///< 极轻量级自旋锁，保护当前节点的并发拓扑修改
+  bool thread_owned = false;  ///< 是否属于某个线程独占的影子树（无需原子 RMW）
+  std::atomic<uint32_t> child_epoch{
+      0};  ///< 子链表每被整体摘除一次就 +1，用于判定线程缓存是否过期（永不回退）
+  uint32_t pool_index = 0;  ///< 在 Service 节点池中的编号（从 1 开始），0 表示不归池管理
+  std::atomic<uint32_t> pool_next{0};  ///< [节点池内部] 空闲时指向下一批的批首编号
 
   // === L1 Cache Line 2: 高频并发指标 (完全原子化) ===
   alignas(64) std::atomic<uint64_t> call_count{0};  ///< 累计被调用的次数
-  std::atomic<uint64_t> total_time_ns{0};  ///< 累计耗时纳秒，允许使用原生硬件 fetch_add
+  std::atomic<uint64_t> total_ticks{0};  ///< 累计耗时 (ProfilerClock tick)，允许使用原生硬件 fetch_add
 
-  std::atomic<uint64_t> max_time_ms_bits{0}; ///< 历史单次最大耗时
-  std::atomic<uint64_t> min_time_ms_bits{0}; ///< 历史单次最小耗时
+  std::atomic<uint64_t> max_ticks{0}; ///< 历史单次最大耗时 (tick)
+  std::atomic<uint64_t> min_ticks{std::numeric_limits<uint64_t>::max()}; ///< 历史单次最小耗时 (tick)
 
-  std::atomic<uint64_t> sum_value_bits{0}; ///< 数值型节点的累加值
-  std::atomic<uint64_t> max_value_bits{0}; ///< 数值型节点的历史最大值
-  std::atomic<uint64_t> min_value_bits{0}; ///< 数值型节点的历史最小值
+  /// 数值统计与标签（不持有所有权）。为空表示该节点从未记录数值或标签
+  std::atomic<NodeColdStats*> cold{nullptr};
 
-  std::array<TagData, 2>
-      tags{};  ///< 绑定的上下文标签数组（硬上限 2 个，避免结构体过大）
-  std::atomic<size_t> tag_count{0};  ///< 当前已绑定的标签数量
+  /// 作用域自身（不含子作用域）的堆分配次数 / 字节数（System.Profiler.AllocationTracking）
+  std::atomic<uint64_t> alloc_count{0};
+  std::atomic<uint64_t> alloc_bytes{0};
+
+  /// 分位数直方图（耗时按 tick，数值按 kValueScale 定点化）。由 Service 在分配节点时挂上，可为空
+  std::unique_ptr<LogHistogram> histogram;
+  static constexpr double kValueScale = 1000.0;  ///< 数值型样本入桶前乘以该系数（保留 3 位小数）
+
+  /** @brief 记录一次耗时 (探针热路径：只做整数原子操作，不做浮点换算)。 */
+  void RecordTicks(uint64_t ticks) {
+    if (thread_owned) {
+      // 独占子树：没有并发写者，普通 load/store 即可 (x86 上就是 mov)
+      OwnedAdd(call_count, 1);
+      OwnedAdd(total_ticks, ticks);
+      if (ticks > max_ticks.load(std::memory_order_relaxed))
+        max_ticks.store(ticks, std::memory_order_relaxed);
+      if (ticks < min_ticks.load(std::memory_order_relaxed))
+        min_ticks.store(ticks, std::memory_order_relaxed);
+      if (histogram) histogram->RecordOwned(ticks);
+      return;
+    }
+    call_count.fetch_add(1, std::memory_order_relaxed);
+    total_ticks.fetch_add(ticks, std::memory_order_relaxed);
+    AtomicUpdateMaxU64(max_ticks, ticks);
+    AtomicUpdateMinU64(min_ticks, ticks);
+    if (histogram) histogram->Record(ticks);
+  }
+
+  /** @brief 记录一次堆分配 (分配钩子：只在节点所属线程的影子栈栈顶上调用)。 */
+  void RecordAllocation(uint64_t bytes) {
+    if (thread_owned) {
+      OwnedAdd(alloc_count, 1);
+      OwnedAdd(alloc_bytes, bytes);
+      return;
+    }
+    alloc_count.fetch_add(1, std::memory_order_relaxed);
+    alloc_bytes.fetch_add(bytes, std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief 记录一次数值 (Value / Event 节点)。
+   * @details 数值统计写入冷数据块；未挂冷数据块时只计次数。
+   */
+  void RecordValue(double value) {
+    NodeColdStats* stats = cold.load(std::memory_order_acquire);
+    if (thread_owned) {
+      OwnedAdd(call_count, 1);
+      if (stats) {
+        const double sum = GetSumValue() + value;
+        uint64_t bits;
+        std::memcpy(&bits, &sum, sizeof(double));
+        stats->sum_value_bits.store(bits, std::memory_order_relaxed);
+        if (value > GetMaxValue()) {
+          std::memcpy(&bits, &value, sizeof(double));
+          stats->max_value_bits.store(bits, std::memory_order_relaxed);
+        }
+        if (value < GetMinValue()) {
+          std::memcpy(&bits, &value, sizeof(double));
+          stats->min_value_bits.store(bits, std::memory_order_relaxed);
+        }
+      }
+      if (histogram) histogram->RecordOwned(ScaleValue(value));
+      return;
+    }
+    call_count.fetch_add(1, std::memory_order_relaxed);
+    if (stats) {
+      // 使用 CAS 原语进行无锁浮点数累加和极值更新
+      AtomicAddDouble(stats->sum_value_bits, value);
+      AtomicUpdateMax(stats->max_value_bits, value);
+      AtomicUpdateMin(stats->min_value_bits, value);
+    }
+    if (histogram) histogram->Record(ScaleValue(value));
+  }
+
+  /** @brief 耗时分位数（毫秒）。未挂直方图时返回 0。 */
+  double GetPercentileMs(double q) const {
+    return histogram ? ProfilerClock::TicksToMs(histogram->Percentile(q)) : 0.0;
+  }
+
+  /** @brief 数值分位数（负数样本计为 0）。未挂直方图时返回 0。 */
+  double GetValuePercentile(double q) const {
+    return histogram ? histogram->Percentile(q) / kValueScale : 0.0;
+  }
 
-  // [新增] 供业务层安全读取的接口
+  // [新增] 供业务层安全读取的接口 (报告路径：tick 在这里才换算为毫秒)
   double GetTotalTimeMs() const {
-    return total_time_ns.load(std::memory_order_relaxed) / 1000000.0;
+    return ProfilerClock::TicksToMs(total_ticks.load(std::memory_order_relaxed));
   }
 
   double GetMaxTimeMs() const {
-    double val;
-    uint64_t bits = max_time_ms_bits.load(std::memory_order_relaxed);
-    std::memcpy(&val, &bits, sizeof(double));
-    return val;
+    return ProfilerClock::TicksToMs(max_ticks.load(std::memory_order_relaxed));
   }
 
   double GetMinTimeMs() const {
-    double val;
-    uint64_t bits = min_time_ms_bits.load(std::memory_order_relaxed);
-    std::memcpy(&val, &bits, sizeof(double));
-    return val;
+    const uint64_t ticks = min_ticks.load(std::memory_order_relaxed);
+    return ticks == std::numeric_limits<uint64_t>::max()
+               ? 0.0
+               : ProfilerClock::TicksToMs(ticks);
   }
 
   double GetSumValue() const {
+    const NodeColdStats* stats = cold.load(std::memory_order_acquire);
+    if (!stats) return 0.0;
     double val;
-    uint64_t bits = sum_value_bits.load(std::memory_order_relaxed);
+    uint64_t bits = stats->sum_value_bits.load(std::memory_order_relaxed);
     std::memcpy(&val, &bits, sizeof(double));
     return val;
   }
 
   double GetMaxValue() const {
+    const NodeColdStats* stats = cold.load(std::memory_order_acquire);
+    if (!stats) return 0.0;
     double val;
-    uint64_t bits = max_value_bits.load(std::memory_order_relaxed);
+    uint64_t bits = stats->max_value_bits.load(std::memory_order_relaxed);
     std::memcpy(&val, &bits, sizeof(double));
     return val;
   }
 
   double GetMinValue() const {
+    const NodeColdStats* stats = cold.load(std::memory_order_acquire);
+    if (!stats) return 0.0;
     double val;
-    uint64_t bits = min_value_bits.load(std::memory_order_relaxed);
+    uint64_t bits = stats->min_value_bits.load(std::memory_order_relaxed);
     std::memcpy(&val, &bits, sizeof(double));
     return val;
   }
@@ -201,20 +633,83 @@ struct alignas(64) AggregatorNode {
    */
   void Reset() {
     call_count.store(0, std::memory_order_relaxed);
-    total_time_ns.store(0, std::memory_order_relaxed);
+    total_ticks.store(0, std::memory_order_relaxed);
+    max_ticks.store(0, std::memory_order_relaxed);
+    min_ticks.store(std::numeric_limits<uint64_t>::max(), std::memory_order_relaxed);
+    alloc_count.store(0, std::memory_order_relaxed);
+    alloc_bytes.store(0, std::memory_order_relaxed);
+    if (NodeColdStats* stats = cold.load(std::memory_order_relaxed)) stats->Reset();
+    if (histogram) histogram->Reset();
+  }
 
-    double zero = 0.0, max_init = 999999.0, min_init = -999999.0;
-    uint64_t zero_bits, max_init_bits, min_init_bits;
-    std::memcpy(&zero_bits, &zero, sizeof(double));
-    std::memcpy(&max_init_bits, &max_init, sizeof(double));
-    std::memcpy(&min_init_bits, &min_init, sizeof(double));
+ private:
+  static uint64_t ScaleValue(double value) {
+    const double scaled = value * kValueScale;
+    if (!(scaled > 0.0)) return 0;
+    if (scaled >= 1.8e19) return std::numeric_limits<uint64_t>::max();
+    return static_cast<uint64_t>(scaled);
+  }
 
-    max_time_ms_bits.store(zero_bits, std::memory_order_relaxed);
-    min_time_ms_bits.store(max_init_bits, std::memory_order_relaxed);
-    sum_value_bits.store(zero_bits, std::memory_order_relaxed);
-    max_value_bits.store(min_init_bits, std::memory_order_relaxed);
-    min_value_bits.store(max_init_bits, std::memory_order_relaxed);
-    tag_count.store(0, std::memory_order_relaxed);
+  static void OwnedAdd(std::atomic<uint64_t>& target, uint64_t delta) {
+    target.store(target.load(std::memory_order_relaxed) + delta,
+                 std::memory_order_relaxed);
+  }
+};
+static_assert(sizeof(AggregatorNode) == 128,
+              "AggregatorNode should stay two cache lines (topology + hot counters)");
+
+/**
+ * @brief 设备时间戳来源：把 CUDA event、OpenCL profiling event 等适配给 Profiler。
+ * @details
+ * 【面向使用者】
+ * Profiler 不链接任何设备运行时，由业务为每条设备队列（CUDA stream / OpenCL command queue）
+ * 实现一个适配器，交给 Z3Y_PROFILE_DEVICE。`Mark` 在提交线程上调用，`Query` / `Release`
+ * 在 Profiler 的设备轮询线程上调用，实现需要允许这两个线程同时访问。
+ * 设备时钟的原点任意，Profiler 只用同一来源两个标记之差，并自行估计它与主机时钟的偏移。
+ */
+class IDeviceTimestampSource {
+ public:
+  virtual ~IDeviceTimestampSource() = default;
+  /** @brief 设备轨道名（如 "cuda:0/stream1"），同名的来源汇总在一起。 */
+  virtual const char* DeviceName() const = 0;
+  /** @brief 在队列当前位置插入一个时间戳标记（不阻塞），返回标记句柄，0 表示失败。 */
+  virtual uint64_t Mark() = 0;
+  /** @brief 非阻塞查询：标记已在设备上执行时写出它的设备时刻（纳秒）并返回 true。 */
+  virtual bool Query(uint64_t marker, uint64_t* device_ns) = 0;
+  /** @brief 释放标记。每个成功的 Mark 恰好对应一次 Release（解析完成或放弃之后）。 */
+  virtual void Release(uint64_t marker) = 0;
+};
+
+/**
+ * @brief 飞行记录器的一个线程环（System.Profiler.FlightRecorderRingSize > 0 时由服务分配）。
+ * @details
+ * 【面向维护者】
+ * 只有所属线程写入，写满后覆盖最旧的记录。每条 16 字节：ProfilerClock 时刻 + 探针指针
+ * （最低位 1 表示进入作用域）。写入方不加锁、没有原子读改写，x86 上只是几次普通 store。
+ * 冻结时其它线程并发读取：先读 published 取得已写完的区间，拷贝后再读 claimed，
+ * 序号不大于 claimed - 容量 的槽位可能在拷贝期间被覆盖，一律丢弃（环形的 seqlock）。
+ */
+struct FlightRing {
+  struct Record {
+    std::atomic<uint64_t> ticks{0};
+    std::atomic<uintptr_t> word{0};  ///< ProfileNodeData 指针 | 进入标志
+  };
+
+  Record* records = nullptr;
+  uint64_t mask = 0;                   ///< 容量 - 1（容量为 2 的幂）
+  std::atomic<uint64_t> claimed{0};    ///< 已开始写入的条数
+  std::atomic<uint64_t> published{0};  ///< 已写完的条数
+
+  void Push(const ProfileNodeData* data, bool begin, uint64_t ticks) noexcept {
+    const uint64_t index = published.load(std::memory_order_relaxed);
+    claimed.store(index + 1, std::memory_order_relaxed);
+    // 读者读到下面写入的新值时，必然也能看到 claimed 已前移
+    std::atomic_thread_fence(std::memory_order_release);
+    Record& record = records[index & mask];
+    record.ticks.store(ticks, std::memory_order_relaxed);
+    record.word.store(reinterpret_cast<uintptr_t>(data) | (begin ? 1u : 0u),
+                      std::memory_order_relaxed);
+    published.store(index + 1, std::memory_order_release);
   }
 };
 
@@ -228,16 +723,61 @@ struct alignas(64) AggregatorNode {
  * 完全无锁化是实现零开销记录的核心保障。
  */
 struct ProfilerThreadState {
-  AggregatorNode*
-      shadow_stack[128]{};  ///< 影子栈，记录当前函数调用的嵌套层级（硬上限
-                            ///< 128 层深）
-  size_t stack_depth = 0;   ///< 当前影子栈的深度
+  /**
+   * @brief 子节点查找缓存的一个槽位：(parent, data) -> child。
+   * @details 只有 `parent->child_epoch` 仍等于 `epoch` 时命中才有效：
+   * 父节点的子链表一旦被摘除回收，epoch 就会变化，缓存自动失效。
+   */
+  struct ChildCacheEntry {
+    AggregatorNode* parent = nullptr;
+    const ProfileNodeData* data = nullptr;
+    AggregatorNode* child = nullptr;
+    uint32_t epoch = 0;
+  };
+  static constexpr size_t kChildCacheSize = 64;  ///< 直接映射，必须是 2 的幂
+  /// 内联影子栈深度；更深的调用由服务在堆上扩容（见 GrowShadowStack）
+  static constexpr size_t kInlineStackDepth = 16;
+  /// 影子栈深度硬上限；超出的层级不再记录，并计入报告的 depth_overflows
+  static constexpr size_t kMaxStackDepth = 1024;
+  static constexpr size_t kInlineThreadRoots = 4;  ///< 内联独立根节点数
+
+  ProfilerThreadState() = default;
+  ProfilerThreadState(const ProfilerThreadState&) = delete;
+  ProfilerThreadState& operator=(const ProfilerThreadState&) = delete;
+
+  /// 影子栈，记录当前函数调用的嵌套层级。初始指向 inline_stack，扩容后指向堆
+  AggregatorNode** shadow_stack = inline_stack;
+  size_t stack_depth = 0;                        ///< 当前影子栈的深度
+  size_t stack_capacity = kInlineStackDepth;     ///< 影子栈当前容量
   AggregatorNode* current_root =
       nullptr;  ///< 当前线程所属的根节点（如关联的 Async Slot 根节点）
 
-  AggregatorNode* thread_roots[64]{};  ///< 当前线程持有的独立根节点集合（用于
-                                       ///< Z3Y_PROFILE_ROOT）
-  size_t thread_root_count = 0;        ///< 当前线程独立根节点的数量
+  /// 当前线程持有的独立根节点集合（用于 Z3Y_PROFILE_ROOT），扩容规则同影子栈
+  AggregatorNode** thread_roots = inline_roots;
+  size_t thread_root_count = 0;                    ///< 当前线程独立根节点的数量
+  size_t thread_root_capacity = kInlineThreadRoots;  ///< 独立根节点集合当前容量
+
+  ChildCacheEntry child_cache[kChildCacheSize]{};  ///< 子节点查找缓存（无锁命中）
+
+  /// 服务的探针启用位图（每个已登记探针一位，只读）
+  const std::atomic<uint64_t>* probe_bits = nullptr;
+  uint32_t probe_tag = 0;  ///< 服务注册表标签，与探针 probe_key 的高 32 位比较
+
+  /// 飞行记录器的当前会话号（服务所有，只读；0 表示关闭）
+  const std::atomic<uint64_t>* flight_session = nullptr;
+  FlightRing* flight_ring = nullptr;  ///< 本线程在 flight_ring_session 下的环（可能为空）
+  uint64_t flight_ring_session = 0;   ///< flight_ring 所属的会话号
+
+  AggregatorNode* inline_stack[kInlineStackDepth]{};  ///< 影子栈的内联存储
+  AggregatorNode* inline_roots[kInlineThreadRoots]{};  ///< 独立根节点的内联存储
+
+  /** @brief 计算 (parent, data) 在查找缓存中的槽位。 */
+  static size_t ChildCacheSlot(const AggregatorNode* parent,
+                               const ProfileNodeData* data) {
+    const auto key = (reinterpret_cast<uintptr_t>(parent) >> 6) ^
+                     (reinterpret_cast<uintptr_t>(data) >> 3);
+    return key & (kChildCacheSize - 1);
+  }
 };
 
 }  // namespace z3y::interfaces::profiler
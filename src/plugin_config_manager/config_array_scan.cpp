@@ -0,0 +1,191 @@
+﻿/**
+ * @file config_array_scan.cpp
+ * @brief 数值数组区间扫描的实现：按块向量化归约，越界时在块内标量定位。
+ */
+#include "config_array_scan.h"
+
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define Z3Y_CONFIG_SCAN_X64 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define Z3Y_TARGET_AVX2
+#else
+#define Z3Y_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define Z3Y_CONFIG_SCAN_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace z3y {
+namespace plugins {
+namespace config {
+namespace {
+
+// 每块归约一次即判定；块越小越早停止，越大分支越少
+constexpr size_t kScanBlock = 1024;
+
+size_t ScanInt64Scalar(const int64_t* p, size_t begin, size_t end, int64_t lo, int64_t hi) {
+  for (size_t i = begin; i < end; ++i) {
+    if (p[i] < lo || p[i] > hi) return i;
+  }
+  return end;
+}
+
+size_t ScanDoubleScalar(const double* p, size_t begin, size_t end, double lo, double hi) {
+  for (size_t i = begin; i < end; ++i) {
+    if (!(p[i] >= lo && p[i] <= hi)) return i;  // NaN 两个比较都不成立
+  }
+  return end;
+}
+
+bool Int64BlockScalar(const int64_t* p, size_t n, int64_t lo, int64_t hi) {
+  bool bad = false;  // 无早退的归约，便于编译器自动向量化
+  for (size_t i = 0; i < n; ++i) bad |= (p[i] < lo) | (p[i] > hi);
+  return !bad;
+}
+
+bool DoubleBlockScalar(const double* p, size_t n, double lo, double hi) {
+  return ScanDoubleScalar(p, 0, n, lo, hi) == n;
+}
+
+#if defined(Z3Y_CONFIG_SCAN_X64)
+
+bool CpuHasAvx2() {
+#if defined(_MSC_VER) && !defined(__clang__)
+  int regs[4];
+  __cpuid(regs, 0);
+  if (regs[0] < 7) return false;
+  __cpuid(regs, 1);
+  const bool osxsave = (regs[2] & (1 << 27)) != 0;
+  const bool avx = (regs[2] & (1 << 28)) != 0;
+  if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) return false;  // 系统须保存 YMM 状态
+  __cpuidex(regs, 7, 0);
+  return (regs[1] & (1 << 5)) != 0;
+#else
+  return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+
+Z3Y_TARGET_AVX2 bool Int64BlockAvx2(const int64_t* p, size_t n, int64_t lo, int64_t hi) {
+  const __m256i vlo = _mm256_set1_epi64x(lo);
+  const __m256i vhi = _mm256_set1_epi64x(hi);
+  __m256i bad = _mm256_setzero_si256();
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+    bad = _mm256_or_si256(bad, _mm256_or_si256(_mm256_cmpgt_epi64(vlo, x),
+                                               _mm256_cmpgt_epi64(x, vhi)));
+  }
+  if (!_mm256_testz_si256(bad, bad)) return false;
+  return ScanInt64Scalar(p, i, n, lo, hi) == n;
+}
+
+Z3Y_TARGET_AVX2 bool DoubleBlockAvx2(const double* p, size_t n, double lo, double hi) {
+  const __m256d vlo = _mm256_set1_pd(lo);
+  const __m256d vhi = _mm256_set1_pd(hi);
+  __m256d ok = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    const __m256d x = _mm256_loadu_pd(p + i);
+    // 有序比较：NaN 得 0
+    ok = _mm256_and_pd(ok, _mm256_and_pd(_mm256_cmp_pd(x, vlo, _CMP_GE_OQ),
+                                         _mm256_cmp_pd(x, vhi, _CMP_LE_OQ)));
+  }
+  if (_mm256_movemask_pd(ok) != 0xF) return false;
+  return ScanDoubleScalar(p, i, n, lo, hi) == n;
+}
+
+bool DoubleBlockSse2(const double* p, size_t n, double lo, double hi) {
+  const __m128d vlo = _mm_set1_pd(lo);
+  const __m128d vhi = _mm_set1_pd(hi);
+  __m128d ok = _mm_castsi128_pd(_mm_set1_epi32(-1));
+  size_t i = 0;
+  for (; i + 2 <= n; i += 2) {
+    const __m128d x = _mm_loadu_pd(p + i);
+    ok = _mm_and_pd(ok, _mm_and_pd(_mm_cmpge_pd(x, vlo), _mm_cmple_pd(x, vhi)));
+  }
+  if (_mm_movemask_pd(ok) != 0x3) return false;
+  return ScanDoubleScalar(p, i, n, lo, hi) == n;
+}
+
+#elif defined(Z3Y_CONFIG_SCAN_NEON)
+
+bool Int64BlockNeon(const int64_t* p, size_t n, int64_t lo, int64_t hi) {
+  const int64x2_t vlo = vdupq_n_s64(lo);
+  const int64x2_t vhi = vdupq_n_s64(hi);
+  uint64x2_t bad = vdupq_n_u64(0);
+  size_t i = 0;
+  for (; i + 2 <= n; i += 2) {
+    const int64x2_t x = vld1q_s64(p + i);
+    bad = vorrq_u64(bad, vorrq_u64(vcltq_s64(x, vlo), vcgtq_s64(x, vhi)));
+  }
+  if (vmaxvq_u32(vreinterpretq_u32_u64(bad)) != 0) return false;
+  return ScanInt64Scalar(p, i, n, lo, hi) == n;
+}
+
+bool DoubleBlockNeon(const double* p, size_t n, double lo, double hi) {
+  const float64x2_t vlo = vdupq_n_f64(lo);
+  const float64x2_t vhi = vdupq_n_f64(hi);
+  uint64x2_t ok = vdupq_n_u64(~uint64_t{0});
+  size_t i = 0;
+  for (; i + 2 <= n; i += 2) {
+    const float64x2_t x = vld1q_f64(p + i);
+    ok = vandq_u64(ok, vandq_u64(vcgeq_f64(x, vlo), vcleq_f64(x, vhi)));
+  }
+  if (vminvq_u32(vreinterpretq_u32_u64(ok)) != 0xFFFFFFFFu) return false;
+  return ScanDoubleScalar(p, i, n, lo, hi) == n;
+}
+
+#endif
+
+using Int64BlockFn = bool (*)(const int64_t*, size_t, int64_t, int64_t);
+using DoubleBlockFn = bool (*)(const double*, size_t, double, double);
+
+Int64BlockFn SelectInt64Block() {
+#if defined(Z3Y_CONFIG_SCAN_X64)
+  return CpuHasAvx2() ? &Int64BlockAvx2 : &Int64BlockScalar;  // SSE2 无 64 位整数比较
+#elif defined(Z3Y_CONFIG_SCAN_NEON)
+  return &Int64BlockNeon;
+#else
+  return &Int64BlockScalar;
+#endif
+}
+
+DoubleBlockFn SelectDoubleBlock() {
+#if defined(Z3Y_CONFIG_SCAN_X64)
+  return CpuHasAvx2() ? &DoubleBlockAvx2 : &DoubleBlockSse2;
+#elif defined(Z3Y_CONFIG_SCAN_NEON)
+  return &DoubleBlockNeon;
+#else
+  return &DoubleBlockScalar;
+#endif
+}
+
+template <typename T, typename BlockFn, typename ScanFn>
+size_t FindOutOfRange(const T* data, size_t n, T lo, T hi, BlockFn block, ScanFn scan) {
+  for (size_t begin = 0; begin < n; begin += kScanBlock) {
+    const size_t end = begin + std::min(kScanBlock, n - begin);
+    if (!block(data + begin, end - begin, lo, hi)) return scan(data, begin, end, lo, hi);
+  }
+  return n;
+}
+
+}  // namespace
+
+size_t FindInt64OutOfRange(const int64_t* data, size_t n, int64_t lo, int64_t hi) {
+  static const Int64BlockFn block = SelectInt64Block();
+  return FindOutOfRange(data, n, lo, hi, block, &ScanInt64Scalar);
+}
+
+size_t FindDoubleOutOfRange(const double* data, size_t n, double lo, double hi) {
+  static const DoubleBlockFn block = SelectDoubleBlock();
+  return FindOutOfRange(data, n, lo, hi, block, &ScanDoubleScalar);
+}
+
+}  // namespace config
+}  // namespace plugins
+}  // namespace z3y
@@ -0,0 +1,35 @@
+﻿/**
+ * @file config_array_scan.h
+ * @brief 数值数组参数的向量化区间扫描 (ConfigSchemaCheck 使用)。
+ * * @details
+ * 大数组 (波形、标定表) 整段写入时逐元素比较是校验的主要开销。这里按块做向量化归约：
+ * - x86-64：运行期检测到 AVX2 时走 256 位路径；否则浮点走 SSE2 (x86-64 基线)，整型走标量。
+ * - AArch64：NEON。其余平台：标量。
+ * 块内归约只回答"是否全部在范围内"；出现越界时才在该块内标量定位第一个下标，
+ * 因此报错信息与逐元素比较完全一致。
+ */
+#pragma once
+#ifndef Z3Y_CONFIG_ARRAY_SCAN_H_
+#define Z3Y_CONFIG_ARRAY_SCAN_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace z3y {
+namespace plugins {
+namespace config {
+
+/** @return 第一个不在 [lo, hi] 内的下标；全部在范围内时返回 n。 */
+size_t FindInt64OutOfRange(const int64_t* data, size_t n, int64_t lo, int64_t hi);
+
+/**
+ * @return 第一个不在 [lo, hi] 内的下标；全部在范围内时返回 n。
+ * NaN 与任何区间都不满足，总被视为越界；lo / hi 取有限值时 ±Inf 同样越界。
+ */
+size_t FindDoubleOutOfRange(const double* data, size_t n, double lo, double hi);
+
+}  // namespace config
+}  // namespace plugins
+}  // namespace z3y
+
+#endif  // Z3Y_CONFIG_ARRAY_SCAN_H_
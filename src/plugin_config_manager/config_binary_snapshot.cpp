@@ -0,0 +1,377 @@
+﻿/**
+ * @file config_binary_snapshot.cpp
+ * @brief ConfigBinarySnapshot 的读写实现。
+ */
+
+#include "config_binary_snapshot.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+
+namespace z3y {
+namespace plugins {
+namespace config {
+
+namespace {
+
+constexpr char kMagic[8] = {'Z', '3', 'Y', 'C', 'F', 'G', 'B', '\0'};
+constexpr uint32_t kVersion = 1;
+
+enum class ValueType : uint8_t {
+  kInt = 1,
+  kDouble,
+  kBool,
+  kString,
+  kIntArray,
+  kDoubleArray,
+  kStringArray,
+  kEmptyArray,  ///< 空数组可读作任意数组类型
+  kRawJson,     ///< ConfigValue 无法表达的 JSON，仅用于原样写回
+};
+
+size_t AlignUp(size_t value) { return (value + 7) & ~size_t{7}; }
+
+/** @brief 能无损存为 int64 的 JSON 整数 (超出范围的无符号数按原样 JSON 保存)。 */
+bool IsInt64(const nlohmann::json& value) {
+  return value.is_number_integer() &&
+         (!value.is_number_unsigned() ||
+          value.get<uint64_t>() <=
+              static_cast<uint64_t>(std::numeric_limits<int64_t>::max()));
+}
+
+template <typename T>
+void Append(std::string& out, const T& value) {
+  out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+}  // namespace
+
+struct ConfigBinarySnapshot::Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t entry_count;
+  uint64_t json_size;
+  uint64_t json_hash;
+  uint64_t index_offset;
+  uint64_t strings_offset;
+  uint64_t data_offset;
+  uint64_t file_size;
+};
+
+uint64_t ConfigBinarySnapshot::Hash(std::string_view bytes, uint64_t seed) {
+  static_assert(sizeof(Header) == 64, "binary layout");
+  static_assert(sizeof(IndexEntry) == 24, "binary layout");
+  uint64_t hash = seed;
+  for (unsigned char c : bytes) {
+    hash ^= c;
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+void ConfigBinarySnapshot::Builder::Add(const std::string& key,
+                                        const nlohmann::json& value) {
+  auto add_string = [this](std::string_view text) {
+    const auto offset = static_cast<uint32_t>(strings_.size());
+    strings_.append(text.data(), text.size());
+    return offset;
+  };
+
+  IndexEntry entry{};
+  entry.key_offset = add_string(key);
+  entry.key_length = static_cast<uint32_t>(key.size());
+  ValueType type = ValueType::kRawJson;
+
+  if (IsInt64(value)) {
+    type = ValueType::kInt;
+    const int64_t v = value.get<int64_t>();
+    std::memcpy(&entry.value, &v, sizeof(v));
+  } else if (value.is_number_float()) {
+    type = ValueType::kDouble;
+    const double v = value.get<double>();
+    std::memcpy(&entry.value, &v, sizeof(v));
+  } else if (value.is_boolean()) {
+    type = ValueType::kBool;
+    entry.value = value.get<bool>() ? 1 : 0;
+  } else if (value.is_string()) {
+    type = ValueType::kString;
+    const auto& text = value.get_ref<const std::string&>();
+    entry.value = add_string(text);
+    entry.count = static_cast<uint32_t>(text.size());
+  } else if (value.is_array()) {
+    const bool all_int = std::all_of(value.begin(), value.end(), IsInt64);
+    const bool all_number = std::all_of(value.begin(), value.end(),
+                                        [](const auto& v) { return v.is_number(); });
+    const bool all_string = std::all_of(value.begin(), value.end(),
+                                        [](const auto& v) { return v.is_string(); });
+    entry.count = static_cast<uint32_t>(value.size());
+    if (value.empty()) {
+      type = ValueType::kEmptyArray;
+    } else if (all_int || all_number) {
+      type = all_int ? ValueType::kIntArray : ValueType::kDoubleArray;
+      data_.resize(AlignUp(data_.size()), '\0');
+      entry.value = data_.size();
+      for (const auto& v : value) {
+        if (all_int) {
+          Append(data_, v.get<int64_t>());
+        } else {
+          Append(data_, v.get<double>());
+        }
+      }
+    } else if (all_string) {
+      type = ValueType::kStringArray;
+      data_.resize(AlignUp(data_.size()), '\0');
+      entry.value = data_.size();
+      for (const auto& v : value) {
+        const auto& text = v.get_ref<const std::string&>();
+        Append(data_, add_string(text));
+        Append(data_, static_cast<uint32_t>(text.size()));
+      }
+    }
+  }
+  if (type == ValueType::kRawJson) {
+    const std::string text = value.dump();
+    entry.value = add_string(text);
+    entry.count = static_cast<uint32_t>(text.size());
+  }
+  entry.type = static_cast<uint8_t>(type);
+  index_.push_back(entry);
+}
+
+bool ConfigBinarySnapshot::Builder::Write(const std::string& path,
+                                          uint64_t json_size, uint64_t json_hash) {
+  // Find 按键名二分查找；与 nlohmann::json 对象的顺序相同 (字节序)
+  std::sort(index_.begin(), index_.end(), [this](const IndexEntry& a, const IndexEntry& b) {
+    return std::string_view(strings_.data() + a.key_offset, a.key_length) <
+           std::string_view(strings_.data() + b.key_offset, b.key_length);
+  });
+
+  Header header{};
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.entry_count = static_cast<uint32_t>(index_.size());
+  header.json_size = json_size;
+  header.json_hash = json_hash;
+  header.index_offset = sizeof(Header);
+  header.strings_offset = header.index_offset + index_.size() * sizeof(IndexEntry);
+  header.data_offset = AlignUp(header.strings_offset + strings_.size());
+  header.file_size = header.data_offset + data_.size();
+
+  const std::string tmp_path = path + ".tmp";
+  {
+    std::ofstream ofs(tmp_path, std::ios::binary | std::ios::trunc);
+    if (!ofs.is_open()) return false;
+    ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    ofs.write(reinterpret_cast<const char*>(index_.data()),
+              static_cast<std::streamsize>(index_.size() * sizeof(IndexEntry)));
+    ofs.write(strings_.data(), static_cast<std::streamsize>(strings_.size()));
+    const std::string padding(header.data_offset - header.strings_offset - strings_.size(), '\0');
+    ofs.write(padding.data(), static_cast<std::streamsize>(padding.size()));
+    ofs.write(data_.data(), static_cast<std::streamsize>(data_.size()));
+    if (!ofs) return false;
+  }
+  std::error_code ec;
+  std::filesystem::rename(tmp_path, path, ec);
+  return !ec;
+}
+
+bool ConfigBinarySnapshot::Load(const std::string& path,
+                                const std::string& json_path) {
+  bytes_.clear();
+  std::ifstream ifs(path, std::ios::binary | std::ios::ate);
+  if (!ifs.is_open()) return false;
+  const auto size = static_cast<size_t>(ifs.tellg());
+  if (size < sizeof(Header)) return false;
+  std::vector<char> bytes(size);
+  ifs.seekg(0);
+  if (!ifs.read(bytes.data(), static_cast<std::streamsize>(size))) return false;
+
+  Header h;
+  std::memcpy(&h, bytes.data(), sizeof(h));
+  const bool valid =
+      std::memcmp(h.magic, kMagic, sizeof(kMagic)) == 0 && h.version == kVersion &&
+      h.file_size == size && h.index_offset == sizeof(Header) &&
+      h.strings_offset == h.index_offset + uint64_t{h.entry_count} * sizeof(IndexEntry) &&
+      h.strings_offset <= h.data_offset && h.data_offset <= size;
+  // 先比长度，长度一致才分块计算哈希
+  std::error_code ec;
+  const uintmax_t json_size = std::filesystem::file_size(json_path, ec);
+  if (!valid || ec || h.json_size != json_size) return false;
+  std::ifstream json(json_path, std::ios::binary);
+  std::vector<char> chunk(64 * 1024);
+  uint64_t hash = kHashSeed;
+  while (json.read(chunk.data(), static_cast<std::streamsize>(chunk.size())) || json.gcount() > 0) {
+    hash = Hash(std::string_view(chunk.data(), static_cast<size_t>(json.gcount())), hash);
+  }
+  if (h.json_hash != hash) return false;
+  bytes_ = std::move(bytes);
+  return true;
+}
+
+const ConfigBinarySnapshot::Header& ConfigBinarySnapshot::header() const {
+  return *reinterpret_cast<const Header*>(bytes_.data());
+}
+
+size_t ConfigBinarySnapshot::Size() const {
+  return IsLoaded() ? header().entry_count : 0;
+}
+
+const ConfigBinarySnapshot::IndexEntry* ConfigBinarySnapshot::index() const {
+  return reinterpret_cast<const IndexEntry*>(bytes_.data() + header().index_offset);
+}
+
+std::string_view ConfigBinarySnapshot::StringAt(uint32_t offset,
+                                                uint32_t length) const {
+  const uint64_t begin = header().strings_offset + offset;
+  if (begin + length > header().data_offset) return {};
+  return std::string_view(bytes_.data() + begin, length);
+}
+
+bool ConfigBinarySnapshot::Find(std::string_view key,
+                                const ConfigValue& reference,
+                                ConfigValue& out) const {
+  if (!IsLoaded()) return false;
+  const IndexEntry* begin = index();
+  const IndexEntry* end = begin + header().entry_count;
+  const IndexEntry* it = std::lower_bound(
+      begin, end, key, [this](const IndexEntry& e, std::string_view k) {
+        return StringAt(e.key_offset, e.key_length) < k;
+      });
+  if (it == end || StringAt(it->key_offset, it->key_length) != key) return false;
+
+  const auto type = static_cast<ValueType>(it->type);
+  const char* data = bytes_.data() + header().data_offset;
+  const uint64_t data_size = header().file_size - header().data_offset;
+  auto scalar = [it](auto tag) {
+    decltype(tag) v;
+    std::memcpy(&v, &it->value, sizeof(v));
+    return v;
+  };
+  auto numbers = [&](auto tag) {
+    using Element = decltype(tag);
+    std::vector<Element> result;
+    if (it->value + uint64_t{it->count} * 8 > data_size) return result;
+    result.reserve(it->count);
+    for (uint32_t i = 0; i < it->count; ++i) {
+      if (type == ValueType::kIntArray) {
+        int64_t v;
+        std::memcpy(&v, data + it->value + i * 8, sizeof(v));
+        result.push_back(static_cast<Element>(v));
+      } else {
+        double v;
+        std::memcpy(&v, data + it->value + i * 8, sizeof(v));
+        result.push_back(static_cast<Element>(v));
+      }
+    }
+    return result;
+  };
+
+  // 类型兼容规则与 JsonToConfigValue (nlohmann::json::get) 保持一致
+  if (std::holds_alternative<int64_t>(reference) ||
+      std::holds_alternative<double>(reference)) {
+    const bool want_int = std::holds_alternative<int64_t>(reference);
+    if (type == ValueType::kInt) {
+      const int64_t v = scalar(int64_t{});
+      out = want_int ? ConfigValue(v) : ConfigValue(static_cast<double>(v));
+      return true;
+    }
+    if (type == ValueType::kDouble) {
+      const double v = scalar(double{});
+      out = want_int ? ConfigValue(static_cast<int64_t>(v)) : ConfigValue(v);
+      return true;
+    }
+    return false;
+  }
+  if (std::holds_alternative<bool>(reference)) {
+    if (type != ValueType::kBool) return false;
+    out = it->value != 0;
+    return true;
+  }
+  if (std::holds_alternative<std::string>(reference)) {
+    if (type != ValueType::kString) return false;
+    out = std::string(StringAt(static_cast<uint32_t>(it->value), it->count));
+    return true;
+  }
+  const bool numeric_array =
+      type == ValueType::kIntArray || type == ValueType::kDoubleArray;
+  if (std::holds_alternative<std::vector<int64_t>>(reference)) {
+    if (type == ValueType::kEmptyArray) { out = std::vector<int64_t>{}; return true; }
+    if (!numeric_array) return false;
+    out = numbers(int64_t{});
+    return true;
+  }
+  if (std::holds_alternative<std::vector<double>>(reference)) {
+    if (type == ValueType::kEmptyArray) { out = std::vector<double>{}; return true; }
+    if (!numeric_array) return false;
+    out = numbers(double{});
+    return true;
+  }
+  if (std::holds_alternative<std::vector<std::string>>(reference)) {
+    if (type == ValueType::kEmptyArray) { out = std::vector<std::string>{}; return true; }
+    if (type != ValueType::kStringArray ||
+        it->value + uint64_t{it->count} * 8 > data_size) {
+      return false;
+    }
+    std::vector<std::string> result;
+    result.reserve(it->count);
+    for (uint32_t i = 0; i < it->count; ++i) {
+      uint32_t offset, length;
+      std::memcpy(&offset, data + it->value + i * 8, sizeof(offset));
+      std::memcpy(&length, data + it->value + i * 8 + 4, sizeof(length));
+      result.emplace_back(StringAt(offset, length));
+    }
+    out = std::move(result);
+    return true;
+  }
+  return false;
+}
+
+nlohmann::json ConfigBinarySnapshot::ToJson(const IndexEntry& entry) const {
+  const auto type = static_cast<ValueType>(entry.type);
+  ConfigValue reference;
+  switch (type) {
+    case ValueType::kInt: reference = int64_t{}; break;
+    case ValueType::kDouble: reference = double{}; break;
+    case ValueType::kBool: reference = bool{}; break;
+    case ValueType::kString: reference = std::string{}; break;
+    case ValueType::kIntArray: reference = std::vector<int64_t>{}; break;
+    case ValueType::kDoubleArray: reference = std::vector<double>{}; break;
+    case ValueType::kStringArray: reference = std::vector<std::string>{}; break;
+    case ValueType::kEmptyArray: return nlohmann::json::array();
+    case ValueType::kRawJson:
+    default:
+      return nlohmann::json::parse(
+          StringAt(static_cast<uint32_t>(entry.value), entry.count), nullptr, false);
+  }
+  ConfigValue value;
+  if (!Find(StringAt(entry.key_offset, entry.key_length), reference, value)) {
+    return nullptr;
+  }
+  return std::visit(
+      [](auto&& arg) -> nlohmann::json {
+        using T = std::decay_t<decltype(arg)>;
+        if constexpr (std::is_same_v<T, std::monostate>) {
+          return nullptr;
+        } else {
+          return arg;
+        }
+      },
+      value);
+}
+
+void ConfigBinarySnapshot::ForEach(
+    const std::function<void(const std::string&, nlohmann::json)>& fn) const {
+  if (!IsLoaded()) return;
+  const IndexEntry* entries = index();
+  for (uint32_t i = 0; i < header().entry_count; ++i) {
+    fn(std::string(StringAt(entries[i].key_offset, entries[i].key_length)),
+       ToJson(entries[i]));
+  }
+}
+
+}  // namespace config
+}  // namespace plugins
+}  // namespace z3y
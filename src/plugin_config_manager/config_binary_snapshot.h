@@ -0,0 +1,121 @@
+﻿/**
+ * @file config_binary_snapshot.h
+ * @brief 配置快照的二进制伴生文件 (config.json.bin)：启动时免解析加载。
+ * * @details
+ * config.json 仍是唯一可人工编辑的真相来源。每次写完整快照时，顺带写一份
+ * 同内容的二进制文件，并记录 JSON 文本的长度与 FNV-1a 哈希。启动时若哈希与当前
+ * config.json 一致，直接在内存中二分查找二进制索引，不构建任何 nlohmann::json；
+ * 不一致 (运维手工改过 JSON) 则回退到解析 JSON。
+ * * 【文件布局】(小端，所有偏移相对文件头，8 字节对齐，可直接内存映射)
+ * - Header (64 字节)
+ * - Index：按键名字节序排序的 IndexEntry 数组 (24 字节/条)
+ * - Strings：键名与字符串值，不以 '\0' 结尾
+ * - Data：int64 / double 数组，字符串数组的 (偏移, 长度) 对
+ * * 标量值直接内联在 IndexEntry.value 中。无法用 ConfigValue 表达的 JSON
+ * (null、对象、混合数组) 以 JSON 文本存入 Strings，只用于原样写回。
+ */
+#pragma once
+#ifndef Z3Y_CONFIG_BINARY_SNAPSHOT_H_
+#define Z3Y_CONFIG_BINARY_SNAPSHOT_H_
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+#include "interfaces_core/config_types.h"
+
+namespace z3y {
+namespace plugins {
+namespace config {
+using namespace z3y::interfaces::core;
+
+/**
+ * @brief 只读的二进制配置快照。Load 之后的查询不分配键名、不解析 JSON。
+ * @note 非线程安全，由 ConfigProviderService 在 cache_mutex_ 保护下使用。
+ */
+class ConfigBinarySnapshot {
+  /** @brief 索引项 (24 字节)，按键名字节序排序。 */
+  struct IndexEntry {
+    uint32_t key_offset;  ///< 相对 Strings 段
+    uint32_t key_length;
+    uint8_t type;
+    uint8_t reserved[3];
+    uint32_t count;  ///< 字符串长度 / 数组元素个数
+    uint64_t value;  ///< 标量的位模式，或相对 Strings / Data 段的偏移
+  };
+
+ public:
+  static constexpr uint64_t kHashSeed = 14695981039346656037ull;
+
+  /**
+   * @brief 64 位 FNV-1a，用于判定二进制文件是否与 JSON 文本同源。
+   * @param seed 上一段的哈希值，分段计算时把前一次的结果传入。
+   */
+  static uint64_t Hash(std::string_view bytes, uint64_t seed = kHashSeed);
+
+  /**
+   * @brief 逐条累积 config.json 的成员，最后一次性写成二进制快照。
+   * @details 只保存紧凑的二进制编码，不保留 nlohmann::json。与 ConfigJsonWriter 配合，
+   * 写 JSON 的同时构建，JSON 文本的长度与哈希在写完后才知道。
+   */
+  class Builder {
+   public:
+    /** @brief 追加一个成员。键的顺序任意，Write 时统一排序。 */
+    void Add(const std::string& key, const nlohmann::json& value);
+
+    /**
+     * @brief 写出二进制快照 (先写 .tmp 再原子重命名)。
+     * @param json_size / json_hash 对应 config.json 的文本长度与哈希，记入文件头。
+     */
+    bool Write(const std::string& path, uint64_t json_size, uint64_t json_hash);
+
+   private:
+    std::vector<IndexEntry> index_;
+    std::string strings_;
+    std::string data_;
+  };
+
+  /**
+   * @brief 读入二进制快照。文件缺失、损坏或与 json_path 的内容不同源时返回 false 并清空。
+   * @details 先比较长度，一致时再分块读取 JSON 文件计算哈希，不把它整体读入内存。
+   */
+  bool Load(const std::string& path, const std::string& json_path);
+
+  /** @brief 丢弃已加载的数据。 */
+  void Reset() { bytes_.clear(); }
+
+  bool IsLoaded() const { return !bytes_.empty(); }
+
+  /** @brief 已加载的条目数 (未加载时为 0)。 */
+  size_t Size() const;
+
+  /**
+   * @brief 按 reference 的类型取出 key 的值 (规则与 JSON 加载一致：整数可读作浮点等)。
+   * @return key 不存在或类型不兼容时返回 false。
+   */
+  bool Find(std::string_view key, const ConfigValue& reference,
+            ConfigValue& out) const;
+
+  /** @brief 逐条以 JSON 形式回调 (写回快照、导出配方时保留未认领的数据)。 */
+  void ForEach(
+      const std::function<void(const std::string&, nlohmann::json)>& fn) const;
+
+ private:
+  struct Header;
+
+  const Header& header() const;
+  const IndexEntry* index() const;
+  std::string_view StringAt(uint32_t offset, uint32_t length) const;
+  nlohmann::json ToJson(const IndexEntry& entry) const;
+
+  std::vector<char> bytes_;  ///< 整个文件 (8 字节对齐的缓冲区)
+};
+
+}  // namespace config
+}  // namespace plugins
+}  // namespace z3y
+
+#endif  // Z3Y_CONFIG_BINARY_SNAPSHOT_H_
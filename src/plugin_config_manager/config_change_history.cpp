@@ -0,0 +1,202 @@
+﻿/**
+ * @file config_change_history.cpp
+ * @brief ConfigChangeHistory 的实现。
+ */
+#include "config_change_history.h"
+
+#include <algorithm>
+#include <fstream>
+#include <utility>
+
+namespace z3y {
+namespace plugins {
+namespace config {
+
+namespace {
+
+const size_t kDefaultCapacity = ConfigHistoryPolicy{}.capacity;
+
+nlohmann::json ValueToJson(const ConfigValue& value) {
+  return std::visit(
+      [](const auto& v) -> nlohmann::json {
+        using T = std::decay_t<decltype(v)>;
+        if constexpr (std::is_same_v<T, std::monostate>) {
+          return nullptr;
+        } else {
+          return v;
+        }
+      },
+      value);
+}
+
+}  // namespace
+
+ConfigChangeHistory::ConfigChangeHistory() : ring_(kDefaultCapacity) {}
+
+void ConfigChangeHistory::SetPolicy(const ConfigHistoryPolicy& policy) {
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  spill_path_ = policy.spill_path;
+  const uint64_t count = next_sequence_ - first_sequence_;
+  const uint64_t keep = std::min<uint64_t>(count, policy.capacity);
+  while (next_sequence_ - first_sequence_ > keep) EvictOldestLocked();
+
+  // 按新容量重新摆放保留的记录 (序号不变，只是槽位取模改变)
+  std::vector<Record> resized(policy.capacity);
+  for (uint64_t s = first_sequence_; s < next_sequence_; ++s) {
+    resized[s % resized.size()] = std::move(ring_[s % ring_.size()]);
+  }
+  ring_.swap(resized);
+  enabled_.store(policy.capacity > 0, std::memory_order_relaxed);
+}
+
+uint32_t ConfigChangeHistory::InternLocked(std::string_view text,
+                                           std::unordered_map<std::string, uint32_t>& ids,
+                                           std::vector<std::string>& names) {
+  std::string key(text);
+  auto it = ids.find(key);
+  if (it != ids.end()) return it->second;
+  const auto id = static_cast<uint32_t>(names.size());
+  names.push_back(key);
+  ids.emplace(std::move(key), id);
+  return id;
+}
+
+void ConfigChangeHistory::EvictOldestLocked() {
+  Record& oldest = ring_[first_sequence_ % ring_.size()];
+  by_path_[oldest.path_id].pop_front();
+  if (!spill_path_.empty()) {
+    const uint32_t path_id = oldest.path_id;
+    const uint32_t role_id = oldest.role_id;
+    spill_queue_.push_back({std::move(oldest), paths_[path_id], roles_[role_id]});
+  }
+  ++first_sequence_;
+}
+
+void ConfigChangeHistory::Append(const Change* changes, size_t count, std::string_view role,
+                                 uint64_t timestamp_ms) {
+  if (count == 0) return;
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  if (ring_.empty()) return;
+  // 墙上时钟可能回拨：保持缓冲按时间有序，时间范围查询才能二分
+  last_timestamp_ms_ = std::max(last_timestamp_ms_, timestamp_ms);
+  const uint32_t role_id = InternLocked(role, role_ids_, roles_);
+  for (size_t i = 0; i < count; ++i) {
+    if (next_sequence_ - first_sequence_ == ring_.size()) EvictOldestLocked();
+    const uint32_t path_id = InternLocked(changes[i].path, path_ids_, paths_);
+    if (path_id == by_path_.size()) by_path_.emplace_back();
+    const uint64_t sequence = next_sequence_++;
+    ring_[sequence % ring_.size()] = {sequence, last_timestamp_ms_, path_id, role_id,
+                                      changes[i].old_value, changes[i].new_value};
+    by_path_[path_id].push_back(sequence);
+  }
+}
+
+ConfigHistoryRecord ConfigChangeHistory::ToPublic(const Record& record) const {
+  ConfigHistoryRecord out;
+  out.sequence = record.sequence;
+  out.timestamp_ms = record.timestamp_ms;
+  out.path = paths_[record.path_id];
+  out.operator_role = roles_[record.role_id];
+  out.old_value = record.old_value.Share();
+  out.new_value = record.new_value.Share();
+  return out;
+}
+
+std::vector<ConfigHistoryRecord> ConfigChangeHistory::Query(
+    const ConfigHistoryQuery& query) const {
+  std::vector<ConfigHistoryRecord> result;
+  if (query.from_ms > query.to_ms) return result;
+  std::shared_lock<std::shared_mutex> lock(mutex_);
+  const auto before_from = [this](uint64_t sequence, uint64_t ms) {
+    return At(sequence).timestamp_ms < ms;
+  };
+  const auto after_to = [this](uint64_t ms, uint64_t sequence) {
+    return ms < At(sequence).timestamp_ms;
+  };
+
+  if (!query.path.empty()) {
+    // 路径索引：只在该路径的序号队列里二分
+    auto id = path_ids_.find(query.path);
+    if (id == path_ids_.end()) return result;
+    const std::deque<uint64_t>& sequences = by_path_[id->second];
+    auto begin = std::lower_bound(sequences.begin(), sequences.end(), query.from_ms,
+                                  before_from);
+    auto end = std::upper_bound(begin, sequences.end(), query.to_ms, after_to);
+    if (query.limit != 0 && static_cast<size_t>(end - begin) > query.limit) {
+      begin = end - static_cast<std::ptrdiff_t>(query.limit);
+    }
+    result.reserve(static_cast<size_t>(end - begin));
+    for (auto it = begin; it != end; ++it) result.push_back(ToPublic(At(*it)));
+    return result;
+  }
+
+  // 时间索引：缓冲按时间有序，直接在序号区间上二分
+  uint64_t lo = first_sequence_;
+  uint64_t hi = next_sequence_;
+  for (uint64_t count = hi - lo; count > 0;) {  // lower_bound(from_ms)
+    const uint64_t half = count / 2;
+    if (before_from(lo + half, query.from_ms)) {
+      lo += half + 1;
+      count -= half + 1;
+    } else {
+      count = half;
+    }
+  }
+  uint64_t end = lo;
+  for (uint64_t count = hi - lo; count > 0;) {  // upper_bound(to_ms)
+    const uint64_t half = count / 2;
+    if (!after_to(query.to_ms, end + half)) {
+      end += half + 1;
+      count -= half + 1;
+    } else {
+      count = half;
+    }
+  }
+  if (query.limit != 0 && end - lo > query.limit) lo = end - query.limit;
+  result.reserve(static_cast<size_t>(end - lo));
+  for (uint64_t s = lo; s < end; ++s) result.push_back(ToPublic(At(s)));
+  return result;
+}
+
+bool ConfigChangeHistory::HasPendingSpill() const {
+  std::shared_lock<std::shared_mutex> lock(mutex_);
+  return !spill_queue_.empty();
+}
+
+bool ConfigChangeHistory::FlushSpill() {
+  std::lock_guard<std::mutex> io_lock(spill_io_mutex_);
+  std::vector<SpillItem> items;
+  std::string target;
+  {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    items.swap(spill_queue_);
+    target = spill_path_;
+  }
+  if (items.empty() || target.empty()) return true;
+
+  // 锁外序列化与写盘，追加期间业务线程照常记录
+  try {
+    std::string lines;
+    for (const SpillItem& item : items) {
+      nlohmann::json line;
+      line["s"] = item.record.sequence;
+      line["t"] = item.record.timestamp_ms;
+      line["p"] = item.path;
+      line["r"] = item.role;
+      line["o"] = ValueToJson(item.record.old_value.ToValue());
+      line["n"] = ValueToJson(item.record.new_value.ToValue());
+      lines += line.dump();
+      lines += '\n';
+    }
+    std::ofstream ofs(target, std::ios::binary | std::ios::app);
+    ofs << lines;
+    ofs.flush();
+    return static_cast<bool>(ofs);
+  } catch (const nlohmann::json::exception&) {
+    return false;  // 非法 UTF-8 的字符串值
+  }
+}
+
+}  // namespace config
+}  // namespace plugins
+}  // namespace z3y
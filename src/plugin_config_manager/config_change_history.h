@@ -0,0 +1,121 @@
+﻿/**
+ * @file config_change_history.h
+ * @brief 服务内的修改历史：有界环形缓冲 + 路径 / 时间索引。
+ * * @details
+ * 审计原本只能靠订阅 ConfigChangedEvent 自行留存，“上一个班次改了什么”要么扫日志，
+ * 要么每个消费者各存一份。本仓库在修改生效的同一把节点锁内追加一条紧凑记录：
+ * - 记录只含路径 / 角色的驻留 id、新旧值单元 (与节点共享不可变缓冲)、时间戳与序号。
+ * - 时间戳在追加时单调化 (不早于上一条)，整个缓冲按时间有序，时间范围二分定位。
+ * - 每个路径维护一个按序号递增的队列，按路径查询只访问该路径的记录。
+ * - 缓冲满后淘汰最旧的记录；配置了追加文件时淘汰记录先排队，由 FlushSpill
+ *   (后台提交任务) 以 JSON Lines 写出，业务线程不做 IO。
+ * * 【约定】
+ * - 内部锁是叶子锁：可在节点锁内追加，持锁期间不回调业务代码。
+ * - 驻留的路径与角色只增不删 (与节点表一致)。
+ */
+#pragma once
+#ifndef Z3Y_CONFIG_CHANGE_HISTORY_H_
+#define Z3Y_CONFIG_CHANGE_HISTORY_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "interfaces_core/config_types.h"
+#include "config_value_cell.h"
+
+namespace z3y {
+namespace plugins {
+namespace config {
+using namespace z3y::interfaces::core;
+
+class ConfigChangeHistory {
+ public:
+  /** @brief 待追加的一条修改 (path 只需在 Append 返回前有效)。 */
+  struct Change {
+    std::string_view path;
+    ConfigValueCell old_value;
+    ConfigValueCell new_value;
+  };
+
+  ConfigChangeHistory();
+
+  /**
+   * @brief 调整容量与追加文件。缩小容量时淘汰最旧的记录 (按新策略决定是否写出)；
+   * 容量为 0 时关闭并清空。
+   */
+  void SetPolicy(const ConfigHistoryPolicy& policy);
+
+  /** @brief 是否在记录 (关闭时调用方不必构造 Change)。 */
+  bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+  /** @brief 追加同一事务的一批修改 (共用角色与时间戳，序号连续)。 */
+  void Append(const Change* changes, size_t count, std::string_view role,
+              uint64_t timestamp_ms);
+  void Append(const Change& change, std::string_view role, uint64_t timestamp_ms) {
+    Append(&change, 1, role, timestamp_ms);
+  }
+
+  /** @brief 按条件查询，结果按序号升序。 */
+  std::vector<ConfigHistoryRecord> Query(const ConfigHistoryQuery& query) const;
+
+  /** @brief 是否有淘汰记录等待写出。 */
+  bool HasPendingSpill() const;
+
+  /** @brief 把排队的淘汰记录追加到文件。写盘失败返回 false (记录被丢弃，不阻塞后续写出)。 */
+  bool FlushSpill();
+
+ private:
+  /** @brief 缓冲中的一条记录 (56 字节)。 */
+  struct Record {
+    uint64_t sequence;
+    uint64_t timestamp_ms;
+    uint32_t path_id;
+    uint32_t role_id;
+    ConfigValueCell old_value;
+    ConfigValueCell new_value;
+  };
+  /** @brief 等待写出的淘汰记录 (已还原路径与角色，脱离驻留表)。 */
+  struct SpillItem {
+    Record record;
+    std::string path;
+    std::string role;
+  };
+
+  static uint32_t InternLocked(std::string_view text,
+                               std::unordered_map<std::string, uint32_t>& ids,
+                               std::vector<std::string>& names);
+  const Record& At(uint64_t sequence) const { return ring_[sequence % ring_.size()]; }
+  /** @brief 淘汰最旧的一条。调用方持有 mutex_ 写锁且缓冲非空。 */
+  void EvictOldestLocked();
+  ConfigHistoryRecord ToPublic(const Record& record) const;
+
+  mutable std::shared_mutex mutex_;  ///< 保护以下全部成员 (叶子锁)
+  std::atomic<bool> enabled_{true};
+  std::vector<Record> ring_;         ///< 容量即 size()；序号 s 存放在 s % size()
+  uint64_t first_sequence_ = 0;      ///< 缓冲中最旧记录的序号
+  uint64_t next_sequence_ = 0;       ///< 下一条记录的序号
+  uint64_t last_timestamp_ms_ = 0;   ///< 单调化后的最新时间戳
+  std::unordered_map<std::string, uint32_t> path_ids_;
+  std::vector<std::string> paths_;
+  std::unordered_map<std::string, uint32_t> role_ids_;
+  std::vector<std::string> roles_;
+  std::vector<std::deque<uint64_t>> by_path_;  ///< path_id → 该路径在缓冲中的序号 (升序)
+  std::string spill_path_;
+  std::vector<SpillItem> spill_queue_;
+
+  std::mutex spill_io_mutex_;  ///< 串行化追加文件的写出 (不与 mutex_ 嵌套)
+};
+
+}  // namespace config
+}  // namespace plugins
+}  // namespace z3y
+
+#endif  // Z3Y_CONFIG_CHANGE_HISTORY_H_
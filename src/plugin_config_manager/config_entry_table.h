@@ -0,0 +1,151 @@
+﻿/**
+ * @file config_entry_table.h
+ * @brief 按路径哈希分片的配置节点表，替代单把全局字典锁。
+ * * @details
+ * 路径的哈希决定它落在哪个分片，每个分片各自持有一把 std::shared_mutex 和一张
+ * unordered_map。不同路径的 GetValue / SetValue / Subscribe 几乎总落在不同分片，
+ * 既不互相阻塞，也不在同一条缓存行上反复争抢读者计数。
+ * * 【约定】
+ * - 节点只增不删，Find 返回的 shared_ptr 在表之外继续有效。
+ * - ForEach 逐个分片持共享锁遍历，不是跨分片的原子快照 (节点值本来就逐个加锁读取)。
+ * - 锁顺序：分片锁 → 节点锁。持有分片锁时不得回调业务代码。
+ */
+#pragma once
+#ifndef Z3Y_CONFIG_ENTRY_TABLE_H_
+#define Z3Y_CONFIG_ENTRY_TABLE_H_
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "framework/profiled_mutex.h"
+
+namespace z3y {
+namespace plugins {
+namespace config {
+
+template <typename Entry>
+class ConfigEntryTable {
+ public:
+  static constexpr size_t kShardBits = 6;
+  static constexpr size_t kShardCount = size_t{1} << kShardBits;
+
+  /** @brief 查找节点，不存在返回 nullptr。 */
+  std::shared_ptr<Entry> Find(const std::string& path) const {
+    const Shard& shard = ShardOf(path);
+    std::shared_lock lock(shard.mutex);
+    auto it = shard.map.find(path);
+    return it == shard.map.end() ? nullptr : it->second;
+  }
+
+  bool Contains(const std::string& path) const { return Find(path) != nullptr; }
+
+  /**
+   * @brief 查找节点，不存在则插入一个默认构造的节点。
+   * @param inserted 输出：本次调用是否新建了节点。
+   * @details 先走共享锁快路径，只有真的需要插入时才取分片独占锁。
+   */
+  std::shared_ptr<Entry> FindOrInsert(const std::string& path, bool& inserted) {
+    Shard& shard = ShardOf(path);
+    inserted = false;
+    {
+      std::shared_lock lock(shard.mutex);
+      auto it = shard.map.find(path);
+      if (it != shard.map.end()) return it->second;
+    }
+    std::unique_lock lock(shard.mutex);
+    auto& slot = shard.map[path];
+    if (!slot) {
+      slot = std::make_shared<Entry>();
+      inserted = true;
+    }
+    return slot;
+  }
+
+  /**
+   * @brief 批量 FindOrInsert：按分片分组，每个涉及的分片只取一次独占锁。
+   * @param paths 待查找的路径 (不得重复)。
+   * @param out 输出：与 paths 一一对应的节点。
+   * @param inserted 输出：与 paths 一一对应，本次是否新建了节点。
+   */
+  void FindOrInsertMany(const std::vector<const std::string*>& paths,
+                        std::vector<std::shared_ptr<Entry>>& out,
+                        std::vector<char>& inserted) {
+    out.assign(paths.size(), nullptr);
+    inserted.assign(paths.size(), 0);
+    std::vector<std::pair<size_t, size_t>> order;  // (分片, 下标)
+    order.reserve(paths.size());
+    for (size_t i = 0; i < paths.size(); ++i) order.emplace_back(ShardIndex(*paths[i]), i);
+    std::sort(order.begin(), order.end());
+    for (size_t begin = 0; begin < order.size();) {
+      Shard& shard = shards_[order[begin].first];
+      size_t end = begin;
+      std::unique_lock lock(shard.mutex);
+      for (; end < order.size() && order[end].first == order[begin].first; ++end) {
+        const size_t i = order[end].second;
+        auto& slot = shard.map[*paths[i]];
+        if (!slot) {
+          slot = std::make_shared<Entry>();
+          inserted[i] = 1;
+        }
+        out[i] = slot;
+      }
+      begin = end;
+    }
+  }
+
+  /** @brief 逐分片遍历：fn(const std::string& path, const std::shared_ptr<Entry>&)。 */
+  template <typename Fn>
+  void ForEach(Fn&& fn) const {
+    for (const Shard& shard : shards_) {
+      std::shared_lock lock(shard.mutex);
+      for (const auto& kv : shard.map) fn(kv.first, kv.second);
+    }
+  }
+
+  /** @brief 按预计的节点总数预留桶，注册高峰期不再反复 rehash。 */
+  void Reserve(size_t expected_total) {
+    const size_t per_shard = expected_total / kShardCount + 1;
+    for (Shard& shard : shards_) {
+      std::unique_lock lock(shard.mutex);
+      if (shard.map.bucket_count() < per_shard) shard.map.reserve(per_shard);
+    }
+  }
+
+ private:
+  // 每个分片独占缓存行，相邻分片的读者计数不会伪共享
+  struct alignas(64) Shard {
+    // 所有分片共用一个锁名：竞争报告里按调用点区分，不按分片
+    mutable z3y::ProfiledMutex<std::shared_mutex> mutex{
+        "ConfigEntryTable.shard_mutex"};
+    std::unordered_map<std::string, std::shared_ptr<Entry>> map;
+  };
+
+  static size_t ShardIndex(const std::string& path) {
+    size_t h = std::hash<std::string>{}(path);
+    // unordered_map 取模使用低位，分片改用混合后的高位，两者互不相关
+    h ^= h >> 17;
+    h *= static_cast<size_t>(0x9E3779B97F4A7C15ull);
+    return (h >> (sizeof(size_t) * 8 - kShardBits)) & (kShardCount - 1);
+  }
+  Shard& ShardOf(const std::string& path) { return shards_[ShardIndex(path)]; }
+  const Shard& ShardOf(const std::string& path) const {
+    return shards_[ShardIndex(path)];
+  }
+
+  std::array<Shard, kShardCount> shards_;
+};
+
+}  // namespace config
+}  // namespace plugins
+}  // namespace z3y
+
+#endif  // Z3Y_CONFIG_ENTRY_TABLE_H_
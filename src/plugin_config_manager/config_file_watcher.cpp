@@ -0,0 +1,234 @@
+﻿/**
+ * @file config_file_watcher.cpp
+ * @brief ConfigFileWatcher 的平台实现。
+ */
+
+#include "config_file_watcher.h"
+
+#include <cerrno>
+#include <filesystem>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#elif defined(__linux__)
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace z3y {
+namespace plugins {
+namespace config {
+
+namespace {
+
+std::filesystem::path WatchedDirectory(const std::filesystem::path& file) {
+  std::filesystem::path dir = file.parent_path();
+  return dir.empty() ? std::filesystem::path(".") : dir;
+}
+
+}  // namespace
+
+#ifdef _WIN32
+
+bool ConfigFileWatcher::Start(const std::string& file_path,
+                              std::chrono::milliseconds debounce, Callback on_change) {
+  Stop();
+  const std::filesystem::path file(file_path);
+  HANDLE dir = ::CreateFileW(WatchedDirectory(file).c_str(), FILE_LIST_DIRECTORY,
+                             FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                             nullptr, OPEN_EXISTING,
+                             FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+  if (dir == INVALID_HANDLE_VALUE) return false;
+  HANDLE stop = ::CreateEventW(nullptr, TRUE, FALSE, nullptr);
+  if (!stop) {
+    ::CloseHandle(dir);
+    return false;
+  }
+  dir_handle_ = dir;
+  stop_event_ = stop;
+  thread_ = std::thread(&ConfigFileWatcher::Run, this, file.filename().string(), debounce,
+                        std::move(on_change));
+  return true;
+}
+
+void ConfigFileWatcher::Stop() {
+  if (!thread_.joinable()) return;
+  ::SetEvent(static_cast<HANDLE>(stop_event_));
+  thread_.join();
+  ::CloseHandle(static_cast<HANDLE>(dir_handle_));
+  ::CloseHandle(static_cast<HANDLE>(stop_event_));
+  dir_handle_ = nullptr;
+  stop_event_ = nullptr;
+}
+
+void ConfigFileWatcher::Run(std::string file_name, std::chrono::milliseconds debounce,
+                            Callback on_change) {
+  const HANDLE dir = static_cast<HANDLE>(dir_handle_);
+  const HANDLE stop = static_cast<HANDLE>(stop_event_);
+  const std::wstring target = std::filesystem::path(file_name).wstring();
+  OVERLAPPED overlapped{};
+  overlapped.hEvent = ::CreateEventW(nullptr, TRUE, FALSE, nullptr);
+  if (!overlapped.hEvent) return;
+  // FILE_NOTIFY_INFORMATION 要求 DWORD 对齐
+  std::vector<DWORD> buffer(16 * 1024);
+  const DWORD filter = FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME |
+                       FILE_NOTIFY_CHANGE_SIZE;
+  bool pending = false;
+  std::chrono::steady_clock::time_point deadline;
+
+  while (true) {
+    ::ResetEvent(overlapped.hEvent);
+    if (!::ReadDirectoryChangesW(dir, buffer.data(),
+                                 static_cast<DWORD>(buffer.size() * sizeof(DWORD)), FALSE,
+                                 filter, nullptr, &overlapped, nullptr)) {
+      break;
+    }
+    bool io_done = false;
+    while (!io_done) {
+      DWORD timeout = INFINITE;
+      if (pending) {
+        const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now());
+        timeout = left.count() > 0 ? static_cast<DWORD>(left.count()) : 0;
+      }
+      const HANDLE handles[2] = {stop, overlapped.hEvent};
+      const DWORD result = ::WaitForMultipleObjects(2, handles, FALSE, timeout);
+      if (result == WAIT_OBJECT_0) {
+        ::CancelIoEx(dir, &overlapped);
+        DWORD ignored = 0;
+        ::GetOverlappedResult(dir, &overlapped, &ignored, TRUE);
+        ::CloseHandle(overlapped.hEvent);
+        return;
+      }
+      if (result == WAIT_TIMEOUT) {
+        pending = false;
+        on_change();
+        continue;
+      }
+      if (result != WAIT_OBJECT_0 + 1) {
+        ::CloseHandle(overlapped.hEvent);
+        return;
+      }
+      io_done = true;
+      DWORD bytes = 0;
+      if (!::GetOverlappedResult(dir, &overlapped, &bytes, FALSE)) break;
+      bool matched = bytes == 0;  // 缓冲区溢出：事件丢失，按“可能变化”处理
+      const char* cursor = reinterpret_cast<const char*>(buffer.data());
+      while (bytes != 0) {
+        const auto* info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(cursor);
+        const std::wstring name(info->FileName, info->FileNameLength / sizeof(WCHAR));
+        if (info->Action != FILE_ACTION_REMOVED &&
+            info->Action != FILE_ACTION_RENAMED_OLD_NAME &&
+            ::_wcsicmp(name.c_str(), target.c_str()) == 0) {
+          matched = true;
+        }
+        if (info->NextEntryOffset == 0) break;
+        cursor += info->NextEntryOffset;
+      }
+      if (matched) {
+        pending = true;
+        deadline = std::chrono::steady_clock::now() + debounce;
+      }
+    }
+  }
+  ::CloseHandle(overlapped.hEvent);
+}
+
+#elif defined(__linux__)
+
+bool ConfigFileWatcher::Start(const std::string& file_path,
+                              std::chrono::milliseconds debounce, Callback on_change) {
+  Stop();
+  const std::filesystem::path file(file_path);
+  const int fd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (fd < 0) return false;
+  // 写入完成 (就地保存)、移入 (原子重命名)、创建 (删除后重建)
+  if (::inotify_add_watch(fd, WatchedDirectory(file).c_str(),
+                          IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) < 0 ||
+      ::pipe2(stop_pipe_, O_CLOEXEC) != 0) {
+    ::close(fd);
+    return false;
+  }
+  notify_fd_ = fd;
+  thread_ = std::thread(&ConfigFileWatcher::Run, this, file.filename().string(), debounce,
+                        std::move(on_change));
+  return true;
+}
+
+void ConfigFileWatcher::Stop() {
+  if (!thread_.joinable()) return;
+  const char byte = 0;
+  (void)::write(stop_pipe_[1], &byte, 1);
+  thread_.join();
+  ::close(notify_fd_);
+  ::close(stop_pipe_[0]);
+  ::close(stop_pipe_[1]);
+  notify_fd_ = -1;
+  stop_pipe_[0] = stop_pipe_[1] = -1;
+}
+
+void ConfigFileWatcher::Run(std::string file_name, std::chrono::milliseconds debounce,
+                            Callback on_change) {
+  // inotify_event 后接变长文件名，缓冲区按其对齐
+  alignas(inotify_event) char buffer[16 * 1024];
+  bool pending = false;
+  std::chrono::steady_clock::time_point deadline;
+
+  while (true) {
+    int timeout = -1;
+    if (pending) {
+      const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+          deadline - std::chrono::steady_clock::now());
+      timeout = left.count() > 0 ? static_cast<int>(left.count()) : 0;
+    }
+    pollfd fds[2] = {{stop_pipe_[0], POLLIN, 0}, {notify_fd_, POLLIN, 0}};
+    const int ready = ::poll(fds, 2, timeout);
+    if (ready < 0) {
+      if (errno == EINTR) continue;
+      return;
+    }
+    if (fds[0].revents != 0) return;
+    if (ready == 0) {
+      pending = false;
+      on_change();
+      continue;
+    }
+    while (true) {
+      const ssize_t n = ::read(notify_fd_, buffer, sizeof(buffer));
+      if (n <= 0) break;
+      for (ssize_t offset = 0; offset < n;) {
+        const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+        // 队列溢出：事件丢失，按“可能变化”处理
+        if ((event->mask & IN_Q_OVERFLOW) ||
+            (event->len > 0 && file_name == event->name)) {
+          pending = true;
+          deadline = std::chrono::steady_clock::now() + debounce;
+        }
+        offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+      }
+    }
+  }
+}
+
+#else
+
+bool ConfigFileWatcher::Start(const std::string&, std::chrono::milliseconds, Callback) {
+  return false;
+}
+
+void ConfigFileWatcher::Stop() {}
+
+void ConfigFileWatcher::Run(std::string, std::chrono::milliseconds, Callback) {}
+
+#endif
+
+}  // namespace config
+}  // namespace plugins
+}  // namespace z3y
@@ -0,0 +1,66 @@
+﻿/**
+ * @file config_file_watcher.h
+ * @brief 监视 config.json 的外部修改 (Linux inotify / Windows ReadDirectoryChangesW)。
+ * * @details
+ * 监视的是文件所在的目录而不是文件本身：编辑器与部署脚本常用“写临时文件再重命名”
+ * 替换配置，直接监视旧 inode 会在第一次替换后失效。目录中只有目标文件名的
+ * 写入完成 / 移入 / 创建事件才计数。
+ * - 事件去抖：最后一个事件之后安静 debounce 才回调一次，编辑器连续保存只处理一次。
+ * - 回调在监视线程上执行，调用方自行判断内容是否真的变化 (例如自己的原子重命名)。
+ * - 其他平台 Start 返回 false，调用方仍可手动 ReloadFromFile。
+ */
+#pragma once
+#ifndef Z3Y_CONFIG_FILE_WATCHER_H_
+#define Z3Y_CONFIG_FILE_WATCHER_H_
+
+#include <chrono>
+#include <functional>
+#include <string>
+#include <thread>
+
+namespace z3y {
+namespace plugins {
+namespace config {
+
+class ConfigFileWatcher {
+ public:
+  using Callback = std::function<void()>;
+
+  ConfigFileWatcher() = default;
+  ~ConfigFileWatcher() { Stop(); }
+
+  ConfigFileWatcher(const ConfigFileWatcher&) = delete;
+  ConfigFileWatcher& operator=(const ConfigFileWatcher&) = delete;
+
+  /**
+   * @brief 开始监视 file_path (已在监视时先停止旧的)。
+   * @param debounce 最后一个事件之后等待多久才回调。
+   * @param on_change 在监视线程上调用；Stop 返回后不再调用。
+   * @return 平台不支持或目录无法监视时返回 false。
+   */
+  bool Start(const std::string& file_path, std::chrono::milliseconds debounce,
+             Callback on_change);
+
+  /** @brief 停止监视并等待监视线程退出。不得在 on_change 内调用。 */
+  void Stop();
+
+  bool IsRunning() const { return thread_.joinable(); }
+
+ private:
+  void Run(std::string file_name, std::chrono::milliseconds debounce, Callback on_change);
+
+  std::thread thread_;
+#ifdef _WIN32
+  void* dir_handle_ = nullptr;  ///< 目录句柄 (HANDLE)
+  void* stop_event_ = nullptr;  ///< Stop 置位的手动重置事件 (HANDLE)
+#else
+  int notify_fd_ = -1;          ///< inotify 描述符
+  int stop_pipe_[2] = {-1, -1}; ///< Stop 写入一个字节唤醒 poll
+#endif
+};
+
+}  // namespace config
+}  // namespace plugins
+}  // namespace z3y
+
+#endif  // Z3Y_CONFIG_FILE_WATCHER_H_
@@ -0,0 +1,141 @@
+﻿/**
+ * @file config_group_index.h
+ * @brief 分组二级索引：group_key → subgroup_key → 路径 → 节点。
+ * * @details
+ * UI 切换页签时调用 GetConfigsByGroup / GetAllGroupKeys。原实现扫描整个字典并给
+ * 每个节点加锁读取 meta.group_key，大配置下会卡住编辑器。本索引在 RegisterSchema
+ * 时登记 (分组、隐藏与高级标记此后不再变化)，查询只遍历目标分组，不碰其余节点的锁。
+ * 每个二级分组另记非隐藏 / 高级参数的计数，导航树的骨架 (GetGroupIndex) 只读计数。
+ * * 【约定】
+ * - 节点只增不删，因此索引也只增不删。占位节点不进入索引，转正时才登记。
+ * - 锁顺序：索引锁 → 节点锁。持有索引锁时不得回调业务代码。
+ */
+#pragma once
+#ifndef Z3Y_CONFIG_GROUP_INDEX_H_
+#define Z3Y_CONFIG_GROUP_INDEX_H_
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+namespace z3y {
+namespace plugins {
+namespace config {
+
+template <typename Entry>
+class ConfigGroupIndex {
+ public:
+  /** @brief 登记一个已定型节点 (每个路径只登记一次)。 */
+  void Add(const std::string& group_key, const std::string& subgroup_key,
+           bool is_hidden, bool is_advanced, const std::string& path,
+           std::shared_ptr<Entry> entry) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    AddLocked(group_key, subgroup_key, is_hidden, is_advanced, path, std::move(entry));
+  }
+
+  /** @brief 批量登记中的一项 (字符串由调用方持有，AddMany 返回前有效)。 */
+  struct Item {
+    const std::string* group_key;
+    const std::string* subgroup_key;
+    bool is_hidden;
+    bool is_advanced;
+    const std::string* path;
+    std::shared_ptr<Entry> entry;
+  };
+
+  /** @brief 在一次独占锁内登记一批节点 (SchemaBatch 注册)。 */
+  void AddMany(std::vector<Item>& items) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    for (Item& item : items) {
+      AddLocked(*item.group_key, *item.subgroup_key, item.is_hidden, item.is_advanced,
+                *item.path, std::move(item.entry));
+    }
+  }
+
+  /**
+   * @brief 遍历一个分组的全部节点 (按二级分组、路径排序)：
+   * fn(const std::string& path, const std::shared_ptr<Entry>&)。
+   */
+  template <typename Fn>
+  void ForEachInGroup(const std::string& group_key, Fn&& fn) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    auto it = groups_.find(group_key);
+    if (it == groups_.end()) return;
+    for (const auto& sub : it->second.subgroups) {
+      for (const auto& kv : sub.second.entries) fn(kv.first, kv.second);
+    }
+  }
+
+  /** @brief 遍历一个二级分组的全部节点 (按路径排序)，回调同 ForEachInGroup。 */
+  template <typename Fn>
+  void ForEachInSubgroup(const std::string& group_key, const std::string& subgroup_key,
+                         Fn&& fn) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    auto it = groups_.find(group_key);
+    if (it == groups_.end()) return;
+    auto sub = it->second.subgroups.find(subgroup_key);
+    if (sub == it->second.subgroups.end()) return;
+    for (const auto& kv : sub->second.entries) fn(kv.first, kv.second);
+  }
+
+  /**
+   * @brief 只读计数地遍历含非隐藏节点的二级分组 (分组名非空，有序)：
+   * fn(group_key, subgroup_key, visible_count, advanced_count)。不访问任何节点。
+   */
+  template <typename Fn>
+  void ForEachVisibleSubgroup(Fn&& fn) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    for (const auto& kv : groups_) {
+      if (kv.first.empty() || kv.second.visible_count == 0) continue;
+      for (const auto& sub : kv.second.subgroups) {
+        if (sub.second.visible_count == 0) continue;
+        fn(kv.first, sub.first, sub.second.visible_count, sub.second.advanced_count);
+      }
+    }
+  }
+
+  /** @brief 含至少一个非隐藏节点的非空分组名 (有序)。 */
+  std::vector<std::string> VisibleGroupKeys() const {
+    std::vector<std::string> keys;
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    for (const auto& kv : groups_) {
+      if (!kv.first.empty() && kv.second.visible_count > 0) keys.push_back(kv.first);
+    }
+    return keys;
+  }
+
+ private:
+  struct Subgroup {
+    size_t visible_count = 0;   ///< 非隐藏节点数
+    size_t advanced_count = 0;  ///< 其中的高级节点数
+    std::map<std::string, std::shared_ptr<Entry>> entries;
+  };
+
+  struct Group {
+    size_t visible_count = 0;  ///< 非隐藏节点数，为 0 的分组不展示给 UI
+    std::map<std::string, Subgroup> subgroups;
+  };
+
+  void AddLocked(const std::string& group_key, const std::string& subgroup_key,
+                 bool is_hidden, bool is_advanced, const std::string& path,
+                 std::shared_ptr<Entry> entry) {
+    Group& group = groups_[group_key];
+    Subgroup& subgroup = group.subgroups[subgroup_key];
+    if (!subgroup.entries.emplace(path, std::move(entry)).second || is_hidden) return;
+    ++group.visible_count;
+    ++subgroup.visible_count;
+    if (is_advanced) ++subgroup.advanced_count;
+  }
+
+  mutable std::shared_mutex mutex_;
+  std::map<std::string, Group> groups_;
+};
+
+}  // namespace config
+}  // namespace plugins
+}  // namespace z3y
+
+#endif  // Z3Y_CONFIG_GROUP_INDEX_H_
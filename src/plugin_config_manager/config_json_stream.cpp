@@ -0,0 +1,166 @@
+﻿/**
+ * @file config_json_stream.cpp
+ * @brief ConfigJsonObjectReader / ConfigJsonWriter 的实现。
+ */
+
+#include "config_json_stream.h"
+
+#include <istream>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+namespace z3y {
+namespace plugins {
+namespace config {
+
+namespace {
+
+/**
+ * @brief SAX 处理器：跳过顶层对象本身，只为当前成员的值构建 DOM。
+ * @details stack_ 保存当前成员内尚未闭合的对象 / 数组。子容器的地址在其闭合前
+ * 保持稳定：父对象是 std::map，父数组在子容器闭合前不会再追加元素。
+ */
+class MemberSaxHandler {
+ public:
+  using json = nlohmann::json;
+
+  explicit MemberSaxHandler(const ConfigJsonObjectReader::MemberCallback& fn) : fn_(fn) {}
+
+  bool null() { return Put(nullptr); }
+  bool boolean(bool val) { return Put(val); }
+  bool number_integer(json::number_integer_t val) { return Put(val); }
+  bool number_unsigned(json::number_unsigned_t val) { return Put(val); }
+  bool number_float(json::number_float_t val, const json::string_t&) { return Put(val); }
+  bool string(json::string_t& val) { return Put(std::move(val)); }
+  bool binary(json::binary_t& val) { return Put(json::binary(std::move(val))); }
+
+  bool start_object(std::size_t) { return Open(json::object()); }
+  bool start_array(std::size_t) {
+    if (!in_root_) return Fail("Config file must be a JSON object.");
+    return Open(json::array());
+  }
+  bool end_object() { return Close(); }
+  bool end_array() { return Close(); }
+
+  bool key(json::string_t& val) {
+    if (stack_.empty()) {
+      member_key_ = std::move(val);
+    } else {
+      slot_ = &(*stack_.back())[val];
+    }
+    return true;
+  }
+
+  bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception& ex) {
+    return Fail(ex.what());
+  }
+
+  const std::string& error() const { return error_; }
+
+ private:
+  bool Fail(std::string message) {
+    error_ = std::move(message);
+    return false;
+  }
+
+  /** @brief 当前容器中下一个值的位置。 */
+  json* Slot() {
+    json& top = *stack_.back();
+    if (top.is_array()) {
+      top.emplace_back();
+      return &top.back();
+    }
+    return slot_;
+  }
+
+  template <typename V>
+  bool Put(V&& val) {
+    if (!in_root_) return Fail("Config file must be a JSON object.");
+    if (stack_.empty()) {
+      member_value_ = std::forward<V>(val);
+      Emit();
+    } else {
+      *Slot() = std::forward<V>(val);
+    }
+    return true;
+  }
+
+  bool Open(json container) {
+    if (!in_root_) {
+      in_root_ = true;  // 顶层对象本身不构建
+      return true;
+    }
+    json* target = stack_.empty() ? &member_value_ : Slot();
+    *target = std::move(container);
+    stack_.push_back(target);
+    return true;
+  }
+
+  bool Close() {
+    if (stack_.empty()) return true;  // 顶层对象结束
+    stack_.pop_back();
+    if (stack_.empty()) Emit();
+    return true;
+  }
+
+  void Emit() {
+    fn_(member_key_, std::move(member_value_));
+    member_value_ = json();
+  }
+
+  const ConfigJsonObjectReader::MemberCallback& fn_;
+  bool in_root_ = false;
+  std::string member_key_;
+  json member_value_;
+  std::vector<json*> stack_;
+  json* slot_ = nullptr;
+  std::string error_;
+};
+
+}  // namespace
+
+bool ConfigJsonObjectReader::ForEachMember(std::istream& input, const MemberCallback& fn,
+                                           std::string& out_error) {
+  MemberSaxHandler handler(fn);
+  const bool ok = nlohmann::json::sax_parse(input, &handler);
+  if (!ok) out_error = handler.error().empty() ? "JSON parse error." : handler.error();
+  return ok;
+}
+
+ConfigJsonWriter::ConfigJsonWriter(std::ostream& output, ConfigBinarySnapshot::Builder* binary)
+    : output_(output), binary_(binary) {
+  Write("{");
+}
+
+void ConfigJsonWriter::Add(const std::string& key, const nlohmann::json& value) {
+  // 与 dump(4) 相同：成员缩进 4 格，嵌套内容整体再缩进一级 (JSON 字符串内不含裸换行)
+  buffer_ = empty_ ? "\n    " : ",\n    ";
+  buffer_ += nlohmann::json(key).dump();
+  buffer_ += ": ";
+  const std::string text = value.dump(4);
+  for (char c : text) {
+    buffer_ += c;
+    if (c == '\n') buffer_ += "    ";
+  }
+  Write(buffer_);
+  empty_ = false;
+  if (binary_) binary_->Add(key, value);
+  if (member_hashes_) (*member_hashes_)[key] = ConfigBinarySnapshot::Hash(text);
+}
+
+uint64_t ConfigJsonWriter::ValueHash(const nlohmann::json& value) {
+  return ConfigBinarySnapshot::Hash(value.dump(4));
+}
+
+void ConfigJsonWriter::Finish() { Write(empty_ ? "}" : "\n}"); }
+
+void ConfigJsonWriter::Write(std::string_view text) {
+  output_.write(text.data(), static_cast<std::streamsize>(text.size()));
+  size_ += text.size();
+  hash_ = ConfigBinarySnapshot::Hash(text, hash_);
+}
+
+}  // namespace config
+}  // namespace plugins
+}  // namespace z3y
@@ -0,0 +1,92 @@
+﻿/**
+ * @file config_json_stream.h
+ * @brief config.json / 配方文件的流式读写：不为整个文件构建 nlohmann::json DOM。
+ * * @details
+ * 配置文件顶层固定是一个 { "路径": 值, ... } 对象，单个值很小而条目很多。
+ * - 读取：ConfigJsonObjectReader 以 SAX 方式解析，每读完一个顶层成员就回调一次，
+ *   只为这一个值构建 nlohmann::json，回调返回后即释放。
+ * - 写入：ConfigJsonWriter 逐条写出成员，输出与 nlohmann::json::dump(4) 逐字节相同，
+ *   并顺带累计文本长度与 FNV-1a 哈希 (供二进制伴生快照判定同源)。
+ * - 文件监视开启时，写入器还按成员记录值的哈希 (ValueHash)，外部修改时据此只应用变化的键。
+ */
+#pragma once
+#ifndef Z3Y_CONFIG_JSON_STREAM_H_
+#define Z3Y_CONFIG_JSON_STREAM_H_
+
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include <nlohmann/json.hpp>
+#include "config_binary_snapshot.h"
+
+namespace z3y {
+namespace plugins {
+namespace config {
+
+/**
+ * @brief 流式遍历顶层 JSON 对象的成员。
+ */
+class ConfigJsonObjectReader {
+ public:
+  using MemberCallback = std::function<void(const std::string& key, nlohmann::json value)>;
+
+  /**
+   * @brief 逐个回调 input 顶层对象的成员 (按文件顺序，重复的键回调多次)。
+   * @param out_error 失败时写入原因。
+   * @return 语法错误或顶层不是对象时返回 false；出错之前的成员已经回调过。
+   */
+  static bool ForEachMember(std::istream& input, const MemberCallback& fn,
+                            std::string& out_error);
+};
+
+/**
+ * @brief 逐条写出顶层 JSON 对象，格式与 dump(4) 一致。
+ * @note 键由调用方保证有序且不重复 (与 nlohmann::json 对象的输出顺序相同)。
+ */
+class ConfigJsonWriter {
+ public:
+  /** @param binary 非空时把每个成员同时交给二进制快照构建器。 */
+  explicit ConfigJsonWriter(std::ostream& output,
+                            ConfigBinarySnapshot::Builder* binary = nullptr);
+
+  /** @brief 写出一个成员。值中的非法 UTF-8 会抛出 nlohmann::json::exception。 */
+  void Add(const std::string& key, const nlohmann::json& value);
+
+  /**
+   * @brief 按成员记录值的哈希 (与 ValueHash 相同)，sink 为空时不记录。
+   * @details 供文件监视比对外部修改 (见 ConfigProviderService::SetFileWatch)。
+   */
+  void SetMemberHashSink(std::unordered_map<std::string, uint64_t>* sink) {
+    member_hashes_ = sink;
+  }
+
+  /** @brief 单个值的哈希：dump(4) 文本的 FNV-1a，与写出时使用的文本一致。 */
+  static uint64_t ValueHash(const nlohmann::json& value);
+
+  /** @brief 写出结尾的 '}'。之后 size() / hash() 即整个文件的长度与哈希。 */
+  void Finish();
+
+  uint64_t size() const { return size_; }
+  uint64_t hash() const { return hash_; }
+
+ private:
+  void Write(std::string_view text);
+
+  std::ostream& output_;
+  ConfigBinarySnapshot::Builder* binary_;
+  std::unordered_map<std::string, uint64_t>* member_hashes_ = nullptr;
+  std::string buffer_;  ///< 复用的单条序列化缓冲
+  bool empty_ = true;
+  uint64_t size_ = 0;
+  uint64_t hash_ = ConfigBinarySnapshot::kHashSeed;
+};
+
+}  // namespace config
+}  // namespace plugins
+}  // namespace z3y
+
+#endif  // Z3Y_CONFIG_JSON_STREAM_H_
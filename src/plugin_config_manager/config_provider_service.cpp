@@ -17,9 +17,23 @@
 
 #include <algorithm>
 #include <chrono>
+#include <filesystem>
 #include <fstream>
 #include <iostream>
-#include <set>
+#include <string_view>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 #include "framework/z3y_framework.h"
 
@@ -35,11 +49,34 @@ namespace {
 thread_local int g_recursion_depth = 0;
 thread_local bool g_has_cyclic_error = false;
 
+// 注册时认领磁盘旧值所用的操作者角色 (此时不按枚举字典校验)
+constexpr const char* kInitRole = "System_Init";
+
 struct RecursionGuard {
   RecursionGuard() { g_recursion_depth++; }
   ~RecursionGuard() { g_recursion_depth--; }
 };
 
+/**
+ * @brief RAII 批量加锁门神：按 items 的顺序独占每个元素的 entry->entry_mutex。
+ * @details 调用方负责把 items 按节点地址排好序且节点不重复，保证加锁顺序全局一致。
+ */
+template <typename Items>
+class BatchLockGuard {
+ public:
+  explicit BatchLockGuard(const Items& items) : items_(items) {
+    for (const auto& item : items_) item.entry->entry_mutex.lock();
+  }
+  ~BatchLockGuard() {
+    for (const auto& item : items_) item.entry->entry_mutex.unlock();
+  }
+  BatchLockGuard(const BatchLockGuard&) = delete;
+  BatchLockGuard& operator=(const BatchLockGuard&) = delete;
+
+ private:
+  const Items& items_;
+};
+
 /**
  * @brief 将严格变体类型降维序列化为无类型的 JSON 结构。
  */
@@ -100,6 +137,44 @@ bool JsonToConfigValue(const nlohmann::json& j, const ConfigValue& reference,
   return false;
 }
 
+/**
+ * @brief 辅助：已存在的节点能否被重新注册。
+ * @return 占位节点 (订阅者先到) 返回 true，可以“转正”。
+ * @throws std::invalid_argument 已定型节点的类型与 default_val 不同。
+ * @throws std::logic_error 已被别的业务注册过。
+ */
+bool CheckReRegistration(const ConfigEntry& entry, const std::string& path,
+                         const ConfigValue& default_val) {
+  size_t existing_type;
+  {
+    std::shared_lock<std::shared_mutex> entry_lock(entry.entry_mutex);
+    existing_type = entry.default_value.index();
+  }
+  if (existing_type == ConfigValue(std::monostate{}).index()) {
+    return true;
+  }
+  if (existing_type != default_val.index()) {
+    // 已定型节点被以另一种类型重新注册：属于类型错误，而非单纯的重复注册
+    throw std::invalid_argument(
+        "ConfigType Mismatch on re-registration for path: " + path);
+  }
+  // 真的是被别的业务注册过了，抛出异常，防止多个组件竞态注册同一配置项
+  throw std::logic_error("Duplicated configuration registration for path: " + path);
+}
+
+/**
+ * @brief 辅助：监视参数只能是标量。
+ * @throws std::invalid_argument is_monitor 的默认值不是 int64 / double / bool。
+ */
+void CheckMonitorType(const SchemaMetadata& meta, const std::string& path,
+                      const ConfigValue& default_val) {
+  if (meta.is_monitor && !std::holds_alternative<int64_t>(default_val) &&
+      !std::holds_alternative<double>(default_val) &&
+      !std::holds_alternative<bool>(default_val)) {
+    throw std::invalid_argument("Monitor parameters must be int64, double or bool: " + path);
+  }
+}
+
 /** @brief 辅助：获取当前系统毫秒级时间戳 */
 uint64_t GetCurrentTimestampMs() {
   return std::chrono::duration_cast<std::chrono::milliseconds>(
@@ -107,102 +182,199 @@ uint64_t GetCurrentTimestampMs() {
       .count();
 }
 
-/** @brief 辅助：将 Variant 转化为清晰的字符串，用于写入审计日志 */
-std::string ConfigValueToString(const ConfigValue& val) {
-  return ConfigValueToJson(val).dump();
+/** @brief 辅助：构造审计事件 (新旧值以共享只读形式携带，不做 JSON 序列化) */
+ConfigChangedEvent MakeChangedEvent(const std::string& path, ConfigValue old_val,
+                                    const ConfigValue& new_val, const std::string& role,
+                                    uint64_t timestamp_ms) {
+  ConfigChangedEvent evt;
+  evt.path = path;
+  evt.old_value = std::make_shared<const ConfigValue>(std::move(old_val));
+  evt.new_value = std::make_shared<const ConfigValue>(new_val);
+  evt.operator_role = role;
+  evt.timestamp_ms = timestamp_ms;
+  return evt;
+}
+
+/** @brief 辅助：把文件内容刷到物理介质 (fsync / FlushFileBuffers) */
+bool SyncFile(const std::string& path) {
+#ifdef _WIN32
+  HANDLE h = ::CreateFileW(std::filesystem::path(path).c_str(), GENERIC_WRITE,
+                           FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                           OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (h == INVALID_HANDLE_VALUE) return false;
+  const bool ok = ::FlushFileBuffers(h) != 0;
+  ::CloseHandle(h);
+  return ok;
+#else
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) return false;
+  const bool ok = ::fsync(fd) == 0;
+  ::close(fd);
+  return ok;
+#endif
+}
+
+/**
+ * @brief 辅助：让目录项 (rename 的结果) 落盘。
+ * @details Windows 上 NTFS 的元数据日志保证 rename 的持久性，这里无事可做。
+ */
+void SyncParentDirectory(const std::string& path) {
+#ifndef _WIN32
+  std::string dir = std::filesystem::path(path).parent_path().string();
+  if (dir.empty()) dir = ".";
+  const int fd = ::open(dir.c_str(), O_RDONLY);
+  if (fd < 0) return;
+  ::fsync(fd);
+  ::close(fd);
+#else
+  (void)path;
+#endif
 }
 
 }  // namespace
 
 ConfigProviderService::ConfigProviderService() {}
 
-ConfigProviderService::~ConfigProviderService() {}
+ConfigProviderService::~ConfigProviderService() {
+  // 与 Shutdown 并发提交、未被排空的写入：承诺以 false 兑现
+  for (auto& write : TakeAsyncWrites()) write->done.set_value(false);
+}
 
 // 框架在安全时刻调用的初始化
 void ConfigProviderService::Initialize() {
   // 生成存活防线：在 Shutdown 之前它都不会过期
   alive_token_ = std::make_shared<int>(0);
+  try {
+    event_bus_ = z3y::GetService<z3y::IEventBus>(z3y::clsid::kEventBus);
+  } catch (const z3y::PluginException&) {
+    // 没有事件总线时不广播审计事件
+  }
+  try {
+    executor_ = z3y::GetService<z3y::IExecutorService>(z3y::clsid::kExecutor);
+  } catch (const z3y::PluginException&) {
+    // 没有框架执行器时在调用线程上同步提交
+  }
   LoadFromFile();  // 读取落盘文件到初始内存池
-
-  // 必须在准备工作全部就绪后，再拉起 IO 守护线程
-  worker_thread_ = std::thread(&ConfigProviderService::WorkerRoutine, this);
 }
 
 // 框架在卸载插件前调用的清理
 void ConfigProviderService::Shutdown() {
-  // 优雅停止线程的经典写法
+  // 先拒绝新的异步写入，再在本线程执行已排队的，使最后一次落盘包含它们
+  async_stopped_.store(true, std::memory_order_release);
+  DrainAsyncWrites();
+  async_writer_.Stop();
+
+  // 读者保留映射，看到 publisher_attached 变为 false
+  shared_view_.Stop();
+
+  {
+    // 先停监视：退出前的最后一次写盘不必再被识别，外部修改也不再应用到正在关闭的服务
+    std::lock_guard<std::mutex> control_lock(watch_control_mutex_);
+    file_watch_enabled_.store(false);
+    file_watcher_.Stop();
+  }
+
+  bool fsync = true;
   {
     std::unique_lock<std::mutex> lock(worker_mutex_);
     stop_worker_ = true;
+    // 撤销尚未到期的预约；已到期的预约与进行中的提交看到 stop_worker_ 后不再提交，等它们离场
+    // (执行器已随框架销毁时预约不会再执行，直接作废)
+    auto executor = executor_.lock();
+    if (commit_timer_ != 0 && (!executor || executor->CancelTimer(commit_timer_))) {
+      commit_timer_ = 0;
+    }
+    flush_cv_.wait(lock, [this] { return commit_timer_ == 0 && !commit_running_; });
+
+    // 处理完最后一次脏数据 (直接写完整快照)
+    if (is_snapshot_dirty_) RunCommit(lock, true);
+    fsync = policy_.fsync;
   }
-  worker_cv_.notify_one();
 
-  if (worker_thread_.joinable()) {
-    worker_thread_.join();
+  {
+    // 退出前把残留的日志压实，下次启动只需读取一份完整快照
+    std::lock_guard<std::mutex> io_lock(io_mutex_);
+    std::error_code ec;
+    if (std::filesystem::file_size(config_journal_path_, ec) > 0 && !ec) {
+      WriteFullSnapshot(fsync);
+    }
   }
+
+  {
+    std::unique_lock<std::mutex> lock(worker_mutex_);
+    worker_exited_ = true;
+  }
+  flush_cv_.notify_all();
+
+  // 排队中的订阅回调可能指向即将卸载的插件代码，卸载前停下派发线程并丢弃
+  notify_executor_.Stop();
 }
 
 void ConfigProviderService::RegisterSchema(const std::string& path,
                                            const SchemaMetadata& meta,
                                            const ConfigValue& default_val) {
+  CheckMonitorType(meta, path, default_val);
   std::shared_ptr<ConfigEntry> target_entry;
   bool is_phantom_upgrade = false;  // 关键标记：是否正在把一个占位节点“转正”
 
-  // 用于在全局字典锁内安全地提取和暂存缓存数据
+  // 用于在孤儿锁内安全地提取和暂存缓存数据
   nlohmann::json cached_json;
   bool has_cache = false;
+  ConfigValue binary_val;  // 二进制快照中已按 default_val 类型取出的值
+  bool has_binary = false;
 
   {
-    // 独占全局字典锁：严格保护 config_dict_ 和 initial_load_cache_ 的并发操作
-    std::unique_lock<std::shared_mutex> dict_lock(dict_mutex_);
-    auto it = config_dict_.find(path);
+    // 只独占 path 所在的分片：全新节点直接插入拓扑树
+    bool inserted = false;
+    target_entry = config_dict_.FindOrInsert(path, inserted);
 
-    if (it != config_dict_.end()) {
+    if (!inserted) {
       // 检查当前是不是空节点。
       // 【背景】如果有插件在底层注册前，就已经通过 Subscribe 想听这个数据，
       // 系统为了保存它的回调句柄，会强行插入一个 default_value 为 monostate
       // 的假节点（占位）。
-      if (std::holds_alternative<std::monostate>(it->second->default_value)) {
-        target_entry = it->second;
-        is_phantom_upgrade = true;  // 确认正在给假节点转正
-      } else {
-        // 真的是被别的业务注册过了，抛出异常，防止多个组件竞态注册同一配置项
-        throw std::logic_error(
-            "Duplicated configuration registration for path: " + path);
-      }
-    } else {
-      // 全新节点，直接插入拓扑树
-      target_entry = std::make_shared<ConfigEntry>();
-      config_dict_[path] = target_entry;
+      is_phantom_upgrade = CheckReRegistration(*target_entry, path, default_val);
     }
+  }
 
-    // 在安全区内从“未定型数据池”认领数据
+  {
+    // 独占孤儿锁：在安全区内从“未定型数据池”认领数据
+    std::unique_lock<std::shared_mutex> cache_lock(cache_mutex_);
     auto cache_it = initial_load_cache_.find(path);
     if (cache_it != initial_load_cache_.end()) {
-      cached_json = cache_it->second;  // 将 JSON 数据深拷贝出来
-      has_cache = true;
+      // 易失参数不认领旧值，但同样擦除，下一次落盘时旧值随之从文件中消失
+      if (!meta.is_volatile) {
+        cached_json = std::move(cache_it->second);  // 移出 JSON 数据，随即擦除
+        has_cache = true;
+      }
       initial_load_cache_.erase(cache_it);  // 清理内存
+    } else if (!meta.is_volatile) {
+      // JSON 缓存 (含变更日志) 中没有时，再查二进制快照，免去 JSON 解析
+      has_binary = binary_snapshot_.Find(path, default_val, binary_val);
     }
-  }  // <--- 全局字典锁 dict_lock 在此释放，后续操作不再阻塞其他插件的注册或查询
+  }  // <--- 孤儿锁在此释放，后续操作不再阻塞其他插件的注册或查询
 
   // [第二阶段] 节点装配与回填区。
-  std::vector<std::function<void(const ConfigValue&)>> callbacks_to_notify;
+  std::shared_ptr<const ConfigSubscriberList> subscribers_to_notify;
   ConfigValue initial_actual_val = default_val;
+  // 在节点锁外完成驻留：相同的 Schema 共用一条只读记录
+  ConfigSchemaStore::Interned interned = schema_store_.Intern(meta);
 
   {
     // 节点级写锁：只保护当前这一个节点的读写，极大提升了并发性能
     std::unique_lock<std::shared_mutex> entry_lock(target_entry->entry_mutex);
 
-    target_entry->meta = meta;
-    target_entry->default_value = default_val;
+    target_entry->meta = std::move(interned.meta);
+    target_entry->check = std::move(interned.check);
+    target_entry->default_value = ConfigValueCell(default_val);
 
-    if (has_cache) {
-      ConfigValue parsed_val;
+    if (has_cache || has_binary) {
+      ConfigValue parsed_val = binary_val;
       // 利用刚确立的 default_val 做基准进行类型反演
-      if (JsonToConfigValue(cached_json, default_val, parsed_val)) {
+      if (has_binary || JsonToConfigValue(cached_json, default_val, parsed_val)) {
         std::string err;
         // 关键安全门：防止外来不合法旧数据污染刚创立的完美节点
-        if (ValidateInternal(*target_entry, parsed_val, "System_Init", err)) {
+        if (ValidateInternal(*target_entry, parsed_val, kInitRole, err)) {
           initial_actual_val = parsed_val;
         } else {
           std::cerr << "[Config Warn] Path [" << path
@@ -212,21 +384,26 @@ void ConfigProviderService::RegisterSchema(const std::string& path,
       }
     }
 
-    target_entry->current_value = initial_actual_val;
+    target_entry->current_value = ConfigValueCell(initial_actual_val);
+    target_entry->monitor =
+        meta.is_monitor ? std::make_shared<ConfigMonitorCell>(initial_actual_val) : nullptr;
+    if (!target_entry->monitor) shared_view_.Store(path, initial_actual_val);
 
     // 【极其重要】：如果在你注册之前，已经有苦等数据的订阅者了。
     // 转正后必须立刻把他们的回调装进火箭准备发射，告诉他们初始值已到账！
     if (is_phantom_upgrade) {
-      for (const auto& pair : target_entry->callbacks) {
-        callbacks_to_notify.push_back(pair.second);
-      }
+      subscribers_to_notify = target_entry->subscribers;  // COW：只复制一个 shared_ptr
     }
   }  // <--- 节点级写锁 entry_lock 在此释放
 
+  // 节点装配完成后登记分组索引，UI 的分组查询从此只需遍历本组
+  group_index_.Add(meta.group_key, meta.subgroup_key, meta.is_hidden, meta.is_advanced,
+                   path, target_entry);
+
   // [第三阶段] 无锁化回调派发区。
   // 不要在锁里调用未知业务 Lambda！它可能在里面又调用了一次 GetValue
   // 导致同一把锁死锁重入。
-  if (!callbacks_to_notify.empty()) {
+  if (subscribers_to_notify && !subscribers_to_notify->empty()) {
     if (g_recursion_depth == 0) {
       g_has_cyclic_error = false;
     }
@@ -237,9 +414,9 @@ void ConfigProviderService::RegisterSchema(const std::string& path,
     }
     
     RecursionGuard guard;
-    for (const auto& cb : callbacks_to_notify) {
+    for (const auto& sub : *subscribers_to_notify) {
       try {
-        cb(initial_actual_val);
+        sub->Deliver(initial_actual_val, notify_executor_);
       } catch (...) {
         // 隔离业务端故障，保证核心模块不随之崩溃
       }
@@ -251,74 +428,307 @@ void ConfigProviderService::RegisterSchema(const std::string& path,
   }
 }
 
-ConfigValue ConfigProviderService::GetValue(const std::string& path) const {
-  std::shared_ptr<ConfigEntry> entry;
+std::vector<uint64_t> ConfigProviderService::RegisterSchemas(
+    std::vector<SchemaRegistration>& items) {
+  std::vector<uint64_t> ids(items.size(), 0);
+  if (items.empty()) return ids;
+
+  // [第零阶段] 先查冲突：任何一项不合法都在插入节点之前抛出，本批不留痕迹
   {
-    // 对字典只采用共享读锁，百万次读取也不会降低系统性能。
-    std::shared_lock<std::shared_mutex> dict_lock(dict_mutex_);
-    auto it = config_dict_.find(path);
-    if (it == config_dict_.end()) return ConfigValue{};
-    entry = it->second;
+    std::unordered_set<std::string_view> seen;
+    seen.reserve(items.size());
+    for (const SchemaRegistration& item : items) {
+      if (!seen.insert(item.path).second) {
+        throw std::logic_error("Duplicated configuration registration for path: " +
+                               item.path);
+      }
+      CheckMonitorType(item.meta, item.path, item.default_value);
+      if (item.callback && item.delivery_type == ConnectionType::kDirect &&
+          item.delivery_executor) {
+        throw std::invalid_argument(
+            "Config subscriptions with an executor must be kQueued or kQueuedCoalesced: " +
+            item.path);
+      }
+      if (const auto existing = config_dict_.Find(item.path)) {
+        CheckReRegistration(*existing, item.path, item.default_value);
+      }
+    }
+  }
+
+  // 每一项在各阶段之间传递的中间状态
+  struct Pending {
+    std::shared_ptr<ConfigEntry> entry;
+    bool is_phantom_upgrade = false;
+    nlohmann::json cached_json;
+    bool has_cache = false;
+    ConfigValue binary_val;
+    bool has_binary = false;
+    ConfigSchemaStore::Interned interned;
+    ConfigValue initial_actual_val;
+    std::shared_ptr<const ConfigSubscriberList> subscribers_to_notify;
+  };
+  std::vector<Pending> pending(items.size());
+
+  // [第一阶段] 每个涉及的分片只取一次独占锁，整批插入节点
+  {
+    std::vector<const std::string*> paths;
+    paths.reserve(items.size());
+    for (const SchemaRegistration& item : items) paths.push_back(&item.path);
+    std::vector<std::shared_ptr<ConfigEntry>> entries;
+    std::vector<char> inserted;
+    config_dict_.FindOrInsertMany(paths, entries, inserted);
+    for (size_t i = 0; i < items.size(); ++i) {
+      pending[i].entry = std::move(entries[i]);
+      if (!inserted[i]) {
+        // 只剩第零阶段之后并发注册的竞态，或本就是占位节点
+        pending[i].is_phantom_upgrade =
+            CheckReRegistration(*pending[i].entry, items[i].path, items[i].default_value);
+      }
+    }
+  }
+
+  // [第二阶段] 一次独占孤儿锁，整批认领 (JSON 移出而不是复制)
+  {
+    std::unique_lock<std::shared_mutex> cache_lock(cache_mutex_);
+    for (size_t i = 0; i < items.size(); ++i) {
+      auto cache_it = initial_load_cache_.find(items[i].path);
+      if (cache_it != initial_load_cache_.end()) {
+        if (!items[i].meta.is_volatile) {
+          pending[i].cached_json = std::move(cache_it->second);
+          pending[i].has_cache = true;
+        }
+        initial_load_cache_.erase(cache_it);
+      } else if (!items[i].meta.is_volatile) {
+        pending[i].has_binary = binary_snapshot_.Find(items[i].path, items[i].default_value,
+                                                      pending[i].binary_val);
+      }
+    }
+  }
+
+  // [第三阶段] 锁外驻留 Schema、类型反演与校验；项数较多时分给多个线程
+  auto prepare = [this, &items, &pending](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      const SchemaRegistration& item = items[i];
+      Pending& p = pending[i];
+      p.interned = schema_store_.Intern(item.meta);
+      p.initial_actual_val = item.default_value;
+      if (!p.has_cache && !p.has_binary) continue;
+      ConfigValue parsed_val = std::move(p.binary_val);
+      if (p.has_binary || JsonToConfigValue(p.cached_json, item.default_value, parsed_val)) {
+        std::string err;
+        bool valid = false;
+        try {
+          // 从磁盘认领旧值时不按枚举字典校验 (与 ValidateInternal 的 kInitRole 分支一致)
+          valid = p.interned.check->Validate(parsed_val, item.default_value.index(),
+                                             kInitRole, false, err);
+        } catch (const std::exception& e) {
+          err = e.what();
+        } catch (...) {
+          err = "custom validator threw";
+        }
+        if (valid) {
+          p.initial_actual_val = std::move(parsed_val);
+        } else {
+          std::cerr << "[Config Warn] Path [" << item.path
+                    << "] invalid value in file(" << err
+                    << "), falling back to default." << std::endl;
+        }
+      }
+      nlohmann::json().swap(p.cached_json);
+    }
+  };
+  const size_t hardware = std::max(1u, std::thread::hardware_concurrency());
+  const size_t thread_count =
+      items.size() < kParallelClaimThreshold
+          ? 1
+          : std::min(hardware, items.size() / (kParallelClaimThreshold / 2));
+  if (thread_count <= 1) {
+    prepare(0, items.size());
+  } else {
+    const size_t chunk = (items.size() + thread_count - 1) / thread_count;
+    std::vector<std::thread> workers;
+    workers.reserve(thread_count - 1);
+    for (size_t t = 1; t < thread_count; ++t) {
+      const size_t begin = std::min(items.size(), t * chunk);
+      const size_t end = std::min(items.size(), begin + chunk);
+      workers.emplace_back(prepare, begin, end);
+    }
+    prepare(0, std::min(items.size(), chunk));  // 调用线程处理第一段
+    for (std::thread& worker : workers) worker.join();
   }
 
+  // [第四阶段] 逐节点装配 (节点锁互不相关，无需整体加锁)
+  std::vector<ConfigGroupIndex<ConfigEntry>::Item> index_items;
+  index_items.reserve(items.size());
+  for (size_t i = 0; i < items.size(); ++i) {
+    SchemaRegistration& item = items[i];
+    Pending& p = pending[i];
+    {
+      std::unique_lock<std::shared_mutex> entry_lock(p.entry->entry_mutex);
+      p.entry->meta = std::move(p.interned.meta);
+      p.entry->check = std::move(p.interned.check);
+      p.entry->default_value = ConfigValueCell(item.default_value);
+      p.entry->current_value = ConfigValueCell(p.initial_actual_val);
+      p.entry->monitor = item.meta.is_monitor
+                             ? std::make_shared<ConfigMonitorCell>(p.initial_actual_val)
+                             : nullptr;
+      if (!p.entry->monitor) shared_view_.Store(item.path, p.initial_actual_val);
+      if (p.is_phantom_upgrade) p.subscribers_to_notify = p.entry->subscribers;
+    }
+    index_items.push_back({&item.meta.group_key, &item.meta.subgroup_key,
+                           item.meta.is_hidden, item.meta.is_advanced, &item.path,
+                           p.entry});
+  }
+  group_index_.AddMany(index_items);
+
+  // [第五阶段] 无锁化回调派发区：先通知苦等的占位订阅者，再逐项回填并订阅 (与 Bind 顺序一致)
+  for (const Pending& p : pending) {
+    if (!p.subscribers_to_notify || p.subscribers_to_notify->empty()) continue;
+    if (g_recursion_depth == 0) {
+      g_has_cyclic_error = false;
+    }
+    if (g_recursion_depth > 5) {
+      std::cerr << "[Config Error] Maximum recursion depth exceeded during RegisterSchemas."
+                << std::endl;
+      g_has_cyclic_error = true;
+      break;
+    }
+    RecursionGuard guard;
+    for (const auto& sub : *p.subscribers_to_notify) {
+      try {
+        sub->Deliver(p.initial_actual_val, notify_executor_);
+      } catch (...) {
+        // 隔离业务端故障，保证核心模块不随之崩溃
+      }
+    }
+  }
+
+  size_t i = 0;
+  try {
+    for (; i < items.size(); ++i) {
+      SchemaRegistration& item = items[i];
+      if (!item.callback) continue;
+      item.callback(GetValue(item.path));
+      ids[i] = InternalSubscribeWithDelivery(item.path, std::move(item.callback),
+                                             item.delivery_type,
+                                             std::move(item.delivery_executor));
+    }
+  } catch (...) {
+    // 与 Bind 一样让回调的异常传给调用方；本批已建立的订阅没有句柄可以退订，先行撤销
+    for (size_t j = 0; j < i; ++j) {
+      if (ids[j] != 0) InternalUnsubscribe(items[j].path, ids[j]);
+    }
+    throw;
+  }
+  return ids;
+}
+
+ConfigValue ConfigProviderService::GetValue(const std::string& path) const {
+  // 只对 path 所在分片加共享读锁，不同路径的读取互不干扰。
+  const std::shared_ptr<ConfigEntry> entry = config_dict_.Find(path);
+  if (!entry) return ConfigValue{};
+
   // 对节点同样采用共享读锁
   std::shared_lock<std::shared_mutex> entry_lock(entry->entry_mutex);
-  return entry->current_value;
+  return entry->LiveValue();
+}
+
+std::shared_ptr<const ConfigValue> ConfigProviderService::GetValueShared(
+    const std::string& path) const {
+  const std::shared_ptr<ConfigEntry> entry = config_dict_.Find(path);
+  if (!entry) return nullptr;
+
+  // 锁内只增加堆块的引用计数，之后 SetValue 换上新堆块也不影响读者手里的这一份
+  std::shared_lock<std::shared_mutex> entry_lock(entry->entry_mutex);
+  if (entry->monitor) return std::make_shared<const ConfigValue>(entry->monitor->Load());
+  return entry->current_value.Share();
+}
+
+std::shared_ptr<ConfigMonitorCell> ConfigProviderService::GetMonitorCell(
+    const std::string& path) const {
+  const std::shared_ptr<ConfigEntry> entry = config_dict_.Find(path);
+  if (!entry) return nullptr;
+  std::shared_lock<std::shared_mutex> entry_lock(entry->entry_mutex);
+  return entry->monitor;
 }
 
 uint64_t ConfigProviderService::InternalSubscribe(
     const std::string& path, std::function<void(const ConfigValue&)> cb) {
-  std::shared_ptr<ConfigEntry> entry;
-  {
-    // 这里必须是独占锁，因为可能面临目标未注册需要插入“占位节点”的情况
-    std::unique_lock<std::shared_mutex> dict_lock(dict_mutex_);
-    auto it = config_dict_.find(path);
-    if (it == config_dict_.end()) {
-      // 【核心方案】：如果是订阅者先到，创建一个“占位节点”
-      entry = std::make_shared<ConfigEntry>();
-      // 默认的 ConfigEntry.default_value 就是 monostate 空白。
-      config_dict_[path] = entry;
-    } else {
-      entry = it->second;
-    }
+  return InternalSubscribeWithDelivery(path, std::move(cb), ConnectionType::kDirect,
+                                       nullptr);
+}
+
+uint64_t ConfigProviderService::InternalSubscribeWithDelivery(
+    const std::string& path, std::function<void(const ConfigValue&)> cb,
+    ConnectionType type, std::shared_ptr<IEventExecutor> executor) {
+  if (type == ConnectionType::kDirect && executor) {
+    throw std::invalid_argument(
+        "Config subscriptions with an executor must be kQueued or kQueuedCoalesced: " +
+        path);
   }
 
+  // 【核心方案】：如果是订阅者先到，创建一个“占位节点”。
+  // 默认的 ConfigEntry.default_value 就是 monostate 空白。
+  // 节点已存在时只需分片共享锁；插入占位节点也只独占这一个分片。
+  bool inserted = false;
+  const std::shared_ptr<ConfigEntry> entry = config_dict_.FindOrInsert(path, inserted);
+
   uint64_t id = next_cb_id_.fetch_add(1);
+  auto sub = std::make_shared<ConfigSubscription>(id, std::move(cb), type,
+                                                  std::move(executor));
   std::unique_lock<std::shared_mutex> entry_lock(entry->entry_mutex);
-  entry->callbacks[id] = std::move(cb);
+  // 写时复制：正在派发的线程手里仍是旧列表
+  auto list = entry->subscribers
+                  ? std::make_shared<ConfigSubscriberList>(*entry->subscribers)
+                  : std::make_shared<ConfigSubscriberList>();
+  list->push_back(std::move(sub));
+  entry->subscribers = std::move(list);
   return id;
 }
 
 void ConfigProviderService::InternalUnsubscribe(const std::string& path,
                                                 uint64_t cb_id) {
-  std::shared_ptr<ConfigEntry> entry;
-  {
-    std::shared_lock<std::shared_mutex> dict_lock(dict_mutex_);
-    auto it = config_dict_.find(path);
-    if (it == config_dict_.end()) return;
-    entry = it->second;
-  }
+  const std::shared_ptr<ConfigEntry> entry = config_dict_.Find(path);
+  if (!entry) return;
 
   std::unique_lock<std::shared_mutex> entry_lock(entry->entry_mutex);
-  entry->callbacks.erase(cb_id);
+  if (!entry->subscribers) return;
+  auto list = std::make_shared<ConfigSubscriberList>();
+  list->reserve(entry->subscribers->size());
+  for (const auto& sub : *entry->subscribers) {
+    if (sub->id() == cb_id) {
+      sub->Deactivate();  // 已排队但尚未执行的投递随之作废
+    } else {
+      list->push_back(sub);
+    }
+  }
+  entry->subscribers = std::move(list);
 }
 
 bool ConfigProviderService::SetValue(const std::string& path,
                                      const ConfigValue& new_val,
                                      const std::string& operator_role) {
-  std::shared_ptr<ConfigEntry> entry;
+  const std::shared_ptr<ConfigEntry> entry = config_dict_.Find(path);
+  if (!entry) return false;
+
+  std::shared_ptr<const ConfigSubscriberList> subscribers;
+  std::shared_ptr<const ConfigValue> validated_val;
+
   {
-    std::shared_lock<std::shared_mutex> dict_lock(dict_mutex_);
-    auto it = config_dict_.find(path);
-    if (it == config_dict_.end()) return false;
-    entry = it->second;
+    // 监视参数：校验后直接存入无锁单元，不取写锁、不通知、不审计、不落盘
+    std::shared_lock<std::shared_mutex> entry_lock(entry->entry_mutex);
+    if (entry->monitor) {
+      std::string err;
+      if (!ValidateInternal(*entry, new_val, operator_role, err)) return false;
+      entry->monitor->PublishValue(new_val);
+      return true;
+    }
   }
 
-  std::vector<std::function<void(const ConfigValue&)>> callbacks_to_run;
-  ConfigValue validated_val;
-
   bool value_changed = false;
+  bool persistent = true;
   ConfigChangedEvent audit_evt;
+  const PluginPtr<z3y::IEventBus> audit_bus = AuditBus();
 
   {
     // 在节点修改层面采用独占写锁
@@ -330,31 +740,35 @@ bool ConfigProviderService::SetValue(const std::string& path,
     }
 
     // 数值发生实质性改变时，才产生更新动作，屏蔽无意义的刷新
-    if (entry->current_value.index() == new_val.index() &&
-        entry->current_value == new_val) {
+    if (entry->current_value == new_val) {
       return true;
     }
 
-    // 【新增】：在更新前，收集安全锁内的审计数据
-    audit_evt.path = path;
-    audit_evt.old_value = ConfigValueToString(entry->current_value);
-    audit_evt.new_value = ConfigValueToString(new_val);
-    audit_evt.operator_role =
-        operator_role.empty() ? "System_API" : operator_role;
-    audit_evt.timestamp_ms = GetCurrentTimestampMs();
+    // 只拷贝一次进新堆块，派发、历史与日志共享同一份 (大数组不再复制第二遍)
+    ConfigValueCell new_cell(new_val);
+    const std::string role = operator_role.empty() ? "System_API" : operator_role;
+    const uint64_t timestamp_ms =
+        (audit_bus || history_.enabled()) ? GetCurrentTimestampMs() : 0;
+    // 【新增】：在更新前，收集安全锁内的审计数据 (没有订阅者时跳过)
+    if (audit_bus) {
+      audit_evt = MakeChangedEvent(path, entry->current_value.ToValue(), new_val, role,
+                                   timestamp_ms);
+    }
+    persistent = entry->IsPersistent();
+    if (persistent && history_.enabled()) {
+      history_.Append({path, entry->current_value, new_cell}, role, timestamp_ms);
+    }
     value_changed = true;
 
-    entry->current_value = new_val;
-    validated_val = new_val;
+    entry->current_value = std::move(new_cell);
+    validated_val = entry->current_value.Share();
+    shared_view_.Store(path, *validated_val);
 
-    callbacks_to_run.reserve(entry->callbacks.size());
-    for (const auto& pair : entry->callbacks) {
-      callbacks_to_run.push_back(pair.second);
-    }
+    subscribers = entry->subscribers;  // COW：锁内只复制一个 shared_ptr
   }
 
   // 【安全墙：循环递归死锁保护】
-  if (!callbacks_to_run.empty()) {
+  if (subscribers && !subscribers->empty()) {
     if (g_recursion_depth == 0) {
       g_has_cyclic_error = false;
     }
@@ -367,9 +781,9 @@ bool ConfigProviderService::SetValue(const std::string& path,
     }
 
     RecursionGuard guard;
-    for (const auto& cb : callbacks_to_run) {
+    for (const auto& sub : *subscribers) {
       try {
-        cb(validated_val);
+        sub->Deliver(*validated_val, notify_executor_);
       } catch (const std::exception& e) {
         // 防止某个不讲武德的插件在回调里抛出异常，把整个配置服务搞崩
         std::cerr
@@ -389,61 +803,125 @@ bool ConfigProviderService::SetValue(const std::string& path,
 
   // 无锁广播审计事件！
   if (value_changed) {
-    z3y::FireGlobalEvent<ConfigChangedEvent>(audit_evt);
-    AsyncSaveSnapshot();
+    if (audit_bus) audit_bus->FireGlobal<ConfigChangedEvent>(std::move(audit_evt));
+    if (persistent) AsyncAppendJournal({{path, *validated_val}});
   }
   return true;
 }
 
+std::future<bool> ConfigProviderService::SetValueAsync(const std::string& path,
+                                                     ConfigValue value,
+                                                     const std::string& operator_role) {
+  auto write = std::make_unique<AsyncWrite>();
+  write->path = path;
+  write->value = std::move(value);
+  write->operator_role = operator_role;
+  std::future<bool> result = write->done.get_future();
+  if (async_stopped_.load(std::memory_order_acquire)) {
+    write->done.set_value(false);
+    return result;
+  }
+
+  // 压栈 (Treiber)：排空一次取走整个栈，不存在单个节点出栈的 ABA 问题
+  AsyncWrite* node = write.release();
+  node->next = async_head_.load(std::memory_order_relaxed);
+  while (!async_head_.compare_exchange_weak(node->next, node, std::memory_order_release,
+                                            std::memory_order_relaxed)) {
+  }
+  // 只有第一个写入者投递排空任务，其余写入只压栈
+  if (!async_scheduled_.exchange(true, std::memory_order_acq_rel)) {
+    async_writer_.Post([this] { DrainAsyncWrites(); });
+  }
+  return result;
+}
+
+std::vector<std::unique_ptr<ConfigProviderService::AsyncWrite>>
+ConfigProviderService::TakeAsyncWrites() {
+  std::vector<std::unique_ptr<AsyncWrite>> writes;
+  for (AsyncWrite* node = async_head_.exchange(nullptr, std::memory_order_acquire); node;) {
+    AsyncWrite* next = node->next;
+    writes.emplace_back(node);
+    node = next;
+  }
+  std::reverse(writes.begin(), writes.end());
+  return writes;
+}
+
+void ConfigProviderService::DrainAsyncWrites() {
+  std::lock_guard<std::mutex> drain_lock(async_drain_mutex_);
+  // 先清除投递标记再取栈：此后压栈的写入会投递新的排空，不会滞留
+  async_scheduled_.store(false, std::memory_order_release);
+  std::vector<std::unique_ptr<AsyncWrite>> writes = TakeAsyncWrites();
+  if (writes.empty()) return;
+
+  std::unordered_map<std::string_view, size_t> last_of_path;
+  last_of_path.reserve(writes.size());
+  for (size_t i = 0; i < writes.size(); ++i) last_of_path[writes[i]->path] = i;
+
+  std::vector<char> applied(writes.size(), 0);
+  for (size_t i = 0; i < writes.size(); ++i) {
+    const AsyncWrite& write = *writes[i];
+    if (last_of_path[write.path] != i) continue;  // 之后还有同一路径的写入，本次被合并
+    try {
+      applied[i] = SetValue(write.path, write.value, write.operator_role) ? 1 : 0;
+    } catch (...) {
+      applied[i] = 0;
+    }
+  }
+  for (const auto& write : writes) {
+    write->done.set_value(applied[last_of_path[write->path]] != 0);
+  }
+}
+
 std::vector<std::string> ConfigProviderService::ApplyBatch(
     const std::map<std::string, ConfigValue>& changes,
     const std::string& operator_role) {
+  std::vector<ConfigChange> flat;
+  flat.reserve(changes.size());
+  for (const auto& kv : changes) flat.push_back({kv.first, kv.second});
+  return ApplyChanges(flat, operator_role);
+}
+
+std::vector<std::string> ConfigProviderService::ApplyChanges(
+    const std::vector<ConfigChange>& changes, const std::string& operator_role) {
   std::vector<std::string> errors;
 
+  // 只保存 changes 中元素的下标，不复制路径与值
   struct LockPair {
     std::shared_ptr<ConfigEntry> entry;
-    std::string path;
-    ConfigValue new_val;
+    size_t index;
   };
   std::vector<LockPair> pairs;
+  pairs.reserve(changes.size());
 
-  {
-    std::shared_lock<std::shared_mutex> dict_lock(dict_mutex_);
-    for (const auto& kv : changes) {
-      auto it = config_dict_.find(kv.first);
-      if (it == config_dict_.end()) {
-        errors.push_back("Path does not exist:" + kv.first);
-        return errors;  // 严格事务拦截：若有一个路径不对，整个事务必须无条件流产截断
-      }
-      pairs.push_back({it->second, kv.first, kv.second});
+  for (size_t i = 0; i < changes.size(); ++i) {
+    auto entry = config_dict_.Find(changes[i].path);
+    if (!entry) {
+      errors.push_back("Path does not exist:" + changes[i].path);
+      return errors;  // 严格事务拦截：若有一个路径不对，整个事务必须无条件流产截断
     }
+    pairs.push_back({std::move(entry), i});
   }
 
   // 【极其硬核的防止交叉死锁机制】
   // 对需要同时加锁的互斥量内存地址强行排序，保证获取锁的顺序绝对单向一致。
+  // 同一节点按输入顺序相邻，只保留最后一项 (同一把锁不能加两次)。
   std::sort(pairs.begin(), pairs.end(),
             [](const LockPair& a, const LockPair& b) {
-              return a.entry.get() < b.entry.get();
+              return a.entry.get() != b.entry.get() ? a.entry.get() < b.entry.get()
+                                                    : a.index < b.index;
             });
-
-  // RAII 批量加锁门神
-  struct BatchLockGuard {
-    std::vector<LockPair>& p_ref;
-    BatchLockGuard(std::vector<LockPair>& p) : p_ref(p) {
-      for (auto& item : p_ref) item.entry->entry_mutex.lock();
-    }
-    ~BatchLockGuard() {
-      for (auto& item : p_ref) item.entry->entry_mutex.unlock();
-    }
-  };
+  auto last_of_each = std::unique(pairs.rbegin(), pairs.rend(),
+                                  [](const LockPair& a, const LockPair& b) {
+                                    return a.entry.get() == b.entry.get();
+                                  });
+  pairs.erase(pairs.begin(), last_of_each.base());
 
   // 准备审计事件和回调的容器（存放在锁外）
   std::vector<ConfigChangedEvent> audit_events;
-  struct PendingCb {
-    const std::function<void(const ConfigValue&)>* cb;
-    ConfigValue val;
-  };
-  std::vector<PendingCb> batch_callbacks;
+  std::vector<PendingNotification> batch_callbacks;
+  std::vector<ConfigChange> journal_changes;
+  const PluginPtr<z3y::IEventBus> audit_bus = AuditBus();
 
   {
     // ================= [绝对安全的事务锁内区域] =================
@@ -451,9 +929,10 @@ std::vector<std::string> ConfigProviderService::ApplyBatch(
 
     // 1. 在批量锁定状态下执行统一校验
     for (const auto& p : pairs) {
+      const ConfigChange& change = changes[p.index];
       std::string err;
-      if (!ValidateInternal(*(p.entry), p.new_val, operator_role, err)) {
-        errors.push_back("Validation failed for parameter [" + p.path +
+      if (!ValidateInternal(*(p.entry), change.value, operator_role, err)) {
+        errors.push_back("Validation failed for parameter [" + change.path +
                          "]: " + err);
       }
     }
@@ -461,25 +940,49 @@ std::vector<std::string> ConfigProviderService::ApplyBatch(
       return errors;  // 校验哪怕错一个，直接 return（guard 自动解锁）
 
     // 2. 校验全通：原子赋值、生成审计事件、收集回调
+    // 同一事务共用一个时间戳与角色
+    const uint64_t timestamp_ms = GetCurrentTimestampMs();
+    const std::string role = operator_role.empty() ? "System" : operator_role;
+    std::vector<ConfigChangeHistory::Change> history_changes;
     for (auto& p : pairs) {
-      if (p.entry->current_value != p.new_val) {
-        ConfigChangedEvent audit_evt;
-        audit_evt.path = p.path;
-        audit_evt.old_value = ConfigValueToString(p.entry->current_value);
-        audit_evt.new_value = ConfigValueToString(p.new_val);
-        audit_evt.operator_role =
-            operator_role.empty() ? "System" : operator_role;
-        audit_evt.timestamp_ms = GetCurrentTimestampMs();
-        audit_events.push_back(audit_evt);
-
-        p.entry->current_value = p.new_val;
-        for (const auto& cb_pair : p.entry->callbacks) {
-          batch_callbacks.push_back({&cb_pair.second, p.new_val});
+      const ConfigChange& change = changes[p.index];
+      if (p.entry->current_value != change.value) {
+        if (audit_bus) {
+          audit_events.push_back(MakeChangedEvent(change.path, p.entry->current_value.ToValue(),
+                                                  change.value, role, timestamp_ms));
+        }
+
+        ConfigValueCell new_cell(change.value);
+        const bool persistent = p.entry->IsPersistent();
+        if (persistent && history_.enabled()) {
+          history_changes.push_back({change.path, p.entry->current_value, new_cell});
+        }
+        p.entry->current_value = std::move(new_cell);
+        shared_view_.Store(change.path, change.value);
+        if (persistent) journal_changes.push_back(change);
+        if (p.entry->subscribers && !p.entry->subscribers->empty()) {
+          batch_callbacks.push_back({p.entry->subscribers, change.value});
         }
       }
     }
+    // 整个事务一次追加，序号连续
+    history_.Append(history_changes.data(), history_changes.size(), role, timestamp_ms);
   }  // <--- guard 在这里超出作用域析构，所有的节点锁被安全释放！
 
+  return PublishCommitted(batch_callbacks, audit_bus, audit_events, journal_changes);
+}
+
+PluginPtr<z3y::IEventBus> ConfigProviderService::AuditBus() const {
+  PluginPtr<z3y::IEventBus> bus = event_bus_.lock();
+  if (!bus || !bus->IsGlobalSubscribed(ConfigChangedEvent::kEventId)) return nullptr;
+  return bus;
+}
+
+std::vector<std::string> ConfigProviderService::PublishCommitted(
+    const std::vector<PendingNotification>& batch_callbacks,
+    const PluginPtr<z3y::IEventBus>& audit_bus,
+    const std::vector<ConfigChangedEvent>& audit_events,
+    const std::vector<ConfigChange>& journal_changes) {
   // 【全局死循环防爆栈保护】
   if (!batch_callbacks.empty()) {
     if (g_recursion_depth == 0) {
@@ -498,10 +1001,12 @@ std::vector<std::string> ConfigProviderService::ApplyBatch(
 
     // 1. 触发所有收集到的回调任务
     for (const auto& task : batch_callbacks) {
-      try {
-        (*(task.cb))(task.val);
-      } catch (...) {
-        // 隔离业务端抛出的异常
+      for (const auto& sub : *task.subscribers) {
+        try {
+          sub->Deliver(task.value, notify_executor_);
+        } catch (...) {
+          // 隔离业务端抛出的异常
+        }
       }
     }
 
@@ -510,36 +1015,37 @@ std::vector<std::string> ConfigProviderService::ApplyBatch(
     }
   }
 
-  // 2. 无锁广播审计事件
-  if (!audit_events.empty()) {
-    for (const auto& evt : audit_events) {
-      z3y::FireGlobalEvent<ConfigChangedEvent>(evt);
-    }
+  // 2. 无锁广播审计事件：整个事务一次发布
+  if (audit_bus && !audit_events.empty()) {
+    audit_bus->FireGlobalBatch(audit_events);
   }
 
-  // 3. 异步落盘
-  if (!batch_callbacks.empty()) {
+  // 3. 异步落盘 (只追加本次事务实际改变的节点)
+  // 大批量修改 (配方切换) 直接压实为一次完整快照，不再逐项写日志。
+  if (journal_changes.size() >= kSnapshotBatchThreshold) {
     AsyncSaveSnapshot();
+  } else if (!journal_changes.empty()) {
+    AsyncAppendJournal(journal_changes);
   }
 
-  return errors;
+  return {};
 }
 
 bool ConfigProviderService::UpdateEnumSchema(const std::string& path, 
                                              const std::vector<std::string>& new_values, 
                                              const std::vector<std::string>& new_display_keys) {
-  std::shared_ptr<ConfigEntry> target_entry;
-  {
-    std::shared_lock<std::shared_mutex> dict_lock(dict_mutex_);
-    auto it = config_dict_.find(path);
-    if (it == config_dict_.end()) return false;
-    target_entry = it->second;
-  }
+  const std::shared_ptr<ConfigEntry> target_entry = config_dict_.Find(path);
+  if (!target_entry) return false;
   {
     std::unique_lock<std::shared_mutex> entry_lock(target_entry->entry_mutex);
-    target_entry->meta.enum_values = new_values;
-    target_entry->meta.enum_display_keys = new_display_keys;
-    target_entry->meta.widget_type = z3y::interfaces::core::WidgetType::kComboBox;
+    // Schema 记录可能被其它节点共享：复制一份修改后重新驻留，只替换本节点的指针
+    SchemaMetadata updated = *target_entry->meta;
+    updated.enum_values = new_values;
+    updated.enum_display_keys = new_display_keys;
+    updated.widget_type = z3y::interfaces::core::WidgetType::kComboBox;
+    ConfigSchemaStore::Interned interned = schema_store_.Intern(updated);
+    target_entry->meta = std::move(interned.meta);
+    target_entry->check = std::move(interned.check);
   }
   return true;
 }
@@ -547,42 +1053,78 @@ bool ConfigProviderService::UpdateEnumSchema(const std::string& path,
 std::map<std::string, ConfigSnapshot> ConfigProviderService::GetAllConfigs()
     const {
   std::map<std::string, ConfigSnapshot> result;
-  // 仅需对全局字典加一次读锁
-  std::shared_lock<std::shared_mutex> dict_lock(dict_mutex_);
-  for (const auto& kv : config_dict_) {
+  // 逐分片加读锁遍历
+  config_dict_.ForEach([&result](const std::string& path,
+                                 const std::shared_ptr<ConfigEntry>& entry) {
     // 必须用读锁逐个读取，虽然是快照也不能容忍半脏数据
-    std::shared_lock<std::shared_mutex> entry_lock(kv.second->entry_mutex);
-    if (!kv.second->meta
-             .is_hidden) {  // 【核心过滤】将隐藏参数拒之于 UI 显示之外
-      result[kv.first] = {kv.second->meta, kv.second->current_value};
+    std::shared_lock<std::shared_mutex> entry_lock(entry->entry_mutex);
+    if (!entry->meta->is_hidden) {  // 【核心过滤】将隐藏参数拒之于 UI 显示之外
+      result[path] = {*entry->meta, entry->LiveValue()};
     }
-  }
+  });
   return result;
 }
 
 void ConfigProviderService::SetStoragePath(const std::string& absolute_path) {
-  // 夺取最高权限防止重定向并发异常
-  std::unique_lock<std::shared_mutex> dict_lock(dict_mutex_);
+  {
+    // 夺取最高权限防止重定向并发异常
+    std::unique_lock<std::shared_mutex> cache_lock(cache_mutex_);
+
+    config_file_path_ = absolute_path;
+    config_tmp_path_ = absolute_path + ".tmp";
+    config_journal_path_ = absolute_path + ".journal";
+    config_binary_path_ = absolute_path + ".bin";
 
-  config_file_path_ = absolute_path;
-  config_tmp_path_ = absolute_path + ".tmp";
+    // 路径改变后，立即触发一次读取
+    LoadFromFile();
+  }
 
-  // 路径改变后，立即触发一次读取
-  LoadFromFile();
+  // 监视跟随新路径 (必须在释放 cache_mutex_ 之后：监视线程处理事件时也要取它)
+  std::lock_guard<std::mutex> control_lock(watch_control_mutex_);
+  if (file_watch_enabled_.load()) StartFileWatch_UNLOCKED();
 }
 
 void ConfigProviderService::LoadFromFile() {
   // 【新增：启动时读取 config.json】
-  std::ifstream ifs(config_file_path_);
-  if (ifs.is_open()) {
-    try {
-      nlohmann::json root;
-      ifs >> root;
-      // 存入临时缓存，等待各模块注册时认领
-      for (auto& el : root.items()) {
-        initial_load_cache_[el.key()] = el.value();  // 全量搬入未定型缓存池
+  // 二进制快照与 JSON 同源：注册时直接从它取值，不必解析 JSON
+  if (!binary_snapshot_.Load(config_binary_path_, config_file_path_)) {
+    std::ifstream ifs(config_file_path_, std::ios::binary);
+    if (ifs.is_open()) {
+      // 流式解析，逐条存入临时缓存，等待各模块注册时认领 (不构建整个文件的 DOM)
+      std::string error;
+      const bool ok = ConfigJsonObjectReader::ForEachMember(
+          ifs,
+          [this](const std::string& key, nlohmann::json value) {
+            initial_load_cache_[key] = std::move(value);
+          },
+          error);
+      if (!ok) {
+        std::cerr << "[Config Warn] " << config_file_path_ << ": " << error
+                  << " Entries before the error are kept." << std::endl;
       }
+    }
+  }
+  // 快照之后的变更记录在日志里，按顺序覆盖
+  ReplayJournal();
+
+  // 文件里的键基本都会被注册，按其数量预留分片桶，避免注册高峰期 rehash
+  config_dict_.Reserve(initial_load_cache_.size() + binary_snapshot_.Size());
+}
+
+void ConfigProviderService::ReplayJournal() {
+  std::ifstream ifs(config_journal_path_);
+  if (!ifs.is_open()) return;
+  std::string line;
+  while (std::getline(ifs, line)) {
+    if (line.empty()) continue;
+    try {
+      const nlohmann::json record = nlohmann::json::parse(line);
+      initial_load_cache_[record.at("p").get<std::string>()] = record.at("v");
     } catch (...) {
+      // 断电时最后一行可能只写了一半，之后的内容不可信
+      std::cerr << "[Config Warn] Journal truncated at a corrupt record: "
+                << config_journal_path_ << std::endl;
+      break;
     }
   }
 }
@@ -591,320 +1133,568 @@ bool ConfigProviderService::ValidateInternal(const ConfigEntry& entry,
                                              const ConfigValue& new_val,
                                              const std::string& role,
                                              std::string& out_error) const {
-  if (entry.meta.read_only) {
-    out_error = "Parameter is read-only.";
-    return false;
-  }
+  // 规则已在驻留 Schema 时编译好 (ConfigSchemaCheck)。从磁盘认领旧值时不按枚举字典校验：
+  // 动态字典 (UpdateEnumSchema) 往往在界面打开前才刷新，此时拒绝会丢掉上次保存的选择
+  return entry.check->Validate(new_val, entry.default_value.index(), role,
+                               role != kInitRole, out_error);
+}
 
-  // 极度细粒度的权限校验拦截
-  if (!entry.meta.permission_token.empty() &&
-      role != entry.meta.permission_token) {
-    out_error = "Insufficient permissions.";
-    return false;
+void ConfigProviderService::MarkDirty_UNLOCKED() {
+  const auto now = std::chrono::steady_clock::now();
+  if (!is_snapshot_dirty_) first_change_time_ = now;
+  last_change_time_ = now;
+  is_snapshot_dirty_ = true;
+  ++requested_seq_;
+}
+
+void ConfigProviderService::AsyncSaveSnapshot() {
+  // 仅仅触发一个电信号立刻返回，绝不在业务主循环里进行哪怕几微秒的文件系统操作
+  {
+    std::unique_lock<std::mutex> lock(worker_mutex_);
+    MarkDirty_UNLOCKED();
+    compact_requested_ = true;
   }
+  RequestCommit();
+}
 
-  // 阻止一切试图改变底层数据类型的变体覆盖操作
-  if (new_val.index() != entry.default_value.index()) {
-    out_error = "Data type mismatch.";
-    return false;
+void ConfigProviderService::AsyncAppendJournal(
+    const std::vector<ConfigChange>& changes) {
+  {
+    std::unique_lock<std::mutex> lock(worker_mutex_);
+    // 防抖窗口内同一路径反复修改 (拖动滑动条) 只保留最后一次
+    for (const auto& change : changes) pending_changes_[change.path] = change.value;
+    MarkDirty_UNLOCKED();
   }
+  RequestCommit();
+}
 
-  // -------------各类型的刚性数值边界校验逻辑---------------------
-  if (std::holds_alternative<int64_t>(new_val)) {
-    int64_t val = std::get<int64_t>(new_val);
-    if (std::holds_alternative<int64_t>(entry.meta.min_val) &&
-        val < std::get<int64_t>(entry.meta.min_val)) {
-      out_error = "Value is below the allowed minimum.";
-      return false;
-    }
-    if (std::holds_alternative<int64_t>(entry.meta.max_val) &&
-        val > std::get<int64_t>(entry.meta.max_val)) {
-      out_error = "Value exceeds the allowed maximum.";
-      return false;
-    }
-  } else if (std::holds_alternative<double>(new_val)) {
-    double val = std::get<double>(new_val);
-    if (std::holds_alternative<double>(entry.meta.min_val) &&
-        val < std::get<double>(entry.meta.min_val)) {
-      out_error = "Floating-point value is below the allowed minimum.";
-      return false;
-    }
-    if (std::holds_alternative<double>(entry.meta.max_val) &&
-        val > std::get<double>(entry.meta.max_val)) {
-      out_error = "Floating-point value exceeds the allowed maximum.";
-      return false;
-    }
-  } else if (std::holds_alternative<std::vector<int64_t>>(new_val)) {
-    const auto& vec = std::get<std::vector<int64_t>>(new_val);
-    for (size_t i = 0; i < vec.size(); ++i) {
-      if (std::holds_alternative<int64_t>(entry.meta.min_val) &&
-          vec[i] < std::get<int64_t>(entry.meta.min_val)) {
-        out_error = "Value of array element at index " + std::to_string(i) +
-                    " is below the allowed minimum.";
-        return false;
-      }
-      if (std::holds_alternative<int64_t>(entry.meta.max_val) &&
-          vec[i] > std::get<int64_t>(entry.meta.max_val)) {
-        out_error = "Value of array element at index " + std::to_string(i) +
-                    " exceeds the allowed maximum.";
-        return false;
-      }
-    }
-  } else if (std::holds_alternative<std::vector<double>>(new_val)) {
-    const auto& vec = std::get<std::vector<double>>(new_val);
-    for (size_t i = 0; i < vec.size(); ++i) {
-      if (std::holds_alternative<double>(entry.meta.min_val) &&
-          vec[i] < std::get<double>(entry.meta.min_val)) {
-        out_error = "Value of array element at index " + std::to_string(i) +
-                    " is below the allowed minimum.";
-        return false;
-      }
-      if (std::holds_alternative<double>(entry.meta.max_val) &&
-          vec[i] > std::get<double>(entry.meta.max_val)) {
-        out_error = "Value of array element at index " + std::to_string(i) +
-                    " exceeds the allowed maximum.";
-        return false;
-      }
-    }
+void ConfigProviderService::SetPersistencePolicy(
+    const ConfigPersistencePolicy& policy) {
+  {
+    std::unique_lock<std::mutex> lock(worker_mutex_);
+    policy_ = policy;
   }
+  // 已预约的提交按新窗口重新计算截止时间 (窗口缩短时提前)
+  RequestCommit();
+}
 
-  // 【自定义高级校验防线】：这是最后一关，将权利交回给业务插件自己写死的 Lambda
-  if (entry.meta.custom_validator) {
-    // 此时已经保证了 new_val 的底层类型正确，大胆执行闭包
-    std::string custom_err = entry.meta.custom_validator(new_val);
-    if (!custom_err.empty()) {
-      out_error = custom_err;  // 拦截！将业务提供的中文报错原因透传给外部
-      return false;
-    }
+ConfigPersistenceStats ConfigProviderService::GetPersistenceStats() const {
+  ConfigPersistenceStats stats;
+  stats.commits = commit_count_.load(std::memory_order_relaxed);
+  stats.failures = commit_failures_.load(std::memory_order_relaxed);
+  stats.snapshot_writes = snapshot_writes_.load(std::memory_order_relaxed);
+  stats.last_commit_ms =
+      static_cast<double>(last_commit_ns_.load(std::memory_order_relaxed)) / 1e6;
+  stats.max_commit_ms =
+      static_cast<double>(max_commit_ns_.load(std::memory_order_relaxed)) / 1e6;
+  stats.external_reloads = external_reloads_.load(std::memory_order_relaxed);
+  stats.external_ignored = external_ignored_.load(std::memory_order_relaxed);
+  const uint64_t attempts = stats.commits + stats.failures;
+  if (attempts > 0) {
+    stats.avg_commit_ms =
+        static_cast<double>(commit_total_ns_.load(std::memory_order_relaxed)) /
+        1e6 / static_cast<double>(attempts);
   }
+  return stats;
+}
 
+void ConfigProviderService::SetHistoryPolicy(const ConfigHistoryPolicy& policy) {
+  history_.SetPolicy(policy);
+  // 缩小容量淘汰的记录立即写出 (管理操作，不在业务热路径上)
+  if (history_.HasPendingSpill()) history_.FlushSpill();
+}
+
+std::vector<ConfigHistoryRecord> ConfigProviderService::QueryHistory(
+    const ConfigHistoryQuery& query) const {
+  return history_.Query(query);
+}
+
+bool ConfigProviderService::PublishSharedView(const ConfigSharedViewOptions& options,
+                                              std::string& out_error) {
+  if (!shared_view_.Start(options, out_error)) return false;
+  // 先开启发布再逐个补写：与遍历并发的修改要么已被遍历读到，要么在节点锁内自行写入，
+  // 而遍历在节点读锁内写入，不会用旧值覆盖之后的修改
+  config_dict_.ForEach([this](const std::string& path,
+                              const std::shared_ptr<ConfigEntry>& entry) {
+    std::shared_lock<std::shared_mutex> entry_lock(entry->entry_mutex);
+    if (entry->monitor || entry->current_value.is_empty()) return;
+    shared_view_.Store(path, *entry->current_value.Share());
+  });
   return true;
 }
 
-void ConfigProviderService::AsyncSaveSnapshot() {
-  // 仅仅触发一个电信号立刻返回，绝不在业务主循环里进行哪怕几微秒的文件系统操作
-  {
-    std::unique_lock<std::mutex> lock(worker_mutex_);
-    is_snapshot_dirty_ = true;
+void ConfigProviderService::StopSharedView() { shared_view_.Stop(); }
+
+ConfigSharedViewStats ConfigProviderService::GetSharedViewStats() const {
+  return shared_view_.GetStats();
+}
+
+bool ConfigProviderService::Flush(uint32_t timeout_ms) {
+  std::unique_lock<std::mutex> lock(worker_mutex_);
+  const uint64_t target = requested_seq_;
+  if (durable_seq_ >= target) return true;
+  if (worker_exited_) return false;
+  if (!is_snapshot_dirty_) {
+    // 上一次提交失败且之后再无修改：重写一次完整快照
+    MarkDirty_UNLOCKED();
+    compact_requested_ = true;
   }
-  worker_cv_.notify_one();
+  flush_requested_ = true;
+  RequestCommit_UNLOCKED(lock);
+
+  flush_cv_.wait_for(lock, std::chrono::milliseconds(timeout_ms), [&] {
+    return durable_seq_ >= target || attempted_seq_ >= target || worker_exited_;
+  });
+  return durable_seq_ >= target;
 }
 
-void ConfigProviderService::WorkerRoutine() {
-  while (true) {
-    bool should_sleep = false;
-    {
-      std::unique_lock<std::mutex> lock(worker_mutex_);
+std::chrono::steady_clock::time_point
+ConfigProviderService::CommitDeadline_UNLOCKED() const {
+  if (flush_requested_ || policy_.group_commit) return {};
+  // 【IO 防抖机制】
+  // 业务可能在半秒内调用了 100 次 SetValue（比如拉动滑动条）。
+  // 每次修改都把安静截止时间往后推，但不超过首次修改 + max_latency_ms。
+  return std::min(
+      last_change_time_ + std::chrono::milliseconds(policy_.debounce_ms),
+      first_change_time_ + std::chrono::milliseconds(policy_.max_latency_ms));
+}
+
+void ConfigProviderService::RequestCommit() {
+  std::unique_lock<std::mutex> lock(worker_mutex_);
+  RequestCommit_UNLOCKED(lock);
+}
 
-      // 线程在此处睡眠，直至有人将脏标记设为 true 或者发出框架终止信号
-      worker_cv_.wait(lock,
-                      [this] { return stop_worker_ || is_snapshot_dirty_; });
+void ConfigProviderService::RequestCommit_UNLOCKED(
+    std::unique_lock<std::mutex>& lock) {
+  // 进行中的提交结束后会重新检查脏标记，这里不必重复预约
+  if (stop_worker_ || !is_snapshot_dirty_ || commit_running_) return;
+  if (auto executor = executor_.lock()) {
+    if (ArmCommitTimer_UNLOCKED(*executor)) return;
+  }
+  // 没有可用的执行器：在调用线程上同步提交 (不做防抖)
+  while (!stop_worker_ && is_snapshot_dirty_ && !commit_running_) {
+    RunCommit(lock, false);
+  }
+}
 
-      // 如果只是要求退出，且没有脏数据了，和平离去
-      if (stop_worker_ && !is_snapshot_dirty_) {
-        break;
-      }
+bool ConfigProviderService::ArmCommitTimer_UNLOCKED(
+    z3y::IExecutorService& executor) {
+  const auto deadline = CommitDeadline_UNLOCKED();
+  if (commit_timer_ != 0) {
+    // 已有不晚于新截止时间的预约：到期后它会按最新的截止时间重新判断
+    if (deadline >= commit_deadline_) return true;
+    // 截止时间提前 (Flush / 组提交 / 窗口缩短)。撤销失败说明它已到期，马上就会运行
+    if (!executor.CancelTimer(commit_timer_)) return true;
+    commit_timer_ = 0;
+  }
+  const auto delay = std::max(deadline - std::chrono::steady_clock::now(),
+                              std::chrono::steady_clock::duration::zero());
+  // 定时任务在获取 worker_mutex_ 时才登记自己离场，这里持锁写入句柄不会与之竞争
+  commit_timer_ = executor.PostDelayed(delay, [this] { OnCommitTimer(); });
+  commit_deadline_ = deadline;
+  return commit_timer_ != 0;
+}
 
-      if (is_snapshot_dirty_) {
-        should_sleep = true;
-        is_snapshot_dirty_ = false;  // 提前清除脏标记
-      }
+void ConfigProviderService::OnCommitTimer() {
+  std::unique_lock<std::mutex> lock(worker_mutex_);
+  commit_timer_ = 0;
+  if (!stop_worker_ && is_snapshot_dirty_ && !commit_running_) {
+    auto executor = executor_.lock();
+    // 等待期间又有修改，截止时间被推后：按新时间重新预约
+    if (executor && std::chrono::steady_clock::now() < CommitDeadline_UNLOCKED() &&
+        ArmCommitTimer_UNLOCKED(*executor)) {
+      return;
     }
+    RunCommit(lock, false);
+    // 提交期间到达的修改 (组提交时即下一批) 接着预约
+    RequestCommit_UNLOCKED(lock);
+  }
+  // Shutdown 可能正在等待本预约离场
+  flush_cv_.notify_all();
+}
 
-    // 【IO 防抖机制】
-    // 业务可能在半秒内调用了 100 次 SetValue（比如拉动滑动条）。
-    // 醒来后别急着去保存，稍微等一等。这段时间的狂乱赋值最终都会只产生一次写盘。
-    // 在无锁状态下睡眠防抖，绝不阻塞前端的 SetValue 业务！
-    if (should_sleep) {
-      std::this_thread::sleep_for(std::chrono::milliseconds(500));
+void ConfigProviderService::RunCommit(std::unique_lock<std::mutex>& lock,
+                                      bool stopping) {
+  using Clock = std::chrono::steady_clock;
+  // 取走窗口内积攒的变更 (组提交时即上次提交期间到达的全部修改)
+  std::map<std::string, ConfigValue> changes;
+  changes.swap(pending_changes_);
+  const bool compact = compact_requested_;
+  compact_requested_ = false;
+  is_snapshot_dirty_ = false;
+  flush_requested_ = false;
+  const bool fsync = policy_.fsync;
+  const uint64_t commit_seq = requested_seq_;
+  commit_running_ = true;
+  // 落盘期间释放 worker_mutex_，绝不阻塞前端的 SetValue 业务！
+  lock.unlock();
+
+  bool ok = false;
+  bool wrote_snapshot = false;
+  uint64_t commit_ns = 0;
+  {
+    std::lock_guard<std::mutex> io_lock(io_mutex_);
+    const auto commit_start = Clock::now();
+    // 日志超过快照本身的大小后，重放它比读一次快照还贵，此时压实
+    std::error_code ec;
+    const auto snapshot_size = std::filesystem::file_size(config_file_path_, ec);
+    const bool has_snapshot = !ec;
+    const auto journal_size = std::filesystem::file_size(config_journal_path_, ec);
+    const bool journal_too_large =
+        !ec && journal_size >= std::max<uintmax_t>(snapshot_size, 64 * 1024);
+
+    ok = !(compact || stopping || !has_snapshot || journal_too_large) &&
+         AppendJournal(changes, fsync);
+    if (!ok) {
+      wrote_snapshot = true;
+      ok = WriteFullSnapshot(fsync);
     }
+    commit_ns = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() -
+                                                             commit_start)
+            .count());
+  }
 
-    is_snapshot_dirty_ = false;
+  // 修改历史中被淘汰的记录顺带追加到归档文件 (与配置文件无关，不计入提交耗时)
+  if (history_.HasPendingSpill()) history_.FlushSpill();
+
+  // 提交之间互斥，统计只有一个写者，relaxed 即可；max 也无需 CAS
+  (ok ? commit_count_ : commit_failures_)
+      .fetch_add(1, std::memory_order_relaxed);
+  if (wrote_snapshot) snapshot_writes_.fetch_add(1, std::memory_order_relaxed);
+  commit_total_ns_.fetch_add(commit_ns, std::memory_order_relaxed);
+  last_commit_ns_.store(commit_ns, std::memory_order_relaxed);
+  if (commit_ns > max_commit_ns_.load(std::memory_order_relaxed)) {
+    max_commit_ns_.store(commit_ns, std::memory_order_relaxed);
+  }
 
-    // [提取阶段]
-    // 在持有互斥锁的最短时间内，把全局数据全量拷贝成为“内存离线快照”。
-    // 这样做可以让你放开锁去进行漫长的 IO 写盘，彻底解放主线程。
-    std::map<std::string, ConfigValue> io_snapshot;
-    {
-      std::shared_lock<std::shared_mutex> dict_lock(dict_mutex_);
-      for (const auto& kv : config_dict_) {
-        std::shared_lock<std::shared_mutex> entry_lock(kv.second->entry_mutex);
-        io_snapshot[kv.first] = kv.second->current_value;
+  lock.lock();
+  commit_running_ = false;
+  attempted_seq_ = commit_seq;
+  if (ok) {
+    durable_seq_ = commit_seq;
+  } else {
+    // 内存中的值仍是最新的，下一次提交改写完整快照
+    compact_requested_ = true;
+  }
+  flush_cv_.notify_all();
+}
+
+bool ConfigProviderService::AppendJournal(
+    const std::map<std::string, ConfigValue>& changes, bool fsync) {
+  if (changes.empty()) return true;
+  try {
+    std::string lines;
+    const uint64_t now_ms = GetCurrentTimestampMs();
+    for (const auto& kv : changes) {
+      nlohmann::json record;
+      record["p"] = kv.first;
+      record["v"] = ConfigValueToJson(kv.second);
+      record["t"] = now_ms;
+      lines += record.dump();
+      lines += '\n';
+    }
+    std::ofstream ofs(config_journal_path_, std::ios::app | std::ios::binary);
+    if (!ofs.is_open()) return false;
+    ofs << lines;
+    ofs.close();
+    if (!ofs) return false;
+    return !fsync || SyncFile(config_journal_path_);
+  } catch (...) {
+    return false;
+  }
+}
+
+void ConfigProviderService::WriteMergedJson_UNLOCKED(
+    ConfigJsonWriter& writer, const std::map<std::string, ConfigValueCell>& live) const {
+  // 三个来源各自有序 (二进制快照按字节序、live 是 std::map、孤儿缓存排序后)，
+  // 归并后的输出顺序与 nlohmann::json 对象一致，每次只为一个值构造 JSON
+  std::vector<const std::pair<const std::string, nlohmann::json>*> orphans;
+  orphans.reserve(initial_load_cache_.size());
+  for (const auto& kv : initial_load_cache_) orphans.push_back(&kv);
+  std::sort(orphans.begin(), orphans.end(),
+            [](const auto* a, const auto* b) { return a->first < b->first; });
+
+  auto live_it = live.begin();
+  auto orphan_it = orphans.begin();
+  // 写出 live / 孤儿中键小于 bound 的成员 (bound 为空时写出全部)，同名时 live 覆盖孤儿
+  auto emit_before = [&](const std::string* bound) {
+    for (;;) {
+      const bool has_live = live_it != live.end() && (!bound || live_it->first < *bound);
+      const bool has_orphan =
+          orphan_it != orphans.end() && (!bound || (*orphan_it)->first < *bound);
+      if (!has_live && !has_orphan) return;
+      if (has_live && (!has_orphan || live_it->first <= (*orphan_it)->first)) {
+        if (has_orphan && live_it->first == (*orphan_it)->first) ++orphan_it;
+        writer.Add(live_it->first, ConfigValueToJson(live_it->second.ToValue()));
+        ++live_it;
+      } else {
+        writer.Add((*orphan_it)->first, (*orphan_it)->second);
+        ++orphan_it;
       }
     }
+  };
 
-    // [序列化与原子落盘阶段]
-    try {
-      nlohmann::json root;
+  binary_snapshot_.ForEach([&](const std::string& key, nlohmann::json value) {
+    emit_before(&key);
+    const bool in_live = live_it != live.end() && live_it->first == key;
+    const bool in_orphans = orphan_it != orphans.end() && (*orphan_it)->first == key;
+    if (in_live) {
+      writer.Add(key, ConfigValueToJson(live_it->second.ToValue()));
+    } else if (in_orphans) {
+      writer.Add(key, (*orphan_it)->second);
+    } else {
+      writer.Add(key, value);
+    }
+    if (in_live) ++live_it;
+    if (in_orphans) ++orphan_it;
+  });
+  emit_before(nullptr);
+}
 
-      // 1. 保底机制：首先无脑填充未被认领的残留缓存配置，防丢处理。
+bool ConfigProviderService::WriteFullSnapshot(bool fsync) {
+  // [提取阶段]
+  // 在持有互斥锁的最短时间内，把全局数据全量拷贝成为“内存离线快照”。
+  // 这样做可以让你放开锁去进行漫长的 IO 写盘，彻底解放主线程。
+  // 存的是 ConfigValueCell：锁内只复制标量或增加引用计数，字符串与数组不深拷贝。
+  std::map<std::string, ConfigValueCell> io_snapshot;
+  config_dict_.ForEach([&io_snapshot](const std::string& path,
+                                      const std::shared_ptr<ConfigEntry>& entry) {
+    std::shared_lock<std::shared_mutex> entry_lock(entry->entry_mutex);
+    if (entry->IsPersistent()) io_snapshot[path] = entry->current_value;
+  });
+
+  // [流式序列化与原子落盘阶段]
+  try {
+    // 先写到一个不存在的 .tmp 文件中，同时构建同源的二进制伴生快照
+    ConfigBinarySnapshot::Builder binary;
+    uint64_t json_size = 0;
+    uint64_t json_hash = 0;
+    // 文件监视开启时顺带记录逐键哈希，写完后作为外部修改的比对基线
+    const bool watching = file_watch_enabled_.load();
+    FileWatchBaseline written;
+    {
+      std::ofstream ofs(config_tmp_path_, std::ios::binary | std::ios::trunc);
+      if (!ofs.is_open()) return false;
+      ConfigJsonWriter writer(ofs, &binary);
+      if (watching) writer.SetMemberHashSink(&written.members);
       {
-        std::shared_lock<std::shared_mutex> dict_lock(dict_mutex_);
-        for (const auto& kv : initial_load_cache_) {
-          root[kv.first] = kv.second;  // cache 里存的本来就是 nlohmann::json
-        }
+        // 未被认领的残留配置一并写回，防丢处理。写盘期间只阻塞孤儿缓存的修改 (注册认领)
+        std::shared_lock<std::shared_mutex> cache_lock(cache_mutex_);
+        WriteMergedJson_UNLOCKED(writer, io_snapshot);
       }
+      writer.Finish();
+      json_size = writer.size();
+      json_hash = writer.hash();
+      ofs.close();
+      if (!ofs) return false;
+    }
+    // 重命名之前必须让临时文件内容落盘，否则断电后可能得到一个改名成功的空文件
+    if (fsync && !SyncFile(config_tmp_path_)) {
+      std::cerr << "[Config IO Error] fsync failed: " << config_tmp_path_
+                << std::endl;
+      return false;
+    }
 
-      // 2. 覆盖机制：将当前最新的提取快照覆盖进去（同名键会天然顶掉旧缓存）
-      for (const auto& kv : io_snapshot) {
-        root[kv.first] = ConfigValueToJson(kv.second);
-      }
+    // 重命名之前换上新基线：监视线程随后看到的 config.json 与它同源，识别为自身写盘
+    FileWatchBaseline previous;
+    if (watching) {
+      written.valid = true;
+      written.size = json_size;
+      written.hash = json_hash;
+      std::lock_guard<std::mutex> lock(watch_mutex_);
+      previous = std::exchange(watch_baseline_, std::move(written));
+    }
 
-      // 3. 原子覆写 (Atomic Override) 操作
-      // 先写到一个不存在的 .tmp 文件中。
-      std::ofstream ofs(config_tmp_path_, std::ios::trunc);
-      if (ofs.is_open()) {
-        ofs << root.dump(4);
-        ofs.close();
-
-        // 使用操作系统级的重命名接口。
-        // 好处：如果前面大篇幅的 dump 写入中断电了，原始的 config.json
-        // 并未损坏！
-        std::error_code ec;
-        std::filesystem::rename(config_tmp_path_, config_file_path_, ec);
-        if (ec) {
-          std::cerr << "[Config IO Error] Rename failed: " << ec.message()
-                    << std::endl;
-        }
+    // 使用操作系统级的重命名接口。
+    // 好处：如果前面大篇幅的写入中断电了，原始的 config.json 并未损坏！
+    std::error_code ec;
+    std::filesystem::rename(config_tmp_path_, config_file_path_, ec);
+    if (ec) {
+      std::cerr << "[Config IO Error] Rename failed: " << ec.message()
+                << std::endl;
+      if (watching) {
+        std::lock_guard<std::mutex> lock(watch_mutex_);
+        watch_baseline_ = std::move(previous);
       }
-    } catch (...) {
+      return false;
     }
-
-    // 检测到框架正在下达逐客令，处理完最后一次脏数据便结束自己的一生
-    if (stop_worker_) {
-      break;
+    if (fsync) SyncParentDirectory(config_file_path_);
+    // 快照已包含日志中的全部变更。若恰好在此之前断电，重放日志只会回到
+    // 最近一个防抖窗口之前的值，与防抖本身的丢失窗口相同。
+    std::filesystem::remove(config_journal_path_, ec);
+
+    // 同源的二进制伴生快照，供下次启动免解析加载 (失败只影响启动速度)
+    if (!binary.Write(config_binary_path_, json_size, json_hash)) {
+      std::cerr << "[Config IO Warn] Failed to write binary snapshot: "
+                << config_binary_path_ << std::endl;
     }
+    return true;
+  } catch (...) {
+    return false;
   }
 }
 
 bool ConfigProviderService::ReloadFromFile() {
-  std::ifstream ifs(config_file_path_);
+  std::ifstream ifs(config_file_path_, std::ios::binary);
   if (!ifs.is_open()) {
     std::cerr << "[Config Error] Reload failed: Cannot open file "
               << config_file_path_ << std::endl;
     return false;
   }
 
-  nlohmann::json root;
-  try {
-    ifs >> root;
-  } catch (...) {
+  // 先做一遍只校验语法的 SAX 扫描 (不构建 DOM)：文件损坏时一个值都不应用
+  if (!nlohmann::json::accept(ifs)) {
+    std::cerr << "[Config Error] Reload failed: Malformed JSON in "
+              << config_file_path_ << std::endl;
+    return false;
+  }
+  ifs.clear();
+  ifs.seekg(0);
+
+  FileApplyResult result;
+  std::string parse_error;
+  if (!ApplyFileMembers(ifs, "System_Reload", nullptr, nullptr, result, parse_error)) {
+    // 语法已在第一遍校验过，到这里只可能是顶层不是对象 (此时尚未应用任何值)
+    std::cerr << "[Config Error] Reload failed: " << parse_error << std::endl;
     return false;
   }
+  return PublishFileApply(result, "Reload");
+}
 
+bool ConfigProviderService::ApplyFileMembers(
+    std::istream& input, const std::string& role,
+    const std::unordered_map<std::string, uint64_t>* baseline,
+    std::unordered_map<std::string, uint64_t>* out_hashes, FileApplyResult& result,
+    std::string& out_error) {
   // 【核心设计 1：闭包收集器】
-  // 用于收集所有需要被触发的回调。我们绝不在持有锁的时候去执行它！
-  struct PendingCallback {
-    std::function<void(const ConfigValue&)> cb;
-    ConfigValue val;
-  };
-  std::vector<PendingCallback> callbacks_to_run;
-
-  // 【新增】：审计事件篮子
-  std::vector<ConfigChangedEvent> audit_events;
+  // 用于收集所有需要被触发的回调 (result.callbacks)。我们绝不在持有锁的时候去执行它！
+  // 审计事件同样先收进 result.audit_events (没有订阅者时不构造)。
+  const PluginPtr<z3y::IEventBus> audit_bus = AuditBus();
+  const uint64_t timestamp_ms = GetCurrentTimestampMs();
 
   // 【终极并发修复】：准备一个临时篮子，专门装“孤儿数据”，绝不在读锁里写数据！
   std::unordered_map<std::string, nlohmann::json> pending_orphans;
 
-  {
-    // 【核心设计 2：细粒度并发控制】
-    // 使用共享读锁保护全局字典。因为 Reload
-    // 只是修改现有节点的值，不增删节点拓扑。
-    std::shared_lock<std::shared_mutex> dict_lock(dict_mutex_);
-
-    // 1. 遍历内存中所有活跃的节点
-    for (const auto& [path, entry_ptr] : config_dict_) {
-      if (!root.contains(path)) {
-        continue;  // 磁盘文件中不存在该项，略过（保持内存原状）
-      }
+  // 【核心设计 2：流式逐条应用】
+  // 每读完文件中的一个成员就处理一个，内存里同时只有一个值的 JSON。
+  // 只修改现有节点的值，不增删节点拓扑；磁盘文件中不存在的项保持内存原状。
+  const bool parsed_ok = ConfigJsonObjectReader::ForEachMember(
+      input,
+      [&](const std::string& path, nlohmann::json value) {
+        // 【增量模式】：值与上一份文件相同的键没有被外部改动，不加锁、不校验
+        if (baseline || out_hashes) {
+          const uint64_t value_hash = ConfigJsonWriter::ValueHash(value);
+          if (out_hashes) (*out_hashes)[path] = value_hash;
+          if (baseline) {
+            auto it = baseline->find(path);
+            if (it != baseline->end() && it->second == value_hash) return;
+          }
+        }
 
-      // 获取该特定节点的独占写锁
-      std::unique_lock<std::shared_mutex> entry_lock(entry_ptr->entry_mutex);
+        const std::shared_ptr<ConfigEntry> entry_ptr = config_dict_.Find(path);
+        // 【修复】：孤儿节点处理。放入局部篮子 pending_orphans 中！
+        if (!entry_ptr) {
+          pending_orphans[path] = std::move(value);
+          return;
+        }
 
-      // 【修复】：占位节点处理。将其放入局部篮子 pending_orphans 中，而非直接写
-      // initial_load_cache_！
-      if (std::holds_alternative<std::monostate>(entry_ptr->default_value)) {
-        pending_orphans[path] = root[path];
-        continue;
-      }
+        // 获取该特定节点的独占写锁
+        std::unique_lock<std::shared_mutex> entry_lock(entry_ptr->entry_mutex);
 
-      ConfigValue parsed_val;
-      // 借助 default_value 的类型信息，安全地将无类型的 JSON 解析为强类型的
-      // ConfigValue
-      if (JsonToConfigValue(root[path], entry_ptr->default_value, parsed_val)) {
+        // 【修复】：占位节点处理。将其放入局部篮子 pending_orphans 中，而非直接写
+        // initial_load_cache_！
+        if (entry_ptr->default_value.is_empty()) {
+          pending_orphans[path] = std::move(value);
+          return;
+        }
+        // 易失 / 监视参数的值不来自文件：文件里残留的旧值直接忽略
+        if (!entry_ptr->IsPersistent()) return;
+
+        ConfigValue parsed_val;
+        // 借助 default_value 的类型信息，安全地将无类型的 JSON 解析为强类型的
+        // ConfigValue
+        if (!JsonToConfigValue(value, entry_ptr->default_value.ToValue(), parsed_val)) {
+          return;
+        }
         std::string err_msg;
 
         // 【核心设计 3：合法性防线】
         // 外部用记事本瞎改的数据，必须经过严格的 Schema 校验
         // (Min/Max/只读/类型)。
-        if (ValidateInternal(*entry_ptr, parsed_val, "System_Reload",
-                             err_msg)) {
-          // 【核心设计 4：实质变化检测】
-          // 只有当数据真正发生改变时，才更新内存并收集回调。
-          // 避免运维人员只改了 A 参数，却导致 B
-          // 参数也触发了毫无意义的硬件重置。
-          if (entry_ptr->current_value != parsed_val) {
-            // 【新增】：在内存被覆盖前，生成审计事件
-            ConfigChangedEvent audit_evt;
-            audit_evt.path = path;
-            audit_evt.old_value = ConfigValueToString(entry_ptr->current_value);
-            audit_evt.new_value = ConfigValueToString(parsed_val);
-            audit_evt.operator_role = "System_Reload";
-            audit_evt.timestamp_ms = GetCurrentTimestampMs();
-            audit_events.push_back(audit_evt);
-
-            entry_ptr->current_value = parsed_val;
-
-            // 遍历并收集该节点下所有嗷嗷待哺的订阅者
-            for (const auto& cb_pair : entry_ptr->callbacks) {
-              callbacks_to_run.push_back({cb_pair.second, parsed_val});
-            }
-          }
-        } else {
+        if (!ValidateInternal(*entry_ptr, parsed_val, role, err_msg)) {
           std::cerr << "[Config Warn] Reload rejected for path [" << path
                     << "]: " << err_msg << ". Kept old value." << std::endl;
+          return;
         }
-      }
-    }
+        // 【核心设计 4：实质变化检测】
+        // 只有当数据真正发生改变时，才更新内存并收集回调。
+        // 避免运维人员只改了 A 参数，却导致 B
+        // 参数也触发了毫无意义的硬件重置。
+        if (entry_ptr->current_value != parsed_val) {
+          // 【新增】：在内存被覆盖前，生成审计事件
+          if (audit_bus) {
+            result.audit_events.push_back(MakeChangedEvent(
+                path, entry_ptr->current_value.ToValue(), parsed_val, role, timestamp_ms));
+          }
+          result.any_changed = true;
 
-    // 【修复】：孤儿节点处理。同样放入局部篮子 pending_orphans 中！
-    for (auto& el : root.items()) {
-      if (config_dict_.find(el.key()) == config_dict_.end()) {
-        pending_orphans[el.key()] = el.value();
-      }
-    }
-  }  // <=== dict_lock 和所有的 entry_lock 在这里被自动释放
+          ConfigValueCell new_cell(parsed_val);
+          if (history_.enabled()) {
+            history_.Append({path, entry_ptr->current_value, new_cell}, role, timestamp_ms);
+          }
+          entry_ptr->current_value = std::move(new_cell);
+          shared_view_.Store(path, parsed_val);
+
+          // 遍历并收集该节点下所有嗷嗷待哺的订阅者
+          if (entry_ptr->subscribers && !entry_ptr->subscribers->empty()) {
+            result.callbacks.push_back({entry_ptr->subscribers, parsed_val});
+          }
+        }
+      },
+      out_error);  // <=== 每个成员处理完即释放节点锁
+  if (!parsed_ok) return false;
 
   // 【终极并发修复落实】：如果发现了孤儿数据，单独获取极短暂的【独占写锁】合并！
-  if (!pending_orphans.empty()) {
-    std::unique_lock<std::shared_mutex> dict_write_lock(dict_mutex_);
-    for (const auto& kv : pending_orphans) {
-      initial_load_cache_[kv.first] = kv.second;
+  // 全量重载时文件中的孤儿已全部进入 initial_load_cache_，二进制快照可能已与文件不同源，丢弃。
+  // 增量应用只带来变化了的孤儿，其余孤儿仍要从二进制快照认领，保留它 (缓存优先于快照)。
+  {
+    std::unique_lock<std::shared_mutex> cache_lock(cache_mutex_);
+    for (auto& kv : pending_orphans) {
+      initial_load_cache_[kv.first] = std::move(kv.second);
     }
+    if (!baseline) binary_snapshot_.Reset();
   }
+  return true;
+}
 
+bool ConfigProviderService::PublishFileApply(const FileApplyResult& result,
+                                             const char* source) {
   // 【核心设计 6：无锁派发回调】
   // 锁已经全部释放，业务线程畅通无阻。现在安全地触发所有回调。
-  if (!callbacks_to_run.empty()) {
+  if (!result.callbacks.empty()) {
     if (g_recursion_depth == 0) {
       g_has_cyclic_error = false;
     }
     if (g_recursion_depth > 5) {
-      std::cerr << "[Config Error] Maximum recursion depth exceeded during ReloadFromFile." << std::endl;
+      std::cerr << "[Config Error] Maximum recursion depth exceeded during " << source
+                << "." << std::endl;
       g_has_cyclic_error = true;
       return false;
     }
 
     RecursionGuard guard;
-    for (const auto& task : callbacks_to_run) {
-      try {
-        task.cb(task.val);
-      } catch (const std::exception& e) {
-        std::cerr << "[Config Error] Exception in Reload callback: " << e.what()
-                  << std::endl;
-      } catch (...) {
-        std::cerr << "[Config Error] Unknown exception in Reload callback."
-                  << std::endl;
+    for (const auto& task : result.callbacks) {
+      for (const auto& sub : *task.subscribers) {
+        try {
+          sub->Deliver(task.value, notify_executor_);
+        } catch (const std::exception& e) {
+          std::cerr << "[Config Error] Exception in " << source << " callback: " << e.what()
+                    << std::endl;
+        } catch (...) {
+          std::cerr << "[Config Error] Unknown exception in " << source << " callback."
+                    << std::endl;
+        }
       }
     }
 
@@ -913,21 +1703,156 @@ bool ConfigProviderService::ReloadFromFile() {
     }
   }
 
-  // 【核心新增】：安全触发所有被 Reload 篡改的参数的审计事件！
-  if (!audit_events.empty()) {
-    for (const auto& evt : audit_events) {
-      z3y::FireGlobalEvent<ConfigChangedEvent>(evt);
+  // 【核心新增】：安全触发所有被重载篡改的参数的审计事件！
+  if (!result.audit_events.empty()) {
+    if (const PluginPtr<z3y::IEventBus> audit_bus = AuditBus()) {
+      audit_bus->FireGlobalBatch(result.audit_events);
     }
+  }
+  if (result.any_changed) {
     AsyncSaveSnapshot();
   }
 
-  std::cout << "[Config Info] Reload completed. Triggered "
-            << callbacks_to_run.size() << " callbacks." << std::endl;
+  size_t callback_count = 0;
+  for (const auto& task : result.callbacks) callback_count += task.subscribers->size();
+  std::cout << "[Config Info] " << source << " completed. Triggered "
+            << callback_count << " callbacks." << std::endl;
   return true;
 }
 
 // ============================================================================
-// 1. 恢复出厂设置 (复用 ApplyBatch 事务锁)
+// 外部修改监视 (SetFileWatch)
+// ============================================================================
+
+namespace {
+
+/** @brief 分块计算文件的长度与 FNV-1a 哈希 (与 ConfigJsonWriter 的累计方式一致)。 */
+bool HashFile(const std::string& path, uint64_t& out_size, uint64_t& out_hash) {
+  std::ifstream ifs(path, std::ios::binary);
+  if (!ifs.is_open()) return false;
+  std::vector<char> chunk(64 * 1024);
+  out_size = 0;
+  out_hash = ConfigBinarySnapshot::kHashSeed;
+  while (ifs.read(chunk.data(), static_cast<std::streamsize>(chunk.size())) || ifs.gcount() > 0) {
+    const size_t n = static_cast<size_t>(ifs.gcount());
+    out_hash = ConfigBinarySnapshot::Hash(std::string_view(chunk.data(), n), out_hash);
+    out_size += n;
+  }
+  return true;
+}
+
+}  // namespace
+
+bool ConfigProviderService::SetFileWatch(bool enabled, uint32_t debounce_ms) {
+  std::lock_guard<std::mutex> control_lock(watch_control_mutex_);
+  if (!enabled) {
+    file_watch_enabled_.store(false);
+    file_watcher_.Stop();
+    std::lock_guard<std::mutex> lock(watch_mutex_);
+    watch_baseline_ = FileWatchBaseline{};
+    return true;
+  }
+  watch_debounce_ms_ = debounce_ms;
+  return StartFileWatch_UNLOCKED();
+}
+
+bool ConfigProviderService::StartFileWatch_UNLOCKED() {
+  file_watcher_.Stop();
+  std::string file_path;
+  {
+    std::shared_lock<std::shared_mutex> cache_lock(cache_mutex_);
+    file_path = config_file_path_;
+  }
+  // 先打开开关再建基线：此后写快照都会更新基线，不会漏掉建基线期间的自身写盘
+  file_watch_enabled_.store(true);
+
+  FileWatchBaseline baseline;
+  {
+    // 与提交互斥，读到的一定是某一次完整重命名后的文件
+    std::lock_guard<std::mutex> io_lock(io_mutex_);
+    std::ifstream ifs(file_path, std::ios::binary);
+    std::string error;
+    if (ifs.is_open() && HashFile(file_path, baseline.size, baseline.hash) &&
+        ConfigJsonObjectReader::ForEachMember(
+            ifs,
+            [&baseline](const std::string& key, nlohmann::json value) {
+              baseline.members[key] = ConfigJsonWriter::ValueHash(value);
+            },
+            error)) {
+      baseline.valid = true;
+    }
+  }
+  {
+    std::lock_guard<std::mutex> lock(watch_mutex_);
+    watch_baseline_ = std::move(baseline);
+  }
+
+  if (!file_watcher_.Start(file_path, std::chrono::milliseconds(watch_debounce_ms_),
+                           [this]() { OnConfigFileChanged(); })) {
+    file_watch_enabled_.store(false);
+    std::cerr << "[Config Warn] File watching is not available for " << file_path
+              << std::endl;
+    return false;
+  }
+  return true;
+}
+
+void ConfigProviderService::OnConfigFileChanged() {
+  std::string file_path;
+  {
+    std::shared_lock<std::shared_mutex> cache_lock(cache_mutex_);
+    file_path = config_file_path_;
+  }
+  uint64_t size = 0;
+  uint64_t hash = 0;
+  if (!HashFile(file_path, size, hash)) return;  // 被删除：保持内存原状
+
+  // 长度与哈希都与上一份文件相同：自身的原子重命名写盘，或没有实质修改的保存
+  std::unordered_map<std::string, uint64_t> previous;
+  {
+    std::lock_guard<std::mutex> lock(watch_mutex_);
+    if (watch_baseline_.valid && watch_baseline_.size == size &&
+        watch_baseline_.hash == hash) {
+      external_ignored_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    previous = watch_baseline_.valid ? watch_baseline_.members
+                                     : std::unordered_map<std::string, uint64_t>{};
+  }
+
+  std::ifstream ifs(file_path, std::ios::binary);
+  if (!ifs.is_open()) return;
+  // 编辑器可能只写了一半：语法不完整时跳过，等待下一次写入事件
+  if (!nlohmann::json::accept(ifs)) {
+    std::cerr << "[Config Warn] Ignoring incomplete external edit of " << file_path
+              << std::endl;
+    return;
+  }
+  ifs.clear();
+  ifs.seekg(0);
+
+  FileApplyResult result;
+  std::unordered_map<std::string, uint64_t> members;
+  std::string error;
+  if (!ApplyFileMembers(ifs, "System_FileWatch", &previous, &members, result, error)) {
+    std::cerr << "[Config Warn] External edit of " << file_path << " ignored: " << error
+              << std::endl;
+    return;
+  }
+  {
+    // 被应用的文件成为新的比对基线
+    std::lock_guard<std::mutex> lock(watch_mutex_);
+    watch_baseline_.valid = true;
+    watch_baseline_.size = size;
+    watch_baseline_.hash = hash;
+    watch_baseline_.members = std::move(members);
+  }
+  external_reloads_.fetch_add(1, std::memory_order_relaxed);
+  PublishFileApply(result, "External edit");
+}
+
+// ============================================================================
+// 1. 恢复出厂设置 (复用 ApplyChanges 事务锁)
 // ============================================================================
 
 bool ConfigProviderService::ResetToDefault(const std::string& path) {
@@ -935,43 +1860,38 @@ bool ConfigProviderService::ResetToDefault(const std::string& path) {
 
   {
     // [第一阶段] 极速只读锁：从字典中查询目标节点的默认值
-    std::shared_lock<std::shared_mutex> dict_lock(dict_mutex_);
-    auto it = config_dict_.find(path);
-    if (it == config_dict_.end()) return false;
+    const std::shared_ptr<ConfigEntry> entry = config_dict_.Find(path);
+    if (!entry) return false;
 
-    std::shared_lock<std::shared_mutex> entry_lock(it->second->entry_mutex);
-    def_val = it->second->default_value;
+    std::shared_lock<std::shared_mutex> entry_lock(entry->entry_mutex);
+    def_val = entry->default_value.ToValue();
   }
 
   // 拦截占位节点：如果它还没被真正注册过，默认值会是 std::monostate，拒绝重置
   if (std::holds_alternative<std::monostate>(def_val)) return false;
 
   // 【架构精髓】：绝不在此时自己写加锁逻辑！
-  // 直接委托给极其健壮的 ApplyBatch
+  // 直接委托给极其健壮的 ApplyChanges
   // 事务处理器，它会自动完成验证、防死锁、以及无锁派发回调。
-  auto errors = ApplyBatch({{path, def_val}}, "System_Reset_Action");
+  auto errors = ApplyChanges({{path, def_val}}, "System_Reset_Action");
 
   return errors.empty();
 }
 
 void ConfigProviderService::ResetGroupToDefault(const std::string& group_key) {
-  std::map<std::string, ConfigValue> batch_changes;
+  std::vector<ConfigChange> batch_changes;
 
   {
-    // [第一阶段] 收集特定 Group 下的所有默认值
-    std::shared_lock<std::shared_mutex> dict_lock(dict_mutex_);
-    for (const auto& [path, entry_ptr] : config_dict_) {
+    // [第一阶段] 经分组索引收集特定 Group 下的所有默认值
+    group_index_.ForEachInGroup(group_key, [&](const std::string& path,
+                                               const std::shared_ptr<ConfigEntry>& entry_ptr) {
       std::shared_lock<std::shared_mutex> entry_lock(entry_ptr->entry_mutex);
 
-      // 过滤匹配的 Group，并且剔除掉未经注册的占位节点
-      if (entry_ptr->meta.group_key == group_key &&
-          !std::holds_alternative<std::monostate>(entry_ptr->default_value)) {
-        // 优化：只有当前值与默认值不一样时，才加入修改批次，避免无意义的触发
-        if (entry_ptr->current_value != entry_ptr->default_value) {
-          batch_changes[path] = entry_ptr->default_value;
-        }
+      // 索引里只有已注册节点；只有当前值与默认值不一样时，才加入修改批次，避免无意义的触发
+      if (entry_ptr->current_value != entry_ptr->default_value) {
+        batch_changes.push_back({path, entry_ptr->default_value.ToValue()});
       }
-    }
+    });
   }
 
   // [第二阶段] 如果没有变化，直接返回
@@ -979,7 +1899,7 @@ void ConfigProviderService::ResetGroupToDefault(const std::string& group_key) {
 
   // [第三阶段] 复用 ACID 事务批量提交
   // 这将保证模块级的重置是一次性生效的，即便内部发生了地址抢占，也会被排序算法化解。
-  auto errors = ApplyBatch(batch_changes, "System_GroupReset_Action");
+  auto errors = ApplyChanges(batch_changes, "System_GroupReset_Action");
 
   if (!errors.empty()) {
     std::cerr << "[Config Error] Failed to reset group '" << group_key
@@ -993,32 +1913,27 @@ void ConfigProviderService::ResetGroupToDefault(const std::string& group_key) {
 // ============================================================================
 
 bool ConfigProviderService::ExportToFile(const std::string& target_path) const {
-  nlohmann::json root;
-
-  {
-    // 获取全局字典拓扑保护锁
-    std::shared_lock<std::shared_mutex> dict_lock(dict_mutex_);
-
-    // 1. 先填充未定型的“孤儿数据”，保证配方导出时不会丢失未加载插件的配置
-    for (const auto& kv : initial_load_cache_) {
-      root[kv.first] = kv.second;
-    }
-
-    // 2. 填充已注册活跃节点的当前内存值
-    for (const auto& kv : config_dict_) {
-      std::shared_lock<std::shared_mutex> entry_lock(kv.second->entry_mutex);
-      // 调用本文件匿名命名空间中的辅助函数：ConfigValueToJson
-      root[kv.first] = ConfigValueToJson(kv.second->current_value);
-    }
-  }
-
-  // 3. 序列化并写入目标绝对路径
+  // 1. 提取已注册活跃节点的当前内存值 (单元拷贝只增加引用计数)
+  std::map<std::string, ConfigValueCell> live;
+  config_dict_.ForEach([&live](const std::string& path,
+                               const std::shared_ptr<ConfigEntry>& entry) {
+    std::shared_lock<std::shared_mutex> entry_lock(entry->entry_mutex);
+    if (entry->IsPersistent()) live[path] = entry->current_value;  // 运行时状态不进配方
+  });
+
+  // 2. 与未定型的“孤儿数据”归并后流式写入目标绝对路径，
+  // 保证配方导出时不会丢失未加载插件的配置
   try {
     std::ofstream ofs(target_path, std::ios::trunc);
     if (!ofs.is_open()) return false;
-    ofs << root.dump(4);
+    ConfigJsonWriter writer(ofs);
+    {
+      std::shared_lock<std::shared_mutex> cache_lock(cache_mutex_);
+      WriteMergedJson_UNLOCKED(writer, live);
+    }
+    writer.Finish();
     ofs.close();
-    return true;
+    return static_cast<bool>(ofs);
   } catch (...) {
     return false;
   }
@@ -1028,15 +1943,20 @@ bool ConfigProviderService::ImportFromFile(const std::string& source_path,
                                            bool apply_immediately) {
   std::error_code ec;
 
-  // 1. 利用标准库，原子级覆盖当前系统的配置文件 (config.json)
-  std::filesystem::copy_file(source_path, config_file_path_,
-                             std::filesystem::copy_options::overwrite_existing,
-                             ec);
-
-  if (ec) {
-    std::cerr << "[Config Error] Import failed. Cannot copy file: "
-              << ec.message() << std::endl;
-    return false;
+  {
+    std::lock_guard<std::mutex> io_lock(io_mutex_);
+    // 1. 利用标准库，原子级覆盖当前系统的配置文件 (config.json)
+    std::filesystem::copy_file(source_path, config_file_path_,
+                               std::filesystem::copy_options::overwrite_existing,
+                               ec);
+
+    if (ec) {
+      std::cerr << "[Config Error] Import failed. Cannot copy file: "
+                << ec.message() << std::endl;
+      return false;
+    }
+    // 旧日志记录的是导入前的变更，不能再重放到新配方上
+    std::filesystem::remove(config_journal_path_, ec);
   }
 
   // 2. 如果要求立刻生效，则直接调用我们之前写好的 ReloadFromFile
@@ -1051,39 +1971,221 @@ bool ConfigProviderService::ImportFromFile(const std::string& source_path,
 // 3. 前端的高级搜索与层级过滤 API
 // ============================================================================
 std::vector<std::string> ConfigProviderService::GetAllGroupKeys() const {
-  std::set<std::string> groups;
-  std::shared_lock<std::shared_mutex> dict_lock(dict_mutex_);
-
-  for (const auto& [path, entry_ptr] : config_dict_) {
-    // 只有非隐藏且设置了 GroupKey 的才返回给 UI
-    std::shared_lock<std::shared_mutex> entry_lock(entry_ptr->entry_mutex);
-    if (!entry_ptr->meta.is_hidden && !entry_ptr->meta.group_key.empty()) {
-      groups.insert(entry_ptr->meta.group_key);
-    }
-  }
-  return std::vector<std::string>(groups.begin(), groups.end());
+  // 只有含非隐藏节点且设置了 GroupKey 的分组才返回给 UI (索引维护计数，不碰节点锁)
+  return group_index_.VisibleGroupKeys();
 }
 
 std::map<std::string, ConfigSnapshot> ConfigProviderService::GetConfigsByGroup(
     const std::string& group_key) const {
   std::map<std::string, ConfigSnapshot> result;
-  std::shared_lock<std::shared_mutex> dict_lock(dict_mutex_);
 
-  for (const auto& [path, entry_ptr] : config_dict_) {
+  // 只遍历本组节点：其余分组的节点锁一把都不碰
+  group_index_.ForEachInGroup(group_key, [&](const std::string& path,
+                                             const std::shared_ptr<ConfigEntry>& entry_ptr) {
     // 【必须】给特定节点加读锁，防止在快照打包时该节点数据被其他线程篡改
     std::shared_lock<std::shared_mutex> entry_lock(entry_ptr->entry_mutex);
 
-    // 双重过滤：1. 隐藏参数不给前端 ； 2. Group 名称必须匹配
-    if (!entry_ptr->meta.is_hidden && entry_ptr->meta.group_key == group_key) {
+    // 隐藏参数不给前端
+    if (!entry_ptr->meta->is_hidden) {
       // 【修复】注入出厂默认值
-      result[path] = {entry_ptr->meta, entry_ptr->current_value,
-                      entry_ptr->default_value};
+      result[path] = {*entry_ptr->meta, entry_ptr->LiveValue(),
+                      entry_ptr->default_value.ToValue()};
     }
-  }
+  });
+
+  return result;
+}
 
+std::vector<ConfigGroupSummary> ConfigProviderService::GetGroupIndex() const {
+  // 只读索引里的计数：参数再多，开销也只与二级分组数成正比
+  std::vector<ConfigGroupSummary> result;
+  group_index_.ForEachVisibleSubgroup([&result](const std::string& group_key,
+                                                const std::string& subgroup_key,
+                                                size_t visible, size_t advanced) {
+    if (result.empty() || result.back().group_key != group_key) {
+      result.push_back({group_key, {}});
+    }
+    result.back().subgroups.push_back({subgroup_key, static_cast<uint32_t>(visible),
+                                       static_cast<uint32_t>(advanced)});
+  });
   return result;
 }
 
+std::vector<ConfigNavEntry> ConfigProviderService::GetSubgroupEntries(
+    const std::string& group_key, const std::string& subgroup_key) const {
+  std::vector<ConfigNavEntry> result;
+  group_index_.ForEachInSubgroup(
+      group_key, subgroup_key,
+      [&result](const std::string& path, const std::shared_ptr<ConfigEntry>& entry_ptr) {
+        std::shared_lock<std::shared_mutex> entry_lock(entry_ptr->entry_mutex);
+        const SchemaMetadata& meta = *entry_ptr->meta;
+        if (!meta.is_hidden) result.push_back({path, meta.name_key, meta.is_advanced});
+      });
+  return result;
+}
+
+// ============================================================================
+// 4. 配方覆盖层：预编译一次，切换时只写入差异
+// ============================================================================
+std::vector<std::string> ConfigProviderService::PrepareOverlay(
+    const std::string& name, const std::vector<ConfigChange>& values,
+    const std::string& operator_role) {
+  std::vector<std::string> errors;
+  auto overlay = std::make_shared<ConfigOverlay>();
+  overlay->operator_role = operator_role;
+
+  // 1. 解析路径。同一节点保留最后一项
+  std::vector<std::pair<std::shared_ptr<ConfigEntry>, size_t>> resolved;
+  resolved.reserve(values.size());
+  for (size_t i = 0; i < values.size(); ++i) {
+    auto entry = config_dict_.Find(values[i].path);
+    if (!entry) {
+      errors.push_back("Path does not exist:" + values[i].path);
+      continue;
+    }
+    resolved.emplace_back(std::move(entry), i);
+  }
+  if (!errors.empty()) return errors;
+  std::sort(resolved.begin(), resolved.end(), [](const auto& a, const auto& b) {
+    return a.first.get() != b.first.get() ? a.first.get() < b.first.get()
+                                          : a.second < b.second;
+  });
+  auto last_of_each = std::unique(
+      resolved.rbegin(), resolved.rend(),
+      [](const auto& a, const auto& b) { return a.first.get() == b.first.get(); });
+  resolved.erase(resolved.begin(), last_of_each.base());
+
+  // 2. 逐项校验 (节点读锁)，记录校验所依据的 Schema
+  overlay->items.reserve(resolved.size());
+  for (auto& [entry, index] : resolved) {
+    const ConfigChange& change = values[index];
+    std::string err;
+    std::shared_ptr<const SchemaMetadata> meta;
+    {
+      std::shared_lock<std::shared_mutex> entry_lock(entry->entry_mutex);
+      if (!ValidateInternal(*entry, change.value, operator_role, err)) {
+        errors.push_back("Validation failed for parameter [" + change.path +
+                         "]: " + err);
+        continue;
+      }
+      meta = entry->meta;
+    }
+    overlay->items.push_back(
+        {std::move(entry), change.path, ConfigValueCell(change.value), std::move(meta)});
+  }
+  if (!errors.empty()) return errors;
+
+  std::unique_lock<std::shared_mutex> overlay_lock(overlay_mutex_);
+  overlays_[name] = std::move(overlay);
+  return errors;
+}
+
+std::vector<std::string> ConfigProviderService::PrepareOverlayFromFile(
+    const std::string& name, const std::string& source_path,
+    const std::string& operator_role) {
+  std::ifstream ifs(source_path, std::ios::binary);
+  if (!ifs.is_open()) return {"Cannot open overlay file:" + source_path};
+
+  // 流式解析：每个成员读完立即按节点类型转换，文件本身不构建 DOM
+  std::vector<std::string> errors;
+  std::vector<ConfigChange> values;
+  std::string parse_error;
+  const bool parsed_ok = ConfigJsonObjectReader::ForEachMember(
+      ifs,
+      [&](const std::string& key, nlohmann::json value) {
+        const std::shared_ptr<ConfigEntry> entry = config_dict_.Find(key);
+        ConfigValue reference;
+        if (entry) {
+          std::shared_lock<std::shared_mutex> entry_lock(entry->entry_mutex);
+          reference = entry->default_value.ToValue();
+        }
+        // 未注册 (含占位节点) 的路径没有类型依据，无法预编译
+        ConfigValue parsed;
+        if (std::holds_alternative<std::monostate>(reference)) {
+          errors.push_back("Path does not exist:" + key);
+        } else if (!JsonToConfigValue(value, reference, parsed)) {
+          errors.push_back("Type mismatch for parameter [" + key + "]");
+        } else {
+          values.push_back({key, std::move(parsed)});
+        }
+      },
+      parse_error);
+  if (!parsed_ok) return {"Overlay file parse error: " + parse_error};
+  if (!errors.empty()) return errors;
+  return PrepareOverlay(name, values, operator_role);
+}
+
+std::vector<std::string> ConfigProviderService::ActivateOverlay(
+    const std::string& name) {
+  std::shared_ptr<const ConfigOverlay> overlay;
+  {
+    std::shared_lock<std::shared_mutex> overlay_lock(overlay_mutex_);
+    auto it = overlays_.find(name);
+    if (it == overlays_.end()) return {"Overlay does not exist:" + name};
+    overlay = it->second;
+  }
+
+  std::vector<std::string> errors;
+  std::vector<ConfigChangedEvent> audit_events;
+  std::vector<PendingNotification> batch_callbacks;
+  std::vector<ConfigChange> journal_changes;
+  const PluginPtr<z3y::IEventBus> audit_bus = AuditBus();
+  {
+    // 节点已在预编译时按地址排序去重，直接按序加锁
+    BatchLockGuard guard(overlay->items);
+
+    // 只有预编译之后 Schema 被替换过的节点才需要重新校验
+    for (const auto& item : overlay->items) {
+      if (item.entry->meta == item.validated_meta) continue;
+      std::string err;
+      if (!ValidateInternal(*item.entry, item.value.ToValue(), overlay->operator_role, err)) {
+        errors.push_back("Validation failed for parameter [" + item.path + "]: " + err);
+      }
+    }
+    if (!errors.empty()) return errors;
+
+    const uint64_t timestamp_ms = GetCurrentTimestampMs();
+    const std::string role =
+        overlay->operator_role.empty() ? "System_Overlay" : overlay->operator_role;
+    std::vector<ConfigChangeHistory::Change> history_changes;
+    for (const auto& item : overlay->items) {
+      if (item.entry->current_value == item.value) continue;  // 值相同的节点不产生任何动作
+      ConfigValue new_val = item.value.ToValue();
+      if (audit_bus) {
+        audit_events.push_back(MakeChangedEvent(item.path, item.entry->current_value.ToValue(),
+                                                new_val, role, timestamp_ms));
+      }
+      const bool persistent = item.entry->IsPersistent();
+      if (persistent && history_.enabled()) {
+        history_changes.push_back({item.path, item.entry->current_value, item.value});
+      }
+
+      item.entry->current_value = item.value;  // 只增加一次引用计数
+      shared_view_.Store(item.path, new_val);
+      if (item.entry->subscribers && !item.entry->subscribers->empty()) {
+        batch_callbacks.push_back({item.entry->subscribers, new_val});
+      }
+      if (persistent) journal_changes.push_back({item.path, std::move(new_val)});
+    }
+    history_.Append(history_changes.data(), history_changes.size(), role, timestamp_ms);
+  }
+
+  return PublishCommitted(batch_callbacks, audit_bus, audit_events, journal_changes);
+}
+
+bool ConfigProviderService::RemoveOverlay(const std::string& name) {
+  std::unique_lock<std::shared_mutex> overlay_lock(overlay_mutex_);
+  return overlays_.erase(name) > 0;
+}
+
+std::vector<std::string> ConfigProviderService::GetOverlayNames() const {
+  std::shared_lock<std::shared_mutex> overlay_lock(overlay_mutex_);
+  std::vector<std::string> names;
+  names.reserve(overlays_.size());
+  for (const auto& kv : overlays_) names.push_back(kv.first);
+  return names;
+}
+
 }  // namespace config
 }  // namespace plugins
 }  // namespace z3y
@@ -6,19 +6,40 @@
  * * 【并发模型与锁策略设计】
  * 为了应对工业级高频并发场景，本服务采用**极高精度的双重读写锁 (Double-Level
  * Read-Write Locks)** 结构：
- * 1. 拓扑锁 (dict_mutex_)：全局唯一的 std::shared_mutex。
- * - 仅用于保护 `config_dict_` 这个 std::unordered_map
- * 的增删（也就是节点注册阶段）。
- * - 当业务查询(GetValue) 或 修改(SetValue)
- * 某个特定节点时，只持有此全局锁的**共享读锁(shared_lock)**，
- * 因此不同路径的读写请求可以完全并行，绝不会互相阻塞。
+ * 1. 分片锁 (ConfigEntryTable)：`config_dict_` 按路径哈希分成 64 个分片，
+ * 每个分片一把 std::shared_mutex。
+ * - 查询(GetValue)、修改(SetValue)、订阅只锁目标路径所在的分片，插入占位节点
+ * 也只独占这一个分片，插件启动期成百上千次 Bind 不再排在同一把锁后面。
+ * - 孤儿数据 (`initial_load_cache_` / `binary_snapshot_`) 另由 `cache_mutex_`
+ * 保护，只在注册认领、加载与落盘时短暂持有。
+ * - 分组查询经 `group_index_` (group → subgroup → 路径) 只遍历目标分组。
  * 2. 节点锁 (entry_mutex)：每个 ConfigEntry 内部各自拥有一把
  * std::shared_mutex。
- * - 负责保护该节点内部的数据 `current_value` 和回调表 `callbacks`。
+ * - 负责保护该节点内部的数据 `current_value` 和订阅者列表 `subscribers`。
  * - GetValue 时使用节点级共享读锁，SetValue 时使用节点级独占写锁。
- * * 【未来计划】
- * - 加入 File Watcher，支持在文件系统被修改时触发基于增量解析的热重载 (Hot
- * Reload) 机制。
+ * * 【持久化模型：快照 + 变更日志】
+ * - `config.json` 是完整快照，`config.json.journal` 是只追加的变更日志，
+ * 每行一条 {"p": 路径, "v": 值, "t": 毫秒时间戳}。
+ * - 稳态下 Worker 只把防抖窗口内变化过的节点追加到日志，写盘量与变化量成正比。
+ * - 日志超过快照大小 (至少 64KB)、快照尚不存在、Reload 之后以及退出时，
+ * 压实为一次完整快照并清空日志。
+ * - 启动加载时先读快照再按顺序重放日志 (后者覆盖前者)，断电截断的末行被忽略。
+ * - 落盘节奏由 ConfigPersistencePolicy 决定：防抖窗口 + 最大延迟，或组提交
+ * (上一次提交结束即提交)。开启 fsync 时，临时文件在重命名前、日志在追加后都会刷到
+ * 物理介质，重命名后再同步所在目录。Flush() 跳过防抖并等待提交序号追上调用时刻。
+ * - 每次写完整快照时顺带写 `config.json.bin` (见 ConfigBinarySnapshot)。启动时
+ * 若它与 config.json 同源 (长度与哈希一致)，注册时直接从二进制索引取值，跳过 JSON 解析。
+ * - 提交不再占用专属线程：防抖截止时间作为定时器预约在框架共享执行器
+ * (IExecutorService) 上，到期后在池线程上执行一次提交；同一时刻最多一个提交在进行。
+ * 框架没有提供执行器时退化为在调用线程上同步提交。
+ * - 开启文件监视 (SetFileWatch) 后记住上一份 config.json 的长度、哈希与逐键值哈希：
+ * 自身写盘的事件据此忽略，外部修改只应用值哈希变化了的键。
+ * - 每次实际修改都在节点锁内追加到修改历史 (ConfigChangeHistory)；超出保留条数被淘汰的
+ * 记录随提交任务追加到 ConfigHistoryPolicy::spill_path。
+ * - 发布共享视图 (PublishSharedView) 后，每次实际修改还在节点锁内写入共享内存区域
+ * (ConfigSharedViewWriter)，同机其它进程经 IConfigSharedView 免锁读取。
+ * - SetValueAsync 把写入压入免锁栈 (调用线程不取任何服务锁)，栈由空变非空时才向专属
+ * 写入线程投递一次排空；排空时同一路径只执行最后一次 SetValue。
  */
 #pragma once
 #ifndef Z3Y_CONFIG_PROVIDER_SERVICE_H_
@@ -26,12 +47,27 @@
 
 #include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <future>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <shared_mutex>
-#include <thread>
 #include <unordered_map>
 #include <nlohmann/json.hpp>
 #include "interfaces_core/i_config_service.h"
+#include "config_binary_snapshot.h"
+#include "config_change_history.h"
+#include "config_entry_table.h"
+#include "config_file_watcher.h"
+#include "config_group_index.h"
+#include "config_json_stream.h"
+#include "config_schema_store.h"
+#include "config_shared_view.h"
+#include "config_subscription.h"
+#include "config_value_cell.h"
+#include "framework/i_event_bus.h"
+#include "framework/i_executor_service.h"
 #include "framework/z3y_define_impl.h"
 
 namespace z3y {
@@ -43,16 +79,47 @@ using namespace z3y::interfaces::core;
  * @brief 数据节点模型，表示单个配置项在内存中的全部信息。
  */
 struct ConfigEntry {
-  SchemaMetadata meta; /**< 该节点的 Schema 规则约束 */
-  ConfigValue current_value; /**< 当前处于合法生效状态的值 */
-  ConfigValue default_value; /**< 当重置或节点转正时参考的默认值 */
+  /** 该节点的 Schema 规则约束 (ConfigSchemaStore 中驻留的只读记录，可被多个节点共享) */
+  std::shared_ptr<const SchemaMetadata> meta = ConfigSchemaStore::Empty().meta;
+  /** 由 meta 编译出的校验对象，始终与 meta 成对替换 */
+  std::shared_ptr<const ConfigSchemaCheck> check = ConfigSchemaStore::Empty().check;
+  ConfigValueCell current_value; /**< 当前处于合法生效状态的值 */
+  ConfigValueCell default_value; /**< 当重置或节点转正时参考的默认值 (占位节点为空) */
 
   mutable std::shared_mutex entry_mutex; /**< [关键] 保护当前这一条记录的超细粒度读写锁 */
 
-  /** * @brief 存储注册到该节点的所有回调闭包。
-   * key 是一次性生成的自增 id，便于后期 O(1) 复杂度注销。
+  /** * @brief 注册到该节点的全部订阅者 (写时复制，可为空)。
+   * 通知时在锁内只复制这个 shared_ptr，锁外逐个按投递模式派发。
    */
-  std::map<uint64_t, std::function<void(const ConfigValue&)>> callbacks;
+  std::shared_ptr<const ConfigSubscriberList> subscribers;
+
+  /** 监视参数 (is_monitor) 的无锁值单元，此时它代替 current_value 保存当前值；其余节点为空 */
+  std::shared_ptr<ConfigMonitorCell> monitor;
+
+  /** @brief 修改是否需要记入历史并落盘：易失参数与监视参数不需要 (调用方持有 entry_mutex)。 */
+  bool IsPersistent() const { return !meta->is_volatile && !monitor; }
+
+  /** @brief 对外可见的当前值 (调用方持有 entry_mutex)。 */
+  ConfigValue LiveValue() const {
+    return monitor ? monitor->Load() : current_value.ToValue();
+  }
+};
+
+/**
+ * @brief 预编译的配方覆盖层 (PrepareOverlay 生成，ActivateOverlay 写入)。
+ * @details 登记后不再修改：激活时只在 overlay_mutex_ 下复制一次 shared_ptr，
+ * 与并发的 Prepare/Remove 互不阻塞。
+ */
+struct ConfigOverlay {
+  struct Item {
+    std::shared_ptr<ConfigEntry> entry; /**< 已解析的目标节点，激活时不再查字典 */
+    std::string path;
+    ConfigValueCell value; /**< 已通过校验的值 */
+    /** 校验时节点的 Schema 记录；激活时若已被替换 (UpdateEnumSchema) 则重新校验 */
+    std::shared_ptr<const SchemaMetadata> validated_meta;
+  };
+  std::vector<Item> items; /**< 按节点地址排序且节点唯一，激活时直接按序加锁 */
+  std::string operator_role;
 };
 
 /**
@@ -78,9 +145,13 @@ class ConfigProviderService
 
   bool SetValue(const std::string& path, const ConfigValue& value,
                 const std::string& operator_role) override;
+  std::future<bool> SetValueAsync(const std::string& path, ConfigValue value,
+                                  const std::string& operator_role) override;
   std::vector<std::string> ApplyBatch(
       const std::map<std::string, ConfigValue>& changes,
       const std::string& operator_role) override;
+  std::vector<std::string> ApplyChanges(const std::vector<ConfigChange>& changes,
+                                        const std::string& operator_role) override;
 
   bool UpdateEnumSchema(const std::string& path, 
                         const std::vector<std::string>& new_values, 
@@ -88,11 +159,17 @@ class ConfigProviderService
 
   void RegisterSchema(const std::string& path, const SchemaMetadata& meta,
                       const ConfigValue& default_val) override;
+  std::vector<uint64_t> RegisterSchemas(std::vector<SchemaRegistration>& items) override;
   uint64_t InternalSubscribe(
       const std::string& path,
       std::function<void(const ConfigValue&)> cb) override;
+  uint64_t InternalSubscribeWithDelivery(
+      const std::string& path, std::function<void(const ConfigValue&)> cb,
+      ConnectionType type, std::shared_ptr<IEventExecutor> executor) override;
   void InternalUnsubscribe(const std::string& path, uint64_t cb_id) override;
   ConfigValue GetValue(const std::string& path) const override;
+  std::shared_ptr<const ConfigValue> GetValueShared(const std::string& path) const override;
+  std::shared_ptr<ConfigMonitorCell> GetMonitorCell(const std::string& path) const override;
 
   std::shared_ptr<void> GetAliveToken() const override { return alive_token_; }
 
@@ -106,11 +183,80 @@ class ConfigProviderService
   bool ImportFromFile(const std::string& source_path,
                       bool apply_immediately = true) override;
 
+  std::vector<std::string> PrepareOverlay(const std::string& name,
+                                          const std::vector<ConfigChange>& values,
+                                          const std::string& operator_role) override;
+  std::vector<std::string> PrepareOverlayFromFile(
+      const std::string& name, const std::string& source_path,
+      const std::string& operator_role) override;
+  std::vector<std::string> ActivateOverlay(const std::string& name) override;
+  bool RemoveOverlay(const std::string& name) override;
+  std::vector<std::string> GetOverlayNames() const override;
+
   std::vector<std::string> GetAllGroupKeys() const override;
   std::map<std::string, ConfigSnapshot> GetConfigsByGroup(
       const std::string& group_key) const override;
+  std::vector<z3y::interfaces::core::ConfigGroupSummary> GetGroupIndex() const override;
+  std::vector<z3y::interfaces::core::ConfigNavEntry> GetSubgroupEntries(
+      const std::string& group_key, const std::string& subgroup_key) const override;
+
+  void SetPersistencePolicy(const ConfigPersistencePolicy& policy) override;
+  bool Flush(uint32_t timeout_ms = 5000) override;
+  ConfigPersistenceStats GetPersistenceStats() const override;
+  bool SetFileWatch(bool enabled, uint32_t debounce_ms = 200) override;
+  void SetHistoryPolicy(const ConfigHistoryPolicy& policy) override;
+  std::vector<ConfigHistoryRecord> QueryHistory(const ConfigHistoryQuery& query) const override;
+  bool PublishSharedView(const ConfigSharedViewOptions& options, std::string& out_error) override;
+  void StopSharedView() override;
+  ConfigSharedViewStats GetSharedViewStats() const override;
 
  private:
+  /** @brief 从文件读到的一批变更 (锁外派发的回调、审计事件)。 */
+  struct FileApplyResult {
+    std::vector<PendingNotification> callbacks;
+    std::vector<ConfigChangedEvent> audit_events;
+    bool any_changed = false;
+  };
+
+  /**
+   * @brief 流式应用文件中的成员 (ReloadFromFile 与文件监视共用)。
+   * @param baseline 非空时只应用值哈希与其不同的键 (增量)；为空时全部应用，
+   * 并丢弃已与文件不同源的二进制快照。
+   * @param out_hashes 非空时记录文件中每个键的值哈希，作为下一次比对的基线。
+   * @return 顶层不是对象时返回 false (此时尚未应用任何值)。
+   */
+  bool ApplyFileMembers(std::istream& input, const std::string& role,
+                        const std::unordered_map<std::string, uint64_t>* baseline,
+                        std::unordered_map<std::string, uint64_t>* out_hashes,
+                        FileApplyResult& result, std::string& out_error);
+
+  /** @brief 锁外派发 ApplyFileMembers 收集的回调与审计事件，并登记落盘。检测到循环更新返回 false。 */
+  bool PublishFileApply(const FileApplyResult& result, const char* source);
+
+  /** @brief 一次排队的异步写入 (免锁栈上的节点)。 */
+  struct AsyncWrite {
+    AsyncWrite* next = nullptr;
+    std::string path;
+    ConfigValue value;
+    std::string operator_role;
+    std::promise<bool> done;
+  };
+
+  /** @brief 取走全部排队的异步写入，按提交顺序 (先进先出) 排列。 */
+  std::vector<std::unique_ptr<AsyncWrite>> TakeAsyncWrites();
+
+  /**
+   * @brief [写入线程 / Shutdown] 执行排队的异步写入：同一路径只执行最后一次 SetValue，
+   * 被合并的写入以同一结果兑现。
+   */
+  void DrainAsyncWrites();
+
+  /** @brief [监视线程] 文件事件去抖后调用：内容与基线相同则忽略，否则增量应用。 */
+  void OnConfigFileChanged();
+
+  /** @brief 按当前 config_file_path_ 启动监视并重建基线。调用方持有 watch_control_mutex_。 */
+  bool StartFileWatch_UNLOCKED();
+
   /** @brief 内部加载逻辑：将 json 读取到初始缓存池 initial_load_cache_ 中。 */
   void LoadFromFile();
 
@@ -120,14 +266,73 @@ class ConfigProviderService
   bool ValidateInternal(const ConfigEntry& entry, const ConfigValue& new_val,
                         const std::string& role, std::string& out_error) const;
 
-  /** @brief 极速返回的异步保存触发器。只修改标记，不阻塞业务线程。 */
+  /** @brief 批量注册时达到此项数才把类型反演与校验分给多个线程。 */
+  static constexpr size_t kParallelClaimThreshold = 512;
+
+  /** @brief 有人订阅 ConfigChangedEvent 时返回事件总线，否则返回空 (此时不构造审计事件)。 */
+  PluginPtr<z3y::IEventBus> AuditBus() const;
+
+  /**
+   * @brief 事务提交后的锁外阶段：派发回调、广播审计事件、登记落盘。
+   * @return 检测到循环更新时返回错误 (此时不再广播与落盘)，否则为空。
+   */
+  std::vector<std::string> PublishCommitted(
+      const std::vector<PendingNotification>& batch_callbacks,
+      const PluginPtr<z3y::IEventBus>& audit_bus,
+      const std::vector<ConfigChangedEvent>& audit_events,
+      const std::vector<ConfigChange>& journal_changes);
+
+  /** @brief 极速返回的异步保存触发器 (压实为完整快照)。只修改标记，不阻塞业务线程。 */
   void AsyncSaveSnapshot();
 
-   /** * @brief 专属后台 IO 守护线程的核心执行体。
-   * @details 采用带有“睡眠抖动合并”设计的 Wait-Condition
-   * 模型，极大地降低了高频写盘造成的 I/O 开销。
+  /** @brief 登记已生效的变更，由 Worker 防抖后追加到变更日志。 */
+  void AsyncAppendJournal(const std::vector<ConfigChange>& changes);
+
+  /** @brief 一次事务改变的节点数达到此值时直接压实为完整快照，不逐项追加日志。 */
+  static constexpr size_t kSnapshotBatchThreshold = 256;
+
+  /** @brief 登记一次待落盘修改 (推进 requested_seq_ 与防抖时间点)，调用方持有 worker_mutex_。 */
+  void MarkDirty_UNLOCKED();
+
+  /** @brief [提交任务] 把全部节点写成完整快照 (原子重命名) 并清空变更日志。失败返回 false。 */
+  bool WriteFullSnapshot(bool fsync);
+
+  /**
+   * @brief 按键名顺序流式写出全部配置 (二进制快照 < 孤儿缓存 < live，同名时后者覆盖)。
+   * @details 落盘快照与导出配方共用，不构建整个文件的 DOM。调用方持有 cache_mutex_ 读锁。
    */
-  void WorkerRoutine();
+  void WriteMergedJson_UNLOCKED(ConfigJsonWriter& writer,
+                                const std::map<std::string, ConfigValueCell>& live) const;
+
+  /** @brief [提交任务] 追加变更日志。失败返回 false，由调用方改为压实。 */
+  bool AppendJournal(const std::map<std::string, ConfigValue>& changes, bool fsync);
+
+  /** @brief 按顺序重放变更日志到 initial_load_cache_ (LoadFromFile 调用)。 */
+  void ReplayJournal();
+
+  /**
+   * @brief 本轮修改的提交截止时间：最后一次修改 + debounce_ms 与首次修改 + max_latency_ms
+   * 取先到者，期间的修改合并为一次写盘。组提交与 Flush 时不等待 (返回时间原点)。
+   */
+  std::chrono::steady_clock::time_point CommitDeadline_UNLOCKED() const;
+
+  /** @brief 有待落盘的修改且没有提交在进行时，预约 (或提前) 一次提交。调用方持有 worker_mutex_。 */
+  void RequestCommit_UNLOCKED(std::unique_lock<std::mutex>& lock);
+
+  /** @brief 同上，自行加锁。 */
+  void RequestCommit();
+
+  /** @brief 在执行器上按截止时间预约提交定时器。执行器已停止时返回 false。 */
+  bool ArmCommitTimer_UNLOCKED(z3y::IExecutorService& executor);
+
+  /** @brief [池线程] 提交定时器到期：截止时间被新的修改推后则重新预约，否则提交一次。 */
+  void OnCommitTimer();
+
+  /**
+   * @brief 取走积攒的变更并提交一次 (期间释放 worker_mutex_)。
+   * @param stopping 退出前的最后一次提交：总是写完整快照。
+   */
+  void RunCommit(std::unique_lock<std::mutex>& lock, bool stopping);
 
  private:
   /** * @brief 未定型数据孤儿院。
@@ -139,20 +344,85 @@ class ConfigProviderService
   std::unordered_map<std::string, nlohmann::json> initial_load_cache_;
   std::string config_file_path_ = "config.json"; /**< 真实配置文件存放路径 */
   std::string config_tmp_path_ = "config.json.tmp"; /**< 用于实现原子覆写的临时文件路径 */
+  std::string config_journal_path_ = "config.json.journal"; /**< 只追加的变更日志路径 */
+  std::string config_binary_path_ = "config.json.bin"; /**< 二进制伴生快照路径 */
 
-  /** @brief 核心字典拓扑结构：路径字符串映射到共享指针节点。 */
-  std::unordered_map<std::string, std::shared_ptr<ConfigEntry>> config_dict_;
-  mutable std::shared_mutex dict_mutex_; /**< 保护字典拓扑结构的全局读写锁 */
+  /** @brief 与 config.json 同源时加载的二进制快照 (优先级低于 initial_load_cache_)，受 cache_mutex_ 保护 */
+  ConfigBinarySnapshot binary_snapshot_;
+  /** @brief 保护 initial_load_cache_、binary_snapshot_ 与存储路径。锁顺序：cache_mutex_ → 分片锁 → 节点锁 */
+  mutable std::shared_mutex cache_mutex_;
+
+  /** @brief 核心字典拓扑结构：按路径哈希分片，路径字符串映射到共享指针节点 (只增不删)。 */
+  ConfigEntryTable<ConfigEntry> config_dict_;
+  /** @brief 分组二级索引 (group → subgroup → 路径)，RegisterSchema 时登记，供 UI 分组查询。 */
+  ConfigGroupIndex<ConfigEntry> group_index_;
+  /** @brief Schema 驻留仓库：内容相同的 Schema 只保留一份 (节点持有其只读记录)。 */
+  ConfigSchemaStore schema_store_;
+  /** @brief 修改历史：在节点锁内追加 (叶子锁)，淘汰记录由提交任务写出。 */
+  ConfigChangeHistory history_;
+  /** @brief 共享内存只读视图的发布端：在节点锁内写入 (叶子锁)，未发布时 Store 立即返回。 */
+  ConfigSharedViewWriter shared_view_;
+  mutable std::shared_mutex overlay_mutex_; /**< 保护 overlays_ (只交换指针，不碰节点锁) */
+  std::map<std::string, std::shared_ptr<const ConfigOverlay>> overlays_; /**< 已预编译的配方覆盖层 */
   std::atomic<uint64_t> next_cb_id_{1}; /**< 全局自增 ID 生成器，用于派发回调句柄 */
   std::shared_ptr<void> alive_token_;  /**< 框架级防坠网生还标志。生命周期与插件相同 */
+  std::weak_ptr<z3y::IEventBus> event_bus_; /**< Initialize 时取得，广播审计事件时不再逐次查找服务 */
+  ConfigNotifyExecutor notify_executor_; /**< 未指定执行器的排队订阅在此线程回调 */
+
+  // ---------------- 异步写入 (SetValueAsync) ----------------
+  std::atomic<AsyncWrite*> async_head_{nullptr}; /**< 免锁栈顶 (后进先出，排空时逆序还原) */
+  std::atomic<bool> async_scheduled_{false}; /**< 已投递一次排空且尚未开始执行 */
+  std::atomic<bool> async_stopped_{false};   /**< Shutdown 之后拒绝新的异步写入 */
+  std::mutex async_drain_mutex_; /**< 串行化排空，保证同一路径的写入按顺序生效 */
+  ConfigNotifyExecutor async_writer_{"config.async_writer"}; /**< 执行异步写入的专属线程 */
 
-  // ---------------- 后台工作线程专属成员 (Worker Thread) ----------------
-  std::thread worker_thread_; /**< 负责落盘操作的实际线程对象 */
-  std::mutex worker_mutex_; /**< 守护下面脏标记和条件变量的专有互斥锁 */
-  std::condition_variable worker_cv_; /**< 用于阻塞和唤醒 Worker 线程 */
+  // ---------------- 落盘提交状态 (提交任务运行在框架共享执行器上) ----------------
+  std::weak_ptr<z3y::IExecutorService> executor_; /**< Initialize 时取得；弱引用，避免与框架互相持有 */
+  std::mutex worker_mutex_; /**< 守护下面的脏标记、提交预约与序号 */
+  z3y::TimerId commit_timer_ = 0; /**< 已预约、尚未开始的提交定时器 (0 表示没有) */
+  std::chrono::steady_clock::time_point commit_deadline_; /**< commit_timer_ 的到期时间 */
+  bool commit_running_ = false; /**< 是否有提交正在进行 (提交之间互斥) */
 
   bool is_snapshot_dirty_ = false;  /**< 脏数据标志位，表示内存数据发生改变且未落盘 */
+  bool compact_requested_ = false;  /**< 下一次落盘必须写完整快照 (AsyncSaveSnapshot) */
+  std::map<std::string, ConfigValue> pending_changes_; /**< 待追加到日志的变更 (同路径只留最新) */
+  std::mutex io_mutex_; /**< 串行化提交落盘与 ImportFromFile 覆盖文件 */
   bool stop_worker_ = false; /**< 优雅退出标志，接通 Shutdown() 的终止信号 */
+
+  ConfigPersistencePolicy policy_; /**< 落盘策略 (受 worker_mutex_ 保护) */
+  std::chrono::steady_clock::time_point first_change_time_; /**< 本轮首个未落盘修改的时间 */
+  std::chrono::steady_clock::time_point last_change_time_;  /**< 本轮最后一次修改的时间 */
+  uint64_t requested_seq_ = 0; /**< 已登记的修改序号 (每次 MarkDirty 加一) */
+  uint64_t durable_seq_ = 0;   /**< 已成功落盘的最大修改序号 */
+  uint64_t attempted_seq_ = 0; /**< 已尝试提交的最大修改序号 (含失败) */
+  bool flush_requested_ = false; /**< Flush() 要求跳过剩余防抖等待 */
+  bool worker_exited_ = false;   /**< 已完成退出前的最后一次提交，Flush 不再等待 */
+  std::condition_variable flush_cv_; /**< 每次提交结束 (或预约离场) 后唤醒等待中的 Flush() / Shutdown() */
+
+  // ---------------- 外部修改监视 ----------------
+  /** @brief 上一份 config.json (自身写盘或最近一次被应用的外部文件) 的指纹。 */
+  struct FileWatchBaseline {
+    bool valid = false;  ///< false：文件不存在或尚未读取，任何事件都按外部修改处理
+    uint64_t size = 0;
+    uint64_t hash = 0;
+    std::unordered_map<std::string, uint64_t> members;  ///< 键 → ConfigJsonWriter::ValueHash
+  };
+  std::mutex watch_control_mutex_; /**< 串行化监视的启停 (SetFileWatch / SetStoragePath) */
+  ConfigFileWatcher file_watcher_;
+  uint32_t watch_debounce_ms_ = 200;
+  std::atomic<bool> file_watch_enabled_{false}; /**< 为 true 时写快照顺带记录逐键哈希 */
+  std::mutex watch_mutex_; /**< 保护 watch_baseline_ */
+  FileWatchBaseline watch_baseline_;
+  std::atomic<uint64_t> external_reloads_{0};
+  std::atomic<uint64_t> external_ignored_{0};
+
+  // 落盘统计：提交之间互斥，同一时刻只有一个写者；GetPersistenceStats 无锁读取
+  std::atomic<uint64_t> commit_count_{0};      /**< 成功提交次数 */
+  std::atomic<uint64_t> commit_failures_{0};   /**< 失败提交次数 */
+  std::atomic<uint64_t> snapshot_writes_{0};   /**< 完整快照落盘次数 */
+  std::atomic<uint64_t> commit_total_ns_{0};   /**< 全部提交的累计耗时 */
+  std::atomic<uint64_t> last_commit_ns_{0};    /**< 最近一次提交耗时 */
+  std::atomic<uint64_t> max_commit_ns_{0};     /**< 单次提交最大耗时 */
 };
 }  // namespace config
 }  // namespace plugins
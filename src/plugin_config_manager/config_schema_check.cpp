@@ -0,0 +1,127 @@
+﻿/**
+ * @file config_schema_check.cpp
+ * @brief ConfigSchemaCheck 的实现。
+ */
+#include "config_schema_check.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <vector>
+
+#include "config_array_scan.h"
+
+namespace z3y {
+namespace plugins {
+namespace config {
+
+ConfigSchemaCheck::ConfigSchemaCheck(const SchemaMetadata& meta)
+    : read_only_(meta.read_only),
+      permission_token_(meta.permission_token),
+      custom_validator_(meta.custom_validator) {
+  if (const auto* v = std::get_if<int64_t>(&meta.min_val)) {
+    has_int_min_ = true;
+    int_min_ = *v;
+  }
+  if (const auto* v = std::get_if<int64_t>(&meta.max_val)) {
+    has_int_max_ = true;
+    int_max_ = *v;
+  }
+  if (const auto* v = std::get_if<double>(&meta.min_val)) {
+    has_double_min_ = true;
+    double_min_ = *v;
+  }
+  if (const auto* v = std::get_if<double>(&meta.max_val)) {
+    has_double_max_ = true;
+    double_max_ = *v;
+  }
+  enum_values_.insert(meta.enum_values.begin(), meta.enum_values.end());
+}
+
+bool ConfigSchemaCheck::Validate(const ConfigValue& new_val, size_t type_index,
+                                 const std::string& role, bool check_enum,
+                                 std::string& out_error) const {
+  if (read_only_) {
+    out_error = "Parameter is read-only.";
+    return false;
+  }
+
+  // 极度细粒度的权限校验拦截
+  if (!permission_token_.empty() && role != permission_token_) {
+    out_error = "Insufficient permissions.";
+    return false;
+  }
+
+  // 阻止一切试图改变底层数据类型的变体覆盖操作
+  if (new_val.index() != type_index) {
+    out_error = "Data type mismatch.";
+    return false;
+  }
+
+  // -------------各类型的刚性数值边界校验逻辑---------------------
+  if (const auto* val = std::get_if<int64_t>(&new_val)) {
+    if (has_int_min_ && *val < int_min_) {
+      out_error = "Value is below the allowed minimum.";
+      return false;
+    }
+    if (has_int_max_ && *val > int_max_) {
+      out_error = "Value exceeds the allowed maximum.";
+      return false;
+    }
+  } else if (const auto* val = std::get_if<double>(&new_val)) {
+    if (has_double_min_ && *val < double_min_) {
+      out_error = "Floating-point value is below the allowed minimum.";
+      return false;
+    }
+    if (has_double_max_ && *val > double_max_) {
+      out_error = "Floating-point value exceeds the allowed maximum.";
+      return false;
+    }
+  } else if (const auto* vec = std::get_if<std::vector<int64_t>>(&new_val)) {
+    if (has_int_min_ || has_int_max_) {
+      const int64_t lo = has_int_min_ ? int_min_ : INT64_MIN;
+      const int64_t hi = has_int_max_ ? int_max_ : INT64_MAX;
+      const size_t i = FindInt64OutOfRange(vec->data(), vec->size(), lo, hi);
+      if (i != vec->size()) {
+        out_error = "Value of array element at index " + std::to_string(i) +
+                    ((*vec)[i] < lo ? " is below the allowed minimum."
+                                    : " exceeds the allowed maximum.");
+        return false;
+      }
+    }
+  } else if (const auto* vec = std::get_if<std::vector<double>>(&new_val)) {
+    // 数组元素一律要求有限值 (JSON 无法表示 NaN / Inf)，无边界时也扫描
+    const double lo = has_double_min_ ? std::max(double_min_, -DBL_MAX) : -DBL_MAX;
+    const double hi = has_double_max_ ? std::min(double_max_, DBL_MAX) : DBL_MAX;
+    const size_t i = FindDoubleOutOfRange(vec->data(), vec->size(), lo, hi);
+    if (i != vec->size()) {
+      const double v = (*vec)[i];
+      out_error = "Value of array element at index " + std::to_string(i) +
+                  (!std::isfinite(v) ? " is not a finite number."
+                   : v < lo          ? " is below the allowed minimum."
+                                     : " exceeds the allowed maximum.");
+      return false;
+    }
+  } else if (const auto* text = std::get_if<std::string>(&new_val)) {
+    // 下拉框的后台值：只有字符串节点按字典校验 (整型枚举的 enum_values 仅供显示)
+    if (check_enum && !enum_values_.empty() && enum_values_.count(*text) == 0) {
+      out_error = "Value is not one of the allowed options.";
+      return false;
+    }
+  }
+
+  // 【自定义高级校验防线】：这是最后一关，将权利交回给业务插件自己写死的 Lambda
+  if (custom_validator_) {
+    // 此时已经保证了 new_val 的底层类型正确，大胆执行闭包
+    std::string custom_err = custom_validator_(new_val);
+    if (!custom_err.empty()) {
+      out_error = std::move(custom_err);  // 拦截！将业务提供的中文报错原因透传给外部
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace config
+}  // namespace plugins
+}  // namespace z3y
@@ -0,0 +1,63 @@
+﻿/**
+ * @file config_schema_check.h
+ * @brief 由 SchemaMetadata 编译出的校验对象：写入时不再逐项解读 Schema。
+ * * @details
+ * 每条驻留的 Schema (ConfigSchemaStore) 在驻留时编译一次，与 Schema 同分配、同生命周期：
+ * - 最小 / 最大值按节点类型预先取出为 int64 / double，校验时不再 holds_alternative + get。
+ * - 数值数组的边界由 config_array_scan 按块向量化扫描；浮点数组元素另须为有限值。
+ * - 字符串节点的 enum_values 编为哈希集合。
+ * - custom_validator 不复制，直接引用 Schema 记录中的 std::function。
+ * 校验对象不可变，可被多个线程同时使用 (custom_validator 本身是否可重入由业务保证)。
+ */
+#pragma once
+#ifndef Z3Y_CONFIG_SCHEMA_CHECK_H_
+#define Z3Y_CONFIG_SCHEMA_CHECK_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_set>
+
+#include "interfaces_core/config_types.h"
+
+namespace z3y {
+namespace plugins {
+namespace config {
+using namespace z3y::interfaces::core;
+
+class ConfigSchemaCheck {
+ public:
+  /** @param meta 编译来源；custom_validator 以引用保存，meta 须比本对象活得久。 */
+  explicit ConfigSchemaCheck(const SchemaMetadata& meta);
+
+  /**
+   * @brief 依次校验只读、权限、类型、数值边界、枚举集合与自定义校验。
+   * @param type_index 节点默认值的 ConfigValue::index()，new_val 必须与之相同。
+   * @param check_enum false 时跳过枚举集合 (从磁盘认领的旧值，字典可能尚未刷新)。
+   */
+  bool Validate(const ConfigValue& new_val, size_t type_index, const std::string& role,
+                bool check_enum, std::string& out_error) const;
+
+ private:
+  bool read_only_;
+  std::string permission_token_;
+
+  bool has_int_min_ = false;
+  bool has_int_max_ = false;
+  int64_t int_min_ = 0;
+  int64_t int_max_ = 0;
+  bool has_double_min_ = false;
+  bool has_double_max_ = false;
+  double double_min_ = 0.0;
+  double double_max_ = 0.0;
+
+  std::unordered_set<std::string> enum_values_;  ///< 空 = 不限制
+  const std::function<std::string(const ConfigValue&)>& custom_validator_;
+};
+
+}  // namespace config
+}  // namespace plugins
+}  // namespace z3y
+
+#endif  // Z3Y_CONFIG_SCHEMA_CHECK_H_
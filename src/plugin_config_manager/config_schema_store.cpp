@@ -0,0 +1,121 @@
+﻿/**
+ * @file config_schema_store.cpp
+ * @brief ConfigSchemaStore 的实现。
+ */
+#include "config_schema_store.h"
+
+#include <functional>
+#include <string>
+
+namespace z3y {
+namespace plugins {
+namespace config {
+
+namespace {
+
+void HashCombine(size_t& seed, size_t value) {
+  seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+
+size_t HashValue(const ConfigValue& value) {
+  size_t seed = value.index();
+  std::visit(
+      [&seed](const auto& v) {
+        using T = std::decay_t<decltype(v)>;
+        if constexpr (std::is_same_v<T, std::monostate>) {
+        } else if constexpr (std::is_arithmetic_v<T> || std::is_same_v<T, std::string>) {
+          HashCombine(seed, std::hash<T>{}(v));
+        } else {
+          using E = typename T::value_type;
+          for (const auto& e : v) HashCombine(seed, std::hash<E>{}(e));
+        }
+      },
+      value);
+  return seed;
+}
+
+}  // namespace
+
+/** @brief 一次分配同时存放 Schema 与校验对象 (校验对象引用 meta 中的 custom_validator)。 */
+struct ConfigSchemaStore::Record {
+  explicit Record(const SchemaMetadata& m) : meta(m), check(meta) {}
+  SchemaMetadata meta;
+  ConfigSchemaCheck check;
+};
+
+ConfigSchemaStore::Interned ConfigSchemaStore::Make(const SchemaMetadata& meta) {
+  auto record = std::make_shared<const Record>(meta);
+  return {std::shared_ptr<const SchemaMetadata>(record, &record->meta),
+          std::shared_ptr<const ConfigSchemaCheck>(record, &record->check)};
+}
+
+const ConfigSchemaStore::Interned& ConfigSchemaStore::Empty() {
+  static const Interned empty = Make(SchemaMetadata{});
+  return empty;
+}
+
+size_t ConfigSchemaStore::HashOf(const SchemaMetadata& meta) {
+  std::hash<std::string> hs;
+  size_t seed = 0;
+  for (const std::string* s :
+       {&meta.name_key, &meta.group_key, &meta.subgroup_key, &meta.tooltip_key,
+        &meta.enable_condition, &meta.file_filter, &meta.permission_token,
+        &meta.custom_ui_key, &meta.custom_args}) {
+    HashCombine(seed, hs(*s));
+  }
+  HashCombine(seed, HashValue(meta.min_val));
+  HashCombine(seed, HashValue(meta.max_val));
+  HashCombine(seed, HashValue(meta.step_val));
+  for (const auto& s : meta.enum_values) HashCombine(seed, hs(s));
+  for (const auto& s : meta.enum_display_keys) HashCombine(seed, hs(s));
+  HashCombine(seed, static_cast<size_t>(meta.widget_type));
+  HashCombine(seed, (meta.is_advanced ? 1u : 0u) | (meta.is_hidden ? 2u : 0u) |
+                        (meta.read_only ? 4u : 0u) | (meta.requires_restart ? 8u : 0u) |
+                        (meta.is_monitor ? 16u : 0u) | (meta.is_volatile ? 32u : 0u));
+  return seed;
+}
+
+bool ConfigSchemaStore::SameSchema(const SchemaMetadata& a, const SchemaMetadata& b) {
+  return a.name_key == b.name_key && a.group_key == b.group_key &&
+         a.subgroup_key == b.subgroup_key && a.tooltip_key == b.tooltip_key &&
+         a.enable_condition == b.enable_condition && a.min_val == b.min_val &&
+         a.max_val == b.max_val && a.step_val == b.step_val &&
+         a.enum_values == b.enum_values && a.enum_display_keys == b.enum_display_keys &&
+         a.file_filter == b.file_filter && a.permission_token == b.permission_token &&
+         a.widget_type == b.widget_type && a.is_advanced == b.is_advanced &&
+         a.is_hidden == b.is_hidden && a.read_only == b.read_only &&
+         a.requires_restart == b.requires_restart && a.is_monitor == b.is_monitor &&
+         a.is_volatile == b.is_volatile &&
+         a.custom_ui_key == b.custom_ui_key && a.custom_args == b.custom_args;
+}
+
+ConfigSchemaStore::Interned ConfigSchemaStore::Intern(const SchemaMetadata& meta) {
+  if (meta.custom_validator) {
+    // std::function 无法判等：独立存放
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      ++unique_count_;
+    }
+    return Make(meta);
+  }
+  const size_t hash = HashOf(meta);
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto& bucket = buckets_[hash];
+  for (const auto& existing : bucket) {
+    if (SameSchema(*existing.meta, meta)) return existing;
+  }
+  // 新记录在驻留时编译一次校验对象，之后与共享它的所有节点共用
+  bucket.push_back(Make(meta));
+  return bucket.back();
+}
+
+size_t ConfigSchemaStore::Size() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  size_t count = unique_count_;
+  for (const auto& kv : buckets_) count += kv.second.size();
+  return count;
+}
+
+}  // namespace config
+}  // namespace plugins
+}  // namespace z3y
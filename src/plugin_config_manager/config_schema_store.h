@@ -0,0 +1,64 @@
+﻿/**
+ * @file config_schema_store.h
+ * @brief 只读为主的 Schema 仓库：相同的 SchemaMetadata 全局只存一份。
+ * * @details
+ * SchemaMetadata 含十来个 std::string、两个字符串数组、三个 ConfigValue 和一个
+ * std::function，一份就有数百字节。节点不再各自内嵌一份，而是持有指向不可变记录的
+ * shared_ptr：
+ * - 内容完全相同的 Schema (批量生成的参数、未填 UI 信息的后端参数) 共享同一条记录。
+ * - 占位节点共享同一条空记录。
+ * - 带 custom_validator 的 Schema 无法判等，各自独立存放，但仍只存一份、不随快照复制。
+ * - 修改 (UpdateEnumSchema) 时复制出新记录再替换节点指针，共享该记录的其它节点不受影响。
+ * - 每条记录驻留时编译一份 ConfigSchemaCheck，与记录同分配，写入校验直接使用。
+ */
+#pragma once
+#ifndef Z3Y_CONFIG_SCHEMA_STORE_H_
+#define Z3Y_CONFIG_SCHEMA_STORE_H_
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "interfaces_core/config_types.h"
+#include "config_schema_check.h"
+
+namespace z3y {
+namespace plugins {
+namespace config {
+using namespace z3y::interfaces::core;
+
+class ConfigSchemaStore {
+ public:
+  /** @brief 驻留结果：Schema 记录与其编译出的校验对象 (共享同一个控制块)。 */
+  struct Interned {
+    std::shared_ptr<const SchemaMetadata> meta;
+    std::shared_ptr<const ConfigSchemaCheck> check;
+  };
+
+  /** @brief 所有占位节点共享的空 Schema。 */
+  static const Interned& Empty();
+
+  /** @brief 返回与 meta 内容相同的共享记录 (没有则新建并编译校验对象)。线程安全。 */
+  Interned Intern(const SchemaMetadata& meta);
+
+  /** @brief 当前记录数 (诊断用)。 */
+  size_t Size() const;
+
+ private:
+  struct Record;
+  static Interned Make(const SchemaMetadata& meta);
+  static size_t HashOf(const SchemaMetadata& meta);
+  static bool SameSchema(const SchemaMetadata& a, const SchemaMetadata& b);
+
+  mutable std::mutex mutex_;
+  std::unordered_map<size_t, std::vector<Interned>> buckets_;
+  size_t unique_count_ = 0;  ///< 带 custom_validator 的独立记录数
+};
+
+}  // namespace config
+}  // namespace plugins
+}  // namespace z3y
+
+#endif  // Z3Y_CONFIG_SCHEMA_STORE_H_
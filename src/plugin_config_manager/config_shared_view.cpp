@@ -0,0 +1,691 @@
+﻿/**
+ * @file config_shared_view.cpp
+ * @brief 共享内存配置视图的发布端、读者与平台映射。
+ */
+
+#include "config_shared_view.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <ctime>
+#endif
+#endif
+
+namespace z3y {
+namespace plugins {
+namespace config {
+
+namespace shared_view {
+
+uint64_t HashKey(std::string_view key) noexcept {
+  uint64_t hash = 14695981039346656037ull;
+  for (const char c : key) {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 1099511628211ull;
+  }
+  return hash != 0 ? hash : 1;
+}
+
+bool IsValidName(const std::string& name) noexcept {
+  if (name.empty() || name.size() > 64) return false;
+  return std::all_of(name.begin(), name.end(), [](char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+           c == '-' || c == '_' || c == '.';
+  });
+}
+
+}  // namespace shared_view
+
+namespace {
+using shared_view::Header;
+using shared_view::Slot;
+
+constexpr size_t kMinSlots = 16;
+/** @brief 读者连续看到奇数序号的上限：发布进程在写入中途崩溃时不至于永远自旋。 */
+constexpr int kMaxTornRetries = 100000;
+
+constexpr size_t AlignUp(size_t n, size_t alignment) noexcept {
+  return (n + alignment - 1) & ~(alignment - 1);
+}
+
+/** @brief 各段相对区域起点的偏移 (发布端与读者按区域头同样计算)。 */
+struct Layout {
+  size_t slots;
+  size_t keys;
+  size_t data;
+  size_t total;
+};
+
+Layout ComputeLayout(uint32_t slot_count, uint32_t key_bytes, uint32_t data_bytes) noexcept {
+  Layout layout{};
+  layout.slots = sizeof(Header);
+  layout.keys = layout.slots + static_cast<size_t>(slot_count) * sizeof(Slot);
+  layout.data = layout.keys + AlignUp(key_bytes, 64);
+  layout.total = layout.data + AlignUp(data_bytes, 64);
+  return layout;
+}
+
+/** @brief 值内容的字节数 (标量为 0)。 */
+size_t PayloadBytes(const ConfigValue& value) {
+  switch (value.index()) {
+    case 4:
+      return std::get<std::string>(value).size();
+    case 5:
+      return std::get<std::vector<int64_t>>(value).size() * sizeof(int64_t);
+    case 6:
+      return std::get<std::vector<double>>(value).size() * sizeof(double);
+    case 7: {
+      size_t bytes = 0;
+      for (const auto& s : std::get<std::vector<std::string>>(value)) {
+        bytes += sizeof(uint32_t) + s.size();
+      }
+      return bytes;
+    }
+    default:
+      return 0;
+  }
+}
+
+template <typename T>
+uint64_t BitsOf(T v) noexcept {
+  uint64_t bits = 0;
+  std::memcpy(&bits, &v, sizeof(v));
+  return bits;
+}
+
+template <typename T>
+T FromBits(uint64_t bits) noexcept {
+  T v;
+  std::memcpy(&v, &bits, sizeof(v));
+  return v;
+}
+
+void FutexWake(std::atomic<uint32_t>* word) noexcept {
+#if defined(__linux__)
+  ::syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAKE, INT32_MAX, nullptr,
+            nullptr, 0);
+#else
+  (void)word;
+#endif
+}
+
+/** @brief 在 word 仍等于 expected 时最多等待 timeout；其它平台退化为短睡眠。 */
+void FutexWait(std::atomic<uint32_t>* word, uint32_t expected,
+               std::chrono::nanoseconds timeout) noexcept {
+#if defined(__linux__)
+  timespec ts{};
+  ts.tv_sec = static_cast<time_t>(timeout.count() / 1000000000);
+  ts.tv_nsec = static_cast<long>(timeout.count() % 1000000000);
+  ::syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAIT, expected, &ts, nullptr,
+            0);
+#else
+  (void)word;
+  (void)expected;
+  std::this_thread::sleep_for(std::min<std::chrono::nanoseconds>(timeout,
+                                                                  std::chrono::milliseconds(1)));
+#endif
+}
+
+ConfigSharedViewStats StatsOf(const Header& header) {
+  ConfigSharedViewStats stats;
+  stats.generation = header.generation.load(std::memory_order_acquire);
+  stats.entries = header.entries.load(std::memory_order_acquire);
+  stats.max_entries = header.max_entries;
+  stats.data_used = header.data_used.load(std::memory_order_relaxed);
+  stats.data_bytes = header.data_bytes;
+  stats.dropped = header.dropped.load(std::memory_order_relaxed);
+  stats.publisher_attached = header.publisher_attached.load(std::memory_order_acquire) != 0;
+  return stats;
+}
+
+}  // namespace
+
+// ============================================================================
+// ConfigSharedRegion (平台映射)
+// ============================================================================
+
+#ifdef _WIN32
+
+bool ConfigSharedRegion::Create(const std::string& name, size_t size, std::string& out_error) {
+  Close();
+  const std::string native = "Local\\z3y.config." + name;
+  const unsigned long long bytes = size;
+  HANDLE mapping = ::CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+                                        static_cast<DWORD>(bytes >> 32),
+                                        static_cast<DWORD>(bytes & 0xFFFFFFFFull), native.c_str());
+  if (mapping != NULL && ::GetLastError() == ERROR_ALREADY_EXISTS) {
+    ::CloseHandle(mapping);
+    out_error = "Shared config view '" + name + "' already exists";
+    return false;
+  }
+  if (mapping == NULL) {
+    out_error = "CreateFileMapping('" + native + "') failed (error " +
+                std::to_string(::GetLastError()) + ")";
+    return false;
+  }
+  void* base = ::MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+  if (base == NULL) {
+    out_error = "MapViewOfFile('" + native + "') failed (error " +
+                std::to_string(::GetLastError()) + ")";
+    ::CloseHandle(mapping);
+    return false;
+  }
+  base_ = static_cast<char*>(base);
+  size_ = size;
+  native_handle_ = mapping;
+  owner_ = true;
+  return true;
+}
+
+bool ConfigSharedRegion::Open(const std::string& name, std::string& out_error) {
+  Close();
+  const std::string native = "Local\\z3y.config." + name;
+  HANDLE mapping = ::OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, native.c_str());
+  if (mapping == NULL) {
+    out_error = "Shared config view '" + name + "' unavailable (error " +
+                std::to_string(::GetLastError()) + ")";
+    return false;
+  }
+  void* base = ::MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+  if (base == NULL) {
+    out_error = "MapViewOfFile('" + native + "') failed (error " +
+                std::to_string(::GetLastError()) + ")";
+    ::CloseHandle(mapping);
+    return false;
+  }
+  MEMORY_BASIC_INFORMATION info;
+  base_ = static_cast<char*>(base);
+  size_ = ::VirtualQuery(base, &info, sizeof(info)) != 0 ? info.RegionSize : 0;
+  native_handle_ = mapping;
+  owner_ = false;
+  return true;
+}
+
+void ConfigSharedRegion::Close() {
+  if (base_) ::UnmapViewOfFile(base_);
+  if (native_handle_) ::CloseHandle(static_cast<HANDLE>(native_handle_));
+  base_ = nullptr;
+  size_ = 0;
+  native_handle_ = nullptr;
+  owner_ = false;
+}
+
+#else
+
+bool ConfigSharedRegion::Create(const std::string& name, size_t size, std::string& out_error) {
+  Close();
+  const std::string native = "/z3y.config." + name;
+  const int fd = ::shm_open(native.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (fd < 0) {
+    out_error = "shm_open('" + native + "') failed: " + std::strerror(errno);
+    return false;
+  }
+  if (::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+    out_error = "ftruncate('" + native + "') failed: " + std::strerror(errno);
+    ::close(fd);
+    ::shm_unlink(native.c_str());
+    return false;
+  }
+  void* base = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (base == MAP_FAILED) {
+    out_error = "mmap('" + native + "') failed: " + std::strerror(errno);
+    ::shm_unlink(native.c_str());
+    return false;
+  }
+  base_ = static_cast<char*>(base);
+  size_ = size;
+  native_name_ = native;
+  owner_ = true;
+  return true;
+}
+
+bool ConfigSharedRegion::Open(const std::string& name, std::string& out_error) {
+  Close();
+  const std::string native = "/z3y.config." + name;
+  // 读者也以读写方式映射：等待变化时要更新区域头里的等待者计数
+  const int fd = ::shm_open(native.c_str(), O_RDWR, 0);
+  if (fd < 0) {
+    out_error = "shm_open('" + native + "') failed: " + std::strerror(errno);
+    return false;
+  }
+  struct stat st;
+  if (::fstat(fd, &st) != 0 || st.st_size <= 0) {
+    out_error = "fstat('" + native + "') failed";
+    ::close(fd);
+    return false;
+  }
+  const size_t size = static_cast<size_t>(st.st_size);
+  void* base = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (base == MAP_FAILED) {
+    out_error = "mmap('" + native + "') failed: " + std::strerror(errno);
+    return false;
+  }
+  base_ = static_cast<char*>(base);
+  size_ = size;
+  native_name_ = native;
+  owner_ = false;
+  return true;
+}
+
+void ConfigSharedRegion::Close() {
+  if (base_) ::munmap(base_, size_);
+  if (owner_) ::shm_unlink(native_name_.c_str());
+  base_ = nullptr;
+  size_ = 0;
+  native_name_.clear();
+  owner_ = false;
+}
+
+#endif
+
+// ============================================================================
+// ConfigSharedViewWriter
+// ============================================================================
+
+bool ConfigSharedViewWriter::Start(const ConfigSharedViewOptions& options,
+                                   std::string& out_error) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (active_.load(std::memory_order_relaxed)) {
+    out_error = "A shared config view is already being published";
+    return false;
+  }
+  if (!shared_view::IsValidName(options.name)) {
+    out_error = "Invalid shared config view name: '" + options.name + "'";
+    return false;
+  }
+  if (options.max_entries == 0 || options.max_entries > (1u << 30)) {
+    out_error = "Shared config view max_entries out of range";
+    return false;
+  }
+
+  size_t slot_count = kMinSlots;
+  while (slot_count < static_cast<size_t>(options.max_entries) * 2) slot_count <<= 1;
+  const Layout layout = ComputeLayout(static_cast<uint32_t>(slot_count), options.key_bytes,
+                                      options.data_bytes);
+  if (!region_.Create(options.name, layout.total, out_error)) return false;
+
+  char* base = region_.base();
+  header_ = reinterpret_cast<Header*>(base);
+  slots_ = reinterpret_cast<Slot*>(base + layout.slots);
+  keys_ = base + layout.keys;
+  data_ = base + layout.data;
+  keys_used_ = 0;
+
+  // 新区域内容全为 0：原子量与空槽都已处于初始状态，只需填写布局参数
+  header_->version = Header::kVersion;
+  header_->slot_count = static_cast<uint32_t>(slot_count);
+  header_->max_entries = options.max_entries;
+  header_->key_bytes = options.key_bytes;
+  header_->data_bytes = options.data_bytes;
+  header_->total_bytes = layout.total;
+  header_->publisher_attached.store(1, std::memory_order_relaxed);
+  header_->magic.store(Header::kMagic, std::memory_order_release);
+  active_.store(true, std::memory_order_release);
+  return true;
+}
+
+void ConfigSharedViewWriter::Stop() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!active_.load(std::memory_order_relaxed)) return;
+  active_.store(false, std::memory_order_release);
+  header_->publisher_attached.store(0, std::memory_order_release);
+  header_->notify.fetch_add(1);
+  if (header_->waiters.load() != 0) FutexWake(&header_->notify);
+  region_.Close();
+  header_ = nullptr;
+  slots_ = nullptr;
+  keys_ = nullptr;
+  data_ = nullptr;
+}
+
+Slot* ConfigSharedViewWriter::FindOrInsert_UNLOCKED(const std::string& path) {
+  const uint64_t hash = shared_view::HashKey(path);
+  const size_t mask = header_->slot_count - 1;
+  for (size_t i = 0; i <= mask; ++i) {
+    Slot& slot = slots_[(hash + i) & mask];
+    const uint64_t h = slot.key_hash.load(std::memory_order_relaxed);
+    if (h == 0) {
+      if (header_->entries.load(std::memory_order_relaxed) >= header_->max_entries ||
+          path.size() > header_->key_bytes - keys_used_) {
+        return nullptr;
+      }
+      std::memcpy(keys_ + keys_used_, path.data(), path.size());
+      slot.key_offset = keys_used_;
+      slot.key_length = static_cast<uint32_t>(path.size());
+      keys_used_ += static_cast<uint32_t>(path.size());
+      slot.key_hash.store(hash, std::memory_order_release);
+      header_->entries.fetch_add(1, std::memory_order_release);
+      return &slot;
+    }
+    if (h == hash && slot.key_length == path.size() &&
+        std::memcmp(keys_ + slot.key_offset, path.data(), path.size()) == 0) {
+      return &slot;
+    }
+  }
+  return nullptr;
+}
+
+bool ConfigSharedViewWriter::Allocate_UNLOCKED(size_t bytes, uint32_t& out_offset) {
+  const uint64_t used = header_->data_used.load(std::memory_order_relaxed);
+  const size_t aligned = AlignUp(bytes, 8);
+  if (aligned > header_->data_bytes - used) return false;
+  out_offset = static_cast<uint32_t>(used);
+  header_->data_used.store(used + aligned, std::memory_order_relaxed);
+  return true;
+}
+
+void ConfigSharedViewWriter::Store(const std::string& path, const ConfigValue& value) {
+  if (!active_.load(std::memory_order_acquire) || value.index() == 0) return;
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!active_.load(std::memory_order_relaxed)) return;
+
+  Slot* slot = FindOrInsert_UNLOCKED(path);
+  if (!slot) {
+    header_->dropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  const uint32_t type = static_cast<uint32_t>(value.index());
+  const size_t payload = PayloadBytes(value);
+  bool fits = payload <= header_->data_bytes;
+  if (fits && type >= 4 && payload > slot->block_capacity) {
+    // 预留一半余量，值在原长度附近变化时原地改写；余量放不下时退回刚好够用
+    uint32_t offset = 0;
+    size_t capacity = std::max<size_t>(AlignUp(payload + payload / 2, 8), 16);
+    if (!Allocate_UNLOCKED(capacity, offset)) {
+      capacity = AlignUp(payload, 8);
+      fits = Allocate_UNLOCKED(capacity, offset);
+    }
+    if (fits) {
+      slot->block_offset = offset;
+      slot->block_capacity = static_cast<uint32_t>(capacity);
+    }
+  }
+
+  const uint64_t generation = header_->generation.load(std::memory_order_relaxed) + 1;
+  const uint32_t seq = slot->seq.load(std::memory_order_relaxed);
+  slot->seq.store(seq + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  if (!fits) {
+    slot->type.store(0, std::memory_order_relaxed);
+    header_->dropped.fetch_add(1, std::memory_order_relaxed);
+  } else {
+    uint64_t scalar = slot->block_offset;
+    uint32_t count = 0;
+    char* block = data_ + slot->block_offset;
+    switch (type) {
+      case 1:
+        scalar = BitsOf(std::get<int64_t>(value));
+        break;
+      case 2:
+        scalar = BitsOf(std::get<double>(value));
+        break;
+      case 3:
+        scalar = std::get<bool>(value) ? 1 : 0;
+        break;
+      case 4: {
+        const auto& s = std::get<std::string>(value);
+        std::memcpy(block, s.data(), s.size());
+        count = static_cast<uint32_t>(s.size());
+        break;
+      }
+      case 5: {
+        const auto& v = std::get<std::vector<int64_t>>(value);
+        if (!v.empty()) std::memcpy(block, v.data(), payload);
+        count = static_cast<uint32_t>(v.size());
+        break;
+      }
+      case 6: {
+        const auto& v = std::get<std::vector<double>>(value);
+        if (!v.empty()) std::memcpy(block, v.data(), payload);
+        count = static_cast<uint32_t>(v.size());
+        break;
+      }
+      case 7: {
+        const auto& v = std::get<std::vector<std::string>>(value);
+        for (const auto& s : v) {
+          const uint32_t length = static_cast<uint32_t>(s.size());
+          std::memcpy(block, &length, sizeof(length));
+          std::memcpy(block + sizeof(length), s.data(), s.size());
+          block += sizeof(length) + s.size();
+        }
+        count = static_cast<uint32_t>(v.size());
+        break;
+      }
+      default:
+        break;
+    }
+    slot->type.store(type, std::memory_order_relaxed);
+    slot->scalar.store(scalar, std::memory_order_relaxed);
+    slot->count.store(count, std::memory_order_relaxed);
+    slot->bytes.store(static_cast<uint32_t>(payload), std::memory_order_relaxed);
+  }
+  slot->changed_at.store(generation, std::memory_order_relaxed);
+  slot->seq.store(seq + 2, std::memory_order_release);
+
+  header_->generation.store(generation, std::memory_order_release);
+  // 与读者的 waiters 自增构成 Dekker 式配对 (均为 seq_cst)：要么读者看到新的 notify，要么这里看到等待者
+  header_->notify.fetch_add(1);
+  if (header_->waiters.load() != 0) FutexWake(&header_->notify);
+}
+
+ConfigSharedViewStats ConfigSharedViewWriter::GetStats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!header_) return {};
+  return StatsOf(*header_);
+}
+
+// ============================================================================
+// ConfigSharedViewReader
+// ============================================================================
+
+bool ConfigSharedViewReader::Open(const std::string& name, std::string& out_error) {
+  Close();
+  if (!shared_view::IsValidName(name)) {
+    out_error = "Invalid shared config view name: '" + name + "'";
+    return false;
+  }
+  if (!region_.Open(name, out_error)) return false;
+
+  auto* header = reinterpret_cast<Header*>(region_.base());
+  if (region_.size() < sizeof(Header) ||
+      header->magic.load(std::memory_order_acquire) != Header::kMagic) {
+    out_error = "Shared config view '" + name + "' is not initialized";
+    region_.Close();
+    return false;
+  }
+  if (header->version != Header::kVersion) {
+    out_error = "Shared config view '" + name + "' has layout version " +
+                std::to_string(header->version) + ", expected " +
+                std::to_string(Header::kVersion);
+    region_.Close();
+    return false;
+  }
+  const uint32_t slot_count = header->slot_count;
+  const Layout layout = ComputeLayout(slot_count, header->key_bytes, header->data_bytes);
+  if (slot_count == 0 || (slot_count & (slot_count - 1)) != 0 ||
+      layout.total != header->total_bytes || layout.total > region_.size()) {
+    out_error = "Shared config view '" + name + "' has a corrupted layout";
+    region_.Close();
+    return false;
+  }
+
+  header_ = header;
+  slots_ = reinterpret_cast<Slot*>(region_.base() + layout.slots);
+  keys_ = region_.base() + layout.keys;
+  data_ = region_.base() + layout.data;
+  return true;
+}
+
+void ConfigSharedViewReader::Close() {
+  region_.Close();
+  header_ = nullptr;
+  slots_ = nullptr;
+  keys_ = nullptr;
+  data_ = nullptr;
+}
+
+const Slot* ConfigSharedViewReader::Find(std::string_view path) const noexcept {
+  const uint64_t hash = shared_view::HashKey(path);
+  const size_t mask = header_->slot_count - 1;
+  const uint32_t key_bytes = header_->key_bytes;
+  for (size_t i = 0; i <= mask; ++i) {
+    const Slot& slot = slots_[(hash + i) & mask];
+    const uint64_t h = slot.key_hash.load(std::memory_order_acquire);
+    if (h == 0) return nullptr;
+    if (h == hash && slot.key_length == path.size() && slot.key_offset <= key_bytes &&
+        path.size() <= key_bytes - slot.key_offset &&
+        std::memcmp(keys_ + slot.key_offset, path.data(), path.size()) == 0) {
+      return &slot;
+    }
+  }
+  return nullptr;
+}
+
+bool ConfigSharedViewReader::TryDecode(uint32_t type, uint64_t scalar, uint32_t count,
+                                       uint32_t bytes, ConfigValue& out) const {
+  if (type >= 4 && (scalar > header_->data_bytes || bytes > header_->data_bytes - scalar)) {
+    return false;  // 偏移与长度来自被打断的写入
+  }
+  const char* block = data_ + scalar;
+  switch (type) {
+    case 1:
+      out = FromBits<int64_t>(scalar);
+      return true;
+    case 2:
+      out = FromBits<double>(scalar);
+      return true;
+    case 3:
+      out = scalar != 0;
+      return true;
+    case 4:
+      if (count != bytes) return false;
+      out = std::string(block, bytes);
+      return true;
+    case 5: {
+      if (static_cast<uint64_t>(count) * sizeof(int64_t) != bytes) return false;
+      std::vector<int64_t> v(count);
+      if (count != 0) std::memcpy(v.data(), block, bytes);
+      out = std::move(v);
+      return true;
+    }
+    case 6: {
+      if (static_cast<uint64_t>(count) * sizeof(double) != bytes) return false;
+      std::vector<double> v(count);
+      if (count != 0) std::memcpy(v.data(), block, bytes);
+      out = std::move(v);
+      return true;
+    }
+    case 7: {
+      if (count > bytes / sizeof(uint32_t)) return false;
+      std::vector<std::string> v;
+      v.reserve(count);
+      size_t pos = 0;
+      for (uint32_t i = 0; i < count; ++i) {
+        uint32_t length = 0;
+        if (bytes - pos < sizeof(length)) return false;
+        std::memcpy(&length, block + pos, sizeof(length));
+        pos += sizeof(length);
+        if (bytes - pos < length) return false;
+        v.emplace_back(block + pos, length);
+        pos += length;
+      }
+      out = std::move(v);
+      return true;
+    }
+    default:
+      return false;
+  }
+}
+
+bool ConfigSharedViewReader::Read(const std::string& path, ConfigValue& out) const {
+  if (!header_) return false;
+  const Slot* slot = Find(path);
+  if (!slot) return false;
+
+  for (int torn = 0; torn < kMaxTornRetries; ++torn) {
+    const uint32_t seq = slot->seq.load(std::memory_order_acquire);
+    if (seq & 1) {
+      std::this_thread::yield();
+      continue;
+    }
+    const uint32_t type = slot->type.load(std::memory_order_relaxed);
+    const uint64_t scalar = slot->scalar.load(std::memory_order_relaxed);
+    const uint32_t count = slot->count.load(std::memory_order_relaxed);
+    const uint32_t bytes = slot->bytes.load(std::memory_order_relaxed);
+    ConfigValue value;
+    const bool decoded = TryDecode(type, scalar, count, bytes, value);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot->seq.load(std::memory_order_relaxed) != seq) continue;
+    if (!decoded) return false;  // 值未能发布 (type 0) 或区域已损坏
+    out = std::move(value);
+    return true;
+  }
+  return false;
+}
+
+uint64_t ConfigSharedViewReader::Generation() const noexcept {
+  return header_ ? header_->generation.load(std::memory_order_acquire) : 0;
+}
+
+uint64_t ConfigSharedViewReader::WaitForChange(uint64_t seen, uint32_t timeout_ms) const {
+  if (!header_) return seen;
+  const auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+  for (;;) {
+    // 先取唤醒字再检查代数：检查之后的修改必然改变唤醒字，futex 不会睡过头
+    const uint32_t notify = header_->notify.load();
+    const uint64_t generation = header_->generation.load(std::memory_order_acquire);
+    if (generation != seen) return generation;
+    if (header_->publisher_attached.load(std::memory_order_acquire) == 0) return seen;
+    const auto now = std::chrono::steady_clock::now();
+    if (now >= deadline) return seen;
+    header_->waiters.fetch_add(1);
+    FutexWait(&header_->notify, notify, deadline - now);
+    header_->waiters.fetch_sub(1);
+  }
+}
+
+std::vector<std::string> ConfigSharedViewReader::ChangedSince(uint64_t generation) const {
+  std::vector<std::string> paths;
+  if (!header_) return paths;
+  const uint32_t key_bytes = header_->key_bytes;
+  for (size_t i = 0; i < header_->slot_count; ++i) {
+    const Slot& slot = slots_[i];
+    if (slot.key_hash.load(std::memory_order_acquire) == 0) continue;
+    if (slot.changed_at.load(std::memory_order_acquire) <= generation) continue;
+    if (slot.key_offset > key_bytes || slot.key_length > key_bytes - slot.key_offset) continue;
+    paths.emplace_back(keys_ + slot.key_offset, slot.key_length);
+  }
+  return paths;
+}
+
+ConfigSharedViewStats ConfigSharedViewReader::GetStats() const {
+  if (!header_) return {};
+  return StatsOf(*header_);
+}
+
+}  // namespace config
+}  // namespace plugins
+}  // namespace z3y
@@ -0,0 +1,195 @@
+﻿/**
+ * @file config_shared_view.h
+ * @brief 配置的共享内存只读视图：区域布局、发布端 (写者) 与读者。
+ * * @details
+ * 【区域布局】(同一台机器上同一份代码编译的进程之间共享，不考虑字节序)
+ * - Header (128 字节)：魔数 (初始化完毕后最后写入)、各段大小、修改代数、唤醒字与等待者计数。
+ * - Slots：开放寻址的键槽 (2 的幂个，线性探测)，每槽 64 字节。
+ * - Keys：键名字节，只追加。
+ * - Data：字符串与数组的内容，每个键一块 (8 字节对齐)。新值放不下时重新分配，旧块不回收。
+ * 字符串数组的块内依次是各元素的 [uint32 长度 + 字节]。
+ * * 【并发协议】
+ * - 只有发布进程写区域，进程内由 ConfigSharedViewWriter::mutex_ 串行化；读者不取任何锁。
+ * - 新键：先写键名与槽的其余字段，最后以 release 写入 key_hash (0 表示空槽)。键只增不删。
+ * - 值：每槽一把序列锁，seq 为奇数表示正在写。读者读 seq → 拷出字段与内容 → 再读 seq，
+ * 两次相同且为偶数才采用，否则重试。内容越界 (读到写了一半的偏移) 同样按被打断处理。
+ * - 每次修改使 generation 加一，槽的 changed_at 记下该代数。
+ * - 唤醒：Linux 上读者以 futex 等待 notify 字 (跨进程，不带 PRIVATE 标志)，发布端只在
+ * waiters 非 0 时 FUTEX_WAKE；其它平台读者以 1ms 间隔轮询 generation。
+ * * 【锁顺序】节点锁 → mutex_ (发布端在节点锁内调用 Store，保证同一个键的发布顺序与修改顺序一致)。
+ */
+#pragma once
+#ifndef Z3Y_CONFIG_SHARED_VIEW_H_
+#define Z3Y_CONFIG_SHARED_VIEW_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "interfaces_core/config_types.h"
+
+namespace z3y {
+namespace plugins {
+namespace config {
+using namespace z3y::interfaces::core;
+
+namespace shared_view {
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+              "shared config view cells must be lock-free atomics");
+static_assert(std::atomic<uint32_t>::is_always_lock_free,
+              "shared config view cells must be lock-free atomics");
+
+struct alignas(64) Header {
+  static constexpr uint32_t kMagic = 0x5A334356;  // "Z3CV"
+  static constexpr uint32_t kVersion = 1;
+
+  std::atomic<uint32_t> magic;  ///< 发布端初始化完毕后最后写入
+  uint32_t version;
+  uint32_t slot_count;          ///< 2 的幂
+  uint32_t max_entries;
+  uint32_t key_bytes;
+  uint32_t data_bytes;
+  uint64_t total_bytes;
+  std::atomic<uint32_t> publisher_attached;
+  std::atomic<uint32_t> entries;
+  std::atomic<uint64_t> generation;
+  std::atomic<uint64_t> data_used;
+  std::atomic<uint64_t> dropped;
+  alignas(64) std::atomic<uint32_t> notify;  ///< futex 字：每次修改加一
+  std::atomic<uint32_t> waiters;             ///< 正在 futex 上等待的读者数
+};
+static_assert(sizeof(Header) == 128, "shared config view header layout must be stable");
+
+struct alignas(64) Slot {
+  std::atomic<uint64_t> key_hash;  ///< 0 表示空槽；键名与下面两个字段写好后才发布
+  uint32_t key_offset;             ///< 相对 Keys 区
+  uint32_t key_length;
+  std::atomic<uint32_t> seq;       ///< 序列锁
+  std::atomic<uint32_t> type;      ///< ConfigValue::index()，0 表示值未能发布
+  std::atomic<uint64_t> scalar;    ///< 标量的位模式，或内容块相对 Data 区的偏移
+  std::atomic<uint32_t> count;     ///< 字符串字节数 / 数组元素个数
+  std::atomic<uint32_t> bytes;     ///< 内容块中有效字节数
+  std::atomic<uint64_t> changed_at;  ///< 最近一次修改的代数
+  uint32_t block_offset;           ///< [发布端] 当前内容块
+  uint32_t block_capacity;
+};
+static_assert(sizeof(Slot) == 64, "shared config view slot layout must be stable");
+
+/** @brief 键名哈希 (FNV-1a)，0 保留给空槽。 */
+uint64_t HashKey(std::string_view key) noexcept;
+
+/** @brief 名称合法时返回 true：1~64 个 [A-Za-z0-9-_.] 字符。 */
+bool IsValidName(const std::string& name) noexcept;
+
+}  // namespace shared_view
+
+/**
+ * @brief 一段命名共享内存的映射 (POSIX shm_open / Windows 命名文件映射)。
+ */
+class ConfigSharedRegion {
+ public:
+  ConfigSharedRegion() = default;
+  ~ConfigSharedRegion() { Close(); }
+
+  ConfigSharedRegion(const ConfigSharedRegion&) = delete;
+  ConfigSharedRegion& operator=(const ConfigSharedRegion&) = delete;
+
+  /** @brief 创建并映射 (同名区域已存在时失败)，内容为全 0。 */
+  bool Create(const std::string& name, size_t size, std::string& out_error);
+  /** @brief 打开已有区域，映射大小取自系统。 */
+  bool Open(const std::string& name, std::string& out_error);
+  /** @brief 解除映射；创建者同时删除区域名。 */
+  void Close();
+
+  char* base() const noexcept { return base_; }
+  size_t size() const noexcept { return size_; }
+
+ private:
+  char* base_ = nullptr;
+  size_t size_ = 0;
+  void* native_handle_ = nullptr;  ///< Windows: 文件映射句柄
+  std::string native_name_;        ///< POSIX: shm_open 名称
+  bool owner_ = false;
+};
+
+/**
+ * @brief 发布端：把配置值写入共享视图 (ConfigProviderService 持有)。
+ */
+class ConfigSharedViewWriter {
+ public:
+  ConfigSharedViewWriter() = default;
+  ~ConfigSharedViewWriter() { Stop(); }
+
+  ConfigSharedViewWriter(const ConfigSharedViewWriter&) = delete;
+  ConfigSharedViewWriter& operator=(const ConfigSharedViewWriter&) = delete;
+
+  /** @brief 创建区域。已在发布、名称非法或创建失败时返回 false。 */
+  bool Start(const ConfigSharedViewOptions& options, std::string& out_error);
+
+  /** @brief 标记发布端离开、唤醒等待者并删除区域名。 */
+  void Stop();
+
+  bool IsActive() const noexcept { return active_.load(std::memory_order_acquire); }
+
+  /**
+   * @brief 发布一个键的当前值。未在发布时立即返回。
+   * @details 调用方持有该键的节点锁；空值 (占位节点) 不发布。
+   */
+  void Store(const std::string& path, const ConfigValue& value);
+
+  ConfigSharedViewStats GetStats() const;
+
+ private:
+  shared_view::Slot* FindOrInsert_UNLOCKED(const std::string& path);
+  /** @brief 从 Data 区分配 bytes 字节 (8 字节对齐)，不足时返回 false。 */
+  bool Allocate_UNLOCKED(size_t bytes, uint32_t& out_offset);
+
+  mutable std::mutex mutex_;  ///< 串行化写入与启停 (叶子锁)
+  std::atomic<bool> active_{false};
+  ConfigSharedRegion region_;
+  shared_view::Header* header_ = nullptr;
+  shared_view::Slot* slots_ = nullptr;
+  char* keys_ = nullptr;
+  char* data_ = nullptr;
+  uint32_t keys_used_ = 0;
+};
+
+/**
+ * @brief 读者：在映射上免锁读取 (ConfigSharedViewService 持有)。
+ * @note Open / Close 不得与读取并发。
+ */
+class ConfigSharedViewReader {
+ public:
+  bool Open(const std::string& name, std::string& out_error);
+  void Close();
+  bool IsOpen() const noexcept { return header_ != nullptr; }
+
+  bool Read(const std::string& path, ConfigValue& out) const;
+  uint64_t Generation() const noexcept;
+  uint64_t WaitForChange(uint64_t seen, uint32_t timeout_ms) const;
+  std::vector<std::string> ChangedSince(uint64_t generation) const;
+  ConfigSharedViewStats GetStats() const;
+
+ private:
+  const shared_view::Slot* Find(std::string_view path) const noexcept;
+  /** @brief 拷出一次槽内容；被写入打断或内容越界时返回 false。 */
+  bool TryDecode(uint32_t type, uint64_t scalar, uint32_t count, uint32_t bytes,
+                 ConfigValue& out) const;
+
+  ConfigSharedRegion region_;
+  shared_view::Header* header_ = nullptr;
+  shared_view::Slot* slots_ = nullptr;
+  const char* keys_ = nullptr;
+  const char* data_ = nullptr;
+};
+
+}  // namespace config
+}  // namespace plugins
+}  // namespace z3y
+
+#endif  // Z3Y_CONFIG_SHARED_VIEW_H_
@@ -0,0 +1,11 @@
+﻿/**
+ * @file config_shared_view_service.cpp
+ * @brief 注册共享内存配置视图组件。
+ */
+
+#include "config_shared_view_service.h"
+
+#include "framework/z3y_framework.h"
+
+Z3Y_AUTO_REGISTER_COMPONENT(z3y::plugins::config::ConfigSharedViewService,
+                            "Config.SharedView", true);
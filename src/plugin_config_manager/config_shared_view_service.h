@@ -0,0 +1,60 @@
+﻿/**
+ * @file config_shared_view_service.h
+ * @brief IConfigSharedView 的默认实现：在另一进程发布的共享内存上只读访问配置。
+ * * @details
+ * 只是 ConfigSharedViewReader 的组件外壳 (别名 "Config.SharedView")，
+ * 读取不经过本进程的 ConfigProviderService，也不要求它加载过 config.json。
+ */
+#pragma once
+#ifndef Z3Y_CONFIG_SHARED_VIEW_SERVICE_H_
+#define Z3Y_CONFIG_SHARED_VIEW_SERVICE_H_
+
+#include <string>
+#include <vector>
+
+#include "config_shared_view.h"
+#include "framework/z3y_define_impl.h"
+#include "interfaces_core/i_config_shared_view.h"
+
+namespace z3y {
+namespace plugins {
+namespace config {
+
+class ConfigSharedViewService
+    : public z3y::PluginImpl<ConfigSharedViewService, IConfigSharedView> {
+ public:
+  Z3Y_DEFINE_COMPONENT_ID("z3y-core-ConfigSharedView-Impl-v1");
+
+  bool Open(const std::string& name, std::string& out_error) override {
+    return reader_.Open(name, out_error);
+  }
+  void Close() override { reader_.Close(); }
+  bool IsOpen() const override { return reader_.IsOpen(); }
+
+  bool TryGetValue(const std::string& path, ConfigValue& out) const override {
+    return reader_.Read(path, out);
+  }
+  ConfigValue GetValue(const std::string& path) const override {
+    ConfigValue value;
+    reader_.Read(path, value);
+    return value;
+  }
+
+  uint64_t GetGeneration() const override { return reader_.Generation(); }
+  uint64_t WaitForChange(uint64_t seen_generation, uint32_t timeout_ms) const override {
+    return reader_.WaitForChange(seen_generation, timeout_ms);
+  }
+  std::vector<std::string> GetChangedSince(uint64_t generation) const override {
+    return reader_.ChangedSince(generation);
+  }
+  ConfigSharedViewStats GetStats() const override { return reader_.GetStats(); }
+
+ private:
+  ConfigSharedViewReader reader_;
+};
+
+}  // namespace config
+}  // namespace plugins
+}  // namespace z3y
+
+#endif  // Z3Y_CONFIG_SHARED_VIEW_SERVICE_H_
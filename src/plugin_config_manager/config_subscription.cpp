@@ -0,0 +1,100 @@
+﻿/**
+ * @file config_subscription.cpp
+ * @brief ConfigSubscription 与 ConfigNotifyExecutor 的实现。
+ */
+#include "config_subscription.h"
+
+#include <iostream>
+
+#include "framework/thread_placement.h"
+
+namespace z3y {
+namespace plugins {
+namespace config {
+
+void ConfigNotifyExecutor::Post(std::function<void()> task) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stopped_) return;
+    if (!worker_.joinable()) worker_ = std::thread(&ConfigNotifyExecutor::Run, this);
+    tasks_.push_back(std::move(task));
+  }
+  cv_.notify_one();
+}
+
+void ConfigNotifyExecutor::Stop() {
+  std::deque<std::function<void()>> dropped;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stopped_) return;
+    stopped_ = true;
+    dropped.swap(tasks_);
+  }
+  cv_.notify_one();
+  if (worker_.joinable()) worker_.join();
+  // dropped 在锁外析构：任务里的订阅者可能正是最后一个引用
+}
+
+void ConfigNotifyExecutor::Run() {
+  (void)PlaceCurrentThread(thread_name_);
+  for (;;) {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [this] { return stopped_ || !tasks_.empty(); });
+      if (stopped_) return;
+      task = std::move(tasks_.front());
+      tasks_.pop_front();
+    }
+    task();
+  }
+}
+
+void ConfigSubscription::Invoke(ConfigSubscription& sub, const ConfigValue& value) {
+  if (!sub.active_.load(std::memory_order_acquire)) return;
+  try {
+    sub.callback_(value);
+  } catch (const std::exception& e) {
+    std::cerr << "[Config Error] Exception thrown during queued callback:"
+              << e.what() << std::endl;
+  } catch (...) {
+    std::cerr << "[Config Error] Unknown exception thrown during queued callback."
+              << std::endl;
+  }
+}
+
+void ConfigSubscription::Deliver(const ConfigValue& value, IEventExecutor& fallback) {
+  if (type_ == ConnectionType::kDirect) {
+    if (active_.load(std::memory_order_acquire)) callback_(value);
+    return;
+  }
+  auto self = shared_from_this();
+  IEventExecutor& executor = executor_ ? *executor_ : fallback;
+
+  if (type_ == ConnectionType::kQueued) {
+    executor.Post([self, value] { Invoke(*self, value); });
+    return;
+  }
+
+  // kQueuedCoalesced：同一时刻最多一个待执行任务，执行时取最新值
+  {
+    std::lock_guard<std::mutex> lock(coalesce_mutex_);
+    latest_ = value;
+    if (scheduled_) return;
+    scheduled_ = true;
+  }
+  executor.Post([self] {
+    ConfigValue latest;
+    {
+      std::lock_guard<std::mutex> lock(self->coalesce_mutex_);
+      latest = std::move(*self->latest_);
+      self->latest_.reset();
+      self->scheduled_ = false;
+    }
+    Invoke(*self, latest);
+  });
+}
+
+}  // namespace config
+}  // namespace plugins
+}  // namespace z3y
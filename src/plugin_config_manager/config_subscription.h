@@ -0,0 +1,116 @@
+﻿/**
+ * @file config_subscription.h
+ * @brief 配置订阅的投递策略 (直接 / 排队 / 合并最新值) 与默认派发线程。
+ * * @details
+ * 每个节点的订阅者保存在写时复制 (COW) 的扁平数组里：通知时在节点锁内只复制
+ * 一个 shared_ptr，不再逐个复制 std::function；订阅/退订时复制数组后整体替换。
+ * * 【投递模式】(复用事件总线的 z3y::ConnectionType)
+ * - kDirect：在 SetValue 的调用线程同步执行，受递归深度保护。
+ * - kQueued：每次变化都投递到执行器 (未指定时为配置服务自带的派发线程)。
+ * - kQueuedCoalesced：尚未执行的投递只保留最新值，慢订阅者每轮只处理一次。
+ * * 退订后尚未执行的排队投递会被丢弃；正在执行的回调不会被打断。
+ */
+#pragma once
+#ifndef Z3Y_CONFIG_SUBSCRIPTION_H_
+#define Z3Y_CONFIG_SUBSCRIPTION_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "framework/connection_type.h"
+#include "framework/event_executor.h"
+#include "interfaces_core/config_types.h"
+
+namespace z3y {
+namespace plugins {
+namespace config {
+using namespace z3y::interfaces::core;
+
+/**
+ * @brief 配置服务自带的单线程派发器，承接未指定执行器的排队订阅。
+ * @details 首次 Post 时启动线程；Stop 之后丢弃剩余任务并拒绝新任务
+ * (插件卸载前必须停下，否则任务里的回调可能指向已卸载模块的代码)。
+ */
+class ConfigNotifyExecutor final : public IEventExecutor {
+ public:
+  /** @param thread_name 派发线程的名称 (线程布局按名称匹配)。 */
+  explicit ConfigNotifyExecutor(const char* thread_name = "config.notify")
+      : thread_name_(thread_name) {}
+  ~ConfigNotifyExecutor() override { Stop(); }
+
+  void Post(std::function<void()> task) override;
+
+  /** @brief 停止派发线程 (幂等)。 */
+  void Stop();
+
+ private:
+  void Run();
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<std::function<void()>> tasks_;
+  std::thread worker_;
+  bool stopped_ = false;
+  const char* thread_name_;
+};
+
+/**
+ * @brief 一个订阅者：回调 + 投递模式。创建后除 active / 合并槽外不再修改。
+ * @note 必须由 std::make_shared 创建，排队任务持有它的 shared_ptr。
+ */
+class ConfigSubscription : public std::enable_shared_from_this<ConfigSubscription> {
+ public:
+  ConfigSubscription(uint64_t id, std::function<void(const ConfigValue&)> cb,
+                     ConnectionType type, std::shared_ptr<IEventExecutor> executor)
+      : id_(id), callback_(std::move(cb)), type_(type), executor_(std::move(executor)) {}
+
+  uint64_t id() const { return id_; }
+  bool is_direct() const { return type_ == ConnectionType::kDirect; }
+
+  /** @brief 退订：之后到期的排队投递不再执行。 */
+  void Deactivate() { active_.store(false, std::memory_order_release); }
+
+  /**
+   * @brief 按投递模式送出一次变化。
+   * @details kDirect 在当前线程执行，回调异常向调用方传播；排队模式投递给执行器
+   * (为空时用 fallback)，异常在派发线程内吞掉。
+   */
+  void Deliver(const ConfigValue& value, IEventExecutor& fallback);
+
+ private:
+  static void Invoke(ConfigSubscription& sub, const ConfigValue& value);
+
+  const uint64_t id_;
+  const std::function<void(const ConfigValue&)> callback_;
+  const ConnectionType type_;
+  const std::shared_ptr<IEventExecutor> executor_;
+  std::atomic<bool> active_{true};
+
+  // kQueuedCoalesced：已投递但尚未执行时，新值只替换 latest_
+  std::mutex coalesce_mutex_;
+  std::optional<ConfigValue> latest_;
+  bool scheduled_ = false;
+};
+
+/** @brief 节点的订阅者列表：写时复制，通知时只复制 shared_ptr。 */
+using ConfigSubscriberList = std::vector<std::shared_ptr<ConfigSubscription>>;
+
+/** @brief 一次待派发的通知：锁内取出的订阅者列表快照 + 新值。 */
+struct PendingNotification {
+  std::shared_ptr<const ConfigSubscriberList> subscribers;
+  ConfigValue value;
+};
+
+}  // namespace config
+}  // namespace plugins
+}  // namespace z3y
+
+#endif  // Z3Y_CONFIG_SUBSCRIPTION_H_
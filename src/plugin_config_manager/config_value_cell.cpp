@@ -0,0 +1,159 @@
+﻿/**
+ * @file config_value_cell.cpp
+ * @brief ConfigValueCell 的实现。
+ */
+#include "config_value_cell.h"
+
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+namespace z3y {
+namespace plugins {
+namespace config {
+
+// 类型标签直接复用 variant 的序号，堆块类型从序号 4 开始
+static_assert(std::is_same_v<std::variant_alternative_t<1, ConfigValue>, int64_t>);
+static_assert(std::is_same_v<std::variant_alternative_t<2, ConfigValue>, double>);
+static_assert(std::is_same_v<std::variant_alternative_t<3, ConfigValue>, bool>);
+static_assert(std::is_same_v<std::variant_alternative_t<4, ConfigValue>, std::string>);
+static_assert(std::variant_size_v<ConfigValue> == 8);
+static_assert(sizeof(ConfigValueCell) == 16, "ConfigValueCell must stay 16 bytes");
+
+ConfigValueCell::ConfigValueCell(const ConfigValue& value)
+    : tag_(static_cast<uint8_t>(value.index())), int_(0) {
+  switch (tag_) {
+    case 0:
+      break;
+    case 1:
+      int_ = std::get<int64_t>(value);
+      break;
+    case 2:
+      double_ = std::get<double>(value);
+      break;
+    case 3:
+      bool_ = std::get<bool>(value);
+      break;
+    default:
+      heap_ = new Heap{};
+      heap_->value = value;
+      break;
+  }
+}
+
+ConfigValueCell::ConfigValueCell(ConfigValue&& value)
+    : tag_(static_cast<uint8_t>(value.index())), int_(0) {
+  if (is_heap()) {
+    heap_ = new Heap{};
+    heap_->value = std::move(value);
+  } else {
+    // 标量没有可移动的缓冲，与拷贝构造相同
+    *this = ConfigValueCell(static_cast<const ConfigValue&>(value));
+  }
+}
+
+ConfigValueCell::ConfigValueCell(const ConfigValueCell& other) noexcept
+    : tag_(other.tag_), int_(0) {
+  CopyPayload(other);
+  if (is_heap()) heap_->refs.fetch_add(1, std::memory_order_relaxed);
+}
+
+ConfigValueCell::ConfigValueCell(ConfigValueCell&& other) noexcept
+    : tag_(other.tag_), int_(0) {
+  CopyPayload(other);
+  other.tag_ = 0;
+  other.int_ = 0;
+}
+
+ConfigValueCell& ConfigValueCell::operator=(const ConfigValueCell& other) noexcept {
+  if (this != &other) {
+    ConfigValueCell copy(other);
+    *this = std::move(copy);
+  }
+  return *this;
+}
+
+ConfigValueCell& ConfigValueCell::operator=(ConfigValueCell&& other) noexcept {
+  if (this != &other) {
+    Release();
+    tag_ = other.tag_;
+    CopyPayload(other);
+    other.tag_ = 0;
+    other.int_ = 0;
+  }
+  return *this;
+}
+
+void ConfigValueCell::CopyPayload(const ConfigValueCell& other) noexcept {
+  // 负载是 8 字节的平凡类型之一，按字节复制即可，不关心当前活跃成员
+  std::memcpy(&int_, &other.int_, sizeof(int_));
+}
+
+void ConfigValueCell::Release() noexcept {
+  if (is_heap() && heap_->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    delete heap_;
+  }
+  tag_ = 0;
+  int_ = 0;
+}
+
+ConfigValue ConfigValueCell::ToValue() const {
+  switch (tag_) {
+    case 0:
+      return ConfigValue{};
+    case 1:
+      return int_;
+    case 2:
+      return double_;
+    case 3:
+      return bool_;
+    default:
+      return heap_->value;
+  }
+}
+
+std::shared_ptr<const ConfigValue> ConfigValueCell::Share() const {
+  if (!is_heap()) return std::make_shared<const ConfigValue>(ToValue());
+  heap_->refs.fetch_add(1, std::memory_order_relaxed);
+  Heap* heap = heap_;
+  // 删除器只归还这一份引用，堆块仍由最后一个持有者 (单元或读者) 释放
+  return std::shared_ptr<const ConfigValue>(&heap->value, [heap](const ConfigValue*) {
+    if (heap->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) delete heap;
+  });
+}
+
+bool ConfigValueCell::operator==(const ConfigValue& value) const {
+  if (value.index() != tag_) return false;
+  switch (tag_) {
+    case 0:
+      return true;
+    case 1:
+      return int_ == std::get<int64_t>(value);
+    case 2:
+      return double_ == std::get<double>(value);
+    case 3:
+      return bool_ == std::get<bool>(value);
+    default:
+      return heap_->value == value;
+  }
+}
+
+bool ConfigValueCell::operator==(const ConfigValueCell& other) const {
+  if (tag_ != other.tag_) return false;
+  switch (tag_) {
+    case 0:
+      return true;
+    case 1:
+      return int_ == other.int_;
+    case 2:
+      return double_ == other.double_;
+    case 3:
+      return bool_ == other.bool_;
+    default:
+      return heap_ == other.heap_ || heap_->value == other.heap_->value;
+  }
+}
+
+}  // namespace config
+}  // namespace plugins
+}  // namespace z3y
@@ -0,0 +1,83 @@
+﻿/**
+ * @file config_value_cell.h
+ * @brief ConfigValue 的 16 字节紧凑存储单元 (节点的 current_value / default_value)。
+ * * @details
+ * ConfigValue (std::variant) 为了容纳 std::string 与 std::vector，每份占 40 字节，
+ * 拷贝字符串/数组时还要深拷贝。节点里的值大多是整数、浮点、布尔，因此改存为
+ * “1 字节类型标签 + 8 字节负载”：标量内联，字符串与数组放在引用计数的不可变堆块里。
+ * * - 拷贝一个单元只是复制标量或增加一次引用计数，落盘快照在锁内不再深拷贝字符串。
+ * - 类型标签与 ConfigValue::index() 一一对应，可直接比较类型。
+ * - 修改值时整体替换单元 (旧堆块由最后一个持有者释放)，堆块内容永不修改。
+ * - Share() 把堆块以 shared_ptr<const ConfigValue> 交给读者 (GetValueShared)，
+ *   读取大数组只增加一次引用计数，不复制元素。
+ */
+#pragma once
+#ifndef Z3Y_CONFIG_VALUE_CELL_H_
+#define Z3Y_CONFIG_VALUE_CELL_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "interfaces_core/config_types.h"
+
+namespace z3y {
+namespace plugins {
+namespace config {
+using namespace z3y::interfaces::core;
+
+class ConfigValueCell {
+ public:
+  ConfigValueCell() noexcept : tag_(0), int_(0) {}
+  explicit ConfigValueCell(const ConfigValue& value);
+  /** @brief 移入 value：字符串与数组的缓冲直接成为堆块内容，不再复制一次。 */
+  explicit ConfigValueCell(ConfigValue&& value);
+  ConfigValueCell(const ConfigValueCell& other) noexcept;
+  ConfigValueCell(ConfigValueCell&& other) noexcept;
+  ConfigValueCell& operator=(const ConfigValueCell& other) noexcept;
+  ConfigValueCell& operator=(ConfigValueCell&& other) noexcept;
+  ~ConfigValueCell() { Release(); }
+
+  /** @brief 与 ConfigValue::index() 相同的类型序号 (0 = monostate 占位)。 */
+  size_t index() const noexcept { return tag_; }
+  bool is_empty() const noexcept { return tag_ == 0; }
+
+  /** @brief 还原为 ConfigValue (字符串与数组在此时才拷贝)。 */
+  ConfigValue ToValue() const;
+
+  /**
+   * @brief 共享只读的值：堆块类型只增加引用计数 (返回的指针持有堆块)，
+   * 标量包装为一份新的 ConfigValue。
+   */
+  std::shared_ptr<const ConfigValue> Share() const;
+
+  bool operator==(const ConfigValue& value) const;
+  bool operator!=(const ConfigValue& value) const { return !(*this == value); }
+  bool operator==(const ConfigValueCell& other) const;
+  bool operator!=(const ConfigValueCell& other) const { return !(*this == other); }
+
+ private:
+  struct Heap {
+    std::atomic<uint32_t> refs{1};
+    ConfigValue value;  ///< 只存 string / vector 三种数组
+  };
+
+  bool is_heap() const noexcept { return tag_ >= 4; }
+  void CopyPayload(const ConfigValueCell& other) noexcept;
+  void Release() noexcept;
+
+  uint8_t tag_;
+  union {
+    int64_t int_;
+    double double_;
+    bool bool_;
+    Heap* heap_;
+  };
+};
+
+}  // namespace config
+}  // namespace plugins
+}  // namespace z3y
+
+#endif  // Z3Y_CONFIG_VALUE_CELL_H_
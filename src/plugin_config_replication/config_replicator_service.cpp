@@ -0,0 +1,436 @@
+﻿/**
+ * @file config_replicator_service.cpp
+ * @brief 多节点配置复制器的核心实现：版本向量、增量合并、冲突判定与反熵同步。
+ * * @details
+ * 【面向维护者】
+ * **版本比较**：两个向量逐节点比较 (缺失的分量视为 0)。a 的每个分量都不小于 b 且至少一个更大
+ * 时 a 覆盖 b；双方各有更大的分量时为并发。
+ *
+ * **冲突判定**：并发时只比较两条修改自身的元数据 (角色排名、时间戳、发起节点)，与收到的先后
+ * 无关，所以每个节点对同一对版本得出相同的胜者。本地胜出时把合并后的版本回送给发送方，
+ * 发送方据此覆盖自己的值，不必等待下一次同步。
+ *
+ * **同步回送**：回送的值在锁外经 GetValue 读取，版本取自读取之前的版本表；期间若有新的本机修改，
+ * 它自己的增量随后会覆盖回送的版本。
+ */
+
+#include "config_replicator_service.h"
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <utility>
+
+#include "framework/z3y_service_locator.h"
+
+Z3Y_AUTO_REGISTER_COMPONENT(z3y::plugins::config_replication::ConfigReplicatorService,
+                            "Config.Replicator", true);
+
+namespace z3y::plugins::config_replication {
+
+using namespace z3y::interfaces::core;
+
+namespace {
+
+/** @brief 当前线程正在写入远端修改：由此产生的本机修改事件不再发出。 */
+thread_local bool t_applying_remote = false;
+
+struct ApplyingRemoteGuard {
+  ApplyingRemoteGuard() { t_applying_remote = true; }
+  ~ApplyingRemoteGuard() { t_applying_remote = false; }
+};
+
+enum class Order { kEqual, kBefore, kAfter, kConcurrent };
+
+using VersionVector = std::vector<std::pair<uint64_t, uint64_t>>;
+
+/** @brief a 相对于 b 的先后 (两者均按节点升序)。 */
+Order CompareVersions(const VersionVector& a, const VersionVector& b) {
+  bool a_ahead = false;
+  bool b_ahead = false;
+  size_t i = 0;
+  size_t j = 0;
+  while (i < a.size() || j < b.size()) {
+    uint64_t ca = 0;
+    uint64_t cb = 0;
+    if (j == b.size() || (i < a.size() && a[i].first < b[j].first)) {
+      ca = a[i++].second;
+    } else if (i == a.size() || b[j].first < a[i].first) {
+      cb = b[j++].second;
+    } else {
+      ca = a[i++].second;
+      cb = b[j++].second;
+    }
+    a_ahead = a_ahead || ca > cb;
+    b_ahead = b_ahead || cb > ca;
+  }
+  if (a_ahead && b_ahead) return Order::kConcurrent;
+  if (a_ahead) return Order::kAfter;
+  if (b_ahead) return Order::kBefore;
+  return Order::kEqual;
+}
+
+/** @brief 逐节点取最大值。 */
+VersionVector MergeVersions(const VersionVector& a, const VersionVector& b) {
+  VersionVector merged;
+  merged.reserve(std::max(a.size(), b.size()));
+  size_t i = 0;
+  size_t j = 0;
+  while (i < a.size() || j < b.size()) {
+    if (j == b.size() || (i < a.size() && a[i].first < b[j].first)) {
+      merged.push_back(a[i++]);
+    } else if (i == a.size() || b[j].first < a[i].first) {
+      merged.push_back(b[j++]);
+    } else {
+      merged.emplace_back(a[i].first, std::max(a[i].second, b[j].second));
+      ++i;
+      ++j;
+    }
+  }
+  return merged;
+}
+
+/** @brief version 是否含有摘要之后的分量 (请求者尚未见过的修改)。 */
+bool NewerThan(const VersionVector& version, const VersionVector& summary) {
+  for (const auto& component : version) {
+    auto it = std::lower_bound(
+        summary.begin(), summary.end(), component.first,
+        [](const std::pair<uint64_t, uint64_t>& s, uint64_t node) { return s.first < node; });
+    const uint64_t seen = (it != summary.end() && it->first == component.first) ? it->second : 0;
+    if (component.second > seen) return true;
+  }
+  return false;
+}
+
+/** @brief 增量事件中一个键的大致字节数 (用于切分，不必精确)。 */
+size_t EstimateBytes(const ConfigReplicaEntry& entry) {
+  size_t value_bytes = std::visit(
+      [](const auto& v) -> size_t {
+        using T = std::decay_t<decltype(v)>;
+        if constexpr (std::is_same_v<T, std::string>) {
+          return v.size();
+        } else if constexpr (std::is_same_v<T, std::vector<std::string>>) {
+          size_t total = 0;
+          for (const auto& s : v) total += 4 + s.size();
+          return total;
+        } else if constexpr (std::is_same_v<T, std::vector<int64_t>> ||
+                             std::is_same_v<T, std::vector<double>>) {
+          return v.size() * 8;
+        } else {
+          return 8;
+        }
+      },
+      entry.value);
+  return 40 + entry.path.size() + entry.operator_role.size() + 16 * entry.version.size() +
+         value_bytes;
+}
+
+uint64_t RandomNodeId() {
+  std::random_device rd;
+  const uint64_t hi = rd();
+  const uint64_t lo = rd();
+  const uint64_t id =
+      (hi << 32) ^ lo ^
+      static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+  return id != 0 ? id : 1;
+}
+
+}  // namespace
+
+bool ConfigReplicatorService::Start(const ConfigReplicationOptions& options,
+                                    PluginPtr<INetEventBridge> bridge,
+                                    std::string& out_error) {
+  std::lock_guard<std::mutex> lifecycle(lifecycle_mutex_);
+  if (running_.load()) {
+    out_error = "Replicator is already running.";
+    return false;
+  }
+  PluginPtr<z3y::IEventBus> bus;
+  try {
+    config_ = z3y::GetDefaultService<IConfigService>();
+    bus = z3y::GetService<z3y::IEventBus>(z3y::clsid::kEventBus);
+  } catch (const z3y::PluginException& e) {
+    config_.reset();
+    out_error = std::string("Config service or event bus unavailable: ") + e.what();
+    return false;
+  }
+
+  options_ = options;
+  if (options_.max_delta_bytes == 0) options_.max_delta_bytes = 1;
+  uint64_t node_id = node_id_.load();
+  if (options_.node_id != 0) node_id = options_.node_id;
+  if (node_id == 0) node_id = RandomNodeId();
+  node_id_.store(node_id);
+  {
+    // 计数以微秒时钟为起点：重启后的新修改仍大于对端见过的旧计数
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    const auto now_us = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::system_clock::now().time_since_epoch())
+            .count());
+    local_counter_ = std::max(local_counter_, now_us);
+  }
+
+  bus_ = bus;
+  listener_ = std::make_shared<Listener>(this);
+  local_conn_ = bus->SubscribeGlobalBatch<ConfigChangedEvent>(listener_,
+                                                              &Listener::OnLocalChanges);
+  delta_conn_ = bus->SubscribeGlobal<ConfigReplicaDeltaEvent>(listener_, &Listener::OnDelta);
+  sync_conn_ =
+      bus->SubscribeGlobal<ConfigReplicaSyncRequestEvent>(listener_, &Listener::OnSyncRequest);
+  if (bridge) {
+    bridge->Export<ConfigReplicaDeltaEvent>();
+    bridge->Export<ConfigReplicaSyncRequestEvent>();
+    bridge->Import<ConfigReplicaDeltaEvent>();
+    bridge->Import<ConfigReplicaSyncRequestEvent>();
+  }
+  running_.store(true);
+  return true;
+}
+
+void ConfigReplicatorService::Stop() {
+  std::lock_guard<std::mutex> lifecycle(lifecycle_mutex_);
+  running_.store(false);
+  local_conn_.Disconnect();
+  delta_conn_.Disconnect();
+  sync_conn_.Disconnect();
+  listener_.reset();
+  config_.reset();
+}
+
+void ConfigReplicatorService::RequestSync(bool full) {
+  if (!running_.load()) return;
+  const PluginPtr<z3y::IEventBus> bus = bus_.lock();
+  if (!bus) return;
+  ConfigReplicaSyncRequestEvent request;
+  request.sender = GetNodeId();
+  if (!full) {
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    request.summary.assign(summary_.begin(), summary_.end());
+  }
+  bus->FireGlobal<ConfigReplicaSyncRequestEvent>(std::move(request));
+}
+
+ConfigReplicationStats ConfigReplicatorService::GetStats() const {
+  ConfigReplicationStats stats;
+  stats.local_changes = local_changes_.load(std::memory_order_relaxed);
+  stats.delta_events_sent = delta_events_sent_.load(std::memory_order_relaxed);
+  stats.remote_received = remote_received_.load(std::memory_order_relaxed);
+  stats.remote_applied = remote_applied_.load(std::memory_order_relaxed);
+  stats.remote_stale = remote_stale_.load(std::memory_order_relaxed);
+  stats.conflicts_local_won = conflicts_local_won_.load(std::memory_order_relaxed);
+  stats.remote_rejected = remote_rejected_.load(std::memory_order_relaxed);
+  stats.sync_requests_served = sync_requests_served_.load(std::memory_order_relaxed);
+  stats.sync_entries_sent = sync_entries_sent_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+bool ConfigReplicatorService::Replicates(const std::string& path) const {
+  if (options_.path_prefixes.empty()) return true;
+  for (const auto& prefix : options_.path_prefixes) {
+    if (path.compare(0, prefix.size(), prefix) == 0) return true;
+  }
+  return false;
+}
+
+bool ConfigReplicatorService::RemoteWins(const Versioned& local,
+                                         const ConfigReplicaEntry& remote) const {
+  if (options_.conflict_policy == ReplicaConflictPolicy::kRolePriority) {
+    const auto rank = [this](const std::string& role) {
+      const auto& order = options_.role_priority;
+      return static_cast<size_t>(std::find(order.begin(), order.end(), role) - order.begin());
+    };
+    const size_t local_rank = rank(local.operator_role);
+    const size_t remote_rank = rank(remote.operator_role);
+    if (local_rank != remote_rank) return remote_rank < local_rank;
+  }
+  if (local.timestamp_ms != remote.timestamp_ms) return remote.timestamp_ms > local.timestamp_ms;
+  return remote.origin > local.origin;
+}
+
+void ConfigReplicatorService::StoreVersionLocked(const std::string& path, Versioned versioned) {
+  for (const auto& component : versioned.version) {
+    uint64_t& seen = summary_[component.first];
+    seen = std::max(seen, component.second);
+  }
+  versions_[path] = std::move(versioned);
+}
+
+void ConfigReplicatorService::OnLocalChanges(const z3y::EventBatch<ConfigChangedEvent>& batch) {
+  if (t_applying_remote || !running_.load(std::memory_order_relaxed)) return;
+  const uint64_t node_id = GetNodeId();
+  std::vector<ConfigReplicaEntry> entries;
+  {
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    for (const ConfigChangedEvent& e : batch) {
+      if (!e.new_value || !Replicates(e.path)) continue;
+      Versioned versioned;
+      auto it = versions_.find(e.path);
+      if (it != versions_.end()) versioned.version = it->second.version;
+      // 只推进本节点的分量：新值覆盖本节点见过的该键的全部版本
+      versioned.version = MergeVersions(versioned.version, {{node_id, ++local_counter_}});
+      versioned.timestamp_ms = e.timestamp_ms;
+      versioned.origin = node_id;
+      versioned.operator_role = e.operator_role;
+      entries.push_back({e.path, *e.new_value, versioned.version, versioned.timestamp_ms,
+                         node_id, versioned.operator_role});
+      StoreVersionLocked(e.path, std::move(versioned));
+    }
+  }
+  if (entries.empty()) return;
+  local_changes_.fetch_add(entries.size(), std::memory_order_relaxed);
+  FireDeltas(std::move(entries), 0);
+}
+
+void ConfigReplicatorService::OnDelta(const ConfigReplicaDeltaEvent& e) {
+  const uint64_t node_id = GetNodeId();
+  if (!running_.load() || e.sender == node_id || (e.target != 0 && e.target != node_id)) {
+    return;
+  }
+  remote_received_.fetch_add(e.entries.size(), std::memory_order_relaxed);
+
+  std::vector<const ConfigReplicaEntry*> to_apply;
+  std::vector<ConfigReplicaEntry> local_winners;  // 回送给发送方的本地胜出版本
+  {
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    for (const ConfigReplicaEntry& entry : e.entries) {
+      if (!Replicates(entry.path)) {
+        remote_stale_.fetch_add(1, std::memory_order_relaxed);
+        continue;
+      }
+      auto it = versions_.find(entry.path);
+      const Versioned local = it != versions_.end() ? it->second : Versioned{};
+      switch (CompareVersions(entry.version, local.version)) {
+        case Order::kEqual:
+        case Order::kBefore:
+          remote_stale_.fetch_add(1, std::memory_order_relaxed);
+          break;
+        case Order::kAfter:
+          to_apply.push_back(&entry);
+          break;
+        case Order::kConcurrent:
+          if (RemoteWins(local, entry)) {
+            to_apply.push_back(&entry);
+          } else {
+            conflicts_local_won_.fetch_add(1, std::memory_order_relaxed);
+            Versioned merged = local;
+            merged.version = MergeVersions(local.version, entry.version);
+            local_winners.push_back({entry.path, ConfigValue{}, merged.version,
+                                     merged.timestamp_ms, merged.origin, merged.operator_role});
+            StoreVersionLocked(entry.path, std::move(merged));
+          }
+          break;
+      }
+    }
+  }
+
+  // 锁外写入：按相邻的同一角色分组，每组一次事务
+  std::vector<bool> applied(to_apply.size(), false);
+  for (size_t begin = 0; begin < to_apply.size();) {
+    size_t end = begin + 1;
+    while (end < to_apply.size() &&
+           to_apply[end]->operator_role == to_apply[begin]->operator_role) {
+      ++end;
+    }
+    std::vector<const ConfigReplicaEntry*> group(to_apply.begin() + begin,
+                                                 to_apply.begin() + end);
+    std::vector<bool> group_applied;
+    ApplyRemote(group, group_applied);
+    std::copy(group_applied.begin(), group_applied.end(), applied.begin() + begin);
+    begin = end;
+  }
+
+  if (!to_apply.empty()) {
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    for (size_t i = 0; i < to_apply.size(); ++i) {
+      const ConfigReplicaEntry& entry = *to_apply[i];
+      if (!applied[i]) {
+        // 不记入版本：之后的同步会再次送达
+        remote_rejected_.fetch_add(1, std::memory_order_relaxed);
+        continue;
+      }
+      remote_applied_.fetch_add(1, std::memory_order_relaxed);
+      Versioned versioned;
+      auto it = versions_.find(entry.path);
+      versioned.version = it != versions_.end()
+                              ? MergeVersions(it->second.version, entry.version)
+                              : entry.version;
+      versioned.timestamp_ms = entry.timestamp_ms;
+      versioned.origin = entry.origin;
+      versioned.operator_role = entry.operator_role;
+      StoreVersionLocked(entry.path, std::move(versioned));
+    }
+  }
+
+  if (!local_winners.empty() && config_) {
+    for (auto& winner : local_winners) winner.value = config_->GetValue(winner.path);
+    FireDeltas(std::move(local_winners), e.sender);
+  }
+}
+
+void ConfigReplicatorService::ApplyRemote(const std::vector<const ConfigReplicaEntry*>& group,
+                                          std::vector<bool>& applied) {
+  applied.assign(group.size(), false);
+  if (!config_ || group.empty()) return;
+  const std::string& role = group.front()->operator_role;
+  ApplyingRemoteGuard guard;
+  std::vector<ConfigChange> changes;
+  changes.reserve(group.size());
+  for (const ConfigReplicaEntry* entry : group) changes.push_back({entry->path, entry->value});
+  if (config_->ApplyChanges(changes, role).empty()) {
+    applied.assign(group.size(), true);
+    return;
+  }
+  // 事务是全有或全无：有坏值时逐项写入，其余键照常生效
+  if (group.size() == 1) return;
+  for (size_t i = 0; i < changes.size(); ++i) {
+    applied[i] = config_->ApplyChanges({changes[i]}, role).empty();
+  }
+}
+
+void ConfigReplicatorService::OnSyncRequest(const ConfigReplicaSyncRequestEvent& e) {
+  if (!running_.load() || e.sender == GetNodeId() || !config_) return;
+  std::vector<ConfigReplicaEntry> entries;
+  {
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    for (const auto& kv : versions_) {
+      if (!NewerThan(kv.second.version, e.summary)) continue;
+      entries.push_back({kv.first, ConfigValue{}, kv.second.version, kv.second.timestamp_ms,
+                         kv.second.origin, kv.second.operator_role});
+    }
+  }
+  for (auto& entry : entries) entry.value = config_->GetValue(entry.path);
+  entries.erase(std::remove_if(entries.begin(), entries.end(),
+                               [](const ConfigReplicaEntry& entry) {
+                                 return std::holds_alternative<std::monostate>(entry.value);
+                               }),
+                entries.end());
+  sync_requests_served_.fetch_add(1, std::memory_order_relaxed);
+  sync_entries_sent_.fetch_add(entries.size(), std::memory_order_relaxed);
+  FireDeltas(std::move(entries), e.sender);
+}
+
+void ConfigReplicatorService::FireDeltas(std::vector<ConfigReplicaEntry> entries,
+                                         uint64_t target) {
+  const PluginPtr<z3y::IEventBus> bus = bus_.lock();
+  if (!bus || entries.empty()) return;
+  ConfigReplicaDeltaEvent delta;
+  delta.sender = GetNodeId();
+  delta.target = target;
+  size_t bytes = 0;
+  const auto fire = [&] {
+    bus->FireGlobal<ConfigReplicaDeltaEvent>(delta);
+    delta_events_sent_.fetch_add(1, std::memory_order_relaxed);
+    delta.entries.clear();
+    bytes = 0;
+  };
+  for (auto& entry : entries) {
+    const size_t size = EstimateBytes(entry);
+    if (!delta.entries.empty() && bytes + size > options_.max_delta_bytes) fire();
+    bytes += size;
+    delta.entries.push_back(std::move(entry));
+  }
+  fire();
+}
+
+}  // namespace z3y::plugins::config_replication
@@ -0,0 +1,125 @@
+﻿/**
+ * @file config_replicator_service.h
+ * @brief 多节点配置复制器的具体实现类声明。
+ * * @details
+ * 【面向维护者】
+ * 1. **线程**：本机修改在修改者线程上 (ConfigChangedEvent 的批订阅，kDirect) 记版本并发出增量；
+ * 远端增量与同步请求在桥的网络线程上处理。
+ * 2. **版本表**：`versions_` 只记录复制期间出现过修改的键 (路径 → 版本向量 + 胜出修改的元数据)，
+ * `summary_` 是版本表中每个节点分量的最大值，作为同步请求的摘要。二者受 `state_mutex_` 保护。
+ * 3. **应用远端修改**：在 `state_mutex_` 内判定胜负，释放后再调用 ApplyChanges (配置回调可能
+ * 连锁写入，甚至回调复制器)，写入成功后重新加锁合并版本。
+ * 4. **锁顺序**：state_mutex_ 是叶子锁，持有期间不调用配置服务、不发布事件。
+ */
+
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "framework/connection.h"
+#include "framework/i_event_bus.h"
+#include "framework/z3y_define_impl.h"
+#include "interfaces_core/i_config_replication.h"
+#include "interfaces_core/i_config_service.h"
+
+namespace z3y::plugins::config_replication {
+
+/**
+ * @brief IConfigReplicator 的默认实现类。
+ */
+class ConfigReplicatorService
+    : public z3y::PluginImpl<ConfigReplicatorService,
+                             z3y::interfaces::core::IConfigReplicator> {
+ public:
+  Z3Y_DEFINE_COMPONENT_ID("z3y-core-ConfigReplicator-Impl-v1");
+
+  ~ConfigReplicatorService() override { Stop(); }
+
+  void Shutdown() override { Stop(); }
+
+  bool Start(const z3y::interfaces::core::ConfigReplicationOptions& options,
+             PluginPtr<z3y::interfaces::core::INetEventBridge> bridge,
+             std::string& out_error) override;
+  void Stop() override;
+  void RequestSync(bool full = false) override;
+  uint64_t GetNodeId() const override { return node_id_.load(std::memory_order_relaxed); }
+  z3y::interfaces::core::ConfigReplicationStats GetStats() const override;
+
+ private:
+  using VersionVector = std::vector<std::pair<uint64_t, uint64_t>>;  ///< 按节点升序
+
+  /** @brief 版本表中的一个键：当前值的版本与胜出修改的元数据。 */
+  struct Versioned {
+    VersionVector version;
+    uint64_t timestamp_ms = 0;
+    uint64_t origin = 0;
+    std::string operator_role;
+  };
+
+  /** @brief 事件总线的订阅者 (总线要求 enable_shared_from_this)，转发给复制器。 */
+  struct Listener : std::enable_shared_from_this<Listener> {
+    explicit Listener(ConfigReplicatorService* owner) : owner(owner) {}
+    void OnLocalChanges(const z3y::EventBatch<z3y::interfaces::core::ConfigChangedEvent>& batch) {
+      owner->OnLocalChanges(batch);
+    }
+    void OnDelta(const z3y::interfaces::core::ConfigReplicaDeltaEvent& e) { owner->OnDelta(e); }
+    void OnSyncRequest(const z3y::interfaces::core::ConfigReplicaSyncRequestEvent& e) {
+      owner->OnSyncRequest(e);
+    }
+    ConfigReplicatorService* owner;
+  };
+
+  void OnLocalChanges(const z3y::EventBatch<z3y::interfaces::core::ConfigChangedEvent>& batch);
+  void OnDelta(const z3y::interfaces::core::ConfigReplicaDeltaEvent& e);
+  void OnSyncRequest(const z3y::interfaces::core::ConfigReplicaSyncRequestEvent& e);
+
+  bool Replicates(const std::string& path) const;
+  /** @brief 并发修改时远端是否胜出 (所有节点对同一对版本的判定相同)。 */
+  bool RemoteWins(const Versioned& local,
+                  const z3y::interfaces::core::ConfigReplicaEntry& remote) const;
+  /** @brief [state_mutex_] 记录 path 的新版本并推进摘要。 */
+  void StoreVersionLocked(const std::string& path, Versioned versioned);
+  /**
+   * @brief 以 ApplyChanges 写入一组远端值 (同一角色)；整批被拒时逐项重试以隔离坏值。
+   * @param applied 输出：写入成功的下标。
+   */
+  void ApplyRemote(const std::vector<const z3y::interfaces::core::ConfigReplicaEntry*>& group,
+                   std::vector<bool>& applied);
+  /** @brief 按 max_delta_bytes 切分后发布增量事件。 */
+  void FireDeltas(std::vector<z3y::interfaces::core::ConfigReplicaEntry> entries,
+                  uint64_t target);
+
+  std::mutex lifecycle_mutex_;  ///< 串行化 Start / Stop
+  z3y::interfaces::core::ConfigReplicationOptions options_;
+  std::atomic<uint64_t> node_id_{0};
+  PluginPtr<z3y::interfaces::core::IConfigService> config_;
+  std::weak_ptr<z3y::IEventBus> bus_;
+  std::shared_ptr<Listener> listener_;
+  z3y::ScopedConnection local_conn_;
+  z3y::ScopedConnection delta_conn_;
+  z3y::ScopedConnection sync_conn_;
+  std::atomic<bool> running_{false};
+
+  mutable std::mutex state_mutex_;  ///< 保护以下版本状态 (叶子锁)
+  std::unordered_map<std::string, Versioned> versions_;
+  std::map<uint64_t, uint64_t> summary_;  ///< 节点 → 版本表中该节点分量的最大值
+  uint64_t local_counter_ = 0;            ///< 本节点最近一次修改的计数
+
+  std::atomic<uint64_t> local_changes_{0};
+  std::atomic<uint64_t> delta_events_sent_{0};
+  std::atomic<uint64_t> remote_received_{0};
+  std::atomic<uint64_t> remote_applied_{0};
+  std::atomic<uint64_t> remote_stale_{0};
+  std::atomic<uint64_t> conflicts_local_won_{0};
+  std::atomic<uint64_t> remote_rejected_{0};
+  std::atomic<uint64_t> sync_requests_served_{0};
+  std::atomic<uint64_t> sync_entries_sent_{0};
+};
+
+}  // namespace z3y::plugins::config_replication
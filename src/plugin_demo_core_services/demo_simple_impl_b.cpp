@@ -40,6 +40,13 @@
  //      或其 CLSID 来创建。
 Z3Y_AUTO_REGISTER_COMPONENT(z3y::demo::DemoSimpleImplB, "Demo.Simple.B", false);
 
+ // [插件开发者核心]
+ // **声明式事件处理函数**
+ // 每个 DemoSimpleImplB 实例在创建时自动订阅 DemoGlobalEvent (kDirect)，
+ // 实例释放后订阅随之失效。无需在 Initialize() 中调用 SubscribeGlobal，也无需保存 Connection。
+Z3Y_EVENT_HANDLER(z3y::demo::DemoSimpleImplB, z3y::demo::DemoGlobalEvent,
+    &z3y::demo::DemoSimpleImplB::OnGlobalEvent);
+
 namespace z3y {
     namespace demo {
 
@@ -52,7 +59,13 @@ namespace z3y {
         }
 
         std::string DemoSimpleImplB::GetSimpleString() {
-            return "Hello from DemoSimpleImplB";
+            const int received = events_received_.load(std::memory_order_relaxed);
+            if (received == 0) return "Hello from DemoSimpleImplB";
+            return "Hello from DemoSimpleImplB (global events: " + std::to_string(received) + ")";
+        }
+
+        void DemoSimpleImplB::OnGlobalEvent(const DemoGlobalEvent&) {
+            events_received_.fetch_add(1, std::memory_order_relaxed);
         }
 
     }  // namespace demo
@@ -26,6 +26,7 @@
  *
  * 演示了如何为同一个接口 (`IDemoSimple`)
  * 提供 *第二个*（非默认）的实现。
+ * 它还演示了声明式事件处理函数 (`Z3Y_EVENT_HANDLER`)：每个实例自动订阅 `DemoGlobalEvent`。
  *
  * @see IDemoSimple (它实现的接口)
  * @see z3y::demo::DemoSimpleImplA (同一接口的默认实现)
@@ -36,8 +37,10 @@
 #ifndef Z3Y_PLUGIN_DEMO_CORE_DEMO_SIMPLE_IMPL_B_H_
 #define Z3Y_PLUGIN_DEMO_CORE_DEMO_SIMPLE_IMPL_B_H_
 
+#include <atomic>
 #include <string>
 #include "framework/z3y_define_impl.h"
+#include "interfaces_demo/demo_events.h"    // 包含 DemoGlobalEvent
 #include "interfaces_demo/i_demo_simple.h"  // 包含 IDemoSimple 接口
 
 namespace z3y {
@@ -60,6 +63,12 @@ namespace z3y {
             DemoSimpleImplB();
             virtual ~DemoSimpleImplB();
             std::string GetSimpleString() override;
+
+            //! [声明式事件处理函数] 由 Z3Y_EVENT_HANDLER 在实例创建时订阅
+            void OnGlobalEvent(const DemoGlobalEvent& e);
+
+        private:
+            std::atomic<int> events_received_{ 0 };
         };
 
     }  // namespace demo
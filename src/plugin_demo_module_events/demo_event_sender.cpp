@@ -116,6 +116,9 @@ namespace z3y {
                 }
                 if (!bus_) {
                     bus_ = z3y::GetService<IEventBus>(clsid::kEventBus);
+                    echo_ = std::make_shared<EchoListener>();
+                    echo_conn_ = bus_->SubscribeGlobal<DemoGlobalEvent>(
+                        echo_, &EchoListener::OnGlobalEvent);
                 }
                 return true;
             } catch (const z3y::PluginException& e) {
@@ -47,6 +47,8 @@
 #define Z3Y_PLUGIN_DEMO_MODULE_EVENTS_SENDER_H_
 
 #include "framework/z3y_define_impl.h"
+#include "framework/connection.h"  // 包含 ScopedConnection
+#include "interfaces_demo/demo_events.h"
 #include "interfaces_demo/i_demo_event_sender.h"
 #include "interfaces_demo/i_demo_logger.h" // 包含 IDemoLogger
 
@@ -117,6 +119,19 @@ namespace z3y {
             PluginPtr<IDemoLogger> logger_;
             //! 缓存的 EventBus 服务指针 (懒加载)
             PluginPtr<IEventBus> bus_;
+
+            /**
+             * @brief [演示] 订阅者不是服务自身的情形：统计收到的 DemoGlobalEvent。
+             * @details 卸载插件时框架只移除单例自身的订阅；这类辅助对象的订阅
+             * 由下面的 `echo_conn_` 在服务析构时断开。
+             */
+            struct EchoListener : std::enable_shared_from_this<EchoListener> {
+                void OnGlobalEvent(const DemoGlobalEvent&) { ++received; }
+                int received = 0;
+            };
+            std::shared_ptr<EchoListener> echo_;
+            //! 随服务析构自动 `Disconnect()` (RAII)
+            z3y::ScopedConnection echo_conn_;
         };
 
     }  // namespace demo
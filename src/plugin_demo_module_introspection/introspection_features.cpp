@@ -162,6 +162,30 @@ namespace z3y {
             logger_->Log("   ... Total components registered: " +
                 std::to_string(all_components.size()));
 
+            // 4.1 [演示] GetPluginMemoryUsage (宿主未启用内存记账时为空)
+            auto usage = query_->GetPluginMemoryUsage();
+            if (usage.empty()) {
+                logger_->Log("   ... Memory accounting disabled.");
+            }
+            for (const auto& u : usage) {
+                logger_->Log("   ... Memory: " + u.plugin_path + ": " +
+                    std::to_string(u.component_bytes) + " bytes / " +
+                    std::to_string(u.live_components) + " components, " +
+                    std::to_string(u.subscriptions) + " subscriptions");
+            }
+
+            // 4.2 [演示] GetPluginCpuUsage (宿主未启用 CPU 记账时为空)
+            auto cpu = query_->GetPluginCpuUsage();
+            if (cpu.empty()) {
+                logger_->Log("   ... CPU accounting disabled.");
+            }
+            for (const auto& u : cpu) {
+                logger_->Log("   ... CPU: " + u.plugin_path + ": " +
+                    std::to_string(u.callback_cpu_ns / 1000) + " us in " +
+                    std::to_string(u.callback_calls) + " callbacks, " +
+                    std::to_string(u.lifecycle_cpu_ns / 1000) + " us in lifecycle");
+            }
+
             // --- 高级特性演示 ---
 
             logger_->Log("\n======= [Advanced Features Demo] Starting =======");
@@ -0,0 +1,631 @@
+﻿/**
+ * @file metrics_exporter_service.cpp
+ * @brief 指标导出插件的核心实现：快照合并、OpenMetrics / StatsD 渲染与 HTTP 端点。
+ * * @details
+ * 【面向维护者】
+ * 1. **线程**：一个刷新线程按 `System.Metrics.IntervalMs` 调用 Refresh；
+ * 一个 HTTP 线程串行处理 `/metrics` 请求（抓取方通常只有一两个 Prometheus，
+ * 不值得引入线程池）。二者通过 front_mutex_ 交换渲染好的文本。
+ * 2. **计数器单调性**：报告从业务线程提交到 Sink 回调之间有一个窗口，此时根节点
+ * 已清零而 ReportedTotals 尚未累加，`已输出 + 在途` 会短暂偏小。
+ * 计数器按 OpenMetrics 语义不允许回退，所以每一代都与上一代取最大值，
+ * 少算的部分在下一次刷新时补上。
+ * 3. **gauge 语义**：max 与分位数取最近一个窗口（在途数据优先，否则取最近一份报告），
+ * 同名根节点分布在多个线程上时取各线程的最大值（分位数因此是上界近似）。
+ * 4. **机群汇总 (System.Metrics.FleetTarget)**：每条序列另外累计报告中的直方图桶，
+ * 刷新时交给 FleetEncoder 编码为相对上一次发送的增量（见 fleet_snapshot.h），
+ * 与 StatsD 一样以 UDP 推送。计数取整到纳秒 / kValueScale 定点值后发送。
+ */
+
+#include "metrics_exporter_service.h"
+
+#include <spdlog/fmt/fmt.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+#include "framework/z3y_service_locator.h"
+#include "interfaces_core/z3y_log_macros.h"
+#include "interfaces_profiler/i_profiler_service.h"
+
+Z3Y_AUTO_REGISTER_SERVICE(z3y::plugins::metrics::MetricsExporterService,
+                          "System.MetricsExporter", true);
+
+namespace z3y::plugins::metrics {
+
+using namespace z3y::interfaces::core;
+using namespace z3y::interfaces::profiler;
+
+namespace {
+
+constexpr int kHttpPollMs = 200;      ///< HTTP 线程检查停止标志的周期
+constexpr int kHttpIoTimeoutMs = 2000;  ///< 单个请求的读写超时
+constexpr size_t kHttpMaxRequest = 8192;
+constexpr const char* kQuantiles[4] = {"0.5", "0.95", "0.99", "0.999"};
+constexpr const char* kStatsdQuantiles[4] = {"p50", "p95", "p99", "p999"};
+
+bool IsTimed(NodeType type) {
+  return type == NodeType::Timer || type == NodeType::Linear;
+}
+
+/** @brief 与区域设置无关的数字格式（OpenMetrics 与 StatsD 都要求 '.' 作小数点）。 */
+std::string FormatNumber(double v) {
+  char buf[32];
+  int n = std::snprintf(buf, sizeof(buf), "%.12g", v);
+  std::string s(buf, n > 0 ? static_cast<size_t>(n) : 0);
+  std::replace(s.begin(), s.end(), ',', '.');
+  return s;
+}
+
+/** @brief 指标名只允许 [a-zA-Z0-9_:]，其余字符替换为 '_'。 */
+std::string SanitizeMetricName(const std::string& name) {
+  std::string out = name.empty() ? std::string("z3y") : name;
+  for (char& c : out) {
+    bool ok = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+              (c >= '0' && c <= '9') || c == '_' || c == ':';
+    if (!ok) c = '_';
+  }
+  if (out[0] >= '0' && out[0] <= '9') out.insert(out.begin(), '_');
+  return out;
+}
+
+/** @brief StatsD 名字以 '.' 分层；路径分隔符 '/' 映射为 '.'，其余特殊字符替换为 '_'。 */
+std::string SanitizeStatsdName(const std::string& path) {
+  std::string out = path;
+  for (char& c : out) {
+    if (c == '/') {
+      c = '.';
+      continue;
+    }
+    bool ok = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+              (c >= '0' && c <= '9') || c == '_' || c == '-';
+    if (!ok) c = '_';
+  }
+  return out;
+}
+
+void AppendLabelValue(std::string& out, const std::string& value) {
+  out += '"';
+  for (char c : value) {
+    if (c == '\\' || c == '"') {
+      out += '\\';
+      out += c;
+    } else if (c == '\n') {
+      out += "\\n";
+    } else {
+      out += c;
+    }
+  }
+  out += '"';
+}
+
+void AppendSample(std::string& out, const std::string& metric,
+                  const std::string& path, NodeType type, const char* quantile,
+                  double value) {
+  out += metric;
+  out += "{path=";
+  AppendLabelValue(out, path);
+  out += ",type=\"";
+  out += z3y::interfaces::profiler::detail::NodeTypeName(type);
+  out += '"';
+  if (quantile) {
+    out += ",quantile=\"";
+    out += quantile;
+    out += '"';
+  }
+  out += "} ";
+  out += FormatNumber(value);
+  out += '\n';
+}
+
+/** @brief 取整为机群编码使用的整数单位；序列已保证单调，取整不会让增量为负。 */
+fleet::FleetSeriesMap ToFleetSeries(const MetricSeriesMap& series) {
+  fleet::FleetSeriesMap out;
+  for (const auto& [path, s] : series) {
+    fleet::FleetSeries& f = out[path];
+    f.type = s.type;
+    f.count = s.count;
+    f.total_ns = static_cast<uint64_t>(std::llround(std::max(s.total_ms, 0.0) * 1.0e6));
+    f.sum_fixed = std::llround(s.sum_value * AggregatorNode::kValueScale);
+    f.histogram_bits = s.histogram_bits;
+    f.histogram = s.histogram;
+  }
+  return out;
+}
+
+void AppendFamily(std::string& out, const std::string& family, const char* kind,
+                  const char* help) {
+  out += "# TYPE " + family + ' ' + kind + '\n';
+  out += "# HELP " + family + ' ' + help + '\n';
+}
+
+}  // namespace
+
+void AccumulateHistogram(MetricSeries& dst, uint32_t bits,
+                         const std::map<uint32_t, uint64_t>& src) {
+  if (src.empty()) return;
+  if (dst.histogram_bits != bits) {
+    dst.histogram.clear();
+    dst.histogram_bits = bits;
+  }
+  for (const auto& [index, c] : src) dst.histogram[index] += c;
+}
+
+void AccumulateReport(const ProfileReport& report, bool take_window,
+                      MetricSeriesMap& out) {
+  std::vector<std::string> paths(report.nodes.size());
+  for (size_t i = 0; i < report.nodes.size(); ++i) {
+    const ReportNode& n = report.nodes[i];
+    // 先序排列保证父节点的路径已经生成
+    paths[i] = (n.parent >= 0 && static_cast<size_t>(n.parent) < i)
+                   ? paths[n.parent] + '/' + n.name
+                   : n.name;
+    MetricSeries& s = out[paths[i]];
+    s.type = n.type;
+    s.count += n.count;
+    s.total_ms += n.total_ms;
+    s.sum_value += n.sum_value;
+    if (!n.histogram.empty()) {
+      AccumulateHistogram(s, n.histogram_bits,
+                          std::map<uint32_t, uint64_t>(n.histogram.begin(),
+                                                       n.histogram.end()));
+    }
+    if (n.count == 0) continue;
+    double window_max = n.type == NodeType::Value ? n.max_value : n.max_ms;
+    if (take_window) {
+      s.max = window_max;
+      s.has_percentiles = n.has_percentiles;
+      s.percentiles = n.percentiles;
+    } else {
+      s.max = std::max(s.max, window_max);
+      if (n.has_percentiles) {
+        for (size_t q = 0; q < s.percentiles.size(); ++q) {
+          s.percentiles[q] = s.has_percentiles
+                                 ? std::max(s.percentiles[q], n.percentiles[q])
+                                 : n.percentiles[q];
+        }
+        s.has_percentiles = true;
+      }
+    }
+  }
+}
+
+std::string RenderOpenMetricsText(const MetricSeriesMap& series,
+                                  const std::string& prefix) {
+  const std::string p = SanitizeMetricName(prefix) + "_profile_";
+  std::string out;
+  out.reserve(256 + series.size() * 160);
+
+  AppendFamily(out, p + "calls", "counter",
+               "Completed probe scopes, recorded values or events.");
+  for (const auto& [path, s] : series) {
+    AppendSample(out, p + "calls_total", path, s.type, nullptr,
+                 static_cast<double>(s.count));
+  }
+  AppendFamily(out, p + "time_ms", "counter",
+               "Accumulated time spent in the scope, in milliseconds.");
+  for (const auto& [path, s] : series) {
+    if (IsTimed(s.type)) {
+      AppendSample(out, p + "time_ms_total", path, s.type, nullptr, s.total_ms);
+    }
+  }
+  AppendFamily(out, p + "time_max_ms", "gauge",
+               "Longest single scope in the latest window, in milliseconds.");
+  for (const auto& [path, s] : series) {
+    if (IsTimed(s.type) && s.count > 0) {
+      AppendSample(out, p + "time_max_ms", path, s.type, nullptr, s.max);
+    }
+  }
+  AppendFamily(out, p + "time_quantile_ms", "gauge",
+               "Scope duration percentiles in the latest window, in milliseconds.");
+  for (const auto& [path, s] : series) {
+    if (!IsTimed(s.type) || !s.has_percentiles) continue;
+    for (size_t q = 0; q < 4; ++q) {
+      AppendSample(out, p + "time_quantile_ms", path, s.type, kQuantiles[q],
+                   s.percentiles[q]);
+    }
+  }
+  AppendFamily(out, p + "value_sum", "counter",
+               "Sum of values recorded by Z3Y_PROFILE_VALUE.");
+  for (const auto& [path, s] : series) {
+    if (s.type == NodeType::Value) {
+      AppendSample(out, p + "value_sum_total", path, s.type, nullptr,
+                   s.sum_value);
+    }
+  }
+  AppendFamily(out, p + "value_max", "gauge",
+               "Largest value recorded in the latest window.");
+  for (const auto& [path, s] : series) {
+    if (s.type == NodeType::Value && s.count > 0) {
+      AppendSample(out, p + "value_max", path, s.type, nullptr, s.max);
+    }
+  }
+  AppendFamily(out, p + "value_quantile", "gauge",
+               "Recorded value percentiles in the latest window.");
+  for (const auto& [path, s] : series) {
+    if (s.type != NodeType::Value || !s.has_percentiles) continue;
+    for (size_t q = 0; q < 4; ++q) {
+      AppendSample(out, p + "value_quantile", path, s.type, kQuantiles[q],
+                   s.percentiles[q]);
+    }
+  }
+  out += "# EOF\n";
+  return out;
+}
+
+std::vector<std::string> BuildStatsdDatagrams(const MetricSeriesMap& current,
+                                              const MetricSeriesMap& previous,
+                                              const std::string& prefix,
+                                              size_t max_datagram) {
+  std::vector<std::string> datagrams;
+  std::string packet;
+  auto emit = [&](const std::string& name, const char* suffix, double value,
+                  const char* kind) {
+    std::string line = name + suffix + ':' + FormatNumber(value) + '|' + kind;
+    if (!packet.empty() && packet.size() + 1 + line.size() > max_datagram) {
+      datagrams.push_back(std::move(packet));
+      packet.clear();
+    }
+    if (!packet.empty()) packet += '\n';
+    packet += line;
+  };
+
+  for (const auto& [path, s] : current) {
+    MetricSeries base;
+    if (auto it = previous.find(path); it != previous.end()) base = it->second;
+    if (s.count <= base.count) continue;  // 本周期没有新数据
+    std::string name = SanitizeStatsdName(path);
+    if (!prefix.empty()) name = SanitizeStatsdName(prefix) + '.' + name;
+
+    emit(name, ".calls", static_cast<double>(s.count - base.count), "c");
+    if (IsTimed(s.type)) {
+      emit(name, ".time_ms", s.total_ms - base.total_ms, "c");
+      emit(name, ".max_ms", s.max, "g");
+    } else if (s.type == NodeType::Value) {
+      emit(name, ".value_sum", s.sum_value - base.sum_value, "c");
+      emit(name, ".value_max", s.max, "g");
+    }
+    if (s.has_percentiles && s.type != NodeType::Event) {
+      for (size_t q = 0; q < 4; ++q) {
+        std::string suffix = std::string(".") + kStatsdQuantiles[q] +
+                             (IsTimed(s.type) ? "_ms" : "");
+        emit(name, suffix.c_str(), s.percentiles[q], "g");
+      }
+    }
+  }
+  if (!packet.empty()) datagrams.push_back(std::move(packet));
+  return datagrams;
+}
+
+/**
+ * @brief 累加已输出报告的 Sink。独立于服务对象持有，迟到的回调不会访问已析构的服务。
+ */
+class MetricsExporterService::ReportedTotals : public IProfilerReportSink {
+ public:
+  void OnReport(const ProfileReport& report) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    AccumulateReport(report, true, totals_);
+  }
+
+  MetricSeriesMap Snapshot() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return totals_;
+  }
+
+ private:
+  mutable std::mutex mutex_;
+  MetricSeriesMap totals_;
+};
+
+void MetricsExporterService::Initialize() {
+  reported_ = std::make_shared<ReportedTotals>();
+  front_text_ = RenderOpenMetricsText({}, prefix_);
+
+  if (auto [log_mgr, err] = z3y::TryGetDefaultService<ILogManagerService>();
+      err == z3y::InstanceError::kSuccess) {
+    logger_ = log_mgr->GetLogger("System.Metrics");
+  }
+  AttachToProfiler();
+
+  if (auto [cfg_svc, err] = z3y::TryGetDefaultService<IConfigService>();
+      err == z3y::InstanceError::kSuccess) {
+    config_conns_ += cfg_svc->Builder<int>("System.Metrics.IntervalMs")
+                         .NameKey("Metrics Refresh Interval (ms)")
+                         .Default(10000)
+                         .Min(100)
+                         .Bind([this](int val) {
+                           interval_ms_.store(std::max(val, 100),
+                                              std::memory_order_relaxed);
+                           worker_cv_.notify_all();
+                         });
+    config_conns_ += cfg_svc->Builder<std::string>("System.Metrics.Prefix")
+                         .NameKey("Metrics Name Prefix")
+                         .Default(std::string("z3y"))
+                         .Bind([this](const std::string& val) {
+                           std::lock_guard<std::mutex> lock(refresh_mutex_);
+                           prefix_ = val;
+                         });
+    config_conns_ +=
+        cfg_svc->Builder<std::string>("System.Metrics.HttpBindAddress")
+            .NameKey("Metrics HTTP Bind Address")
+            .Default(std::string("127.0.0.1"))
+            .Bind([this](const std::string& val) {
+              {
+                std::lock_guard<std::mutex> lock(http_control_mutex_);
+                if (http_bind_address_ == val) return;
+                http_bind_address_ = val;
+              }
+              RestartHttp();
+            });
+    config_conns_ += cfg_svc->Builder<int>("System.Metrics.HttpPort")
+                         .NameKey("Metrics HTTP Port (0 = off)")
+                         .Default(0)
+                         .Min(0)
+                         .Max(65535)
+                         .Bind([this](int val) {
+                           {
+                             std::lock_guard<std::mutex> lock(http_control_mutex_);
+                             http_port_config_ = static_cast<uint16_t>(val);
+                           }
+                           RestartHttp();
+                         });
+    config_conns_ +=
+        cfg_svc->Builder<std::string>("System.Metrics.StatsdTarget")
+            .NameKey("Metrics StatsD Target (host:port)")
+            .Default(std::string())
+            .Bind([this](const std::string& val) { OpenStatsd(val); });
+    config_conns_ +=
+        cfg_svc->Builder<std::string>("System.Metrics.FleetNode")
+            .NameKey("Metrics Fleet Node Name (empty = host name)")
+            .Default(std::string())
+            .Bind([this](const std::string& val) {
+              {
+                std::lock_guard<std::mutex> lock(refresh_mutex_);
+                fleet_node_ = val;
+              }
+              OpenFleet();
+            });
+    config_conns_ +=
+        cfg_svc->Builder<std::string>("System.Metrics.FleetTarget")
+            .NameKey("Metrics Fleet Aggregator Target (host:port)")
+            .Default(std::string())
+            .Bind([this](const std::string& val) {
+              {
+                std::lock_guard<std::mutex> lock(refresh_mutex_);
+                fleet_target_ = val;
+              }
+              OpenFleet();
+            });
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(worker_mutex_);
+    worker_stop_ = false;
+  }
+  worker_ = std::thread(&MetricsExporterService::WorkerLoop, this);
+}
+
+void MetricsExporterService::Shutdown() {
+  // 先断开配置，防止回调在关闭过程中重新拉起线程
+  config_conns_.Clear();
+  {
+    std::lock_guard<std::mutex> lock(worker_mutex_);
+    worker_stop_ = true;
+  }
+  worker_cv_.notify_all();
+  if (worker_.joinable()) worker_.join();
+  {
+    std::lock_guard<std::mutex> lock(http_control_mutex_);
+    http_port_config_ = 0;
+  }
+  RestartHttp();
+  {
+    std::lock_guard<std::mutex> lock(refresh_mutex_);
+    statsd_.Close();
+    fleet_.Close();
+    fleet_encoder_.reset();
+  }
+  if (reported_ && profiler_instance_id_ != 0) {
+    if (auto [profiler, err] = z3y::TryGetDefaultService<IProfilerService>();
+        err == z3y::InstanceError::kSuccess &&
+        profiler->GetInstanceId() == profiler_instance_id_) {
+      profiler->RemoveReportSink(reported_);
+    }
+    profiler_instance_id_ = 0;
+  }
+  logger_.reset();
+}
+
+void MetricsExporterService::AttachToProfiler() {
+  auto [profiler, err] = z3y::TryGetDefaultService<IProfilerService>();
+  if (err != z3y::InstanceError::kSuccess) return;
+  if (profiler->GetInstanceId() == profiler_instance_id_) return;
+  // Profiler 被重载过：旧实例的累计值随它的 Sink 一起作废
+  reported_ = std::make_shared<ReportedTotals>();
+  emitted_.clear();
+  profiler->AddReportSink(reported_);
+  profiler_instance_id_ = profiler->GetInstanceId();
+}
+
+void MetricsExporterService::Refresh() {
+  std::lock_guard<std::mutex> lock(refresh_mutex_);
+  AttachToProfiler();
+
+  MetricSeriesMap next = reported_->Snapshot();
+  if (auto [profiler, err] = z3y::TryGetDefaultService<IProfilerService>();
+      err == z3y::InstanceError::kSuccess) {
+    MetricSeriesMap live;
+    for (const ProfileReport& report : profiler->SnapshotLiveRoots()) {
+      AccumulateReport(report, false, live);
+    }
+    for (const auto& [path, s] : live) {
+      MetricSeries& t = next[path];
+      t.type = s.type;
+      t.count += s.count;
+      t.total_ms += s.total_ms;
+      t.sum_value += s.sum_value;
+      AccumulateHistogram(t, s.histogram_bits, s.histogram);
+      if (s.count > 0) {
+        t.max = s.max;
+        t.has_percentiles = s.has_percentiles;
+        t.percentiles = s.percentiles;
+      }
+    }
+  }
+  for (auto& [path, s] : next) {
+    if (auto it = emitted_.find(path); it != emitted_.end()) {
+      s.count = std::max(s.count, it->second.count);
+      s.total_ms = std::max(s.total_ms, it->second.total_ms);
+      s.sum_value = std::max(s.sum_value, it->second.sum_value);
+      if (s.histogram_bits == it->second.histogram_bits) {
+        for (const auto& [index, c] : it->second.histogram) {
+          uint64_t& bucket = s.histogram[index];
+          bucket = std::max(bucket, c);
+        }
+      }
+    }
+  }
+
+  std::string text = RenderOpenMetricsText(next, prefix_);
+  if (statsd_.IsOpen()) {
+    for (const std::string& datagram :
+         BuildStatsdDatagrams(next, emitted_, prefix_, kStatsdMaxDatagram)) {
+      statsd_.Send(datagram);
+    }
+  }
+  if (fleet_.IsOpen() && fleet_encoder_) {
+    for (const std::string& datagram :
+         fleet_encoder_->Encode(ToFleetSeries(next), fleet::kFleetMaxDatagram)) {
+      fleet_.Send(datagram);
+    }
+  }
+  emitted_.swap(next);
+  std::lock_guard<std::mutex> front_lock(front_mutex_);
+  front_text_.swap(text);
+}
+
+std::string MetricsExporterService::RenderOpenMetrics() const {
+  std::lock_guard<std::mutex> lock(front_mutex_);
+  return front_text_;
+}
+
+uint16_t MetricsExporterService::GetHttpPort() const {
+  return http_port_.load(std::memory_order_acquire);
+}
+
+void MetricsExporterService::WorkerLoop() {
+  std::unique_lock<std::mutex> lock(worker_mutex_);
+  while (!worker_stop_) {
+    auto interval =
+        std::chrono::milliseconds(interval_ms_.load(std::memory_order_relaxed));
+    // 周期被改短时 notify 会让这里提前醒来，按新周期重新计时
+    if (worker_cv_.wait_for(lock, interval) == std::cv_status::no_timeout) {
+      continue;
+    }
+    if (worker_stop_) break;
+    lock.unlock();
+    Refresh();
+    lock.lock();
+  }
+}
+
+void MetricsExporterService::OpenStatsd(const std::string& target) {
+  std::lock_guard<std::mutex> lock(refresh_mutex_);
+  statsd_.Close();
+  if (target.empty()) return;
+  std::string error;
+  if (!statsd_.Open(target, error)) {
+    Z3Y_LOG_WARN(logger_, "[Metrics] StatsD target disabled: {}", error);
+  }
+}
+
+void MetricsExporterService::OpenFleet() {
+  std::lock_guard<std::mutex> lock(refresh_mutex_);
+  fleet_.Close();
+  fleet_encoder_.reset();
+  if (fleet_target_.empty()) return;
+  std::string error;
+  if (!fleet_.Open(fleet_target_, error)) {
+    Z3Y_LOG_WARN(logger_, "[Metrics] Fleet target disabled: {}", error);
+    return;
+  }
+  // 新的会话号让汇总端区分重启前后的序号；新编码器首次发送的是全部累计值
+  std::random_device rd;
+  const uint64_t session =
+      (static_cast<uint64_t>(rd()) << 32 | rd()) ^
+      static_cast<uint64_t>(
+          std::chrono::steady_clock::now().time_since_epoch().count());
+  fleet_encoder_ = std::make_unique<fleet::FleetEncoder>(
+      fleet_node_.empty() ? GetLocalHostName() : fleet_node_, session);
+}
+
+void MetricsExporterService::RestartHttp() {
+  std::lock_guard<std::mutex> lock(http_control_mutex_);
+  http_stop_.store(true, std::memory_order_release);
+  if (http_thread_.joinable()) http_thread_.join();
+  http_listener_.Close();
+  http_port_.store(0, std::memory_order_release);
+  if (http_port_config_ == 0) return;
+
+  std::string error;
+  if (!http_listener_.Listen(http_bind_address_, http_port_config_, error)) {
+    Z3Y_LOG_WARN(logger_, "[Metrics] Cannot listen on {}:{}: {}",
+                 http_bind_address_, http_port_config_, error);
+    return;
+  }
+  http_stop_.store(false, std::memory_order_release);
+  http_port_.store(http_port_config_, std::memory_order_release);
+  http_thread_ = std::thread(&MetricsExporterService::HttpLoop, this);
+}
+
+void MetricsExporterService::HttpLoop() {
+  while (!http_stop_.load(std::memory_order_acquire)) {
+    SocketHandle client = http_listener_.Accept(kHttpPollMs);
+    if (client == kInvalidSocket) continue;
+    HandleHttpClient(client);
+    CloseSocket(client);
+  }
+}
+
+void MetricsExporterService::HandleHttpClient(SocketHandle client) {
+  std::string request;
+  if (!ReceiveRequestHead(client, request, kHttpMaxRequest, kHttpIoTimeoutMs)) {
+    return;
+  }
+  // 请求行："GET /metrics?x=y HTTP/1.1"
+  std::string line = request.substr(0, request.find("\r\n"));
+  size_t sp1 = line.find(' ');
+  size_t sp2 = sp1 == std::string::npos ? sp1 : line.find(' ', sp1 + 1);
+  std::string method = line.substr(0, sp1);
+  std::string target = sp1 == std::string::npos
+                           ? std::string()
+                           : line.substr(sp1 + 1, sp2 - sp1 - 1);
+  target = target.substr(0, target.find('?'));
+
+  const char* status = "200 OK";
+  const char* content_type =
+      "application/openmetrics-text; version=1.0.0; charset=utf-8";
+  std::string body;
+  if (method != "GET" && method != "HEAD") {
+    status = "405 Method Not Allowed";
+    content_type = "text/plain; charset=utf-8";
+    body = "Only GET is supported.\n";
+  } else if (target == "/metrics") {
+    body = RenderOpenMetrics();
+  } else {
+    status = "404 Not Found";
+    content_type = "text/plain; charset=utf-8";
+    body = "Metrics are served at /metrics.\n";
+  }
+  std::string response = fmt::format(
+      "HTTP/1.1 {}\r\nContent-Type: {}\r\nContent-Length: {}\r\n"
+      "Connection: close\r\n\r\n",
+      status, content_type, body.size());
+  if (method != "HEAD") response += body;
+  SendAll(client, response, kHttpIoTimeoutMs);
+}
+
+}  // namespace z3y::plugins::metrics
@@ -0,0 +1,155 @@
+﻿/**
+ * @file metrics_exporter_service.h
+ * @brief 指标导出插件的具体实现类声明。
+ * * @details
+ * 【面向维护者】
+ * 数据来源有两部分，合起来才是某个探针自进程启动以来的累计值：
+ * 1. **已输出的报告**：Profiler 每次按周期 / SLA 输出报告后会把根节点清零。
+ * 导出器注册一个 IProfilerReportSink (ReportedTotals)，把每份报告按节点路径累加起来。
+ * 2. **在途数据**：`IProfilerService::SnapshotLiveRoots` 读取各线程根节点自上次
+ * 清零以来的数值，不做重置，因此导出器与报告周期互不干扰。
+ * 每次刷新把二者相加得到新一代指标 (back buffer)，渲染成 OpenMetrics 文本后
+ * 在锁内与 front buffer 交换；HTTP 线程只读 front 文本，不会等待树的遍历。
+ */
+
+#pragma once
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "framework/z3y_define_impl.h"
+#include "interfaces_core/i_config_service.h"
+#include "interfaces_core/i_log_service.h"
+#include "interfaces_profiler/fleet_snapshot.h"
+#include "interfaces_profiler/i_metrics_exporter.h"
+#include "interfaces_profiler/profiler_report.h"
+#include "metrics_socket.h"
+
+namespace z3y::plugins::metrics {
+
+/**
+ * @brief 一条时间序列（对应聚合树中的一个节点路径）。
+ */
+struct MetricSeries {
+  z3y::interfaces::profiler::NodeType type =
+      z3y::interfaces::profiler::NodeType::Timer;
+  uint64_t count = 0;      ///< 累计调用 / 发生次数
+  double total_ms = 0.0;   ///< 累计耗时（Timer / Linear）
+  double sum_value = 0.0;  ///< 数值累加（Value）
+  // 以下为最近一个窗口（最近一份报告或在途数据）的瞬时值，作为 gauge 输出
+  double max = 0.0;  ///< 单次最大耗时 / 最大数值
+  bool has_percentiles = false;
+  std::array<double, 4> percentiles{};  ///< p50 / p95 / p99 / p999
+  /// 累计直方图（桶下标 -> 次数，单位同 ReportNode::histogram），供机群汇总合并
+  uint32_t histogram_bits = 0;
+  std::map<uint32_t, uint64_t> histogram;
+};
+
+/// 按节点路径 ("Root/Child/Leaf") 排序的序列表；有序保证输出稳定
+using MetricSeriesMap = std::map<std::string, MetricSeries>;
+
+/**
+ * @brief 把报告拍平成路径 -> 序列并累加到 out 中。
+ * @param take_window 是否用本报告的数据覆盖 gauge（max / 分位数）。
+ */
+void AccumulateReport(const z3y::interfaces::profiler::ProfileReport& report,
+                      bool take_window, MetricSeriesMap& out);
+
+/** @brief 渲染 OpenMetrics 文本（以 "# EOF" 结尾）。 */
+std::string RenderOpenMetricsText(const MetricSeriesMap& series,
+                                  const std::string& prefix);
+
+/**
+ * @brief 生成 StatsD 行：计数器输出相对 previous 的增量 (|c)，瞬时值输出 gauge (|g)。
+ * @param max_datagram 单个 UDP 包的最大字节数，超出前换包。
+ * @return 若干个按行拼接好的数据报。
+ */
+std::vector<std::string> BuildStatsdDatagrams(const MetricSeriesMap& current,
+                                              const MetricSeriesMap& previous,
+                                              const std::string& prefix,
+                                              size_t max_datagram);
+
+/**
+ * @brief 把 src 的累计直方图加到 dst 上。精度变化后旧桶不可比，dst 以 src 的精度重新开始。
+ */
+void AccumulateHistogram(MetricSeries& dst, uint32_t bits,
+                         const std::map<uint32_t, uint64_t>& src);
+
+/**
+ * @brief IMetricsExporter 的默认实现类。
+ */
+class MetricsExporterService
+    : public z3y::PluginImpl<MetricsExporterService,
+                             z3y::interfaces::profiler::IMetricsExporter> {
+ public:
+  Z3Y_DEFINE_COMPONENT_ID("z3y-core-MetricsExporterService-Impl-v1");
+
+  /// 一个 StatsD 数据报的上限：以太网 MTU 1500 减去 IP/UDP 头，避免分片
+  static constexpr size_t kStatsdMaxDatagram = 1432;
+
+  MetricsExporterService() = default;
+  ~MetricsExporterService() override { Shutdown(); }
+
+  void Initialize() override;
+  void Shutdown() override;
+
+  void Refresh() override;
+  std::string RenderOpenMetrics() const override;
+  uint16_t GetHttpPort() const override;
+
+ private:
+  class ReportedTotals;
+
+  /** @brief 确保 ReportedTotals 注册在当前存活的 Profiler 实例上。 */
+  void AttachToProfiler();
+  void WorkerLoop();
+  /** @brief 按当前的端口与绑定地址重启 HTTP 监听（port 为 0 时只关闭）。 */
+  void RestartHttp();
+  void HttpLoop();
+  void HandleHttpClient(SocketHandle client);
+  void OpenStatsd(const std::string& target);
+  /** @brief 按当前的汇总端地址与机器名重建机群发送端（目标为空时只关闭）。 */
+  void OpenFleet();
+
+  z3y::PluginPtr<z3y::interfaces::core::ILogger> logger_;
+  z3y::interfaces::core::ConnectionGroup config_conns_;
+
+  std::shared_ptr<ReportedTotals> reported_;  ///< 已输出报告的累计值
+  uint64_t profiler_instance_id_ = 0;         ///< reported_ 注册所在的 Profiler 实例
+
+  std::mutex refresh_mutex_;  ///< 串行化 Refresh，保护以下各项与 statsd_ / fleet_
+  MetricSeriesMap emitted_;   ///< 上一代已输出的序列（计数单调性与 StatsD 增量的基准）
+  std::string prefix_ = "z3y";
+  UdpSender statsd_;
+  std::string fleet_target_;  ///< System.Metrics.FleetTarget
+  std::string fleet_node_;    ///< System.Metrics.FleetNode，空表示主机名
+  UdpSender fleet_;
+  /// 机群增量的编码器（保存上一次发送的累计值）；随目标 / 机器名变化重建
+  std::unique_ptr<z3y::interfaces::profiler::fleet::FleetEncoder> fleet_encoder_;
+
+  mutable std::mutex front_mutex_;
+  std::string front_text_;  ///< 最近一次渲染的 OpenMetrics 文本
+
+  std::atomic<int> interval_ms_{10000};
+  std::thread worker_;
+  std::mutex worker_mutex_;
+  std::condition_variable worker_cv_;
+  bool worker_stop_ = false;  ///< 受 worker_mutex_ 保护
+
+  std::mutex http_control_mutex_;  ///< 串行化 RestartHttp，保护以下两项
+  std::string http_bind_address_ = "127.0.0.1";
+  uint16_t http_port_config_ = 0;
+  TcpListener http_listener_;  ///< 只在 HTTP 线程停止时被 RestartHttp 修改
+  std::thread http_thread_;
+  std::atomic<bool> http_stop_{false};
+  std::atomic<uint16_t> http_port_{0};
+};
+
+}  // namespace z3y::plugins::metrics
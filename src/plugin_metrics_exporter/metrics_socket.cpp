@@ -0,0 +1,170 @@
+﻿/**
+ * @file metrics_socket.cpp
+ * @brief metrics_socket.h 的平台实现。
+ */
+
+#include "metrics_socket.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <netdb.h>
+#include <sys/socket.h>
+#endif
+
+namespace z3y::plugins::metrics {
+
+bool ReceiveRequestHead(SocketHandle s, std::string& out, size_t max_bytes,
+                        int timeout_ms) {
+  char buf[1024];
+  while (out.size() < max_bytes) {
+    if (out.find("\r\n\r\n") != std::string::npos) return true;
+    if (!net::WaitSocket(s, false, timeout_ms)) return false;
+    const long n = net::ReceiveBytes(s, buf, sizeof(buf));
+    if (n <= 0) return false;
+    out.append(buf, static_cast<size_t>(n));
+  }
+  return out.find("\r\n\r\n") != std::string::npos;
+}
+
+bool SendAll(SocketHandle s, const std::string& data, int timeout_ms) {
+  size_t sent = 0;
+  while (sent < data.size()) {
+    if (!net::WaitSocket(s, true, timeout_ms)) return false;
+    const long n = net::SendBytes(s, data.data() + sent, data.size() - sent);
+    if (n <= 0) return false;
+    sent += static_cast<size_t>(n);
+  }
+  return true;
+}
+
+bool TcpListener::Listen(const std::string& address, uint16_t port,
+                         std::string& error) {
+  Close();
+  if (!net::EnsureSockets()) {
+    error = "socket library initialization failed";
+    return false;
+  }
+  addrinfo hints{};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  hints.ai_flags = AI_PASSIVE | AI_NUMERICHOST;
+  addrinfo* res = nullptr;
+  std::string port_str = std::to_string(port);
+  if (int rc = ::getaddrinfo(address.empty() ? nullptr : address.c_str(),
+                             port_str.c_str(), &hints, &res);
+      rc != 0) {
+    error = "invalid bind address '" + address + "'";
+    return false;
+  }
+  SocketHandle s = static_cast<SocketHandle>(
+      ::socket(res->ai_family, res->ai_socktype, res->ai_protocol));
+  if (s == kInvalidSocket) {
+    error = net::LastSocketError();
+    ::freeaddrinfo(res);
+    return false;
+  }
+#ifndef _WIN32
+  // 允许重启后立即重新绑定仍处于 TIME_WAIT 的端口
+  int reuse = 1;
+  ::setsockopt(s, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+#endif
+#ifdef _WIN32
+  bool ok = ::bind(static_cast<SOCKET>(s), res->ai_addr,
+                   static_cast<int>(res->ai_addrlen)) == 0 &&
+            ::listen(static_cast<SOCKET>(s), 16) == 0;
+#else
+  bool ok = ::bind(s, res->ai_addr, res->ai_addrlen) == 0 &&
+            ::listen(s, 16) == 0;
+#endif
+  ::freeaddrinfo(res);
+  if (!ok) {
+    error = net::LastSocketError();
+    CloseSocket(s);
+    return false;
+  }
+  socket_ = s;
+  port_ = port;
+  return true;
+}
+
+void TcpListener::Close() {
+  CloseSocket(socket_);
+  socket_ = kInvalidSocket;
+  port_ = 0;
+}
+
+SocketHandle TcpListener::Accept(int timeout_ms) {
+  if (socket_ == kInvalidSocket || !net::WaitSocket(socket_, false, timeout_ms)) {
+    return kInvalidSocket;
+  }
+#ifdef _WIN32
+  return static_cast<SocketHandle>(
+      ::accept(static_cast<SOCKET>(socket_), nullptr, nullptr));
+#else
+  return ::accept(socket_, nullptr, nullptr);
+#endif
+}
+
+bool UdpSender::Open(const std::string& target, std::string& error) {
+  Close();
+  std::string host, port;
+  if (!net::SplitHostPort(target, host, port)) {
+    error = "expected 'host:port', got '" + target + "'";
+    return false;
+  }
+  if (!net::EnsureSockets()) {
+    error = "socket library initialization failed";
+    return false;
+  }
+  addrinfo hints{};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_DGRAM;
+  addrinfo* res = nullptr;
+  if (::getaddrinfo(host.c_str(), port.c_str(), &hints, &res) != 0) {
+    error = "cannot resolve '" + target + "'";
+    return false;
+  }
+  for (addrinfo* ai = res; ai; ai = ai->ai_next) {
+    SocketHandle s = static_cast<SocketHandle>(
+        ::socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol));
+    if (s == kInvalidSocket) continue;
+    // UDP 的 connect 只记录默认目的地址，之后用 send 即可
+#ifdef _WIN32
+    bool ok = ::connect(static_cast<SOCKET>(s), ai->ai_addr,
+                        static_cast<int>(ai->ai_addrlen)) == 0;
+#else
+    bool ok = ::connect(s, ai->ai_addr, ai->ai_addrlen) == 0;
+#endif
+    ok = ok && net::SetNonBlocking(s);
+    if (ok) {
+      socket_ = s;
+      break;
+    }
+    CloseSocket(s);
+  }
+  ::freeaddrinfo(res);
+  if (socket_ == kInvalidSocket) {
+    error = net::LastSocketError();
+    return false;
+  }
+  return true;
+}
+
+std::string GetLocalHostName() { return net::LocalHostName("unknown"); }
+
+void UdpSender::Close() {
+  CloseSocket(socket_);
+  socket_ = kInvalidSocket;
+}
+
+bool UdpSender::Send(const std::string& datagram) {
+  if (socket_ == kInvalidSocket || datagram.empty()) return false;
+  return net::SendBytes(socket_, datagram.data(), datagram.size()) > 0;
+}
+
+}  // namespace z3y::plugins::metrics
@@ -0,0 +1,83 @@
+﻿/**
+ * @file metrics_socket.h
+ * @brief 指标导出插件使用的最小化 TCP / UDP 封装（BSD Socket 与 Winsock 通用）。
+ * * @details
+ * 【面向维护者】
+ * 只实现导出器需要的部分：单线程串行处理的 HTTP 监听端口、带超时的读写，
+ * 以及向固定目标发送数据报的 UDP 发送端。所有调用都不会无限期阻塞，
+ * 以保证 Shutdown 能在有限时间内让后台线程退出。平台差异由 z3y_socket_common 处理。
+ */
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "z3y_socket_common/socket_common.h"
+
+namespace z3y::plugins::metrics {
+
+using net::SocketHandle;
+using net::kInvalidSocket;
+using net::CloseSocket;
+
+/**
+ * @brief 在 timeout_ms 内读取数据追加到 out，直到出现 "\r\n\r\n" 或达到 max_bytes。
+ * @return 是否读到了完整的请求头。
+ */
+bool ReceiveRequestHead(SocketHandle s, std::string& out, size_t max_bytes,
+                        int timeout_ms);
+
+/** @brief 发送全部数据；对端关闭或超时视为失败。 */
+bool SendAll(SocketHandle s, const std::string& data, int timeout_ms);
+
+/** @brief 本机主机名；取不到时返回 "unknown"。 */
+std::string GetLocalHostName();
+
+/**
+ * @brief 监听一个 TCP 端口。
+ */
+class TcpListener {
+ public:
+  TcpListener() = default;
+  ~TcpListener() { Close(); }
+  TcpListener(const TcpListener&) = delete;
+  TcpListener& operator=(const TcpListener&) = delete;
+
+  /** @brief 绑定 address:port 并开始监听；失败时 error 中给出原因。 */
+  bool Listen(const std::string& address, uint16_t port, std::string& error);
+  void Close();
+  bool IsOpen() const { return socket_ != kInvalidSocket; }
+  uint16_t GetPort() const { return port_; }
+
+  /** @brief 等待至多 timeout_ms 接受一个连接；超时返回 kInvalidSocket。 */
+  SocketHandle Accept(int timeout_ms);
+
+ private:
+  SocketHandle socket_ = kInvalidSocket;
+  uint16_t port_ = 0;
+};
+
+/**
+ * @brief 向固定的 "host:port" 发送 UDP 数据报。
+ */
+class UdpSender {
+ public:
+  UdpSender() = default;
+  ~UdpSender() { Close(); }
+  UdpSender(const UdpSender&) = delete;
+  UdpSender& operator=(const UdpSender&) = delete;
+
+  /** @brief 解析 target 并创建套接字；失败时 error 中给出原因。 */
+  bool Open(const std::string& target, std::string& error);
+  void Close();
+  bool IsOpen() const { return socket_ != kInvalidSocket; }
+
+  /** @brief 发送一个数据报（非阻塞，发送缓冲区满时直接丢弃）。 */
+  bool Send(const std::string& datagram);
+
+ private:
+  SocketHandle socket_ = kInvalidSocket;
+};
+
+}  // namespace z3y::plugins::metrics
@@ -0,0 +1,713 @@
+﻿/**
+ * @file net_event_bridge_service.cpp
+ * @brief 跨主机事件桥的核心实现：帧格式、订阅通告、批量发送、背压与网络线程。
+ * * @details
+ * 【面向维护者】
+ * **帧格式**：每帧 24 字节帧头 {magic u32, version u16, type u16, length u32, reserved u32,
+ * node_id u64} 加 length 字节载荷。TCP 上帧首尾相接，组播上一个数据报恰好一帧。
+ * - kInterest：{count u32, event_id u64 × count}，对端导入的完整集合 (替换上一次)。
+ * - kBatch：若干条 {event_id u64, size u32, 事件的 Serialize 输出}。
+ *
+ * **批量**：发布线程把记录追加到对端的 batch 中，只在 batch 由空变为非空时唤醒网络线程；
+ * 网络线程醒来时把 batch 整体封成一帧，其间到达的事件自然合并。batch 超过
+ * `max_batch_bytes` 时由发布线程当场封帧，避免单帧过大。
+ *
+ * **回环抑制**：导入事件在网络线程上发布，发布期间线程局部标记置位，
+ * 所有桥的导出接收者看到标记后直接返回。
+ */
+
+#include "net_event_bridge_service.h"
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+
+#include "framework/z3y_service_locator.h"
+
+Z3Y_AUTO_REGISTER_COMPONENT(z3y::plugins::net_bridge::NetEventBridgeService,
+                            "System.NetEventBridge", true);
+
+namespace z3y::plugins::net_bridge {
+
+using namespace z3y::interfaces::core;
+
+namespace {
+
+constexpr uint32_t kFrameMagic = 0x4E59335A;  // "Z3YN"
+constexpr uint16_t kFrameVersion = 1;
+constexpr uint16_t kFrameInterest = 1;
+constexpr uint16_t kFrameBatch = 2;
+constexpr size_t kFrameHeaderBytes = 24;
+constexpr size_t kRecordHeaderBytes = 12;  ///< event_id u64 + size u32
+constexpr uint32_t kMaxFrameBytes = 64u << 20;  ///< 超过即视为数据损坏并断开
+constexpr int kIdlePollMs = 1000;
+
+/** @brief 当前线程正在发布导入事件 (所有桥共享)。 */
+thread_local bool t_dispatching_imported = false;
+
+void AppendFrame(std::string& out, uint16_t type, uint64_t node_id,
+                 const char* payload, size_t size) {
+  z3y::EventWriter header;
+  header.Write(kFrameMagic);
+  header.Write(kFrameVersion);
+  header.Write(type);
+  header.Write(static_cast<uint32_t>(size));
+  header.Write(uint32_t{0});
+  header.Write(node_id);
+  out += header.Buffer();
+  out.append(payload, size);
+}
+
+uint64_t RandomNodeId() {
+  std::random_device rd;
+  const uint64_t hi = rd();
+  const uint64_t lo = rd();
+  const uint64_t id =
+      (hi << 32) ^ lo ^
+      static_cast<uint64_t>(
+          std::chrono::steady_clock::now().time_since_epoch().count());
+  return id != 0 ? id : 1;
+}
+
+}  // namespace
+
+NetEventBridgeService::NetEventBridgeService()
+    : peers_(std::make_shared<const PeerList>()) {}
+
+void NetEventBridgeService::Initialize() {
+  try {
+    bus_ = z3y::GetService<z3y::IEventBus>(z3y::clsid::kEventBus);
+  } catch (const z3y::PluginException&) {
+    // 没有事件总线时桥不转发任何事件
+  }
+}
+
+bool NetEventBridgeService::Configure(const NetBridgeOptions& options) {
+  std::lock_guard<std::mutex> lock(lifecycle_mutex_);
+  if (io_thread_.joinable()) return false;
+  options_ = options;
+  return true;
+}
+
+bool NetEventBridgeService::EnsureStarted(std::string& error) {
+  if (io_thread_.joinable()) return true;
+  wake_ = OpenWakeSocket(error);
+  if (wake_ == kInvalidSocket) return false;
+  node_id_ = options_.node_id != 0 ? options_.node_id : RandomNodeId();
+  next_announce_ = Clock::now();
+  io_stop_.store(false);
+  io_thread_ = std::thread(&NetEventBridgeService::IoLoop, this);
+  return true;
+}
+
+uint16_t NetEventBridgeService::ListenTcp(const std::string& bind_address,
+                                          uint16_t port,
+                                          std::string& out_error) {
+  std::lock_guard<std::mutex> lock(lifecycle_mutex_);
+  uint16_t bound = 0;
+  SocketHandle s = OpenTcpListener(bind_address, port, bound, out_error);
+  if (s == kInvalidSocket) return 0;
+  if (!EnsureStarted(out_error)) {
+    CloseSocket(s);
+    return 0;
+  }
+  {
+    std::lock_guard<std::mutex> control(control_mutex_);
+    pending_listeners_.push_back(s);
+  }
+  WakeSocket(wake_);
+  return bound;
+}
+
+bool NetEventBridgeService::ConnectTcp(const std::string& target,
+                                       std::string& out_error) {
+  std::lock_guard<std::mutex> lock(lifecycle_mutex_);
+  auto peer = std::make_shared<Peer>(Peer::Kind::kOutbound);
+  if (!ResolveAddress(target, false, peer->address, out_error)) return false;
+  if (!EnsureStarted(out_error)) return false;
+  peer->retry_at = Clock::now();
+  {
+    std::lock_guard<std::mutex> control(control_mutex_);
+    pending_peers_.push_back(std::move(peer));
+  }
+  WakeSocket(wake_);
+  return true;
+}
+
+bool NetEventBridgeService::JoinMulticast(const std::string& group_target,
+                                          const std::string& interface_address,
+                                          std::string& out_error) {
+  std::lock_guard<std::mutex> lock(lifecycle_mutex_);
+  auto peer = std::make_shared<Peer>(Peer::Kind::kMulticast);
+  peer->socket = OpenMulticast(group_target, interface_address,
+                               options_.multicast_ttl, peer->address, out_error);
+  if (peer->socket == kInvalidSocket) return false;
+  if (!EnsureStarted(out_error)) {
+    CloseSocket(peer->socket);
+    return false;
+  }
+  peer->connected = true;
+  peer->accepting = true;
+  {
+    std::lock_guard<std::mutex> control(control_mutex_);
+    pending_peers_.push_back(std::move(peer));
+  }
+  WakeSocket(wake_);
+  return true;
+}
+
+void NetEventBridgeService::Stop() {
+  std::lock_guard<std::mutex> lock(lifecycle_mutex_);
+  if (!io_thread_.joinable()) return;
+  io_stop_.store(true);
+  WakeSocket(wake_);
+  io_thread_.join();
+
+  // 网络线程已退出：由这里接管剩余的套接字
+  AdoptPending();
+  for (const auto& peer : io_peers_) {
+    CloseSocket(peer->socket);
+    peer->socket = kInvalidSocket;
+    ApplyInterest(*peer, {});
+    std::lock_guard<std::mutex> peer_lock(peer->mutex);
+    peer->accepting = false;
+    peer->space_cv.notify_all();
+  }
+  io_peers_.clear();
+  PublishPeers();
+  for (SocketHandle s : listeners_) CloseSocket(s);
+  listeners_.clear();
+  CloseSocket(wake_);
+  wake_ = kInvalidSocket;
+  connected_peers_.store(0);
+}
+
+bool NetEventBridgeService::IsRemoteSubscribed(EventId event_id) const {
+  std::lock_guard<std::mutex> lock(control_mutex_);
+  return remote_interest_.count(event_id) != 0;
+}
+
+NetBridgeStats NetEventBridgeService::GetStats() const {
+  NetBridgeStats stats;
+  stats.sent_events = sent_events_.load(std::memory_order_relaxed);
+  stats.sent_frames = sent_frames_.load(std::memory_order_relaxed);
+  stats.received_events = received_events_.load(std::memory_order_relaxed);
+  stats.received_frames = received_frames_.load(std::memory_order_relaxed);
+  stats.dropped_events = dropped_events_.load(std::memory_order_relaxed);
+  stats.unknown_events = unknown_events_.load(std::memory_order_relaxed);
+  stats.decode_failures = decode_failures_.load(std::memory_order_relaxed);
+  stats.connected_peers = connected_peers_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+void NetEventBridgeService::RegisterExport(EventId event_id,
+                                           ExportSubscribeFn subscribe) {
+  std::lock_guard<std::mutex> lock(control_mutex_);
+  auto [it, inserted] = exports_.try_emplace(event_id);
+  if (!inserted) return;
+  it->second.subscribe = subscribe;
+  if (remote_interest_.count(event_id)) ActivateExportLocked(it->second);
+}
+
+void NetEventBridgeService::RegisterImport(EventId event_id,
+                                           ImportDecodeFn decode) {
+  {
+    std::lock_guard<std::mutex> lock(control_mutex_);
+    if (!imports_.emplace(event_id, decode).second) return;
+  }
+  // 新的导入集合立即通告给所有已连接的对端
+  const std::string frame = BuildInterestFrame();
+  const auto peers = SnapshotPeers();
+  for (const auto& peer : *peers) QueueInterest(*peer, frame);
+  if (wake_ != kInvalidSocket) WakeSocket(wake_);
+}
+
+void NetEventBridgeService::SendEvent(EventId event_id, const void* payload,
+                                      size_t size) {
+  if (t_dispatching_imported) return;
+  const size_t record = kRecordHeaderBytes + size;
+  const auto peers = SnapshotPeers();
+  bool sent = false;
+  bool wake = false;
+  for (const auto& peer : *peers) {
+    std::unique_lock<std::mutex> lock(peer->mutex);
+    if (!peer->accepting || !peer->interest.count(event_id)) continue;
+
+    if (peer->kind == Peer::Kind::kMulticast) {
+      // 组播不可靠：放不进一个数据报或积压已满时直接丢弃
+      if (record > kMaxDatagramBatch ||
+          peer->PendingBytes() + record > options_.max_pending_bytes) {
+        dropped_events_.fetch_add(1, std::memory_order_relaxed);
+        continue;
+      }
+      if (peer->batch.Size() + record > kMaxDatagramBatch) SealBatchLocked(*peer);
+    } else if (peer->PendingBytes() + record > options_.max_pending_bytes) {
+      // 背压：等待网络线程发出数据，超时仍无空间则丢弃
+      const bool has_space = options_.backpressure_timeout_ms > 0 &&
+          peer->space_cv.wait_for(
+              lock, std::chrono::milliseconds(options_.backpressure_timeout_ms),
+              [&] {
+                return !peer->accepting ||
+                       peer->PendingBytes() + record <= options_.max_pending_bytes;
+              });
+      if (!has_space || !peer->accepting) {
+        dropped_events_.fetch_add(1, std::memory_order_relaxed);
+        continue;
+      }
+    }
+
+    wake = wake || peer->batch.Size() == 0;
+    peer->batch.Write(static_cast<uint64_t>(event_id));
+    peer->batch.WriteBytes(payload, size);
+    if (peer->kind != Peer::Kind::kMulticast &&
+        peer->batch.Size() >= options_.max_batch_bytes) {
+      SealBatchLocked(*peer);
+      wake = true;
+    }
+    sent = true;
+  }
+  if (sent) sent_events_.fetch_add(1, std::memory_order_relaxed);
+  if (wake) WakeSocket(wake_);
+}
+
+bool NetEventBridgeService::IsDispatchingImported() const noexcept {
+  return t_dispatching_imported;
+}
+
+void NetEventBridgeService::ActivateExportLocked(ExportEntry& entry) {
+  if (entry.active) return;
+  auto bus = bus_.lock();
+  if (!bus) return;
+  entry.connection = entry.subscribe(*bus, *this, entry.sink);
+  entry.active = true;
+}
+
+void NetEventBridgeService::DeactivateExportLocked(ExportEntry& entry) {
+  if (!entry.active) return;
+  entry.connection.Disconnect();
+  entry.sink.reset();
+  entry.active = false;
+}
+
+void NetEventBridgeService::ApplyInterest(Peer& peer,
+                                          std::unordered_set<EventId> interest) {
+  std::vector<EventId> added, removed;
+  for (EventId id : interest) {
+    if (!peer.applied_interest.count(id)) added.push_back(id);
+  }
+  for (EventId id : peer.applied_interest) {
+    if (!interest.count(id)) removed.push_back(id);
+  }
+  peer.applied_interest = interest;
+  {
+    std::lock_guard<std::mutex> lock(peer.mutex);
+    peer.interest = std::move(interest);
+  }
+  if (added.empty() && removed.empty()) return;
+
+  std::lock_guard<std::mutex> lock(control_mutex_);
+  for (EventId id : added) {
+    if (++remote_interest_[id] != 1) continue;
+    auto it = exports_.find(id);
+    if (it != exports_.end()) ActivateExportLocked(it->second);
+  }
+  for (EventId id : removed) {
+    auto count = remote_interest_.find(id);
+    if (count == remote_interest_.end() || --count->second != 0) continue;
+    remote_interest_.erase(count);
+    auto it = exports_.find(id);
+    if (it != exports_.end()) DeactivateExportLocked(it->second);
+  }
+}
+
+std::string NetEventBridgeService::BuildInterestFrame() const {
+  z3y::EventWriter payload;
+  {
+    std::lock_guard<std::mutex> lock(control_mutex_);
+    payload.Write(static_cast<uint32_t>(imports_.size()));
+    for (const auto& entry : imports_) payload.Write(static_cast<uint64_t>(entry.first));
+  }
+  std::string frame;
+  AppendFrame(frame, kFrameInterest, node_id_, payload.Buffer().data(),
+              payload.Size());
+  return frame;
+}
+
+void NetEventBridgeService::QueueInterest(Peer& peer, const std::string& frame) {
+  std::lock_guard<std::mutex> lock(peer.mutex);
+  if (!peer.accepting) return;
+  if (peer.kind == Peer::Kind::kMulticast) {
+    peer.datagram_bytes += frame.size();
+    peer.datagrams.push_back(frame);
+  } else {
+    peer.out += frame;
+  }
+}
+
+std::shared_ptr<const NetEventBridgeService::PeerList>
+NetEventBridgeService::SnapshotPeers() const {
+  std::lock_guard<std::mutex> lock(peers_mutex_);
+  return peers_;
+}
+
+void NetEventBridgeService::PublishPeers() {
+  auto snapshot = std::make_shared<const PeerList>(io_peers_);
+  std::lock_guard<std::mutex> lock(peers_mutex_);
+  peers_ = std::move(snapshot);
+}
+
+void NetEventBridgeService::AdoptPending() {
+  PeerList peers;
+  std::vector<SocketHandle> listeners;
+  {
+    std::lock_guard<std::mutex> lock(control_mutex_);
+    peers.swap(pending_peers_);
+    listeners.swap(pending_listeners_);
+  }
+  listeners_.insert(listeners_.end(), listeners.begin(), listeners.end());
+  if (peers.empty()) return;
+  for (auto& peer : peers) {
+    if (peer->kind == Peer::Kind::kMulticast) {
+      QueueInterest(*peer, BuildInterestFrame());
+    }
+    io_peers_.push_back(std::move(peer));
+  }
+  PublishPeers();
+}
+
+void NetEventBridgeService::SealBatchLocked(Peer& peer) {
+  if (peer.batch.Size() == 0) return;
+  if (peer.kind == Peer::Kind::kMulticast) {
+    std::string datagram;
+    AppendFrame(datagram, kFrameBatch, node_id_, peer.batch.Buffer().data(),
+                peer.batch.Size());
+    peer.datagram_bytes += datagram.size();
+    peer.datagrams.push_back(std::move(datagram));
+  } else {
+    AppendFrame(peer.out, kFrameBatch, node_id_, peer.batch.Buffer().data(),
+                peer.batch.Size());
+  }
+  peer.batch.Clear();
+  sent_frames_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void NetEventBridgeService::SealBatches() {
+  for (const auto& peer : io_peers_) {
+    std::lock_guard<std::mutex> lock(peer->mutex);
+    SealBatchLocked(*peer);
+  }
+}
+
+void NetEventBridgeService::FlushPeer(const std::shared_ptr<Peer>& peer) {
+  if (peer->socket == kInvalidSocket || !peer->connected) return;
+  bool failed = false;
+  {
+    std::lock_guard<std::mutex> lock(peer->mutex);
+    const size_t before = peer->PendingBytes();
+    if (peer->kind == Peer::Kind::kMulticast) {
+      while (!peer->datagrams.empty()) {
+        const std::string& d = peer->datagrams.front();
+        if (!SendDatagram(peer->socket, peer->address, d.data(), d.size())) break;
+        peer->datagram_bytes -= d.size();
+        peer->datagrams.pop_front();
+      }
+    } else {
+      while (peer->out_sent < peer->out.size()) {
+        const long n = SendSome(peer->socket, peer->out.data() + peer->out_sent,
+                                peer->out.size() - peer->out_sent);
+        if (n < 0) {
+          failed = true;
+          break;
+        }
+        if (n == 0) break;
+        peer->out_sent += static_cast<size_t>(n);
+      }
+      if (peer->out_sent == peer->out.size()) {
+        peer->out.clear();
+        peer->out_sent = 0;
+      } else if (peer->out_sent > (1u << 20)) {
+        peer->out.erase(0, peer->out_sent);
+        peer->out_sent = 0;
+      }
+    }
+    if (peer->PendingBytes() < before) peer->space_cv.notify_all();
+  }
+  if (failed) ClosePeer(peer);
+}
+
+void NetEventBridgeService::OnConnected(const std::shared_ptr<Peer>& peer) {
+  peer->connecting = false;
+  peer->connected = true;
+  connected_peers_.fetch_add(1, std::memory_order_relaxed);
+  {
+    std::lock_guard<std::mutex> lock(peer->mutex);
+    peer->accepting = true;
+  }
+  QueueInterest(*peer, BuildInterestFrame());
+}
+
+void NetEventBridgeService::ClosePeer(const std::shared_ptr<Peer>& peer) {
+  CloseSocket(peer->socket);
+  peer->socket = kInvalidSocket;
+  if (peer->connected) connected_peers_.fetch_sub(1, std::memory_order_relaxed);
+  peer->connecting = false;
+  peer->connected = false;
+  peer->in.clear();
+  ApplyInterest(*peer, {});
+  {
+    std::lock_guard<std::mutex> lock(peer->mutex);
+    peer->accepting = false;
+    peer->batch.Clear();
+    peer->out.clear();
+    peer->out_sent = 0;
+    peer->space_cv.notify_all();
+  }
+  if (peer->kind == Peer::Kind::kOutbound) {
+    peer->retry_at =
+        Clock::now() + std::chrono::milliseconds(options_.reconnect_interval_ms);
+  } else {
+    io_peers_.erase(std::remove(io_peers_.begin(), io_peers_.end(), peer),
+                    io_peers_.end());
+    PublishPeers();
+  }
+}
+
+void NetEventBridgeService::ReadTcp(const std::shared_ptr<Peer>& peer) {
+  char buf[64 * 1024];
+  for (;;) {
+    const long n = ReceiveSome(peer->socket, buf, sizeof(buf));
+    if (n < 0) {
+      ClosePeer(peer);
+      return;
+    }
+    if (n == 0) break;
+    peer->in.append(buf, static_cast<size_t>(n));
+  }
+
+  size_t offset = 0;
+  while (peer->in.size() - offset >= kFrameHeaderBytes) {
+    z3y::EventReader header(peer->in.data() + offset, kFrameHeaderBytes);
+    const uint32_t magic = header.Read<uint32_t>();
+    const uint16_t version = header.Read<uint16_t>();
+    const uint16_t type = header.Read<uint16_t>();
+    const uint32_t length = header.Read<uint32_t>();
+    (void)header.Read<uint32_t>();
+    const uint64_t node_id = header.Read<uint64_t>();
+    if (magic != kFrameMagic || version != kFrameVersion || length > kMaxFrameBytes) {
+      ClosePeer(peer);  // 不是桥协议，或数据已损坏
+      return;
+    }
+    if (peer->in.size() - offset < kFrameHeaderBytes + length) break;
+    HandleFrame(peer, type, node_id, peer->in.data() + offset + kFrameHeaderBytes,
+                length);
+    if (!peer->connected) return;  // 处理过程中连接被关闭
+    offset += kFrameHeaderBytes + length;
+  }
+  peer->in.erase(0, offset);
+}
+
+void NetEventBridgeService::ReadMulticast(const std::shared_ptr<Peer>& peer) {
+  char buf[64 * 1024];
+  for (;;) {
+    const long n = ReceiveDatagram(peer->socket, buf, sizeof(buf));
+    if (n < 0) return;
+    if (static_cast<size_t>(n) < kFrameHeaderBytes) continue;
+    z3y::EventReader header(buf, kFrameHeaderBytes);
+    const uint32_t magic = header.Read<uint32_t>();
+    const uint16_t version = header.Read<uint16_t>();
+    const uint16_t type = header.Read<uint16_t>();
+    const uint32_t length = header.Read<uint32_t>();
+    (void)header.Read<uint32_t>();
+    const uint64_t node_id = header.Read<uint64_t>();
+    if (magic != kFrameMagic || version != kFrameVersion || node_id == node_id_ ||
+        kFrameHeaderBytes + length != static_cast<size_t>(n)) {
+      continue;  // 自己发出的 (组播回环)、其他协议或被截断的数据报
+    }
+    HandleFrame(peer, type, node_id, buf + kFrameHeaderBytes, length);
+  }
+}
+
+void NetEventBridgeService::HandleFrame(const std::shared_ptr<Peer>& peer,
+                                        uint16_t type, uint64_t node_id,
+                                        const char* data, size_t size) {
+  if (type == kFrameBatch) {
+    received_frames_.fetch_add(1, std::memory_order_relaxed);
+    DispatchBatch(data, size);
+    return;
+  }
+  if (type != kFrameInterest) return;  // 忽略未知类型，便于协议扩展
+
+  std::unordered_set<EventId> interest;
+  try {
+    z3y::EventReader reader(data, size);
+    const uint32_t count = reader.Read<uint32_t>();
+    for (uint32_t i = 0; i < count; ++i) interest.insert(reader.Read<uint64_t>());
+  } catch (const std::out_of_range&) {
+    return;
+  }
+  if (peer->kind == Peer::Kind::kMulticast) {
+    const auto now = Clock::now();
+    MulticastSource& source = peer->sources[node_id];
+    source.interest = std::move(interest);
+    source.expires =
+        now + std::chrono::milliseconds(3 * options_.multicast_announce_ms);
+    RefreshMulticastInterest(*peer, now);
+  } else {
+    ApplyInterest(*peer, std::move(interest));
+  }
+}
+
+void NetEventBridgeService::RefreshMulticastInterest(Peer& peer,
+                                                     Clock::time_point now) {
+  std::unordered_set<EventId> merged;
+  for (auto it = peer.sources.begin(); it != peer.sources.end();) {
+    if (it->second.expires <= now) {
+      it = peer.sources.erase(it);
+      continue;
+    }
+    merged.insert(it->second.interest.begin(), it->second.interest.end());
+    ++it;
+  }
+  ApplyInterest(peer, std::move(merged));
+}
+
+void NetEventBridgeService::DispatchBatch(const char* data, size_t size) {
+  auto bus = bus_.lock();
+  z3y::EventReader batch(data, size);
+  while (batch.Remaining() != 0) {
+    uint64_t event_id = 0;
+    std::string_view payload;
+    try {
+      event_id = batch.Read<uint64_t>();
+      payload = batch.ReadBytes();
+    } catch (const std::out_of_range&) {
+      decode_failures_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    ImportDecodeFn decode = nullptr;
+    {
+      std::lock_guard<std::mutex> lock(control_mutex_);
+      auto it = imports_.find(event_id);
+      if (it != imports_.end()) decode = it->second;
+    }
+    if (!decode || !bus) {
+      unknown_events_.fetch_add(1, std::memory_order_relaxed);
+      continue;
+    }
+    z3y::EventReader reader(payload.data(), payload.size());
+    t_dispatching_imported = true;
+    try {
+      decode(*bus, reader);
+      received_events_.fetch_add(1, std::memory_order_relaxed);
+    } catch (...) {
+      decode_failures_.fetch_add(1, std::memory_order_relaxed);
+    }
+    t_dispatching_imported = false;
+  }
+}
+
+void NetEventBridgeService::IoLoop() {
+  std::vector<PollEntry> entries;
+  std::vector<std::shared_ptr<Peer>> polled;
+  while (!io_stop_.load()) {
+    AdoptPending();
+    const auto now = Clock::now();
+    auto next_wakeup = now + std::chrono::milliseconds(kIdlePollMs);
+
+    // 1. 定时任务：重连与组播订阅通告
+    for (const auto& peer : io_peers_) {
+      if (peer->kind == Peer::Kind::kOutbound && peer->socket == kInvalidSocket) {
+        if (peer->retry_at <= now) {
+          std::string error;
+          peer->socket = StartTcpConnect(peer->address, error);
+          peer->connecting = peer->socket != kInvalidSocket;
+          if (!peer->connecting) {
+            peer->retry_at =
+                now + std::chrono::milliseconds(options_.reconnect_interval_ms);
+          }
+        }
+        if (peer->socket == kInvalidSocket) {
+          next_wakeup = std::min(next_wakeup, peer->retry_at);
+        }
+      }
+    }
+    if (next_announce_ <= now) {
+      next_announce_ = now + std::chrono::milliseconds(options_.multicast_announce_ms);
+      std::string frame;
+      for (const auto& peer : io_peers_) {
+        if (peer->kind != Peer::Kind::kMulticast) continue;
+        if (frame.empty()) frame = BuildInterestFrame();
+        QueueInterest(*peer, frame);
+        RefreshMulticastInterest(*peer, now);
+      }
+    }
+    next_wakeup = std::min(next_wakeup, next_announce_);
+
+    // 2. 封帧并等待套接字就绪
+    SealBatches();
+    entries.clear();
+    polled.clear();
+    entries.push_back(PollEntry{wake_});
+    for (SocketHandle s : listeners_) entries.push_back(PollEntry{s});
+    for (const auto& peer : io_peers_) {
+      if (peer->socket == kInvalidSocket) continue;
+      PollEntry entry{peer->socket};
+      {
+        std::lock_guard<std::mutex> lock(peer->mutex);
+        entry.want_write = peer->connecting || peer->out_sent < peer->out.size() ||
+                           !peer->datagrams.empty();
+      }
+      entries.push_back(entry);
+      polled.push_back(peer);
+    }
+    const auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(
+        next_wakeup - now);
+    PollSockets(entries, static_cast<int>(std::max<int64_t>(1, wait.count())));
+    if (io_stop_.load()) break;
+
+    // 3. 处理就绪的套接字
+    if (entries[0].readable) DrainWakeSocket(wake_);
+    for (size_t i = 0; i < listeners_.size(); ++i) {
+      if (!entries[1 + i].readable) continue;
+      for (SocketHandle s; (s = AcceptTcp(listeners_[i])) != kInvalidSocket;) {
+        auto peer = std::make_shared<Peer>(Peer::Kind::kAccepted);
+        peer->socket = s;
+        io_peers_.push_back(peer);
+        OnConnected(peer);
+        PublishPeers();
+      }
+    }
+    const size_t first_peer = 1 + listeners_.size();
+    for (size_t i = 0; i < polled.size(); ++i) {
+      const PollEntry& entry = entries[first_peer + i];
+      const auto& peer = polled[i];
+      if (peer->socket != entry.socket) continue;  // 本轮中已被关闭
+      if (peer->connecting) {
+        if (!entry.writable && !entry.readable && !entry.failed) continue;
+        if (FinishTcpConnect(peer->socket)) {
+          OnConnected(peer);
+        } else {
+          ClosePeer(peer);
+        }
+        continue;
+      }
+      if (peer->kind == Peer::Kind::kMulticast) {
+        if (entry.readable) ReadMulticast(peer);
+        continue;
+      }
+      if (entry.failed) {
+        ClosePeer(peer);
+        continue;
+      }
+      if (entry.readable) ReadTcp(peer);
+    }
+
+    // 4. 本轮新到的事件与通告一并发出
+    SealBatches();
+    const PeerList peers = io_peers_;  // FlushPeer 可能移除对端
+    for (const auto& peer : peers) FlushPeer(peer);
+  }
+}
+
+}  // namespace z3y::plugins::net_bridge
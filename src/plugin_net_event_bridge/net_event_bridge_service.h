@@ -0,0 +1,181 @@
+﻿/**
+ * @file net_event_bridge_service.h
+ * @brief 跨主机事件桥插件的具体实现类声明。
+ * * @details
+ * 【面向维护者】
+ * 1. **线程**：每个桥一个网络线程，负责全部套接字 I/O、帧解析、导入事件的发布以及
+ * 重连 / 组播通告定时。发布线程只在 `SendEvent` 中锁住对端缓冲区追加记录。
+ * 2. **对端表**：网络线程独占 `io_peers_`，每次增删后发布一份只读快照 `peers_`
+ * 供发布线程遍历，遍历期间不持有任何全局锁。
+ * 3. **订阅计数**：`remote_interest_` 记录每个事件 ID 被多少个对端导入；从 0 变 1 时
+ * 调用登记的订阅函数在本地总线上订阅，回到 0 时断开。
+ * 4. **锁顺序**：lifecycle_mutex_ → control_mutex_ → Peer::mutex。发布线程只取 Peer::mutex。
+ */
+
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "framework/z3y_define_impl.h"
+#include "interfaces_core/i_net_event_bridge.h"
+#include "net_socket.h"
+
+namespace z3y::plugins::net_bridge {
+
+/**
+ * @brief INetEventBridge 的默认实现类。
+ */
+class NetEventBridgeService
+    : public z3y::PluginImpl<NetEventBridgeService,
+                             z3y::interfaces::core::INetEventBridge> {
+ public:
+  Z3Y_DEFINE_COMPONENT_ID("z3y-core-NetEventBridge-Impl-v1");
+
+  /// 组播单个数据报中批的上限：以太网 MTU 1500 减去 IP/UDP 头与帧头，避免分片
+  static constexpr size_t kMaxDatagramBatch = 1400;
+
+  NetEventBridgeService();
+  ~NetEventBridgeService() override { Stop(); }
+
+  void Initialize() override;
+  void Shutdown() override { Stop(); }
+
+  bool Configure(const z3y::interfaces::core::NetBridgeOptions& options) override;
+  uint16_t ListenTcp(const std::string& bind_address, uint16_t port,
+                     std::string& out_error) override;
+  bool ConnectTcp(const std::string& target, std::string& out_error) override;
+  bool JoinMulticast(const std::string& group_target,
+                     const std::string& interface_address,
+                     std::string& out_error) override;
+  void Stop() override;
+  bool IsRemoteSubscribed(EventId event_id) const override;
+  z3y::interfaces::core::NetBridgeStats GetStats() const override;
+
+  void RegisterExport(EventId event_id, ExportSubscribeFn subscribe) override;
+  void RegisterImport(EventId event_id, ImportDecodeFn decode) override;
+  void SendEvent(EventId event_id, const void* payload, size_t size) override;
+  bool IsDispatchingImported() const noexcept override;
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  struct ExportEntry {
+    ExportSubscribeFn subscribe = nullptr;
+    std::shared_ptr<void> sink;
+    Connection connection;
+    bool active = false;
+  };
+
+  /** @brief 组播上某个远端节点最近一次通告的订阅集合。 */
+  struct MulticastSource {
+    std::unordered_set<EventId> interest;
+    Clock::time_point expires;
+  };
+
+  struct Peer {
+    enum class Kind { kAccepted, kOutbound, kMulticast };
+    explicit Peer(Kind k) : kind(k) {}
+
+    const Kind kind;
+    SocketAddress address;  ///< 连接目标或组播组
+
+    // ---- 仅网络线程访问 ----
+    SocketHandle socket = kInvalidSocket;
+    bool connecting = false;
+    bool connected = false;
+    Clock::time_point retry_at;
+    std::string in;
+    std::unordered_set<EventId> applied_interest;  ///< 已计入 remote_interest_ 的集合
+    std::unordered_map<uint64_t, MulticastSource> sources;
+
+    // ---- 受 mutex 保护 (发布线程与网络线程共享) ----
+    std::mutex mutex;
+    std::condition_variable space_cv;  ///< 积压减少或连接断开时通知
+    bool accepting = false;            ///< 已连接，可以接收事件
+    std::unordered_set<EventId> interest;
+    z3y::EventWriter batch;            ///< 尚未成帧的事件记录
+    std::string out;                   ///< TCP：已成帧、待发送的字节
+    size_t out_sent = 0;
+    std::deque<std::string> datagrams;  ///< 组播：待发送的数据报
+    size_t datagram_bytes = 0;
+
+    size_t PendingBytes() const {
+      return batch.Size() + (out.size() - out_sent) + datagram_bytes;
+    }
+  };
+  using PeerList = std::vector<std::shared_ptr<Peer>>;
+
+  bool EnsureStarted(std::string& error);
+  void IoLoop();
+  void AdoptPending();
+  void PublishPeers();
+  std::shared_ptr<const PeerList> SnapshotPeers() const;
+
+  /** @brief [Peer::mutex] 把积攒的记录封成一帧 (TCP) 或一个数据报 (组播)。 */
+  void SealBatchLocked(Peer& peer);
+  void SealBatches();
+  void FlushPeer(const std::shared_ptr<Peer>& peer);
+  void ReadTcp(const std::shared_ptr<Peer>& peer);
+  void ReadMulticast(const std::shared_ptr<Peer>& peer);
+  void HandleFrame(const std::shared_ptr<Peer>& peer, uint16_t type,
+                   uint64_t node_id, const char* data, size_t size);
+  void DispatchBatch(const char* data, size_t size);
+  void OnConnected(const std::shared_ptr<Peer>& peer);
+  void ClosePeer(const std::shared_ptr<Peer>& peer);
+  void ApplyInterest(Peer& peer, std::unordered_set<EventId> interest);
+  void RefreshMulticastInterest(Peer& peer, Clock::time_point now);
+
+  std::string BuildInterestFrame() const;
+  /** @brief 把当前的导入集合排入一个对端的发送队列。 */
+  void QueueInterest(Peer& peer, const std::string& frame);
+
+  /** @brief [control_mutex_] 在本地总线上订阅 / 断开一个导出事件。 */
+  void ActivateExportLocked(ExportEntry& entry);
+  void DeactivateExportLocked(ExportEntry& entry);
+
+  std::weak_ptr<z3y::IEventBus> bus_;  ///< Initialize 时取得
+
+  std::mutex lifecycle_mutex_;  ///< 串行化 Configure / Listen / Connect / Join / Stop
+  z3y::interfaces::core::NetBridgeOptions options_;
+  uint64_t node_id_ = 0;
+
+  mutable std::mutex control_mutex_;  ///< 保护以下登记表与待接管的套接字
+  std::unordered_map<EventId, ExportEntry> exports_;
+  std::unordered_map<EventId, ImportDecodeFn> imports_;
+  std::unordered_map<EventId, uint32_t> remote_interest_;
+  std::vector<SocketHandle> pending_listeners_;
+  PeerList pending_peers_;
+
+  // ---- 仅网络线程访问 ----
+  std::vector<SocketHandle> listeners_;
+  PeerList io_peers_;
+  Clock::time_point next_announce_;
+
+  mutable std::mutex peers_mutex_;
+  std::shared_ptr<const PeerList> peers_;  ///< 发布线程使用的对端快照
+
+  SocketHandle wake_ = kInvalidSocket;
+  std::thread io_thread_;
+  std::atomic<bool> io_stop_{false};
+
+  std::atomic<uint64_t> sent_events_{0};
+  std::atomic<uint64_t> sent_frames_{0};
+  std::atomic<uint64_t> received_events_{0};
+  std::atomic<uint64_t> received_frames_{0};
+  std::atomic<uint64_t> dropped_events_{0};
+  std::atomic<uint64_t> unknown_events_{0};
+  std::atomic<uint64_t> decode_failures_{0};
+  std::atomic<uint32_t> connected_peers_{0};
+};
+
+}  // namespace z3y::plugins::net_bridge
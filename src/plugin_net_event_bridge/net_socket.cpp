@@ -0,0 +1,328 @@
+﻿/**
+ * @file net_socket.cpp
+ * @brief net_socket.h 的平台实现。
+ */
+
+#include "net_socket.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#endif
+
+#include <cstring>
+
+namespace z3y::plugins::net_bridge {
+
+namespace {
+
+#ifdef _WIN32
+SOCKET Native(SocketHandle s) { return static_cast<SOCKET>(s); }
+#else
+int Native(SocketHandle s) { return s; }
+#endif
+
+SocketHandle OpenSocket(int family, int type, int protocol) {
+  return static_cast<SocketHandle>(::socket(family, type, protocol));
+}
+
+/** @brief 事件帧通常很小，关闭 Nagle 以免批次被额外延迟。 */
+void DisableNagle(SocketHandle s) {
+  int on = 1;
+  ::setsockopt(Native(s), IPPROTO_TCP, TCP_NODELAY,
+               reinterpret_cast<const char*>(&on), sizeof(on));
+}
+
+void EnableReuse(SocketHandle s) {
+  int on = 1;
+  ::setsockopt(Native(s), SOL_SOCKET, SO_REUSEADDR,
+               reinterpret_cast<const char*>(&on), sizeof(on));
+}
+
+const sockaddr* AsSockaddr(const SocketAddress& a) {
+  return reinterpret_cast<const sockaddr*>(a.storage.data());
+}
+
+}  // namespace
+
+bool ResolveAddress(const std::string& target, bool datagram,
+                    SocketAddress& out, std::string& error) {
+  std::string host, port;
+  if (!net::SplitHostPort(target, host, port)) {
+    error = "expected 'host:port', got '" + target + "'";
+    return false;
+  }
+  if (!net::EnsureSockets()) {
+    error = "socket library initialization failed";
+    return false;
+  }
+  addrinfo hints{};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = datagram ? SOCK_DGRAM : SOCK_STREAM;
+  addrinfo* res = nullptr;
+  if (::getaddrinfo(host.c_str(), port.c_str(), &hints, &res) != 0 || !res) {
+    error = "cannot resolve '" + target + "'";
+    return false;
+  }
+  out.length = static_cast<uint32_t>(res->ai_addrlen);
+  std::memcpy(out.storage.data(), res->ai_addr, res->ai_addrlen);
+  ::freeaddrinfo(res);
+  return true;
+}
+
+SocketHandle OpenTcpListener(const std::string& address, uint16_t port,
+                             uint16_t& out_port, std::string& error) {
+  if (!net::EnsureSockets()) {
+    error = "socket library initialization failed";
+    return kInvalidSocket;
+  }
+  addrinfo hints{};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  hints.ai_flags = AI_PASSIVE | AI_NUMERICHOST;
+  addrinfo* res = nullptr;
+  const std::string port_str = std::to_string(port);
+  if (::getaddrinfo(address.empty() ? nullptr : address.c_str(),
+                    port_str.c_str(), &hints, &res) != 0) {
+    error = "invalid bind address '" + address + "'";
+    return kInvalidSocket;
+  }
+  SocketHandle s = OpenSocket(res->ai_family, res->ai_socktype, res->ai_protocol);
+  if (s == kInvalidSocket) {
+    error = net::LastSocketError();
+    ::freeaddrinfo(res);
+    return kInvalidSocket;
+  }
+#ifndef _WIN32
+  // 允许重启后立即重新绑定仍处于 TIME_WAIT 的端口
+  EnableReuse(s);
+#endif
+  bool ok = ::bind(Native(s), res->ai_addr,
+                   static_cast<int>(res->ai_addrlen)) == 0 &&
+            ::listen(Native(s), 16) == 0 && net::SetNonBlocking(s);
+  ::freeaddrinfo(res);
+  sockaddr_storage bound{};
+  socklen_t bound_len = sizeof(bound);
+  if (ok) {
+    ok = ::getsockname(Native(s), reinterpret_cast<sockaddr*>(&bound),
+                       &bound_len) == 0;
+  }
+  if (!ok) {
+    error = net::LastSocketError();
+    CloseSocket(s);
+    return kInvalidSocket;
+  }
+  out_port = bound.ss_family == AF_INET6
+                 ? ntohs(reinterpret_cast<sockaddr_in6*>(&bound)->sin6_port)
+                 : ntohs(reinterpret_cast<sockaddr_in*>(&bound)->sin_port);
+  return s;
+}
+
+SocketHandle AcceptTcp(SocketHandle listener) {
+  SocketHandle s =
+      static_cast<SocketHandle>(::accept(Native(listener), nullptr, nullptr));
+  if (s == kInvalidSocket) return kInvalidSocket;
+  if (!net::SetNonBlocking(s)) {
+    CloseSocket(s);
+    return kInvalidSocket;
+  }
+  DisableNagle(s);
+  return s;
+}
+
+SocketHandle StartTcpConnect(const SocketAddress& to, std::string& error) {
+  if (!net::EnsureSockets()) {
+    error = "socket library initialization failed";
+    return kInvalidSocket;
+  }
+  SocketHandle s = OpenSocket(AsSockaddr(to)->sa_family, SOCK_STREAM, 0);
+  if (s == kInvalidSocket || !net::SetNonBlocking(s)) {
+    error = net::LastSocketError();
+    CloseSocket(s);
+    return kInvalidSocket;
+  }
+  DisableNagle(s);
+  if (::connect(Native(s), AsSockaddr(to), static_cast<int>(to.length)) != 0 &&
+      !net::WouldBlock()) {
+    error = net::LastSocketError();
+    CloseSocket(s);
+    return kInvalidSocket;
+  }
+  return s;
+}
+
+bool FinishTcpConnect(SocketHandle s) { return net::ConnectSucceeded(s); }
+
+long SendSome(SocketHandle s, const char* data, size_t size) {
+  const long n = net::SendBytes(s, data, size);
+  if (n >= 0) return n;
+  return net::WouldBlock() ? 0 : -1;
+}
+
+long ReceiveSome(SocketHandle s, char* buf, size_t size) {
+  const long n = net::ReceiveBytes(s, buf, size);
+  if (n > 0) return n;
+  if (n == 0) return -1;  // 对端关闭
+  return net::WouldBlock() ? 0 : -1;
+}
+
+SocketHandle OpenMulticast(const std::string& group_target,
+                           const std::string& interface_address, int ttl,
+                           SocketAddress& out_group, std::string& error) {
+  std::string host, port;
+  if (!net::SplitHostPort(group_target, host, port)) {
+    error = "expected 'group:port', got '" + group_target + "'";
+    return kInvalidSocket;
+  }
+  if (!net::EnsureSockets()) {
+    error = "socket library initialization failed";
+    return kInvalidSocket;
+  }
+  sockaddr_in group{};
+  group.sin_family = AF_INET;
+  group.sin_port = htons(static_cast<uint16_t>(std::stoi(port)));
+  if (::inet_pton(AF_INET, host.c_str(), &group.sin_addr) != 1 ||
+      !IN_MULTICAST(ntohl(group.sin_addr.s_addr))) {
+    error = "'" + host + "' is not an IPv4 multicast address";
+    return kInvalidSocket;
+  }
+  in_addr iface{};
+  iface.s_addr = htonl(INADDR_ANY);
+  if (!interface_address.empty() &&
+      ::inet_pton(AF_INET, interface_address.c_str(), &iface) != 1) {
+    error = "invalid interface address '" + interface_address + "'";
+    return kInvalidSocket;
+  }
+
+  SocketHandle s = OpenSocket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  if (s == kInvalidSocket) {
+    error = net::LastSocketError();
+    return kInvalidSocket;
+  }
+  // 同一主机上的多个节点共用组播端口
+  EnableReuse(s);
+#ifdef SO_REUSEPORT
+  int on = 1;
+  ::setsockopt(s, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on));
+#endif
+  sockaddr_in bind_addr{};
+  bind_addr.sin_family = AF_INET;
+  bind_addr.sin_port = group.sin_port;
+  bind_addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  ip_mreq mreq{};
+  mreq.imr_multiaddr = group.sin_addr;
+  mreq.imr_interface = iface;
+  const unsigned char loop = 1;
+  const unsigned char ttl_byte = static_cast<unsigned char>(ttl);
+  bool ok =
+      ::bind(Native(s), reinterpret_cast<const sockaddr*>(&bind_addr),
+             sizeof(bind_addr)) == 0 &&
+      ::setsockopt(Native(s), IPPROTO_IP, IP_ADD_MEMBERSHIP,
+                   reinterpret_cast<const char*>(&mreq), sizeof(mreq)) == 0 &&
+      ::setsockopt(Native(s), IPPROTO_IP, IP_MULTICAST_IF,
+                   reinterpret_cast<const char*>(&iface), sizeof(iface)) == 0 &&
+      ::setsockopt(Native(s), IPPROTO_IP, IP_MULTICAST_LOOP,
+                   reinterpret_cast<const char*>(&loop), sizeof(loop)) == 0 &&
+      ::setsockopt(Native(s), IPPROTO_IP, IP_MULTICAST_TTL,
+                   reinterpret_cast<const char*>(&ttl_byte),
+                   sizeof(ttl_byte)) == 0 &&
+      net::SetNonBlocking(s);
+  if (!ok) {
+    error = net::LastSocketError();
+    CloseSocket(s);
+    return kInvalidSocket;
+  }
+  out_group.length = sizeof(group);
+  std::memcpy(out_group.storage.data(), &group, sizeof(group));
+  return s;
+}
+
+bool SendDatagram(SocketHandle s, const SocketAddress& to, const char* data,
+                  size_t size) {
+#ifdef _WIN32
+  return ::sendto(Native(s), data, static_cast<int>(size), 0, AsSockaddr(to),
+                  static_cast<int>(to.length)) > 0;
+#else
+  return ::sendto(s, data, size, MSG_NOSIGNAL, AsSockaddr(to), to.length) > 0;
+#endif
+}
+
+long ReceiveDatagram(SocketHandle s, char* buf, size_t size) {
+  return net::ReceiveBytes(s, buf, size);
+}
+
+SocketHandle OpenWakeSocket(std::string& error) {
+  if (!net::EnsureSockets()) {
+    error = "socket library initialization failed";
+    return kInvalidSocket;
+  }
+  SocketHandle s = OpenSocket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  if (s == kInvalidSocket) {
+    error = net::LastSocketError();
+    return kInvalidSocket;
+  }
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t len = sizeof(addr);
+  bool ok = ::bind(Native(s), reinterpret_cast<const sockaddr*>(&addr),
+                   sizeof(addr)) == 0 &&
+            ::getsockname(Native(s), reinterpret_cast<sockaddr*>(&addr),
+                          &len) == 0 &&
+            ::connect(Native(s), reinterpret_cast<const sockaddr*>(&addr),
+                      sizeof(addr)) == 0 &&
+            net::SetNonBlocking(s);
+  if (!ok) {
+    error = net::LastSocketError();
+    CloseSocket(s);
+    return kInvalidSocket;
+  }
+  return s;
+}
+
+void WakeSocket(SocketHandle s) {
+  const char byte = 1;
+  (void)net::SendBytes(s, &byte, 1);
+}
+
+void DrainWakeSocket(SocketHandle s) {
+  char buf[64];
+  while (ReceiveDatagram(s, buf, sizeof(buf)) > 0) {
+  }
+}
+
+void PollSockets(std::vector<PollEntry>& entries, int timeout_ms) {
+#ifdef _WIN32
+  std::vector<WSAPOLLFD> fds(entries.size());
+  for (size_t i = 0; i < entries.size(); ++i) {
+    fds[i].fd = Native(entries[i].socket);
+    fds[i].events = POLLRDNORM | (entries[i].want_write ? POLLWRNORM : 0);
+  }
+  const int rc = WSAPoll(fds.data(), static_cast<ULONG>(fds.size()), timeout_ms);
+#else
+  std::vector<pollfd> fds(entries.size());
+  for (size_t i = 0; i < entries.size(); ++i) {
+    fds[i].fd = entries[i].socket;
+    fds[i].events = static_cast<short>(POLLIN | (entries[i].want_write ? POLLOUT : 0));
+  }
+  const int rc = ::poll(fds.data(), fds.size(), timeout_ms);
+#endif
+  for (size_t i = 0; i < entries.size(); ++i) {
+    const short re = rc > 0 ? fds[i].revents : 0;
+    entries[i].readable = (re & (POLLIN | POLLHUP)) != 0;
+    entries[i].writable = (re & POLLOUT) != 0;
+    entries[i].failed = (re & (POLLERR | POLLNVAL)) != 0;
+  }
+}
+
+}  // namespace z3y::plugins::net_bridge
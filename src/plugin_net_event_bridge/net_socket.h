@@ -0,0 +1,95 @@
+﻿/**
+ * @file net_socket.h
+ * @brief 事件桥插件使用的非阻塞 TCP / UDP 封装（BSD Socket 与 Winsock 通用）。
+ * * @details
+ * 【面向维护者】
+ * 桥只有一个网络线程，所有套接字都是非阻塞的，由 `PollSockets` 统一等待。
+ * 发布线程不直接接触套接字：它们写入对端缓冲区后，通过唤醒套接字（绑定在回环地址、
+ * 连接到自身的 UDP 套接字）叫醒网络线程。组播只支持 IPv4。
+ * 与其它网络插件共用的平台层 (Winsock 初始化、"host:port" 拆分等) 在 z3y_socket_common。
+ */
+
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "z3y_socket_common/socket_common.h"
+
+namespace z3y::plugins::net_bridge {
+
+using net::SocketHandle;
+using net::kInvalidSocket;
+using net::CloseSocket;
+
+/** @brief 不透明的套接字地址（sockaddr_storage 的拷贝）。 */
+struct SocketAddress {
+  std::array<unsigned char, 128> storage{};
+  uint32_t length = 0;
+};
+
+/** @brief 解析 "host:port"（取第一个结果）。 */
+bool ResolveAddress(const std::string& target, bool datagram,
+                    SocketAddress& out, std::string& error);
+
+/**
+ * @brief 以非阻塞方式监听 address:port。
+ * @param out_port 实际绑定的端口（port 为 0 时由系统分配）。
+ */
+SocketHandle OpenTcpListener(const std::string& address, uint16_t port,
+                             uint16_t& out_port, std::string& error);
+
+/** @brief 接受一个连接（非阻塞）；没有待处理的连接时返回 kInvalidSocket。 */
+SocketHandle AcceptTcp(SocketHandle listener);
+
+/** @brief 发起非阻塞连接；连接完成后套接字可写，再用 `FinishTcpConnect` 确认结果。 */
+SocketHandle StartTcpConnect(const SocketAddress& to, std::string& error);
+
+/** @brief 查询非阻塞连接的结果。 */
+bool FinishTcpConnect(SocketHandle s);
+
+/** @brief 发送尽可能多的数据。@return 已发送字节数，0 表示缓冲区已满，-1 表示连接出错。 */
+long SendSome(SocketHandle s, const char* data, size_t size);
+
+/** @brief 读取可用数据。@return 读到的字节数，0 表示暂无数据，-1 表示连接已关闭或出错。 */
+long ReceiveSome(SocketHandle s, char* buf, size_t size);
+
+/**
+ * @brief 打开 IPv4 组播套接字：绑定组播端口、加入组播组并开启回环。
+ * @param out_group 组播组地址，用作 `SendDatagram` 的目的地址。
+ */
+SocketHandle OpenMulticast(const std::string& group_target,
+                           const std::string& interface_address, int ttl,
+                           SocketAddress& out_group, std::string& error);
+
+/** @brief 发送一个数据报（非阻塞，缓冲区满时返回 false）。 */
+bool SendDatagram(SocketHandle s, const SocketAddress& to, const char* data,
+                  size_t size);
+
+/** @brief 接收一个数据报。@return 字节数，没有数据时返回 -1。 */
+long ReceiveDatagram(SocketHandle s, char* buf, size_t size);
+
+/** @brief 打开唤醒套接字：绑定 127.0.0.1 的临时端口并连接到自身。 */
+SocketHandle OpenWakeSocket(std::string& error);
+
+/** @brief 叫醒在 `PollSockets` 中等待唤醒套接字的线程。 */
+void WakeSocket(SocketHandle s);
+
+/** @brief 读空唤醒套接字中积攒的唤醒包。 */
+void DrainWakeSocket(SocketHandle s);
+
+/** @brief `PollSockets` 的一个条目。 */
+struct PollEntry {
+  SocketHandle socket = kInvalidSocket;
+  bool want_write = false;
+  bool readable = false;  ///< 输出：可读（或对端关闭）
+  bool writable = false;  ///< 输出：可写（或连接完成）
+  bool failed = false;    ///< 输出：出错或挂断
+};
+
+/** @brief 等待至多 timeout_ms，直到任一套接字就绪。 */
+void PollSockets(std::vector<PollEntry>& entries, int timeout_ms);
+
+}  // namespace z3y::plugins::net_bridge
@@ -0,0 +1,123 @@
+﻿/**
+ * @file alloc_interposer.cpp
+ * @brief 可选目标 z3y_alloc_interposer：替换全局 operator new / delete，每次分配上报给
+ * z3y::ReportAllocation（Profiler 的 System.Profiler.AllocationTracking 据此按作用域统计）。
+ * * @details
+ * 【面向使用者】
+ * 这是一个 OBJECT 库：只有链接进可执行文件才生效，插件不应链接它。
+ * \code{.cmake}
+ * target_link_libraries(my_host PRIVATE z3y_alloc_interposer)
+ * \endcode
+ * 分配直接转给 malloc / posix_memalign（Windows 为 _aligned_malloc），失败时按标准
+ * 语义循环调用 new_handler。没有安装钩子时每次分配只多一次跨模块调用和一次原子读。
+ * Windows 上每个 DLL 自带 operator new，替换只覆盖可执行文件本身（见 framework/allocation_hook.h）。
+ */
+
+#include <cstdlib>
+#include <new>
+
+#include "framework/allocation_hook.h"
+
+#ifdef _WIN32
+#include <malloc.h>  // _aligned_malloc / _aligned_free
+#endif
+
+namespace {
+
+void* AllocateOrNull(std::size_t size, std::size_t alignment) noexcept {
+  if (size == 0) size = 1;
+  if (alignment <= alignof(std::max_align_t)) return std::malloc(size);
+#ifdef _WIN32
+  return _aligned_malloc(size, alignment);
+#else
+  void* p = nullptr;
+  return posix_memalign(&p, alignment, size) == 0 ? p : nullptr;
+#endif
+}
+
+/** @brief 标准 operator new 的语义：失败时调用 new_handler 重试，没有 handler 时抛出。 */
+void* Allocate(std::size_t size, std::size_t alignment) {
+  z3y::ReportAllocation(size);
+  for (;;) {
+    if (void* p = AllocateOrNull(size, alignment)) return p;
+    std::new_handler handler = std::get_new_handler();
+    if (!handler) throw std::bad_alloc();
+    handler();
+  }
+}
+
+void* AllocateNoThrow(std::size_t size, std::size_t alignment) noexcept {
+  try {
+    return Allocate(size, alignment);
+  } catch (...) {
+    return nullptr;
+  }
+}
+
+void Free(void* p, std::size_t alignment) noexcept {
+#ifdef _WIN32
+  if (alignment > alignof(std::max_align_t)) {
+    _aligned_free(p);
+    return;
+  }
+#else
+  (void)alignment;
+#endif
+  std::free(p);
+}
+
+constexpr std::size_t kDefault = alignof(std::max_align_t);
+
+}  // namespace
+
+// --- 普通分配 ---
+void* operator new(std::size_t size) { return Allocate(size, kDefault); }
+void* operator new[](std::size_t size) { return Allocate(size, kDefault); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+  return AllocateNoThrow(size, kDefault);
+}
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+  return AllocateNoThrow(size, kDefault);
+}
+void operator delete(void* p) noexcept { Free(p, kDefault); }
+void operator delete[](void* p) noexcept { Free(p, kDefault); }
+void operator delete(void* p, std::size_t) noexcept { Free(p, kDefault); }
+void operator delete[](void* p, std::size_t) noexcept { Free(p, kDefault); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { Free(p, kDefault); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { Free(p, kDefault); }
+
+// --- 超对齐分配 (C++17) ---
+void* operator new(std::size_t size, std::align_val_t align) {
+  return Allocate(size, static_cast<std::size_t>(align));
+}
+void* operator new[](std::size_t size, std::align_val_t align) {
+  return Allocate(size, static_cast<std::size_t>(align));
+}
+void* operator new(std::size_t size, std::align_val_t align,
+                   const std::nothrow_t&) noexcept {
+  return AllocateNoThrow(size, static_cast<std::size_t>(align));
+}
+void* operator new[](std::size_t size, std::align_val_t align,
+                     const std::nothrow_t&) noexcept {
+  return AllocateNoThrow(size, static_cast<std::size_t>(align));
+}
+void operator delete(void* p, std::align_val_t align) noexcept {
+  Free(p, static_cast<std::size_t>(align));
+}
+void operator delete[](void* p, std::align_val_t align) noexcept {
+  Free(p, static_cast<std::size_t>(align));
+}
+void operator delete(void* p, std::size_t, std::align_val_t align) noexcept {
+  Free(p, static_cast<std::size_t>(align));
+}
+void operator delete[](void* p, std::size_t, std::align_val_t align) noexcept {
+  Free(p, static_cast<std::size_t>(align));
+}
+void operator delete(void* p, std::align_val_t align,
+                     const std::nothrow_t&) noexcept {
+  Free(p, static_cast<std::size_t>(align));
+}
+void operator delete[](void* p, std::align_val_t align,
+                       const std::nothrow_t&) noexcept {
+  Free(p, static_cast<std::size_t>(align));
+}
@@ -0,0 +1,192 @@
+﻿/**
+ * @file async_frame_table.h
+ * @brief 异步分析流（ASYNC_BEGIN / ATTACH / COMMIT）的帧表。
+ * * @details
+ * 【面向维护者】
+ * 早期实现是一个静态的 `AsyncSlot[1024]`，按 `frame_id % 1024` 线性探测：
+ * 在途帧一多，每次调用都可能扫完 1024 个槽位，且同时在途的帧超过 1024 个就会熔断。
+ * 现在的帧表：
+ * 1. **O(1) 查找**：frame_id 按哈希分到 16 个条带，每个条带一把互斥锁 + 一张哈希表，
+ * 不同帧之间几乎不会争用同一把锁。
+ * 2. **引用计数在锁内增减**：Attach 的“查找 + 持有”与 Commit 的“释放 + 摘除”
+ * 在同一条带锁内完成，不会出现 Worker 挂到一个刚被回收并复用的槽位上。
+ * 3. **有界内存**：槽位按需分配并在池中复用，在途帧数受 `capacity` 约束
+ * （System.Profiler.MaxAsyncFrames），超出时由调用方触发熔断。
+ */
+
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "interfaces_profiler/profiler_types.h"
+
+namespace z3y::plugins::profiler {
+
+/**
+ * @brief 一个异步分析流的槽位。
+ * @details `ref_count` 由帧表在条带锁内维护；其余字段由 Service 访问。
+ */
+struct AsyncSlot {
+  uint64_t frame_id = 0;   ///< 当前服务的帧 ID（受条带锁保护）
+  uint32_t ref_count = 0;  ///< Begin 持有 1 个，每次 Attach 再 +1（受条带锁保护）
+  z3y::interfaces::profiler::AggregatorNode root_node;  ///< 该异步流的专属根节点
+  z3y::interfaces::profiler::ProfileNodeData dynamic_info{
+      nullptr, "", 0,
+      z3y::interfaces::profiler::NodeType::Timer};  ///< 预置的动态元信息
+  uint32_t period = 1;                            ///< 触发报告的次数阈值
+  double sla_ms = 0.0;                            ///< SLA 容忍极限
+  std::atomic_flag shard_lock = ATOMIC_FLAG_INIT;  ///< 保护 shards 链
+  z3y::interfaces::profiler::AggregatorNode* shards =
+      nullptr;  ///< 各 Worker 的影子树根，经 next_sibling 串联
+  /// 帧在途期间摘下的旧代（其他 Worker 可能仍在写入），受 shard_lock 保护，
+  /// 经 next_sibling 串联，在最后一个引用释放时统一回收
+  z3y::interfaces::profiler::AggregatorNode* retired = nullptr;
+};
+
+/**
+ * @brief frame_id -> AsyncSlot 的并发哈希表，附带槽位池。
+ */
+class AsyncFrameTable {
+ public:
+  /** @brief 默认的在途帧上限。 */
+  static constexpr size_t kDefaultCapacity = 65536;
+
+  void SetCapacity(size_t capacity) {
+    capacity_.store(capacity > 0 ? capacity : 1, std::memory_order_relaxed);
+  }
+  size_t GetCapacity() const {
+    return capacity_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief [AsyncBegin] 为 frame_id 分配槽位并持有初始引用。
+   * @param[out] existed 该帧已在途时为 true，此时返回已有槽位且引用计数不变。
+   * @return 槽位；在途帧数达到上限时返回 nullptr。
+   * @details 新槽位的根节点已清空，并在发布到表中之前写好名字与报告参数。
+   */
+  AsyncSlot* Begin(uint64_t frame_id, const char* name, uint32_t period,
+                   double sla_ms, bool* existed) {
+    Stripe& stripe = StripeOf(frame_id);
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+    auto it = stripe.frames.find(frame_id);
+    if (it != stripe.frames.end()) {
+      *existed = true;
+      return it->second;
+    }
+    *existed = false;
+    AsyncSlot* slot = AllocateSlot();
+    if (!slot) return nullptr;
+    slot->frame_id = frame_id;
+    slot->ref_count = 1;
+    slot->root_node.Reset();
+    slot->dynamic_info.name = name;
+    slot->root_node.static_info = &slot->dynamic_info;
+    slot->period = period;
+    slot->sla_ms = sla_ms;
+    stripe.frames.emplace(frame_id, slot);
+    return slot;
+  }
+
+  /** @brief [AsyncAttach] 查找 frame_id 并持有一个引用。帧不存在时返回 nullptr。 */
+  AsyncSlot* Acquire(uint64_t frame_id) {
+    Stripe& stripe = StripeOf(frame_id);
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+    auto it = stripe.frames.find(frame_id);
+    if (it == stripe.frames.end()) return nullptr;
+    ++it->second->ref_count;
+    return it->second;
+  }
+
+  /** @brief 查找 frame_id（不改变引用计数）。调用方须已通过 Begin / Acquire 持有引用。 */
+  AsyncSlot* Find(uint64_t frame_id) {
+    Stripe& stripe = StripeOf(frame_id);
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+    auto it = stripe.frames.find(frame_id);
+    return it == stripe.frames.end() ? nullptr : it->second;
+  }
+
+  /**
+   * @brief [AsyncCommit] 释放一个引用。
+   * @return true 表示这是最后一个引用：槽位已从表中摘除，调用方收尾后必须调用 Recycle。
+   */
+  bool Release(AsyncSlot* slot) {
+    Stripe& stripe = StripeOf(slot->frame_id);
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+    if (slot->ref_count == 0 || --slot->ref_count > 0) return false;
+    stripe.frames.erase(slot->frame_id);
+    return true;
+  }
+
+  /** @brief 把已摘除的槽位归还到池中（其子树必须已被释放）。 */
+  void Recycle(AsyncSlot* slot) {
+    slot->frame_id = 0;
+    slot->shards = nullptr;
+    slot->retired = nullptr;
+    std::lock_guard<std::mutex> lock(pool_mutex_);
+    free_slots_.push_back(slot);
+    live_.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief 摘除全部在途帧（Service 关闭时调用）。
+   * @param on_slot 对每个被摘除的槽位调用一次，用于释放其子树。
+   */
+  template <typename F>
+  void Clear(F&& on_slot) {
+    std::vector<AsyncSlot*> drained;
+    for (Stripe& stripe : stripes_) {
+      std::lock_guard<std::mutex> lock(stripe.mutex);
+      for (auto& entry : stripe.frames) drained.push_back(entry.second);
+      stripe.frames.clear();
+    }
+    for (AsyncSlot* slot : drained) {
+      slot->ref_count = 0;
+      on_slot(*slot);
+      Recycle(slot);
+    }
+  }
+
+ private:
+  static constexpr size_t kStripes = 16;
+
+  struct Stripe {
+    std::mutex mutex;
+    std::unordered_map<uint64_t, AsyncSlot*> frames;
+  };
+
+  Stripe& StripeOf(uint64_t frame_id) {
+    // 斐波那契散列：连续的帧号也能均匀落到各条带
+    return stripes_[(frame_id * 0x9E3779B97F4A7C15ull) >> 60];
+  }
+
+  AsyncSlot* AllocateSlot() {
+    if (live_.fetch_add(1, std::memory_order_relaxed) >= GetCapacity()) {
+      live_.fetch_sub(1, std::memory_order_relaxed);
+      return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(pool_mutex_);
+    if (!free_slots_.empty()) {
+      AsyncSlot* slot = free_slots_.back();
+      free_slots_.pop_back();
+      return slot;
+    }
+    all_slots_.push_back(std::make_unique<AsyncSlot>());
+    return all_slots_.back().get();
+  }
+
+  static_assert((kStripes & (kStripes - 1)) == 0 && kStripes == 16,
+                "StripeOf() takes the top 4 bits of the hash");
+  Stripe stripes_[kStripes];
+  std::atomic<size_t> capacity_{kDefaultCapacity};
+  std::atomic<size_t> live_{0};  ///< 在途帧数
+
+  std::mutex pool_mutex_;
+  std::vector<std::unique_ptr<AsyncSlot>> all_slots_;  ///< 槽位所有权
+  std::vector<AsyncSlot*> free_slots_;
+};
+
+}  // namespace z3y::plugins::profiler
@@ -0,0 +1,158 @@
+﻿/**
+ * @file device_timeline.cpp
+ * @brief DeviceTimeline 的实现。
+ */
+
+#include "device_timeline.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "interfaces_profiler/profiler_clock.h"
+
+namespace z3y::plugins::profiler {
+
+using namespace z3y::interfaces::profiler;
+
+void DeviceTimeline::ReleaseMarkers(Pending& span) {
+  span.source->Release(span.begin_marker);
+  span.source->Release(span.end_marker);
+}
+
+void DeviceTimeline::Submit(std::shared_ptr<IDeviceTimestampSource> source,
+                            ProfileNodeData* data, uint64_t begin_marker,
+                            uint64_t end_marker, uint64_t host_begin_ticks) {
+  Pending span{std::move(source), data, begin_marker, end_marker, host_begin_ticks};
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!stopped_ && queue_.size() + in_flight_ < kMaxPending) {
+      if (!thread_.joinable()) thread_ = std::thread(&DeviceTimeline::Loop, this);
+      const bool was_empty = queue_.empty();
+      queue_.push_back(std::move(span));
+      if (was_empty) wake_cv_.notify_one();
+      return;
+    }
+  }
+  dropped_.fetch_add(1, std::memory_order_relaxed);
+  ReleaseMarkers(span);
+}
+
+size_t DeviceTimeline::Flush(uint32_t timeout_ms) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  idle_cv_.wait_for(lock, std::chrono::milliseconds(timeout_ms),
+                    [this] { return queue_.empty() && in_flight_ == 0; });
+  return queue_.size() + in_flight_;
+}
+
+void DeviceTimeline::Stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stopped_) return;
+    stopped_ = true;
+    wake_cv_.notify_one();
+  }
+  if (thread_.joinable()) thread_.join();
+  std::vector<Pending> abandoned;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    abandoned.swap(queue_);
+  }
+  dropped_.fetch_add(abandoned.size(), std::memory_order_relaxed);
+  for (Pending& span : abandoned) ReleaseMarkers(span);
+  idle_cv_.notify_all();
+}
+
+void DeviceTimeline::Loop() {
+  std::vector<Pending> batch;
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    if (queue_.empty()) {
+      idle_cv_.notify_all();
+      wake_cv_.wait(lock, [this] { return stopped_ || !queue_.empty(); });
+    } else {
+      wake_cv_.wait_for(lock, std::chrono::milliseconds(kPollIntervalMs),
+                        [this] { return stopped_; });
+    }
+    if (stopped_) return;
+
+    batch.swap(queue_);
+    in_flight_ = batch.size();
+    lock.unlock();
+
+    const uint64_t now = ProfilerClock::Now();
+    const double ns_per_tick = 1e6 / ProfilerClock::TicksPerMs();
+    auto keep = batch.begin();
+    for (auto it = batch.begin(); it != batch.end(); ++it) {
+      if (Resolve(*it, now, ns_per_tick)) continue;
+      if (keep != it) *keep = std::move(*it);
+      ++keep;
+    }
+    batch.erase(keep, batch.end());
+
+    lock.lock();
+    // 未解析的排在新提交之前，保持提交顺序
+    batch.insert(batch.end(), std::make_move_iterator(queue_.begin()),
+                 std::make_move_iterator(queue_.end()));
+    queue_.swap(batch);
+    batch.clear();
+    in_flight_ = 0;
+  }
+}
+
+bool DeviceTimeline::Resolve(Pending& span, uint64_t now_ticks, double ns_per_tick) {
+  uint64_t end_ns = 0;
+  if (!span.begin_done) {
+    span.begin_done = span.source->Query(span.begin_marker, &span.begin_ns);
+  }
+  if (!span.begin_done || !span.source->Query(span.end_marker, &end_ns)) {
+    const auto waited_ms =
+        static_cast<double>(now_ticks - span.host_begin_ticks) * ns_per_tick / 1e6;
+    if (now_ticks > span.host_begin_ticks && waited_ms > kResolveTimeoutMs) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      ReleaseMarkers(span);
+      return true;
+    }
+    return false;
+  }
+
+  Device* device = DeviceFor(span.source->DeviceName());
+  const auto host_ns =
+      static_cast<int64_t>(static_cast<double>(span.host_begin_ticks) * ns_per_tick);
+  const int64_t offset = static_cast<int64_t>(span.begin_ns) - host_ns;
+  if (!device->has_offset || offset < device->offset_ns) {
+    device->offset_ns = offset;
+    device->has_offset = true;
+  }
+  const int64_t begin_host_ns = static_cast<int64_t>(span.begin_ns) - device->offset_ns;
+  const uint64_t duration_ns = end_ns > span.begin_ns ? end_ns - span.begin_ns : 0;
+
+  ResolvedDeviceSpan resolved;
+  resolved.device = &device->data;
+  resolved.scope = span.data;
+  resolved.track_id = device->track_id;
+  resolved.begin_ticks = static_cast<uint64_t>(
+      static_cast<double>(std::max<int64_t>(begin_host_ns, 0)) / ns_per_tick);
+  resolved.end_ticks =
+      resolved.begin_ticks + static_cast<uint64_t>(static_cast<double>(duration_ns) / ns_per_tick);
+  ReleaseMarkers(span);
+  handler_(resolved);
+  return true;
+}
+
+DeviceTimeline::Device* DeviceTimeline::DeviceFor(const char* name) {
+  std::string key = name ? name : "";
+  auto it = devices_.find(key);
+  if (it != devices_.end()) return it->second.get();
+  if (devices_.size() >= kMaxDevices) {
+    key = "other";
+    it = devices_.find(key);
+    if (it != devices_.end()) return it->second.get();
+  }
+  auto device = std::make_unique<Device>();
+  device->name = "[Device] " + key;
+  device->data.name = device->name.c_str();  // unique_ptr 持有，地址不变
+  device->track_id = kTrackIdBase + devices_.size();
+  return devices_.emplace(std::move(key), std::move(device)).first->second.get();
+}
+
+}  // namespace z3y::plugins::profiler
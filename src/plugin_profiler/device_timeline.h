@@ -0,0 +1,116 @@
+﻿/**
+ * @file device_timeline.h
+ * @brief 设备区间的异步解析（Z3Y_PROFILE_DEVICE）。
+ * * @details
+ * 【面向维护者】
+ * 设备工作在提交后才执行，作用域结束时它的时间戳还不存在。提交线程只把
+ * (来源, 首尾标记, 主机时刻) 放进待解析队列，由本类的轮询线程反复 Query：
+ * 1. **轮询线程**：首次提交时才启动；队列非空时每 kPollIntervalMs 轮询一次，空闲时睡眠。
+ * Query / Release 在锁外调用，适配器慢也不会挡住提交线程。
+ * 2. **时钟对齐**：同一设备名的来源共享一个偏移估计，取 (设备首时刻 - 提交前的主机时刻)
+ * 的最小值。首标记总在主机时刻之后执行，最小值就是排队最短的那一次，样本越多越接近真实偏移。
+ * 3. **兜底**：待解析超过 kMaxPending 条时丢弃新的提交；超过 kResolveTimeoutMs 仍未完成
+ * （设备复位、队列被销毁）的区间放弃并释放标记。两者都计入 Dropped()。
+ * 4. **设备节点名**：按设备名去重，超过 kMaxDevices 个之后并入 "[Device] other"。
+ */
+
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "interfaces_profiler/profiler_types.h"
+
+namespace z3y::plugins::profiler {
+
+/** @brief 一段已解析的设备区间（时刻已换算到主机 ProfilerClock）。 */
+struct ResolvedDeviceSpan {
+  z3y::interfaces::profiler::ProfileNodeData* device;  ///< 设备节点（名为 "[Device] <设备名>"）
+  z3y::interfaces::profiler::ProfileNodeData* scope;   ///< 作用域的探针
+  uint64_t track_id;     ///< 追踪中设备轨道的线程 ID
+  uint64_t begin_ticks;  ///< 设备开始执行的主机时刻
+  uint64_t end_ticks;    ///< 设备执行结束的主机时刻
+};
+
+/**
+ * @brief 设备区间的待解析队列与轮询线程。由 ProfilerService 持有，所有公有方法线程安全。
+ */
+class DeviceTimeline {
+ public:
+  static constexpr size_t kMaxPending = 65536;       ///< 待解析区间上限
+  static constexpr size_t kMaxDevices = 64;          ///< 不同设备名的上限
+  static constexpr uint32_t kPollIntervalMs = 1;     ///< 有待解析区间时的轮询间隔
+  static constexpr uint32_t kResolveTimeoutMs = 10000;  ///< 放弃一个区间前等待的时间
+  /// 设备轨道的线程 ID 起点：高于 Linux 的 pid_max 上限 (2^22)，不与真实线程重叠
+  static constexpr uint64_t kTrackIdBase = 0xD0000000u;
+
+  using SpanHandler = std::function<void(const ResolvedDeviceSpan&)>;
+
+  /** @param handler 在轮询线程上逐个收到解析完成的区间。 */
+  explicit DeviceTimeline(SpanHandler handler) : handler_(std::move(handler)) {}
+  ~DeviceTimeline() { Stop(); }
+  DeviceTimeline(const DeviceTimeline&) = delete;
+  DeviceTimeline& operator=(const DeviceTimeline&) = delete;
+
+  /** @brief 提交一段区间；队列已满或已停止时立即释放标记并计入 Dropped()。 */
+  void Submit(std::shared_ptr<z3y::interfaces::profiler::IDeviceTimestampSource> source,
+              z3y::interfaces::profiler::ProfileNodeData* data, uint64_t begin_marker,
+              uint64_t end_marker, uint64_t host_begin_ticks);
+
+  /** @brief 等待全部区间解析（或放弃），最多 timeout_ms 毫秒，返回仍未解析的数量。 */
+  size_t Flush(uint32_t timeout_ms);
+
+  /** @brief 停止轮询线程，放弃并释放所有待解析区间。之后的提交直接丢弃。 */
+  void Stop();
+
+  /** @brief 丢弃（队列满 / 超时 / 停止）的区间总数。 */
+  uint64_t Dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+ private:
+  struct Pending {
+    std::shared_ptr<z3y::interfaces::profiler::IDeviceTimestampSource> source;
+    z3y::interfaces::profiler::ProfileNodeData* data;
+    uint64_t begin_marker;
+    uint64_t end_marker;
+    uint64_t host_begin_ticks;
+    uint64_t begin_ns = 0;  ///< 首标记的设备时刻（begin_done 之后有效）
+    bool begin_done = false;
+  };
+  /** @brief 一个设备名。只由轮询线程访问。 */
+  struct Device {
+    std::string name;
+    z3y::interfaces::profiler::ProfileNodeData data{
+        nullptr, "[Device]", 0, z3y::interfaces::profiler::NodeType::Timer};
+    uint64_t track_id = 0;
+    bool has_offset = false;
+    int64_t offset_ns = 0;  ///< 设备时刻 - 主机时刻 的估计
+  };
+
+  void Loop();
+  /** @brief 尝试解析一个区间；完成或放弃时返回 true（标记已释放）。 */
+  bool Resolve(Pending& span, uint64_t now_ticks, double ns_per_tick);
+  Device* DeviceFor(const char* name);
+  static void ReleaseMarkers(Pending& span);
+
+  SpanHandler handler_;
+  std::atomic<uint64_t> dropped_{0};
+
+  std::mutex mutex_;  ///< 保护以下字段
+  std::condition_variable wake_cv_;  ///< 有新提交 / 已停止
+  std::condition_variable idle_cv_;  ///< 队列与轮询中的批次都已清空
+  std::vector<Pending> queue_;
+  size_t in_flight_ = 0;  ///< 轮询线程正在处理的区间数
+  bool stopped_ = false;
+  std::thread thread_;
+
+  std::map<std::string, std::unique_ptr<Device>> devices_;  ///< [轮询线程]
+};
+
+}  // namespace z3y::plugins::profiler
@@ -0,0 +1,109 @@
+﻿/**
+ * @file event_probe_table.h
+ * @brief 事件总线钩子 (System.Profiler.EventBusHook) 使用的动态探针元信息表。
+ * * @details
+ * 【面向维护者】
+ * Z3Y_PROFILE* 的节点名都是字符串字面量，由探针所在模块持有。事件总线的节点
+ * 按 EventId / 订阅者地址在运行时产生，名字只能由 Profiler 自己保存：
+ * 表中的 ProfileNodeData 放在 deque 里（地址稳定），随服务实例一起销毁，
+ * 聚合树上的节点只挂它的裸指针。订阅者地址可能不断变化（临时订阅者），
+ * 数量超过 kMaxProbes 后新的订阅者并入同一个 "[Direct] other" 节点。
+ */
+
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <tuple>
+
+#include "interfaces_profiler/profiler_types.h"
+
+namespace z3y::plugins::profiler {
+
+/** @brief 事件总线节点的种类。 */
+enum class EventProbeKind : uint8_t {
+  Event,      ///< 一个 EventId（同步回调与异步任务耗时之和）
+  Direct,     ///< 某个订阅者的同步 (kDirect) 回调
+  Queued,     ///< 派发线程上的异步任务执行
+  QueueWait,  ///< 异步任务从入队到开始执行的等待
+};
+
+/**
+ * @brief (EventId, 订阅者, 种类) -> ProfileNodeData 的只增表。所有方法线程安全。
+ */
+class EventProbeTable {
+ public:
+  static constexpr size_t kMaxProbes = 4096;  ///< 不同节点的数量上限
+
+  /**
+   * @brief 取得节点的元信息，首次见到时创建。返回的指针在表的生命周期内有效。
+   * @param subscriber 只对 Direct 有意义，其余种类忽略。
+   */
+  z3y::interfaces::profiler::ProfileNodeData* Get(uint64_t event_id,
+                                                  uintptr_t subscriber,
+                                                  EventProbeKind kind) {
+    if (kind != EventProbeKind::Direct) subscriber = 0;
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(Key{event_id, subscriber, kind});
+    if (it != index_.end()) return &it->second->data;
+    if (probes_.size() >= kMaxProbes && kind == EventProbeKind::Direct) {
+      subscriber = kOtherSubscriber;
+      it = index_.find(Key{event_id, subscriber, kind});
+      if (it != index_.end()) return &it->second->data;
+    }
+
+    Probe& probe = probes_.emplace_back();
+    char name[64];
+    switch (kind) {
+      case EventProbeKind::Event:
+        std::snprintf(name, sizeof(name), "Event 0x%016llx",
+                      static_cast<unsigned long long>(event_id));
+        break;
+      case EventProbeKind::Direct:
+        if (subscriber == kOtherSubscriber) {
+          std::snprintf(name, sizeof(name), "[Direct] other");
+        } else {
+          std::snprintf(name, sizeof(name), "[Direct] 0x%llx",
+                        static_cast<unsigned long long>(subscriber));
+        }
+        break;
+      case EventProbeKind::Queued:
+        std::snprintf(name, sizeof(name), "[Queued]");
+        break;
+      case EventProbeKind::QueueWait:
+        std::snprintf(name, sizeof(name), "[QueueWait]");
+        break;
+    }
+    probe.name = name;
+    probe.data.name = probe.name.c_str();  // deque 中的元素不会移动
+    index_.emplace(Key{event_id, subscriber, kind}, &probe);
+    return &probe.data;
+  }
+
+ private:
+  static constexpr uintptr_t kOtherSubscriber = ~uintptr_t{0};
+
+  struct Key {
+    uint64_t event_id;
+    uintptr_t subscriber;
+    EventProbeKind kind;
+    bool operator<(const Key& o) const {
+      return std::tie(event_id, subscriber, kind) <
+             std::tie(o.event_id, o.subscriber, o.kind);
+    }
+  };
+  struct Probe {
+    std::string name;
+    z3y::interfaces::profiler::ProfileNodeData data{
+        nullptr, "[EventBus]", 0, z3y::interfaces::profiler::NodeType::Timer};
+  };
+
+  std::mutex mutex_;
+  std::map<Key, Probe*> index_;
+  std::deque<Probe> probes_;
+};
+
+}  // namespace z3y::plugins::profiler
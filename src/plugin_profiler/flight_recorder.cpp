@@ -0,0 +1,171 @@
+﻿/**
+ * @file flight_recorder.cpp
+ * @brief FlightRecorder 的实现。
+ */
+
+#include "flight_recorder.h"
+
+#include <algorithm>
+#include <functional>
+#include <thread>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#elif defined(__linux__)
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "interfaces_profiler/profiler_clock.h"
+
+namespace z3y::plugins::profiler {
+
+using namespace z3y::interfaces::profiler;
+
+namespace {
+
+/** @brief 当前线程的系统线程 ID（与追踪事件的一致）。 */
+uint64_t CurrentThreadId() {
+#ifdef _WIN32
+  return static_cast<uint64_t>(GetCurrentThreadId());
+#elif defined(__linux__)
+  return static_cast<uint64_t>(syscall(SYS_gettid));
+#else
+  return static_cast<uint64_t>(
+      std::hash<std::thread::id>()(std::this_thread::get_id()));
+#endif
+}
+
+}  // namespace
+
+void FlightRecorder::SetRingSize(size_t records) {
+  if (records > kMaxRingSize) records = kMaxRingSize;
+  size_t capacity = 0;
+  if (records) {
+    capacity = 1;
+    while (capacity < records) capacity <<= 1;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (capacity == ring_size_) return;
+  for (auto& ring : rings_) retired_.push_back(std::move(ring));
+  rings_.clear();
+  ring_size_ = capacity;
+  session_.store(capacity ? ++last_session_ : 0, std::memory_order_release);
+}
+
+void FlightRecorder::SetWindowMs(uint32_t window_ms) {
+  window_ms_.store(window_ms, std::memory_order_relaxed);
+}
+
+void FlightRecorder::Acquire(ProfilerThreadState* state) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const uint64_t session = session_.load(std::memory_order_relaxed);
+  state->flight_ring_session = session;
+  state->flight_ring = nullptr;
+  if (session == 0) return;
+
+  Ring* slot = nullptr;
+  for (auto& ring : rings_) {
+    if (ring->exited) {
+      slot = ring.get();
+      break;
+    }
+  }
+  if (slot) {
+    // 复用已退出线程的环：旧记录随之作废
+    slot->ring.claimed.store(0, std::memory_order_relaxed);
+    slot->ring.published.store(0, std::memory_order_relaxed);
+  } else {
+    auto fresh = std::make_unique<Ring>();
+    fresh->storage = std::make_unique<FlightRing::Record[]>(ring_size_);
+    fresh->ring.records = fresh->storage.get();
+    fresh->ring.mask = ring_size_ - 1;
+    slot = fresh.get();
+    rings_.push_back(std::move(fresh));
+  }
+  slot->exited = false;
+  slot->thread_id = CurrentThreadId();
+  state->flight_ring = &slot->ring;
+}
+
+void FlightRecorder::Release(ProfilerThreadState* state) {
+  if (!state->flight_ring) return;
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto& ring : rings_) {
+    if (&ring->ring == state->flight_ring) ring->exited = true;
+  }
+  state->flight_ring = nullptr;
+}
+
+bool FlightRecorder::Freeze(const std::string& reason, bool automatic, size_t* events) {
+  const uint64_t now = ProfilerClock::Now();
+  const double ticks_per_ms = ProfilerClock::TicksPerMs();
+  const uint32_t window_ms = window_ms_.load(std::memory_order_relaxed);
+  const auto window = static_cast<uint64_t>(window_ms * ticks_per_ms);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (session_.load(std::memory_order_relaxed) == 0) return false;
+  if (automatic) {
+    if (last_auto_ticks_ != 0 && now - last_auto_ticks_ < window) return false;
+    last_auto_ticks_ = now;
+  }
+
+  FlightRecording recording;
+  recording.sequence = ++sequence_;
+  recording.reason = reason;
+  recording.window_ms = window_ms;
+  const uint64_t from = now > window ? now - window : 0;
+  const double us_per_tick = 1000.0 / ticks_per_ms;
+  const uint64_t capacity = ring_size_;
+  std::vector<std::pair<uint64_t, uintptr_t>> copy;
+  for (const auto& slot : rings_) {
+    const FlightRing& ring = slot->ring;
+    const uint64_t published = ring.published.load(std::memory_order_acquire);
+    const uint64_t begin = published > capacity ? published - capacity : 0;
+    copy.clear();
+    for (uint64_t i = begin; i < published; ++i) {
+      const FlightRing::Record& record = ring.records[i & ring.mask];
+      copy.emplace_back(record.ticks.load(std::memory_order_relaxed),
+                        record.word.load(std::memory_order_relaxed));
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const uint64_t claimed = ring.claimed.load(std::memory_order_relaxed);
+    // 序号不大于 claimed - capacity 的槽位可能已被新记录覆盖
+    const uint64_t valid = claimed > capacity ? claimed - capacity : 0;
+    const uint64_t first = std::max(begin, valid);
+    recording.trace.overwritten += first - begin;
+    for (uint64_t i = first; i < published; ++i) {
+      const auto& [ticks, word] = copy[i - begin];
+      if (ticks < from || ticks > now) continue;
+      const auto* data = reinterpret_cast<const ProfileNodeData*>(word & ~uintptr_t{1});
+      TraceEvent e;
+      e.timestamp_us = static_cast<double>(ticks - from) * us_per_tick;
+      e.thread_id = slot->thread_id;
+      e.phase = (word & 1u) ? TracePhase::ScopeBegin : TracePhase::ScopeEnd;
+      e.name = data && data->name ? data->name : "";
+      recording.trace.events.push_back(std::move(e));
+    }
+  }
+  // 各线程内部已有序；稳定排序保证同一时刻的退出仍排在随后的进入之前
+  std::stable_sort(recording.trace.events.begin(), recording.trace.events.end(),
+                   [](const TraceEvent& a, const TraceEvent& b) {
+                     return a.timestamp_us < b.timestamp_us;
+                   });
+  if (events) *events = recording.trace.events.size();
+  recordings_.push_back(std::move(recording));
+  if (recordings_.size() > kMaxRecordings) recordings_.pop_front();
+  return true;
+}
+
+std::vector<FlightRecording> FlightRecorder::Take() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<FlightRecording> taken(std::make_move_iterator(recordings_.begin()),
+                                     std::make_move_iterator(recordings_.end()));
+  recordings_.clear();
+  return taken;
+}
+
+}  // namespace z3y::plugins::profiler
@@ -0,0 +1,88 @@
+﻿/**
+ * @file flight_recorder.h
+ * @brief 飞行记录器（System.Profiler.FlightRecorderRingSize / FlightRecorderWindowMs）。
+ * * @details
+ * 【面向维护者】
+ * 聚合树只告诉你超时那一刻的累计值，看不到超时前各线程在做什么。飞行记录器让每个探针
+ * 作用域在进入 / 退出时往本线程的环里写一条 16 字节的记录（见 FlightRing），平时不落盘，
+ * 也不做任何格式化；SLA 超时或显式调用 Freeze 时才把最近一个窗口的记录拷贝出来：
+ * 1. **环的归属**：环由本类分配并登记，线程状态里只存裸指针。容量变化 / 关闭都开启新会话，
+ * 旧会话的环移入 retired_ 保留到析构——写入方在看到新会话号之前可能仍在写旧环。
+ * 2. **线程退出**：环标记为 exited，数据仍可被冻结，直到被同一会话中的新线程复用。
+ * 3. **冻结**：持 mutex_ 逐个拷贝环，按 published / claimed 剔除拷贝期间被覆盖的记录，
+ * 探针名在冻结时解析（与报告相同，要求探针所在模块仍已加载）。自动冻结每个窗口至多一次，
+ * 连续超时不会反复拷贝。
+ */
+
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "interfaces_profiler/profiler_report.h"
+#include "interfaces_profiler/profiler_types.h"
+
+namespace z3y::plugins::profiler {
+
+/**
+ * @brief 飞行记录器。由 ProfilerService 持有，所有公有方法线程安全。
+ */
+class FlightRecorder {
+ public:
+  static constexpr size_t kMaxRingSize = 1u << 22;  ///< 每线程记录数上限（64MB）
+  static constexpr size_t kMaxRecordings = 8;       ///< 保留的冻结结果数
+
+  FlightRecorder() = default;
+  FlightRecorder(const FlightRecorder&) = delete;
+  FlightRecorder& operator=(const FlightRecorder&) = delete;
+
+  /** @brief 每线程的记录数（向上取 2 的幂），0 表示关闭。容量变化时开启新会话。 */
+  void SetRingSize(size_t records);
+  /** @brief 冻结的时间窗口（毫秒）。 */
+  void SetWindowMs(uint32_t window_ms);
+
+  /** @brief 当前会话号（0 表示关闭），线程状态保存它的地址。 */
+  const std::atomic<uint64_t>* Session() const { return &session_; }
+
+  /** @brief 为调用线程分配（或复用）当前会话的环，写入 state。 */
+  void Acquire(z3y::interfaces::profiler::ProfilerThreadState* state);
+  /** @brief 线程退出：它的环留给后来的线程复用。 */
+  void Release(z3y::interfaces::profiler::ProfilerThreadState* state);
+
+  /**
+   * @brief 冻结最近一个窗口的记录。
+   * @param automatic 为 true 时（SLA 超时）距上一次自动冻结不足一个窗口则跳过。
+   * @param[out] events 冻结到的事件数（可为空）。
+   * @return 是否产生了一份记录。
+   */
+  bool Freeze(const std::string& reason, bool automatic, size_t* events = nullptr);
+
+  /** @brief 取走已冻结的记录。 */
+  std::vector<z3y::interfaces::profiler::FlightRecording> Take();
+
+ private:
+  struct Ring {
+    z3y::interfaces::profiler::FlightRing ring;
+    std::unique_ptr<z3y::interfaces::profiler::FlightRing::Record[]> storage;
+    uint64_t thread_id = 0;
+    bool exited = false;
+  };
+
+  std::atomic<uint64_t> session_{0};
+  std::atomic<uint32_t> window_ms_{2000};
+
+  std::mutex mutex_;  ///< 保护以下全部成员
+  uint64_t last_session_ = 0;
+  size_t ring_size_ = 0;
+  uint64_t last_auto_ticks_ = 0;
+  uint64_t sequence_ = 0;
+  std::vector<std::unique_ptr<Ring>> rings_;    ///< 当前会话
+  std::vector<std::unique_ptr<Ring>> retired_;  ///< 旧会话，保留到析构
+  std::deque<z3y::interfaces::profiler::FlightRecording> recordings_;
+};
+
+}  // namespace z3y::plugins::profiler
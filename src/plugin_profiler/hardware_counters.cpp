@@ -0,0 +1,119 @@
+﻿/**
+ * @file hardware_counters.cpp
+ * @brief HardwareCounterGroup 的实现（Linux perf_event）。
+ */
+
+#include "hardware_counters.h"
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cstring>
+#endif
+
+namespace z3y::plugins::profiler {
+
+using namespace z3y::interfaces::profiler;
+
+#if defined(__linux__)
+
+namespace {
+
+/** @brief 按 HardwareCounter 下标排列的 perf 通用硬件事件。 */
+constexpr uint64_t kPerfEvents[kHardwareCounterCount] = {
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_BRANCH_MISSES,
+};
+
+int OpenEvent(uint64_t config, int group_fd) {
+  perf_event_attr attr;
+  std::memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.config = config;
+  attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_ID |
+                     PERF_FORMAT_TOTAL_TIME_ENABLED |
+                     PERF_FORMAT_TOTAL_TIME_RUNNING;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  // pid = 0, cpu = -1：只统计调用线程，随线程在任意 CPU 上运行
+  return static_cast<int>(
+      syscall(__NR_perf_event_open, &attr, 0, -1, group_fd, PERF_FLAG_FD_CLOEXEC));
+}
+
+}  // namespace
+
+HardwareCounterGroup::~HardwareCounterGroup() {
+  for (int fd : fds_) {
+    if (fd >= 0) close(fd);
+  }
+}
+
+bool HardwareCounterGroup::Open() {
+  fds_[0] = OpenEvent(kPerfEvents[0], -1);
+  if (fds_[0] < 0) return false;
+  for (size_t i = 1; i < kHardwareCounterCount; ++i) {
+    fds_[i] = OpenEvent(kPerfEvents[i], fds_[0]);  // 失败时该项恒为 0
+  }
+  for (size_t i = 0; i < kHardwareCounterCount; ++i) {
+    if (fds_[i] >= 0 && ioctl(fds_[i], PERF_EVENT_IOC_ID, &ids_[i]) != 0) {
+      close(fds_[i]);
+      fds_[i] = -1;
+    }
+  }
+  return fds_[0] >= 0;
+}
+
+bool HardwareCounterGroup::Read(HardwareCounterSample& out) {
+  if (state_ == State::kUnopened) {
+    state_ = Open() ? State::kOpen : State::kUnavailable;
+  }
+  if (state_ != State::kOpen) return false;
+
+  // PERF_FORMAT_GROUP 的布局：nr, time_enabled, time_running, {value, id} * nr
+  uint64_t buffer[3 + 2 * kHardwareCounterCount];
+  const ssize_t bytes = read(fds_[0], buffer, sizeof(buffer));
+  if (bytes < static_cast<ssize_t>(3 * sizeof(uint64_t))) return false;
+  const uint64_t count = buffer[0];
+  const uint64_t enabled = buffer[1];
+  const uint64_t running = buffer[2];
+
+  out.fill(0);
+  for (uint64_t e = 0; e < count && e < kHardwareCounterCount; ++e) {
+    uint64_t value = buffer[3 + 2 * e];
+    const uint64_t id = buffer[4 + 2 * e];
+    // 组被多路复用时只运行了 running / enabled 的时间，按比例外推
+    if (running > 0 && running < enabled) {
+      value = static_cast<uint64_t>(static_cast<double>(value) *
+                                    static_cast<double>(enabled) /
+                                    static_cast<double>(running));
+    }
+    for (size_t i = 0; i < kHardwareCounterCount; ++i) {
+      if (fds_[i] >= 0 && ids_[i] == id) {
+        out[i] = value;
+        break;
+      }
+    }
+  }
+  return true;
+}
+
+#else  // !__linux__
+
+HardwareCounterGroup::~HardwareCounterGroup() = default;
+
+bool HardwareCounterGroup::Open() { return false; }
+
+bool HardwareCounterGroup::Read(HardwareCounterSample& out) {
+  out.fill(0);
+  return false;
+}
+
+#endif
+
+}  // namespace z3y::plugins::profiler
@@ -0,0 +1,47 @@
+﻿/**
+ * @file hardware_counters.h
+ * @brief 每线程一组的硬件性能计数器（System.Profiler.HardwareCounters）。
+ * * @details
+ * 【面向维护者】
+ * 只看墙钟时间分不清视觉算子的退化来自缓存未命中还是分支预测失败。
+ * 开启后 Z3Y_PROFILE_ROOT 在作用域两端各读一次本线程的计数器组，增量累加到根节点：
+ * 1. **Linux**：`perf_event_open` 打开一个事件组（指令数为组长，另加周期、LLC 未命中、
+ * 分支预测失败），只统计本线程的用户态。一次 `read` 取回整组，并按
+ * time_enabled / time_running 校正内核多路复用造成的缺口。
+ * 单个事件不被硬件支持（常见于虚拟机）时该项恒为 0，组长打不开时整组不可用。
+ * 2. **其他平台**：暂不支持，`Read` 恒返回 false。
+ * 计数器组按线程惰性打开；打开失败会被记住，不会在每个作用域重试系统调用。
+ */
+
+#pragma once
+#include "interfaces_profiler/profiler_types.h"
+
+namespace z3y::plugins::profiler {
+
+/**
+ * @brief 当前线程的硬件计数器组。以 thread_local 持有，不可跨线程使用。
+ */
+class HardwareCounterGroup {
+ public:
+  HardwareCounterGroup() = default;
+  ~HardwareCounterGroup();
+  HardwareCounterGroup(const HardwareCounterGroup&) = delete;
+  HardwareCounterGroup& operator=(const HardwareCounterGroup&) = delete;
+
+  /**
+   * @brief 读取本线程自计数器组打开以来的累计值（首次调用时打开）。
+   * @return false 表示平台不支持或没有权限（如 perf_event_paranoid 限制）。
+   */
+  bool Read(z3y::interfaces::profiler::HardwareCounterSample& out);
+
+ private:
+  enum class State { kUnopened, kOpen, kUnavailable };
+
+  bool Open();
+
+  State state_ = State::kUnopened;
+  int fds_[z3y::interfaces::profiler::kHardwareCounterCount] = {-1, -1, -1, -1};
+  uint64_t ids_[z3y::interfaces::profiler::kHardwareCounterCount] = {};
+};
+
+}  // namespace z3y::plugins::profiler
@@ -0,0 +1,250 @@
+﻿/**
+ * @file keyed_root_table.h
+ * @brief 分组根节点 (Z3Y_PROFILE_ROOT_KEYED) 的 (探针, 键) -> 独立根节点表。
+ * * @details
+ * 【面向维护者】
+ * 同一个 ROOT 调用点按业务键（配方号、相机通道……）拆成多棵独立的树，每个键一个共享根，
+ * 所有线程写入同一棵树（与事件总线根相同，不是线程独占的影子树）：
+ * 1. **无锁查找**：`TryPin` 先查按 (site, key) 哈希的提示数组，未命中再线性扫描
+ * 已用过的槽位；命中后登记为写入者 (pins +1) 再复核 site / key，全程不加锁。
+ * 2. **写入者计数即淘汰栅栏**：淘汰者把 pins 从 0 CAS 成 kEvicting 后独占槽位；
+ * 之后的 TryPin 看到 kEvicting 会撤回自己的 +1。淘汰结束时减去 kEvicting 而不是清零，
+ * 这些撤回中的 +1 / -1 才能配平。
+ * 3. **有界 + LRU**：在用的键数受 `capacity` 约束（System.Profiler.KeyedRootCapacity），
+ * 新键到来而表已满时淘汰最久未用 (`last_used`) 且当前没有写入者的键；
+ * 每个键都正被使用时新键不记录。插入与淘汰由一把互斥锁串行化，只在未命中时进入。
+ * 4. **槽位数组一次分配**：首次使用时按 kMaxEntries 分配并发布，之后地址不变；
+ * 未使用该功能的进程不付出这部分内存。
+ */
+
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+#include "async_frame_table.h"
+#include "interfaces_profiler/profiler_types.h"
+
+namespace z3y::plugins::profiler {
+
+/**
+ * @brief 一个分组根：键 + 共享根节点（复用 AsyncSlot 的根节点、名字与旧代链）。
+ * @details site / key 只在淘汰者独占槽位时改写；name 是 slot.dynamic_info.name 的存储。
+ */
+struct KeyedRoot {
+  std::atomic<uintptr_t> site{0};      ///< 调用点的 ProfileNodeData 地址，0 表示空闲
+  std::atomic<uint64_t> key{0};        ///< 业务键
+  std::atomic<uint64_t> pins{0};       ///< 正在写入的作用域数；>= kEvicting 表示正被淘汰
+  std::atomic<uint64_t> last_used{0};  ///< 最近一次进入的时刻 (ProfilerClock tick)，供 LRU
+  AsyncSlot slot;
+  char name[64] = {};
+};
+
+/**
+ * @brief 分组根表。所有公有方法线程安全。
+ */
+class KeyedRootTable {
+ public:
+  static constexpr size_t kMaxEntries = 256;             ///< 槽位数（也是 capacity 的上限）
+  static constexpr size_t kDefaultCapacity = 64;         ///< 默认同时存在的键数
+  static constexpr uint64_t kEvicting = uint64_t{1} << 62;
+
+  void SetCapacity(size_t capacity) {
+    if (capacity < 1) capacity = 1;
+    if (capacity > kMaxEntries) capacity = kMaxEntries;
+    capacity_.store(capacity, std::memory_order_relaxed);
+  }
+
+  /** @brief 按句柄（BeginKeyedRoot 返回的下标）取得槽位。调用方须持有该槽位的 pin。 */
+  KeyedRoot& At(uint32_t handle) {
+    return entries_.load(std::memory_order_acquire)[handle];
+  }
+
+  /** @brief 无锁查找 (site, key)，命中时已登记为写入者。 */
+  KeyedRoot* TryPin(uintptr_t site, uint64_t key, uint32_t* handle) {
+    KeyedRoot* entries = entries_.load(std::memory_order_acquire);
+    if (!entries) return nullptr;
+    auto& hint = hints_[HintOf(site, key)];
+    const uint32_t hinted = hint.load(std::memory_order_relaxed);
+    if (hinted && Pin(entries[hinted - 1], site, key)) {
+      *handle = hinted - 1;
+      return &entries[hinted - 1];
+    }
+    const size_t used = used_.load(std::memory_order_acquire);
+    for (uint32_t i = 0; i < used; ++i) {
+      if (Pin(entries[i], site, key)) {
+        hint.store(i + 1, std::memory_order_relaxed);
+        *handle = i;
+        return &entries[i];
+      }
+    }
+    return nullptr;
+  }
+
+  /**
+   * @brief 为 (site, key) 分配一个槽位并登记为写入者（TryPin 未命中后调用）。
+   * @param on_evict 对被淘汰的槽位调用一次（此时独占，无任何写入者），用于输出并释放它的树。
+   * @param on_assign 在槽位发布前调用一次，用于写入名字与元信息。
+   * @return nullptr 表示表已满且每个键都正被使用。
+   */
+  template <typename Evict, typename Assign>
+  KeyedRoot* Insert(uintptr_t site, uint64_t key, uint32_t* handle,
+                    Evict&& on_evict, Assign&& on_assign) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    KeyedRoot* entries = entries_.load(std::memory_order_relaxed);
+    if (!entries) {
+      storage_ = std::make_unique<KeyedRoot[]>(kMaxEntries);
+      entries = storage_.get();
+      entries_.store(entries, std::memory_order_release);
+    }
+    // 等锁期间别的线程可能已经插入了同一个键
+    if (KeyedRoot* hit = TryPin(site, key, handle)) return hit;
+
+    const size_t capacity = capacity_.load(std::memory_order_relaxed);
+    while (live_ >= capacity) {
+      if (!EvictLeastRecent(entries, on_evict)) return nullptr;
+    }
+    KeyedRoot* target = nullptr;
+    const size_t used = used_.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < used && !target; ++i) {
+      if (entries[i].site.load(std::memory_order_relaxed) == 0) target = &entries[i];
+    }
+    if (!target) {
+      target = &entries[used];  // live_ < capacity <= kMaxEntries，必有空位
+      used_.store(used + 1, std::memory_order_release);
+    }
+    on_assign(*target);
+    target->key.store(key, std::memory_order_relaxed);
+    target->pins.fetch_add(1, std::memory_order_seq_cst);
+    target->site.store(site, std::memory_order_release);  // 最后发布
+    ++live_;
+    *handle = static_cast<uint32_t>(target - entries);
+    hints_[HintOf(site, key)].store(*handle + 1, std::memory_order_relaxed);
+    return target;
+  }
+
+  /** @brief 注销写入者。@return 注销后的写入者数。 */
+  static uint64_t Unpin(KeyedRoot& entry) {
+    return entry.pins.fetch_sub(1, std::memory_order_seq_cst) - 1;
+  }
+
+  /** @brief 当前在用的键数。 */
+  size_t Live() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return live_;
+  }
+
+  /** @brief 累计被淘汰的键数。 */
+  uint64_t Evictions() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return evictions_;
+  }
+
+  /**
+   * @brief 对每个在用的槽位调用 fn（依次登记为写入者，调用期间不会被淘汰）。
+   */
+  template <typename F>
+  void ForEachLive(F&& fn) {
+    KeyedRoot* entries = entries_.load(std::memory_order_acquire);
+    if (!entries) return;
+    const size_t used = used_.load(std::memory_order_acquire);
+    for (size_t i = 0; i < used; ++i) {
+      KeyedRoot& entry = entries[i];
+      const uintptr_t site = entry.site.load(std::memory_order_acquire);
+      if (!site || !Pin(entry, site, entry.key.load(std::memory_order_acquire))) {
+        continue;
+      }
+      fn(entry);
+      Unpin(entry);
+    }
+  }
+
+  /**
+   * @brief 清空全部键（Service 关闭时调用）。
+   * @param on_entry 对每个在用的槽位调用一次，用于释放其树。
+   */
+  template <typename F>
+  void Clear(F&& on_entry) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    KeyedRoot* entries = entries_.load(std::memory_order_relaxed);
+    if (!entries) return;
+    const size_t used = used_.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < used; ++i) {
+      if (entries[i].site.load(std::memory_order_relaxed) == 0) continue;
+      on_entry(entries[i]);
+      entries[i].site.store(0, std::memory_order_release);
+    }
+    for (auto& hint : hints_) hint.store(0, std::memory_order_relaxed);
+    live_ = 0;
+  }
+
+ private:
+  static constexpr size_t kHintSize = 512;  ///< 提示数组大小（2 的幂）
+
+  static size_t HintOf(uintptr_t site, uint64_t key) {
+    const uint64_t h = (static_cast<uint64_t>(site) >> 3) ^ (key * 0x9E3779B97F4A7C15ull);
+    return static_cast<size_t>(h ^ (h >> 29)) & (kHintSize - 1);
+  }
+
+  /** @brief 若槽位当前属于 (site, key)，登记为写入者并返回 true。 */
+  static bool Pin(KeyedRoot& entry, uintptr_t site, uint64_t key) {
+    if (entry.site.load(std::memory_order_acquire) != site ||
+        entry.key.load(std::memory_order_acquire) != key) {
+      return false;
+    }
+    const uint64_t before = entry.pins.fetch_add(1, std::memory_order_seq_cst);
+    // 复核：检查与 +1 之间槽位可能已被淘汰并分给了别的键
+    if (before >= kEvicting || entry.site.load(std::memory_order_acquire) != site ||
+        entry.key.load(std::memory_order_acquire) != key) {
+      entry.pins.fetch_sub(1, std::memory_order_seq_cst);
+      return false;
+    }
+    return true;
+  }
+
+  /** @brief 淘汰最久未用且没有写入者的键（调用方持有 mutex_）。 */
+  template <typename Evict>
+  bool EvictLeastRecent(KeyedRoot* entries, Evict& on_evict) {
+    const size_t used = used_.load(std::memory_order_relaxed);
+    for (;;) {
+      KeyedRoot* victim = nullptr;
+      for (size_t i = 0; i < used; ++i) {
+        KeyedRoot& e = entries[i];
+        if (e.site.load(std::memory_order_relaxed) == 0 ||
+            e.pins.load(std::memory_order_relaxed) != 0) {
+          continue;
+        }
+        if (!victim || e.last_used.load(std::memory_order_relaxed) <
+                           victim->last_used.load(std::memory_order_relaxed)) {
+          victim = &e;
+        }
+      }
+      if (!victim) return false;
+      uint64_t idle = 0;
+      if (!victim->pins.compare_exchange_strong(idle, kEvicting,
+                                                std::memory_order_seq_cst)) {
+        continue;  // 刚好有写入者进入：重新挑选
+      }
+      on_evict(*victim);
+      victim->site.store(0, std::memory_order_release);
+      victim->key.store(0, std::memory_order_relaxed);
+      victim->pins.fetch_sub(kEvicting, std::memory_order_seq_cst);
+      --live_;
+      ++evictions_;
+      return true;
+    }
+  }
+
+  std::atomic<size_t> capacity_{kDefaultCapacity};
+  std::atomic<KeyedRoot*> entries_{nullptr};  ///< 发布后不变
+  std::atomic<size_t> used_{0};  ///< entries_[0, used_) 至少被分配过一次（只增）
+  std::atomic<uint32_t> hints_[kHintSize]{};  ///< (site, key) 哈希 -> 下标 + 1，只是提示
+
+  mutable std::mutex mutex_;  ///< 串行化插入 / 淘汰 / 清空，保护以下字段
+  std::unique_ptr<KeyedRoot[]> storage_;
+  size_t live_ = 0;
+  uint64_t evictions_ = 0;
+};
+
+}  // namespace z3y::plugins::profiler
@@ -0,0 +1,176 @@
+﻿/**
+ * @file lock_probe_table.h
+ * @brief 锁竞争钩子 (System.Profiler.LockContention) 使用的 (锁, 调用点) 统计表。
+ * * @details
+ * 【面向维护者】
+ * 框架的 ProfiledMutex 每次加锁上报一条 LockContentionSample：锁名是声明处的字符串
+ * 字面量，调用点是 lock() 的返回地址。两者都可能随插件卸载失效，表在第一次见到时
+ * 把锁名拷贝出来；调用点只保存地址，节点名用十六进制地址，符号在 Snapshot 时才解析——
+ * 钩子可能在持有共享锁时被调用，此时调用 dladdr 可能与正在 dlopen 的线程死锁。
+ * 每项同时保存累计计数（供排名报告，从不清零）与三个 ProfileNodeData（供聚合树）：
+ * Locks → 锁名 → [Wait] / [Hold] 调用点。不同调用点超过 kMaxSites 后并入调用点 0。
+ */
+
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "interfaces_profiler/profiler_report.h"
+#include "interfaces_profiler/profiler_types.h"
+#include "sampling_profiler.h"  // ResolveAddress
+
+namespace z3y::plugins::profiler {
+
+/**
+ * @brief (锁名地址, 调用点) -> 统计项的只增表。所有方法线程安全。
+ */
+class LockProbeTable {
+ public:
+  static constexpr size_t kMaxSites = 4096;  ///< 不同 (锁, 调用点) 的数量上限
+
+  /** @brief 一把锁在一个调用点上的统计与节点元信息。 */
+  struct Site {
+    z3y::interfaces::profiler::ProfileNodeData* lock_data = nullptr;  ///< 锁名节点（同名锁共用）
+    uintptr_t call_site = 0;
+    std::string wait_name;
+    std::string hold_name;
+    z3y::interfaces::profiler::ProfileNodeData wait_data{
+        nullptr, "[Locks]", 0, z3y::interfaces::profiler::NodeType::Timer};
+    z3y::interfaces::profiler::ProfileNodeData hold_data{
+        nullptr, "[Locks]", 0, z3y::interfaces::profiler::NodeType::Timer};
+    std::atomic<uint64_t> acquisitions{0};
+    std::atomic<uint64_t> contended{0};
+    std::atomic<uint64_t> wait_ns{0};
+    std::atomic<uint64_t> max_wait_ns{0};
+    std::atomic<uint64_t> hold_ns{0};
+    std::atomic<uint64_t> max_hold_ns{0};
+
+    /** @brief 累计一次加锁。 */
+    void Record(uint64_t wait, uint64_t hold, bool was_contended) {
+      acquisitions.fetch_add(1, std::memory_order_relaxed);
+      if (was_contended) contended.fetch_add(1, std::memory_order_relaxed);
+      wait_ns.fetch_add(wait, std::memory_order_relaxed);
+      hold_ns.fetch_add(hold, std::memory_order_relaxed);
+      UpdateMax(max_wait_ns, wait);
+      UpdateMax(max_hold_ns, hold);
+    }
+  };
+
+  /** @brief 取得 (锁, 调用点) 的统计项，首次见到时创建。返回的指针在表的生命周期内有效。 */
+  Site* Get(const char* lock_name, const void* call_site) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(Key{lock_name, call_site});
+    if (it != index_.end()) return it->second;
+    if (sites_.size() >= kMaxSites) {
+      call_site = nullptr;
+      it = index_.find(Key{lock_name, call_site});
+      if (it != index_.end()) return it->second;
+    }
+
+    // 同名锁（例如插件重新加载后字面量地址变了）共用一个锁名节点
+    std::string name = lock_name ? lock_name : "(unnamed)";
+    auto lock_it = locks_.find(name);
+    if (lock_it == locks_.end()) {
+      LockNode& node = lock_nodes_.emplace_back();
+      node.name = name;
+      node.data.name = node.name.c_str();  // deque 中的元素不会移动
+      lock_it = locks_.emplace(name, &node.data).first;
+    }
+
+    Site& site = sites_.emplace_back();
+    site.lock_data = lock_it->second;
+    site.call_site = reinterpret_cast<uintptr_t>(call_site);
+    char buffer[48];
+    std::snprintf(buffer, sizeof(buffer), "[Wait] 0x%llx",
+                  static_cast<unsigned long long>(site.call_site));
+    site.wait_name = buffer;
+    std::snprintf(buffer, sizeof(buffer), "[Hold] 0x%llx",
+                  static_cast<unsigned long long>(site.call_site));
+    site.hold_name = buffer;
+    site.wait_data.name = site.wait_name.c_str();
+    site.hold_data.name = site.hold_name.c_str();
+    index_.emplace(Key{lock_name, call_site}, &site);
+    return &site;
+  }
+
+  /**
+   * @brief 按累计等待时间降序排名，解析调用点符号。
+   * @param max_entries 最多返回的条目数，0 表示不限。
+   */
+  std::vector<z3y::interfaces::profiler::LockContentionEntry> Snapshot(
+      size_t max_entries) const {
+    struct Row {
+      const Site* site;
+      uint64_t wait_ns;
+    };
+    std::vector<Row> rows;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      rows.reserve(sites_.size());
+      for (const Site& site : sites_) {
+        if (site.acquisitions.load(std::memory_order_relaxed) == 0) continue;
+        rows.push_back({&site, site.wait_ns.load(std::memory_order_relaxed)});
+      }
+    }
+    // 表只增不删，锁外读取已登记的项是安全的；解析可能较慢，不在锁内进行
+    std::sort(rows.begin(), rows.end(),
+              [](const Row& a, const Row& b) { return a.wait_ns > b.wait_ns; });
+    if (max_entries != 0 && rows.size() > max_entries) rows.resize(max_entries);
+
+    std::vector<z3y::interfaces::profiler::LockContentionEntry> entries;
+    entries.reserve(rows.size());
+    for (const Row& row : rows) {
+      const Site& site = *row.site;
+      auto& entry = entries.emplace_back();
+      entry.lock_name = site.lock_data->name;
+      if (site.call_site != 0) {
+        ResolvedAddress where = ResolveAddress(site.call_site);
+        entry.module = std::move(where.module);
+        entry.symbol = std::move(where.symbol);
+      } else {
+        entry.symbol = "(other)";
+      }
+      entry.acquisitions = site.acquisitions.load(std::memory_order_relaxed);
+      entry.contended = site.contended.load(std::memory_order_relaxed);
+      entry.total_wait_ms = static_cast<double>(row.wait_ns) / 1e6;
+      entry.max_wait_ms =
+          static_cast<double>(site.max_wait_ns.load(std::memory_order_relaxed)) / 1e6;
+      entry.total_hold_ms =
+          static_cast<double>(site.hold_ns.load(std::memory_order_relaxed)) / 1e6;
+      entry.max_hold_ms =
+          static_cast<double>(site.max_hold_ns.load(std::memory_order_relaxed)) / 1e6;
+    }
+    return entries;
+  }
+
+ private:
+  static void UpdateMax(std::atomic<uint64_t>& slot, uint64_t value) {
+    uint64_t seen = slot.load(std::memory_order_relaxed);
+    while (value > seen &&
+           !slot.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {
+    }
+  }
+
+  using Key = std::pair<const char*, const void*>;
+  struct LockNode {
+    std::string name;
+    z3y::interfaces::profiler::ProfileNodeData data{
+        nullptr, "[Locks]", 0, z3y::interfaces::profiler::NodeType::Timer};
+  };
+
+  mutable std::mutex mutex_;
+  std::map<Key, Site*> index_;
+  std::map<std::string, z3y::interfaces::profiler::ProfileNodeData*> locks_;
+  std::deque<LockNode> lock_nodes_;
+  std::deque<Site> sites_;
+};
+
+}  // namespace z3y::plugins::profiler
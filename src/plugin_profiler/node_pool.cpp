@@ -0,0 +1,52 @@
+﻿/**
+ * @file node_pool.cpp
+ * @brief NodePool 的平台相关部分：节点块的页映射与物理页交还。
+ * * @details
+ * 交还物理页时必须保留地址可读：POSIX 用 madvise(MADV_DONTNEED)，之后读到零页；
+ * Windows 用 MEM_RESET，页面内容不再保证但仍可访问（MEM_DECOMMIT 会让迟到的读者访问违例）。
+ */
+
+#include "node_pool.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+namespace z3y::plugins::profiler {
+
+using z3y::interfaces::profiler::AggregatorNode;
+
+AggregatorNode* NodePool::MapSlabMemory(size_t bytes) {
+#ifdef _WIN32
+  void* memory = ::VirtualAlloc(nullptr, bytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+  return static_cast<AggregatorNode*>(memory);
+#else
+  void* memory =
+      ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  return memory == MAP_FAILED ? nullptr : static_cast<AggregatorNode*>(memory);
+#endif
+}
+
+void NodePool::DiscardSlabMemory(void* address, size_t bytes) {
+#ifdef _WIN32
+  ::VirtualAlloc(address, bytes, MEM_RESET, PAGE_READWRITE);
+#else
+  ::madvise(address, bytes, MADV_DONTNEED);
+#endif
+}
+
+void NodePool::UnmapSlabMemory(void* address, size_t bytes) {
+#ifdef _WIN32
+  (void)bytes;
+  ::VirtualFree(address, 0, MEM_RELEASE);
+#else
+  ::munmap(address, bytes);
+#endif
+}
+
+}  // namespace z3y::plugins::profiler
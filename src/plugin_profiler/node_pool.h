@@ -0,0 +1,390 @@
+﻿/**
+ * @file node_pool.h
+ * @brief 聚合节点的分块对象池（Slab + 无锁全局空闲栈 + 线程缓存）。
+ * * @details
+ * 【面向维护者】
+ * 早期实现中，线程私有的 256 个空闲节点用完后就要拿全局互斥锁，
+ * 全局池也空了再逐个 `make_unique<AggregatorNode>()`；多个线程同时出现新调用路径时，
+ * 这把锁和每节点一次的 malloc 会出现在热点里。现在：
+ * 1. **分块分配**：节点从每块 kSlabNodes 个、按 Cache Line 对齐的大块中切出，
+ * 每次切一批 (kBatchNodes)；只有切分新批次才拿 slab_mutex_。
+ * 2. **无锁全局空闲栈**：以“批”为单位的 Treiber 栈。栈顶是 (标签 << 32 | 节点下标 + 1)，
+ * 每次 CAS 都递增标签以规避 ABA；批与批之间用原子的 `pool_next` 串联，
+ * 批内节点用 `next_sibling` 串联（只有持有该批的线程会读写）。
+ * 3. **线程缓存 (Magazine)**：每个线程持有一条正在使用的链 (current) 和一整批备用链
+ * (spare)。分配与归还几乎总是只动本线程的链表，与全局栈之间整批搬运。
+ * 4. **按 NUMA 节点分片**：每个节点一个全局空闲栈。整批归还到归还线程所在节点的栈，
+ * 取批时先查本节点、再查其他节点，多路服务器上节点内存不会在插槽之间来回搬运。
+ * 5. **内存预算与归还**：块按页直接向操作系统映射。`SetNodeLimit` 限制常驻块的总节点数，
+ * 映射新块会超出预算时 Acquire 返回 nullptr。`Trim` 把全局空闲栈整体取出，
+ * 1024 个节点全部空闲的块析构节点后交还物理页 (madvise / MEM_RESET)，地址保持映射：
+ * 迟到的读者 (PopBatchFrom 读 pool_next) 读到的是零页，CAS 照样因标签不符而失败。
+ * 交还的块进入 idle_slabs_，下次需要新块时优先复用。
+ * 块的虚拟地址直到池析构才解除映射。
+ */
+
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#include "framework/thread_placement.h"
+#include "interfaces_profiler/profiler_types.h"
+
+namespace z3y::plugins::profiler {
+
+/**
+ * @brief 聚合节点池。线程缓存由调用方以 thread_local 持有，池本身不感知线程。
+ */
+class NodePool {
+ public:
+  static constexpr uint32_t kSlabNodes = 1024;  ///< 每块节点数
+  static constexpr uint32_t kBatchNodes = 64;   ///< 线程缓存与全局栈之间每次搬运的节点数
+  /// 节点总数硬上限（预算的上限，决定块表大小）
+  static constexpr uint32_t kMaxNodes = 4u << 20;
+  static constexpr size_t kSlabBytes =
+      kSlabNodes * sizeof(z3y::interfaces::profiler::AggregatorNode);
+  static_assert(kSlabNodes % kBatchNodes == 0, "a batch never spans two slabs");
+  static constexpr size_t kMaxNodeShards = 8;   ///< 空闲栈分片数上限 (NUMA 节点更多时取模)
+
+  /** @brief 单个线程的节点缓存。owner 不是本池时视为空（池已换届）。 */
+  struct ThreadCache {
+    uint64_t owner = 0;
+    z3y::interfaces::profiler::AggregatorNode* current = nullptr;
+    uint32_t current_count = 0;
+    z3y::interfaces::profiler::AggregatorNode* spare = nullptr;  ///< 满批或空
+  };
+
+  NodePool()
+      : id_(NextPoolId()),
+        shard_count_(std::clamp<size_t>(z3y::GetNumaNodeCount(), 1, kMaxNodeShards)) {}
+  ~NodePool() {
+    for (uint32_t i = 0; i < kMaxSlabs; ++i) {
+      auto* slab = slabs_[i].load(std::memory_order_relaxed);
+      if (!slab) continue;
+      if (slab_resident_[i]) DestroyNodes(slab);
+      UnmapSlabMemory(slab, kSlabBytes);
+    }
+  }
+  NodePool(const NodePool&) = delete;
+  NodePool& operator=(const NodePool&) = delete;
+
+  /**
+   * @brief 取出一个空闲节点（内容未复位，由调用方 Reset）。
+   * @return 达到 kMaxNodes 时返回 nullptr。
+   */
+  z3y::interfaces::profiler::AggregatorNode* Acquire(ThreadCache& cache) {
+    Bind(cache);
+    if (!cache.current) {
+      if (cache.spare) {
+        cache.current = cache.spare;
+        cache.current_count = kBatchNodes;
+        cache.spare = nullptr;
+      } else if (!PopBatch(cache) && !CarveBatch(cache)) {
+        return nullptr;
+      }
+    }
+    auto* node = cache.current;
+    cache.current = node->next_sibling;
+    --cache.current_count;
+    node->next_sibling = nullptr;
+    return node;
+  }
+
+  /** @brief 归还一个节点。不属于本池的节点（如 AsyncSlot 内嵌的根节点）被忽略。 */
+  void Release(ThreadCache& cache, z3y::interfaces::profiler::AggregatorNode* node) {
+    if (node->pool_index == 0) return;
+    Bind(cache);
+    if (cache.current_count == kBatchNodes) {
+      if (cache.spare) PushBatch(cache.spare, kBatchNodes);
+      cache.spare = cache.current;
+      cache.current = nullptr;
+      cache.current_count = 0;
+    }
+    node->next_sibling = cache.current;
+    cache.current = node;
+    ++cache.current_count;
+  }
+
+  /** @brief 把线程缓存中的节点全部交回全局栈（线程退出时调用）。 */
+  void Flush(ThreadCache& cache) {
+    if (cache.owner != id_) return;
+    if (cache.current) PushBatch(cache.current, cache.current_count);
+    if (cache.spare) PushBatch(cache.spare, kBatchNodes);
+    cache = ThreadCache{};
+    cache.owner = id_;
+  }
+
+  /** @brief 常驻（占用物理内存）的块数。 */
+  size_t SlabCount() const { return resident_slabs_.load(std::memory_order_relaxed); }
+  /** @brief 常驻块中已切分出的节点数（在用 + 各级空闲）。 */
+  size_t CarvedNodes() const {
+    return carved_.load(std::memory_order_relaxed) -
+           size_t{idle_slab_count_.load(std::memory_order_relaxed)} * kSlabNodes;
+  }
+  /** @brief 常驻块的节点容量，即实际占用的节点内存 / sizeof(节点)。 */
+  size_t ResidentNodes() const { return SlabCount() * kSlabNodes; }
+  /** @brief 累计交还给操作系统的块数。 */
+  uint64_t ReleasedSlabs() const { return released_slabs_.load(std::memory_order_relaxed); }
+
+  /** @brief 设置常驻节点数上限（向上取整到整块，不超过 kMaxNodes）。已常驻的块不受影响。 */
+  void SetNodeLimit(size_t nodes) {
+    const size_t slabs = std::clamp<size_t>((nodes + kSlabNodes - 1) / kSlabNodes, 1, kMaxSlabs);
+    node_limit_.store(static_cast<uint32_t>(slabs * kSlabNodes), std::memory_order_relaxed);
+  }
+  size_t NodeLimit() const { return node_limit_.load(std::memory_order_relaxed); }
+
+  /**
+   * @brief 把整块空闲的块交还给操作系统，全局空闲栈至少保留 keep_free 个节点。
+   * @param on_release 节点析构前的回调（释放直方图、回收冷数据块）。
+   * @return 交还的块数。只看全局空闲栈：节点停在某个线程缓存里的块不会被交还。
+   */
+  template <typename OnRelease>
+  size_t Trim(size_t keep_free, OnRelease&& on_release) {
+    std::lock_guard<std::mutex> lock(slab_mutex_);
+    // 1. 整体取出各分片的空闲批
+    std::vector<z3y::interfaces::profiler::AggregatorNode*> free_nodes;
+    free_nodes.reserve(free_count_.load(std::memory_order_relaxed));
+    for (size_t shard = 0; shard < shard_count_; ++shard) {
+      ThreadCache batch;
+      while (PopBatchFrom(free_heads_[shard].head, batch)) {
+        for (auto* node = batch.current; node; node = node->next_sibling) {
+          free_nodes.push_back(node);
+        }
+      }
+    }
+    // 2. 找出节点全部空闲的块（只看已整块切完的块）
+    const uint32_t carved = carved_.load(std::memory_order_relaxed);
+    const uint32_t full_slabs = carved / kSlabNodes;
+    std::vector<uint32_t> free_per_slab((carved + kSlabNodes - 1) / kSlabNodes, 0);
+    for (auto* node : free_nodes) ++free_per_slab[(node->pool_index - 1) / kSlabNodes];
+    std::vector<bool> release(free_per_slab.size(), false);
+    size_t released = 0;
+    for (uint32_t i = 0; i < full_slabs; ++i) {
+      if (free_per_slab[i] != kSlabNodes || !slab_resident_[i]) continue;
+      if (free_nodes.size() - (released + 1) * kSlabNodes < keep_free) break;
+      release[i] = true;
+      ++released;
+    }
+    // 3. 其余节点按整批放回。空闲越多的块越先入栈（压在栈底），之后的分配优先取用较满的块，
+    // 稀疏的块逐渐空出来，下一次整理时即可交还
+    auto slab_of = [](const z3y::interfaces::profiler::AggregatorNode* node) {
+      return (node->pool_index - 1) / kSlabNodes;
+    };
+    std::sort(free_nodes.begin(), free_nodes.end(), [&](auto* a, auto* b) {
+      const uint32_t sa = slab_of(a), sb = slab_of(b);
+      if (free_per_slab[sa] != free_per_slab[sb]) return free_per_slab[sa] > free_per_slab[sb];
+      return a->pool_index > b->pool_index;
+    });
+    z3y::interfaces::profiler::AggregatorNode* head = nullptr;
+    uint32_t count = 0;
+    for (auto* node : free_nodes) {
+      if (release[slab_of(node)]) continue;
+      node->next_sibling = head;
+      head = node;
+      if (++count == kBatchNodes) {
+        PushBatch(head, count);
+        head = nullptr;
+        count = 0;
+      }
+    }
+    if (head) PushBatch(head, count);
+    // 4. 析构节点、交还物理页。复用时 child_epoch 从 epoch_floor_ 起步，线程缓存里
+    // 指向旧节点地址的条目不会因 epoch 归零而误命中
+    for (uint32_t i = 0; i < full_slabs; ++i) {
+      if (!release[i]) continue;
+      auto* slab = slabs_[i].load(std::memory_order_relaxed);
+      for (uint32_t j = 0; j < kSlabNodes; ++j) {
+        epoch_floor_ = std::max(epoch_floor_,
+                                slab[j].child_epoch.load(std::memory_order_relaxed) + 1);
+        on_release(slab + j);
+      }
+      DestroyNodes(slab);
+      DiscardSlabMemory(slab, kSlabBytes);
+      slab_resident_[i] = false;
+      idle_slabs_.push_back(i);
+    }
+    resident_slabs_.fetch_sub(released, std::memory_order_relaxed);
+    idle_slab_count_.fetch_add(static_cast<uint32_t>(released), std::memory_order_relaxed);
+    released_slabs_.fetch_add(released, std::memory_order_relaxed);
+    return released;
+  }
+  /** @brief 全局空闲栈中的节点数（不含各线程缓存）。 */
+  size_t GlobalFreeNodes() const {
+    return free_count_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  static constexpr uint32_t kMaxSlabs = (kMaxNodes + kSlabNodes - 1) / kSlabNodes;
+
+  // 平台相关的块映射 (node_pool.cpp)：按页映射 / 交还物理页但保留地址 / 解除映射
+  static z3y::interfaces::profiler::AggregatorNode* MapSlabMemory(size_t bytes);
+  static void DiscardSlabMemory(void* address, size_t bytes);
+  static void UnmapSlabMemory(void* address, size_t bytes);
+
+  static void ConstructNodes(z3y::interfaces::profiler::AggregatorNode* slab) {
+    for (uint32_t i = 0; i < kSlabNodes; ++i) {
+      new (slab + i) z3y::interfaces::profiler::AggregatorNode();
+    }
+  }
+  static void DestroyNodes(z3y::interfaces::profiler::AggregatorNode* slab) {
+    for (uint32_t i = 0; i < kSlabNodes; ++i) slab[i].~AggregatorNode();
+  }
+
+  /** @brief 进程内唯一的池编号。线程缓存用它而不是地址识别池 (地址可能被复用)。 */
+  static uint64_t NextPoolId() {
+    static std::atomic<uint64_t> next{1};
+    return next.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void Bind(ThreadCache& cache) const {
+    if (cache.owner == id_) return;
+    // 缓存里的节点属于已销毁的上一个池，直接丢弃，绝不解引用
+    cache = ThreadCache{};
+    cache.owner = id_;
+  }
+
+  /** @param index 节点的 pool_index（从 1 开始）。 */
+  z3y::interfaces::profiler::AggregatorNode* NodeAt(uint32_t index) const {
+    const uint32_t i = index - 1;
+    return slabs_[i / kSlabNodes].load(std::memory_order_acquire) + i % kSlabNodes;
+  }
+
+  /** @brief 调用线程所在节点的空闲栈分片。 */
+  size_t LocalShard() const {
+    return shard_count_ > 1 ? z3y::GetCurrentNumaNode() % shard_count_ : 0;
+  }
+
+  void PushBatch(z3y::interfaces::profiler::AggregatorNode* head, uint32_t count) {
+    std::atomic<uint64_t>& free_head = free_heads_[LocalShard()].head;
+    uint64_t old = free_head.load(std::memory_order_relaxed);
+    uint64_t desired;
+    do {
+      head->pool_next.store(static_cast<uint32_t>(old), std::memory_order_relaxed);
+      desired = ((old >> 32) + 1) << 32 | head->pool_index;
+    } while (!free_head.compare_exchange_weak(old, desired,
+                                              std::memory_order_release,
+                                              std::memory_order_relaxed));
+    free_count_.fetch_add(count, std::memory_order_relaxed);
+  }
+
+  /** @brief 先从本节点的分片取一批，本节点为空时再依次查看其他分片。 */
+  bool PopBatch(ThreadCache& cache) {
+    const size_t local = LocalShard();
+    for (size_t i = 0; i < shard_count_; ++i) {
+      if (PopBatchFrom(free_heads_[(local + i) % shard_count_].head, cache)) return true;
+    }
+    return false;
+  }
+
+  bool PopBatchFrom(std::atomic<uint64_t>& free_head, ThreadCache& cache) {
+    uint64_t old = free_head.load(std::memory_order_acquire);
+    z3y::interfaces::profiler::AggregatorNode* head;
+    for (;;) {
+      const auto index = static_cast<uint32_t>(old);
+      if (index == 0) return false;
+      head = NodeAt(index);
+      // 即使 head 已被别的线程弹出，读到的 pool_next 也只会让下面的 CAS 失败（标签已变）
+      const uint64_t desired =
+          ((old >> 32) + 1) << 32 | head->pool_next.load(std::memory_order_relaxed);
+      if (free_head.compare_exchange_weak(old, desired, std::memory_order_acquire,
+                                          std::memory_order_acquire))
+        break;
+    }
+    uint32_t count = 0;
+    for (auto* node = head; node; node = node->next_sibling) ++count;
+    free_count_.fetch_sub(count, std::memory_order_relaxed);
+    cache.current = head;
+    cache.current_count = count;
+    return true;
+  }
+
+  /** @brief 映射新块会超出预算时返回 false。 */
+  bool WithinLimit() const {
+    return ResidentNodes() + kSlabNodes <= node_limit_.load(std::memory_order_relaxed);
+  }
+
+  bool CarveBatch(ThreadCache& cache) {
+    std::lock_guard<std::mutex> lock(slab_mutex_);
+    const uint32_t first = carved_.load(std::memory_order_relaxed);
+    if (first % kSlabNodes == 0) {
+      // 当前块已切完：先复用交还过的块，再映射新块
+      if (!WithinLimit()) return false;
+      if (!idle_slabs_.empty()) return ReviveSlab(cache);
+      if (first >= kMaxNodes) return false;
+      auto* fresh = MapSlabMemory(kSlabBytes);
+      if (!fresh) return false;
+      ConstructNodes(fresh);
+      slabs_[first / kSlabNodes].store(fresh, std::memory_order_release);
+      slab_resident_[first / kSlabNodes] = true;
+      resident_slabs_.fetch_add(1, std::memory_order_relaxed);
+    }
+    auto* slab = slabs_[first / kSlabNodes].load(std::memory_order_relaxed);
+    const uint32_t count = std::min(kBatchNodes, kMaxNodes - first);
+    z3y::interfaces::profiler::AggregatorNode* head = nullptr;
+    for (uint32_t i = count; i-- > 0;) {
+      auto* node = slab + (first + i) % kSlabNodes;
+      node->pool_index = first + i + 1;
+      node->next_sibling = head;
+      head = node;
+    }
+    carved_.store(first + count, std::memory_order_relaxed);
+    cache.current = head;
+    cache.current_count = count;
+    return true;
+  }
+
+  /** @brief [slab_mutex_] 重新构造一个交还过的块：第一批交给调用方，其余整批入栈。 */
+  bool ReviveSlab(ThreadCache& cache) {
+    const uint32_t index = idle_slabs_.back();
+    idle_slabs_.pop_back();
+    auto* slab = slabs_[index].load(std::memory_order_relaxed);
+    ConstructNodes(slab);
+    for (uint32_t batch = kSlabNodes / kBatchNodes; batch-- > 0;) {
+      z3y::interfaces::profiler::AggregatorNode* head = nullptr;
+      for (uint32_t i = kBatchNodes; i-- > 0;) {
+        auto* node = slab + batch * kBatchNodes + i;
+        node->pool_index = index * kSlabNodes + batch * kBatchNodes + i + 1;
+        node->child_epoch.store(epoch_floor_, std::memory_order_relaxed);
+        node->next_sibling = head;
+        head = node;
+      }
+      if (batch == 0) {
+        cache.current = head;
+        cache.current_count = kBatchNodes;
+      } else {
+        PushBatch(head, kBatchNodes);
+      }
+    }
+    slab_resident_[index] = true;
+    resident_slabs_.fetch_add(1, std::memory_order_relaxed);
+    idle_slab_count_.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+  }
+
+  /** @brief 一个节点分片的 Treiber 栈顶：(标签 << 32) | (批首 pool_index)。独占缓存行。 */
+  struct alignas(64) FreeHead {
+    std::atomic<uint64_t> head{0};
+  };
+
+  const uint64_t id_;
+  const size_t shard_count_;             ///< 空闲栈分片数 (单节点机器为 1)
+  FreeHead free_heads_[kMaxNodeShards];
+  std::atomic<size_t> free_count_{0};
+  std::mutex slab_mutex_;                 ///< 保护切分新批次、块的映射与交还
+  std::atomic<uint32_t> carved_{0};       ///< 切分进度（节点编号上限，写入受 slab_mutex_ 保护）
+  std::atomic<uint32_t> node_limit_{kMaxNodes};
+  std::atomic<size_t> resident_slabs_{0};
+  std::atomic<uint32_t> idle_slab_count_{0};
+  std::atomic<uint64_t> released_slabs_{0};
+  std::atomic<z3y::interfaces::profiler::AggregatorNode*> slabs_[kMaxSlabs] = {};
+  // 以下受 slab_mutex_ 保护
+  bool slab_resident_[kMaxSlabs] = {};
+  std::vector<uint32_t> idle_slabs_;  ///< 已交还物理页、可复用的块
+  uint32_t epoch_floor_ = 0;          ///< 交还过的节点中最大的 child_epoch + 1
+};
+
+}  // namespace z3y::plugins::profiler
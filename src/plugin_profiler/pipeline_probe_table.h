@@ -0,0 +1,92 @@
+﻿/**
+ * @file pipeline_probe_table.h
+ * @brief 管线追踪钩子 (System.Profiler.PipelineHook) 使用的动态探针元信息表。
+ * * @details
+ * 【面向维护者】
+ * 框架上报的管线名 / 阶段名只在钩子调用期间有效，表在第一次见到时拷贝出来，
+ * ProfileNodeData 放在 deque 里（地址稳定），随服务实例一起销毁。
+ * 管线名节点同时用作该管线异步帧的名字。聚合树：Pipelines → 管线 → 阶段 → [QueueWait]。
+ * 不同 (管线, 阶段) 超过 kMaxStages 后并入同一个 "(other)" 阶段。
+ */
+
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+
+#include "interfaces_profiler/profiler_types.h"
+
+namespace z3y::plugins::profiler {
+
+/**
+ * @brief (管线名, 阶段名) -> 节点元信息的只增表。所有方法线程安全。
+ */
+class PipelineProbeTable {
+ public:
+  static constexpr size_t kMaxStages = 1024;  ///< 不同阶段的数量上限
+
+  /** @brief 一个阶段的节点元信息。 */
+  struct Stage {
+    z3y::interfaces::profiler::ProfileNodeData* pipeline_data = nullptr;  ///< 所属管线的节点
+    std::string name;
+    z3y::interfaces::profiler::ProfileNodeData stage_data{
+        nullptr, "[Pipeline]", 0, z3y::interfaces::profiler::NodeType::Timer};
+    z3y::interfaces::profiler::ProfileNodeData wait_data{
+        "[QueueWait]", "[Pipeline]", 0, z3y::interfaces::profiler::NodeType::Timer};
+  };
+
+  /** @brief 取得管线节点，首次见到时创建。返回的指针（及其 name）在表的生命周期内有效。 */
+  z3y::interfaces::profiler::ProfileNodeData* GetPipeline(const char* pipeline) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return PipelineLocked(pipeline);
+  }
+
+  /** @brief 取得阶段的节点元信息，首次见到时创建。 */
+  Stage* GetStage(const char* pipeline, const char* stage) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Key key{pipeline ? pipeline : "", stage ? stage : ""};
+    auto it = stages_.find(key);
+    if (it != stages_.end()) return it->second;
+    if (stage_nodes_.size() >= kMaxStages) {
+      key.second = "(other)";
+      it = stages_.find(key);
+      if (it != stages_.end()) return it->second;
+    }
+    Stage& node = stage_nodes_.emplace_back();
+    node.pipeline_data = PipelineLocked(pipeline);
+    node.name = key.second;
+    node.stage_data.name = node.name.c_str();  // deque 中的元素不会移动
+    stages_.emplace(std::move(key), &node);
+    return &node;
+  }
+
+ private:
+  using Key = std::pair<std::string, std::string>;
+  struct PipelineNode {
+    std::string name;
+    z3y::interfaces::profiler::ProfileNodeData data{
+        nullptr, "[Pipeline]", 0, z3y::interfaces::profiler::NodeType::Timer};
+  };
+
+  z3y::interfaces::profiler::ProfileNodeData* PipelineLocked(const char* pipeline) {
+    std::string name = pipeline ? pipeline : "(unnamed)";
+    auto it = pipelines_.find(name);
+    if (it != pipelines_.end()) return it->second;
+    PipelineNode& node = pipeline_nodes_.emplace_back();
+    node.name = name;
+    node.data.name = node.name.c_str();
+    pipelines_.emplace(std::move(name), &node.data);
+    return &node.data;
+  }
+
+  std::mutex mutex_;
+  std::map<Key, Stage*> stages_;
+  std::map<std::string, z3y::interfaces::profiler::ProfileNodeData*> pipelines_;
+  std::deque<PipelineNode> pipeline_nodes_;
+  std::deque<Stage> stage_nodes_;
+};
+
+}  // namespace z3y::plugins::profiler
@@ -4,24 +4,115 @@
  * * @details
  * 【面向维护者 - 工业级稳定性大揭秘】
  * 1. **UAF 防御 (Use-After-Free)**：
- * 当宿主框架热重载（卸载又重新装载）该插件时，旧的 master_nodes_
+ * 当宿主框架热重载（卸载又重新装载）该插件时，旧的节点池 (node_pool_)
  * 会被析构。如果工作线程 的 `thread_local`
  * 不做感知，将会拿到失效的内存指针。这里通过 `g_profiler_service_instance` 和
  * `tls_last_service_instance` 双重原子比对，在重载瞬间强行清空 TLS
  * 缓存，完美避开段错误。
- * 2. **三级内存分配机制**：
- * 分配请求 -> 线程私有池(tls_free_nodes, O(1)无锁) -> 全局池(free_nodes_,
- * 批量获取, 低锁碰撞) -> OS 堆内存(new)
- * 3. **OOM 绝对防爆阀**：
- * 如果业务人员在错误的分支中生成了无限数量的节点名称，`master_nodes_.size() >=
- * 2000000` 将强制返回 nullptr 拒绝服务。在工业检测中，保全宿主系统内存（不
- * OOM）永远高于收集监控数据。
+ * 2. **三级内存分配机制**（见 node_pool.h）：
+ * 分配请求 -> 线程缓存(tls_node_cache, 无锁无原子) -> 无锁全局空闲栈(整批搬运)
+ * -> 从 1024 节点一块的 Slab 中切出新批次(仅此处加锁)
+ * 3. **节点内存预算 (System.Profiler.NodeMemoryBudgetMB)**：
+ * 如果业务人员在错误的分支中生成了大量节点名称，常驻节点块达到预算后 `AcquireNode`
+ * 返回 nullptr，新路径不再记录。在工业检测中，保全宿主系统内存（不 OOM）永远高于收集监控数据。
+ * 剩余可用节点（未映射的预算 + 全局空闲栈）不足预算的 1/8 或分配失败时进入压力状态：各根（线程根、异步流、分组根、
+ * 事件总线 / 锁根）在下一次结束时提前换代，输出当前数据后整代回收——冷门路径随旧代一起淘汰，
+ * 热路径在新一代中立即重建。只有换代能安全回收仍可能有写入者的子树，所以淘汰以根的一代为单位。
+ * 报告线程在输出报告 / 回收旧代后调用 `TrimNodePool`，把整块空闲的块交还给操作系统；
+ * 在用节点降到预算一半以下时解除压力状态。
  * 4. **并发撕裂与僵尸节点驱逐**：
  * `ReleaseChildren` 和 `Formatxxx` 中采用了
  * Snapshot（快照）自旋锁机制，防止异步 Worker
  * 正在挂载节点时主线程去遍历树导致链表崩溃。
- * 对于 `g_async_slots`，当环形缓冲区满载僵尸（由于某异常没调
- * Commit）时，会强制驱逐旧节点。
+ * 对于异步帧表 (AsyncFrameTable)，在途帧数达到上限（大量帧因异常没调
+ * Commit）时触发熔断，新帧不再分析，保护进程内存。
+ * 5. **分片聚合 (System.Profiler.ShardedAggregation)**：
+ * 多个 Worker 挂载同一个异步流时，默认全部写入槽位的共享树，热点节点的
+ * fetch_add / CAS 会在各核之间来回争抢同一条 Cache Line。开启分片后，
+ * `AsyncAttach` 为每个线程分配一棵独占的影子树 (`thread_owned`，无原子 RMW)，
+ * 挂在槽位的 `shards` 链上；`AsyncCommit` 在提交报告前把影子树合并进共享树。
+ * 6. **后台报告输出**：
+ * 触发报告的线程只在 `TakeSnapshot` 中把树拍平成 ProfileReport 并入队；
+ * 文本格式化、日志写入和 IProfilerReportSink 回调都在后台报告线程上完成。
+ * 7. **分位数直方图 (System.Profiler.HistogramPrecision)**：
+ * 精度 1~4 时，`AcquireNode` 给节点挂一个 LogHistogram，报告中输出 p50/p95/p99/p999。
+ * 直方图随节点一起在池中复用；总数受 kMaxHistograms 限制，超出后新节点不再统计分位数。
+ * 8. **开销补偿 (System.Profiler.OverheadCompensation)**：
+ * `Initialize` 用一棵私有的树标定热路径探针的开销：两次读时钟之间的部分计入节点自身
+ * (self)，查找节点 + 两次读时钟 + 累加的全部耗时计入父节点 (outer)。快照中每个计时节点的
+ * 累计耗时扣除 `count * self + 计时后代调用数 * outer`，结果下限为 0。
+ * Min/Max/分位数是单次分布，保持原始值。
+ * 9. **探针注册表**：
+ * 探针第一次在本实例下执行时经 `RegisterProbe` 登记，按“文件:行号:名字”分到位图中的
+ * 一位，所在模块名用 dladdr / GetModuleHandleEx 从探针地址反查。注册表只保存拷贝出的
+ * 字符串，之后从不解引用探针指针，所以模块卸载后也不会写到已释放的内存。
+ * `SetProbesEnabled` 记下规则并重算位图；热路径只读一位，与规则数量无关。
+ * 10. **线程状态按需扩容**：
+ * 影子栈与独立根节点集合先使用 ProfilerThreadState 内联的小数组，满了才由
+ * `GrowShadowStack` / `AcquireThreadRoot` 在堆上翻倍扩容（线程退出时释放），空闲线程的
+ * TLS 只占内联部分。影子栈达到 kMaxStackDepth 后更深的层级不再记录，溢出次数计入
+ * 下一份报告的 `depth_overflows`。
+ * 11. **节点冷热分离**：
+ * AggregatorNode 只保留拓扑与次数 / 耗时 (128 字节)。数值统计与标签放在 NodeColdStats
+ * 中，由 `AttachColdStats` 在第一次记录数值或绑定标签时从旁路表 (cold_stats_) 分配，
+ * 之后随节点一起复用；纯计时节点不占这部分内存，树遍历也不会把它读进缓存。
+ * 12. **采样模式 (System.Profiler.SamplingHz)**：
+ * 与插桩并行，由 SamplingProfiler 按频率记录进程内运行中线程的 PC（见 sampling_profiler.h），
+ * `GetSamplingProfile` 按模块 / 导出符号 / 线程聚合，并对照已加载的插件文件标出插件模块。
+ * 13. **硬件计数器 (System.Profiler.HardwareCounters)**：
+ * ROOT 作用域两端经 `ReadHardwareCounters` 读取本线程的计数器组（见 hardware_counters.h），
+ * 增量由 `RecordHardwareCounters` 累加到根节点的冷数据块，报告中以每次调用的均值输出。
+ * 14. **实时快照 (SnapshotLiveRoots)**：
+ * `AcquireThreadRoot` 把新根节点登记到 live_roots_，线程退出时经 `ReleaseThreadRoots`
+ * 先注销再回收；快照全程持有 live_roots_mutex_，因此被读取的树不会中途还回池中。
+ * 快照走与报告相同的自旋锁协议，只读不清零（供 plugin_metrics_exporter 使用）。
+ * 15. **报告换代 (DetachGeneration / RetireGeneration)**：
+ * 出报告时先把根节点的统计值与整棵子树摘到一个壳节点上（持锁只交换指针），根节点
+ * 立即开始接收新一代的写入，报告读的是摘下的旧代。旧代延后回收：线程根节点的旧代
+ * 交给报告线程，等换代前开始的 SnapshotLiveRoots 结束（reader_epoch_ / retire_epoch_）；
+ * 异步流的旧代挂在槽位上，其他 Worker 可能仍在上面计时，等最后一个引用释放时回收。
+ * 16. **异步流追踪 (System.Profiler.TraceRingSize)**：
+ * 开启后 ASYNC_BEGIN / ATTACH / COMMIT 各在调用线程的环形缓冲区记一条事件（见 trace_recorder.h），
+ * `CollectTrace` 汇总后由 WriteChromeTrace 输出为带 flow 箭头的 Chrome Trace，聚合树不受影响。
+ * 17. **事件总线钩子 (System.Profiler.EventBusHook)**：
+ * 开启后本服务安装为 `PluginManager::SetEventTraceHook`，在 kDirectCallStart/End 与
+ * kQueuedExecuteStart/End 之间计时，节点名按 EventId / 订阅者地址动态生成（见 event_probe_table.h），
+ * 全部线程写入同一个 EventBus 根；排队等待取自 `PluginManager::GetCurrentEventTaskWaitNs`。
+ * 18. **类型化标签 (Z3Y_PROFILE_TAG_INT / ENUM / NAME / ID)**：
+ * 节点冷数据中按 (key, kind, value) 各占一个计数槽位（见 NodeColdStats::CountTagValue），
+ * 字符串只以驻留编号保存（tag_strings_），`TakeSnapshot` 才解析回文本并合并重复槽位。
+ * 19. **分组根 (Z3Y_PROFILE_ROOT_KEYED)**：
+ * 每个 (调用点, 键) 一个共享根（见 keyed_root_table.h），换代与出报告复用 `CheckRoot` 的
+ * 异步槽位路径，旧代挂在槽位的 retired 链上，由最后一个离开的写入者回收；
+ * 分组数超过 System.Profiler.KeyedRootCapacity 时按 LRU 淘汰，淘汰前输出剩余数据。
+ * 20. **锁竞争 (System.Profiler.LockContention)**：
+ * 开启后本服务安装为 `z3y::SetLockProfileHook`，框架的 ProfiledMutex（以 Z3Y_LOCK_PROFILING
+ * 构建时）每次加锁上报等待 / 持有时间与调用点，计入 lock_probe_table.h 的排名表和共享的
+ * Locks 根；`GetLockContention` 在读取时才解析调用点符号。
+ * 21. **分配统计 (System.Profiler.AllocationTracking)**：
+ * 开启后本服务安装为 `z3y::SetAllocationHook`，宿主链接的 z3y_alloc_interposer 每次
+ * `operator new` 都把字节数计入当前线程影子栈栈顶节点的 alloc_count / alloc_bytes（自身分配，
+ * 不含子作用域）。钩子只读平凡的 TLS 指针 (tls_alloc_state)，不会在分配路径上构造线程状态；
+ * Profiler 自身的分配（节点池扩容、探针登记、出报告）由 AllocationMute 排除。
+ * 22. **节拍根 (Z3Y_PROFILE_ROOT_PACED)**：
+ * 宏在作用域结束时调用 `RecordPacedFrame`，状态放在本线程的 tls_pacing 中（记录与换代都在
+ * 拥有该根的线程上，不加锁）。每帧记下各直接子节点累计耗时的增量，下一帧开始时才知道这一帧的
+ * 间隔，间隔足够长就连同这些增量记入最差帧；`CheckRoot` 换代时取走统计放进报告。
+ * 23. **飞行记录器 (System.Profiler.FlightRecorderRingSize)**：
+ * 线程状态保存 FlightRecorder 会话号的地址，探针进入 / 退出时往本线程的环里各写一条记录；
+ * 会话号变化（开关或改容量）后第一次写入经 `AcquireFlightRing` 换环。`CheckRoot` 因 SLA
+ * 超时出报告时冻结最近一个窗口（每窗口至多一次），`TakeFlightRecordings` 取走结果。
+ * 24. **设备区间 (Z3Y_PROFILE_DEVICE)**：
+ * 宏在设备队列上打首尾标记后经 `SubmitDeviceSpan` 交给 DeviceTimeline（见 device_timeline.h），
+ * 它的轮询线程解析出设备耗时后回调 `RecordDeviceSpan`，写入与 EventBus / Locks 相同模式的
+ * 共享根 Devices（只有轮询线程写入），追踪开启时经 `TraceRecorder::DeviceSpan` 记到设备轨道。
+ * 25. **接口调用拦截 (System.Profiler.InterceptedCalls)**：
+ * 逗号分隔的接口名 / 组件别名交给 `PluginManager::SetCallInterception`；带代理描述的接口
+ * （framework/interface_proxy.h）此后返回代理，经 ProxyCallTimer 为每个方法记一个 "接口::方法" 节点。
+ * 26. **管线钩子 (System.Profiler.PipelineHook)**：
+ * 开启后本服务安装为 `z3y::SetPipelineTraceHook`。每次阶段结束把 Process 耗时与通道等待计入共享的
+ * Pipelines 根（节点名见 pipeline_probe_table.h）；帧号每 PipelinePeriod 取一帧映射为异步帧：
+ * kItemBegin → AsyncBegin，每一级 AsyncAttach / 记阶段节点 / AsyncCommit，kItemEnd 释放最初的引用。
  */
 
 #include "profiler_service.h"
@@ -29,8 +120,28 @@
 #include <spdlog/fmt/fmt.h>
 
 #include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <limits>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX  // 本文件使用 std::min / std::max
+#endif
+#include <Windows.h>
+#else
+#include <dlfcn.h>  // dladdr
+#endif
+
+#if defined(_MSC_VER) || defined(__i386__) || defined(__x86_64__)
+#include <immintrin.h>  // _mm_pause
+#endif
 
 #include "interfaces_core/z3y_log_macros.h"
+#include "interfaces_profiler/profiler_macros.h"  // FindOrCreateNode
+#ifdef _WIN32
+#include "framework/z3y_utils.h"  // PathToUtf8
+#endif
 
 Z3Y_AUTO_REGISTER_SERVICE(z3y::plugins::profiler::ProfilerService,
                           "System.Profiler", true);
@@ -47,9 +158,84 @@ std::atomic<uint64_t> ProfilerService::g_instance_counter_{1};
 static std::atomic<ProfilerService*> g_profiler_service_instance{nullptr};
 
 thread_local uint64_t tls_last_service_id = 0;
-thread_local z3y::interfaces::profiler::AggregatorNode*
-    tls_free_nodes[256];  // 假设最多缓存256个
-thread_local int tls_free_node_count = 0;
+thread_local NodePool::ThreadCache tls_node_cache;  // 池按自身编号识别换届
+thread_local HardwareCounterGroup tls_hw_counters;   // 与服务实例无关，线程退出时关闭
+
+/**
+ * @brief 事件总线钩子的线程局部状态：嵌套的同步回调栈与正在执行的异步任务。
+ */
+struct EventHookThreadState {
+  static constexpr size_t kMaxDepth = 32;  ///< 更深的嵌套只计深度，不计时
+  struct Call {
+    EventId event_id;
+    uint64_t start_ticks;
+  };
+  Call direct[kMaxDepth];
+  size_t depth = 0;
+  bool in_task = false;
+  EventId task_event = 0;
+  uint64_t task_start = 0;
+};
+thread_local EventHookThreadState tls_event_hook;
+
+/**
+ * @brief 本线程一个节拍根 (Z3Y_PROFILE_ROOT_PACED) 的帧间隔状态。
+ * @details 记录与换代都发生在拥有该根的线程上（宏的析构 -> CheckRoot），不需要加锁。
+ */
+struct PacingTrack {
+  uint64_t service_id = 0;
+  const AggregatorNode* root = nullptr;
+  uint64_t frames = 0;      ///< 已记录的帧数
+  uint64_t prev_start = 0;  ///< 上一帧的开始 / 结束时刻
+  uint64_t prev_end = 0;
+  /// 上一帧各直接子节点的耗时增量，等到下一帧开始时才知道它的间隔
+  std::vector<std::pair<const ProfileNodeData*, uint64_t>> prev_stages;
+  /// 当前一代各直接子节点的累计耗时，下一帧据此求增量；换代后清空
+  std::vector<std::pair<const AggregatorNode*, uint64_t>> child_totals;
+  std::vector<std::pair<const AggregatorNode*, uint64_t>> scratch;
+  double sum_interval_ms = 0.0;
+  double sum_sq_deviation = 0.0;
+  FramePacing stats;  ///< 本代的统计，随下一份报告取走
+};
+thread_local std::vector<PacingTrack> tls_pacing;
+
+static PacingTrack* FindPacingTrack(uint64_t service_id, const AggregatorNode* root) {
+  for (PacingTrack& track : tls_pacing) {
+    if (track.root == root && track.service_id == service_id) return &track;
+  }
+  return nullptr;
+}
+
+/** @brief 取走本代的节拍统计（补上平均值与均方根），之后从空统计重新累积。 */
+static FramePacing TakePacing(PacingTrack& track) {
+  FramePacing pacing = std::move(track.stats);
+  if (pacing.intervals > 0) {
+    const auto n = static_cast<double>(pacing.intervals);
+    pacing.mean_interval_ms = track.sum_interval_ms / n;
+    pacing.jitter_rms_ms = std::sqrt(track.sum_sq_deviation / n);
+  }
+  track.stats = FramePacing{};
+  track.stats.cadence_ms = pacing.cadence_ms;
+  track.stats.tolerance = pacing.tolerance;
+  track.sum_interval_ms = 0.0;
+  track.sum_sq_deviation = 0.0;
+  track.child_totals.clear();  // 子节点随旧代摘走了
+  return pacing;
+}
+
+// 分配钩子读取的线程状态：平凡类型，钩子访问它不会触发 TLS 构造或析构注册。
+// 由 GetOrCreateThreadState 写入，线程状态析构时清空
+thread_local ProfilerThreadState* tls_alloc_state = nullptr;
+thread_local uint64_t tls_alloc_state_owner = 0;  ///< tls_alloc_state 所属的服务实例
+thread_local uint32_t tls_alloc_muted = 0;  ///< 大于 0 时本线程的分配来自 Profiler 自身，不计入
+
+/** @brief 作用域内本线程的分配不计入当前节点（节点池扩容、出报告等 Profiler 自身的开销）。 */
+struct AllocationMute {
+  AllocationMute() { ++tls_alloc_muted; }
+  ~AllocationMute() { --tls_alloc_muted; }
+  AllocationMute(const AllocationMute&) = delete;
+  AllocationMute& operator=(const AllocationMute&) = delete;
+};
 
 /**
  * @brief 线程局部变量包装器，用于在线程退出时触发 C++ 运行时自动垃圾回收。
@@ -57,42 +243,74 @@ thread_local int tls_free_node_count = 0;
 struct ProfilerThreadStateWrapper {
   ProfilerThreadState state;
   ~ProfilerThreadStateWrapper() {
+    tls_alloc_state = nullptr;  // 此后的分配（含下面的回收）不再计入
     // 只有在 Service
     // 实例存活时（没有在卸载期），才安全地将自己名下的根树归还给对象池。
     if (auto* svc =
             g_profiler_service_instance.load(std::memory_order_acquire)) {
       // 仅当当前存活的实例，就是当初分配这些节点的那个实例时，才允许释放
       if (svc && svc->GetInstanceId() == tls_last_service_id) {
-        for (size_t i = 0; i < state.thread_root_count; ++i) {
-          svc->ReleaseNodeTree(state.thread_roots[i]);
-        }
+        svc->ReleaseThreadRoots(&state);
+        svc->ReleaseFlightRing(&state);
+        svc->FlushThreadNodeCache();
+        svc->RequestNodeTrim();
       }
     }
+    // 扩容出的存储总是由本模块分配，与服务是否存活无关
+    if (state.shadow_stack != state.inline_stack) delete[] state.shadow_stack;
+    if (state.thread_roots != state.inline_roots) delete[] state.thread_roots;
   }
 };
 thread_local ProfilerThreadStateWrapper t_profiler_state_wrapper;
 
-/**
- * @brief 异步分析流槽位结构，采用环形缓冲区实现无锁分配。
- */
-struct AsyncSlot {
-  std::atomic<uint64_t> active_frame_id{
-      0};                    ///< 当前槽位服务的目标帧ID，0表示空闲
-  std::atomic<uint32_t> ref_count{
-      0};                    // [新增] 根级侵入式引用计数，防止僵尸线程 UAF
-  AggregatorNode root_node;  ///< 该异步流的专属根节点
-  ProfileNodeData dynamic_info{nullptr, "", 0,
-                               NodeType::Timer};  ///< 预置的动态元信息
-  uint32_t period = 1;                            ///< 触发报告的次数阈值
-  double sla_ms = 0.0;                            ///< SLA 容忍极限
-};
-static AsyncSlot g_async_slots[1024];
+
+// 直方图总数硬上限：精度 2 时约 2KB/个，上限对应约 128MB
+static constexpr size_t kMaxHistograms = 65536;
+
+static void LockSpin(std::atomic_flag& flag) {
+  while (flag.test_and_set(std::memory_order_acquire)) {
+#if defined(_MSC_VER) || defined(__i386__) || defined(__x86_64__)
+    _mm_pause();
+#elif defined(__arm__) || defined(__aarch64__)
+    __asm__ volatile("yield");
+#endif
+  }
+}
+
+/** @brief 从槽位的影子树链上摘下 shard（shard 为空时摘下整条链）。 */
+static AggregatorNode* DetachShards(AsyncSlot& slot,
+                                    AggregatorNode* shard = nullptr) {
+  LockSpin(slot.shard_lock);
+  AggregatorNode* detached = nullptr;
+  if (!shard) {
+    detached = slot.shards;
+    slot.shards = nullptr;
+  } else {
+    for (AggregatorNode** link = &slot.shards; *link;
+         link = &(*link)->next_sibling) {
+      if (*link == shard) {
+        detached = shard;
+        *link = shard->next_sibling;
+        shard->next_sibling = nullptr;
+        break;
+      }
+    }
+  }
+  slot.shard_lock.clear(std::memory_order_release);
+  return detached;
+}
 
 ProfilerService::ProfilerService() {
   uint64_t timestamp =
       std::chrono::steady_clock::now().time_since_epoch().count();
   instance_id_ =
       timestamp ^ g_instance_counter_.fetch_add(1, std::memory_order_relaxed);
+
+  // 标签必须非 0：探针的初始 probe_key 为 0，代表“尚未登记”
+  probe_tag_ = static_cast<uint32_t>(instance_id_ ^ (instance_id_ >> 32)) | 1u;
+  probe_bits_ = std::make_unique<std::atomic<uint64_t>[]>(kMaxProbes / 64);
+  probe_bits_[0].store(1, std::memory_order_relaxed);
+  probes_.emplace_back();  // 0 号：恒为启用的公共位
 }
 
 bool ProfilerService::IsEnabled() const {
@@ -102,6 +320,17 @@ bool ProfilerService::IsEnabled() const {
 void ProfilerService::Initialize() {
   g_profiler_service_instance.store(this, std::memory_order_release);
   is_active_.store(true, std::memory_order_release);
+  CalibrateOverhead();
+  ProfilerClock::TicksPerMs();  // 节拍根在业务线程上换算间隔：先在这里校准，不占用某一帧
+  event_bus_.dynamic_info.name = "EventBus";
+  event_bus_.root_node.static_info = &event_bus_.dynamic_info;
+  locks_.dynamic_info.name = "Locks";
+  locks_.root_node.static_info = &locks_.dynamic_info;
+  devices_.dynamic_info.name = "Devices";
+  devices_.root_node.static_info = &devices_.dynamic_info;
+  pipelines_.dynamic_info.name = "Pipelines";
+  pipelines_.root_node.static_info = &pipelines_.dynamic_info;
+  StartReportThread();
 
   if (auto [log_mgr, err] = z3y::TryGetDefaultService<ILogManagerService>();
       err == z3y::InstanceError::kSuccess) {
@@ -116,20 +345,225 @@ void ProfilerService::Initialize() {
                          .Bind([this](bool val) {
                            enable_.store(val, std::memory_order_relaxed);
                          });
+    config_conns_ +=
+        cfg_svc->Builder<int>("System.Profiler.NodeMemoryBudgetMB")
+            .NameKey("Profiler Node Memory Budget (MB)")
+            .Default(256)
+            .Min(1)
+            .Max(static_cast<int>(NodePool::kMaxNodes * sizeof(AggregatorNode) >> 20))
+            .Bind([this](int val) {
+              const size_t bytes = static_cast<size_t>(val > 0 ? val : 1) << 20;
+              node_pool_.SetNodeLimit(bytes / sizeof(AggregatorNode));
+            });
+    config_conns_ +=
+        cfg_svc->Builder<bool>("System.Profiler.ShardedAggregation")
+            .NameKey("Profiler Sharded Aggregation")
+            .Default(false)
+            .Bind([this](bool val) {
+              sharded_.store(val, std::memory_order_relaxed);
+            });
+    config_conns_ +=
+        cfg_svc->Builder<int>("System.Profiler.HistogramPrecision")
+            .NameKey("Profiler Histogram Precision")
+            .Default(0)
+            .Min(0)
+            .Max(static_cast<int>(LogHistogram::kMaxPrecisionBits))
+            .Bind([this](int val) {
+              histogram_bits_.store(static_cast<uint32_t>(val > 0 ? val : 0),
+                                    std::memory_order_relaxed);
+            });
+    config_conns_ +=
+        cfg_svc->Builder<int>("System.Profiler.MaxAsyncFrames")
+            .NameKey("Profiler Max Async Frames")
+            .Default(static_cast<int>(AsyncFrameTable::kDefaultCapacity))
+            .Min(1)
+            .Bind([this](int val) {
+              frames_.SetCapacity(static_cast<size_t>(val > 0 ? val : 1));
+            });
+    config_conns_ +=
+        cfg_svc->Builder<bool>("System.Profiler.OverheadCompensation")
+            .NameKey("Profiler Overhead Compensation")
+            .Default(true)
+            .Bind([this](bool val) {
+              compensate_.store(val, std::memory_order_relaxed);
+            });
+    config_conns_ +=
+        cfg_svc->Builder<bool>("System.Profiler.HardwareCounters")
+            .NameKey("Profiler Hardware Counters")
+            .Default(false)
+            .Bind([this](bool val) {
+              if (val) {
+                // 在配置线程上试开一组，不可用时提前告知（各线程仍会各自尝试）
+                HardwareCounterGroup probe;
+                HardwareCounterSample sample;
+                if (!probe.Read(sample) && profiler_logger_) {
+                  Z3Y_LOG_WARN(profiler_logger_,
+                               "[Profiler] Hardware counters are unavailable "
+                               "(unsupported platform or perf_event_paranoid).");
+                }
+              }
+              hw_counters_.store(val, std::memory_order_relaxed);
+            });
+    config_conns_ +=
+        cfg_svc->Builder<int>("System.Profiler.PacingTolerancePercent")
+            .NameKey("Profiler Pacing Tolerance (%)")
+            .Default(10)
+            .Min(0)
+            .Max(100)
+            .Bind([this](int val) {
+              pacing_tolerance_.store((val > 0 ? val : 0) / 100.0,
+                                      std::memory_order_relaxed);
+            });
+    config_conns_ +=
+        cfg_svc->Builder<int>("System.Profiler.SamplingHz")
+            .NameKey("Profiler Sampling Rate (Hz)")
+            .Default(0)
+            .Min(0)
+            .Max(static_cast<int>(SamplingProfiler::kMaxRateHz))
+            .Bind([this](int val) {
+              if (!sampler_.SetRate(static_cast<uint32_t>(val > 0 ? val : 0)) &&
+                  profiler_logger_) {
+                Z3Y_LOG_WARN(profiler_logger_,
+                             "[Profiler] Sampling mode is unavailable on this "
+                             "platform or already active in this process.");
+              }
+            });
+    config_conns_ +=
+        cfg_svc->Builder<int>("System.Profiler.TraceRingSize")
+            .NameKey("Profiler Trace Ring Size (events per thread)")
+            .Default(0)
+            .Min(0)
+            .Max(static_cast<int>(TraceRecorder::kMaxRingSize))
+            .Bind([this](int val) {
+              tracer_.SetRingSize(static_cast<size_t>(val > 0 ? val : 0));
+            });
+    config_conns_ +=
+        cfg_svc->Builder<int>("System.Profiler.FlightRecorderRingSize")
+            .NameKey("Profiler Flight Recorder Ring Size (records per thread)")
+            .Default(0)
+            .Min(0)
+            .Max(static_cast<int>(FlightRecorder::kMaxRingSize))
+            .Bind([this](int val) {
+              flight_.SetRingSize(static_cast<size_t>(val > 0 ? val : 0));
+            });
+    config_conns_ +=
+        cfg_svc->Builder<int>("System.Profiler.FlightRecorderWindowMs")
+            .NameKey("Profiler Flight Recorder Window (ms)")
+            .Default(2000)
+            .Min(1)
+            .Max(600000)
+            .Bind([this](int val) {
+              flight_.SetWindowMs(static_cast<uint32_t>(val > 0 ? val : 1));
+            });
+    config_conns_ +=
+        cfg_svc->Builder<int>("System.Profiler.KeyedRootCapacity")
+            .NameKey("Profiler Keyed Root Capacity")
+            .Default(static_cast<int>(KeyedRootTable::kDefaultCapacity))
+            .Min(1)
+            .Max(static_cast<int>(KeyedRootTable::kMaxEntries))
+            .Bind([this](int val) {
+              keyed_roots_.SetCapacity(static_cast<size_t>(val > 0 ? val : 1));
+            });
+    config_conns_ +=
+        cfg_svc->Builder<int>("System.Profiler.EventBusPeriod")
+            .NameKey("Profiler Event Bus Report Period")
+            .Default(10000)
+            .Min(1)
+            .Bind([this](int val) {
+              event_bus_period_.store(static_cast<uint32_t>(val > 0 ? val : 1),
+                                      std::memory_order_relaxed);
+            });
+    config_conns_ +=
+        cfg_svc->Builder<bool>("System.Profiler.EventBusHook")
+            .NameKey("Profiler Event Bus Hook")
+            .Default(false)
+            .Bind([this](bool val) { SetEventBusHook(val); });
+    config_conns_ +=
+        cfg_svc->Builder<int>("System.Profiler.LockContentionPeriod")
+            .NameKey("Profiler Lock Contention Report Period")
+            .Default(100000)
+            .Min(1)
+            .Bind([this](int val) {
+              lock_period_.store(static_cast<uint32_t>(val > 0 ? val : 1),
+                                 std::memory_order_relaxed);
+            });
+    config_conns_ +=
+        cfg_svc->Builder<int>("System.Profiler.PipelinePeriod")
+            .NameKey("Profiler Pipeline Report Period")
+            .Default(1000)
+            .Min(1)
+            .Bind([this](int val) {
+              pipeline_period_.store(static_cast<uint32_t>(val > 0 ? val : 1),
+                                     std::memory_order_relaxed);
+            });
+    config_conns_ +=
+        cfg_svc->Builder<int>("System.Profiler.DevicePeriod")
+            .NameKey("Profiler Device Span Report Period")
+            .Default(1000)
+            .Min(1)
+            .Bind([this](int val) {
+              device_period_.store(static_cast<uint32_t>(val > 0 ? val : 1),
+                                   std::memory_order_relaxed);
+            });
+    config_conns_ +=
+        cfg_svc->Builder<bool>("System.Profiler.LockContention")
+            .NameKey("Profiler Lock Contention")
+            .Default(false)
+            .Bind([this](bool val) { SetLockContentionHook(val); });
+    config_conns_ +=
+        cfg_svc->Builder<bool>("System.Profiler.PipelineHook")
+            .NameKey("Profiler Pipeline Hook")
+            .Default(false)
+            .Bind([this](bool val) { SetPipelineHook(val); });
+    config_conns_ +=
+        cfg_svc->Builder<bool>("System.Profiler.AllocationTracking")
+            .NameKey("Profiler Allocation Tracking")
+            .Default(false)
+            .Bind([this](bool val) { SetAllocationTracking(val); });
+    config_conns_ +=
+        cfg_svc->Builder<std::string>("System.Profiler.InterceptedCalls")
+            .NameKey("Profiler Intercepted Interfaces")
+            .Default(std::string())
+            .Bind([this](const std::string& val) { SetInterceptedCalls(val); });
   }
 }
 
 void ProfilerService::Shutdown() {
+  // 先卸下事件、锁、管线与分配钩子：返回后不会再有钩子调用进入本实例
+  SetEventBusHook(false);
+  SetLockContentionHook(false);
+  SetPipelineHook(false);
+  SetAllocationTracking(false);
+  SetInterceptedCalls(std::string());
+  // 设备轮询线程同样会写入聚合树，并放弃尚未解析的区间
+  device_timeline_.Stop();
   is_active_.store(false, std::memory_order_release);
   g_profiler_service_instance.store(nullptr, std::memory_order_release);
 
-  // [新增] 强行清理静态槽位中的幽灵指针，防止下次重载时发生 UAF
-  for (auto& slot : g_async_slots) {
-    slot.active_frame_id.store(0, std::memory_order_relaxed);
+  // [新增] 强行摘除所有在途帧，防止下次重载时发生 UAF
+  frames_.Clear([this](AsyncSlot& slot) {
     // 使用线程安全的隔离函数，确保没有异步线程正在操作它
     ReleaseChildren(&slot.root_node);
-  }
-
+    // 影子树与摘下的旧代可能仍被挂载线程写入，归 node_pool_ 所有，随实例一起销毁
+  });
+  ReleaseChildren(&event_bus_.root_node);
+  ReleaseShardChain(event_bus_.retired);
+  event_bus_.retired = nullptr;
+  ReleaseChildren(&locks_.root_node);
+  ReleaseShardChain(locks_.retired);
+  locks_.retired = nullptr;
+  ReleaseChildren(&devices_.root_node);
+  ReleaseShardChain(devices_.retired);
+  devices_.retired = nullptr;
+  ReleaseChildren(&pipelines_.root_node);
+  ReleaseShardChain(pipelines_.retired);
+  pipelines_.retired = nullptr;
+  keyed_roots_.Clear([this](KeyedRoot& entry) { EvictKeyedRoot(entry, false); });
+
+  sampler_.SetRate(0);
+
+  // 输出完已入队的报告后再断开 Logger
+  StopReportThread();
   config_conns_.Clear();
   profiler_logger_.reset();
 }
@@ -149,66 +583,467 @@ ProfilerThreadState* ProfilerService::GetOrCreateThreadState() {
     state->stack_depth = 0;
 
     // 彻底清空缓存的根节点数组，防止 ScopedRoot 顺藤摸瓜找到野指针触发崩溃
-    for (int i = 0; i < 32; ++i) {
-      state->thread_roots[i] = nullptr;
-    }
+    std::fill(state->thread_roots,
+              state->thread_roots + state->thread_root_capacity, nullptr);
+
+    // 彻底清空影子栈（保留已扩容的容量）
+    std::fill(state->shadow_stack, state->shadow_stack + state->stack_capacity,
+              nullptr);
 
-    // 彻底清空影子栈
-    for (int i = 0; i < 128; ++i) {
-      state->shadow_stack[i] = nullptr;
+    // 查找缓存里的节点属于上一个实例，地址可能被新实例复用，必须全部作废
+    for (auto& entry : state->child_cache) {
+      entry = ProfilerThreadState::ChildCacheEntry{};
     }
+    state->probe_bits = probe_bits_.get();
+    state->probe_tag = probe_tag_;
+    // 旧实例的环随实例销毁，不能再写
+    state->flight_session = flight_.Session();
+    state->flight_ring = nullptr;
+    state->flight_ring_session = 0;
 
     // 记录新的从属身份
     tls_current_state_service_id = this->instance_id_;
+    tls_alloc_state = state;
+    tls_alloc_state_owner = this->instance_id_;
     state->thread_root_count = 0;  // 必须彻底复位计数器
   }
 
   return state;
 }
 
-void ProfilerService::ReturnTlsNodesToGlobal(
-    const std::vector<AggregatorNode*>& nodes) {
-  if (nodes.empty()) return;
-  std::lock_guard<std::mutex> lock(alloc_mutex_);
-  free_nodes_.insert(free_nodes_.end(), nodes.begin(), nodes.end());
+/**
+ * @brief 把一个指针数组的容量翻倍（不超过 max_capacity），保留前 used 个元素。
+ * @details 初始存储是 ProfilerThreadState 内联的数组，不能释放。
+ */
+static void GrowPointerArray(AggregatorNode**& data,
+                             AggregatorNode** inline_storage, size_t used,
+                             size_t& capacity, size_t max_capacity) {
+  const size_t new_capacity = std::min(capacity * 2, max_capacity);
+  auto* grown = new AggregatorNode*[new_capacity]();
+  std::copy(data, data + used, grown);
+  if (data != inline_storage) delete[] data;
+  data = grown;
+  capacity = new_capacity;
 }
 
-AggregatorNode* ProfilerService::AcquireNode() {
-  // 生命周期安全校验：如果当前线程记录的服务地址与 this
-  // 不同，说明发生了组件热插拔，立刻清空该线程兜里的失效野指针池。
-  if (tls_last_service_id != this->instance_id_) {
-    tls_free_node_count = 0;  // O(1) 瞬间废弃野指针，绝不触发 free()
-    tls_last_service_id = this->instance_id_;
+bool ProfilerService::GrowShadowStack(ProfilerThreadState* state) {
+  if (state->stack_capacity >= ProfilerThreadState::kMaxStackDepth) {
+    stack_overflows_.fetch_add(1, std::memory_order_relaxed);
+    return false;
   }
+  GrowPointerArray(state->shadow_stack, state->inline_stack, state->stack_depth,
+                   state->stack_capacity, ProfilerThreadState::kMaxStackDepth);
+  return true;
+}
 
-  // 2. 优先从 TLS 原始数组中拿
-  if (tls_free_node_count > 0) {
-    AggregatorNode* node = tls_free_nodes[--tls_free_node_count];
-    node->Reset();
-    return node;
+AggregatorNode* ProfilerService::AcquireThreadRoot(ProfilerThreadState* state,
+                                                   ProfileNodeData* data) {
+  AggregatorNode* root = AcquireNode();
+  if (!root) return nullptr;
+  root->static_info = data;
+  // 根探针的数量受代码中的 ROOT 位置数限制，无需上限
+  if (state->thread_root_count == state->thread_root_capacity) {
+    GrowPointerArray(state->thread_roots, state->inline_roots,
+                     state->thread_root_count, state->thread_root_capacity,
+                     std::numeric_limits<size_t>::max());
+  }
+  state->thread_roots[state->thread_root_count++] = root;
+  {
+    std::lock_guard<std::mutex> lock(live_roots_mutex_);
+    live_roots_.push_back(root);
   }
+  return root;
+}
 
-  // 3. 如果 TLS 没货，再去全局池拿
-  std::lock_guard<std::mutex> lock(alloc_mutex_);
-  if (!free_nodes_.empty()) {
-    AggregatorNode* node = free_nodes_.back();
-    free_nodes_.pop_back();
-    node->Reset();
-    return node;
+void ProfilerService::ReleaseThreadRoots(ProfilerThreadState* state) {
+  AggregatorNode** begin = state->thread_roots;
+  AggregatorNode** end = begin + state->thread_root_count;
+  {
+    // 先注销：等正在进行的 SnapshotLiveRoots 结束后才能把节点还回池中
+    std::lock_guard<std::mutex> lock(live_roots_mutex_);
+    live_roots_.erase(std::remove_if(live_roots_.begin(), live_roots_.end(),
+                                     [&](AggregatorNode* root) {
+                                       return std::find(begin, end, root) != end;
+                                     }),
+                      live_roots_.end());
   }
+  for (AggregatorNode** it = begin; it != end; ++it) ReleaseNodeTree(*it);
+  state->thread_root_count = 0;
+}
+
+void ProfilerService::RequestNodeTrim() {
+  {
+    std::lock_guard<std::mutex> lock(report_mutex_);
+    trim_pending_ = true;
+  }
+  report_cv_.notify_one();
+}
+
+std::vector<ProfileReport> ProfilerService::SnapshotLiveRoots() {
+  std::vector<ProfileReport> reports;
+  std::lock_guard<std::mutex> lock(live_roots_mutex_);
+  // 登记读者：快照期间被摘下的旧代要等它结束才回收（见 ReclaimRetired）
+  reader_epoch_.store(retire_epoch_.load(std::memory_order_seq_cst),
+                      std::memory_order_seq_cst);
+  reports.reserve(live_roots_.size());
+  for (AggregatorNode* root : live_roots_) {
+    if (!root->static_info) continue;
+    reports.push_back(TakeSnapshot(root, "Live Snapshot"));
+  }
+  reader_epoch_.store(0, std::memory_order_release);
+  // 事件总线根由钩子线程共同写入：快照期间登记为写入者，换代摘下的旧代暂不回收
+  event_writers_.fetch_add(1, std::memory_order_seq_cst);
+  if (event_bus_.root_node.call_count.load(std::memory_order_relaxed) > 0) {
+    reports.push_back(TakeSnapshot(&event_bus_.root_node, "Live Snapshot"));
+  }
+  event_writers_.fetch_sub(1, std::memory_order_seq_cst);
+  lock_writers_.fetch_add(1, std::memory_order_seq_cst);
+  if (locks_.root_node.call_count.load(std::memory_order_relaxed) > 0) {
+    reports.push_back(TakeSnapshot(&locks_.root_node, "Live Snapshot"));
+  }
+  lock_writers_.fetch_sub(1, std::memory_order_seq_cst);
+  device_writers_.fetch_add(1, std::memory_order_seq_cst);
+  if (devices_.root_node.call_count.load(std::memory_order_relaxed) > 0) {
+    reports.push_back(TakeSnapshot(&devices_.root_node, "Live Snapshot"));
+  }
+  device_writers_.fetch_sub(1, std::memory_order_seq_cst);
+  pipeline_writers_.fetch_add(1, std::memory_order_seq_cst);
+  if (pipelines_.root_node.call_count.load(std::memory_order_relaxed) > 0) {
+    reports.push_back(TakeSnapshot(&pipelines_.root_node, "Live Snapshot"));
+  }
+  pipeline_writers_.fetch_sub(1, std::memory_order_seq_cst);
+  // 分组根：逐个登记为写入者后拍快照，期间既不会被淘汰，旧代也不会被回收
+  keyed_roots_.ForEachLive([&](KeyedRoot& entry) {
+    if (entry.slot.root_node.call_count.load(std::memory_order_relaxed) > 0) {
+      reports.push_back(TakeSnapshot(&entry.slot.root_node, "Live Snapshot"));
+    }
+  });
+  return reports;
+}
+
+void ProfilerService::FlushThreadNodeCache() {
+  node_pool_.Flush(tls_node_cache);
+}
+
+ProfilerMemoryStats ProfilerService::GetMemoryStats() const {
+  ProfilerMemoryStats stats;
+  stats.node_slabs = node_pool_.SlabCount();
+  stats.node_bytes = stats.node_slabs * NodePool::kSlabNodes * sizeof(AggregatorNode);
+  stats.nodes_carved = node_pool_.CarvedNodes();
+  stats.nodes_free_global = node_pool_.GlobalFreeNodes();
+  stats.histograms = histogram_count_.load(std::memory_order_relaxed);
+  {
+    std::lock_guard<std::mutex> lock(cold_mutex_);
+    stats.cold_blocks = cold_stats_.size();
+  }
+  stats.cold_bytes = stats.cold_blocks * sizeof(NodeColdStats);
+  stats.keyed_roots = keyed_roots_.Live();
+  stats.keyed_root_evictions = keyed_roots_.Evictions();
+  stats.node_budget_bytes = node_pool_.NodeLimit() * sizeof(AggregatorNode);
+  stats.nodes_in_use = stats.nodes_carved > stats.nodes_free_global
+                           ? stats.nodes_carved - stats.nodes_free_global
+                           : 0;
+  stats.node_slabs_released = node_pool_.ReleasedSlabs();
+  stats.node_acquire_failures = node_acquire_failures_.load(std::memory_order_relaxed);
+  stats.budget_evictions = budget_evictions_.load(std::memory_order_relaxed);
+  stats.memory_pressure = memory_pressure_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+SamplingProfile ProfilerService::GetSamplingProfile(size_t max_symbols) const {
+  std::vector<std::string> plugin_files;
+  if (auto [query, err] = z3y::TryGetService<z3y::IPluginQuery>(
+          z3y::clsid::kPluginQuery);
+      err == z3y::InstanceError::kSuccess) {
+    plugin_files = query->GetLoadedPluginFiles();
+  }
+  return sampler_.Collect(plugin_files, max_symbols);
+}
+
+TraceCapture ProfilerService::CollectTrace(bool clear) {
+  return tracer_.Collect(clear);
+}
+
+void ProfilerService::AcquireFlightRing(ProfilerThreadState* state) {
+  flight_.Acquire(state);
+}
+
+bool ProfilerService::FreezeFlightRecorder(const std::string& reason) {
+  return flight_.Freeze(reason, false);
+}
+
+std::vector<FlightRecording> ProfilerService::TakeFlightRecordings() {
+  return flight_.Take();
+}
+
+void ProfilerService::SubmitDeviceSpan(std::shared_ptr<IDeviceTimestampSource> source,
+                                       ProfileNodeData* data, uint64_t begin_marker,
+                                       uint64_t end_marker, uint64_t host_begin_ticks) {
+  device_timeline_.Submit(std::move(source), data, begin_marker, end_marker,
+                          host_begin_ticks);
+}
+
+size_t ProfilerService::FlushDeviceSpans(uint32_t timeout_ms) {
+  return device_timeline_.Flush(timeout_ms);
+}
+
+uint32_t ProfilerService::InternTagString(const char* text) {
+  AllocationMute mute;
+  return tag_strings_.Intern(text);
+}
+
+std::vector<LockContentionEntry> ProfilerService::GetLockContention(
+    size_t max_entries) const {
+  return lock_probes_.Snapshot(max_entries);
+}
+
+template <typename Counter>
+void ProfilerService::ReclaimRetiredIfIdle(AsyncSlot* slot,
+                                           const Counter& writers) {
+  AggregatorNode* chain = nullptr;
+  LockSpin(slot->shard_lock);
+  if (writers.load(std::memory_order_seq_cst) == 0) {
+    chain = slot->retired;
+    slot->retired = nullptr;
+  }
+  slot->shard_lock.clear(std::memory_order_release);
+  ReleaseShardChain(chain);
+}
 
-// 4. 扩容路径：如果全局池也没货，且没有超过硬性上限，则创建新节点
-  if (master_nodes_.size() >= 2000000) {
-    return nullptr;  // 达到 200W 个节点上限，触发防爆阀，防止 OOM 撑爆物理内存
+AggregatorNode* ProfilerService::BeginKeyedRoot(ProfileNodeData* site,
+                                                uint64_t key, uint32_t* handle) {
+  if (!site || !enable_.load(std::memory_order_relaxed)) return nullptr;
+  const auto site_id = reinterpret_cast<uintptr_t>(site);
+  KeyedRoot* entry = keyed_roots_.TryPin(site_id, key, handle);
+  if (!entry) {
+    entry = keyed_roots_.Insert(
+        site_id, key, handle,
+        [this](KeyedRoot& victim) { EvictKeyedRoot(victim, true); },
+        [&](KeyedRoot& fresh) {
+          if (key & kKeyedRootInternedKey) {
+            const std::string text =
+                tag_strings_.Lookup(static_cast<uint32_t>(key));
+            std::snprintf(fresh.name, sizeof(fresh.name), "%s [%s]",
+                          site->name ? site->name : "", text.c_str());
+          } else {
+            std::snprintf(fresh.name, sizeof(fresh.name), "%s [%lld]",
+                          site->name ? site->name : "",
+                          static_cast<long long>(key));
+          }
+          fresh.slot.dynamic_info.name = fresh.name;
+          fresh.slot.dynamic_info.file = site->file;
+          fresh.slot.dynamic_info.line = site->line;
+          fresh.slot.root_node.static_info = &fresh.slot.dynamic_info;
+          fresh.last_used.store(ProfilerClock::Now(), std::memory_order_relaxed);
+        });
+    if (!entry) return nullptr;
+  }
+  // LRU 只需粗粒度的时间：同一个键被多个线程高频进入时，避免每次都写同一条缓存行
+  const uint64_t now = ProfilerClock::Now();
+  if (now - entry->last_used.load(std::memory_order_relaxed) >
+      static_cast<uint64_t>(ProfilerClock::TicksPerMs())) {
+    entry->last_used.store(now, std::memory_order_relaxed);
   }
+  return &entry->slot.root_node;
+}
 
-  master_nodes_.push_back(
-      std::make_unique<z3y::interfaces::profiler::AggregatorNode>());
-  z3y::interfaces::profiler::AggregatorNode* node = master_nodes_.back().get();
+void ProfilerService::EndKeyedRoot(uint32_t handle, uint32_t period,
+                                   double sla_ms) {
+  KeyedRoot& entry = keyed_roots_.At(handle);
+  CheckRoot(&entry.slot.root_node, period, sla_ms, &entry.slot);
+  if (KeyedRootTable::Unpin(entry) == 0) {
+    ReclaimRetiredIfIdle(&entry.slot, entry.pins);
+  }
+}
+
+void ProfilerService::EvictKeyedRoot(KeyedRoot& entry, bool report) {
+  AggregatorNode* root = &entry.slot.root_node;
+  if (report && root->call_count.load(std::memory_order_relaxed) > 0 &&
+      (profiler_logger_ || sink_count_.load(std::memory_order_relaxed) > 0)) {
+    GenerateReportAndLog(root, "Evicted (LRU)");
+  }
+  ReleaseChildren(root);
+  ReleaseShardChain(entry.slot.retired);
+  entry.slot.retired = nullptr;
+  root->Reset();
+}
+
+bool ProfilerService::ReadHardwareCounters(HardwareCounterSample& out) {
+  if (!hw_counters_.load(std::memory_order_relaxed)) return false;
+  return tls_hw_counters.Read(out);
+}
+
+void ProfilerService::RecordHardwareCounters(
+    AggregatorNode* node, const HardwareCounterSample& delta) {
+  NodeColdStats* stats = AttachColdStats(node);
+  if (!stats) return;
+  for (size_t i = 0; i < kHardwareCounterCount; ++i) {
+    stats->hw_counters[i].fetch_add(delta[i], std::memory_order_relaxed);
+  }
+  stats->hw_samples.fetch_add(1, std::memory_order_relaxed);
+}
+
+NodeColdStats* ProfilerService::AttachColdStats(AggregatorNode* node) {
+  if (!node) return nullptr;
+  if (NodeColdStats* stats = node->cold.load(std::memory_order_acquire)) {
+    return stats;
+  }
+  AllocationMute mute;
+  // 持锁二次检查：并发挂载同一节点时只分配一块
+  std::lock_guard<std::mutex> lock(cold_mutex_);
+  if (NodeColdStats* stats = node->cold.load(std::memory_order_acquire)) {
+    return stats;
+  }
+  NodeColdStats* stats;
+  if (!cold_free_.empty()) {
+    stats = cold_free_.back();
+    cold_free_.pop_back();
+    stats->Reset();
+  } else {
+    stats = &cold_stats_.emplace_back();
+  }
+  node->cold.store(stats, std::memory_order_release);
+  return stats;
+}
+
+void ProfilerService::RecordPacedFrame(AggregatorNode* root, double cadence_ms,
+                                       uint64_t start_ticks, uint64_t end_ticks) {
+  if (!root || cadence_ms <= 0.0) return;
+  AllocationMute mute;
+  PacingTrack* track = FindPacingTrack(instance_id_, root);
+  if (!track) {
+    // 上一个服务实例留下的条目已经无用
+    tls_pacing.erase(std::remove_if(tls_pacing.begin(), tls_pacing.end(),
+                                    [this](const PacingTrack& t) {
+                                      return t.service_id != instance_id_;
+                                    }),
+                     tls_pacing.end());
+    track = &tls_pacing.emplace_back();
+    track->service_id = instance_id_;
+    track->root = root;
+  }
+  FramePacing& stats = track->stats;
+  stats.cadence_ms = cadence_ms;
+  stats.tolerance = pacing_tolerance_.load(std::memory_order_relaxed);
+
+  // 1. 上一帧开始到本帧开始的间隔，计入上一帧
+  if (track->frames > 0 && start_ticks > track->prev_start) {
+    const double ticks_per_ms = ProfilerClock::TicksPerMs();
+    const double interval = static_cast<double>(start_ticks - track->prev_start) / ticks_per_ms;
+    const double deviation = interval - cadence_ms;
+    if (stats.intervals == 0 || interval < stats.min_interval_ms) stats.min_interval_ms = interval;
+    stats.max_interval_ms = std::max(stats.max_interval_ms, interval);
+    ++stats.intervals;
+    track->sum_interval_ms += interval;
+    track->sum_sq_deviation += deviation * deviation;
+    if (interval > cadence_ms * (1.0 + stats.tolerance)) ++stats.deadline_misses;
+    const auto& bounds = FramePacing::kJitterBounds;
+    const size_t bucket = static_cast<size_t>(
+        std::upper_bound(bounds.begin(), bounds.end(), std::abs(deviation) / cadence_ms) -
+        bounds.begin());
+    ++stats.jitter_histogram[bucket];
+
+    auto& worst = stats.worst_frames;
+    if (worst.size() < FramePacing::kMaxWorstFrames || interval > worst.back().interval_ms) {
+      PacedFrame frame;
+      frame.frame = track->frames;
+      frame.interval_ms = interval;
+      frame.frame_ms = static_cast<double>(track->prev_end - track->prev_start) / ticks_per_ms;
+      frame.gap_ms = std::max(0.0, interval - frame.frame_ms);
+      frame.stages.reserve(track->prev_stages.size());
+      for (const auto& [data, ticks] : track->prev_stages) {
+        frame.stages.emplace_back(data->name ? data->name : "",
+                                  static_cast<double>(ticks) / ticks_per_ms);
+      }
+      std::sort(frame.stages.begin(), frame.stages.end(),
+                [](const auto& a, const auto& b) { return a.second > b.second; });
+      auto pos = std::find_if(worst.begin(), worst.end(), [&](const PacedFrame& f) {
+        return f.interval_ms < interval;
+      });
+      worst.insert(pos, std::move(frame));
+      if (worst.size() > FramePacing::kMaxWorstFrames) worst.pop_back();
+    }
+  }
+
+  // 2. 本帧各直接子节点的耗时：当前累计值减去上一帧结束时的累计值。
+  // 子链表只由本线程修改（插入与换代），遍历不需要加锁
+  track->prev_stages.clear();
+  track->scratch.clear();
+  size_t hint = 0;  // 子链表顺序稳定，按位置先猜一次
+  for (AggregatorNode* child = root->first_child; child; child = child->next_sibling, ++hint) {
+    const ProfileNodeData* data = child->static_info;
+    if (!data || data->type == NodeType::Value || data->type == NodeType::Event) continue;
+    const uint64_t total = child->total_ticks.load(std::memory_order_relaxed);
+    uint64_t last = 0;
+    auto& totals = track->child_totals;
+    if (hint < totals.size() && totals[hint].first == child) {
+      last = totals[hint].second;
+    } else {
+      for (const auto& [node, ticks] : totals) {
+        if (node == child) {
+          last = ticks;
+          break;
+        }
+      }
+    }
+    if (total > last) track->prev_stages.emplace_back(data, total - last);
+    track->scratch.emplace_back(child, total);
+  }
+  track->child_totals.swap(track->scratch);
+  ++track->frames;
+  track->prev_start = start_ticks;
+  track->prev_end = end_ticks;
+}
+
+AggregatorNode* ProfilerService::AcquireNode() {
+  // 生命周期安全校验：线程缓存的换届由节点池按池编号识别（旧池的节点直接丢弃），
+  // 这里只记下本线程最后一次使用的实例，供线程退出时判断根树归属
+  tls_last_service_id = this->instance_id_;
+
+  AllocationMute mute;
+  AggregatorNode* node = node_pool_.Acquire(tls_node_cache);
+  if (!node) {
+    // 达到节点内存预算：放弃记录，由各根在结束时提前换代腾出节点
+    node_acquire_failures_.fetch_add(1, std::memory_order_relaxed);
+    memory_pressure_.store(true, std::memory_order_relaxed);
+    return nullptr;
+  }
+  // 高水位：剩余可用节点 (未映射的预算 + 全局空闲栈) 不足预算的 1/8 时，在耗尽之前开始淘汰
+  const size_t limit = node_pool_.NodeLimit();
+  const size_t resident = node_pool_.ResidentNodes();
+  if (resident > limit - limit / 8 &&
+      limit - std::min(limit, resident) + node_pool_.GlobalFreeNodes() < limit / 8 &&
+      !memory_pressure_.load(std::memory_order_relaxed)) {
+    memory_pressure_.store(true, std::memory_order_relaxed);
+  }
   node->Reset();
+  node->first_child = nullptr;
+  node->next_sibling = nullptr;
+  node->thread_owned = false;
+  AttachHistogram(node);
   return node;
 }
 
+void ProfilerService::AttachHistogram(AggregatorNode* node) {
+  // 节点尚未发布给任何线程，可以直接替换直方图
+  const uint32_t bits = histogram_bits_.load(std::memory_order_relaxed);
+  if (bits == 0) {
+    if (node->histogram) {
+      node->histogram.reset();
+      histogram_count_.fetch_sub(1, std::memory_order_relaxed);
+    }
+    return;
+  }
+  if (node->histogram && node->histogram->GetPrecisionBits() == bits) return;
+  if (!node->histogram &&
+      histogram_count_.fetch_add(1, std::memory_order_relaxed) >=
+          kMaxHistograms) {
+    histogram_count_.fetch_sub(1, std::memory_order_relaxed);
+    return;  // 达到上限：该节点只统计 Avg/Min/Max
+  }
+  node->histogram = std::make_unique<LogHistogram>(bits);
+}
+
 void ProfilerService::ReleaseNodeTree(
     z3y::interfaces::profiler::AggregatorNode* node) {
   if (!node) return;
@@ -216,21 +1051,9 @@ void ProfilerService::ReleaseNodeTree(
   // 1. 先释放它的所有子节点（保留你原有的树遍历逻辑）
   ReleaseChildren(node);
 
-  // 2.
-  // 跨边界防御：实例换届检查，防止把当前实例的节点塞进上一个实例残留的数组逻辑里
-  if (tls_last_service_id != this->instance_id_) {
-    tls_free_node_count = 0;
-    tls_last_service_id = this->instance_id_;
-  }
-
-  // 3. 极速归还：尝试塞回本线程的无锁口袋
-  if (tls_free_node_count < 256) {
-    tls_free_nodes[tls_free_node_count++] = node;
-  } else {
-    // 4. 溢出归还：如果口袋满了 (超过 256 个)，则归还给中央全局池
-    std::lock_guard<std::mutex> lock(alloc_mutex_);
-    free_nodes_.push_back(node);
-  }
+  // 2. 归还到本线程缓存；缓存满一批时整批推入全局无锁栈
+  tls_last_service_id = this->instance_id_;
+  node_pool_.Release(tls_node_cache, node);
 }
 
 void ProfilerService::ReleaseChildren(AggregatorNode* parent) {
@@ -250,26 +1073,44 @@ void ProfilerService::ReleaseChildren(AggregatorNode* parent) {
   }
   AggregatorNode* detached_child_tree = parent->first_child;
   parent->first_child = nullptr;
+  // 使所有线程缓存里指向这批子节点的条目失效
+  parent->child_epoch.fetch_add(1, std::memory_order_release);
   parent->lock.clear(std::memory_order_release);
 
-  if (detached_child_tree) {
+  // 子节点经 next_sibling 串联，必须逐个归还，否则兄弟节点会永久游离在池外
+  while (detached_child_tree) {
+    AggregatorNode* next = detached_child_tree->next_sibling;
+    detached_child_tree->next_sibling = nullptr;
     ReleaseNodeTree(detached_child_tree);
+    detached_child_tree = next;
   }
 }
 
 void ProfilerService::SubmitRootForCheck(AggregatorNode* root, uint32_t period,
                                          double sla_ms) {
+  CheckRoot(root, period, sla_ms, nullptr);
+}
+
+void ProfilerService::CheckRoot(AggregatorNode* root, uint32_t period,
+                                double sla_ms, AsyncSlot* slot) {
+  if (!root) return;
+  AllocationMute mute;
+  // 节拍根的帧间隔状态在拥有它的线程上，异步槽位的共享根没有
+  PacingTrack* pacing = slot ? nullptr : FindPacingTrack(instance_id_, root);
   bool is_enabled = enable_.load(std::memory_order_relaxed);
-  if (!is_enabled || !profiler_logger_) {
-    if (root) {
+  if (!is_enabled ||
+      (!profiler_logger_ && sink_count_.load(std::memory_order_relaxed) == 0)) {
+    if (pacing) TakePacing(*pacing);
+    if (AggregatorNode* old = DetachGeneration(root, true)) {
+      RetireGeneration(old, slot);
+    } else if (!slot) {
+      // 节点池已满：原地清理，持锁挡住并发的实时快照
+      std::lock_guard<std::mutex> lock(live_roots_mutex_);
       ReleaseChildren(root);
-      auto* saved_info = root->static_info;  // [修复] 保存节点身份
       root->Reset();
-      root->static_info = saved_info;  // [修复] 恢复节点身份
     }
     return;
   }
-  if (!root) return;
 
   // [修改] 原子自增并获取当前值
   uint64_t current_calls =
@@ -283,209 +1124,804 @@ void ProfilerService::SubmitRootForCheck(AggregatorNode* root, uint32_t period,
   bool should_report =
       (effective_sla > 0.0 && current_total_ms > effective_sla) ||
       (period > 0 && current_calls >= period);
+  // 内存压力：未到周期也提前换代，旧代输出后整代回收
+  const bool evict = !should_report && memory_pressure_.load(std::memory_order_relaxed);
 
-  if (should_report) {
+  if (should_report || evict) {
     std::string reason;
-    if (effective_sla > 0.0 && current_total_ms > effective_sla) {
+    if (evict) {
+      budget_evictions_.fetch_add(1, std::memory_order_relaxed);
+      reason = fmt::format("Memory Budget (Limit: {} MB)",
+                           node_pool_.NodeLimit() * sizeof(AggregatorNode) >> 20);
+    } else if (effective_sla > 0.0 && current_total_ms > effective_sla) {
       reason =
           fmt::format("SLA Timeout (Limit: {:.1f}ms, Actual: {:.1f}ms)",
                       effective_sla, current_total_ms);  // [修改] 使用快照变量
+      size_t flight_events = 0;
+      if (flight_.Freeze(reason, true, &flight_events) && profiler_logger_) {
+        Z3Y_LOG_WARN(profiler_logger_,
+                     "[Profiler] Flight recorder frozen ({} events): {}",
+                     flight_events, reason);
+      }
     } else {
       reason = fmt::format("Periodic Tick (Period: {})", period);
     }
-    GenerateReportAndLog(root, reason);
-    // 汇报完毕后，清理子树数据准备下一个周期的积攒
-    ReleaseChildren(root);
+    FramePacing frame_pacing;
+    if (pacing) frame_pacing = TakePacing(*pacing);
+    // 先换代：之后的写入进入 root 上的新一代，报告只读摘下来的旧代
+    if (AggregatorNode* old = DetachGeneration(root, true)) {
+      GenerateReportAndLog(old, reason, &frame_pacing);
+      RetireGeneration(old, slot);
+      return;
+    }
+    // 节点池已满，无法换代：退回原地输出。共享根的子树仍可能有写入者，保留不回收
+    GenerateReportAndLog(root, reason, &frame_pacing);
+    if (!slot) {
+      std::lock_guard<std::mutex> lock(live_roots_mutex_);
+      ReleaseChildren(root);
+    }
     auto* saved_info = root->static_info;  // [修复] 保存节点身份
     root->Reset();
     root->static_info = saved_info;  // [修复] 恢复节点身份
   }
 }
 
-void ProfilerService::GenerateReportAndLog(AggregatorNode* root,
-                                           const std::string& reason) {
-  std::string report = fmt::format(
-      "\n[Z3Y Profiler] Performance Report | Trigger: {}\n", reason);
-  for (size_t i = 0; i < root->tag_count; ++i) {
-    report += fmt::format("Global Context: [{}: {}] ", root->tags[i].key,
-                          root->tags[i].value);
+AggregatorNode* ProfilerService::DetachGeneration(AggregatorNode* root,
+                                                  bool with_stats) {
+  if (!with_stats) {
+    LockSpin(root->lock);
+    const bool empty = root->first_child == nullptr;
+    root->lock.clear(std::memory_order_release);
+    if (empty) return nullptr;
+  }
+  AggregatorNode* shell = AcquireNode();
+  if (!shell) return nullptr;
+  shell->static_info = root->static_info;
+  if (with_stats) {
+    // 计数用 exchange 搬走，并发写入不会丢；冷数据块（标签、硬件计数器）与壳节点的
+    // 空块对调，不复制也不新分配。直方图是普通指针，只能合并后清零
+    shell->call_count.store(root->call_count.exchange(0, std::memory_order_relaxed),
+                            std::memory_order_relaxed);
+    shell->total_ticks.store(
+        root->total_ticks.exchange(0, std::memory_order_relaxed),
+        std::memory_order_relaxed);
+    shell->max_ticks.store(root->max_ticks.exchange(0, std::memory_order_relaxed),
+                           std::memory_order_relaxed);
+    shell->min_ticks.store(
+        root->min_ticks.exchange(std::numeric_limits<uint64_t>::max(),
+                                 std::memory_order_relaxed),
+        std::memory_order_relaxed);
+    shell->alloc_count.store(
+        root->alloc_count.exchange(0, std::memory_order_relaxed),
+        std::memory_order_relaxed);
+    shell->alloc_bytes.store(
+        root->alloc_bytes.exchange(0, std::memory_order_relaxed),
+        std::memory_order_relaxed);
+    shell->cold.store(
+        root->cold.exchange(shell->cold.load(std::memory_order_relaxed),
+                            std::memory_order_acq_rel),
+        std::memory_order_release);
+    if (shell->histogram && root->histogram) {
+      shell->histogram->Merge(*root->histogram);
+    }
+    if (root->histogram) root->histogram->Reset();
+  }
+  // 【原子换代】持锁只交换子链表指针；epoch +1 让各线程缓存里指向旧子节点的条目失效，
+  // 正在旧代节点上计时的作用域照常写完，数据计入旧代
+  LockSpin(root->lock);
+  shell->first_child = root->first_child;
+  root->first_child = nullptr;
+  root->child_epoch.fetch_add(1, std::memory_order_release);
+  root->lock.clear(std::memory_order_release);
+  return shell;
+}
+
+void ProfilerService::RetireGeneration(AggregatorNode* generation,
+                                       AsyncSlot* slot) {
+  if (!generation) return;
+  if (slot) {
+    // 其他 Worker 可能仍在旧代上计时：挂在槽位上，随最后一个引用一起回收
+    LockSpin(slot->shard_lock);
+    generation->next_sibling = slot->retired;
+    slot->retired = generation;
+    slot->shard_lock.clear(std::memory_order_release);
+    return;
+  }
+  // 纪元在换代之后推进：此后开始的实时快照只能看到新一代
+  const uint64_t epoch = retire_epoch_.fetch_add(1, std::memory_order_seq_cst);
+  {
+    std::lock_guard<std::mutex> lock(report_mutex_);
+    if (report_thread_.joinable() && !report_stop_) {
+      retired_.push_back({generation, epoch});
+      report_cv_.notify_one();
+      return;
+    }
+  }
+  // 报告线程未运行（Initialize 之前 / Shutdown 之后）：就地等待快照读者离开
+  for (uint64_t reader = reader_epoch_.load(std::memory_order_seq_cst);
+       reader != 0 && reader <= epoch;
+       reader = reader_epoch_.load(std::memory_order_seq_cst)) {
+    std::this_thread::yield();
+  }
+  ReleaseNodeTree(generation);
+}
+
+void ProfilerService::ReclaimRetired(std::unique_lock<std::mutex>& lock) {
+  // 读者记下的是它开始时的纪元：只有在它之后摘下的代才可能仍被它引用
+  const uint64_t reader = reader_epoch_.load(std::memory_order_seq_cst);
+  std::vector<AggregatorNode*> ready;
+  auto keep = std::remove_if(retired_.begin(), retired_.end(),
+                             [&](const RetiredGeneration& g) {
+                               if (reader != 0 && reader <= g.epoch) return false;
+                               ready.push_back(g.node);
+                               return true;
+                             });
+  retired_.erase(keep, retired_.end());
+  if (ready.empty()) return;
+  ++reports_in_flight_;
+  lock.unlock();
+  for (AggregatorNode* node : ready) ReleaseNodeTree(node);
+  lock.lock();
+  --reports_in_flight_;
+  trim_pending_ = true;
+}
+
+void ProfilerService::ReleaseShardChain(AggregatorNode* chain) {
+  while (chain) {
+    AggregatorNode* next = chain->next_sibling;
+    chain->next_sibling = nullptr;
+    ReleaseNodeTree(chain);
+    chain = next;
+  }
+}
+
+void ProfilerService::MergeShardTree(AggregatorNode* dst,
+                                     AggregatorNode* shard) {
+  if (!dst || !shard) return;
+  MergeNodeRecursive(dst, shard);
+  ReleaseNodeTree(shard);
+}
+
+void ProfilerService::MergeNodeRecursive(AggregatorNode* dst,
+                                         AggregatorNode* src) {
+  const uint64_t count = src->call_count.load(std::memory_order_relaxed);
+  if (count > 0) {
+    dst->call_count.fetch_add(count, std::memory_order_relaxed);
+    dst->total_ticks.fetch_add(src->total_ticks.load(std::memory_order_relaxed),
+                               std::memory_order_relaxed);
+    AtomicUpdateMaxU64(dst->max_ticks,
+                       src->max_ticks.load(std::memory_order_relaxed));
+    AtomicUpdateMinU64(dst->min_ticks,
+                       src->min_ticks.load(std::memory_order_relaxed));
+    if (dst->histogram && src->histogram) {
+      dst->histogram->Merge(*src->histogram);
+    }
+  }
+  if (const uint64_t allocs = src->alloc_count.load(std::memory_order_relaxed)) {
+    dst->alloc_count.fetch_add(allocs, std::memory_order_relaxed);
+    dst->alloc_bytes.fetch_add(src->alloc_bytes.load(std::memory_order_relaxed),
+                               std::memory_order_relaxed);
+  }
+  if (const NodeColdStats* from = src->cold.load(std::memory_order_acquire)) {
+    NodeColdStats* to = AttachColdStats(dst);
+    if (count > 0) {
+      AtomicAddDouble(to->sum_value_bits, src->GetSumValue());
+      AtomicUpdateMax(to->max_value_bits, src->GetMaxValue());
+      AtomicUpdateMin(to->min_value_bits, src->GetMinValue());
+    }
+    for (const TagData& tag : from->tags) {
+      if (const char* key = tag.key.load(std::memory_order_acquire)) {
+        to->AddTag(key, tag.value);
+      }
+    }
+    for (const TagValueCount& slot : from->tag_values) {
+      if (const char* key = slot.key.load(std::memory_order_acquire)) {
+        to->CountTagValue(key, slot.kind, slot.value,
+                          slot.count.load(std::memory_order_relaxed));
+      }
+    }
+    if (const uint64_t lost =
+            from->tag_value_overflow.load(std::memory_order_relaxed)) {
+      to->tag_value_overflow.fetch_add(lost, std::memory_order_relaxed);
+    }
+  }
+
+  // 影子树已不再被写入，无需加锁即可遍历
+  for (AggregatorNode* child = src->first_child; child;
+       child = child->next_sibling) {
+    if (AggregatorNode* peer =
+            FindOrCreateNode(this, child->static_info, dst)) {
+      MergeNodeRecursive(peer, child);
+    }
+  }
+}
+
+void ProfilerService::CalibrateOverhead() {
+  static ProfileNodeData s_root{"Profiler_Calibration_Root", __FILE__,
+                                __LINE__, NodeType::Timer};
+  static ProfileNodeData s_probe{"Profiler_Calibration", __FILE__, __LINE__,
+                                 NodeType::Timer};
+  static constexpr int kRounds = 7;
+  static constexpr uint64_t kIterations = 2000;
+
+  // 与 ScopedTimer 的热路径相同：缓存命中的 FindOrCreateNode + 两次读时钟 + 累加。
+  // 取多轮中的最小值，排除被抢占的轮次
+  AggregatorNode root;
+  root.static_info = &s_root;
+  auto tls = std::make_unique<ProfilerThreadState>();
+  uint64_t best_outer = std::numeric_limits<uint64_t>::max();
+  uint64_t best_self = std::numeric_limits<uint64_t>::max();
+  for (int round = 0; round < kRounds; ++round) {
+    AggregatorNode* node = FindOrCreateNode(this, &s_probe, &root, tls.get());
+    if (!node) break;
+    const uint64_t self_before = node->total_ticks.load(std::memory_order_relaxed);
+    const uint64_t begin = ProfilerClock::Now();
+    for (uint64_t i = 0; i < kIterations; ++i) {
+      AggregatorNode* hot = FindOrCreateNode(this, &s_probe, &root, tls.get());
+      const uint64_t start = ProfilerClock::Now();
+      hot->RecordTicks(ProfilerClock::Now() - start);
+    }
+    const uint64_t end = ProfilerClock::Now();
+    best_outer = std::min(best_outer, (end - begin) / kIterations);
+    best_self = std::min(
+        best_self,
+        (node->total_ticks.load(std::memory_order_relaxed) - self_before) /
+            kIterations);
+  }
+  ReleaseChildren(&root);
+  if (best_outer == std::numeric_limits<uint64_t>::max()) return;
+  probe_outer_ticks_ = best_outer;
+  probe_self_ticks_ = std::min(best_self, best_outer);
+}
+
+void ProfilerService::CompensateOverhead(ProfileReport& report) const {
+  if (!compensate_.load(std::memory_order_relaxed) || probe_outer_ticks_ == 0)
+    return;
+  const double self_ms = ProfilerClock::TicksToMs(probe_self_ticks_);
+  const double outer_ms = ProfilerClock::TicksToMs(probe_outer_ticks_);
+  report.probe_self_ns = self_ms * 1e6;
+  report.probe_overhead_ns = outer_ms * 1e6;
+
+  // 先序数组逆序遍历即可自底向上累加每个节点的计时后代调用数
+  auto& nodes = report.nodes;
+  std::vector<uint64_t> timed_descendants(nodes.size(), 0);
+  for (size_t i = nodes.size(); i-- > 0;) {
+    ReportNode& node = nodes[i];
+    const bool timed =
+        node.type == NodeType::Timer || node.type == NodeType::Linear;
+    if (node.parent >= 0) {
+      timed_descendants[static_cast<size_t>(node.parent)] +=
+          timed_descendants[i] + (timed ? node.count : 0);
+    }
+    if (!timed) continue;
+    // 根节点的计时由 ScopedRoot / 异步流完成，不属于探针，只扣后代开销
+    const double own = node.parent >= 0 ? node.count * self_ms : 0.0;
+    const double overhead = own + timed_descendants[i] * outer_ms;
+    node.total_ms = std::max(0.0, node.total_ms - overhead);
+  }
+  if (!nodes.empty()) report.root_ms = nodes.front().total_ms;
+}
+
+// 后台队列上限：输出跟不上时丢弃新报告，绝不让触发线程阻塞
+static constexpr size_t kMaxPendingReports = 64;
+
+void ProfilerService::CollectTagValues(const NodeColdStats& cold,
+                                       ReportNode& out) const {
+  for (const TagValueCount& slot : cold.tag_values) {
+    const char* key = slot.key.load(std::memory_order_acquire);
+    if (!key) continue;
+    std::string value;
+    switch (slot.kind) {
+      case TagValueKind::Integer:
+      case TagValueKind::Enum:
+        value = std::to_string(static_cast<int64_t>(slot.value));
+        break;
+      case TagValueKind::Interned:
+        value = tag_strings_.Lookup(slot.value);
+        break;
+    }
+    const uint64_t count = slot.count.load(std::memory_order_relaxed);
+    auto it = std::find_if(out.tag_values.begin(), out.tag_values.end(),
+                           [&](const TagValueStat& s) {
+                             return s.key == key && s.value == value;
+                           });
+    if (it != out.tag_values.end()) {
+      it->count += count;
+    } else {
+      out.tag_values.push_back({key, std::move(value), count});
+    }
+  }
+  // 同一个键的值排在一起，键内按次数降序
+  std::stable_sort(out.tag_values.begin(), out.tag_values.end(),
+                   [](const TagValueStat& a, const TagValueStat& b) {
+                     return a.key != b.key ? a.key < b.key : a.count > b.count;
+                   });
+  out.tag_value_overflow = cold.tag_value_overflow.load(std::memory_order_relaxed);
+}
+
+namespace {
+/// 把节点直方图导出为与时钟频率无关的稀疏桶：Timer 的 tick 桶按中点换算成纳秒后重新分桶
+void ExportHistogram(const LogHistogram& histogram, NodeType type, ReportNode& out) {
+  const uint32_t bits = histogram.GetPrecisionBits();
+  const double ns_per_tick = 1.0e6 / ProfilerClock::TicksPerMs();
+  out.histogram_bits = bits;
+  for (size_t i = 0, n = LogHistogram::BucketCount(bits); i < n; ++i) {
+    const uint64_t c = histogram.BucketValue(i);
+    if (c == 0) continue;
+    size_t index = i;
+    if (type != NodeType::Value) {
+      const double ns =
+          static_cast<double>(LogHistogram::MidpointOf(bits, i)) * ns_per_tick;
+      index = LogHistogram::IndexOf(bits, static_cast<uint64_t>(ns + 0.5));
+    }
+    // tick 比纳秒粗时多个桶可能落到同一个纳秒桶；下标单调不减，只需与末尾合并
+    if (!out.histogram.empty() && out.histogram.back().first == index) {
+      out.histogram.back().second += c;
+    } else {
+      out.histogram.emplace_back(static_cast<uint32_t>(index), c);
+    }
+  }
+}
+}  // namespace
+
+ProfileReport ProfilerService::TakeSnapshot(AggregatorNode* root,
+                                            const std::string& reason) {
+  ProfileReport report;
+  report.reason = reason;
+  report.root_ms = root->GetTotalTimeMs();
+
+  // 显式栈先序遍历：整棵树只用一个待访问数组，不再为每个节点分配快照 vector
+  struct Pending {
+    AggregatorNode* node;
+    uint32_t depth;
+    int32_t parent;
+  };
+  std::vector<Pending> stack;
+  stack.reserve(32);
+  stack.push_back({root, 0, -1});
+  while (!stack.empty()) {
+    const Pending item = stack.back();
+    stack.pop_back();
+    AggregatorNode* node = item.node;
+    if (!node->static_info) continue;
+
+    const auto index = static_cast<int32_t>(report.nodes.size());
+    ReportNode& out = report.nodes.emplace_back();
+    const NodeType type = node->static_info->type;
+    out.name = node->static_info->name ? node->static_info->name : "";
+    out.file = node->static_info->file ? node->static_info->file : "";
+    out.line = node->static_info->line;
+    out.type = type;
+    out.depth = item.depth;
+    out.parent = item.parent;
+    out.count = node->call_count.load(std::memory_order_relaxed);
+    out.total_ms = node->GetTotalTimeMs();
+    out.min_ms = node->GetMinTimeMs();
+    out.max_ms = node->GetMaxTimeMs();
+    out.sum_value = node->GetSumValue();
+    out.max_value = node->GetMaxValue();
+    out.alloc_count = node->alloc_count.load(std::memory_order_relaxed);
+    out.alloc_bytes = node->alloc_bytes.load(std::memory_order_relaxed);
+    if (node->histogram && out.count > 0 && type != NodeType::Event) {
+      static constexpr double kQuantiles[4] = {0.50, 0.95, 0.99, 0.999};
+      out.has_percentiles = true;
+      for (size_t q = 0; q < 4; ++q) {
+        out.percentiles[q] = type == NodeType::Value
+                                 ? node->GetValuePercentile(kQuantiles[q])
+                                 : node->GetPercentileMs(kQuantiles[q]);
+      }
+      ExportHistogram(*node->histogram, type, out);
+    }
+    if (const NodeColdStats* cold = node->cold.load(std::memory_order_acquire)) {
+      for (const TagData& tag : cold->tags) {
+        if (const char* key = tag.key.load(std::memory_order_acquire)) {
+          out.tags.emplace_back(key, tag.value);
+        }
+      }
+      CollectTagValues(*cold, out);
+      out.hw_samples = cold->hw_samples.load(std::memory_order_relaxed);
+      for (size_t i = 0; i < kHardwareCounterCount; ++i) {
+        out.hw_counters[i] = cold->hw_counters[i].load(std::memory_order_relaxed);
+      }
+    }
+
+    // 持锁只做指针拷贝；逆序压栈，使第一个子节点最先弹出
+    const size_t mark = stack.size();
+    LockSpin(node->lock);
+    for (AggregatorNode* child = node->first_child; child;
+         child = child->next_sibling) {
+      stack.push_back({child, item.depth + 1, index});
+    }
+    node->lock.clear(std::memory_order_release);
+    std::reverse(stack.begin() + static_cast<std::ptrdiff_t>(mark), stack.end());
+  }
+  CompensateOverhead(report);
+  return report;
+}
+
+/**
+ * @brief 把报告快照格式化为日志文本（格式与早期的同步实现保持一致）。
+ */
+static std::string FormatTextReport(const ProfileReport& report) {
+  std::string output = fmt::format(
+      "\n[Z3Y Profiler] Performance Report | Trigger: {}\n", report.reason);
+  if (!report.nodes.empty()) {
+    const auto& root_tags = report.nodes.front().tags;
+    for (const auto& tag : root_tags) {
+      output += fmt::format("Global Context: [{}: {}] ", tag.first, tag.second);
+    }
+    if (!root_tags.empty()) output += "\n";
+  }
+  if (report.depth_overflows > 0) {
+    output += fmt::format(
+        "Warning: {} probes skipped (shadow stack deeper than {} levels)\n",
+        report.depth_overflows, ProfilerThreadState::kMaxStackDepth);
   }
-  if (root->tag_count > 0) report += "\n";
 
-  report +=
+  if (report.pacing.cadence_ms > 0.0) {
+    const FramePacing& pacing = report.pacing;
+    output += fmt::format(
+        "Pacing: Cadence {:.3f} ms | Intervals: {} | Deadline Misses: {} (> {:.3f} ms) | "
+        "Interval Min/Avg/Max: {:.3f}/{:.3f}/{:.3f} ms | Jitter RMS: {:.3f} ms\n",
+        pacing.cadence_ms, pacing.intervals, pacing.deadline_misses,
+        pacing.cadence_ms * (1.0 + pacing.tolerance), pacing.min_interval_ms,
+        pacing.mean_interval_ms, pacing.max_interval_ms, pacing.jitter_rms_ms);
+    output += "Jitter (|interval - cadence|):";
+    for (size_t b = 0; b < FramePacing::kJitterBuckets; ++b) {
+      output += b < FramePacing::kJitterBounds.size()
+                    ? fmt::format(" <{:g}%: {}", FramePacing::kJitterBounds[b] * 100.0,
+                                  pacing.jitter_histogram[b])
+                    : fmt::format(" >={:g}%: {}", FramePacing::kJitterBounds.back() * 100.0,
+                                  pacing.jitter_histogram[b]);
+    }
+    output += "\n";
+    for (const PacedFrame& frame : pacing.worst_frames) {
+      output += fmt::format("  Worst Frame #{}: {:.3f} ms = Frame {:.3f} ms + Gap {:.3f} ms",
+                            frame.frame, frame.interval_ms, frame.frame_ms, frame.gap_ms);
+      for (size_t t = 0; t < frame.stages.size(); ++t) {
+        output += fmt::format("{} {} {:.3f} ms", t ? "," : " |", frame.stages[t].first,
+                              frame.stages[t].second);
+      }
+      output += "\n";
+    }
+  }
+
+  output +=
       "========================================================================"
       "===========\n";
-  report +=
+  // 开启分配统计后多出两列：作用域自身的分配次数与字节数
+  const bool show_allocs =
+      std::any_of(report.nodes.begin(), report.nodes.end(),
+                  [](const ReportNode& node) { return node.alloc_count > 0; });
+  output +=
       "Node Name                             Count     Avg(ms)   Min(ms)   "
-      "Max(ms)   %Time\n";
-  report +=
+      "Max(ms)   %Time";
+  output += show_allocs ? "   Allocs    Bytes\n" : "\n";
+  output +=
       "------------------------------------------------------------------------"
       "-----------\n";
 
-  FormatTimerRecursive(report, root, 0, root->GetTotalTimeMs());
-
-  report +=
-      "------------------------------------------------------------------------"
-      "-----------\n";
-  report += "[Metrics]\n";
-  FormatMetricsRecursive(report, root);
-  report +=
-      "========================================================================"
-      "===========\n";
-
-  // 注意：极高频工业环境，强烈建议底层 Logger 实现采用异步文件队列机制（Async
-  // Sink），防止 IO 阻滞。
-  z3y::interfaces::core::LogSourceLocation loc{__FILE__, __LINE__,
-                                               __FUNCTION__};
-  profiler_logger_->Log(loc, z3y::interfaces::core::LogLevel::Warn,
-                        report.c_str());
-}
-
-void ProfilerService::FormatTimerRecursive(std::string& output,
-                                           AggregatorNode* node, int depth,
-                                           double root_ms) {
-  if (!node || !node->static_info) return;
-  if (node->static_info->type != NodeType::Value &&
-      node->static_info->type != NodeType::Event) {
-    std::string indent(depth * 2, ' ');
-    std::string prefix = (depth > 0) ? "|- " : "";
-    std::string raw_name = indent + prefix + node->static_info->name;
+  for (const ReportNode& node : report.nodes) {
+    if (node.type == NodeType::Value || node.type == NodeType::Event) continue;
+    std::string indent(node.depth * 2, ' ');
+    std::string prefix = (node.depth > 0) ? "|- " : "";
+    std::string raw_name = indent + prefix + node.name;
     if (raw_name.length() > 34) raw_name = raw_name.substr(0, 31) + "...";
 
-    // [修复] 提前通过 load() 取出常规数值快照
-    uint64_t current_count = node->call_count.load(std::memory_order_relaxed);
-
-    // 后面的算术运算和格式化，全部使用 current_count 这个普通变量
-    double avg =
-        current_count > 0 ? (node->GetTotalTimeMs() / current_count) : 0.0;
+    double avg = node.count > 0 ? (node.total_ms / node.count) : 0.0;
     double percent =
-        (root_ms > 0) ? (node->GetTotalTimeMs() / root_ms * 100.0) : 100.0;
+        (report.root_ms > 0) ? (node.total_ms / report.root_ms * 100.0) : 100.0;
     if (percent > 100.0) percent = 100.0;
 
-    output += fmt::format("{:<37} {:<9} {:<9.2f} {:<9.2f} {:<9.2f} {:.1f}%\n",
-                          raw_name, current_count, avg, node->GetMinTimeMs(),
-                          node->GetMaxTimeMs(), percent);
+    const std::string time_share = fmt::format("{:.1f}%", percent);
+    if (show_allocs) {
+      output += fmt::format(
+          "{:<37} {:<9} {:<9.2f} {:<9.2f} {:<9.2f} {:<7} {:<9} {}\n", raw_name,
+          node.count, avg, node.min_ms, node.max_ms, time_share,
+          node.alloc_count, node.alloc_bytes);
+    } else {
+      output += fmt::format("{:<37} {:<9} {:<9.2f} {:<9.2f} {:<9.2f} {}\n",
+                            raw_name, node.count, avg, node.min_ms, node.max_ms,
+                            time_share);
+    }
 
-    for (size_t i = 0; i < node->tag_count; ++i) {
-      output += fmt::format("{}  |- [Tag] {}: {}\n", indent, node->tags[i].key,
-                            node->tags[i].value);
+    if (node.has_percentiles) {
+      output += fmt::format(
+          "{}  |- [Pct] p50: {:.3f}  p95: {:.3f}  p99: {:.3f}  p999: {:.3f} "
+          "(ms)\n",
+          indent, node.percentiles[0], node.percentiles[1],
+          node.percentiles[2], node.percentiles[3]);
+    }
+    if (node.hw_samples > 0) {
+      const double per_call = 1.0 / static_cast<double>(node.hw_samples);
+      const auto& hw = node.hw_counters;
+      const double ipc =
+          hw[1] > 0 ? static_cast<double>(hw[0]) / static_cast<double>(hw[1])
+                    : 0.0;
+      output += fmt::format(
+          "{}  |- [HW] IPC: {:.2f}  Instr: {:.0f}  Cycles: {:.0f}  "
+          "LLC Miss: {:.0f}  Branch Miss: {:.0f} (per call)\n",
+          indent, ipc, hw[0] * per_call, hw[1] * per_call, hw[2] * per_call,
+          hw[3] * per_call);
+    }
+    for (const auto& tag : node.tags) {
+      output +=
+          fmt::format("{}  |- [Tag] {}: {}\n", indent, tag.first, tag.second);
+    }
+    for (size_t t = 0; t < node.tag_values.size(); ++t) {
+      const TagValueStat& tag = node.tag_values[t];
+      if (t == 0 || node.tag_values[t - 1].key != tag.key) {
+        output += fmt::format("{}  |- [Tag] {}:", indent, tag.key);
+      }
+      output += fmt::format(" {} x{}", tag.value, tag.count);
+      if (t + 1 == node.tag_values.size() || node.tag_values[t + 1].key != tag.key) {
+        output += "\n";
+      }
+    }
+    if (node.tag_value_overflow > 0) {
+      output += fmt::format("{}  |- [Tag] (other values) x{}\n", indent,
+                            node.tag_value_overflow);
     }
   }
 
-  // 将快照数组的声明和预分配移到【获取锁的外面】
-  std::vector<AggregatorNode*> snapshot;
-  snapshot.reserve(16);  // [新增] 预先分配好内存，避免在锁内触发 new
+  output +=
+      "------------------------------------------------------------------------"
+      "-----------\n";
+  output += "[Metrics]\n";
+  for (const ReportNode& node : report.nodes) {
+    if (node.type == NodeType::Value) {
+      double avg = node.count > 0 ? (node.sum_value / node.count) : 0.0;
+      output += fmt::format(
+          " |- {:<26} (Value)  Count: {:<6} Avg: {:<8.2f} Max: {:.2f}",
+          node.name, node.count, avg, node.max_value);
+      if (node.has_percentiles) {
+        output += fmt::format("  p50: {:.2f} p95: {:.2f} p99: {:.2f}",
+                              node.percentiles[0], node.percentiles[1],
+                              node.percentiles[2]);
+      }
+      output += "\n";
+    } else if (node.type == NodeType::Event) {
+      output += fmt::format(" |- {:<26} (Event)  Total Occurrences: {}\n",
+                            node.name, node.count);
+    }
+  }
+  output +=
+      "========================================================================"
+      "===========\n";
+  return output;
+}
 
-  while (node->lock.test_and_set(std::memory_order_acquire)) {
-#if defined(_MSC_VER) || defined(__i386__) || defined(__x86_64__)
-    _mm_pause();
-#elif defined(__arm__) || defined(__aarch64__)
-    __asm__ volatile("yield");
-#endif
+void ProfilerService::GenerateReportAndLog(AggregatorNode* root,
+                                           const std::string& reason,
+                                           FramePacing* pacing) {
+  ProfileReport report = TakeSnapshot(root, reason);
+  if (pacing) report.pacing = std::move(*pacing);
+  // 溢出计数只交给真正输出的报告；实时快照不取走它
+  report.depth_overflows = stack_overflows_.exchange(0, std::memory_order_relaxed);
+  {
+    std::lock_guard<std::mutex> lock(report_mutex_);
+    if (report_thread_.joinable() && !report_stop_) {
+      if (report_queue_.size() >= kMaxPendingReports) {
+        ++dropped_reports_;
+        return;
+      }
+      report_queue_.push_back(std::move(report));
+      report_cv_.notify_one();
+      return;
+    }
   }
+  // 后台线程未运行（Initialize 之前 / Shutdown 之后）：就地输出
+  DeliverReport(report);
+}
 
-  AggregatorNode* child = node->first_child;
-  while (child) {
-    snapshot.push_back(child);  // 现在这里大概率不会触发内存分配了
-    child = child->next_sibling;
+void ProfilerService::DeliverReport(const ProfileReport& report) {
+  if (profiler_logger_) {
+    // 注意：极高频工业环境，强烈建议底层 Logger 实现采用异步文件队列机制（Async
+    // Sink），防止 IO 阻滞。
+    const std::string text = FormatTextReport(report);
+    z3y::interfaces::core::LogSourceLocation loc{__FILE__, __LINE__,
+                                                 __FUNCTION__};
+    profiler_logger_->Log(loc, z3y::interfaces::core::LogLevel::Warn,
+                          text.c_str());
   }
-  node->lock.clear(std::memory_order_release);
 
-  for (auto* c : snapshot) {
-    FormatTimerRecursive(output, c, depth + 1, root_ms);
+  std::shared_ptr<const SinkList> sinks;
+  {
+    std::lock_guard<std::mutex> lock(sinks_mutex_);
+    sinks = sinks_;
+  }
+  for (const auto& sink : *sinks) {
+    try {
+      sink->OnReport(report);
+    } catch (...) {
+      // Sink 的异常不能杀死报告线程
+    }
   }
 }
 
-void ProfilerService::FormatMetricsRecursive(std::string& output,
-                                             AggregatorNode* node) {
-  if (!node || !node->static_info) return;
-
-  if (node->static_info->type == NodeType::Value) {
-    uint64_t current_count = node->call_count.load(std::memory_order_relaxed);
-    double avg =
-        current_count > 0 ? (node->GetSumValue() / current_count) : 0.0;
-
-    output += fmt::format(
-        " |- {:<26} (Value)  Count: {:<6} Avg: {:<8.2f} Max: {:.2f}\n",
-        node->static_info->name, current_count, avg,
-        node->GetMaxValue());  // [修复] GetMaxValue()
+void ProfilerService::ReportLoop() {
+  std::unique_lock<std::mutex> lock(report_mutex_);
+  for (;;) {
+    if (report_queue_.empty()) {
+      if (!retired_.empty()) {
+        ReclaimRetired(lock);
+        // 仍有实时快照未结束：稍后再试
+        if (!retired_.empty()) {
+          report_cv_.wait_for(lock, std::chrono::milliseconds(1));
+          continue;
+        }
+      }
+      if (trim_pending_ && report_queue_.empty()) {
+        trim_pending_ = false;
+        ++reports_in_flight_;
+        lock.unlock();
+        TrimNodePool();
+        lock.lock();
+        --reports_in_flight_;
+        continue;  // 整理期间可能有新报告入队
+      }
+      if (report_queue_.empty() && reports_in_flight_ == 0) {
+        report_idle_cv_.notify_all();
+      }
+      if (report_stop_ && report_queue_.empty()) break;  // 队列与回收都已清空
+      report_cv_.wait(lock, [this] {
+        return report_stop_ || !report_queue_.empty() || !retired_.empty() || trim_pending_;
+      });
+      continue;
+    }
 
-  } else if (node->static_info->type == NodeType::Event) {
-    output += fmt::format(
-        " |- {:<26} (Event)  Total Occurrences: {}\n", node->static_info->name,
-        node->call_count.load(std::memory_order_relaxed));  // [修复]
+    ProfileReport report = std::move(report_queue_.front());
+    report_queue_.pop_front();
+    if (dropped_reports_ > 0) {
+      report.reason += fmt::format(" [{} reports dropped]", dropped_reports_);
+      dropped_reports_ = 0;
+    }
+    ++reports_in_flight_;
+    lock.unlock();
+    DeliverReport(report);
+    lock.lock();
+    --reports_in_flight_;
+    trim_pending_ = true;
   }
+  lock.unlock();
+  // 回收的节点留在本线程的缓存里，退出前交回全局池
+  FlushThreadNodeCache();
+}
 
-  // 将快照数组的声明和预分配移到【获取锁的外面】
-  std::vector<AggregatorNode*> snapshot;
-  snapshot.reserve(16);  // [新增] 预先分配好内存，避免在锁内触发 new
-
-  while (node->lock.test_and_set(std::memory_order_acquire)) {
-#if defined(_MSC_VER) || defined(__i386__) || defined(__x86_64__)
-    _mm_pause();
-#elif defined(__arm__) || defined(__aarch64__)
-    __asm__ volatile("yield");
-#endif
+void ProfilerService::TrimNodePool() {
+  AllocationMute mute;
+  // 回收的旧代停在本线程缓存里：先交回全局栈，整块空闲的块才看得出来
+  FlushThreadNodeCache();
+  const size_t limit = node_pool_.NodeLimit();
+  const bool pressure = memory_pressure_.load(std::memory_order_relaxed);
+  // 全局空闲栈保留预算的 1/8 (至多 4 块)，避免下一个周期重建树时马上重新映射。
+  // 整理要取出并排序全部空闲节点：没有内存压力时至多每秒一次
+  const size_t keep = std::min(limit / 8, size_t{NodePool::kSlabNodes} * 4);
+  const auto now = std::chrono::steady_clock::now();
+  if (node_pool_.GlobalFreeNodes() >= keep + NodePool::kSlabNodes &&
+      (pressure || now - last_trim_ >= std::chrono::seconds(1))) {
+    last_trim_ = now;
+    std::vector<NodeColdStats*> orphaned;
+    node_pool_.Trim(keep, [&](AggregatorNode* node) {
+      if (node->histogram) histogram_count_.fetch_sub(1, std::memory_order_relaxed);
+      if (NodeColdStats* cold = node->cold.load(std::memory_order_relaxed)) {
+        orphaned.push_back(cold);
+      }
+    });
+    if (!orphaned.empty()) {
+      std::lock_guard<std::mutex> lock(cold_mutex_);
+      cold_free_.insert(cold_free_.end(), orphaned.begin(), orphaned.end());
+    }
   }
+  if (!pressure) return;
+
+  const size_t carved = node_pool_.CarvedNodes();
+  const size_t in_use = carved - std::min(carved, node_pool_.GlobalFreeNodes());
+  if (!pressure_logged_ && profiler_logger_) {
+    Z3Y_LOG_WARN(profiler_logger_,
+                 "[Profiler] Node memory budget ({} MB) reached: {} nodes in use, "
+                 "{} node acquisitions failed. Evicting root generations early.",
+                 limit * sizeof(AggregatorNode) >> 20, in_use,
+                 node_acquire_failures_.load(std::memory_order_relaxed));
+  }
+  pressure_logged_ = true;
+  if (in_use < limit / 2) {
+    memory_pressure_.store(false, std::memory_order_relaxed);
+    pressure_logged_ = false;
+    if (profiler_logger_) {
+      Z3Y_LOG_INFO(profiler_logger_,
+                   "[Profiler] Node memory pressure relieved: {} nodes in use, "
+                   "{} slabs returned to the OS so far.",
+                   in_use, node_pool_.ReleasedSlabs());
+    }
+  }
+}
 
-  AggregatorNode* child = node->first_child;
-  while (child) {
-    snapshot.push_back(child);  // 现在这里大概率不会触发内存分配了
-    child = child->next_sibling;
+void ProfilerService::StartReportThread() {
+  if (report_thread_.joinable()) return;
+  {
+    std::lock_guard<std::mutex> lock(report_mutex_);
+    report_stop_ = false;
   }
-  node->lock.clear(std::memory_order_release);
+  report_thread_ = std::thread(&ProfilerService::ReportLoop, this);
+}
 
-  for (auto* c : snapshot) {
-    FormatMetricsRecursive(output, c);
+void ProfilerService::StopReportThread() {
+  if (!report_thread_.joinable()) return;
+  {
+    std::lock_guard<std::mutex> lock(report_mutex_);
+    report_stop_ = true;
   }
+  report_cv_.notify_all();
+  report_thread_.join();
+}
+
+void ProfilerService::FlushReports() {
+  if (std::this_thread::get_id() == report_thread_.get_id()) return;  // Sink 内调用
+  std::unique_lock<std::mutex> lock(report_mutex_);
+  report_idle_cv_.wait(lock, [this] {
+    return report_queue_.empty() && retired_.empty() && reports_in_flight_ == 0 &&
+           !trim_pending_;
+  });
+}
+
+void ProfilerService::AddReportSink(std::shared_ptr<IProfilerReportSink> sink) {
+  if (!sink) return;
+  std::lock_guard<std::mutex> lock(sinks_mutex_);
+  if (std::find(sinks_->begin(), sinks_->end(), sink) != sinks_->end()) return;
+  auto next = std::make_shared<SinkList>(*sinks_);
+  next->push_back(std::move(sink));
+  sink_count_.store(next->size(), std::memory_order_relaxed);
+  sinks_ = std::move(next);
+}
+
+void ProfilerService::RemoveReportSink(
+    const std::shared_ptr<IProfilerReportSink>& sink) {
+  std::lock_guard<std::mutex> lock(sinks_mutex_);
+  auto next = std::make_shared<SinkList>(*sinks_);
+  next->erase(std::remove(next->begin(), next->end(), sink), next->end());
+  sink_count_.store(next->size(), std::memory_order_relaxed);
+  sinks_ = std::move(next);
 }
 
 void ProfilerService::AsyncBegin(const char* name, uint64_t frame_id,
                                  uint32_t period, double sla_ms) {
-  size_t start_idx = frame_id % 1024;
-  for (size_t i = 0; i < 1024; ++i) {
-    size_t idx = (start_idx + i) % 1024;
-
-    auto& slot = g_async_slots[idx];
-
-    uint64_t expected = 0;
-
-    // [新增防御] 必须且仅当物理槽位完全释放（没有僵尸 Worker
-    // 引用）时，才允许复用
-    if (slot.ref_count.load(std::memory_order_acquire) == 0) {
-      if (slot.active_frame_id.compare_exchange_strong(
-              expected, frame_id, std::memory_order_acq_rel)) {
-        ReleaseChildren(&slot.root_node);
-        slot.root_node.Reset();
-        slot.dynamic_info.name = name;
-        slot.root_node.static_info = &slot.dynamic_info;
-        slot.period = period;
-        slot.sla_ms = sla_ms;
-        // [新增] 抢占成功，赋予初始主生命周期计数 1
-        slot.ref_count.store(1, std::memory_order_release);
-        return;
-      } else if (expected == frame_id) {
-        // 重复的 Begin，软复位
-        ReleaseChildren(&slot.root_node);
-        slot.root_node.Reset();
-        slot.dynamic_info.name = name;
-        slot.root_node.static_info = &slot.dynamic_info;
-        slot.period = period;
-        slot.sla_ms = sla_ms;
-        slot.ref_count.store(1, std::memory_order_release);
-        return;
-      }
+  bool existed = false;
+  AsyncSlot* slot = frames_.Begin(frame_id, name, period, sla_ms, &existed);
+  if (slot && existed) {
+    // 重复的 Begin，软复位（引用计数不变，已挂载的 Worker 仍会各自 Commit）。
+    // 旧代与影子树可能仍有写入者，换代后挂在槽位上等最后一个引用释放
+    if (AggregatorNode* old = DetachGeneration(&slot->root_node, true)) {
+      RetireGeneration(old, slot);
+    } else {
+      slot->root_node.Reset();
+    }
+    for (AggregatorNode* shard = DetachShards(*slot); shard;) {
+      AggregatorNode* next = shard->next_sibling;
+      shard->next_sibling = nullptr;
+      RetireGeneration(shard, slot);
+      shard = next;
     }
+    slot->dynamic_info.name = name;
+    slot->period = period;
+    slot->sla_ms = sla_ms;
+    return;
+  }
+  if (slot) {
+    tracer_.FrameBegin(frame_id, name);
+    return;
   }
 
   if (profiler_logger_) {
     z3y::interfaces::core::LogSourceLocation loc{__FILE__, __LINE__,
                                                  __FUNCTION__};
-    profiler_logger_->Log(
-        loc, z3y::interfaces::core::LogLevel::Error,
-        "[Profiler Error] 1024 Async Slots fully exhausted by zombies! "
+    const std::string message = fmt::format(
+        "[Profiler Error] {} Async Slots fully exhausted by zombies! "
         "Circuit breaker active. Profiling skipped for this frame to protect "
-        "process memory.");
+        "process memory.",
+        frames_.GetCapacity());
+    profiler_logger_->Log(loc, z3y::interfaces::core::LogLevel::Error,
+                          message.c_str());
   }
 }
 
@@ -494,56 +1930,547 @@ void ProfilerService::AsyncAttach(uint64_t frame_id) {
   // 防止后续宏调用时发生延迟初始化，将我们下面挂载的数据误杀。
   GetOrCreateThreadState();
 
-  size_t start_idx = frame_id % 1024;
-  for (size_t i = 0; i < 1024; ++i) {
-    size_t idx = (start_idx + i) % 1024;
-    // 使用 Memory_order_acquire 保证读取到的 frame_id 同步一致性
-    if (g_async_slots[idx].active_frame_id.load(std::memory_order_acquire) ==
-        frame_id) {
-      g_async_slots[idx].ref_count.fetch_add(1, std::memory_order_relaxed);
-
-      t_profiler_state_wrapper.state.current_root =
-          &(g_async_slots[idx].root_node);
-      t_profiler_state_wrapper.state.stack_depth = 1;
-      t_profiler_state_wrapper.state.shadow_stack[0] =
-          t_profiler_state_wrapper.state.current_root;
-      return;
+  // 查找与引用计数 +1 在帧表的条带锁内一次完成
+  AsyncSlot* slot = frames_.Acquire(frame_id);
+  if (!slot) return;
+  tracer_.StageBegin(frame_id, slot->dynamic_info.name);
+
+  AggregatorNode* root = &slot->root_node;
+  if (sharded_.load(std::memory_order_relaxed)) {
+    // 分片模式：本线程写入自己的影子树，提交时再合并回共享树
+    if (AggregatorNode* shard = AcquireNode()) {
+      shard->static_info = &slot->dynamic_info;
+      shard->thread_owned = true;
+      LockSpin(slot->shard_lock);
+      shard->next_sibling = slot->shards;
+      slot->shards = shard;
+      slot->shard_lock.clear(std::memory_order_release);
+      root = shard;
     }
   }
+
+  t_profiler_state_wrapper.state.current_root = root;
+  t_profiler_state_wrapper.state.stack_depth = 1;
+  t_profiler_state_wrapper.state.shadow_stack[0] =
+      t_profiler_state_wrapper.state.current_root;
 }
 
 void ProfilerService::AsyncCommit(uint64_t frame_id) {
   GetOrCreateThreadState();
 
-  size_t start_idx = frame_id % 1024;
-  for (size_t i = 0; i < 1024; ++i) {
-    size_t idx = (start_idx + i) % 1024;
-    if (g_async_slots[idx].active_frame_id.load(std::memory_order_acquire) ==
-        frame_id) {
-      auto& slot = g_async_slots[idx];
-      SubmitRootForCheck(&slot.root_node, slot.period, slot.sla_ms);
-      ReleaseChildren(&slot.root_node);
-      // 【修改为】：仅当当前线程确实正挂载在该槽位时，才清空 TLS
-      // 防止破坏主调度线程的分析栈导致整数下溢越界
-      if (t_profiler_state_wrapper.state.current_root == &slot.root_node) {
-        t_profiler_state_wrapper.state.current_root = nullptr;
-        t_profiler_state_wrapper.state.stack_depth = 0;
+  AsyncSlot* slot = frames_.Find(frame_id);
+  if (!slot) return;
+  tracer_.StageEnd(frame_id);
+
+  // 本线程不再写入自己的影子树，先把它合并回共享树再提交
+  AggregatorNode* current = t_profiler_state_wrapper.state.current_root;
+  AggregatorNode* own_shard = nullptr;
+  if (current && current->thread_owned) {
+    own_shard = DetachShards(*slot, current);
+    MergeShardTree(&slot->root_node, own_shard);
+  }
+  // 其他 Worker 可能仍在共享树上计时：本帧的子树整代摘下，延后到最后一个引用释放时回收
+  CheckRoot(&slot->root_node, slot->period, slot->sla_ms, slot);
+  RetireGeneration(DetachGeneration(&slot->root_node, false), slot);
+  // 【修改为】：仅当当前线程确实正挂载在该槽位时，才清空 TLS
+  // 防止破坏主调度线程的分析栈导致整数下溢越界
+  if (current == &slot->root_node || (own_shard && current == own_shard)) {
+    t_profiler_state_wrapper.state.current_root = nullptr;
+    t_profiler_state_wrapper.state.stack_depth = 0;
+  }
+
+  if (frames_.Release(slot)) {
+    // 最后一个引用：槽位已从帧表摘除，绝无任何其他线程访问它。
+    // 合并残留的影子树后生成报表并销毁子树，再归还槽位
+    for (AggregatorNode* shard = DetachShards(*slot); shard;) {
+      AggregatorNode* next = shard->next_sibling;
+      shard->next_sibling = nullptr;
+      MergeShardTree(&slot->root_node, shard);
+      shard = next;
+    }
+    tracer_.FrameEnd(frame_id, slot->dynamic_info.name);
+    SubmitRootForCheck(&slot->root_node, slot->period, slot->sla_ms);
+    ReleaseChildren(&slot->root_node);
+    ReleaseShardChain(slot->retired);
+    frames_.Recycle(slot);
+  }
+}
+
+void ProfilerService::SetEventBusHook(bool enable) {
+  std::lock_guard<std::mutex> lock(event_hook_mutex_);
+  const bool installed = !event_hook_token_.expired();
+  if (enable == installed) return;
+  auto manager = z3y::PluginManager::GetActiveInstance();
+  if (enable) {
+    if (!manager) {
+      if (profiler_logger_) {
+        Z3Y_LOG_WARN(profiler_logger_,
+                     "[Profiler] Event bus hook unavailable: no active "
+                     "PluginManager.");
       }
-      uint32_t prior_count =
-          slot.ref_count.fetch_sub(1, std::memory_order_release);
-
-      if (prior_count == 1) {
-        // [新增] Acquire 内存屏障，强迫当前核心读取主存，获取其他所有 Worker
-        // 刚刚刷入的数据
-        std::atomic_thread_fence(std::memory_order_acquire);
-
-        // 此时绝无任何其他线程访问此槽位，安全生成报表并销毁子树
-        SubmitRootForCheck(&slot.root_node, slot.period, slot.sla_ms);
-        ReleaseChildren(&slot.root_node);
-        slot.active_frame_id.store(0, std::memory_order_release);
+      return;
+    }
+    // 令牌随钩子对象一起释放：框架在调用期间持有钩子快照，令牌过期即没有进行中的调用
+    auto token = std::make_shared<int>(0);
+    event_hook_token_ = token;
+    manager->SetEventTraceHook(
+        [this, token](z3y::EventTracePoint point, z3y::EventId event_id,
+                      void* subscriber, const char*) {
+          OnEventTrace(point, event_id, subscriber);
+        });
+    return;
+  }
+  if (!manager) return;  // 框架已销毁，钩子随之释放
+  manager->SetEventTraceHook(nullptr);
+  while (!event_hook_token_.expired()) std::this_thread::yield();
+}
+
+void ProfilerService::SetInterceptedCalls(const std::string& list) {
+  std::unordered_set<std::string> next;
+  size_t begin = 0;
+  while (begin <= list.size()) {
+    size_t end = list.find(',', begin);
+    if (end == std::string::npos) end = list.size();
+    size_t first = list.find_first_not_of(" \t", begin);
+    size_t last = list.find_last_not_of(" \t", end == 0 ? 0 : end - 1);
+    if (first != std::string::npos && first < end && last >= first) {
+      next.insert(list.substr(first, last - first + 1));
+    }
+    begin = end + 1;
+  }
+
+  std::lock_guard<std::mutex> lock(intercept_mutex_);
+  auto manager = z3y::PluginManager::GetActiveInstance();
+  if (manager) {
+    for (const auto& name : intercepted_calls_) {
+      if (!next.count(name)) manager->SetCallInterception(name, false);
+    }
+    for (const auto& name : next) {
+      if (!intercepted_calls_.count(name)) manager->SetCallInterception(name, true);
+    }
+  }
+  intercepted_calls_ = std::move(next);
+}
+
+void ProfilerService::OnEventTrace(z3y::EventTracePoint point,
+                                   z3y::EventId event_id, void* subscriber) {
+  using Point = z3y::EventTracePoint;
+  EventHookThreadState& t = tls_event_hook;
+  const uint64_t now = ProfilerClock::Now();
+  switch (point) {
+    case Point::kDirectCallStart:
+      if (t.depth < EventHookThreadState::kMaxDepth) {
+        t.direct[t.depth] = {event_id, now};
+      }
+      ++t.depth;
+      break;
+    case Point::kDirectCallEnd:
+      if (t.depth == 0) break;  // 钩子在回调途中才安装
+      --t.depth;
+      if (t.depth < EventHookThreadState::kMaxDepth &&
+          t.direct[t.depth].event_id == event_id) {
+        // 嵌套在其他回调或异步任务里的调用已计入外层，不再重复计入根节点
+        RecordEventTicks(event_id, reinterpret_cast<uintptr_t>(subscriber),
+                         EventProbeKind::Direct,
+                         now - t.direct[t.depth].start_ticks,
+                         t.depth == 0 && !t.in_task);
+      }
+      break;
+    case Point::kQueuedExecuteStart: {
+      t.in_task = true;
+      t.task_event = event_id;
+      t.task_start = now;
+      const uint64_t wait_ns = z3y::PluginManager::GetCurrentEventTaskWaitNs();
+      RecordEventTicks(event_id, 0, EventProbeKind::QueueWait,
+                       static_cast<uint64_t>(static_cast<double>(wait_ns) *
+                                             ProfilerClock::TicksPerMs() / 1e6),
+                       false);
+      break;
+    }
+    case Point::kQueuedExecuteEnd:
+      if (t.in_task && t.task_event == event_id) {
+        RecordEventTicks(event_id, 0, EventProbeKind::Queued, now - t.task_start,
+                         true);
       }
+      t.in_task = false;
+      break;
+    default:
+      break;
+  }
+}
+
+void ProfilerService::RecordEventTicks(z3y::EventId event_id,
+                                       uintptr_t subscriber,
+                                       EventProbeKind kind, uint64_t ticks,
+                                       bool count_call) {
+  if (!enable_.load(std::memory_order_relaxed)) return;
+  ProfilerThreadState* state = GetOrCreateThreadState();
+  AggregatorNode* root = &event_bus_.root_node;
+  bool reported = false;
+
+  event_writers_.fetch_add(1, std::memory_order_seq_cst);
+  AggregatorNode* event_node = FindOrCreateNode(
+      this, event_probes_.Get(event_id, 0, EventProbeKind::Event), root, state);
+  if (event_node) {
+    if (AggregatorNode* leaf = FindOrCreateNode(
+            this, event_probes_.Get(event_id, subscriber, kind), event_node,
+            state)) {
+      leaf->RecordTicks(ticks);
+    }
+    if (kind != EventProbeKind::QueueWait) event_node->RecordTicks(ticks);
+  }
+  if (count_call) {
+    root->total_ticks.fetch_add(ticks, std::memory_order_relaxed);
+    const uint32_t period = event_bus_period_.load(std::memory_order_relaxed);
+    const uint64_t calls =
+        root->call_count.fetch_add(1, std::memory_order_relaxed) + 1;
+    // 只有恰好数到周期整数倍的线程出报告；换代失败（节点池已满）时下一个整数倍重试
+    if (calls % period == 0) {
+      if (AggregatorNode* old = DetachGeneration(root, true)) {
+        if (profiler_logger_ || sink_count_.load(std::memory_order_relaxed) > 0) {
+          GenerateReportAndLog(old,
+                               fmt::format("Periodic Tick (Period: {})", period));
+        }
+        RetireGeneration(old, &event_bus_);
+        reported = true;
+      }
+    }
+  }
+  event_writers_.fetch_sub(1, std::memory_order_seq_cst);
+
+  // 换代之后观察到没有写入者，说明之前摘下的各代都不再被引用
+  if (reported && event_writers_.load(std::memory_order_seq_cst) == 0) {
+    ReclaimRetiredIfIdle(&event_bus_, event_writers_);
+  }
+}
+
+void ProfilerService::SetLockContentionHook(bool enable) {
+  std::lock_guard<std::mutex> lock(lock_hook_mutex_);
+  if (enable == lock_hook_installed_) return;
+  if (enable && !z3y::kLockProfilingCompiled && profiler_logger_) {
+    Z3Y_LOG_WARN(profiler_logger_,
+                 "[Profiler] Lock contention hook installed, but the framework "
+                 "was built without Z3Y_LOCK_PROFILING: no samples will arrive.");
+  }
+  z3y::SetLockProfileHook(enable ? &ProfilerService::OnLockSample : nullptr,
+                          enable ? this : nullptr);
+  lock_hook_installed_ = enable;
+}
+
+void ProfilerService::SetPipelineHook(bool enable) {
+  std::lock_guard<std::mutex> lock(pipeline_hook_mutex_);
+  if (enable == pipeline_hook_installed_) return;
+  z3y::SetPipelineTraceHook(enable ? &ProfilerService::OnPipelineSample : nullptr,
+                            enable ? this : nullptr);
+  pipeline_hook_installed_ = enable;
+}
+
+void ProfilerService::OnPipelineSample(const z3y::PipelineTraceSample& sample,
+                                       void* context) {
+  static_cast<ProfilerService*>(context)->RecordPipelineSample(sample);
+}
+
+void ProfilerService::RecordPipelineSample(const z3y::PipelineTraceSample& sample) {
+  using Point = z3y::PipelineTracePoint;
+  if (!enable_.load(std::memory_order_relaxed)) return;
+  const uint32_t period = pipeline_period_.load(std::memory_order_relaxed);
+  // 帧号最高位是框架的标记位，低位按 Push 顺序递增：同一帧的各次上报判定一致
+  const bool tracked = ((sample.frame_id << 1) >> 1) % period == 0;
+  switch (sample.point) {
+    case Point::kItemBegin:
+      // 槽位名取自表中的拷贝：报告在帧的最后一个引用释放时才生成
+      if (tracked) AsyncBegin(pipeline_probes_.GetPipeline(sample.pipeline)->name,
+                              sample.frame_id, 1, 0.0);
+      return;
+    case Point::kStageStart:
+      if (tracked) AsyncAttach(sample.frame_id);
+      return;
+    case Point::kItemEnd:
+      if (tracked) AsyncCommit(sample.frame_id);
       return;
+    case Point::kStageEnd:
+      break;
+  }
+
+  PipelineProbeTable::Stage* site =
+      pipeline_probes_.GetStage(sample.pipeline, sample.stage);
+  const double ticks_per_ns = ProfilerClock::TicksPerMs() / 1e6;
+  const auto busy_ticks =
+      static_cast<uint64_t>(static_cast<double>(sample.busy_ns) * ticks_per_ns);
+  const auto wait_ticks =
+      static_cast<uint64_t>(static_cast<double>(sample.wait_ns) * ticks_per_ns);
+  ProfilerThreadState* state = GetOrCreateThreadState();
+  if (tracked) {
+    // AsyncAttach 已把本线程挂到帧的根（或分片模式下本线程的影子树）上
+    if (AggregatorNode* frame_root = state->current_root) {
+      if (AggregatorNode* node =
+              FindOrCreateNode(this, &site->stage_data, frame_root, state)) {
+        node->RecordTicks(busy_ticks);
+      }
+    }
+    AsyncCommit(sample.frame_id);
+  }
+
+  AggregatorNode* root = &pipelines_.root_node;
+  bool reported = false;
+  pipeline_writers_.fetch_add(1, std::memory_order_seq_cst);
+  if (AggregatorNode* pipeline =
+          FindOrCreateNode(this, site->pipeline_data, root, state)) {
+    pipeline->RecordTicks(busy_ticks);
+    if (AggregatorNode* stage =
+            FindOrCreateNode(this, &site->stage_data, pipeline, state)) {
+      stage->RecordTicks(busy_ticks);
+      if (AggregatorNode* wait =
+              FindOrCreateNode(this, &site->wait_data, stage, state)) {
+        wait->RecordTicks(wait_ticks);
+      }
+    }
+  }
+  root->total_ticks.fetch_add(busy_ticks, std::memory_order_relaxed);
+  const uint64_t calls = root->call_count.fetch_add(1, std::memory_order_relaxed) + 1;
+  if (calls % period == 0) {
+    if (AggregatorNode* old = DetachGeneration(root, true)) {
+      if (profiler_logger_ || sink_count_.load(std::memory_order_relaxed) > 0) {
+        GenerateReportAndLog(old, fmt::format("Periodic Tick (Period: {})", period));
+      }
+      RetireGeneration(old, &pipelines_);
+      reported = true;
+    }
+  }
+  pipeline_writers_.fetch_sub(1, std::memory_order_seq_cst);
+
+  if (reported && pipeline_writers_.load(std::memory_order_seq_cst) == 0) {
+    ReclaimRetiredIfIdle(&pipelines_, pipeline_writers_);
+  }
+}
+
+void ProfilerService::SetAllocationTracking(bool enable) {
+  std::lock_guard<std::mutex> lock(alloc_hook_mutex_);
+  if (enable == alloc_hook_installed_) return;
+  z3y::SetAllocationHook(enable ? &ProfilerService::OnAllocation : nullptr,
+                         enable ? this : nullptr);
+  alloc_hook_installed_ = enable;
+}
+
+void ProfilerService::OnAllocation(size_t bytes, void* context) {
+  auto* self = static_cast<ProfilerService*>(context);
+  // 只认本实例写入的线程状态；没有进入过被统计作用域的线程直接返回
+  if (tls_alloc_state_owner != self->instance_id_ || tls_alloc_muted > 0) return;
+  ProfilerThreadState* state = tls_alloc_state;
+  if (!state || !state->current_root ||
+      !self->enable_.load(std::memory_order_relaxed)) {
+    return;
+  }
+  AggregatorNode* node = state->stack_depth > 0
+                             ? state->shadow_stack[state->stack_depth - 1]
+                             : state->current_root;
+  if (node) node->RecordAllocation(bytes);
+}
+
+void ProfilerService::OnLockSample(const z3y::LockContentionSample& sample,
+                                   void* context) {
+  static_cast<ProfilerService*>(context)->RecordLockSample(sample);
+}
+
+void ProfilerService::RecordLockSample(const z3y::LockContentionSample& sample) {
+  if (!enable_.load(std::memory_order_relaxed)) return;
+  LockProbeTable::Site* site = lock_probes_.Get(sample.lock_name, sample.call_site);
+  site->Record(sample.wait_ns, sample.hold_ns, sample.contended);
+
+  const double ticks_per_ns = ProfilerClock::TicksPerMs() / 1e6;
+  const auto wait_ticks =
+      static_cast<uint64_t>(static_cast<double>(sample.wait_ns) * ticks_per_ns);
+  ProfilerThreadState* state = GetOrCreateThreadState();
+  AggregatorNode* root = &locks_.root_node;
+  bool reported = false;
+
+  lock_writers_.fetch_add(1, std::memory_order_seq_cst);
+  if (AggregatorNode* lock_node =
+          FindOrCreateNode(this, site->lock_data, root, state)) {
+    lock_node->RecordTicks(wait_ticks);
+    if (AggregatorNode* wait = FindOrCreateNode(this, &site->wait_data, lock_node, state)) {
+      wait->RecordTicks(wait_ticks);
+    }
+    if (!sample.shared) {
+      if (AggregatorNode* hold = FindOrCreateNode(this, &site->hold_data, lock_node, state)) {
+        hold->RecordTicks(static_cast<uint64_t>(
+            static_cast<double>(sample.hold_ns) * ticks_per_ns));
+      }
+    }
+  }
+  root->total_ticks.fetch_add(wait_ticks, std::memory_order_relaxed);
+  const uint32_t period = lock_period_.load(std::memory_order_relaxed);
+  const uint64_t calls = root->call_count.fetch_add(1, std::memory_order_relaxed) + 1;
+  if (calls % period == 0) {
+    if (AggregatorNode* old = DetachGeneration(root, true)) {
+      if (profiler_logger_ || sink_count_.load(std::memory_order_relaxed) > 0) {
+        GenerateReportAndLog(old, fmt::format("Periodic Tick (Period: {})", period));
+      }
+      RetireGeneration(old, &locks_);
+      reported = true;
+    }
+  }
+  lock_writers_.fetch_sub(1, std::memory_order_seq_cst);
+
+  if (reported && lock_writers_.load(std::memory_order_seq_cst) == 0) {
+    ReclaimRetiredIfIdle(&locks_, lock_writers_);
+  }
+}
+
+void ProfilerService::RecordDeviceSpan(const ResolvedDeviceSpan& span) {
+  tracer_.DeviceSpan(span.track_id, span.device->name, span.scope->name,
+                     span.begin_ticks, span.end_ticks);
+  if (!enable_.load(std::memory_order_relaxed)) return;
+  const uint64_t ticks = span.end_ticks - span.begin_ticks;
+  ProfilerThreadState* state = GetOrCreateThreadState();
+  AggregatorNode* root = &devices_.root_node;
+  bool reported = false;
+
+  device_writers_.fetch_add(1, std::memory_order_seq_cst);
+  if (AggregatorNode* device = FindOrCreateNode(this, span.device, root, state)) {
+    device->RecordTicks(ticks);
+    if (AggregatorNode* scope = FindOrCreateNode(this, span.scope, device, state)) {
+      scope->RecordTicks(ticks);
+    }
+  }
+  root->total_ticks.fetch_add(ticks, std::memory_order_relaxed);
+  const uint32_t period = device_period_.load(std::memory_order_relaxed);
+  const uint64_t calls = root->call_count.fetch_add(1, std::memory_order_relaxed) + 1;
+  if (calls % period == 0) {
+    if (AggregatorNode* old = DetachGeneration(root, true)) {
+      if (profiler_logger_ || sink_count_.load(std::memory_order_relaxed) > 0) {
+        GenerateReportAndLog(old, fmt::format("Periodic Tick (Period: {})", period));
+      }
+      RetireGeneration(old, &devices_);
+      reported = true;
+    }
+  }
+  device_writers_.fetch_sub(1, std::memory_order_seq_cst);
+
+  if (reported && device_writers_.load(std::memory_order_seq_cst) == 0) {
+    ReclaimRetiredIfIdle(&devices_, device_writers_);
+  }
+}
+
+/** @brief 探针地址所在模块（EXE / DLL / SO）的文件名，查不到时为空。 */
+static std::string ModuleNameOf(const void* address) {
+#ifdef _WIN32
+  HMODULE module = nullptr;
+  if (GetModuleHandleExW(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS |
+                             GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+                         static_cast<LPCWSTR>(address), &module)) {
+    wchar_t buffer[MAX_PATH];
+    const DWORD length = GetModuleFileNameW(module, buffer, MAX_PATH);
+    if (length > 0) {
+      return z3y::utils::PathToUtf8(
+          std::filesystem::path(std::wstring(buffer, length)).filename());
+    }
+  }
+  return {};
+#else
+  Dl_info info{};
+  if (dladdr(address, &info) && info.dli_fname) {
+    return std::filesystem::path(info.dli_fname).filename().string();
+  }
+  return {};
+#endif
+}
+
+/** @brief 统一路径分隔符后判断 path 是否以 suffix 结尾。 */
+static bool PathEndsWith(std::string path, std::string suffix) {
+  std::replace(path.begin(), path.end(), '\\', '/');
+  std::replace(suffix.begin(), suffix.end(), '\\', '/');
+  return suffix.size() <= path.size() &&
+         path.compare(path.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+static bool ProbeMatches(ProbeMatch match, const std::string& pattern,
+                         const ProbeInfo& probe) {
+  switch (match) {
+    case ProbeMatch::Name: return probe.name == pattern;
+    case ProbeMatch::File: return PathEndsWith(probe.file, pattern);
+    case ProbeMatch::Module:
+      return probe.module.find(pattern) != std::string::npos;
+  }
+  return false;
+}
+
+bool ProfilerService::EvaluateProbeRules(const ProbeInfo& probe) const {
+  bool enabled = true;
+  for (const ProbeRule& rule : probe_rules_) {
+    if (ProbeMatches(rule.match, rule.pattern, probe)) enabled = rule.enabled;
+  }
+  return enabled;
+}
+
+void ProfilerService::SetProbeBit(uint32_t index, bool enabled) {
+  const uint64_t bit = uint64_t{1} << (index & 63);
+  if (enabled) {
+    probe_bits_[index >> 6].fetch_or(bit, std::memory_order_relaxed);
+  } else {
+    probe_bits_[index >> 6].fetch_and(~bit, std::memory_order_relaxed);
+  }
+}
+
+uint64_t ProfilerService::RegisterProbe(ProfileNodeData* data) {
+  AllocationMute mute;
+  const char* name = data->name ? data->name : "";
+  const char* file = data->file ? data->file : "";
+  std::string key = fmt::format("{}:{}:{}", file, data->line, name);
+
+  uint32_t index = 0;
+  {
+    std::lock_guard<std::mutex> lock(probe_mutex_);
+    if (auto it = probe_index_.find(key); it != probe_index_.end()) {
+      index = it->second;
+    } else if (probes_.size() < kMaxProbes) {
+      index = static_cast<uint32_t>(probes_.size());
+      ProbeInfo& probe = probes_.emplace_back();
+      probe.name = name;
+      probe.file = file;
+      probe.line = data->line;
+      probe.type = data->type;
+      probe.module = ModuleNameOf(data);
+      SetProbeBit(index, EvaluateProbeRules(probe));
+      probe_index_.emplace(std::move(key), index);
     }
   }
+  const uint64_t probe_key = (uint64_t{probe_tag_} << 32) | index;
+  data->probe_key.store(probe_key, std::memory_order_relaxed);
+  return probe_key;
+}
+
+size_t ProfilerService::SetProbesEnabled(ProbeMatch match,
+                                         const std::string& pattern,
+                                         bool enabled) {
+  std::lock_guard<std::mutex> lock(probe_mutex_);
+  // 同一目标只保留最新的一条规则，规则表不会无限增长
+  probe_rules_.erase(
+      std::remove_if(probe_rules_.begin(), probe_rules_.end(),
+                     [&](const ProbeRule& rule) {
+                       return rule.match == match && rule.pattern == pattern;
+                     }),
+      probe_rules_.end());
+  probe_rules_.push_back({match, pattern, enabled});
+
+  size_t matched = 0;
+  for (size_t i = 1; i < probes_.size(); ++i) {
+    if (ProbeMatches(match, pattern, probes_[i])) ++matched;
+    SetProbeBit(static_cast<uint32_t>(i), EvaluateProbeRules(probes_[i]));
+  }
+  return matched;
+}
+
+std::vector<ProbeInfo> ProfilerService::GetProbes() const {
+  std::lock_guard<std::mutex> lock(probe_mutex_);
+  std::vector<ProbeInfo> result;
+  result.reserve(probes_.size() - 1);
+  for (size_t i = 1; i < probes_.size(); ++i) {
+    ProbeInfo& probe = result.emplace_back(probes_[i]);
+    probe.enabled = (probe_bits_[i >> 6].load(std::memory_order_relaxed) >>
+                     (i & 63)) &
+                    1u;
+  }
+  return result;
 }
 }  // namespace z3y::plugins::profiler
@@ -4,7 +4,7 @@
  * * @details
  * 【面向维护者】
  * 这里封装了 Profiler 的核心引擎。包括：
- * 1. 中央节点内存池 (master_nodes_, free_nodes_)
+ * 1. 中央节点内存池 (node_pool_)
  * 2. SLA 校验和报表生成器
  * 3. 插件生命周期拦截器 (is_active_)
  * 在设计上严格遵守了无感拦截、零开销内存复用、以及防插件重载崩溃的工业级要求。
@@ -12,11 +12,34 @@
 
 #pragma once
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <memory>
 #include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
+#include "async_frame_table.h"
+#include "device_timeline.h"
+#include "event_probe_table.h"
+#include "flight_recorder.h"
+#include "hardware_counters.h"
+#include "keyed_root_table.h"
+#include "lock_probe_table.h"
+#include "node_pool.h"
+#include "pipeline_probe_table.h"
+#include "sampling_profiler.h"
+#include "tag_intern_table.h"
+#include "trace_recorder.h"
+#include "framework/allocation_hook.h"
 #include "framework/connection.h"
+#include "framework/pipeline.h"
+#include "framework/plugin_manager.h"
+#include "framework/profiled_mutex.h"
 #include "framework/z3y_define_impl.h"
 #include "interfaces_core/i_config_service.h"
 #include "interfaces_core/i_log_service.h"
@@ -43,9 +66,16 @@ class ProfilerService
 
   uint64_t GetInstanceId() const override { return instance_id_; }  // [新增]
 
-  // [新增] 用于给 TLS 回收资源的方法
-  void ReturnTlsNodesToGlobal(
-      const std::vector<z3y::interfaces::profiler::AggregatorNode*>& nodes);
+  /** @brief 把当前线程缓存的空闲节点交回全局池（线程退出时调用）。 */
+  void FlushThreadNodeCache();
+  /** @brief 注销并释放线程的全部独立根节点（线程退出时调用）。 */
+  void ReleaseThreadRoots(z3y::interfaces::profiler::ProfilerThreadState* state);
+  /** @brief 交出线程的飞行记录环（线程退出时调用）。 */
+  void ReleaseFlightRing(z3y::interfaces::profiler::ProfilerThreadState* state) {
+    flight_.Release(state);
+  }
+  /** @brief 请报告线程整理节点池（线程退出、根树整棵还回池中之后调用）。 */
+  void RequestNodeTrim();
 
   z3y::interfaces::profiler::ProfilerThreadState* GetOrCreateThreadState()
       override;
@@ -60,44 +90,342 @@ class ProfilerService
   void AsyncAttach(uint64_t frame_id) override;
   void AsyncCommit(uint64_t frame_id) override;
 
+  void AddReportSink(std::shared_ptr<z3y::interfaces::profiler::IProfilerReportSink>
+                         sink) override;
+  void RemoveReportSink(
+      const std::shared_ptr<z3y::interfaces::profiler::IProfilerReportSink>& sink)
+      override;
+  void FlushReports() override;
+
+  uint64_t RegisterProbe(
+      z3y::interfaces::profiler::ProfileNodeData* data) override;
+  size_t SetProbesEnabled(z3y::interfaces::profiler::ProbeMatch match,
+                          const std::string& pattern, bool enabled) override;
+  std::vector<z3y::interfaces::profiler::ProbeInfo> GetProbes() const override;
+
+  bool GrowShadowStack(
+      z3y::interfaces::profiler::ProfilerThreadState* state) override;
+  z3y::interfaces::profiler::AggregatorNode* AcquireThreadRoot(
+      z3y::interfaces::profiler::ProfilerThreadState* state,
+      z3y::interfaces::profiler::ProfileNodeData* data) override;
+  z3y::interfaces::profiler::ProfilerMemoryStats GetMemoryStats() const override;
+  z3y::interfaces::profiler::NodeColdStats* AttachColdStats(
+      z3y::interfaces::profiler::AggregatorNode* node) override;
+  z3y::interfaces::profiler::SamplingProfile GetSamplingProfile(
+      size_t max_symbols) const override;
+  std::vector<z3y::interfaces::profiler::ProfileReport> SnapshotLiveRoots()
+      override;
+  z3y::interfaces::profiler::TraceCapture CollectTrace(bool clear) override;
+  uint32_t InternTagString(const char* text) override;
+  z3y::interfaces::profiler::AggregatorNode* BeginKeyedRoot(
+      z3y::interfaces::profiler::ProfileNodeData* site, uint64_t key,
+      uint32_t* handle) override;
+  void EndKeyedRoot(uint32_t handle, uint32_t period, double sla_ms) override;
+  std::vector<z3y::interfaces::profiler::LockContentionEntry> GetLockContention(
+      size_t max_entries) const override;
+  bool ReadHardwareCounters(
+      z3y::interfaces::profiler::HardwareCounterSample& out) override;
+  void RecordHardwareCounters(
+      z3y::interfaces::profiler::AggregatorNode* node,
+      const z3y::interfaces::profiler::HardwareCounterSample& delta) override;
+  void RecordPacedFrame(z3y::interfaces::profiler::AggregatorNode* root,
+                        double cadence_ms, uint64_t start_ticks,
+                        uint64_t end_ticks) override;
+  void AcquireFlightRing(
+      z3y::interfaces::profiler::ProfilerThreadState* state) override;
+  bool FreezeFlightRecorder(const std::string& reason) override;
+  std::vector<z3y::interfaces::profiler::FlightRecording> TakeFlightRecordings()
+      override;
+  void SubmitDeviceSpan(
+      std::shared_ptr<z3y::interfaces::profiler::IDeviceTimestampSource> source,
+      z3y::interfaces::profiler::ProfileNodeData* data, uint64_t begin_marker,
+      uint64_t end_marker, uint64_t host_begin_ticks) override;
+  size_t FlushDeviceSpans(uint32_t timeout_ms) override;
+
  private:
+  /** @brief 一条探针启停规则（按设置顺序生效，后者覆盖前者）。 */
+  struct ProbeRule {
+    z3y::interfaces::profiler::ProbeMatch match;
+    std::string pattern;
+    bool enabled;
+  };
+  /** @brief 位图容量；超出后新探针共用恒为启用的 0 号位，不受规则控制。 */
+  static constexpr size_t kMaxProbes = 65536;
+
+  using SinkList =
+      std::vector<std::shared_ptr<z3y::interfaces::profiler::IProfilerReportSink>>;
+
   /**
-   * @brief 将树状节点数据格式化为字符串报表并写入 Logger。
+   * @brief [触发线程] 把聚合树拍平成快照，交给后台线程输出。
+   * @param pacing 节拍根本代的帧间隔统计，移入报告。
    */
   void GenerateReportAndLog(z3y::interfaces::profiler::AggregatorNode* root,
-                            const std::string& reason);
+                            const std::string& reason,
+                            z3y::interfaces::profiler::FramePacing* pacing = nullptr);
   /**
-   * @brief 递归格式化耗时类型的节点。
+   * @brief 先序遍历聚合树，拷贝出一份与节点池无关的报告快照。
    */
-  void FormatTimerRecursive(std::string& output,
-                            z3y::interfaces::profiler::AggregatorNode* node,
-                            int depth, double parent_ms);
+  z3y::interfaces::profiler::ProfileReport TakeSnapshot(
+      z3y::interfaces::profiler::AggregatorNode* root, const std::string& reason);
+  /** @brief 把冷数据中的类型化标签计数解析成文本写入报告节点（相同的值合并）。 */
+  void CollectTagValues(const z3y::interfaces::profiler::NodeColdStats& cold,
+                        z3y::interfaces::profiler::ReportNode& out) const;
   /**
-   * @brief 递归格式化数值类型的节点。
+   * @brief [后台线程] 输出一份报告：文本日志 + 所有 Sink。
    */
-  void FormatMetricsRecursive(std::string& output,
-                              z3y::interfaces::profiler::AggregatorNode* node);
+  void DeliverReport(const z3y::interfaces::profiler::ProfileReport& report);
+  /** @brief 后台报告线程主循环。 */
+  void ReportLoop();
+  /** @brief 启动 / 停止后台报告线程（停止前会输出完队列中剩余的报告）。 */
+  void StartReportThread();
+  void StopReportThread();
+  /**
+   * @brief [报告线程] 把整块空闲的节点块交还给操作系统，内存压力缓解后解除压力状态。
+   */
+  void TrimNodePool();
+  /**
+   * @brief 按当前配置给新分配的节点挂上（或摘掉）分位数直方图。
+   */
+  void AttachHistogram(z3y::interfaces::profiler::AggregatorNode* node);
   /**
    * @brief 安全地断开并释放某节点的所有子节点。
    */
   void ReleaseChildren(z3y::interfaces::profiler::AggregatorNode* parent);
+  /**
+   * @brief SubmitRootForCheck 的实现。slot 非空表示 root 是该异步槽位的共享根。
+   */
+  void CheckRoot(z3y::interfaces::profiler::AggregatorNode* root, uint32_t period,
+                 double sla_ms, AsyncSlot* slot);
+  /**
+   * @brief 把 root 当前的一代摘到一个新的壳节点上，root 留下空的新一代继续接收写入。
+   * @param with_stats 为 true 时连同 root 自身的统计值一起移走并清零 root；
+   * 为 false 时只摘子树（异步流的根计数跨帧累积）。
+   * @return 壳节点；没有可摘的子树（with_stats 为 false）或节点池已满时返回 nullptr。
+   * @details 只在 root 的锁内交换一个指针，热线程不会被树的遍历阻塞。
+   */
+  z3y::interfaces::profiler::AggregatorNode* DetachGeneration(
+      z3y::interfaces::profiler::AggregatorNode* root, bool with_stats);
+  /**
+   * @brief 在宽限期之后回收一代：slot 非空时挂到槽位上，等最后一个挂载线程提交；
+   * 否则交给报告线程，等所有进行中的 SnapshotLiveRoots 结束。
+   */
+  void RetireGeneration(z3y::interfaces::profiler::AggregatorNode* generation,
+                        AsyncSlot* slot);
+  /** @brief [报告线程] 回收宽限期已过的代（调用方持有 report_mutex_，期间会暂时释放）。 */
+  void ReclaimRetired(std::unique_lock<std::mutex>& lock);
+  /**
+   * @brief 把一棵线程独占的影子树合并进共享树，随后归还影子树。
+   * @details 调用方必须保证影子树的所属线程已不再写入它。
+   */
+  void MergeShardTree(z3y::interfaces::profiler::AggregatorNode* dst,
+                      z3y::interfaces::profiler::AggregatorNode* shard);
+  /**
+   * @brief 逐个归还一条经 next_sibling 串联的影子树链。
+   */
+  void ReleaseShardChain(z3y::interfaces::profiler::AggregatorNode* chain);
+  /**
+   * @brief 共享根（事件总线 / 分组根）的写入者已全部离开时，回收它 retired 链上的旧代。
+   * @details 在 shard_lock 内复核写入者数：旧代都是由仍登记着的写入者摘下并挂上的，
+   * 锁内看到 0 说明它们与它们之前的写入者都已离开，之后进入的写入者只能看到新一代。
+   */
+  template <typename Counter>
+  void ReclaimRetiredIfIdle(AsyncSlot* slot, const Counter& writers);
+  /** @brief [独占槽位] 输出分组根尚未报告的数据，释放它的树（LRU 淘汰 / 关闭时调用）。 */
+  void EvictKeyedRoot(KeyedRoot& entry, bool report);
+  /**
+   * @brief 递归累加 src 子树的指标到 dst 子树（按 static_info 配对）。
+   */
+  void MergeNodeRecursive(z3y::interfaces::profiler::AggregatorNode* dst,
+                          z3y::interfaces::profiler::AggregatorNode* src);
+  /**
+   * @brief [持有 probe_mutex_] 按全部规则计算一个探针是否启用。
+   */
+  bool EvaluateProbeRules(const z3y::interfaces::profiler::ProbeInfo& probe) const;
+  /**
+   * @brief [持有 probe_mutex_] 设置位图中的一位。
+   */
+  void SetProbeBit(uint32_t index, bool enabled);
+  /**
+   * @brief 把本服务安装为框架的事件追踪钩子，或卸下（System.Profiler.EventBusHook）。
+   * @details 卸下时等待进行中的钩子调用全部返回；钩子已被别人替换时不再改动。
+   */
+  void SetEventBusHook(bool enable);
+  /** @brief 事件追踪钩子的回调，可在任意线程上并发调用。 */
+  void OnEventTrace(z3y::EventTracePoint point, z3y::EventId event_id,
+                    void* subscriber);
+  /**
+   * @brief 把一次耗时计入 EventBus 根下的 [事件 -> 叶子] 节点。
+   * @param count_call 为 true 时计入根节点的调用数与耗时，并按 EventBusPeriod 出报告。
+   */
+  void RecordEventTicks(z3y::EventId event_id, uintptr_t subscriber,
+                        EventProbeKind kind, uint64_t ticks, bool count_call);
+  /**
+   * @brief 把本服务安装为框架的锁竞争采样钩子，或卸下（System.Profiler.LockContention）。
+   * @details 卸下时 z3y::SetLockProfileHook 等待进行中的钩子调用全部返回。
+   */
+  void SetLockContentionHook(bool enable);
+  /** @brief 锁竞争采样钩子的入口（context 为服务实例），可在任意线程上并发调用。 */
+  static void OnLockSample(const z3y::LockContentionSample& sample, void* context);
+  /**
+   * @brief 把一次加锁计入排名表与 Locks 根下的 [锁名 -> [Wait] / [Hold] 调用点] 节点，
+   * 并按 LockContentionPeriod 出报告。
+   */
+  void RecordLockSample(const z3y::LockContentionSample& sample);
+  /**
+   * @brief 把本服务安装为框架的管线追踪钩子，或卸下（System.Profiler.PipelineHook）。
+   * @details 卸下时 z3y::SetPipelineTraceHook 等待进行中的钩子调用全部返回。
+   */
+  void SetPipelineHook(bool enable);
+  /** @brief 管线追踪钩子的入口（context 为服务实例），可在任意线程上并发调用。 */
+  static void OnPipelineSample(const z3y::PipelineTraceSample& sample, void* context);
+  /**
+   * @brief 每 PipelinePeriod 帧取一帧映射为异步帧（Begin / 每级 Attach + Commit / 最终 Commit）；
+   * 每次阶段结束都计入 Pipelines 根下的 [管线 -> 阶段 -> [QueueWait]] 节点，并按 PipelinePeriod 出报告。
+   */
+  void RecordPipelineSample(const z3y::PipelineTraceSample& sample);
+  /**
+   * @brief [设备轮询线程] 把一段已解析的设备区间计入 Devices 根下的 [设备 -> 探针] 节点，
+   * 按 DevicePeriod 出报告，追踪开启时另记到设备轨道。
+   */
+  void RecordDeviceSpan(const ResolvedDeviceSpan& span);
+  /**
+   * @brief 把本服务安装为全局堆分配钩子，或卸下（System.Profiler.AllocationTracking）。
+   * @details 卸下时 z3y::SetAllocationHook 等待进行中的钩子调用全部返回。
+   */
+  void SetAllocationTracking(bool enable);
+  /**
+   * @brief 按逗号分隔的接口名 / 组件别名更新框架的调用拦截规则（System.Profiler.InterceptedCalls）。
+   * @details 只增删与上一次不同的条目；传空串撤销本服务开启的全部规则。
+   */
+  void SetInterceptedCalls(const std::string& list);
+  /**
+   * @brief 分配钩子的入口（context 为服务实例）：计入当前线程影子栈栈顶节点。
+   * @details 在分配路径上同步执行，只读线程局部状态，不加锁、不分配。
+   */
+  static void OnAllocation(size_t bytes, void* context);
+  /**
+   * @brief 标定单个探针的自身开销（Initialize 中执行一次）。
+   */
+  void CalibrateOverhead();
+  /**
+   * @brief 从快照的累计耗时中扣除探针自身开销。
+   */
+  void CompensateOverhead(z3y::interfaces::profiler::ProfileReport& report) const;
 
   // 【生命周期安全防线】用于在插件即将卸载时，拦截任何延后的延迟析构和内存访问，防段错误。
   std::atomic<bool> is_active_{false};
 
   std::atomic<bool> enable_{true};  ///< 总控开关，受 ConfigService 监听控制
   std::atomic<double> default_sla_ms_{0.0};  ///< 全局默认 SLA 阈值
+  std::atomic<bool> sharded_{false};  ///< 异步流分片聚合（每个 Worker 一棵影子树）
+  std::atomic<uint32_t> histogram_bits_{0};  ///< 分位数直方图精度，0 表示不挂直方图
+  std::atomic<size_t> histogram_count_{0};   ///< 当前已分配的直方图数量（受硬上限约束）
+  std::atomic<bool> compensate_{true};  ///< 报告中扣除探针自身开销
+  std::atomic<bool> hw_counters_{false};  ///< ROOT 作用域读取硬件性能计数器
+  std::atomic<double> pacing_tolerance_{0.10};  ///< 节拍根允许的晚到比例
+  uint64_t probe_self_ticks_ = 0;   ///< 每次探针计入自身节点的开销（标定值）
+  uint64_t probe_outer_ticks_ = 0;  ///< 每次探针计入父节点的完整开销（标定值）
+  std::atomic<uint64_t> stack_overflows_{0};  ///< 影子栈溢出次数（每份报告取走清零）
+  // 节点内存预算：超过高水位或分配失败时进入压力状态，各根在结束时提前换代；
+  // 报告线程回收后在用节点降到预算一半以下时解除
+  std::atomic<bool> memory_pressure_{false};
+  bool pressure_logged_ = false;  ///< [报告线程] 已输出进入压力状态的警告
+  std::atomic<uint64_t> node_acquire_failures_{0};
+  std::atomic<uint64_t> budget_evictions_{0};
+  bool trim_pending_ = false;  ///< 有报告输出或代回收后待整理节点池（受 report_mutex_ 保护）
+  std::chrono::steady_clock::time_point last_trim_{};  ///< [报告线程] 上次整理节点池的时间
 
   z3y::PluginPtr<z3y::interfaces::core::ILogger>
       profiler_logger_;                                  ///< 日志组件接口句柄
   z3y::interfaces::core::ConnectionGroup config_conns_;  ///< 配置变更监听连接组
 
-  std::mutex alloc_mutex_;  ///< 全局中央内存池互斥锁（由于有 TLS
-                            ///< 局部池，此锁极少发生碰撞）
-  std::vector<std::unique_ptr<z3y::interfaces::profiler::AggregatorNode>>
-      master_nodes_;  ///< 唯一持有所有节点所有权的容器
-  std::vector<z3y::interfaces::profiler::AggregatorNode*>
-      free_nodes_;  ///< 全局中央空闲节点池 (FreeList)
+  NodePool node_pool_;  ///< 唯一持有所有节点所有权的分块对象池
+  // 冷数据旁路表：deque 保证元素地址稳定，节点上只挂裸指针。
+  // 节点块交还时其上的冷数据块进入 cold_free_，AttachColdStats 优先复用
+  mutable std::mutex cold_mutex_;
+  std::deque<z3y::interfaces::profiler::NodeColdStats> cold_stats_;
+  std::vector<z3y::interfaces::profiler::NodeColdStats*> cold_free_;
+  mutable SamplingProfiler sampler_;  ///< 采样模式（System.Profiler.SamplingHz）
+  TraceRecorder tracer_;  ///< 异步流追踪（System.Profiler.TraceRingSize）
+  FlightRecorder flight_;  ///< 飞行记录器（System.Profiler.FlightRecorderRingSize）
+  TagInternTable tag_strings_;  ///< 类型化标签的字符串驻留表
+  // 全部线程的独立根节点，供 SnapshotLiveRoots 跨线程读取；快照期间持锁，根节点不会被释放
+  std::mutex live_roots_mutex_;
+  std::vector<z3y::interfaces::profiler::AggregatorNode*> live_roots_;
+  // 代回收纪元：每摘下一代 +1；进行中的 SnapshotLiveRoots 记下开始时的纪元，结束后清零
+  std::atomic<uint64_t> retire_epoch_{1};
+  std::atomic<uint64_t> reader_epoch_{0};
+  /** @brief 等待回收的一代及其摘下时的纪元。 */
+  struct RetiredGeneration {
+    z3y::interfaces::profiler::AggregatorNode* node;
+    uint64_t epoch;
+  };
+  std::vector<RetiredGeneration> retired_;  ///< 受 report_mutex_ 保护
+  // 后台报告线程：触发线程只负责入队快照
+  std::mutex report_mutex_;
+  std::condition_variable report_cv_;       ///< 有新报告 / 请求停止
+  std::condition_variable report_idle_cv_;  ///< 队列已清空（FlushReports 等待）
+  std::deque<z3y::interfaces::profiler::ProfileReport> report_queue_;
+  size_t reports_in_flight_ = 0;  ///< 已出队但尚未输出完毕的报告数（含正在回收的代）
+  bool report_stop_ = false;
+  std::thread report_thread_;
+  uint64_t dropped_reports_ = 0;  ///< 队列满时丢弃的报告数（受 report_mutex_ 保护）
+
+  std::mutex sinks_mutex_;
+  std::shared_ptr<const SinkList> sinks_ = std::make_shared<SinkList>();  ///< 写时复制
+  std::atomic<size_t> sink_count_{0};  ///< 供 SubmitRootForCheck 无锁判断是否有 Sink
+
+  AsyncFrameTable frames_;  ///< 异步分析流的帧表（frame_id -> 槽位）
+
+  // 事件总线钩子：所有线程共享 event_bus_ 的根节点；出报告换代摘下的旧代挂在它的 retired
+  // 链上，等没有钩子调用正在写入 (event_writers_ == 0) 时回收
+  AsyncSlot event_bus_;
+  EventProbeTable event_probes_;
+  std::atomic<uint32_t> event_writers_{0};
+  std::atomic<uint32_t> event_bus_period_{10000};  ///< 每多少次回调出一份报告
+  std::mutex event_hook_mutex_;           ///< 串行化钩子的安装与卸下
+  std::weak_ptr<void> event_hook_token_;  ///< 已安装的钩子持有它；过期说明钩子已被释放
+
+  // 锁竞争钩子：与事件总线钩子相同，所有线程共享 locks_ 的根节点，旧代等 lock_writers_ == 0 时回收
+  AsyncSlot locks_;
+  LockProbeTable lock_probes_;
+  std::atomic<uint32_t> lock_writers_{0};
+  std::atomic<uint32_t> lock_period_{100000};  ///< 每多少次加锁出一份报告
+  std::mutex lock_hook_mutex_;      ///< 串行化钩子的安装与卸下
+  std::mutex intercept_mutex_;                       ///< 保护 intercepted_calls_
+  std::unordered_set<std::string> intercepted_calls_;  ///< 本服务开启的拦截规则
+  bool lock_hook_installed_ = false;  ///< 受 lock_hook_mutex_ 保护
+
+  // 管线钩子：与锁竞争钩子相同，所有线程共享 pipelines_ 的根节点，旧代等 pipeline_writers_ == 0 时回收
+  AsyncSlot pipelines_;
+  PipelineProbeTable pipeline_probes_;
+  std::atomic<uint32_t> pipeline_writers_{0};
+  std::atomic<uint32_t> pipeline_period_{1000};  ///< 出报告的阶段次数周期，也是异步帧的采样间隔
+  std::mutex pipeline_hook_mutex_;       ///< 串行化钩子的安装与卸下
+  bool pipeline_hook_installed_ = false;  ///< 受 pipeline_hook_mutex_ 保护
+
+  // 设备区间：只有设备轮询线程写入 devices_ 的根节点，旧代等 device_writers_ == 0 时回收
+  AsyncSlot devices_;
+  std::atomic<uint32_t> device_writers_{0};
+  std::atomic<uint32_t> device_period_{1000};  ///< 每多少段设备区间出一份报告
+  DeviceTimeline device_timeline_{
+      [this](const ResolvedDeviceSpan& span) { RecordDeviceSpan(span); }};
+
+  std::mutex alloc_hook_mutex_;        ///< 串行化分配钩子的安装与卸下
+  bool alloc_hook_installed_ = false;  ///< 受 alloc_hook_mutex_ 保护
+
+  KeyedRootTable keyed_roots_;  ///< 分组根 (Z3Y_PROFILE_ROOT_KEYED)
+
+  // 探针注册表：位图一次分配、从不搬迁，探针热路径只读其中一位
+  mutable std::mutex probe_mutex_;
+  std::vector<z3y::interfaces::profiler::ProbeInfo>
+      probes_;  ///< 下标即位图下标；0 号保留（恒为启用）
+  std::unordered_map<std::string, uint32_t>
+      probe_index_;  ///< "文件:行号:名字" -> 下标（模块重载后沿用同一位）
+  std::vector<ProbeRule> probe_rules_;
+  std::unique_ptr<std::atomic<uint64_t>[]> probe_bits_;
+  uint32_t probe_tag_ = 0;  ///< 本实例的注册表标签（非 0）
+
   static std::atomic<uint64_t> g_instance_counter_;  // [新增] 全局计数器
   uint64_t instance_id_;                             // [新增] 本实例 ID
 };
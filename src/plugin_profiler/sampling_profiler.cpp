@@ -0,0 +1,437 @@
+﻿/**
+ * @file sampling_profiler.cpp
+ * @brief SamplingProfiler 的平台相关实现（SIGPROF / SuspendThread）。
+ * * @details
+ * 【面向维护者 - 信号处理函数的生命周期】
+ * SIGPROF 的处理函数位于本插件的代码段中。插件卸载前必须保证：
+ * 1. 计时器已停止，且 `g_active_sampler` 已置空（迟到的信号直接返回）；
+ * 2. 正在执行的处理函数都已返回（`g_handlers_in_flight` 归零）；
+ * 3. 信号处置已改回安装前的状态。若安装前是 SIG_DFL，改为 SIG_IGN ——
+ * SIGPROF 的默认动作是终止进程，卸载后仍在途的信号不能把宿主杀掉。
+ */
+
+#include "sampling_profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#include <TlHelp32.h>
+#else
+#include <dlfcn.h>  // dladdr
+#include <signal.h>
+#include <sys/syscall.h>
+#include <sys/time.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+#include <cerrno>
+#endif
+
+#include "framework/z3y_utils.h"  // PathToUtf8
+
+namespace z3y::plugins::profiler {
+
+using namespace z3y::interfaces::profiler;
+
+namespace {
+/// 进程内当前开启的采样器（同一时刻至多一个）
+std::atomic<SamplingProfiler*> g_active_sampler{nullptr};
+}  // namespace
+
+#ifndef _WIN32
+namespace {
+
+std::atomic<int> g_handlers_in_flight{0};
+std::mutex g_signal_mutex;          ///< 保护下面两项
+bool g_signal_installed = false;    ///< 本模块的处理函数是否已安装
+struct sigaction g_previous_action;  ///< 安装前的信号处置
+
+/** @brief 从信号上下文中取出被中断的指令地址。不支持的架构返回 0。 */
+uintptr_t ProgramCounterOf(void* context) {
+  auto* uc = static_cast<ucontext_t*>(context);
+#if defined(__linux__) && defined(__x86_64__)
+  return static_cast<uintptr_t>(uc->uc_mcontext.gregs[REG_RIP]);
+#elif defined(__linux__) && defined(__i386__)
+  return static_cast<uintptr_t>(uc->uc_mcontext.gregs[REG_EIP]);
+#elif defined(__linux__) && defined(__aarch64__)
+  return static_cast<uintptr_t>(uc->uc_mcontext.pc);
+#else
+  (void)uc;
+  return 0;
+#endif
+}
+
+constexpr bool kPlatformSupported =
+#if defined(__linux__) && \
+    (defined(__x86_64__) || defined(__i386__) || defined(__aarch64__))
+    true;
+#else
+    false;
+#endif
+
+void OnProfSignal(int, siginfo_t*, void* context) {
+  const int saved_errno = errno;
+  g_handlers_in_flight.fetch_add(1);
+  if (SamplingProfiler* sampler = g_active_sampler.load()) {
+    sampler->Push(ProgramCounterOf(context),
+                  static_cast<uint64_t>(syscall(SYS_gettid)));
+  }
+  g_handlers_in_flight.fetch_sub(1);
+  errno = saved_errno;
+}
+
+void WaitForHandlers() {
+  while (g_handlers_in_flight.load() > 0) std::this_thread::yield();
+}
+
+}  // namespace
+#endif
+
+SamplingProfiler::SamplingProfiler()
+    : ring_(std::make_unique<RawSample[]>(kRingCapacity)) {}
+
+SamplingProfiler::~SamplingProfiler() {
+  SetRate(0);
+#ifndef _WIN32
+  std::lock_guard<std::mutex> lock(g_signal_mutex);
+  if (g_signal_installed && !g_active_sampler.load()) {
+    struct sigaction restore = g_previous_action;
+    if (!(restore.sa_flags & SA_SIGINFO) && restore.sa_handler == SIG_DFL) {
+      restore.sa_handler = SIG_IGN;
+    }
+    sigaction(SIGPROF, &restore, nullptr);
+    g_signal_installed = false;
+    WaitForHandlers();
+  }
+#endif
+}
+
+bool SamplingProfiler::SetRate(uint32_t hz) {
+  hz = std::min(hz, kMaxRateHz);
+  std::lock_guard<std::mutex> lock(control_mutex_);
+  if (hz == rate_hz_.load(std::memory_order_relaxed)) return true;
+  Stop();
+  {
+    // 新会话：丢弃上一次的样本
+    std::lock_guard<std::mutex> data_lock(data_mutex_);
+    DrainLocked();
+    pc_counts_.clear();
+    thread_counts_.clear();
+    total_samples_ = 0;
+    dropped_.store(0, std::memory_order_relaxed);
+  }
+  if (hz == 0) return true;
+  if (!Start(hz)) return false;
+  rate_hz_.store(hz, std::memory_order_relaxed);
+  return true;
+}
+
+void SamplingProfiler::Push(uintptr_t pc, uint64_t thread_id) noexcept {
+  if (pc == 0) return;
+  uint64_t index = write_index_.load(std::memory_order_relaxed);
+  do {
+    if (index - read_index_.load(std::memory_order_acquire) >= kRingCapacity) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+  } while (!write_index_.compare_exchange_weak(index, index + 1,
+                                               std::memory_order_relaxed));
+  RawSample& sample = ring_[index & (kRingCapacity - 1)];
+  sample.thread_id.store(thread_id, std::memory_order_relaxed);
+  sample.pc.store(pc, std::memory_order_release);
+}
+
+void SamplingProfiler::DrainLocked() {
+  uint64_t read = read_index_.load(std::memory_order_relaxed);
+  const uint64_t write = write_index_.load(std::memory_order_acquire);
+  for (; read < write; ++read) {
+    RawSample& sample = ring_[read & (kRingCapacity - 1)];
+    const uintptr_t pc = sample.pc.load(std::memory_order_acquire);
+    if (pc == 0) break;  // 写者已占位但尚未写完，下次再取
+    ++pc_counts_[pc];
+    ++thread_counts_[sample.thread_id.load(std::memory_order_relaxed)];
+    ++total_samples_;
+    sample.pc.store(0, std::memory_order_relaxed);
+  }
+  read_index_.store(read, std::memory_order_release);
+}
+
+bool SamplingProfiler::Start(uint32_t hz) {
+#ifndef _WIN32
+  if (!kPlatformSupported) return false;
+#endif
+  SamplingProfiler* expected = nullptr;
+  if (!g_active_sampler.compare_exchange_strong(expected, this)) return false;
+#ifndef _WIN32
+  {
+    std::lock_guard<std::mutex> lock(g_signal_mutex);
+    if (!g_signal_installed) {
+      struct sigaction action {};
+      action.sa_sigaction = &OnProfSignal;
+      action.sa_flags = SA_SIGINFO | SA_RESTART;
+      sigemptyset(&action.sa_mask);
+      if (sigaction(SIGPROF, &action, &g_previous_action) != 0) {
+        g_active_sampler.store(nullptr);
+        return false;
+      }
+      g_signal_installed = true;
+    }
+  }
+  itimerval timer{};
+  timer.it_interval.tv_sec = 0;
+  timer.it_interval.tv_usec = static_cast<suseconds_t>(1000000 / hz);
+  timer.it_value = timer.it_interval;
+  if (setitimer(ITIMER_PROF, &timer, nullptr) != 0) {
+    g_active_sampler.store(nullptr);
+    return false;
+  }
+#endif
+  {
+    std::lock_guard<std::mutex> lock(worker_mutex_);
+    worker_stop_ = false;
+  }
+  worker_ = std::thread(&SamplingProfiler::WorkerLoop, this, hz);
+  return true;
+}
+
+void SamplingProfiler::Stop() {
+  if (!worker_.joinable()) return;
+#ifndef _WIN32
+  itimerval timer{};
+  setitimer(ITIMER_PROF, &timer, nullptr);
+  g_active_sampler.store(nullptr);
+  WaitForHandlers();  // 之后不会再有写者
+#endif
+  {
+    std::lock_guard<std::mutex> lock(worker_mutex_);
+    worker_stop_ = true;
+  }
+  worker_cv_.notify_all();
+  worker_.join();
+#ifdef _WIN32
+  g_active_sampler.store(nullptr);
+#endif
+  rate_hz_.store(0, std::memory_order_relaxed);
+}
+
+void SamplingProfiler::WorkerLoop(uint32_t hz) {
+#ifdef _WIN32
+  // Windows 上由本线程主动采样：每一拍间隔 1000/hz ms（受系统计时器精度限制）
+  const auto period = std::chrono::microseconds(1000000 / hz);
+  const uint32_t ticks_per_drain = std::max<uint32_t>(1, hz / 10);
+  uint32_t tick = 0;
+  std::unique_lock<std::mutex> lock(worker_mutex_);
+  while (!worker_cv_.wait_for(lock, period, [this] { return worker_stop_; })) {
+    lock.unlock();
+    // 每秒刷新一次线程列表，以发现新创建的线程
+    SampleThreads(tick % std::max<uint32_t>(1, hz) == 0);
+    if (++tick % ticks_per_drain == 0) {
+      std::lock_guard<std::mutex> data_lock(data_mutex_);
+      DrainLocked();
+    }
+    lock.lock();
+  }
+  lock.unlock();
+  for (auto& entry : threads_) CloseHandle(entry.handle);
+  threads_.clear();
+  std::lock_guard<std::mutex> data_lock(data_mutex_);
+  DrainLocked();
+#else
+  (void)hz;
+  std::unique_lock<std::mutex> lock(worker_mutex_);
+  while (!worker_cv_.wait_for(lock, std::chrono::milliseconds(100),
+                              [this] { return worker_stop_; })) {
+    lock.unlock();
+    {
+      std::lock_guard<std::mutex> data_lock(data_mutex_);
+      DrainLocked();
+    }
+    lock.lock();
+  }
+#endif
+}
+
+#ifdef _WIN32
+void SamplingProfiler::SampleThreads(bool refresh) {
+  const DWORD self = GetCurrentThreadId();
+  if (refresh || threads_.empty()) {
+    std::vector<ThreadEntry> fresh;
+    HANDLE snapshot = CreateToolhelp32Snapshot(TH32CS_SNAPTHREAD, 0);
+    if (snapshot != INVALID_HANDLE_VALUE) {
+      THREADENTRY32 te{};
+      te.dwSize = sizeof(te);
+      const DWORD pid = GetCurrentProcessId();
+      for (BOOL ok = Thread32First(snapshot, &te); ok;
+           ok = Thread32Next(snapshot, &te)) {
+        if (te.th32OwnerProcessID != pid || te.th32ThreadID == self) continue;
+        auto known = std::find_if(threads_.begin(), threads_.end(),
+                                  [&](const ThreadEntry& e) {
+                                    return e.id == te.th32ThreadID;
+                                  });
+        if (known != threads_.end()) {
+          fresh.push_back(*known);
+          known->handle = nullptr;  // 所有权转移到 fresh
+          continue;
+        }
+        HANDLE handle = OpenThread(THREAD_SUSPEND_RESUME | THREAD_GET_CONTEXT |
+                                       THREAD_QUERY_INFORMATION,
+                                   FALSE, te.th32ThreadID);
+        if (handle) fresh.push_back({te.th32ThreadID, handle, 0});
+      }
+      CloseHandle(snapshot);
+    }
+    for (auto& entry : threads_) {
+      if (entry.handle) CloseHandle(entry.handle);  // 已退出的线程
+    }
+    threads_ = std::move(fresh);
+  }
+
+  for (auto& entry : threads_) {
+    ULONG64 cycles = 0;
+    if (!QueryThreadCycleTime(entry.handle, &cycles) || cycles == entry.cycles) {
+      continue;  // 自上一拍以来没有运行过
+    }
+    entry.cycles = cycles;
+    if (SuspendThread(entry.handle) == static_cast<DWORD>(-1)) continue;
+    CONTEXT context{};
+    context.ContextFlags = CONTEXT_CONTROL;
+    if (GetThreadContext(entry.handle, &context)) {
+#if defined(_M_X64)
+      Push(static_cast<uintptr_t>(context.Rip), entry.id);
+#elif defined(_M_IX86)
+      Push(static_cast<uintptr_t>(context.Eip), entry.id);
+#elif defined(_M_ARM64)
+      Push(static_cast<uintptr_t>(context.Pc), entry.id);
+#endif
+    }
+    ResumeThread(entry.handle);
+  }
+}
+#endif
+
+ResolvedAddress ResolveAddress(uintptr_t pc) {
+  char offset[32];
+#ifdef _WIN32
+  HMODULE module = nullptr;
+  if (GetModuleHandleExW(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS |
+                             GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+                         reinterpret_cast<LPCWSTR>(pc), &module)) {
+    wchar_t buffer[MAX_PATH];
+    const DWORD length = GetModuleFileNameW(module, buffer, MAX_PATH);
+    std::snprintf(offset, sizeof(offset), "+0x%llx",
+                  static_cast<unsigned long long>(
+                      pc - reinterpret_cast<uintptr_t>(module)));
+    return {length > 0 ? z3y::utils::PathToUtf8(
+                             std::filesystem::path(std::wstring(buffer, length))
+                                 .filename())
+                       : std::string("[unknown]"),
+            offset};
+  }
+#else
+  Dl_info info{};
+  if (dladdr(reinterpret_cast<void*>(pc), &info) && info.dli_fname) {
+    ResolvedAddress out;
+    out.module = std::filesystem::path(info.dli_fname).filename().string();
+    if (info.dli_sname) {
+      out.symbol = info.dli_sname;
+    } else {
+      std::snprintf(offset, sizeof(offset), "+0x%llx",
+                    static_cast<unsigned long long>(
+                        pc - reinterpret_cast<uintptr_t>(info.dli_fbase)));
+      out.symbol = offset;
+    }
+    return out;
+  }
+#endif
+  std::snprintf(offset, sizeof(offset), "0x%llx",
+                static_cast<unsigned long long>(pc));
+  return {"[unknown]", offset};
+}
+
+namespace {
+
+std::string ThreadNameOf(uint64_t thread_id) {
+#if defined(__linux__)
+  std::ifstream comm("/proc/self/task/" + std::to_string(thread_id) + "/comm");
+  std::string name;
+  std::getline(comm, name);
+  return name;
+#else
+  (void)thread_id;
+  return {};
+#endif
+}
+
+template <typename T>
+void SortBySamples(std::vector<T>& items) {
+  std::sort(items.begin(), items.end(),
+            [](const T& a, const T& b) { return a.samples > b.samples; });
+}
+
+}  // namespace
+
+SamplingProfile SamplingProfiler::Collect(
+    const std::vector<std::string>& plugin_files, size_t max_symbols) {
+  SamplingProfile profile;
+  profile.rate_hz = rate_hz_.load(std::memory_order_relaxed);
+  std::vector<std::pair<uintptr_t, uint64_t>> pcs;
+  std::vector<std::pair<uint64_t, uint64_t>> threads;
+  {
+    std::lock_guard<std::mutex> lock(data_mutex_);
+    DrainLocked();
+    profile.total_samples = total_samples_;
+    pcs.assign(pc_counts_.begin(), pc_counts_.end());
+    threads.assign(thread_counts_.begin(), thread_counts_.end());
+  }
+  profile.dropped_samples = dropped_.load(std::memory_order_relaxed);
+
+  std::vector<std::string> plugin_names;
+  plugin_names.reserve(plugin_files.size());
+  for (const auto& file : plugin_files) {
+    plugin_names.push_back(z3y::utils::PathToUtf8(
+        z3y::utils::Utf8ToPath(file).filename()));
+  }
+
+  // 解析在锁外进行：dladdr 可能较慢，且不能阻塞后台汇总
+  std::unordered_map<std::string, uint64_t> module_samples;
+  std::unordered_map<std::string, SampledSymbol> symbol_samples;
+  for (const auto& [pc, count] : pcs) {
+    ResolvedAddress where = ResolveAddress(pc);
+    module_samples[where.module] += count;
+    SampledSymbol& symbol = symbol_samples[where.module + '!' + where.symbol];
+    if (symbol.samples == 0) {
+      symbol.module = where.module;
+      symbol.symbol = std::move(where.symbol);
+    }
+    symbol.samples += count;
+  }
+
+  for (auto& [name, count] : module_samples) {
+    const bool is_plugin = std::find(plugin_names.begin(), plugin_names.end(),
+                                     name) != plugin_names.end();
+    profile.modules.push_back({name, is_plugin, count});
+  }
+  SortBySamples(profile.modules);
+
+  for (auto& entry : symbol_samples) {
+    profile.symbols.push_back(std::move(entry.second));
+  }
+  SortBySamples(profile.symbols);
+  if (profile.symbols.size() > max_symbols) profile.symbols.resize(max_symbols);
+
+  for (const auto& [id, count] : threads) {
+    profile.threads.push_back({id, ThreadNameOf(id), count});
+  }
+  SortBySamples(profile.threads);
+  return profile;
+}
+
+}  // namespace z3y::plugins::profiler
@@ -0,0 +1,119 @@
+﻿/**
+ * @file sampling_profiler.h
+ * @brief 与插桩并行的连续采样分析器（System.Profiler.SamplingHz）。
+ * * @details
+ * 【面向维护者】
+ * 插桩只能看到写了 Z3Y_PROFILE* 宏的代码。采样模式按固定频率记录进程内
+ * 正在运行的线程的指令地址 (PC)，事后按模块 / 导出符号聚合：
+ * 1. **Linux**：`setitimer(ITIMER_PROF)` 按进程 CPU 时间投递 SIGPROF，内核把信号
+ * 交给正在消耗 CPU 的线程；处理函数只从 ucontext 取 PC、读线程 ID，
+ * 再写入无锁环形缓冲区，全部是异步信号安全的操作。空闲线程不会被采到。
+ * 2. **Windows**：后台线程逐个 `SuspendThread` + `GetThreadContext` 取 PC。
+ * 只采样自上一拍以来消耗过 CPU 周期的线程 (`QueryThreadCycleTime`)，
+ * 语义与 Linux 一致；目标线程挂起期间不做任何堆分配（防止与其持有的堆锁死锁）。
+ * 3. **只记录叶子 PC**：在信号处理函数里展开调用栈需要帧指针或 unwinder，
+ * 后者可能与正在 dlopen 的线程死锁（插件加载时恰好会发生），所以不做。
+ * 4. **后台汇总**：同一个工作线程每 100ms 把环形缓冲区汇总到 PC -> 次数表；
+ * 地址解析 (dladdr / GetModuleHandleEx) 只在 `Collect` 时对不同的 PC 各做一次。
+ * 进程内同一时刻只能有一个采样器处于开启状态（SIGPROF 与 ITIMER_PROF 都是进程级资源）。
+ */
+
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "interfaces_profiler/profiler_report.h"
+
+namespace z3y::plugins::profiler {
+
+/** @brief 一个地址解析后的归属。 */
+struct ResolvedAddress {
+  std::string module;  ///< 所在模块的文件名；查不到时为 "[unknown]"
+  std::string symbol;  ///< 导出符号名；查不到时为模块内偏移 "+0x..."
+};
+
+/** @brief 把代码地址解析为模块与符号（dladdr / GetModuleHandleEx，较慢，结果应缓存）。 */
+ResolvedAddress ResolveAddress(uintptr_t pc);
+
+/**
+ * @brief 进程级采样分析器。由 ProfilerService 持有，所有公有方法线程安全。
+ */
+class SamplingProfiler {
+ public:
+  static constexpr uint32_t kMaxRateHz = 10000;      ///< 采样频率上限
+  static constexpr size_t kRingCapacity = 1u << 14;  ///< 环形缓冲区样本数（2 的幂）
+
+  SamplingProfiler();
+  ~SamplingProfiler();
+  SamplingProfiler(const SamplingProfiler&) = delete;
+  SamplingProfiler& operator=(const SamplingProfiler&) = delete;
+
+  /**
+   * @brief 设置采样频率，0 表示关闭。频率变化时清空之前的样本，开始新的会话。
+   * @return false 表示当前平台不支持，或进程内已有别的采样器在运行。
+   */
+  bool SetRate(uint32_t hz);
+
+  /** @brief 当前采样频率（0 表示未开启）。 */
+  uint32_t GetRate() const { return rate_hz_.load(std::memory_order_relaxed); }
+
+  /**
+   * @brief 汇总当前会话的样本。
+   * @param plugin_files 已加载插件的路径（来自 IPluginQuery::GetLoadedPluginFiles）。
+   * @param max_symbols 最多返回的函数条目数。
+   */
+  z3y::interfaces::profiler::SamplingProfile Collect(
+      const std::vector<std::string>& plugin_files, size_t max_symbols);
+
+  /** @brief 写入一个样本（异步信号安全：只有原子操作）。缓冲区已满时计入丢弃数。 */
+  void Push(uintptr_t pc, uint64_t thread_id) noexcept;
+
+ private:
+  /** @brief 环形缓冲区中的一个样本。pc 非 0 表示写入已完成。 */
+  struct RawSample {
+    std::atomic<uintptr_t> pc{0};
+    std::atomic<uint64_t> thread_id{0};
+  };
+
+  bool Start(uint32_t hz);
+  void Stop();
+  void WorkerLoop(uint32_t hz);
+  /** @brief 把环形缓冲区中已完成的样本汇总到 pc_counts_（调用方持有 data_mutex_）。 */
+  void DrainLocked();
+#ifdef _WIN32
+  /** @brief 挂起每个消耗过 CPU 的线程并记录它的 PC。 */
+  void SampleThreads(bool refresh);
+  struct ThreadEntry {
+    unsigned long id = 0;
+    void* handle = nullptr;
+    uint64_t cycles = 0;
+  };
+  std::vector<ThreadEntry> threads_;  ///< 只由工作线程访问
+#endif
+
+  std::mutex control_mutex_;  ///< 串行化 SetRate
+  std::atomic<uint32_t> rate_hz_{0};
+  std::thread worker_;
+  std::mutex worker_mutex_;
+  std::condition_variable worker_cv_;
+  bool worker_stop_ = false;  ///< 受 worker_mutex_ 保护
+
+  std::unique_ptr<RawSample[]> ring_;
+  std::atomic<uint64_t> write_index_{0};
+  std::atomic<uint64_t> read_index_{0};
+  std::atomic<uint64_t> dropped_{0};
+
+  std::mutex data_mutex_;  ///< 保护下列汇总数据，并保证只有一个消费者读环形缓冲区
+  std::unordered_map<uintptr_t, uint64_t> pc_counts_;
+  std::unordered_map<uint64_t, uint64_t> thread_counts_;
+  uint64_t total_samples_ = 0;
+};
+
+}  // namespace z3y::plugins::profiler
@@ -0,0 +1,56 @@
+﻿/**
+ * @file tag_intern_table.h
+ * @brief 类型化标签 (Z3Y_PROFILE_TAG_NAME / Z3Y_PROFILE_TAG_ID) 使用的字符串驻留表。
+ * * @details
+ * 【面向维护者】
+ * 节点上的类型化标签只保存 8 字节的值，字符串标签保存的是这里的编号：
+ * 记录时不拷贝、不比较字符串，报告时才按编号查回文本。字符串由表自己拷贝保存，
+ * 调用方的缓冲区（或提供字面量的插件）之后被释放也不影响报告。
+ * 表只增不减，随服务实例一起销毁；数量超过 kMaxStrings 后一律返回 0。
+ */
+
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace z3y::plugins::profiler {
+
+/**
+ * @brief 字符串 -> 编号（从 1 开始）的只增表。所有方法线程安全。
+ */
+class TagInternTable {
+ public:
+  static constexpr size_t kMaxStrings = 4096;  ///< 不同字符串的数量上限
+
+  /** @brief 驻留 text 并返回编号；text 为空或表已满时返回 0。 */
+  uint32_t Intern(const char* text) {
+    if (!text) return 0;
+    const std::string_view key(text);
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(key);
+    if (it != index_.end()) return it->second;
+    if (strings_.size() >= kMaxStrings) return 0;
+    const std::string& stored = strings_.emplace_back(key);  // deque 中的元素不会移动
+    const auto id = static_cast<uint32_t>(strings_.size());
+    index_.emplace(std::string_view(stored), id);
+    return id;
+  }
+
+  /** @brief 按编号取回文本；未知编号（含 0）返回 "(other)"。 */
+  std::string Lookup(uint64_t id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (id == 0 || id > strings_.size()) return "(other)";
+    return strings_[static_cast<size_t>(id - 1)];
+  }
+
+ private:
+  mutable std::mutex mutex_;
+  std::unordered_map<std::string_view, uint32_t> index_;  ///< 键指向 strings_ 中的元素
+  std::deque<std::string> strings_;
+};
+
+}  // namespace z3y::plugins::profiler
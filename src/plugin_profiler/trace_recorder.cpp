@@ -0,0 +1,231 @@
+﻿/**
+ * @file trace_recorder.cpp
+ * @brief TraceRecorder 的实现。
+ */
+
+#include "trace_recorder.h"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <thread>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#elif defined(__linux__)
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "interfaces_profiler/profiler_clock.h"
+
+namespace z3y::plugins::profiler {
+
+using namespace z3y::interfaces::profiler;
+
+namespace {
+
+/** @brief 当前线程的系统线程 ID（与采样模式报告的一致）。 */
+uint64_t CurrentThreadId() {
+#ifdef _WIN32
+  return static_cast<uint64_t>(GetCurrentThreadId());
+#elif defined(__linux__)
+  return static_cast<uint64_t>(syscall(SYS_gettid));
+#else
+  return static_cast<uint64_t>(
+      std::hash<std::thread::id>()(std::this_thread::get_id()));
+#endif
+}
+
+void CopyName(char (&dst)[TraceRecorder::kNameLength], const char* src) {
+  size_t len = src ? std::strlen(src) : 0;
+  if (len >= TraceRecorder::kNameLength) len = TraceRecorder::kNameLength - 1;
+  if (len) std::memcpy(dst, src, len);
+  dst[len] = '\0';
+}
+
+}  // namespace
+
+/** @brief 线程当前使用的缓冲区及其所属的记录器实例。 */
+struct TraceThreadCache {
+  uint64_t owner = 0;
+  std::shared_ptr<void> ring;  // 类型擦除，避免在头文件中暴露 ThreadRing
+};
+thread_local TraceThreadCache tls_trace_ring;
+
+std::atomic<uint64_t> TraceRecorder::g_instance_counter_{1};
+
+TraceRecorder::TraceRecorder()
+    : instance_id_(g_instance_counter_.fetch_add(1, std::memory_order_relaxed)) {}
+
+void TraceRecorder::SetRingSize(size_t events) {
+  if (events > kMaxRingSize) events = kMaxRingSize;
+  std::lock_guard<std::mutex> lock(rings_mutex_);
+  if (events == ring_size_.load(std::memory_order_relaxed)) return;
+  rings_.clear();
+  device_rings_.clear();
+  start_ticks_.store(ProfilerClock::Now(), std::memory_order_relaxed);
+  session_.fetch_add(1, std::memory_order_release);
+  ring_size_.store(events, std::memory_order_relaxed);
+}
+
+TraceRecorder::ThreadRing* TraceRecorder::LocalRing() {
+  TraceThreadCache& cache = tls_trace_ring;
+  auto* ring = static_cast<ThreadRing*>(cache.ring.get());
+  if (ring && cache.owner == instance_id_ &&
+      ring->session == session_.load(std::memory_order_acquire)) {
+    return ring;
+  }
+
+  std::lock_guard<std::mutex> lock(rings_mutex_);
+  const size_t size = ring_size_.load(std::memory_order_relaxed);
+  if (size == 0) return nullptr;
+  auto fresh = std::make_shared<ThreadRing>();
+  fresh->session = session_.load(std::memory_order_relaxed);
+  fresh->thread_id = CurrentThreadId();
+  fresh->events.resize(size);
+  // 已退出线程（只剩登记表持有）的缓冲区超过上限时，丢弃最早的一个
+  size_t retired = 0;
+  for (const auto& r : rings_) retired += r.use_count() == 1;
+  if (retired >= kMaxRetiredRings) {
+    rings_.erase(std::find_if(rings_.begin(), rings_.end(),
+                              [](const auto& r) { return r.use_count() == 1; }));
+  }
+  rings_.push_back(fresh);
+  cache.owner = instance_id_;
+  cache.ring = fresh;
+  return fresh.get();
+}
+
+void TraceRecorder::PushLocked(ThreadRing& ring, TracePhase phase,
+                               uint64_t frame_id, const char* name,
+                               uint64_t ticks) {
+  RawEvent& e = ring.events[ring.written % ring.events.size()];
+  e.ticks = ticks;
+  e.frame_id = frame_id;
+  e.phase = phase;
+  CopyName(e.name, name);
+  ++ring.written;
+}
+
+void TraceRecorder::FrameBegin(uint64_t frame_id, const char* name) {
+  if (!IsEnabled()) return;
+  ThreadRing* ring = LocalRing();
+  if (!ring) return;
+  std::lock_guard<std::mutex> lock(ring->mutex);
+  PushLocked(*ring, TracePhase::FrameBegin, frame_id, name, ProfilerClock::Now());
+}
+
+void TraceRecorder::StageBegin(uint64_t frame_id, const char* name) {
+  if (!IsEnabled()) return;
+  ThreadRing* ring = LocalRing();
+  if (!ring) return;
+  const uint64_t now = ProfilerClock::Now();
+  std::lock_guard<std::mutex> lock(ring->mutex);
+  if (ring->stage_open) {
+    // ATTACH 覆盖线程的挂载目标：上一帧的处理到此为止
+    PushLocked(*ring, TracePhase::StageEnd, ring->stage_frame,
+               ring->stage_name, now);
+  }
+  PushLocked(*ring, TracePhase::StageBegin, frame_id, name, now);
+  ring->stage_open = true;
+  ring->stage_frame = frame_id;
+  CopyName(ring->stage_name, name);
+}
+
+void TraceRecorder::StageEnd(uint64_t frame_id) {
+  if (!IsEnabled()) return;
+  ThreadRing* ring = LocalRing();
+  if (!ring) return;
+  const uint64_t now = ProfilerClock::Now();
+  std::lock_guard<std::mutex> lock(ring->mutex);
+  if (!ring->stage_open || ring->stage_frame != frame_id) return;
+  PushLocked(*ring, TracePhase::StageEnd, frame_id, ring->stage_name, now);
+  ring->stage_open = false;
+}
+
+void TraceRecorder::FrameEnd(uint64_t frame_id, const char* name) {
+  if (!IsEnabled()) return;
+  ThreadRing* ring = LocalRing();
+  if (!ring) return;
+  std::lock_guard<std::mutex> lock(ring->mutex);
+  PushLocked(*ring, TracePhase::FrameEnd, frame_id, name, ProfilerClock::Now());
+}
+
+void TraceRecorder::DeviceSpan(uint64_t track_id, const char* device_name,
+                               const char* name, uint64_t begin_ticks,
+                               uint64_t end_ticks) {
+  if (!IsEnabled()) return;
+  std::shared_ptr<ThreadRing> ring;
+  {
+    std::lock_guard<std::mutex> lock(rings_mutex_);
+    const size_t size = ring_size_.load(std::memory_order_relaxed);
+    if (size == 0) return;
+    auto it = std::find_if(device_rings_.begin(), device_rings_.end(),
+                           [&](const auto& r) { return r->thread_id == track_id; });
+    if (it != device_rings_.end()) {
+      ring = *it;
+    } else {
+      ring = std::make_shared<ThreadRing>();
+      ring->session = session_.load(std::memory_order_relaxed);
+      ring->thread_id = track_id;
+      ring->events.resize(size);
+      ring->device_track = true;
+      CopyName(ring->stage_name, device_name);
+      rings_.push_back(ring);
+      device_rings_.push_back(ring);
+    }
+  }
+  std::lock_guard<std::mutex> lock(ring->mutex);
+  PushLocked(*ring, TracePhase::ScopeBegin, 0, name, begin_ticks);
+  PushLocked(*ring, TracePhase::ScopeEnd, 0, name, end_ticks);
+}
+
+TraceCapture TraceRecorder::Collect(bool clear) {
+  TraceCapture capture;
+  std::lock_guard<std::mutex> lock(rings_mutex_);
+  const uint64_t origin = start_ticks_.load(std::memory_order_relaxed);
+  const double us_per_tick = 1000.0 / ProfilerClock::TicksPerMs();
+  for (const auto& ring : rings_) {
+    std::lock_guard<std::mutex> ring_lock(ring->mutex);
+    if (ring->device_track) {
+      TraceEvent e;
+      e.thread_id = ring->thread_id;
+      e.phase = TracePhase::TrackName;
+      e.name = ring->stage_name;
+      capture.events.push_back(std::move(e));
+    }
+    const uint64_t size = ring->events.size();
+    const uint64_t kept = std::min<uint64_t>(ring->written, size);
+    capture.overwritten += ring->written - kept;
+    for (uint64_t i = ring->written - kept; i < ring->written; ++i) {
+      const RawEvent& raw = ring->events[i % size];
+      TraceEvent e;
+      e.timestamp_us =
+          raw.ticks > origin ? static_cast<double>(raw.ticks - origin) * us_per_tick
+                             : 0.0;
+      e.frame_id = raw.frame_id;
+      e.thread_id = ring->thread_id;
+      e.phase = raw.phase;
+      e.name = raw.name;
+      capture.events.push_back(std::move(e));
+    }
+    if (clear) ring->written = 0;
+  }
+  if (clear) {
+    rings_.erase(std::remove_if(rings_.begin(), rings_.end(),
+                                [](const auto& r) { return r.use_count() == 1; }),
+                 rings_.end());
+  }
+  // 各线程内部已有序；稳定排序保证同一时刻的 StageEnd 仍排在随后的 StageBegin 之前
+  std::stable_sort(capture.events.begin(), capture.events.end(),
+                   [](const TraceEvent& a, const TraceEvent& b) {
+                     return a.timestamp_us < b.timestamp_us;
+                   });
+  return capture;
+}
+
+}  // namespace z3y::plugins::profiler
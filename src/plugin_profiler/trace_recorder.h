@@ -0,0 +1,114 @@
+﻿/**
+ * @file trace_recorder.h
+ * @brief 异步流的跨线程追踪（System.Profiler.TraceRingSize）。
+ * * @details
+ * 【面向维护者】
+ * ASYNC_BEGIN / ATTACH / COMMIT 只把各线程的数据聚合进同一棵树，看不出一帧在阶段之间
+ * 排了多久的队。追踪模式在这几个调用处额外记一条带时间戳与线程 ID 的事件：
+ * 1. **每线程一个环形缓冲区**：只有所属线程写入，写满后覆盖最旧的事件。每个缓冲区
+ * 一把互斥锁，平时只有所属线程持有（无竞争），`Collect` 时才与之短暂竞争。
+ * 2. **名字按值拷贝**：帧名来自探针所在的插件，收集时它可能已被卸载，所以记录时就截断
+ * 拷贝到事件里，之后从不解引用原指针。
+ * 3. **线程退出后事件保留**：缓冲区由登记表与线程的 TLS 共同持有，线程退出后仍可被收集；
+ * `Collect(clear)` 会丢弃已退出线程的缓冲区，未收集时最多保留 kMaxRetiredRings 个。
+ * 4. **会话**：`SetRingSize` 每次改变容量都开启新会话并清空全部事件；各线程下一次记录时
+ * 发现会话变了，按新容量重新登记。
+ * 5. **设备轨道**：设备区间由轮询线程按设备写入各自的缓冲区（thread_id 为轨道 ID），
+ * 这些缓冲区另由 device_rings_ 持有，不会被当作已退出线程丢弃。
+ */
+
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "interfaces_profiler/profiler_report.h"
+
+namespace z3y::plugins::profiler {
+
+/**
+ * @brief 追踪事件记录器。由 ProfilerService 持有，所有公有方法线程安全。
+ */
+class TraceRecorder {
+ public:
+  static constexpr size_t kMaxRingSize = 1u << 20;   ///< 每线程事件数上限
+  static constexpr size_t kNameLength = 47;           ///< 事件内联保存的帧名长度
+  static constexpr size_t kMaxRetiredRings = 64;      ///< 未收集时保留的已退出线程缓冲区数
+
+  TraceRecorder();
+  TraceRecorder(const TraceRecorder&) = delete;
+  TraceRecorder& operator=(const TraceRecorder&) = delete;
+
+  /** @brief 设置每个线程的环形缓冲区容量（事件数），0 表示关闭。容量变化时清空全部事件。 */
+  void SetRingSize(size_t events);
+
+  /** @brief 追踪是否开启。 */
+  bool IsEnabled() const {
+    return ring_size_.load(std::memory_order_relaxed) != 0;
+  }
+
+  /** @brief 帧进入流水线（ASYNC_BEGIN 新建槽位）。 */
+  void FrameBegin(uint64_t frame_id, const char* name);
+  /** @brief 当前线程开始处理一帧（ASYNC_ATTACH）。本线程上未结束的阶段先被结束。 */
+  void StageBegin(uint64_t frame_id, const char* name);
+  /** @brief 当前线程结束对该帧的处理（ASYNC_COMMIT）。本线程并未处理该帧时什么也不做。 */
+  void StageEnd(uint64_t frame_id);
+  /** @brief 帧离开流水线（最后一个引用提交）。 */
+  void FrameEnd(uint64_t frame_id, const char* name);
+  /**
+   * @brief 在设备轨道 track_id 上记一段区间（ScopeBegin / ScopeEnd）。
+   * @param device_name 轨道名（首次出现时记下），Collect 时作为 TrackName 输出。
+   */
+  void DeviceSpan(uint64_t track_id, const char* device_name, const char* name,
+                  uint64_t begin_ticks, uint64_t end_ticks);
+
+  /**
+   * @brief 收集全部线程的事件，按时间升序排列。
+   * @param clear 为 true 时收集后清空缓冲区，并丢弃已退出线程的缓冲区。
+   */
+  z3y::interfaces::profiler::TraceCapture Collect(bool clear);
+
+ private:
+  /** @brief 环形缓冲区中的一条事件（64 字节）。 */
+  struct RawEvent {
+    uint64_t ticks;
+    uint64_t frame_id;
+    z3y::interfaces::profiler::TracePhase phase;
+    char name[kNameLength];
+  };
+
+  /** @brief 一个线程的环形缓冲区。除 session / thread_id 外的字段受 mutex 保护。 */
+  struct ThreadRing {
+    std::mutex mutex;
+    uint64_t session = 0;    ///< 登记时的会话号（登记后不变）
+    uint64_t thread_id = 0;  ///< 系统线程 ID（登记后不变）
+    std::vector<RawEvent> events;
+    uint64_t written = 0;      ///< 自上次清空以来写入的条数；下一条写到 written % size
+    bool stage_open = false;   ///< 本线程是否有未结束的阶段
+    uint64_t stage_frame = 0;  ///< 未结束阶段所属的帧
+    char stage_name[kNameLength] = {};  ///< 设备轨道上保存设备名
+    bool device_track = false;  ///< 设备轨道（登记后不变）
+  };
+
+  /** @brief 当前线程在本会话下的缓冲区，追踪关闭时返回 nullptr。 */
+  ThreadRing* LocalRing();
+  /** @brief 追加一条事件（调用方持有 ring.mutex）。 */
+  static void PushLocked(ThreadRing& ring,
+                         z3y::interfaces::profiler::TracePhase phase,
+                         uint64_t frame_id, const char* name, uint64_t ticks);
+
+  static std::atomic<uint64_t> g_instance_counter_;
+  const uint64_t instance_id_;  ///< 线程缓存按它识别换届
+
+  std::atomic<size_t> ring_size_{0};
+  std::atomic<uint64_t> session_{0};
+  std::atomic<uint64_t> start_ticks_{0};  ///< 本会话的时间原点
+
+  std::mutex rings_mutex_;  ///< 保护 rings_，并串行化 SetRingSize / Collect
+  std::vector<std::shared_ptr<ThreadRing>> rings_;
+  std::vector<std::shared_ptr<ThreadRing>> device_rings_;  ///< 设备轨道，受 rings_mutex_ 保护
+};
+
+}  // namespace z3y::plugins::profiler
@@ -20,11 +20,14 @@
 #include <QFormLayout>
 #include <QHBoxLayout>
 #include <QHeaderView>
+#include <QFutureWatcher>
 #include <QIcon>
+#include <QLabel>
 #include <QLineEdit>
 #include <QMessageBox>
 #include <QMetaType>
 #include <QProgressBar>
+#include <QPromise>
 #include <QPushButton>
 #include <QRegularExpression>
 #include <QScrollArea>
@@ -33,6 +36,7 @@
 #include <QSplitter>
 #include <QStatusBar>
 #include <QStringList>
+#include <QTableView>
 #include <QTableWidget>
 #include <QTimer>
 #include <QTreeWidget>
@@ -45,6 +49,7 @@
 
 #include "framework/z3y_service_locator.h"
 #include "interfaces_core/i_config_service.h"
+#include "performance_dashboard.h"
 #include "widget_factory.h"
 #include "qt_utils.h"
 
@@ -55,6 +60,8 @@ namespace qt_ui {
 ConfigMainWindow::ConfigMainWindow(EventBridge* bridge, QWidget* parent)
     : QMainWindow(parent), event_bridge_(bridge), current_group_("") {
   dependency_graph_ = std::make_unique<DependencyGraph>();
+  // 页面准备以 I/O 与拷贝为主，两条线程足够，也避免快速连续点击时抢占全局线程池
+  page_loader_pool_.setMaxThreadCount(2);
 
   // 挂载一个内部属性列表，专门用来记住那些“提交被后台拒绝”的控件路径
   this->setProperty("backend_errors", QStringList());
@@ -83,9 +90,27 @@ ConfigMainWindow::ConfigMainWindow(EventBridge* bridge, QWidget* parent)
   // 最核心的骨架连接：当桥接器收到数据时，通知本窗口进行批量局部重绘
   connect(event_bridge_, &EventBridge::batchedConfigChanged, this,
           &ConfigMainWindow::OnBatchedConfigChanged);
+  // 监视参数不产生变更事件，由拉取器按刷新率送来可见控件的新值，走同一条刷新路径
+  monitor_poller_ = new MonitorPoller(this);
+  connect(monitor_poller_, &MonitorPoller::valuesChanged, this,
+          &ConfigMainWindow::OnBatchedConfigChanged);
+  // 没有控件显示的参数 (所在页面未构建或已被 LRU 淘汰) 在桥接器里直接丢弃：
+  // 页面下次构建时会向后台读取最新值
+  event_bridge_->SetUpdateFilter([this](const QString& path) {
+    // 后台准备页面期间全部放行，由 OnBatchedConfigChanged 暂存给在途页面
+    if (!page_loads_.empty()) return true;
+    auto it = global_widget_map_.find(path);
+    if (it != global_widget_map_.end() && !it->second.isNull()) return true;
+    return FindVirtualModel(path) != nullptr;
+  });
 }
 
-ConfigMainWindow::~ConfigMainWindow() = default;
+ConfigMainWindow::~ConfigMainWindow() {
+  // 桥接器比窗口活得久，必须先摘掉捕获了 this 的过滤器
+  if (event_bridge_) event_bridge_->SetUpdateFilter(nullptr);
+  // 在途的数据准备任务不引用窗口，但仍在执行本插件的代码，卸载前必须等它们跑完
+  page_loader_pool_.waitForDone();
+}
 
 void ConfigMainWindow::SetRole(const std::string& role) {
   current_role_ = role;
@@ -116,6 +141,12 @@ void ConfigMainWindow::SetupUI() {
   toolbar_layout->addWidget(cb_advanced_);
   toolbar_layout->addStretch();
 
+  QPushButton* btn_perf = new QPushButton(tr("Performance Monitor"));
+  btn_perf->setStyleSheet("padding: 4px 15px;");
+  connect(btn_perf, &QPushButton::clicked, this,
+          &ConfigMainWindow::OnPerformanceMonitorClicked);
+  toolbar_layout->addWidget(btn_perf);
+
   QPushButton* btn_import = new QPushButton(tr("Import Profile"));
   btn_import->setStyleSheet("padding: 4px 15px;");
   connect(btn_import, &QPushButton::clicked, this,
@@ -152,10 +183,33 @@ void ConfigMainWindow::SetupUI() {
           &ConfigMainWindow::OnGlobalSearchTextChanged);
   left_layout->addWidget(search_box_);
 
+  // 连续打字只在停顿后查询一次
+  search_timer_ = new QTimer(this);
+  search_timer_->setSingleShot(true);
+  search_timer_->setInterval(kSearchDebounceMs);
+  connect(search_timer_, &QTimer::timeout, this,
+          &ConfigMainWindow::ApplyGlobalSearch);
+
   nav_tree_ = new QTreeWidget();
   nav_tree_->setHeaderHidden(true);
   connect(nav_tree_, &QTreeWidget::currentItemChanged, this,
           &ConfigMainWindow::OnTreeSelectionChanged);
+  // 手动展开 / 折叠也要让索引知道，差量基准才与树的真实状态一致
+  connect(nav_tree_, &QTreeWidget::itemExpanded, this,
+          [this](QTreeWidgetItem* item) {
+            search_index_.OnItemExpansionChanged(item, true);
+            // 子分组第一次展开时才创建参数节点，随后按当前的搜索与高级模式重新结算可见性
+            if (search_index_.Populate(item)) {
+              const QString text = search_box_->text();
+              if (!text.trimmed().isEmpty()) search_index_.LoadCatalog();
+              search_index_.Apply(
+                  search_index_.Evaluate(text, is_advanced_mode_), false);
+            }
+          });
+  connect(nav_tree_, &QTreeWidget::itemCollapsed, this,
+          [this](QTreeWidgetItem* item) {
+            search_index_.OnItemExpansionChanged(item, false);
+          });
   left_layout->addWidget(nav_tree_);
 
   splitter->addWidget(left_panel);
@@ -170,94 +224,58 @@ void ConfigMainWindow::LoadNavigationTree() {
       z3y::GetDefaultService<z3y::interfaces::core::IConfigService>();
   if (!config_srv) return;
 
-  auto all_configs = config_srv->GetAllConfigs();
-  std::map<QString, QTreeWidgetItem*> group_nodes;
-  std::map<QString, QTreeWidgetItem*> subgroup_nodes;
-
-  for (const auto& [path, snap] : all_configs) {
-    if (snap.meta.is_hidden) continue;
-    QString g_key = QString::fromStdString(snap.meta.group_key);
-    if (g_key.isEmpty()) continue;
+  // 只按分组索引的计数搭骨架 (分组 / 子分组)，不复制任何参数快照；
+  // 参数节点在子分组展开或搜索命中时才由搜索索引经 loader 拉取并创建
+  for (const auto& group : config_srv->GetGroupIndex()) {
+    QString g_key = QString::fromStdString(group.group_key);
 
     // 分组节点构建 (例如 "Network")
-    if (!group_nodes.count(g_key)) {
-      QTreeWidgetItem* grp_item =
-          new QTreeWidgetItem(nav_tree_, QStringList() << g_key);
-      grp_item->setData(0, Qt::UserRole, g_key);
-      grp_item->setData(0, Qt::UserRole + 1, "GROUP");
-      group_nodes[g_key] = grp_item;
-    }
-
-    // 子分组节点构建
-    QString subg_key = snap.meta.subgroup_key.empty() ? tr("General Attributes") : QString::fromStdString(snap.meta.subgroup_key);
-    QString full_subg_key = g_key + "::" + subg_key;
-    if (!subgroup_nodes.count(full_subg_key)) {
+    QTreeWidgetItem* grp_item =
+        new QTreeWidgetItem(nav_tree_, QStringList() << g_key);
+    grp_item->setData(0, Qt::UserRole, g_key);
+    grp_item->setData(0, Qt::UserRole + 1, "GROUP");
+
+    // 子分组节点构建：带计数、暂无子节点，始终显示展开箭头
+    for (const auto& sub : group.subgroups) {
+      QString subg_key = sub.subgroup_key.empty() ? tr("General Attributes") : QString::fromStdString(sub.subgroup_key);
       QTreeWidgetItem* subgrp_item =
-          new QTreeWidgetItem(group_nodes[g_key], QStringList() << subg_key);
+          new QTreeWidgetItem(grp_item, QStringList() << subg_key);
       subgrp_item->setData(0, Qt::UserRole, g_key); // 点击 SubGroup 还是切换到对应的 Group 页面
       subgrp_item->setData(0, Qt::UserRole + 1, "SUBGROUP");
-      subgroup_nodes[full_subg_key] = subgrp_item;
+      subgrp_item->setData(0, NavigationSearchIndex::kSubgroupKeyRole,
+                           QString::fromStdString(sub.subgroup_key));
+      subgrp_item->setData(0, NavigationSearchIndex::kVisibleCountRole,
+                           sub.visible_count);
+      subgrp_item->setData(0, NavigationSearchIndex::kAdvancedCountRole,
+                           sub.advanced_count);
+      subgrp_item->setChildIndicatorPolicy(QTreeWidgetItem::ShowIndicator);
     }
-
-    // 参数节点构建 (挂在组下面，如 "IP Address")
-    QString name = QString::fromStdString(snap.meta.name_key);
-    QTreeWidgetItem* item_node =
-        new QTreeWidgetItem(subgroup_nodes[full_subg_key], QStringList() << name);
-    item_node->setData(0, Qt::UserRole, QString::fromStdString(path));
-    item_node->setData(0, Qt::UserRole + 1, "ITEM");
-    item_node->setData(0, Qt::UserRole + 2, g_key);
-    item_node->setData(0, Qt::UserRole + 3, snap.meta.is_advanced); // 存入高级标记
   }
-  
+
+  // 树结构 (Schema) 一旦重建，搜索索引必须跟着重建
+  search_index_.Build(nav_tree_, [](const QTreeWidgetItem* subgroup) {
+    std::vector<NavigationSearchIndex::LazyItem> items;
+    auto srv = z3y::GetDefaultService<z3y::interfaces::core::IConfigService>();
+    if (!srv) return items;
+    const auto entries = srv->GetSubgroupEntries(
+        subgroup->data(0, Qt::UserRole).toString().toStdString(),
+        subgroup->data(0, NavigationSearchIndex::kSubgroupKeyRole)
+            .toString()
+            .toStdString());
+    items.reserve(entries.size());
+    for (const auto& e : entries) {
+      items.push_back({QString::fromStdString(e.path),
+                       QString::fromStdString(e.name_key), e.is_advanced});
+    }
+    return items;
+  });
   RefreshTreeVisibility(is_advanced_mode_);
 }
 
 void ConfigMainWindow::RefreshTreeVisibility(bool is_advanced_mode) {
-  // 1. 先根据高级模式控制所有 ITEM 的显示/隐藏
-  QTreeWidgetItemIterator it_item(nav_tree_);
-  while (*it_item) {
-    if ((*it_item)->data(0, Qt::UserRole + 1).toString() == "ITEM") {
-      bool is_advanced = (*it_item)->data(0, Qt::UserRole + 3).toBool();
-      if (is_advanced && !is_advanced_mode) {
-        (*it_item)->setHidden(true);
-      } else {
-        (*it_item)->setHidden(false);
-      }
-    }
-    ++it_item;
-  }
-
-  // 2. 检查并更新所有 SUBGROUP (如果全隐藏，自身也隐藏)
-  QTreeWidgetItemIterator it_subg(nav_tree_);
-  while (*it_subg) {
-    if ((*it_subg)->data(0, Qt::UserRole + 1).toString() == "SUBGROUP") {
-      bool has_visible_child = false;
-      for (int i = 0; i < (*it_subg)->childCount(); ++i) {
-        if (!(*it_subg)->child(i)->isHidden()) {
-          has_visible_child = true;
-          break;
-        }
-      }
-      (*it_subg)->setHidden(!has_visible_child);
-    }
-    ++it_subg;
-  }
-
-  // 3. 检查并更新所有 GROUP (如果全隐藏，自身也隐藏)
-  QTreeWidgetItemIterator it_g(nav_tree_);
-  while (*it_g) {
-    if ((*it_g)->data(0, Qt::UserRole + 1).toString() == "GROUP") {
-      bool has_visible_child = false;
-      for (int i = 0; i < (*it_g)->childCount(); ++i) {
-        if (!(*it_g)->child(i)->isHidden()) {
-          has_visible_child = true;
-          break;
-        }
-      }
-      (*it_g)->setHidden(!has_visible_child);
-    }
-    ++it_g;
-  }
+  // 参数节点按高级模式显隐，子分组 / 分组在子节点全部隐藏时跟着隐藏；展开状态保持不变
+  search_index_.Apply(search_index_.Evaluate(QString(), is_advanced_mode),
+                      false);
 }
 
 void ConfigMainWindow::OnTreeSelectionChanged(QTreeWidgetItem* current,
@@ -296,74 +314,185 @@ void ConfigMainWindow::OnTreeSelectionChanged(QTreeWidgetItem* current,
     // 缓存命中 (Cache Hit)：刷新 LRU 队列，直接展示
     lru_queue_.splice(lru_queue_.end(), lru_queue_, lru_mapping_[group_key]);
     stacked_pages_->setCurrentWidget(page_cache_[group_key]);
+    // == 场景2：用户其实是点击了树里面的某个特定参数节点 ==
+    RevealParameter(group_key, target_path);
+  } else if (page_loads_.count(group_key) > 0) {
+    // 该页面已在后台准备中：切回占位页，就绪后跳到最新点击的参数
+    PageLoad& load = page_loads_[group_key];
+    load.target_path = target_path;
+    if (load.placeholder) stacked_pages_->setCurrentWidget(load.placeholder);
   } else {
-    // 缓存未命中 (Cache Miss)：召唤工厂，生成这个全新的重型页面
-    auto value_changed_cb = [this](const QString& path, const QVariant& val) {
-      std::string safe_path = path.toStdString();
-      this->pending_changes_[safe_path] = val; // 记录到悬浮更改池中
+    // 缓存未命中 (Cache Miss)：数据准备丢给后台线程，GUI 线程先显示占位页
+    StartPageLoad(group_key, target_path);
+  }
+}
 
-      // 如果这个控件原来带着红色的错误边框，只要它一改动，立刻消除红框
-      QStringList errs = this->property("backend_errors").toStringList();
-      if (errs.removeAll(path) > 0) {
-        this->setProperty("backend_errors", errs);
-      }
+void ConfigMainWindow::StartPageLoad(const QString& group_key,
+                                     const QString& target_path) {
+  // 占位页：小分组通常一两帧内就绪，进度条延迟出现，避免一闪而过
+  QWidget* placeholder = new QWidget();
+  QVBoxLayout* layout = new QVBoxLayout(placeholder);
+  QLabel* label = new QLabel(tr("Loading %1 ...").arg(group_key));
+  label->setAlignment(Qt::AlignCenter);
+  QProgressBar* busy = new QProgressBar();
+  busy->setRange(0, 0);  // 不确定进度的忙碌动画
+  busy->setTextVisible(false);
+  busy->setFixedWidth(320);
+  layout->addStretch();
+  layout->addWidget(label);
+  layout->addWidget(busy, 0, Qt::AlignHCenter);
+  layout->addStretch();
+  label->setVisible(false);
+  busy->setVisible(false);
+  QTimer::singleShot(kLoadingIndicatorDelayMs, placeholder, [label, busy]() {
+    label->setVisible(true);
+    busy->setVisible(true);
+  });
+  stacked_pages_->addWidget(placeholder);
+  stacked_pages_->setCurrentWidget(placeholder);
+  page_loads_[group_key] = PageLoad{placeholder, target_path};
+
+  // 结果经 QFutureWatcher 回到 GUI 线程；watcher 随窗口销毁，迟到的结果自然被丢弃
+  using PlanPtr = std::shared_ptr<const PagePlan>;
+  auto promise = std::make_shared<QPromise<PlanPtr>>();
+  auto* watcher = new QFutureWatcher<PlanPtr>(this);
+  connect(watcher, &QFutureWatcher<PlanPtr>::finished, this, [this, watcher]() {
+    watcher->deleteLater();
+    if (watcher->future().resultCount() > 0) OnPagePlanReady(watcher->result());
+  });
+  watcher->setFuture(promise->future());
+  promise->start();
+  page_loader_pool_.start([promise, group_key]() {
+    promise->addResult(BuildPagePlan(group_key));
+    promise->finish();
+  });
+}
 
-      if (global_widget_map_.count(path) &&
-          !global_widget_map_[path].isNull()) {
-        global_widget_map_[path]->setStyleSheet(
-            "font-weight: bold; color: #b35900;"); // 改为醒目的橙色修改态
-        global_widget_map_[path]->setToolTip("");
-      }
-      // 通知依赖图谱更新其它联动控件
-      if (dependency_graph_) dependency_graph_->OnParameterChanged(safe_path);
-    };
+void ConfigMainWindow::OnPagePlanReady(std::shared_ptr<const PagePlan> plan) {
+  auto load_it = page_loads_.find(plan->group_key);
+  if (load_it == page_loads_.end()) return;
+  PageLoad load = load_it->second;
+  page_loads_.erase(load_it);
+
+  QWidget* new_page = InstallPage(*plan);
+  const bool is_current = (current_group_ == plan->group_key);
+  if (load.placeholder) {
+    const bool placeholder_shown =
+        stacked_pages_->currentWidget() == load.placeholder.data();
+    if (placeholder_shown) stacked_pages_->setCurrentWidget(new_page);
+    stacked_pages_->removeWidget(load.placeholder);
+    load.placeholder->deleteLater();
+  } else if (is_current) {
+    stacked_pages_->setCurrentWidget(new_page);
+  }
+  EvictOldestPageIfNeeded();
+  dependency_graph_->EvaluatePending(); // 只结算该新页面新挂载的依赖规则
+
+  // 重放准备期间到达的、属于本页面的后台变更
+  ConfigUpdateMap replay;
+  for (const PagePlanItem& item : plan->items) {
+    auto it = load_backlog_.find(item.qpath);
+    if (it == load_backlog_.end()) continue;
+    replay.insert(*it);
+    load_backlog_.erase(it);
+  }
+  if (page_loads_.empty()) load_backlog_.clear();
+  if (!replay.empty()) OnBatchedConfigChanged(replay);
 
-    QWidget* new_page = WidgetFactory::CreatePage(
-        group_key, current_role_, dependency_graph_.get(), pending_changes_,
-        this, value_changed_cb, is_advanced_mode_, custom_panels_);
+  if (is_current) RevealParameter(plan->group_key, load.target_path);
+}
 
-    // 将生成出来的控件全部录入全局雷达 (global_widget_map_)
-    auto child_widgets = new_page->findChildren<QWidget*>();
-    child_widgets.append(new_page);
+QWidget* ConfigMainWindow::InstallPage(const PagePlan& plan) {
+  const QString& group_key = plan.group_key;
+  auto value_changed_cb = [this](const QString& path, const QVariant& val) {
+    std::string safe_path = path.toStdString();
+    this->pending_changes_[safe_path] = val; // 记录到悬浮更改池中
 
-    QStringList current_errors =
-        this->property("backend_errors").toStringList();
+    // 如果这个控件原来带着红色的错误边框，只要它一改动，立刻消除红框
+    QStringList errs = this->property("backend_errors").toStringList();
+    if (errs.removeAll(path) > 0) {
+      this->setProperty("backend_errors", errs);
+    }
 
-    for (auto* child : child_widgets) {
-      QString path = child->property("config_path").toString();
-      if (!path.isEmpty()) {
-        global_widget_map_[path] = QPointer<QWidget>(child);
+    if (global_widget_map_.count(path) &&
+        !global_widget_map_[path].isNull()) {
+      global_widget_map_[path]->setStyleSheet(
+          "font-weight: bold; color: #b35900;"); // 改为醒目的橙色修改态
+      global_widget_map_[path]->setToolTip("");
+    }
+    // 通知依赖图谱更新其它联动控件
+    if (dependency_graph_) dependency_graph_->OnParameterChanged(safe_path);
+    RefreshVirtualConditions();
+  };
 
-        // 如果这个页面是带着旧的未修复错误加载进来的，自动补红框
-        if (current_errors.contains(path)) {
-          child->setStyleSheet(
-              "border: 2px solid red; background-color: #ffe6e6;");
-        } else if (pending_changes_.count(path.toStdString())) {
-          child->setStyleSheet("font-weight: bold; color: #b35900;");
-        }
+  // 数据已在后台准备好，这里只剩控件实例化与绑定
+  QWidget* new_page = WidgetFactory::CreatePage(
+      plan, dependency_graph_.get(), pending_changes_, this, value_changed_cb,
+      is_advanced_mode_, custom_panels_, &widget_pool_);
+
+  // 将生成出来的控件全部录入全局雷达 (global_widget_map_)
+  auto child_widgets = new_page->findChildren<QWidget*>();
+  child_widgets.append(new_page);
+
+  QStringList current_errors =
+      this->property("backend_errors").toStringList();
+
+  for (auto* child : child_widgets) {
+    QString path = child->property("config_path").toString();
+    if (!path.isEmpty()) {
+      global_widget_map_[path] = QPointer<QWidget>(child);
+
+      // 如果这个页面是带着旧的未修复错误加载进来的，自动补红框
+      if (current_errors.contains(path)) {
+        child->setStyleSheet(
+            "border: 2px solid red; background-color: #ffe6e6;");
+      } else if (pending_changes_.count(path.toStdString())) {
+        child->setStyleSheet("font-weight: bold; color: #b35900;");
       }
     }
+  }
 
-    // 录入 LRU 缓存池
-    page_cache_[group_key] = new_page;
-    lru_queue_.push_back(group_key);
-    lru_mapping_[group_key] = std::prev(lru_queue_.end());
+  // 虚拟化页面没有带 config_path 的控件，改为登记模型，并把旧错误标到对应行上
+  if (ConfigPageModel* model = new_page->findChild<ConfigPageModel*>()) {
+    virtual_models_[group_key] = model;
+    for (const QString& err_path : current_errors) {
+      model->SetRowState(err_path, ConfigPageModel::RowState::kError);
+    }
+  }
 
-    stacked_pages_->addWidget(new_page);
-    stacked_pages_->setCurrentWidget(new_page);
-    EvictOldestPageIfNeeded();
-    dependency_graph_->EvaluateAll(); // 结算该新页面的依赖规则
+  // 监视参数登记到拉取器：整页模式以参数控件为锚点，虚拟化页面以整页为锚点
+  auto config_srv = z3y::GetDefaultService<z3y::interfaces::core::IConfigService>();
+  for (const PagePlanItem& item : plan.items) {
+    if (!item.snap.meta.is_monitor || !config_srv) continue;
+    auto cell = config_srv->GetMonitorCell(item.path);
+    if (!cell) continue;
+    auto it = global_widget_map_.find(item.qpath);
+    QWidget* anchor = (it != global_widget_map_.end() && !it->second.isNull())
+                          ? it->second.data()
+                          : new_page;
+    monitor_poller_->Register(item.qpath, std::move(cell), anchor);
   }
 
-  // == 场景2：用户其实是点击了树里面的某个特定参数节点 ==
-  if (!target_path.isEmpty() && global_widget_map_.count(target_path)) {
+  // 录入 LRU 缓存池
+  page_cache_[group_key] = new_page;
+  lru_queue_.push_back(group_key);
+  lru_mapping_[group_key] = std::prev(lru_queue_.end());
+  stacked_pages_->addWidget(new_page);
+  return new_page;
+}
+
+void ConfigMainWindow::RevealParameter(const QString& group_key,
+                                       const QString& target_path) {
+  if (target_path.isEmpty() || !page_cache_.count(group_key)) return;
+  QWidget* page = page_cache_[group_key];
+
+  if (global_widget_map_.count(target_path)) {
     QPointer<QWidget> target_w = global_widget_map_[target_path];
     if (!target_w.isNull()) {
       // 1. 自动滚过去
-      QScrollArea* scroll =
-          stacked_pages_->currentWidget()->findChild<QScrollArea*>();
-      if (!scroll && stacked_pages_->currentWidget()->inherits("QScrollArea")) {
-        scroll = qobject_cast<QScrollArea*>(stacked_pages_->currentWidget());
+      QScrollArea* scroll = page->findChild<QScrollArea*>();
+      if (!scroll && page->inherits("QScrollArea")) {
+        scroll = qobject_cast<QScrollArea*>(page);
       }
       if (scroll) {
         scroll->ensureWidgetVisible(target_w.data(), 50, 50);
@@ -374,10 +503,23 @@ void ConfigMainWindow::OnTreeSelectionChanged(QTreeWidgetItem* current,
       target_w->setStyleSheet(
           orig_style +
           " background-color: #ffff99; border: 2px solid #ffcc00;");
-      QTimer::singleShot(1000, target_w.data(), [target_w, orig_style]() {
-        if (target_w) target_w->setStyleSheet(orig_style);
+      // 控件可能已随页面淘汰被回收并绑定到别的参数上，此时不再恢复旧样式
+      QTimer::singleShot(1000, target_w.data(),
+                         [target_w, orig_style, target_path]() {
+        if (target_w &&
+            target_w->property("config_path").toString() == target_path) {
+          target_w->setStyleSheet(orig_style);
+        }
       });
     }
+  } else if (virtual_models_.count(group_key) && virtual_models_[group_key]) {
+    // 虚拟化页面：滚到该行并选中，编辑器在用户真正开始编辑时才会创建
+    QModelIndex idx = virtual_models_[group_key]->IndexOf(target_path);
+    QTableView* view = page->findChild<QTableView*>();
+    if (idx.isValid() && view) {
+      view->scrollTo(idx, QAbstractItemView::PositionAtCenter);
+      view->setCurrentIndex(idx);
+    }
   }
 }
 
@@ -392,19 +534,25 @@ void ConfigMainWindow::EvictOldestPageIfNeeded() {
   auto widgets_to_check = old_page->findChildren<QWidget*>();
   widgets_to_check.append(old_page);
 
-  // 清除全局雷达中对应的指引
+  // 清除全局雷达中对应的指引 (编辑器控件会被回收复用，监视登记必须显式注销)
   for (auto* child : widgets_to_check) {
     QString path = child->property("config_path").toString();
-    if (!path.isEmpty()) global_widget_map_.erase(path);
+    if (path.isEmpty()) continue;
+    global_widget_map_.erase(path);
+    monitor_poller_->Unregister(path);
   }
 
+  virtual_models_.erase(evict_key);
   stacked_pages_->removeWidget(old_page);
   page_cache_.erase(evict_key);
+  // 编辑器控件先拆下来放回回收池，下次打开任意页面时复用，其余部分随页面销毁
+  widget_pool_.Harvest(old_page, dependency_graph_.get());
   old_page->deleteLater(); // 彻底从堆上物理超度释放内存
 }
 
 void ConfigMainWindow::OnBatchedConfigChanged(
     const z3y::plugins::qt_ui::ConfigUpdateMap& updates) {
+  bool any_param_changed = false;
   for (const auto& [path, val] : updates) {
     auto it = global_widget_map_.find(path);
     if (it != global_widget_map_.end() && !it->second.isNull()) {
@@ -419,6 +567,7 @@ void ConfigMainWindow::OnBatchedConfigChanged(
         widget->setToolTip(
             tr("⚠️ Warning: Data changed by background system! Apply to overwrite or reload this page."));
         if (dependency_graph_) dependency_graph_->OnParameterChanged(safe_path);
+        any_param_changed = true;
         continue;
       }
 
@@ -558,100 +707,54 @@ void ConfigMainWindow::OnBatchedConfigChanged(
       if (actually_changed && dependency_graph_) {
         dependency_graph_->OnParameterChanged(safe_path);
       }
+      any_param_changed |= actually_changed;
+    } else if (ConfigPageModel* model = FindVirtualModel(path)) {
+      // 虚拟化页面：只改模型里的这一行，视口外的行不会触发任何绘制
+      std::string safe_path = path.toStdString();
+      model->SetCommittedValue(path, val);
+      if (pending_changes_.count(safe_path)) {
+        model->SetRowState(
+            path, ConfigPageModel::RowState::kConflict,
+            tr("⚠️ Warning: Data changed by background system! Apply to overwrite or reload this page."));
+      } else {
+        QStringList errs = this->property("backend_errors").toStringList();
+        if (errs.removeAll(path) > 0) {
+          this->setProperty("backend_errors", errs);
+        }
+        model->SetRowState(path, ConfigPageModel::RowState::kNone);
+      }
+      if (dependency_graph_) dependency_graph_->OnParameterChanged(safe_path);
+      any_param_changed = true;
+    } else if (!page_loads_.empty()) {
+      // 有页面正在后台准备：它的快照可能早于这条变更，先暂存，页面装配后重放
+      load_backlog_[path] = val;
     }
   }
+  // 虚拟化页面的联动使能只在整批结束后失效一次缓存，不按更新条数重复刷新
+  if (any_param_changed) RefreshVirtualConditions();
 }
 
 void ConfigMainWindow::OnGlobalSearchTextChanged(const QString& text) {
-  if (text.trimmed().isEmpty()) {
-    RefreshTreeVisibility(is_advanced_mode_);
-    QTreeWidgetItemIterator it_reset(nav_tree_);
-    while (*it_reset) {
-      (*it_reset)->setExpanded(false);
-      ++it_reset;
-    }
-    return;
-  }
-
-  QTreeWidgetItemIterator it_hide(nav_tree_);
-  while (*it_hide) {
-    (*it_hide)->setHidden(true);
-    (*it_hide)->setExpanded(false);
-    ++it_hide;
-  }
-
-  QTreeWidgetItemIterator it_match(nav_tree_);
-  while (*it_match) {
-    // 过滤掉不应该显示的高级节点
-    if (!is_advanced_mode_ && (*it_match)->data(0, Qt::UserRole + 1).toString() == "ITEM" && (*it_match)->data(0, Qt::UserRole + 3).toBool()) {
-      ++it_match;
-      continue;
-    }
+  Q_UNUSED(text);
+  search_timer_->start();
+}
 
-    QString display_name = (*it_match)->text(0);
-    QString raw_key = (*it_match)->data(0, Qt::UserRole).toString();
-
-    if (display_name.contains(text, Qt::CaseInsensitive) ||
-        raw_key.contains(text, Qt::CaseInsensitive)) {
-      QTreeWidgetItem* node = *it_match;
-      // 命中节点之后，把它到根部所有的长辈节点全显出来，并且展开树枝
-      while (node) {
-        node->setHidden(false);
-        node->setExpanded(true);
-        node = node->parent();
-      }
+void ConfigMainWindow::ApplyGlobalSearch() {
+  search_timer_->stop();
+  const QString text = search_box_->text();
+  // 第一次搜索时才拉取全部参数名 (只进索引，命中后才创建树节点)
+  if (!text.trimmed().isEmpty()) search_index_.LoadCatalog();
+  std::vector<uint8_t> state = search_index_.Evaluate(text, is_advanced_mode_);
 
-      // 并且把这个命中节点下面的小分支也全展露出来
-      QList<QTreeWidgetItem*> children_queue;
-      for (int i = 0; i < (*it_match)->childCount(); ++i) {
-        children_queue.append((*it_match)->child(i));
-      }
-      while (!children_queue.isEmpty()) {
-        QTreeWidgetItem* child = children_queue.takeFirst();
-        
-        // 过滤高级选项
-        bool is_advanced_item = child->data(0, Qt::UserRole + 1).toString() == "ITEM" && child->data(0, Qt::UserRole + 3).toBool();
-        if (is_advanced_item && !is_advanced_mode_) continue;
-
-        child->setHidden(false);
-        for (int i = 0; i < child->childCount(); ++i) {
-          children_queue.append(child->child(i));
-        }
-      }
-    }
-    ++it_match;
-  }
-
-  // 搜索后清理空节点：如果命中节点，但其下子节点全因高级过滤而不可见，则隐藏该组
-  QTreeWidgetItemIterator clean_subg(nav_tree_);
-  while (*clean_subg) {
-    if (!(*clean_subg)->isHidden() && (*clean_subg)->data(0, Qt::UserRole + 1).toString() == "SUBGROUP") {
-      bool has_visible_child = false;
-      for (int i = 0; i < (*clean_subg)->childCount(); ++i) {
-        if (!(*clean_subg)->child(i)->isHidden()) {
-          has_visible_child = true;
-          break;
-        }
-      }
-      if (!has_visible_child) (*clean_subg)->setHidden(true);
-    }
-    ++clean_subg;
+  // 清空搜索时与旧行为一致：恢复高级模式下的可见性，并收起所有节点
+  if (text.trimmed().isEmpty()) {
+    for (auto& bits : state) bits &= ~NavigationSearchIndex::kExpanded;
   }
 
-  QTreeWidgetItemIterator clean_g(nav_tree_);
-  while (*clean_g) {
-    if (!(*clean_g)->isHidden() && (*clean_g)->data(0, Qt::UserRole + 1).toString() == "GROUP") {
-      bool has_visible_child = false;
-      for (int i = 0; i < (*clean_g)->childCount(); ++i) {
-        if (!(*clean_g)->child(i)->isHidden()) {
-          has_visible_child = true;
-          break;
-        }
-      }
-      if (!has_visible_child) (*clean_g)->setHidden(true);
-    }
-    ++clean_g;
-  }
+  // 差量应用：只有状态真正变化的节点才会收到 setHidden / setExpanded
+  nav_tree_->setUpdatesEnabled(false);
+  search_index_.Apply(state, true);
+  nav_tree_->setUpdatesEnabled(true);
 }
 
 void ConfigMainWindow::OnAdvancedModeToggled(bool checked) {
@@ -660,8 +763,8 @@ void ConfigMainWindow::OnAdvancedModeToggled(bool checked) {
   if (search_box_->text().trimmed().isEmpty()) {
     RefreshTreeVisibility(is_advanced_mode_);
   } else {
-    // 重新应用带有新过滤规则的搜索
-    OnGlobalSearchTextChanged(search_box_->text());
+    // 重新应用带有新过滤规则的搜索 (立即执行，不走防抖)
+    ApplyGlobalSearch();
   }
   
   QList<QFormLayout*> all_forms = stacked_pages_->findChildren<QFormLayout*>();
@@ -679,6 +782,10 @@ void ConfigMainWindow::OnAdvancedModeToggled(bool checked) {
       }
     }
   }
+  for (auto& [group, model] : virtual_models_) {
+    if (model) model->SetAdvancedMode(checked);
+  }
+
   // 通知页面重新计算长宽高布局以消除空鼓
   if (stacked_pages_->currentWidget() &&
       stacked_pages_->currentWidget()->layout()) {
@@ -708,6 +815,20 @@ void ConfigMainWindow::OnImportClicked() {
   }
 }
 
+void ConfigMainWindow::OnPerformanceMonitorClicked() {
+  if (!perf_dashboard_) {
+    // 作为子窗口挂在主窗口下，随主窗口一起销毁；关闭时直接释放，停止采样
+    perf_dashboard_ = new PerformanceDashboard(this);
+    perf_dashboard_->setWindowFlag(Qt::Window);
+    perf_dashboard_->setAttribute(Qt::WA_DeleteOnClose);
+    perf_dashboard_->setWindowTitle(tr("Performance Monitor"));
+    perf_dashboard_->resize(760, 620);
+  }
+  perf_dashboard_->show();
+  perf_dashboard_->raise();
+  perf_dashboard_->activateWindow();
+}
+
 void ConfigMainWindow::OnExportClicked() {
   QString file_path =
       QFileDialog::getSaveFileName(this, tr("Export Configuration Profile"), "config_backup.json",
@@ -744,6 +865,8 @@ void ConfigMainWindow::DiscardAllPendingChanges() {
       if (it != global_widget_map_.end() && !it->second.isNull()) {
         it->second->setStyleSheet("");
         it->second->setToolTip("");
+      } else if (ConfigPageModel* model = FindVirtualModel(qs_path)) {
+        model->SetRowState(qs_path, ConfigPageModel::RowState::kNone);
       }
     }
   }
@@ -807,6 +930,8 @@ bool ConfigMainWindow::ApplyChanges() {
         !global_widget_map_[qs_path].isNull()) {
       global_widget_map_[qs_path]->setStyleSheet(
           "font-weight: bold; color: #b35900;");
+    } else if (ConfigPageModel* model = FindVirtualModel(qs_path)) {
+      model->SetRowState(qs_path, ConfigPageModel::RowState::kNone);
     }
   }
 
@@ -973,6 +1098,9 @@ bool ConfigMainWindow::ApplyChanges() {
             !global_widget_map_[qpath].isNull()) {
           global_widget_map_[qpath]->setStyleSheet(
               "border: 2px solid red; background-color: #ffe6e6;");
+        } else if (ConfigPageModel* model = FindVirtualModel(qpath)) {
+          model->SetRowState(qpath, ConfigPageModel::RowState::kError,
+                             err_qstr);
         }
 
         // 把左边导航树的那一截染成红十字，让用户就算在别的页面也能注意到
@@ -1046,6 +1174,21 @@ void ConfigMainWindow::RefreshPageValues(const QString& group_key) {
   OnBatchedConfigChanged(batch_updates);
 }
 
+ConfigPageModel* ConfigMainWindow::FindVirtualModel(
+    const QString& path) const {
+  // 最多 kMaxCachedPages 个模型，每个模型内部按路径哈希查找
+  for (const auto& [group, model] : virtual_models_) {
+    if (model && model->Contains(path)) return model.data();
+  }
+  return nullptr;
+}
+
+void ConfigMainWindow::RefreshVirtualConditions() {
+  for (auto& [group, model] : virtual_models_) {
+    if (model) model->RefreshConditions();
+  }
+}
+
 void ConfigMainWindow::closeEvent(QCloseEvent* event) {
   if (!PromptUnsavedChanges()) {
     event->ignore(); // 用户选择了“取消”，或者点击了申请但又改错了，阻止关门
@@ -6,6 +6,10 @@
  * 这是配置系统的门面。它主要包含了一个左侧的导航树 (QTreeWidget) 
  * 和一个右侧的动态堆叠页面 (QStackedWidget)。
  * 为了应对高达几百个配置参数带来的卡顿，采用了懒加载 (Lazy Load) 与 LRU 页面缓存置换机制。
+ * 参数上千的大分组改用虚拟化表格页面 (ConfigPageModel)，只为正在编辑的行创建控件。
+ * 页面数据 (快照、排序、翻译、条件解析) 在后台线程池中准备成 PagePlan，GUI 线程只做控件绑定，
+ * 准备期间显示占位页。
+ * 高频监视参数不走事件桥，由 MonitorPoller 按刷新率拉取当前可见的控件。
  */
 
 #pragma once
@@ -16,6 +20,8 @@
 #include <QSplitter>
 #include <QStackedWidget>
 #include <QString>
+#include <QThreadPool>
+#include <QTimer>
 #include <QTreeWidget>
 #include <QVariant>
 #include <list>
@@ -25,8 +31,13 @@
 #include <unordered_map>
 #include <vector>
 
+#include "config_page_model.h"
 #include "dependency_graph.h"
 #include "event_bridge.h"
+#include "monitor_poller.h"
+#include "navigation_search_index.h"
+#include "page_plan.h"
+#include "widget_recycle_pool.h"
 #include "interfaces_ui/i_config_ui_manager.h"
 
 namespace z3y {
@@ -70,8 +81,10 @@ class ConfigMainWindow : public QMainWindow {
   /** @brief 左侧导航树的节点选中切换时触发，负责页面缓存调度和新建。 */
   void OnTreeSelectionChanged(QTreeWidgetItem* current,
                               QTreeWidgetItem* previous);
-  /** @brief 全局搜索栏文本变化时触发，动态过滤显示符合要求的树节点。 */
+  /** @brief 全局搜索栏文本变化时触发：只重启防抖定时器，停止输入后才真正查询。 */
   void OnGlobalSearchTextChanged(const QString& text);
+  /** @brief 防抖到期后执行查询，并把结果以差量方式应用到导航树。 */
+  void ApplyGlobalSearch();
   /** @brief 接收从后台线程通过 EventBridge 发送过来的批量数据更新包。 */
   void OnBatchedConfigChanged(
       const z3y::plugins::qt_ui::ConfigUpdateMap& updates);
@@ -84,33 +97,56 @@ class ConfigMainWindow : public QMainWindow {
   void OnImportClicked();
   /** @brief 点击“导出配方”按钮，将当前系统的全部内存参数落盘至指定的 JSON 文件。 */
   void OnExportClicked();
+  /** @brief 点击“性能监控”按钮，以独立窗口打开 (或唤起) 内置的实时性能面板。 */
+  void OnPerformanceMonitorClicked();
 
  private:
   /** @brief 创建并排列窗口内的所有的控件容器。 */
   void SetupUI();
   /** @brief 扫描底层的所有配置信息，将所有的一级、二级分组装配进左侧导航树。 */
   void LoadNavigationTree();
-  /** @brief 递归刷新树节点的可见性，支持高级参数的级联隐藏。 */
+  /** @brief 刷新树节点的可见性，支持高级参数的级联隐藏 (经搜索索引差量应用)。 */
   void RefreshTreeVisibility(bool is_advanced_mode);
-  /** @brief LRU 缓存淘汰：如果已创建的页面过多，则销毁最早最久未使用的页面以释放内存。 */
+  /** @brief 在后台线程池准备分组数据，GUI 线程先挂上占位页。 */
+  void StartPageLoad(const QString& group_key, const QString& target_path);
+  /** @brief 后台准备完成 (GUI 线程)：装配页面、替换占位页、重放准备期间的变更。 */
+  void OnPagePlanReady(std::shared_ptr<const PagePlan> plan);
+  /** @brief 按计划实例化控件，登记到全局雷达与 LRU 缓存 (不切换当前页)。 */
+  QWidget* InstallPage(const PagePlan& plan);
+  /** @brief 在已缓存的页面中滚动到目标参数并高亮 (target_path 为空时什么也不做)。 */
+  void RevealParameter(const QString& group_key, const QString& target_path);
+  /** @brief LRU 缓存淘汰：如果已创建的页面过多，则销毁最早最久未使用的页面 (编辑器控件归还回收池)。 */
   void EvictOldestPageIfNeeded();
   /** @brief 询问用户是否要抛弃/保存那些还未 Apply 的悬而不决的更改。 */
   bool PromptUnsavedChanges();
   /** @brief 放弃目前界面上所有修改，将所有带有高亮边框的组件恢复为后台真实数值。 */
   void DiscardAllPendingChanges();
+  /** @brief 在已缓存的虚拟化页面中查找包含该路径的模型，找不到返回 nullptr。 */
+  ConfigPageModel* FindVirtualModel(const QString& path) const;
+  /** @brief 依赖参数变化后，让所有虚拟化页面重新结算联动使能。 */
+  void RefreshVirtualConditions();
 
  private:
   /** @brief 内存中最多同时保留的活跃子页面数量，超过则淘汰。 */
   static constexpr int kMaxCachedPages = 10;
+  /** @brief 搜索框防抖间隔：停止输入这么久之后才执行一次查询。 */
+  static constexpr int kSearchDebounceMs = 150;
+  /** @brief 页面准备超过这么久才露出占位页上的忙碌进度条。 */
+  static constexpr int kLoadingIndicatorDelayMs = 120;
 
   EventBridge* event_bridge_;  /**< @brief 通信桥指针，由 Service 提供。 */
   std::string current_role_;   /**< @brief 当前角色的字符串标识。 */
   bool is_advanced_mode_ = false; /**< @brief 当前是否已经勾选了高级模式。 */
   QString current_group_;      /**< @brief 记录当前所处的组节点名称。 */
+  QPointer<QWidget> perf_dashboard_; /**< @brief 懒创建的性能面板独立窗口。 */
 
   QCheckBox* cb_advanced_;     /**< @brief 顶部栏的高级勾选框。 */
   QLineEdit* search_box_;      /**< @brief 左上角的搜索框。 */
   QTreeWidget* nav_tree_;      /**< @brief 左侧树状目录。 */
+  QTimer* search_timer_;       /**< @brief 搜索防抖定时器。 */
+  MonitorPoller* monitor_poller_; /**< @brief 监视参数拉取器，登记已装配页面上的监视参数。 */
+  /** @brief 导航树的三元组搜索索引，随 LoadNavigationTree 重建。 */
+  NavigationSearchIndex search_index_;
   QStackedWidget* stacked_pages_; /**< @brief 右侧多页面堆栈。 */
 
   /** @brief 用于在不同的参数之间建立并运算复杂的使能/禁用依赖关系的图谱。 */
@@ -120,13 +156,33 @@ class ConfigMainWindow : public QMainWindow {
   std::list<QString> lru_queue_;
   std::unordered_map<QString, std::list<QString>::iterator> lru_mapping_;
   std::unordered_map<QString, QWidget*> page_cache_;
+  /** @brief 淘汰页面时回收编辑器控件，重建页面时复用 (见 widget_recycle_pool.h)。 */
+  WidgetRecyclePool widget_pool_;
 
   /** 
    * @brief 全局控件快速索引字典。
    * @details 键是配置参数的全路径(如 "Camera.Exposure")，值是创建出来的对应 UI 控件弱指针。 
    */
   std::unordered_map<QString, QPointer<QWidget>> global_widget_map_;
+
+  /**
+   * @brief 已缓存的虚拟化页面模型 (键为分组名，随 LRU 淘汰一起移除)。
+   * @details 虚拟化页面没有常驻控件，不进 global_widget_map_，高亮与刷新经由模型完成。
+   */
+  std::unordered_map<QString, QPointer<ConfigPageModel>> virtual_models_;
   
+  /** @brief 一个正在后台准备中的页面。 */
+  struct PageLoad {
+    QPointer<QWidget> placeholder;  ///< 准备期间显示的占位页
+    QString target_path;            ///< 就绪后要跳转到的参数 (最近一次点击)
+  };
+  /** @brief 在途的页面准备任务 (键为分组名)。 */
+  std::unordered_map<QString, PageLoad> page_loads_;
+  /** @brief 页面准备期间收到、尚无控件承接的后台变更，页面装配后重放。 */
+  ConfigUpdateMap load_backlog_;
+  /** @brief 页面数据准备专用线程池 (析构时等待在途任务结束)。 */
+  QThreadPool page_loader_pool_;
+
   /** @brief 所有用户在界面上修改了、但是还没有点击 Apply 发往后台的数据缓存池。 */
   std::map<std::string, QVariant> pending_changes_;
 
@@ -0,0 +1,516 @@
+﻿/**
+ * @file config_page_model.cpp
+ * @brief 虚拟化参数页面模型与编辑代理的实现。
+ */
+
+#include "config_page_model.h"
+
+#include <QAction>
+#include <QBrush>
+#include <QColor>
+#include <QComboBox>
+#include <QCoreApplication>
+#include <QDoubleSpinBox>
+#include <QFileDialog>
+#include <QFont>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLineEdit>
+#include <QPersistentModelIndex>
+#include <QPointer>
+#include <QRegularExpression>
+#include <QRegularExpressionValidator>
+#include <QSlider>
+#include <QStringList>
+#include <QStyle>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <variant>
+
+#include "qt_utils.h"
+#include "scroll_guard.h"
+
+namespace z3y {
+namespace plugins {
+namespace qt_ui {
+
+namespace {
+
+using z3y::interfaces::core::ConfigSnapshot;
+using z3y::interfaces::core::WidgetType;
+
+bool IsArrayValue(const z3y::interfaces::core::ConfigValue& v) {
+  return std::holds_alternative<std::vector<int64_t>>(v) ||
+         std::holds_alternative<std::vector<double>>(v) ||
+         std::holds_alternative<std::vector<std::string>>(v);
+}
+
+QJsonObject ParseCustomArgs(const ConfigSnapshot& snap) {
+  if (snap.meta.custom_args.empty()) return QJsonObject();
+  QJsonParseError err;
+  QJsonDocument doc = QJsonDocument::fromJson(
+      QString::fromStdString(snap.meta.custom_args).toUtf8(), &err);
+  return err.error == QJsonParseError::NoError ? doc.object() : QJsonObject();
+}
+
+/** @brief 数组按 ", " 拼接显示，单元格编辑时也用这种文本形式。 */
+QString JoinList(const QVariantList& list) {
+  QStringList parts;
+  parts.reserve(list.size());
+  for (const auto& v : list) parts << v.toString();
+  return parts.join(", ");
+}
+
+/** @brief 判断两个显示值是否相同 (数组逐项按文本比较，与整页模式的表格一致)。 */
+bool SameValue(const QVariant& a, const QVariant& b) {
+  if (a.userType() == QMetaType::QVariantList ||
+      b.userType() == QMetaType::QVariantList) {
+    return JoinList(a.toList()) == JoinList(b.toList());
+  }
+  if (a.userType() == QMetaType::Double || b.userType() == QMetaType::Double) {
+    return a.toDouble() == b.toDouble();
+  }
+  return a == b || a.toString() == b.toString();
+}
+
+/** @brief 下拉枚举：把真实值反查为显示文本，查不到时显示真实值本身。 */
+QString ComboDisplayText(const ConfigSnapshot& snap, const QVariant& val) {
+  const auto& values = snap.meta.enum_values;
+  const auto& names = snap.meta.enum_display_keys;
+  const QString target = val.toString();
+  for (size_t i = 0; i < names.size(); ++i) {
+    QString real = i < values.size() ? QString::fromStdString(values[i])
+                                     : QString::number(i);
+    if (real == target) return QString::fromStdString(names[i]);
+  }
+  return target;
+}
+
+}  // namespace
+
+// ==================== ConfigPageModel ====================
+
+ConfigPageModel::ConfigPageModel(
+    const PagePlan& plan,
+    const std::map<std::string, QVariant>* pending_changes,
+    const DependencyGraph* graph, ChangeCallback on_change_callback,
+    bool is_advanced_mode, QObject* parent)
+    : QAbstractTableModel(parent),
+      is_advanced_mode_(is_advanced_mode),
+      pending_changes_(pending_changes),
+      graph_(graph),
+      on_change_callback_(std::move(on_change_callback)) {
+  // 计划已剔除隐藏参数并按 "子分组 -> 路径" 排好序，与整页模式的 GroupBox 顺序一致
+  rows_.reserve(plan.items.size());
+  row_of_path_.reserve(plan.items.size());
+  for (const PagePlanItem& item : plan.items) {
+    Row row;
+    row.path = item.qpath;
+    row.subgroup = item.subgroup;
+    row.snap = item.snap;
+    row.committed = item.value;
+    row_of_path_[row.path] = static_cast<int>(rows_.size());
+    rows_.push_back(std::move(row));
+  }
+  has_conditions_ = plan.has_conditions;
+  RebuildVisibleRows();
+}
+
+void ConfigPageModel::RebuildVisibleRows() {
+  visible_rows_.clear();
+  visible_pos_.assign(rows_.size(), -1);
+  for (int i = 0; i < static_cast<int>(rows_.size()); ++i) {
+    if (rows_[i].snap.meta.is_advanced && !is_advanced_mode_) continue;
+    visible_pos_[i] = static_cast<int>(visible_rows_.size());
+    visible_rows_.push_back(i);
+  }
+}
+
+int ConfigPageModel::rowCount(const QModelIndex& parent) const {
+  return parent.isValid() ? 0 : static_cast<int>(visible_rows_.size());
+}
+
+int ConfigPageModel::columnCount(const QModelIndex& parent) const {
+  return parent.isValid() ? 0 : kColumnCount;
+}
+
+const ConfigSnapshot* ConfigPageModel::SnapshotAt(int row) const {
+  if (row < 0 || row >= static_cast<int>(visible_rows_.size())) return nullptr;
+  return &rows_[visible_rows_[row]].snap;
+}
+
+bool ConfigPageModel::Contains(const QString& path) const {
+  return row_of_path_.count(path) > 0;
+}
+
+QModelIndex ConfigPageModel::IndexOf(const QString& path) const {
+  auto it = row_of_path_.find(path);
+  if (it == row_of_path_.end() || visible_pos_[it->second] < 0) {
+    return QModelIndex();
+  }
+  return index(visible_pos_[it->second], kColumnValue);
+}
+
+bool ConfigPageModel::HasPending(const Row& row) const {
+  return pending_changes_ &&
+         pending_changes_->count(row.path.toStdString()) > 0;
+}
+
+QVariant ConfigPageModel::EffectiveValue(const Row& row) const {
+  if (pending_changes_) {
+    auto it = pending_changes_->find(row.path.toStdString());
+    if (it != pending_changes_->end()) return it->second;
+  }
+  return row.committed;
+}
+
+bool ConfigPageModel::IsRowEnabled(const Row& row) const {
+  if (row.snap.meta.enable_condition.empty() || !graph_) return true;
+  if (row.enabled_gen != condition_gen_) {
+    row.enabled = graph_->EvaluateCondition(
+        QString::fromStdString(row.snap.meta.enable_condition));
+    row.enabled_gen = condition_gen_;
+  }
+  return row.enabled;
+}
+
+QVariant ConfigPageModel::data(const QModelIndex& index, int role) const {
+  if (!index.isValid() || index.row() >= rowCount()) return QVariant();
+  const Row& row = rows_[visible_rows_[index.row()]];
+  const auto& meta = row.snap.meta;
+
+  switch (role) {
+    case kPathRole:
+      return row.path;
+    case Qt::ToolTipRole:
+      return row.state_tooltip.isEmpty()
+                 ? QString::fromStdString(meta.tooltip_key)
+                 : row.state_tooltip;
+    case Qt::ForegroundRole:
+      if (row.state == RowState::kError) return QBrush(QColor(Qt::red));
+      if (HasPending(row)) return QBrush(QColor("#b35900"));
+      return QVariant();
+    case Qt::BackgroundRole:
+      if (row.state == RowState::kError) return QBrush(QColor("#ffe6e6"));
+      if (row.state == RowState::kConflict) return QBrush(QColor("#ffe0b3"));
+      return QVariant();
+    case Qt::FontRole:
+      if (HasPending(row)) {
+        QFont font;
+        font.setBold(true);
+        return font;
+      }
+      return QVariant();
+    default:
+      break;
+  }
+
+  if (index.column() == kColumnSubgroup) {
+    return role == Qt::DisplayRole ? QVariant(row.subgroup) : QVariant();
+  }
+  if (index.column() == kColumnName) {
+    return role == Qt::DisplayRole
+               ? QVariant(QString::fromStdString(meta.name_key))
+               : QVariant();
+  }
+
+  const QVariant val = EffectiveValue(row);
+  const bool is_bool =
+      std::holds_alternative<bool>(row.snap.current_value);
+  if (role == Qt::EditRole) return val;
+  if (role == Qt::CheckStateRole && is_bool) {
+    return val.toBool() ? Qt::Checked : Qt::Unchecked;
+  }
+  if (role != Qt::DisplayRole || is_bool) return QVariant();
+
+  // 数值列的显示文本：只在该行被绘制时才计算
+  if (meta.widget_type == WidgetType::kPasswordInput) {
+    return QString(val.toString().size(), QChar(0x2022));
+  }
+  if (meta.widget_type == WidgetType::kComboBox) {
+    return ComboDisplayText(row.snap, val);
+  }
+  if (val.userType() == QMetaType::QVariantList) return JoinList(val.toList());
+  if (val.userType() == QMetaType::Double) {
+    return QString::number(val.toDouble(), 'g', 16);
+  }
+  return val.toString();
+}
+
+bool ConfigPageModel::setData(const QModelIndex& index, const QVariant& value,
+                              int role) {
+  if (!index.isValid() || index.column() != kColumnValue ||
+      index.row() >= rowCount()) {
+    return false;
+  }
+  Row& row = rows_[visible_rows_[index.row()]];
+
+  QVariant new_val = value;
+  if (role == Qt::CheckStateRole) {
+    new_val = QVariant(value.toInt() == Qt::Checked);
+  } else if (role != Qt::EditRole) {
+    return false;
+  }
+  if (!new_val.isValid() || SameValue(new_val, EffectiveValue(row))) {
+    return false;
+  }
+
+  // 用户一改动就消除错误 / 冲突高亮，与整页模式的红框行为一致
+  row.state = RowState::kNone;
+  row.state_tooltip.clear();
+  if (on_change_callback_) on_change_callback_(row.path, new_val);
+  EmitRowChanged(index.row());
+  return true;
+}
+
+Qt::ItemFlags ConfigPageModel::flags(const QModelIndex& index) const {
+  if (!index.isValid() || index.row() >= rowCount()) return Qt::NoItemFlags;
+  const Row& row = rows_[visible_rows_[index.row()]];
+
+  Qt::ItemFlags f = Qt::ItemIsSelectable;
+  if (!IsRowEnabled(row)) return f;
+  f |= Qt::ItemIsEnabled;
+  if (index.column() != kColumnValue) return f;
+
+  if (row.snap.meta.widget_type == WidgetType::kProgressBar) return f;
+  if (std::holds_alternative<bool>(row.snap.current_value)) {
+    return f | Qt::ItemIsUserCheckable;
+  }
+  return f | Qt::ItemIsEditable;
+}
+
+QVariant ConfigPageModel::headerData(int section, Qt::Orientation orientation,
+                                     int role) const {
+  if (orientation != Qt::Horizontal || role != Qt::DisplayRole) {
+    return QVariant();
+  }
+  switch (section) {
+    case kColumnSubgroup:
+      return tr("Subgroup");
+    case kColumnName:
+      return tr("Parameter");
+    case kColumnValue:
+      return tr("Value");
+    default:
+      return QVariant();
+  }
+}
+
+void ConfigPageModel::EmitRowChanged(int row) {
+  emit dataChanged(index(row, 0), index(row, kColumnCount - 1));
+}
+
+void ConfigPageModel::SetCommittedValue(const QString& path,
+                                        const QVariant& value) {
+  auto it = row_of_path_.find(path);
+  if (it == row_of_path_.end()) return;
+  Row& row = rows_[it->second];
+  if (SameValue(row.committed, value)) return;
+
+  row.committed = value;
+  if (HasPending(row)) return;  // 悬挂值仍然优先显示
+  if (visible_pos_[it->second] >= 0) EmitRowChanged(visible_pos_[it->second]);
+}
+
+void ConfigPageModel::SetRowState(const QString& path, RowState state,
+                                  const QString& tooltip) {
+  auto it = row_of_path_.find(path);
+  if (it == row_of_path_.end()) return;
+  Row& row = rows_[it->second];
+  row.state = state;
+  row.state_tooltip = tooltip;
+  if (visible_pos_[it->second] >= 0) EmitRowChanged(visible_pos_[it->second]);
+}
+
+void ConfigPageModel::RefreshRow(const QString& path) {
+  auto it = row_of_path_.find(path);
+  if (it != row_of_path_.end() && visible_pos_[it->second] >= 0) {
+    EmitRowChanged(visible_pos_[it->second]);
+  }
+}
+
+void ConfigPageModel::RefreshConditions() {
+  if (!has_conditions_ || visible_rows_.empty()) return;
+  // 只让缓存失效：视图重绘时才对可见行重新求值，不在这里遍历全部行
+  ++condition_gen_;
+  emit dataChanged(index(0, 0), index(rowCount() - 1, kColumnCount - 1));
+}
+
+void ConfigPageModel::SetAdvancedMode(bool is_advanced_mode) {
+  if (is_advanced_mode_ == is_advanced_mode) return;
+  beginResetModel();
+  is_advanced_mode_ = is_advanced_mode;
+  RebuildVisibleRows();
+  endResetModel();
+}
+
+void ConfigPageModel::ResetRowsToDefault(const std::vector<int>& rows) {
+  for (int r : rows) {
+    const ConfigSnapshot* snap = SnapshotAt(r);
+    if (!snap || !(flags(index(r, kColumnValue)) & Qt::ItemIsEnabled)) {
+      continue;
+    }
+    setData(index(r, kColumnValue), ConvertToQVariant(snap->default_value),
+            Qt::EditRole);
+  }
+}
+
+// ==================== ConfigValueDelegate ====================
+
+ConfigValueDelegate::ConfigValueDelegate(QObject* parent)
+    : QStyledItemDelegate(parent) {}
+
+QWidget* ConfigValueDelegate::createEditor(QWidget* parent,
+                                           const QStyleOptionViewItem& option,
+                                           const QModelIndex& index) const {
+  const auto* model = qobject_cast<const ConfigPageModel*>(index.model());
+  const ConfigSnapshot* snap = model ? model->SnapshotAt(index.row()) : nullptr;
+  if (!snap) return QStyledItemDelegate::createEditor(parent, option, index);
+
+  const auto& meta = snap->meta;
+  const QJsonObject custom_args = ParseCustomArgs(*snap);
+  QWidget* editor = nullptr;
+
+  if (meta.widget_type == WidgetType::kComboBox) {
+    QComboBox* combo = new QComboBox(parent);
+    for (size_t i = 0; i < meta.enum_display_keys.size(); ++i) {
+      QVariant real_data =
+          (i < meta.enum_values.size())
+              ? QVariant(QString::fromStdString(meta.enum_values[i]))
+              : QVariant(static_cast<qlonglong>(i));
+      combo->addItem(QString::fromStdString(meta.enum_display_keys[i]),
+                     real_data);
+    }
+    editor = combo;
+  } else if (meta.widget_type == WidgetType::kSlider &&
+             std::holds_alternative<int64_t>(snap->current_value)) {
+    QSlider* slider = new QSlider(Qt::Horizontal, parent);
+    slider->setMinimum(static_cast<int>(std::clamp<int64_t>(
+        ExtractInt64(meta.min_val, std::numeric_limits<int>::min()),
+        std::numeric_limits<int>::min(), std::numeric_limits<int>::max())));
+    slider->setMaximum(static_cast<int>(std::clamp<int64_t>(
+        ExtractInt64(meta.max_val, std::numeric_limits<int>::max()),
+        std::numeric_limits<int>::min(), std::numeric_limits<int>::max())));
+    slider->setSingleStep(ExtractJsonInt(custom_args, "step", 1));
+    editor = slider;
+  } else if (std::holds_alternative<double>(snap->current_value) ||
+             (std::holds_alternative<int64_t>(snap->current_value) &&
+              std::abs(index.data(Qt::EditRole).toDouble()) <=
+                  9007199254740991.0)) {
+    // 与整页模式一致：整数用 0 位小数的 QDoubleSpinBox 伪装，超出 2^53 时改用文本框
+    const bool is_int = std::holds_alternative<int64_t>(snap->current_value);
+    QDoubleSpinBox* dspin = new QDoubleSpinBox(parent);
+    dspin->setDecimals(is_int ? 0 : ExtractJsonInt(custom_args, "decimals", 6));
+    dspin->setMinimum(ExtractDouble(meta.min_val, -9e15));
+    dspin->setMaximum(ExtractDouble(meta.max_val, 9e15));
+    dspin->setSingleStep(ExtractJsonDouble(custom_args, "step", 1.0));
+    editor = dspin;
+  } else {
+    QLineEdit* line_edit = new QLineEdit(parent);
+    if (meta.widget_type == WidgetType::kPasswordInput) {
+      line_edit->setEchoMode(QLineEdit::Password);
+    } else if (std::holds_alternative<int64_t>(snap->current_value)) {
+      line_edit->setValidator(new QRegularExpressionValidator(
+          QRegularExpression("^-?\\d{1,19}$"), line_edit));
+    } else if (IsArrayValue(snap->current_value)) {
+      line_edit->setToolTip(tr("Comma separated list"));
+    } else if (meta.widget_type == WidgetType::kFilePicker ||
+               meta.widget_type == WidgetType::kDirPicker) {
+      // 文件对话框是模态的，编辑器会因失焦先被关闭，所以选中结果直接写回模型
+      QString filter = custom_args.contains("filter")
+                           ? custom_args["filter"].toString()
+                           : "All Files (*.*)";
+      bool is_dir = (meta.widget_type == WidgetType::kDirPicker);
+      QAction* browse = line_edit->addAction(
+          line_edit->style()->standardIcon(QStyle::SP_DirOpenIcon),
+          QLineEdit::TrailingPosition);
+      browse->setToolTip("...");
+      QPersistentModelIndex target(index);
+      QPointer<QAbstractItemModel> target_model(
+          const_cast<QAbstractItemModel*>(index.model()));
+      QString start = index.data(Qt::EditRole).toString();
+      connect(browse, &QAction::triggered, this,
+              [target, target_model, filter, is_dir, start]() {
+                QString selected =
+                    is_dir ? QFileDialog::getExistingDirectory(
+                                 nullptr, "Select Directory", start)
+                           : QFileDialog::getOpenFileName(
+                                 nullptr, "Select File", start, filter);
+                if (!selected.isEmpty() && target_model && target.isValid()) {
+                  target_model->setData(target, selected, Qt::EditRole);
+                }
+              });
+    }
+    editor = line_edit;
+  }
+
+  editor->setFocusPolicy(Qt::StrongFocus);
+  editor->installEventFilter(new ScrollGuardFilter(editor));
+  return editor;
+}
+
+void ConfigValueDelegate::setEditorData(QWidget* editor,
+                                        const QModelIndex& index) const {
+  const QVariant val = index.data(Qt::EditRole);
+  if (auto* combo = qobject_cast<QComboBox*>(editor)) {
+    int idx = FindComboIndexSafe(combo, val);
+    if (idx == -1 && (val.userType() == QMetaType::Int ||
+                      val.userType() == QMetaType::LongLong)) {
+      idx = val.toInt() < combo->count() ? val.toInt() : -1;
+    }
+    if (idx != -1) combo->setCurrentIndex(idx);
+  } else if (auto* slider = qobject_cast<QSlider*>(editor)) {
+    slider->setValue(static_cast<int>(std::clamp<qint64>(
+        val.toLongLong(), std::numeric_limits<int>::min(),
+        std::numeric_limits<int>::max())));
+  } else if (auto* dspin = qobject_cast<QDoubleSpinBox*>(editor)) {
+    dspin->setValue(val.toDouble());
+  } else if (auto* line = qobject_cast<QLineEdit*>(editor)) {
+    line->setText(val.userType() == QMetaType::QVariantList
+                      ? JoinList(val.toList())
+                      : val.toString());
+  }
+}
+
+void ConfigValueDelegate::setModelData(QWidget* editor,
+                                       QAbstractItemModel* model,
+                                       const QModelIndex& index) const {
+  const auto* page_model = qobject_cast<const ConfigPageModel*>(model);
+  const ConfigSnapshot* snap =
+      page_model ? page_model->SnapshotAt(index.row()) : nullptr;
+  if (!snap) return;
+
+  // 转回与整页模式相同的 QVariant 类型，ApplyChanges 据此推导 C++ 强类型
+  const bool is_int = std::holds_alternative<int64_t>(snap->current_value);
+  QVariant val;
+  if (auto* combo = qobject_cast<QComboBox*>(editor)) {
+    val = combo->itemData(combo->currentIndex());
+  } else if (auto* slider = qobject_cast<QSlider*>(editor)) {
+    val = QVariant(static_cast<qint64>(slider->value()));
+  } else if (auto* dspin = qobject_cast<QDoubleSpinBox*>(editor)) {
+    val = is_int ? QVariant(static_cast<qint64>(std::llround(dspin->value())))
+                 : QVariant(dspin->value());
+  } else if (auto* line = qobject_cast<QLineEdit*>(editor)) {
+    const QString text = line->text();
+    if (is_int) {
+      bool ok = false;
+      qlonglong v = text.toLongLong(&ok);
+      if (!ok) return;
+      val = QVariant(v);
+    } else if (IsArrayValue(snap->current_value)) {
+      QVariantList list;
+      if (!text.trimmed().isEmpty()) {
+        for (const QString& part : text.split(',')) list.append(part.trimmed());
+      }
+      val = list;
+    } else {
+      val = text;
+    }
+  }
+  model->setData(index, val, Qt::EditRole);
+}
+
+}  // namespace qt_ui
+}  // namespace plugins
+}  // namespace z3y
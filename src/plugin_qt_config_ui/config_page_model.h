@@ -0,0 +1,149 @@
+﻿/**
+ * @file config_page_model.h
+ * @brief 虚拟化参数页面：基于 Model/View 的配置快照表格模型与按需编辑代理。
+ *
+ * @details
+ * WidgetFactory::CreatePage 为每个参数常驻一个 QWidget，几千个参数的大分组打开要数秒、
+ * 占用上百 MB。虚拟化页面改为一张 QTableView：
+ * - ConfigPageModel 只持有该分组的快照数据 (一行一个参数)，不创建任何控件；
+ * - ConfigValueDelegate 只在用户开始编辑某一行时创建编辑器，编辑结束即销毁；
+ * - QTableView 只绘制视口内的行，行高固定，打开页面的耗时只与视口大小相关。
+ * 悬挂修改、冲突与错误高亮、联动使能、高级过滤全部通过模型的数据角色表达。
+ */
+
+#pragma once
+#include <QAbstractTableModel>
+#include <QString>
+#include <QStyledItemDelegate>
+#include <QVariant>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "dependency_graph.h"
+#include "page_plan.h"
+#include "interfaces_core/i_config_service.h"
+
+namespace z3y {
+namespace plugins {
+namespace qt_ui {
+
+/**
+ * @class ConfigPageModel
+ * @brief 一个配置分组的扁平表格模型：子分组 / 名称 / 数值 三列。
+ */
+class ConfigPageModel : public QAbstractTableModel {
+  Q_OBJECT
+ public:
+  /** @brief 表格列定义。 */
+  enum Column { kColumnSubgroup = 0, kColumnName, kColumnValue, kColumnCount };
+
+  /** @brief 自定义数据角色：取该行绑定的配置全路径。 */
+  static constexpr int kPathRole = Qt::UserRole + 1;
+
+  /** @brief 行的高亮状态 (对应整页模式下控件的样式表)。 */
+  enum class RowState { kNone, kConflict, kError };
+
+  using ChangeCallback = std::function<void(const QString&, const QVariant&)>;
+
+  /**
+   * @param plan 该分组的构建计划 (已剔除隐藏参数并排好序，行顺序与之一致)。
+   * @param pending_changes 主窗口的悬挂修改池，模型只读引用，优先于后台值显示。
+   * @param graph 依赖图谱，用于按行结算 enable_condition。
+   * @param on_change_callback 用户改动某行后向主窗口汇报。
+   * @param is_advanced_mode 初始是否显示高级参数。
+   */
+  ConfigPageModel(
+      const PagePlan& plan, const std::map<std::string, QVariant>* pending_changes,
+      const DependencyGraph* graph, ChangeCallback on_change_callback,
+      bool is_advanced_mode, QObject* parent = nullptr);
+
+  int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+  int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+  QVariant data(const QModelIndex& index, int role) const override;
+  bool setData(const QModelIndex& index, const QVariant& value,
+               int role) override;
+  Qt::ItemFlags flags(const QModelIndex& index) const override;
+  QVariant headerData(int section, Qt::Orientation orientation,
+                      int role) const override;
+
+  /** @brief 取可见行对应的快照 (元数据 + 默认值)，越界返回 nullptr。 */
+  const z3y::interfaces::core::ConfigSnapshot* SnapshotAt(int row) const;
+  /** @brief 模型是否包含该路径 (无论当前是否被高级过滤隐藏)。 */
+  bool Contains(const QString& path) const;
+  /** @brief 路径对应的数值列索引；不存在或被过滤时返回无效索引。 */
+  QModelIndex IndexOf(const QString& path) const;
+
+  /**
+   * @brief 后台值更新 (OnBatchedConfigChanged 调用)。
+   * @details 该行有悬挂修改时只记录新值、仍显示悬挂值，放弃修改后自然露出后台值。
+   */
+  void SetCommittedValue(const QString& path, const QVariant& value);
+  /** @brief 设置某行的冲突 / 错误高亮。 */
+  void SetRowState(const QString& path, RowState state,
+                   const QString& tooltip = QString());
+  /** @brief 悬挂修改池变化后 (Apply / Discard) 重绘该行。 */
+  void RefreshRow(const QString& path);
+  /** @brief 依赖参数变化后重新结算联动使能 (只对正在绘制的行实际求值)。 */
+  void RefreshConditions();
+  /** @brief 切换高级模式：不显示的行直接从模型中过滤掉。 */
+  void SetAdvancedMode(bool is_advanced_mode);
+  /** @brief 将指定可见行写回默认值 (进入悬挂修改池，需 Apply 才落地)。 */
+  void ResetRowsToDefault(const std::vector<int>& rows);
+
+ private:
+  struct Row {
+    QString path;
+    QString subgroup;
+    z3y::interfaces::core::ConfigSnapshot snap;
+    QVariant committed;  ///< 后台当前值
+    RowState state = RowState::kNone;
+    QString state_tooltip;
+    // 联动使能的惰性缓存：enabled_gen != condition_gen_ 时重新求值
+    mutable bool enabled = true;
+    mutable uint64_t enabled_gen = 0;
+  };
+
+  /** @brief 悬挂值优先，否则后台值。 */
+  QVariant EffectiveValue(const Row& row) const;
+  bool HasPending(const Row& row) const;
+  bool IsRowEnabled(const Row& row) const;
+  void RebuildVisibleRows();
+  void EmitRowChanged(int row);
+
+  std::vector<Row> rows_;
+  std::vector<int> visible_rows_;  ///< 可见行号 -> rows_ 下标
+  std::vector<int> visible_pos_;   ///< rows_ 下标 -> 可见行号 (-1 = 被过滤)
+  std::unordered_map<QString, int> row_of_path_;
+  bool has_conditions_ = false;
+  uint64_t condition_gen_ = 1;
+  bool is_advanced_mode_ = false;
+
+  const std::map<std::string, QVariant>* pending_changes_;
+  const DependencyGraph* graph_;
+  ChangeCallback on_change_callback_;
+};
+
+/**
+ * @class ConfigValueDelegate
+ * @brief 数值列的编辑代理：按 Schema 的 widget_type 在编辑开始时才创建编辑器。
+ * @details 布尔参数走 Qt::CheckStateRole 勾选，进度条只读，均不需要编辑器。
+ */
+class ConfigValueDelegate : public QStyledItemDelegate {
+  Q_OBJECT
+ public:
+  explicit ConfigValueDelegate(QObject* parent = nullptr);
+
+  QWidget* createEditor(QWidget* parent, const QStyleOptionViewItem& option,
+                        const QModelIndex& index) const override;
+  void setEditorData(QWidget* editor, const QModelIndex& index) const override;
+  void setModelData(QWidget* editor, QAbstractItemModel* model,
+                    const QModelIndex& index) const override;
+};
+
+}  // namespace qt_ui
+}  // namespace plugins
+}  // namespace z3y
@@ -15,6 +15,7 @@
 
 #include "config_main_window.h"
 #include "event_bridge.h"
+#include "performance_dashboard.h"
 #include "framework/z3y_framework.h"
 
 // 将服务自动注册到框架中，以便其他模块可以通过 GetService 获取
@@ -31,6 +32,15 @@ void ConfigUIManagerService::Initialize() {
   qRegisterMetaType<z3y::plugins::qt_ui::ConfigUpdateMap>(
       "z3y::plugins::qt_ui::ConfigUpdateMap");
 
+  // 内置的实时性能面板：Schema 中 custom_ui_key 填这个键即可嵌入任意分组；
+  // 业务方若已用同名键注册了自己的面板，则尊重业务方的实现
+  if (custom_panels_.find(kPerformanceDashboardPanelKey) ==
+      custom_panels_.end()) {
+    custom_panels_[kPerformanceDashboardPanelKey] = [](void* parent) -> void* {
+      return new PerformanceDashboard(static_cast<QWidget*>(parent));
+    };
+  }
+
   // 初始化翻译系统
   if (qApp) {
     translator_ = std::make_unique<QTranslator>();
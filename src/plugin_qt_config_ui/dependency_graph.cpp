@@ -14,104 +14,195 @@ namespace plugins {
 namespace qt_ui {
 
 void DependencyGraph::SetValueProvider(ValueProvider provider) {
-  // 保存回调，后续 EvaluateExpression 需要通过这个通道溯源真值
+  // 保存回调，后续 Evaluate 需要通过这个通道溯源真值
   value_provider_ = std::move(provider);
 }
 
-void DependencyGraph::AddDependency(const std::string& target_path,
-                                    const std::string& depends_on_path,
-                                    QWidget* widget) {
-  // 建立反向依赖：当 depends_on_path 改变时，必须顺藤摸瓜通知到 target_path 绑定的 widget
-  reverse_deps_[depends_on_path].push_back(QPointer<QWidget>(widget));
-
-  // 预编译表达式：将条件字符串 ("!Camera.AutoExp == true") 一次性拆解提炼并注入给控件自己的 Property。
-  // 这样在海量重算时就不需要重复去进行缓慢的正则匹配。
-  QString cond = widget->property("enable_condition").toString();
-  if (!cond.isEmpty()) {
-    // 捕获组定义：1. 是否取反  2. 所依赖的后台路径  3. 操作符(如>=)  4. 目标阈值
-    static const QRegularExpression re(
-        "^(!?)([\\w\\.]+)(?:\\s*(==|!=|>|<|>=|<=)\\s*(.*))?$");
-    QRegularExpressionMatch match = re.match(cond);
-    if (match.hasMatch()) {
-      widget->setProperty("pred_parsed", true);
-      widget->setProperty("pred_invert", !match.captured(1).isEmpty());
-      widget->setProperty("pred_dep_path", match.captured(2));
-      widget->setProperty("pred_op", match.captured(3));
-
-      // 剥离两端包裹的纯字符串外衣单双引号
-      QString target_val_str = match.captured(4).trimmed();
-      if (target_val_str.startsWith('\'') && target_val_str.endsWith('\'')) {
-        target_val_str = target_val_str.mid(1, target_val_str.length() - 2);
-      } else if (target_val_str.startsWith('"') && target_val_str.endsWith('"')) {
-        target_val_str = target_val_str.mid(1, target_val_str.length() - 2);
-      }
-      widget->setProperty("pred_target_val", target_val_str);
-    }
+int DependencyGraph::InternPath(const std::string& path) const {
+  auto [it, inserted] =
+      path_ids_.emplace(path, static_cast<int>(paths_.size()));
+  if (inserted) paths_.push_back(path);
+  return it->second;
+}
+
+DependencyGraph::ParsedCondition DependencyGraph::Parse(const QString& cond) {
+  ParsedCondition pc;
+  // 捕获组定义：1. 是否取反  2. 所依赖的后台路径  3. 操作符(如>=)  4. 目标阈值
+  static const QRegularExpression re(
+      "^(!?)([\\w\\.]+)(?:\\s*(==|!=|>|<|>=|<=)\\s*(.*))?$");
+  QRegularExpressionMatch match = re.match(cond);
+  if (!match.hasMatch()) return pc;
+
+  pc.parsed = true;
+  pc.invert = !match.captured(1).isEmpty();
+  pc.dep_path = match.captured(2).toStdString();
+
+  const QString op = match.captured(3);
+  if (op == "==") pc.op = Op::kEq;
+  else if (op == "!=") pc.op = Op::kNe;
+  else if (op == ">") pc.op = Op::kGt;
+  else if (op == "<") pc.op = Op::kLt;
+  else if (op == ">=") pc.op = Op::kGe;
+  else if (op == "<=") pc.op = Op::kLe;
+
+  // 剥离两端包裹的纯字符串外衣单双引号
+  QString target_val_str = match.captured(4).trimmed();
+  if (target_val_str.startsWith('\'') && target_val_str.endsWith('\'')) {
+    target_val_str = target_val_str.mid(1, target_val_str.length() - 2);
+  } else if (target_val_str.startsWith('"') && target_val_str.endsWith('"')) {
+    target_val_str = target_val_str.mid(1, target_val_str.length() - 2);
   }
+  pc.target_str = target_val_str;
+  pc.target_num = target_val_str.toDouble(&pc.target_is_num);
+  pc.target_bool =
+      (target_val_str.toLower() == "true" || target_val_str == "1");
+  return pc;
 }
 
-void DependencyGraph::OnParameterChanged(const std::string& changed_path) {
-  // 收到风声说 changed_path 被人修改了。顺着它的名字去图谱里查一下有谁依赖了它
-  if (reverse_deps_.find(changed_path) == reverse_deps_.end()) return;
+DependencyGraph::CompiledPredicate DependencyGraph::Compile(
+    const QString& cond) const {
+  return Compile(Parse(cond));
+}
 
-  auto& targets = reverse_deps_[changed_path];
+DependencyGraph::CompiledPredicate DependencyGraph::Compile(
+    const ParsedCondition& cond) const {
+  CompiledPredicate pred;
+  if (!cond.parsed) return pred;
+  pred.parsed = true;
+  pred.invert = cond.invert;
+  pred.op = cond.op;
+  pred.dep_id = InternPath(cond.dep_path);
+  pred.target_str = cond.target_str;
+  pred.target_is_num = cond.target_is_num;
+  pred.target_num = cond.target_num;
+  pred.target_bool = cond.target_bool;
+  return pred;
+}
 
-  // 消除 O(N^2) 内存碎片：安全的 Erase-Remove 惯用法，踢出那些已经被销毁的 QPointer
-  targets.erase(
-      std::remove_if(targets.begin(), targets.end(),
-                     [](const QPointer<QWidget>& w) { return w.isNull(); }),
-      targets.end());
+bool DependencyGraph::AddDependency(const std::string& target_path,
+                                    const QString& condition,
+                                    QWidget* widget) {
+  return AddDependency(target_path, Parse(condition), widget);
+}
 
-  // 挨个点名，让这些依附的小弟们重新计算一下自己现在的条件还成不成立
-  for (auto& w : targets) {
-    if (w) {
-      bool should_enable = EvaluateExpression(w.data());
-      w->setEnabled(should_enable);
-    }
+bool DependencyGraph::AddDependency(const std::string& target_path,
+                                    const ParsedCondition& condition,
+                                    QWidget* widget) {
+  Q_UNUSED(target_path);
+  if (!widget) return false;
+  CompiledPredicate pred = Compile(condition);
+  if (!pred.parsed) return false;
+
+  // 同一控件重复挂载时覆盖旧记录；控件地址被新控件复用时旧记录早已失效，同样覆盖
+  int slot;
+  auto it = binding_of_widget_.find(widget);
+  if (it != binding_of_widget_.end() &&
+      bindings_[it->second].widget.data() == widget) {
+    slot = it->second;
+  } else if (!free_bindings_.empty()) {
+    slot = free_bindings_.back();
+    free_bindings_.pop_back();
+  } else {
+    slot = static_cast<int>(bindings_.size());
+    bindings_.emplace_back();
   }
+
+  bindings_[slot].key = widget;
+  bindings_[slot].widget = widget;
+  bindings_[slot].pred = pred;
+  binding_of_widget_[widget] = slot;
+
+  // 建立反向依赖：当依赖路径改变时，必须顺藤摸瓜通知到这条记录
+  auto& targets = reverse_deps_[pred.dep_id];
+  if (std::find(targets.begin(), targets.end(), slot) == targets.end()) {
+    targets.push_back(slot);
+  }
+  pending_bindings_.push_back(slot);
+  return true;
 }
 
-void DependencyGraph::EvaluateAll() {
-  // 这是一招大杀器：遍历全图，让每一个绑定了附庸条件的组件都进行自我反省
-  for (auto& [dep_path, targets] : reverse_deps_) {
-    targets.erase(
-        std::remove_if(targets.begin(), targets.end(),
-                       [](const QPointer<QWidget>& w) { return w.isNull(); }),
-        targets.end());
-
-    for (auto& w : targets) {
-      if (w) {
-        bool should_enable = EvaluateExpression(w.data());
-        w->setEnabled(should_enable);
+void DependencyGraph::RemoveDependency(QWidget* widget) {
+  auto it = binding_of_widget_.find(widget);
+  if (it == binding_of_widget_.end()) return;
+  // 置空弱指针即等同于控件已销毁，Refresh 会顺带回收槽位
+  if (bindings_[it->second].widget.data() == widget) {
+    bindings_[it->second].widget = nullptr;
+  }
+}
+
+bool DependencyGraph::Refresh(int binding) {
+  Binding& b = bindings_[binding];
+  if (b.widget.isNull()) {
+    // 控件已随页面淘汰销毁：回收槽位，留给后续挂载复用
+    if (b.pred.parsed) {
+      auto it = binding_of_widget_.find(b.key);
+      if (it != binding_of_widget_.end() && it->second == binding) {
+        binding_of_widget_.erase(it);
       }
+      b.key = nullptr;
+      b.pred = CompiledPredicate();
+      free_bindings_.push_back(binding);
     }
+    return false;
   }
+  b.widget->setEnabled(Evaluate(b.pred));
+  return true;
+}
+
+void DependencyGraph::OnParameterChanged(const std::string& changed_path) {
+  // 收到风声说 changed_path 被人修改了。顺着它的名字去图谱里查一下有谁依赖了它
+  auto id_it = path_ids_.find(changed_path);
+  if (id_it == path_ids_.end()) return;
+  auto dep_it = reverse_deps_.find(id_it->second);
+  if (dep_it == reverse_deps_.end()) return;
+
+  auto& targets = dep_it->second;
+  // 挨个点名重算；踢出已经被销毁 (或槽位已被其他依赖复用) 的记录
+  targets.erase(std::remove_if(targets.begin(), targets.end(),
+                               [this, &id_it](int slot) {
+                                 if (bindings_[slot].pred.dep_id !=
+                                     id_it->second) {
+                                   return true;
+                                 }
+                                 return !Refresh(slot);
+                               }),
+                targets.end());
+}
+
+void DependencyGraph::EvaluatePending() {
+  std::vector<int> pending;
+  pending.swap(pending_bindings_);
+  for (int slot : pending) Refresh(slot);
 }
 
-bool DependencyGraph::EvaluateExpression(QWidget* widget) {
-  // 如果当前根本没有注入代理通道去要数据，为了防止界面瘫痪，必须一律放行
-  if (!value_provider_) return true;
+void DependencyGraph::EvaluateAll() {
+  pending_bindings_.clear();
+  for (int slot = 0; slot < static_cast<int>(bindings_.size()); ++slot) {
+    if (bindings_[slot].pred.parsed) Refresh(slot);
+  }
+}
 
-  // 如果当初预编译正则表达式失败，也一律放行
-  if (!widget->property("pred_parsed").toBool()) {
-    QString cond = widget->property("enable_condition").toString();
-    return cond.isEmpty() ? true : true; 
+bool DependencyGraph::EvaluateCondition(const QString& cond) const {
+  if (!value_provider_ || cond.isEmpty()) return true;
+  auto it = condition_cache_.find(cond);
+  if (it == condition_cache_.end()) {
+    it = condition_cache_.emplace(cond, Compile(cond)).first;
   }
+  return Evaluate(it->second);
+}
 
-  // 从控件身上把预编译好的结构体拿出来
-  bool invert_logic = widget->property("pred_invert").toBool();
-  std::string dep_path = widget->property("pred_dep_path").toString().toStdString();
-  QString op = widget->property("pred_op").toString();
-  QString target_val_str = widget->property("pred_target_val").toString();
+bool DependencyGraph::Evaluate(const CompiledPredicate& pred) const {
+  // 如果当前根本没有注入代理通道去要数据，或者当初解析失败，为了防止界面瘫痪，必须一律放行
+  if (!value_provider_ || !pred.parsed) return true;
 
   // 找大哥（代理通道）问一下目前依赖的这个参数是多少
-  QVariant current_val = value_provider_(dep_path);
+  QVariant current_val = value_provider_(paths_[pred.dep_id]);
 
   // 【防卡死护城河】：如果后台路径被热更移除或尚未建立，强制放行，避免 UI 被永久锁死
   if (!current_val.isValid()) return true;
 
   // 【隐式逻辑推断】：纯变量没有提供操作符时的直接判定 (如 "!Camera.AutoExp")
-  if (op.isEmpty()) {
+  if (pred.op == Op::kNone) {
     bool res = true;
     if (current_val.userType() == QMetaType::Bool) {
       res = current_val.toBool();
@@ -119,34 +210,35 @@ bool DependencyGraph::EvaluateExpression(QWidget* widget) {
                current_val.userType() == QMetaType::LongLong) {
       res = current_val.toLongLong() != 0;
     }
-    return invert_logic ? !res : res;
+    return pred.invert ? !res : res;
   }
 
   // 布尔状态特化安全处理
   if (current_val.userType() == QMetaType::Bool) {
     bool c_bool = current_val.toBool();
-    bool t_bool = (target_val_str.toLower() == "true" || target_val_str == "1");
-    if (op == "==") return c_bool == t_bool;
-    if (op == "!=") return c_bool != t_bool;
+    if (pred.op == Op::kEq) return c_bool == pred.target_bool;
+    if (pred.op == Op::kNe) return c_bool != pred.target_bool;
   }
 
-  // 数值特化处理，避免用字符串方式比较数字大小
-  bool is_num = false;
-  double t_num = target_val_str.toDouble(&is_num);
-  if (is_num) {
+  // 数值特化处理，避免用字符串方式比较数字大小 (目标值已在编译时解析)
+  if (pred.target_is_num) {
     double c_num = current_val.toDouble();
-    if (op == "==") return std::abs(c_num - t_num) < 1e-9;
-    if (op == "!=") return std::abs(c_num - t_num) >= 1e-9;
-    if (op == ">")  return c_num > t_num;
-    if (op == "<")  return c_num < t_num;
-    if (op == ">=") return c_num >= t_num;
-    if (op == "<=") return c_num <= t_num;
+    double t_num = pred.target_num;
+    switch (pred.op) {
+      case Op::kEq: return std::abs(c_num - t_num) < 1e-9;
+      case Op::kNe: return std::abs(c_num - t_num) >= 1e-9;
+      case Op::kGt: return c_num > t_num;
+      case Op::kLt: return c_num < t_num;
+      case Op::kGe: return c_num >= t_num;
+      case Op::kLe: return c_num <= t_num;
+      default: break;
+    }
   }
 
   // 字符串托底退化比较
   QString c_str = current_val.toString();
-  if (op == "==") return c_str == target_val_str;
-  if (op == "!=") return c_str != target_val_str;
+  if (pred.op == Op::kEq) return c_str == pred.target_str;
+  if (pred.op == Op::kNe) return c_str != pred.target_str;
 
   return true;
 }
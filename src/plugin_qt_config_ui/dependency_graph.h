@@ -6,12 +6,18 @@
  * 现代参数系统常常需要联动：比如，只有当勾选了“开启自动测光”，下面的“曝光时间”参数才会从禁用变灰状态解禁。
  * DependencyGraph 负责解析这类在 Schema 中定义的字符串依赖条件（如 "Camera.AutoExp == true"），
  * 形成一张拓扑图，当某个主参数改变时，自动结算依赖该参数的所有下游控件的可用性（Enabled 状态）。
+ *
+ * 条件字符串在挂载时只解析一次，编译成 CompiledPredicate (枚举操作符、预解析的目标值、
+ * 驻留的路径 ID) 存入侧表；求值时不再读取控件的动态属性，也不再做字符串解析。
+ * 解析 (Parse) 是纯函数，可以在后台线程提前完成 (见 page_plan.h)，挂载时只剩路径驻留。
  */
 
 #pragma once
 #include <QPointer>
+#include <QString>
 #include <QVariant>
 #include <QWidget>
+#include <cstdint>
 #include <functional>
 #include <string>
 #include <unordered_map>
@@ -32,36 +38,123 @@ class DependencyGraph {
    */
   using ValueProvider = std::function<QVariant(const std::string&)>;
 
+  /** @brief 比较操作符。kNone 表示纯变量 (如 "!Camera.AutoExp")。 */
+  enum class Op : uint8_t { kNone, kEq, kNe, kGt, kLt, kGe, kLe };
+
+  /** @brief 解析后尚未驻留路径的条件，不依赖图谱状态，可跨线程传递。 */
+  struct ParsedCondition {
+    bool parsed = false;
+    bool invert = false;
+    Op op = Op::kNone;
+    std::string dep_path;      ///< 所依赖的配置路径
+    QString target_str;        ///< 字符串比较用的目标值 (已剥去引号)
+    bool target_is_num = false;
+    double target_num = 0.0;
+    bool target_bool = false;
+  };
+
+  /**
+   * @brief 解析条件字符串 (纯函数，线程安全)。
+   * @return 语法不符时 parsed 为 false。
+   */
+  static ParsedCondition Parse(const QString& cond);
+
   /** @brief 注入外部的寻值代理。 */
   void SetValueProvider(ValueProvider provider);
 
   /**
-   * @brief 为某个目标 UI 控件增加对特定参数的依赖约束。
+   * @brief 为某个目标 UI 控件挂载一条使能条件。
    * @param target_path 本控件绑定的配置路径。
-   * @param depends_on_path 它所依赖的那个配置参数的路径。
+   * @param condition 条件字符串 (如 "!Camera.AutoExp"、"Mode == 'auto'")，只在这里解析一次。
    * @param widget 需要被管控 Enabled 状态的目标控件指针。
+   * @return 条件无法解析时返回 false，该控件保持常亮。
    */
-  void AddDependency(const std::string& target_path,
-                     const std::string& depends_on_path, QWidget* widget);
+  bool AddDependency(const std::string& target_path, const QString& condition,
+                     QWidget* widget);
+
+  /** @brief 同上，条件已经事先 Parse 过 (后台准备的页面走这条路径)。 */
+  bool AddDependency(const std::string& target_path,
+                     const ParsedCondition& condition, QWidget* widget);
+
+  /**
+   * @brief 摘除某个控件的挂载记录 (控件被回收池复用前调用)。
+   * @details 只断开记录与控件的联系，槽位在下一次结算时回收。
+   */
+  void RemoveDependency(QWidget* widget);
 
   /**
    * @brief 当系统感知到某个参数发生了值变动时触发此调用，启动下游状态级联刷新。
+   * @details 经反向索引只重算依赖该路径的控件。
    * @param changed_path 发生变化的参数路径。
    */
   void OnParameterChanged(const std::string& changed_path);
 
   /**
-   * @brief 用于页面首次加载时的全局群体状态结算，确保所有控件在显示的第一瞬间处于正确的灰度状态。
+   * @brief 结算自上次调用以来新挂载的控件 (页面首次构建后调用)。
+   * @details 已缓存页面上的控件状态早已由 OnParameterChanged 维护，无需重算。
+   */
+  void EvaluatePending();
+
+  /**
+   * @brief 全局群体状态结算，确保所有控件都处于正确的灰度状态。
    */
   void EvaluateAll();
 
+  /**
+   * @brief 不依附控件、直接对一条条件字符串求值 (虚拟化页面按行调用，行没有常驻控件)。
+   * @details 同一条件字符串只编译一次，结果缓存在内部。
+   * @return 条件成立或无法解析时返回 true。
+   */
+  bool EvaluateCondition(const QString& cond) const;
+
  private:
-  /** @brief 核心布尔逻辑求值器。根据字符串如 "Param > 10"，向 provider 求值比对后返回真假。 */
-  bool EvaluateExpression(QWidget* widget);
+  /** @brief 编译后的条件：求值时只剩一次取值和一次比较。 */
+  struct CompiledPredicate {
+    bool parsed = false;
+    bool invert = false;
+    Op op = Op::kNone;
+    int dep_id = -1;           ///< 依赖路径的驻留 ID (下标进 paths_)
+    QString target_str;        ///< 字符串比较用的目标值 (已剥去引号)
+    bool target_is_num = false;
+    double target_num = 0.0;
+    bool target_bool = false;
+  };
+
+  /** @brief 侧表中的一条挂载记录。 */
+  struct Binding {
+    QWidget* key = nullptr;  ///< binding_of_widget_ 中的键 (控件销毁后仍可用于擦除)
+    QPointer<QWidget> widget;
+    CompiledPredicate pred;
+  };
+
+  /** @brief 把条件字符串编译为 CompiledPredicate (会驻留依赖路径)。 */
+  CompiledPredicate Compile(const QString& cond) const;
+  /** @brief 驻留已解析条件的依赖路径，得到可求值的 CompiledPredicate。 */
+  CompiledPredicate Compile(const ParsedCondition& cond) const;
+  /** @brief 路径驻留：同一路径始终得到同一个 ID。 */
+  int InternPath(const std::string& path) const;
+  /** @brief 核心布尔逻辑求值器：向 provider 取一次值后按编译结果比较。 */
+  bool Evaluate(const CompiledPredicate& pred) const;
+  /** @brief 重算一条挂载记录；控件已销毁时回收槽位并返回 false。 */
+  bool Refresh(int binding);
+
+  /** @brief 驻留的依赖路径表。 */
+  mutable std::vector<std::string> paths_;
+  mutable std::unordered_map<std::string, int> path_ids_;
+
+  /** @brief 挂载侧表 (槽位可复用) 与按控件查找的索引。 */
+  std::vector<Binding> bindings_;
+  std::vector<int> free_bindings_;
+  std::unordered_map<QWidget*, int> binding_of_widget_;
+  /** @brief 尚未结算过的新挂载记录。 */
+  std::vector<int> pending_bindings_;
+
+  /** @brief 反向依赖索引表：依赖路径 ID -> [受其牵连的挂载记录] */
+  std::unordered_map<int, std::vector<int>> reverse_deps_;
+
+  /** @brief EvaluateCondition 的编译缓存。 */
+  mutable std::unordered_map<QString, CompiledPredicate> condition_cache_;
 
-  /** @brief 反向依赖索引表：主路径 -> [受其牵连的众多目标控件] */
-  std::unordered_map<std::string, std::vector<QPointer<QWidget>>> reverse_deps_;
-  
   /** @brief 指向系统真实取值来源的函数代理。 */
   ValueProvider value_provider_;
 };
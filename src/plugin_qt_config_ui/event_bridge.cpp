@@ -3,7 +3,7 @@
  * @brief 跨线程事件桥接器的实现代码。
  *
  * @details
- * 主要实现了基于 QMetaObject::invokeMethod 的无锁化数据跨线程投递逻辑，
+ * 主要实现了基于 IEventExecutor 的无锁化数据跨线程投递逻辑 (事件直接投递到 UI 线程)，
  * 极大地保证了在高频并发参数更新下，UI 界面的流畅度与系统的绝对稳定。
  */
 
@@ -11,6 +11,7 @@
 
 #include <QString>
 #include <QVariantList>
+#include <algorithm>
 
 #include "framework/plugin_exceptions.h"
 #include "framework/z3y_service_locator.h"
@@ -20,22 +21,33 @@ namespace z3y {
 namespace plugins {
 namespace qt_ui {
 
+void QtObjectExecutor::Post(std::function<void()> task) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  if (!context_) return;
+  // 非阻塞：把任务塞进 context_ 所在线程的事件队列。
+  // 对象销毁时 Qt 会丢弃尚未执行的排队调用。
+  QMetaObject::invokeMethod(context_, std::move(task), Qt::QueuedConnection);
+}
+
 void EventBridgeSubscriber::OnConfigChanged(
     const z3y::interfaces::core::ConfigChangedEvent& evt) {
   std::lock_guard<std::mutex> lock(mtx_);
   // 确保 bridge_ 还在，且服务没被卸载
   if (bridge_ && bridge_->cached_config_srv_) {
     QString qt_path = QString::fromUtf8(evt.path.data(), evt.path.size());
+    // 没有控件显示的参数不必取值和转换
+    if (!bridge_->Accepts(qt_path)) return;
 
     try {
-      // 重新向底层请求一次获取强类型的真实数据
-      auto current_val = bridge_->cached_config_srv_->GetValue(evt.path);
-      // 转化为 Qt 可以理解的数据结构
-      QVariant qt_val = ConvertToQVariant(current_val);
-      
-      // 【核心技术点】：强行将其投递回 Main(UI) 线程执行 ReceiveDataInMainThread。
-      // 这个动作本身是非阻塞的，它会把调用任务塞进 UI 线程的事件队列中。
-      QMetaObject::invokeMethod(bridge_, [bridge = bridge_, qt_path, qt_val]() { bridge->ReceiveDataInMainThread(qt_path, qt_val); }, Qt::QueuedConnection);
+      // 事件自带强类型新值时直接使用，否则再向底层请求一次
+      QVariant qt_val =
+          evt.new_value
+              ? ConvertToQVariant(*evt.new_value)
+              : ConvertToQVariant(
+                    bridge_->cached_config_srv_->GetValue(evt.path));
+
+      // 【核心技术点】：QtObjectExecutor 已经把本回调送到了 UI 线程，这里直接写入即可。
+      bridge_->ReceiveDataInMainThread(qt_path, qt_val);
     } catch (...) {
       // 忽略因路径被瞬间移除导致无法获取值的情况
     }
@@ -45,8 +57,9 @@ void EventBridgeSubscriber::OnConfigChanged(
 EventBridge::EventBridge(QObject* parent) : QObject(parent) {}
 
 EventBridge::~EventBridge() {
-  // 析构时先切断 EventBus
+  // 析构时先切断 EventBus，再停止向本对象投递
   conn_.Disconnect();
+  if (executor_) executor_->Detach();
   // 并且主动清理 Subscriber 对自身的指引，避免野指针调用
   if (subscriber_) subscriber_->Detach();
 }
@@ -58,28 +71,59 @@ void EventBridge::Init() {
     auto event_bus = z3y::GetService<z3y::IEventBus>(z3y::clsid::kEventBus);
     if (event_bus) {
       subscriber_ = std::make_shared<EventBridgeSubscriber>(this);
-      // 订阅全局级别的 ConfigChangedEvent
+      executor_ = std::make_shared<QtObjectExecutor>(this);
+      // 订阅全局级别的 ConfigChangedEvent，事件直接投递到 UI 线程
       conn_ =
           event_bus->SubscribeGlobal<z3y::interfaces::core::ConfigChangedEvent>(
-              subscriber_, &EventBridgeSubscriber::OnConfigChanged,
-              z3y::ConnectionType::kDirect);
+              subscriber_, &EventBridgeSubscriber::OnConfigChanged, executor_);
     }
   } catch (...) {
   }
 
-  // 设置定时器：每 33ms 收割一次全部积累的更新包发送给 UI
-  throttle_timer_.setInterval(33);
+  // 单发定时器：收到变更时才按需启动，见 ScheduleFlush
+  throttle_timer_.setSingleShot(true);
   connect(&throttle_timer_, &QTimer::timeout, this,
           &EventBridge::FlushDirtyData);
-  throttle_timer_.start();
+  interval_ms_ = min_interval_ms_;
+  stats_.current_interval_ms = interval_ms_;
+  since_last_flush_.start();
+}
+
+void EventBridge::SetUpdateFilter(UpdateFilter filter) {
+  filter_ = std::move(filter);
+}
+
+void EventBridge::SetThrottleLimits(int min_interval_ms, int max_interval_ms) {
+  min_interval_ms_ = std::max(0, min_interval_ms);
+  max_interval_ms_ = std::max(min_interval_ms_, max_interval_ms);
+  interval_ms_ = std::clamp(interval_ms_, min_interval_ms_, max_interval_ms_);
+  stats_.current_interval_ms = interval_ms_;
+}
+
+bool EventBridge::Accepts(const QString& path) {
+  if (!filter_ || filter_(path)) return true;
+  ++stats_.dropped_updates;
+  return false;
+}
+
+void EventBridge::ScheduleFlush() {
+  if (throttle_timer_.isActive() || dirty_map_.empty()) return;
+  // 距上次刷新已超过当前间隔 (空闲)：0ms 定时器，处理完本轮排队事件后立即刷出；
+  // 否则等到间隔走完，期间到达的变更在 dirty_map_ 里合并
+  const qint64 waited = since_last_flush_.isValid()
+                            ? since_last_flush_.elapsed()
+                            : static_cast<qint64>(interval_ms_);
+  const qint64 remaining = std::max<qint64>(0, interval_ms_ - waited);
+  throttle_timer_.start(static_cast<int>(remaining));
 }
 
 void EventBridge::ReceiveDataInMainThread(QString path, QVariant value) {
   // 【无锁化设计原理】
-  // 这个函数由于被 invokeMethod 丢到了主线程执行，所以此时环境 100% 是单线程的 UI 线程。
+  // 这个函数由 QtObjectExecutor 投递到主线程执行，所以此时环境 100% 是单线程的 UI 线程。
   // 此时对 dirty_map_ 进行读写是绝对线程安全的，不需要任何 std::mutex 互斥锁。
   // 若同一个参数在 33ms 内突发变化几十次，map 还会天然地通过 key 覆盖去重，只有最后一次值留存。
   dirty_map_[path] = value;
+  ScheduleFlush();
 }
 
 void EventBridge::FlushDirtyData() {
@@ -91,7 +135,30 @@ void EventBridge::FlushDirtyData() {
   batch.swap(dirty_map_);
 
   // 直接将聚合打包好的数据发出去（Main Window 会连接这个信号）
+  // 同线程直连，计时涵盖主窗口处理这一批更新的全部耗时
+  QElapsedTimer cost;
+  cost.start();
   emit batchedConfigChanged(batch);
+  const double cost_ms = static_cast<double>(cost.nsecsElapsed()) / 1e6;
+
+  ++stats_.flush_count;
+  stats_.delivered_updates += batch.size();
+  stats_.last_flush_ms = cost_ms;
+  stats_.avg_flush_ms = stats_.flush_count == 1
+                            ? cost_ms
+                            : stats_.avg_flush_ms * (1.0 - kAvgWeight) +
+                                  cost_ms * kAvgWeight;
+  stats_.max_flush_ms = std::max(stats_.max_flush_ms, cost_ms);
+
+  // 负载越重间隔越长；用滑动平均避免单批抖动导致间隔忽长忽短
+  interval_ms_ = std::clamp(
+      static_cast<int>(std::max(cost_ms, stats_.avg_flush_ms) * kLoadFactor),
+      min_interval_ms_, max_interval_ms_);
+  stats_.current_interval_ms = interval_ms_;
+  since_last_flush_.restart();
+
+  // 处理期间又有新变更进来 (例如槽函数里改了值)，按新间隔继续安排
+  ScheduleFlush();
 }
 
 }  // namespace qt_ui
@@ -9,6 +9,11 @@
  * 1. 它订阅后台的 ConfigChangedEvent。
  * 2. 收集一定时间内的密集变更（节流 Throttling）。
  * 3. 最终通过 Qt 的信号-槽（QueuedConnection）打包发送给 UI 进行无锁刷新。
+ *
+ * 【自适应节流】
+ * 空闲时第一条变更会在当前事件循环处理完后立刻刷出；刷新间隔随 UI 线程处理一批更新的实测耗时
+ * 伸缩 (耗时 x kLoadFactor，限定在 [min, max] 之间)，导入配方这类洪峰下 UI 线程最多约 1/5 的时间
+ * 花在刷新上。主窗口可以注入过滤器，尚未实例化的页面上的参数在进入脏数据池之前就被丢弃。
  */
 
 #pragma once
@@ -16,13 +21,17 @@
 #include <QObject>
 #include <QString>
 #include <QTimer>
+#include <QElapsedTimer>
 #include <QVariant>
+#include <cstdint>
+#include <functional>
 #include <map>
 #include <memory>
 #include <mutex>
 #include <string>
 
 #include "framework/connection.h"
+#include "framework/event_executor.h"
 #include "framework/i_event_bus.h"
 #include "interfaces_core/config_types.h"
 #include "interfaces_core/i_config_service.h"
@@ -36,6 +45,31 @@ using ConfigUpdateMap = std::map<QString, QVariant>;
 
 class EventBridge;
 
+/**
+ * @class QtObjectExecutor
+ * @brief 把 EventBus 的异步投递直接送进某个 QObject 所在线程的事件循环。
+ *
+ * @details
+ * 订阅时把它作为执行器传入，回调就会在 UI 线程上执行，
+ * 不必再在后台回调里手动 `QMetaObject::invokeMethod` 转投一次。
+ */
+class QtObjectExecutor : public z3y::IEventExecutor {
+ public:
+  explicit QtObjectExecutor(QObject* context) : context_(context) {}
+
+  void Post(std::function<void()> task) override;
+
+  /** @brief 宿主 QObject 析构前调用，之后的投递全部丢弃 */
+  void Detach() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    context_ = nullptr;
+  }
+
+ private:
+  std::mutex mtx_;      /**< @brief 保护 context_ 指针 */
+  QObject* context_;    /**< @brief 投递目标 */
+};
+
 /**
  * @class EventBridgeSubscriber
  * @brief 订阅者实体类，专门负责从 EventBus 接收全局事件。
@@ -50,7 +84,7 @@ class EventBridgeSubscriber
   /** @brief 构造并绑定关联的 EventBridge 大脑 */
   explicit EventBridgeSubscriber(EventBridge* bridge) : bridge_(bridge) {}
   
-  /** @brief 后台数据变更时触发的核心回调函数 */
+  /** @brief 数据变更时触发的核心回调函数 (经 QtObjectExecutor 在 UI 线程上执行) */
   void OnConfigChanged(const z3y::interfaces::core::ConfigChangedEvent& evt);
   
   /** @brief 脱离函数，用于在 EventBridge 销毁时主动切断联系 */
@@ -75,13 +109,39 @@ class EventBridge : public QObject {
   explicit EventBridge(QObject* parent = nullptr);
   ~EventBridge() override;
 
-  /** @brief 初始化操作：向 EventBus 注册订阅，启动节流定时器 */
+  /** @brief 自适应节流的运行统计，供调优观察。 */
+  struct FlushStats {
+    uint64_t flush_count = 0;        /**< @brief 已刷出的批次数 */
+    uint64_t delivered_updates = 0;  /**< @brief 已交给 UI 的参数条数 (去重后) */
+    uint64_t dropped_updates = 0;    /**< @brief 被过滤器丢弃的事件数 (页面未实例化) */
+    double last_flush_ms = 0.0;      /**< @brief 最近一批在 UI 线程上的处理耗时 */
+    double avg_flush_ms = 0.0;       /**< @brief 处理耗时的指数滑动平均 */
+    double max_flush_ms = 0.0;       /**< @brief 处理耗时的历史峰值 */
+    int current_interval_ms = 0;     /**< @brief 当前生效的刷新间隔 */
+  };
+
+  /** @brief 路径过滤器：返回 false 的参数变更直接丢弃。 */
+  using UpdateFilter = std::function<bool(const QString& path)>;
+
+  /** @brief 初始化操作：向 EventBus 注册订阅，准备节流定时器 */
   void Init();
 
+  /**
+   * @brief 注入过滤器 (通常由主窗口提供“该路径当前是否有控件”)。传入空函数表示不过滤。
+   * @details 被丢弃的页面下次构建时会直接向后台读取最新值，不会显示旧数据。
+   */
+  void SetUpdateFilter(UpdateFilter filter);
+
+  /** @brief 调整自适应刷新间隔的上下限 (毫秒)。 */
+  void SetThrottleLimits(int min_interval_ms, int max_interval_ms);
+
+  /** @brief 读取节流统计。 */
+  FlushStats GetFlushStats() const { return stats_; }
+
  signals:
   /**
    * @brief 打包发送给主窗口的数据更新信号。
-   * @param updates 汇总了这 33ms 内所有被修改的数据字典。
+   * @param updates 汇总了自上一批以来所有被修改的数据字典 (同一参数只保留最后一次值)。
    */
   void batchedConfigChanged(
       const z3y::plugins::qt_ui::ConfigUpdateMap& updates);
@@ -92,20 +152,38 @@ class EventBridge : public QObject {
 
  private:
   /**
-   * @brief 在主线程中接收来自后台线程投递的单条数据。
-   * @details 宏 Q_INVOKABLE 使得该函数可通过 QMetaObject::invokeMethod 进行跨线程调用。
+   * @brief 在主线程中接收单条数据。
    * @param path 发生变化的参数路径
    * @param value 最新的数据值，已经转换为 Qt 变体 QVariant
    */
-  Q_INVOKABLE void ReceiveDataInMainThread(QString path, QVariant value);
+  void ReceiveDataInMainThread(QString path, QVariant value);
+  /** @brief 过滤器判定；被丢弃时计入统计。 */
+  bool Accepts(const QString& path);
+  /** @brief 有脏数据且定时器空闲时，按距上次刷新的时间安排下一次刷新。 */
+  void ScheduleFlush();
 
  private:
+  /** @brief 刷新间隔 = 单批耗时 x kLoadFactor，UI 线程约 1/(1+kLoadFactor) 的时间用于刷新。 */
+  static constexpr double kLoadFactor = 4.0;
+  /** @brief 处理耗时滑动平均的权重。 */
+  static constexpr double kAvgWeight = 0.2;
+
   /** @brief 管理全局订阅的生命周期锚点 */
   z3y::Connection conn_;
   /** @brief 指向底层订阅回调载体的共享指针 */
   std::shared_ptr<EventBridgeSubscriber> subscriber_;
-  /** @brief 30 FPS 的节流定时器，防止 UI 响应过度频繁卡死 */
+  /** @brief 把事件投递到本对象所在 (UI) 线程的执行器 */
+  std::shared_ptr<QtObjectExecutor> executor_;
+  /** @brief 单发节流定时器：只在有脏数据时启动，空闲时不产生任何唤醒 */
   QTimer throttle_timer_;
+  /** @brief 距上次刷新的计时，用于判断是否空闲 */
+  QElapsedTimer since_last_flush_;
+  int min_interval_ms_ = 16;   /**< @brief 刷新间隔下限 (约 60 FPS) */
+  int max_interval_ms_ = 500;  /**< @brief 刷新间隔上限，洪峰下也保证每秒至少两次反馈 */
+  int interval_ms_ = 16;       /**< @brief 当前刷新间隔 */
+
+  UpdateFilter filter_;
+  FlushStats stats_;
 
   /** @brief 缓存 ConfigService 句柄，便于快速读取最新的真实数据 */
   std::shared_ptr<z3y::interfaces::core::IConfigService> cached_config_srv_;
@@ -0,0 +1,64 @@
+﻿/**
+ * @file monitor_poller.cpp
+ * @brief 监视参数拉取器的实现。
+ */
+
+#include "monitor_poller.h"
+
+#include <algorithm>
+
+#include "qt_utils.h"
+
+namespace z3y {
+namespace plugins {
+namespace qt_ui {
+
+MonitorPoller::MonitorPoller(QObject* parent) : QObject(parent) {
+  timer_.setInterval(kDefaultIntervalMs);
+  // 轮询本身是定长的小开销，粗精度定时器即可，不需要为它唤醒 CPU
+  timer_.setTimerType(Qt::CoarseTimer);
+  connect(&timer_, &QTimer::timeout, this, &MonitorPoller::Poll);
+}
+
+void MonitorPoller::SetInterval(int interval_ms) {
+  timer_.setInterval(std::max(1, interval_ms));
+}
+
+void MonitorPoller::Register(
+    const QString& path, std::shared_ptr<z3y::interfaces::core::ConfigMonitorCell> cell,
+    QWidget* anchor) {
+  if (!cell || !anchor) return;
+  entries_[path] = Entry{std::move(cell), QPointer<QWidget>(anchor), UINT64_MAX};
+  if (!timer_.isActive()) timer_.start();
+}
+
+void MonitorPoller::Unregister(const QString& path) {
+  entries_.erase(path);
+  if (entries_.empty()) timer_.stop();
+}
+
+void MonitorPoller::Poll() {
+  ConfigUpdateMap updates;
+  for (auto it = entries_.begin(); it != entries_.end();) {
+    Entry& entry = it->second;
+    if (entry.anchor.isNull()) {
+      it = entries_.erase(it);  // 控件随页面销毁，顺带注销
+      continue;
+    }
+    // 隐藏的页面 (堆栈中的非当前页) 或被折叠的高级参数不读取
+    if (entry.anchor->isVisible()) {
+      const uint64_t version = entry.cell->Version();
+      if (version != entry.seen_version) {
+        entry.seen_version = version;
+        updates.emplace(it->first, ConvertToQVariant(entry.cell->Load()));
+      }
+    }
+    ++it;
+  }
+  if (entries_.empty()) timer_.stop();
+  if (!updates.empty()) emit valuesChanged(updates);
+}
+
+}  // namespace qt_ui
+}  // namespace plugins
+}  // namespace z3y
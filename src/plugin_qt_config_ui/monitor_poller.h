@@ -0,0 +1,79 @@
+﻿/**
+ * @file monitor_poller.h
+ * @brief 高频监视参数 (SchemaMetadata::is_monitor) 的界面拉取器。
+ *
+ * @details
+ * 监视参数的写入方以 kHz 频率刷新 ConfigMonitorCell，不产生 ConfigChangedEvent，
+ * EventBridge 因此收不到它们。拉取器以固定刷新率 (默认约 30 Hz) 在 GUI 线程上轮询：
+ * - 只看锚点控件当前可见的参数 (整页模式锚点是参数控件本身，虚拟化页面锚点是整页)，
+ * 被 LRU 淘汰或切到后台的页面不产生任何开销。
+ * - 先比较单元的版本号，没有变化的参数不转换、不发信号。
+ * - 变化的值汇成一个 ConfigUpdateMap 经 valuesChanged 发出，主窗口复用 OnBatchedConfigChanged 的刷新路径。
+ * - 没有登记任何参数时定时器停止。只在 GUI 线程使用。
+ */
+
+#pragma once
+#include <QObject>
+#include <QPointer>
+#include <QString>
+#include <QTimer>
+#include <QWidget>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+
+#include "event_bridge.h"
+#include "interfaces_core/config_types.h"
+
+namespace z3y {
+namespace plugins {
+namespace qt_ui {
+
+/**
+ * @class MonitorPoller
+ * @brief 按刷新率轮询可见监视参数的版本号，变化时批量发出新值。
+ */
+class MonitorPoller : public QObject {
+  Q_OBJECT
+ public:
+  /** @brief 默认刷新间隔 (约 30 Hz)。 */
+  static constexpr int kDefaultIntervalMs = 33;
+
+  explicit MonitorPoller(QObject* parent = nullptr);
+
+  /** @brief 修改刷新间隔。 */
+  void SetInterval(int interval_ms);
+
+  /**
+   * @brief 登记一个监视参数。
+   * @param anchor 决定是否轮询的控件：不可见时跳过，销毁后自动注销。
+   * 重复登记同一路径时替换锚点，并在下一次轮询时无条件刷新一次。
+   */
+  void Register(const QString& path, std::shared_ptr<z3y::interfaces::core::ConfigMonitorCell> cell,
+                QWidget* anchor);
+  /** @brief 注销一个监视参数 (路径未登记时什么也不做)。 */
+  void Unregister(const QString& path);
+  /** @brief 是否登记了该路径。 */
+  bool Contains(const QString& path) const { return entries_.count(path) != 0; }
+
+ signals:
+  /** @brief 一轮轮询中发生变化的可见参数。 */
+  void valuesChanged(const z3y::plugins::qt_ui::ConfigUpdateMap& updates);
+
+ private slots:
+  void Poll();
+
+ private:
+  struct Entry {
+    std::shared_ptr<z3y::interfaces::core::ConfigMonitorCell> cell;
+    QPointer<QWidget> anchor;
+    uint64_t seen_version = UINT64_MAX;  ///< 上次发出时的版本号 (初始值保证首轮刷新)
+  };
+
+  QTimer timer_;
+  std::unordered_map<QString, Entry> entries_;
+};
+
+}  // namespace qt_ui
+}  // namespace plugins
+}  // namespace z3y
@@ -0,0 +1,330 @@
+﻿/**
+ * @file navigation_search_index.cpp
+ * @brief 导航树搜索索引的实现。
+ */
+
+#include "navigation_search_index.h"
+
+#include <algorithm>
+
+namespace z3y {
+namespace plugins {
+namespace qt_ui {
+
+namespace {
+
+/** @brief 三个 UTF-16 码元打包成一个键。 */
+uint64_t TrigramKey(const QChar* p) {
+  return (static_cast<uint64_t>(p[0].unicode()) << 32) |
+         (static_cast<uint64_t>(p[1].unicode()) << 16) |
+         static_cast<uint64_t>(p[2].unicode());
+}
+
+}  // namespace
+
+void NavigationSearchIndex::Build(QTreeWidget* tree, Loader loader) {
+  tree_ = tree;
+  loader_ = std::move(loader);
+  catalog_.clear();
+  catalog_loaded_ = false;
+  entries_.clear();
+  applied_.clear();
+  Reindex();
+}
+
+void NavigationSearchIndex::Reindex() {
+  std::unordered_map<QTreeWidgetItem*, uint8_t> previous;
+  for (size_t i = 0; i < entries_.size(); ++i) {
+    if (entries_[i].item) previous[entries_[i].item] = applied_[i];
+  }
+  entries_.clear();
+  entry_of_item_.clear();
+  trigrams_.clear();
+  applied_.clear();
+  if (!tree_) return;
+
+  for (int i = 0; i < tree_->topLevelItemCount(); ++i) {
+    AddNode(tree_->topLevelItem(i), -1);
+  }
+
+  // 差量基准：已索引过的节点沿用旧基准，新节点取自树的真实状态，之后的第一次 Apply 不会漏改
+  applied_.resize(entries_.size());
+  for (size_t i = 0; i < entries_.size(); ++i) {
+    QTreeWidgetItem* item = entries_[i].item;
+    if (!item) continue;  // 尚未创建的节点既不可见也未展开
+    auto it = previous.find(item);
+    applied_[i] = it != previous.end()
+                      ? it->second
+                      : static_cast<uint8_t>((item->isHidden() ? 0 : kVisible) |
+                                             (item->isExpanded() ? kExpanded : 0));
+  }
+}
+
+bool NavigationSearchIndex::IsUnpopulated(const QTreeWidgetItem* item) {
+  return item->childCount() == 0 && item->data(0, kVisibleCountRole).toUInt() > 0;
+}
+
+bool NavigationSearchIndex::Populate(QTreeWidgetItem* subgroup) {
+  if (!subgroup || !IsUnpopulated(subgroup)) return false;
+
+  std::vector<LazyItem> lazy_items;
+  auto cat = catalog_.find(subgroup);
+  const bool indexed = cat != catalog_.end();  // 目录已载入：子条目已在索引里
+  if (indexed) {
+    lazy_items = std::move(cat->second);
+    catalog_.erase(cat);
+  } else if (loader_) {
+    lazy_items = loader_(subgroup);
+  }
+
+  const QString group_key = subgroup->data(0, Qt::UserRole).toString();
+  QList<QTreeWidgetItem*> children;
+  children.reserve(static_cast<qsizetype>(lazy_items.size()));
+  for (const LazyItem& lazy : lazy_items) {
+    QTreeWidgetItem* node = new QTreeWidgetItem(QStringList() << lazy.name);
+    node->setData(0, Qt::UserRole, lazy.path);
+    node->setData(0, Qt::UserRole + 1, "ITEM");
+    node->setData(0, Qt::UserRole + 2, group_key);
+    node->setData(0, Qt::UserRole + 3, lazy.is_advanced);  // 存入高级标记
+    children.append(node);
+  }
+  // 分组里的参数在建树之后全部消失：清掉计数，不再反复拉取
+  if (children.isEmpty()) subgroup->setData(0, kVisibleCountRole, 0u);
+  subgroup->addChildren(children);
+
+  auto self = entry_of_item_.find(subgroup);
+  if (indexed && self != entry_of_item_.end() &&
+      entries_[self->second].subtree_end - self->second - 1 == children.size()) {
+    // 子条目已按同样的顺序占好位置，只需补上树节点 (新节点可见、未展开)
+    for (int k = 0; k < children.size(); ++k) {
+      const int entry = self->second + 1 + k;
+      entries_[entry].item = children[k];
+      entry_of_item_[children[k]] = entry;
+      applied_[entry] = kVisible;
+    }
+  } else {
+    Reindex();
+  }
+  return true;
+}
+
+void NavigationSearchIndex::LoadCatalog() {
+  if (catalog_loaded_ || !loader_) return;
+  catalog_loaded_ = true;
+  for (const Entry& e : entries_) {
+    if (e.kind == Kind::kSubgroup && IsUnpopulated(e.item)) {
+      catalog_[e.item] = loader_(e.item);
+    }
+  }
+  Reindex();
+}
+
+void NavigationSearchIndex::AddNode(QTreeWidgetItem* item, int parent) {
+  const int self = static_cast<int>(entries_.size());
+  Entry entry;
+  entry.item = item;
+  entry.parent = parent;
+
+  const QString type = item->data(0, Qt::UserRole + 1).toString();
+  if (type == "GROUP") {
+    entry.kind = Kind::kGroup;
+  } else if (type == "SUBGROUP") {
+    entry.kind = Kind::kSubgroup;
+  } else if (type == "ITEM") {
+    entry.kind = Kind::kItem;
+    entry.is_advanced = item->data(0, Qt::UserRole + 3).toBool();
+  }
+  entry.name_folded = item->text(0).toCaseFolded();
+  entry.key_folded = item->data(0, Qt::UserRole).toString().toCaseFolded();
+  entries_.push_back(std::move(entry));
+  entry_of_item_[item] = self;
+
+  IndexText(entries_[self].name_folded, self);
+  IndexText(entries_[self].key_folded, self);
+
+  for (int i = 0; i < item->childCount(); ++i) {
+    AddNode(item->child(i), self);
+  }
+  if (entries_[self].kind == Kind::kSubgroup && IsUnpopulated(item)) {
+    auto cat = catalog_.find(item);
+    if (cat != catalog_.end()) {
+      for (const LazyItem& lazy : cat->second) AddLazyNode(lazy, self);
+    } else {
+      // 子节点还没拉取：可见性按计数结算
+      const uint32_t visible = item->data(0, kVisibleCountRole).toUInt();
+      const uint32_t advanced = item->data(0, kAdvancedCountRole).toUInt();
+      entries_[self].lazy_visible = visible;
+      entries_[self].lazy_basic = visible > advanced ? visible - advanced : 0;
+    }
+  }
+  entries_[self].subtree_end = static_cast<int>(entries_.size());
+}
+
+void NavigationSearchIndex::AddLazyNode(const LazyItem& lazy, int parent) {
+  const int self = static_cast<int>(entries_.size());
+  Entry entry;
+  entry.parent = parent;
+  entry.kind = Kind::kItem;
+  entry.is_advanced = lazy.is_advanced;
+  entry.name_folded = lazy.name.toCaseFolded();
+  entry.key_folded = lazy.path.toCaseFolded();
+  entry.subtree_end = self + 1;
+  entries_.push_back(std::move(entry));
+  IndexText(entries_[self].name_folded, self);
+  IndexText(entries_[self].key_folded, self);
+}
+
+void NavigationSearchIndex::IndexText(const QString& text, int entry) {
+  const QChar* p = text.constData();
+  for (qsizetype i = 0; i + 3 <= text.size(); ++i) {
+    auto& postings = trigrams_[TrigramKey(p + i)];
+    // 节点按先序递增加入，同一节点重复出现的三元组只记一次，倒排表天然有序
+    if (postings.empty() || postings.back() != entry) postings.push_back(entry);
+  }
+}
+
+std::vector<int> NavigationSearchIndex::Match(const QString& folded) const {
+  std::vector<int> result;
+  auto contains = [&folded](const Entry& e) {
+    return e.name_folded.contains(folded) || e.key_folded.contains(folded);
+  };
+
+  if (folded.size() < 3) {
+    for (int i = 0; i < static_cast<int>(entries_.size()); ++i) {
+      if (contains(entries_[i])) result.push_back(i);
+    }
+    return result;
+  }
+
+  // 收集查询串的全部三元组倒排表，从最短的开始求交集
+  std::vector<const std::vector<int>*> lists;
+  const QChar* p = folded.constData();
+  for (qsizetype i = 0; i + 3 <= folded.size(); ++i) {
+    auto it = trigrams_.find(TrigramKey(p + i));
+    if (it == trigrams_.end()) return result;
+    lists.push_back(&it->second);
+  }
+  std::sort(lists.begin(), lists.end(),
+            [](const auto* a, const auto* b) { return a->size() < b->size(); });
+
+  std::vector<int> candidates = *lists.front();
+  std::vector<int> scratch;
+  for (size_t l = 1; l < lists.size() && !candidates.empty(); ++l) {
+    scratch.clear();
+    std::set_intersection(candidates.begin(), candidates.end(),
+                          lists[l]->begin(), lists[l]->end(),
+                          std::back_inserter(scratch));
+    candidates.swap(scratch);
+  }
+
+  // 三元组可能分属显示名与原始键两段文本，逐个确认真正包含
+  for (int i : candidates) {
+    if (contains(entries_[i])) result.push_back(i);
+  }
+  return result;
+}
+
+std::vector<uint8_t> NavigationSearchIndex::Evaluate(
+    const QString& query, bool is_advanced_mode) const {
+  const int n = static_cast<int>(entries_.size());
+  std::vector<uint8_t> state(n, 0);
+  auto filtered = [&](const Entry& e) {
+    return e.kind == Kind::kItem && e.is_advanced && !is_advanced_mode;
+  };
+
+  const QString folded = query.trimmed().toCaseFolded();
+  if (folded.isEmpty()) {
+    // 无搜索：参数节点只受高级模式控制，分组节点随后按“有无可见子节点”结算
+    for (int i = 0; i < n; ++i) {
+      const Entry& e = entries_[i];
+      if (e.kind == Kind::kItem && !filtered(e)) state[i] = kVisible;
+      if (e.kind == Kind::kOther) state[i] = applied_[i] & kVisible;
+      // 保留展开位，Apply(touch_expansion = false) 不会改动它
+      state[i] |= applied_[i] & kExpanded;
+    }
+  } else {
+    // 命中节点：自身到根全部显示并展开；其子树整体显示 (用差分数组合并重叠区间)
+    std::vector<int> cover(n + 1, 0);
+    for (int m : Match(folded)) {
+      if (filtered(entries_[m])) continue;
+      for (int a = m; a >= 0 && !(state[a] & kExpanded);
+           a = entries_[a].parent) {
+        state[a] |= kVisible | kExpanded;
+      }
+      ++cover[m + 1];
+      --cover[entries_[m].subtree_end];
+    }
+    int depth = 0;
+    for (int i = 0; i < n; ++i) {
+      depth += cover[i];
+      if (depth > 0 && !filtered(entries_[i])) state[i] |= kVisible;
+    }
+  }
+
+  // 清理空壳：先序的逆序保证子节点先于父节点结算，子分组与分组逐级隐藏
+  std::vector<uint8_t> has_visible_child(n, 0);
+  for (int i = n - 1; i >= 0; --i) {
+    const Entry& e = entries_[i];
+    const bool container =
+        e.kind == Kind::kGroup || e.kind == Kind::kSubgroup;
+    // 尚未拉取的二级分组按计数判断是否还有可显示的参数
+    if (is_advanced_mode ? e.lazy_visible > 0 : e.lazy_basic > 0) {
+      has_visible_child[i] = 1;
+    }
+    if (container && folded.isEmpty()) {
+      state[i] = static_cast<uint8_t>((state[i] & kExpanded) |
+                                      (has_visible_child[i] ? kVisible : 0));
+    } else if (container && (state[i] & kVisible) && !has_visible_child[i]) {
+      state[i] &= static_cast<uint8_t>(~kVisible);
+    }
+    if ((state[i] & kVisible) && e.parent >= 0) has_visible_child[e.parent] = 1;
+  }
+  return state;
+}
+
+void NavigationSearchIndex::OnItemExpansionChanged(QTreeWidgetItem* item,
+                                                   bool expanded) {
+  auto it = entry_of_item_.find(item);
+  if (it == entry_of_item_.end() || applied_.empty()) return;
+  uint8_t& bits = applied_[it->second];
+  bits = static_cast<uint8_t>(expanded ? (bits | kExpanded)
+                                       : (bits & ~kExpanded));
+}
+
+void NavigationSearchIndex::Apply(const std::vector<uint8_t>& state,
+                                  bool touch_expansion) {
+  if (state.size() != entries_.size()) return;
+  // 先为将要在展开的父节点下显示、但还没有树节点的参数创建节点 (目录已载入，索引位置不变)
+  std::vector<QTreeWidgetItem*> to_populate;
+  for (size_t i = 0; i < entries_.size(); ++i) {
+    const Entry& e = entries_[i];
+    if (e.item || e.parent < 0 || !(state[i] & kVisible)) continue;
+    const uint8_t parent_bits = touch_expansion ? state[e.parent] : applied_[e.parent];
+    QTreeWidgetItem* parent_item = entries_[e.parent].item;
+    if ((parent_bits & kExpanded) &&
+        (to_populate.empty() || to_populate.back() != parent_item)) {
+      to_populate.push_back(parent_item);
+    }
+  }
+  for (QTreeWidgetItem* subgroup : to_populate) Populate(subgroup);
+  if (state.size() != entries_.size()) return;
+
+  for (size_t i = 0; i < entries_.size(); ++i) {
+    QTreeWidgetItem* item = entries_[i].item;
+    if (!item) continue;
+    const uint8_t diff = state[i] ^ applied_[i];
+    if (diff == 0) continue;
+    if (diff & kVisible) item->setHidden(!(state[i] & kVisible));
+    if (touch_expansion && (diff & kExpanded)) {
+      item->setExpanded(state[i] & kExpanded);
+    }
+    applied_[i] = touch_expansion
+                      ? state[i]
+                      : static_cast<uint8_t>((state[i] & kVisible) |
+                                             (applied_[i] & kExpanded));
+  }
+}
+
+}  // namespace qt_ui
+}  // namespace plugins
+}  // namespace z3y
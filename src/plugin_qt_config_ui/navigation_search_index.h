@@ -0,0 +1,136 @@
+﻿/**
+ * @file navigation_search_index.h
+ * @brief 左侧导航树的全局搜索索引。
+ *
+ * @details
+ * 导航树节点可达数万个，逐键遍历整棵树做大小写无关的 contains 会让每次按键卡顿近一秒。
+ * 本索引在树建好后只扫描一次：
+ * - 把每个节点的显示名与原始键做 case folding，并按三元组 (trigram) 建立倒排表；
+ * - 查询时先求各三元组倒排表的交集，再对候选逐个确认 contains；不足三个字符的查询退化为
+ *   对预先折叠好的字符串做线性扫描 (不再触碰 QTreeWidgetItem)；
+ * - 可见性以“上一次已应用的状态”为基准做差量更新，只对真正变化的节点调用 setHidden / setExpanded。
+ * 树重新加载 (LoadNavigationTree) 时必须重新 Build。
+ *
+ * 【懒加载】树一开始只有分组与二级分组 (来自 IConfigService::GetGroupIndex 的计数)，
+ * 参数节点由本类在二级分组展开时经 Loader 拉取并创建 (Populate)。未填充的二级分组按计数
+ * 结算可见性；第一次搜索前 LoadCatalog 拉取全部参数名建入索引但不创建树节点，
+ * Apply 只为真正要展开显示的二级分组创建节点。
+ */
+
+#pragma once
+#include <QString>
+#include <QTreeWidget>
+#include <QTreeWidgetItem>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+namespace z3y {
+namespace plugins {
+namespace qt_ui {
+
+/**
+ * @class NavigationSearchIndex
+ * @brief 导航树节点的三元组倒排索引 + 差量可见性应用器。
+ */
+class NavigationSearchIndex {
+ public:
+  /** @brief 节点可见性状态位。 */
+  enum StateBits : uint8_t { kVisible = 1, kExpanded = 2 };
+
+  /** @brief 二级分组节点上的数据角色：原始二级分组名、非隐藏参数数、其中的高级参数数。 */
+  static constexpr int kSubgroupKeyRole = Qt::UserRole + 4;
+  static constexpr int kVisibleCountRole = Qt::UserRole + 5;
+  static constexpr int kAdvancedCountRole = Qt::UserRole + 6;
+
+  /** @brief 懒加载二级分组下的一个参数节点。 */
+  struct LazyItem {
+    QString path;
+    QString name;
+    bool is_advanced = false;
+  };
+  /** @brief 拉取一个二级分组节点下的参数 (按显示顺序)。 */
+  using Loader = std::function<std::vector<LazyItem>(const QTreeWidgetItem* subgroup)>;
+
+  /**
+   * @brief 按先序遍历扫描整棵树建立索引，并以当前树状态作为差量基准。
+   * @param loader 带计数角色且尚无子节点的二级分组由它按需填充；为空时不做懒加载。
+   */
+  void Build(QTreeWidget* tree, Loader loader = nullptr);
+
+  /**
+   * @brief 为一个尚未填充的二级分组创建参数节点 (接 QTreeWidget::itemExpanded)。
+   * @return 本次确实创建了节点时返回 true，调用方应重新应用一次当前的过滤状态。
+   */
+  bool Populate(QTreeWidgetItem* subgroup);
+
+  /** @brief 拉取所有未填充二级分组的参数名并建入索引 (只在第一次搜索前做一次，不创建树节点)。 */
+  void LoadCatalog();
+
+  /**
+   * @brief 计算一次查询后每个节点应处的状态 (与旧版逐树遍历的显示规则一致)。
+   * @param query 搜索文本；空串表示“无搜索”，只按高级模式过滤，不改变展开状态。
+   * @param is_advanced_mode 非高级模式下 is_advanced 的参数节点永不显示。
+   * @return 与节点一一对应的 StateBits 数组。
+   */
+  std::vector<uint8_t> Evaluate(const QString& query,
+                                bool is_advanced_mode) const;
+
+  /**
+   * @brief 将 Evaluate 的结果以差量方式写回树。
+   * @details 要显示在已展开父节点下、尚未创建的参数节点会先经 Populate 创建出来。
+   * @param touch_expansion 为 false 时保留节点当前的展开状态 (只更新可见性)。
+   */
+  void Apply(const std::vector<uint8_t>& state, bool touch_expansion);
+
+  /**
+   * @brief 同步树上的展开 / 折叠 (接 QTreeWidget::itemExpanded / itemCollapsed)。
+   * @details 用户手动展开的节点也要记入差量基准，否则下一次 Apply 会误判为“无需改动”。
+   */
+  void OnItemExpansionChanged(QTreeWidgetItem* item, bool expanded);
+
+  /** @brief 已索引的节点数。 */
+  size_t size() const { return entries_.size(); }
+
+ private:
+  enum class Kind : uint8_t { kGroup, kSubgroup, kItem, kOther };
+
+  struct Entry {
+    QTreeWidgetItem* item = nullptr;  ///< 目录中尚未创建树节点的参数为 nullptr
+    int parent = -1;        ///< 父节点下标 (-1 = 顶层)
+    int subtree_end = 0;    ///< 先序遍历中子树的结束位置 [自身, subtree_end)
+    Kind kind = Kind::kOther;
+    bool is_advanced = false;
+    QString name_folded;    ///< 显示名 (case folded)
+    QString key_folded;     ///< UserRole 原始键 (case folded)
+    uint32_t lazy_visible = 0;  ///< 子节点尚未进入索引时的参数数 (二级分组)
+    uint32_t lazy_basic = 0;    ///< 其中的非高级参数数
+  };
+
+  /** @brief 按树的当前结构重排索引，保留已有节点的差量基准。 */
+  void Reindex();
+  void AddNode(QTreeWidgetItem* item, int parent);
+  /** @brief 追加一个尚未创建树节点的参数条目。 */
+  void AddLazyNode(const LazyItem& lazy, int parent);
+  /** @brief 二级分组是否还等着懒加载 (有计数、未填充)。 */
+  static bool IsUnpopulated(const QTreeWidgetItem* item);
+  void IndexText(const QString& text, int entry);
+  /** @brief 返回同时包含 folded 的所有节点下标 (升序)。 */
+  std::vector<int> Match(const QString& folded) const;
+
+  std::vector<Entry> entries_;
+  std::unordered_map<QTreeWidgetItem*, int> entry_of_item_;
+  std::unordered_map<uint64_t, std::vector<int>> trigrams_;
+  std::vector<uint8_t> applied_;  ///< 上一次写回树的状态
+
+  QTreeWidget* tree_ = nullptr;
+  Loader loader_;
+  /** @brief LoadCatalog 拉取的、尚未创建树节点的二级分组内容。 */
+  std::unordered_map<const QTreeWidgetItem*, std::vector<LazyItem>> catalog_;
+  bool catalog_loaded_ = false;
+};
+
+}  // namespace qt_ui
+}  // namespace plugins
+}  // namespace z3y
@@ -0,0 +1,83 @@
+﻿/**
+ * @file page_plan.cpp
+ * @brief 页面构建计划的数据准备实现 (可在任意线程执行)。
+ */
+
+#include "page_plan.h"
+
+#include <QCoreApplication>
+#include <QJsonDocument>
+#include <algorithm>
+
+#include "framework/z3y_service_locator.h"
+#include "qt_utils.h"
+
+namespace z3y {
+namespace plugins {
+namespace qt_ui {
+
+std::shared_ptr<const PagePlan> BuildPagePlan(const QString& group_key) {
+  auto plan = std::make_shared<PagePlan>();
+  plan->group_key = group_key;
+
+  auto config_srv =
+      z3y::GetDefaultService<z3y::interfaces::core::IConfigService>();
+  if (!config_srv) {
+    plan->failed = true;
+    return plan;
+  }
+
+  std::map<std::string, z3y::interfaces::core::ConfigSnapshot> snapshots;
+  try {
+    snapshots = config_srv->GetConfigsByGroup(group_key.toStdString());
+  } catch (...) {
+    plan->failed = true;
+    return plan;
+  }
+
+  // QCoreApplication::translate 本身是线程安全的，这里只查一次
+  const QString general = QCoreApplication::translate(
+      "z3y::plugins::qt_ui::WidgetFactory", "General Attributes");
+
+  plan->items.reserve(snapshots.size());
+  for (auto& [path, snap] : snapshots) {
+    if (snap.meta.is_hidden) continue;
+    PagePlanItem item;
+    item.path = path;
+    item.qpath = QString::fromStdString(path);
+    item.subgroup = snap.meta.subgroup_key.empty()
+                        ? general
+                        : QString::fromStdString(snap.meta.subgroup_key);
+    item.name = QString::fromStdString(snap.meta.name_key);
+    item.tooltip = QString::fromStdString(snap.meta.tooltip_key);
+    item.value = ConvertToQVariant(snap.current_value);
+
+    if (!snap.meta.custom_args.empty()) {
+      QJsonParseError err;
+      QJsonDocument doc = QJsonDocument::fromJson(
+          QString::fromStdString(snap.meta.custom_args).toUtf8(), &err);
+      if (err.error == QJsonParseError::NoError) item.custom_args = doc.object();
+    }
+    if (!snap.meta.enable_condition.empty()) {
+      item.condition_str = QString::fromStdString(snap.meta.enable_condition);
+      item.condition = DependencyGraph::Parse(item.condition_str);
+      plan->has_conditions = true;
+    }
+    if (snap.meta.widget_type == z3y::interfaces::core::WidgetType::kCustom) {
+      plan->has_custom = true;
+    }
+    item.snap = std::move(snap);
+    plan->items.push_back(std::move(item));
+  }
+
+  // snapshots 已按路径有序，稳定排序后即为 "子分组 -> 路径" 的展示顺序
+  std::stable_sort(plan->items.begin(), plan->items.end(),
+                   [](const PagePlanItem& a, const PagePlanItem& b) {
+                     return a.subgroup < b.subgroup;
+                   });
+  return plan;
+}
+
+}  // namespace qt_ui
+}  // namespace plugins
+}  // namespace z3y
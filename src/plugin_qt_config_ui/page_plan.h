@@ -0,0 +1,64 @@
+﻿/**
+ * @file page_plan.h
+ * @brief 配置页面的不可变构建计划：在后台线程准备数据，GUI 线程只负责绑定控件。
+ *
+ * @details
+ * 打开一个分组的开销大头在控件创建之前：GetConfigsByGroup 拷贝快照、ConfigValue 到 QVariant
+ * 的转换、子分组归类排序、翻译查找、custom_args 的 JSON 解析与 enable_condition 的解析。
+ * 这些步骤都不碰 QWidget，BuildPagePlan 把它们收拢成一个只读的 PagePlan，主窗口在线程池里调用它，
+ * 完成后再把计划交给 WidgetFactory 在 GUI 线程上实例化控件。
+ * 计划一经构建不再修改；内部的 QString / QVariant / QJsonObject 都是隐式共享、引用计数原子化的，
+ * 以 shared_ptr<const PagePlan> 跨线程传递是安全的。
+ */
+
+#pragma once
+#include <QJsonObject>
+#include <QString>
+#include <QVariant>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "dependency_graph.h"
+#include "interfaces_core/i_config_service.h"
+
+namespace z3y {
+namespace plugins {
+namespace qt_ui {
+
+/** @brief 页面中的一个参数：快照及其预先算好的界面数据。 */
+struct PagePlanItem {
+  std::string path;
+  QString qpath;
+  QString subgroup;    ///< 已翻译的子分组标题 (空子分组归入 "General Attributes")
+  QString name;
+  QString tooltip;
+  z3y::interfaces::core::ConfigSnapshot snap;
+  QVariant value;            ///< snap.current_value 转换后的 QVariant
+  QJsonObject custom_args;   ///< 解析后的 meta.custom_args，解析失败为空对象
+  QString condition_str;     ///< 原始 enable_condition，为空表示无条件
+  DependencyGraph::ParsedCondition condition;
+};
+
+/** @brief 一个配置分组的构建计划。 */
+struct PagePlan {
+  QString group_key;
+  /** @brief 可见参数 (已剔除隐藏项)，先按子分组、再按路径排序，与页面上的展示顺序一致。 */
+  std::vector<PagePlanItem> items;
+  /** @brief 分组内是否有自定义画板 (需要常驻控件，不能虚拟化)。 */
+  bool has_custom = false;
+  /** @brief 是否有参数带使能条件。 */
+  bool has_conditions = false;
+  /** @brief 服务不可用或读取失败。 */
+  bool failed = false;
+};
+
+/**
+ * @brief 读取并整理一个分组的数据 (线程安全，不创建任何 QObject)。
+ * @return 永不为空；读取失败时 failed 为 true、items 为空。
+ */
+std::shared_ptr<const PagePlan> BuildPagePlan(const QString& group_key);
+
+}  // namespace qt_ui
+}  // namespace plugins
+}  // namespace z3y
@@ -0,0 +1,311 @@
+﻿/**
+ * @file performance_dashboard.cpp
+ * @brief 实时性能面板的采样与绘制实现。
+ */
+
+#include "performance_dashboard.h"
+
+#include <QGridLayout>
+#include <QHeaderView>
+#include <QHideEvent>
+#include <QPainter>
+#include <QPainterPath>
+#include <QShowEvent>
+#include <QVBoxLayout>
+#include <algorithm>
+#include <vector>
+
+#include "framework/z3y_service_locator.h"
+#include "interfaces_core/i_config_service.h"
+#include "interfaces_core/i_log_service.h"
+#include "interfaces_profiler/i_profiler_service.h"
+
+namespace z3y {
+namespace plugins {
+namespace qt_ui {
+
+// ============================================================================
+// MetricSparkline
+// ============================================================================
+
+MetricSparkline::MetricSparkline(const QString& title, const QString& unit,
+                                 double warn_threshold, QWidget* parent)
+    : QWidget(parent),
+      title_(title),
+      unit_(unit),
+      warn_threshold_(warn_threshold) {
+  setMinimumSize(220, 90);
+  setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Fixed);
+}
+
+QSize MetricSparkline::sizeHint() const { return QSize(320, 100); }
+
+void MetricSparkline::AddSample(double value) {
+  available_ = true;
+  samples_.push_back(value);
+  if (samples_.size() > kHistory) samples_.pop_front();
+  update();
+}
+
+void MetricSparkline::SetUnavailable() {
+  available_ = false;
+  samples_.clear();
+  update();
+}
+
+void MetricSparkline::paintEvent(QPaintEvent* event) {
+  Q_UNUSED(event);
+  QPainter p(this);
+  p.setRenderHint(QPainter::Antialiasing);
+  const QRect frame = rect().adjusted(1, 1, -1, -1);
+  p.setPen(QColor("#c0c0c0"));
+  p.setBrush(QColor("#fafafa"));
+  p.drawRoundedRect(frame, 4, 4);
+
+  // 标题行：左边指标名，右边当前值
+  const int header_h = fontMetrics().height() + 6;
+  const QRect header = frame.adjusted(8, 2, -8, 0);
+  p.setPen(palette().color(QPalette::WindowText));
+  p.drawText(header.left(), header.top(), header.width(), header_h,
+             Qt::AlignLeft | Qt::AlignVCenter, title_);
+
+  const bool warn = available_ && !samples_.empty() && warn_threshold_ > 0 &&
+                    samples_.back() > warn_threshold_;
+  const QString current =
+      !available_ ? QStringLiteral("n/a")
+      : samples_.empty()
+          ? QStringLiteral("-")
+          : QString("%1 %2").arg(samples_.back(), 0, 'g', 4).arg(unit_);
+  QFont bold = font();
+  bold.setBold(true);
+  p.setFont(bold);
+  p.setPen(warn ? QColor("#d13438") : palette().color(QPalette::WindowText));
+  p.drawText(header.left(), header.top(), header.width(), header_h,
+             Qt::AlignRight | Qt::AlignVCenter, current);
+  p.setFont(font());
+
+  if (samples_.size() < 2) return;
+
+  // 折线区：纵轴从 0 到 max(历史最大值, 告警阈值)，告警阈值画成虚线
+  const QRectF plot = QRectF(frame).adjusted(8, header_h + 2, -8, -6);
+  double y_max = *std::max_element(samples_.begin(), samples_.end());
+  if (warn_threshold_ > 0) y_max = std::max(y_max, warn_threshold_);
+  if (y_max <= 0) y_max = 1.0;
+
+  const double dx = plot.width() / static_cast<double>(kHistory - 1);
+  const double x0 =
+      plot.right() - dx * static_cast<double>(samples_.size() - 1);
+  auto y_of = [&](double v) {
+    return plot.bottom() - plot.height() * std::clamp(v / y_max, 0.0, 1.0);
+  };
+
+  if (warn_threshold_ > 0) {
+    QPen dash(QColor("#f7a8a8"));
+    dash.setStyle(Qt::DashLine);
+    p.setPen(dash);
+    const double y = y_of(warn_threshold_);
+    p.drawLine(QPointF(plot.left(), y), QPointF(plot.right(), y));
+  }
+
+  QPainterPath path;
+  for (size_t i = 0; i < samples_.size(); ++i) {
+    const QPointF pt(x0 + dx * static_cast<double>(i), y_of(samples_[i]));
+    if (i == 0) path.moveTo(pt);
+    else path.lineTo(pt);
+  }
+  p.setPen(QPen(warn ? QColor("#d13438") : QColor("#0078D7"), 1.5));
+  p.setBrush(Qt::NoBrush);
+  p.drawPath(path);
+}
+
+// ============================================================================
+// PerformanceDashboard
+// ============================================================================
+
+PerformanceDashboard::PerformanceDashboard(QWidget* parent) : QWidget(parent) {
+  QVBoxLayout* layout = new QVBoxLayout(this);
+
+  QGridLayout* grid = new QGridLayout();
+  event_depth_ = new MetricSparkline(tr("Event queue depth"), "", 1000);
+  event_latency_ =
+      new MetricSparkline(tr("Event dispatch latency p99"), "ms", 50);
+  profiler_p99_ = new MetricSparkline(tr("Slowest profiler root p99"), "ms", 0);
+  log_fill_ = new MetricSparkline(tr("Logger queue fill"), "%", 80);
+  log_drops_ = new MetricSparkline(tr("Logger drops"), "/s", 0.5);
+  config_commit_ = new MetricSparkline(tr("Config save latency"), "ms", 200);
+  grid->addWidget(event_depth_, 0, 0);
+  grid->addWidget(event_latency_, 0, 1);
+  grid->addWidget(profiler_p99_, 1, 0);
+  grid->addWidget(config_commit_, 1, 1);
+  grid->addWidget(log_fill_, 2, 0);
+  grid->addWidget(log_drops_, 2, 1);
+  layout->addLayout(grid);
+
+  profiler_table_ = new QTableWidget(0, 5);
+  profiler_table_->setHorizontalHeaderLabels(
+      {tr("Profiler root"), tr("Count"), "p50 (ms)", "p95 (ms)", "p99 (ms)"});
+  profiler_table_->setEditTriggers(QAbstractItemView::NoEditTriggers);
+  profiler_table_->setSelectionMode(QAbstractItemView::NoSelection);
+  profiler_table_->verticalHeader()->setVisible(false);
+  profiler_table_->horizontalHeader()->setSectionResizeMode(
+      0, QHeaderView::Stretch);
+  profiler_table_->setMinimumHeight(160);
+  layout->addWidget(profiler_table_, 1);
+
+  summary_label_ = new QLabel();
+  summary_label_->setStyleSheet("color: gray;");
+  layout->addWidget(summary_label_);
+
+  timer_ = new QTimer(this);
+  timer_->setInterval(kSampleIntervalMs);
+  connect(timer_, &QTimer::timeout, this, &PerformanceDashboard::Sample);
+}
+
+void PerformanceDashboard::showEvent(QShowEvent* event) {
+  QWidget::showEvent(event);
+  if (!timer_->isActive()) {
+    Sample();  // 打开即有数据，不必等第一个周期
+    timer_->start();
+  }
+}
+
+void PerformanceDashboard::hideEvent(QHideEvent* event) {
+  QWidget::hideEvent(event);
+  timer_->stop();
+}
+
+void PerformanceDashboard::Sample() {
+  SampleEventBus();
+  SampleProfiler();
+  SampleLogger();
+  SampleConfig();
+}
+
+void PerformanceDashboard::SampleEventBus() {
+  auto manager = z3y::PluginManager::GetActiveInstance();
+  if (!manager) {
+    event_depth_->SetUnavailable();
+    event_latency_->SetUnavailable();
+    return;
+  }
+  const z3y::EventDispatchMetrics metrics = manager->GetEventDispatchMetrics();
+  event_depth_->AddSample(static_cast<double>(metrics.queue_depth));
+
+  // 直方图是自启动以来的累计值，与上一次采样相减得到最近一秒的分布
+  z3y::LatencyHistogram total;
+  for (const auto& [event_id, hist] : metrics.queue_latency) {
+    for (size_t i = 0; i < z3y::LatencyHistogram::kBuckets; ++i) {
+      total.buckets[i] += hist.buckets[i];
+    }
+    total.count += hist.count;
+    total.total_ns += hist.total_ns;
+    total.max_ns = std::max(total.max_ns, hist.max_ns);
+  }
+  z3y::LatencyHistogram window = total;
+  if (has_last_event_latency_ && total.count >= last_event_latency_.count) {
+    for (size_t i = 0; i < z3y::LatencyHistogram::kBuckets; ++i) {
+      window.buckets[i] -= std::min(window.buckets[i],
+                                    last_event_latency_.buckets[i]);
+    }
+    window.count -= last_event_latency_.count;
+  }
+  last_event_latency_ = total;
+  has_last_event_latency_ = true;
+  event_latency_->AddSample(static_cast<double>(window.PercentileNs(0.99)) /
+                            1e6);
+
+  summary_label_->setText(
+      tr("Event queue high water: %1, dropped tasks: %2, callback exceptions: %3")
+          .arg(metrics.queue_high_water)
+          .arg(metrics.dropped_tasks)
+          .arg(metrics.exceptions));
+}
+
+void PerformanceDashboard::SampleProfiler() {
+  auto [profiler, err] =
+      z3y::TryGetDefaultService<z3y::interfaces::profiler::IProfilerService>();
+  if (err != z3y::InstanceError::kSuccess || !profiler ||
+      !profiler->IsEnabled()) {
+    profiler_p99_->SetUnavailable();
+    profiler_table_->setRowCount(0);
+    return;
+  }
+
+  // 在途快照不清零，与报告周期、指标导出互不干扰
+  struct RootRow {
+    QString name;
+    uint64_t count;
+    double p50, p95, p99;
+  };
+  std::vector<RootRow> rows;
+  for (const auto& report : profiler->SnapshotLiveRoots()) {
+    if (report.nodes.empty()) continue;
+    const auto& root = report.nodes[0];
+    if (!root.has_percentiles || root.count == 0) continue;
+    rows.push_back({QString::fromStdString(root.name), root.count,
+                    root.percentiles[0], root.percentiles[1],
+                    root.percentiles[2]});
+  }
+  std::sort(rows.begin(), rows.end(),
+            [](const RootRow& a, const RootRow& b) { return a.p99 > b.p99; });
+  profiler_p99_->AddSample(rows.empty() ? 0.0 : rows.front().p99);
+
+  const int shown = std::min<int>(static_cast<int>(rows.size()), kMaxProfilerRows);
+  profiler_table_->setRowCount(shown);
+  for (int r = 0; r < shown; ++r) {
+    const RootRow& row = rows[static_cast<size_t>(r)];
+    const QString cells[] = {row.name, QString::number(row.count),
+                             QString::number(row.p50, 'f', 3),
+                             QString::number(row.p95, 'f', 3),
+                             QString::number(row.p99, 'f', 3)};
+    for (int c = 0; c < 5; ++c) {
+      QTableWidgetItem* item = profiler_table_->item(r, c);
+      if (!item) {
+        item = new QTableWidgetItem();
+        profiler_table_->setItem(r, c, item);
+      }
+      item->setText(cells[c]);
+    }
+  }
+}
+
+void PerformanceDashboard::SampleLogger() {
+  auto [log_mgr, err] =
+      z3y::TryGetDefaultService<z3y::interfaces::core::ILogManagerService>();
+  if (err != z3y::InstanceError::kSuccess || !log_mgr) {
+    log_fill_->SetUnavailable();
+    log_drops_->SetUnavailable();
+    return;
+  }
+  const z3y::interfaces::core::LogQueueStats stats = log_mgr->GetQueueStats();
+  if (stats.pools == 0) {
+    log_fill_->SetUnavailable();
+    log_drops_->SetUnavailable();
+    return;
+  }
+  log_fill_->AddSample(stats.capacity ? 100.0 * static_cast<double>(stats.queued) /
+                                            static_cast<double>(stats.capacity)
+                                      : 0.0);
+  const uint64_t dropped = stats.overrun + stats.discarded;
+  const uint64_t delta = (has_last_log_dropped_ && dropped >= last_log_dropped_)
+                             ? dropped - last_log_dropped_
+                             : 0;
+  last_log_dropped_ = dropped;
+  has_last_log_dropped_ = true;
+  log_drops_->AddSample(static_cast<double>(delta) * 1000.0 /
+                        kSampleIntervalMs);
+}
+
+void PerformanceDashboard::SampleConfig() {
+  auto [config_srv, err] =
+      z3y::TryGetDefaultService<z3y::interfaces::core::IConfigService>();
+  if (err != z3y::InstanceError::kSuccess || !config_srv) {
+    config_commit_->SetUnavailable();
+    return;
+  }
+  config_commit_->AddSample(config_srv->GetPersistenceStats().last_commit_ms);
+}
+
+}  // namespace qt_ui
+}  // namespace plugins
+}  // namespace z3y
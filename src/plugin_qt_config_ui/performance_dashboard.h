@@ -0,0 +1,122 @@
+﻿/**
+ * @file performance_dashboard.h
+ * @brief 内置的实时性能面板：低频拉取框架各子系统的运行指标并绘制趋势曲线。
+ *
+ * @details
+ * 现场排查性能退化时不必登录机器看日志。面板每秒采样一次 (只在可见时运行)：
+ * - 事件总线：积压任务数、入队到执行延迟的 p99 (两次采样之间的增量直方图)、丢弃数；
+ * - Profiler：各线程根节点的在途分位数 (SnapshotLiveRoots，不重置数据)；
+ * - 日志：异步队列的占用率与每秒丢弃条数 (ILogManagerService::GetQueueStats)；
+ * - 配置：最近一次落盘提交的耗时 (IConfigService::GetPersistenceStats)。
+ * 这些接口在写侧都只有 relaxed 原子或短暂加锁，低频读取不会干扰业务线程。
+ * 缺少某个服务 (插件未加载) 时对应曲线显示 "n/a"。
+ *
+ * 面板以内置自定义画板 kPerformanceDashboardPanelKey 注册，Schema 中 custom_ui_key
+ * 填这个键即可嵌入任意分组；主窗口工具栏的 "Performance Monitor" 按钮也会以独立窗口打开它。
+ */
+
+#pragma once
+#include <QLabel>
+#include <QString>
+#include <QTableWidget>
+#include <QTimer>
+#include <QWidget>
+#include <cstdint>
+#include <deque>
+
+#include "framework/plugin_manager.h"
+
+namespace z3y {
+namespace plugins {
+namespace qt_ui {
+
+/** @brief 内置性能面板在 custom_panels 中的键。 */
+inline constexpr const char* kPerformanceDashboardPanelKey =
+    "z3y.PerformanceDashboard";
+
+/**
+ * @class MetricSparkline
+ * @brief 一条指标的迷你趋势图：标题、当前值，以及最近 kHistory 个采样的折线。
+ */
+class MetricSparkline : public QWidget {
+  Q_OBJECT
+ public:
+  /** @brief 保留的采样点数 (每秒一点，即最近两分钟)。 */
+  static constexpr size_t kHistory = 120;
+
+  /**
+   * @param title 指标名称。
+   * @param unit 单位后缀 (如 "ms"、"%")。
+   * @param warn_threshold 当前值超过该阈值时曲线转为警示色；<= 0 表示不告警。
+   */
+  MetricSparkline(const QString& title, const QString& unit,
+                  double warn_threshold, QWidget* parent = nullptr);
+
+  /** @brief 追加一个采样点并重绘。 */
+  void AddSample(double value);
+  /** @brief 数据源不可用：清空曲线并显示 "n/a"。 */
+  void SetUnavailable();
+
+  QSize sizeHint() const override;
+
+ protected:
+  void paintEvent(QPaintEvent* event) override;
+
+ private:
+  QString title_;
+  QString unit_;
+  double warn_threshold_;
+  bool available_ = true;
+  std::deque<double> samples_;
+};
+
+/**
+ * @class PerformanceDashboard
+ * @brief 实时性能面板本体：六条趋势曲线 + Profiler 根节点分位数表。
+ */
+class PerformanceDashboard : public QWidget {
+  Q_OBJECT
+ public:
+  /** @brief 采样周期。 */
+  static constexpr int kSampleIntervalMs = 1000;
+  /** @brief 表格中最多列出的 Profiler 根节点数 (按 p99 降序)。 */
+  static constexpr int kMaxProfilerRows = 10;
+
+  explicit PerformanceDashboard(QWidget* parent = nullptr);
+
+ protected:
+  /** @brief 只在面板可见时采样，隐藏或随页面缓存退到后台时停止。 */
+  void showEvent(QShowEvent* event) override;
+  void hideEvent(QHideEvent* event) override;
+
+ private slots:
+  /** @brief 拉取一次全部指标并刷新界面。 */
+  void Sample();
+
+ private:
+  void SampleEventBus();
+  void SampleProfiler();
+  void SampleLogger();
+  void SampleConfig();
+
+  QTimer* timer_;
+  MetricSparkline* event_depth_;
+  MetricSparkline* event_latency_;
+  MetricSparkline* profiler_p99_;
+  MetricSparkline* log_fill_;
+  MetricSparkline* log_drops_;
+  MetricSparkline* config_commit_;
+  QTableWidget* profiler_table_;
+  QLabel* summary_label_;
+
+  /** @brief 上一次采样时各 EventId 入队延迟直方图的合计，用于求两次采样之间的增量。 */
+  z3y::LatencyHistogram last_event_latency_;
+  bool has_last_event_latency_ = false;
+  /** @brief 上一次采样时日志的累计丢弃条数。 */
+  uint64_t last_log_dropped_ = 0;
+  bool has_last_log_dropped_ = false;
+};
+
+}  // namespace qt_ui
+}  // namespace plugins
+}  // namespace z3y
@@ -4,6 +4,9 @@
  */
 
 #pragma once
+#include <QComboBox>
+#include <QJsonObject>
+#include <QJsonValue>
 #include <QVariant>
 #include <QString>
 #include <QVariantList>
@@ -51,6 +54,67 @@ inline QVariant ConvertToQVariant(const z3y::interfaces::core::ConfigValue& val)
       val);
 }
 
+/**
+ * @brief 辅助工具函数：从万能变体 ConfigValue 中安全汲取浮点数。
+ * @details 当我们认定某个参数是浮点型控件(如 DoubleSpinBox) 时，如果底层传了个整数(int64_t)过来，我们在这里强转。
+ * @param val 后端变体。
+ * @param def_val 拿不到或者拿错时的托底保命值。
+ */
+inline double ExtractDouble(const z3y::interfaces::core::ConfigValue& val,
+                            double def_val) {
+  if (std::holds_alternative<double>(val)) return std::get<double>(val);
+  if (std::holds_alternative<int64_t>(val))
+    return static_cast<double>(std::get<int64_t>(val));
+  return def_val;
+}
+
+/**
+ * @brief 辅助工具函数：从万能变体 ConfigValue 中安全汲取大整数。
+ */
+inline int64_t ExtractInt64(const z3y::interfaces::core::ConfigValue& val,
+                            int64_t def_val) {
+  if (std::holds_alternative<int64_t>(val)) return std::get<int64_t>(val);
+  if (std::holds_alternative<double>(val))
+    return static_cast<int64_t>(std::get<double>(val));
+  return def_val;
+}
+
+/**
+ * @brief 辅助工具函数：从附加信息的 JSON 对象中提取浮点属性（如 step, decimals）。
+ */
+inline double ExtractJsonDouble(const QJsonObject& obj, const QString& key,
+                                double def = 0.0) {
+  if (!obj.contains(key)) return def;
+  QJsonValue v = obj[key];
+  if (v.isString()) return v.toString().toDouble();
+  return v.toDouble(def);
+}
+
+/**
+ * @brief 辅助工具函数：从附加信息的 JSON 对象中提取整型属性。
+ */
+inline int ExtractJsonInt(const QJsonObject& obj, const QString& key,
+                          int def = 0) {
+  if (!obj.contains(key)) return def;
+  QJsonValue v = obj[key];
+  if (v.isString()) return v.toString().toInt();
+  return v.toInt(def);
+}
+
+/**
+ * @brief 辅助工具函数：安全地在 QComboBox 列表中寻找对应数值所在的 Index 索引。
+ */
+inline int FindComboIndexSafe(QComboBox* cb, const QVariant& target_val) {
+  int idx = cb->findData(target_val);
+  if (idx != -1) return idx;
+
+  QString target_str = target_val.toString();
+  for (int i = 0; i < cb->count(); ++i) {
+    if (cb->itemData(i).toString() == target_str) return i;
+  }
+  return -1;
+}
+
 }  // namespace qt_ui
 }  // namespace plugins
 }  // namespace z3y
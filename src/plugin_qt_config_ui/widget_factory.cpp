@@ -14,7 +14,6 @@
 #include <QHBoxLayout>
 #include <QHeaderView>
 #include <QJsonArray>
-#include <QJsonDocument>
 #include <QJsonObject>
 #include <QLabel>
 #include <QLineEdit>
@@ -26,15 +25,19 @@
 #include <QScrollArea>
 #include <QSlider>
 #include <QSpinBox>
+#include <QTableView>
 #include <QTableWidget>
 #include <QVBoxLayout>
 #include <algorithm>
 #include <limits>
 #include <variant>
 
+#include "config_page_model.h"
+#include "page_plan.h"
 #include "interfaces_core/i_config_service.h"
 #include "scroll_guard.h"
 #include "qt_utils.h"
+#include "widget_recycle_pool.h"
 
 namespace z3y {
 namespace plugins {
@@ -42,79 +45,30 @@ namespace qt_ui {
 
 namespace {
 
-/**
- * @brief 辅助工具函数：从万能变体 ConfigValue 中安全汲取浮点数。
- * @details 当我们认定某个参数是浮点型控件(如 DoubleSpinBox) 时，如果底层传了个整数(int64_t)过来，我们在这里强转。
- * @param val 后端变体。
- * @param def_val 拿不到或者拿错时的托底保命值。
- */
-double ExtractDouble(const z3y::interfaces::core::ConfigValue& val,
-                     double def_val) {
-  if (std::holds_alternative<double>(val)) return std::get<double>(val);
-  if (std::holds_alternative<int64_t>(val))
-    return static_cast<double>(std::get<int64_t>(val));
-  return def_val;
-}
-
-/**
- * @brief 辅助工具函数：从万能变体 ConfigValue 中安全汲取大整数。
- */
-int64_t ExtractInt64(const z3y::interfaces::core::ConfigValue& val,
-                     int64_t def_val) {
-  if (std::holds_alternative<int64_t>(val)) return std::get<int64_t>(val);
-  if (std::holds_alternative<double>(val))
-    return static_cast<int64_t>(std::get<double>(val));
-  return def_val;
-}
-
-/**
- * @brief 辅助工具函数：从附加信息的 JSON 对象中提取浮点属性（如 step, decimals）。
- */
-double ExtractJsonDouble(const QJsonObject& obj, const QString& key,
-                         double def = 0.0) {
-  if (!obj.contains(key)) return def;
-  QJsonValue v = obj[key];
-  if (v.isString()) return v.toString().toDouble();
-  return v.toDouble(def);
-}
-
-/**
- * @brief 辅助工具函数：从附加信息的 JSON 对象中提取整型属性。
- */
-int ExtractJsonInt(const QJsonObject& obj, const QString& key, int def = 0) {
-  if (!obj.contains(key)) return def;
-  QJsonValue v = obj[key];
-  if (v.isString()) return v.toString().toInt();
-  return v.toInt(def);
-}
-
-/**
- * @brief 辅助工具函数：安全地在 QComboBox 列表中寻找对应数值所在的 Index 索引。
- */
-int FindComboIndexSafe(QComboBox* cb, const QVariant& target_val) {
-  int idx = cb->findData(target_val);
-  if (idx != -1) return idx;
-
-  QString target_str = target_val.toString();
-  for (int i = 0; i < cb->count(); ++i) {
-    if (cb->itemData(i).toString() == target_str) return i;
-  }
-  return -1;
+/** @brief 有回收池时从池中取编辑器，否则新建。 */
+template <typename T>
+T* NewEditor(WidgetRecyclePool* pool) {
+  return pool ? pool->Acquire<T>() : new T();
 }
 
 }  // namespace
 
 QWidget* WidgetFactory::CreatePage(
-    const QString& group_key, const std::string& current_role,
-    DependencyGraph* graph,
+    const PagePlan& plan, DependencyGraph* graph,
     const std::map<std::string, QVariant>& pending_changes,
     QObject* context_obj,
     std::function<void(const QString&, const QVariant&)> on_change_callback,
     bool is_advanced_mode,
     const std::map<std::string,
                    z3y::interfaces::ui::IConfigUIManager::CustomPanelCreator>&
-        custom_panels) {
-  
+        custom_panels,
+    WidgetRecyclePool* widget_pool) {
+  // 0. 参数过多的大分组改走虚拟化表格页面；自定义画板需要常驻控件，只能整页构建
+  if (plan.items.size() >= kVirtualPageThreshold && !plan.has_custom) {
+    return CreateVirtualPage(plan, graph, pending_changes, on_change_callback,
+                             is_advanced_mode);
+  }
+
   // 1. 创建该分组的顶级容器：带滚动条的画板
   QScrollArea* scroll_area = new QScrollArea();
   scroll_area->setWidgetResizable(true);
@@ -123,34 +77,22 @@ QWidget* WidgetFactory::CreatePage(
   QWidget* container = new QWidget();
   QVBoxLayout* main_layout = new QVBoxLayout(container);
 
-  auto config_srv =
-      z3y::GetDefaultService<z3y::interfaces::core::IConfigService>();
-  if (!config_srv) {
+  if (plan.failed) {
     scroll_area->setWidget(container);
     return scroll_area;
   }
 
-  std::map<std::string, z3y::interfaces::core::ConfigSnapshot> snapshots;
-  try {
-    snapshots = config_srv->GetConfigsByGroup(group_key.toStdString());
-  } catch (...) {
-  }
-
-  // 3. 将扁平的一级分组数据，根据 meta.subgroup_key 二次分类合并，准备打包装入各个 GroupBox
-  std::map<std::string,
-           std::vector<
-               std::pair<std::string, z3y::interfaces::core::ConfigSnapshot>>>
-      grouped_snaps;
-  for (const auto& [path, snap] : snapshots) {
-    if (snap.meta.is_hidden) continue;
-    std::string subg = snap.meta.subgroup_key.empty() ? QCoreApplication::translate("z3y::plugins::qt_ui::WidgetFactory", "General Attributes").toStdString()
-                                                      : snap.meta.subgroup_key;
-    grouped_snaps[subg].push_back({path, snap});
-  }
+  // 3. 计划中的参数已按子分组排好序，相邻的同名子分组即为一个 GroupBox
+  const std::vector<PagePlanItem>& items = plan.items;
+  for (size_t group_begin = 0; group_begin < items.size();) {
+    size_t group_end = group_begin;
+    while (group_end < items.size() &&
+           items[group_end].subgroup == items[group_begin].subgroup) {
+      ++group_end;
+    }
 
-  // 4. 遍历所有二级分组，生成带边框和标题的 QGroupBox 控件组
-  for (const auto& [subg_name, items] : grouped_snaps) {
-    QGroupBox* group_box = new QGroupBox(QString::fromStdString(subg_name));
+    // 4. 为每个二级分组生成带边框和标题的 QGroupBox 控件组
+    QGroupBox* group_box = new QGroupBox(items[group_begin].subgroup);
     group_box->setStyleSheet(
         "QGroupBox { font-weight: bold; border: 1px solid #c0c0c0; "
         "border-radius: 5px; margin-top: 1ex; padding: 10px; } "
@@ -175,26 +117,23 @@ QWidget* WidgetFactory::CreatePage(
     std::vector<std::function<void()>> resets_actions;
 
     // 5. 核心循环：将数据快照转换成真实可见的 Qt Widget
-    for (const auto& [path, snap] : items) {
-      const QString qpath = QString::fromStdString(path);
+    for (size_t item_idx = group_begin; item_idx < group_end; ++item_idx) {
+      const PagePlanItem& item = items[item_idx];
+      const z3y::interfaces::core::ConfigSnapshot& snap = item.snap;
+      const QString& qpath = item.qpath;
       QWidget* control = nullptr;
       QVariant display_val;
       bool has_pending = false;
 
       // 看看这个参数是否正处于“挂起状态”（用户刚改过还没 Apply）
-      auto it_pending = pending_changes.find(path);
+      auto it_pending = pending_changes.find(item.path);
       if (it_pending != pending_changes.end()) {
         display_val = it_pending->second;
         has_pending = true;
       }
 
-      QJsonObject custom_args;
-      if (!snap.meta.custom_args.empty()) {
-        QJsonParseError err;
-        QJsonDocument doc = QJsonDocument::fromJson(
-            QString::fromStdString(snap.meta.custom_args).toUtf8(), &err);
-        if (err.error == QJsonParseError::NoError) custom_args = doc.object();
-      }
+      // custom_args 与 enable_condition 已在后台线程解析好 (见 page_plan.h)
+      const QJsonObject& custom_args = item.custom_args;
 
       // ==== 5.1 解析 Schema 的 widget_type 进行控件动态实例化 ==== 
       
@@ -262,7 +201,7 @@ QWidget* WidgetFactory::CreatePage(
                  z3y::interfaces::core::WidgetType::kSlider) {
         // [滑动条型]：细分为精细浮点数旋转盒，或者纯粹的整数滑块
         if (std::holds_alternative<double>(snap.current_value)) {
-          QDoubleSpinBox* dspin = new QDoubleSpinBox();
+          QDoubleSpinBox* dspin = NewEditor<QDoubleSpinBox>(widget_pool);
           dspin->setDecimals(ExtractJsonInt(custom_args, "decimals", 6));
           dspin->setMinimum(ExtractDouble(snap.meta.min_val, std::numeric_limits<int>::min()));
           dspin->setMaximum(ExtractDouble(snap.meta.max_val, std::numeric_limits<int>::max()));
@@ -279,7 +218,8 @@ QWidget* WidgetFactory::CreatePage(
           }
           control = dspin;
         } else if (std::holds_alternative<int64_t>(snap.current_value)) {
-          QSlider* slider = new QSlider(Qt::Horizontal);
+          QSlider* slider = NewEditor<QSlider>(widget_pool);
+          slider->setOrientation(Qt::Horizontal);
           slider->setMinimum(
               std::clamp<int64_t>(ExtractInt64(snap.meta.min_val, std::numeric_limits<int>::min()),
                                   std::numeric_limits<int>::min(),
@@ -311,7 +251,7 @@ QWidget* WidgetFactory::CreatePage(
                  z3y::interfaces::core::WidgetType::kPasswordInput) {
         // [密码屏蔽框]
         if (!std::holds_alternative<std::string>(snap.current_value)) continue;
-        QLineEdit* pwd_edit = new QLineEdit();
+        QLineEdit* pwd_edit = NewEditor<QLineEdit>(widget_pool);
         pwd_edit->setEchoMode(QLineEdit::Password);
         pwd_edit->setText(has_pending
                               ? display_val.toString()
@@ -339,7 +279,7 @@ QWidget* WidgetFactory::CreatePage(
       } else if (snap.meta.widget_type ==
                  z3y::interfaces::core::WidgetType::kComboBox) {
         // [下拉枚举字典]
-        QComboBox* combo = new QComboBox();
+        QComboBox* combo = NewEditor<QComboBox>(widget_pool);
         for (size_t i = 0; i < snap.meta.enum_display_keys.size(); ++i) {
           QVariant real_data =
               (i < snap.meta.enum_values.size())
@@ -389,7 +329,7 @@ QWidget* WidgetFactory::CreatePage(
                                       : std::get<int64_t>(snap.current_value);
         // 如果整数大得超出了 Qt 控件的承受极限，转而使用 QLineEdit 防爆
         if (act_val > 9007199254740991LL || act_val < -9007199254740991LL) {
-          QLineEdit* line_edit = new QLineEdit();
+          QLineEdit* line_edit = NewEditor<QLineEdit>(widget_pool);
           line_edit->setText(QString::number(act_val));
           line_edit->setValidator(new QRegularExpressionValidator(
               QRegularExpression("^-?\\d{1,19}$"), line_edit));
@@ -404,7 +344,7 @@ QWidget* WidgetFactory::CreatePage(
           }
           control = line_edit;
         } else {
-          QDoubleSpinBox* spin = new QDoubleSpinBox();
+          QDoubleSpinBox* spin = NewEditor<QDoubleSpinBox>(widget_pool);
           spin->setDecimals(0); // 伪装成整数调节器
           spin->setMinimum(ExtractDouble(snap.meta.min_val, -9e15));
           spin->setMaximum(ExtractDouble(snap.meta.max_val, 9e15));
@@ -422,7 +362,7 @@ QWidget* WidgetFactory::CreatePage(
         }
       } else if (std::holds_alternative<double>(snap.current_value)) {
         // [缺省分支：推导为浮点型 QDoubleSpinBox]
-        QDoubleSpinBox* dspin = new QDoubleSpinBox();
+        QDoubleSpinBox* dspin = NewEditor<QDoubleSpinBox>(widget_pool);
         dspin->setDecimals(ExtractJsonInt(custom_args, "decimals", 6));
         dspin->setMinimum(ExtractDouble(snap.meta.min_val, -9e15));
         dspin->setMaximum(ExtractDouble(snap.meta.max_val, 9e15));
@@ -452,7 +392,7 @@ QWidget* WidgetFactory::CreatePage(
         control = check;
       } else if (std::holds_alternative<std::string>(snap.current_value)) {
         // [缺省分支：推导为字符串输入框]
-        QLineEdit* line_edit = new QLineEdit();
+        QLineEdit* line_edit = NewEditor<QLineEdit>(widget_pool);
         line_edit->setText(has_pending
                                ? display_val.toString()
                                : QString::fromStdString(std::get<std::string>(
@@ -588,17 +528,16 @@ QWidget* WidgetFactory::CreatePage(
         control->setProperty("is_advanced", snap.meta.is_advanced);
 
         // [条件管控挂载]
-        if (!snap.meta.enable_condition.empty()) {
-          QString cond_str = QString::fromStdString(snap.meta.enable_condition);
-          control->setProperty("enable_condition", cond_str);
-          static const QRegularExpression re(
-              "^(!?)([\\w\\.]+)(?:\\s*(==|!=|>|<|>=|<=)\\s*(.*))?$");
-          QRegularExpressionMatch match = re.match(cond_str);
-          if (match.hasMatch()) {
-            if (graph)
-              graph->AddDependency(qpath.toStdString(),
-                                   match.captured(2).toStdString(), control);
-          }
+        if (!item.condition_str.isEmpty()) {
+          control->setProperty("enable_condition", item.condition_str);
+          // 条件已预先解析，图谱只需驻留路径，之后的求值不再解析字符串
+          if (graph) graph->AddDependency(item.path, item.condition, control);
+        }
+
+        // [监视参数] 只读展示，数值由 MonitorPoller 按刷新率拉取 (进度条本就不可编辑)
+        if (snap.meta.is_monitor && item.condition_str.isEmpty() &&
+            !qobject_cast<QProgressBar*>(control)) {
+          control->setEnabled(false);
         }
 
         // [防护] 为这个控件戴上套套，防止滚轮乱切改变数值
@@ -609,17 +548,20 @@ QWidget* WidgetFactory::CreatePage(
         if (has_pending)
           control->setStyleSheet("font-weight: bold; color: #b35900;");
         else
-          control->setToolTip(QString::fromStdString(snap.meta.tooltip_key));
+          control->setToolTip(item.tooltip);
 
         // 像表单一样左右布局，左边标题，右边是这个刚刚做出来的控件
-        form_layout->addRow(QString::fromStdString(snap.meta.name_key),
-                            control);
+        form_layout->addRow(item.name, control);
 
         // 如果权限不够或者需要勾选高级模式，就先让它隐形
         if (snap.meta.is_advanced && !is_advanced_mode) {
           control->setVisible(false);
           QWidget* label = form_layout->labelForField(control);
           if (label) label->setVisible(false);
+        } else if (control->property(WidgetRecyclePool::kPooledProperty)
+                       .toBool()) {
+          // 回收的控件脱离旧页面时被隐藏过，需显式恢复可见
+          control->setVisible(true);
         }
 
         // 【重置按钮绑定逻辑】：组装一个闭包，把它塞到 resets_actions 列表里
@@ -710,6 +652,7 @@ QWidget* WidgetFactory::CreatePage(
                      });
 
     main_layout->addWidget(group_box);
+    group_begin = group_end;
   }
 
   // 画板的最下面用弹簧撑起来，保持紧凑排版
@@ -718,6 +661,68 @@ QWidget* WidgetFactory::CreatePage(
   return scroll_area;
 }
 
+QWidget* WidgetFactory::CreateVirtualPage(
+    const PagePlan& plan,
+    const DependencyGraph* graph,
+    const std::map<std::string, QVariant>& pending_changes,
+    std::function<void(const QString&, const QVariant&)> on_change_callback,
+    bool is_advanced_mode) {
+  QWidget* page = new QWidget();
+  QVBoxLayout* page_layout = new QVBoxLayout(page);
+
+  // 1. 顶部的 “[↺] Reset Data”：作用于选中行，没有选中时作用于整页
+  QHBoxLayout* header_layout = new QHBoxLayout();
+  header_layout->addStretch();
+  QPushButton* btn_reset = new QPushButton(QCoreApplication::translate(
+      "z3y::plugins::qt_ui::WidgetFactory", "[↺] Reset Data"));
+  btn_reset->setToolTip(
+      "将选中的参数 (未选中时为本页全部参数) 刷回系统底层预设的安全值 "
+      "(需要点击 Apply 才会实质落地)。");
+  header_layout->addWidget(btn_reset);
+  page_layout->addLayout(header_layout);
+
+  // 2. 表格视图：固定行高，视图只需按行号换算位置，不必逐行测量内容
+  QTableView* view = new QTableView();
+  ConfigPageModel* model =
+      new ConfigPageModel(plan, &pending_changes, graph,
+                          std::move(on_change_callback), is_advanced_mode, view);
+  view->setModel(model);
+  view->setItemDelegateForColumn(ConfigPageModel::kColumnValue,
+                                 new ConfigValueDelegate(view));
+  view->setSelectionBehavior(QAbstractItemView::SelectRows);
+  view->setEditTriggers(QAbstractItemView::DoubleClicked |
+                        QAbstractItemView::SelectedClicked |
+                        QAbstractItemView::EditKeyPressed |
+                        QAbstractItemView::AnyKeyPressed);
+  view->setAlternatingRowColors(true);
+  view->setWordWrap(false);
+  view->verticalHeader()->setVisible(false);
+  view->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+  view->verticalHeader()->setDefaultSectionSize(
+      view->fontMetrics().height() + 10);
+  view->horizontalHeader()->setSectionResizeMode(QHeaderView::Interactive);
+  view->horizontalHeader()->setStretchLastSection(true);
+  view->setColumnWidth(ConfigPageModel::kColumnSubgroup, 180);
+  view->setColumnWidth(ConfigPageModel::kColumnName, 280);
+  page_layout->addWidget(view, 1);
+
+  QPointer<QTableView> safe_view(view);
+  QObject::connect(btn_reset, &QPushButton::clicked, view, [safe_view, model]() {
+    if (!safe_view) return;
+    std::vector<int> rows;
+    for (const QModelIndex& idx : safe_view->selectionModel()->selectedRows()) {
+      rows.push_back(idx.row());
+    }
+    if (rows.empty()) {
+      rows.resize(static_cast<size_t>(model->rowCount()));
+      for (int i = 0; i < model->rowCount(); ++i) rows[i] = i;
+    }
+    model->ResetRowsToDefault(rows);
+  });
+
+  return page;
+}
+
 }  // namespace qt_ui
 }  // namespace plugins
 }  // namespace z3y
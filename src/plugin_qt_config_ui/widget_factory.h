@@ -5,6 +5,7 @@
  * @details
  * 属于 UI 数据驱动引擎 (Data-Driven UI Engine) 的核心部位。
  * 解析诸如 WidgetType::kSlider 等 Schema 枚举，动态生成对应的 QSlider，绑定信号，排版入组。
+ * 输入是后台线程准备好的 PagePlan (见 page_plan.h)，这里只做必须在 GUI 线程完成的控件实例化与绑定。
  */
 
 #pragma once
@@ -16,6 +17,9 @@
 #include <string>
 
 #include "dependency_graph.h"
+#include "page_plan.h"
+#include "widget_recycle_pool.h"
+#include "interfaces_core/i_config_service.h"
 #include "interfaces_ui/i_config_ui_manager.h"
 
 namespace z3y {
@@ -28,29 +32,48 @@ namespace qt_ui {
  */
 class WidgetFactory {
  public:
+  /**
+   * @brief 可见参数达到该数量 (且分组内没有自定义画板) 时改用虚拟化页面。
+   * @details 虚拟化页面只为正在编辑的那一行创建编辑器，见 config_page_model.h。
+   */
+  static constexpr size_t kVirtualPageThreshold = 200;
+
   /**
    * @brief 自动为一个完整的配置大类（如 "Network"）生成一整个排版好的 QScrollArea 容器页面。
    *
-   * @param group_key 需要渲染的大类名称（由底层 Schema 提供支持）。
-   * @param current_role 现在的用户权限角色（用于剪除无权查看的行）。
+   * @param plan 由 BuildPagePlan 准备好的分组数据 (快照、排序、翻译、解析后的条件)。
    * @param graph 指向依赖图谱的指针，构建出的新控件如果带有条件，会被挂载到图谱上。
    * @param pending_changes 当前还悬而未决的修改池，如果某个控件在这个池里有值，它会以这个值作为优先级最高的值呈现，并且显示高亮橙边。
    * @param context_obj Qt 对象槽系统所需的生命周期从属对象（通常传主窗口）。
    * @param on_change_callback 核心注入：当控件被用户拉动/输入导致改变时，该向谁汇报。
    * @param is_advanced_mode 用户当前是否已经打开了高级模式（以显示那些 is_advanced=true 的硬核选项）。
    * @param custom_panels 第三方提供的高级逃生舱自定义画板列表。
+   * @param widget_pool 可选的控件回收池：SpinBox / ComboBox / Slider / 文本框优先从池中取，
+   * 页面淘汰时由调用方经 WidgetRecyclePool::Harvest 归还。
    * @return QWidget* 返回构建完成的根界面，通常里面已经包含了滚动条、各种分组框（GroupBox）以及网格排版。
+   * 大分组返回 CreateVirtualPage 生成的表格页面。
    */
   static QWidget* CreatePage(
-      const QString& group_key, const std::string& current_role,
-      DependencyGraph* graph,
+      const PagePlan& plan, DependencyGraph* graph,
       const std::map<std::string, QVariant>& pending_changes,
       QObject* context_obj,
       std::function<void(const QString&, const QVariant&)> on_change_callback,
       bool is_advanced_mode,
       const std::map<std::string,
                      z3y::interfaces::ui::IConfigUIManager::CustomPanelCreator>&
-          custom_panels);
+          custom_panels,
+      WidgetRecyclePool* widget_pool = nullptr);
+
+  /**
+   * @brief 生成虚拟化页面：一个 QTableView + ConfigPageModel，不为参数常驻控件。
+   * @details 页面内可通过 findChild<ConfigPageModel*>() 取到模型。pending_changes
+   * 以指针形式被模型长期引用，调用方须保证其生命周期长于页面。
+   */
+  static QWidget* CreateVirtualPage(
+      const PagePlan& plan, const DependencyGraph* graph,
+      const std::map<std::string, QVariant>& pending_changes,
+      std::function<void(const QString&, const QVariant&)> on_change_callback,
+      bool is_advanced_mode);
 };
 
 }  // namespace qt_ui
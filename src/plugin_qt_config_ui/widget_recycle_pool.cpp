@@ -0,0 +1,88 @@
+﻿/**
+ * @file widget_recycle_pool.cpp
+ * @brief 编辑器控件回收池的实现。
+ */
+
+#include "widget_recycle_pool.h"
+
+#include <QSignalBlocker>
+#include <QValidator>
+
+#include "scroll_guard.h"
+
+namespace z3y {
+namespace plugins {
+namespace qt_ui {
+
+WidgetRecyclePool::~WidgetRecyclePool() {
+  // 空闲控件没有父对象，只能由池自己释放
+  qDeleteAll(spin_boxes_);
+  qDeleteAll(combo_boxes_);
+  qDeleteAll(sliders_);
+  qDeleteAll(line_edits_);
+}
+
+template <typename T>
+void WidgetRecyclePool::Recycle(T* widget) {
+  QSignalBlocker blocker(widget);
+  // 脱离页面 (布局会随 ChildRemoved 事件移除对应的表单项)
+  widget->setParent(nullptr);
+
+  std::vector<T*>& idle = IdleOf<T>();
+  if (idle.size() >= kMaxIdlePerType) {
+    widget->deleteLater();
+    return;
+  }
+
+  widget->setStyleSheet(QString());
+  widget->setToolTip(QString());
+  widget->setObjectName(QString());
+  widget->setProperty("config_path", QVariant());
+  widget->setProperty("is_advanced", QVariant());
+  widget->setProperty("enable_condition", QVariant());
+  widget->setEnabled(true);
+
+  if constexpr (std::is_same_v<T, QComboBox>) {
+    widget->clear();
+  } else if constexpr (std::is_same_v<T, QLineEdit>) {
+    widget->setValidator(nullptr);
+    qDeleteAll(widget->findChildren<QValidator*>(QString(),
+                                                  Qt::FindDirectChildrenOnly));
+    widget->setEchoMode(QLineEdit::Normal);
+    widget->clear();
+  }
+  // QDoubleSpinBox / QSlider 的范围、步长与数值由工厂在复用时全部重设
+  idle.push_back(widget);
+}
+
+void WidgetRecyclePool::Harvest(QWidget* page, DependencyGraph* graph) {
+  if (!page) return;
+  // 先收集再拆：拆下的控件会从 page 的子对象树中消失
+  const QList<QWidget*> children = page->findChildren<QWidget*>();
+  std::vector<QWidget*> pooled;
+  for (QWidget* child : children) {
+    if (child->property(kPooledProperty).toBool()) pooled.push_back(child);
+  }
+
+  for (QWidget* widget : pooled) {
+    if (graph) graph->RemoveDependency(widget);
+    // 断开控件发出的全部信号：旧页面的回调闭包捕获的是旧路径
+    QObject::disconnect(widget, nullptr, nullptr, nullptr);
+    qDeleteAll(widget->findChildren<ScrollGuardFilter*>(
+        QString(), Qt::FindDirectChildrenOnly));
+
+    if (auto* spin = qobject_cast<QDoubleSpinBox*>(widget)) {
+      Recycle(spin);
+    } else if (auto* combo = qobject_cast<QComboBox*>(widget)) {
+      Recycle(combo);
+    } else if (auto* slider = qobject_cast<QSlider*>(widget)) {
+      Recycle(slider);
+    } else if (auto* line = qobject_cast<QLineEdit*>(widget)) {
+      Recycle(line);
+    }
+  }
+}
+
+}  // namespace qt_ui
+}  // namespace plugins
+}  // namespace z3y
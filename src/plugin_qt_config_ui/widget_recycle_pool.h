@@ -0,0 +1,108 @@
+﻿/**
+ * @file widget_recycle_pool.h
+ * @brief 整页模式编辑器控件的回收池：页面被 LRU 淘汰时回收控件，重建页面时复用。
+ *
+ * @details
+ * 在十几个大分组之间来回切换时，每次淘汰都会销毁上千个 SpinBox / ComboBox，重新打开又要
+ * 重新构造。回收池按类型保存脱离页面的空闲控件，WidgetFactory 取出后只需重设范围与数值、
+ * 重新连接信号，页面切换的耗时主要剩下数值绑定。
+ * - 只回收经 Acquire 取出的控件 (带 kPooledProperty 标记)；自定义画板和复合控件内部的子控件不动。
+ * - 回收时断开控件发出的全部信号、删除其 ScrollGuardFilter 与校验器、从依赖图谱摘除，
+ * 清掉样式、提示与 config_path 等属性，并清空类型相关的状态 (下拉项、文本、回显模式)。
+ * - 只在 GUI 线程使用。
+ */
+
+#pragma once
+#include <QComboBox>
+#include <QDoubleSpinBox>
+#include <QLineEdit>
+#include <QSlider>
+#include <QWidget>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+#include "dependency_graph.h"
+
+namespace z3y {
+namespace plugins {
+namespace qt_ui {
+
+/**
+ * @class WidgetRecyclePool
+ * @brief QDoubleSpinBox / QComboBox / QSlider / QLineEdit 的分类型空闲栈。
+ */
+class WidgetRecyclePool {
+ public:
+  /** @brief 每种控件最多保留的空闲数量，超出部分直接销毁。 */
+  static constexpr size_t kMaxIdlePerType = 1024;
+  /** @brief 标记“由回收池发放”的动态属性名。 */
+  static constexpr const char* kPooledProperty = "z3y_pooled";
+
+  WidgetRecyclePool() = default;
+  ~WidgetRecyclePool();
+
+  WidgetRecyclePool(const WidgetRecyclePool&) = delete;
+  WidgetRecyclePool& operator=(const WidgetRecyclePool&) = delete;
+
+  /**
+   * @brief 取一个空闲控件，没有时新建。
+   * @details 返回的控件没有父对象、没有信号连接，调用方负责设置范围 / 数值后再连接信号。
+   */
+  template <typename T>
+  T* Acquire() {
+    std::vector<T*>& idle = IdleOf<T>();
+    T* widget = nullptr;
+    if (!idle.empty()) {
+      widget = idle.back();
+      idle.pop_back();
+    } else {
+      widget = new T();
+      widget->setProperty(kPooledProperty, true);
+    }
+    return widget;
+  }
+
+  /**
+   * @brief 回收页面中所有由本池发放的控件 (在页面被销毁之前调用)。
+   * @param page 即将被销毁的页面。
+   * @param graph 依赖图谱，回收的控件从中摘除，避免条件结算落到复用后的控件上。
+   */
+  void Harvest(QWidget* page, DependencyGraph* graph);
+
+  /** @brief 当前空闲的控件总数。 */
+  size_t IdleCount() const {
+    return spin_boxes_.size() + combo_boxes_.size() + sliders_.size() +
+           line_edits_.size();
+  }
+
+ private:
+  template <typename T>
+  std::vector<T*>& IdleOf() {
+    if constexpr (std::is_same_v<T, QDoubleSpinBox>) {
+      return spin_boxes_;
+    } else if constexpr (std::is_same_v<T, QComboBox>) {
+      return combo_boxes_;
+    } else if constexpr (std::is_same_v<T, QSlider>) {
+      return sliders_;
+    } else {
+      static_assert(std::is_same_v<T, QLineEdit>,
+                    "WidgetRecyclePool only pools QDoubleSpinBox, QComboBox, "
+                    "QSlider and QLineEdit");
+      return line_edits_;
+    }
+  }
+
+  /** @brief 清空一个已脱离页面的控件并放回对应的空闲栈 (满了则销毁)。 */
+  template <typename T>
+  void Recycle(T* widget);
+
+  std::vector<QDoubleSpinBox*> spin_boxes_;
+  std::vector<QComboBox*> combo_boxes_;
+  std::vector<QSlider*> sliders_;
+  std::vector<QLineEdit*> line_edits_;
+};
+
+}  // namespace qt_ui
+}  // namespace plugins
+}  // namespace z3y
@@ -0,0 +1,246 @@
+﻿/*
+ * Copyright [2025] [Yue Liu]
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file coalescing_file_sink.cpp
+ * @brief coalescing_file_sink 的实现。
+ */
+
+#include "coalescing_file_sink.h"
+
+#include <spdlog/common.h>
+
+#include <algorithm>
+#include <system_error>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace z3y {
+namespace plugins {
+namespace log {
+
+namespace fs = std::filesystem;
+
+namespace {
+constexpr size_t kPageSize = 4096;
+}  // namespace
+
+/** @brief 追加写入的文件句柄。Windows 上走 overlapped I/O，偏移自行维护。 */
+class coalescing_file_sink::File {
+ public:
+  explicit File(const fs::path& path) {
+#ifdef _WIN32
+    handle_ = ::CreateFileW(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_DELETE,
+                            nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED,
+                            nullptr);
+    if (handle_ == INVALID_HANDLE_VALUE) Fail(path, static_cast<int>(::GetLastError()));
+    LARGE_INTEGER size{};
+    ::GetFileSizeEx(handle_, &size);
+    offset_ = static_cast<uint64_t>(size.QuadPart);
+    event_ = ::CreateEventW(nullptr, TRUE, FALSE, nullptr);
+#else
+    fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd_ < 0) Fail(path, errno);
+    offset_ = static_cast<uint64_t>(::lseek(fd_, 0, SEEK_END));
+#endif
+  }
+
+  ~File() {
+#ifdef _WIN32
+    if (event_) ::CloseHandle(event_);
+    ::CloseHandle(handle_);
+#else
+    ::close(fd_);
+#endif
+  }
+
+  File(const File&) = delete;
+  File& operator=(const File&) = delete;
+
+  uint64_t size() const { return offset_; }
+
+  /** @brief 写入整块，返回是否成功。 */
+  bool Write(const char* data, size_t size) {
+    while (size > 0) {
+#ifdef _WIN32
+      OVERLAPPED overlapped{};
+      overlapped.Offset = static_cast<DWORD>(offset_);
+      overlapped.OffsetHigh = static_cast<DWORD>(offset_ >> 32);
+      overlapped.hEvent = event_;
+      const DWORD chunk = static_cast<DWORD>(std::min<size_t>(size, 1u << 30));
+      DWORD written = 0;
+      if (!::WriteFile(handle_, data, chunk, nullptr, &overlapped) &&
+          ::GetLastError() != ERROR_IO_PENDING) {
+        return false;
+      }
+      if (!::GetOverlappedResult(handle_, &overlapped, &written, TRUE)) return false;
+#else
+      const ssize_t written = ::write(fd_, data, size);
+      if (written < 0) {
+        if (errno == EINTR) continue;
+        return false;
+      }
+#endif
+      data += written;
+      size -= static_cast<size_t>(written);
+      offset_ += static_cast<uint64_t>(written);
+    }
+    return true;
+  }
+
+ private:
+  [[noreturn]] static void Fail(const fs::path& path, int code) {
+    spdlog::throw_spdlog_ex("coalescing_file_sink: cannot open '" + path.string() + "'",
+                            code);
+  }
+
+  uint64_t offset_ = 0;
+#ifdef _WIN32
+  HANDLE handle_ = INVALID_HANDLE_VALUE;
+  HANDLE event_ = nullptr;
+#else
+  int fd_ = -1;
+#endif
+};
+
+coalescing_file_sink::coalescing_file_sink(fs::path base_path, size_t max_size,
+                                           size_t max_files, size_t buffer_size)
+    : base_path_(std::move(base_path)),
+      max_size_(max_size),
+      max_files_(std::max<size_t>(max_files, 1)),
+      buffer_size_((std::max<size_t>(buffer_size, 1) + kPageSize - 1) / kPageSize * kPageSize) {
+  std::error_code ec;
+  if (base_path_.has_parent_path()) fs::create_directories(base_path_.parent_path(), ec);
+  // 与 rotating_file_sink 一致：续写已有的活动文件
+  file_ = std::make_unique<File>(base_path_);
+  current_size_ = static_cast<size_t>(file_->size());
+  front_.reserve(buffer_size_);
+  back_.reserve(buffer_size_);
+  thread_ = std::thread([this] { Run(); });
+}
+
+coalescing_file_sink::~coalescing_file_sink() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Submit(false);
+  }
+  {
+    std::unique_lock<std::mutex> lock(io_mutex_);
+    WaitIdle(lock);
+    stop_ = true;
+  }
+  io_cv_.notify_all();
+  thread_.join();
+}
+
+fs::path coalescing_file_sink::archive_path(size_t index) const {
+  // app.log -> app.<index>.log
+  fs::path name = base_path_.stem();
+  name += "." + std::to_string(index);
+  name += base_path_.extension();
+  return base_path_.parent_path() / name;
+}
+
+void coalescing_file_sink::sink_it_(const spdlog::details::log_msg& msg) {
+  spdlog::memory_buf_t formatted;
+  formatter_->format(msg, formatted);
+  if (max_size_ > 0 && current_size_ > 0 && current_size_ + formatted.size() > max_size_) {
+    Submit(true);
+    current_size_ = 0;
+  }
+  if (!front_.empty() && front_.size() + formatted.size() > buffer_size_) Submit(false);
+  front_.append(formatted.data(), formatted.size());
+  current_size_ += formatted.size();
+  if (front_.size() >= buffer_size_) Submit(false);
+}
+
+void coalescing_file_sink::flush_() {
+  Submit(false);
+  std::unique_lock<std::mutex> lock(io_mutex_);
+  WaitIdle(lock);
+}
+
+void coalescing_file_sink::Submit(bool roll_after) {
+  if (front_.empty() && !roll_after) return;
+  {
+    std::unique_lock<std::mutex> lock(io_mutex_);
+    if (busy_) {
+      stalls_.fetch_add(1, std::memory_order_relaxed);
+      WaitIdle(lock);
+    }
+    front_.swap(back_);
+    busy_ = true;
+    roll_after_ = roll_after;
+  }
+  io_cv_.notify_all();
+  front_.clear();
+}
+
+void coalescing_file_sink::WaitIdle(std::unique_lock<std::mutex>& lock) {
+  io_cv_.wait(lock, [this] { return !busy_; });
+}
+
+void coalescing_file_sink::Run() {
+  std::unique_lock<std::mutex> lock(io_mutex_);
+  for (;;) {
+    io_cv_.wait(lock, [this] { return stop_ || busy_; });
+    if (!busy_) return;
+    const bool roll = roll_after_;
+    // back_ 在 busy_ 期间只归 I/O 线程，写盘时不持锁
+    lock.unlock();
+    if (!back_.empty()) {
+      if (file_ && file_->Write(back_.data(), back_.size())) {
+        writes_.fetch_add(1, std::memory_order_relaxed);
+      } else {
+        write_errors_.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+    if (roll) Roll();
+    lock.lock();
+    back_.clear();
+    busy_ = false;
+    io_cv_.notify_all();
+  }
+}
+
+void coalescing_file_sink::Roll() {
+  file_.reset();
+  std::error_code ec;
+  fs::remove(archive_path(max_files_), ec);
+  for (size_t i = max_files_; i > 1; --i) {
+    fs::rename(archive_path(i - 1), archive_path(i), ec);
+  }
+  fs::rename(base_path_, archive_path(1), ec);
+  try {
+    file_ = std::make_unique<File>(base_path_);
+  } catch (const spdlog::spdlog_ex&) {
+    // 打不开新文件：后续块计入 write_errors，下一次轮转再重试
+  }
+}
+
+}  // namespace log
+}  // namespace plugins
+}  // namespace z3y
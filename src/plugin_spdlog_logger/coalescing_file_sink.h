@@ -0,0 +1,118 @@
+﻿/*
+ * Copyright [2025] [Yue Liu]
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file coalescing_file_sink.h
+ * @brief [内部] 合并写入的轮转文件 Sink (type: "coalescing_file_sink")。
+ *
+ * @details
+ * [设计]
+ * 1. **合并**: 格式化结果追加到前台缓冲 (buffer_kb，按 4KB 取整)，攒满一整块才提交一次写入，
+ * 不再每条消息一次 fwrite。Flush (含 flush_every 定时刷盘) 时把不足一块的部分也提交。
+ * 2. **双缓冲**: 提交即与后台缓冲交换，写盘由专属 I/O 线程完成，格式化线程只在
+ * 上一块仍未写完时等待 (计入 stalls)。
+ * 3. **写盘**: Windows 以 FILE_FLAG_OVERLAPPED 打开，按偏移投递 WriteFile 并等待完成；
+ * 其它平台由 I/O 线程 write()。
+ * 4. **轮转**: 与 rotating_file_sink 相同的 max_size / max_files；需要轮转的块带标记，
+ * I/O 线程写完该块后改名 (app.log -> app.1.log …) 并重新打开，顺序与提交一致。
+ */
+
+#pragma once
+
+#ifndef Z3Y_PLUGIN_SPDLOG_COALESCING_FILE_SINK_H_
+#define Z3Y_PLUGIN_SPDLOG_COALESCING_FILE_SINK_H_
+
+#include <spdlog/sinks/base_sink.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace z3y {
+namespace plugins {
+namespace log {
+
+class coalescing_file_sink final : public spdlog::sinks::base_sink<std::mutex> {
+ public:
+  /**
+   * @param base_path 活动文件路径，如 logs/app.log。
+   * @param max_size 每个文件的字节数上限，0 = 不轮转。
+   * @param max_files 保留的历史文件数。
+   * @param buffer_size 每个缓冲的字节数 (按 4KB 取整)。
+   * @throws spdlog::spdlog_ex 无法打开文件时。
+   */
+  coalescing_file_sink(std::filesystem::path base_path, size_t max_size, size_t max_files,
+                       size_t buffer_size);
+  ~coalescing_file_sink() override;
+
+  /** @brief 第 index 个历史文件的路径 (1 为最新)。 */
+  std::filesystem::path archive_path(size_t index) const;
+
+  /** @brief 已提交的写入次数 (每次一整块或 Flush 时的剩余部分)。 */
+  uint64_t writes() const { return writes_.load(std::memory_order_relaxed); }
+  /** @brief 格式化线程等待上一块写完的次数。 */
+  uint64_t stalls() const { return stalls_.load(std::memory_order_relaxed); }
+  /** @brief 写盘失败的次数 (失败的块被丢弃)。 */
+  uint64_t write_errors() const { return write_errors_.load(std::memory_order_relaxed); }
+
+ protected:
+  void sink_it_(const spdlog::details::log_msg& msg) override;
+  void flush_() override;
+
+ private:
+  class File;
+
+  /** @brief 前台缓冲交给 I/O 线程 (调用方持有 base_sink::mutex_)。 */
+  void Submit(bool roll_after);
+  /** @brief 等待 I/O 线程写完手上的块。 */
+  void WaitIdle(std::unique_lock<std::mutex>& lock);
+  void Run();
+  void Roll();
+
+  const std::filesystem::path base_path_;
+  const size_t max_size_;
+  const size_t max_files_;
+  const size_t buffer_size_;
+
+  // 格式化线程状态 (受 base_sink::mutex_ 保护)
+  std::string front_;
+  size_t current_size_ = 0;  ///< 当前文件已提交 + 前台缓冲中的字节数
+
+  // 与 I/O 线程交接
+  std::mutex io_mutex_;
+  std::condition_variable io_cv_;
+  std::string back_;
+  bool busy_ = false;        ///< back_ 已交给 I/O 线程且尚未写完
+  bool roll_after_ = false;  ///< 写完 back_ 后轮转
+  bool stop_ = false;
+
+  std::unique_ptr<File> file_;  ///< 仅 I/O 线程在启动后访问
+  std::atomic<uint64_t> writes_{0};
+  std::atomic<uint64_t> stalls_{0};
+  std::atomic<uint64_t> write_errors_{0};
+  std::thread thread_;  ///< 最后初始化，Run 启动时其它成员已就绪
+};
+
+}  // namespace log
+}  // namespace plugins
+}  // namespace z3y
+
+#endif  // Z3Y_PLUGIN_SPDLOG_COALESCING_FILE_SINK_H_
@@ -0,0 +1,299 @@
+﻿/*
+ * Copyright [2025] [Yue Liu]
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file compressed_rotating_file_sink.cpp
+ * @brief compressed_rotating_file_sink 的实现。
+ */
+
+#include "compressed_rotating_file_sink.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <system_error>
+#include <thread>
+#include <utility>
+
+#include "lz4_frame.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace z3y {
+namespace plugins {
+namespace log {
+
+namespace fs = std::filesystem;
+
+/** @brief 低优先级后台线程：按提交顺序执行任务，并按 CPU 预算节流。 */
+class compressed_rotating_file_sink::Worker {
+ public:
+  // 积压超过此数量时不再休眠 (每个任务最多持有 64KB 数据)
+  static constexpr size_t kMaxThrottledBacklog = 64;
+
+  explicit Worker(uint32_t cpu_percent)
+      : cpu_percent_(std::clamp<uint32_t>(cpu_percent, 1, 100)),
+        thread_([this] { Run(); }) {}
+
+  ~Worker() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    cv_.notify_all();
+    thread_.join();  // 退出前执行完所有已提交的任务
+  }
+
+  void Post(std::function<void()> job) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      jobs_.push_back(std::move(job));
+    }
+    cv_.notify_one();
+  }
+
+  /** @brief 在任务内部调用：刚忙了 busy，按 CPU 预算休眠。 */
+  void Throttle(std::chrono::steady_clock::duration busy) {
+    if (cpu_percent_ >= 100) return;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (stop_ || jobs_.size() > kMaxThrottledBacklog) return;
+    }
+    std::this_thread::sleep_for(busy * (100 - cpu_percent_) / cpu_percent_);
+  }
+
+ private:
+  void Run() {
+#ifdef _WIN32
+    ::SetThreadPriority(::GetCurrentThread(), THREAD_PRIORITY_LOWEST);
+#else
+    // Linux 上 who = 0 只作用于调用线程
+    ::setpriority(PRIO_PROCESS, 0, 10);
+#endif
+    for (;;) {
+      std::function<void()> job;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this] { return stop_ || !jobs_.empty(); });
+        if (jobs_.empty()) return;
+        job = std::move(jobs_.front());
+        jobs_.pop_front();
+      }
+      try {
+        job();  // 压缩任务在每个块之后自行调用 Throttle
+      } catch (...) {
+        // 磁盘错误等不能杀掉后台线程；该段的归档会缺失
+      }
+    }
+  }
+
+  const uint32_t cpu_percent_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<std::function<void()>> jobs_;
+  bool stop_ = false;
+  std::thread thread_;  ///< 最后初始化，Run 启动时其它成员已就绪
+};
+
+compressed_rotating_file_sink::compressed_rotating_file_sink(
+    fs::path base_path, size_t max_size, size_t max_files,
+    const Lz4CompressionOptions& options)
+    : base_path_(std::move(base_path)),
+      max_size_(std::max<size_t>(max_size, 1)),
+      max_files_(std::max<size_t>(max_files, 1)),
+      options_{std::clamp(options.level, lz4::kMinLevel, lz4::kMaxLevel),
+               options.compress_active, options.cpu_percent},
+      worker_(std::make_unique<Worker>(options.cpu_percent)) {
+  std::error_code ec;
+  if (base_path_.has_parent_path()) fs::create_directories(base_path_.parent_path(), ec);
+
+  if (options_.compress_active) {
+    // 上次运行留下的活动帧先归档 (异常退出时可能缺少 EndMark)
+    if (fs::exists(active_path(), ec)) {
+      worker_->Post([this] {
+        ShiftArchives();
+        std::error_code rename_ec;
+        fs::rename(active_path(), archive_path(1), rename_ec);
+      });
+    }
+  } else {
+    // 与 rotating_file_sink 一致：续写已有的活动文件
+    file_.open(base_path_.native(), false);
+    current_size_ = file_.size();
+  }
+}
+
+compressed_rotating_file_sink::~compressed_rotating_file_sink() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (options_.compress_active) {
+    PostBlock(std::move(block_));
+    worker_->Post([this] { CloseActiveFrame(); });
+  } else {
+    file_.close();
+  }
+  worker_.reset();
+}
+
+fs::path compressed_rotating_file_sink::archive_path(size_t index) const {
+  // app.log -> app.<index>.log.lz4
+  fs::path name = base_path_.stem();
+  name += "." + std::to_string(index);
+  name += base_path_.extension();
+  name += ".lz4";
+  return base_path_.parent_path() / name;
+}
+
+fs::path compressed_rotating_file_sink::active_path() const {
+  if (!options_.compress_active) return base_path_;
+  fs::path path = base_path_;
+  path += ".lz4";
+  return path;
+}
+
+void compressed_rotating_file_sink::sink_it_(const spdlog::details::log_msg& msg) {
+  spdlog::memory_buf_t formatted;
+  formatter_->format(msg, formatted);
+  if (current_size_ > 0 && current_size_ + formatted.size() > max_size_) Roll();
+
+  if (options_.compress_active) {
+    block_.append(formatted.data(), formatted.size());
+    while (block_.size() >= lz4::kBlockSize) {
+      PostBlock(block_.substr(0, lz4::kBlockSize));
+      block_.erase(0, lz4::kBlockSize);
+    }
+  } else {
+    file_.write(formatted);
+  }
+  current_size_ += formatted.size();
+}
+
+void compressed_rotating_file_sink::flush_() {
+  if (options_.compress_active) {
+    // 不足一块的数据也压缩写出，崩溃时最多丢失尚未被后台线程处理的部分
+    PostBlock(std::move(block_));
+    block_.clear();
+    worker_->Post([this] {
+      if (active_frame_.is_open()) active_frame_.flush();
+    });
+  } else {
+    file_.flush();
+  }
+}
+
+void compressed_rotating_file_sink::Roll() {
+  current_size_ = 0;
+  if (options_.compress_active) {
+    PostBlock(std::move(block_));
+    block_.clear();
+    worker_->Post([this] {
+      CloseActiveFrame();
+      ShiftArchives();
+      std::error_code ec;
+      fs::rename(active_path(), archive_path(1), ec);
+    });
+    return;
+  }
+
+  // 明文段改名为临时文件后立即换新，压缩在后台线程上进行
+  file_.close();
+  fs::path pending = base_path_;
+  pending += "." + std::to_string(++pending_counter_) + ".pending";
+  std::error_code ec;
+  fs::rename(base_path_, pending, ec);
+  file_.open(base_path_.native(), true);
+  if (ec) return;  // 改名失败 (例如被其它进程占用)：本段直接被覆盖，不产生归档
+  worker_->Post([this, pending] {
+    ShiftArchives();
+    CompressFile(pending, archive_path(1));
+    std::error_code remove_ec;
+    fs::remove(pending, remove_ec);
+  });
+}
+
+void compressed_rotating_file_sink::PostBlock(std::string block) {
+  if (block.empty()) return;
+  worker_->Post([this, block = std::move(block)] { WriteActiveBlock(block); });
+}
+
+void compressed_rotating_file_sink::ShiftArchives() {
+  std::error_code ec;
+  fs::remove(archive_path(max_files_), ec);
+  for (size_t i = max_files_; i-- > 1;) {
+    fs::rename(archive_path(i), archive_path(i + 1), ec);
+  }
+}
+
+void compressed_rotating_file_sink::CompressFile(const fs::path& source,
+                                                 const fs::path& target) {
+  std::ifstream in(source, std::ios::binary);
+  if (!in) return;
+  fs::path temp = target;
+  temp += ".tmp";
+  std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+  if (!out) return;
+
+  std::string chunk(lz4::kBlockSize, '\0');
+  std::string encoded = lz4::FrameHeader();
+  for (;;) {
+    const auto start = std::chrono::steady_clock::now();
+    in.read(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+    const auto n = static_cast<size_t>(in.gcount());
+    if (n == 0) break;
+    lz4::AppendFrameBlock(chunk.data(), n, options_.level, encoded, scratch_);
+    out.write(encoded.data(), static_cast<std::streamsize>(encoded.size()));
+    encoded.clear();
+    worker_->Throttle(std::chrono::steady_clock::now() - start);
+  }
+  encoded += lz4::FrameEnd();
+  out.write(encoded.data(), static_cast<std::streamsize>(encoded.size()));
+  out.close();
+  // 写完后整体改名，归档文件要么不存在要么完整
+  std::error_code ec;
+  if (out) fs::rename(temp, target, ec);
+  if (!out || ec) fs::remove(temp, ec);
+}
+
+void compressed_rotating_file_sink::WriteActiveBlock(const std::string& block) {
+  const auto start = std::chrono::steady_clock::now();
+  std::string encoded;
+  if (!active_frame_.is_open()) {
+    active_frame_.open(active_path(), std::ios::binary | std::ios::trunc);
+    encoded = lz4::FrameHeader();
+  }
+  lz4::AppendFrameBlock(block.data(), block.size(), options_.level, encoded, scratch_);
+  active_frame_.write(encoded.data(), static_cast<std::streamsize>(encoded.size()));
+  worker_->Throttle(std::chrono::steady_clock::now() - start);
+}
+
+void compressed_rotating_file_sink::CloseActiveFrame() {
+  if (!active_frame_.is_open()) return;
+  const std::string end = lz4::FrameEnd();
+  active_frame_.write(end.data(), static_cast<std::streamsize>(end.size()));
+  active_frame_.close();
+}
+
+}  // namespace log
+}  // namespace plugins
+}  // namespace z3y
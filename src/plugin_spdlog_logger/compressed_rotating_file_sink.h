@@ -0,0 +1,118 @@
+﻿/*
+ * Copyright [2025] [Yue Liu]
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file compressed_rotating_file_sink.h
+ * @brief [内部] 按大小轮转并用 LZ4 压缩归档的文件 Sink
+ * (rotating_file_sink + "compression": "lz4")。
+ *
+ * @details
+ * [设计]
+ * 1. **归档压缩** (默认): 活动文件 `app.log` 仍是明文；写满 max_size 后改名为临时文件
+ * 立即换新，压缩交给后台线程，生成 `app.1.log.lz4` … `app.N.log.lz4` (N = max_files)。
+ * 2. **活动段流式压缩** (compress_active): 活动文件直接是 LZ4 帧 `app.log.lz4`，
+ * 消息攒满 64KB 块后由后台线程压缩追加；Flush 时把不足一块的数据也写出。
+ * max_size 按未压缩字节计。
+ * 3. **后台线程**: 降低线程优先级，按 cpu_percent 在每个块之后休眠 (忙 t 则睡
+ * t * (100 - p) / p)；积压过多时暂停休眠，避免内存无限增长。
+ * 所有文件操作 (压缩、改名、删除) 都在该线程上按提交顺序执行。
+ */
+
+#pragma once
+
+#ifndef Z3Y_PLUGIN_SPDLOG_COMPRESSED_ROTATING_FILE_SINK_H_
+#define Z3Y_PLUGIN_SPDLOG_COMPRESSED_ROTATING_FILE_SINK_H_
+
+#include <spdlog/details/file_helper.h>
+#include <spdlog/sinks/base_sink.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace z3y {
+namespace plugins {
+namespace log {
+
+/** @brief 压缩参数 (配置项 compression_level / compress_active / compression_cpu_percent)。 */
+struct Lz4CompressionOptions {
+  int level = 5;                 ///< 1 (最快) ~ 9 (压缩率最好)
+  bool compress_active = false;  ///< 活动段也写成 LZ4 帧
+  uint32_t cpu_percent = 25;     ///< 后台线程的 CPU 占用上限 (1 ~ 100)
+};
+
+class compressed_rotating_file_sink final
+    : public spdlog::sinks::base_sink<std::mutex> {
+ public:
+  /**
+   * @param base_path 活动文件路径，如 logs/app.log。
+   * @param max_size 每个段的未压缩字节数上限。
+   * @param max_files 保留的压缩归档数。
+   */
+  compressed_rotating_file_sink(std::filesystem::path base_path, size_t max_size,
+                                size_t max_files,
+                                const Lz4CompressionOptions& options);
+  ~compressed_rotating_file_sink() override;
+
+  /** @brief 第 index 个归档的路径 (1 为最新)。 */
+  std::filesystem::path archive_path(size_t index) const;
+  /** @brief 活动文件路径 (compress_active 时带 .lz4 后缀)。 */
+  std::filesystem::path active_path() const;
+
+ protected:
+  void sink_it_(const spdlog::details::log_msg& msg) override;
+  void flush_() override;
+
+ private:
+  class Worker;
+
+  void Roll();
+  void PostBlock(std::string block);
+
+  // 以下在后台线程上执行
+  void ShiftArchives();
+  void CompressFile(const std::filesystem::path& source,
+                    const std::filesystem::path& target);
+  void WriteActiveBlock(const std::string& block);
+  void CloseActiveFrame();
+
+  const std::filesystem::path base_path_;
+  const size_t max_size_;
+  const size_t max_files_;
+  const Lz4CompressionOptions options_;
+
+  // 写入线程状态 (受 base_sink::mutex_ 保护)
+  spdlog::details::file_helper file_;  ///< 明文活动文件 (归档压缩模式)
+  std::string block_;                  ///< 未满 64KB 的待压缩数据 (流式模式)
+  size_t current_size_ = 0;
+  uint64_t pending_counter_ = 0;
+
+  // 后台线程状态
+  std::ofstream active_frame_;
+  std::vector<char> scratch_;
+
+  std::unique_ptr<Worker> worker_;  ///< 最后声明：析构时最先停止
+};
+
+}  // namespace log
+}  // namespace plugins
+}  // namespace z3y
+
+#endif  // Z3Y_PLUGIN_SPDLOG_COMPRESSED_ROTATING_FILE_SINK_H_
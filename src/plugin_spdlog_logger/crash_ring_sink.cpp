@@ -0,0 +1,391 @@
+﻿/*
+ * Copyright [2025] [Yue Liu]
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file crash_ring_sink.cpp
+ * @brief crash_ring_sink 的实现：环形写入、崩溃标记处理函数与启动恢复。
+ */
+
+#include "crash_ring_sink.h"
+
+#include <spdlog/common.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string_view>
+#include <unordered_map>
+
+#include "mapped_file.h"
+#include "mmap_binary_format.h"
+#include "structured_log_context.h"
+
+#ifndef _WIN32
+#include <signal.h>
+#include <time.h>
+#endif
+
+namespace z3y {
+namespace plugins {
+namespace log {
+
+namespace {
+
+using binlog::FileHeader;
+using binlog::RecordHeader;
+using binlog::RecordType;
+
+constexpr char kRingMagic[8] = {'Z', '3', 'Y', 'R', 'I', 'N', 'G', '1'};
+constexpr uint32_t kRingVersion = 1;
+constexpr uint8_t kPadRecord = 0xFF;     ///< 环尾的填充记录
+constexpr size_t kMaxNameLength = 1024;  ///< 内联名字的截断长度
+
+/** @brief 环文件头的状态。 */
+enum class RingState : uint32_t {
+  kClean = 0,    ///< 正常关闭
+  kRunning = 1,  ///< 进程运行中 (下次启动仍为此值说明进程未正常关闭)
+  kCrashed = 2,  ///< 崩溃处理函数已标记
+};
+
+/**
+ * @brief 环文件头，之后是 capacity 字节的数据区。
+ * head / tail 为累计字节数，数据区内的偏移为 % capacity；记录不跨越环尾。
+ */
+struct RingHeader {
+  char magic[8];         ///< kRingMagic
+  uint32_t version;      ///< kRingVersion
+  uint32_t header_size;  ///< sizeof(RingHeader)
+  uint64_t capacity;     ///< 数据区字节数 (8 字节对齐)
+  uint64_t head;         ///< 已提交的写入位置
+  uint64_t tail;         ///< 最旧完整记录的位置
+  int64_t created_ns;    ///< 环创建时间 (Unix 纪元纳秒)
+  uint32_t state;        ///< RingState
+  int32_t signal;        ///< 崩溃处理函数记录的信号 / 异常码
+  int64_t crash_ns;      ///< 崩溃处理函数记录的时间
+};
+static_assert(sizeof(RingHeader) == 64, "RingHeader layout is part of the file format");
+
+int64_t ToUnixNanos(spdlog::log_clock::time_point tp) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(tp.time_since_epoch())
+      .count();
+}
+
+/** @brief 当前安装了崩溃处理函数的环 (同一时刻至多一个)。 */
+std::atomic<RingHeader*> g_crash_ring{nullptr};
+
+/** @brief 在文件头写下崩溃标记。只做普通内存写入，可在信号处理函数中调用。 */
+void MarkCrashed(int signal_number) {
+  RingHeader* header = g_crash_ring.load(std::memory_order_acquire);
+  if (!header) return;
+#ifdef _WIN32
+  const int64_t now = ToUnixNanos(spdlog::log_clock::now());
+#else
+  timespec ts{};
+  ::clock_gettime(CLOCK_REALTIME, &ts);
+  const int64_t now = static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+#endif
+  header->signal = signal_number;
+  header->crash_ns = now;
+  std::atomic_signal_fence(std::memory_order_release);
+  header->state = static_cast<uint32_t>(RingState::kCrashed);
+}
+
+#ifdef _WIN32
+LPTOP_LEVEL_EXCEPTION_FILTER g_previous_filter = nullptr;
+
+LONG WINAPI OnUnhandledException(EXCEPTION_POINTERS* info) {
+  MarkCrashed(static_cast<int>(info->ExceptionRecord->ExceptionCode));
+  return g_previous_filter ? g_previous_filter(info) : EXCEPTION_CONTINUE_SEARCH;
+}
+
+bool InstallCrashHandler() {
+  g_previous_filter = ::SetUnhandledExceptionFilter(&OnUnhandledException);
+  return true;
+}
+
+void UninstallCrashHandler() { ::SetUnhandledExceptionFilter(g_previous_filter); }
+#else
+constexpr int kCrashSignals[] = {SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT};
+struct sigaction g_previous_actions[std::size(kCrashSignals)];
+
+void RestorePreviousActions() {
+  for (size_t i = 0; i < std::size(kCrashSignals); ++i) {
+    ::sigaction(kCrashSignals[i], &g_previous_actions[i], nullptr);
+  }
+}
+
+void OnCrashSignal(int signal_number, siginfo_t*, void*) {
+  MarkCrashed(signal_number);
+  // 交还原处置后重新发出：信号在处理期间被屏蔽，返回后按原处置 (默认为终止) 送达
+  RestorePreviousActions();
+  ::raise(signal_number);
+}
+
+bool InstallCrashHandler() {
+  struct sigaction action {};
+  action.sa_sigaction = &OnCrashSignal;
+  action.sa_flags = SA_SIGINFO;
+  sigemptyset(&action.sa_mask);
+  for (size_t i = 0; i < std::size(kCrashSignals); ++i) {
+    if (::sigaction(kCrashSignals[i], &action, &g_previous_actions[i]) != 0) {
+      for (size_t j = 0; j < i; ++j) {
+        ::sigaction(kCrashSignals[j], &g_previous_actions[j], nullptr);
+      }
+      return false;
+    }
+  }
+  return true;
+}
+
+void UninstallCrashHandler() { RestorePreviousActions(); }
+#endif
+
+/** @brief 向恢复出的段追加一条记录 (布局同 mmap_binary_sink::Append)。 */
+void AppendRecord(std::string& segment, RecordType type, uint8_t level, uint16_t name_id,
+                  int64_t time_ns, uint64_t thread_id, std::string_view payload,
+                  std::string_view fields = {}) {
+  RecordHeader header{};
+  header.type = static_cast<uint8_t>(type);
+  header.level = level;
+  header.name_id = name_id;
+  header.payload_len = static_cast<uint32_t>(payload.size());
+  header.fields_len = static_cast<uint32_t>(fields.size());
+  header.time_ns = time_ns;
+  header.thread_id = thread_id;
+  header.size = binlog::RecordSize(header.payload_len + header.fields_len);
+  const size_t offset = segment.size();
+  segment.resize(offset + header.size, '\0');
+  std::memcpy(&segment[offset], &header, sizeof(header));
+  std::memcpy(&segment[offset + sizeof(header)], payload.data(), payload.size());
+  if (!fields.empty()) {
+    std::memcpy(&segment[offset + sizeof(header) + payload.size()], fields.data(),
+                fields.size());
+  }
+}
+
+}  // namespace
+
+crash_ring_sink::crash_ring_sink(std::filesystem::path path, size_t size,
+                                 bool install_crash_handler)
+    : path_(std::move(path)), size_(std::max(size, kMinSize) & ~size_t{7}) {
+  std::error_code ec;
+  if (path_.has_parent_path()) std::filesystem::create_directories(path_.parent_path(), ec);
+  Recover();
+
+  mapping_ = std::make_unique<MappedFile>(path_, size_, "crash_ring_sink");
+  capacity_ = size_ - sizeof(RingHeader);
+  auto* header = reinterpret_cast<RingHeader*>(mapping_->data());
+  std::memcpy(header->magic, kRingMagic, sizeof(header->magic));
+  header->version = kRingVersion;
+  header->header_size = static_cast<uint32_t>(sizeof(RingHeader));
+  header->capacity = capacity_;
+  header->created_ns = ToUnixNanos(spdlog::log_clock::now());
+  header->state = static_cast<uint32_t>(RingState::kRunning);
+
+  if (install_crash_handler) {
+    RingHeader* expected = nullptr;
+    if (g_crash_ring.compare_exchange_strong(expected, header)) {
+      handler_installed_ = InstallCrashHandler();
+      if (!handler_installed_) g_crash_ring.store(nullptr);
+    }
+  }
+}
+
+crash_ring_sink::~crash_ring_sink() {
+  if (handler_installed_) {
+    UninstallCrashHandler();
+    g_crash_ring.store(nullptr);
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto* header = reinterpret_cast<RingHeader*>(mapping_->data());
+  header->state = static_cast<uint32_t>(RingState::kClean);
+  mapping_->FlushAsync();
+  mapping_.reset();
+}
+
+void crash_ring_sink::Recover() {
+  std::error_code ec;
+  if (!std::filesystem::exists(path_, ec)) return;
+  std::string bytes;
+  {
+    std::ifstream in(path_, std::ios::binary);
+    bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+  }
+  RingHeader ring{};
+  if (bytes.size() < sizeof(RingHeader)) return;
+  std::memcpy(&ring, bytes.data(), sizeof(ring));
+  if (std::memcmp(ring.magic, kRingMagic, sizeof(kRingMagic)) != 0 ||
+      ring.version != kRingVersion || ring.header_size != sizeof(RingHeader) ||
+      ring.capacity > bytes.size() - sizeof(RingHeader) || ring.capacity % 8 != 0 ||
+      ring.head < ring.tail || ring.head - ring.tail > ring.capacity) {
+    recovery_.error = "unrecognized ring file";
+    return;
+  }
+  if (ring.state == static_cast<uint32_t>(RingState::kClean)) return;
+  const bool crashed = ring.state == static_cast<uint32_t>(RingState::kCrashed);
+  if (crashed) recovery_.signal = ring.signal;
+
+  std::string segment(sizeof(FileHeader), '\0');
+  std::unordered_map<std::string_view, uint16_t> names;
+  auto name_id = [&](std::string_view name, int64_t time_ns) {
+    auto it = names.find(name);
+    if (it != names.end()) return it->second;
+    const auto id = static_cast<uint16_t>(names.size());
+    AppendRecord(segment, RecordType::kName, 0, id, time_ns, 0, name);
+    names.emplace(name, id);
+    return id;
+  };
+
+  const char* data = bytes.data() + sizeof(RingHeader);
+  int64_t last_ns = ring.created_ns;
+  for (uint64_t p = ring.tail; p < ring.head;) {
+    const uint64_t pos = p % ring.capacity;
+    const uint64_t remaining = ring.capacity - pos;
+    if (remaining < sizeof(RecordHeader)) {
+      p += remaining;
+      continue;
+    }
+    RecordHeader record;
+    std::memcpy(&record, data + pos, sizeof(record));
+    if (record.size == 0 || record.size > remaining || p + record.size > ring.head) break;
+    if (record.type == static_cast<uint8_t>(RecordType::kLog)) {
+      if (record.name_id > record.payload_len ||
+          record.size < binlog::RecordSize(record.payload_len + record.fields_len)) {
+        break;
+      }
+      const char* body = data + pos + sizeof(RecordHeader);
+      const std::string_view name(body, record.name_id);
+      const std::string_view message(body + record.name_id,
+                                     record.payload_len - record.name_id);
+      const std::string_view fields(body + record.payload_len, record.fields_len);
+      AppendRecord(segment, RecordType::kLog, record.level, name_id(name, record.time_ns),
+                   record.time_ns, record.thread_id, message, fields);
+      last_ns = record.time_ns;
+      ++recovery_.records;
+    }
+    p += record.size;
+  }
+
+  // 末尾附一条说明，解码时可见上次运行是如何结束的
+  const std::string note =
+      crashed ? "previous run terminated by signal " + std::to_string(ring.signal)
+              : std::string("previous run ended without a clean shutdown");
+  const int64_t note_ns = crashed && ring.crash_ns > 0 ? ring.crash_ns : last_ns;
+  AppendRecord(segment, RecordType::kLog, static_cast<uint8_t>(spdlog::level::critical),
+               name_id("crash_ring", note_ns), note_ns, 0, note);
+
+  FileHeader file{};
+  std::memcpy(file.magic, binlog::kFileMagic, sizeof(file.magic));
+  file.version = binlog::kFormatVersion;
+  file.header_size = static_cast<uint32_t>(sizeof(FileHeader));
+  file.segment_size = segment.size();
+  file.created_ns = ring.created_ns;
+  file.used_bytes = segment.size();
+  std::memcpy(&segment[0], &file, sizeof(file));
+
+  const auto now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                          spdlog::log_clock::now().time_since_epoch())
+                          .count();
+  const std::filesystem::path directory =
+      path_.has_parent_path() ? path_.parent_path() : std::filesystem::path(".");
+  recovery_.path = directory / (path_.stem().string() + ".crash-" +
+                                std::to_string(now_ms) + ".blog");
+  std::ofstream out(recovery_.path, std::ios::binary | std::ios::trunc);
+  out.write(segment.data(), static_cast<std::streamsize>(segment.size()));
+  if (!out) {
+    recovery_.error = "failed to write '" + recovery_.path.string() + "'";
+    recovery_.records = 0;
+  }
+}
+
+void crash_ring_sink::Reserve(uint64_t bytes) {
+  const char* data = mapping_->data() + sizeof(RingHeader);
+  while (head_ + bytes - tail_ > capacity_) {
+    const uint64_t pos = tail_ % capacity_;
+    const uint64_t remaining = capacity_ - pos;
+    uint32_t size = 0;
+    if (remaining >= sizeof(RecordHeader)) std::memcpy(&size, data + pos, sizeof(size));
+    tail_ += (size == 0 || size > remaining) ? remaining : size;
+  }
+  // 先公布新的 tail，再覆盖旧数据：崩溃时恢复端不会读到写了一半的区域
+  std::atomic_thread_fence(std::memory_order_release);
+  reinterpret_cast<RingHeader*>(mapping_->data())->tail = tail_;
+  std::atomic_thread_fence(std::memory_order_release);
+}
+
+void crash_ring_sink::Pad(uint64_t bytes) {
+  Reserve(bytes);
+  if (bytes >= sizeof(RecordHeader)) {
+    RecordHeader pad{};
+    pad.size = static_cast<uint32_t>(bytes);
+    pad.type = kPadRecord;
+    std::memcpy(mapping_->data() + sizeof(RingHeader) + head_ % capacity_, &pad, sizeof(pad));
+  }
+  head_ += bytes;
+  std::atomic_thread_fence(std::memory_order_release);
+  reinterpret_cast<RingHeader*>(mapping_->data())->head = head_;
+}
+
+void crash_ring_sink::sink_it_(const spdlog::details::log_msg& msg) {
+  const auto name_len = std::min<size_t>(msg.logger_name.size(), kMaxNameLength);
+  const auto message_len = std::min<size_t>(msg.payload.size(), capacity_ / 4);
+  fields_scratch_.clear();
+  if (const StructuredLogContext* context = CurrentStructuredLog()) {
+    AppendBinaryFields(*context, fields_scratch_);
+    if (fields_scratch_.size() > capacity_ / 4) fields_scratch_.clear();
+  }
+
+  RecordHeader header{};
+  header.type = static_cast<uint8_t>(RecordType::kLog);
+  header.level = static_cast<uint8_t>(msg.level);
+  header.name_id = static_cast<uint16_t>(name_len);
+  header.payload_len = static_cast<uint32_t>(name_len + message_len);
+  header.fields_len = static_cast<uint32_t>(fields_scratch_.size());
+  header.time_ns = ToUnixNanos(msg.time);
+  header.thread_id = static_cast<uint64_t>(msg.thread_id);
+  const uint32_t size = binlog::RecordSize(header.payload_len + header.fields_len);
+
+  if (capacity_ - head_ % capacity_ < size) Pad(capacity_ - head_ % capacity_);
+  Reserve(size);
+
+  // 先写头部 (size 为 0) 与正文，最后写 size 并推进 head
+  char* out = mapping_->data() + sizeof(RingHeader) + head_ % capacity_;
+  std::memcpy(out, &header, sizeof(header));
+  std::memcpy(out + sizeof(header), msg.logger_name.data(), name_len);
+  std::memcpy(out + sizeof(header) + name_len, msg.payload.data(), message_len);
+  if (!fields_scratch_.empty()) {
+    std::memcpy(out + sizeof(header) + header.payload_len, fields_scratch_.data(),
+                fields_scratch_.size());
+  }
+  std::atomic_thread_fence(std::memory_order_release);
+  std::memcpy(out + offsetof(RecordHeader, size), &size, sizeof(size));
+  head_ += size;
+  std::atomic_thread_fence(std::memory_order_release);
+  reinterpret_cast<RingHeader*>(mapping_->data())->head = head_;
+}
+
+void crash_ring_sink::flush_() {
+  // 映射页对进程崩溃已经安全；这里只提示系统尽快写回 (防断电)
+  mapping_->FlushAsync();
+}
+
+}  // namespace log
+}  // namespace plugins
+}  // namespace z3y
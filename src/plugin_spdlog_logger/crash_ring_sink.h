@@ -0,0 +1,105 @@
+﻿/*
+ * Copyright [2025] [Yue Liu]
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file crash_ring_sink.h
+ * @brief [内部] 崩溃环：内存映射的环形缓冲，保留最近 N 字节的日志，下次启动时恢复。
+ *
+ * @details
+ * 由 global_settings.crash_ring 开启，挂在所有 Logger 上 (与 Observer Sink 相同)。
+ * [设计]
+ * 1. **写入即持久**: 环文件整体映射，写入只是 memcpy。进程崩溃时映射页仍由操作系统写回，
+ * 不需要按级别 (flush_on_level) 或定期刷盘来保住崩溃前的日志。
+ * 2. **覆盖最旧**: 环满时推进 tail 丢弃最旧的记录。记录格式与 mmap_binary_sink 相同，
+ * 只是 Logger 名字内联在正文之前 (RecordHeader::name_id 存名字长度)，被覆盖的记录不影响其余记录。
+ * 3. **崩溃标记**: 可选安装致命信号 (POSIX) / 未处理异常 (Windows) 处理函数，
+ * 只在文件头写下信号与时间，随后交还给原处理函数。栈溢出等处理函数无法运行的情况下，
+ * 文件头仍是 "运行中"，下次启动同样会恢复。
+ * 4. **恢复**: 构造时若发现上次运行未正常关闭，把 tail..head 间的记录转成标准二进制段
+ * `<stem>.crash-<毫秒时间戳>.blog` (可用 tool_log_decoder 解码)，末尾附一条说明崩溃原因的记录。
+ * 正常析构时文件头标记为 "已关闭"，不再恢复。
+ *
+ * 后台线程尚未写入 Sink 的记录 (异步队列 / 延迟格式化环中) 在崩溃时仍会丢失。
+ * 同一环文件只应由一个进程使用。
+ */
+
+#pragma once
+
+#ifndef Z3Y_PLUGIN_SPDLOG_CRASH_RING_SINK_H_
+#define Z3Y_PLUGIN_SPDLOG_CRASH_RING_SINK_H_
+
+#include <spdlog/sinks/base_sink.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace z3y {
+namespace plugins {
+namespace log {
+
+class MappedFile;
+
+class crash_ring_sink final : public spdlog::sinks::base_sink<std::mutex> {
+ public:
+  static constexpr size_t kMinSize = 64 * 1024;
+
+  /** @brief 构造时对上一次运行的恢复结果。 */
+  struct Recovery {
+    size_t records = 0;          ///< 恢复的日志条数 (0 = 上次正常关闭或没有环文件)
+    int signal = 0;              ///< 上次运行终止的信号 / 异常码 (0 = 未记录到)
+    std::filesystem::path path;  ///< 恢复出的段文件
+    std::string error;           ///< 恢复失败的原因 (不影响新环的创建)
+  };
+
+  /**
+   * @param path 环文件路径，如 logs/crash/app.ring。
+   * @param size 环文件大小 (不小于 kMinSize)。
+   * @param install_crash_handler 是否安装崩溃标记处理函数 (进程内同时只有一个环安装)。
+   * @throws spdlog::spdlog_ex 无法创建或映射环文件时。
+   */
+  crash_ring_sink(std::filesystem::path path, size_t size, bool install_crash_handler);
+  ~crash_ring_sink() override;
+
+  const Recovery& recovery() const { return recovery_; }
+
+ protected:
+  void sink_it_(const spdlog::details::log_msg& msg) override;
+  void flush_() override;
+
+ private:
+  void Recover();
+  void Reserve(uint64_t bytes);  ///< 推进 tail，直到环中空出 bytes 字节
+  void Pad(uint64_t bytes);      ///< 用填充记录跳过环尾放不下整条记录的部分
+
+  const std::filesystem::path path_;
+  const size_t size_;
+  std::unique_ptr<MappedFile> mapping_;
+  uint64_t capacity_ = 0;  ///< 数据区字节数
+  uint64_t head_ = 0;      ///< 累计写入字节数 (文件头中的副本供恢复使用)
+  uint64_t tail_ = 0;      ///< 最旧完整记录的累计位置
+  bool handler_installed_ = false;
+  Recovery recovery_;
+  std::string fields_scratch_;  ///< 结构化字段的编码缓冲 (复用)
+};
+
+}  // namespace log
+}  // namespace plugins
+}  // namespace z3y
+
+#endif  // Z3Y_PLUGIN_SPDLOG_CRASH_RING_SINK_H_
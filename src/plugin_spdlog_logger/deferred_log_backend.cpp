@@ -0,0 +1,559 @@
+﻿/*
+ * Copyright [2025] [Yue Liu]
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file deferred_log_backend.cpp
+ * @brief DeferredLogBackend 的实现。
+ */
+
+#include "deferred_log_backend.h"
+
+#include <spdlog/details/os.h>
+#include <spdlog/sinks/sink.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <string_view>
+
+#include "structured_log_context.h"
+
+#if defined(SPDLOG_FMT_EXTERNAL)
+#include <fmt/args.h>
+#else
+#include <spdlog/fmt/bundled/args.h>
+#endif
+
+namespace z3y {
+namespace plugins {
+namespace log {
+
+namespace {
+
+constexpr uint32_t kPadding = ~uint32_t{0};  ///< arg_count 取此值表示回绕填充
+
+/** @brief 记录的种类。 */
+enum class RecordKind : uint8_t {
+  kDeferred,    ///< format + LogArg 数组
+  kStructured,  ///< format 是结构化日志的模板，参数带字段名
+  kText,        ///< 已格式化的正文 (Log 经 thread_rings 后端提交)
+};
+
+/**
+ * @brief 环中一条记录的头部，后接 LogArg[arg_count]、(结构化时) 字段名指针
+ * const char*[arg_count] 与字符串内容；文本记录直接后接正文。
+ * @details String 参数在环中的 u64 存的是相对记录起点的偏移。
+ */
+struct alignas(8) DeferredRecord {
+  uint32_t size;       ///< 含头部的总字节数 (8 字节对齐)
+  uint32_t arg_count;  ///< kPadding 表示回绕填充，此时只有 size 有效；文本记录为正文字节数
+  spdlog::logger* logger;
+  const char* format;
+  LogSourceLocation loc;
+  spdlog::log_clock::time_point time;
+  size_t thread_id;
+  spdlog::level::level_enum level;
+  RecordKind kind;
+};
+
+size_t RoundUp8(size_t n) { return (n + 7) & ~size_t{7}; }
+
+/** @brief 以参数的原始类型调用 fn (String 取 str 指针，string_base 非空时 u64 为偏移)。 */
+template <typename F>
+void VisitArg(const LogArg& a, const char* string_base, F&& fn) {
+  switch (a.type) {
+    case LogArgType::Int64:
+      fn(a.i64);
+      break;
+    case LogArgType::UInt64:
+      fn(a.u64);
+      break;
+    case LogArgType::Double:
+      fn(a.f64);
+      break;
+    case LogArgType::Bool:
+      fn(a.u64 != 0);
+      break;
+    case LogArgType::Char:
+      fn(static_cast<char>(a.u64));
+      break;
+    case LogArgType::Pointer:
+      fn(a.ptr);
+      break;
+    case LogArgType::String:
+      fn(fmt::string_view(string_base ? string_base + a.u64 : a.str, a.size));
+      break;
+  }
+}
+
+std::string FormatWith(const char* format, const LogArg* args,
+                       uint32_t arg_count, const char* string_base) {
+  fmt::dynamic_format_arg_store<fmt::format_context> store;
+  store.reserve(arg_count, 0);
+  for (uint32_t i = 0; i < arg_count; ++i) {
+    VisitArg(args[i], string_base, [&store](auto v) { store.push_back(v); });
+  }
+  try {
+    return fmt::vformat(fmt::string_view(format), store);
+  } catch (const std::exception& e) {
+    return fmt::format("[format error: {}] {}", e.what(), format);
+  }
+}
+
+/** @brief 模板中是否有以 key 为名的占位符 ("{key}" 或 "{key:...}")。 */
+bool Referenced(std::string_view tmpl, std::string_view key) {
+  for (size_t pos = tmpl.find(key); pos != std::string_view::npos;
+       pos = tmpl.find(key, pos + 1)) {
+    const size_t end = pos + key.size();
+    if (pos > 0 && tmpl[pos - 1] == '{' && end < tmpl.size() &&
+        (tmpl[end] == '}' || tmpl[end] == ':')) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief 把一条已格式化的消息直接写入 logger 的各个 Sink (等价于 logger::sink_it_)。
+ */
+void WriteToSinks(spdlog::logger& logger, spdlog::log_clock::time_point time,
+                  const LogSourceLocation& loc, size_t thread_id,
+                  spdlog::level::level_enum level, spdlog::string_view_t text) {
+  spdlog::details::log_msg msg(
+      time, spdlog::source_loc{loc.file_name, loc.line_number, loc.function_name},
+      logger.name(), level, text);
+  msg.thread_id = thread_id;
+  const bool flush = level >= logger.flush_level() && level != spdlog::level::off;
+  for (auto& sink : logger.sinks()) {
+    if (!sink->should_log(level)) continue;
+    try {
+      sink->log(msg);
+      if (flush) sink->flush();
+    } catch (...) {
+      // 与 spdlog 的默认错误处理一致：单个 Sink 出错不影响其余 Sink 与后续日志
+    }
+  }
+}
+
+void WriteToSinks(spdlog::logger& logger, const DeferredRecord& rec,
+                  spdlog::level::level_enum level, spdlog::string_view_t text) {
+  WriteToSinks(logger, rec.time, rec.loc, rec.thread_id, level, text);
+}
+
+/** @brief 渲染结构化日志，并在写 Sink 期间公布原始字段。 */
+void WriteStructured(spdlog::logger& logger, spdlog::log_clock::time_point time,
+                     const LogSourceLocation& loc, size_t thread_id,
+                     spdlog::level::level_enum level, const char* message_template,
+                     const LogField* fields, uint32_t field_count) {
+  const std::string text = FormatStructured(message_template, fields, field_count);
+  const StructuredLogContext context{message_template, fields, field_count};
+  StructuredLogScope scope(context);
+  WriteToSinks(logger, time, loc, thread_id, level, text);
+}
+
+}  // namespace
+
+std::string FormatDeferred(const char* format, const LogArg* args,
+                           uint32_t arg_count) {
+  return FormatWith(format, args, arg_count, nullptr);
+}
+
+std::string FormatStructured(const char* message_template, const LogField* fields,
+                             uint32_t field_count) {
+  fmt::dynamic_format_arg_store<fmt::format_context> store;
+  store.reserve(field_count, field_count);
+  for (uint32_t i = 0; i < field_count; ++i) {
+    const char* key = fields[i].key;
+    VisitArg(fields[i].value, nullptr,
+             [&store, key](auto v) { store.push_back(fmt::arg(key, v)); });
+  }
+  std::string text;
+  try {
+    text = fmt::vformat(fmt::string_view(message_template), store);
+  } catch (const std::exception& e) {
+    text = fmt::format("[format error: {}] {}", e.what(), message_template);
+  }
+  // 模板没有引用的字段附在文本末尾，控制台上也能看到完整上下文
+  for (uint32_t i = 0; i < field_count; ++i) {
+    if (Referenced(message_template, fields[i].key)) continue;
+    text += ' ';
+    text += fields[i].key;
+    text += '=';
+    VisitArg(fields[i].value, nullptr,
+             [&text](auto v) { fmt::format_to(std::back_inserter(text), "{}", v); });
+  }
+  return text;
+}
+
+void WriteStructuredNow(spdlog::logger& logger, const LogSourceLocation& loc,
+                        spdlog::level::level_enum level, const char* message_template,
+                        const LogField* fields, uint32_t field_count) {
+  WriteStructured(logger, spdlog::log_clock::now(), loc, spdlog::details::os::thread_id(),
+                  level, message_template, fields, field_count);
+}
+
+/**
+ * @brief 单生产者 (所属线程) / 单消费者 (持有 drain_mutex_ 者) 字节环。
+ * @details head_ / tail_ 单调递增，取模得到偏移；尾部放不下时写一条填充记录回绕。
+ */
+class DeferredLogBackend::Ring {
+ public:
+  explicit Ring(size_t bytes)
+      : capacity_(bytes), mask_(bytes - 1), storage_(new uint64_t[bytes / 8]) {}
+
+  char* Base() { return reinterpret_cast<char*>(storage_.get()); }
+
+  /** @brief [生产者] 预留 bytes (8 对齐) 字节的连续空间，放不下时返回 nullptr。 */
+  char* TryReserve(size_t bytes) {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    const size_t tail = tail_.load(std::memory_order_acquire);
+    const size_t offset = head & mask_;
+    const size_t contiguous = capacity_ - offset;
+    const size_t pad = contiguous < bytes ? contiguous : 0;
+    if (head + pad + bytes - tail > capacity_) return nullptr;
+    if (pad) {
+      auto* filler = reinterpret_cast<DeferredRecord*>(Base() + offset);
+      filler->size = static_cast<uint32_t>(pad);
+      filler->arg_count = kPadding;
+    }
+    pending_ = pad + bytes;
+    return Base() + ((head + pad) & mask_);
+  }
+
+  /** @brief [生产者] 发布 TryReserve 预留的记录。 */
+  void Commit() {
+    head_.store(head_.load(std::memory_order_relaxed) + pending_,
+                std::memory_order_release);
+    committed_.store(committed_.load(std::memory_order_relaxed) + 1,
+                     std::memory_order_relaxed);
+  }
+
+  /** @brief [消费者] 记下当前已发布的位置，本轮的 Front / Pop 只处理这之前的记录。 */
+  void BeginRead() { read_head_ = head_.load(std::memory_order_acquire); }
+
+  /** @brief [消费者] 本轮的下一条记录 (跳过回绕填充)，读完时返回 nullptr。 */
+  const DeferredRecord* Front() {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    while (tail != read_head_) {
+      const auto* rec = reinterpret_cast<const DeferredRecord*>(Base() + (tail & mask_));
+      if (rec->arg_count != kPadding) return rec;
+      tail += rec->size;
+      tail_.store(tail, std::memory_order_release);
+    }
+    return nullptr;
+  }
+
+  /** @brief [消费者] 释放 Front 返回的记录 (逐条释放，阻塞中的生产者尽早继续)。 */
+  void Pop(const DeferredRecord& rec) {
+    tail_.store(tail_.load(std::memory_order_relaxed) + rec.size, std::memory_order_release);
+    consumed_.store(consumed_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  }
+
+  bool Empty() const {
+    return head_.load(std::memory_order_acquire) ==
+           tail_.load(std::memory_order_acquire);
+  }
+
+  /** @brief 已提交、尚未释放的记录数 (任意线程读取，近似值)。 */
+  uint64_t Queued() const {
+    const uint64_t consumed = consumed_.load(std::memory_order_relaxed);
+    const uint64_t committed = committed_.load(std::memory_order_relaxed);
+    return committed > consumed ? committed - consumed : 0;
+  }
+
+  std::atomic<uint64_t> dropped{0};  ///< 尚未告警的丢弃条数
+
+ private:
+  const size_t capacity_;
+  const size_t mask_;
+  std::unique_ptr<uint64_t[]> storage_;  ///< 以 uint64_t 分配，保证 8 字节对齐
+  alignas(64) std::atomic<size_t> head_{0};
+  size_t pending_ = 0;  ///< 仅生产者访问
+  std::atomic<uint64_t> committed_{0};  ///< 仅生产者写入
+  alignas(64) std::atomic<size_t> tail_{0};
+  size_t read_head_ = 0;  ///< 仅消费者访问
+  std::atomic<uint64_t> consumed_{0};  ///< 仅消费者写入
+};
+
+namespace {
+
+/** @brief 线程当前使用的环及其所属的后台实例。 */
+struct DeferredThreadCache {
+  uint64_t owner = 0;
+  std::shared_ptr<void> ring;  // 类型擦除，登记表退出前环不会被释放
+};
+thread_local DeferredThreadCache tls_deferred_ring;
+
+/** @brief 在 dst 处填写记录头，时间戳与线程 ID 取调用时刻。 */
+DeferredRecord* WriteHeader(char* dst, size_t bytes, uint32_t arg_count,
+                            spdlog::logger& logger, const char* format,
+                            const LogSourceLocation& loc, spdlog::level::level_enum level,
+                            RecordKind kind) {
+  auto* rec = reinterpret_cast<DeferredRecord*>(dst);
+  rec->size = static_cast<uint32_t>(bytes);
+  rec->arg_count = arg_count;
+  rec->logger = &logger;
+  rec->format = format;
+  rec->loc = loc;
+  rec->time = spdlog::log_clock::now();
+  rec->thread_id = spdlog::details::os::thread_id();
+  rec->level = level;
+  rec->kind = kind;
+  return rec;
+}
+
+}  // namespace
+
+std::atomic<uint64_t> DeferredLogBackend::g_instance_counter_{1};
+
+DeferredLogBackend::DeferredLogBackend(size_t ring_bytes, bool block_when_full)
+    : instance_id_(g_instance_counter_.fetch_add(1, std::memory_order_relaxed)),
+      ring_bytes_([ring_bytes] {
+        size_t bytes = kMinRingBytes;
+        while (bytes < ring_bytes && bytes < kMaxRingBytes) bytes <<= 1;
+        return bytes;
+      }()),
+      block_when_full_(block_when_full) {
+  worker_ = std::thread([this] { Run(); });
+}
+
+DeferredLogBackend::~DeferredLogBackend() { Stop(); }
+
+void DeferredLogBackend::Stop() {
+  {
+    std::lock_guard<std::mutex> lock(wake_mutex_);
+    if (!running_.exchange(false, std::memory_order_acq_rel)) return;
+  }
+  wake_cv_.notify_all();
+  if (worker_.joinable()) worker_.join();
+  Drain();
+}
+
+DeferredLogBackend::Ring* DeferredLogBackend::LocalRing() {
+  DeferredThreadCache& cache = tls_deferred_ring;
+  if (cache.ring && cache.owner == instance_id_) {
+    return static_cast<Ring*>(cache.ring.get());
+  }
+  auto fresh = std::make_shared<Ring>(ring_bytes_);
+  {
+    std::lock_guard<std::mutex> lock(rings_mutex_);
+    rings_.push_back(fresh);
+  }
+  cache.owner = instance_id_;
+  cache.ring = fresh;
+  return fresh.get();
+}
+
+bool DeferredLogBackend::SubmitRecord(spdlog::logger& logger,
+                                      const LogSourceLocation& loc,
+                                      spdlog::level::level_enum level,
+                                      const char* format, const LogArg* args,
+                                      const LogField* fields, uint32_t arg_count,
+                                      bool structured) {
+  if (!running_.load(std::memory_order_acquire)) return false;
+  const auto arg = [&](uint32_t i) -> const LogArg& {
+    return structured ? fields[i].value : args[i];
+  };
+
+  const size_t keys_offset = sizeof(DeferredRecord) + sizeof(LogArg) * arg_count;
+  size_t bytes = keys_offset + (structured ? sizeof(const char*) * arg_count : 0);
+  for (uint32_t i = 0; i < arg_count; ++i) {
+    if (arg(i).type == LogArgType::String) bytes += arg(i).size;
+  }
+  bytes = RoundUp8(bytes);
+  if (bytes > ring_bytes_ / 2) return false;  // 超大记录：退回同步格式化
+
+  Ring* ring = nullptr;
+  char* dst = nullptr;
+  switch (ReserveLocal(bytes, ring, dst)) {
+    case Reserve::kDropped:
+      return true;
+    case Reserve::kStopped:
+      return false;
+    case Reserve::kOk:
+      break;
+  }
+
+  auto* rec = WriteHeader(dst, bytes, arg_count, logger, format, loc, level,
+                          structured ? RecordKind::kStructured : RecordKind::kDeferred);
+
+  auto* packed = reinterpret_cast<LogArg*>(rec + 1);
+  size_t string_offset = keys_offset;
+  if (structured) {
+    auto* keys = reinterpret_cast<const char**>(dst + keys_offset);
+    for (uint32_t i = 0; i < arg_count; ++i) keys[i] = fields[i].key;
+    string_offset += sizeof(const char*) * arg_count;
+  }
+  for (uint32_t i = 0; i < arg_count; ++i) {
+    const LogArg& a = arg(i);
+    packed[i] = a;
+    if (a.type == LogArgType::String) {
+      if (a.size) std::memcpy(dst + string_offset, a.str, a.size);
+      packed[i].u64 = string_offset;
+      string_offset += a.size;
+    }
+  }
+  ring->Commit();
+  return true;
+}
+
+bool DeferredLogBackend::SubmitText(spdlog::logger& logger, const LogSourceLocation& loc,
+                                    spdlog::level::level_enum level, std::string_view text) {
+  if (!running_.load(std::memory_order_acquire)) return false;
+  const size_t bytes = RoundUp8(sizeof(DeferredRecord) + text.size());
+  if (bytes > ring_bytes_ / 2) return false;  // 超大记录：退回 spdlog 的异步队列
+
+  Ring* ring = nullptr;
+  char* dst = nullptr;
+  switch (ReserveLocal(bytes, ring, dst)) {
+    case Reserve::kDropped:
+      return true;
+    case Reserve::kStopped:
+      return false;
+    case Reserve::kOk:
+      break;
+  }
+  auto* rec = WriteHeader(dst, bytes, static_cast<uint32_t>(text.size()), logger, nullptr,
+                          loc, level, RecordKind::kText);
+  if (!text.empty()) std::memcpy(rec + 1, text.data(), text.size());
+  ring->Commit();
+  return true;
+}
+
+DeferredLogBackend::Reserve DeferredLogBackend::ReserveLocal(size_t bytes, Ring*& ring,
+                                                             char*& dst) {
+  ring = LocalRing();
+  dst = ring->TryReserve(bytes);
+  if (dst) return Reserve::kOk;
+  if (!block_when_full_) {
+    ring->dropped.fetch_add(1, std::memory_order_relaxed);
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    return Reserve::kDropped;
+  }
+  while (!(dst = ring->TryReserve(bytes))) {
+    if (!running_.load(std::memory_order_acquire)) return Reserve::kStopped;
+    wake_cv_.notify_one();
+    std::this_thread::yield();
+  }
+  return Reserve::kOk;
+}
+
+uint64_t DeferredLogBackend::Queued() {
+  std::lock_guard<std::mutex> lock(rings_mutex_);
+  uint64_t queued = 0;
+  for (const auto& ring : rings_) queued += ring->Queued();
+  return queued;
+}
+
+void DeferredLogBackend::Drain() {
+  std::lock_guard<std::mutex> lock(drain_mutex_);
+  DrainLocked();
+}
+
+size_t DeferredLogBackend::DrainLocked() {
+  std::vector<std::shared_ptr<Ring>> rings;
+  {
+    std::lock_guard<std::mutex> lock(rings_mutex_);
+    rings = rings_;
+  }
+
+  std::vector<LogField> fields;  // 结构化记录的字段 (逐条复用)
+  auto write = [&fields](Ring& ring, const DeferredRecord& rec) {
+    if (uint64_t lost = ring.dropped.exchange(0, std::memory_order_relaxed)) {
+      WriteToSinks(*rec.logger, rec, spdlog::level::warn,
+                   fmt::format("[deferred] {} messages dropped: ring full", lost));
+    }
+    const char* base = reinterpret_cast<const char*>(&rec);
+    if (rec.kind == RecordKind::kText) {
+      WriteToSinks(*rec.logger, rec, rec.level,
+                   spdlog::string_view_t(base + sizeof(DeferredRecord), rec.arg_count));
+      return;
+    }
+    const auto* packed = reinterpret_cast<const LogArg*>(&rec + 1);
+    if (rec.kind == RecordKind::kDeferred) {
+      WriteToSinks(*rec.logger, rec, rec.level,
+                   FormatWith(rec.format, packed, rec.arg_count, base));
+      return;
+    }
+    // 还原字段：字段名取自记录，String 的偏移换回指针
+    const auto* keys = reinterpret_cast<const char* const*>(packed + rec.arg_count);
+    fields.resize(rec.arg_count);
+    for (uint32_t i = 0; i < rec.arg_count; ++i) {
+      fields[i] = LogField{keys[i], packed[i]};
+      if (packed[i].type == LogArgType::String) fields[i].value.str = base + packed[i].u64;
+    }
+    WriteStructured(*rec.logger, rec.time, rec.loc, rec.thread_id, rec.level, rec.format,
+                    fields.data(), rec.arg_count);
+  };
+
+  // 本轮只处理各环此刻已发布的记录，按调用时刻多路归并 (堆顶为最早的一条)
+  using Cursor = std::pair<const DeferredRecord*, Ring*>;
+  std::vector<Cursor> heap;
+  heap.reserve(rings.size());
+  for (const auto& ring : rings) {
+    ring->BeginRead();
+    if (const DeferredRecord* rec = ring->Front()) heap.emplace_back(rec, ring.get());
+  }
+  const auto later = [](const Cursor& a, const Cursor& b) {
+    return b.first->time < a.first->time;
+  };
+  std::make_heap(heap.begin(), heap.end(), later);
+
+  size_t count = 0;
+  while (!heap.empty()) {
+    std::pop_heap(heap.begin(), heap.end(), later);
+    Cursor& top = heap.back();
+    write(*top.second, *top.first);
+    top.second->Pop(*top.first);
+    ++count;
+    if ((top.first = top.second->Front())) {
+      std::push_heap(heap.begin(), heap.end(), later);
+    } else {
+      heap.pop_back();
+    }
+  }
+  rings.clear();
+
+  // 回收已退出线程 (只剩登记表持有) 且已读空的环
+  std::lock_guard<std::mutex> lock(rings_mutex_);
+  rings_.erase(std::remove_if(rings_.begin(), rings_.end(),
+                              [](const std::shared_ptr<Ring>& r) {
+                                return r.use_count() == 1 && r->Empty();
+                              }),
+               rings_.end());
+  return count;
+}
+
+void DeferredLogBackend::Run() {
+  while (running_.load(std::memory_order_acquire)) {
+    size_t count;
+    {
+      std::lock_guard<std::mutex> lock(drain_mutex_);
+      count = DrainLocked();
+    }
+    if (count == 0) {
+      // 生产者不做唤醒 (省去热路径上的系统调用)，空闲时以 1ms 为周期轮询
+      std::unique_lock<std::mutex> lock(wake_mutex_);
+      wake_cv_.wait_for(lock, std::chrono::milliseconds(1), [this] {
+        return !running_.load(std::memory_order_acquire);
+      });
+    }
+  }
+}
+
+}  // namespace log
+}  // namespace plugins
+}  // namespace z3y
@@ -0,0 +1,183 @@
+﻿/*
+ * Copyright [2025] [Yue Liu]
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file deferred_log_backend.h
+ * @brief [内部] 延迟格式化日志 (ILogger::LogDeferred) 的线程环形缓冲与后台格式化线程。
+ *
+ * @details
+ * [设计]
+ * 1. **线程私有环**: 每个提交线程首次调用时分配一个单生产者 / 单消费者字节环，
+ * 调用方只写入 "记录头 + LogArg 数组 + 字符串内容"，不加锁、不分配内存。
+ * 2. **后台格式化**: 后台线程轮询所有环，用 fmt 动态参数表格式化，然后直接写入
+ * Logger 的各个 Sink（不再经过 spdlog 的异步队列，避免二次拷贝）。
+ * 时间戳与线程 ID 在调用时刻记录，写入 log_msg 时原样恢复。
+ * 3. **满载策略**: 与 async_overflow_policy 一致——block 时调用方等待空间，
+ * overrun_oldest 时丢弃新消息并计数，该环的下一条日志前补一条丢弃告警。
+ * 放不进环的超大记录、后台线程未运行时，退回调用线程同步格式化。
+ * 4. **结构化日志**: 同一个环，记录额外带字段名指针数组。后台线程渲染文本后，
+ * 在写 Sink 期间通过 StructuredLogScope 公布原始字段，JSON / 二进制 Sink 与观察者据此输出。
+ * 5. **文本日志**: 全局设置 "async_backend": "thread_rings" 时，Log() 的正文也写入同一个环
+ * (SubmitText)，不再进入 spdlog 由互斥量与条件变量保护的 mpmc 队列，提交线程之间没有共享的写入点。
+ * 环只能丢弃新消息，因此 overrun_oldest 时文本日志仍留在 spdlog 队列 (由服务在初始化时决定)。
+ * 6. **按时间合并**: 后台每一轮先记下各环已发布的位置，再按调用时刻的时间戳多路归并输出，
+ * 不同线程的日志在同一轮内按时间先后写入 Sink；同一线程的日志始终保持提交顺序。
+ */
+
+#pragma once
+
+#ifndef Z3Y_PLUGIN_SPDLOG_DEFERRED_LOG_BACKEND_H_
+#define Z3Y_PLUGIN_SPDLOG_DEFERRED_LOG_BACKEND_H_
+
+#include <spdlog/spdlog.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "interfaces_core/i_log_service.h"
+
+namespace z3y {
+namespace plugins {
+namespace log {
+
+using namespace z3y::interfaces::core;
+
+/**
+ * @brief 把格式串与参数数组格式化为文本。格式串错误时返回带 "[format error]" 的原始格式串。
+ */
+std::string FormatDeferred(const char* format, const LogArg* args,
+                           uint32_t arg_count);
+
+/**
+ * @brief 渲染结构化日志的文本：模板按字段名格式化，模板未引用的字段以 " key=value" 追加。
+ * @param fields String 字段的 str 须为实际指针。
+ */
+std::string FormatStructured(const char* message_template, const LogField* fields,
+                             uint32_t field_count);
+
+/**
+ * @brief 在调用线程上渲染一条结构化日志并直接写入 logger 的各个 Sink (同步路径)。
+ */
+void WriteStructuredNow(spdlog::logger& logger, const LogSourceLocation& loc,
+                        spdlog::level::level_enum level, const char* message_template,
+                        const LogField* fields, uint32_t field_count);
+
+/**
+ * @class DeferredLogBackend
+ * @brief 线程环形缓冲 + 后台格式化线程。Submit / Drain 线程安全。
+ */
+class DeferredLogBackend {
+ public:
+  static constexpr size_t kMinRingBytes = 4 * 1024;
+  static constexpr size_t kMaxRingBytes = 64 * 1024 * 1024;
+
+  /**
+   * @param ring_bytes 每个线程的环大小 (向上取整为 2 的幂)。
+   * @param block_when_full 环满时等待 (true) 还是丢弃 (false)。
+   */
+  DeferredLogBackend(size_t ring_bytes, bool block_when_full);
+  ~DeferredLogBackend();
+
+  DeferredLogBackend(const DeferredLogBackend&) = delete;
+  DeferredLogBackend& operator=(const DeferredLogBackend&) = delete;
+
+  /**
+   * @brief 把一条记录写入当前线程的环。
+   * @return false 表示没有写入 (记录过大或后台未运行)，调用方应同步格式化。
+   * 丢弃策略下环满时返回 true (消息已计入丢弃数)。
+   */
+  bool Submit(spdlog::logger& logger, const LogSourceLocation& loc,
+              spdlog::level::level_enum level, const char* format,
+              const LogArg* args, uint32_t arg_count) {
+    return SubmitRecord(logger, loc, level, format, args, nullptr, arg_count, false);
+  }
+
+  /** @brief 把一条结构化日志写入当前线程的环 (返回值同 Submit)。 */
+  bool SubmitStructured(spdlog::logger& logger, const LogSourceLocation& loc,
+                        spdlog::level::level_enum level, const char* message_template,
+                        const LogField* fields, uint32_t field_count) {
+    return SubmitRecord(logger, loc, level, message_template, nullptr, fields, field_count,
+                        true);
+  }
+
+  /**
+   * @brief 把一条已格式化的文本写入当前线程的环 (返回值同 Submit)。
+   * @details 正文在调用时拷入环，调用返回后 text 即可释放。
+   */
+  bool SubmitText(spdlog::logger& logger, const LogSourceLocation& loc,
+                  spdlog::level::level_enum level, std::string_view text);
+
+  /** @brief 同步格式化并输出所有已提交的记录 (Flush / Shutdown 调用)。 */
+  void Drain();
+
+  /**
+   * @brief 停止后台线程并输出剩余记录 (幂等)。
+   * @details 之后的 Submit 一律返回 false，调用方退回同步格式化；
+   * 服务析构时调用，仍被外部持有的 Logger 不会再把记录交给已停止的线程。
+   */
+  void Stop();
+
+  /** @brief 累计因环满丢弃的记录数。 */
+  uint64_t Dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+  /** @brief 各环中已提交、尚未写入 Sink 的记录数之和 (并入 GetQueueStats)。 */
+  uint64_t Queued();
+
+ private:
+  class Ring;
+
+  Ring* LocalRing();
+  /** @brief 预留当前线程环中 bytes 字节；环满时按满载策略等待或计入丢弃。 */
+  enum class Reserve { kOk, kDropped, kStopped };
+  Reserve ReserveLocal(size_t bytes, Ring*& ring, char*& dst);
+  /** @brief structured 时参数取自 fields，否则取自 args。 */
+  bool SubmitRecord(spdlog::logger& logger, const LogSourceLocation& loc,
+                    spdlog::level::level_enum level, const char* format,
+                    const LogArg* args, const LogField* fields, uint32_t arg_count,
+                    bool structured);
+  void Run();
+  size_t DrainLocked();
+
+  const uint64_t instance_id_;
+  const size_t ring_bytes_;
+  const bool block_when_full_;
+
+  std::mutex rings_mutex_;  ///< 保护 rings_
+  std::vector<std::shared_ptr<Ring>> rings_;
+
+  std::mutex drain_mutex_;  ///< 串行化消费者 (后台线程与 Drain)，保证每个环只有一个读者
+
+  std::atomic<bool> running_{true};
+  std::atomic<uint64_t> dropped_{0};
+  std::mutex wake_mutex_;
+  std::condition_variable wake_cv_;
+  std::thread worker_;
+
+  static std::atomic<uint64_t> g_instance_counter_;
+};
+
+}  // namespace log
+}  // namespace plugins
+}  // namespace z3y
+
+#endif  // Z3Y_PLUGIN_SPDLOG_DEFERRED_LOG_BACKEND_H_
@@ -0,0 +1,165 @@
+﻿/*
+ * Copyright [2025] [Yue Liu]
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file json_lines_formatter.h
+ * @brief [内部] JSON Lines 格式化器 (Sink 配置 "format": "json")。
+ *
+ * @details
+ * 每条日志一行 JSON 对象，日志分析直接按字段读取，不再用正则拆文本：
+ * @code
+ * {"ts":1732150000123,"level":"info","logger":"Order","thread":4242,
+ *  "msg":"order 7 filled","template":"order {id} filled","fields":{"id":7}}
+ * @endcode
+ * - ts 为 Unix 纪元毫秒；template / fields 只出现在结构化日志 (LogStructured) 上。
+ * - 字段保持原始类型：整数、浮点 (非有限值写 null)、布尔为 JSON 原生类型，
+ * 字符、指针、字符串写成 JSON 字符串。
+ * - 字段取自写入线程公布的 StructuredLogContext；绑定专属线程池的 Sink 只得到 msg。
+ */
+
+#pragma once
+
+#ifndef Z3Y_PLUGIN_SPDLOG_JSON_LINES_FORMATTER_H_
+#define Z3Y_PLUGIN_SPDLOG_JSON_LINES_FORMATTER_H_
+
+#include <spdlog/formatter.h>
+
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <string_view>
+
+#include "structured_log_context.h"
+
+namespace z3y {
+namespace plugins {
+namespace log {
+
+/** @brief 追加原样文本。 */
+inline void AppendJsonRaw(spdlog::memory_buf_t& dest, std::string_view text) {
+  dest.append(text.data(), text.data() + text.size());
+}
+
+/** @brief 追加 JSON 字符串 (含引号与转义)。 */
+inline void AppendJsonString(spdlog::memory_buf_t& dest, std::string_view text) {
+  dest.push_back('"');
+  size_t run = 0;  // 无需转义的连续字节整段拷贝
+  for (size_t i = 0; i < text.size(); ++i) {
+    const auto c = static_cast<unsigned char>(text[i]);
+    if (c >= 0x20 && c != '"' && c != '\\') continue;
+    AppendJsonRaw(dest, text.substr(run, i - run));
+    run = i + 1;
+    switch (c) {
+      case '"':
+        AppendJsonRaw(dest, "\\\"");
+        break;
+      case '\\':
+        AppendJsonRaw(dest, "\\\\");
+        break;
+      case '\n':
+        AppendJsonRaw(dest, "\\n");
+        break;
+      case '\r':
+        AppendJsonRaw(dest, "\\r");
+        break;
+      case '\t':
+        AppendJsonRaw(dest, "\\t");
+        break;
+      default:
+        fmt::format_to(std::back_inserter(dest), "\\u{:04x}", c);
+    }
+  }
+  AppendJsonRaw(dest, text.substr(run));
+  dest.push_back('"');
+}
+
+/** @brief 按原始类型追加一个值 (非有限浮点写 null，字符 / 指针写成字符串)。 */
+inline void AppendJsonValue(spdlog::memory_buf_t& dest,
+                            const z3y::interfaces::core::LogArg& value) {
+  using z3y::interfaces::core::LogArgType;
+  switch (value.type) {
+    case LogArgType::Int64:
+      fmt::format_to(std::back_inserter(dest), "{}", value.i64);
+      break;
+    case LogArgType::UInt64:
+      fmt::format_to(std::back_inserter(dest), "{}", value.u64);
+      break;
+    case LogArgType::Double:
+      if (std::isfinite(value.f64)) {
+        fmt::format_to(std::back_inserter(dest), "{}", value.f64);
+      } else {
+        AppendJsonRaw(dest, "null");
+      }
+      break;
+    case LogArgType::Bool:
+      AppendJsonRaw(dest, value.u64 ? "true" : "false");
+      break;
+    case LogArgType::Char: {
+      const char c = static_cast<char>(value.u64);
+      AppendJsonString(dest, std::string_view(&c, 1));
+      break;
+    }
+    case LogArgType::Pointer:
+      fmt::format_to(std::back_inserter(dest), "\"{}\"", value.ptr);
+      break;
+    case LogArgType::String:
+      AppendJsonString(dest, std::string_view(value.str, value.size));
+      break;
+  }
+}
+
+class json_lines_formatter final : public spdlog::formatter {
+ public:
+  void format(const spdlog::details::log_msg& msg, spdlog::memory_buf_t& dest) override {
+    const auto ts = std::chrono::duration_cast<std::chrono::milliseconds>(
+                        msg.time.time_since_epoch())
+                        .count();
+    AppendJsonRaw(dest, "{\"ts\":");
+    fmt::format_to(std::back_inserter(dest), "{}", ts);
+    AppendJsonRaw(dest, ",\"level\":");
+    AppendJsonString(dest, {spdlog::level::to_string_view(msg.level).data(),
+                            spdlog::level::to_string_view(msg.level).size()});
+    AppendJsonRaw(dest, ",\"logger\":");
+    AppendJsonString(dest, {msg.logger_name.data(), msg.logger_name.size()});
+    fmt::format_to(std::back_inserter(dest), ",\"thread\":{}", msg.thread_id);
+    AppendJsonRaw(dest, ",\"msg\":");
+    AppendJsonString(dest, {msg.payload.data(), msg.payload.size()});
+
+    if (const StructuredLogContext* context = CurrentStructuredLog()) {
+      AppendJsonRaw(dest, ",\"template\":");
+      AppendJsonString(dest, context->message_template);
+      AppendJsonRaw(dest, ",\"fields\":{");
+      for (uint32_t i = 0; i < context->field_count; ++i) {
+        if (i) dest.push_back(',');
+        AppendJsonString(dest, context->fields[i].key);
+        dest.push_back(':');
+        AppendJsonValue(dest, context->fields[i].value);
+      }
+      dest.push_back('}');
+    }
+    AppendJsonRaw(dest, "}\n");
+  }
+
+  std::unique_ptr<spdlog::formatter> clone() const override {
+    return std::make_unique<json_lines_formatter>();
+  }
+};
+
+}  // namespace log
+}  // namespace plugins
+}  // namespace z3y
+
+#endif  // Z3Y_PLUGIN_SPDLOG_JSON_LINES_FORMATTER_H_
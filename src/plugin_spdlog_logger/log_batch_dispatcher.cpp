@@ -0,0 +1,277 @@
+﻿/*
+ * Copyright [2025] [Yue Liu]
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file log_batch_dispatcher.cpp
+ * @brief LogBatchDispatcher 的实现。
+ */
+
+#include "log_batch_dispatcher.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+namespace z3y {
+namespace plugins {
+namespace log {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+/** @brief 一个攒批缓冲：记录中的字符串指针在投递前存的是 arena 内的偏移。 */
+struct Buffer {
+  std::vector<LogRecord> records;
+  std::vector<LogField> fields;  ///< 记录的 fields 存下标；字段的 key 与 String 的 str 存 arena 偏移
+  std::string arena;
+};
+
+/** @brief 把 '\0' 结尾的字符串追加到 arena，返回以指针形式保存的偏移。 */
+const char* Stash(std::string& arena, const char* text, size_t length) {
+  const size_t offset = arena.size();
+  if (text) arena.append(text, length);
+  arena.push_back('\0');
+  return reinterpret_cast<const char*>(static_cast<uintptr_t>(offset));
+}
+
+const char* Resolve(const std::string& arena, const char* stashed) {
+  return arena.data() + reinterpret_cast<uintptr_t>(stashed);
+}
+
+size_t LengthOf(const char* text) { return text ? std::strlen(text) : 0; }
+
+}  // namespace
+
+struct LogBatchDispatcher::Entry {
+  LogBatchObserverCallback callback;
+  LogBatchOptions options;
+
+  std::mutex mutex;  ///< 保护 filling / dropped / last_delivery (Feed 与投递交换缓冲时)
+  Buffer filling;
+  uint64_t dropped = 0;
+  Clock::time_point last_delivery = Clock::now();
+
+  std::mutex deliver_mutex;  ///< 串行化投递 (投递线程 / Remove / Stop)，保护以下字段
+  Buffer delivering;
+  std::vector<LogRecord> resolved;
+  bool removed = false;
+};
+
+LogBatchDispatcher::~LogBatchDispatcher() { Stop(); }
+
+LogObserverCallback LogBatchDispatcher::Add(const std::string& name,
+                                            LogBatchObserverCallback cb,
+                                            const LogBatchOptions& options) {
+  auto entry = std::make_shared<Entry>();
+  entry->callback = std::move(cb);
+  entry->options = options;
+  entry->options.interval_ms = std::max<uint32_t>(entry->options.interval_ms, 1);
+  entry->options.max_batch = std::max<uint32_t>(entry->options.max_batch, 1);
+  entry->options.capacity =
+      std::max(entry->options.capacity, entry->options.max_batch);
+  entry->filling.records.reserve(entry->options.max_batch);
+
+  Remove(name);  // 同名替换：旧观察者先把剩余记录投递完
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_[name] = entry;
+    if (!running_ && !stopped_) {
+      running_ = true;
+      worker_ = std::thread([this] { Run(); });
+    }
+  }
+
+  // Feed 只持有 Entry 与 Signal，不引用本对象
+  return [entry, signal = signal_](const LogRecord& record) {
+    const size_t name_length = record.version >= 2 ? record.logger_name_length
+                                                   : LengthOf(record.logger_name);
+    const size_t message_length =
+        record.version >= 2 ? record.message_length : LengthOf(record.message);
+    bool batch_ready = false;
+    {
+      std::lock_guard<std::mutex> lock(entry->mutex);
+      Buffer& buffer = entry->filling;
+      if (buffer.records.size() >= entry->options.capacity) {
+        ++entry->dropped;
+        return;
+      }
+      LogRecord copy = record;
+      copy.logger_name = Stash(buffer.arena, record.logger_name, name_length);
+      copy.message = Stash(buffer.arena, record.message, message_length);
+      // 源码位置在调用方模块里，攒批期间该模块可能已卸载，同样拷贝
+      copy.file_name = Stash(buffer.arena, record.file_name, LengthOf(record.file_name));
+      copy.func_name = Stash(buffer.arena, record.func_name, LengthOf(record.func_name));
+      copy.logger_name_length = static_cast<uint32_t>(name_length);
+      copy.message_length = static_cast<uint32_t>(message_length);
+      if (record.version >= 3 && record.message_template) {
+        // 模板与源码位置一样在调用方模块里 (偏移必大于 0，与 nullptr 可区分)
+        copy.message_template = Stash(buffer.arena, record.message_template,
+                                      LengthOf(record.message_template));
+        copy.fields = reinterpret_cast<const LogField*>(
+            static_cast<uintptr_t>(buffer.fields.size()));
+        for (uint32_t i = 0; i < record.field_count; ++i) {
+          LogField field = record.fields[i];
+          field.key = Stash(buffer.arena, field.key, LengthOf(field.key));
+          if (field.value.type == LogArgType::String) {
+            field.value.str = Stash(buffer.arena, field.value.str, field.value.size);
+          }
+          buffer.fields.push_back(field);
+        }
+      } else {
+        copy.fields = nullptr;
+        copy.field_count = 0;
+        copy.message_template = nullptr;
+      }
+      buffer.records.push_back(copy);
+      batch_ready = buffer.records.size() == entry->options.max_batch;
+    }
+    if (batch_ready) {
+      {
+        std::lock_guard<std::mutex> lock(signal->mutex);
+        signal->pending = true;
+      }
+      signal->cv.notify_one();
+    }
+  };
+}
+
+void LogBatchDispatcher::Deliver(Entry& entry) {
+  std::lock_guard<std::mutex> deliver_lock(entry.deliver_mutex);
+  if (entry.removed) return;
+  uint64_t dropped;
+  {
+    std::lock_guard<std::mutex> lock(entry.mutex);
+    std::swap(entry.filling, entry.delivering);
+    dropped = entry.dropped;
+    entry.dropped = 0;
+    entry.last_delivery = Clock::now();
+  }
+  Buffer& buffer = entry.delivering;
+  if (buffer.records.empty() && dropped == 0) return;
+
+  entry.resolved.assign(buffer.records.begin(), buffer.records.end());
+  for (LogRecord& r : entry.resolved) {
+    r.logger_name = Resolve(buffer.arena, r.logger_name);
+    r.message = Resolve(buffer.arena, r.message);
+    r.file_name = Resolve(buffer.arena, r.file_name);
+    r.func_name = Resolve(buffer.arena, r.func_name);
+    if (r.message_template) {
+      r.message_template = Resolve(buffer.arena, r.message_template);
+      LogField* fields = buffer.fields.data() + reinterpret_cast<uintptr_t>(r.fields);
+      for (uint32_t i = 0; i < r.field_count; ++i) {
+        fields[i].key = Resolve(buffer.arena, fields[i].key);
+        if (fields[i].value.type == LogArgType::String) {
+          fields[i].value.str = Resolve(buffer.arena, fields[i].value.str);
+        }
+      }
+      r.fields = fields;
+    }
+  }
+  // 投递线程唤醒前缓冲可能已超过 max_batch，按 max_batch 切片回调
+  const size_t total = entry.resolved.size();
+  size_t offset = 0;
+  do {
+    LogBatch batch{};
+    batch.struct_size = static_cast<uint32_t>(sizeof(LogBatch));
+    batch.version = 1;
+    batch.records = entry.resolved.data() + offset;
+    batch.count = std::min<size_t>(total - offset, entry.options.max_batch);
+    batch.dropped = offset == 0 ? dropped : 0;
+    offset += batch.count;
+    try {
+      entry.callback(batch);
+    } catch (...) {
+      // UI 回调的异常不能打断投递线程
+    }
+  } while (offset < total);
+  // 保留容量，下一轮交换回来继续使用
+  buffer.records.clear();
+  buffer.fields.clear();
+  buffer.arena.clear();
+}
+
+bool LogBatchDispatcher::Remove(const std::string& name) {
+  std::shared_ptr<Entry> entry;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(name);
+    if (it == entries_.end()) return false;
+    entry = std::move(it->second);
+    entries_.erase(it);
+  }
+  Deliver(*entry);
+  std::lock_guard<std::mutex> deliver_lock(entry->deliver_mutex);
+  entry->removed = true;  // 投递线程手里可能还有它的引用
+  return true;
+}
+
+void LogBatchDispatcher::Stop() {
+  std::map<std::string, std::shared_ptr<Entry>> entries;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stopped_) return;
+    stopped_ = true;
+    running_ = false;
+    entries.swap(entries_);
+  }
+  {
+    std::lock_guard<std::mutex> lock(signal_->mutex);
+    signal_->pending = true;
+  }
+  signal_->cv.notify_all();
+  if (worker_.joinable()) worker_.join();
+  for (auto& [name, entry] : entries) {
+    Deliver(*entry);
+    std::lock_guard<std::mutex> deliver_lock(entry->deliver_mutex);
+    entry->removed = true;
+  }
+}
+
+void LogBatchDispatcher::Run() {
+  for (;;) {
+    std::vector<std::shared_ptr<Entry>> due;
+    const auto now = Clock::now();
+    auto next_wake = now + std::chrono::milliseconds(100);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (!running_) return;
+      for (const auto& [name, entry] : entries_) {
+        const auto interval = std::chrono::milliseconds(entry->options.interval_ms);
+        std::lock_guard<std::mutex> entry_lock(entry->mutex);
+        const bool has_data = !entry->filling.records.empty() || entry->dropped;
+        const auto deadline = entry->last_delivery + interval;
+        if (has_data && (entry->filling.records.size() >= entry->options.max_batch ||
+                         now >= deadline)) {
+          due.push_back(entry);
+        } else {
+          next_wake = std::min(next_wake, has_data ? deadline : now + interval);
+        }
+      }
+    }
+
+    for (const auto& entry : due) Deliver(*entry);
+    if (!due.empty()) continue;
+
+    std::unique_lock<std::mutex> lock(signal_->mutex);
+    signal_->cv.wait_until(lock, next_wake, [this] { return signal_->pending; });
+    signal_->pending = false;
+  }
+}
+
+}  // namespace log
+}  // namespace plugins
+}  // namespace z3y
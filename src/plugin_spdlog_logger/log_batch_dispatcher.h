@@ -0,0 +1,108 @@
+﻿/*
+ * Copyright [2025] [Yue Liu]
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file log_batch_dispatcher.h
+ * @brief [内部] 批量日志观察者 (AddLogBatchObserver) 的攒批缓冲与投递线程。
+ *
+ * @details
+ * [设计]
+ * 1. **接入**: 每个批量观察者在 Observer Sink 上登记一个逐条回调 (Feed)，
+ * 它只把记录拷进该观察者的缓冲区：LogRecord 数组 + 一段连续的字符串区，
+ * 字符串指针先存为偏移，投递前再换算，攒批期间不逐条分配内存。
+ * 2. **投递**: 一个投递线程服务全部批量观察者；攒够 max_batch 条时 Feed 唤醒它，
+ * 否则按 interval_ms 定时投递。投递时交换双缓冲，回调在缓冲区锁之外执行，
+ * 每次回调不超过 max_batch 条。
+ * 3. **有界**: 两次投递之间超过 capacity 条时丢弃新日志，下一批的 dropped 报告条数。
+ */
+
+#pragma once
+
+#ifndef Z3Y_PLUGIN_SPDLOG_LOG_BATCH_DISPATCHER_H_
+#define Z3Y_PLUGIN_SPDLOG_LOG_BATCH_DISPATCHER_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "interfaces_core/i_log_service.h"
+
+namespace z3y {
+namespace plugins {
+namespace log {
+
+using namespace z3y::interfaces::core;
+
+/**
+ * @class LogBatchDispatcher
+ * @brief 批量观察者表 + 投递线程。所有公有方法线程安全。
+ */
+class LogBatchDispatcher {
+ public:
+  LogBatchDispatcher() = default;
+  ~LogBatchDispatcher();
+
+  LogBatchDispatcher(const LogBatchDispatcher&) = delete;
+  LogBatchDispatcher& operator=(const LogBatchDispatcher&) = delete;
+
+  /**
+   * @brief 登记 (或替换) 一个批量观察者，首次调用时启动投递线程。
+   * @return 交给 Observer Sink 的逐条回调。
+   */
+  LogObserverCallback Add(const std::string& name, LogBatchObserverCallback cb,
+                          const LogBatchOptions& options);
+
+  /**
+   * @brief 注销批量观察者：投递剩余记录后返回，之后不再回调。
+   * @details 调用方须先从 Observer Sink 上摘掉它的 Feed。
+   * @return false 表示没有这个名字的批量观察者。
+   */
+  bool Remove(const std::string& name);
+
+  /** @brief 停止投递线程 (幂等)。剩余记录投递一次后丢弃。 */
+  void Stop();
+
+ private:
+  struct Entry;
+  /** @brief Feed 攒够一批时唤醒投递线程。与 Feed 共享所有权，Feed 可比本对象活得久。 */
+  struct Signal {
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool pending = false;
+  };
+
+  void Run();
+  static void Deliver(Entry& entry);
+
+  std::mutex mutex_;  ///< 保护 entries_ / running_ / stopped_ / worker_
+  std::shared_ptr<Signal> signal_ = std::make_shared<Signal>();
+  std::map<std::string, std::shared_ptr<Entry>> entries_;
+  bool running_ = false;
+  bool stopped_ = false;
+  std::thread worker_;
+};
+
+}  // namespace log
+}  // namespace plugins
+}  // namespace z3y
+
+#endif  // Z3Y_PLUGIN_SPDLOG_LOG_BATCH_DISPATCHER_H_
@@ -0,0 +1,108 @@
+﻿/*
+ * Copyright [2025] [Yue Liu]
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file log_rate_limiter.cpp
+ * @brief LogRateLimiter 的实现。
+ */
+
+#include "log_rate_limiter.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace z3y {
+namespace plugins {
+namespace log {
+
+namespace {
+
+constexpr int64_t kNanosPerSecond = 1000000000;
+
+/** @brief GCRA 判定：放行时把 TAT 推进一个间隔。 */
+bool Conform(std::atomic<int64_t>& tat, int64_t now, int64_t interval,
+             int64_t tolerance) noexcept {
+  int64_t current = tat.load(std::memory_order_relaxed);
+  for (;;) {
+    const int64_t base = std::max(current, now);
+    if (base - now > tolerance) return false;
+    if (tat.compare_exchange_weak(current, base + interval,
+                                  std::memory_order_relaxed)) {
+      return true;
+    }
+  }
+}
+
+}  // namespace
+
+LogRateLimiter::LogRateLimiter(const LogRateLimit& limit)
+    : limit_(limit),
+      rate_interval_ns_(limit.per_second ? kNanosPerSecond / limit.per_second : 0),
+      rate_tolerance_ns_(rate_interval_ns_ *
+                         (static_cast<int64_t>(limit.burst ? limit.burst : limit.per_second) - 1)),
+      dedup_window_ns_(static_cast<int64_t>(limit.dedup_window_ms) * 1000000) {
+  if (limit.per_call_site || dedup_window_ns_ > 0) {
+    sites_ = std::make_unique<Slot[]>(kCallSiteSlots);
+  }
+}
+
+bool LogRateLimiter::IsUnlimited(const LogRateLimit& limit) noexcept {
+  return limit.per_second == 0 && limit.dedup_window_ms == 0;
+}
+
+LogRateLimiter::Slot* LogRateLimiter::FindSlot(const LogSourceLocation& loc) noexcept {
+  // 宏传入的 __FILE__ 是模块内的静态字符串，指针 + 行号即可唯一标识调用点
+  uint64_t key = reinterpret_cast<uintptr_t>(loc.file_name) * 0x9E3779B97F4A7C15ull ^
+                 static_cast<uint64_t>(static_cast<uint32_t>(loc.line_number));
+  key = (key ^ (key >> 29)) | 1;  // 保证非 0
+  for (size_t probe = 0; probe < kMaxProbe; ++probe) {
+    Slot& slot = sites_[(key + probe) & (kCallSiteSlots - 1)];
+    uint64_t current = slot.key.load(std::memory_order_acquire);
+    if (current == key) return &slot;
+    if (current == 0 &&
+        (slot.key.compare_exchange_strong(current, key, std::memory_order_acq_rel) ||
+         current == key)) {
+      return &slot;
+    }
+  }
+  return &logger_slot_;
+}
+
+bool LogRateLimiter::Admit(const LogSourceLocation& loc, uint64_t* suppressed) noexcept {
+  const int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                          std::chrono::steady_clock::now().time_since_epoch())
+                          .count();
+  Slot* site = sites_ ? FindSlot(loc) : &logger_slot_;
+  Slot& rate_slot = limit_.per_call_site ? *site : logger_slot_;
+
+  // 先限速再去重：被限速拒绝的日志不会占用去重窗口
+  const bool admitted =
+      (rate_interval_ns_ == 0 ||
+       Conform(rate_slot.rate_tat, now, rate_interval_ns_, rate_tolerance_ns_)) &&
+      (dedup_window_ns_ == 0 || Conform(site->dedup_tat, now, dedup_window_ns_, 0));
+  if (!admitted) {
+    site->suppressed.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  *suppressed = site->suppressed.load(std::memory_order_relaxed)
+                    ? site->suppressed.exchange(0, std::memory_order_relaxed)
+                    : 0;
+  return true;
+}
+
+}  // namespace log
+}  // namespace plugins
+}  // namespace z3y
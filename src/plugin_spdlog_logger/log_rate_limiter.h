@@ -0,0 +1,93 @@
+﻿/*
+ * Copyright [2025] [Yue Liu]
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file log_rate_limiter.h
+ * @brief [内部] ILogger::Admit 背后的令牌桶限流与调用点去重。
+ *
+ * @details
+ * [设计]
+ * 1. **GCRA**: 令牌桶用 "理论到达时间" (TAT) 表示，每个桶只有一个 atomic<int64_t>，
+ * 判定是一次 CAS，不加锁。速率 r、容量 b 时间隔 = 1s / r，容差 = (b - 1) * 间隔。
+ * 去重窗口 w 等价于间隔 w、容差 0 的桶。
+ * 2. **调用点表**: 按 (文件名指针, 行号) 哈希到固定大小的开放寻址表，槽位一经占用
+ * 不再释放；探测失败 (表满) 时退回 Logger 级的公共桶。
+ * 3. **丢弃计数**: 被拒绝的条数累加在对应槽位上，下一次放行时取出，由 LoggerImpl
+ * 补一条提示日志。
+ */
+
+#pragma once
+
+#ifndef Z3Y_PLUGIN_SPDLOG_LOG_RATE_LIMITER_H_
+#define Z3Y_PLUGIN_SPDLOG_LOG_RATE_LIMITER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include "interfaces_core/i_log_service.h"
+
+namespace z3y {
+namespace plugins {
+namespace log {
+
+using namespace z3y::interfaces::core;
+
+class LogRateLimiter {
+ public:
+  static constexpr size_t kCallSiteSlots = 256;  ///< 2 的幂
+  static constexpr size_t kMaxProbe = 8;
+
+  explicit LogRateLimiter(const LogRateLimit& limit);
+
+  /** @brief per_second 与 dedup_window_ms 都为 0。 */
+  static bool IsUnlimited(const LogRateLimit& limit) noexcept;
+
+  /**
+   * @brief 判定一条日志是否放行。线程安全、无锁。
+   * @param[out] suppressed 放行时写入此前该桶累计丢弃的条数 (并清零)。
+   */
+  bool Admit(const LogSourceLocation& loc, uint64_t* suppressed) noexcept;
+
+  /** @brief 丢弃计数是否按调用点统计 (决定提示日志的措辞)。 */
+  bool counts_per_call_site() const noexcept { return sites_ != nullptr; }
+
+  const LogRateLimit& limit() const noexcept { return limit_; }
+
+ private:
+  struct Slot {
+    std::atomic<uint64_t> key{0};  ///< 0 = 空槽
+    std::atomic<int64_t> rate_tat{0};
+    std::atomic<int64_t> dedup_tat{0};
+    std::atomic<uint64_t> suppressed{0};
+  };
+
+  Slot* FindSlot(const LogSourceLocation& loc) noexcept;
+
+  const LogRateLimit limit_;
+  const int64_t rate_interval_ns_;   ///< 0 = 不限速
+  const int64_t rate_tolerance_ns_;
+  const int64_t dedup_window_ns_;    ///< 0 = 不去重
+
+  Slot logger_slot_;              ///< Logger 级的桶，也是调用点表满时的退路
+  std::unique_ptr<Slot[]> sites_;  ///< 按调用点限速或去重时才分配
+};
+
+}  // namespace log
+}  // namespace plugins
+}  // namespace z3y
+
+#endif  // Z3Y_PLUGIN_SPDLOG_LOG_RATE_LIMITER_H_
@@ -0,0 +1,118 @@
+﻿/*
+ * Copyright [2025] [Yue Liu]
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file log_socket.cpp
+ * @brief log_socket.h 的平台实现。
+ */
+
+#include "log_socket.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <netdb.h>
+#include <sys/socket.h>
+#endif
+
+namespace z3y {
+namespace plugins {
+namespace log {
+
+namespace {
+
+/** @brief 非阻塞连接并在 timeout_ms 内等待完成 (UDP 的 connect 只记录默认目的地址)。 */
+bool ConnectWithin(SocketHandle s, const addrinfo* ai, int timeout_ms) {
+#ifdef _WIN32
+  if (::connect(static_cast<SOCKET>(s), ai->ai_addr, static_cast<int>(ai->ai_addrlen)) == 0) {
+    return true;
+  }
+#else
+  if (::connect(s, ai->ai_addr, ai->ai_addrlen) == 0) return true;
+#endif
+  return net::WouldBlock() && net::WaitSocket(s, true, timeout_ms) &&
+         net::ConnectSucceeded(s);
+}
+
+}  // namespace
+
+std::string LocalHostName() { return net::LocalHostName("localhost"); }
+
+bool LogSocket::Open(const std::string& target, bool tcp, int timeout_ms,
+                     std::string& error) {
+  Close();
+  std::string host, port;
+  if (!net::SplitHostPort(target, host, port)) {
+    error = "expected 'host:port', got '" + target + "'";
+    return false;
+  }
+  if (!net::EnsureSockets()) {
+    error = "socket library initialization failed";
+    return false;
+  }
+  addrinfo hints{};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = tcp ? SOCK_STREAM : SOCK_DGRAM;
+  addrinfo* res = nullptr;
+  if (::getaddrinfo(host.c_str(), port.c_str(), &hints, &res) != 0) {
+    error = "cannot resolve '" + target + "'";
+    return false;
+  }
+  for (addrinfo* ai = res; ai; ai = ai->ai_next) {
+    SocketHandle s = static_cast<SocketHandle>(
+        ::socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol));
+    if (s == kInvalidSocket) continue;
+    if (net::SetNonBlocking(s) && ConnectWithin(s, ai, timeout_ms)) {
+      socket_ = s;
+      break;
+    }
+    net::CloseSocket(s);
+  }
+  ::freeaddrinfo(res);
+  if (socket_ == kInvalidSocket) {
+    error = "cannot connect to '" + target + "'";
+    return false;
+  }
+  tcp_ = tcp;
+  return true;
+}
+
+void LogSocket::Close() {
+  net::CloseSocket(socket_);
+  socket_ = kInvalidSocket;
+}
+
+bool LogSocket::Send(const std::string& data, int timeout_ms) {
+  if (socket_ == kInvalidSocket || data.empty()) return false;
+  size_t sent = 0;
+  while (sent < data.size()) {
+    // UDP 不等待：数据报要么整个进入发送缓冲区，要么丢弃
+    if (tcp_ && !net::WaitSocket(socket_, true, timeout_ms)) return false;
+    const long n = net::SendBytes(socket_, data.data() + sent, data.size() - sent);
+    if (n <= 0) return false;
+    if (!tcp_) return true;
+    sent += static_cast<size_t>(n);
+  }
+  return true;
+}
+
+}  // namespace log
+}  // namespace plugins
+}  // namespace z3y
@@ -0,0 +1,80 @@
+﻿/*
+ * Copyright [2025] [Yue Liu]
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file log_socket.h
+ * @brief [内部] 网络日志 Sink 使用的最小化 TCP / UDP 发送端（BSD Socket 与 Winsock 通用）。
+ *
+ * @details
+ * 只有发送方向：连接与发送都带超时，收集端不可达时最多阻塞 network_log_sink 的发送线程
+ * timeout_ms，不会无限期挂住。平台差异由 z3y_socket_common 处理。
+ */
+
+#pragma once
+
+#ifndef Z3Y_PLUGIN_SPDLOG_LOG_SOCKET_H_
+#define Z3Y_PLUGIN_SPDLOG_LOG_SOCKET_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "z3y_socket_common/socket_common.h"
+
+namespace z3y {
+namespace plugins {
+namespace log {
+
+using net::SocketHandle;
+using net::kInvalidSocket;
+
+/** @brief 本机主机名 (syslog / GELF 的 host 字段)；取不到时返回 "localhost"。 */
+std::string LocalHostName();
+
+/**
+ * @brief 向固定的 "host:port" 发送数据：UDP 为数据报，TCP 为字节流。
+ */
+class LogSocket {
+ public:
+  LogSocket() = default;
+  ~LogSocket() { Close(); }
+  LogSocket(const LogSocket&) = delete;
+  LogSocket& operator=(const LogSocket&) = delete;
+
+  /**
+   * @brief 解析 target 并创建套接字；TCP 在 timeout_ms 内完成连接。
+   * @return 失败时 error 中给出原因。
+   */
+  bool Open(const std::string& target, bool tcp, int timeout_ms, std::string& error);
+  void Close();
+  bool IsOpen() const { return socket_ != kInvalidSocket; }
+
+  /**
+   * @brief 发送一段数据。UDP 为一个数据报 (发送缓冲区满时直接丢弃)；
+   * TCP 在 timeout_ms 内发完，对端关闭或超时视为失败。
+   */
+  bool Send(const std::string& data, int timeout_ms);
+
+ private:
+  SocketHandle socket_ = kInvalidSocket;
+  bool tcp_ = false;
+};
+
+}  // namespace log
+}  // namespace plugins
+}  // namespace z3y
+
+#endif  // Z3Y_PLUGIN_SPDLOG_LOG_SOCKET_H_
@@ -0,0 +1,302 @@
+﻿/*
+ * Copyright [2025] [Yue Liu]
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file logger_lookup.h
+ * @brief [内部] GetLogger 的无锁名字表与 Logger 名字树。
+ *
+ * @details
+ * [设计]
+ * 1. **LoggerNameTable**: 开放寻址 (线性探测) 的哈希表，键为 Logger 名字的
+ * FNV-1a 哈希 + 名字本身。只插入不删除；读者只做 acquire load，不加锁。
+ * 扩容时整表重建后原子替换，旧表与节点保留到表析构，正在探测旧表的读者不受影响。
+ * 写者须由调用方串行 (SpdlogProviderService 在 provider_lock_ 写锁下插入)。
+ * 2. **LoggerTree**: Logger 名字的字符前缀树。Rule 的 matcher、SetLevel / SetRateLimit
+ * 的前缀与已创建的 Logger 都挂在对应节点上：
+ * - 创建 Logger 时沿名字走一遍，路径上最深的 Rule / 覆写即为生效值 (继承)，O(名字长度)；
+ * - 覆写某前缀时只遍历该节点的子树，同时清掉子树里更深的同类覆写 (它们匹配的名字
+ * 全都被新覆写盖住，后设置优先的语义因此等价于 "最深者优先")。
+ * 按字符而不是按 '.' 分段建树：SetLevel("Cam") 照旧匹配 "Camera.3"，
+ * 点分名字 ("Camera.3.Exposure") 的公共前缀自然共用节点。
+ */
+
+#pragma once
+
+#ifndef Z3Y_PLUGIN_SPDLOG_LOGGER_LOOKUP_H_
+#define Z3Y_PLUGIN_SPDLOG_LOGGER_LOOKUP_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <spdlog/common.h>
+
+#include "interfaces_core/i_log_service.h"
+
+namespace z3y {
+namespace plugins {
+namespace log {
+
+/**
+ * @class LoggerNameTable
+ * @brief 名字 -> shared_ptr<T> 的只增哈希表。Find 无锁，Insert 须由调用方串行。
+ */
+template <typename T>
+class LoggerNameTable {
+ public:
+  explicit LoggerNameTable(size_t initial_capacity = 256) {
+    size_t capacity = 16;
+    while (capacity < initial_capacity) capacity <<= 1;
+    Publish(std::make_unique<Table>(capacity));
+  }
+
+  LoggerNameTable(const LoggerNameTable&) = delete;
+  LoggerNameTable& operator=(const LoggerNameTable&) = delete;
+
+  /** @brief FNV-1a 64 位哈希。调用方算一次，Find / Insert 共用。 */
+  static constexpr uint64_t Hash(std::string_view name) noexcept {
+    uint64_t hash = 14695981039346656037ull;
+    for (char c : name) {
+      hash ^= static_cast<unsigned char>(c);
+      hash *= 1099511628211ull;
+    }
+    return hash;
+  }
+
+  /** @brief 无锁查找，未命中返回 nullptr。 */
+  std::shared_ptr<T> Find(std::string_view name, uint64_t hash) const {
+    const Table* table = current_.load(std::memory_order_acquire);
+    for (size_t i = hash & table->mask;; i = (i + 1) & table->mask) {
+      const Node* node = table->slots[i].load(std::memory_order_acquire);
+      if (!node) return nullptr;
+      if (node->hash == hash && node->name == name) return node->value;
+    }
+  }
+
+  /** @brief 插入新名字 (调用方保证名字尚不存在，且写者互斥)。 */
+  void Insert(std::string name, uint64_t hash, std::shared_ptr<T> value) {
+    nodes_.push_back(std::make_unique<Node>(
+        Node{hash, std::move(name), std::move(value)}));
+    const Node* node = nodes_.back().get();
+
+    const Table* table = current_.load(std::memory_order_relaxed);
+    // 负载因子保持在 1/2 以下，探测链短且必有空槽
+    if (nodes_.size() * 2 > table->mask + 1) {
+      auto grown = std::make_unique<Table>((table->mask + 1) * 2);
+      for (const auto& existing : nodes_) {
+        if (existing.get() != node) Place(*grown, existing.get());
+      }
+      Place(*grown, node);
+      Publish(std::move(grown));
+      return;
+    }
+    Place(*table, node);
+  }
+
+ private:
+  struct Node {
+    uint64_t hash;
+    std::string name;
+    std::shared_ptr<T> value;
+  };
+
+  struct Table {
+    explicit Table(size_t capacity)
+        : mask(capacity - 1),
+          slots(new std::atomic<const Node*>[capacity]) {
+      for (size_t i = 0; i < capacity; ++i) {
+        slots[i].store(nullptr, std::memory_order_relaxed);
+      }
+    }
+    size_t mask;
+    std::unique_ptr<std::atomic<const Node*>[]> slots;
+  };
+
+  static void Place(const Table& table, const Node* node) {
+    size_t i = node->hash & table.mask;
+    while (table.slots[i].load(std::memory_order_relaxed)) {
+      i = (i + 1) & table.mask;
+    }
+    // release：读者看到槽位时，节点内容已完整可见
+    table.slots[i].store(node, std::memory_order_release);
+  }
+
+  void Publish(std::unique_ptr<Table> table) {
+    current_.store(table.get(), std::memory_order_release);
+    tables_.push_back(std::move(table));
+  }
+
+  std::atomic<const Table*> current_{nullptr};
+  std::vector<std::unique_ptr<Table>> tables_;  ///< 含已替换的旧表，析构时统一释放
+  std::vector<std::unique_ptr<Node>> nodes_;
+};
+
+/**
+ * @class LoggerTree
+ * @brief Logger 名字的字符前缀树：Rule、级别 / 限流覆写按最深前缀继承，Logger 挂在名字节点上。
+ * @details 不加锁，调用方串行 (SpdlogProviderService 在 provider_lock_ 写锁下访问)。
+ * 只保存 Logger 的裸指针，所有权在 logger_cache_。
+ */
+template <typename T>
+class LoggerTree {
+ public:
+  /** @brief 名字路径上的继承结果。 */
+  struct Resolved {
+    int rule = -1;                                    ///< 最深的 Rule 下标，-1 = default_rule
+    spdlog::level::level_enum level = spdlog::level::trace;  ///< 覆写级别，无覆写为 trace
+    std::optional<z3y::interfaces::core::LogRateLimit> rate_limit;  ///< 限流覆写
+  };
+
+  LoggerTree() : nodes_(1) {}
+
+  /** @brief 挂一条 Rule；同一 matcher 已有 Rule 时保留先挂的 (下标较小者)。 */
+  void AddRule(std::string_view matcher, int index) {
+    Node& node = nodes_[Walk(matcher)];
+    if (node.rule < 0) node.rule = index;
+  }
+
+  /** @brief 沿名字取继承值。 */
+  Resolved Resolve(std::string_view name) const {
+    Resolved resolved;
+    size_t current = 0;
+    Inherit(nodes_[0], resolved);
+    for (char c : name) {
+      const int next = Child(current, c);
+      if (next < 0) break;
+      current = static_cast<size_t>(next);
+      Inherit(nodes_[current], resolved);
+    }
+    return resolved;
+  }
+
+  /** @brief 把新建的 Logger 挂到名字节点上。 */
+  void Attach(std::string_view name, T* logger) {
+    nodes_[Walk(name)].loggers.push_back(logger);
+  }
+
+  /**
+   * @brief 覆写前缀下所有 Logger 的级别 (含将来创建的)，对子树内已有 Logger 调用 apply。
+   * @return 受影响的 Logger 数。
+   */
+  template <typename Fn>
+  size_t SetLevel(std::string_view prefix, spdlog::level::level_enum level, Fn&& apply) {
+    const size_t root = Walk(prefix);
+    nodes_[root].level = level;
+    return VisitSubtree(root, [&](Node& node, bool descendant) {
+      if (descendant) node.level.reset();
+      for (T* logger : node.loggers) apply(*logger);
+    });
+  }
+
+  /** @brief 覆写前缀下所有 Logger 的限流参数，语义同 SetLevel。 */
+  template <typename Fn>
+  size_t SetRateLimit(std::string_view prefix,
+                      const z3y::interfaces::core::LogRateLimit& limit, Fn&& apply) {
+    const size_t root = Walk(prefix);
+    nodes_[root].rate_limit = limit;
+    return VisitSubtree(root, [&](Node& node, bool descendant) {
+      if (descendant) node.rate_limit.reset();
+      for (T* logger : node.loggers) apply(*logger);
+    });
+  }
+
+  /** @brief 遍历全部 Logger，连同各自的继承结果 (一次深度优先，不逐个回溯路径)。 */
+  template <typename Fn>
+  void ForEach(Fn&& fn) const {
+    std::vector<std::pair<size_t, Resolved>> stack;
+    Resolved root;
+    Inherit(nodes_[0], root);
+    stack.emplace_back(0, root);
+    while (!stack.empty()) {
+      auto [index, resolved] = std::move(stack.back());
+      stack.pop_back();
+      const Node& node = nodes_[index];
+      for (T* logger : node.loggers) fn(*logger, resolved);
+      for (const auto& [ch, child] : node.children) {
+        Resolved inherited = resolved;
+        Inherit(nodes_[child], inherited);
+        stack.emplace_back(static_cast<size_t>(child), std::move(inherited));
+      }
+    }
+  }
+
+ private:
+  struct Node {
+    std::vector<std::pair<char, int>> children;
+    int rule = -1;
+    std::optional<spdlog::level::level_enum> level;
+    std::optional<z3y::interfaces::core::LogRateLimit> rate_limit;
+    std::vector<T*> loggers;
+  };
+
+  static void Inherit(const Node& node, Resolved& resolved) {
+    if (node.rule >= 0) resolved.rule = node.rule;
+    if (node.level) resolved.level = *node.level;
+    if (node.rate_limit) resolved.rate_limit = node.rate_limit;
+  }
+
+  int Child(size_t node, char c) const {
+    for (const auto& [ch, index] : nodes_[node].children) {
+      if (ch == c) return index;
+    }
+    return -1;
+  }
+
+  /** @brief 走到名字对应的节点，沿途缺的节点补建。 */
+  size_t Walk(std::string_view name) {
+    size_t current = 0;
+    for (char c : name) {
+      int next = Child(current, c);
+      if (next < 0) {
+        next = static_cast<int>(nodes_.size());
+        nodes_[current].children.emplace_back(c, next);
+        nodes_.emplace_back();
+      }
+      current = static_cast<size_t>(next);
+    }
+    return current;
+  }
+
+  /** @brief 深度优先访问子树，visit(node, 是否为后代)；返回子树内 Logger 总数。 */
+  template <typename Fn>
+  size_t VisitSubtree(size_t root, Fn&& visit) {
+    size_t count = 0;
+    std::vector<size_t> stack{root};
+    while (!stack.empty()) {
+      const size_t index = stack.back();
+      stack.pop_back();
+      visit(nodes_[index], index != root);
+      count += nodes_[index].loggers.size();
+      for (const auto& [ch, child] : nodes_[index].children) {
+        stack.push_back(static_cast<size_t>(child));
+      }
+    }
+    return count;
+  }
+
+  std::vector<Node> nodes_;  ///< nodes_[0] 为根 (空前缀)
+};
+
+}  // namespace log
+}  // namespace plugins
+}  // namespace z3y
+
+#endif  // Z3Y_PLUGIN_SPDLOG_LOGGER_LOOKUP_H_
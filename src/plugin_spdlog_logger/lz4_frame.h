@@ -0,0 +1,291 @@
+﻿/*
+ * Copyright [2025] [Yue Liu]
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file lz4_frame.h
+ * @brief [内部] 自带的 LZ4 块压缩与 LZ4 帧封装 (无第三方依赖)。
+ *
+ * @details
+ * 输出为标准 LZ4 Frame (magic 0x184D2204，块独立，64KB 块，无内容校验)，
+ * 可直接用 `lz4 -d` / `lz4cat` 解压。压缩器是单哈希表的贪心匹配 (与 LZ4 fast 同类)，
+ * 用于日志这种高重复文本已足够；level 越高跳跃越少、压缩率越好。
+ * 解压函数供测试与诊断使用，容忍缺少 EndMark 的帧 (正在写入的活动段)。
+ */
+
+#pragma once
+
+#ifndef Z3Y_PLUGIN_SPDLOG_LZ4_FRAME_H_
+#define Z3Y_PLUGIN_SPDLOG_LZ4_FRAME_H_
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace z3y {
+namespace plugins {
+namespace log {
+namespace lz4 {
+
+inline constexpr uint32_t kFrameMagic = 0x184D2204u;
+inline constexpr size_t kBlockSize = 64 * 1024;  ///< BD 中的块大小 ID 4
+inline constexpr int kMinLevel = 1;
+inline constexpr int kMaxLevel = 9;
+
+namespace detail {
+
+inline uint32_t Read32(const uint8_t* p) {
+  uint32_t v;
+  std::memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+inline void PutLE32(std::string& out, uint32_t v) {
+  const char bytes[4] = {static_cast<char>(v), static_cast<char>(v >> 8),
+                         static_cast<char>(v >> 16), static_cast<char>(v >> 24)};
+  out.append(bytes, 4);
+}
+
+inline uint32_t GetLE32(const uint8_t* p) {
+  return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) |
+         (uint32_t(p[3]) << 24);
+}
+
+inline uint32_t Rotl32(uint32_t x, int r) { return (x << r) | (x >> (32 - r)); }
+
+/** @brief XXH32 (帧头校验字节需要)。 */
+inline uint32_t Xxh32(const uint8_t* p, size_t len, uint32_t seed) {
+  constexpr uint32_t k1 = 2654435761u, k2 = 2246822519u, k3 = 3266489917u,
+                     k4 = 668265263u, k5 = 374761393u;
+  const uint8_t* const end = p + len;
+  uint32_t h;
+  if (len >= 16) {
+    uint32_t v1 = seed + k1 + k2, v2 = seed + k2, v3 = seed, v4 = seed - k1;
+    const uint8_t* const limit = end - 16;
+    do {
+      v1 = Rotl32(v1 + GetLE32(p) * k2, 13) * k1;
+      v2 = Rotl32(v2 + GetLE32(p + 4) * k2, 13) * k1;
+      v3 = Rotl32(v3 + GetLE32(p + 8) * k2, 13) * k1;
+      v4 = Rotl32(v4 + GetLE32(p + 12) * k2, 13) * k1;
+      p += 16;
+    } while (p <= limit);
+    h = Rotl32(v1, 1) + Rotl32(v2, 7) + Rotl32(v3, 12) + Rotl32(v4, 18);
+  } else {
+    h = seed + k5;
+  }
+  h += static_cast<uint32_t>(len);
+  while (p + 4 <= end) {
+    h = Rotl32(h + GetLE32(p) * k3, 17) * k4;
+    p += 4;
+  }
+  while (p < end) {
+    h = Rotl32(h + (*p++) * k5, 11) * k1;
+  }
+  h ^= h >> 15;
+  h *= k2;
+  h ^= h >> 13;
+  h *= k3;
+  h ^= h >> 16;
+  return h;
+}
+
+inline void PutLength(uint8_t*& op, size_t length) {
+  while (length >= 255) {
+    *op++ = 255;
+    length -= 255;
+  }
+  *op++ = static_cast<uint8_t>(length);
+}
+
+}  // namespace detail
+
+/** @brief 压缩输出的最坏长度。 */
+constexpr size_t CompressBound(size_t n) { return n + n / 255 + 16; }
+
+/**
+ * @brief 压缩一个 LZ4 块。
+ * @param dst 至少 CompressBound(n) 字节。
+ * @param level 1 (最快) ~ 9 (压缩率最好)。
+ * @return 压缩后的字节数。
+ */
+inline size_t CompressBlock(const char* source, size_t n, char* dst, int level) {
+  constexpr int kHashBits = 12;
+  constexpr size_t kMinMatch = 4, kLastLiterals = 5, kMatchFindLimit = 12;
+  const auto* src = reinterpret_cast<const uint8_t*>(source);
+  auto* op = reinterpret_cast<uint8_t*>(dst);
+
+  const auto emit = [&op, src](size_t anchor, size_t literals, size_t offset,
+                               size_t match_length) {
+    uint8_t* token = op++;
+    const size_t ml = match_length ? match_length - kMinMatch : 0;
+    *token = static_cast<uint8_t>(((literals >= 15 ? 15 : literals) << 4) |
+                                  (ml >= 15 ? 15 : ml));
+    if (literals >= 15) detail::PutLength(op, literals - 15);
+    std::memcpy(op, src + anchor, literals);
+    op += literals;
+    if (!match_length) return;  // 最后一个序列只有字面量
+    *op++ = static_cast<uint8_t>(offset);
+    *op++ = static_cast<uint8_t>(offset >> 8);
+    if (ml >= 15) detail::PutLength(op, ml - 15);
+  };
+
+  size_t anchor = 0;
+  if (n > kMatchFindLimit) {
+    uint32_t table[1u << kHashBits] = {};  // 位置 + 1，0 表示空
+    const size_t limit = n - kMatchFindLimit;
+    const size_t match_limit = n - kLastLiterals;
+    const size_t acceleration = static_cast<size_t>(kMaxLevel + 1 - level);
+    size_t ip = 0;
+    size_t misses = 0;
+    while (ip < limit) {
+      const uint32_t sequence = detail::Read32(src + ip);
+      const uint32_t hash = (sequence * 2654435761u) >> (32 - kHashBits);
+      const uint32_t candidate = table[hash];
+      table[hash] = static_cast<uint32_t>(ip + 1);
+      if (candidate && ip - (candidate - 1) <= 65535 &&
+          detail::Read32(src + candidate - 1) == sequence) {
+        size_t ref = candidate - 1;
+        // 向前扩展到 anchor
+        while (ip > anchor && ref > 0 && src[ip - 1] == src[ref - 1]) {
+          --ip;
+          --ref;
+        }
+        size_t length = kMinMatch;
+        while (ip + length < match_limit && src[ref + length] == src[ip + length]) {
+          ++length;
+        }
+        emit(anchor, ip - anchor, ip - ref, length);
+        ip += length;
+        anchor = ip;
+        misses = 0;
+        continue;
+      }
+      // 连续未命中时逐渐加大步长 (与 LZ4 的 acceleration 同理)
+      ip += 1 + ((misses++ * acceleration) >> 6);
+    }
+  }
+  emit(anchor, n - anchor, 0, 0);
+  return static_cast<size_t>(op - reinterpret_cast<uint8_t*>(dst));
+}
+
+/**
+ * @brief 解压一个 LZ4 块并追加到 out。
+ * @return false 表示数据损坏。
+ */
+inline bool DecompressBlock(const char* source, size_t n, std::string& out) {
+  const auto* ip = reinterpret_cast<const uint8_t*>(source);
+  const uint8_t* const end = ip + n;
+  const size_t base = out.size();
+  const auto read_length = [&](size_t length) -> size_t {
+    if (length != 15) return length;
+    uint8_t b;
+    do {
+      if (ip >= end) return SIZE_MAX;
+      b = *ip++;
+      length += b;
+    } while (b == 255);
+    return length;
+  };
+  while (ip < end) {
+    const uint8_t token = *ip++;
+    const size_t literals = read_length(token >> 4);
+    if (literals == SIZE_MAX || literals > static_cast<size_t>(end - ip)) return false;
+    out.append(reinterpret_cast<const char*>(ip), literals);
+    ip += literals;
+    if (ip == end) break;  // 最后一个序列
+    if (end - ip < 2) return false;
+    const size_t offset = size_t(ip[0]) | (size_t(ip[1]) << 8);
+    ip += 2;
+    size_t length = read_length(token & 15);
+    if (length == SIZE_MAX || offset == 0 || offset > out.size() - base) return false;
+    length += 4;
+    const size_t from = out.size() - offset;
+    for (size_t i = 0; i < length; ++i) out.push_back(out[from + i]);  // 可能重叠
+  }
+  return true;
+}
+
+/** @brief 帧头 (magic + FLG + BD + HC)。 */
+inline std::string FrameHeader() {
+  std::string header;
+  detail::PutLE32(header, kFrameMagic);
+  const uint8_t descriptor[2] = {
+      0x60,  // FLG: version 01, 块独立，无块校验 / 内容长度 / 内容校验
+      0x40,  // BD: 最大块 64KB
+  };
+  header.append(reinterpret_cast<const char*>(descriptor), 2);
+  header.push_back(static_cast<char>((detail::Xxh32(descriptor, 2, 0) >> 8) & 0xFF));
+  return header;
+}
+
+/** @brief 帧结尾 (EndMark)。 */
+inline std::string FrameEnd() { return std::string(4, '\0'); }
+
+/**
+ * @brief 把不超过 kBlockSize 的数据编码为一个帧内块 (块长度 + 数据)。
+ * 压缩后不比原文小时按未压缩块存放。
+ */
+inline void AppendFrameBlock(const char* data, size_t n, int level, std::string& out,
+                             std::vector<char>& scratch) {
+  if (n == 0) return;
+  scratch.resize(CompressBound(n));
+  const size_t compressed = CompressBlock(data, n, scratch.data(), level);
+  if (compressed < n) {
+    detail::PutLE32(out, static_cast<uint32_t>(compressed));
+    out.append(scratch.data(), compressed);
+  } else {
+    detail::PutLE32(out, static_cast<uint32_t>(n) | 0x80000000u);
+    out.append(data, n);
+  }
+}
+
+/**
+ * @brief 解压整个帧 (可以缺少 EndMark)。
+ * @return false 表示不是 LZ4 帧或数据损坏；已解出的部分仍留在 out 中。
+ */
+inline bool DecompressFrame(std::string_view frame, std::string& out) {
+  const auto* p = reinterpret_cast<const uint8_t*>(frame.data());
+  const uint8_t* const end = p + frame.size();
+  if (frame.size() < 7 || detail::GetLE32(p) != kFrameMagic) return false;
+  const uint8_t flg = p[4];
+  if ((flg >> 6) != 1) return false;
+  size_t header = 7 + ((flg & 0x08) ? 8 : 0) + ((flg & 0x01) ? 4 : 0);
+  if (frame.size() < header) return false;
+  p += header;
+  const bool block_checksum = (flg & 0x10) != 0;
+  while (end - p >= 4) {
+    const uint32_t word = detail::GetLE32(p);
+    p += 4;
+    if (word == 0) return true;  // EndMark
+    const size_t size = word & 0x7FFFFFFFu;
+    if (static_cast<size_t>(end - p) < size + (block_checksum ? 4 : 0)) return false;
+    if (word & 0x80000000u) {
+      out.append(reinterpret_cast<const char*>(p), size);
+    } else if (!DecompressBlock(reinterpret_cast<const char*>(p), size, out)) {
+      return false;
+    }
+    p += size + (block_checksum ? 4 : 0);
+  }
+  return p == end;  // 没有 EndMark：正在写入的帧
+}
+
+}  // namespace lz4
+}  // namespace log
+}  // namespace plugins
+}  // namespace z3y
+
+#endif  // Z3Y_PLUGIN_SPDLOG_LZ4_FRAME_H_
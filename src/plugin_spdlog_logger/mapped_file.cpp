@@ -0,0 +1,119 @@
+﻿/*
+ * Copyright [2025] [Yue Liu]
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file mapped_file.cpp
+ * @brief MappedFile 的实现 (Windows: 文件映射对象；POSIX: mmap)。
+ */
+
+#include "mapped_file.h"
+
+#include <spdlog/common.h>
+
+#include <string>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cerrno>
+#endif
+
+namespace z3y {
+namespace plugins {
+namespace log {
+
+namespace {
+
+[[noreturn]] void ThrowSystemError(const char* owner, const std::string& what,
+                                   const std::filesystem::path& path) {
+#ifdef _WIN32
+  const int code = static_cast<int>(::GetLastError());
+#else
+  const int code = errno;
+#endif
+  spdlog::throw_spdlog_ex(std::string(owner) + ": " + what + " '" + path.string() + "'", code);
+}
+
+}  // namespace
+
+MappedFile::MappedFile(const std::filesystem::path& path, size_t size, const char* owner)
+    : size_(size) {
+#ifdef _WIN32
+  file_ = ::CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE,
+                        FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, CREATE_ALWAYS,
+                        FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file_ == INVALID_HANDLE_VALUE) ThrowSystemError(owner, "failed to create", path);
+  // 以映射大小创建映射对象，文件随之扩展 (新增部分由系统填 0)
+  const auto size64 = static_cast<uint64_t>(size);
+  mapping_ = ::CreateFileMappingW(file_, nullptr, PAGE_READWRITE,
+                                  static_cast<DWORD>(size64 >> 32),
+                                  static_cast<DWORD>(size64 & 0xFFFFFFFFull), nullptr);
+  if (!mapping_) {
+    Close();
+    ThrowSystemError(owner, "failed to size", path);
+  }
+  data_ = static_cast<char*>(::MapViewOfFile(mapping_, FILE_MAP_WRITE, 0, 0, size));
+  if (!data_) {
+    Close();
+    ThrowSystemError(owner, "failed to map", path);
+  }
+#else
+  fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd_ < 0) ThrowSystemError(owner, "failed to create", path);
+  if (::ftruncate(fd_, static_cast<off_t>(size)) != 0) {
+    Close();
+    ThrowSystemError(owner, "failed to size", path);
+  }
+  void* data = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+  if (data == MAP_FAILED) {
+    Close();
+    ThrowSystemError(owner, "failed to map", path);
+  }
+  data_ = static_cast<char*>(data);
+#endif
+}
+
+MappedFile::~MappedFile() { Close(); }
+
+void MappedFile::FlushAsync() {
+  if (!data_) return;
+#ifdef _WIN32
+  ::FlushViewOfFile(data_, 0);
+#else
+  ::msync(data_, size_, MS_ASYNC);
+#endif
+}
+
+void MappedFile::Close() {
+#ifdef _WIN32
+  if (data_) ::UnmapViewOfFile(data_);
+  if (mapping_) ::CloseHandle(mapping_);
+  if (file_ != INVALID_HANDLE_VALUE) ::CloseHandle(file_);
+  mapping_ = nullptr;
+  file_ = INVALID_HANDLE_VALUE;
+#else
+  if (data_) ::munmap(data_, size_);
+  if (fd_ >= 0) ::close(fd_);
+  fd_ = -1;
+#endif
+  data_ = nullptr;
+}
+
+}  // namespace log
+}  // namespace plugins
+}  // namespace z3y
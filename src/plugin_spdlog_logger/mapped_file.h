@@ -0,0 +1,81 @@
+﻿/*
+ * Copyright [2025] [Yue Liu]
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file mapped_file.h
+ * @brief [内部] 可读写的文件映射 (mmap_binary_sink 的段文件与崩溃环共用)。
+ *
+ * @details
+ * 创建 (截断) 文件、扩展到指定大小并整体映射。写入映射区即写入页缓存：
+ * 进程崩溃后数据仍由操作系统写回，FlushAsync 只是请求尽快写回。
+ */
+
+#pragma once
+
+#ifndef Z3Y_PLUGIN_SPDLOG_MAPPED_FILE_H_
+#define Z3Y_PLUGIN_SPDLOG_MAPPED_FILE_H_
+
+#include <cstddef>
+#include <filesystem>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#endif
+
+namespace z3y {
+namespace plugins {
+namespace log {
+
+/** @brief 一个文件的读写映射，析构时解除映射并关闭文件。 */
+class MappedFile {
+ public:
+  /**
+   * @param owner 错误信息的前缀 (使用方的名字)。
+   * @throws spdlog::spdlog_ex 无法创建、扩展或映射文件时。
+   */
+  MappedFile(const std::filesystem::path& path, size_t size, const char* owner);
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  char* data() const { return data_; }
+  size_t size() const { return size_; }
+
+  /** @brief 请求系统异步写回脏页 (不等待落盘)。 */
+  void FlushAsync();
+
+ private:
+  void Close();
+
+  size_t size_;
+  char* data_ = nullptr;
+#ifdef _WIN32
+  HANDLE file_ = INVALID_HANDLE_VALUE;
+  HANDLE mapping_ = nullptr;
+#else
+  int fd_ = -1;
+#endif
+};
+
+}  // namespace log
+}  // namespace plugins
+}  // namespace z3y
+
+#endif  // Z3Y_PLUGIN_SPDLOG_MAPPED_FILE_H_
@@ -0,0 +1,225 @@
+﻿/*
+ * Copyright [2025] [Yue Liu]
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file mmap_binary_format.h
+ * @brief mmap_binary_sink 的二进制段文件格式 (写入端与 tool_log_decoder 共用)。
+ *
+ * @details
+ * [文件布局] 每个段文件预先扩展到 segment_size，整体映射到内存：
+ * @code
+ * | FileHeader (64B) | Record | Record | ... | 0 填充直到文件末尾 |
+ * @endcode
+ * - Record 由 RecordHeader (32B) + 正文组成，总长度按 8 字节对齐。
+ * - 正文：Name 记录为 Logger 名字；Log 记录为格式化后的消息 (不含时间戳等前缀)。
+ * - Logger 名字按段建立字典：段内首次出现时写一条 Name 记录分配 name_id，
+ * 之后的 Log 记录只带 name_id。每个段自成一体，删除旧段不影响解码。
+ * - 结构化日志的 Log 记录在消息之后紧跟 fields_len 字节的字段区，每个字段为
+ * `u8 类型 | u8 键长 | 键 | 值`：String 的值为 `u32 长度 | 字节`，其余为 8 字节。
+ * 早期版本的该位置恒为 0，旧解码器按 payload_len 读取消息，自然跳过字段区。
+ *
+ * [崩溃安全] 写入端先写正文，最后写 RecordHeader::size。进程崩溃时映射页仍由
+ * 操作系统写回，解码器读到 size == 0 (或越界) 即认为到达末尾，半条记录不会被误读。
+ *
+ * 所有整数为写入机器的本机字节序 (目标平台均为小端)。
+ */
+
+#pragma once
+
+#ifndef Z3Y_PLUGIN_SPDLOG_MMAP_BINARY_FORMAT_H_
+#define Z3Y_PLUGIN_SPDLOG_MMAP_BINARY_FORMAT_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+
+namespace z3y {
+namespace plugins {
+namespace log {
+namespace binlog {
+
+inline constexpr char kFileMagic[8] = {'Z', '3', 'Y', 'B', 'L', 'O', 'G', '1'};
+inline constexpr uint32_t kFormatVersion = 1;
+inline constexpr uint32_t kRecordAlign = 8;
+
+/** @brief 记录类型。0 保留给 "未写入" (映射区的 0 填充)。 */
+enum class RecordType : uint8_t {
+  kEnd = 0,
+  kName = 1,  ///< 定义 name_id -> Logger 名字
+  kLog = 2,   ///< 一条日志
+};
+
+struct FileHeader {
+  char magic[8];          ///< kFileMagic
+  uint32_t version;       ///< kFormatVersion
+  uint32_t header_size;   ///< sizeof(FileHeader)，首条记录的偏移
+  uint64_t segment_size;  ///< 文件预分配大小
+  uint64_t sequence;      ///< 段序号，跨进程重启单调递增，解码时据此排序
+  int64_t created_ns;     ///< 段创建时间 (Unix 纪元纳秒)
+  uint64_t used_bytes;    ///< 已提交字节数 (仅供参考，以记录链为准)
+  uint8_t reserved[16];
+};
+static_assert(sizeof(FileHeader) == 64, "FileHeader layout is part of the file format");
+
+struct RecordHeader {
+  uint32_t size;         ///< 整条记录的字节数 (含本头部与对齐填充)，最后写入
+  uint8_t type;          ///< RecordType
+  uint8_t level;         ///< spdlog::level::level_enum (0 = trace ... 5 = critical)
+  uint16_t name_id;      ///< Logger 名字在本段字典中的 ID
+  uint32_t payload_len;  ///< 正文字节数
+  uint32_t fields_len;   ///< 正文之后的字段区字节数 (非结构化日志为 0)
+  int64_t time_ns;       ///< 日志时间 (Unix 纪元纳秒)
+  uint64_t thread_id;    ///< 产生日志的线程 ID
+};
+static_assert(sizeof(RecordHeader) == 32, "RecordHeader layout is part of the file format");
+
+/** @brief 记录总长度 (含对齐)。 */
+constexpr uint32_t RecordSize(uint32_t payload_len) {
+  return (static_cast<uint32_t>(sizeof(RecordHeader)) + payload_len + kRecordAlign - 1) &
+         ~(kRecordAlign - 1);
+}
+
+/** @brief 字段值的类型 (取值与 LogArgType 一致)。 */
+enum class FieldType : uint8_t {
+  kInt64 = 0,
+  kUInt64 = 1,
+  kDouble = 2,
+  kBool = 3,
+  kChar = 4,
+  kPointer = 5,
+  kString = 6,
+};
+
+/**
+ * @brief 向字段区追加一个字段。
+ * @param raw 非 String 字段的 8 字节原始值 (double 按位存放)。
+ */
+inline void AppendField(std::string& out, std::string_view key, FieldType type, uint64_t raw,
+                        std::string_view text = {}) {
+  const auto key_len = static_cast<uint8_t>(std::min<size_t>(key.size(), UINT8_MAX));
+  out.push_back(static_cast<char>(type));
+  out.push_back(static_cast<char>(key_len));
+  out.append(key.data(), key_len);
+  if (type == FieldType::kString) {
+    const auto len = static_cast<uint32_t>(text.size());
+    out.append(reinterpret_cast<const char*>(&len), sizeof(len));
+    out.append(text.data(), text.size());
+  } else {
+    out.append(reinterpret_cast<const char*>(&raw), sizeof(raw));
+  }
+}
+
+/**
+ * @brief 依次解码字段区。
+ * @param on_field 回调 (std::string_view key, FieldType, uint64_t raw, std::string_view text)。
+ * @return 字段区完整时为 true；截断或类型未知时停在该处并返回 false。
+ */
+template <typename OnField>
+bool ForEachField(std::string_view fields, OnField&& on_field) {
+  size_t pos = 0;
+  while (pos < fields.size()) {
+    if (pos + 2 > fields.size()) return false;
+    const auto type = static_cast<FieldType>(fields[pos]);
+    const auto key_len = static_cast<uint8_t>(fields[pos + 1]);
+    pos += 2;
+    if (pos + key_len > fields.size() || static_cast<uint8_t>(type) > 6) return false;
+    const std::string_view key = fields.substr(pos, key_len);
+    pos += key_len;
+    uint64_t raw = 0;
+    std::string_view text;
+    if (type == FieldType::kString) {
+      uint32_t len = 0;
+      if (pos + sizeof(len) > fields.size()) return false;
+      std::memcpy(&len, fields.data() + pos, sizeof(len));
+      pos += sizeof(len);
+      if (pos + len > fields.size()) return false;
+      text = fields.substr(pos, len);
+      pos += len;
+    } else {
+      if (pos + sizeof(raw) > fields.size()) return false;
+      std::memcpy(&raw, fields.data() + pos, sizeof(raw));
+      pos += sizeof(raw);
+    }
+    on_field(key, type, raw, text);
+  }
+  return true;
+}
+
+/** @brief 与 spdlog 短级别名一致的单字母。 */
+constexpr char LevelLetter(uint8_t level) {
+  constexpr char kLetters[] = {'T', 'D', 'I', 'W', 'E', 'C', 'O'};
+  return level < sizeof(kLetters) ? kLetters[level] : '?';
+}
+
+/** @brief 校验段文件头。 */
+inline bool IsSegment(const void* data, size_t length) {
+  if (length < sizeof(FileHeader)) return false;
+  const auto* header = static_cast<const FileHeader*>(data);
+  return std::memcmp(header->magic, kFileMagic, sizeof(kFileMagic)) == 0 &&
+         header->version == kFormatVersion && header->header_size >= sizeof(FileHeader);
+}
+
+/**
+ * @brief 依次解码一个段中的 Log 记录。
+ * @param on_log 回调 (const RecordHeader&, std::string_view logger_name, std::string_view message)，
+ * 或多接收一个 std::string_view fields (字段区，用 ForEachField 解码)。
+ * @return 解码的 Log 记录数；文件头无效时返回 0。
+ */
+template <typename OnLog>
+size_t ForEachRecord(const char* data, size_t length, OnLog&& on_log) {
+  if (!IsSegment(data, length)) return 0;
+  const auto* file = reinterpret_cast<const FileHeader*>(data);
+  std::unordered_map<uint16_t, std::string_view> names;
+  size_t offset = file->header_size;
+  size_t count = 0;
+  while (offset + sizeof(RecordHeader) <= length) {
+    RecordHeader record;
+    std::memcpy(&record, data + offset, sizeof(record));
+    if (record.size == 0 || record.payload_len > record.size || record.fields_len > record.size ||
+        record.size < RecordSize(record.payload_len + record.fields_len) ||
+        offset + record.size > length) {
+      break;
+    }
+    const std::string_view payload(data + offset + sizeof(RecordHeader), record.payload_len);
+    if (record.type == static_cast<uint8_t>(RecordType::kName)) {
+      names[record.name_id] = payload;
+    } else if (record.type == static_cast<uint8_t>(RecordType::kLog)) {
+      auto it = names.find(record.name_id);
+      const std::string_view name = it != names.end() ? it->second : std::string_view();
+      if constexpr (std::is_invocable_v<OnLog&, const RecordHeader&, std::string_view,
+                                        std::string_view, std::string_view>) {
+        on_log(record, name, payload,
+               std::string_view(payload.data() + payload.size(), record.fields_len));
+      } else {
+        on_log(record, name, payload);
+      }
+      ++count;
+    }
+    offset += record.size;
+  }
+  return count;
+}
+
+}  // namespace binlog
+}  // namespace log
+}  // namespace plugins
+}  // namespace z3y
+
+#endif  // Z3Y_PLUGIN_SPDLOG_MMAP_BINARY_FORMAT_H_
@@ -0,0 +1,230 @@
+﻿/*
+ * Copyright [2025] [Yue Liu]
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file mmap_binary_sink.cpp
+ * @brief mmap_binary_sink 的实现。
+ */
+
+#include "mmap_binary_sink.h"
+
+#include <spdlog/common.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <system_error>
+#include <vector>
+
+#include "mapped_file.h"
+#include "mmap_binary_format.h"
+#include "structured_log_context.h"
+
+namespace z3y {
+namespace plugins {
+namespace log {
+
+namespace {
+
+using binlog::FileHeader;
+using binlog::RecordHeader;
+using binlog::RecordType;
+
+int64_t ToUnixNanos(spdlog::log_clock::time_point tp) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(tp.time_since_epoch())
+      .count();
+}
+
+}  // namespace
+
+mmap_binary_sink::mmap_binary_sink(std::filesystem::path base_path,
+                                   size_t segment_size, size_t max_files)
+    : directory_(base_path.has_parent_path() ? base_path.parent_path()
+                                             : std::filesystem::path(".")),
+      stem_(base_path.stem().string()),
+      extension_(base_path.has_extension() ? base_path.extension().string()
+                                           : std::string(".blog")),
+      segment_size_(std::max(segment_size, kMinSegmentSize)),
+      max_files_(std::max<size_t>(max_files, 1)) {
+  std::error_code ec;
+  std::filesystem::create_directories(directory_, ec);
+  sequence_ = ScanLastSequence();
+  OpenNextSegment();
+}
+
+mmap_binary_sink::~mmap_binary_sink() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (mapping_) mapping_->FlushAsync();
+  mapping_.reset();
+}
+
+std::filesystem::path mmap_binary_sink::current_path() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return SegmentPath(sequence_);
+}
+
+std::filesystem::path mmap_binary_sink::SegmentPath(uint64_t sequence) const {
+  char index[24];
+  std::snprintf(index, sizeof(index), ".%06llu",
+                static_cast<unsigned long long>(sequence));
+  return directory_ / (stem_ + index + extension_);
+}
+
+uint64_t mmap_binary_sink::ScanLastSequence() const {
+  uint64_t last = 0;
+  std::error_code ec;
+  for (const auto& entry : std::filesystem::directory_iterator(directory_, ec)) {
+    const std::string name = entry.path().filename().string();
+    // <stem>.<digits><ext>
+    if (name.size() <= stem_.size() + 1 + extension_.size() ||
+        name.compare(0, stem_.size() + 1, stem_ + ".") != 0 ||
+        name.compare(name.size() - extension_.size(), extension_.size(), extension_) != 0) {
+      continue;
+    }
+    const std::string digits = name.substr(
+        stem_.size() + 1, name.size() - stem_.size() - 1 - extension_.size());
+    if (digits.empty() ||
+        !std::all_of(digits.begin(), digits.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+      continue;
+    }
+    last = std::max<uint64_t>(last, std::stoull(digits));
+  }
+  return last;
+}
+
+void mmap_binary_sink::OpenNextSegment() {
+  if (mapping_) mapping_->FlushAsync();
+  mapping_.reset();
+  names_.clear();
+  last_name_.clear();
+  last_name_id_ = -1;
+
+  ++sequence_;
+  const auto path = SegmentPath(sequence_);
+  mapping_ = std::make_unique<MappedFile>(path, segment_size_, "mmap_binary_sink");
+
+  FileHeader header{};
+  std::memcpy(header.magic, binlog::kFileMagic, sizeof(header.magic));
+  header.version = binlog::kFormatVersion;
+  header.header_size = static_cast<uint32_t>(sizeof(FileHeader));
+  header.segment_size = segment_size_;
+  header.sequence = sequence_;
+  header.created_ns = ToUnixNanos(spdlog::log_clock::now());
+  std::memcpy(mapping_->data(), &header, sizeof(header));
+  offset_ = sizeof(FileHeader);
+
+  RemoveOldSegments();
+}
+
+void mmap_binary_sink::RemoveOldSegments() {
+  if (sequence_ <= max_files_) return;
+  // 只清理紧邻保留窗口之前的段；更早的段在之前的滚动中已经删除
+  std::error_code ec;
+  for (uint64_t seq = sequence_ - max_files_; seq > 0; --seq) {
+    if (!std::filesystem::remove(SegmentPath(seq), ec)) break;
+  }
+}
+
+void mmap_binary_sink::Append(uint8_t type, uint8_t level, uint16_t name_id,
+                              int64_t time_ns, uint64_t thread_id,
+                              const char* payload, uint32_t payload_len,
+                              std::string_view fields) {
+  char* base = mapping_->data();
+  RecordHeader header{};
+  header.type = type;
+  header.level = level;
+  header.name_id = name_id;
+  header.payload_len = payload_len;
+  header.fields_len = static_cast<uint32_t>(fields.size());
+  header.time_ns = time_ns;
+  header.thread_id = thread_id;
+  const uint32_t size = binlog::RecordSize(payload_len + header.fields_len);
+
+  // 先写头部 (size 暂为 0)、正文与字段区，最后写 size：崩溃时半条记录对解码器不可见
+  std::memcpy(base + offset_, &header, sizeof(header));
+  std::memcpy(base + offset_ + sizeof(header), payload, payload_len);
+  if (!fields.empty()) {
+    std::memcpy(base + offset_ + sizeof(header) + payload_len, fields.data(), fields.size());
+  }
+  std::memcpy(base + offset_ + offsetof(RecordHeader, size), &size, sizeof(size));
+  offset_ += size;
+
+  const uint64_t used = offset_;
+  std::memcpy(base + offsetof(FileHeader, used_bytes), &used, sizeof(used));
+}
+
+int mmap_binary_sink::FindName(std::string_view name) {
+  // 同一个 Logger 连续写入最常见，先比较上一次的名字，避免构造 std::string
+  if (last_name_id_ >= 0 && name == last_name_) return last_name_id_;
+  auto it = names_.find(std::string(name));
+  if (it == names_.end()) return -1;
+  last_name_.assign(name.data(), name.size());
+  last_name_id_ = it->second;
+  return last_name_id_;
+}
+
+uint16_t mmap_binary_sink::DefineName(std::string_view name, int64_t time_ns) {
+  const auto id = static_cast<uint16_t>(names_.size());
+  const auto length = static_cast<uint32_t>(std::min(name.size(), segment_size_ / 4));
+  Append(static_cast<uint8_t>(RecordType::kName), 0, id, time_ns, 0, name.data(), length);
+  names_.emplace(std::string(name), id);
+  last_name_.assign(name.data(), name.size());
+  last_name_id_ = id;
+  return id;
+}
+
+void mmap_binary_sink::sink_it_(const spdlog::details::log_msg& msg) {
+  const int64_t time_ns = ToUnixNanos(msg.time);
+  const std::string_view name(msg.logger_name.data(), msg.logger_name.size());
+  // 单条消息最多占段的一半，超出部分截断
+  const auto payload_len =
+      static_cast<uint32_t>(std::min<size_t>(msg.payload.size(), segment_size_ / 2));
+  // 结构化字段按原始类型编码；超过段的四分之一时整体舍弃 (消息文本仍含全部字段)
+  fields_scratch_.clear();
+  if (const StructuredLogContext* context = CurrentStructuredLog()) {
+    AppendBinaryFields(*context, fields_scratch_);
+    if (fields_scratch_.size() > segment_size_ / 4) fields_scratch_.clear();
+  }
+  const auto fields_len = static_cast<uint32_t>(fields_scratch_.size());
+
+  // 本段放不下 "可能的 Name 记录 + Log 记录"，或名字字典已满时滚动到下一段
+  int name_id = FindName(name);
+  const size_t name_cost =
+      name_id >= 0 ? 0
+                   : binlog::RecordSize(static_cast<uint32_t>(
+                         std::min(name.size(), segment_size_ / 4)));
+  if (offset_ + name_cost + binlog::RecordSize(payload_len + fields_len) > segment_size_ ||
+      (name_id < 0 && names_.size() > UINT16_MAX)) {
+    OpenNextSegment();
+    name_id = -1;
+  }
+  if (name_id < 0) name_id = DefineName(name, time_ns);
+
+  Append(static_cast<uint8_t>(RecordType::kLog), static_cast<uint8_t>(msg.level),
+         static_cast<uint16_t>(name_id), time_ns, static_cast<uint64_t>(msg.thread_id),
+         msg.payload.data(), payload_len, fields_scratch_);
+}
+
+void mmap_binary_sink::flush_() {
+  // 数据已在映射页中，对进程崩溃而言已经安全；这里只提示系统尽快写回
+  mapping_->FlushAsync();
+}
+
+}  // namespace log
+}  // namespace plugins
+}  // namespace z3y
@@ -0,0 +1,104 @@
+﻿/*
+ * Copyright [2025] [Yue Liu]
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file mmap_binary_sink.h
+ * @brief [内部] 内存映射的二进制日志 Sink (配置类型 "mmap_binary_sink")。
+ *
+ * @details
+ * [设计]
+ * 1. **预分配段**: 每个段文件创建时即扩展到 max_size 并整体映射，写入只是 memcpy，
+ * 没有 fwrite 缓冲，也不需要显式刷盘——进程崩溃后数据仍在页缓存里由系统写回。
+ * 2. **紧凑记录**: 不使用 pattern，只写 32 字节定长头 + 原始消息；Logger 名字按段
+ * 建字典 (格式见 mmap_binary_format.h)。用 tools/tool_log_decoder 还原为文本。
+ * 3. **结构化字段**: 结构化日志 (LogStructured) 的字段以二进制附在消息之后，不渲染成文本。
+ * 4. **滚动**: 段写满后打开下一个段 `<stem>.<序号>.<ext>`，只保留最新的 max_files 个。
+ * 序号从目录中已有的最大序号继续，进程重启不会覆盖旧段。
+ */
+
+#pragma once
+
+#ifndef Z3Y_PLUGIN_SPDLOG_MMAP_BINARY_SINK_H_
+#define Z3Y_PLUGIN_SPDLOG_MMAP_BINARY_SINK_H_
+
+#include <spdlog/sinks/base_sink.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace z3y {
+namespace plugins {
+namespace log {
+
+class MappedFile;
+
+class mmap_binary_sink final : public spdlog::sinks::base_sink<std::mutex> {
+ public:
+  static constexpr size_t kMinSegmentSize = 64 * 1024;
+
+  /**
+   * @param base_path 段文件的基础路径，如 logs/app.blog -> logs/app.000001.blog。
+   * @param segment_size 每个段的预分配大小 (不小于 kMinSegmentSize)。
+   * @param max_files 保留的段数 (至少 1)。
+   * @throws spdlog::spdlog_ex 无法创建或映射段文件时。
+   */
+  mmap_binary_sink(std::filesystem::path base_path, size_t segment_size,
+                   size_t max_files);
+  ~mmap_binary_sink() override;
+
+  /** @brief 当前段的路径 (测试与诊断用)。 */
+  std::filesystem::path current_path();
+
+ protected:
+  void sink_it_(const spdlog::details::log_msg& msg) override;
+  void flush_() override;
+
+ private:
+  std::filesystem::path SegmentPath(uint64_t sequence) const;
+  uint64_t ScanLastSequence() const;
+  void OpenNextSegment();
+  void RemoveOldSegments();
+  void Append(uint8_t type, uint8_t level, uint16_t name_id, int64_t time_ns,
+              uint64_t thread_id, const char* payload, uint32_t payload_len,
+              std::string_view fields = {});
+  int FindName(std::string_view name);  ///< 当前段中的 name_id，未定义返回 -1
+  uint16_t DefineName(std::string_view name, int64_t time_ns);
+
+  const std::filesystem::path directory_;
+  const std::string stem_;
+  const std::string extension_;
+  const size_t segment_size_;
+  const size_t max_files_;
+
+  std::unique_ptr<MappedFile> mapping_;
+  uint64_t sequence_ = 0;
+  size_t offset_ = 0;
+  std::unordered_map<std::string, uint16_t> names_;  ///< 当前段的名字字典
+  std::string last_name_;  ///< 最近一次命中的名字 (快路径)
+  int last_name_id_ = -1;
+  std::string fields_scratch_;  ///< 结构化字段的编码缓冲 (复用)
+};
+
+}  // namespace log
+}  // namespace plugins
+}  // namespace z3y
+
+#endif  // Z3Y_PLUGIN_SPDLOG_MMAP_BINARY_SINK_H_
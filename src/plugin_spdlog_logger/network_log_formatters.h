@@ -0,0 +1,203 @@
+﻿/*
+ * Copyright [2025] [Yue Liu]
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file network_log_formatters.h
+ * @brief [内部] 网络日志 Sink 的报文格式 (Sink 配置 "format": "syslog" / "gelf")。
+ *
+ * @details
+ * - syslog: RFC 5424，`<PRI>1 时间 主机 应用 进程 Logger 结构化数据 消息`。
+ * 时间为 UTC 微秒；结构化日志的字段写成 `[fields@32473 key="value" ...]`，普通日志为 `-`。
+ * - gelf: GELF 1.1 JSON，`short_message` 为消息，Logger 名与线程 ID 为 `_logger` / `_thread`，
+ * 结构化字段为 `_<key>` 并保持原始类型。
+ * 每条记录以 '\n' 结尾，由 network_log_sink 换成所用传输的分隔符。
+ * 字段取自写入线程公布的 StructuredLogContext (见 structured_log_context.h)。
+ */
+
+#pragma once
+
+#ifndef Z3Y_PLUGIN_SPDLOG_NETWORK_LOG_FORMATTERS_H_
+#define Z3Y_PLUGIN_SPDLOG_NETWORK_LOG_FORMATTERS_H_
+
+#include <spdlog/details/os.h>
+#include <spdlog/formatter.h>
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "json_lines_formatter.h"
+#include "structured_log_context.h"
+
+namespace z3y {
+namespace plugins {
+namespace log {
+
+/** @brief spdlog 级别对应的 syslog severity (GELF 的 level 同此)。 */
+inline int SyslogSeverity(spdlog::level::level_enum level) {
+  switch (level) {
+    case spdlog::level::critical:
+      return 2;
+    case spdlog::level::err:
+      return 3;
+    case spdlog::level::warn:
+      return 4;
+    case spdlog::level::info:
+      return 6;
+    default:
+      return 7;
+  }
+}
+
+class syslog_formatter final : public spdlog::formatter {
+ public:
+  /**
+   * @param facility syslog facility (0 ~ 23，默认 16 = local0)。
+   */
+  syslog_formatter(std::string app_name, std::string host_name, int facility)
+      : app_name_(Token(app_name, 48)),
+        host_name_(Token(host_name, 255)),
+        facility_(facility) {}
+
+  void format(const spdlog::details::log_msg& msg, spdlog::memory_buf_t& dest) override {
+    const auto since_epoch = msg.time.time_since_epoch();
+    const auto seconds = std::chrono::duration_cast<std::chrono::seconds>(since_epoch);
+    const auto micros =
+        std::chrono::duration_cast<std::chrono::microseconds>(since_epoch - seconds).count();
+    const std::tm tm = spdlog::details::os::gmtime(static_cast<std::time_t>(seconds.count()));
+    fmt::format_to(std::back_inserter(dest),
+                   "<{}>1 {:04}-{:02}-{:02}T{:02}:{:02}:{:02}.{:06}Z {} {} {} {} ",
+                   facility_ * 8 + SyslogSeverity(msg.level), tm.tm_year + 1900,
+                   tm.tm_mon + 1, tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec, micros,
+                   host_name_, app_name_, spdlog::details::os::pid(),
+                   Token({msg.logger_name.data(), msg.logger_name.size()}, 32));
+
+    const StructuredLogContext* context = CurrentStructuredLog();
+    if (context && context->field_count > 0) {
+      AppendJsonRaw(dest, "[fields@32473");
+      for (uint32_t i = 0; i < context->field_count; ++i) {
+        dest.push_back(' ');
+        AppendJsonRaw(dest, Token(context->fields[i].key, 32, true));
+        AppendJsonRaw(dest, "=\"");
+        AppendParamValue(dest, context->fields[i].value);
+        dest.push_back('"');
+      }
+      dest.push_back(']');
+    } else {
+      dest.push_back('-');
+    }
+    dest.push_back(' ');
+    AppendJsonRaw(dest, {msg.payload.data(), msg.payload.size()});
+    dest.push_back('\n');
+  }
+
+  std::unique_ptr<spdlog::formatter> clone() const override {
+    return std::make_unique<syslog_formatter>(*this);
+  }
+
+ private:
+  /** @brief RFC 5424 的头部字段：可见 ASCII，空值写 "-"；SD-NAME 另外不含 '=' ']' '"'。 */
+  static std::string Token(std::string_view text, size_t max_length, bool sd_name = false) {
+    std::string out;
+    for (char c : text.substr(0, max_length)) {
+      const bool printable = c > 32 && c < 127;
+      const bool reserved = sd_name && (c == '=' || c == ']' || c == '"');
+      out.push_back(printable && !reserved ? c : '_');
+    }
+    return out.empty() ? std::string("-") : out;
+  }
+
+  /** @brief PARAM-VALUE：'"' '\' ']' 需要转义。 */
+  static void AppendParamValue(spdlog::memory_buf_t& dest,
+                               const z3y::interfaces::core::LogArg& value) {
+    using z3y::interfaces::core::LogArgType;
+    if (value.type != LogArgType::String && value.type != LogArgType::Char) {
+      // 其余类型的 JSON 表示不含需转义的字符 (指针带引号，去掉)
+      spdlog::memory_buf_t text;
+      AppendJsonValue(text, value);
+      std::string_view view(text.data(), text.size());
+      if (view.size() >= 2 && view.front() == '"') view = view.substr(1, view.size() - 2);
+      AppendJsonRaw(dest, view);
+      return;
+    }
+    const char c = static_cast<char>(value.u64);
+    const std::string_view text = value.type == LogArgType::String
+                                      ? std::string_view(value.str, value.size)
+                                      : std::string_view(&c, 1);
+    for (char ch : text) {
+      if (ch == '"' || ch == '\\' || ch == ']') dest.push_back('\\');
+      dest.push_back(ch);
+    }
+  }
+
+  std::string app_name_;
+  std::string host_name_;
+  int facility_;
+};
+
+class gelf_formatter final : public spdlog::formatter {
+ public:
+  explicit gelf_formatter(std::string host_name) : host_name_(std::move(host_name)) {}
+
+  void format(const spdlog::details::log_msg& msg, spdlog::memory_buf_t& dest) override {
+    const auto micros = std::chrono::duration_cast<std::chrono::microseconds>(
+                            msg.time.time_since_epoch())
+                            .count();
+    AppendJsonRaw(dest, "{\"version\":\"1.1\",\"host\":");
+    AppendJsonString(dest, host_name_);
+    AppendJsonRaw(dest, ",\"short_message\":");
+    AppendJsonString(dest, {msg.payload.data(), msg.payload.size()});
+    fmt::format_to(std::back_inserter(dest), ",\"timestamp\":{}.{:06},\"level\":{}",
+                   micros / 1000000, micros % 1000000, SyslogSeverity(msg.level));
+    AppendJsonRaw(dest, ",\"_logger\":");
+    AppendJsonString(dest, {msg.logger_name.data(), msg.logger_name.size()});
+    fmt::format_to(std::back_inserter(dest), ",\"_thread\":{}", msg.thread_id);
+
+    if (const StructuredLogContext* context = CurrentStructuredLog()) {
+      for (uint32_t i = 0; i < context->field_count; ++i) {
+        AppendJsonRaw(dest, ",\"_");
+        AppendFieldName(dest, context->fields[i].key);
+        AppendJsonRaw(dest, "\":");
+        AppendJsonValue(dest, context->fields[i].value);
+      }
+    }
+    AppendJsonRaw(dest, "}\n");
+  }
+
+  std::unique_ptr<spdlog::formatter> clone() const override {
+    return std::make_unique<gelf_formatter>(host_name_);
+  }
+
+ private:
+  /** @brief GELF 附加字段名只允许 [A-Za-z0-9_.-]；"_id" 为保留字段。 */
+  static void AppendFieldName(spdlog::memory_buf_t& dest, std::string_view key) {
+    for (char c : key) {
+      const bool allowed = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+                           (c >= '0' && c <= '9') || c == '_' || c == '.' || c == '-';
+      dest.push_back(allowed ? c : '_');
+    }
+    if (key == "id") dest.push_back('_');
+  }
+
+  std::string host_name_;
+};
+
+}  // namespace log
+}  // namespace plugins
+}  // namespace z3y
+
+#endif  // Z3Y_PLUGIN_SPDLOG_NETWORK_LOG_FORMATTERS_H_
@@ -0,0 +1,198 @@
+﻿/*
+ * Copyright [2025] [Yue Liu]
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file network_log_sink.cpp
+ * @brief network_log_sink 的实现：有界队列、发送线程与按批压缩。
+ */
+
+#include "network_log_sink.h"
+
+#include <algorithm>
+#include <string_view>
+#include <vector>
+
+#include "framework/thread_placement.h"
+#include "lz4_frame.h"
+
+namespace z3y {
+namespace plugins {
+namespace log {
+
+namespace {
+
+constexpr size_t kUdpBatchBytes = 1400;  ///< 不分片的以太网 UDP 载荷
+constexpr size_t kTcpBatchBytes = 64 * 1024;
+constexpr auto kMaxBackoff = std::chrono::milliseconds(30000);
+
+}  // namespace
+
+network_log_sink::network_log_sink(const NetworkSinkOptions& options)
+    : options_([&] {
+        NetworkSinkOptions o = options;
+        o.queue_size = std::max<size_t>(o.queue_size, 1);
+        o.max_batch_records = std::max<size_t>(o.max_batch_records, 1);
+        if (o.max_batch_bytes == 0) o.max_batch_bytes = o.tcp ? kTcpBatchBytes : kUdpBatchBytes;
+        o.compression_level = std::clamp(o.compression_level, lz4::kMinLevel, lz4::kMaxLevel);
+        return o;
+      }()),
+      worker_([this] { Run(); }) {}
+
+network_log_sink::~network_log_sink() {
+  {
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    stop_ = true;
+  }
+  queue_cv_.notify_all();
+  if (worker_.joinable()) worker_.join();
+}
+
+size_t network_log_sink::queued() {
+  std::lock_guard<std::mutex> lock(queue_mutex_);
+  return queue_.size();
+}
+
+bool network_log_sink::Enqueue(const spdlog::details::log_msg& msg) {
+  formatted_.clear();
+  formatter_->format(msg, formatted_);
+  std::string record(formatted_.data(), formatted_.size());
+  while (!record.empty() && (record.back() == '\n' || record.back() == '\r')) {
+    record.pop_back();
+  }
+  record.push_back(options_.delimiter);
+
+  bool wake = false;
+  {
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    if (queue_.size() >= options_.queue_size) return false;
+    queue_.push_back(std::move(record));
+    wake = queue_.size() == options_.max_batch_records;
+  }
+  if (wake) queue_cv_.notify_one();
+  return true;
+}
+
+void network_log_sink::sink_it_(const spdlog::details::log_msg& msg) {
+  const uint64_t dropped = dropped_.load(std::memory_order_relaxed);
+  if (dropped > reported_drops_) {
+    const std::string notice =
+        "[network sink] " + std::to_string(dropped - reported_drops_) + " records dropped";
+    spdlog::details::log_msg note(msg.time, msg.source, msg.logger_name, spdlog::level::warn,
+                                  notice);
+    note.thread_id = msg.thread_id;
+    if (Enqueue(note)) reported_drops_ = dropped;
+  }
+  if (!Enqueue(msg)) dropped_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void network_log_sink::flush_() {
+  {
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    flush_requested_ = true;
+  }
+  queue_cv_.notify_one();
+}
+
+bool network_log_sink::EnsureConnected() {
+  if (socket_.IsOpen()) return true;
+  const auto now = std::chrono::steady_clock::now();
+  if (now < next_connect_) return false;
+  std::string error;
+  if (socket_.Open(options_.target, options_.tcp, options_.timeout_ms, error)) {
+    backoff_ = std::chrono::milliseconds(0);
+    return true;
+  }
+  backoff_ = std::min(kMaxBackoff, std::max(std::chrono::milliseconds(500), backoff_ * 2));
+  next_connect_ = now + backoff_;
+  return false;
+}
+
+std::string network_log_sink::Encode(std::string batch) const {
+  if (!options_.tcp) batch.pop_back();  // 数据报自身已有边界
+  if (!options_.lz4) return batch;
+  std::string frame = lz4::FrameHeader();
+  std::vector<char> scratch;
+  for (size_t offset = 0; offset < batch.size(); offset += lz4::kBlockSize) {
+    lz4::AppendFrameBlock(batch.data() + offset,
+                          std::min(lz4::kBlockSize, batch.size() - offset),
+                          options_.compression_level, frame, scratch);
+  }
+  frame += lz4::FrameEnd();
+  return frame;
+}
+
+void network_log_sink::Run() {
+  z3y::PlaceCurrentThread("spdlog.network");
+  const auto interval = std::chrono::milliseconds(options_.flush_interval_ms);
+  std::unique_lock<std::mutex> lock(queue_mutex_);
+  while (true) {
+    queue_cv_.wait_for(lock, interval, [this] {
+      return stop_ || flush_requested_ || queue_.size() >= options_.max_batch_records;
+    });
+    if (queue_.empty()) {
+      flush_requested_ = false;
+      if (stop_) break;
+      continue;
+    }
+
+    lock.unlock();
+    const bool connected = EnsureConnected();
+    lock.lock();
+    if (!connected) {
+      if (stop_) {
+        // 退出时收集端仍不可达：剩余记录计入丢弃
+        dropped_.fetch_add(queue_.size(), std::memory_order_relaxed);
+        queue_.clear();
+        break;
+      }
+      // 记录留在队列里，等到下次重连时间 (期间新记录照常入队，满了由 sink_it_ 丢弃)
+      queue_cv_.wait_until(lock, next_connect_, [this] { return stop_; });
+      continue;
+    }
+
+    std::string batch;
+    size_t count = 0;
+    while (!queue_.empty() && count < options_.max_batch_records) {
+      std::string& record = queue_.front();
+      if (count > 0 && batch.size() + record.size() > options_.max_batch_bytes) break;
+      if (!options_.tcp && record.size() > options_.max_batch_bytes) {
+        // 单条超过数据报上限：截断，保留分隔符
+        record.resize(options_.max_batch_bytes - 1);
+        record.push_back(options_.delimiter);
+      }
+      batch += record;
+      queue_.pop_front();
+      ++count;
+    }
+    if (queue_.empty()) flush_requested_ = false;
+    lock.unlock();
+
+    if (socket_.Send(Encode(std::move(batch)), options_.timeout_ms)) {
+      sent_.fetch_add(count, std::memory_order_relaxed);
+    } else {
+      dropped_.fetch_add(count, std::memory_order_relaxed);
+      if (options_.tcp) {
+        socket_.Close();
+        EnsureConnected();  // 立即重连一次，失败则进入退避
+      }
+    }
+    lock.lock();
+  }
+}
+
+}  // namespace log
+}  // namespace plugins
+}  // namespace z3y
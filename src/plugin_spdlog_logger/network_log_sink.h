@@ -0,0 +1,115 @@
+﻿/*
+ * Copyright [2025] [Yue Liu]
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file network_log_sink.h
+ * @brief [内部] 批量发送到网络收集端的 Sink (配置类型 "network_sink")。
+ *
+ * @details
+ * [设计]
+ * 1. **不阻塞写入方**: sink_it_ 只格式化并放入有界队列；队列满时丢弃新记录并计数，
+ * 之后第一条能入队的记录前插入一条 "[network sink] N records dropped" 说明。
+ * 2. **专属发送线程**: 攒满 max_batch_records / max_batch_bytes 或等待 flush_interval_ms 后
+ * 发出一批。UDP 每批一个数据报；TCP 为连续字节流，连接失败按指数退避重连
+ * (最长 30 秒)，断线期间记录留在队列里，队列满后按第 1 条丢弃。
+ * 3. **分隔**: 每条记录以分隔符结尾 (gelf 为 '\0'，其余为 '\n')；UDP 数据报省略最后一个分隔符。
+ * 4. **压缩** (compression: lz4): 每批编码为一个独立的 LZ4 帧。TCP 流是首尾相接的帧序列，
+ * `lz4 -d` 可直接解压；批大小按未压缩字节计。
+ * 连接与发送都带超时，Flush 只是叫醒发送线程，不等待送达。
+ */
+
+#pragma once
+
+#ifndef Z3Y_PLUGIN_SPDLOG_NETWORK_LOG_SINK_H_
+#define Z3Y_PLUGIN_SPDLOG_NETWORK_LOG_SINK_H_
+
+#include <spdlog/sinks/base_sink.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "log_socket.h"
+
+namespace z3y {
+namespace plugins {
+namespace log {
+
+/** @brief network_sink 的参数 (配置项同名)。 */
+struct NetworkSinkOptions {
+  std::string target;              ///< "host:port"
+  bool tcp = false;                ///< protocol: "udp" (默认) / "tcp"
+  size_t queue_size = 8192;        ///< 发送队列的最大条数
+  size_t max_batch_records = 64;   ///< 每批最多条数
+  size_t max_batch_bytes = 0;      ///< 每批最多字节 (未压缩)；0 = UDP 1400 / TCP 64KB
+  uint32_t flush_interval_ms = 200;  ///< 不满一批时的最长等待
+  bool lz4 = false;                ///< compression: "lz4"
+  int compression_level = 1;       ///< 1 (最快) ~ 9
+  int timeout_ms = 1000;           ///< 连接 / 发送超时
+  char delimiter = '\n';           ///< 记录分隔符
+};
+
+class network_log_sink final : public spdlog::sinks::base_sink<std::mutex> {
+ public:
+  explicit network_log_sink(const NetworkSinkOptions& options);
+  ~network_log_sink() override;
+
+  uint64_t sent_records() const { return sent_.load(std::memory_order_relaxed); }
+  uint64_t dropped_records() const { return dropped_.load(std::memory_order_relaxed); }
+  /** @brief 当前排队的条数与队列容量 (并入 GetQueueStats)。 */
+  size_t queued();
+  size_t capacity() const { return options_.queue_size; }
+
+ protected:
+  void sink_it_(const spdlog::details::log_msg& msg) override;
+  void flush_() override;
+
+ private:
+  bool Enqueue(const spdlog::details::log_msg& msg);  ///< 队列满时返回 false
+  void Run();
+  bool EnsureConnected();  ///< 发送线程：按退避策略 (重新) 打开套接字
+  std::string Encode(std::string batch) const;
+
+  const NetworkSinkOptions options_;
+  spdlog::memory_buf_t formatted_;  ///< 受 base_sink::mutex_ 保护
+  uint64_t reported_drops_ = 0;     ///< 已插入说明的丢弃数 (受 base_sink::mutex_ 保护)
+
+  std::mutex queue_mutex_;
+  std::condition_variable queue_cv_;
+  std::deque<std::string> queue_;
+  bool flush_requested_ = false;
+  bool stop_ = false;
+
+  // 发送线程状态
+  LogSocket socket_;
+  std::chrono::steady_clock::time_point next_connect_{};
+  std::chrono::milliseconds backoff_{0};
+
+  std::atomic<uint64_t> sent_{0};
+  std::atomic<uint64_t> dropped_{0};
+  std::thread worker_;  ///< 最后声明：其余成员构造完成后才启动
+};
+
+}  // namespace log
+}  // namespace plugins
+}  // namespace z3y
+
+#endif  // Z3Y_PLUGIN_SPDLOG_NETWORK_LOG_SINK_H_
@@ -1,10 +1,16 @@
 ﻿#pragma once
-#include <spdlog/sinks/base_sink.h>
+#include <spdlog/sinks/sink.h>
 
-#include <map>
+#include <atomic>
+#include <memory>
 #include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 
 #include "interfaces_core/i_log_service.h"
+#include "structured_log_context.h"
 
 // 获取跨平台 PID
 #ifdef _WIN32
@@ -17,28 +23,57 @@
 
 namespace z3y::plugins::log {
 
-template <typename Mutex>
-class spdlog_observer_sink : public spdlog::sinks::base_sink<Mutex> {
+/**
+ * @brief 把日志转发给 UI 观察者的 Sink。挂在每一个 Logger 上。
+ * @details
+ * - **写时复制**: 观察者表是不可变快照，增删时整体替换；log() 只取一次快照，
+ * 回调在任何锁之外执行，UI 注册 / 注销不会拖慢正在写日志的线程。
+ * - **无人订阅即脱离**: 没有观察者时 Sink 级别为 off，Logger 在调用 log() 前的
+ * should_log 检查就把它跳过，Service 计算有效级别时也不再受它影响。
+ * - **回调并发**: 多个后台线程 (线程池 / 延迟格式化) 可能同时调用回调，
+ * 回调须自行保证线程安全。remove_observer 返回前会等待旧快照上的回调全部结束。
+ */
+class spdlog_observer_sink final : public spdlog::sinks::sink {
  public:
+  spdlog_observer_sink() { set_level(spdlog::level::off); }
+
   void add_observer(const std::string& name,
                     z3y::interfaces::core::LogObserverCallback cb) {
-    std::lock_guard<Mutex> lock(this->mutex_);
-    observers_[name] = cb;
+    std::lock_guard<std::mutex> lock(writer_mutex_);
+    auto next = std::make_shared<ObserverList>(*std::atomic_load(&observers_));
+    auto it = Find(*next, name);
+    if (it != next->end()) {
+      it->second = std::move(cb);
+    } else {
+      next->emplace_back(name, std::move(cb));
+    }
+    Publish(std::move(next));
   }
 
   void remove_observer(const std::string& name) {
-    std::lock_guard<Mutex> lock(this->mutex_);
-    observers_.erase(name);
+    std::lock_guard<std::mutex> lock(writer_mutex_);
+    auto next = std::make_shared<ObserverList>(*std::atomic_load(&observers_));
+    auto it = Find(*next, name);
+    if (it == next->end()) return;
+    next->erase(it);
+    Publish(std::move(next));
   }
 
- protected:
-  void sink_it_(const spdlog::details::log_msg& msg) override {
-    if (observers_.empty()) return;  // 没人订阅，直接零开销跳过
+  void log(const spdlog::details::log_msg& msg) override {
+    auto observers = std::atomic_load(&observers_);
+    if (observers->empty()) return;  // 级别切换前已进入的调用
+
+    // 名字与正文拷入线程内复用的缓冲区 (LogRecord 约定以 '\0' 结尾)，预热后不再分配
+    thread_local std::string scratch;
+    scratch.assign(msg.logger_name.data(), msg.logger_name.size());
+    scratch.push_back('\0');
+    scratch.append(msg.payload.data(), msg.payload.size());
+    const size_t name_length = msg.logger_name.size();
 
     z3y::interfaces::core::LogRecord record{};
     record.struct_size =
         static_cast<uint32_t>(sizeof(z3y::interfaces::core::LogRecord));
-    record.version = 1;
+    record.version = 3;
 
     record.timestamp_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
                               msg.time.time_since_epoch())
@@ -52,27 +87,51 @@ class spdlog_observer_sink : public spdlog::sinks::base_sink<Mutex> {
     record.func_name = msg.source.funcname ? msg.source.funcname : "Unknown";
     record.line_number = msg.source.line;
 
-    // 模块名转换
-    std::string logger_name_str = fmt::to_string(msg.logger_name);
-    record.logger_name = logger_name_str.c_str();
-
-    // 格式化后的完整日志 (包含时间等)
-    // 注意：这里由于我们直接给 UI，UI可能想要纯净的 payload，或者带格式的。
-    // 这里我们给纯净的消息，UI 自己决定怎么拼。
-    std::string payload_str = fmt::to_string(msg.payload);
-    record.message = payload_str.c_str();
+    // 纯净的消息正文 (不含时间等格式)，UI 自己决定怎么拼
+    record.logger_name = scratch.data();
+    record.logger_name_length = static_cast<uint32_t>(name_length);
+    record.message = scratch.data() + name_length + 1;
+    record.message_length = static_cast<uint32_t>(msg.payload.size());
+
+    // 结构化日志：字段原样交给观察者 (由写入线程公布，回调期间有效)
+    if (const StructuredLogContext* context = CurrentStructuredLog()) {
+      record.fields = context->fields;
+      record.field_count = context->field_count;
+      record.message_template = context->message_template;
+    }
 
-    // 同步分发给所有 UI
-    for (const auto& pair : observers_) {
+    // 在锁外分发给所有 UI
+    for (const auto& pair : *observers) {
       pair.second(record);
     }
   }
 
-  void flush_() override {}
+  void flush() override {}
+  void set_pattern(const std::string&) override {}
+  void set_formatter(std::unique_ptr<spdlog::formatter>) override {}
 
  private:
-  std::map<std::string, z3y::interfaces::core::LogObserverCallback> observers_;
+  using ObserverList =
+      std::vector<std::pair<std::string, z3y::interfaces::core::LogObserverCallback>>;
+
+  static ObserverList::iterator Find(ObserverList& list, const std::string& name) {
+    for (auto it = list.begin(); it != list.end(); ++it) {
+      if (it->first == name) return it;
+    }
+    return list.end();
+  }
+
+  /** @brief 发布新快照，并等待仍在使用旧快照的回调结束 (调用方持有 writer_mutex_)。 */
+  void Publish(std::shared_ptr<ObserverList> next) {
+    set_level(next->empty() ? spdlog::level::off : spdlog::level::trace);
+    std::shared_ptr<const ObserverList> previous =
+        std::atomic_exchange(&observers_, std::shared_ptr<const ObserverList>(std::move(next)));
+    while (previous.use_count() > 1) std::this_thread::yield();
+  }
+
+  std::mutex writer_mutex_;  ///< 串行化 add / remove
+  std::shared_ptr<const ObserverList> observers_ = std::make_shared<const ObserverList>();
 };
 
-using spdlog_observer_sink_mt = spdlog_observer_sink<std::mutex>;
+using spdlog_observer_sink_mt = spdlog_observer_sink;
 }  // namespace z3y::plugins::log
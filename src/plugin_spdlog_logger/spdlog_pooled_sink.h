@@ -0,0 +1,61 @@
+﻿#pragma once
+#include <spdlog/async_logger.h>
+#include <spdlog/details/thread_pool.h>
+#include <spdlog/sinks/sink.h>
+
+#include <memory>
+#include <string>
+#include <utility>
+
+namespace z3y::plugins::log {
+
+/**
+ * @brief 把写入转交给专属线程池的 Sink 外壳 (配置项 sinks.<name>.thread_pool)。
+ * @details
+ * Logger 所在线程池只做一次入队，真正的设备写入 (控制台、文件) 在 pool_ 的线程上执行，
+ * 慢设备不再拖住共用同一线程池的其它 Sink。入队的是完整的 log_msg 拷贝，
+ * 时间戳、线程 ID、Logger 名字都保持原样。
+ * target_ 是只挂着设备 Sink 的内部 async_logger (不注册到 spdlog 全局表)，
+ * 它的 flush_on 为 off：按级别刷盘由外层 Logger 触发，经 flush() 转交过来。
+ */
+class spdlog_pooled_sink final : public spdlog::sinks::sink {
+ public:
+  spdlog_pooled_sink(std::shared_ptr<spdlog::details::thread_pool> pool,
+                     spdlog::sink_ptr device,
+                     spdlog::async_overflow_policy policy)
+      : pool_(std::move(pool)),
+        device_(std::move(device)),
+        target_(std::make_shared<spdlog::async_logger>(
+            "__pooled_sink", device_, pool_, policy)),
+        policy_(policy) {
+    target_->set_level(spdlog::level::trace);
+    target_->flush_on(spdlog::level::off);
+  }
+
+  void log(const spdlog::details::log_msg& msg) override {
+    pool_->post_log(spdlog::details::async_logger_ptr(target_), msg, policy_);
+  }
+
+  void flush() override {
+    pool_->post_flush(spdlog::details::async_logger_ptr(target_), policy_);
+  }
+
+  /** @brief 被转交的设备 Sink (同步 / 优先通道的 Logger 直接写它)。 */
+  const spdlog::sink_ptr& device() const noexcept { return device_; }
+
+  void set_pattern(const std::string& pattern) override {
+    device_->set_pattern(pattern);
+  }
+
+  void set_formatter(std::unique_ptr<spdlog::formatter> sink_formatter) override {
+    device_->set_formatter(std::move(sink_formatter));
+  }
+
+ private:
+  std::shared_ptr<spdlog::details::thread_pool> pool_;
+  spdlog::sink_ptr device_;
+  std::shared_ptr<spdlog::async_logger> target_;
+  spdlog::async_overflow_policy policy_;
+};
+
+}  // namespace z3y::plugins::log
@@ -25,12 +25,17 @@
 
 // 引入宏定义头文件，解决 Z3Y_LOG_SOURCE_LOCATION 编译错误
 #include <algorithm>
+#include <atomic>
 #include <cctype>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
 
+#include "framework/thread_placement.h"
 #include "interfaces_core/z3y_log_macros.h"
+#include "json_lines_formatter.h"
+#include "mmap_binary_sink.h"
+#include "network_log_formatters.h"
 
 // spdlog headers
 #include <spdlog/async.h>
@@ -58,6 +63,64 @@ using json = nlohmann::json;
 
 // --- 辅助函数 ---
 
+bool SameRateLimit(const LogRateLimit& a, const LogRateLimit& b) {
+  return a.per_second == b.per_second && a.burst == b.burst &&
+         a.per_call_site == b.per_call_site &&
+         a.dedup_window_ms == b.dedup_window_ms;
+}
+
+// spdlog 后台线程启动回调：按宿主配置的 "spdlog.backend" 角色放置，各线程依次编号
+std::function<void()> MakeBackendThreadStart() {
+  auto next_index = std::make_shared<std::atomic<size_t>>(0);
+  return [next_index] {
+    (void)z3y::PlaceCurrentThread(
+        "spdlog.backend", next_index->fetch_add(1, std::memory_order_relaxed));
+  };
+}
+
+// "rate_limit": {"per_second", "burst", "per_call_site", "dedup_window_ms"}
+LogRateLimit ParseRateLimit(const nlohmann::json& rule) {
+  LogRateLimit limit;
+  if (!rule.contains("rate_limit")) return limit;
+  const auto& j = rule["rate_limit"];
+  limit.per_second = j.value("per_second", 0u);
+  limit.burst = j.value("burst", 0u);
+  limit.per_call_site = j.value("per_call_site", false);
+  limit.dedup_window_ms = j.value("dedup_window_ms", 0u);
+  return limit;
+}
+
+// "async_backend": "spdlog" | "thread_rings"
+LogAsyncBackend ParseAsyncBackend(const nlohmann::json& settings) {
+  const std::string backend = settings.value("async_backend", "spdlog");
+  if (backend == "spdlog") return LogAsyncBackend::Spdlog;
+  if (backend == "thread_rings") return LogAsyncBackend::ThreadRings;
+  throw std::runtime_error("Unsupported async_backend: " + backend);
+}
+
+// "delivery": "async" | "sync" | "priority"
+LogDelivery ParseDelivery(const nlohmann::json& rule) {
+  const std::string delivery = rule.value("delivery", "async");
+  if (delivery == "async") return LogDelivery::Async;
+  if (delivery == "sync") return LogDelivery::Sync;
+  if (delivery == "priority") return LogDelivery::Priority;
+  throw std::runtime_error("Unsupported delivery: " + delivery);
+}
+
+// 优先通道与同步 Logger 直接写设备：绑定专属线程池的 Sink 去掉转交这一层
+std::vector<spdlog::sink_ptr> DirectSinks(const std::vector<spdlog::sink_ptr>& sinks) {
+  std::vector<spdlog::sink_ptr> direct;
+  direct.reserve(sinks.size());
+  for (const auto& sink : sinks) {
+    if (auto pooled = std::dynamic_pointer_cast<spdlog_pooled_sink>(sink)) {
+      direct.push_back(pooled->device());
+    } else {
+      direct.push_back(sink);
+    }
+  }
+  return direct;
+}
+
 spdlog::level::level_enum ToSpdlogLevel(LogLevel level) {
   switch (level) {
     case LogLevel::Trace:
@@ -78,9 +141,19 @@ spdlog::level::level_enum ToSpdlogLevel(LogLevel level) {
 
 // --- LoggerImpl 实现 ---
 
-LoggerImpl::LoggerImpl(std::shared_ptr<spdlog::logger> logger)
-    : logger_(std::move(logger)) {}
-
+LoggerImpl::LoggerImpl(std::shared_ptr<spdlog::logger> logger,
+                       std::shared_ptr<DeferredLogBackend> deferred,
+                       std::shared_ptr<spdlog::logger> direct,
+                       spdlog::level::level_enum direct_level,
+                       bool text_via_rings)
+    : logger_(std::move(logger)),
+      deferred_(std::move(deferred)),
+      direct_(std::move(direct)),
+      direct_level_(direct_level),
+      text_via_rings_(text_via_rings && deferred_) {}
+
+// logger_ 的级别由 Service 维护为有效级别 (见 ApplyEffectiveLevel_UNLOCKED)，
+// should_log 只是一次 relaxed load 加比较。
 bool LoggerImpl::IsEnabled(LogLevel level) const noexcept {
   return logger_->should_log(ToSpdlogLevel(level));
 }
@@ -90,8 +163,79 @@ void LoggerImpl::Log(const LogSourceLocation& loc, LogLevel level,
   // 使用宏捕获的精确位置信息构造 spdlog source_loc
   spdlog::source_loc spdlog_loc{loc.file_name, (int)loc.line_number,
                                 loc.function_name};
+  const auto spd_level = ToSpdlogLevel(level);
+  // 优先通道：不进队列，调用线程写完 (含 flush_on) 才返回
+  if (Bypasses(spd_level)) {
+    if (logger_->should_log(spd_level)) direct_->log(spdlog_loc, spd_level, message);
+    return;
+  }
+  // 线程环：只把正文拷进本线程的环；环满且策略为丢弃时同样计入丢弃数
+  if (text_via_rings_ && logger_->should_log(spd_level) &&
+      deferred_->SubmitText(*logger_, loc, spd_level, message)) {
+    return;
+  }
   // spdlog 的 log 方法原生支持 const char*
-  logger_->log(spdlog_loc, ToSpdlogLevel(level), message);
+  logger_->log(spdlog_loc, spd_level, message);
+}
+
+void LoggerImpl::LogDeferred(const LogSourceLocation& loc, LogLevel level,
+                             const char* format, const LogArg* args,
+                             uint32_t arg_count) {
+  // 与 Log 相同，级别检查由宏负责；这里只在后台不可用时退回同步格式化
+  if (deferred_ && !Bypasses(ToSpdlogLevel(level)) &&
+      deferred_->Submit(*logger_, loc, ToSpdlogLevel(level), format, args, arg_count)) {
+    return;
+  }
+  Log(loc, level, FormatDeferred(format, args, arg_count).c_str());
+}
+
+void LoggerImpl::LogStructured(const LogSourceLocation& loc, LogLevel level,
+                               const char* message_template, const LogField* fields,
+                               uint32_t field_count) {
+  // 与 LogDeferred 相同走线程环；后台不可用时在调用线程渲染并直接写 Sink
+  // (不经异步队列，字段才能在写入期间交给 Sink)
+  const auto spd_level = ToSpdlogLevel(level);
+  if (Bypasses(spd_level)) {
+    if (logger_->should_log(spd_level)) {
+      WriteStructuredNow(*direct_, loc, spd_level, message_template, fields, field_count);
+    }
+    return;
+  }
+  if (deferred_ && deferred_->SubmitStructured(*logger_, loc, spd_level, message_template,
+                                               fields, field_count)) {
+    return;
+  }
+  WriteStructuredNow(*logger_, loc, spd_level, message_template, fields, field_count);
+}
+
+bool LoggerImpl::Admit(const LogSourceLocation& loc, LogLevel level) noexcept {
+  LogRateLimiter* limiter = limiter_.load(std::memory_order_acquire);
+  if (!limiter) return true;
+  uint64_t suppressed = 0;
+  if (!limiter->Admit(loc, &suppressed)) return false;
+  if (suppressed > 0) {
+    // 以放行日志的级别补报此前被丢弃的条数
+    try {
+      spdlog::source_loc spdlog_loc{loc.file_name, (int)loc.line_number,
+                                    loc.function_name};
+      logger_->log(spdlog_loc, ToSpdlogLevel(level),
+                   "[rate limit] {} messages suppressed from this {}", suppressed,
+                   limiter->counts_per_call_site() ? "call site" : "logger");
+    } catch (...) {
+    }
+  }
+  return true;
+}
+
+void LoggerImpl::SetRateLimit(const LogRateLimit& limit) {
+  LogRateLimiter* current = limiter_.load(std::memory_order_relaxed);
+  if (LogRateLimiter::IsUnlimited(limit)) {
+    limiter_.store(nullptr, std::memory_order_release);
+    return;
+  }
+  if (current && SameRateLimit(current->limit(), limit)) return;
+  limiters_.push_back(std::make_unique<LogRateLimiter>(limit));
+  limiter_.store(limiters_.back().get(), std::memory_order_release);
 }
 
 // --- SpdlogProviderService 实现 ---
@@ -117,6 +261,9 @@ SpdlogProviderService::SpdlogProviderService() {
 SpdlogProviderService::~SpdlogProviderService() {
   // [生命周期] 仅在析构函数中彻底关闭 spdlog。
   // 此时应保证没有其他业务组件在运行。
+  // 延迟格式化线程先停：它直接写 Sink，必须在 spdlog 释放 Sink 之前结束。
+  if (deferred_) deferred_->Stop();
+  batch_dispatcher_.Stop();
   if (is_initialized_) {
     spdlog::shutdown();
   }
@@ -125,24 +272,76 @@ SpdlogProviderService::~SpdlogProviderService() {
 void SpdlogProviderService::Shutdown() {
   // [生命周期] 仅 Flush，不 Shutdown。
   // 防止框架卸载过程中，其他组件析构函数写日志导致崩溃。
+  if (deferred_) deferred_->Drain();
   if (is_initialized_) {
     spdlog::apply_all([](std::shared_ptr<spdlog::logger> l) { l->flush(); });
   }
 }
 
 void SpdlogProviderService::Flush() {
+  // 先把延迟格式化的记录写入 Sink，再统一刷盘
+  if (deferred_) deferred_->Drain();
   if (is_initialized_) {
     spdlog::apply_all([](std::shared_ptr<spdlog::logger> l) { l->flush(); });
   }
 }
 
+LogQueueStats SpdlogProviderService::GetQueueStats() {
+  LogQueueStats stats;
+  std::shared_lock lock(provider_lock_);
+  if (!is_initialized_) return stats;
+  stats.loggers = logger_cache_.size();
+
+  auto add_pool = [&stats](spdlog::details::thread_pool& pool, size_t capacity) {
+    stats.queued += pool.queue_size();
+    stats.overrun += pool.overrun_counter();
+    stats.discarded += pool.discard_counter();
+    stats.capacity += capacity;
+    ++stats.pools;
+  };
+  if (auto global_pool = spdlog::thread_pool()) {
+    add_pool(*global_pool, async_queue_size_);
+  }
+  for (const auto& [name, pool] : thread_pools_) {
+    auto cap_it = thread_pool_capacity_.find(name);
+    add_pool(*pool, cap_it != thread_pool_capacity_.end() ? cap_it->second
+                                                          : async_queue_size_);
+  }
+  // 线程环 (延迟格式化与 thread_rings 后端)：容量按字节计，不计入 capacity；环满丢弃即 discard_new
+  if (deferred_) {
+    stats.queued += deferred_->Queued();
+    stats.discarded += deferred_->Dropped();
+  }
+  // 网络 Sink 的发送队列满时丢弃新记录，与 discard_new 同义
+  for (const auto& sink : network_sinks_) {
+    stats.queued += sink->queued();
+    stats.capacity += sink->capacity();
+    stats.discarded += sink->dropped_records();
+  }
+  return stats;
+}
+
 void SpdlogProviderService::AddLogObserver(const std::string& name,
                                            LogObserverCallback cb) {
   observer_sink_->add_observer(name, cb);
+  batch_dispatcher_.Remove(name);  // 同名的批量观察者已被替换
+  // 有了观察者，Observer Sink 开始接收全部级别，需要放开各 Logger 的门槛
+  ApplyEffectiveLevelToAll();
 }
 
 void SpdlogProviderService::RemoveLogObserver(const std::string& name) {
+  // 先摘掉 Feed，再投递批量观察者剩余的记录
   observer_sink_->remove_observer(name);
+  batch_dispatcher_.Remove(name);
+  ApplyEffectiveLevelToAll();
+}
+
+void SpdlogProviderService::AddLogBatchObserver(
+    const std::string& name, LogBatchObserverCallback callback,
+    const LogBatchOptions& options) {
+  observer_sink_->add_observer(
+      name, batch_dispatcher_.Add(name, std::move(callback), options));
+  ApplyEffectiveLevelToAll();
 }
 
 // [P1] 动态设置日志级别
@@ -152,23 +351,14 @@ void SpdlogProviderService::SetLevel(const std::string& name_prefix,
   if (!is_initialized_) return;
   auto spd_level = ToSpdlogLevel(level);
 
-  std::unique_lock<std::shared_mutex> lock(provider_lock_);
+  std::unique_lock lock(provider_lock_);
 
-  // 1. 持久化规则：将此规则存入列表，以便 ApplyLevelOverrides_UNLOCKED 在创建新
-  // Logger 时使用。
-  level_overrides_.push_back({name_prefix, spd_level});
-
-  // 2. 即时生效：遍历当前缓存的所有 Logger，匹配前缀并更新级别。
-  int count = 0;
-  for (auto& [name, logger_impl] : logger_cache_) {
-    // rfind(prefix, 0) == 0 用于判断 starts_with
-    if (name_prefix.empty() || name.rfind(name_prefix, 0) == 0) {
-      if (logger_impl) {
-        logger_impl->GetSpdlogLogger()->set_level(spd_level);
-        count++;
-      }
-    }
-  }
+  // 覆写记在前缀节点上 (未来创建的 Logger 沿名字继承)，并只对该前缀子树里的
+  // Logger 重新计算级别。
+  const size_t count =
+      logger_tree_.SetLevel(name_prefix, spd_level, [&](LoggerImpl& logger_impl) {
+        ApplyEffectiveLevel_UNLOCKED(spd_level, *logger_impl.GetSpdlogLogger());
+      });
 
   // 记录操作日志
   if (fallback_logger_) {
@@ -179,14 +369,44 @@ void SpdlogProviderService::SetLevel(const std::string& name_prefix,
   }
 }
 
-void SpdlogProviderService::ApplyLevelOverrides_UNLOCKED(
-    const std::string& name, std::shared_ptr<spdlog::logger> logger) {
-  // 遍历所有已记录的覆写规则，后设置的优先级更高（覆盖前面的）。
-  for (const auto& override : level_overrides_) {
-    if (override.prefix.empty() || name.rfind(override.prefix, 0) == 0) {
-      logger->set_level(override.level);
-    }
+// 动态设置限流参数：与 SetLevel 相同，既更新已缓存的 Logger，也记入未来创建的 Logger
+void SpdlogProviderService::SetRateLimit(const std::string& name_prefix,
+                                         const LogRateLimit& limit) {
+  if (!is_initialized_) return;
+
+  std::unique_lock lock(provider_lock_);
+  const size_t count = logger_tree_.SetRateLimit(
+      name_prefix, limit, [&](LoggerImpl& logger_impl) { logger_impl.SetRateLimit(limit); });
+
+  if (fallback_logger_) {
+    fallback_logger_->Log(
+        Z3Y_LOG_SOURCE_LOCATION(), LogLevel::Info,
+        fmt::format("SetRateLimit: Prefix='{}' -> {}/s burst {}{}, dedup {}ms. "
+                    "Updated {} loggers.",
+                    name_prefix, limit.per_second, limit.burst,
+                    limit.per_call_site ? " per call site" : "",
+                    limit.dedup_window_ms, count).c_str());
+  }
+}
+
+void SpdlogProviderService::ApplyEffectiveLevel_UNLOCKED(
+    spdlog::level::level_enum requested, spdlog::logger& logger) {
+  // Sink 门槛：低于所有 Sink 级别的消息格式化后也只会被丢弃。
+  // (Observer Sink 没有观察者时级别为 off，自然不参与)
+  auto floor = spdlog::level::off;
+  for (const auto& sink : logger.sinks()) {
+    floor = std::min(floor, sink->level());
   }
+
+  logger.set_level(std::max(requested, floor));
+}
+
+void SpdlogProviderService::ApplyEffectiveLevelToAll() {
+  if (!is_initialized_) return;
+  std::unique_lock lock(provider_lock_);
+  logger_tree_.ForEach([&](LoggerImpl& logger_impl, const auto& resolved) {
+    ApplyEffectiveLevel_UNLOCKED(resolved.level, *logger_impl.GetSpdlogLogger());
+  });
 }
 
 spdlog::level::level_enum SpdlogProviderService::ParseLogLevel(
@@ -202,6 +422,7 @@ spdlog::level::level_enum SpdlogProviderService::ParseLogLevel(
   if (lower == "warn") return spdlog::level::warn;
   if (lower == "error") return spdlog::level::err;
   if (lower == "fatal") return spdlog::level::critical;
+  if (lower == "off") return spdlog::level::off;
   return default_level;
 }
 
@@ -235,9 +456,9 @@ bool SpdlogProviderService::InitializeService(
     // [Robustness] 允许 JSON 解析抛出异常，我们在外层捕获并打印错误日志
     json config = json::parse(f);
 
-    std::unique_lock<std::shared_mutex> provider_lock(provider_lock_);
+    std::unique_lock provider_lock(provider_lock_);
     log_directory_ = log_root_directory;
-    level_overrides_.clear();
+    logger_tree_ = LoggerTree<LoggerImpl>();
 
     // 1. 解析全局配置
     if (config.contains("global_settings")) {
@@ -245,13 +466,39 @@ bool SpdlogProviderService::InitializeService(
       format_pattern_ =
           gs.value("format_pattern", "[%Y-%m-%d %H:%M:%S.%e] [%L] [%n] %v");
       async_queue_size_ = gs.value("async_queue_size", 8192);
+      async_thread_count_ = gs.value("async_thread_count", 1);
       std::string p_str = gs.value("async_overflow_policy", "block");
       async_policy_ = (p_str == "overrun_oldest")
                           ? spdlog::async_overflow_policy::overrun_oldest
                           : spdlog::async_overflow_policy::block;
+      async_backend_ = ParseAsyncBackend(gs);
+      // 单生产者环无法由提交方丢弃最旧的记录 (读位置归后台线程所有)，
+      // overrun_oldest 时普通日志仍走 spdlog 队列，保留 "丢弃最旧" 的语义
+      if (async_backend_ == LogAsyncBackend::ThreadRings &&
+          async_policy_ == spdlog::async_overflow_policy::overrun_oldest) {
+        fallback_logger_->Log(Z3Y_LOG_SOURCE_LOCATION(), LogLevel::Warn,
+                              "async_backend \"thread_rings\" cannot drop the oldest "
+                              "records; using \"spdlog\" for async_overflow_policy "
+                              "\"overrun_oldest\".");
+        async_backend_ = LogAsyncBackend::Spdlog;
+      }
 
       flush_interval_sec_ = gs.value("flush_interval_seconds", 5);
-      std::string f_lvl = gs.value("flush_on_level", "error");
+      deferred_ring_kb_ = gs.value("deferred_ring_kb", 256);
+
+      // 崩溃环：最近的日志写入即进入映射文件，不再需要按级别同步刷盘
+      if (gs.contains("crash_ring")) {
+        auto& cr = gs["crash_ring"];
+        const std::filesystem::path ring_path =
+            z3y::utils::Utf8ToPath(log_root_directory) /
+            z3y::utils::Utf8ToPath(cr.value("base_name", "crash/app.ring"));
+        crash_ring_ = std::make_shared<crash_ring_sink>(
+            ring_path, cr.value("size_kb", size_t{4096}) * 1024,
+            cr.value("signal_handler", true));
+        crash_ring_->set_level(
+            ParseLogLevel(cr.value("level", "info"), spdlog::level::info));
+      }
+      std::string f_lvl = gs.value("flush_on_level", crash_ring_ ? "off" : "error");
       flush_level_ = ParseLogLevel(f_lvl, spdlog::level::err);
     }
 
@@ -260,16 +507,35 @@ bool SpdlogProviderService::InitializeService(
     // 线程池，再次初始化会抛出异常。
     // 我们捕获该异常并记录警告，继续使用现有的线程池。
     try {
-      spdlog::init_thread_pool(async_queue_size_, 1);
+      spdlog::init_thread_pool(async_queue_size_, async_thread_count_,
+                               MakeBackendThreadStart());
     } catch (const spdlog::spdlog_ex&) {
       fallback_logger_->Log(Z3Y_LOG_SOURCE_LOCATION(), LogLevel::Warn,
                             "Spdlog thread pool already initialized. "
                             "Configured async_queue_size ignored.");
     }
 
+    // 2.1 具名线程池：Rule / Sink 可按名字绑定到独立的后台线程
+    thread_pools_.clear();
+    thread_pool_capacity_.clear();
+    if (config.contains("thread_pools")) {
+      for (auto& [name, pool_conf] : config["thread_pools"].items()) {
+        const size_t queue_size = pool_conf.value("queue_size", async_queue_size_);
+        thread_pools_[name] = std::make_shared<spdlog::details::thread_pool>(
+            queue_size, pool_conf.value("threads", size_t{1}),
+            MakeBackendThreadStart());
+        thread_pool_capacity_[name] = queue_size;
+      }
+    }
+
     // 3. 设置定期刷盘
     spdlog::flush_every(std::chrono::seconds(flush_interval_sec_));
 
+    // 3.1 延迟格式化后台线程 (环满策略与异步队列一致)
+    deferred_ = std::make_shared<DeferredLogBackend>(
+        deferred_ring_kb_ * 1024,
+        async_policy_ == spdlog::async_overflow_policy::block);
+
     // 4. 解析 Sinks (输出目标)
     if (config.contains("sinks")) {
       for (auto& [name, sink_conf] : config["sinks"].items()) {
@@ -280,11 +546,73 @@ bool SpdlogProviderService::InitializeService(
 
         if (cfg.type.find("file") != std::string::npos) {
           cfg.base_name = sink_conf.value("base_name", "app.log");
+        } else if (cfg.type == "mmap_binary_sink") {
+          cfg.base_name = sink_conf.value("base_name", "app.blog");
         }
-        if (cfg.type == "rotating_file_sink") {
+        if (cfg.type == "rotating_file_sink" || cfg.type == "coalescing_file_sink" ||
+            cfg.type == "mmap_binary_sink") {
           cfg.max_size = sink_conf.value("max_size", 1024 * 1024 * 5);
           cfg.max_files = sink_conf.value("max_files", 3);
         }
+        if (cfg.type == "coalescing_file_sink") {
+          cfg.buffer_kb = sink_conf.value("buffer_kb", cfg.buffer_kb);
+        }
+        if (cfg.type == "rotating_file_sink") {
+          cfg.compression = sink_conf.value("compression", "");
+          if (cfg.compression == "none") cfg.compression.clear();
+          if (!cfg.compression.empty() && cfg.compression != "lz4") {
+            throw std::runtime_error("Unsupported compression: " + cfg.compression +
+                                     " (sink '" + name + "', available: lz4)");
+          }
+          auto& opt = cfg.compression_options;
+          opt.level = sink_conf.value("compression_level", opt.level);
+          opt.compress_active = sink_conf.value("compress_active", opt.compress_active);
+          opt.cpu_percent =
+              sink_conf.value("compression_cpu_percent", opt.cpu_percent);
+        }
+        const std::string format = sink_conf.value("format", "text");
+        const bool network = cfg.type == "network_sink";
+        if (format != "text" && format != "json" &&
+            !(network && (format == "syslog" || format == "gelf"))) {
+          throw std::runtime_error("Unsupported format: " + format + " (sink '" + name +
+                                   "', available: text, json" +
+                                   (network ? ", syslog, gelf)" : ")"));
+        }
+        cfg.format = cfg.type == "mmap_binary_sink" ? "text" : format;
+        if (network) {
+          auto& net = cfg.network;
+          net.target = sink_conf.value("target", "");
+          if (net.target.empty()) {
+            throw std::runtime_error("network_sink '" + name + "' requires target");
+          }
+          const std::string protocol = sink_conf.value("protocol", "udp");
+          if (protocol != "udp" && protocol != "tcp") {
+            throw std::runtime_error("Unsupported protocol: " + protocol + " (sink '" + name +
+                                     "', available: udp, tcp)");
+          }
+          net.tcp = protocol == "tcp";
+          const std::string compression = sink_conf.value("compression", "none");
+          if (compression != "none" && compression != "lz4") {
+            throw std::runtime_error("Unsupported compression: " + compression + " (sink '" +
+                                     name + "', available: lz4)");
+          }
+          net.lz4 = compression == "lz4";
+          net.compression_level = sink_conf.value("compression_level", net.compression_level);
+          net.queue_size = sink_conf.value("queue_size", net.queue_size);
+          // 标准 syslog / GELF 的 UDP 收集端要求一个数据报一条消息
+          const bool one_per_datagram = !net.tcp && format != "text" && format != "json";
+          net.max_batch_records =
+              sink_conf.value("max_batch_records", one_per_datagram ? size_t{1} : size_t{64});
+          net.max_batch_bytes = sink_conf.value("max_batch_bytes", net.max_batch_bytes);
+          net.flush_interval_ms = sink_conf.value("flush_interval_ms", net.flush_interval_ms);
+          net.timeout_ms = sink_conf.value("timeout_ms", net.timeout_ms);
+          net.delimiter = format == "gelf" ? '\0' : '\n';
+          cfg.app_name = sink_conf.value("app_name", cfg.app_name);
+          cfg.syslog_facility =
+              std::clamp(sink_conf.value("syslog_facility", cfg.syslog_facility), 0, 23);
+        }
+        cfg.thread_pool = sink_conf.value("thread_pool", "");
+        if (!cfg.thread_pool.empty()) FindThreadPool_UNLOCKED(cfg.thread_pool);
         sinks_config_[name] = cfg;
       }
     }
@@ -293,12 +621,27 @@ bool SpdlogProviderService::InitializeService(
     if (config.contains("default_rule")) {
       default_rule_.sink_names =
           config["default_rule"].value("sinks", std::vector<std::string>{});
+      default_rule_.thread_pool =
+          config["default_rule"].value("thread_pool", "");
+      default_rule_.rate_limit = ParseRateLimit(config["default_rule"]);
+      default_rule_.delivery = ParseDelivery(config["default_rule"]);
+      default_rule_.priority_level = ParseLogLevel(
+          config["default_rule"].value("priority_level", "error"), spdlog::level::err);
+      if (!default_rule_.thread_pool.empty()) {
+        FindThreadPool_UNLOCKED(default_rule_.thread_pool);
+      }
     }
     if (config.contains("rules")) {
       for (const auto& rule : config["rules"]) {
         RuleConfig cfg;
         cfg.matcher = rule.value("matcher", "");
         cfg.sink_names = rule.value("sinks", std::vector<std::string>{});
+        cfg.thread_pool = rule.value("thread_pool", "");
+        cfg.rate_limit = ParseRateLimit(rule);
+        cfg.delivery = ParseDelivery(rule);
+        cfg.priority_level =
+            ParseLogLevel(rule.value("priority_level", "error"), spdlog::level::err);
+        if (!cfg.thread_pool.empty()) FindThreadPool_UNLOCKED(cfg.thread_pool);
         if (!cfg.matcher.empty()) rules_.push_back(cfg);
       }
     }
@@ -306,12 +649,30 @@ bool SpdlogProviderService::InitializeService(
     std::sort(rules_.begin(), rules_.end(), [](const auto& a, const auto& b) {
       return a.matcher.length() > b.matcher.length();
     });
+    for (size_t i = 0; i < rules_.size(); ++i) {
+      logger_tree_.AddRule(rules_[i].matcher, static_cast<int>(i));
+    }
 
     is_initialized_ = true;
 
     fallback_logger_->Log(
         Z3Y_LOG_SOURCE_LOCATION(), LogLevel::Info,
         fmt::format("Log Service Initialized. Conf: {}", config_file_path).c_str());
+    if (crash_ring_) {
+      const auto& recovery = crash_ring_->recovery();
+      if (recovery.records > 0) {
+        fallback_logger_->Log(
+            Z3Y_LOG_SOURCE_LOCATION(), LogLevel::Warn,
+            fmt::format("Crash ring: recovered {} records of the previous run (signal {}) -> {}",
+                        recovery.records, recovery.signal,
+                        z3y::utils::PathToUtf8(recovery.path))
+                .c_str());
+      } else if (!recovery.error.empty()) {
+        fallback_logger_->Log(
+            Z3Y_LOG_SOURCE_LOCATION(), LogLevel::Warn,
+            fmt::format("Crash ring: recovery failed: {}", recovery.error).c_str());
+      }
+    }
 
     return true;
 
@@ -323,6 +684,15 @@ bool SpdlogProviderService::InitializeService(
   }
 }
 
+std::shared_ptr<spdlog::details::thread_pool>
+SpdlogProviderService::FindThreadPool_UNLOCKED(const std::string& pool_name) {
+  auto it = thread_pools_.find(pool_name);
+  if (it == thread_pools_.end()) {
+    throw std::runtime_error("Undefined thread pool: " + pool_name);
+  }
+  return it->second;
+}
+
 std::shared_ptr<spdlog::sinks::sink>
 SpdlogProviderService::GetOrCreateSink_UNLOCKED(const std::string& sink_name) {
   auto it = sinks_config_.find(sink_name);
@@ -340,7 +710,9 @@ SpdlogProviderService::GetOrCreateSink_UNLOCKED(const std::string& sink_name) {
 
   // 自动创建目录
   if ((config.type == "daily_file_sink" ||
-       config.type == "rotating_file_sink") &&
+       config.type == "rotating_file_sink" ||
+       config.type == "coalescing_file_sink" ||
+       config.type == "mmap_binary_sink") &&
       full_path.has_parent_path()) {
     std::error_code ec;
     std::filesystem::create_directories(full_path.parent_path(), ec);
@@ -356,15 +728,47 @@ SpdlogProviderService::GetOrCreateSink_UNLOCKED(const std::string& sink_name) {
   } else if (config.type == "daily_file_sink") {
     new_sink =
         std::make_shared<spdlog::sinks::daily_file_sink_mt>(native_path, 0, 0);
+  } else if (config.type == "rotating_file_sink" && !config.compression.empty()) {
+    new_sink = std::make_shared<compressed_rotating_file_sink>(
+        full_path, config.max_size, config.max_files, config.compression_options);
   } else if (config.type == "rotating_file_sink") {
     new_sink = std::make_shared<spdlog::sinks::rotating_file_sink_mt>(
         native_path, config.max_size, config.max_files);
+  } else if (config.type == "coalescing_file_sink") {
+    // 攒满 buffer_kb 才交给 I/O 线程写盘，格式化线程不等磁盘
+    new_sink = std::make_shared<coalescing_file_sink>(full_path, config.max_size,
+                                                      config.max_files,
+                                                      config.buffer_kb * 1024);
+  } else if (config.type == "mmap_binary_sink") {
+    // 二进制记录不使用 pattern，max_size 为每段预分配大小，max_files 为保留段数
+    new_sink = std::make_shared<mmap_binary_sink>(full_path, config.max_size,
+                                                  config.max_files);
+  } else if (config.type == "network_sink") {
+    auto network_sink = std::make_shared<network_log_sink>(config.network);
+    network_sinks_.push_back(network_sink);
+    new_sink = network_sink;
   } else {
     throw std::runtime_error("Unsupported sink type: " + config.type);
   }
 
   new_sink->set_level(config.level);
-  new_sink->set_pattern(format_pattern_);
+  if (config.format == "json") {
+    new_sink->set_formatter(std::make_unique<json_lines_formatter>());
+  } else if (config.format == "syslog") {
+    new_sink->set_formatter(std::make_unique<syslog_formatter>(
+        config.app_name, LocalHostName(), config.syslog_facility));
+  } else if (config.format == "gelf") {
+    new_sink->set_formatter(std::make_unique<gelf_formatter>(LocalHostName()));
+  } else {
+    new_sink->set_pattern(format_pattern_);
+  }
+  // 绑定了专属线程池：外层只入队，设备写入在该线程池上串行执行
+  if (!config.thread_pool.empty()) {
+    auto pooled = std::make_shared<spdlog_pooled_sink>(
+        FindThreadPool_UNLOCKED(config.thread_pool), new_sink, async_policy_);
+    pooled->set_level(config.level);
+    new_sink = pooled;
+  }
   config.instance = new_sink;
   return new_sink;
 }
@@ -372,28 +776,21 @@ SpdlogProviderService::GetOrCreateSink_UNLOCKED(const std::string& sink_name) {
 PluginPtr<ILogger> SpdlogProviderService::GetLogger(const std::string& name) {
   if (!is_initialized_) return GetFallbackLogger(name);
 
-  // [性能优化] 1. 读锁检查缓存 (Fast Path)
-  {
-    std::shared_lock<std::shared_mutex> read_lock(provider_lock_);
-    auto it = logger_cache_.find(name);
-    if (it != logger_cache_.end()) return it->second;
-  }
+  // [性能优化] 1. 无锁查表 (Fast Path)
+  const uint64_t hash = LoggerNameTable<LoggerImpl>::Hash(name);
+  if (auto cached = logger_table_.Find(name, hash)) return cached;
 
   // [性能优化] 2. 写锁创建 (Slow Path)
-  std::unique_lock<std::shared_mutex> write_lock(provider_lock_);
-  // [双重检查锁定] 再次检查，防止在锁升级期间被其他线程创建
+  std::unique_lock write_lock(provider_lock_);
+  // [双重检查锁定] 再次检查，防止在等待写锁期间被其他线程创建
   auto it = logger_cache_.find(name);
   if (it != logger_cache_.end()) return it->second;
 
   try {
-    // 匹配规则
-    RuleConfig* matched_rule = &default_rule_;
-    for (auto& r : rules_) {
-      if (name.rfind(r.matcher, 0) == 0) {
-        matched_rule = &r;
-        break;
-      }
-    }
+    // 匹配规则与覆写 (名字树上路径最深者生效)
+    const auto resolved = logger_tree_.Resolve(name);
+    RuleConfig* matched_rule =
+        resolved.rule >= 0 ? &rules_[resolved.rule] : &default_rule_;
 
     // 收集 Sinks
     std::vector<spdlog::sink_ptr> sinks;
@@ -403,22 +800,53 @@ PluginPtr<ILogger> SpdlogProviderService::GetLogger(const std::string& name) {
 
     // === 强行把 Observer Sink 挂载到所有新创建的 Logger 上 ===
     sinks.push_back(observer_sink_);
+    if (crash_ring_) sinks.push_back(crash_ring_);
+
+    // 按 Rule 的 delivery 创建 Logger：
+    // async / priority 为异步 Logger (Rule 绑定了线程池时入队到该线程池)，sync 为同步 Logger
+    std::shared_ptr<spdlog::logger> spd_logger;
+    std::shared_ptr<spdlog::logger> direct;
+    if (matched_rule->delivery == LogDelivery::Sync) {
+      const auto direct_sinks = DirectSinks(sinks);
+      spd_logger = std::make_shared<spdlog::logger>(name, direct_sinks.begin(),
+                                                    direct_sinks.end());
+    } else {
+      auto pool = matched_rule->thread_pool.empty()
+                      ? spdlog::thread_pool()
+                      : FindThreadPool_UNLOCKED(matched_rule->thread_pool);
+      spd_logger = std::make_shared<spdlog::async_logger>(
+          name, sinks.begin(), sinks.end(), pool, async_policy_);
+    }
+    if (matched_rule->delivery == LogDelivery::Priority) {
+      // 与 spd_logger 共用 Sink 实例，不注册到 spdlog 全局表 (刷盘经 spd_logger 完成)
+      const auto direct_sinks = DirectSinks(sinks);
+      direct = std::make_shared<spdlog::logger>(name, direct_sinks.begin(),
+                                                direct_sinks.end());
+      direct->set_level(spdlog::level::trace);
+      direct->flush_on(flush_level_);
+    }
 
-    // 创建异步 Logger
-    auto spd_logger = std::make_shared<spdlog::async_logger>(
-        name, sinks.begin(), sinks.end(), spdlog::thread_pool(), async_policy_);
-
-    spd_logger->set_level(spdlog::level::trace);  // 默认全开，由 Sinks 过滤
-    spd_logger->flush_on(flush_level_);           // 自动刷盘策略
+    spd_logger->flush_on(flush_level_);  // 自动刷盘策略
 
-    // 应用动态覆写规则 (检查是否有运维命令要求修改此 Logger 的级别)
-    ApplyLevelOverrides_UNLOCKED(name, spd_logger);
+    // 计算有效级别：动态覆写规则 + Sinks 门槛 (没有 Sink 接收的级别直接拦截)
+    ApplyEffectiveLevel_UNLOCKED(resolved.level, *spd_logger);
 
     // 必须注册到 spdlog 全局表，调用 Flush() 时才能找到它
     spdlog::register_logger(spd_logger);
 
-    auto wrapper = std::make_shared<LoggerImpl>(spd_logger);
+    // 同步 Logger 不经延迟格式化后台 (后台线程会把写入挪出调用线程)；
+    // 绑定了具名线程池的 Rule 保持在自己的线程池上，不改走线程环
+    const bool text_via_rings = async_backend_ == LogAsyncBackend::ThreadRings &&
+                                matched_rule->thread_pool.empty();
+    auto wrapper = std::make_shared<LoggerImpl>(
+        spd_logger,
+        matched_rule->delivery == LogDelivery::Sync ? nullptr : deferred_, direct,
+        matched_rule->priority_level, text_via_rings);
+    // 限流参数：SetRateLimit 的覆写优先，否则取 Rule 的 rate_limit
+    wrapper->SetRateLimit(resolved.rate_limit.value_or(matched_rule->rate_limit));
     logger_cache_[name] = wrapper;
+    logger_table_.Insert(name, hash, wrapper);
+    logger_tree_.Attach(name, wrapper.get());
     return wrapper;
 
   } catch (const std::exception& e) {
@@ -40,17 +40,26 @@
 
 #include <atomic>
 #include <filesystem>
-#include <list>
 #include <map>
 #include <mutex>
 #include <shared_mutex>  // C++17 读写锁
 #include <string>
 #include <vector>
 
+#include "framework/profiled_mutex.h"
 #include "framework/z3y_define_impl.h"
 #include "interfaces_core/i_log_service.h"
 
+#include "coalescing_file_sink.h"
+#include "deferred_log_backend.h"
+#include "compressed_rotating_file_sink.h"
+#include "crash_ring_sink.h"
+#include "log_batch_dispatcher.h"
+#include "log_rate_limiter.h"
+#include "logger_lookup.h"
+#include "network_log_sink.h"
 #include "spdlog_observer_sink.h"
+#include "spdlog_pooled_sink.h"
 
 namespace z3y {
 namespace plugins {
@@ -61,23 +70,60 @@ using namespace z3y::interfaces::core;
 /**
  * @class LoggerImpl
  * @brief [内部适配器] 将 ILogger 接口调用转发给 spdlog::logger。
- * @details 持有一个 spdlog::logger 的 shared_ptr。
+ * @details 持有一个 spdlog::logger 的 shared_ptr。ILogger 不需要菱形继承，
+ *          因此使用 `DirectPluginImpl` 并声明为 final，插件内部的调用可去虚化。
  */
-class LoggerImpl : public PluginImpl<LoggerImpl, ILogger> {
+class LoggerImpl final : public DirectPluginImpl<LoggerImpl, ILogger> {
  public:
   Z3Y_DEFINE_COMPONENT_ID("z3y-core-CLogChannelImpl-UUID-L0000004");
 
-  explicit LoggerImpl(std::shared_ptr<spdlog::logger> logger);
+  /**
+   * @param direct 不经队列、在调用线程写入 Sink 的同步 Logger (Rule 的 delivery 为 "priority")；
+   * 级别不低于 direct_level 的日志改由它写入。
+   * @param text_via_rings Log() 的正文也写入 deferred 的线程环 (async_backend 为 "thread_rings")。
+   */
+  explicit LoggerImpl(std::shared_ptr<spdlog::logger> logger,
+                      std::shared_ptr<DeferredLogBackend> deferred = nullptr,
+                      std::shared_ptr<spdlog::logger> direct = nullptr,
+                      spdlog::level::level_enum direct_level = spdlog::level::off,
+                      bool text_via_rings = false);
 
   bool IsEnabled(LogLevel level) const noexcept override;
   void Log(const LogSourceLocation& loc, LogLevel level,
            const char* message) override;
+  void LogDeferred(const LogSourceLocation& loc, LogLevel level,
+                   const char* format, const LogArg* args,
+                   uint32_t arg_count) override;
+  bool Admit(const LogSourceLocation& loc, LogLevel level) noexcept override;
+  void LogStructured(const LogSourceLocation& loc, LogLevel level,
+                     const char* message_template, const LogField* fields,
+                     uint32_t field_count) override;
 
   // [内部] 暴露底层指针，供 Service 动态修改级别
   std::shared_ptr<spdlog::logger> GetSpdlogLogger() { return logger_; }
 
+  // [内部] 替换限流参数 (Service 在 provider_lock_ 写锁下调用)
+  void SetRateLimit(const LogRateLimit& limit);
+
  private:
+  /** @brief 该级别是否绕过队列，由 direct_ 在调用线程写入。 */
+  bool Bypasses(spdlog::level::level_enum level) const noexcept {
+    return direct_ && level >= direct_level_;
+  }
+
   std::shared_ptr<spdlog::logger> logger_;
+  // 延迟格式化后台 (Fallback Logger 与同步 Logger 为空，此时 LogDeferred 在调用线程格式化)
+  std::shared_ptr<DeferredLogBackend> deferred_;
+  // 优先通道：级别门槛仍以 logger_ 为准，direct_ 本身不过滤
+  std::shared_ptr<spdlog::logger> direct_;
+  spdlog::level::level_enum direct_level_;
+  // Log() 经 deferred_ 的线程环提交，不进 spdlog 的异步队列
+  bool text_via_rings_;
+
+  // 当前限流器 (nullptr = 不限流)。替换后旧限流器保留在 limiters_ 中，
+  // 正在 Admit 的线程可能仍持有它的指针，随 LoggerImpl 一起释放。
+  std::atomic<LogRateLimiter*> limiter_{nullptr};
+  std::vector<std::unique_ptr<LogRateLimiter>> limiters_;
 };
 
 /**
@@ -86,17 +132,49 @@ class LoggerImpl : public PluginImpl<LoggerImpl, ILogger> {
  */
 struct SinkConfig {
   std::string type;       // 类型: "stdout_color_sink", "daily_file_sink",
-                          // "rotating_file_sink"
+                          // "rotating_file_sink", "coalescing_file_sink",
+                          // "mmap_binary_sink", "network_sink"
   std::string base_name;  // 路径 (UTF-8 编码)
+  std::string format = "text";  // "text" / "json" / "syslog" / "gelf" (后两者仅 network_sink)
 
-  // [Rotating Sink 参数]
+  // [Rotating / coalescing / mmap_binary Sink 参数]
   size_t max_size = 1024 * 1024 * 5;  // 默认 5MB
   size_t max_files = 3;               // 默认 3 个备份
 
+  // [Coalescing Sink 参数] 每个写缓冲的大小 (双缓冲，共两块)
+  size_t buffer_kb = 1024;
+
+  // [Rotating Sink 压缩参数] compression 为空或 "none" 时使用 spdlog 原生 rotating sink
+  std::string compression;
+  Lz4CompressionOptions compression_options;
+
+  // [Network Sink 参数]
+  NetworkSinkOptions network;
+  std::string app_name = "z3y";  // syslog 的 APP-NAME
+  int syslog_facility = 16;      // syslog facility (默认 local0)
+
   spdlog::level::level_enum level;                          // Sink 级过滤门槛
+  std::string thread_pool;  // 专属线程池名 (空 = 在 Logger 所在线程池上直接写入)
   std::shared_ptr<spdlog::sinks::sink> instance = nullptr;  // 懒加载缓存实例
 };
 
+/**
+ * @brief [配置结构] Rule 的投递方式 (配置项 delivery)。
+ */
+enum class LogDelivery {
+  Async,     // "async"：全部入队，由线程池写入 Sink (默认)
+  Sync,      // "sync"：全部在调用线程直接写入 Sink
+  Priority,  // "priority"：不低于 priority_level 的日志绕过队列直接写入，其余入队
+};
+
+/**
+ * @brief [配置结构] 异步 Logger 的入队后端 (global_settings.async_backend)。
+ */
+enum class LogAsyncBackend {
+  Spdlog,       // "spdlog"：spdlog 线程池的 mpmc 阻塞队列 (默认)
+  ThreadRings,  // "thread_rings"：每个提交线程一个无锁单生产者环，由延迟格式化后台线程按时间归并写入
+};
+
 /**
  * @struct RuleConfig
  * @brief [配置结构] 描述路由规则。
@@ -104,17 +182,10 @@ struct SinkConfig {
 struct RuleConfig {
   std::string matcher;                  // 前缀匹配串
   std::vector<std::string> sink_names;  // 目标 Sinks
-};
-
-/**
- * @struct LevelOverride
- * @brief [运行时状态] 动态等级覆写规则。
- * @details 用于记录通过 SetLevel 接口设置的动态规则，以便应用到未来创建的
- * Logger 上。
- */
-struct LevelOverride {
-  std::string prefix;
-  spdlog::level::level_enum level;
+  std::string thread_pool;  // 匹配的 Logger 使用的线程池名 (空 = 全局线程池)
+  LogRateLimit rate_limit;  // 匹配的 Logger 的限流参数 (默认不限流)
+  LogDelivery delivery = LogDelivery::Async;
+  spdlog::level::level_enum priority_level = spdlog::level::err;  // Priority 的绕过门槛
 };
 
 /**
@@ -123,10 +194,24 @@ struct LevelOverride {
  *
  * @section Maintainer 维护者指南
  * [并发模型]
- * - `provider_lock_` (shared_mutex): 保护 `logger_cache_` 和
- * `level_overrides_`。
- * - GetLogger 采用 "读写分离"
- * 策略：绝大多数命中缓存的调用只需获取读锁，性能极高。
+ * - `provider_lock_` (shared_mutex): 保护 `logger_cache_` 和 `logger_tree_`。
+ * - GetLogger 命中缓存时不加锁：名字哈希一次后在 `logger_table_` (开放寻址表)
+ * 中无锁探测；未命中才取写锁创建，创建后同时写入 `logger_cache_` 与 `logger_table_`。
+ * - `logger_tree_` 是 Logger 名字的前缀树：Rule、SetLevel / SetRateLimit 的覆写与已创建的
+ * Logger 都挂在节点上。创建 Logger 时沿名字继承 Rule 与覆写；覆写只遍历前缀的子树，
+ * 代价与 Logger 总数、历史覆写条数无关。
+ *
+ * [线程池]
+ * - 全局线程池 (async_thread_count 个线程) 服务所有未单独绑定的 Logger。
+ * - async_backend 为 "thread_rings" 时，这些 Logger 的 Log() 改走延迟格式化后台的
+ * 线程私有环：提交线程之间不再争用 spdlog 队列的互斥量，吞吐随提交线程数增长。
+ * - Rule 的 thread_pool 决定匹配 Logger 的入队线程池；Sink 的 thread_pool 用
+ * spdlog_pooled_sink 把设备写入再转交一次，每个设备各自串行，慢控制台不再拖住文件。
+ *
+ * [有效级别]
+ * - spdlog::logger 的级别不再固定为 trace，而是 "没有任何 Sink 会接收的级别
+ * 一律拒绝"：未开启的级别在 IsEnabled 处即被拦截，fmt::format、字符串分配和
+ * 异步入队都不会发生。创建 Logger、SetLevel、增减观察者时重新计算。
  *
  * [生命周期]
  * - **析构安全**: `Shutdown()` 仅刷新缓冲区，不关闭 spdlog。真正的 cleanup
@@ -155,22 +240,39 @@ class SpdlogProviderService
   void AddLogObserver(const std::string& observer_name,
                       LogObserverCallback callback) override;
   void RemoveLogObserver(const std::string& observer_name) override;
+  void AddLogBatchObserver(const std::string& observer_name,
+                           LogBatchObserverCallback callback,
+                           const LogBatchOptions& options) override;
+  void SetRateLimit(const std::string& name_prefix,
+                    const LogRateLimit& limit) override;
+  LogQueueStats GetQueueStats() override;
 
  private:
   PluginPtr<ILogger> GetFallbackLogger(const std::string& name);
   spdlog::level::level_enum ParseLogLevel(
       const std::string& level_str, spdlog::level::level_enum default_level);
 
+  // [内部] 按名字取线程池，未定义时抛出异常 (必须在 provider_lock_ 的写锁保护下调用)
+  std::shared_ptr<spdlog::details::thread_pool> FindThreadPool_UNLOCKED(
+      const std::string& pool_name);
+
   // [内部] 获取 Sink (必须在 provider_lock_ 的写锁保护下调用)
   std::shared_ptr<spdlog::sinks::sink> GetOrCreateSink_UNLOCKED(
       const std::string& sink_name);
 
-  // [内部] 检查是否有动态覆写规则适用于该 logger (无锁辅助函数)
-  void ApplyLevelOverrides_UNLOCKED(const std::string& name,
-                                    std::shared_ptr<spdlog::logger> logger);
+  // [内部] 重新计算并写入该 logger 的有效级别 (调用方持有 provider_lock_ 写锁)
+  // 有效级别 = max(覆写级别, 所有 Sink 级别的最小值)；没有观察者时 Observer Sink
+  // 的级别为 off，不参与取最小值。结果写回 spdlog::logger，IsEnabled 只需一次 relaxed load。
+  // requested 为 logger_tree_ 上继承到的覆写级别。
+  void ApplyEffectiveLevel_UNLOCKED(spdlog::level::level_enum requested,
+                                    spdlog::logger& logger);
+  // [内部] 对所有已缓存的 logger 重新计算有效级别 (观察者增减时调用)
+  void ApplyEffectiveLevelToAll();
 
   std::mutex init_mutex_;            // 保护初始化过程
-  std::shared_mutex provider_lock_;  // 读写锁，保护缓存和状态
+  // 读写锁，保护缓存和状态
+  z3y::ProfiledMutex<std::shared_mutex> provider_lock_{
+      "SpdlogProviderService.provider_lock_"};
 
   bool is_initialized_ = false;
 
@@ -180,27 +282,51 @@ class SpdlogProviderService
 
   // 异步策略配置
   size_t async_queue_size_ = 8192;
+  size_t async_thread_count_ = 1;  // 全局线程池的后台线程数
   spdlog::async_overflow_policy async_policy_ =
       spdlog::async_overflow_policy::block;
+  // 未绑定具名线程池的异步 Logger 的入队后端
+  LogAsyncBackend async_backend_ = LogAsyncBackend::Spdlog;
 
   // 自动 Flush 配置
   spdlog::level::level_enum flush_level_ = spdlog::level::err;
   size_t flush_interval_sec_ = 5;
 
+  // 崩溃环 (global_settings.crash_ring)：挂在所有 Logger 上，开启后 flush_on_level 默认为 off
+  std::shared_ptr<crash_ring_sink> crash_ring_;
+
+  // 延迟格式化 (LogDeferred) 的线程环大小与后台线程
+  size_t deferred_ring_kb_ = 256;
+  std::shared_ptr<DeferredLogBackend> deferred_;
+
+  // 具名线程池 (配置项 thread_pools)，供 Rule / Sink 按名字绑定
+  std::map<std::string, std::shared_ptr<spdlog::details::thread_pool>>
+      thread_pools_;
+  // 具名线程池的队列容量 (spdlog 不对外暴露容量，只能记下配置值)
+  std::map<std::string, size_t> thread_pool_capacity_;
+
   std::map<std::string, SinkConfig> sinks_config_;
   std::vector<RuleConfig> rules_;
   RuleConfig default_rule_;
 
-  // 运行时动态调整的等级记录表
-  std::list<LevelOverride> level_overrides_;
+  // Logger 名字树：rules_ 的 matcher (值为 rules_ 下标)、运行时的级别 / 限流覆写、
+  // 已创建的 Logger (指向 logger_cache_ 中的对象)
+  LoggerTree<LoggerImpl> logger_tree_;
 
   // Logger 缓存 (Key: Logger Name)
   std::map<std::string, std::shared_ptr<LoggerImpl>> logger_cache_;
+  // 同一批 Logger 的无锁查找表 (GetLogger 快路径)
+  LoggerNameTable<LoggerImpl> logger_table_;
 
   // 备用 Logger (初始化失败时使用)
   PluginPtr<ILogger> fallback_logger_;
 
+  // 已创建的网络 Sink (发送队列并入 GetQueueStats)
+  std::vector<std::shared_ptr<network_log_sink>> network_sinks_;
+
   std::shared_ptr<spdlog_observer_sink_mt> observer_sink_;
+  // 批量观察者：在 observer_sink_ 上登记逐条 Feed，由投递线程攒批回调
+  LogBatchDispatcher batch_dispatcher_;
 };
 
 }  // namespace log
@@ -0,0 +1,95 @@
+﻿/*
+ * Copyright [2025] [Yue Liu]
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file structured_log_context.h
+ * @brief [内部] 写 Sink 期间公布当前结构化日志的原始字段。
+ *
+ * @details
+ * spdlog::details::log_msg 只能携带文本正文。结构化日志由本插件直接写入各个 Sink
+ * (后台线程或同步路径)，写入期间在线程局部变量里公布模板与字段，
+ * 认识它的 Sink (Observer / JSON 格式 / mmap_binary_sink) 在 log() 内读取。
+ * 绑定了专属线程池 (thread_pool) 的 Sink 在另一个线程上写入，只能得到渲染后的文本。
+ */
+
+#pragma once
+
+#ifndef Z3Y_PLUGIN_SPDLOG_STRUCTURED_LOG_CONTEXT_H_
+#define Z3Y_PLUGIN_SPDLOG_STRUCTURED_LOG_CONTEXT_H_
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "interfaces_core/i_log_service.h"
+#include "mmap_binary_format.h"
+
+namespace z3y {
+namespace plugins {
+namespace log {
+
+/** @brief 正在写入的结构化日志。String 字段的 str 是实际指针。 */
+struct StructuredLogContext {
+  const char* message_template;
+  const z3y::interfaces::core::LogField* fields;
+  uint32_t field_count;
+};
+
+namespace detail {
+inline thread_local const StructuredLogContext* tls_structured_log = nullptr;
+}  // namespace detail
+
+/** @brief 当前线程正在写入的结构化日志；普通日志返回 nullptr。 */
+inline const StructuredLogContext* CurrentStructuredLog() noexcept {
+  return detail::tls_structured_log;
+}
+
+/** @brief 在作用域内公布一条结构化日志。 */
+class StructuredLogScope {
+ public:
+  explicit StructuredLogScope(const StructuredLogContext& context) noexcept
+      : previous_(detail::tls_structured_log) {
+    detail::tls_structured_log = &context;
+  }
+  ~StructuredLogScope() { detail::tls_structured_log = previous_; }
+
+  StructuredLogScope(const StructuredLogScope&) = delete;
+  StructuredLogScope& operator=(const StructuredLogScope&) = delete;
+
+ private:
+  const StructuredLogContext* previous_;
+};
+
+/** @brief 按二进制段格式的字段区编码字段 (mmap_binary_sink 与崩溃环共用)。 */
+inline void AppendBinaryFields(const StructuredLogContext& context, std::string& out) {
+  using z3y::interfaces::core::LogArgType;
+  for (uint32_t i = 0; i < context.field_count; ++i) {
+    const auto& field = context.fields[i];
+    const auto type = static_cast<binlog::FieldType>(field.value.type);
+    if (field.value.type == LogArgType::String) {
+      binlog::AppendField(out, field.key, type, 0,
+                          std::string_view(field.value.str, field.value.size));
+    } else {
+      binlog::AppendField(out, field.key, type, field.value.u64);
+    }
+  }
+}
+
+}  // namespace log
+}  // namespace plugins
+}  // namespace z3y
+
+#endif  // Z3Y_PLUGIN_SPDLOG_STRUCTURED_LOG_CONTEXT_H_
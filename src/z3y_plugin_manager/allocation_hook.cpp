@@ -0,0 +1,69 @@
+﻿/*
+* Copyright [2025] [Yue Liu]
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/**
+ * @file allocation_hook.cpp
+ * @brief [内部] 全局堆分配钩子的安装与分发。
+ * @details 所有状态都是常量初始化的 POD / 原子量：替换后的 `operator new` 在静态初始化
+ * 期间 (早于本库的任何动态初始化) 就会调用 `ReportAllocation`。
+ */
+
+#include "framework/allocation_hook.h"
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+namespace z3y {
+
+    namespace {
+        /** @brief 已安装的钩子。整体替换，读者拿到的指针在 calls 归零前不会被释放。 */
+        struct HookSlot {
+            AllocationHook hook;
+            void* context;
+        };
+
+        std::atomic<const HookSlot*> g_allocation_hook{ nullptr };
+        std::atomic<uint32_t> g_allocation_hook_calls{ 0 };  //!< 进行中的钩子调用数
+        thread_local bool tls_in_allocation_hook = false;  //!< 钩子内部的分配不递归上报
+    }  // namespace
+
+    void SetAllocationHook(AllocationHook hook, void* context) {
+        static std::mutex install_mutex;  // 串行化安装：否则两个安装者可能释放同一个旧钩子
+        std::lock_guard<std::mutex> lock(install_mutex);
+        const HookSlot* next = hook ? new HookSlot{ hook, context } : nullptr;
+        const HookSlot* old = g_allocation_hook.exchange(next, std::memory_order_seq_cst);
+        while (g_allocation_hook_calls.load(std::memory_order_seq_cst) != 0) std::this_thread::yield();
+        delete old;
+    }
+
+    bool IsAllocationHookInstalled() noexcept {
+        return g_allocation_hook.load(std::memory_order_relaxed) != nullptr;
+    }
+
+    void ReportAllocation(size_t bytes) noexcept {
+        if (g_allocation_hook.load(std::memory_order_relaxed) == nullptr || tls_in_allocation_hook) return;
+        g_allocation_hook_calls.fetch_add(1, std::memory_order_seq_cst);
+        if (const HookSlot* slot = g_allocation_hook.load(std::memory_order_seq_cst)) {
+            tls_in_allocation_hook = true;
+            slot->hook(bytes, slot->context);
+            tls_in_allocation_hook = false;
+        }
+        g_allocation_hook_calls.fetch_sub(1, std::memory_order_seq_cst);
+    }
+
+}  // namespace z3y
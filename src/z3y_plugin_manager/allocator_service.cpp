@@ -0,0 +1,311 @@
+﻿/*
+* Copyright [2025] [Yue Liu]
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/**
+ * @file allocator_service.cpp
+ * @brief [内部] 框架分配服务的实现，以及 `PluginManager` 中关于 `IAllocatorService` 的部分。
+ */
+
+#include "allocator_service.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "plugin_manager_pimpl.h"
+
+namespace z3y {
+
+    namespace {
+        constexpr size_t kArenaBlockAlign = 64;
+
+        /** @brief 进程内唯一的编号 (服务与 arena 共用)，0 保留为无效值。 */
+        uint64_t NextAllocatorId() {
+            static std::atomic<uint64_t> next{ 1 };
+            return next.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        /** @brief 只做计数的上游：分级内存池向系统申请的字节数。 */
+        class CountingUpstream final : public std::pmr::memory_resource {
+        public:
+            size_t Bytes() const { return bytes_.load(std::memory_order_relaxed); }
+
+        private:
+            void* do_allocate(size_t bytes, size_t align) override {
+                void* p = std::pmr::new_delete_resource()->allocate(bytes, align);
+                bytes_.fetch_add(bytes, std::memory_order_relaxed);
+                return p;
+            }
+            void do_deallocate(void* p, size_t bytes, size_t align) override {
+                bytes_.fetch_sub(bytes, std::memory_order_relaxed);
+                std::pmr::new_delete_resource()->deallocate(p, bytes, align);
+            }
+            bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+            std::atomic<size_t> bytes_{ 0 };
+        };
+
+        /**
+         * @class MonotonicArena
+         * @brief 单线程的单调 arena：分配只移动指针，释放是空操作，整体按标记回退。
+         * @details 统计字段只由所属线程写入 (load + store，不做原子读改写)，其他线程只读。
+         */
+        class MonotonicArena final : public std::pmr::memory_resource {
+        public:
+            explicit MonotonicArena(uint64_t id) : id_(id) {}
+            ~MonotonicArena() override {
+                for (const Block& block : blocks_) ::operator delete(block.data, std::align_val_t(kArenaBlockAlign));
+            }
+            MonotonicArena(const MonotonicArena&) = delete;
+            MonotonicArena& operator=(const MonotonicArena&) = delete;
+
+            ArenaMark Mark() const { return { id_, current_, offset_, used_.load(std::memory_order_relaxed) }; }
+
+            void Rewind(const ArenaMark& mark) {
+                if (mark.arena == 0) {
+                    current_ = 0;
+                    offset_ = 0;
+                    used_.store(0, std::memory_order_relaxed);
+                } else {
+                    // 标记必须属于本 arena，且不在当前位置之后 (重复回退同一个标记是无害的)
+                    if (mark.arena != id_) return;
+                    if (mark.block > current_ || (mark.block == current_ && mark.offset > offset_)) return;
+                    current_ = mark.block;
+                    offset_ = mark.offset;
+                    used_.store(mark.used, std::memory_order_relaxed);
+                }
+                rewinds_.store(rewinds_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            }
+
+            size_t Used() const { return used_.load(std::memory_order_relaxed); }
+            size_t Reserved() const { return reserved_.load(std::memory_order_relaxed); }
+            size_t Peak() const { return peak_.load(std::memory_order_relaxed); }
+            uint64_t Rewinds() const { return rewinds_.load(std::memory_order_relaxed); }
+
+        private:
+            struct Block {
+                std::byte* data;
+                size_t size;
+            };
+
+            void* do_allocate(size_t bytes, size_t align) override {
+                for (;;) {
+                    if (current_ < blocks_.size()) {
+                        const Block& block = blocks_[current_];
+                        const auto base = reinterpret_cast<std::uintptr_t>(block.data);
+                        const size_t start = ((base + offset_ + align - 1) & ~(std::uintptr_t(align) - 1)) - base;
+                        if (start + bytes <= block.size) {
+                            Consume(start + bytes - offset_);
+                            offset_ = start + bytes;
+                            return block.data + start;
+                        }
+                    }
+                    // 当前块放不下：下一个已有的块够大就沿用，否则在它前面插入一个新块
+                    const size_t next = blocks_.empty() ? 0 : current_ + 1;
+                    if (next >= blocks_.size() || blocks_[next].size < bytes + align) {
+                        size_t size = std::max(next_block_size_, bytes + align);
+                        size = (size + kArenaBlockAlign - 1) & ~(kArenaBlockAlign - 1);
+                        auto* data = static_cast<std::byte*>(::operator new(size, std::align_val_t(kArenaBlockAlign)));
+                        blocks_.insert(blocks_.begin() + static_cast<std::ptrdiff_t>(next), Block{ data, size });
+                        reserved_.store(reserved_.load(std::memory_order_relaxed) + size, std::memory_order_relaxed);
+                        next_block_size_ = std::min(next_block_size_ * 2, AllocatorService::kMaxArenaBlock);
+                    }
+                    current_ = next;
+                    offset_ = 0;
+                }
+            }
+            void do_deallocate(void*, size_t, size_t) override {}
+            bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+            void Consume(size_t bytes) {
+                const size_t used = used_.load(std::memory_order_relaxed) + bytes;
+                used_.store(used, std::memory_order_relaxed);
+                if (used > peak_.load(std::memory_order_relaxed)) peak_.store(used, std::memory_order_relaxed);
+            }
+
+            const uint64_t id_;
+            std::vector<Block> blocks_;
+            size_t current_ = 0;  //!< 正在使用的块；标记只引用它及之前的块，新块总是插在它之后
+            size_t offset_ = 0;
+            size_t next_block_size_ = AllocatorService::kFirstArenaBlock;
+            std::atomic<size_t> used_{ 0 };
+            std::atomic<size_t> reserved_{ 0 };
+            std::atomic<size_t> peak_{ 0 };
+            std::atomic<uint64_t> rewinds_{ 0 };
+        };
+    }  // namespace
+
+    struct AllocatorService::Core {
+        /**
+         * @brief 分级内存池前面的计数视图。
+         * @details `extra` 为框架视图的附加计数器；`account` 为插件视图的记账账户。
+         */
+        class TrackedResource final : public std::pmr::memory_resource {
+        public:
+            TrackedResource(Core& core, std::atomic<size_t>* extra, std::shared_ptr<AllocationAccount> account)
+                : core_(core), extra_(extra), account_(std::move(account)) {}
+
+        private:
+            void* do_allocate(size_t bytes, size_t align) override {
+                void* p = core_.pool.allocate(bytes, align);
+                core_.pool_bytes.fetch_add(bytes, std::memory_order_relaxed);
+                core_.pool_allocations.fetch_add(1, std::memory_order_relaxed);
+                if (extra_) extra_->fetch_add(bytes, std::memory_order_relaxed);
+                if (account_) {
+                    account_->pool_bytes.fetch_add(static_cast<int64_t>(bytes), std::memory_order_relaxed);
+                    account_->pool_allocations.fetch_add(1, std::memory_order_relaxed);
+                }
+                return p;
+            }
+            void do_deallocate(void* p, size_t bytes, size_t align) override {
+                if (account_) account_->pool_bytes.fetch_sub(static_cast<int64_t>(bytes), std::memory_order_relaxed);
+                if (extra_) extra_->fetch_sub(bytes, std::memory_order_relaxed);
+                core_.pool_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+                core_.pool.deallocate(p, bytes, align);
+            }
+            bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+            Core& core_;
+            std::atomic<size_t>* const extra_;
+            const std::shared_ptr<AllocationAccount> account_;
+        };
+
+        const uint64_t id = NextAllocatorId();
+        CountingUpstream upstream;  // 必须先于 pool 构造、后于 pool 析构
+        std::pmr::synchronized_pool_resource pool{ std::pmr::pool_options{ 0, kLargestPoolBlock }, &upstream };
+        std::atomic<size_t> pool_bytes{ 0 };
+        std::atomic<uint64_t> pool_allocations{ 0 };
+        std::atomic<size_t> framework_bytes{ 0 };
+        TrackedResource shared_view{ *this, nullptr, nullptr };
+        TrackedResource framework_view{ *this, &framework_bytes, nullptr };
+
+        mutable std::mutex mutex;  //!< 保护以下成员
+        std::vector<const MonotonicArena*> arenas;  //!< 存活线程的 arena (由线程持有)
+        std::unordered_map<const AllocationAccount*, std::unique_ptr<TrackedResource>> plugin_views;
+        uint64_t retired_rewinds = 0;  //!< 已退出线程的回收次数
+        size_t retired_peak = 0;       //!< 已退出线程的最大使用量
+
+        void Register(const MonotonicArena* arena) {
+            std::lock_guard lock(mutex);
+            arenas.push_back(arena);
+        }
+
+        void Unregister(const MonotonicArena* arena) {
+            std::lock_guard lock(mutex);
+            arenas.erase(std::remove(arenas.begin(), arenas.end(), arena), arenas.end());
+            retired_rewinds += arena->Rewinds();
+            retired_peak = std::max(retired_peak, arena->Peak());
+        }
+    };
+
+    namespace {
+        /** @brief 调用线程的 arena。线程同一时间只为一个服务 (即当前的 PluginManager) 持有 arena。 */
+        struct ThreadArenaSlot {
+            uint64_t core_id = 0;
+            std::weak_ptr<AllocatorService::Core> core;
+            std::unique_ptr<MonotonicArena> arena;
+
+            ~ThreadArenaSlot() { Release(); }
+
+            void Release() {
+                if (!arena) return;
+                if (auto owner = core.lock()) owner->Unregister(arena.get());
+                arena.reset();
+                core.reset();
+                core_id = 0;
+            }
+        };
+
+        thread_local ThreadArenaSlot t_arena_slot;
+
+        MonotonicArena& LocalArena(const std::shared_ptr<AllocatorService::Core>& core) {
+            ThreadArenaSlot& slot = t_arena_slot;
+            if (slot.core_id == core->id) return *slot.arena;
+            slot.Release();
+            slot.arena = std::make_unique<MonotonicArena>(NextAllocatorId());
+            slot.core = core;
+            slot.core_id = core->id;
+            core->Register(slot.arena.get());
+            return *slot.arena;
+        }
+    }  // namespace
+
+    AllocatorService::AllocatorService() : core_(std::make_shared<Core>()) {}
+
+    AllocatorService::~AllocatorService() = default;
+
+    std::pmr::memory_resource* AllocatorService::Arena() { return &LocalArena(core_); }
+
+    ArenaMark AllocatorService::Mark() { return LocalArena(core_).Mark(); }
+
+    void AllocatorService::Rewind(const ArenaMark& mark) { LocalArena(core_).Rewind(mark); }
+
+    std::pmr::memory_resource* AllocatorService::PoolResource(const std::shared_ptr<AllocationAccount>& account) {
+        if (!account) return &core_->shared_view;
+        std::lock_guard lock(core_->mutex);
+        auto& view = core_->plugin_views[account.get()];
+        if (!view) view = std::make_unique<Core::TrackedResource>(*core_, nullptr, account);
+        return view.get();
+    }
+
+    std::pmr::memory_resource* AllocatorService::FrameworkResource() { return &core_->framework_view; }
+
+    AllocatorStats AllocatorService::Stats() const {
+        AllocatorStats stats;
+        {
+            std::lock_guard lock(core_->mutex);
+            stats.arena_threads = core_->arenas.size();
+            stats.arena_rewinds = core_->retired_rewinds;
+            stats.arena_peak_bytes = core_->retired_peak;
+            for (const MonotonicArena* arena : core_->arenas) {
+                stats.arena_reserved_bytes += arena->Reserved();
+                stats.arena_used_bytes += arena->Used();
+                stats.arena_peak_bytes = std::max(stats.arena_peak_bytes, arena->Peak());
+                stats.arena_rewinds += arena->Rewinds();
+            }
+        }
+        stats.pool_bytes = core_->pool_bytes.load(std::memory_order_relaxed);
+        stats.pool_allocations = core_->pool_allocations.load(std::memory_order_relaxed);
+        stats.pool_upstream_bytes = core_->upstream.Bytes();
+        stats.framework_bytes = core_->framework_bytes.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    // --- PluginManager: IAllocatorService 接口实现 (转发给 Pimpl 持有的 AllocatorService) ---
+
+    std::pmr::memory_resource* PluginManager::GetThreadArena() {
+        return pimpl_->allocator_->Arena();
+    }
+
+    ArenaMark PluginManager::MarkThreadArena() {
+        return pimpl_->allocator_->Mark();
+    }
+
+    void PluginManager::RewindThreadArena(const ArenaMark& mark) {
+        pimpl_->allocator_->Rewind(mark);
+    }
+
+    std::pmr::memory_resource* PluginManager::GetPoolResource() {
+        return pimpl_->allocator_->PoolResource(internal::CurrentAllocationAccount());
+    }
+
+    AllocatorStats PluginManager::GetAllocatorStats() const {
+        return pimpl_->allocator_->Stats();
+    }
+
+}  // namespace z3y
@@ -0,0 +1,214 @@
+﻿/*
+* Copyright [2025] [Yue Liu]
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/**
+ * @file allocator_service.h
+ * @brief [内部] `IAllocatorService` 的实现，以及框架热点容器使用的分配器适配：
+ * `ResourceAllocator` (按 memory_resource 分配的 STL 分配器) 与 `PooledTask` (只移动的任务闭包)。
+ *
+ * @details
+ * [受众：框架维护者]
+ *
+ * - 线程帧内存：每个线程一个 `MonotonicArena` (由线程自己持有，线程退出时释放)。内存块从 64 KB 起
+ * 成倍增长 (上限 4 MB)，回退后保留复用。快路径只比较一次 arena 所属服务的编号，不加锁。
+ * - 分级内存池：一个 `std::pmr::synchronized_pool_resource`，≤ 64 KB 的请求按大小分级缓存，
+ * 更大的直接向系统申请。其前面是若干只做计数的视图：共享视图、框架视图、每个插件一个记账视图。
+ *
+ * [生命周期]
+ * 真正的状态在 `Core` 里，由服务对象持有；线程只保存它的弱引用。服务先于线程销毁时，
+ * 线程的 arena 在线程退出 (或首次访问新服务) 时释放；分级内存池随服务一起释放。
+ */
+
+#pragma once
+
+#ifndef Z3Y_SRC_PLUGIN_MANAGER_ALLOCATOR_SERVICE_H_
+#define Z3Y_SRC_PLUGIN_MANAGER_ALLOCATOR_SERVICE_H_
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include "framework/allocation_account.h"
+#include "framework/i_allocator_service.h"
+
+namespace z3y {
+
+    class AllocatorService {
+    public:
+        static constexpr size_t kLargestPoolBlock = size_t(64) << 10;  //!< 分级缓存的最大请求
+        static constexpr size_t kFirstArenaBlock = size_t(64) << 10;   //!< 线程帧内存的首个块
+        static constexpr size_t kMaxArenaBlock = size_t(4) << 20;      //!< 线程帧内存块的增长上限
+
+        AllocatorService();
+        ~AllocatorService();
+        AllocatorService(const AllocatorService&) = delete;
+        AllocatorService& operator=(const AllocatorService&) = delete;
+
+        std::pmr::memory_resource* Arena();
+        ArenaMark Mark();
+        void Rewind(const ArenaMark& mark);
+
+        /** @brief 记到 `account` 名下的分级内存池视图；`account` 为空时返回共享视图。 */
+        std::pmr::memory_resource* PoolResource(const std::shared_ptr<AllocationAccount>& account);
+
+        /** @brief 框架热点容器使用的分级内存池视图 (计入 `AllocatorStats::framework_bytes`)。 */
+        std::pmr::memory_resource* FrameworkResource();
+
+        AllocatorStats Stats() const;
+
+        struct Core;
+
+    private:
+        std::shared_ptr<Core> core_;
+    };
+
+    /**
+     * @class ResourceAllocator
+     * @brief 从指定 `memory_resource` 分配的 STL 分配器。
+     * @details 与 `std::pmr::polymorphic_allocator` 的区别：容器拷贝时沿用原容器的资源
+     * (后者会退回默认资源)。订阅列表写时复制 (`SubList(*current)`)，副本必须仍在同一个池里。
+     * 默认构造时使用 `new_delete_resource`。
+     */
+    template <typename T>
+    class ResourceAllocator {
+    public:
+        using value_type = T;
+        using propagate_on_container_copy_assignment = std::true_type;
+        using propagate_on_container_move_assignment = std::true_type;
+        using propagate_on_container_swap = std::true_type;
+
+        ResourceAllocator() noexcept : resource_(std::pmr::new_delete_resource()) {}
+        explicit ResourceAllocator(std::pmr::memory_resource* resource) noexcept : resource_(resource) {}
+        template <typename U>
+        ResourceAllocator(const ResourceAllocator<U>& other) noexcept : resource_(other.resource()) {}
+
+        T* allocate(size_t n) { return static_cast<T*>(resource_->allocate(n * sizeof(T), alignof(T))); }
+        void deallocate(T* p, size_t n) noexcept { resource_->deallocate(p, n * sizeof(T), alignof(T)); }
+
+        [[nodiscard]] std::pmr::memory_resource* resource() const noexcept { return resource_; }
+
+        template <typename U>
+        bool operator==(const ResourceAllocator<U>& other) const noexcept { return resource_ == other.resource(); }
+        template <typename U>
+        bool operator!=(const ResourceAllocator<U>& other) const noexcept { return resource_ != other.resource(); }
+
+    private:
+        std::pmr::memory_resource* resource_;
+    };
+
+    /**
+     * @class PooledTask
+     * @brief 只移动的 `void()` 闭包，代替异步派发任务里的 `std::function`。
+     * @details 不超过三个指针大小、且可无异常移动的闭包直接存放在对象内；更大的闭包从给定的
+     * `memory_resource` 分配 (默认 `new_delete_resource`)。`std::function` 在 C++17 中无法指定分配器，
+     * 而派发闭包 (快照 + 事件 + 下标) 总是超出它的内联区。
+     */
+    class PooledTask {
+    public:
+        PooledTask() noexcept = default;
+        PooledTask(std::nullptr_t) noexcept {}
+
+        template <typename F, typename Fn = std::decay_t<F>,
+            typename = std::enable_if_t<!std::is_same_v<Fn, PooledTask> && std::is_invocable_v<Fn&>>>
+        PooledTask(F&& f, std::pmr::memory_resource* resource = nullptr) {
+            if constexpr (kFitsInline<Fn>) {
+                ::new (static_cast<void*>(storage_)) Fn(std::forward<F>(f));
+                ops_ = &kInlineOps<Fn>;
+            } else {
+                resource_ = resource ? resource : std::pmr::new_delete_resource();
+                void* p = resource_->allocate(sizeof(Fn), alignof(Fn));
+                try {
+                    ::new (p) Fn(std::forward<F>(f));
+                } catch (...) {
+                    resource_->deallocate(p, sizeof(Fn), alignof(Fn));
+                    throw;
+                }
+                *reinterpret_cast<Fn**>(storage_) = static_cast<Fn*>(p);
+                ops_ = &kHeapOps<Fn>;
+            }
+        }
+
+        PooledTask(PooledTask&& other) noexcept { MoveFrom(other); }
+        PooledTask& operator=(PooledTask&& other) noexcept {
+            if (this != &other) {
+                Reset();
+                MoveFrom(other);
+            }
+            return *this;
+        }
+        PooledTask& operator=(std::nullptr_t) noexcept {
+            Reset();
+            return *this;
+        }
+        PooledTask(const PooledTask&) = delete;
+        PooledTask& operator=(const PooledTask&) = delete;
+        ~PooledTask() { Reset(); }
+
+        void operator()() { ops_->invoke(storage_); }
+        explicit operator bool() const noexcept { return ops_ != nullptr; }
+
+    private:
+        static constexpr size_t kInlineSize = 3 * sizeof(void*);
+
+        struct Ops {
+            void (*invoke)(void* storage);
+            void (*move)(void* dst, void* src) noexcept;
+            void (*destroy)(void* storage, std::pmr::memory_resource* resource) noexcept;
+        };
+
+        template <typename Fn>
+        static constexpr bool kFitsInline = sizeof(Fn) <= kInlineSize && alignof(Fn) <= alignof(void*) &&
+            std::is_nothrow_move_constructible_v<Fn>;
+
+        template <typename Fn>
+        static constexpr Ops kInlineOps{
+            [](void* s) { (*static_cast<Fn*>(s))(); },
+            [](void* d, void* s) noexcept {
+                ::new (d) Fn(std::move(*static_cast<Fn*>(s)));
+                static_cast<Fn*>(s)->~Fn();
+            },
+            [](void* s, std::pmr::memory_resource*) noexcept { static_cast<Fn*>(s)->~Fn(); } };
+
+        template <typename Fn>
+        static constexpr Ops kHeapOps{
+            [](void* s) { (**static_cast<Fn**>(s))(); },
+            [](void* d, void* s) noexcept { *static_cast<Fn**>(d) = *static_cast<Fn**>(s); },
+            [](void* s, std::pmr::memory_resource* r) noexcept {
+                Fn* f = *static_cast<Fn**>(s);
+                f->~Fn();
+                r->deallocate(f, sizeof(Fn), alignof(Fn));
+            } };
+
+        void MoveFrom(PooledTask& other) noexcept {
+            ops_ = std::exchange(other.ops_, nullptr);
+            resource_ = other.resource_;
+            if (ops_) ops_->move(storage_, other.storage_);
+        }
+
+        void Reset() noexcept {
+            if (const Ops* ops = std::exchange(ops_, nullptr)) ops->destroy(storage_, resource_);
+        }
+
+        const Ops* ops_ = nullptr;
+        std::pmr::memory_resource* resource_ = nullptr;
+        alignas(void*) unsigned char storage_[kInlineSize];
+    };
+
+}  // namespace z3y
+
+#endif  // Z3Y_SRC_PLUGIN_MANAGER_ALLOCATOR_SERVICE_H_
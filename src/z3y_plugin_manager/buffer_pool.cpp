@@ -0,0 +1,256 @@
+﻿/*
+* Copyright [2025] [Yue Liu]
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/**
+ * @file buffer_pool.cpp
+ * @brief [内部] 框架缓冲区池的实现，以及 `PluginManager` 中关于 `IBufferPool` 的部分。
+ */
+
+#include "buffer_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+#include "framework/thread_placement.h"
+#include "plugin_manager_pimpl.h"
+
+namespace z3y {
+
+    namespace {
+        constexpr uint16_t kUncachedClass = static_cast<uint16_t>(BufferPool::kClassCount);
+        constexpr uint16_t kFlagLargePages = 1u << 0;
+        constexpr unsigned kNodeShift = 8;      //!< flags 的高 8 位：缓冲区所属的 NUMA 节点分片
+        constexpr size_t kMaxNodeShards = 16;
+        constexpr size_t kCacheLine = 64;
+
+        size_t ClassCapacity(size_t size_class) { return size_t(1) << (BufferPool::kMinClassShift + size_class); }
+
+        /** @brief 能容纳 `size` 的最小级别；超出最大级别时返回 kUncachedClass。 */
+        uint16_t ClassFor(size_t size) {
+            for (size_t c = 0; c < BufferPool::kClassCount; ++c) {
+                if (size <= ClassCapacity(c)) return static_cast<uint16_t>(c);
+            }
+            return kUncachedClass;
+        }
+
+        size_t AlignmentFor(size_t capacity) {
+            static const size_t page = PlatformPageSize();
+            return capacity < page ? kCacheLine : page;
+        }
+    }  // namespace
+
+    class BufferPool::Core {
+    public:
+        Core(size_t max_cached_bytes, bool huge_pages)
+            : max_cached_bytes_(max_cached_bytes), huge_pages_(huge_pages),
+            node_count_(std::clamp<size_t>(GetNumaNodeCount(), 1, kMaxNodeShards)),
+            lists_(new FreeList[node_count_ * kClassCount]) {}
+
+        ~Core() { Trim(); }
+
+        BufferRef Acquire(size_t size) {
+            acquires_.fetch_add(1, std::memory_order_relaxed);
+            const uint16_t size_class = ClassFor(size);
+            const size_t node = node_count_ > 1 ? GetCurrentNumaNode() % node_count_ : 0;
+            BufferHeader* header = nullptr;
+            if (size_class != kUncachedClass) {
+                // 先取本节点的缓存；本节点没有时才借用其他节点的，仍然比重新分配便宜
+                for (size_t i = 0; i < node_count_ && !header; ++i) {
+                    header = TryPop(List((node + i) % node_count_, size_class));
+                }
+            }
+            if (header) {
+                hits_.fetch_add(1, std::memory_order_relaxed);
+                cached_bytes_.fetch_sub(header->capacity, std::memory_order_relaxed);
+            } else {
+                header = Allocate(size_class, size, node);
+            }
+            header->refs.store(1, std::memory_order_relaxed);
+            header->size = size;
+            refs_.fetch_add(1, std::memory_order_relaxed);
+            outstanding_bytes_.fetch_add(header->capacity, std::memory_order_relaxed);
+            return BufferRef(header);
+        }
+
+        void Trim() {
+            for (size_t i = 0; i < node_count_ * kClassCount; ++i) {
+                FreeList& list = lists_[i];
+                std::vector<BufferHeader*> drained;
+                {
+                    std::lock_guard<std::mutex> lock(list.mutex);
+                    drained.swap(list.buffers);
+                    cached_buffers_.fetch_sub(drained.size(), std::memory_order_relaxed);
+                }
+                for (BufferHeader* header : drained) {
+                    cached_bytes_.fetch_sub(header->capacity, std::memory_order_relaxed);
+                    Free(header);
+                }
+            }
+        }
+
+        /** @brief 池对象析构：之后释放的缓冲区不再缓存。 */
+        void Close() {
+            closed_.store(true, std::memory_order_release);
+            Trim();
+            Unref();
+        }
+
+        BufferPoolStats Stats() const {
+            BufferPoolStats stats;
+            stats.cached_buffers = cached_buffers_.load(std::memory_order_relaxed);
+            stats.cached_bytes = cached_bytes_.load(std::memory_order_relaxed);
+            stats.outstanding_buffers = refs_.load(std::memory_order_relaxed) - 1;
+            stats.outstanding_bytes = outstanding_bytes_.load(std::memory_order_relaxed);
+            stats.acquires = acquires_.load(std::memory_order_relaxed);
+            stats.pool_hits = hits_.load(std::memory_order_relaxed);
+            stats.huge_page_buffers = huge_.load(std::memory_order_relaxed);
+            return stats;
+        }
+
+        /** @brief `BufferHeader::release`：最后一个 `BufferRef` 释放时调用，可能在任何线程、任何插件里。 */
+        static void Release(BufferHeader* header) noexcept {
+            Core* core = static_cast<Core*>(header->owner);
+            core->Recycle(header);
+            core->Unref();
+        }
+
+    private:
+        struct FreeList {
+            std::mutex mutex;
+            std::vector<BufferHeader*> buffers;
+        };
+
+        FreeList& List(size_t node, uint16_t size_class) { return lists_[node * kClassCount + size_class]; }
+
+        BufferHeader* TryPop(FreeList& list) {
+            std::lock_guard<std::mutex> lock(list.mutex);
+            if (list.buffers.empty()) return nullptr;
+            BufferHeader* header = list.buffers.back();
+            list.buffers.pop_back();
+            cached_buffers_.fetch_sub(1, std::memory_order_relaxed);
+            return header;
+        }
+
+        /** @param node 分配线程所在的节点分片：数据块由该线程首次写入，归还时回到这个分片。 */
+        BufferHeader* Allocate(uint16_t size_class, size_t size, size_t node) {
+            const size_t capacity = size_class != kUncachedClass
+                ? ClassCapacity(size_class)
+                : (size + PlatformPageSize() - 1) / PlatformPageSize() * PlatformPageSize();
+            auto* header = new BufferHeader();
+            header->size_class = size_class;
+            header->flags = static_cast<uint16_t>(node << kNodeShift);
+            header->release = &Core::Release;
+            header->owner = this;
+            header->capacity = capacity;
+            if (huge_pages_ && capacity >= kLargePageThreshold) {
+                header->data = static_cast<std::byte*>(PlatformAllocateLargePages(capacity));
+                if (header->data) {
+                    header->flags |= kFlagLargePages;
+                    huge_.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+            if (!header->data) {
+                try {
+                    header->data = static_cast<std::byte*>(
+                        ::operator new(capacity, std::align_val_t(AlignmentFor(capacity))));
+                } catch (...) {
+                    delete header;
+                    throw;
+                }
+            }
+            return header;
+        }
+
+        static void Free(BufferHeader* header) noexcept {
+            if (header->flags & kFlagLargePages) {
+                PlatformFreeLargePages(header->data, header->capacity);
+            } else {
+                ::operator delete(header->data, std::align_val_t(AlignmentFor(header->capacity)));
+            }
+            delete header;
+        }
+
+        void Recycle(BufferHeader* header) noexcept {
+            outstanding_bytes_.fetch_sub(header->capacity, std::memory_order_relaxed);
+            if (header->size_class == kUncachedClass || closed_.load(std::memory_order_acquire)) {
+                Free(header);
+                return;
+            }
+            // 先占额度再入栈；超出上限就直接归还系统
+            if (cached_bytes_.fetch_add(header->capacity, std::memory_order_relaxed) + header->capacity >
+                max_cached_bytes_) {
+                cached_bytes_.fetch_sub(header->capacity, std::memory_order_relaxed);
+                Free(header);
+                return;
+            }
+            FreeList& list = List(header->flags >> kNodeShift, header->size_class);
+            try {
+                std::lock_guard<std::mutex> lock(list.mutex);
+                list.buffers.push_back(header);
+                cached_buffers_.fetch_add(1, std::memory_order_relaxed);
+            } catch (...) {
+                cached_bytes_.fetch_sub(header->capacity, std::memory_order_relaxed);
+                Free(header);
+            }
+        }
+
+        void Unref() noexcept {
+            if (refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) delete this;
+        }
+
+        const size_t max_cached_bytes_;
+        const bool huge_pages_;
+        std::atomic<bool> closed_{ false };
+        std::atomic<size_t> refs_{ 1 };  //!< 1 (池对象) + 在外的缓冲区数
+        const size_t node_count_;        //!< NUMA 节点分片数 (单节点机器为 1)
+        const std::unique_ptr<FreeList[]> lists_;  //!< [节点][级别] 的空闲栈
+        std::atomic<size_t> cached_buffers_{ 0 };
+        std::atomic<size_t> cached_bytes_{ 0 };
+        std::atomic<size_t> outstanding_bytes_{ 0 };
+        std::atomic<uint64_t> acquires_{ 0 };
+        std::atomic<uint64_t> hits_{ 0 };
+        std::atomic<uint64_t> huge_{ 0 };
+    };
+
+    BufferPool::BufferPool(size_t max_cached_bytes, bool huge_pages)
+        : core_(new Core(max_cached_bytes, huge_pages)) {}
+
+    BufferPool::~BufferPool() { core_->Close(); }
+
+    BufferRef BufferPool::Acquire(size_t size) { return core_->Acquire(size); }
+
+    BufferPoolStats BufferPool::Stats() const { return core_->Stats(); }
+
+    void BufferPool::Trim() { core_->Trim(); }
+
+    // --- PluginManager: IBufferPool 接口实现 (转发给 Pimpl 持有的 BufferPool) ---
+
+    BufferRef PluginManager::AcquireBuffer(size_t size) {
+        return pimpl_->buffer_pool_->Acquire(size);
+    }
+
+    BufferPoolStats PluginManager::GetBufferPoolStats() const {
+        return pimpl_->buffer_pool_->Stats();
+    }
+
+    void PluginManager::TrimBufferPool() {
+        pimpl_->buffer_pool_->Trim();
+    }
+
+}  // namespace z3y
@@ -0,0 +1,82 @@
+﻿/*
+* Copyright [2025] [Yue Liu]
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/**
+ * @file buffer_pool.h
+ * @brief [内部] `IBufferPool` 的实现：按 2 的幂分级缓存的大块缓冲区。
+ *
+ * @details
+ * [受众：框架维护者]
+ *
+ * - 级别 i 的容量为 `256 << i` 字节，共 `kClassCount` 级 (256 B ~ 256 MB)。更大的请求单独分配，不缓存。
+ * - 小于一页的级别按缓存行对齐，其余按页对齐。开启大页时，≥ 2 MB 的级别改用平台大页映射
+ * (见 `PlatformAllocateLargePages`)，失败则退回普通分配。
+ * - 每个 NUMA 节点、每级一把锁、一个空闲栈。缓冲区通常按帧获取，锁的开销相对数据本身可以忽略。
+ * 获取时优先取调用线程所在节点的缓存；缓冲区记住分配它的节点，释放 (可能在另一个节点上) 时回到原节点。
+ * - 所有空闲缓冲区的总容量不超过 `max_cached_bytes`，超出的直接归还系统。
+ *
+ * [生命周期]
+ * 真正的状态在引用计数的 `Core` 里：池对象本身持有一个引用，每个在外的缓冲区再各持有一个。
+ * 池析构 (PluginManager 销毁) 时清空缓存并放弃自己的引用；最后一个缓冲区释放时 `Core` 才被删除，
+ * 因此比框架活得更久的缓冲区也能安全释放。
+ */
+
+#pragma once
+
+#ifndef Z3Y_SRC_PLUGIN_MANAGER_BUFFER_POOL_H_
+#define Z3Y_SRC_PLUGIN_MANAGER_BUFFER_POOL_H_
+
+#include <cstddef>
+#include "framework/i_buffer_pool.h"
+
+namespace z3y {
+
+    /** @brief [平台实现] 系统页大小。 */
+    size_t PlatformPageSize();
+
+    /**
+     * @brief [平台实现] 以大页方式申请 `bytes` 字节 (Linux: mmap + MADV_HUGEPAGE；Windows: MEM_LARGE_PAGES)。
+     * @return 失败或平台不支持时返回 nullptr，调用方退回普通分配。
+     */
+    void* PlatformAllocateLargePages(size_t bytes);
+
+    /** @brief [平台实现] 释放 `PlatformAllocateLargePages` 申请的内存。 */
+    void PlatformFreeLargePages(void* p, size_t bytes);
+
+    class BufferPool {
+    public:
+        static constexpr size_t kMinClassShift = 8;   //!< 最小级别 256 B
+        static constexpr size_t kClassCount = 21;     //!< 最大级别 256 MB
+        static constexpr size_t kLargePageThreshold = size_t(2) << 20;  //!< ≥ 2 MB 的级别才尝试大页
+
+        BufferPool(size_t max_cached_bytes, bool huge_pages);
+        ~BufferPool();
+        BufferPool(const BufferPool&) = delete;
+        BufferPool& operator=(const BufferPool&) = delete;
+
+        /** @throws std::bad_alloc 内存不足。 */
+        BufferRef Acquire(size_t size);
+        BufferPoolStats Stats() const;
+        void Trim();
+
+    private:
+        class Core;
+        Core* core_;
+    };
+
+}  // namespace z3y
+
+#endif  // Z3Y_SRC_PLUGIN_MANAGER_BUFFER_POOL_H_
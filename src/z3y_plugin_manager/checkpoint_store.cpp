@@ -0,0 +1,181 @@
+﻿/*
+* Copyright [2025] [Yue Liu]
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/**
+ * @file checkpoint_store.cpp
+ * @brief [内部] 单例热状态检查点文件的读写 (见 checkpoint_store.h)。
+ */
+
+#include "checkpoint_store.h"
+#include "plugin_manifest.h"  // QueryPluginFileInfo
+#include "framework/z3y_utils.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <system_error>
+#include <vector>
+
+namespace z3y {
+
+    namespace {
+        constexpr char kCheckpointMagic[8] = { 'z', '3', 'y', 'c', 'k', 'p', 't', '\0' };
+        constexpr uint32_t kCheckpointFormat = 1;
+        constexpr uint64_t kFnvOffsetBasis = 14695981039346656037ull;
+        constexpr uint64_t kFnvPrime = 1099511628211ull;
+
+        /** @brief 文件头 (本机字节序；检查点不跨机器使用)。负载紧随其后，起始地址 8 字节对齐。 */
+        struct CheckpointHeader {
+            char magic[8];
+            uint32_t format;
+            uint32_t state_version;
+            uint64_t clsid;
+            uint64_t plugin_stamp;
+            uint64_t interface_hash;
+            uint64_t payload_size;
+            uint64_t payload_checksum;
+        };
+        static_assert(sizeof(CheckpointHeader) == 56, "checkpoint header layout must not change");
+
+        uint64_t HashBytes(uint64_t hash, const void* data, size_t size) {
+            const auto* p = static_cast<const uint8_t*>(data);
+            for (size_t i = 0; i < size; ++i) hash = (hash ^ p[i]) * kFnvPrime;
+            return hash;
+        }
+
+        template <typename T>
+        uint64_t HashValue(uint64_t hash, const T& value) {
+            return HashBytes(hash, &value, sizeof(value));
+        }
+
+        /** @brief 作用域结束时解除映射 (服务抛出异常时也不泄漏映射)。 */
+        class ScopedMapping {
+        public:
+            ~ScopedMapping() { PlatformUnmapFile(file); }
+            MappedFile file;
+        };
+    }
+
+    CheckpointKey MakeCheckpointKey(ClassId clsid, const std::string& plugin_path, const InterfaceList& interfaces) {
+        CheckpointKey key;
+        key.clsid = clsid;
+        PluginFileInfo info;
+        if (!plugin_path.empty() && QueryPluginFileInfo(utils::Utf8ToPath(plugin_path), info)) {
+            key.plugin_stamp = HashValue(HashValue(kFnvOffsetBasis, info.size), info.mtime);
+        }
+        uint64_t hash = kFnvOffsetBasis;
+        for (const auto& iface : interfaces) {
+            hash = HashValue(hash, iface.iid);
+            hash = HashValue(hash, iface.version.major);
+            hash = HashValue(hash, iface.version.minor);
+        }
+        key.interface_hash = hash;
+        return key;
+    }
+
+    std::filesystem::path CheckpointFilePath(const std::filesystem::path& dir, ClassId clsid) {
+        char name[32];
+        std::snprintf(name, sizeof(name), "%016llx.z3yckpt", static_cast<unsigned long long>(clsid));
+        return dir / name;
+    }
+
+    bool WriteCheckpoint(const std::filesystem::path& dir, const CheckpointKey& key,
+        ICheckpointable& target, std::string& out_error_message) {
+        const std::filesystem::path file = CheckpointFilePath(dir, key.clsid);
+        std::vector<uint8_t> payload;
+        const uint32_t state_version = target.GetCheckpointVersion();
+        std::error_code ec;
+        if (!target.SaveCheckpoint(payload)) {
+            std::filesystem::remove(file, ec);
+            return true;
+        }
+
+        CheckpointHeader header{};
+        std::memcpy(header.magic, kCheckpointMagic, sizeof(header.magic));
+        header.format = kCheckpointFormat;
+        header.state_version = state_version;
+        header.clsid = key.clsid;
+        header.plugin_stamp = key.plugin_stamp;
+        header.interface_hash = key.interface_hash;
+        header.payload_size = payload.size();
+        header.payload_checksum = HashBytes(kFnvOffsetBasis, payload.data(), payload.size());
+
+        std::filesystem::create_directories(dir, ec);
+        std::filesystem::path tmp = file;
+        tmp += ".tmp";
+        {
+            std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+            if (out) {
+                out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+                out.write(reinterpret_cast<const char*>(payload.data()), static_cast<std::streamsize>(payload.size()));
+            }
+            if (!out) {
+                out_error_message = "Cannot write checkpoint '" + utils::PathToUtf8(tmp) + "'";
+                out.close();
+                std::filesystem::remove(tmp, ec);
+                return false;
+            }
+        }
+        std::filesystem::rename(tmp, file, ec);
+        if (ec) {
+            out_error_message = "Cannot rename checkpoint '" + utils::PathToUtf8(tmp) + "': " + ec.message();
+            std::filesystem::remove(tmp, ec);
+            return false;
+        }
+        return true;
+    }
+
+    CheckpointRestore ReadCheckpoint(const std::filesystem::path& dir, const CheckpointKey& key,
+        ICheckpointable& target) {
+        const std::filesystem::path file = CheckpointFilePath(dir, key.clsid);
+        bool accepted = false;
+        {
+            ScopedMapping mapping;
+            if (!PlatformMapFileReadOnly(file, mapping.file)) {
+                std::error_code ec;
+                if (!std::filesystem::exists(file, ec)) return CheckpointRestore::kNone;
+            }
+            else if (mapping.file.size >= sizeof(CheckpointHeader)) {
+                CheckpointHeader header;
+                std::memcpy(&header, mapping.file.data, sizeof(header));
+                const uint8_t* payload = mapping.file.data + sizeof(header);
+                const bool valid = std::memcmp(header.magic, kCheckpointMagic, sizeof(header.magic)) == 0 &&
+                    header.format == kCheckpointFormat &&
+                    header.clsid == key.clsid &&
+                    header.plugin_stamp == key.plugin_stamp &&
+                    header.interface_hash == key.interface_hash &&
+                    header.state_version == target.GetCheckpointVersion() &&
+                    header.payload_size == mapping.file.size - sizeof(header) &&
+                    header.payload_checksum == HashBytes(kFnvOffsetBasis, payload, static_cast<size_t>(header.payload_size));
+                if (valid) {
+                    try {
+                        accepted = target.RestoreCheckpoint(payload, static_cast<size_t>(header.payload_size));
+                    } catch (...) {
+                        PlatformUnmapFile(mapping.file);  // Windows 上映射中的文件不能删除
+                        std::error_code ec;
+                        std::filesystem::remove(file, ec);
+                        throw;
+                    }
+                }
+            }
+        }
+        if (accepted) return CheckpointRestore::kRestored;
+        std::error_code ec;
+        std::filesystem::remove(file, ec);
+        return CheckpointRestore::kDiscarded;
+    }
+
+}  // namespace z3y
@@ -0,0 +1,105 @@
+﻿/*
+* Copyright [2025] [Yue Liu]
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/**
+ * @file checkpoint_store.h
+ * @brief [私有头文件] 单例热状态检查点文件的读写 (见 framework/i_checkpointable.h)。
+ *
+ * @details
+ * [受众：框架维护者]
+ *
+ * 每个单例一个文件 `<目录>/<clsid 十六进制>.z3yckpt`：固定 56 字节的文件头，之后是服务给出的原始字节。
+ * 文件头记录保存时的状态版本、来源插件文件指纹 (大小 + 修改时间，与清单缓存的校验键相同)、
+ * 接口版本指纹 (组件实现的全部 iid + 版本) 与负载的 FNV-1a 校验和，任一项不符即删除文件。
+ *
+ * 保存走普通写入 + 改名 (与清单缓存相同)，读者永远看不到写了一半的文件；
+ * 恢复时把文件只读映射进内存，负载指针直接交给 `ICheckpointable::RestoreCheckpoint`。
+ */
+
+#pragma once
+
+#ifndef Z3Y_SRC_PLUGIN_MANAGER_CHECKPOINT_STORE_H_
+#define Z3Y_SRC_PLUGIN_MANAGER_CHECKPOINT_STORE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+#include "framework/class_id.h"
+#include "framework/i_checkpointable.h"
+#include "framework/i_plugin_query.h"
+
+namespace z3y {
+
+    /**
+     * @struct MappedFile
+     * @brief [平台实现] 一个文件的只读内存映射。
+     */
+    struct MappedFile {
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+        void* native_handle = nullptr;  //!< Windows: 文件映射句柄；POSIX: 未使用
+    };
+
+    /** @brief [平台实现] 只读映射整个文件。文件不存在、为空或无法映射时返回 false。 */
+    bool PlatformMapFileReadOnly(const std::filesystem::path& file, MappedFile& out);
+
+    /** @brief [平台实现] 解除映射 (对未映射的对象为空操作)。 */
+    void PlatformUnmapFile(MappedFile& file);
+
+    /**
+     * @struct CheckpointKey
+     * @brief 检查点的有效性校验键 (状态版本之外的部分)。
+     */
+    struct CheckpointKey {
+        ClassId clsid = 0;
+        uint64_t plugin_stamp = 0;    //!< 来源插件文件的大小 + 修改时间指纹 (进程内注册的组件为 0)
+        uint64_t interface_hash = 0;  //!< 实现的全部接口 (iid + 主/次版本) 的指纹
+    };
+
+    /** @brief 根据组件的注册信息生成校验键 (对插件文件做一次 stat)。 */
+    [[nodiscard]] CheckpointKey MakeCheckpointKey(ClassId clsid, const std::string& plugin_path,
+        const InterfaceList& interfaces);
+
+    /** @brief 检查点文件路径：`<dir>/<clsid 16 位十六进制>.z3yckpt`。 */
+    [[nodiscard]] std::filesystem::path CheckpointFilePath(const std::filesystem::path& dir, ClassId clsid);
+
+    /**
+     * @brief 调用 `target.SaveCheckpoint` 并写入检查点文件 (先写临时文件再改名)。
+     * @details 服务返回 false 时删除已有的旧文件。服务抛出的异常原样传出 (不留下临时文件)。
+     * @return 文件写入失败时返回 false 并写入 out_error_message。
+     */
+    bool WriteCheckpoint(const std::filesystem::path& dir, const CheckpointKey& key,
+        ICheckpointable& target, std::string& out_error_message);
+
+    /** @brief `ReadCheckpoint` 的结果。 */
+    enum class CheckpointRestore {
+        kNone,       //!< 没有检查点
+        kRestored,   //!< 已交给服务且服务接受
+        kDiscarded,  //!< 过期、损坏或被服务拒绝：文件已删除
+    };
+
+    /**
+     * @brief 校验检查点并交给 `target.RestoreCheckpoint` (数据来自只读映射)。
+     * @details 服务抛出异常时同样删除文件，然后原样传出异常。
+     */
+    CheckpointRestore ReadCheckpoint(const std::filesystem::path& dir, const CheckpointKey& key,
+        ICheckpointable& target);
+
+}  // namespace z3y
+
+#endif  // Z3Y_SRC_PLUGIN_MANAGER_CHECKPOINT_STORE_H_
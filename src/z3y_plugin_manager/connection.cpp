@@ -16,7 +16,7 @@
 
 /**
  * @file connection.cpp
- * @brief Connection 类的实现细节。
+ * @brief Connection / EventConnectionGroup 的实现细节，以及票据槽的池。
  *
  * @details
  * 这里实现了 Connection 的核心逻辑，特别是 `Disconnect`。
@@ -24,39 +24,83 @@
  */
 
 #include "framework/connection.h"
+
+#include <mutex>
 #include "framework/i_event_bus.h"
+#include "connection_slot.h"
 
 namespace z3y {
 
-    /**
-     * @brief 构造函数。
-     * 初始化所有状态。注意我们接管了 `active_token` 的 shared_ptr。
-     */
-    Connection::Connection(std::weak_ptr<IEventBus> bus,
-        std::weak_ptr<void> subscriber, EventId event_id,
-        std::weak_ptr<void> sender_key,
-        std::shared_ptr<std::atomic<bool>> active_token)
-        : bus_(std::move(bus)),
-        subscriber_(std::move(subscriber)),
-        event_id_(event_id),
-        sender_key_(std::move(sender_key)),
-        is_connected_(true),
-        active_token_(std::move(active_token)) {
+    namespace {
+        /**
+         * @class ConnectionSlotPool
+         * @brief 票据槽的空闲链表。槽按块分配、永不归还系统。
+         * @details 实例被有意泄漏：静态析构阶段仍可能有连接或订阅列表在释放槽。
+         * 订阅与断开本来就要持有总线的写锁，这里一把互斥锁的开销可以忽略。
+         */
+        class ConnectionSlotPool {
+        public:
+            static constexpr size_t kChunkSlots = 256;
+
+            static ConnectionSlotPool& Instance() {
+                static ConnectionSlotPool* instance = new ConnectionSlotPool();
+                return *instance;
+            }
+
+            internal::ConnectionSlot* Pop() {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (!free_) {
+                    auto* chunk = new internal::ConnectionSlot[kChunkSlots];
+                    for (size_t i = 0; i < kChunkSlots; ++i) {
+                        chunk[i].next_free = free_;
+                        free_ = &chunk[i];
+                    }
+                }
+                internal::ConnectionSlot* slot = free_;
+                free_ = slot->next_free;
+                slot->next_free = nullptr;
+                return slot;
+            }
+
+            void Push(internal::ConnectionSlot* slot) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                slot->next_free = free_;
+                free_ = slot;
+            }
+
+        private:
+            std::mutex mutex_;
+            internal::ConnectionSlot* free_ = nullptr;
+        };
+    }  // namespace
+
+    internal::ConnectionSlot* internal::ConnectionSlot::Acquire(std::weak_ptr<IEventBus> bus,
+        std::weak_ptr<void> subscriber, EventId event_id, std::weak_ptr<void> sender_key) {
+        ConnectionSlot* slot = ConnectionSlotPool::Instance().Pop();
+        slot->bus = std::move(bus);
+        slot->subscriber = std::move(subscriber);
+        slot->event_id = event_id;
+        slot->sender_key = std::move(sender_key);
+        slot->active.store(true, std::memory_order_relaxed);
+        slot->refs.store(1, std::memory_order_release);
+        return slot;
+    }
+
+    void internal::ConnectionSlot::Recycle(ConnectionSlot* slot) noexcept {
+        // 弱引用在锁外释放 (可能释放控制块)
+        slot->bus.reset();
+        slot->subscriber.reset();
+        slot->sender_key.reset();
+        slot->active.store(false, std::memory_order_relaxed);
+        ConnectionSlotPool::Instance().Push(slot);
     }
 
     /**
      * @brief 移动构造函数。
-     * 资源转移。
+     * 资源转移：只交换槽指针。
      */
     Connection::Connection(Connection&& other) noexcept
-        : bus_(std::move(other.bus_)),
-        subscriber_(std::move(other.subscriber_)),
-        event_id_(other.event_id_),
-        sender_key_(std::move(other.sender_key_)),
-        active_token_(std::move(other.active_token_)) {
-        // 原子地将对方标记为未连接，并接管状态
-        bool was_connected = other.is_connected_.exchange(false);
-        is_connected_.store(was_connected);
+        : slot_(std::exchange(other.slot_, nullptr)) {
     }
 
     /**
@@ -65,50 +109,75 @@ namespace z3y {
     Connection& Connection::operator=(Connection&& other) noexcept {
         if (this != &other) {
             Disconnect(); // 先断开自己当前的
-            bus_ = std::move(other.bus_);
-            subscriber_ = std::move(other.subscriber_);
-            event_id_ = other.event_id_;
-            sender_key_ = std::move(other.sender_key_);
-            active_token_ = std::move(other.active_token_);
-            bool was_connected = other.is_connected_.exchange(false);
-            is_connected_.store(was_connected);
+            if (slot_) slot_->Release();
+            slot_ = std::exchange(other.slot_, nullptr);
         }
         return *this;
     }
 
+    Connection::~Connection() {
+        if (slot_) slot_->Release();
+    }
+
     /**
      * @brief 断开连接 (核心实现)。
      *
      * @details
-     * 1. `exchange(false)`: 原子地检查并设置状态，防止多线程重复调用 Disconnect。
-     * 2. `active_token_->store(false)`: **这是最关键的一步！**
-     * 这个 `active_token_` 是和 EventBus 共享的内存。
-     * 只要把它置为 false，所有持有着这个 Token 的待执行回调（无论在队列里还是刚取出来）
+     * 1. `active.exchange(false)`: **这是最关键的一步！**
+     * 票据槽中的 `active` 是和 EventBus 共享的内存。
+     * 只要把它置为 false，所有持有着这个槽的待执行回调（无论在队列里还是刚取出来）
      * 在执行前检查时都会发现 false，从而停止执行。
-     * 使用了 `memory_order_release` 保证写入对其他线程可见。
-     * 3. `strong_bus->Unsubscribe(...)`: 通知 Bus 做物理删除。这一步即使慢一点也没关系，
-     * 因为逻辑上已经断开了。
+     * exchange 同时保证多线程重复调用 Disconnect 时只有一次生效。
+     * 2. `strong_bus->ReleaseConnection(...)`: 通知 Bus 登记惰性 GC (O(1))。
+     * 逻辑上已经断开了，物理删除推迟到 GC 批处理中统一完成。
+     * 槽的引用保留到句柄析构：断开后 `IsConnected()` 仍可安全调用。
      */
     void Connection::Disconnect() {
-        if (!is_connected_.exchange(false)) return;
+        if (!slot_ || !slot_->active.exchange(false, std::memory_order_acq_rel)) return;
 
-        // [撕票] 强一致性断开
-        if (active_token_) {
-            active_token_->store(false, std::memory_order_release);
+        // [物理清理] 登记惰性 GC，由 GC 批处理移除记录
+        if (auto strong_bus = slot_->bus.lock()) {
+            strong_bus->ReleaseConnection(slot_->event_id, slot_->sender_key);
         }
-
-        // [物理清理] 尝试锁定 Bus 并移除记录
-        if (auto strong_bus = bus_.lock()) {
-            if (auto strong_sub = subscriber_.lock()) {
-                strong_bus->Unsubscribe(strong_sub, event_id_, sender_key_);
-            }
-        }
-        active_token_.reset(); // 释放我对 token 的引用
     }
 
     bool Connection::IsConnected() const {
-        // 连接有效的条件：自身标记为 true + Bus 还在 + 订阅者还在
-        return is_connected_.load() && !bus_.expired() && !subscriber_.expired();
+        // 连接有效的条件：票据有效 + Bus 还在 + 订阅者还在
+        return slot_ && slot_->active.load(std::memory_order_acquire) &&
+            !slot_->bus.expired() && !slot_->subscriber.expired();
+    }
+
+    void EventConnectionGroup::Add(Connection connection) {
+        if (connection.slot_) connections_.push_back(std::move(connection));
+    }
+
+    /**
+     * @brief 批量断开。
+     * @details 先撕掉全部票据 (此后回调不再执行)，再按总线分批，每条总线只通知一次。
+     * 组内的连接通常来自同一条总线，分批只是一次指针比较。
+     */
+    void EventConnectionGroup::DisconnectAll() {
+        if (connections_.empty()) return;
+        std::vector<std::pair<EventId, std::weak_ptr<void>>> released;
+        released.reserve(connections_.size());
+        std::shared_ptr<IEventBus> bus;
+        auto flush = [&released, &bus]() {
+            if (bus && !released.empty()) bus->ReleaseConnections(released);
+            released.clear();
+        };
+        for (Connection& connection : connections_) {
+            internal::ConnectionSlot* slot = connection.slot_;
+            if (!slot || !slot->active.exchange(false, std::memory_order_acq_rel)) continue;
+            std::shared_ptr<IEventBus> owner = slot->bus.lock();
+            if (!owner) continue;
+            if (owner != bus) {
+                flush();
+                bus = std::move(owner);
+            }
+            released.emplace_back(slot->event_id, slot->sender_key);
+        }
+        flush();
+        connections_.clear();
     }
 
 }  // namespace z3y
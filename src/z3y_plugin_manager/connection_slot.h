@@ -0,0 +1,132 @@
+﻿/*
+* Copyright [2025] [Yue Liu]
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/**
+ * @file connection_slot.h
+ * @brief [内部] 订阅票据槽 `internal::ConnectionSlot` 与订阅记录持有的引用 `ConnectionTicket`。
+ *
+ * @details
+ * [受众：框架维护者]
+ *
+ * 每个订阅一个槽，槽里放撕票标志，以及 `Connection::Disconnect` 通知总线所需的信息
+ * (总线、订阅者、事件 ID、发送者)。槽来自进程级的池：按 256 个一块分配，永不归还系统，
+ * 订阅与断开都不访问全局堆。
+ *
+ * 槽由侵入式引用计数管理：`Connection` 句柄持有一个引用，订阅列表中这条订阅的每个副本
+ * (各级写时复制快照) 各持有一个。最后一个引用释放时槽回到池中。因此 `Connection` 只是一个指针，
+ * 而派发路径判断订阅是否有效只需读取槽里的一个原子布尔值。
+ */
+
+#pragma once
+
+#ifndef Z3Y_SRC_PLUGIN_MANAGER_CONNECTION_SLOT_H_
+#define Z3Y_SRC_PLUGIN_MANAGER_CONNECTION_SLOT_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include "framework/class_id.h"
+
+namespace z3y {
+
+    class IEventBus;
+
+    namespace internal {
+
+        struct ConnectionSlot {
+            std::atomic<uint32_t> refs{ 0 };
+            std::atomic<bool> active{ false };  //!< 原子票据：false 之后回调不再执行
+            EventId event_id = 0;
+            std::weak_ptr<IEventBus> bus;
+            std::weak_ptr<void> subscriber;
+            std::weak_ptr<void> sender_key;     //!< 全局订阅为空
+            ConnectionSlot* next_free = nullptr;
+
+            /** @brief 从池中取一个槽 (引用计数为 1，票据有效)。 */
+            static ConnectionSlot* Acquire(std::weak_ptr<IEventBus> bus, std::weak_ptr<void> subscriber,
+                EventId event_id, std::weak_ptr<void> sender_key);
+
+            void AddRef() noexcept { refs.fetch_add(1, std::memory_order_relaxed); }
+            void Release() noexcept {
+                if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1) Recycle(this);
+            }
+
+        private:
+            static void Recycle(ConnectionSlot* slot) noexcept;
+        };
+
+    }  // namespace internal
+
+    /**
+     * @class ConnectionTicket
+     * @brief [内部] 订阅记录持有的票据槽引用。拷贝 = 引用计数加一。
+     */
+    class ConnectionTicket {
+    public:
+        ConnectionTicket() noexcept = default;
+
+        /** @brief 接管一个已有的引用 (通常来自 `ConnectionSlot::Acquire`)。 */
+        explicit ConnectionTicket(internal::ConnectionSlot* adopted) noexcept : slot_(adopted) {}
+
+        ConnectionTicket(const ConnectionTicket& other) noexcept : slot_(other.slot_) {
+            if (slot_) slot_->AddRef();
+        }
+        ConnectionTicket(ConnectionTicket&& other) noexcept : slot_(std::exchange(other.slot_, nullptr)) {}
+        ConnectionTicket& operator=(const ConnectionTicket& other) noexcept {
+            if (this != &other) {
+                ConnectionTicket copy(other);
+                std::swap(slot_, copy.slot_);
+            }
+            return *this;
+        }
+        ConnectionTicket& operator=(ConnectionTicket&& other) noexcept {
+            if (this != &other) {
+                ConnectionTicket old(std::move(*this));
+                slot_ = std::exchange(other.slot_, nullptr);
+            }
+            return *this;
+        }
+        ~ConnectionTicket() {
+            if (slot_) slot_->Release();
+        }
+
+        /** @brief 票据是否仍然有效 (没有槽也视为无效)。 */
+        [[nodiscard]] bool Active(std::memory_order order = std::memory_order_acquire) const noexcept {
+            return slot_ && slot_->active.load(order);
+        }
+
+        /**
+         * @brief 撕掉票据 (批量 Unsubscribe 使用)：回调立即停止，订阅留给 GC 物理移除。
+         * @return 本次调用是否把票据从有效变为无效。
+         */
+        bool Revoke() const noexcept {
+            return slot_ && slot_->active.exchange(false, std::memory_order_acq_rel);
+        }
+
+        /** @brief 为 `Connection` 句柄再取一个引用。 */
+        [[nodiscard]] internal::ConnectionSlot* Share() const noexcept {
+            slot_->AddRef();
+            return slot_;
+        }
+
+    private:
+        internal::ConnectionSlot* slot_ = nullptr;
+    };
+
+}  // namespace z3y
+
+#endif  // Z3Y_SRC_PLUGIN_MANAGER_CONNECTION_SLOT_H_
@@ -25,9 +25,23 @@
  * 这保证了 `FireGlobal` 遍历列表时绝对线程安全，且不会被递归调用（在回调里订阅/取消订阅）搞死锁。
  * 2. **Lazy GC (懒惰垃圾回收)**: 当发现失效的订阅（如弱引用过期）时，不立即删除，
  * 而是标记该事件 ID，稍后异步批量清理。
+ * 3. **分片派发 (Sharded Dispatch)**: kQueued 回调按订阅者身份分配到固定的派发线程，
+ * 保证单个订阅者内部有序，不同订阅者之间并行。
+ * 4. **RCU 读侧**: 全局订阅表通过 `RcuDomain` 发布，Fire / IsGlobalSubscribed 不加锁、
+ * 不碰引用计数；旧版本在所有可能的读者离开后才释放。
+ * 读侧按进程级稠密槽号 (`EventSlotIndex`) 直接索引槽表，不做哈希。
+ * 5. **批量投递 (Batch Enqueue)**: 一次 Fire 中落到同一派发线程的所有 kQueued 回调
+ * 被合并为一个任务，只需一次分配、一次入队、一次唤醒。
+ * 6. **优先级通道 (Priority Lanes)**: 每个派发线程按 kRealtime / kNormal / kBackground
+ * 各有一条队列，总是先排空高优先级通道；GC 任务固定走 kBackground。
+ * 7. **类型化通道 (EventChannel)**: 通道自带一份只含 kDirect 订阅的列表，`FireChannelImpl`
+ * 直接从通道状态读取它与其余订阅，不经过槽表与订阅预检。
+ * 8. **慢回调看门狗**: 每次回调的耗时计入订阅自己的滑动平均与最大值，超过阈值时带着
+ * 订阅者的 CLSID 与插件路径上报；可选地把屡次超时的 kDirect 订阅降级到派发线程。
  */
 
 #include "plugin_manager_pimpl.h"
+#include <future>
 #include <iostream>
 #include "framework/connection.h"
 
@@ -36,68 +50,852 @@ namespace z3y {
     extern void ReportException(PluginManagerPimpl* pimpl, const std::exception& e);
     extern void ReportUnknownException(PluginManagerPimpl* pimpl);
 
+    namespace {
+        /**
+         * @brief [内部] 进程级 EventId -> 槽号注册表。
+         * @details 只增不减；槽号一旦分配就永久有效 (跨 PluginManager 实例)。
+         * 只在首次解析某事件类型、或走 EventId 接口时才会访问。
+         * 同时记录事件族索引 (事件 -> 各级事件族，事件族 -> 成员事件)，同样只增不减。
+         */
+        class EventSlotRegistry {
+        public:
+            static EventSlotRegistry& Instance() {
+                static EventSlotRegistry registry;
+                return registry;
+            }
+
+            EventSlotIndex Resolve(EventId event_id) {
+                {
+                    std::shared_lock lock(mutex_);
+                    auto it = slots_.find(event_id);
+                    if (it != slots_.end()) return it->second;
+                }
+                std::unique_lock lock(mutex_);
+                auto it = slots_.find(event_id);
+                if (it != slots_.end()) return it->second;
+                if (slots_.size() >= PluginManagerPimpl::kMaxEventSlots) {
+                    throw std::length_error("z3y: too many distinct event types (event slot table is full)");
+                }
+                EventSlotIndex slot = static_cast<EventSlotIndex>(slots_.size());
+                slots_.emplace(event_id, slot);
+                return slot;
+            }
+
+            bool Find(EventId event_id, EventSlotIndex& out_slot) const {
+                std::shared_lock lock(mutex_);
+                auto it = slots_.find(event_id);
+                if (it == slots_.end()) return false;
+                out_slot = it->second;
+                return true;
+            }
+
+            bool RegisterFamily(EventId event_id, std::vector<EventId> family_ids) {
+                if (family_ids.empty()) return false;
+                std::unique_lock lock(mutex_);
+                if (families_.count(event_id) != 0) return false;
+                for (EventId family_id : family_ids) members_[family_id].push_back(event_id);
+                families_.emplace(event_id, std::move(family_ids));
+                return true;
+            }
+
+            std::vector<EventId> FamiliesOf(EventId event_id) const {
+                std::shared_lock lock(mutex_);
+                auto it = families_.find(event_id);
+                return it != families_.end() ? it->second : std::vector<EventId>();
+            }
+
+            std::vector<EventId> MembersOf(EventId family_id) const {
+                std::shared_lock lock(mutex_);
+                auto it = members_.find(family_id);
+                return it != members_.end() ? it->second : std::vector<EventId>();
+            }
+
+        private:
+            mutable std::shared_mutex mutex_;
+            std::unordered_map<EventId, EventSlotIndex> slots_;
+            std::unordered_map<EventId, std::vector<EventId>> families_; //!< 事件 -> 各级事件族
+            std::unordered_map<EventId, std::vector<EventId>> members_;  //!< 事件族 -> 成员事件
+        };
+
+        /** @brief [内部] 去掉末尾的 `/`。 */
+        std::string NormalizeFamily(const char* family) {
+            std::string name = family ? family : "";
+            while (!name.empty() && name.back() == '/') name.pop_back();
+            return name;
+        }
+
+        EventId HashFamily(const std::string& name) {
+            static const uint64_t seed = internal::Fnv1aHashRt("z3y-event-family:");
+            return internal::Fnv1aHashRt(name.c_str(), seed);
+        }
+    }  // namespace
+
+    EventId EventFamilyIdOf(const char* family) {
+        const std::string name = NormalizeFamily(family);
+        return name.empty() ? 0 : HashFamily(name);
+    }
+
+    bool RegisterEventFamily(EventId event_id, const char* family) {
+        // 每一级前缀各登记一次："a/b/c" -> "a", "a/b", "a/b/c"
+        const std::string name = NormalizeFamily(family);
+        std::vector<EventId> family_ids;
+        for (size_t pos = name.find('/'); pos != std::string::npos; pos = name.find('/', pos + 1)) {
+            if (pos != 0 && name[pos - 1] != '/') family_ids.push_back(HashFamily(name.substr(0, pos)));
+        }
+        if (!name.empty()) family_ids.push_back(HashFamily(name));
+        return EventSlotRegistry::Instance().RegisterFamily(event_id, std::move(family_ids));
+    }
+
+    std::vector<EventId> EventFamiliesOf(EventId event_id) {
+        return EventSlotRegistry::Instance().FamiliesOf(event_id);
+    }
+
+    std::vector<EventId> EventFamilyMembers(EventId family_id) {
+        return EventSlotRegistry::Instance().MembersOf(family_id);
+    }
+
+    EventSlotIndex ResolveEventSlotIndex(EventId event_id) {
+        return EventSlotRegistry::Instance().Resolve(event_id);
+    }
+
+    bool FindEventSlotIndex(EventId event_id, EventSlotIndex& out_slot) {
+        return EventSlotRegistry::Instance().Find(event_id, out_slot);
+    }
+
+    namespace {
+        /** @brief [内部] 派发线程当前的近似积压数 (仅用于追踪)。 */
+        uint32_t QueueDepthOf(PluginManagerPimpl* pimpl, size_t worker_index) {
+            return static_cast<uint32_t>(pimpl->dispatch_workers_[worker_index]->pending.load(std::memory_order_relaxed));
+        }
+
+        /**
+         * @brief [内部] 调用一次回调，捕获并统计异常。`target` 为已固定的订阅者。
+         * @details 所有投递路径最终都经过这里，CPU 时间在此记入订阅所属插件的账户。
+         */
+        void InvokeCallback(PluginManagerPimpl* pimpl, const PluginManagerPimpl::Subscription& sub,
+            void* target, const Event& e) {
+            const CpuChargeScope charge = CpuChargeScope::Callback(sub.stats->account.get());
+            try {
+                sub.callback(target, e);
+            } catch (const std::exception& ex) {
+                sub.stats->exceptions.fetch_add(1, std::memory_order_relaxed);
+                ReportException(pimpl, ex);
+            } catch (...) {
+                sub.stats->exceptions.fetch_add(1, std::memory_order_relaxed);
+                ReportUnknownException(pimpl);
+            }
+        }
+
+        /**
+         * @brief [内部] 在发布线程上对订阅的过滤谓词求值 (调用者已确认 `sub.filter` 非空)。
+         * @details 谓词抛出的异常按回调异常统计与上报，并视为不匹配。
+         */
+        bool PassesFilter(PluginManagerPimpl* pimpl, const PluginManagerPimpl::Subscription& sub, const Event& e) {
+            try {
+                return sub.filter(e);
+            } catch (const std::exception& ex) {
+                sub.stats->exceptions.fetch_add(1, std::memory_order_relaxed);
+                ReportException(pimpl, ex);
+            } catch (...) {
+                sub.stats->exceptions.fetch_add(1, std::memory_order_relaxed);
+                ReportUnknownException(pimpl);
+            }
+            return false;
+        }
+
+        /**
+         * @brief [内部] 上报一次慢回调 (看门狗的慢路径)。
+         * @details 插件路径只在这里按订阅者的 CLSID 查询注册表快照。报告回调抛出的异常被吞掉，不影响派发。
+         */
+        void ReportSlowHandler(PluginManagerPimpl* pimpl, const PluginManagerPimpl::Subscription& sub,
+            EventId event_id, uint64_t ns) {
+            const uint64_t slow_calls = sub.stats->slow_calls.fetch_add(1, std::memory_order_relaxed) + 1;
+            if (pimpl->slow_handler_demote_after_ != 0 && sub.connection_type == ConnectionType::kDirect &&
+                slow_calls >= pimpl->slow_handler_demote_after_) {
+                sub.stats->demoted.store(true, std::memory_order_relaxed);
+            }
+
+            SlowEventHandlerReport report;
+            report.event_id = event_id;
+            report.subscriber = sub.shard_key;
+            report.subscriber_clsid = sub.callback.SubscriberClassId();
+            report.connection_type = sub.connection_type;
+            report.duration_ns = ns;
+            report.average_ns = sub.stats->average_ns.load(std::memory_order_relaxed);
+            report.max_ns = sub.stats->max_ns.load(std::memory_order_relaxed);
+            report.slow_calls = slow_calls;
+            report.demoted = sub.stats->demoted.load(std::memory_order_relaxed);
+            if (report.subscriber_clsid != 0) {
+                if (auto owner = pimpl->owner_.lock()) {
+                    auto snapshot = owner->GetRegistrySnapshot();
+                    if (const ComponentDetails* details = snapshot->Find(report.subscriber_clsid)) {
+                        report.plugin_path = details->source_plugin_path;
+                    }
+                }
+            }
+
+            std::shared_ptr<PluginManager::SlowEventHandlerCallback> callback;
+            {
+                std::lock_guard lock(pimpl->exception_handler_mutex_);
+                callback = pimpl->slow_handler_callback_;
+            }
+            if (callback) {
+                try { (*callback)(report); } catch (...) { std::cerr << "[z3y FW] CRITICAL: Slow handler callback threw." << std::endl; }
+            } else {
+                std::cerr << "[z3y FW] Slow event handler: event 0x" << std::hex << event_id
+                    << " subscriber clsid 0x" << report.subscriber_clsid << std::dec
+                    << " (" << (report.plugin_path.empty() ? "<host>" : report.plugin_path) << ") took "
+                    << ns / 1000000 << " ms" << (report.demoted ? ", demoted to queued" : "") << std::endl;
+            }
+        }
+
+        /**
+         * @brief [内部] 记录一次回调耗时：直方图、滑动平均与最大值；超过阈值时上报。
+         * @param direct 是否在发布线程上同步执行。kDirect 的直方图只在 `event_metrics_time_direct_calls` 开启时记录。
+         */
+        void RecordCallback(PluginManagerPimpl* pimpl, const PluginManagerPimpl::Subscription& sub,
+            EventId event_id, uint64_t ns, bool direct) {
+            if (!direct || pimpl->metrics_time_direct_calls_) sub.stats->callback_time.Record(ns);
+            sub.stats->RecordDuration(ns);
+            if (pimpl->slow_handler_threshold_ns_ != 0 && ns >= pimpl->slow_handler_threshold_ns_) {
+                ReportSlowHandler(pimpl, sub, event_id, ns);
+            }
+        }
+
+        /** @brief [内部] kDirect 订阅是否已被看门狗降级 (只有开启降级且存在派发线程时才可能)。 */
+        bool IsDemoted(PluginManagerPimpl* pimpl, const PluginManagerPimpl::Subscription& sub, bool has_workers) {
+            return pimpl->slow_handler_demote_after_ != 0 && has_workers &&
+                sub.stats->demoted.load(std::memory_order_relaxed);
+        }
+
+        /** @brief [内部] 投递单个事件。批订阅者收到只含这一个事件的批。 */
+        void InvokeSingle(PluginManagerPimpl* pimpl, const PluginManagerPimpl::Subscription& sub,
+            void* target, const Event& e) {
+            if (sub.receives_batch) {
+                EventBatchView view;
+                view.single = &e;
+                InvokeCallback(pimpl, sub, target, view);
+            } else {
+                InvokeCallback(pimpl, sub, target, e);
+            }
+        }
+
+        /**
+         * @brief [内部] 向一个订阅者投递一整批事件。
+         * @details 批订阅者只回调一次；普通订阅者逐个回调，每个元素之前重新验票并求值过滤谓词，
+         * 回调中途断开连接后不会再收到剩余的事件。
+         */
+        void InvokeBatch(PluginManagerPimpl* pimpl, const PluginManagerPimpl::Subscription& sub,
+            void* target, const EventBatchView& batch) {
+            if (sub.receives_batch) {
+                InvokeCallback(pimpl, sub, target, batch);
+                return;
+            }
+            for (size_t i = 0; i < batch.size(); ++i) {
+                if (!sub.ticket.Active(std::memory_order_acquire)) return;
+                if (sub.filter && !PassesFilter(pimpl, sub, batch.At(i))) continue;
+                InvokeCallback(pimpl, sub, target, batch.At(i));
+            }
+        }
+
+        /**
+         * @brief [内部] 在当前线程 (派发线程或外部执行器) 上执行一次异步投递。
+         * @details 执行前重新验票 (Double Check) 并固定订阅者；合并订阅从信箱取执行时刻的最新值。
+         */
+        void DeliverQueued(PluginManagerPimpl* pimpl, EventId event_id, const PluginManagerPimpl::Subscription& sub,
+            const PluginPtr<Event>& e_ptr) {
+            PluginPtr<Event> latest;
+            if (sub.mailbox) {
+                latest = sub.mailbox->Take();
+                if (!latest) return;
+            }
+            if (!sub.ticket.Active(std::memory_order_acquire)) return;
+            // 固定订阅者：回调期间它不会被析构
+            std::shared_ptr<void> pinned = sub.subscriber_id.lock();
+            if (!pinned) return;
+            const uint64_t start_ns = MetricsNowNs();
+            InvokeSingle(pimpl, sub, pinned.get(), sub.mailbox ? *latest : *e_ptr);
+            RecordCallback(pimpl, sub, event_id, MetricsNowNs() - start_ns, false);
+        }
+
+        /** @brief [内部] `DeliverQueued` 的批量版本 (`FireGlobalBatch` 的非合并异步订阅者)。 */
+        void DeliverQueuedBatch(PluginManagerPimpl* pimpl, EventId event_id, const PluginManagerPimpl::Subscription& sub,
+            const EventBatchView& batch) {
+            if (!sub.ticket.Active(std::memory_order_acquire)) return;
+            std::shared_ptr<void> pinned = sub.subscriber_id.lock();
+            if (!pinned) return;
+            const uint64_t start_ns = MetricsNowNs();
+            InvokeBatch(pimpl, sub, pinned.get(), batch);
+            RecordCallback(pimpl, sub, event_id, MetricsNowNs() - start_ns, false);
+        }
+
+        /**
+         * @brief [内部] 把一次投递直接交给订阅者指定的执行器 (不经过框架派发线程)。
+         * @details 任务持有快照与事件；执行时若 PluginManager 已销毁则直接放弃。
+         * 执行器的 Post 抛出的异常按回调异常上报，不影响同一次 Fire 的其他订阅者。
+         */
+        void PostToExecutor(PluginManagerPimpl* pimpl, EventId event_id, const PluginManagerPimpl::SubListPtr& snapshot,
+            size_t index, const PluginPtr<Event>& e_ptr, const PluginPtr<Event>& batch_ptr = nullptr) {
+            const auto& sub = (*snapshot)[index];
+            try {
+                sub.executor->Post([pimpl, owner = pimpl->owner_, event_id, snapshot, index, e_ptr, batch_ptr]() {
+                    auto alive = owner.lock();
+                    if (!alive) return;
+                    const auto& target = (*snapshot)[index];
+                    if (batch_ptr && !target.mailbox) {
+                        DeliverQueuedBatch(pimpl, event_id, target, static_cast<const EventBatchView&>(*batch_ptr));
+                    } else {
+                        DeliverQueued(pimpl, event_id, target, e_ptr);
+                    }
+                    });
+            } catch (const std::exception& e) {
+                ReportException(pimpl, e);
+            } catch (...) {
+                ReportUnknownException(pimpl);
+            }
+        }
+
+        /**
+         * @brief [内部] 一次 Fire 中 kQueued 投递的批量收集器。
+         *
+         * @details
+         * 遍历快照时只记录订阅者在快照中的 *下标*，遍历结束后按 (派发线程, 优先级) 分组，
+         * 每组生成 **一个** EventTask。批任务持有快照 (SubListPtr) 本身，
+         * 因此既不需要逐个复制 `std::function`，也不会在执行时看到被修改的列表。
+         *
+         * 任务执行时逐个重新验票 (Double Check)，并为每个回调单独捕获异常，
+         * 一个订阅者抛出异常不会影响同批的其他订阅者。
+         * kQueuedCoalesced 订阅者不使用本次 Fire 的事件，而是从信箱取走执行时刻的最新值。
+         * 含有合并订阅者的任务不会因队列溢出被丢弃：信箱本身已经限制了它们的积压，
+         * 丢弃反而会让信箱永远处于“已排队”状态。
+         *
+         * `FireGlobalBatch` 时 `batch_ptr` 非空：非合并订阅者在同一个任务里收到整批事件，
+         * 合并订阅者照常从信箱取最新值 (即批中的最后一个事件)。
+         */
+        class QueuedBatch {
+        public:
+            void Add(size_t worker_index, EventPriority priority, uint32_t sub_index, bool coalesced) {
+                for (auto& group : groups_) {
+                    if (group.worker_index == worker_index && group.priority == priority) {
+                        group.indices.push_back(sub_index);
+                        group.has_coalesced |= coalesced;
+                        return;
+                    }
+                }
+                groups_.push_back({ worker_index, priority, std::vector<uint32_t>{ sub_index }, coalesced });
+            }
+
+            void Flush(PluginManagerPimpl* pimpl, EventId event_id,
+                const PluginManagerPimpl::SubListPtr& snapshot, const PluginPtr<Event>& e_ptr,
+                const PluginPtr<Event>& batch_ptr = nullptr) {
+                const bool droppable = pimpl->IsDroppableEvent(event_id);
+                for (auto& group : groups_) {
+                    PluginManagerPimpl::EventTask task;
+                    task.event_id = event_id;
+                    task.droppable = droppable && !group.has_coalesced;
+                    task.priority = group.priority;
+                    task.func = PooledTask([pimpl, event_id, snapshot, e_ptr, batch_ptr, indices = std::move(group.indices)]() {
+                        for (uint32_t index : indices) {
+                            const auto& sub = (*snapshot)[index];
+                            if (batch_ptr && !sub.mailbox) {
+                                DeliverQueuedBatch(pimpl, event_id, sub, static_cast<const EventBatchView&>(*batch_ptr));
+                            } else {
+                                DeliverQueued(pimpl, event_id, sub, e_ptr);
+                            }
+                        }
+                        }, pimpl->framework_resource_);
+                    pimpl->EnqueueTo(group.worker_index, std::move(task));
+                }
+            }
+
+        private:
+            struct Group {
+                size_t worker_index;
+                EventPriority priority;
+                std::vector<uint32_t> indices;
+                bool has_coalesced;
+            };
+            // 派发线程数通常很少，线性查找比哈希表更快
+            std::vector<Group> groups_;
+        };
+
+        /**
+         * @brief [内部] 通过发送者身份找到它的写侧记录。
+         * @details 走 `sender_keys_` 而不是重新计算地址：发送者销毁后地址已无法取得。
+         * 调用者必须持有 `subscriber_map_mutex_`。
+         */
+        PluginManagerPimpl::SenderMap::iterator FindSenderRecord(PluginManagerPimpl* pimpl,
+            const std::weak_ptr<void>& sender_id) {
+            auto key_it = pimpl->sender_keys_.find(sender_id);
+            if (key_it == pimpl->sender_keys_.end()) return pimpl->sender_subscribers_.end();
+            return pimpl->sender_subscribers_.find(key_it->second);
+        }
+
+        /**
+         * @brief [内部] 修改某发送者的记录后调用：剪掉空列表/空记录，并发布给读者。
+         * @details 调用者必须持有 `subscriber_map_mutex_`。
+         */
+        void CommitSenderRecord(PluginManagerPimpl* pimpl, PluginManagerPimpl::SenderMap::iterator rec_it) {
+            if (rec_it == pimpl->sender_subscribers_.end()) return;
+            auto& events = rec_it->second.events;
+            for (auto it = events.begin(); it != events.end();) {
+                if (!it->second || it->second->empty()) it = events.erase(it);
+                else ++it;
+            }
+            std::uintptr_t key = rec_it->first;
+            if (events.empty()) {
+                pimpl->sender_keys_.erase(rec_it->second.owner);
+                pimpl->sender_subscribers_.erase(rec_it);
+            }
+            pimpl->PublishSender(key);
+        }
+
+        /**
+         * @brief [内部] 遍历一份订阅快照并派发事件 (Global 与 Sender 共用)。
+         *
+         * @param e 事件引用。kDirect 订阅者直接使用它，可能位于发布者栈上。
+         * @param e_ptr 已物化的共享事件。为空时，首次遇到 kQueued 订阅者才调用
+         * `promote` 将事件拷贝到堆上 (惰性提升)；纯 kDirect 快照因此没有任何分配。
+         * @return 是否发现了需要 GC 的失效订阅。
+         */
+        bool DispatchSnapshot(PluginManagerPimpl* pimpl, EventId event_id,
+            const PluginManagerPimpl::SubListPtr& snapshot, const Event& e,
+            PluginPtr<Event> e_ptr, EventPromoter promote) {
+            bool needs_gc = false;
+            QueuedBatch batch;
+            const bool has_workers = !pimpl->dispatch_workers_.empty();
+
+            const auto& list = *snapshot;
+            for (size_t i = 0; i < list.size(); ++i) {
+                const auto& sub = list[i];
+                // 检查票据：如果已断开，跳过
+                if (!sub.ticket.Active(std::memory_order_acquire)) {
+                    needs_gc = true; continue;
+                }
+                // 过滤谓词：不匹配的事件不固定订阅者、不提升、不入队
+                if (sub.filter && !PassesFilter(pimpl, sub, e)) continue;
+                // 被看门狗降级的 kDirect 订阅走下面的派发线程分支 (它没有信箱与执行器)
+                if (sub.connection_type == ConnectionType::kDirect && !IsDemoted(pimpl, sub, has_workers)) {
+                    // 同步调用：一次 lock() 同时完成存活检查与固定，回调内部不再检查
+                    std::shared_ptr<void> pinned = sub.subscriber_id.lock();
+                    if (!pinned) {
+                        needs_gc = true; continue;
+                    }
+                    pimpl->Trace(EventTracePoint::kDirectCallStart, event_id, pinned.get(), 0, "DirectCall");
+                    const uint64_t start_ns = pimpl->time_direct_calls_ ? MetricsNowNs() : 0;
+                    InvokeSingle(pimpl, sub, pinned.get(), e);
+                    if (start_ns != 0) RecordCallback(pimpl, sub, event_id, MetricsNowNs() - start_ns, true);
+                    pimpl->Trace(EventTracePoint::kDirectCallEnd, event_id, pinned.get(), 0, "DirectCallEnd");
+                } else if (sub.subscriber_id.expired()) {
+                    needs_gc = true;
+                } else if (sub.executor) {
+                    // 指定了执行器：直接投递给它，不经过框架派发线程 (避免二次转投)
+                    if (!e_ptr) e_ptr = promote(e);
+                    if (sub.mailbox && !sub.mailbox->Post(e_ptr)) continue;
+                    pimpl->Trace(EventTracePoint::kQueuedEntry, event_id, reinterpret_cast<const void*>(sub.shard_key), 0, "ExecutorPost");
+                    PostToExecutor(pimpl, event_id, snapshot, i, e_ptr);
+                } else if (has_workers) {
+                    // 异步调用：事件要跨线程存活，此时才提升到堆上
+                    if (!e_ptr) e_ptr = promote(e);
+                    // 合并模式：已有待投递的任务时只替换负载，不再排队
+                    if (sub.mailbox && !sub.mailbox->Post(e_ptr)) continue;
+                    // 先收集，遍历结束后按派发线程批量投递
+                    const size_t worker_index = pimpl->WorkerIndexOf(sub.shard_key);
+                    batch.Add(worker_index, sub.priority, static_cast<uint32_t>(i), sub.mailbox != nullptr);
+
+                    pimpl->Trace(EventTracePoint::kQueuedEntry, event_id, reinterpret_cast<const void*>(sub.shard_key),
+                        QueueDepthOf(pimpl, worker_index), "QueuePush");
+                }
+            }
+
+            if (e_ptr) batch.Flush(pimpl, event_id, snapshot, e_ptr);
+            return needs_gc;
+        }
+
+        /**
+         * @brief [内部] 派发类型化通道自己的订阅列表 (只含 kDirect 订阅)。
+         * @details 与 `DispatchSnapshot` 的 kDirect 分支相同 (验票、固定、埋点、计时)，
+         * 但没有连接类型分支，也不需要惰性提升。
+         * @return 是否发现了需要 GC 的失效订阅。
+         */
+        bool DispatchChannel(PluginManagerPimpl* pimpl, EventId event_id,
+            const PluginManagerPimpl::SubList& list, const Event& e) {
+            bool needs_gc = false;
+            for (const auto& sub : list) {
+                if (!sub.ticket.Active(std::memory_order_acquire)) {
+                    needs_gc = true; continue;
+                }
+                std::shared_ptr<void> pinned = sub.subscriber_id.lock();
+                if (!pinned) {
+                    needs_gc = true; continue;
+                }
+                pimpl->Trace(EventTracePoint::kDirectCallStart, event_id, pinned.get(), 0, "ChannelCall");
+                const uint64_t start_ns = pimpl->time_direct_calls_ ? MetricsNowNs() : 0;
+                InvokeCallback(pimpl, sub, pinned.get(), e);
+                if (start_ns != 0) RecordCallback(pimpl, sub, event_id, MetricsNowNs() - start_ns, true);
+                pimpl->Trace(EventTracePoint::kDirectCallEnd, event_id, pinned.get(), 0, "ChannelCallEnd");
+            }
+            return needs_gc;
+        }
+
+        /**
+         * @brief [内部] `DispatchSnapshot` 的批量版本：整批事件共用一次遍历。
+         *
+         * @details
+         * - kDirect：订阅者只固定一次，然后依次处理整批 (批订阅者只回调一次)。
+         * - kQueued：整批只拷贝到堆上一次 (`batch.promote`)，每个 (派发线程, 优先级) 只入队一个任务。
+         * - kQueuedCoalesced：只把批中最后一个事件放进信箱，与逐个 Fire 的可观察结果一致。
+         * - 带过滤谓词的异步订阅：批中没有匹配的事件时不入队；执行时逐个元素再求值一次。
+         */
+        bool DispatchSnapshotBatch(PluginManagerPimpl* pimpl, EventId event_id,
+            const PluginManagerPimpl::SubListPtr& snapshot, const EventBatchView& batch) {
+            bool needs_gc = false;
+            QueuedBatch queued;
+            PluginPtr<Event> batch_ptr;  // 整批的堆拷贝 (惰性)
+            PluginPtr<Event> last_ptr;   // 最后一个事件的堆拷贝 (惰性，合并订阅者使用)
+            const bool has_workers = !pimpl->dispatch_workers_.empty();
+
+            const auto& list = *snapshot;
+            for (size_t i = 0; i < list.size(); ++i) {
+                const auto& sub = list[i];
+                if (!sub.ticket.Active(std::memory_order_acquire)) {
+                    needs_gc = true; continue;
+                }
+                if (sub.connection_type == ConnectionType::kDirect && !IsDemoted(pimpl, sub, has_workers)) {
+                    std::shared_ptr<void> pinned = sub.subscriber_id.lock();
+                    if (!pinned) {
+                        needs_gc = true; continue;
+                    }
+                    pimpl->Trace(EventTracePoint::kDirectCallStart, event_id, pinned.get(), 0, "DirectCall");
+                    const uint64_t start_ns = pimpl->time_direct_calls_ ? MetricsNowNs() : 0;
+                    InvokeBatch(pimpl, sub, pinned.get(), batch);
+                    if (start_ns != 0) RecordCallback(pimpl, sub, event_id, MetricsNowNs() - start_ns, true);
+                    pimpl->Trace(EventTracePoint::kDirectCallEnd, event_id, pinned.get(), 0, "DirectCallEnd");
+                    continue;
+                }
+                if (sub.subscriber_id.expired()) {
+                    needs_gc = true; continue;
+                }
+                if (!sub.executor && !has_workers) continue;
+                // 过滤谓词：整批都不匹配时不入队；合并订阅者取最后一个匹配的事件
+                size_t last_match = batch.size() - 1;
+                if (sub.filter) {
+                    bool matched = false;
+                    for (size_t k = batch.size(); k-- > 0;) {
+                        if (PassesFilter(pimpl, sub, batch.At(k))) {
+                            last_match = k; matched = true; break;
+                        }
+                    }
+                    if (!matched) continue;
+                }
+                if (sub.mailbox) {
+                    if (last_match != batch.size() - 1) {
+                        if (!sub.mailbox->Post(batch.promote_element(batch.At(last_match)))) continue;
+                    } else {
+                        if (!last_ptr) last_ptr = batch.promote_element(batch.At(last_match));
+                        if (!sub.mailbox->Post(last_ptr)) continue;
+                    }
+                } else if (!batch_ptr) {
+                    batch_ptr = batch.promote(batch);
+                }
+                if (sub.executor) {
+                    pimpl->Trace(EventTracePoint::kQueuedEntry, event_id, reinterpret_cast<const void*>(sub.shard_key), 0, "ExecutorPost");
+                    PostToExecutor(pimpl, event_id, snapshot, i, last_ptr, batch_ptr);
+                } else {
+                    const size_t worker_index = pimpl->WorkerIndexOf(sub.shard_key);
+                    queued.Add(worker_index, sub.priority, static_cast<uint32_t>(i), sub.mailbox != nullptr);
+                    pimpl->Trace(EventTracePoint::kQueuedEntry, event_id, reinterpret_cast<const void*>(sub.shard_key),
+                        QueueDepthOf(pimpl, worker_index), "QueuePush");
+                }
+            }
+
+            queued.Flush(pimpl, event_id, snapshot, last_ptr, batch_ptr);
+            return needs_gc;
+        }
+
+        /** @brief [内部] 查找保留事件的最新值。`sender_id` 为空表示全局。 */
+        PluginPtr<Event> LookupRetained(PluginManagerPimpl* pimpl, EventId event_id, const std::weak_ptr<void>& sender_id) {
+            std::lock_guard<std::mutex> lock(pimpl->retained_mutex_);
+            if (PluginManagerPimpl::SameOwner(sender_id, std::weak_ptr<void>())) {
+                auto it = pimpl->retained_global_.find(event_id);
+                return it != pimpl->retained_global_.end() ? it->second : nullptr;
+            }
+            auto sender_it = pimpl->retained_sender_.find(sender_id);
+            if (sender_it == pimpl->retained_sender_.end() || sender_it->first.expired()) return nullptr;
+            auto it = sender_it->second.find(event_id);
+            return it != sender_it->second.end() ? it->second : nullptr;
+        }
+
+        /**
+         * @brief [内部] 把保留事件只投递给刚加入的那一个订阅。
+         * @details 用只含该订阅副本的快照走普通派发路径，连接类型、执行器、合并信箱与验票规则都与 Fire 一致。
+         * 必须在释放 subscriber_map_mutex_ 之后调用：kDirect 回调可能再次订阅。
+         */
+        void DeliverRetained(PluginManagerPimpl* pimpl, EventId event_id,
+            const PluginManagerPimpl::SubListPtr& target, PluginPtr<Event> e_ptr) {
+            const Event& e = *e_ptr;
+            DispatchSnapshot(pimpl, event_id, target, e, std::move(e_ptr), nullptr);
+        }
+    }  // namespace
+
     // =========================================================================
     // GC (垃圾回收) 机制
     // =========================================================================
 
+    namespace {
+        /**
+         * @brief [内部] 剔除列表中已失效 / 已断开的订阅。有垃圾时返回新列表，否则返回 nullptr。
+         * @param[out] removed 追加被剔除订阅的订阅者 ID (用于清理反查表)。
+         */
+        PluginManagerPimpl::SubListPtr CompactSubList(const PluginManagerPimpl* pimpl,
+            const PluginManagerPimpl::SubListPtr& current_ptr, std::vector<std::weak_ptr<void>>& removed) {
+            if (!current_ptr) return nullptr;
+            auto is_garbage = [](const PluginManagerPimpl::Subscription& sub) {
+                return sub.subscriber_id.expired() || !sub.ticket.Active(std::memory_order_relaxed);
+            };
+            // 先扫描：没有垃圾时不做任何分配
+            auto first = std::find_if(current_ptr->begin(), current_ptr->end(), is_garbage);
+            if (first == current_ptr->end()) return nullptr;
+
+            auto new_list = pimpl->NewSubList();
+            new_list->reserve(current_ptr->size() - 1);
+            new_list->insert(new_list->end(), current_ptr->begin(), first);
+            for (auto it = first; it != current_ptr->end(); ++it) {
+                if (is_garbage(*it)) removed.push_back(it->subscriber_id);
+                else new_list->push_back(*it);
+            }
+            return new_list;
+        }
+
+        /** @brief [内部] 列表中是否还有该订阅者的其他订阅。 */
+        bool ListHasSubscriber(const PluginManagerPimpl::SubListPtr& list, const std::weak_ptr<void>& sub) {
+            if (!list) return false;
+            return std::any_of(list->begin(), list->end(), [&sub](const PluginManagerPimpl::Subscription& s) {
+                return PluginManagerPimpl::SameOwner(s.subscriber_id, sub);
+                });
+        }
+
+        /**
+         * @brief [内部] 订阅被 GC 剔除后，同步清理全局 (或事件族) 反查表。调用者持有 `subscriber_map_mutex_`。
+         * @details 断开连接时不再同步修改反查表，否则反查表会随短命订阅者无限增长。
+         */
+        void PruneGlobalLookup(PluginManagerPimpl::SubscriberLookupMapG& lookup, EventId event_id,
+            const PluginManagerPimpl::SubListPtr& remaining, const std::vector<std::weak_ptr<void>>& removed) {
+            for (const auto& sub : removed) {
+                if (ListHasSubscriber(remaining, sub)) continue;
+                lookup.Erase(sub, event_id);
+            }
+        }
+
+        /**
+         * @brief [内部] 压缩与 `id` 相关的事件族订阅列表，并重新发布受影响的事件。
+         * @param id 事件 ID (检查它所属的各级事件族) 或事件族 ID 本身 (来自断开连接)。
+         * @return 是否清理了垃圾。调用者持有 `subscriber_map_mutex_`。
+         */
+        bool CompactFamilies(PluginManagerPimpl* pimpl, EventId id, std::vector<std::weak_ptr<void>>& removed) {
+            std::vector<EventId> family_ids = EventFamiliesOf(id);
+            family_ids.push_back(id);
+            bool compacted_any = false;
+            for (EventId family_id : family_ids) {
+                auto it = pimpl->family_subscribers_.find(family_id);
+                if (it == pimpl->family_subscribers_.end()) continue;
+                removed.clear();
+                auto compacted = CompactSubList(pimpl, it->second, removed);
+                if (!compacted) continue;
+                it->second = std::move(compacted);
+                PruneGlobalLookup(pimpl->family_sub_lookup_, family_id, it->second, removed);
+                if (it->second->empty()) pimpl->family_subscribers_.erase(it);
+                pimpl->PublishFamily(family_id);
+                compacted_any = true;
+            }
+            return compacted_any;
+        }
+
+        /** @brief [内部] 同 PruneGlobalLookup，针对特定发送者反查表。 */
+        void PruneSenderLookup(PluginManagerPimpl* pimpl, const std::weak_ptr<void>& sender, EventId event_id,
+            const PluginManagerPimpl::SubListPtr& remaining, const std::vector<std::weak_ptr<void>>& removed) {
+            for (const auto& sub : removed) {
+                if (ListHasSubscriber(remaining, sub)) continue;
+                pimpl->sender_sub_lookup_.Erase(sub, { sender, event_id });
+            }
+        }
+
+        /**
+         * @brief [内部] 回收一个已销毁发送者的记录：剪掉反查表，清空订阅并发布。
+         * @details 调用者必须持有 `subscriber_map_mutex_`。rec_it 此后失效。
+         */
+        void ReclaimExpiredSender(PluginManagerPimpl* pimpl, PluginManagerPimpl::SenderMap::iterator rec_it,
+            std::vector<std::weak_ptr<void>>& removed) {
+            const std::weak_ptr<void>& owner = rec_it->second.owner;
+            for (const auto& entry : rec_it->second.events) {
+                if (!entry.second) continue;
+                removed.clear();
+                for (const auto& sub : *entry.second) removed.push_back(sub.subscriber_id);
+                PruneSenderLookup(pimpl, owner, entry.first, nullptr, removed);
+            }
+            rec_it->second.events.clear();
+            CommitSenderRecord(pimpl, rec_it);
+        }
+
+        /**
+         * @brief [内部] 回收所有已销毁发送者的记录 (订阅新发送者、表规模翻倍时调用)。
+         * @details 发送者销毁后，如果订阅者既不退订也不再向同一地址发布，记录不会被任何路径碰到；
+         * 按规模翻倍批量清理，使表的大小与存活发送者数成正比，均摊到每次新增记录为 O(1)。
+         * 调用者必须持有 `subscriber_map_mutex_`。
+         */
+        void SweepExpiredSenders(PluginManagerPimpl* pimpl) {
+            std::vector<std::uintptr_t> expired;
+            for (const auto& [key, record] : pimpl->sender_subscribers_) {
+                if (record.owner.expired()) expired.push_back(key);
+            }
+            std::vector<std::weak_ptr<void>> removed;
+            for (std::uintptr_t key : expired) {
+                ReclaimExpiredSender(pimpl, pimpl->sender_subscribers_.find(key), removed);
+            }
+            pimpl->sender_prune_at_ = std::max<size_t>(64, pimpl->sender_subscribers_.size() * 2);
+        }
+    }  // namespace
+
     /**
      * @brief 调度垃圾回收。
-     * @details 将一个“执行 GC”的任务放入事件队列，让工作线程稍后处理。
+     * @details 只把事件 ID 记入待回收集合；所有待回收项由 *一个* GC 批处理任务统一清理。
      */
     void PluginManager::ScheduleGC(EventId event_id) {
-        {
-            std::lock_guard<std::mutex> lock(pimpl_->gc_status_mutex_);
-            if (pimpl_->pending_gc_events_.count(event_id)) return; // 已经在排队了
-            pimpl_->pending_gc_events_.insert(event_id);
-        }
+        std::lock_guard<std::mutex> lock(pimpl_->gc_status_mutex_);
+        if (!pimpl_->pending_gc_events_.insert(event_id).second) return; // 已经在排队了
+        ScheduleGCPassLocked();
+    }
+
+    /**
+     * @brief 调度特定发送者订阅表的垃圾回收。
+     * @details 与 ScheduleGC 共用同一个 GC 批处理任务。
+     */
+    void PluginManager::ScheduleSenderGC(std::uintptr_t sender_key) {
+        std::lock_guard<std::mutex> lock(pimpl_->gc_status_mutex_);
+        if (!pimpl_->pending_sender_gc_.insert(sender_key).second) return; // 已经在排队了
+        ScheduleGCPassLocked();
+    }
+
+    /**
+     * @brief 确保有一个 GC 批处理任务在队列中 (调用者持有 gc_status_mutex_)。
+     */
+    void PluginManager::ScheduleGCPassLocked() {
+        if (pimpl_->gc_pass_scheduled_) return;
+        pimpl_->gc_pass_scheduled_ = true;
 
-        // 构造任务
         PluginManagerPimpl::EventTask task;
-        task.event_id = event_id; // 标记这是针对哪个事件的 GC
-        task.func = [this, event_id]() {
-            this->PerformGC(event_id);
+        task.droppable = false;   // 丢弃 GC 任务会让 pending 标记永远无法清除
+        task.priority = EventPriority::kBackground; // 内务任务不应挤占事件回调
+        task.func = [this]() {
+            this->PerformGCPass();
             };
-
-        {
-            std::lock_guard<std::mutex> lock(pimpl_->queue_mutex_);
-            pimpl_->event_queue_.push(std::move(task));
-        }
-        pimpl_->queue_cv_.notify_one();
+        pimpl_->Enqueue(0, std::move(task));
     }
 
     /**
-     * @brief 执行垃圾回收 (在工作线程运行)。
-     * @details 遍历订阅列表，剔除无效项，生成新列表替换旧列表 (COW)。
+     * @brief 执行一轮 GC 批处理 (在工作线程运行)。
+     * @details
+     * 一次持锁清理所有待回收的事件与发送者，而不是每个事件 ID 各排一个任务、各加一次锁。
+     * 每轮最多运行 `gc_pass_budget_` (至少处理一项)；做不完的留给下一轮，
+     * 从而不会长时间独占 `subscriber_map_mutex_`，也不会长时间占住派发线程。
      */
-    void PluginManager::PerformGC(EventId event_id) {
+    void PluginManager::PerformGCPass() {
+        std::vector<EventId> events;
+        std::vector<std::uintptr_t> senders;
         {
             std::lock_guard<std::mutex> lock(pimpl_->gc_status_mutex_);
-            pimpl_->pending_gc_events_.erase(event_id);
+            pimpl_->gc_pass_scheduled_ = false;
+            events.assign(pimpl_->pending_gc_events_.begin(), pimpl_->pending_gc_events_.end());
+            senders.assign(pimpl_->pending_sender_gc_.begin(), pimpl_->pending_sender_gc_.end());
+            pimpl_->pending_gc_events_.clear();
+            pimpl_->pending_sender_gc_.clear();
         }
+        if (events.empty() && senders.empty()) return;
 
-        std::lock_guard<std::mutex> lock(pimpl_->subscriber_map_mutex_);
-        auto it = pimpl_->global_subscribers_.find(event_id);
-        if (it == pimpl_->global_subscribers_.end() || !it->second) return;
-
-        auto& current_ptr = it->second;
-        // 创建新列表，准备搬运有效数据
-        auto new_list = std::make_shared<PluginManagerPimpl::SubList>();
-        new_list->reserve(current_ptr->size());
+        const auto deadline = std::chrono::steady_clock::now() + pimpl_->gc_pass_budget_;
+        size_t processed = 0;
+        auto within_budget = [&processed, &deadline]() {
+            return processed == 0 || std::chrono::steady_clock::now() < deadline;
+        };
 
+        size_t event_index = 0;
+        size_t sender_index = 0;
         bool garbage_found = false;
-        for (const auto& sub : *current_ptr) {
-            bool is_dead = sub.subscriber_id.expired();
-            bool is_disconnected = (sub.active_token && !sub.active_token->load(std::memory_order_relaxed));
+        std::vector<std::weak_ptr<void>> removed;
+        {
+            std::lock_guard lock(pimpl_->subscriber_map_mutex_);
 
-            if (!is_dead && !is_disconnected) {
-                new_list->push_back(sub); // 有效，搬运
-            } else {
-                garbage_found = true; // 发现垃圾
+            for (; event_index < events.size() && within_budget(); ++event_index, ++processed) {
+                const EventId event_id = events[event_index];
+                auto it = pimpl_->global_subscribers_.find(event_id);
+                if (it != pimpl_->global_subscribers_.end()) {
+                    removed.clear();
+                    if (auto compacted = CompactSubList(pimpl_.get(), it->second, removed)) {
+                        it->second = std::move(compacted); // 替换写侧数据
+                        PruneGlobalLookup(pimpl_->global_sub_lookup_, event_id, it->second, removed);
+                        if (it->second->empty()) {
+                            pimpl_->global_subscribers_.erase(it);
+                        }
+                        pimpl_->PublishGlobal(event_id); // 发布给读者，旧版本延迟回收
+                        garbage_found = true;
+                    }
+                }
+                auto channel_it = pimpl_->channel_subscribers_.find(event_id);
+                if (channel_it != pimpl_->channel_subscribers_.end()) {
+                    removed.clear();
+                    if (auto compacted = CompactSubList(pimpl_.get(), channel_it->second, removed)) {
+                        channel_it->second = std::move(compacted);
+                        PruneGlobalLookup(pimpl_->channel_sub_lookup_, event_id, channel_it->second, removed);
+                        if (channel_it->second->empty()) {
+                            pimpl_->channel_subscribers_.erase(channel_it);
+                        }
+                        pimpl_->PublishGlobal(event_id);
+                        garbage_found = true;
+                    }
+                }
+                // 发布的列表里还合并了事件族订阅，它们的垃圾记在各自的事件族上
+                if (!pimpl_->family_subscribers_.empty() && CompactFamilies(pimpl_.get(), event_id, removed)) {
+                    garbage_found = true;
+                }
+            }
+
+            for (; sender_index < senders.size() && within_budget(); ++sender_index, ++processed) {
+                auto rec_it = pimpl_->sender_subscribers_.find(senders[sender_index]);
+                if (rec_it == pimpl_->sender_subscribers_.end()) continue;
+
+                bool sender_dirty = false;
+                const std::weak_ptr<void>& owner = rec_it->second.owner;
+                if (owner.expired()) {
+                    // 发送者已销毁：它的订阅永远不会再触发
+                    ReclaimExpiredSender(pimpl_.get(), rec_it, removed);
+                    garbage_found = true;
+                } else {
+                    for (auto& entry : rec_it->second.events) {
+                        removed.clear();
+                        if (auto compacted = CompactSubList(pimpl_.get(), entry.second, removed)) {
+                            entry.second = std::move(compacted);
+                            PruneSenderLookup(pimpl_.get(), owner, entry.first, entry.second, removed);
+                            sender_dirty = true;
+                        }
+                    }
+                }
+                if (sender_dirty) {
+                    CommitSenderRecord(pimpl_.get(), rec_it);
+                    garbage_found = true;
+                }
+            }
+
+            if (!garbage_found) {
+                pimpl_->rcu_.TryAdvance(); // 顺便推进 RCU，回收此前退役的旧版本
             }
         }
 
-        if (garbage_found) {
-            current_ptr = new_list; // 原子替换
+        // 预算用完：把剩余项放回待回收集合，排下一轮
+        if (event_index < events.size() || sender_index < senders.size()) {
+            std::lock_guard<std::mutex> lock(pimpl_->gc_status_mutex_);
+            pimpl_->pending_gc_events_.insert(events.begin() + event_index, events.end());
+            pimpl_->pending_sender_gc_.insert(senders.begin() + sender_index, senders.end());
+            ScheduleGCPassLocked();
         }
     }
 
@@ -106,31 +904,230 @@ namespace z3y {
     // =========================================================================
 
     /**
-     * @brief 异步事件处理循环。
+     * @brief 启动派发线程池。
+     * @details
+     * vector 先定长，线程运行期间不会再扩容。每个线程先按 `thread_role::kEventDispatch` 放置自己，
+     * 再在本线程上构造自己的 Worker (队列的环形区)：配置了 NUMA 节点时，队列内存按首次写入落在该节点上。
+     * 所有 Worker 就绪后才返回；任何一个构造失败，已启动的线程全部退出并重新抛出异常。
      */
-    void PluginManager::EventLoop() {
-        while (true) {
+    void PluginManager::StartEventWorkers(size_t worker_count, size_t queue_capacity) {
+        if (worker_count == 0) {
+            worker_count = std::max<size_t>(1, std::thread::hardware_concurrency());
+        }
+        pimpl_->dispatch_workers_.clear();
+        pimpl_->dispatch_workers_.resize(worker_count);
+        const ThreadPlacement* placement = FindThreadPlacement(thread_role::kEventDispatch);
+
+        std::vector<std::promise<void>> ready(worker_count);
+        std::vector<std::future<void>> ready_futures;
+        std::vector<std::thread> threads;
+        ready_futures.reserve(worker_count);
+        threads.reserve(worker_count);
+        for (size_t i = 0; i < worker_count; ++i) {
+            ready_futures.push_back(ready[i].get_future());
+            threads.emplace_back([this, i, queue_capacity, placement, &ready]() {
+                if (placement) (void)ApplyThreadPlacement(*placement, i);
+                BindCurrentThread(pimpl_->InternalThreadBinding());
+                try {
+                    pimpl_->dispatch_workers_[i] = std::make_unique<PluginManagerPimpl::DispatchWorker>(queue_capacity);
+                } catch (...) {
+                    ready[i].set_exception(std::current_exception());
+                    return;
+                }
+                ready[i].set_value();
+                EventLoop(i);
+                });
+        }
+
+        std::exception_ptr failure;
+        for (auto& future : ready_futures) {
+            try { future.get(); } catch (...) { failure = std::current_exception(); }
+        }
+        if (failure) {
+            for (size_t i = 0; i < worker_count; ++i) {
+                if (auto& worker = pimpl_->dispatch_workers_[i]) {
+                    worker->running.store(false, std::memory_order_release);
+                    worker->wakeup.NotifyAll();
+                }
+                threads[i].join();
+            }
+            pimpl_->dispatch_workers_.clear();
+            std::rethrow_exception(failure);
+        }
+        for (size_t i = 0; i < worker_count; ++i) {
+            pimpl_->dispatch_workers_[i]->thread = std::move(threads[i]);
+        }
+    }
+
+    /**
+     * @brief 停止派发线程池。
+     * @details 每个线程都会先把自己队列中剩余的任务执行完再退出。
+     */
+    void PluginManager::StopEventWorkers() {
+        for (auto& worker : pimpl_->dispatch_workers_) {
+            worker->running.store(false, std::memory_order_release);
+            worker->wakeup.NotifyAll();
+            worker->space.NotifyAll();
+        }
+        for (auto& worker : pimpl_->dispatch_workers_) {
+            if (worker->thread.joinable()) {
+                worker->thread.join();
+            }
+        }
+    }
+
+    /**
+     * @brief 排空派发线程。
+     * @details 向每个线程的最低优先级通道投递一个屏障任务：屏障被执行时，
+     * 该线程所有通道中先于它入队的任务都已执行完毕。不能在派发线程上调用。
+     */
+    void PluginManager::DrainEventWorkers() {
+        std::vector<std::future<void>> barriers;
+        barriers.reserve(pimpl_->dispatch_workers_.size());
+        for (size_t i = 0; i < pimpl_->dispatch_workers_.size(); ++i) {
+            auto done = std::make_shared<std::promise<void>>();
+            barriers.push_back(done->get_future());
             PluginManagerPimpl::EventTask task;
-            {
-                // 等待任务
-                std::unique_lock<std::mutex> lock(pimpl_->queue_mutex_);
-                pimpl_->queue_cv_.wait(lock, [this] {
-                    return !pimpl_->event_queue_.empty() || !pimpl_->running_;
-                    });
+            task.func = [done]() { done->set_value(); };
+            task.droppable = false;
+            task.priority = EventPriority::kBackground;
+            pimpl_->EnqueueTo(i, std::move(task));
+        }
+        for (auto& barrier : barriers) barrier.wait();
+    }
+
+    size_t PluginManager::GetEventDispatchThreadCount() const {
+        return pimpl_->dispatch_workers_.size();
+    }
+
+    size_t PluginManager::GetEventQueueDropCount() const {
+        return pimpl_->queue_dropped_count_.load(std::memory_order_relaxed);
+    }
+
+    namespace {
+        /** @brief [内部] 把一份订阅列表的统计追加到 out。 */
+        void CollectSubscriberMetrics(const PluginManagerPimpl::SubListPtr& list, EventId event_id,
+            std::vector<SubscriberDispatchMetrics>& out) {
+            if (!list) return;
+            for (const auto& sub : *list) {
+                if (sub.subscriber_id.expired()) continue;
+                if (!sub.ticket.Active(std::memory_order_relaxed)) continue;
+                SubscriberDispatchMetrics m;
+                m.subscriber = sub.shard_key;
+                m.event_id = event_id;
+                m.connection_type = sub.connection_type;
+                sub.stats->callback_time.AddTo(m.callback_time);
+                m.exceptions = sub.stats->exceptions.load(std::memory_order_relaxed);
+                m.subscriber_clsid = sub.callback.SubscriberClassId();
+                m.average_ns = sub.stats->average_ns.load(std::memory_order_relaxed);
+                m.max_ns = sub.stats->max_ns.load(std::memory_order_relaxed);
+                m.slow_calls = sub.stats->slow_calls.load(std::memory_order_relaxed);
+                m.demoted = sub.stats->demoted.load(std::memory_order_relaxed);
+                out.push_back(std::move(m));
+            }
+        }
+    }  // namespace
+
+    EventDispatchMetrics PluginManager::GetEventDispatchMetrics() const {
+        EventDispatchMetrics metrics;
+        for (const auto& worker : pimpl_->dispatch_workers_) {
+            const size_t depth = worker->pending.load(std::memory_order_relaxed);
+            metrics.queue_depth += depth;
+            metrics.worker_queue_depth.push_back(depth);
+            metrics.queue_high_water = std::max(metrics.queue_high_water, worker->high_water.load(std::memory_order_relaxed));
+            worker->latency.AddTo(metrics.queue_latency);
+        }
+        metrics.dropped_tasks = pimpl_->queue_dropped_count_.load(std::memory_order_relaxed);
+        metrics.exceptions = pimpl_->exception_count_.load(std::memory_order_relaxed);
+        metrics.unknown_exceptions = pimpl_->unknown_exception_count_.load(std::memory_order_relaxed);
+
+        std::lock_guard lock(pimpl_->subscriber_map_mutex_);
+        for (const auto& entry : pimpl_->global_subscribers_) {
+            CollectSubscriberMetrics(entry.second, entry.first, metrics.subscribers);
+        }
+        for (const auto& entry : pimpl_->family_subscribers_) {
+            CollectSubscriberMetrics(entry.second, entry.first, metrics.subscribers);
+        }
+        for (const auto& entry : pimpl_->channel_subscribers_) {
+            CollectSubscriberMetrics(entry.second, entry.first, metrics.subscribers);
+        }
+        for (const auto& record : pimpl_->sender_subscribers_) {
+            for (const auto& entry : record.second.events) {
+                CollectSubscriberMetrics(entry.second, entry.first, metrics.subscribers);
+            }
+        }
+        return metrics;
+    }
 
-                if (!pimpl_->running_ && pimpl_->event_queue_.empty()) return; // 退出
+    void PluginManager::ResetEventDispatchMetrics() {
+        for (const auto& worker : pimpl_->dispatch_workers_) {
+            worker->high_water.store(worker->pending.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            worker->latency.Reset();
+        }
+        pimpl_->exception_count_.store(0, std::memory_order_relaxed);
+        pimpl_->unknown_exception_count_.store(0, std::memory_order_relaxed);
 
-                if (!pimpl_->event_queue_.empty()) {
-                    task = std::move(pimpl_->event_queue_.front());
-                    pimpl_->event_queue_.pop();
+        std::lock_guard lock(pimpl_->subscriber_map_mutex_);
+        auto reset = [](const PluginManagerPimpl::SubListPtr& list) {
+            if (!list) return;
+            for (const auto& sub : *list) {
+                sub.stats->callback_time.Reset();
+                sub.stats->exceptions.store(0, std::memory_order_relaxed);
+                sub.stats->average_ns.store(0, std::memory_order_relaxed);
+                sub.stats->max_ns.store(0, std::memory_order_relaxed);
+                sub.stats->slow_calls.store(0, std::memory_order_relaxed);
+            }
+        };
+        for (const auto& entry : pimpl_->global_subscribers_) reset(entry.second);
+        for (const auto& entry : pimpl_->family_subscribers_) reset(entry.second);
+        for (const auto& entry : pimpl_->channel_subscribers_) reset(entry.second);
+        for (const auto& record : pimpl_->sender_subscribers_) {
+            for (const auto& entry : record.second.events) reset(entry.second);
+        }
+    }
+
+    /**
+     * @brief 异步事件处理循环 (每个派发线程一份)。
+     * @param worker_index 本线程在 `dispatch_workers_` 中的下标。
+     */
+    void PluginManager::EventLoop(size_t worker_index) {
+        PluginManagerPimpl::DispatchWorker& worker = *pimpl_->dispatch_workers_[worker_index];
+        PluginManagerPimpl::IsDispatchThread() = true;
+        // 本线程的直方图指针缓存：只有第一次见到某个 EventId 时才访问分片的锁
+        std::unordered_map<EventId, LatencyCells*> latency_cache;
+        while (true) {
+            PluginManagerPimpl::EventTask task;
+            if (!worker.TryPop(task)) {
+                // 队列空：按 EventCount 协议“声明 -> 复查 -> 睡眠”，避免丢失唤醒
+                uint64_t key = worker.wakeup.PrepareWait();
+                if (worker.TryPop(task)) {
+                    worker.wakeup.CancelWait();
+                } else if (!worker.running.load(std::memory_order_acquire)) {
+                    worker.wakeup.CancelWait();
+                    return; // 退出 (队列已排空)
+                } else {
+                    worker.wakeup.Wait(key);
+                    continue;
                 }
             }
 
+            // 已被 kDropOldest 丢弃的墓碑：积压名额在丢弃时已经归还
+            if (!task.Claim()) continue;
+
+            // 腾出一个积压名额：唤醒 kBlock 策略下等待的发布者 (无人等待时只是一次原子读)
+            worker.pending.fetch_sub(1, std::memory_order_relaxed);
+            if (pimpl_->queue_max_pending_ != 0) worker.space.Notify();
+
             if (task.func) {
+                LatencyCells*& latency = latency_cache[task.event_id];
+                if (!latency) latency = &worker.latency.For(task.event_id);
+                const uint64_t wait_ns = MetricsNowNs() - task.enqueue_ns;
+                latency->Record(wait_ns);
+                PluginManagerPimpl::CurrentTaskWaitNs() = wait_ns;
+
                 // [Trace] 埋点：开始执行异步任务
-                if (pimpl_->event_trace_hook_) {
-                    pimpl_->event_trace_hook_(EventTracePoint::kQueuedExecuteStart, task.event_id, nullptr, "AsyncExecStart");
-                }
+                pimpl_->Trace(EventTracePoint::kQueuedExecuteStart, task.event_id, nullptr,
+                    static_cast<uint32_t>(worker.pending.load(std::memory_order_relaxed)), "AsyncExecStart");
 
                 try {
                     task.func(); // 执行任务
@@ -141,9 +1138,9 @@ namespace z3y {
                 }
 
                 // [Trace] 埋点：结束执行
-                if (pimpl_->event_trace_hook_) {
-                    pimpl_->event_trace_hook_(EventTracePoint::kQueuedExecuteEnd, task.event_id, nullptr, "AsyncExecEnd");
-                }
+                pimpl_->Trace(EventTracePoint::kQueuedExecuteEnd, task.event_id, nullptr,
+                    static_cast<uint32_t>(worker.pending.load(std::memory_order_relaxed)), "AsyncExecEnd");
+                PluginManagerPimpl::CurrentTaskWaitNs() = 0;
             }
         }
     }
@@ -157,35 +1154,190 @@ namespace z3y {
      */
     Connection PluginManager::SubscribeGlobalImpl(
         EventId event_id, std::weak_ptr<void> sub,
-        std::function<void(const Event&)> cb, ConnectionType type) {
+        EventDelegate cb, ConnectionType type, EventPriority priority,
+        std::shared_ptr<IEventExecutor> executor, EventFilter filter) {
+
+        // 1. 取一个票据槽 (票据默认有效)
+        ConnectionTicket ticket = pimpl_->NewTicket(sub, event_id, std::weak_ptr<void>());
+        PluginPtr<Event> retained;
+        PluginManagerPimpl::SubListPtr retained_target;
+        {
+            std::lock_guard lock(pimpl_->subscriber_map_mutex_);
+            auto& current_ptr = pimpl_->global_subscribers_[event_id];
 
-        // 1. 创建原子票据 (默认为 true)
-        auto ticket = std::make_shared<std::atomic<bool>>(true);
+            // 2. 将订阅加入列表 (COW 逻辑)
+            // 读者在 RCU 临界区内不持有引用计数，因此不能再用 use_count() 判断"没人在读"，
+            // 一律复制一份新的修改。
+            auto new_list = current_ptr
+                ? pimpl_->NewSubList(*current_ptr)
+                : pimpl_->NewSubList();
+            new_list->emplace_back(sub, std::weak_ptr<void>(), std::move(cb), type, ticket, priority, std::move(executor),
+                std::move(filter));
+            current_ptr = new_list;
+            pimpl_->PublishGlobal(event_id);
 
-        std::lock_guard<std::mutex> lock(pimpl_->subscriber_map_mutex_);
-        auto& current_ptr = pimpl_->global_subscribers_[event_id];
+            // 3. 记录反查表
+            pimpl_->global_sub_lookup_.Insert(sub, event_id);
 
-        // 2. 将订阅加入列表 (COW 逻辑)
-        if (current_ptr && current_ptr.use_count() == 1) {
-            // 优化：如果当前列表只有我在用（没人在遍历），直接修改
-            auto& list = const_cast<PluginManagerPimpl::SubList&>(*current_ptr);
-            list.emplace_back(sub, std::weak_ptr<void>(), std::move(cb), type, ticket);
-        } else {
-            // 标准 COW：有人在读，复制一份新的修改
+            // 保留事件：订阅已发布之后再取最新值，此后的 Fire 一定能看到这个订阅
+            retained = LookupRetained(pimpl_.get(), event_id, std::weak_ptr<void>());
+            if (retained) retained_target = std::make_shared<PluginManagerPimpl::SubList>(1, new_list->back());
+        }
+        if (retained) DeliverRetained(pimpl_.get(), event_id, retained_target, std::move(retained));
+
+        // 4. 返回 Connection
+        return Connection(ticket.Share());
+    }
+
+    /**
+     * @brief 声明式处理函数表的批量订阅。
+     * @details 与逐条 `SubscribeGlobalImpl` 的结果相同 (含保留事件的补发)，但表已按 EventId 排序：
+     * 同一事件的条目一起追加，每个 EventId 只复制、发布一次订阅列表，全程只加一次锁。
+     * 不返回 Connection：订阅随实例释放失效，由 GC 回收。
+     */
+    void SubscribeEventHandlers(PluginManagerPimpl* pimpl, const PluginPtr<IComponent>& instance,
+        const std::vector<EventHandlerEntry>& handlers) {
+        if (handlers.empty()) return;
+        const std::shared_ptr<void> subscriber = handlers.front().subscriber(instance);
+        if (!subscriber) return;
+        const std::weak_ptr<void> sub = subscriber;
+
+        std::vector<ConnectionTicket> tickets;
+        tickets.reserve(handlers.size());
+        for (const auto& handler : handlers) tickets.push_back(pimpl->NewTicket(sub, handler.event_id, std::weak_ptr<void>()));
+
+        std::vector<std::pair<EventId, PluginManagerPimpl::SubListPtr>> retained_targets;
+        std::vector<PluginPtr<Event>> retained_events;
+        {
+            std::lock_guard lock(pimpl->subscriber_map_mutex_);
+            for (size_t first = 0; first < handlers.size();) {
+                const EventId event_id = handlers[first].event_id;
+                size_t last = first;
+                while (last < handlers.size() && handlers[last].event_id == event_id) ++last;
+
+                auto& current_ptr = pimpl->global_subscribers_[event_id];
+                auto new_list = current_ptr ? pimpl->NewSubList(*current_ptr) : pimpl->NewSubList();
+                new_list->reserve(new_list->size() + (last - first));
+                for (size_t i = first; i < last; ++i) {
+                    new_list->emplace_back(sub, std::weak_ptr<void>(), handlers[i].bind(), handlers[i].connection_type,
+                        tickets[i], EventPriority::kNormal, nullptr, EventFilter());
+                }
+                current_ptr = new_list;
+                pimpl->PublishGlobal(event_id);
+                pimpl->global_sub_lookup_.Insert(sub, event_id);
+
+                if (PluginPtr<Event> retained = LookupRetained(pimpl, event_id, std::weak_ptr<void>())) {
+                    auto target = std::make_shared<PluginManagerPimpl::SubList>(new_list->end() - (last - first), new_list->end());
+                    retained_targets.emplace_back(event_id, std::move(target));
+                    retained_events.push_back(std::move(retained));
+                }
+                first = last;
+            }
+        }
+        for (size_t i = 0; i < retained_targets.size(); ++i) {
+            DeliverRetained(pimpl, retained_targets[i].first, retained_targets[i].second, std::move(retained_events[i]));
+        }
+    }
+
+    /**
+     * @brief 事件族订阅实现。
+     * @details 写入事件族表后，把它覆盖的每个已知事件重新发布一次 (订阅时展开，而不是发布时匹配)。
+     * 之后才首次解析的事件类型由 `ResolveEventSlot` 补发。
+     */
+    Connection PluginManager::SubscribeFamilyImpl(
+        const char* family, std::weak_ptr<void> sub,
+        EventDelegate cb, ConnectionType type, EventPriority priority) {
+        const EventId family_id = EventFamilyIdOf(family);
+        if (family_id == 0) {
+            throw std::invalid_argument("z3y: event family must not be empty");
+        }
+        ConnectionTicket ticket = pimpl_->NewTicket(sub, family_id, std::weak_ptr<void>());
+
+        std::lock_guard lock(pimpl_->subscriber_map_mutex_);
+        auto& current_ptr = pimpl_->family_subscribers_[family_id];
+        auto new_list = current_ptr
+            ? pimpl_->NewSubList(*current_ptr)
+            : pimpl_->NewSubList();
+        new_list->emplace_back(sub, std::weak_ptr<void>(), std::move(cb), type, ticket, priority, nullptr);
+        current_ptr = new_list;
+        pimpl_->PublishFamily(family_id);
+
+        pimpl_->family_sub_lookup_.Insert(sub, family_id);
+
+        return Connection(ticket.Share());
+    }
+
+    // =========================================================================
+    // Typed Channels (EventChannel)
+    // =========================================================================
+
+    namespace {
+        PluginManagerPimpl::ChannelState* ChannelStateOf(internal::EventChannelCore* channel) {
+            return reinterpret_cast<PluginManagerPimpl::ChannelState*>(channel);
+        }
+    }  // namespace
+
+    /**
+     * @brief 取得 (必要时创建) 事件的通道状态。
+     * @details 首次创建时立即发布一次，使通道状态中的总线订阅列表与槽表一致。
+     */
+    internal::EventChannelCore* PluginManager::GetChannelImpl(EventId event_id) {
+        std::lock_guard lock(pimpl_->subscriber_map_mutex_);
+        auto& state = pimpl_->channels_[event_id];
+        if (!state) {
+            state = std::make_unique<PluginManagerPimpl::ChannelState>(event_id);
+            pimpl_->PublishGlobal(event_id);
+        }
+        return reinterpret_cast<internal::EventChannelCore*>(state.get());
+    }
+
+    /**
+     * @brief 通道订阅实现。
+     * @details 与 `SubscribeGlobalImpl` 相同，只是写入通道自己的订阅表，且固定为 kDirect。
+     */
+    Connection PluginManager::SubscribeChannelImpl(internal::EventChannelCore* channel,
+        std::weak_ptr<void> sub, EventDelegate cb) {
+        const EventId event_id = ChannelStateOf(channel)->event_id;
+        ConnectionTicket ticket = pimpl_->NewTicket(sub, event_id, std::weak_ptr<void>());
+        PluginPtr<Event> retained;
+        PluginManagerPimpl::SubListPtr retained_target;
+        {
+            std::lock_guard lock(pimpl_->subscriber_map_mutex_);
+            auto& current_ptr = pimpl_->channel_subscribers_[event_id];
             auto new_list = current_ptr
-                ? std::make_shared<PluginManagerPimpl::SubList>(*current_ptr)
-                : std::make_shared<PluginManagerPimpl::SubList>();
-            new_list->reserve(new_list->size() + 4);
-            new_list->emplace_back(sub, std::weak_ptr<void>(), std::move(cb), type, ticket);
+                ? pimpl_->NewSubList(*current_ptr)
+                : pimpl_->NewSubList();
+            new_list->emplace_back(sub, std::weak_ptr<void>(), std::move(cb), ConnectionType::kDirect, ticket,
+                EventPriority::kNormal, nullptr);
             current_ptr = new_list;
+            pimpl_->PublishGlobal(event_id);
+
+            pimpl_->channel_sub_lookup_.Insert(sub, event_id);
+
+            retained = LookupRetained(pimpl_.get(), event_id, std::weak_ptr<void>());
+            if (retained) retained_target = std::make_shared<PluginManagerPimpl::SubList>(1, new_list->back());
         }
+        if (retained) DeliverRetained(pimpl_.get(), event_id, retained_target, std::move(retained));
+
+        return Connection(ticket.Share());
+    }
+
+    /**
+     * @brief 通道发布实现 (同步快速路径，事件位于发布者栈上)。
+     * @details 只进入一次 RCU 读临界区：先投递通道自己的订阅，再投递同一事件的其余订阅。
+     */
+    void PluginManager::FireChannelImpl(internal::EventChannelCore* channel, const Event& e, EventPromoter promote) {
+        const PluginManagerPimpl::ChannelState& state = *ChannelStateOf(channel);
+        RcuDomain::ReadGuard guard(pimpl_->rcu_);
+        const PluginManagerPimpl::SubListPtr* own = state.subscribers.load(std::memory_order_acquire);
+        const PluginManagerPimpl::SubListPtr* rest = state.bus_subscribers.load(std::memory_order_acquire);
+        if (!own && !rest) return;
 
-        // 3. 记录反查表
-        pimpl_->global_sub_lookup_[sub].insert(event_id);
+        pimpl_->Trace(EventTracePoint::kEventFired, state.event_id, nullptr, 0, "ChannelFire");
 
-        // 4. 返回 Connection
-        return Connection(std::static_pointer_cast<IEventBus>(shared_from_this()),
-            sub, event_id, std::weak_ptr<void>(), ticket);
+        bool needs_gc = own && DispatchChannel(pimpl_.get(), state.event_id, **own, e);
+        if (rest && DispatchSnapshot(pimpl_.get(), state.event_id, *rest, e, nullptr, promote)) needs_gc = true;
+        if (needs_gc) ScheduleGC(state.event_id);
     }
 
     // =========================================================================
@@ -193,168 +1345,288 @@ namespace z3y {
     // =========================================================================
 
     /**
-     * @brief 全局广播实现。
+     * @brief 全局广播实现 (事件已在堆上物化)。
      */
     void PluginManager::FireGlobalImpl(EventId event_id, PluginPtr<Event> e_ptr) {
-        PluginManagerPimpl::SubListPtr list_snapshot;
-        {
-            // 1. 获取列表快照 (持有 shared_ptr，增加引用计数)
-            std::lock_guard<std::mutex> lock(pimpl_->subscriber_map_mutex_);
-            auto it = pimpl_->global_subscribers_.find(event_id);
-            if (it != pimpl_->global_subscribers_.end()) {
-                list_snapshot = it->second;
-            }
+        // 1. 获取列表快照 (RCU 读临界区：无锁，也不增加引用计数)
+        RcuDomain::ReadGuard guard(pimpl_->rcu_);
+        const PluginManagerPimpl::SubListPtr* list_snapshot = pimpl_->FindPublishedGlobalById(event_id);
+        if (!list_snapshot) return;
+
+        pimpl_->Trace(EventTracePoint::kEventFired, event_id, nullptr, 0, "GlobalFire");
+
+        // 2. 遍历快照 (列表不可变，且在 guard 结束前不会被释放)
+        const Event& e = *e_ptr;
+        if (DispatchSnapshot(pimpl_.get(), event_id, *list_snapshot, e, std::move(e_ptr), nullptr)) {
+            ScheduleGC(event_id);
         }
+    }
 
+    /**
+     * @brief 全局广播实现 (同步快速路径，事件位于发布者栈上)。
+     * @details 按槽号直接寻址，不做哈希与查表。
+     * 只有快照中存在 kQueued 订阅者时，才会通过 `promote` 把事件拷贝到堆上。
+     */
+    void PluginManager::FireGlobalRefImpl(EventId event_id, EventSlotIndex slot, const Event& e, EventPromoter promote) {
+        RcuDomain::ReadGuard guard(pimpl_->rcu_);
+        const PluginManagerPimpl::SubListPtr* list_snapshot = pimpl_->FindPublishedGlobal(slot);
         if (!list_snapshot) return;
 
-        if (pimpl_->event_trace_hook_) pimpl_->event_trace_hook_(EventTracePoint::kEventFired, event_id, nullptr, "GlobalFire");
-
-        bool needs_gc = false;
+        pimpl_->Trace(EventTracePoint::kEventFired, event_id, nullptr, 0, "GlobalFire");
 
-        // 2. 遍历快照 (此时无需锁，因为列表是 const 的)
-        for (const auto& sub : *list_snapshot) {
-            // 检查票据：如果已断开，跳过
-            if (sub.active_token && !sub.active_token->load(std::memory_order_acquire)) {
-                needs_gc = true; continue;
-            }
-            // 检查弱引用
-            if (sub.subscriber_id.expired()) {
-                needs_gc = true; continue;
-            }
+        if (DispatchSnapshot(pimpl_.get(), event_id, *list_snapshot, e, nullptr, promote)) {
+            ScheduleGC(event_id);
+        }
+    }
 
-            if (sub.connection_type == ConnectionType::kDirect) {
-                // 同步调用
-                if (pimpl_->event_trace_hook_) pimpl_->event_trace_hook_(EventTracePoint::kDirectCallStart, event_id, nullptr, "DirectCall");
-                try {
-                    sub.callback(*e_ptr);
-                } catch (const std::exception& e) {
-                    ReportException(pimpl_.get(), e);
-                } catch (...) {
-                    ReportUnknownException(pimpl_.get());
-                }
-            } else {
-                // 异步调用
-                auto token = sub.active_token;
-                auto cb = sub.callback;
-
-                PluginManagerPimpl::EventTask task;
-                task.event_id = event_id;
-                // 包装任务：在执行前再次验票 (Double Check)
-                task.func = [e_ptr, cb, token]() {
-                    if (token && token->load(std::memory_order_acquire)) {
-                        cb(*e_ptr);
-                    }
-                    };
+    /**
+     * @brief 批量全局广播实现。
+     * @details 整批只取一次快照、只记录一次 kEventFired 埋点。
+     */
+    void PluginManager::FireGlobalBatchImpl(EventId event_id, EventSlotIndex slot, const EventBatchView& batch) {
+        RcuDomain::ReadGuard guard(pimpl_->rcu_);
+        const PluginManagerPimpl::SubListPtr* list_snapshot = pimpl_->FindPublishedGlobal(slot);
+        if (!list_snapshot) return;
 
-                {
-                    std::lock_guard<std::mutex> lock(pimpl_->queue_mutex_);
-                    pimpl_->event_queue_.push(std::move(task));
-                }
-                pimpl_->queue_cv_.notify_one();
+        pimpl_->Trace(EventTracePoint::kEventFired, event_id, nullptr, static_cast<uint32_t>(batch.size()), "GlobalFireBatch");
 
-                if (pimpl_->event_trace_hook_) pimpl_->event_trace_hook_(EventTracePoint::kQueuedEntry, event_id, nullptr, "QueuePush");
-            }
+        if (DispatchSnapshotBatch(pimpl_.get(), event_id, *list_snapshot, batch)) {
+            ScheduleGC(event_id);
         }
-
-        if (needs_gc) ScheduleGC(event_id);
     }
 
     // ... (FireToSenderImpl 等其他函数逻辑类似，此处省略重复注释，但代码保留完整) ...
     // [为节省篇幅，Sender 部分代码与 Global 逻辑高度一致，仅查找表不同]
 
     bool PluginManager::IsSenderSubscribed(const std::weak_ptr<void>& sender_id, EventId event_id) const {
-        std::lock_guard<std::mutex> lock(pimpl_->subscriber_map_mutex_);
-        auto sender_it = pimpl_->sender_subscribers_.find(sender_id);
-        if (sender_it == pimpl_->sender_subscribers_.end()) return false;
-        auto event_it = sender_it->second.find(event_id);
-        return event_it != sender_it->second.end() && event_it->second && !event_it->second->empty();
+        // 空列表不会被发布，因此 "有发布节点" 即 "有订阅者"
+        RcuDomain::ReadGuard guard(pimpl_->rcu_);
+        std::uintptr_t key = 0;
+        bool stale = false;
+        const bool subscribed = pimpl_->FindPublishedSender(sender_id, event_id, key, stale) != nullptr;
+        // 命中同一地址上已销毁发送者的旧记录：与 Fire 一样顺带调度回收 (内务操作，不改变可观察状态)
+        if (stale) const_cast<PluginManager*>(this)->ScheduleSenderGC(key);
+        return subscribed;
     }
 
     bool PluginManager::IsGlobalSubscribed(EventId event_id) const {
-        std::lock_guard<std::mutex> lock(pimpl_->subscriber_map_mutex_);
-        auto it = pimpl_->global_subscribers_.find(event_id);
-        return it != pimpl_->global_subscribers_.end() && it->second && !it->second->empty();
+        // 空列表不会被发布，因此 "有发布节点" 即 "有订阅者"
+        RcuDomain::ReadGuard guard(pimpl_->rcu_);
+        return pimpl_->FindPublishedGlobalById(event_id) != nullptr;
+    }
+
+    bool PluginManager::IsGlobalSlotSubscribed(EventSlotIndex slot) const {
+        RcuDomain::ReadGuard guard(pimpl_->rcu_);
+        return pimpl_->FindPublishedGlobal(slot) != nullptr;
+    }
+
+    /**
+     * @brief 连接断开后的 O(1) 清理。
+     * @details 票据已由 Connection 撕掉；这里只把所在列表登记为待 GC。
+     */
+    void PluginManager::ReleaseConnection(EventId event_id, const std::weak_ptr<void>& sender_key) {
+        bool is_global = !sender_key.owner_before(std::weak_ptr<void>()) && !std::weak_ptr<void>().owner_before(sender_key);
+        if (is_global) {
+            ScheduleGC(event_id);
+            return;
+        }
+        std::uintptr_t key = PluginManagerPimpl::SenderKeyOf(sender_key);
+        if (key == 0) {
+            // 发送者已销毁，地址无法再取得：从写侧索引找回它的哈希键
+            std::lock_guard lock(pimpl_->subscriber_map_mutex_);
+            auto key_it = pimpl_->sender_keys_.find(sender_key);
+            if (key_it == pimpl_->sender_keys_.end()) return;
+            key = key_it->second;
+        }
+        ScheduleSenderGC(key);
+    }
+
+    /**
+     * @brief 一批连接断开后的清理 (EventConnectionGroup)。
+     * @details 先在写侧锁下一次找回所有已销毁发送者的哈希键，再在 GC 状态锁下一次登记全部列表、
+     * 只调度一轮 GC；那一轮在同一次持锁中把它们全部移除。
+     */
+    void PluginManager::ReleaseConnections(const std::vector<std::pair<EventId, std::weak_ptr<void>>>& released) {
+        std::vector<EventId> events;
+        std::vector<std::uintptr_t> senders;
+        std::vector<const std::weak_ptr<void>*> orphaned;  // 发送者已销毁，需从写侧索引找回哈希键
+        for (const auto& entry : released) {
+            const std::weak_ptr<void>& sender_key = entry.second;
+            if (PluginManagerPimpl::SameOwner(sender_key, std::weak_ptr<void>())) {
+                events.push_back(entry.first);
+            } else if (std::uintptr_t key = PluginManagerPimpl::SenderKeyOf(sender_key)) {
+                senders.push_back(key);
+            } else {
+                orphaned.push_back(&sender_key);
+            }
+        }
+        if (!orphaned.empty()) {
+            std::lock_guard lock(pimpl_->subscriber_map_mutex_);
+            for (const std::weak_ptr<void>* sender_key : orphaned) {
+                auto key_it = pimpl_->sender_keys_.find(*sender_key);
+                if (key_it != pimpl_->sender_keys_.end()) senders.push_back(key_it->second);
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(pimpl_->gc_status_mutex_);
+        bool added = false;
+        for (EventId event_id : events) added |= pimpl_->pending_gc_events_.insert(event_id).second;
+        for (std::uintptr_t key : senders) added |= pimpl_->pending_sender_gc_.insert(key).second;
+        if (added) ScheduleGCPassLocked();
+    }
+
+    EventSlotIndex PluginManager::ResolveEventSlot(EventId event_id, const char* family) {
+        const EventSlotIndex slot = ResolveEventSlotIndex(event_id);
+        if (family && RegisterEventFamily(event_id, family)) {
+            // 新的事件族成员：如果已有对应的事件族订阅，立刻把它们合并进该事件的发布列表
+            std::lock_guard lock(pimpl_->subscriber_map_mutex_);
+            if (!pimpl_->family_subscribers_.empty()) pimpl_->PublishGlobal(event_id);
+        }
+        return slot;
     }
 
     Connection PluginManager::SubscribeToSenderImpl(
         EventId event_id, std::weak_ptr<void> sub_id,
-        std::weak_ptr<void> sender_id, std::function<void(const Event&)> cb,
-        ConnectionType connection_type) {
-        auto ticket = std::make_shared<std::atomic<bool>>(true);
-        std::lock_guard<std::mutex> lock(pimpl_->subscriber_map_mutex_);
+        std::weak_ptr<void> sender_id, EventDelegate cb,
+        ConnectionType connection_type, EventPriority priority,
+        std::shared_ptr<IEventExecutor> executor, EventFilter filter) {
+        ConnectionTicket ticket = pimpl_->NewTicket(sub_id, event_id, sender_id);
+        std::unique_lock lock(pimpl_->subscriber_map_mutex_);
 
-        auto& event_map = pimpl_->sender_subscribers_[sender_id];
-        auto& current_ptr = event_map[event_id];
+        // 发送者已销毁：订阅永远不会触发，不必入表
+        std::uintptr_t key = PluginManagerPimpl::SenderKeyOf(sender_id);
+        if (key == 0) {
+            return Connection(ticket.Share());
+        }
 
-        if (current_ptr && current_ptr.use_count() == 1) {
-            auto& list = const_cast<PluginManagerPimpl::SubList&>(*current_ptr);
-            list.emplace_back(sub_id, sender_id, std::move(cb), connection_type, ticket);
-        } else {
-            auto new_list = current_ptr
-                ? std::make_shared<PluginManagerPimpl::SubList>(*current_ptr)
-                : std::make_shared<PluginManagerPimpl::SubList>();
-            new_list->reserve(new_list->size() + 4);
-            new_list->emplace_back(sub_id, sender_id, std::move(cb), connection_type, ticket);
-            current_ptr = new_list;
+        auto rec_it = pimpl_->sender_subscribers_.find(key);
+        if (rec_it != pimpl_->sender_subscribers_.end() &&
+            !PluginManagerPimpl::SameOwner(rec_it->second.owner, sender_id)) {
+            // 同一地址上是已销毁的旧发送者留下的记录 (尚未被 GC)：直接替换
+            pimpl_->sender_keys_.erase(rec_it->second.owner);
+            pimpl_->sender_subscribers_.erase(rec_it);
+            rec_it = pimpl_->sender_subscribers_.end();
         }
+        if (rec_it == pimpl_->sender_subscribers_.end()) {
+            if (pimpl_->sender_subscribers_.size() >= pimpl_->sender_prune_at_) {
+                SweepExpiredSenders(pimpl_.get());
+            }
+            rec_it = pimpl_->sender_subscribers_.emplace(key, PluginManagerPimpl::SenderRecord{ sender_id, {} }).first;
+            pimpl_->sender_keys_[sender_id] = key;
+        }
+
+        // 读者不持有引用计数，一律复制一份新的修改
+        auto& current_ptr = rec_it->second.events[event_id];
+        auto new_list = current_ptr
+            ? pimpl_->NewSubList(*current_ptr)
+            : pimpl_->NewSubList();
+        new_list->emplace_back(sub_id, sender_id, std::move(cb), connection_type, ticket, priority, std::move(executor),
+            std::move(filter));
+        current_ptr = new_list;
+        pimpl_->PublishSender(key);
+
+        pimpl_->sender_sub_lookup_.Insert(sub_id, { sender_id, event_id });
 
-        pimpl_->sender_sub_lookup_[sub_id].insert({ sender_id, event_id });
-        return Connection(std::static_pointer_cast<IEventBus>(shared_from_this()),
-            sub_id, event_id, sender_id, ticket);
+        // 保留事件：与全局订阅相同，解锁后只投递给这一个新订阅
+        PluginPtr<Event> retained = LookupRetained(pimpl_.get(), event_id, sender_id);
+        if (retained) {
+            PluginManagerPimpl::SubListPtr target = std::make_shared<PluginManagerPimpl::SubList>(1, new_list->back());
+            lock.unlock();
+            DeliverRetained(pimpl_.get(), event_id, target, std::move(retained));
+        }
+        return Connection(ticket.Share());
     }
 
+    /**
+     * @brief 定向广播实现 (事件已在堆上物化)。
+     * @details 按发送者地址哈希定位 (O(1))；命中已销毁发送者的旧记录时顺带调度 GC。
+     */
     void PluginManager::FireToSenderImpl(const std::weak_ptr<void>& sender_id, EventId event_id, PluginPtr<Event> e_ptr) {
-        PluginManagerPimpl::SubListPtr list_snapshot;
-        {
-            std::lock_guard<std::mutex> lock(pimpl_->subscriber_map_mutex_);
-            auto sender_it = pimpl_->sender_subscribers_.find(sender_id);
-            if (sender_it != pimpl_->sender_subscribers_.end()) {
-                auto event_it = sender_it->second.find(event_id);
-                if (event_it != sender_it->second.end()) list_snapshot = event_it->second;
-            }
+        RcuDomain::ReadGuard guard(pimpl_->rcu_);
+        std::uintptr_t key = 0;
+        bool stale = false;
+        const PluginManagerPimpl::SubListPtr* list_snapshot = pimpl_->FindPublishedSender(sender_id, event_id, key, stale);
+        if (stale) ScheduleSenderGC(key);
+        if (!list_snapshot) return;
+
+        pimpl_->Trace(EventTracePoint::kEventFired, event_id, nullptr, 0, "SenderFire");
+
+        const Event& e = *e_ptr;
+        if (DispatchSnapshot(pimpl_.get(), event_id, *list_snapshot, e, std::move(e_ptr), nullptr)) {
+            ScheduleSenderGC(key);
         }
+    }
 
+    /**
+     * @brief 定向广播实现 (同步快速路径，事件位于发布者栈上)。
+     */
+    void PluginManager::FireToSenderRefImpl(const std::weak_ptr<void>& sender_id, EventId event_id,
+        const Event& e, EventPromoter promote) {
+        RcuDomain::ReadGuard guard(pimpl_->rcu_);
+        std::uintptr_t key = 0;
+        bool stale = false;
+        const PluginManagerPimpl::SubListPtr* list_snapshot = pimpl_->FindPublishedSender(sender_id, event_id, key, stale);
+        if (stale) ScheduleSenderGC(key);
         if (!list_snapshot) return;
 
-        if (pimpl_->event_trace_hook_) pimpl_->event_trace_hook_(EventTracePoint::kEventFired, event_id, nullptr, "SenderFire");
-
-        bool needs_gc = false;
-        for (const auto& sub : *list_snapshot) {
-            if (sub.active_token && !sub.active_token->load(std::memory_order_acquire)) { needs_gc = true; continue; }
-            if (sub.subscriber_id.expired()) { needs_gc = true; continue; }
+        pimpl_->Trace(EventTracePoint::kEventFired, event_id, nullptr, 0, "SenderFire");
 
-            if (sub.connection_type == ConnectionType::kDirect) {
-                if (pimpl_->event_trace_hook_) pimpl_->event_trace_hook_(EventTracePoint::kDirectCallStart, event_id, nullptr, "DirectCall");
-                try { sub.callback(*e_ptr); } catch (const std::exception& e) { ReportException(pimpl_.get(), e); } catch (...) { ReportUnknownException(pimpl_.get()); }
-            } else {
-                auto token = sub.active_token;
-                auto cb = sub.callback;
+        if (DispatchSnapshot(pimpl_.get(), event_id, *list_snapshot, e, nullptr, promote)) {
+            ScheduleSenderGC(key);
+        }
+    }
 
-                PluginManagerPimpl::EventTask task;
-                task.event_id = event_id;
-                task.func = [e_ptr, cb, token]() {
-                    if (token && token->load(std::memory_order_acquire)) cb(*e_ptr);
-                    };
+    // =========================================================================
+    // Retained Events (保留事件)
+    // =========================================================================
 
-                {
-                    std::lock_guard<std::mutex> lock(pimpl_->queue_mutex_);
-                    pimpl_->event_queue_.push(std::move(task));
-                }
-                pimpl_->queue_cv_.notify_one();
-                if (pimpl_->event_trace_hook_) pimpl_->event_trace_hook_(EventTracePoint::kQueuedEntry, event_id, nullptr, "QueuePush");
+    void PluginManager::RetainEventImpl(EventId event_id, const std::weak_ptr<void>& sender_id, PluginPtr<Event> e_ptr) {
+        PluginPtr<Event> previous;  // 旧值在锁外释放：析构可能较重
+        std::lock_guard<std::mutex> lock(pimpl_->retained_mutex_);
+        if (PluginManagerPimpl::SameOwner(sender_id, std::weak_ptr<void>())) {
+            previous = std::exchange(pimpl_->retained_global_[event_id], std::move(e_ptr));
+            return;
+        }
+        if (sender_id.expired()) return;
+        auto& retained = pimpl_->retained_sender_;
+        if (retained.size() >= pimpl_->retained_sender_prune_at_) {
+            for (auto it = retained.begin(); it != retained.end();) {
+                if (it->first.expired()) it = retained.erase(it);
+                else ++it;
             }
+            pimpl_->retained_sender_prune_at_ = std::max<size_t>(64, retained.size() * 2);
         }
+        previous = std::exchange(retained[sender_id][event_id], std::move(e_ptr));
+    }
 
-        if (needs_gc) {
-            ScheduleGC(event_id);
+    PluginPtr<Event> PluginManager::GetRetainedImpl(EventId event_id, const std::weak_ptr<void>& sender_id) const {
+        return LookupRetained(pimpl_.get(), event_id, sender_id);
+    }
+
+    void PluginManager::ClearRetainedImpl(EventId event_id, const std::weak_ptr<void>& sender_id) {
+        PluginPtr<Event> previous;
+        std::lock_guard<std::mutex> lock(pimpl_->retained_mutex_);
+        if (PluginManagerPimpl::SameOwner(sender_id, std::weak_ptr<void>())) {
+            auto it = pimpl_->retained_global_.find(event_id);
+            if (it == pimpl_->retained_global_.end()) return;
+            previous = std::move(it->second);
+            pimpl_->retained_global_.erase(it);
+            return;
         }
+        auto sender_it = pimpl_->retained_sender_.find(sender_id);
+        if (sender_it == pimpl_->retained_sender_.end()) return;
+        auto it = sender_it->second.find(event_id);
+        if (it == sender_it->second.end()) return;
+        previous = std::move(it->second);
+        sender_it->second.erase(it);
+        if (sender_it->second.empty()) pimpl_->retained_sender_.erase(sender_it);
     }
 
     // 辅助：从列表中物理移除订阅
     static bool RemoveSubscriberFromList(PluginManagerPimpl::SubListPtr& current_ptr, const std::weak_ptr<void>& target_sub) {
         if (!current_ptr) return false;
-        auto new_list = std::make_shared<PluginManagerPimpl::SubList>(*current_ptr);
+        // 副本与原列表同属一个内存资源
+        auto new_list = std::allocate_shared<PluginManagerPimpl::SubList>(current_ptr->get_allocator(), *current_ptr);
         auto it = std::remove_if(new_list->begin(), new_list->end(),
             [&target_sub](const auto& sub) {
                 return !sub.subscriber_id.owner_before(target_sub) && !target_sub.owner_before(sub.subscriber_id);
@@ -368,57 +1640,102 @@ namespace z3y {
     }
 
     void PluginManager::Unsubscribe(std::shared_ptr<void> subscriber, EventId event_id, const std::weak_ptr<void>& sender_key) {
-        std::lock_guard<std::mutex> lock(pimpl_->subscriber_map_mutex_);
+        std::lock_guard lock(pimpl_->subscriber_map_mutex_);
         std::weak_ptr<void> weak_sub = subscriber;
         bool is_global = !sender_key.owner_before(std::weak_ptr<void>()) && !std::weak_ptr<void>().owner_before(sender_key);
 
         if (is_global) {
             auto it = pimpl_->global_subscribers_.find(event_id);
-            if (it != pimpl_->global_subscribers_.end()) RemoveSubscriberFromList(it->second, weak_sub);
-            auto look_it = pimpl_->global_sub_lookup_.find(weak_sub);
-            if (look_it != pimpl_->global_sub_lookup_.end()) {
-                look_it->second.erase(event_id);
-                if (look_it->second.empty()) pimpl_->global_sub_lookup_.erase(look_it);
+            if (it != pimpl_->global_subscribers_.end() && RemoveSubscriberFromList(it->second, weak_sub)) {
+                pimpl_->PublishGlobal(event_id);
             }
+            pimpl_->global_sub_lookup_.Erase(weak_sub, event_id);
+            // event_id 也可能是事件族 ID (来自 SubscribeFamily 返回的 Connection)
+            auto family_it = pimpl_->family_subscribers_.find(event_id);
+            if (family_it != pimpl_->family_subscribers_.end() && RemoveSubscriberFromList(family_it->second, weak_sub)) {
+                if (family_it->second->empty()) pimpl_->family_subscribers_.erase(family_it);
+                pimpl_->PublishFamily(event_id);
+            }
+            pimpl_->family_sub_lookup_.Erase(weak_sub, event_id);
+            auto channel_it = pimpl_->channel_subscribers_.find(event_id);
+            if (channel_it != pimpl_->channel_subscribers_.end() && RemoveSubscriberFromList(channel_it->second, weak_sub)) {
+                if (channel_it->second->empty()) pimpl_->channel_subscribers_.erase(channel_it);
+                pimpl_->PublishGlobal(event_id);
+            }
+            pimpl_->channel_sub_lookup_.Erase(weak_sub, event_id);
         } else {
-            auto sender_it = pimpl_->sender_subscribers_.find(sender_key);
-            if (sender_it != pimpl_->sender_subscribers_.end()) {
-                auto& event_map = sender_it->second;
+            auto rec_it = FindSenderRecord(pimpl_.get(), sender_key);
+            if (rec_it != pimpl_->sender_subscribers_.end()) {
+                auto& event_map = rec_it->second.events;
                 auto evt_it = event_map.find(event_id);
-                if (evt_it != event_map.end()) RemoveSubscriberFromList(evt_it->second, weak_sub);
-            }
-            auto look_it = pimpl_->sender_sub_lookup_.find(weak_sub);
-            if (look_it != pimpl_->sender_sub_lookup_.end()) {
-                look_it->second.erase({ sender_key, event_id });
-                if (look_it->second.empty()) pimpl_->sender_sub_lookup_.erase(look_it);
+                if (evt_it != event_map.end() && RemoveSubscriberFromList(evt_it->second, weak_sub)) {
+                    CommitSenderRecord(pimpl_.get(), rec_it);
+                }
             }
+            pimpl_->sender_sub_lookup_.Erase(weak_sub, { sender_key, event_id });
         }
     }
 
+    namespace {
+        /** @brief [内部] 撕掉列表中属于该订阅者的所有票据。@return 是否撕掉了至少一张 (列表需要 GC)。 */
+        bool RevokeSubscriberInList(const PluginManagerPimpl::SubListPtr& list, const std::weak_ptr<void>& target_sub) {
+            if (!list) return false;
+            bool revoked = false;
+            for (const auto& sub : *list) {
+                if (PluginManagerPimpl::SameOwner(sub.subscriber_id, target_sub) && sub.ticket.Revoke()) revoked = true;
+            }
+            return revoked;
+        }
+    }  // namespace
+
+    /**
+     * @brief 取消某订阅者的全部订阅。
+     * @details
+     * 不再逐个事件复制订阅列表：先按反查表撕掉该订阅者的所有票据 (Fire 随即跳过它们)，
+     * 再在 GC 状态锁下一次登记所有受影响的列表，由一轮 GC 批处理统一压缩。
+     * 持有写侧锁期间只做查找和原子写，订阅了数百个事件的组件析构时也不会长时间占住锁。
+     */
     void PluginManager::Unsubscribe(std::shared_ptr<void> subscriber) {
-        std::lock_guard<std::mutex> lock(pimpl_->subscriber_map_mutex_);
         std::weak_ptr<void> weak_sub = subscriber;
+        std::vector<EventId> events;
+        std::vector<std::uintptr_t> senders;
+        {
+            std::lock_guard lock(pimpl_->subscriber_map_mutex_);
 
-        auto global_it = pimpl_->global_sub_lookup_.find(weak_sub);
-        if (global_it != pimpl_->global_sub_lookup_.end()) {
-            for (auto eid : global_it->second) {
+            for (EventId eid : pimpl_->global_sub_lookup_.Take(weak_sub)) {
                 auto it = pimpl_->global_subscribers_.find(eid);
-                if (it != pimpl_->global_subscribers_.end()) RemoveSubscriberFromList(it->second, weak_sub);
+                if (it != pimpl_->global_subscribers_.end() && RevokeSubscriberInList(it->second, weak_sub)) {
+                    events.push_back(eid);
+                }
             }
-            pimpl_->global_sub_lookup_.erase(global_it);
-        }
-
-        auto sender_it = pimpl_->sender_sub_lookup_.find(weak_sub);
-        if (sender_it != pimpl_->sender_sub_lookup_.end()) {
-            for (const auto& pair : sender_it->second) {
-                auto sit = pimpl_->sender_subscribers_.find(pair.first);
-                if (sit != pimpl_->sender_subscribers_.end()) {
-                    auto eit = sit->second.find(pair.second);
-                    if (eit != sit->second.end()) RemoveSubscriberFromList(eit->second, weak_sub);
+            // 事件族 ID 同样登记在 pending_gc_events_ 中 (GC 会压缩 ID 本身对应的事件族列表)
+            for (EventId family_id : pimpl_->family_sub_lookup_.Take(weak_sub)) {
+                auto it = pimpl_->family_subscribers_.find(family_id);
+                if (it != pimpl_->family_subscribers_.end() && RevokeSubscriberInList(it->second, weak_sub)) {
+                    events.push_back(family_id);
+                }
+            }
+            for (EventId eid : pimpl_->channel_sub_lookup_.Take(weak_sub)) {
+                auto it = pimpl_->channel_subscribers_.find(eid);
+                if (it != pimpl_->channel_subscribers_.end() && RevokeSubscriberInList(it->second, weak_sub)) {
+                    events.push_back(eid);
+                }
+            }
+            for (const auto& pair : pimpl_->sender_sub_lookup_.Take(weak_sub)) {
+                auto rec_it = FindSenderRecord(pimpl_.get(), pair.first);
+                if (rec_it == pimpl_->sender_subscribers_.end()) continue;
+                auto eit = rec_it->second.events.find(pair.second);
+                if (eit != rec_it->second.events.end() && RevokeSubscriberInList(eit->second, weak_sub)) {
+                    senders.push_back(rec_it->first);
                 }
             }
-            pimpl_->sender_sub_lookup_.erase(sender_it);
         }
+        if (events.empty() && senders.empty()) return;
+
+        std::lock_guard<std::mutex> lock(pimpl_->gc_status_mutex_);
+        pimpl_->pending_gc_events_.insert(events.begin(), events.end());
+        pimpl_->pending_sender_gc_.insert(senders.begin(), senders.end());
+        ScheduleGCPassLocked();
     }
 
 } // namespace z3y
@@ -0,0 +1,212 @@
+﻿/*
+* Copyright [2025] [Yue Liu]
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/**
+ * @file event_metrics.h
+ * @brief [私有头文件] 事件派发的常驻运行指标 (队列延迟直方图、订阅者耗时)。
+ *
+ * @details
+ * [受众：框架维护者]
+ *
+ * 这些计数器默认常开，因此写侧只允许 relaxed 原子操作：
+ * - 队列延迟直方图按派发线程分片，只有所属派发线程写入 (无共享写)。
+ * - 订阅者统计挂在 Subscription 上 (写时复制的各版本共享同一份)，无需查表。
+ * 读侧 (`GetEventDispatchMetrics`) 得到的是近似快照，不保证各字段彼此一致。
+ *
+ * 按插件的 CPU 记账 (`CpuChargeScope`) 也在这里：它默认关闭，关闭时只多一次指针判断。
+ */
+
+#pragma once
+
+#ifndef Z3Y_SRC_PLUGIN_MANAGER_EVENT_METRICS_H_
+#define Z3Y_SRC_PLUGIN_MANAGER_EVENT_METRICS_H_
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "framework/allocation_account.h"
+#include "framework/plugin_manager.h"
+#include "platform_threads.h"
+
+namespace z3y {
+
+    /** @brief [内部] 单调时钟纳秒数。 */
+    inline uint64_t MetricsNowNs() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    /**
+     * @class LatencyCells
+     * @brief [内部] `LatencyHistogram` 的原子版本 (以 2 的幂分桶)。
+     */
+    class LatencyCells {
+    public:
+        void Record(uint64_t ns) {
+            buckets_[LatencyHistogram::BucketOf(ns)].fetch_add(1, std::memory_order_relaxed);
+            count_.fetch_add(1, std::memory_order_relaxed);
+            total_ns_.fetch_add(ns, std::memory_order_relaxed);
+            uint64_t prev = max_ns_.load(std::memory_order_relaxed);
+            while (ns > prev && !max_ns_.compare_exchange_weak(prev, ns, std::memory_order_relaxed)) {}
+        }
+
+        /** @brief 累加到 `out` (多个分片合并成一个直方图)。 */
+        void AddTo(LatencyHistogram& out) const {
+            for (size_t i = 0; i < LatencyHistogram::kBuckets; ++i) {
+                out.buckets[i] += buckets_[i].load(std::memory_order_relaxed);
+            }
+            out.count += count_.load(std::memory_order_relaxed);
+            out.total_ns += total_ns_.load(std::memory_order_relaxed);
+            out.max_ns = std::max(out.max_ns, max_ns_.load(std::memory_order_relaxed));
+        }
+
+        void Reset() {
+            for (auto& b : buckets_) b.store(0, std::memory_order_relaxed);
+            count_.store(0, std::memory_order_relaxed);
+            total_ns_.store(0, std::memory_order_relaxed);
+            max_ns_.store(0, std::memory_order_relaxed);
+        }
+
+    private:
+        std::atomic<uint64_t> buckets_[LatencyHistogram::kBuckets] = {};
+        std::atomic<uint64_t> count_{ 0 };
+        std::atomic<uint64_t> total_ns_{ 0 };
+        std::atomic<uint64_t> max_ns_{ 0 };
+    };
+
+    /**
+     * @struct SubscriptionStats
+     * @brief [内部] 单个订阅的回调统计。由 Subscription 通过 shared_ptr 持有。
+     * @details 同时负责订阅的内存记账：列表的各个副本共享同一份 stats，因此一个订阅只记一次，
+     * 最后一个副本释放时扣除。
+     */
+    struct SubscriptionStats {
+        /** @param entry_bytes 订阅条目的大小。在记账作用域内 (插件的 Initialize 中) 构造时记入当前账户。 */
+        explicit SubscriptionStats(size_t entry_bytes)
+            : account(internal::CurrentAllocationAccount()),
+            bytes(static_cast<int64_t>(entry_bytes + sizeof(SubscriptionStats))) {
+            if (!account) return;
+            account->subscription_bytes.fetch_add(bytes, std::memory_order_relaxed);
+            account->subscription_count.fetch_add(1, std::memory_order_relaxed);
+        }
+        ~SubscriptionStats() {
+            if (!account) return;
+            account->subscription_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+            account->subscription_count.fetch_sub(1, std::memory_order_relaxed);
+        }
+        SubscriptionStats(const SubscriptionStats&) = delete;
+        SubscriptionStats& operator=(const SubscriptionStats&) = delete;
+
+        /**
+         * @brief 记入一次回调耗时的滑动平均 (权重 1/8) 与最大值。
+         * @details 同一订阅可能在多个线程上并发执行 (kDirect)，平均值的读改写不加锁，
+         * 偶尔丢失一次更新可以接受；最大值用 CAS 保证单调。
+         */
+        void RecordDuration(uint64_t ns) {
+            const uint64_t avg = average_ns.load(std::memory_order_relaxed);
+            average_ns.store(avg == 0 ? ns : avg - avg / 8 + ns / 8, std::memory_order_relaxed);
+            uint64_t max = max_ns.load(std::memory_order_relaxed);
+            while (ns > max && !max_ns.compare_exchange_weak(max, ns, std::memory_order_relaxed)) {}
+        }
+
+        LatencyCells callback_time;            //!< 回调执行耗时
+        std::atomic<uint64_t> exceptions{ 0 }; //!< 回调抛出的异常数
+        std::atomic<uint64_t> average_ns{ 0 }; //!< 回调耗时的滑动平均 (看门狗)
+        std::atomic<uint64_t> max_ns{ 0 };     //!< 回调耗时的最大值 (看门狗)
+        std::atomic<uint64_t> slow_calls{ 0 }; //!< 超过慢回调阈值的次数
+        std::atomic<bool> demoted{ false };    //!< kDirect 订阅是否已被降级为异步投递
+        const std::shared_ptr<AllocationAccount> account; //!< 记入的账户 (可为空)
+        const int64_t bytes;                   //!< 记入的字节数
+    };
+
+    /**
+     * @class CpuChargeScope
+     * @brief [内部] 把作用域内调用线程消耗的 CPU 时间记入插件账户。
+     * @details 账户为空或未启用 CPU 记账时不读时钟。作用域可以嵌套 (回调里触发另一个插件的回调)，
+     * 外层的时间包含内层，与调用栈上的 “包含时间” 一致。
+     */
+    class CpuChargeScope {
+    public:
+        using Counter = std::atomic<uint64_t> AllocationAccount::*;
+
+        CpuChargeScope(AllocationAccount* account, Counter cpu_ns, Counter calls) noexcept
+            : account_(account && account->cpu_accounting ? account : nullptr),
+            cpu_ns_(cpu_ns), calls_(calls), start_ns_(account_ ? PlatformThreadCpuTimeNs() : 0) {}
+
+        ~CpuChargeScope() {
+            if (!account_) return;
+            const uint64_t now = PlatformThreadCpuTimeNs();
+            (account_->*cpu_ns_).fetch_add(now > start_ns_ ? now - start_ns_ : 0, std::memory_order_relaxed);
+            (account_->*calls_).fetch_add(1, std::memory_order_relaxed);
+        }
+
+        CpuChargeScope(const CpuChargeScope&) = delete;
+        CpuChargeScope& operator=(const CpuChargeScope&) = delete;
+
+        /** @brief 记入回调时间。 */
+        static CpuChargeScope Callback(AllocationAccount* account) noexcept {
+            return CpuChargeScope(account, &AllocationAccount::callback_cpu_ns, &AllocationAccount::callback_calls);
+        }
+        /** @brief 记入 Initialize / Shutdown 时间。 */
+        static CpuChargeScope Lifecycle(AllocationAccount* account) noexcept {
+            return CpuChargeScope(account, &AllocationAccount::lifecycle_cpu_ns, &AllocationAccount::lifecycle_calls);
+        }
+
+    private:
+        AllocationAccount* const account_;
+        const Counter cpu_ns_;
+        const Counter calls_;
+        const uint64_t start_ns_;
+    };
+
+    /**
+     * @class EventLatencyShard
+     * @brief [内部] 一个派发线程的 “EventId -> 入队到执行的延迟” 直方图表。
+     * @details 直方图一旦创建地址就不变；派发线程在本地缓存指针，只有遇到新的 EventId 才加锁。
+     */
+    class EventLatencyShard {
+    public:
+        /** @brief [派发线程] 取得 event_id 的直方图 (不存在则创建)。 */
+        LatencyCells& For(EventId event_id) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto& cells = table_[event_id];
+            if (!cells) cells = std::make_unique<LatencyCells>();
+            return *cells;
+        }
+
+        void AddTo(std::unordered_map<EventId, LatencyHistogram>& out) const {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (const auto& entry : table_) entry.second->AddTo(out[entry.first]);
+        }
+
+        void Reset() {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (auto& entry : table_) entry.second->Reset();
+        }
+
+    private:
+        mutable std::mutex mutex_;
+        std::unordered_map<EventId, std::unique_ptr<LatencyCells>> table_;
+    };
+
+}  // namespace z3y
+
+#endif  // Z3Y_SRC_PLUGIN_MANAGER_EVENT_METRICS_H_
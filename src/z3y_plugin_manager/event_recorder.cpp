@@ -0,0 +1,379 @@
+﻿/*
+* Copyright [2025] [Yue Liu]
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/**
+ * @file event_recorder.cpp
+ * @brief [内部] `EventRecorder` / `EventReplayer` 的实现：录制文件的编码、缓冲写入与按节奏回放。
+ */
+
+#include "framework/event_recorder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace z3y {
+
+    namespace {
+        constexpr char kMagic[8] = { 'Z', '3', 'Y', 'E', 'V', 'R', 'E', 'C' };
+        constexpr uint32_t kVersion = 1;
+        constexpr size_t kHeaderBytes = 24;
+
+        /** @brief 每条记录的最大固定开销：两个 varint (各 ≤ 10 字节) + 8 字节 ID。 */
+        constexpr size_t kMaxRecordOverhead = 28;
+
+        void PutU32(std::string& out, uint32_t v) {
+            for (int i = 0; i < 4; ++i) out.push_back(static_cast<char>((v >> (8 * i)) & 0xFF));
+        }
+        void PutU64(std::string& out, uint64_t v) {
+            for (int i = 0; i < 8; ++i) out.push_back(static_cast<char>((v >> (8 * i)) & 0xFF));
+        }
+        void PutVarint(std::string& out, uint64_t v) {
+            while (v >= 0x80) {
+                out.push_back(static_cast<char>((v & 0x7F) | 0x80));
+                v >>= 7;
+            }
+            out.push_back(static_cast<char>(v));
+        }
+
+        uint64_t GetU64(const unsigned char* p) {
+            uint64_t v = 0;
+            for (int i = 7; i >= 0; --i) v = (v << 8) | p[i];
+            return v;
+        }
+        uint32_t GetU32(const unsigned char* p) {
+            return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+        }
+        bool GetVarint(const unsigned char*& p, const unsigned char* end, uint64_t& out) {
+            uint64_t v = 0;
+            for (int shift = 0; shift < 64 && p < end; shift += 7) {
+                const unsigned char b = *p++;
+                v |= uint64_t(b & 0x7F) << shift;
+                if ((b & 0x80) == 0) {
+                    out = v;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        /** @brief 一条解析出的记录 (负载指向文件缓冲)。 */
+        struct RawRecord {
+            uint64_t delta_ns = 0;
+            EventId event_id = 0;
+            bool has_payload = false;
+            const char* payload = nullptr;
+            size_t size = 0;
+        };
+
+        /** @brief 解析 `p` 处的一条记录；记录不完整 (崩溃留下的尾部) 时返回 false。 */
+        bool ParseRecord(const unsigned char*& p, const unsigned char* end, RawRecord& rec) {
+            const unsigned char* q = p;
+            uint64_t len_plus_one = 0;
+            if (!GetVarint(q, end, rec.delta_ns)) return false;
+            if (end - q < 8) return false;
+            rec.event_id = GetU64(q);
+            q += 8;
+            if (!GetVarint(q, end, len_plus_one)) return false;
+            rec.has_payload = len_plus_one != 0;
+            rec.size = rec.has_payload ? static_cast<size_t>(len_plus_one - 1) : 0;
+            if (static_cast<uint64_t>(end - q) < rec.size) return false;
+            rec.payload = reinterpret_cast<const char*>(q);
+            p = q + rec.size;
+            return true;
+        }
+
+        uint64_t UnixNowNs() {
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count());
+        }
+
+        /** @brief 等到 `target`：距离较远时先睡眠，最后 100 us 让出 CPU 等待，避免睡眠粒度造成的落后。 */
+        void WaitUntil(std::chrono::steady_clock::time_point target) {
+            using namespace std::chrono;
+            auto now = steady_clock::now();
+            if (target - now > microseconds(200)) {
+                std::this_thread::sleep_until(target - microseconds(100));
+            }
+            while (steady_clock::now() < target) std::this_thread::yield();
+        }
+    }  // namespace
+
+    // --- EventRecorder ---
+
+    struct EventRecorder::Impl {
+        std::ofstream file;
+        size_t flush_bytes = kDefaultFlushBytes;
+
+        std::mutex mutex;  // 保护以下成员
+        std::condition_variable flushed;
+        std::string buffer;
+        std::string spare;  // 与 buffer 轮换，复用容量
+        bool flushing = false;
+        bool closed = false;
+        std::chrono::steady_clock::time_point last;
+        std::unordered_set<EventId> recorded;
+        std::vector<std::pair<std::shared_ptr<void>, Connection>> sinks;
+        EventRecorderStats stats;
+
+        /**
+         * @brief 在锁外把缓冲写入文件，直到剩余量低于阈值 (`force` 时写空)。
+         * @details 调用者持有锁且 `flushing == false`；同一时刻只有一个线程写文件，保证记录顺序。
+         */
+        bool Drain(std::unique_lock<std::mutex>& lock, bool force) {
+            flushing = true;
+            bool ok = true;
+            while (!buffer.empty() && (force || buffer.size() >= flush_bytes)) {
+                std::string chunk;
+                chunk.swap(spare);
+                chunk.swap(buffer);  // buffer 接手上一块的容量
+                lock.unlock();
+                file.write(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+                const bool written = static_cast<bool>(file);
+                file.clear();
+                lock.lock();
+                if (written) {
+                    stats.written_bytes += chunk.size();
+                } else {
+                    ++stats.write_failures;
+                    ok = false;
+                }
+                chunk.clear();
+                spare.swap(chunk);
+            }
+            flushing = false;
+            flushed.notify_all();
+            return ok;
+        }
+    };
+
+    std::unique_ptr<EventRecorder> EventRecorder::Create(const std::filesystem::path& path,
+        PluginPtr<IEventBus> bus, std::string& out_error_message, size_t flush_bytes) {
+        if (!bus) {
+            out_error_message = "EventRecorder: event bus is null";
+            return nullptr;
+        }
+        auto impl = std::make_unique<Impl>();
+        impl->file.open(path, std::ios::binary | std::ios::trunc);
+        if (!impl->file) {
+            out_error_message = "EventRecorder: cannot create '" + path.string() + "'";
+            return nullptr;
+        }
+        std::string header(kMagic, sizeof(kMagic));
+        PutU32(header, kVersion);
+        PutU32(header, 0);
+        PutU64(header, UnixNowNs());
+        impl->file.write(header.data(), static_cast<std::streamsize>(header.size()));
+        impl->file.flush();
+        if (!impl->file) {
+            out_error_message = "EventRecorder: cannot write '" + path.string() + "'";
+            return nullptr;
+        }
+        impl->flush_bytes = std::max<size_t>(flush_bytes, 1);
+        impl->buffer.reserve(impl->flush_bytes + kMaxRecordOverhead);
+        impl->stats.written_bytes = header.size();
+        impl->last = std::chrono::steady_clock::now();
+        return std::unique_ptr<EventRecorder>(new EventRecorder(std::move(impl), std::move(bus)));
+    }
+
+    EventRecorder::EventRecorder(std::unique_ptr<Impl> impl, PluginPtr<IEventBus> bus)
+        : bus_(std::move(bus)), impl_(std::move(impl)) {
+    }
+
+    EventRecorder::~EventRecorder() { Stop(); }
+
+    bool EventRecorder::BeginRecord(EventId event_id) {
+        std::lock_guard<std::mutex> lock(impl_->mutex);
+        if (impl_->closed) return false;
+        return impl_->recorded.insert(event_id).second;
+    }
+
+    void EventRecorder::AddSink(std::shared_ptr<void> sink, Connection connection) {
+        std::lock_guard<std::mutex> lock(impl_->mutex);
+        impl_->sinks.emplace_back(std::move(sink), std::move(connection));
+    }
+
+    void EventRecorder::Append(EventId event_id, const void* payload, size_t size, bool has_payload) {
+        std::unique_lock<std::mutex> lock(impl_->mutex);
+        if (impl_->closed) return;
+        // 时间戳在锁内读取，文件中的记录因此严格按时间排序
+        const auto now = std::chrono::steady_clock::now();
+        const auto delta = std::chrono::duration_cast<std::chrono::nanoseconds>(now - impl_->last).count();
+        impl_->last = now;
+        std::string& out = impl_->buffer;
+        PutVarint(out, static_cast<uint64_t>(delta > 0 ? delta : 0));
+        PutU64(out, event_id);
+        PutVarint(out, has_payload ? uint64_t(size) + 1 : 0);
+        if (size != 0) out.append(static_cast<const char*>(payload), size);
+        ++impl_->stats.recorded_events;
+        impl_->stats.payload_bytes += size;
+        if (out.size() >= impl_->flush_bytes && !impl_->flushing) impl_->Drain(lock, false);
+    }
+
+    bool EventRecorder::Flush() {
+        std::unique_lock<std::mutex> lock(impl_->mutex);
+        impl_->flushed.wait(lock, [this] { return !impl_->flushing; });
+        if (impl_->closed) return true;
+        const bool ok = impl_->Drain(lock, true);
+        impl_->file.flush();
+        return ok && static_cast<bool>(impl_->file);
+    }
+
+    void EventRecorder::Stop() {
+        std::vector<std::pair<std::shared_ptr<void>, Connection>> sinks;
+        {
+            std::lock_guard<std::mutex> lock(impl_->mutex);
+            if (impl_->closed) return;
+            sinks.swap(impl_->sinks);
+        }
+        for (auto& entry : sinks) entry.second.Disconnect();
+        std::unique_lock<std::mutex> lock(impl_->mutex);
+        impl_->flushed.wait(lock, [this] { return !impl_->flushing; });
+        impl_->Drain(lock, true);
+        impl_->closed = true;
+        impl_->file.close();
+    }
+
+    EventRecorderStats EventRecorder::GetStats() const {
+        std::lock_guard<std::mutex> lock(impl_->mutex);
+        return impl_->stats;
+    }
+
+    // --- EventReplayer ---
+
+    struct EventReplayer::Impl {
+        std::string bytes;  // 整个文件
+        uint64_t start_time_ns = 0;
+        uint64_t event_count = 0;
+
+        std::mutex mutex;
+        std::unordered_map<EventId, Decoder> decoders;
+    };
+
+    std::unique_ptr<EventReplayer> EventReplayer::Open(const std::filesystem::path& path,
+        PluginPtr<IEventBus> bus, std::string& out_error_message) {
+        if (!bus) {
+            out_error_message = "EventReplayer: event bus is null";
+            return nullptr;
+        }
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            out_error_message = "EventReplayer: cannot open '" + path.string() + "'";
+            return nullptr;
+        }
+        auto impl = std::make_unique<Impl>();
+        impl->bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        const auto* data = reinterpret_cast<const unsigned char*>(impl->bytes.data());
+        if (impl->bytes.size() < kHeaderBytes || std::memcmp(data, kMagic, sizeof(kMagic)) != 0) {
+            out_error_message = "EventReplayer: '" + path.string() + "' is not an event recording";
+            return nullptr;
+        }
+        if (GetU32(data + 8) != kVersion) {
+            out_error_message = "EventReplayer: '" + path.string() + "' has an unsupported version";
+            return nullptr;
+        }
+        impl->start_time_ns = GetU64(data + 16);
+
+        const unsigned char* p = data + kHeaderBytes;
+        const unsigned char* end = data + impl->bytes.size();
+        RawRecord rec;
+        while (ParseRecord(p, end, rec)) ++impl->event_count;
+        return std::unique_ptr<EventReplayer>(new EventReplayer(std::move(impl), std::move(bus)));
+    }
+
+    EventReplayer::EventReplayer(std::unique_ptr<Impl> impl, PluginPtr<IEventBus> bus)
+        : bus_(std::move(bus)), impl_(std::move(impl)) {
+    }
+
+    EventReplayer::~EventReplayer() = default;
+
+    void EventReplayer::AddDecoder(EventId event_id, Decoder decoder) {
+        std::lock_guard<std::mutex> lock(impl_->mutex);
+        impl_->decoders[event_id] = decoder;
+    }
+
+    uint64_t EventReplayer::GetStartTimeNs() const { return impl_->start_time_ns; }
+
+    uint64_t EventReplayer::GetEventCount() const { return impl_->event_count; }
+
+    ReplayStats EventReplayer::Run(const ReplayOptions& options) {
+        using namespace std::chrono;
+        std::unordered_map<EventId, Decoder> decoders;
+        {
+            std::lock_guard<std::mutex> lock(impl_->mutex);
+            decoders = impl_->decoders;
+        }
+
+        ReplayStats stats;
+        const bool paced = options.speed > 0.0;
+        const auto* data = reinterpret_cast<const unsigned char*>(impl_->bytes.data());
+        const unsigned char* end = data + impl_->bytes.size();
+        IEventBus& bus = *bus_;
+        const auto begin = steady_clock::now();
+
+        for (uint32_t round = 0; round < options.repeat; ++round) {
+            const auto round_begin = steady_clock::now();
+            const unsigned char* p = data + kHeaderBytes;
+            uint64_t t = 0;
+            RawRecord rec;
+            while (ParseRecord(p, end, rec)) {
+                t += rec.delta_ns;
+                if (paced) {
+                    const auto target = round_begin +
+                        duration_cast<steady_clock::duration>(nanoseconds(static_cast<int64_t>(double(t) / options.speed)));
+                    const auto now = steady_clock::now();
+                    if (now < target) {
+                        WaitUntil(target);
+                    } else {
+                        stats.max_lag_ns = std::max<uint64_t>(stats.max_lag_ns,
+                            static_cast<uint64_t>(duration_cast<nanoseconds>(now - target).count()));
+                    }
+                }
+
+                auto it = decoders.find(rec.event_id);
+                try {
+                    if (it != decoders.end()) {
+                        EventReader reader(rec.payload, rec.size);
+                        it->second(bus, reader);
+                        ++stats.replayed_events;
+                    } else if (options.raw_fallback) {
+                        bus.FireGlobal<event::ReplayedEvent>(rec.event_id, t, rec.has_payload,
+                            std::string(rec.payload, rec.size));
+                        ++stats.raw_events;
+                    } else {
+                        ++stats.unknown_events;
+                    }
+                }
+                catch (...) {
+                    ++stats.decode_failures;
+                }
+            }
+            stats.recorded_ns = t;
+        }
+        stats.elapsed_ns = static_cast<uint64_t>(duration_cast<nanoseconds>(steady_clock::now() - begin).count());
+        return stats;
+    }
+
+}  // namespace z3y
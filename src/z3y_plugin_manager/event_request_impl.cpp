@@ -0,0 +1,138 @@
+﻿/*
+* Copyright [2025] [Yue Liu]
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/**
+ * @file event_request_impl.cpp
+ * @brief [内部] 事件总线请求/应答 (`HandleRequests` / `Request`) 的实现。
+ *
+ * @details
+ * 请求不走发布路径：按请求 EventId 在处理者表中查到唯一的记录，直接执行 (kDirect)
+ * 或投递到处理者的执行器；回复由处理者侧的调用器写回请求状态。
+ * 超时用共享执行器的定时器实现，回复先到时取消定时器 (取消失败也无妨，
+ * 定时器只持有请求状态的弱引用，且 `TryClaim` 保证只有一方生效)。
+ */
+
+#include "plugin_manager_pimpl.h"
+
+#include <cstring>
+
+namespace z3y {
+
+    extern void ReportException(PluginManagerPimpl* pimpl, const std::exception& e);
+    extern void ReportUnknownException(PluginManagerPimpl* pimpl);
+
+    namespace {
+        std::exception_ptr MakeRequestError(RequestErrorCode code, const char* what) {
+            return std::make_exception_ptr(RequestError(code, what));
+        }
+    }  // namespace
+
+    Connection PluginManager::RegisterRequestHandlerImpl(
+        EventId request_id, std::weak_ptr<void> handler,
+        detail::RequestInvoker invoker, const char* response_type,
+        ConnectionType type, std::shared_ptr<IEventExecutor> executor) {
+        auto entry = std::make_shared<PluginManagerPimpl::RequestHandlerEntry>();
+        entry->handler = handler;
+        entry->invoker = std::move(invoker);
+        entry->response_type = response_type;
+        entry->type = type;
+        entry->executor = std::move(executor);
+        entry->ticket = pimpl_->NewTicket(handler, request_id, std::weak_ptr<void>());
+
+        std::shared_ptr<const PluginManagerPimpl::RequestHandlerEntry> replaced;  // 在锁外析构
+        {
+            std::unique_lock<std::shared_mutex> lock(pimpl_->request_handlers_mutex_);
+            auto& slot = pimpl_->request_handlers_[request_id];
+            if (slot && slot->IsAlive()) {
+                throw std::logic_error("z3y: request already has a handler (one handler per request type)");
+            }
+            replaced = std::move(slot);
+            slot = entry;
+        }
+
+        return Connection(entry->ticket.Share());
+    }
+
+    void PluginManager::SendRequestImpl(EventId request_id,
+        std::shared_ptr<detail::RequestStateBase> state,
+        std::chrono::nanoseconds timeout) {
+        std::shared_ptr<const PluginManagerPimpl::RequestHandlerEntry> entry;
+        {
+            std::shared_lock<std::shared_mutex> lock(pimpl_->request_handlers_mutex_);
+            auto it = pimpl_->request_handlers_.find(request_id);
+            if (it != pimpl_->request_handlers_.end() && it->second->IsAlive()) entry = it->second;
+        }
+        if (!entry) {
+            state->Fail(MakeRequestError(RequestErrorCode::kNoHandler, "z3y: no handler for request"));
+            return;
+        }
+        if (std::strcmp(entry->response_type.c_str(), state->ResponseType()) != 0) {
+            state->Fail(MakeRequestError(RequestErrorCode::kTypeMismatch,
+                "z3y: request handler returns a different response type"));
+            return;
+        }
+
+        // 超时：定时器只持有弱引用，回复之后状态随处理任务释放，定时器即使触发也无事可做
+        std::weak_ptr<TaskExecutor> weak_executor = pimpl_->executor_;
+        TimerId timer = 0;
+        if (timeout > std::chrono::nanoseconds::zero()) {
+            std::weak_ptr<detail::RequestStateBase> weak_state = state;
+            timer = pimpl_->executor_->PostDelayed(timeout, [weak_state]() {
+                if (auto s = weak_state.lock()) {
+                    s->Fail(MakeRequestError(RequestErrorCode::kTimeout, "z3y: request timed out"));
+                }
+                }, TaskPriority::kHigh);
+        }
+
+        std::weak_ptr<PluginManager> owner = pimpl_->owner_;
+        auto run = [entry, state, timer, weak_executor, owner]() {
+            // 已超时的请求不再打扰处理者
+            if (state->IsCompleted()) return;
+            std::shared_ptr<void> handler = entry->ticket.Active()
+                ? entry->handler.lock() : nullptr;
+            if (!handler) {
+                state->Fail(MakeRequestError(RequestErrorCode::kHandlerGone,
+                    "z3y: request handler disconnected before the request ran"));
+            } else {
+                try {
+                    entry->invoker(handler, *state);
+                } catch (const std::exception& e) {
+                    // 处理者的异常交给请求者；请求已完成时 (抛自完成回调) 才报告给框架
+                    if (!state->Fail(std::current_exception())) {
+                        if (auto self = owner.lock()) ReportException(self->pimpl_.get(), e);
+                    }
+                } catch (...) {
+                    if (!state->Fail(std::current_exception())) {
+                        if (auto self = owner.lock()) ReportUnknownException(self->pimpl_.get());
+                    }
+                }
+            }
+            if (timer != 0) {
+                if (auto ex = weak_executor.lock()) ex->CancelTimer(timer);
+            }
+            };
+
+        if (entry->executor) {
+            entry->executor->Post(std::move(run));
+        } else if (entry->type == ConnectionType::kDirect) {
+            run();
+        } else if (!pimpl_->executor_->Post(std::move(run), TaskPriority::kNormal)) {
+            if (timer != 0) pimpl_->executor_->CancelTimer(timer);
+            state->Fail(MakeRequestError(RequestErrorCode::kRejected, "z3y: executor is stopped"));
+        }
+    }
+
+}  // namespace z3y
@@ -0,0 +1,233 @@
+﻿/*
+* Copyright [2025] [Yue Liu]
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/**
+ * @file event_trace_recorder.h
+ * @brief [私有头文件] 事件总线内置的二进制追踪记录器。
+ *
+ * @details
+ * [受众：框架维护者]
+ *
+ * **为什么需要它?**
+ * `EventTraceHook` 只能拿到一个 `const char*` 标签，而且用户回调本身就会扰动时序。
+ * 记录器把每个埋点写成一条定长二进制记录，事后再导出为 Chrome Trace / Perfetto 可读的 JSON。
+ *
+ * **结构:**
+ * - 每个写入线程独占一个环形缓冲区 (单生产者)，写入路径无锁、无共享写。
+ * - 环满后覆盖最旧的记录 (只保留最近 `capacity` 条)。
+ * - 导出时按 seqlock 方式读取：先读已发布的 head，复制，再复查写入线程已认领的序号，
+ * 丢弃复制期间可能被覆盖的槽。
+ * 记录字段都是 relaxed 原子量，因此并发导出不存在数据竞争 (x86 上等价于普通 mov)。
+ */
+
+#pragma once
+
+#ifndef Z3Y_SRC_PLUGIN_MANAGER_EVENT_TRACE_RECORDER_H_
+#define Z3Y_SRC_PLUGIN_MANAGER_EVENT_TRACE_RECORDER_H_
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+#include "framework/plugin_manager.h"
+
+namespace z3y {
+
+    /**
+     * @class EventTraceRecorder
+     * @brief 按线程分片的无锁环形追踪缓冲区。
+     */
+    class EventTraceRecorder {
+        /** @brief 一条记录。每个字段单独是原子量，避免导出线程与写入线程的数据竞争。 */
+        struct Slot {
+            std::atomic<uint64_t> timestamp_ns{ 0 };
+            std::atomic<uint64_t> event_id{ 0 };
+            std::atomic<std::uintptr_t> subscriber{ 0 };
+            std::atomic<uint32_t> queue_depth{ 0 };
+            std::atomic<uint32_t> point{ 0 };
+        };
+
+        /** @brief 单个线程的环。只有所属线程写入 `claimed` / `head`。 */
+        struct Ring {
+            Ring(size_t cap, uint32_t index) : slots(new Slot[cap]), mask(cap - 1), thread_index(index) {}
+            std::unique_ptr<Slot[]> slots;
+            const size_t mask;
+            const uint32_t thread_index;
+            alignas(64) std::atomic<uint64_t> claimed{ 0 }; //!< 开始写入前递增
+            std::atomic<uint64_t> head{ 0 };                //!< 写完后发布
+        };
+
+    public:
+        /** @brief 每个线程默认保留的记录数。 */
+        static constexpr size_t kDefaultCapacity = 65536;
+
+        EventTraceRecorder() : id_(NextRecorderId()) {}
+        EventTraceRecorder(const EventTraceRecorder&) = delete;
+        EventTraceRecorder& operator=(const EventTraceRecorder&) = delete;
+
+        /**
+         * @brief 开始新一轮记录。
+         * @param capacity 每线程环容量 (向上取整为 2 的幂)。只对之后首次写入的线程生效。
+         * @details 之前的记录不会被清空，但导出时只返回本轮开始之后的记录。
+         */
+        void Start(size_t capacity) {
+            size_t cap = 64;
+            while (cap < capacity) cap <<= 1;
+            capacity_.store(cap, std::memory_order_relaxed);
+            session_start_ns_.store(NowNs(), std::memory_order_relaxed);
+        }
+
+        /** @brief 写入一条记录 (在触发埋点的线程上调用)。 */
+        void Record(EventTracePoint point, EventId event_id, const void* subscriber, uint32_t queue_depth) {
+            Ring& ring = RingForThisThread();
+            uint64_t seq = ring.head.load(std::memory_order_relaxed);
+            Slot& slot = ring.slots[seq & ring.mask];
+            ring.claimed.store(seq + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);  // 认领先于覆盖可见
+            slot.timestamp_ns.store(NowNs(), std::memory_order_relaxed);
+            slot.event_id.store(static_cast<uint64_t>(event_id), std::memory_order_relaxed);
+            slot.subscriber.store(reinterpret_cast<std::uintptr_t>(subscriber), std::memory_order_relaxed);
+            slot.queue_depth.store(queue_depth, std::memory_order_relaxed);
+            slot.point.store(static_cast<uint32_t>(point), std::memory_order_relaxed);
+            ring.head.store(seq + 1, std::memory_order_release);
+        }
+
+        /** @brief 导出本轮记录，按时间戳排序。可以与写入并发调用。 */
+        std::vector<EventTraceRecord> Collect() const {
+            const uint64_t since = session_start_ns_.load(std::memory_order_relaxed);
+            std::vector<EventTraceRecord> out;
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (const auto& ring : rings_) {
+                const size_t cap = ring->mask + 1;
+                const uint64_t end = ring->head.load(std::memory_order_acquire);
+                const uint64_t begin = end > cap ? end - cap : 0;
+                const size_t first_new = out.size();
+                for (uint64_t seq = begin; seq < end; ++seq) {
+                    const Slot& slot = ring->slots[seq & ring->mask];
+                    EventTraceRecord rec;
+                    rec.timestamp_ns = slot.timestamp_ns.load(std::memory_order_relaxed);
+                    rec.event_id = static_cast<EventId>(slot.event_id.load(std::memory_order_relaxed));
+                    rec.subscriber = slot.subscriber.load(std::memory_order_relaxed);
+                    rec.queue_depth = slot.queue_depth.load(std::memory_order_relaxed);
+                    rec.point = static_cast<EventTracePoint>(slot.point.load(std::memory_order_relaxed));
+                    rec.thread_index = ring->thread_index;
+                    out.push_back(rec);
+                }
+                // 复查：复制期间被写入线程覆盖的槽不可信，丢弃
+                std::atomic_thread_fence(std::memory_order_acquire);
+                const uint64_t after = ring->claimed.load(std::memory_order_relaxed);
+                if (after > begin + cap) {
+                    const size_t clobbered = static_cast<size_t>(std::min<uint64_t>(after - begin - cap, end - begin));
+                    out.erase(out.begin() + first_new, out.begin() + first_new + clobbered);
+                }
+            }
+            out.erase(std::remove_if(out.begin(), out.end(),
+                [since](const EventTraceRecord& r) { return r.timestamp_ns < since; }), out.end());
+            std::sort(out.begin(), out.end(), [](const EventTraceRecord& a, const EventTraceRecord& b) {
+                return a.timestamp_ns < b.timestamp_ns;
+                });
+            return out;
+        }
+
+        /**
+         * @brief 以 Chrome Trace Event 格式 (JSON) 写出记录，可直接拖入 chrome://tracing 或 ui.perfetto.dev。
+         * @details 同步回调与队列任务的开始/结束写成 B/E 区间，其余埋点写成瞬时事件。
+         */
+        static void WriteChromeTrace(std::ostream& os, const std::vector<EventTraceRecord>& records) {
+            static const char* const kNames[] = {
+                "Fired", "DirectCall", "QueuedEntry", "QueuedExecute", "QueuedExecute", "QueuedDropped",
+                "DirectCall" };
+            const uint64_t origin = records.empty() ? 0 : records.front().timestamp_ns;
+            os << "{\"traceEvents\":[";
+            for (size_t i = 0; i < records.size(); ++i) {
+                const auto& r = records[i];
+                const char* phase = "i";
+                if (r.point == EventTracePoint::kQueuedExecuteStart ||
+                    r.point == EventTracePoint::kDirectCallStart) phase = "B";
+                if (r.point == EventTracePoint::kQueuedExecuteEnd ||
+                    r.point == EventTracePoint::kDirectCallEnd) phase = "E";
+                const auto index = static_cast<size_t>(r.point);
+                const char* name = index < sizeof(kNames) / sizeof(kNames[0]) ? kNames[index] : "Unknown";
+                const uint64_t rel_ns = r.timestamp_ns - origin;
+                if (i != 0) os << ',';
+                os << "\n{\"name\":\"" << name << "\",\"cat\":\"z3y.event\",\"ph\":\"" << phase << '"'
+                    << ",\"ts\":" << rel_ns / 1000 << '.' << (rel_ns % 1000) / 100
+                    << ",\"pid\":1,\"tid\":" << r.thread_index;
+                if (phase[0] == 'i') os << ",\"s\":\"t\"";
+                os << ",\"args\":{\"event_id\":" << static_cast<uint64_t>(r.event_id)
+                    << ",\"subscriber\":" << static_cast<uint64_t>(r.subscriber)
+                    << ",\"queue_depth\":" << r.queue_depth << "}}";
+            }
+            os << "\n],\"displayTimeUnit\":\"ns\"}\n";
+        }
+
+    private:
+        static uint64_t NowNs() {
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count());
+        }
+
+        /** @brief 进程内唯一的记录器编号。线程缓存用它而不是地址识别记录器 (地址可能被复用)。 */
+        static uint64_t NextRecorderId() {
+            static std::atomic<uint64_t> next{ 1 };
+            return next.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        Ring& RingForThisThread() {
+            struct Cache {
+                uint64_t recorder_id = 0;
+                Ring* ring = nullptr;
+            };
+            thread_local Cache cache;
+            if (cache.recorder_id == id_) return *cache.ring;
+
+            // 慢路径：本线程首次写入该记录器 (或在多个记录器之间切换)
+            std::lock_guard<std::mutex> lock(mutex_);
+            const auto self = std::this_thread::get_id();
+            Ring* ring = nullptr;
+            for (size_t i = 0; i < owners_.size(); ++i) {
+                if (owners_[i] == self) { ring = rings_[i].get(); break; }
+            }
+            if (!ring) {
+                rings_.push_back(std::make_unique<Ring>(capacity_.load(std::memory_order_relaxed),
+                    static_cast<uint32_t>(rings_.size())));
+                owners_.push_back(self);
+                ring = rings_.back().get();
+            }
+            cache.recorder_id = id_;
+            cache.ring = ring;
+            return *ring;
+        }
+
+        const uint64_t id_;
+        std::atomic<size_t> capacity_{ kDefaultCapacity };
+        std::atomic<uint64_t> session_start_ns_{ 0 };
+
+        mutable std::mutex mutex_;
+        std::vector<std::unique_ptr<Ring>> rings_;
+        std::vector<std::thread::id> owners_;  //!< 与 rings_ 一一对应
+    };
+
+}  // namespace z3y
+
+#endif  // Z3Y_SRC_PLUGIN_MANAGER_EVENT_TRACE_RECORDER_H_
@@ -0,0 +1,58 @@
+﻿/*
+* Copyright [2025] [Yue Liu]
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/**
+ * @file executor_impl.cpp
+ * @brief `PluginManager` 中关于 `IExecutorService` 的部分。
+ *
+ * @details
+ * 全部转发给 Pimpl 持有的 `TaskExecutor` (见 task_executor.h)。
+ */
+
+#include "plugin_manager_pimpl.h"
+
+namespace z3y {
+
+    bool PluginManager::Post(std::function<void()> task, TaskPriority priority) {
+        return pimpl_->executor_->Post(std::move(task), priority);
+    }
+
+    TimerId PluginManager::PostDelayed(std::chrono::nanoseconds delay, std::function<void()> task,
+        TaskPriority priority) {
+        return pimpl_->executor_->PostDelayed(delay, std::move(task), priority);
+    }
+
+    bool PluginManager::CancelTimer(TimerId timer) {
+        return pimpl_->executor_->CancelTimer(timer);
+    }
+
+    std::shared_ptr<IEventExecutor> PluginManager::GetSerialQueue(const std::string& name) {
+        return pimpl_->executor_->GetSerialQueue(name);
+    }
+
+    std::shared_ptr<IEventExecutor> PluginManager::MakeStrand() {
+        return pimpl_->executor_->MakeStrand();
+    }
+
+    size_t PluginManager::GetWorkerCount() const {
+        return pimpl_->executor_->WorkerCount();
+    }
+
+    ExecutorStats PluginManager::GetExecutorStats() const {
+        return pimpl_->executor_->Stats();
+    }
+
+}  // namespace z3y
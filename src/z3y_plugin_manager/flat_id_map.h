@@ -0,0 +1,237 @@
+﻿/*
+* Copyright [2025] [Yue Liu]
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/**
+ * @file flat_id_map.h
+ * @brief [私有头文件] 以 64 位 ID (ClassId / InterfaceId) 为键的开放寻址哈希表。
+ *
+ * @details
+ * [受众：框架维护者]
+ *
+ * **为什么不用 std::unordered_map?**
+ * 注册表在加载完整插件集后有上千个组件，`unordered_map` 的每个条目都是单独分配的节点，
+ * 每次查找都要先读桶数组、再跳到节点，容易产生两次缓存未命中。
+ *
+ * **方案:**
+ * - 键和值直接存放在一个连续数组中，线性探测，负载因子不超过 3/4。
+ * - ClassId / InterfaceId 本身就是分布良好的 FNV-1a 哈希，直接取低位作为起始槽，不再二次哈希。
+ * - 删除采用回移 (backward shift)，没有墓碑，探测链始终紧凑。
+ *
+ * `AliasIndex` 在此基础上以别名的 FNV-1a 哈希为键，使 `string_view` 查找不需要构造 `std::string`。
+ *
+ * @warning 插入或删除可能移动其他条目，此前取得的值指针/引用随即失效。
+ * 需要稳定地址的值 (例如带 `std::once_flag` 的单例持有者) 应当存放 `std::unique_ptr`。
+ */
+
+#pragma once
+
+#ifndef Z3Y_SRC_PLUGIN_MANAGER_FLAT_ID_MAP_H_
+#define Z3Y_SRC_PLUGIN_MANAGER_FLAT_ID_MAP_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace z3y {
+
+    /**
+     * @class FlatIdMap
+     * @brief `uint64_t -> V` 的开放寻址表。V 必须可默认构造、可移动。不是线程安全的。
+     */
+    template <typename V>
+    class FlatIdMap {
+        struct Slot {
+            uint64_t key = 0;
+            bool used = false;
+            V value{};
+        };
+
+    public:
+        FlatIdMap() = default;
+
+        [[nodiscard]] size_t size() const noexcept { return size_; }
+        [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+
+        /** @brief 查找键；不存在返回 nullptr。 */
+        [[nodiscard]] V* Find(uint64_t key) noexcept {
+            if (slots_.empty()) return nullptr;
+            for (size_t i = Home(key);; i = Next(i)) {
+                Slot& slot = slots_[i];
+                if (!slot.used) return nullptr;
+                if (slot.key == key) return &slot.value;
+            }
+        }
+
+        [[nodiscard]] const V* Find(uint64_t key) const noexcept {
+            return const_cast<FlatIdMap*>(this)->Find(key);
+        }
+
+        [[nodiscard]] bool Contains(uint64_t key) const noexcept { return Find(key) != nullptr; }
+
+        /**
+         * @brief 查找键，不存在则插入一个默认构造的值。
+         * @return {值的引用, 是否为新插入}
+         */
+        std::pair<V*, bool> TryEmplace(uint64_t key) {
+            if ((size_ + 1) * 4 > slots_.size() * 3) Grow();
+            for (size_t i = Home(key);; i = Next(i)) {
+                Slot& slot = slots_[i];
+                if (!slot.used) {
+                    slot.used = true;
+                    slot.key = key;
+                    ++size_;
+                    return { &slot.value, true };
+                }
+                if (slot.key == key) return { &slot.value, false };
+            }
+        }
+
+        V& operator[](uint64_t key) { return *TryEmplace(key).first; }
+
+        /** @brief 删除键。返回是否存在。 */
+        bool Erase(uint64_t key) {
+            if (slots_.empty()) return false;
+            size_t hole = Home(key);
+            for (;; hole = Next(hole)) {
+                if (!slots_[hole].used) return false;
+                if (slots_[hole].key == key) break;
+            }
+            // 回移：把探测链上后续、起始槽不在 (hole, i] 区间内的条目挪进空洞
+            for (size_t i = Next(hole);; i = Next(i)) {
+                Slot& slot = slots_[i];
+                if (!slot.used) break;
+                const size_t home = Home(slot.key);
+                const bool stays = hole < i ? (hole < home && home <= i) : (hole < home || home <= i);
+                if (stays) continue;
+                slots_[hole].key = slot.key;
+                slots_[hole].value = std::move(slot.value);
+                hole = i;
+            }
+            slots_[hole].used = false;
+            slots_[hole].value = V{};
+            --size_;
+            return true;
+        }
+
+        void Clear() {
+            slots_.clear();
+            size_ = 0;
+        }
+
+        /** @brief 预留容量：总条目数不超过 n 时不再扩容。 */
+        void Reserve(size_t n) {
+            size_t capacity = slots_.empty() ? kInitialCapacity : slots_.size();
+            while (n * 4 > capacity * 3) capacity *= 2;
+            if (capacity != slots_.size()) Rehash(capacity);
+        }
+
+        /** @brief 遍历所有条目：`fn(uint64_t key, V& value)`。顺序不确定，遍历期间不能增删。 */
+        template <typename Fn>
+        void ForEach(Fn&& fn) {
+            for (auto& slot : slots_) {
+                if (slot.used) fn(slot.key, slot.value);
+            }
+        }
+
+        template <typename Fn>
+        void ForEach(Fn&& fn) const {
+            for (const auto& slot : slots_) {
+                if (slot.used) fn(slot.key, slot.value);
+            }
+        }
+
+    private:
+        static constexpr size_t kInitialCapacity = 16;
+
+        size_t Home(uint64_t key) const noexcept { return static_cast<size_t>(key) & (slots_.size() - 1); }
+        size_t Next(size_t i) const noexcept { return (i + 1) & (slots_.size() - 1); }
+
+        void Grow() { Rehash(slots_.empty() ? kInitialCapacity : slots_.size() * 2); }
+
+        void Rehash(size_t capacity) {
+            std::vector<Slot> old = std::move(slots_);
+            slots_ = std::vector<Slot>(capacity);
+            for (auto& slot : old) {
+                if (!slot.used) continue;
+                size_t i = Home(slot.key);
+                while (slots_[i].used) i = Next(i);
+                slots_[i].used = true;
+                slots_[i].key = slot.key;
+                slots_[i].value = std::move(slot.value);
+            }
+        }
+
+        std::vector<Slot> slots_;  //!< 容量始终为 0 或 2 的幂
+        size_t size_ = 0;
+    };
+
+    /**
+     * @class AliasIndex
+     * @brief 别名 -> ClassId 索引。键是调用方预先算好的 `ConstexprHash(alias)`。
+     * @details 哈希相同的不同别名 (极少见) 放在同一个小向量里，按全文比较区分。
+     */
+    class AliasIndex {
+        struct Entry {
+            std::string alias;
+            uint64_t clsid;
+        };
+
+    public:
+        /** @brief 插入或覆盖。 */
+        void Insert(std::string_view alias, uint64_t hash, uint64_t clsid) {
+            auto& bucket = buckets_[hash];
+            for (auto& entry : bucket) {
+                if (entry.alias == alias) { entry.clsid = clsid; return; }
+            }
+            bucket.push_back(Entry{ std::string(alias), clsid });
+        }
+
+        /** @brief 查找；不存在返回 nullptr。不分配内存。 */
+        [[nodiscard]] const uint64_t* Find(std::string_view alias, uint64_t hash) const noexcept {
+            const auto* bucket = buckets_.Find(hash);
+            if (!bucket) return nullptr;
+            for (const auto& entry : *bucket) {
+                if (entry.alias == alias) return &entry.clsid;
+            }
+            return nullptr;
+        }
+
+        void Erase(std::string_view alias, uint64_t hash) {
+            auto* bucket = buckets_.Find(hash);
+            if (!bucket) return;
+            for (auto it = bucket->begin(); it != bucket->end(); ++it) {
+                if (it->alias == alias) { bucket->erase(it); break; }
+            }
+            if (bucket->empty()) buckets_.Erase(hash);
+        }
+
+        void Clear() { buckets_.Clear(); }
+
+        /** @brief 为 n 个别名预留容量。 */
+        void Reserve(size_t n) { buckets_.Reserve(n); }
+
+        [[nodiscard]] size_t size() const noexcept { return buckets_.size(); }
+
+    private:
+        FlatIdMap<std::vector<Entry>> buckets_;
+    };
+
+}  // namespace z3y
+
+#endif  // Z3Y_SRC_PLUGIN_MANAGER_FLAT_ID_MAP_H_
@@ -0,0 +1,261 @@
+﻿/*
+* Copyright [2025] [Yue Liu]
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/**
+ * @file ipc_event_bridge.cpp
+ * @brief [内部] `IpcEventBridge` 的实现：共享内存段的建立、发送与接收线程。
+ */
+
+#include "framework/ipc_event_bridge.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include "framework/thread_placement.h"
+#include "shm_ring.h"
+
+namespace z3y {
+
+    namespace {
+        constexpr size_t kMinRingBytes = size_t(64) << 10;
+
+        /** @brief 当前线程正在发布导入事件 (见 `IpcEventBridge::IsDispatchingImported`)。 */
+        thread_local bool t_dispatching_imported = false;
+
+        bool IsValidName(const std::string& name) {
+            if (name.empty() || name.size() > 64) return false;
+            return std::all_of(name.begin(), name.end(), [](char c) {
+                return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+                    c == '-' || c == '_' || c == '.';
+                });
+        }
+
+        size_t RoundRingBytes(size_t bytes) {
+            size_t n = kMinRingBytes;
+            while (n < bytes) n <<= 1;
+            return n;
+        }
+
+        char* RingData(ShmSegmentHeader* header, int index) {
+            return reinterpret_cast<char*>(header) + sizeof(ShmSegmentHeader) +
+                static_cast<size_t>(index) * static_cast<size_t>(header->ring_bytes);
+        }
+    }  // namespace
+
+    struct IpcEventBridge::Impl {
+        SharedMemoryRegion region;
+        ShmSegmentHeader* header = nullptr;
+        int self = 0;  // 0: 创建者，1: 对端
+        ShmRing send_ring;
+        ShmRing recv_ring;
+        std::mutex send_mutex;  // 本进程内的多个发布线程串行写入发送环
+
+        std::mutex table_mutex;
+        std::unordered_map<EventId, Decoder> decoders;
+        std::unordered_set<EventId> exported;
+        std::vector<std::pair<std::shared_ptr<void>, Connection>> exports;
+
+        std::atomic<uint64_t> sent{ 0 };
+        std::atomic<uint64_t> received{ 0 };
+        std::atomic<uint64_t> dropped{ 0 };
+        std::atomic<uint64_t> unknown{ 0 };
+        std::atomic<uint64_t> decode_failures{ 0 };
+
+        std::atomic<bool> stop{ false };
+        std::thread receiver;
+
+        ~Impl() {
+            if (header) header->attached[self].store(0, std::memory_order_release);
+            PlatformCloseSharedMemory(region);
+        }
+
+        void Bind(int index) {
+            self = index;
+            send_ring = ShmRing(&header->rings[index], RingData(header, index), header->ring_bytes);
+            recv_ring = ShmRing(&header->rings[1 - index], RingData(header, 1 - index), header->ring_bytes);
+        }
+
+        void Dispatch(IEventBus& bus, EventId event_id, const char* payload, size_t size) {
+            Decoder decoder = nullptr;
+            {
+                std::lock_guard<std::mutex> lock(table_mutex);
+                auto it = decoders.find(event_id);
+                if (it != decoders.end()) decoder = it->second;
+            }
+            if (!decoder) {
+                unknown.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            EventReader reader(payload, size);
+            t_dispatching_imported = true;
+            try {
+                decoder(bus, reader);
+                received.fetch_add(1, std::memory_order_relaxed);
+            }
+            catch (...) {
+                decode_failures.fetch_add(1, std::memory_order_relaxed);
+            }
+            t_dispatching_imported = false;
+        }
+
+        /** @brief 接收循环：有数据时连续处理，空闲时自旋 → 让出 → 短睡眠 (最长 1 ms)。 */
+        void Run(IEventBus* bus) {
+            (void)PlaceCurrentThread(thread_role::kIpcReceiver);
+            unsigned idle = 0;
+            while (!stop.load(std::memory_order_acquire)) {
+                const size_t n = recv_ring.Drain([&](uint64_t event_id, const char* payload, size_t size) {
+                    Dispatch(*bus, event_id, payload, size);
+                    });
+                if (n != 0) {
+                    idle = 0;
+                    continue;
+                }
+                ++idle;
+                if (idle < 64) continue;
+                if (idle < 128) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                const unsigned shift = std::min(idle - 128, 4u);
+                std::this_thread::sleep_for(std::chrono::microseconds(std::min(62u << shift, 1000u)));
+            }
+        }
+    };
+
+    std::unique_ptr<IpcEventBridge> IpcEventBridge::Create(const std::string& name,
+        PluginPtr<IEventBus> bus, std::string& out_error_message, size_t ring_bytes) {
+        if (!bus) {
+            out_error_message = "IpcEventBridge: event bus is null";
+            return nullptr;
+        }
+        if (!IsValidName(name)) {
+            out_error_message = "IpcEventBridge: invalid segment name '" + name + "'";
+            return nullptr;
+        }
+        ring_bytes = RoundRingBytes(ring_bytes);
+        auto impl = std::make_unique<Impl>();
+        if (!PlatformOpenSharedMemory(name, sizeof(ShmSegmentHeader) + 2 * ring_bytes, true,
+            impl->region, out_error_message)) {
+            return nullptr;
+        }
+
+        impl->header = new (impl->region.base) ShmSegmentHeader{};
+        impl->header->version = ShmSegmentHeader::kVersion;
+        impl->header->ring_bytes = ring_bytes;
+        impl->header->attached[0].store(1, std::memory_order_relaxed);
+        impl->header->magic.store(ShmSegmentHeader::kMagic, std::memory_order_release);
+        impl->Bind(0);
+        return std::unique_ptr<IpcEventBridge>(new IpcEventBridge(std::move(impl), std::move(bus)));
+    }
+
+    std::unique_ptr<IpcEventBridge> IpcEventBridge::Open(const std::string& name,
+        PluginPtr<IEventBus> bus, std::string& out_error_message) {
+        if (!bus) {
+            out_error_message = "IpcEventBridge: event bus is null";
+            return nullptr;
+        }
+        if (!IsValidName(name)) {
+            out_error_message = "IpcEventBridge: invalid segment name '" + name + "'";
+            return nullptr;
+        }
+        auto impl = std::make_unique<Impl>();
+        if (!PlatformOpenSharedMemory(name, 0, false, impl->region, out_error_message)) {
+            return nullptr;
+        }
+
+        auto* header = static_cast<ShmSegmentHeader*>(impl->region.base);
+        if (impl->region.size < sizeof(ShmSegmentHeader) ||
+            header->magic.load(std::memory_order_acquire) != ShmSegmentHeader::kMagic ||
+            header->version != ShmSegmentHeader::kVersion ||
+            impl->region.size < sizeof(ShmSegmentHeader) + 2 * header->ring_bytes) {
+            out_error_message = "IpcEventBridge: segment '" + name + "' has an incompatible layout";
+            return nullptr;
+        }
+        uint32_t expected = 0;
+        if (!header->attached[1].compare_exchange_strong(expected, 1, std::memory_order_acq_rel)) {
+            out_error_message = "IpcEventBridge: segment '" + name + "' already has a peer";
+            return nullptr;
+        }
+        impl->header = header;
+        impl->Bind(1);
+        return std::unique_ptr<IpcEventBridge>(new IpcEventBridge(std::move(impl), std::move(bus)));
+    }
+
+    IpcEventBridge::IpcEventBridge(std::unique_ptr<Impl> impl, PluginPtr<IEventBus> bus)
+        : bus_(std::move(bus)), impl_(std::move(impl)) {
+        impl_->receiver = std::thread(&Impl::Run, impl_.get(), bus_.get());
+    }
+
+    IpcEventBridge::~IpcEventBridge() {
+        std::vector<std::pair<std::shared_ptr<void>, Connection>> exports;
+        {
+            std::lock_guard<std::mutex> lock(impl_->table_mutex);
+            exports.swap(impl_->exports);
+        }
+        for (auto& entry : exports) entry.second.Disconnect();
+        impl_->stop.store(true, std::memory_order_release);
+        if (impl_->receiver.joinable()) impl_->receiver.join();
+    }
+
+    bool IpcEventBridge::IsDispatchingImported() noexcept { return t_dispatching_imported; }
+
+    bool IpcEventBridge::BeginExport(EventId event_id) {
+        std::lock_guard<std::mutex> lock(impl_->table_mutex);
+        return impl_->exported.insert(event_id).second;
+    }
+
+    void IpcEventBridge::AddExport(std::shared_ptr<void> sink, Connection connection) {
+        std::lock_guard<std::mutex> lock(impl_->table_mutex);
+        impl_->exports.emplace_back(std::move(sink), std::move(connection));
+    }
+
+    void IpcEventBridge::AddImport(EventId event_id, Decoder decoder) {
+        std::lock_guard<std::mutex> lock(impl_->table_mutex);
+        impl_->decoders.emplace(event_id, decoder);
+    }
+
+    void IpcEventBridge::Send(EventId event_id, const void* payload, size_t size) {
+        bool written;
+        {
+            std::lock_guard<std::mutex> lock(impl_->send_mutex);
+            written = impl_->send_ring.TryWrite(event_id, payload, size);
+        }
+        (written ? impl_->sent : impl_->dropped).fetch_add(1, std::memory_order_relaxed);
+    }
+
+    bool IpcEventBridge::IsPeerAttached() const {
+        return impl_->header->attached[1 - impl_->self].load(std::memory_order_acquire) != 0;
+    }
+
+    IpcBridgeStats IpcEventBridge::GetStats() const {
+        IpcBridgeStats stats;
+        stats.sent_events = impl_->sent.load(std::memory_order_relaxed);
+        stats.received_events = impl_->received.load(std::memory_order_relaxed);
+        stats.dropped_events = impl_->dropped.load(std::memory_order_relaxed);
+        stats.unknown_events = impl_->unknown.load(std::memory_order_relaxed);
+        stats.decode_failures = impl_->decode_failures.load(std::memory_order_relaxed);
+        stats.send_ring_used_bytes = impl_->send_ring.UsedBytes();
+        return stats;
+    }
+
+}  // namespace z3y
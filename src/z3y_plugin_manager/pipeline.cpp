@@ -0,0 +1,560 @@
+﻿/*
+* Copyright [2025] [Yue Liu]
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/**
+ * @file pipeline.cpp
+ * @brief [内部] `Pipeline` 的实现：有界通道、阶段任务的调度与背压，以及管线追踪钩子。
+ *
+ * @details
+ * 每个阶段的输入通道是一个 `BoundedTaskQueue`，容量由 `depth` 计数先行占位来保证
+ * (环形区向上取整为 2 的幂，只在占位与发布交错的瞬间可能用到溢出区)。
+ * 调度不阻塞工作线程：下一级满时，本级把发出的条目暂存进 `stalled` 后让出线程，
+ * 由下一级取走条目时 (`OnPopped`) 重新调度本级。
+ */
+
+#include "framework/pipeline.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include "framework/plugin_manager.h"
+#include "lock_free_queue.h"
+
+namespace z3y {
+
+    namespace {
+        /** @brief 已安装的钩子。整体替换，读者拿到的指针在 in_flight 归零前不会被释放。 */
+        struct HookSlot {
+            PipelineTraceHook hook;
+            void* context;
+        };
+
+        std::atomic<const HookSlot*> g_pipeline_hook{ nullptr };
+        std::atomic<uint32_t> g_pipeline_hook_calls{ 0 };  //!< 进行中的钩子调用数
+        std::atomic<uint64_t> g_next_frame{ 0 };
+
+        constexpr uint64_t kFrameBit = uint64_t{ 1 } << 63;  //!< 与 ASYNC 宏常用的小整数帧号错开
+        constexpr size_t kBatchPerTask = 64;  //!< 一个任务最多连续处理的条目数，之后让出线程
+
+        void ReportPipelineSample(const PipelineTraceSample& sample) noexcept {
+            g_pipeline_hook_calls.fetch_add(1, std::memory_order_seq_cst);
+            if (const HookSlot* slot = g_pipeline_hook.load(std::memory_order_seq_cst)) {
+                slot->hook(sample, slot->context);
+            }
+            g_pipeline_hook_calls.fetch_sub(1, std::memory_order_seq_cst);
+        }
+
+        uint64_t NowNs() {
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count());
+        }
+
+        /** @brief 被追踪的一帧：最后一个引用它的条目离开管线时上报 kItemEnd。 */
+        struct PipelineFrame {
+            const char* pipeline = nullptr;
+            uint64_t frame_id = 0;
+
+            ~PipelineFrame() {
+                PipelineTraceSample sample;
+                sample.point = PipelineTracePoint::kItemEnd;
+                sample.pipeline = pipeline;
+                sample.frame_id = frame_id;
+                ReportPipelineSample(sample);
+            }
+        };
+
+        /** @brief 通道中的一个条目。 */
+        struct Envelope {
+            PipelineItem item;
+            uint64_t enqueued_ns = 0;
+            std::shared_ptr<PipelineFrame> frame;  //!< 未被追踪时为空
+        };
+
+        /** @brief 收集一次 `Process` 发出的条目。 */
+        class Collector final : public PipelineEmitter {
+        public:
+            void Emit(PipelineItem item) override { items.push_back(std::move(item)); }
+            std::vector<PipelineItem> items;
+        };
+
+        void UpdateMax(std::atomic<size_t>& target, size_t value) {
+            size_t current = target.load(std::memory_order_relaxed);
+            while (current < value &&
+                !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+            }
+        }
+    }  // namespace
+
+    void SetPipelineTraceHook(PipelineTraceHook hook, void* context) {
+        static std::mutex install_mutex;  // 串行化安装：否则两个安装者可能释放同一个旧钩子
+        std::lock_guard<std::mutex> lock(install_mutex);
+        const HookSlot* next = hook ? new HookSlot{ hook, context } : nullptr;
+        const HookSlot* old = g_pipeline_hook.exchange(next, std::memory_order_seq_cst);
+        while (g_pipeline_hook_calls.load(std::memory_order_seq_cst) != 0) std::this_thread::yield();
+        delete old;
+    }
+
+    bool IsPipelineTraceHookInstalled() noexcept {
+        return g_pipeline_hook.load(std::memory_order_relaxed) != nullptr;
+    }
+
+    struct Pipeline::Impl : public std::enable_shared_from_this<Pipeline::Impl> {
+        /** @brief 一个阶段及其输入通道。 */
+        struct Stage {
+            explicit Stage(size_t cap) : input(cap) {}
+
+            std::string name;
+            uint32_t index = 0;
+            size_t parallelism = 1;
+            size_t capacity = 1;
+            BoundedTaskQueue<Envelope> input;
+            std::atomic<size_t> depth{ 0 };      //!< 已占位的条目数 (先占位再入队)
+            std::atomic<size_t> max_depth{ 0 };
+            std::atomic<size_t> active{ 0 };     //!< 已投递或正在执行的任务数
+
+            PluginPtr<IPipelineStage> shared_instance;
+            std::mutex instance_mutex;
+            std::vector<PluginPtr<IPipelineStage>> idle_instances;  //!< 每个并行任务一个
+
+            std::mutex stalled_mutex;
+            std::deque<Envelope> stalled;            //!< 下一级已满时暂存的条目 (保持顺序)
+            std::atomic<size_t> stalled_count{ 0 };
+
+            std::atomic<uint64_t> processed{ 0 };
+            std::atomic<uint64_t> emitted{ 0 };
+            std::atomic<uint64_t> failed{ 0 };
+            std::atomic<uint64_t> stalls{ 0 };
+            std::atomic<uint64_t> busy_ns{ 0 };
+            std::atomic<uint64_t> wait_ns{ 0 };
+        };
+
+        std::string name;
+        std::function<void(PipelineItem)> sink;
+        std::function<void(const std::string&, std::exception_ptr)> error_handler;
+        TaskPriority priority = TaskPriority::kNormal;
+        PluginPtr<IExecutorService> executor;
+        std::vector<std::unique_ptr<Stage>> stages;
+        uint64_t created_ns = NowNs();
+
+        std::atomic<bool> closed{ false };
+        std::atomic<uint64_t> next_sequence{ 0 };
+        std::atomic<uint64_t> pushed{ 0 };
+        std::atomic<uint64_t> delivered{ 0 };
+        std::atomic<uint64_t> dropped{ 0 };
+        std::atomic<uint64_t> in_flight{ 0 };
+
+        std::mutex wait_mutex;
+        std::condition_variable space_cv;  //!< 第一级有了空位 (或已关闭)
+        std::condition_variable idle_cv;   //!< 管线已空
+        std::atomic<uint32_t> space_waiters{ 0 };
+        std::atomic<uint32_t> idle_waiters{ 0 };
+
+        /** @brief 在 `s` 的通道中占一个位置。 */
+        bool TryAdmit(Stage& s) {
+            size_t depth = s.depth.load(std::memory_order_seq_cst);
+            do {
+                if (depth >= s.capacity) return false;
+            } while (!s.depth.compare_exchange_weak(depth, depth + 1, std::memory_order_seq_cst));
+            UpdateMax(s.max_depth, depth + 1);
+            return true;
+        }
+
+        /** @brief [已占位] 把条目放入第 k 级的通道并调度该级。 */
+        void Enqueue(size_t k, Envelope&& env) {
+            env.enqueued_ns = NowNs();
+            stages[k]->input.Push(std::move(env));
+            Schedule(k);
+        }
+
+        /** @brief 第 k 级是否有可做的事：有暂存条目时看下一级是否有空位，否则看通道是否非空。 */
+        bool HasWork(size_t k) {
+            Stage& s = *stages[k];
+            if (s.stalled_count.load(std::memory_order_seq_cst) > 0) {
+                Stage& next = *stages[k + 1];
+                return next.depth.load(std::memory_order_seq_cst) < next.capacity;
+            }
+            return s.depth.load(std::memory_order_seq_cst) > 0;
+        }
+
+        /** @brief 第 k 级任务数未满且有事可做时投递一个任务。 */
+        void Schedule(size_t k) {
+            Stage& s = *stages[k];
+            size_t active = s.active.load(std::memory_order_seq_cst);
+            do {
+                if (active >= s.parallelism || !HasWork(k)) return;
+            } while (!s.active.compare_exchange_weak(active, active + 1, std::memory_order_seq_cst));
+            auto self = shared_from_this();
+            if (!executor->Post([self, k] { self->RunStage(k); }, priority)) {
+                s.active.fetch_sub(1, std::memory_order_seq_cst);
+                // 执行器已停止：通道与暂存区中的条目永远不会再被处理
+                for (size_t i = 0; i < stages.size(); ++i) DropQueued(i);
+            }
+        }
+
+        /** @brief 一个阶段任务：先送出暂存条目，再逐个处理通道中的条目。 */
+        void RunStage(size_t k) {
+            Stage& s = *stages[k];
+            PluginPtr<IPipelineStage> instance = AcquireInstance(s);
+            Collector out;
+            for (size_t handled = 0; handled < kBatchPerTask; ++handled) {
+                if (s.stalled_count.load(std::memory_order_seq_cst) > 0 && !FlushStalled(k)) break;
+                Envelope env;
+                if (!s.input.TryPop(env)) break;
+                s.depth.fetch_sub(1, std::memory_order_seq_cst);
+                OnPopped(k);
+                ProcessOne(k, *instance, env, out);
+            }
+            ReleaseInstance(s, std::move(instance));
+            s.active.fetch_sub(1, std::memory_order_seq_cst);
+            // 与 Enqueue / OnPopped 的“先改计数、后调度”配对，不会漏掉期间到达的条目
+            if (HasWork(k)) Schedule(k);
+        }
+
+        void ProcessOne(size_t k, IPipelineStage& instance, Envelope& env, Collector& out) {
+            Stage& s = *stages[k];
+            const uint64_t start = NowNs();
+            const uint64_t wait = start - env.enqueued_ns;
+            const uint64_t frame_id = env.frame ? env.frame->frame_id : 0;
+            PipelineTraceSample sample;
+            if (frame_id) {
+                sample.pipeline = name.c_str();
+                sample.stage = s.name.c_str();
+                sample.stage_index = s.index;
+                sample.frame_id = frame_id;
+                sample.wait_ns = wait;
+                sample.queue_depth = s.depth.load(std::memory_order_relaxed);
+                sample.point = PipelineTracePoint::kStageStart;
+                ReportPipelineSample(sample);
+            }
+
+            out.items.clear();
+            bool ok = true;
+            try {
+                instance.Process(env.item, out);
+            } catch (...) {
+                ok = false;
+                ReportError(s.name, std::current_exception());
+            }
+            const uint64_t busy = NowNs() - start;
+            s.busy_ns.fetch_add(busy, std::memory_order_relaxed);
+            s.wait_ns.fetch_add(wait, std::memory_order_relaxed);
+            s.processed.fetch_add(1, std::memory_order_relaxed);
+            if (frame_id) {
+                sample.busy_ns = busy;
+                sample.point = PipelineTracePoint::kStageEnd;
+                ReportPipelineSample(sample);
+            }
+
+            if (!ok) {
+                out.items.clear();  // 抛出前发出的条目一并丢弃
+                s.failed.fetch_add(1, std::memory_order_relaxed);
+                dropped.fetch_add(1, std::memory_order_relaxed);
+            }
+            s.emitted.fetch_add(out.items.size(), std::memory_order_relaxed);
+            // 先计入派生条目再扣掉当前条目，in_flight 不会短暂归零
+            in_flight.fetch_add(out.items.size(), std::memory_order_seq_cst);
+            for (PipelineItem& item : out.items) {
+                if (item.sequence == 0) item.sequence = env.item.sequence;
+                Forward(k, Envelope{ std::move(item), 0, env.frame });
+            }
+            out.items.clear();
+            env = Envelope();  // 释放本条目对帧的引用
+            Finish(1);
+        }
+
+        /** @brief 第 k 级发出的条目：交给下一级 (满则暂存) 或 sink。 */
+        void Forward(size_t k, Envelope&& env) {
+            if (k + 1 == stages.size()) {
+                if (sink) {
+                    try {
+                        sink(std::move(env.item));
+                    } catch (...) {
+                        ReportError(std::string(), std::current_exception());
+                    }
+                }
+                delivered.fetch_add(1, std::memory_order_relaxed);
+                env = Envelope();
+                Finish(1);
+                return;
+            }
+            Stage& s = *stages[k];
+            Stage& next = *stages[k + 1];
+            std::lock_guard<std::mutex> lock(s.stalled_mutex);
+            // 已有暂存条目时必须排在它们后面
+            if (s.stalled.empty() && TryAdmit(next)) {
+                Enqueue(k + 1, std::move(env));
+                return;
+            }
+            s.stalled.push_back(std::move(env));
+            s.stalled_count.fetch_add(1, std::memory_order_seq_cst);
+            s.stalls.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        /** @brief 把第 k 级的暂存条目送入下一级。@return 暂存区已清空时返回 true。 */
+        bool FlushStalled(size_t k) {
+            Stage& s = *stages[k];
+            Stage& next = *stages[k + 1];
+            std::lock_guard<std::mutex> lock(s.stalled_mutex);
+            while (!s.stalled.empty() && TryAdmit(next)) {
+                Envelope env = std::move(s.stalled.front());
+                s.stalled.pop_front();
+                s.stalled_count.fetch_sub(1, std::memory_order_seq_cst);
+                Enqueue(k + 1, std::move(env));
+            }
+            return s.stalled.empty();
+        }
+
+        /** @brief 第 k 级取走了一个条目：唤醒等待空位的生产者或上一级。 */
+        void OnPopped(size_t k) {
+            if (k == 0) {
+                if (space_waiters.load(std::memory_order_seq_cst) > 0) {
+                    std::lock_guard<std::mutex> lock(wait_mutex);
+                    space_cv.notify_all();
+                }
+                return;
+            }
+            if (stages[k - 1]->stalled_count.load(std::memory_order_seq_cst) > 0) Schedule(k - 1);
+        }
+
+        /** @brief 丢弃第 k 级通道与暂存区中的全部条目。 */
+        void DropQueued(size_t k) {
+            Stage& s = *stages[k];
+            uint64_t count = 0;
+            Envelope env;
+            while (s.input.TryPop(env)) {
+                s.depth.fetch_sub(1, std::memory_order_seq_cst);
+                env = Envelope();
+                ++count;
+            }
+            {
+                std::lock_guard<std::mutex> lock(s.stalled_mutex);
+                count += s.stalled.size();
+                s.stalled.clear();
+                s.stalled_count.store(0, std::memory_order_seq_cst);
+            }
+            if (count == 0) return;
+            dropped.fetch_add(count, std::memory_order_relaxed);
+            Finish(count);
+        }
+
+        void Finish(uint64_t count) {
+            if (in_flight.fetch_sub(count, std::memory_order_seq_cst) == count &&
+                idle_waiters.load(std::memory_order_seq_cst) > 0) {
+                std::lock_guard<std::mutex> lock(wait_mutex);
+                idle_cv.notify_all();
+            }
+        }
+
+        void ReportError(const std::string& stage, std::exception_ptr error) {
+            if (!error_handler) return;
+            try {
+                error_handler(stage, std::move(error));
+            } catch (...) {
+                // 处理器自身的异常不能打断管线
+            }
+        }
+
+        PluginPtr<IPipelineStage> AcquireInstance(Stage& s) {
+            if (s.shared_instance) return s.shared_instance;
+            std::lock_guard<std::mutex> lock(s.instance_mutex);
+            // active 不超过并行度，池中总有一个空闲实例
+            PluginPtr<IPipelineStage> instance = std::move(s.idle_instances.back());
+            s.idle_instances.pop_back();
+            return instance;
+        }
+
+        void ReleaseInstance(Stage& s, PluginPtr<IPipelineStage> instance) {
+            if (s.shared_instance) return;
+            std::lock_guard<std::mutex> lock(s.instance_mutex);
+            s.idle_instances.push_back(std::move(instance));
+        }
+
+        /** @brief 送入一个条目。`timeout` 为负表示不等待，为 max 表示一直等。 */
+        bool Admit(PipelineItem&& item, std::chrono::nanoseconds timeout) {
+            if (closed.load(std::memory_order_acquire)) return false;
+            Stage& first = *stages[0];
+            if (!TryAdmit(first)) {
+                if (timeout < std::chrono::nanoseconds::zero()) return false;
+                bool admitted = false;
+                auto ready = [&] {
+                    return closed.load(std::memory_order_acquire) || (admitted = TryAdmit(first));
+                };
+                std::unique_lock<std::mutex> lock(wait_mutex);
+                space_waiters.fetch_add(1, std::memory_order_seq_cst);
+                if (timeout == std::chrono::nanoseconds::max()) {
+                    space_cv.wait(lock, ready);
+                } else {
+                    space_cv.wait_for(lock, timeout, ready);
+                }
+                space_waiters.fetch_sub(1, std::memory_order_seq_cst);
+                if (!admitted) return false;
+            }
+
+            Envelope env;
+            env.item = std::move(item);
+            env.item.sequence = next_sequence.fetch_add(1, std::memory_order_relaxed) + 1;
+            if (IsPipelineTraceHookInstalled()) {
+                // 就地构造：PipelineFrame 的析构会上报 kItemEnd，不能经过临时对象
+                env.frame = std::make_shared<PipelineFrame>();
+                env.frame->pipeline = name.c_str();
+                env.frame->frame_id = kFrameBit | (g_next_frame.fetch_add(1, std::memory_order_relaxed) + 1);
+                PipelineTraceSample sample;
+                sample.point = PipelineTracePoint::kItemBegin;
+                sample.pipeline = name.c_str();
+                sample.frame_id = env.frame->frame_id;
+                ReportPipelineSample(sample);
+            }
+            pushed.fetch_add(1, std::memory_order_relaxed);
+            in_flight.fetch_add(1, std::memory_order_seq_cst);
+            Enqueue(0, std::move(env));
+            return true;
+        }
+
+        bool WaitIdle(std::chrono::nanoseconds timeout) {
+            auto idle = [&] { return in_flight.load(std::memory_order_seq_cst) == 0; };
+            if (idle()) return true;
+            std::unique_lock<std::mutex> lock(wait_mutex);
+            idle_waiters.fetch_add(1, std::memory_order_seq_cst);
+            bool ok = true;
+            if (timeout == std::chrono::nanoseconds::max()) {
+                idle_cv.wait(lock, idle);
+            } else {
+                ok = idle_cv.wait_for(lock, timeout, idle);
+            }
+            idle_waiters.fetch_sub(1, std::memory_order_seq_cst);
+            return ok;
+        }
+    };
+
+    std::unique_ptr<Pipeline> Pipeline::Create(PipelineOptions options,
+        PluginPtr<IExecutorService> executor, std::string& out_error_message) {
+        if (!executor) {
+            out_error_message = "Pipeline requires an executor.";
+            return nullptr;
+        }
+        if (options.stages.empty()) {
+            out_error_message = "Pipeline requires at least one stage.";
+            return nullptr;
+        }
+
+        auto impl = std::make_shared<Impl>();
+        impl->name = std::move(options.name);
+        impl->sink = std::move(options.sink);
+        impl->error_handler = std::move(options.error_handler);
+        impl->priority = options.priority;
+        impl->executor = std::move(executor);
+        std::shared_ptr<PluginManager> manager;
+        for (size_t i = 0; i < options.stages.size(); ++i) {
+            PipelineStageSpec& spec = options.stages[i];
+            if (spec.parallelism == 0 || spec.capacity == 0) {
+                out_error_message = "Pipeline stage '" + spec.name +
+                    "' needs a non-zero parallelism and capacity.";
+                return nullptr;
+            }
+            auto stage = std::make_unique<Impl::Stage>(spec.capacity);
+            stage->name = std::move(spec.name);
+            stage->index = static_cast<uint32_t>(i);
+            stage->parallelism = spec.parallelism;
+            stage->capacity = spec.capacity;
+            if (spec.instance) {
+                stage->shared_instance = std::move(spec.instance);
+            } else {
+                if (!manager) manager = PluginManager::GetActiveInstance();
+                if (!manager) {
+                    out_error_message = "PluginManager not active.";
+                    return nullptr;
+                }
+                try {
+                    for (size_t n = 0; n < spec.parallelism; ++n) {
+                        stage->idle_instances.push_back(manager->CreateInstance<IPipelineStage>(spec.clsid));
+                    }
+                } catch (const std::exception& e) {
+                    out_error_message = "Pipeline stage '" + stage->name + "': " + e.what();
+                    return nullptr;
+                }
+            }
+            impl->stages.push_back(std::move(stage));
+        }
+        return std::unique_ptr<Pipeline>(new Pipeline(std::move(impl)));
+    }
+
+    Pipeline::Pipeline(std::shared_ptr<Impl> impl) : impl_(std::move(impl)) {}
+
+    Pipeline::~Pipeline() {
+        Close();
+        Wait();
+    }
+
+    bool Pipeline::Push(PipelineItem item) {
+        return impl_->Admit(std::move(item), std::chrono::nanoseconds::max());
+    }
+
+    bool Pipeline::PushFor(PipelineItem item, std::chrono::nanoseconds timeout) {
+        return impl_->Admit(std::move(item), std::max(timeout, std::chrono::nanoseconds::zero()));
+    }
+
+    bool Pipeline::TryPush(PipelineItem item) {
+        return impl_->Admit(std::move(item), std::chrono::nanoseconds(-1));
+    }
+
+    void Pipeline::Close() {
+        impl_->closed.store(true, std::memory_order_release);
+        std::lock_guard<std::mutex> lock(impl_->wait_mutex);
+        impl_->space_cv.notify_all();
+    }
+
+    void Pipeline::Wait() {
+        impl_->WaitIdle(std::chrono::nanoseconds::max());
+    }
+
+    bool Pipeline::WaitFor(std::chrono::nanoseconds timeout) {
+        return impl_->WaitIdle(timeout);
+    }
+
+    PipelineStats Pipeline::GetStats() const {
+        PipelineStats stats;
+        stats.pushed = impl_->pushed.load(std::memory_order_relaxed);
+        stats.delivered = impl_->delivered.load(std::memory_order_relaxed);
+        stats.dropped = impl_->dropped.load(std::memory_order_relaxed);
+        stats.in_flight = impl_->in_flight.load(std::memory_order_relaxed);
+        stats.elapsed_ns = NowNs() - impl_->created_ns;
+        for (const auto& s : impl_->stages) {
+            PipelineStageStats st;
+            st.name = s->name;
+            st.parallelism = s->parallelism;
+            st.capacity = s->capacity;
+            st.queue_depth = s->depth.load(std::memory_order_relaxed);
+            st.max_queue_depth = s->max_depth.load(std::memory_order_relaxed);
+            st.stalled_items = s->stalled_count.load(std::memory_order_relaxed);
+            st.active_workers = s->active.load(std::memory_order_relaxed);
+            st.processed = s->processed.load(std::memory_order_relaxed);
+            st.emitted = s->emitted.load(std::memory_order_relaxed);
+            st.failed = s->failed.load(std::memory_order_relaxed);
+            st.backpressure_stalls = s->stalls.load(std::memory_order_relaxed);
+            st.busy_ns = s->busy_ns.load(std::memory_order_relaxed);
+            st.queue_wait_ns = s->wait_ns.load(std::memory_order_relaxed);
+            stats.stages.push_back(std::move(st));
+        }
+        return stats;
+    }
+
+}  // namespace z3y
@@ -38,15 +38,36 @@
 #if !defined(_WIN32)
 
 #include "plugin_manager_pimpl.h"  // Pimpl 私有头文件
+#include "shm_ring.h"             // SharedMemoryRegion (跨进程事件桥)
+#include "checkpoint_store.h"     // MappedFile (检查点只读映射)
+#include "platform_threads.h"     // 线程放置与 NUMA 拓扑
 #include <codecvt>  // 用于编码转换
 #include <locale>
 #include <string> 
 #include <cstdio>
 #include <cstring> // for strerror_r
 #include <cerrno>
+#include <algorithm>
+#include <cctype>   // for isdigit
+#include <cstdlib>  // for atoi / strtoul
+#include <fstream>  // 读取 /sys 下的 NUMA 拓扑
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>   // for clock_gettime (线程 CPU 时间)
+#include <sys/resource.h> // for setpriority
+#include <climits>  // for PATH_MAX
+#include <fcntl.h>  // for open / O_DIRECTORY
+#include <sys/mman.h> // for mmap / madvise (缓冲区池大页)
+#include <sys/stat.h> // for stat (插件文件身份)
+#include <unistd.h> // for readlink / fsync / close
 #ifdef __APPLE__
 #include <mach-o/dyld.h>
 #endif
+#ifdef __linux__
+#include <poll.h>          // for poll
+#include <sys/eventfd.h>   // for eventfd (唤醒目录监视线程)
+#include <sys/inotify.h>   // for inotify
+#endif
 #include "framework/z3y_utils.h"
 
 namespace z3y {
@@ -153,7 +174,7 @@ namespace z3y {
                 close(dir_fd);
             }
 
-            return false;
+            return true;
         }
 
     } // namespace utils
@@ -179,8 +200,13 @@ namespace z3y {
                 // 1.
                 // 将本地多字节字符串 (char*) 转换为宽字符串 (wchar_t)
                 // (使用 C++ 标准库的 codecvt， 而不是 C 的 mbstowcs)
-                std::wstring_convert<std::codecvt_byname<wchar_t, char, std::mbstate_t>>
-                    converter(new std::codecvt_byname<wchar_t, char, std::mbstate_t>(""));
+                // codecvt_byname 的析构函数是 protected 的，需要包一层才能交给 wstring_convert 释放
+                struct LocaleCodecvt : std::codecvt_byname<wchar_t, char, std::mbstate_t> {
+                    explicit LocaleCodecvt(const char* name)
+                        : std::codecvt_byname<wchar_t, char, std::mbstate_t>(name) {}
+                    ~LocaleCodecvt() override = default;
+                };
+                std::wstring_convert<LocaleCodecvt> converter(new LocaleCodecvt(""));
 
                 std::wstring wide_str = converter.from_bytes(locale_str);
 
@@ -224,10 +250,11 @@ namespace z3y {
      * @brief [平台实现-POSIX] 加载一个 .so/.dylib。
      * @param[in] path 库的路径 (`std::filesystem::path`
      * 自动处理 UTF-8)。
+     * @param[in] binding 符号绑定策略 (`RTLD_NOW` 或 `RTLD_LAZY`)。
      * @return `void*` 句柄 (作为 `LibHandle`)。
      */
     PluginManager::LibHandle PluginManager::PlatformLoadLibrary(
-        const std::filesystem::path& path) {
+        const std::filesystem::path& path, PluginSymbolBinding binding) {
 
         // 在调用 dlopen 之前清除旧的 dlerror 状态
         (void)dlerror();
@@ -237,8 +264,10 @@ namespace z3y {
         // 上返回 UTF-8 编码的 `const char*`。
         //
         // RTLD_NOW: 立即解析所有符号 (失败时立即返回)。
+        // RTLD_LAZY: 函数符号在首次调用时解析 (缩短加载时间，缺失符号推迟到调用时暴露)。
         // RTLD_LOCAL: 符号不暴露给其他库 (模拟 Windows 行为)。
-        return ::dlopen(path.string().c_str(), RTLD_NOW | RTLD_LOCAL);
+        const int bind_flag = binding == PluginSymbolBinding::kLazy ? RTLD_LAZY : RTLD_NOW;
+        return ::dlopen(path.string().c_str(), bind_flag | RTLD_LOCAL);
     }
 
     /**
@@ -255,6 +284,328 @@ namespace z3y {
         return ::dlsym(handle, func_name);
     }
 
+    /**
+     * @brief [平台实现-POSIX] 卸载一个 .so/.dylib。
+     * @param[in] handle `PlatformLoadLibrary` 返回的 `void*` 句柄。
+     */
+    void PluginManager::PlatformUnloadLibrary(LibHandle handle) {
+        ::dlclose(handle);
+    }
+
+    /**
+     * @brief [平台实现-POSIX] 判断某地址 (代码或数据) 是否属于 `handle` 对应的库。
+     * @details `dladdr` 给出所在映像的路径，再以 `RTLD_NOLOAD` 取回该映像的句柄比较：
+     * 同一已加载映像的句柄相同；`RTLD_NOLOAD` 不会加载新映像，取得的引用随即释放。
+     */
+    bool PluginManager::PlatformAddressInLibrary(LibHandle handle, const void* address) {
+        Dl_info info;
+        if (!address || ::dladdr(address, &info) == 0 || !info.dli_fname || info.dli_fname[0] == '\0') return false;
+        void* owner = ::dlopen(info.dli_fname, RTLD_NOW | RTLD_NOLOAD);
+        if (!owner) return false;
+        ::dlclose(owner);
+        return owner == handle;
+    }
+
+    /**
+     * @brief [平台实现-POSIX] 一次 `stat` 取得文件身份 (st_dev, st_ino) 与版本 (大小、纳秒修改时间)。
+     * @details `stat` 跟随符号链接：经链接加载与直接加载同一文件得到相同的身份。
+     */
+    bool QueryPluginFileInfo(const std::filesystem::path& file, PluginFileInfo& out_info) {
+        struct stat st;
+        if (::stat(file.c_str(), &st) != 0) return false;
+        out_info.device = static_cast<uint64_t>(st.st_dev);
+        out_info.file_id = static_cast<uint64_t>(st.st_ino);
+        out_info.size = static_cast<uint64_t>(st.st_size);
+#ifdef __APPLE__
+        out_info.mtime = static_cast<int64_t>(st.st_mtimespec.tv_sec) * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+        out_info.mtime = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+        return true;
+    }
+
+    /**
+     * @brief [平台实现-POSIX] 目录监视句柄：inotify 描述符 + 用于唤醒停止的 eventfd。
+     * @details 只在 Linux 上可用；其他 POSIX 平台 (macOS 需要 kqueue/FSEvents) 暂不支持。
+     */
+    struct PlatformDirectoryWatch {
+        std::filesystem::path dir;
+        int inotify_fd = -1;
+        int wake_fd = -1;
+
+        ~PlatformDirectoryWatch() {
+            if (inotify_fd != -1) ::close(inotify_fd);
+            if (wake_fd != -1) ::close(wake_fd);
+        }
+    };
+
+    /**
+     * @brief [平台实现-POSIX] 开始监视目录。
+     * @details 只关心 `IN_CLOSE_WRITE` (写完的文件) 与 `IN_MOVED_TO` (重命名进目录)，
+     * 不会在文件写到一半时触发。
+     */
+    bool PluginManager::PlatformOpenDirectoryWatch(const std::filesystem::path& dir) {
+#ifdef __linux__
+        auto watch = std::make_shared<PlatformDirectoryWatch>();
+        watch->dir = dir;
+        watch->inotify_fd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        watch->wake_fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (watch->inotify_fd == -1 || watch->wake_fd == -1) return false;
+        if (::inotify_add_watch(watch->inotify_fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) == -1) return false;
+        pimpl_->dir_watch_ = std::move(watch);
+        return true;
+#else
+        (void)dir;
+        return false;
+#endif
+    }
+
+    /**
+     * @brief [平台实现-POSIX] 阻塞直到目录中有文件写完/移入，或被唤醒停止。
+     * @param[out] out_files 发生变化的文件 (完整路径)。
+     * @return 被唤醒停止或出错时返回 false。
+     */
+    bool PluginManager::PlatformWaitDirectoryChanges(std::vector<std::filesystem::path>& out_files) {
+#ifdef __linux__
+        PlatformDirectoryWatch& watch = *pimpl_->dir_watch_;
+        pollfd fds[2] = { { watch.inotify_fd, POLLIN, 0 }, { watch.wake_fd, POLLIN, 0 } };
+        while (::poll(fds, 2, -1) == -1) {
+            if (errno != EINTR) return false;
+        }
+        if (fds[1].revents != 0) return false;
+        alignas(inotify_event) char buffer[4096];
+        ssize_t len;
+        while ((len = ::read(watch.inotify_fd, buffer, sizeof(buffer))) > 0) {
+            for (const char* p = buffer; p < buffer + len;) {
+                const auto* ev = reinterpret_cast<const inotify_event*>(p);
+                if (ev->len != 0 && !(ev->mask & IN_ISDIR)) out_files.push_back(watch.dir / ev->name);
+                p += sizeof(inotify_event) + ev->len;
+            }
+        }
+        return true;
+#else
+        (void)out_files;
+        return false;
+#endif
+    }
+
+    /** @brief [平台实现-POSIX] 唤醒监视线程，使 `PlatformWaitDirectoryChanges` 返回 false。 */
+    void PluginManager::PlatformWakeDirectoryWatch() {
+#ifdef __linux__
+        const uint64_t one = 1;
+        (void)!::write(pimpl_->dir_watch_->wake_fd, &one, sizeof(one));
+#endif
+    }
+
+    /** @brief [平台实现-POSIX] 系统页大小。 */
+    size_t PlatformPageSize() {
+        const long page = ::sysconf(_SC_PAGESIZE);
+        return page > 0 ? static_cast<size_t>(page) : 4096;
+    }
+
+    /**
+     * @brief [平台实现-POSIX] 申请一段建议使用透明大页的匿名映射。
+     * @details MADV_HUGEPAGE 只是建议：内核能否真正合并为大页取决于 THP 配置与内存碎片。
+     * 非 Linux 平台返回 nullptr (退回普通分配)。
+     */
+    void* PlatformAllocateLargePages(size_t bytes) {
+#ifdef __linux__
+        void* p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED) return nullptr;
+#ifdef MADV_HUGEPAGE
+        (void)::madvise(p, bytes, MADV_HUGEPAGE);
+#endif
+        return p;
+#else
+        (void)bytes;
+        return nullptr;
+#endif
+    }
+
+    /** @brief [平台实现-POSIX] 释放 `PlatformAllocateLargePages` 的映射。 */
+    void PlatformFreeLargePages(void* p, size_t bytes) {
+#ifdef __linux__
+        ::munmap(p, bytes);
+#else
+        (void)p;
+        (void)bytes;
+#endif
+    }
+
+    namespace {
+        /** @brief 解析 Linux 的 CPU 列表格式 (如 "0-3,8-11")。 */
+        std::vector<int> ParseCpuList(const std::string& list) {
+            std::vector<int> cpus;
+            size_t pos = 0;
+            while (pos < list.size()) {
+                size_t end = list.find(',', pos);
+                if (end == std::string::npos) end = list.size();
+                const std::string range = list.substr(pos, end - pos);
+                pos = end + 1;
+                if (range.empty() || !std::isdigit(static_cast<unsigned char>(range[0]))) continue;
+                const size_t dash = range.find('-');
+                const int first = std::atoi(range.c_str());
+                const int last = dash == std::string::npos ? first : std::atoi(range.c_str() + dash + 1);
+                for (int cpu = first; cpu <= last; ++cpu) cpus.push_back(cpu);
+            }
+            return cpus;
+        }
+    }  // namespace
+
+    /** @brief [平台实现-POSIX] 读取 /sys/devices/system/node/node<N>/cpulist。非 Linux 返回空。 */
+    std::vector<std::vector<int>> PlatformReadNumaTopology() {
+        std::vector<std::vector<int>> nodes;
+#ifdef __linux__
+        std::error_code ec;
+        for (const auto& entry : std::filesystem::directory_iterator("/sys/devices/system/node", ec)) {
+            const std::string name = entry.path().filename().string();
+            if (name.size() <= 4 || name.compare(0, 4, "node") != 0 ||
+                !std::all_of(name.begin() + 4, name.end(), [](char c) { return std::isdigit(static_cast<unsigned char>(c)); })) {
+                continue;
+            }
+            const size_t node = std::strtoul(name.c_str() + 4, nullptr, 10);
+            std::ifstream in(entry.path() / "cpulist");
+            std::string list;
+            if (!in || !std::getline(in, list)) continue;
+            if (node >= nodes.size()) nodes.resize(node + 1);
+            nodes[node] = ParseCpuList(list);
+        }
+#endif
+        return nodes;
+    }
+
+    /** @brief [平台实现-POSIX] sched_getcpu (vDSO)。非 Linux 返回 -1。 */
+    int PlatformCurrentCpu() noexcept {
+#ifdef __linux__
+        return ::sched_getcpu();
+#else
+        return -1;
+#endif
+    }
+
+    /** @brief [平台实现-POSIX] pthread_setaffinity_np。macOS 不支持绑定 CPU，返回 false。 */
+    bool PlatformSetThreadAffinity(const std::vector<int>& cpus) {
+#ifdef __linux__
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int cpu : cpus) {
+            if (cpu >= 0 && cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+        }
+        if (CPU_COUNT(&set) == 0) return false;
+        return ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set) == 0;
+#else
+        (void)cpus;
+        return false;
+#endif
+    }
+
+    /**
+     * @brief [平台实现-POSIX] nice 值 (kLow / kHigh) 或 SCHED_FIFO (kRealtime)。
+     * @details Linux 上 setpriority(PRIO_PROCESS, 0) 只作用于调用线程；其他 POSIX 平台上它作用于整个进程，
+     * 因此那里只支持 kRealtime。
+     */
+    bool PlatformSetThreadPriority(ThreadPriority priority, int realtime_priority) {
+        switch (priority) {
+        case ThreadPriority::kDefault:
+            return true;
+        case ThreadPriority::kLow:
+        case ThreadPriority::kHigh:
+#ifdef __linux__
+            return ::setpriority(PRIO_PROCESS, 0, priority == ThreadPriority::kLow ? 10 : -5) == 0;
+#else
+            return false;
+#endif
+        case ThreadPriority::kRealtime: {
+            sched_param param{};
+            param.sched_priority = std::clamp(realtime_priority,
+                ::sched_get_priority_min(SCHED_FIFO), ::sched_get_priority_max(SCHED_FIFO));
+            return ::pthread_setschedparam(::pthread_self(), SCHED_FIFO, &param) == 0;
+        }
+        }
+        return false;
+    }
+
+    /** @brief [平台实现-POSIX] clock_gettime(CLOCK_THREAD_CPUTIME_ID)。 */
+    uint64_t PlatformThreadCpuTimeNs() noexcept {
+        timespec ts{};
+        if (::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0) return 0;
+        return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+    }
+
+
+    /**
+     * @brief [平台实现-POSIX] 以 `shm_open("/z3y.<name>")` 创建或打开共享内存并映射。
+     * @details 文件描述符在映射后即可关闭；段名由创建者在关闭时 `shm_unlink`。
+     */
+    bool PlatformOpenSharedMemory(const std::string& name, size_t size, bool create,
+        SharedMemoryRegion& out, std::string& out_error_message) {
+        const std::string shm_name = "/z3y." + name;
+        const int fd = create ? ::shm_open(shm_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600)
+            : ::shm_open(shm_name.c_str(), O_RDWR, 0);
+        if (fd < 0) {
+            out_error_message = "shm_open('" + shm_name + "') failed: " + std::strerror(errno);
+            return false;
+        }
+        if (create) {
+            if (::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+                out_error_message = "ftruncate('" + shm_name + "') failed: " + std::strerror(errno);
+                ::close(fd);
+                ::shm_unlink(shm_name.c_str());
+                return false;
+            }
+        }
+        else {
+            struct stat st;
+            if (::fstat(fd, &st) != 0 || st.st_size <= 0) {
+                out_error_message = "fstat('" + shm_name + "') failed";
+                ::close(fd);
+                return false;
+            }
+            size = static_cast<size_t>(st.st_size);
+        }
+        void* base = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (base == MAP_FAILED) {
+            out_error_message = "mmap('" + shm_name + "') failed: " + std::strerror(errno);
+            if (create) ::shm_unlink(shm_name.c_str());
+            return false;
+        }
+        out.base = base;
+        out.size = size;
+        out.native_name = shm_name;
+        out.owner = create;
+        return true;
+    }
+
+    /** @brief [平台实现-POSIX] 解除映射；创建者同时 `shm_unlink`。 */
+    void PlatformCloseSharedMemory(SharedMemoryRegion& region) {
+        if (region.base) ::munmap(region.base, region.size);
+        if (region.owner) ::shm_unlink(region.native_name.c_str());
+        region = SharedMemoryRegion();
+    }
+
+    /** @brief [平台实现-POSIX] `mmap(PROT_READ, MAP_PRIVATE)` 整个文件；映射建立后即可关闭描述符。 */
+    bool PlatformMapFileReadOnly(const std::filesystem::path& file, MappedFile& out) {
+        const int fd = ::open(file.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd == -1) return false;
+        struct stat st;
+        void* base = MAP_FAILED;
+        if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+            base = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        ::close(fd);
+        if (base == MAP_FAILED) return false;
+        out.data = static_cast<const uint8_t*>(base);
+        out.size = static_cast<size_t>(st.st_size);
+        return true;
+    }
+
+    /** @brief [平台实现-POSIX] `munmap`。 */
+    void PlatformUnmapFile(MappedFile& file) {
+        if (file.data) ::munmap(const_cast<uint8_t*>(file.data), file.size);
+        file = MappedFile();
+    }
+
 }  // namespace z3y
 
 #endif  // !defined(_WIN32)
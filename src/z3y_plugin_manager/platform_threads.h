@@ -0,0 +1,64 @@
+﻿/*
+* Copyright [2025] [Yue Liu]
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/**
+ * @file platform_threads.h
+ * @brief [私有头文件] 线程放置与 NUMA 拓扑的平台原语 (由 platform_posix.cpp / platform_win.cpp 实现)。
+ *
+ * @details
+ * [受众：框架维护者]
+ *
+ * 只做最薄的一层系统调用封装；候选 CPU 的计算、拓扑缓存与按角色查询在 thread_placement.cpp 中，与平台无关。
+ */
+
+#pragma once
+
+#ifndef Z3Y_SRC_PLUGIN_MANAGER_PLATFORM_THREADS_H_
+#define Z3Y_SRC_PLUGIN_MANAGER_PLATFORM_THREADS_H_
+
+#include <cstdint>
+#include <vector>
+#include "framework/thread_placement.h"
+
+namespace z3y {
+
+    /**
+     * @brief [平台实现] 读取 NUMA 拓扑：下标为节点编号，元素为该节点的逻辑 CPU 编号。
+     * @return 平台不支持或读取失败时返回空 (调用方按单节点处理)。
+     */
+    std::vector<std::vector<int>> PlatformReadNumaTopology();
+
+    /** @brief [平台实现] 调用线程当前所在的逻辑 CPU；不支持时返回 -1。 */
+    int PlatformCurrentCpu() noexcept;
+
+    /**
+     * @brief [平台实现] 把调用线程限定在 `cpus` (非空) 上运行。
+     * @details Windows 的线程只能属于一个处理器组：只采用与第一个 CPU 同组的那些。
+     */
+    bool PlatformSetThreadAffinity(const std::vector<int>& cpus);
+
+    /** @brief [平台实现] 设置调用线程的调度优先级。`kDefault` 直接返回 true。 */
+    bool PlatformSetThreadPriority(ThreadPriority priority, int realtime_priority);
+
+    /**
+     * @brief [平台实现] 调用线程累计消耗的 CPU 时间 (纳秒，用户态 + 内核态)。
+     * @details 只用于求差值；不支持时恒为 0。
+     */
+    uint64_t PlatformThreadCpuTimeNs() noexcept;
+
+}  // namespace z3y
+
+#endif  // Z3Y_SRC_PLUGIN_MANAGER_PLATFORM_THREADS_H_
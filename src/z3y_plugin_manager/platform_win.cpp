@@ -38,6 +38,9 @@
 #ifdef _WIN32
 
 #include "plugin_manager_pimpl.h"  // Pimpl 私有头文件
+#include "shm_ring.h"             // SharedMemoryRegion (跨进程事件桥)
+#include "checkpoint_store.h"     // MappedFile (检查点只读映射)
+#include "platform_threads.h"     // 线程放置与 NUMA 拓扑
 
 #include "framework/z3y_utils.h"
 #include <cstdio> // for _wfopen, fwrite
@@ -185,10 +188,11 @@ namespace z3y {
      * @brief [平台实现-Win] 加载一个 DLL。
      * @param[in] path DLL 的路径 (`std::filesystem::path`
      * 自动处理 UTF-8 到 UTF-16)。
+     * @param[in] binding 未使用：Windows 的导入表总在加载时绑定，延迟绑定由插件链接时的 `/DELAYLOAD` 决定。
      * @return `HMODULE` (作为 `LibHandle`)。
      */
     PluginManager::LibHandle PluginManager::PlatformLoadLibrary(
-        const std::filesystem::path& path) {
+        const std::filesystem::path& path, PluginSymbolBinding /*binding*/) {
         const std::filesystem::path absolute_path = path.is_absolute()
             ? path
             : std::filesystem::absolute(path);
@@ -228,6 +232,287 @@ namespace z3y {
         ::FreeLibrary(static_cast<HMODULE>(handle));
     }
 
+    /**
+     * @brief [平台实现-Win] 判断某地址 (代码或数据) 是否属于 `handle` 对应的 DLL。
+     */
+    bool PluginManager::PlatformAddressInLibrary(LibHandle handle, const void* address) {
+        HMODULE owner = nullptr;
+        if (!address || !::GetModuleHandleExW(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS |
+            GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT, static_cast<LPCWSTR>(address), &owner)) {
+            return false;
+        }
+        return owner == static_cast<HMODULE>(handle);
+    }
+
+    /**
+     * @brief [平台实现-Win] 一次 `GetFileInformationByHandle` 取得文件身份 (卷序列号, 文件索引)
+     * 与版本 (大小、FILETIME 修改时间)。
+     */
+    bool QueryPluginFileInfo(const std::filesystem::path& file, PluginFileInfo& out_info) {
+        HANDLE handle = ::CreateFileW(file.c_str(), FILE_READ_ATTRIBUTES,
+            FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, NULL);
+        if (handle == INVALID_HANDLE_VALUE) return false;
+        BY_HANDLE_FILE_INFORMATION info;
+        const BOOL ok = ::GetFileInformationByHandle(handle, &info);
+        ::CloseHandle(handle);
+        if (!ok) return false;
+        out_info.device = info.dwVolumeSerialNumber;
+        out_info.file_id = (static_cast<uint64_t>(info.nFileIndexHigh) << 32) | info.nFileIndexLow;
+        out_info.size = (static_cast<uint64_t>(info.nFileSizeHigh) << 32) | info.nFileSizeLow;
+        out_info.mtime = static_cast<int64_t>((static_cast<uint64_t>(info.ftLastWriteTime.dwHighDateTime) << 32) |
+            info.ftLastWriteTime.dwLowDateTime);
+        return true;
+    }
+
+    /**
+     * @brief [平台实现-Win] 目录监视句柄：以重叠 I/O 打开的目录、I/O 完成事件与停止事件。
+     */
+    struct PlatformDirectoryWatch {
+        std::filesystem::path dir;
+        HANDLE dir_handle = INVALID_HANDLE_VALUE;
+        HANDLE io_event = NULL;
+        HANDLE stop_event = NULL;
+        OVERLAPPED overlapped = {};
+        bool pending = false;  //!< 是否有一次 ReadDirectoryChangesW 尚未完成
+        alignas(DWORD) BYTE buffer[16384];
+
+        ~PlatformDirectoryWatch() {
+            if (pending) {
+                DWORD ignored = 0;
+                ::CancelIoEx(dir_handle, &overlapped);
+                ::GetOverlappedResult(dir_handle, &overlapped, &ignored, TRUE);  // 等内核放弃写 buffer
+            }
+            if (dir_handle != INVALID_HANDLE_VALUE) ::CloseHandle(dir_handle);
+            if (io_event) ::CloseHandle(io_event);
+            if (stop_event) ::CloseHandle(stop_event);
+        }
+    };
+
+    /** @brief [平台实现-Win] 开始监视目录 (文件名变化与写入)。 */
+    bool PluginManager::PlatformOpenDirectoryWatch(const std::filesystem::path& dir) {
+        auto watch = std::make_shared<PlatformDirectoryWatch>();
+        watch->dir = dir;
+        watch->dir_handle = ::CreateFileW(dir.c_str(), FILE_LIST_DIRECTORY,
+            FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING,
+            FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, NULL);
+        watch->io_event = ::CreateEventW(NULL, TRUE, FALSE, NULL);
+        watch->stop_event = ::CreateEventW(NULL, TRUE, FALSE, NULL);
+        if (watch->dir_handle == INVALID_HANDLE_VALUE || !watch->io_event || !watch->stop_event) return false;
+        pimpl_->dir_watch_ = std::move(watch);
+        return true;
+    }
+
+    /**
+     * @brief [平台实现-Win] 阻塞直到目录中有文件新增/改名进入/被写入，或被唤醒停止。
+     * @details 通知缓冲区溢出 (返回 0 字节) 时退化为列出整个目录：已加载的插件会被跳过。
+     * 与 inotify 不同，Windows 在文件刚创建时就会通知，写完之后的 MODIFIED 通知会让加载重试。
+     */
+    bool PluginManager::PlatformWaitDirectoryChanges(std::vector<std::filesystem::path>& out_files) {
+        PlatformDirectoryWatch& watch = *pimpl_->dir_watch_;
+        if (!watch.pending) {
+            ::ResetEvent(watch.io_event);
+            watch.overlapped = {};
+            watch.overlapped.hEvent = watch.io_event;
+            if (!::ReadDirectoryChangesW(watch.dir_handle, watch.buffer, sizeof(watch.buffer), FALSE,
+                FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE, NULL, &watch.overlapped, NULL)) {
+                return false;
+            }
+            watch.pending = true;
+        }
+        HANDLE handles[2] = { watch.stop_event, watch.io_event };
+        if (::WaitForMultipleObjects(2, handles, FALSE, INFINITE) != WAIT_OBJECT_0 + 1) return false;
+        DWORD bytes = 0;
+        watch.pending = false;
+        if (!::GetOverlappedResult(watch.dir_handle, &watch.overlapped, &bytes, FALSE)) return false;
+        if (bytes == 0) {
+            std::error_code ec;
+            for (const auto& entry : std::filesystem::directory_iterator(watch.dir, ec)) out_files.push_back(entry.path());
+            return true;
+        }
+        for (const BYTE* p = watch.buffer;;) {
+            const auto* info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(p);
+            if (info->Action == FILE_ACTION_ADDED || info->Action == FILE_ACTION_MODIFIED ||
+                info->Action == FILE_ACTION_RENAMED_NEW_NAME) {
+                out_files.push_back(watch.dir / std::wstring(info->FileName, info->FileNameLength / sizeof(WCHAR)));
+            }
+            if (info->NextEntryOffset == 0) break;
+            p += info->NextEntryOffset;
+        }
+        return true;
+    }
+
+    /** @brief [平台实现-Win] 唤醒监视线程，使 `PlatformWaitDirectoryChanges` 返回 false。 */
+    void PluginManager::PlatformWakeDirectoryWatch() {
+        ::SetEvent(pimpl_->dir_watch_->stop_event);
+    }
+
+    /** @brief [平台实现-Win] GetNumaNodeProcessorMaskEx。CPU 编号 = 处理器组 * 64 + 组内序号。 */
+    std::vector<std::vector<int>> PlatformReadNumaTopology() {
+        ULONG highest = 0;
+        if (!::GetNumaHighestNodeNumber(&highest)) return {};
+        std::vector<std::vector<int>> nodes(static_cast<size_t>(highest) + 1);
+        for (USHORT node = 0; node <= highest; ++node) {
+            GROUP_AFFINITY affinity{};
+            if (!::GetNumaNodeProcessorMaskEx(node, &affinity)) continue;
+            for (int bit = 0; bit < 64; ++bit) {
+                if (affinity.Mask & (static_cast<KAFFINITY>(1) << bit)) nodes[node].push_back(affinity.Group * 64 + bit);
+            }
+        }
+        return nodes;
+    }
+
+    /** @brief [平台实现-Win] GetCurrentProcessorNumberEx。 */
+    int PlatformCurrentCpu() noexcept {
+        PROCESSOR_NUMBER number{};
+        ::GetCurrentProcessorNumberEx(&number);
+        return number.Group * 64 + number.Number;
+    }
+
+    /** @brief [平台实现-Win] SetThreadGroupAffinity (只使用第一个 CPU 所在的处理器组)。 */
+    bool PlatformSetThreadAffinity(const std::vector<int>& cpus) {
+        if (cpus.empty() || cpus[0] < 0) return false;
+        GROUP_AFFINITY affinity{};
+        affinity.Group = static_cast<WORD>(cpus[0] / 64);
+        for (int cpu : cpus) {
+            if (cpu >= 0 && cpu / 64 == affinity.Group) affinity.Mask |= static_cast<KAFFINITY>(1) << (cpu % 64);
+        }
+        return ::SetThreadGroupAffinity(::GetCurrentThread(), &affinity, nullptr) != 0;
+    }
+
+    /** @brief [平台实现-Win] SetThreadPriority。Windows 没有可调的实时优先级，kRealtime 映射为 TIME_CRITICAL。 */
+    bool PlatformSetThreadPriority(ThreadPriority priority, int realtime_priority) {
+        (void)realtime_priority;
+        int level = THREAD_PRIORITY_NORMAL;
+        switch (priority) {
+        case ThreadPriority::kDefault: return true;
+        case ThreadPriority::kLow: level = THREAD_PRIORITY_BELOW_NORMAL; break;
+        case ThreadPriority::kHigh: level = THREAD_PRIORITY_ABOVE_NORMAL; break;
+        case ThreadPriority::kRealtime: level = THREAD_PRIORITY_TIME_CRITICAL; break;
+        }
+        return ::SetThreadPriority(::GetCurrentThread(), level) != 0;
+    }
+
+    /**
+     * @brief [平台实现-Win] GetThreadTimes (内核态 + 用户态，100ns 单位)。
+     * @details QueryThreadCycleTime 精度更高但单位是时钟周期，无法稳定换算成纳秒，这里不用。
+     */
+    uint64_t PlatformThreadCpuTimeNs() noexcept {
+        FILETIME creation, exit, kernel, user;
+        if (!::GetThreadTimes(::GetCurrentThread(), &creation, &exit, &kernel, &user)) return 0;
+        const auto ticks = [](const FILETIME& t) {
+            return (static_cast<uint64_t>(t.dwHighDateTime) << 32) | t.dwLowDateTime;
+        };
+        return (ticks(kernel) + ticks(user)) * 100;
+    }
+
+    /** @brief [平台实现-Win] 系统页大小。 */
+    size_t PlatformPageSize() {
+        SYSTEM_INFO info;
+        ::GetSystemInfo(&info);
+        return info.dwPageSize;
+    }
+
+    /**
+     * @brief [平台实现-Win] 以 MEM_LARGE_PAGES 申请内存。
+     * @details 需要进程拥有 SeLockMemoryPrivilege，且大小是大页的整数倍；否则返回 nullptr (退回普通分配)。
+     */
+    void* PlatformAllocateLargePages(size_t bytes) {
+        const SIZE_T large_page = ::GetLargePageMinimum();
+        if (large_page == 0 || bytes % large_page != 0) return nullptr;
+        return ::VirtualAlloc(NULL, bytes, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+    }
+
+    /** @brief [平台实现-Win] 释放 `PlatformAllocateLargePages` 申请的内存。 */
+    void PlatformFreeLargePages(void* p, size_t bytes) {
+        (void)bytes;
+        ::VirtualFree(p, 0, MEM_RELEASE);
+    }
+
+
+    /**
+     * @brief [平台实现-Win] 以 `Local\z3y.<name>` 命名的页面文件映射创建或打开共享内存。
+     * @details 映射对象在最后一个句柄关闭时由系统回收；打开时用 `VirtualQuery` 取得映射大小。
+     */
+    bool PlatformOpenSharedMemory(const std::string& name, size_t size, bool create,
+        SharedMemoryRegion& out, std::string& out_error_message) {
+        const std::wstring wname = utils::Utf8ToPath("Local\\z3y." + name).wstring();
+        HANDLE mapping = NULL;
+        if (create) {
+            const unsigned long long bytes = size;
+            mapping = ::CreateFileMappingW(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+                static_cast<DWORD>(bytes >> 32), static_cast<DWORD>(bytes & 0xFFFFFFFFull), wname.c_str());
+            if (mapping != NULL && ::GetLastError() == ERROR_ALREADY_EXISTS) {
+                ::CloseHandle(mapping);
+                out_error_message = "CreateFileMapping('" + name + "') failed: segment already exists";
+                return false;
+            }
+        }
+        else {
+            mapping = ::OpenFileMappingW(FILE_MAP_ALL_ACCESS, FALSE, wname.c_str());
+        }
+        if (mapping == NULL) {
+            out_error_message = "Shared memory '" + name + "' unavailable (error " +
+                std::to_string(::GetLastError()) + ")";
+            return false;
+        }
+        void* base = ::MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, create ? size : 0);
+        if (base == NULL) {
+            out_error_message = "MapViewOfFile('" + name + "') failed (error " +
+                std::to_string(::GetLastError()) + ")";
+            ::CloseHandle(mapping);
+            return false;
+        }
+        if (!create) {
+            MEMORY_BASIC_INFORMATION info;
+            size = ::VirtualQuery(base, &info, sizeof(info)) != 0 ? info.RegionSize : 0;
+        }
+        out.base = base;
+        out.size = size;
+        out.native_handle = mapping;
+        out.owner = create;
+        return true;
+    }
+
+    /** @brief [平台实现-Win] 解除映射并关闭映射句柄。 */
+    void PlatformCloseSharedMemory(SharedMemoryRegion& region) {
+        if (region.base) ::UnmapViewOfFile(region.base);
+        if (region.native_handle) ::CloseHandle(static_cast<HANDLE>(region.native_handle));
+        region = SharedMemoryRegion();
+    }
+
+    /**
+     * @brief [平台实现-Win] `CreateFileMapping(PAGE_READONLY)` + `MapViewOfFile(FILE_MAP_READ)` 整个文件。
+     * @details 映射存在期间文件不能删除：调用方必须先 `PlatformUnmapFile`。
+     */
+    bool PlatformMapFileReadOnly(const std::filesystem::path& file, MappedFile& out) {
+        HANDLE handle = ::CreateFileW(file.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL,
+            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (handle == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER size;
+        HANDLE mapping = NULL;
+        if (::GetFileSizeEx(handle, &size) && size.QuadPart > 0) {
+            mapping = ::CreateFileMappingW(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+        }
+        ::CloseHandle(handle);  // 映射对象自己持有文件
+        if (mapping == NULL) return false;
+        void* base = ::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (base == NULL) {
+            ::CloseHandle(mapping);
+            return false;
+        }
+        out.data = static_cast<const uint8_t*>(base);
+        out.size = static_cast<size_t>(size.QuadPart);
+        out.native_handle = mapping;
+        return true;
+    }
+
+    /** @brief [平台实现-Win] 解除映射并关闭映射句柄。 */
+    void PlatformUnmapFile(MappedFile& file) {
+        if (file.data) ::UnmapViewOfFile(file.data);
+        if (file.native_handle) ::CloseHandle(static_cast<HANDLE>(file.native_handle));
+        file = MappedFile();
+    }
+
 }  // namespace z3y
 
 #endif  // _WIN32
@@ -20,12 +20,15 @@
  */
 
 #include "plugin_manager_pimpl.h"
+#include "checkpoint_store.h"
 #include <exception>
+#include <fstream>
 #include <iostream>
 #include <optional>
 #include <shared_mutex>
 #include <system_error>
 #include "framework/z3y_utils.h"
+#include "shutdown_scheduler.h"
 
 #ifndef _WIN32
 #include <dlfcn.h>
@@ -35,6 +38,7 @@ namespace z3y {
 
     // ... (辅助函数 ReportException/ReportUnknownException，代码保持不变，已在其他地方定义过) ...
     void ReportException(PluginManagerPimpl* pimpl, const std::exception& e) {
+        pimpl->exception_count_.fetch_add(1, std::memory_order_relaxed);
         std::shared_ptr<PluginManagerPimpl::ExceptionCallback> handler_copy;
         {
             std::lock_guard lock(pimpl->exception_handler_mutex_);
@@ -49,6 +53,7 @@ namespace z3y {
 
     void ReportUnknownException(PluginManagerPimpl* pimpl) {
         static std::runtime_error unknown_err("[z3y FW] Unknown non-std exception caught.");
+        pimpl->unknown_exception_count_.fetch_add(1, std::memory_order_relaxed);
         ReportException(pimpl, unknown_err);
     }
 
@@ -60,16 +65,130 @@ namespace z3y {
             static PluginPtr<PluginManager> s_instance = nullptr;
             return s_instance;
         }
-        // 保护单例创建销毁的锁
+        // 保护单例创建销毁的锁 (只有写者使用)
         std::mutex& GetStaticMutex() {
             static std::mutex s_mutex;
             return s_mutex;
         }
+        // 发布给读者的裸指针。对象由 s_instance (或 Destroy 退役到 RCU 域的引用) 保活
+        std::atomic<PluginManager*>& PublishedInstance() {
+            static std::atomic<PluginManager*> s_published{ nullptr };
+            return s_published;
+        }
+        // 保护 PublishedInstance 读者的 RCU 域：Destroy 等读者离开后才释放实例
+        RcuDomain& InstanceDomain() {
+            static RcuDomain s_domain;
+            return s_domain;
+        }
+        // 服务注册表代数 (从 1 开始，0 留给 “从未缓存”)
+        std::atomic<uint64_t>& ServiceGenerationCounter() {
+            static std::atomic<uint64_t> s_generation{ 1 };
+            return s_generation;
+        }
+        // 任一拦截规则生效 (模板 API 的快速判断)
+        std::atomic<bool>& CallInterceptionFlag() {
+            static std::atomic<bool> s_active{ false };
+            return s_active;
+        }
+        /** @brief 注册表变化后调用：让所有线程的 ServiceHandle 缓存失效。 */
+        void BumpServiceGeneration() {
+            ServiceGenerationCounter().fetch_add(1, std::memory_order_release);
+        }
+        // 实例的线程绑定编号 (从 1 开始、不复用；0 表示未绑定，即跟随默认实例)
+        uint64_t NextBindingId() {
+            static std::atomic<uint64_t> s_next{ 1 };
+            return s_next.fetch_add(1, std::memory_order_relaxed);
+        }
+        // 绑定到已销毁的实例：所有这样的线程都解析为空，可以共用一个编号
+        constexpr uint64_t kExpiredBindingId = UINT64_MAX;
+        // 当前线程绑定的实例。t_bound 为真时 GetActiveInstance 不再读全局实例 (实例已析构则返回空)
+        thread_local std::weak_ptr<PluginManager> t_bound_manager;
+        thread_local bool t_bound = false;
+        // 绑定实例的编号：与服务代数一起构成 ServiceHandle 缓存的键，切换绑定不必递增全局代数
+        thread_local uint64_t t_bound_id = 0;
+
+        /** @brief 与当前线程的绑定互换 (进入与退出作用域各调用一次)。 */
+        void SwapThreadBinding(std::weak_ptr<PluginManager>& manager, bool& bound, uint64_t& id) noexcept {
+            std::swap(t_bound_manager, manager);
+            std::swap(t_bound, bound);
+            std::swap(t_bound_id, id);
+        }
+
+        /** @brief 当前线程是否绑定在 manager 上 (按控制块比较，实例析构期间同样成立)。 */
+        bool IsBoundTo(const std::weak_ptr<PluginManager>& manager) {
+            return t_bound && !t_bound_manager.owner_before(manager) && !manager.owner_before(t_bound_manager);
+        }
+
+        /**
+         * @brief 独立实例在未绑定到它的线程上构造组件、执行插件入口或 Shutdown 时，临时绑定到它，
+         * 使其中的全局服务定位调用解析到同一实例。默认实例与已绑定的线程不做任何事。
+         */
+        class LaneBinding {
+        public:
+            explicit LaneBinding(const PluginManagerPimpl* pimpl) {
+                if (!pimpl->isolated_ || IsBoundTo(pimpl->owner_)) return;
+                active_ = true;
+                previous_ = pimpl->owner_;
+                previous_id_ = pimpl->binding_id_;
+                SwapThreadBinding(previous_, previous_bound_, previous_id_);
+            }
+            ~LaneBinding() {
+                if (active_) SwapThreadBinding(previous_, previous_bound_, previous_id_);
+            }
+
+            LaneBinding(const LaneBinding&) = delete;
+            LaneBinding& operator=(const LaneBinding&) = delete;
+
+        private:
+            bool active_ = false;
+            std::weak_ptr<PluginManager> previous_;
+            bool previous_bound_ = true;
+            uint64_t previous_id_ = 0;
+        };
+    }
+
+    ThreadBinding CaptureThreadBinding() noexcept {
+        return { t_bound_manager, t_bound, t_bound_id };
+    }
+
+    void BindCurrentThread(const ThreadBinding& binding) {
+        if (!binding.bound) return;
+        t_bound_manager = binding.manager;
+        t_bound = true;
+        t_bound_id = binding.id;
+    }
+
+    PluginManagerScope::PluginManagerScope(const std::shared_ptr<PluginManager>& manager)
+        : PluginManagerScope(std::weak_ptr<PluginManager>(manager)) {}
+
+    PluginManagerScope::PluginManagerScope(std::weak_ptr<PluginManager> manager)
+        : previous_(std::move(manager)), previous_bound_(true), previous_id_(kExpiredBindingId) {
+        if (PluginPtr<PluginManager> target = previous_.lock()) previous_id_ = target->pimpl_->binding_id_;
+        SwapThreadBinding(previous_, previous_bound_, previous_id_);
+    }
+
+    PluginManagerScope::~PluginManagerScope() {
+        SwapThreadBinding(previous_, previous_bound_, previous_id_);
     }
 
+    /**
+     * @details 无锁读：RCU 读临界区内加载已发布的裸指针，再通过 weak_from_this 升级为强引用。
+     * 临界区保证实例在升级完成前不会被释放 (见 Destroy)。
+     */
     PluginPtr<PluginManager> PluginManager::GetActiveInstance() {
-        std::lock_guard lock(GetStaticMutex());
-        return GetStaticInstancePtr();
+        if (t_bound) return t_bound_manager.lock();
+        RcuDomain::ReadGuard guard(InstanceDomain());
+        PluginManager* instance = PublishedInstance().load(std::memory_order_acquire);
+        if (!instance) return nullptr;
+        return instance->weak_from_this().lock();
+    }
+
+    const std::atomic<uint64_t>& PluginManager::GetServiceGeneration() noexcept {
+        return ServiceGenerationCounter();
+    }
+
+    const uint64_t& PluginManager::GetThreadBindingId() noexcept {
+        return t_bound_id;
     }
 
     using PluginInitFunc = void(IPluginRegistry*);
@@ -77,55 +196,104 @@ namespace z3y {
     PluginManager::PluginManager() : pimpl_(std::make_unique<PluginManagerPimpl>()) {
         pimpl_->running_ = true;
         // 初始化各钩子为空
-        pimpl_->current_added_components_ = nullptr;
-        pimpl_->event_trace_hook_ = nullptr;
         pimpl_->exception_handler_ = nullptr;
     }
 
     PluginManager::~PluginManager() {
+        // 独立实例：插件的 Shutdown / 析构经服务定位器拿到空指针，而不是默认实例
+        LaneBinding lane(pimpl_.get());
+        // 0. 停止目录监视 (它会并发加载插件)
+        StopPluginDirectoryWatch();
         // 1. 停止事件循环
-        {
-            std::lock_guard<std::mutex> lock(pimpl_->queue_mutex_);
-            pimpl_->running_ = false;
-        }
-        pimpl_->queue_cv_.notify_one();
-        if (pimpl_->event_loop_thread_.joinable()) {
-            pimpl_->event_loop_thread_.join();
-        }
-        // 2. 清理所有插件
+        pimpl_->running_ = false;
+        StopEventWorkers();
+        // 2. 清理所有插件 (单例的 Shutdown 仍可使用执行器取消、等待自己的任务)
         ClearAllRegistries();
+        // 3. 停止共享执行器
+        if (pimpl_->executor_) pimpl_->executor_->Stop();
     }
 
     /**
      * @brief 创建单例。
      */
-    PluginPtr<PluginManager> PluginManager::Create() {
+    PluginPtr<PluginManager> PluginManager::Create(const PluginManagerOptions& options) {
         // 辅助类，用于 make_shared 访问私有构造函数
         struct MakeSharedEnabler : public PluginManager { MakeSharedEnabler() : PluginManager() {} };
         PluginPtr<PluginManager> manager = std::make_shared<MakeSharedEnabler>();
+        manager->pimpl_->owner_ = manager;
+        manager->pimpl_->isolated_ = options.isolated;
+        manager->pimpl_->binding_id_ = NextBindingId();
 
-        {
+        // 独立实例不发布为默认实例，可以任意创建多个
+        if (!options.isolated) {
             std::lock_guard lock(GetStaticMutex());
             if (GetStaticInstancePtr()) throw std::runtime_error("Double Create() detected.");
             GetStaticInstancePtr() = manager;
+            PublishedInstance().store(manager.get(), std::memory_order_release);
+        }
+        BumpServiceGeneration();
+
+        // 队列积压上限 (派发线程启动前设置，之后只读)
+        manager->pimpl_->queue_max_pending_ = options.event_queue_max_pending;
+        manager->pimpl_->queue_overflow_policy_ = options.event_queue_overflow_policy;
+        manager->pimpl_->queue_priority_events_ = options.event_queue_priority_events;
+        manager->pimpl_->gc_pass_budget_ = options.gc_pass_budget;
+        manager->pimpl_->shutdown_threads_ = options.shutdown_threads != 0
+            ? options.shutdown_threads : std::max(1u, std::thread::hardware_concurrency());
+        manager->pimpl_->shutdown_service_timeout_ = options.shutdown_service_timeout;
+        manager->pimpl_->shutdown_skip_unload_ = options.shutdown_skip_library_unload;
+        manager->pimpl_->metrics_time_direct_calls_ = options.event_metrics_time_direct_calls;
+        manager->pimpl_->slow_handler_threshold_ns_ = static_cast<uint64_t>(std::max<int64_t>(options.event_slow_handler_threshold.count(), 0));
+        manager->pimpl_->slow_handler_demote_after_ = options.event_slow_handler_demote_after;
+        manager->pimpl_->time_direct_calls_ = options.event_metrics_time_direct_calls || manager->pimpl_->slow_handler_threshold_ns_ != 0;
+        manager->pimpl_->memory_accounting_ = options.enable_memory_accounting;
+        manager->pimpl_->cpu_accounting_ = options.enable_cpu_accounting;
+        manager->pimpl_->symbol_binding_ = options.plugin_symbol_binding;
+        manager->pimpl_->symbol_binding_overrides_ = options.plugin_symbol_binding_overrides;
+        if (options.framework_pool_allocations) {
+            manager->pimpl_->framework_resource_ = manager->pimpl_->allocator_->FrameworkResource();
         }
+        manager->pimpl_->thread_placements_ = options.thread_placements;
 
-        // 注册内置服务 (EventBus, PluginQuery, PluginManager自身)
-        auto factory = []() -> PluginPtr<IComponent> {
-            if (auto m = PluginManager::GetActiveInstance()) {
+        // 启动派发线程池 (先于内置服务注册，保证任何 Fire 都有线程可投递)
+        manager->StartEventWorkers(options.event_dispatch_threads, options.event_queue_capacity);
+        // 共享执行器：工作线程在第一次投递时才创建。任务异常与事件回调异常走同一个处理器
+        PluginManagerPimpl* pimpl = manager->pimpl_.get();
+        const ThreadPlacement* executor_placement = manager->FindThreadPlacement(thread_role::kExecutor);
+        pimpl->executor_ = std::make_shared<TaskExecutor>(options.executor_threads,
+            [pimpl](const std::exception* e) {
+                if (e) ReportException(pimpl, *e);
+                else ReportUnknownException(pimpl);
+            },
+            [executor_placement, binding = pimpl->InternalThreadBinding()](size_t worker_index) {
+                if (executor_placement) (void)ApplyThreadPlacement(*executor_placement, worker_index);
+                BindCurrentThread(binding);
+            });
+        pimpl->buffer_pool_ = std::make_unique<BufferPool>(options.buffer_pool_max_cached_bytes,
+            options.buffer_pool_huge_pages);
+        pimpl->timer_wheel_ = std::make_unique<TimerWheel>(pimpl->executor_.get(), options.timer_tick,
+            [pimpl](const std::exception* e) {
+                if (e) ReportException(pimpl, *e);
+                else ReportUnknownException(pimpl);
+            });
+
+        // 注册内置服务 (EventBus, PluginQuery, Executor, BufferPool, Timer, Allocator, PluginManager自身)
+        auto factory = [owner = pimpl->owner_]() -> PluginPtr<IComponent> {
+            if (auto m = owner.lock()) {
                 InstanceError err; return PluginCast<IComponent>(m, err);
             }
             return nullptr;
             };
-        auto iids = PluginManager::GetInterfaceDetails();
+        const auto iids = PluginManager::GetInterfaceDescriptors();
 
         manager->RegisterComponent(clsid::kEventBus, factory, true, "z3y.core.eventbus", iids, true);
         manager->RegisterComponent(clsid::kPluginQuery, factory, true, "z3y.core.pluginquery", iids, false);
+        manager->RegisterComponent(clsid::kExecutor, factory, true, "z3y.core.executor", iids, false);
+        manager->RegisterComponent(clsid::kBufferPool, factory, true, "z3y.core.bufferpool", iids, false);
+        manager->RegisterComponent(clsid::kTimerService, factory, true, "z3y.core.timer", iids, false);
+        manager->RegisterComponent(clsid::kAllocator, factory, true, "z3y.core.allocator", iids, false);
         manager->RegisterComponent(PluginManager::kClsid, factory, true, "z3y.core.manager", iids, false);
 
-        // 启动工作线程
-        manager->pimpl_->event_loop_thread_ = std::thread(&PluginManager::EventLoop, manager.get());
-
         // 广播核心事件：框架已就绪
         try {
             auto bus = manager->GetService<IEventBus>(clsid::kEventBus);
@@ -140,14 +308,171 @@ namespace z3y {
         {
             std::lock_guard lock(GetStaticMutex());
             temp = std::move(GetStaticInstancePtr());
+            PublishedInstance().store(nullptr, std::memory_order_release);
+        }
+        BumpServiceGeneration();
+        // 已摘下的指针可能仍被读者持有：把最后一个引用交给 RCU 域，等读者全部离开后在本线程释放
+        InstanceDomain().Retire(std::move(temp));
+        InstanceDomain().Synchronize(); // 触发析构函数
+    }
+
+    void PluginManager::Destroy(std::shared_ptr<PluginManager>& manager) {
+        if (!manager) return;
+        if (!manager->pimpl_->isolated_) {
+            manager.reset();
+            Destroy();
+            return;
         }
-        temp.reset(); // 触发析构函数
+        // 注册表里的内置服务持有实例自身：先清空注册表打破引用环，最后一个引用释放时析构
+        manager->ClearAllRegistries();
+        manager.reset();
+    }
+
+    bool PluginManager::IsIsolated() const noexcept {
+        return pimpl_->isolated_;
     }
 
-    // ... (SetEventTraceHook, SetExceptionHandler 实现略，基本是简单的赋值) ...
+    /**
+     * @details 钩子以 shared_ptr 快照的方式发布：埋点在调用期间持有快照，
+     * 因此替换钩子与正在进行的调用之间没有数据竞争。
+     */
     void PluginManager::SetEventTraceHook(EventTraceHook hook) {
-        std::lock_guard<std::mutex> lock(pimpl_->subscriber_map_mutex_);
-        pimpl_->event_trace_hook_ = std::move(hook);
+        std::shared_ptr<const EventTraceHook> next;
+        if (hook) next = std::make_shared<const EventTraceHook>(std::move(hook));
+        const bool enabled = next != nullptr;
+        std::atomic_store_explicit(&pimpl_->event_trace_hook_, std::move(next), std::memory_order_release);
+        if (enabled) pimpl_->trace_flags_.fetch_or(PluginManagerPimpl::kTraceHook, std::memory_order_release);
+        else pimpl_->trace_flags_.fetch_and(~PluginManagerPimpl::kTraceHook, std::memory_order_release);
+    }
+
+    void PluginManager::SetCallInterception(const std::string& name, bool enabled) {
+        std::lock_guard<std::mutex> lock(pimpl_->interception_mutex_);
+        if (enabled) pimpl_->intercepted_names_.insert(name);
+        else pimpl_->intercepted_names_.erase(name);
+        CallInterceptionFlag().store(
+            !pimpl_->intercepted_names_.empty() || !pimpl_->intercepted_classes_.empty(),
+            std::memory_order_relaxed);
+    }
+
+    void PluginManager::SetCallInterception(const ClassId& clsid, bool enabled) {
+        std::lock_guard<std::mutex> lock(pimpl_->interception_mutex_);
+        if (enabled) pimpl_->intercepted_classes_.insert(clsid);
+        else pimpl_->intercepted_classes_.erase(clsid);
+        CallInterceptionFlag().store(
+            !pimpl_->intercepted_names_.empty() || !pimpl_->intercepted_classes_.empty(),
+            std::memory_order_relaxed);
+    }
+
+    const std::atomic<bool>& PluginManager::IsCallInterceptionActive() noexcept {
+        return CallInterceptionFlag();
+    }
+
+    /** @details 只在有规则时才会被调用；别名在注册表读锁下取出，不与拦截锁嵌套。 */
+    bool PluginManager::ShouldInterceptCalls(const ClassId& clsid, const char* interface_name) const {
+        bool match_alias = false;
+        {
+            std::lock_guard<std::mutex> lock(pimpl_->interception_mutex_);
+            if (pimpl_->intercepted_classes_.count(clsid) ||
+                pimpl_->intercepted_names_.count(interface_name)) {
+                return true;
+            }
+            match_alias = !pimpl_->intercepted_names_.empty();
+        }
+        if (!match_alias) return false;
+        std::string alias;
+        {
+            std::shared_lock lock(pimpl_->registry_mutex_);
+            const auto* record = pimpl_->FindComponent(clsid);
+            if (!record || record->info.alias.empty()) return false;
+            alias = record->info.alias;
+        }
+        std::lock_guard<std::mutex> lock(pimpl_->interception_mutex_);
+        return pimpl_->intercepted_names_.count(alias) != 0;
+    }
+
+    uint64_t PluginManager::GetCurrentEventTaskWaitNs() noexcept {
+        return PluginManagerPimpl::CurrentTaskWaitNs();
+    }
+
+    void PluginManager::StartEventTraceRecording(size_t per_thread_capacity) {
+        pimpl_->trace_recorder_.Start(per_thread_capacity);
+        pimpl_->trace_flags_.fetch_or(PluginManagerPimpl::kTraceRecorder, std::memory_order_release);
+    }
+
+    void PluginManager::StopEventTraceRecording() {
+        pimpl_->trace_flags_.fetch_and(~PluginManagerPimpl::kTraceRecorder, std::memory_order_release);
+    }
+
+    std::vector<EventTraceRecord> PluginManager::GetEventTraceRecords() const {
+        return pimpl_->trace_recorder_.Collect();
+    }
+
+    bool PluginManager::DumpEventTrace(const std::filesystem::path& path) const {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        if (!out) return false;
+        EventTraceRecorder::WriteChromeTrace(out, pimpl_->trace_recorder_.Collect());
+        return static_cast<bool>(out);
+    }
+
+    namespace {
+        /** @brief 进程内稳定的小线程编号 (从 1 开始)，用于启动报告分行。 */
+        uint32_t StartupThreadIndex() {
+            static std::atomic<uint32_t> next{ 1 };
+            thread_local const uint32_t index = next.fetch_add(1, std::memory_order_relaxed);
+            return index;
+        }
+
+        void RecordLoadTiming(PluginManagerPimpl* pimpl, const PluginLoadTiming& timing) {
+            std::lock_guard<std::mutex> lock(pimpl->startup_mutex_);
+            pimpl->load_timings_.push_back(timing);
+        }
+
+        void WriteJsonString(std::ostream& os, const std::string& s) {
+            os << '"';
+            for (const char c : s) {
+                if (c == '"' || c == '\\') os << '\\' << c;
+                else if (static_cast<unsigned char>(c) < 0x20) os << ' ';
+                else os << c;
+            }
+            os << '"';
+        }
+    }
+
+    bool PluginManager::DumpStartupTrace(const std::filesystem::path& path) const {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        if (!out) return false;
+        const StartupReport report = GetStartupReport();
+        uint64_t origin = UINT64_MAX;
+        for (const auto& p : report.plugins) origin = std::min(origin, p.start_ns);
+        for (const auto& s : report.services) origin = std::min(origin, s.start_ns);
+        bool first = true;
+        // 一个 "X" (complete) 区间；时间单位为微秒
+        auto span = [&](const std::string& name, const char* cat, uint64_t start_ns, uint64_t dur_ns, uint32_t tid) {
+            out << (first ? "\n" : ",\n") << "{\"name\":";
+            WriteJsonString(out, name);
+            out << ",\"cat\":\"" << cat << "\",\"ph\":\"X\",\"ts\":" << (start_ns - origin) / 1000 << '.' << ((start_ns - origin) % 1000) / 100
+                << ",\"dur\":" << dur_ns / 1000 << '.' << (dur_ns % 1000) / 100 << ",\"pid\":1,\"tid\":" << tid << '}';
+            first = false;
+            };
+        out << "{\"traceEvents\":[";
+        for (const auto& p : report.plugins) {
+            const std::string file = z3y::utils::PathToUtf8(z3y::utils::Utf8ToPath(p.plugin_path).filename());
+            uint64_t t = p.start_ns;
+            span(file + (p.success ? "" : " (failed)"), "z3y.startup.plugin", t,
+                p.load_library_ns + p.entry_point_ns + p.commit_ns + p.event_ns, p.thread_index);
+            span("load_library", "z3y.startup.phase", t, p.load_library_ns, p.thread_index);
+            t += p.load_library_ns;
+            span("entry_point", "z3y.startup.phase", t, p.entry_point_ns, p.thread_index);
+            t += p.entry_point_ns;
+            span("commit", "z3y.startup.phase", t, p.commit_ns, p.thread_index);
+            t += p.commit_ns;
+            span("register_events", "z3y.startup.phase", t, p.event_ns, p.thread_index);
+        }
+        for (const auto& s : report.services) {
+            span(s.alias.empty() ? std::to_string(s.clsid) : s.alias, "z3y.startup.service", s.start_ns, s.init_ns, s.thread_index);
+        }
+        out << "\n],\"displayTimeUnit\":\"ns\"}\n";
+        return static_cast<bool>(out);
     }
 
     void PluginManager::SetExceptionHandler(ExceptionCallback handler) {
@@ -155,251 +480,950 @@ namespace z3y {
         pimpl_->exception_handler_ = std::make_shared<ExceptionCallback>(std::move(handler));
     }
 
+    void PluginManager::SetSlowEventHandlerCallback(SlowEventHandlerCallback callback) {
+        std::lock_guard lock(pimpl_->exception_handler_mutex_);
+        pimpl_->slow_handler_callback_ = callback ? std::make_shared<SlowEventHandlerCallback>(std::move(callback)) : nullptr;
+    }
+
+    namespace {
+        /** @brief 一个待保存检查点的已构造单例 (在注册表锁内收集，锁外保存)。 */
+        struct CheckpointItem {
+            ClassId clsid;
+            std::string plugin_path;
+            InterfaceList interfaces;
+            PluginPtr<IComponent> instance;
+            std::shared_ptr<AllocationAccount> account;
+        };
+
+        /** @brief [注册表锁内] 收集已构造的单例 (是否实现 ICheckpointable 在锁外判断)。 */
+        void CollectCheckpointItem(std::vector<CheckpointItem>& items, ClassId clsid,
+            const PluginManagerPimpl::ComponentRecord& record) {
+            if (!record.info.is_singleton || !record.singleton.instance) return;
+            items.push_back({ clsid, record.info.source_plugin_path, record.info.implemented_interfaces,
+                record.singleton.instance, record.info.account });
+        }
+
+        /** @brief 依次保存检查点 (在 Shutdown 之前、不持有任何锁)。失败只上报，不影响卸载。 */
+        void SaveCheckpoints(PluginManagerPimpl* pimpl, const std::filesystem::path& dir,
+            const std::vector<CheckpointItem>& items) {
+            for (const auto& item : items) {
+                InstanceError err;
+                ICheckpointable* target = PluginCastNoRef<ICheckpointable>(item.instance, err);
+                if (!target) continue;
+                const CpuChargeScope charge = CpuChargeScope::Lifecycle(item.account.get());
+                try {
+                    std::string message;
+                    if (!WriteCheckpoint(dir, MakeCheckpointKey(item.clsid, item.plugin_path, item.interfaces), *target, message)) {
+                        ReportException(pimpl, std::runtime_error("[z3y FW] " + message));
+                    }
+                } catch (const std::exception& e) { ReportException(pimpl, e); } catch (...) { ReportUnknownException(pimpl); }
+            }
+        }
+    }
+
     void PluginManager::ClearAllRegistries() {
-        // 1. 先 Shutdown 所有单例 (逆序)
-        std::vector<PluginPtr<IComponent>> shutdown_list;
+        LaneBinding lane(pimpl_.get());
+        // 0. 先让所有 ServiceHandle 缓存失效 (之后单例会被 Shutdown 并释放)
+        BumpServiceGeneration();
+        // 1. 先 Shutdown 所有单例：依赖者先于被依赖者，彼此独立的可以并行 (同时就绪时按库的逆序)
+        std::vector<ShutdownItem> shutdown_list;
+        std::vector<CheckpointItem> checkpoints;
+        std::filesystem::path checkpoint_dir;
         {
             std::shared_lock lock(pimpl_->registry_mutex_);
-            // 逆序遍历加载的库，模拟 LIFO
+            checkpoint_dir = pimpl_->checkpoint_dir_;
+            if (!checkpoint_dir.empty()) {
+                pimpl_->components_.ForEach([&checkpoints](ClassId clsid, const auto& record) {
+                    CollectCheckpointItem(checkpoints, clsid, *record);
+                    });
+            }
             for (auto lib_it = pimpl_->loaded_libs_.rbegin(); lib_it != pimpl_->loaded_libs_.rend(); ++lib_it) {
                 auto plugin_comps_it = pimpl_->plugin_path_index_.find(lib_it->first);
                 if (plugin_comps_it == pimpl_->plugin_path_index_.end()) continue;
                 for (const ClassId& clsid : plugin_comps_it->second) {
-                    auto singleton_it = pimpl_->singletons_.find(clsid);
-                    if (singleton_it != pimpl_->singletons_.end() && singleton_it->second.instance) {
-                        shutdown_list.push_back(singleton_it->second.instance);
+                    auto* record = pimpl_->FindComponent(clsid);
+                    if (record && record->singleton.instance) {
+                        shutdown_list.push_back({ clsid, record->info.alias, record->singleton.instance,
+                            record->singleton.dependencies, record->info.account });
                     }
                 }
             }
         }
 
-        for (const auto& instance : shutdown_list) {
-            try { instance->Shutdown(); } catch (const std::exception& e) { ReportException(pimpl_.get(), e); } catch (...) { ReportUnknownException(pimpl_.get()); }
+        // 检查点在任何单例 Shutdown 之前保存：状态仍然完整，依赖的服务也都还在
+        SaveCheckpoints(pimpl_.get(), checkpoint_dir, checkpoints);
+        checkpoints.clear();
+        ShutdownOutcome shutdown = RunShutdownPlan(std::move(shutdown_list),
+            pimpl_->shutdown_threads_, pimpl_->shutdown_service_timeout_);
+        for (const auto& error : shutdown.errors) {
+            try { std::rethrow_exception(error); } catch (const std::exception& e) { ReportException(pimpl_.get(), e); } catch (...) { ReportUnknownException(pimpl_.get()); }
+        }
+        for (ClassId clsid : shutdown.timed_out) {
+            ReportException(pimpl_.get(), std::runtime_error("[z3y FW] Shutdown timed out: clsid " + std::to_string(clsid)));
+        }
+        // 超时的 Shutdown 仍在执行插件代码：这些库不能卸载
+        const bool unload_libraries = !pimpl_->shutdown_skip_unload_ && shutdown.timed_out.empty();
+
+        // 2. 撤下全局/特定发送者订阅表的读侧发布，并等待所有 Fire 离开 RCU 临界区。
+        // (必须在卸载库之前完成：旧列表里的回调闭包代码位于插件模块中)
+        {
+            std::lock_guard lock(pimpl_->subscriber_map_mutex_);
+            std::vector<EventId> published_events;
+            published_events.reserve(pimpl_->global_subscribers_.size());
+            for (const auto& entry : pimpl_->global_subscribers_) {
+                published_events.push_back(entry.first);
+            }
+            for (const auto& entry : pimpl_->family_subscribers_) {
+                for (EventId member : EventFamilyMembers(entry.first)) published_events.push_back(member);
+            }
+            for (const auto& entry : pimpl_->channels_) {
+                published_events.push_back(entry.first);
+            }
+            pimpl_->global_subscribers_.clear();
+            pimpl_->family_subscribers_.clear();
+            pimpl_->channel_subscribers_.clear();
+            for (EventId event_id : published_events) {
+                pimpl_->PublishGlobal(event_id);
+            }
+            pimpl_->sender_subscribers_.clear();
+            pimpl_->sender_keys_.clear();
+            pimpl_->sender_prune_at_ = 64;
+            pimpl_->UnpublishAllSenders();
         }
+        pimpl_->rcu_.Synchronize();
+
+        // 2.5 丢弃共享执行器中尚未开始的任务，并等待正在执行的任务结束 (同样引用插件代码)。
+        // 不能持有注册表锁等待：任务里可能正在 GetService
+        if (pimpl_->executor_) pimpl_->executor_->DiscardPendingAndWait();
+        // 时间轮的唤醒任务刚被一并丢弃；定时器回调同样引用插件代码，全部清空
+        if (pimpl_->timer_wheel_) pimpl_->timer_wheel_->Clear();
+        // 保留事件可能由插件构造，同样在卸载前丢弃
+        pimpl_->ClearRetainedEvents();
 
-        // 2. 清空数据并卸载库
+        // 3. 清空数据并卸载库
         {
             std::scoped_lock lock(
                 pimpl_->registry_mutex_,
                 pimpl_->subscriber_map_mutex_,
-                pimpl_->queue_mutex_,
                 pimpl_->gc_status_mutex_
             );
 
-            // 重置所有容器
-            pimpl_->event_queue_ = {};
+            // 重置所有容器 (丢弃尚未派发的异步任务：它们可能引用即将卸载的插件代码)
+            for (auto& worker : pimpl_->dispatch_workers_) {
+                worker->pending.fetch_sub(worker->Clear(), std::memory_order_relaxed);
+                worker->space.NotifyAll();
+            }
             pimpl_->pending_gc_events_.clear();
+            pimpl_->pending_sender_gc_.clear();
+            pimpl_->gc_pass_scheduled_ = false;
             pimpl_->sender_subscribers_.clear();
+            pimpl_->sender_keys_.clear();
+            pimpl_->sender_prune_at_ = 64;
             pimpl_->global_subscribers_.clear();
             pimpl_->global_sub_lookup_.clear();
+            pimpl_->family_subscribers_.clear();
+            pimpl_->family_sub_lookup_.clear();
+            pimpl_->channel_subscribers_.clear();
+            pimpl_->channel_sub_lookup_.clear();
             pimpl_->sender_sub_lookup_.clear();
 
-            shutdown_list.clear(); // 释放单例引用
-            pimpl_->singletons_.clear();
-            pimpl_->components_.clear();
-            pimpl_->alias_map_.clear();
-            pimpl_->default_map_.clear();
-            pimpl_->current_loading_plugin_path_.clear();
-            pimpl_->current_added_components_ = nullptr;
-            pimpl_->interface_index_.clear();
+            pimpl_->components_.Clear();
+            pimpl_->alias_map_.Clear();
+            pimpl_->default_map_.Clear();
+            pimpl_->interface_index_.Clear();
+            pimpl_->deferred_plugins_.clear();
+            {
+                std::lock_guard<std::mutex> timing_lock(pimpl_->startup_mutex_);
+                pimpl_->load_timings_.clear();
+            }
+            pimpl_->registry_version_.fetch_add(1, std::memory_order_release);
+            std::atomic_store_explicit(&pimpl_->registry_snapshot_, std::shared_ptr<const RegistrySnapshot>(),
+                std::memory_order_release);
             pimpl_->plugin_path_index_.clear();
+            pimpl_->plugin_accounts_.clear();
+            pimpl_->static_plugins_.clear();
 
-            pimpl_->event_trace_hook_ = nullptr;
+            SetEventTraceHook(nullptr);
+            {
+                std::lock_guard<std::mutex> interception_lock(pimpl_->interception_mutex_);
+                pimpl_->intercepted_names_.clear();
+                pimpl_->intercepted_classes_.clear();
+                CallInterceptionFlag().store(false, std::memory_order_relaxed);
+            }
             pimpl_->exception_handler_ = nullptr;
 
-            PlatformSpecificLibraryUnload(); // 调用 FreeLibrary / dlclose
+            if (unload_libraries) PlatformSpecificLibraryUnload(); // 调用 FreeLibrary / dlclose
             pimpl_->loaded_libs_.clear();
+            pimpl_->loaded_lib_paths_.clear();
+            pimpl_->loaded_file_ids_.clear();
         }
     }
 
     // ... (RegisterComponent, CreateInstanceImpl 等逻辑保持不变，省略部分重复代码) ...
-    void PluginManager::RegisterComponent(ClassId clsid, FactoryFunction factory, bool is_singleton, const std::string& alias, std::vector<InterfaceDetails> implemented_interfaces, bool is_default) {
+    void PluginManager::RegisterComponent(ClassId clsid, FactoryFunction factory, bool is_singleton, const std::string& alias, InterfaceDescriptorSpan implemented_interfaces, bool is_default) {
+        RegisterComponentImpl(clsid, std::move(factory), is_singleton, alias, InterfaceList::FromDescriptors(implemented_interfaces), is_default, false);
+    }
+
+    namespace {
+        /** @brief 当前线程正在执行入口函数的插件加载上下文。非空时注册只缓存到其中，由提交阶段统一发布。 */
+        thread_local PluginLoadJob* t_loading_job = nullptr;
+
+        /** @brief 执行插件入口函数，注册收集到 job 中 (动态库与静态插件共用)。 */
+        void RunPluginEntry(IPluginRegistry* registry, PluginLoadJob& job, PluginInitFunc* init_func) {
+            PluginLoadJob* outer = t_loading_job;
+            t_loading_job = &job;
+            const uint64_t entry_start = MetricsNowNs();
+            try {
+                init_func(registry);
+            } catch (const std::exception& e) {
+                job.error = "Init exception: " + std::string(e.what());
+            } catch (...) {
+                job.error = "Init unknown exception";
+            }
+            job.timing.entry_point_ns = MetricsNowNs() - entry_start;
+            t_loading_job = outer;
+        }
+    }
+
+    void PluginManager::RegisterComponentImpl(ClassId clsid, FactoryFunction factory, bool is_singleton, const std::string& alias, InterfaceList implemented_interfaces, bool is_default, bool factory_initializes) {
+        PendingRegistration reg{ clsid, std::move(factory), is_singleton, alias, std::move(implemented_interfaces), is_default, factory_initializes };
+        if (t_loading_job) {
+            t_loading_job->registrations.push_back(std::move(reg));
+            return;
+        }
+        std::vector<PendingRegistration> batch;
+        batch.push_back(std::move(reg));
+        (void)CommitRegistrations(std::string(), nullptr, batch);
+    }
+
+    void PluginManager::RegisterComponents(std::vector<ComponentRegistration> registrations) {
+        std::vector<PendingRegistration> local;
+        std::vector<PendingRegistration>& batch = t_loading_job ? t_loading_job->registrations : local;
+        batch.reserve(batch.size() + registrations.size());
+        for (auto& reg : registrations) {
+            batch.push_back({ reg.clsid, std::move(reg.factory), reg.is_singleton, std::move(reg.alias),
+                InterfaceList::FromDescriptors(reg.implemented_interfaces), reg.is_default, reg.factory_initializes,
+                false, std::move(reg.event_handlers) });
+        }
+        if (!t_loading_job && !batch.empty()) (void)CommitRegistrations(std::string(), nullptr, batch);
+    }
+
+    namespace {
+        /** @brief 声明式处理函数表的内省形式 (事件名复制一份，插件卸载后仍有效)。 */
+        std::vector<EventHandlerDetails> EventHandlerDetailsOf(const std::vector<EventHandlerEntry>& handlers) {
+            std::vector<EventHandlerDetails> details;
+            details.reserve(handlers.size());
+            for (const auto& h : handlers) details.push_back({ h.event_id, h.event_name ? h.event_name : "", h.connection_type });
+            return details;
+        }
+
+        /** @brief 按 event_id 插入 (同一事件保持声明顺序)。 */
+        void InsertEventHandler(std::vector<EventHandlerEntry>& handlers, const EventHandlerEntry& handler) {
+            auto pos = std::upper_bound(handlers.begin(), handlers.end(), handler.event_id,
+                [](EventId id, const EventHandlerEntry& h) { return id < h.event_id; });
+            handlers.insert(pos, handler);
+        }
+    }
+
+    void PluginManager::RegisterEventHandler(ClassId clsid, const EventHandlerEntry& handler) {
+        // 插件加载期间：并入尚未提交的注册
+        if (t_loading_job) {
+            for (auto& reg : t_loading_job->registrations) {
+                if (reg.clsid != clsid) continue;
+                InsertEventHandler(reg.event_handlers, handler);
+                return;
+            }
+        }
+        std::unique_lock lock(pimpl_->registry_mutex_);
+        auto* record = pimpl_->FindComponent(clsid);
+        if (!record) throw std::runtime_error("Event handler for an unregistered ClassId.");
+        auto handlers = record->info.event_handlers
+            ? std::vector<EventHandlerEntry>(*record->info.event_handlers) : std::vector<EventHandlerEntry>();
+        InsertEventHandler(handlers, handler);
+        auto details = std::make_shared<ComponentDetails>(*record->details);
+        details->event_handlers = EventHandlerDetailsOf(handlers);
+        record->details = std::move(details);
+        record->info.event_handlers = std::make_shared<const std::vector<EventHandlerEntry>>(std::move(handlers));
+        pimpl_->registry_version_.fetch_add(1, std::memory_order_release);
+    }
+
+    bool PluginManager::CommitRegistrations(const std::string& plugin_path, LibHandle handle, std::vector<PendingRegistration>& batch, PluginLoadTiming* timing, const PluginFileInfo* file_info) {
         PluginPtr<IEventBus> bus;
+        const uint64_t commit_start = timing ? MetricsNowNs() : 0;
         {
             std::unique_lock lock(pimpl_->registry_mutex_);
-            if (pimpl_->components_.count(clsid)) throw std::runtime_error("ClassId already registered.");
-            if (is_default) {
-                for (const auto& iface : implemented_interfaces) {
+            if (handle && pimpl_->IsLibraryLoaded(plugin_path, file_info)) return false;  // 并发的另一次加载已经提交
+            // 延迟条目的实际加载：同一插件的延迟条目由真实注册替换 (索引已按清单建立)
+            auto deferred_record = [&](ClassId clsid) -> PluginManagerPimpl::ComponentRecord* {
+                auto* record = pimpl_->FindComponent(clsid);
+                return record && record->info.deferred && record->info.source_plugin_path == plugin_path ? record : nullptr;
+                };
+            // 1. 整体校验：任何冲突都在修改注册表之前抛出
+            FlatIdMap<bool> batch_clsids;
+            FlatIdMap<ClassId> batch_defaults;
+            for (const auto& reg : batch) {
+                if (!batch_clsids.TryEmplace(reg.clsid).second) throw std::runtime_error("ClassId already registered.");
+                if (handle && deferred_record(reg.clsid)) continue;
+                if (pimpl_->components_.Contains(reg.clsid)) throw std::runtime_error("ClassId already registered.");
+                if (!reg.is_default) continue;
+                for (const auto& iface : reg.implemented_interfaces) {
                     if (iface.iid == IComponent::kIid) continue;
-                    if (pimpl_->default_map_.count(iface.iid)) throw std::runtime_error("Default conflict: " + iface.name);
-                    pimpl_->default_map_[iface.iid] = clsid;
+                    if (pimpl_->default_map_.Contains(iface.iid) || !batch_defaults.TryEmplace(iface.iid).second) {
+                        throw std::runtime_error("Default conflict: " + iface.name);
+                    }
+                }
+            }
+            // 2. 发布 (先按整批大小预留，避免逐条扩容)
+            pimpl_->components_.Reserve(pimpl_->components_.size() + batch.size());
+            pimpl_->alias_map_.Reserve(pimpl_->alias_map_.size() + batch.size());
+            auto& path_components = pimpl_->plugin_path_index_[plugin_path];
+            path_components.reserve(path_components.size() + batch.size());
+            std::shared_ptr<AllocationAccount> account;
+            if ((pimpl_->memory_accounting_ || pimpl_->cpu_accounting_) && !plugin_path.empty()) {
+                auto& slot = pimpl_->plugin_accounts_[plugin_path];
+                if (!slot) {
+                    slot = std::make_shared<AllocationAccount>();
+                    slot->cpu_accounting = pimpl_->cpu_accounting_;
+                }
+                account = slot;
+            }
+            for (auto& reg : batch) {
+                const ClassId clsid = reg.clsid;
+                if (auto* stub = handle ? deferred_record(clsid) : nullptr) {
+                    stub->info.factory = std::move(reg.factory);
+                    if (const auto* fn = stub->info.factory.target<FactoryFunctionPtr>()) stub->info.factory_ptr = *fn;
+                    stub->info.factory_initializes = reg.factory_initializes;
+                    stub->info.account = account;
+                    if (!reg.event_handlers.empty()) {
+                        auto details = std::make_shared<ComponentDetails>(*stub->details);
+                        details->event_handlers = EventHandlerDetailsOf(reg.event_handlers);
+                        stub->details = std::move(details);
+                        stub->info.event_handlers = std::make_shared<const std::vector<EventHandlerEntry>>(std::move(reg.event_handlers));
+                    }
+                    stub->info.deferred = false;
+                    reg.deferred = true;  // 标记为替换：不再触发注册事件
+                    continue;
+                }
+                if (reg.is_default) {
+                    for (const auto& iface : reg.implemented_interfaces) {
+                        if (iface.iid != IComponent::kIid) pimpl_->default_map_[iface.iid] = clsid;
+                    }
+                }
+                for (const auto& iface : reg.implemented_interfaces) pimpl_->interface_index_[iface.iid].push_back(clsid);
+                path_components.push_back(clsid);
+                auto record = std::make_unique<PluginManagerPimpl::ComponentRecord>();
+                record->info = { std::move(reg.factory), reg.is_singleton, reg.alias, plugin_path, std::move(reg.implemented_interfaces), reg.is_default, reg.factory_initializes };
+                if (const auto* fn = record->info.factory.target<FactoryFunctionPtr>()) record->info.factory_ptr = *fn;
+                record->info.deferred = reg.deferred;
+                record->info.account = account;
+                record->details = std::make_shared<const ComponentDetails>(ComponentDetails{ clsid, reg.alias, reg.is_singleton,
+                    plugin_path, reg.is_default, record->info.implemented_interfaces, EventHandlerDetailsOf(reg.event_handlers) });
+                if (!reg.event_handlers.empty()) {
+                    record->info.event_handlers = std::make_shared<const std::vector<EventHandlerEntry>>(std::move(reg.event_handlers));
                 }
+                pimpl_->components_[clsid] = std::move(record);
+                if (!reg.alias.empty()) pimpl_->alias_map_.Insert(reg.alias, ConstexprHash(reg.alias), clsid);
+            }
+            if (handle) {
+                pimpl_->AddLoadedLibrary(plugin_path, handle, file_info);
+                pimpl_->deferred_plugins_.erase(plugin_path);
             }
-            for (const auto& iface : implemented_interfaces) pimpl_->interface_index_[iface.iid].push_back(clsid);
-            pimpl_->plugin_path_index_[pimpl_->current_loading_plugin_path_].push_back(clsid);
-            pimpl_->components_[clsid] = { factory, is_singleton, alias, pimpl_->current_loading_plugin_path_, std::move(implemented_interfaces), is_default };
-            if (is_singleton) pimpl_->singletons_[clsid].factory = pimpl_->components_[clsid].factory;
-            if (pimpl_->current_added_components_) pimpl_->current_added_components_->push_back(clsid);
-            if (!alias.empty()) pimpl_->alias_map_[alias] = clsid;
+            pimpl_->registry_version_.fetch_add(1, std::memory_order_release);
             if (pimpl_->running_) { InstanceError err; bus = PluginCast<IEventBus>(shared_from_this(), err); }
         }
-        if (bus) bus->FireGlobal<event::ComponentRegisterEvent>(clsid, alias, pimpl_->current_loading_plugin_path_, is_singleton);
+        BumpServiceGeneration(); // 新的默认实现可能让此前 “未找到” 的缓存变为可用
+        const uint64_t events_start = timing ? MetricsNowNs() : 0;
+        if (bus) {
+            std::vector<ClassId> published;
+            published.reserve(batch.size());
+            for (const auto& reg : batch) {
+                if (handle && reg.deferred) continue;
+                bus->FireGlobal<event::ComponentRegisterEvent>(reg.clsid, reg.alias, plugin_path, reg.is_singleton);
+                published.push_back(reg.clsid);
+            }
+            if (!published.empty()) bus->FireGlobal<event::ComponentsRegisteredEvent>(plugin_path, std::move(published));
+        }
+        if (timing) {
+            timing->commit_ns = events_start - commit_start;
+            timing->event_ns = MetricsNowNs() - events_start;
+            timing->component_count = batch.size();
+        }
+        return true;
+    }
+
+    void PluginManager::RegisterPooledComponent(ClassId clsid, FactoryFunction factory, const std::string& alias, InterfaceDescriptorSpan implemented_interfaces, bool is_default) {
+        RegisterComponentImpl(clsid, std::move(factory), false, alias, InterfaceList::FromDescriptors(implemented_interfaces), is_default, true);
+    }
+
+    namespace {
+        /** @brief 当前线程的内存记账作用域 (指向调用方栈上或注册表条目中的账户)。 */
+        thread_local const std::shared_ptr<AllocationAccount>* t_allocation_account = nullptr;
+
+        /**
+         * @brief [内部] 在调用工厂与 Initialize() 期间把插件账户设为当前作用域。
+         * @details 账户为空也会覆盖外层作用域：一个插件在 Initialize 中创建的其他插件 (或宿主) 的组件不记到它名下。
+         */
+        class AllocationScope {
+        public:
+            explicit AllocationScope(const std::shared_ptr<AllocationAccount>& account) noexcept
+                : outer_(t_allocation_account) {
+                t_allocation_account = &account;
+            }
+            ~AllocationScope() { t_allocation_account = outer_; }
+            AllocationScope(const AllocationScope&) = delete;
+            AllocationScope& operator=(const AllocationScope&) = delete;
+
+        private:
+            const std::shared_ptr<AllocationAccount>* outer_;
+        };
+    }
+
+    std::shared_ptr<AllocationAccount> internal::CurrentAllocationAccount() noexcept {
+        const auto* account = t_allocation_account;
+        return account ? *account : nullptr;
     }
 
     PluginPtr<IComponent> PluginManager::CreateInstanceImpl(const ClassId& clsid) {
-        FactoryFunction factory;
-        {
+        FactoryFunctionPtr factory_ptr = nullptr;
+        FactoryFunction factory;  // 仅当工厂有状态时才拷贝
+        bool factory_initializes = false;
+        std::shared_ptr<AllocationAccount> account;
+        std::shared_ptr<const std::vector<EventHandlerEntry>> handlers;
+        for (bool first = true;; first = false) {
             std::shared_lock lock(pimpl_->registry_mutex_);
-            auto it = pimpl_->components_.find(clsid);
-            if (it == pimpl_->components_.end()) throw PluginException(InstanceError::kErrorClsidNotFound);
-            if (it->second.is_singleton) throw PluginException(InstanceError::kErrorNotAComponent);
-            factory = it->second.factory;
+            const auto* record = pimpl_->FindComponent(clsid);
+            if (!record) throw PluginException(InstanceError::kErrorClsidNotFound);
+            if (record->info.is_singleton) throw PluginException(InstanceError::kErrorNotAComponent);
+            if (record->info.deferred) {
+                if (!first) throw PluginException(InstanceError::kErrorFactoryFailed, "Deferred plugin failed to provide the component.");
+                lock.unlock();
+                LoadDeferredPlugin(clsid);
+                continue;
+            }
+            factory_ptr = record->info.factory_ptr;
+            if (!factory_ptr) factory = record->info.factory;
+            factory_initializes = record->info.factory_initializes;
+            account = record->info.account;
+            handlers = record->info.event_handlers;
+            break;
         }
-        auto obj = factory();
+        AllocationScope scope(account);
+        const CpuChargeScope charge = CpuChargeScope::Lifecycle(account.get());
+        LaneBinding lane(pimpl_.get());
+        auto obj = factory_ptr ? factory_ptr() : factory();
         if (!obj) throw PluginException(InstanceError::kErrorFactoryFailed);
-        obj->Initialize();
+        if (!factory_initializes) obj->Initialize();
+        if (handlers) SubscribeEventHandlers(pimpl_.get(), obj, *handlers);
         return obj;
     }
 
+    namespace {
+        /** @brief 当前线程正在初始化的单例的依赖列表 (嵌套 GetService 记录到这里)。 */
+        thread_local std::vector<ClassId>* t_initializing_dependencies = nullptr;
+
+        /** @brief 首次构造单例时需要的检查点参数 (在注册表锁内复制)。dir 为空表示未启用。 */
+        struct CheckpointSource {
+            std::filesystem::path dir;
+            std::string plugin_path;
+            InterfaceList interfaces;
+        };
+
+        /** @brief 工厂返回之后、Initialize 之前尝试恢复检查点。失败只上报：服务照常冷启动。 */
+        void RestoreSingletonCheckpoint(PluginManagerPimpl* pimpl, ClassId clsid, const CheckpointSource& source,
+            const PluginPtr<IComponent>& instance) {
+            InstanceError err;
+            ICheckpointable* target = PluginCastNoRef<ICheckpointable>(instance, err);
+            if (!target) return;
+            try {
+                (void)ReadCheckpoint(source.dir, MakeCheckpointKey(clsid, source.plugin_path, source.interfaces), *target);
+            } catch (const std::exception& e) { ReportException(pimpl, e); } catch (...) { ReportUnknownException(pimpl); }
+        }
+
+        /**
+         * @brief 查找并 (首次访问时) 构造单例。查找失败时返回 nullptr 并写入 out_error，不抛出。
+         * @details 构造失败的异常与错误码都记录在 holder 上，由调用方决定是重新抛出还是返回错误码。
+         * 命中延迟条目时：若 out_deferred 非空则置位并返回 nullptr (由调用方加载库后重试)，否则视为工厂失败。
+         */
+        PluginManagerPimpl::SingletonHolder* ResolveSingleton(PluginManagerPimpl* pimpl, const ClassId& clsid,
+            InstanceError& out_error, bool* out_deferred = nullptr) {
+            PluginManagerPimpl::SingletonHolder* holder = nullptr;
+            const FactoryFunction* factory = nullptr;
+            const std::shared_ptr<AllocationAccount>* account = nullptr;
+            std::shared_ptr<const std::vector<EventHandlerEntry>> handlers;  // 可能被 RegisterEventHandler 替换：锁内复制
+            CheckpointSource checkpoint;
+            {
+                std::shared_lock lock(pimpl->registry_mutex_);
+                auto* record = pimpl->FindComponent(clsid);
+                if (!record) {
+                    out_error = InstanceError::kErrorClsidNotFound;
+                    return nullptr;
+                }
+                if (!record->info.is_singleton) {
+                    out_error = InstanceError::kErrorNotAService;
+                    return nullptr;
+                }
+                if (record->info.deferred) {
+                    if (out_deferred) *out_deferred = true;
+                    else out_error = InstanceError::kErrorFactoryFailed;
+                    return nullptr;
+                }
+                // 条目由 unique_ptr 持有：表扩容不会移动它
+                holder = &record->singleton;
+                factory = &record->info.factory;
+                account = &record->info.account;
+                if (!holder->initialized.load(std::memory_order_acquire)) {
+                    handlers = record->info.event_handlers;
+                    if (!pimpl->checkpoint_dir_.empty()) {
+                        checkpoint = { pimpl->checkpoint_dir_, record->info.source_plugin_path, record->info.implemented_interfaces };
+                    }
+                }
+            }
+            // 在另一个单例的 Initialize 中被获取：记为它的依赖
+            if (auto* deps = t_initializing_dependencies) {
+                if (std::find(deps->begin(), deps->end(), clsid) == deps->end()) deps->push_back(clsid);
+            }
+            std::call_once(holder->flag, [pimpl, clsid, holder, factory, account, &handlers, &checkpoint]() {
+                AllocationScope scope(*account);
+                LaneBinding lane(pimpl);
+                std::vector<ClassId>* outer = t_initializing_dependencies;
+                t_initializing_dependencies = &holder->dependencies;
+                holder->init_thread = StartupThreadIndex();
+                holder->init_start_ns = MetricsNowNs();
+                const auto start = std::chrono::steady_clock::now();
+                try {
+                    const CpuChargeScope charge = CpuChargeScope::Lifecycle(account->get());
+                    holder->instance = (*factory)();
+                    if (!holder->instance) throw PluginException(InstanceError::kErrorFactoryFailed);
+                    if (!checkpoint.dir.empty()) RestoreSingletonCheckpoint(pimpl, clsid, checkpoint, holder->instance);
+                    holder->instance->Initialize();
+                    if (handlers) SubscribeEventHandlers(pimpl, holder->instance, *handlers);
+                } catch (const PluginException& e) {
+                    holder->e_ptr = std::current_exception();
+                    holder->error = e.GetError();
+                    holder->instance.reset();
+                } catch (...) {
+                    holder->e_ptr = std::current_exception();
+                    holder->error = InstanceError::kErrorInternal;
+                    holder->instance.reset();
+                }
+                holder->init_ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start).count());
+                t_initializing_dependencies = outer;
+                holder->initialized.store(true, std::memory_order_release);
+                });
+            out_error = holder->error;
+            return holder;
+        }
+    }
+
     PluginPtr<IComponent> PluginManager::GetServiceImpl(const ClassId& clsid) {
-        PluginManagerPimpl::SingletonHolder* holder = nullptr;
+        InstanceError error = InstanceError::kSuccess;
+        bool deferred = false;
+        PluginManagerPimpl::SingletonHolder* holder = ResolveSingleton(pimpl_.get(), clsid, error, &deferred);
+        if (deferred) {
+            LoadDeferredPlugin(clsid);
+            holder = ResolveSingleton(pimpl_.get(), clsid, error);
+        }
+        if (!holder) throw PluginException(error);
+        if (holder->e_ptr) std::rethrow_exception(holder->e_ptr);
+        return holder->instance;
+    }
+
+    PluginPtr<IComponent> PluginManager::TryGetServiceImpl(const ClassId& clsid, InstanceError& out_error) {
+        bool deferred = false;
+        PluginManagerPimpl::SingletonHolder* holder = ResolveSingleton(pimpl_.get(), clsid, out_error, &deferred);
+        if (deferred) {
+            try {
+                LoadDeferredPlugin(clsid);
+            } catch (...) {}  // noexcept API：加载失败由下面的重试表现为 kErrorFactoryFailed
+            holder = ResolveSingleton(pimpl_.get(), clsid, out_error);
+        }
+        return holder ? holder->instance : nullptr;
+    }
+
+    /**
+     * @details 工作线程从共享下标领取任务 (调用线程也参与)，每个任务就是一次非抛出的单例解析。
+     * 不使用事件派发线程：Initialize 可能阻塞或同步 Fire 事件。
+     */
+    ServiceWarmUpReport PluginManager::WarmUpServices(size_t threads) {
+        const auto start = std::chrono::steady_clock::now();
+        ServiceWarmUpReport report;
         {
             std::shared_lock lock(pimpl_->registry_mutex_);
-            auto it = pimpl_->singletons_.find(clsid);
-            if (it == pimpl_->singletons_.end()) {
-                if (pimpl_->components_.count(clsid)) throw PluginException(InstanceError::kErrorNotAService);
-                throw PluginException(InstanceError::kErrorClsidNotFound);
-            }
-            holder = &(it->second);
+            pimpl_->components_.ForEach([&report](ClassId clsid, const auto& record) {
+                if (!record->info.is_singleton) return;
+                ServiceWarmUpResult result;
+                result.clsid = clsid;
+                result.alias = record->info.alias;
+                report.services.push_back(std::move(result));
+                });
         }
-        std::call_once(holder->flag, [this, holder]() {
-            try {
-                holder->instance = holder->factory();
-                if (!holder->instance) throw PluginException(InstanceError::kErrorFactoryFailed);
-                holder->instance->Initialize();
-            } catch (...) {
-                holder->e_ptr = std::current_exception();
-                holder->instance.reset();
+
+        if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+        threads = std::min(threads, std::max<size_t>(report.services.size(), 1));
+        report.threads = threads;
+
+        std::atomic<size_t> next{ 0 };
+        auto work = [this, &report, &next]() {
+            for (size_t i; (i = next.fetch_add(1, std::memory_order_relaxed)) < report.services.size();) {
+                ServiceWarmUpResult& result = report.services[i];
+                InstanceError error = InstanceError::kSuccess;
+                bool deferred = false;
+                auto* holder = ResolveSingleton(pimpl_.get(), result.clsid, error, &deferred);
+                if (deferred) {
+                    LoadDeferredPlugin(result.clsid);
+                    holder = ResolveSingleton(pimpl_.get(), result.clsid, error);
+                }
+                result.error = error;
+                if (holder) {
+                    result.init_ns = holder->init_ns;
+                    result.dependencies = holder->dependencies;
+                }
             }
-            });
-        if (holder->e_ptr) std::rethrow_exception(holder->e_ptr);
-        return holder->instance;
+            };
+        std::vector<std::thread> pool;
+        for (size_t t = 1; t < threads; ++t) pool.emplace_back(work);
+        work();
+        for (auto& t : pool) t.join();
+
+        report.total_ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count());
+        return report;
     }
 
     std::optional<ClassId> PluginManager::GetDefaultClsidImpl(InterfaceId iid) {
         std::shared_lock lock(pimpl_->registry_mutex_);
-        auto it = pimpl_->default_map_.find(iid);
-        if (it == pimpl_->default_map_.end()) return std::nullopt;
-        return it->second;
+        const ClassId* clsid = pimpl_->default_map_.Find(iid);
+        if (!clsid) return std::nullopt;
+        return *clsid;
     }
 
-    std::optional<ClassId> PluginManager::GetClsidFromAlias(const std::string& alias) const {
+    std::optional<ClassId> PluginManager::GetClsidFromAlias(Alias alias) const {
         std::shared_lock lock(pimpl_->registry_mutex_);
-        auto it = pimpl_->alias_map_.find(alias);
-        if (it != pimpl_->alias_map_.end()) return it->second;
+        if (const ClassId* clsid = pimpl_->alias_map_.Find(alias.name, alias.hash)) return *clsid;
         return std::nullopt;
     }
 
-    void PluginManager::RollbackRegistrations(const std::vector<ClassId>& clsid_list) {
-        std::unique_lock lock(pimpl_->registry_mutex_);
-        for (const ClassId clsid : clsid_list) {
-            auto it = pimpl_->components_.find(clsid);
-            if (it == pimpl_->components_.end()) continue;
-            const auto& info = it->second;
-            if (!info.alias.empty()) pimpl_->alias_map_.erase(info.alias);
-            if (info.is_default_registration) {
-                for (const auto& iface : info.implemented_interfaces) {
-                    auto dit = pimpl_->default_map_.find(iface.iid);
-                    if (dit != pimpl_->default_map_.end() && dit->second == clsid) pimpl_->default_map_.erase(dit);
-                }
-            }
-            for (const auto& iface : info.implemented_interfaces) {
-                auto& vec = pimpl_->interface_index_[iface.iid];
-                vec.erase(std::remove(vec.begin(), vec.end(), clsid), vec.end());
+    bool PluginManager::LoadPluginInternal(const std::filesystem::path& file_path, const std::string& init_func_name, std::string& out_error_message) {
+        PluginLoadJob job;
+        job.file_path = file_path;
+        job.path_str = z3y::utils::PathToUtf8(file_path);
+        PreparePluginLoad(job, init_func_name);
+        return CommitPluginLoad(job, out_error_message);
+    }
+
+    void PluginManager::PreparePluginLoad(PluginLoadJob& job, const std::string& init_func_name) {
+        if (!job.has_file_info) job.has_file_info = QueryPluginFileInfo(job.file_path, job.file_info);
+        {
+            std::shared_lock lock(pimpl_->registry_mutex_);
+            if (pimpl_->IsLibraryLoaded(job.path_str, job.has_file_info ? &job.file_info : nullptr)) {
+                job.already_loaded = true;
+                return;
             }
-            auto& pvec = pimpl_->plugin_path_index_[info.source_plugin_path];
-            pvec.erase(std::remove(pvec.begin(), pvec.end(), clsid), pvec.end());
-            pimpl_->singletons_.erase(clsid);
-            pimpl_->components_.erase(it);
+        }
+        job.timing.plugin_path = job.path_str;
+        job.timing.thread_index = StartupThreadIndex();
+        job.timing.start_ns = MetricsNowNs();
+        PluginSymbolBinding binding = pimpl_->symbol_binding_;
+        auto override_it = pimpl_->symbol_binding_overrides_.find(z3y::utils::PathToUtf8(job.file_path.filename()));
+        if (override_it != pimpl_->symbol_binding_overrides_.end()) binding = override_it->second;
+        job.handle = PlatformLoadLibrary(job.file_path, binding);
+        job.timing.load_library_ns = MetricsNowNs() - job.timing.start_ns;
+        if (!job.handle) {
+            job.error = "LoadLibrary failed: " + z3y::utils::GetLastSystemError();
+            return;
+        }
+        PluginInitFunc* init_func = (PluginInitFunc*)PlatformGetFunction(job.handle, init_func_name.c_str());
+        if (!init_func) {
+            job.error = "Entry point not found: " + init_func_name;
+        } else {
+            LaneBinding lane(pimpl_.get());
+            RunPluginEntry(this, job, init_func);
+        }
+        if (!job.error.empty()) {
+            job.registrations.clear();  // 工厂的代码位于库中，必须先于卸载销毁
+            PlatformUnloadLibrary(job.handle);
+            job.handle = nullptr;
         }
     }
 
-    bool PluginManager::LoadPluginInternal(const std::filesystem::path& file_path, const std::string& init_func_name, std::string& out_error_message) {
+    bool PluginManager::CommitPluginLoad(PluginLoadJob& job, std::string& out_error_message) {
+        if (job.already_loaded) return true;
         PluginPtr<IEventBus> bus;
         try { InstanceError err; bus = PluginCast<IEventBus>(shared_from_this(), err); } catch (...) {}
-        std::string path_str = z3y::utils::PathToUtf8(file_path);
+        if (job.error.empty()) {
+            bool committed = false;
+            try {
+                committed = CommitRegistrations(job.path_str, job.handle, job.registrations, &job.timing,
+                    job.has_file_info ? &job.file_info : nullptr);
+            } catch (const std::exception& e) {
+                job.error = "Init exception: " + std::string(e.what());
+            }
+            job.registrations.clear();
+            if (job.error.empty()) {
+                if (!committed) {
+                    if (job.handle) PlatformUnloadLibrary(job.handle);  // 只释放本次 dlopen 增加的引用
+                    return true;
+                }
+                job.timing.success = true;
+                RecordLoadTiming(pimpl_.get(), job.timing);
+                if (bus) bus->FireGlobal<event::PluginLoadSuccessEvent>(job.path_str);
+                return true;
+            }
+            if (job.handle) PlatformUnloadLibrary(job.handle);  // 静态插件没有库句柄
+            job.handle = nullptr;
+        }
+        RecordLoadTiming(pimpl_.get(), job.timing);
+        out_error_message = job.error;
+        if (bus) bus->FireGlobal<event::PluginLoadFailureEvent>(job.path_str, out_error_message);
+        return false;
+    }
+
+    bool PluginManager::LoadStaticPlugin(const StaticPluginEntry& plugin, std::string& out_error_message) {
+        if (!plugin.name || !plugin.init) {
+            out_error_message = "Invalid static plugin entry.";
+            return false;
+        }
         {
+            // 先占用名字：并发加载同一个静态插件时只有一次执行入口函数
             std::unique_lock lock(pimpl_->registry_mutex_);
-            for (const auto& pair : pimpl_->loaded_libs_) {
-                if (pair.first == path_str) return true;
+            if (!pimpl_->static_plugins_.insert(plugin.name).second) return true;
+        }
+        PluginLoadJob job;
+        job.path_str = std::string(kStaticPluginPathPrefix) + plugin.name;
+        job.timing.plugin_path = job.path_str;
+        job.timing.thread_index = StartupThreadIndex();
+        job.timing.start_ns = MetricsNowNs();
+        LaneBinding lane(pimpl_.get());
+        RunPluginEntry(this, job, plugin.init);
+        if (!job.error.empty()) job.registrations.clear();
+        if (CommitPluginLoad(job, out_error_message)) return true;
+        std::unique_lock lock(pimpl_->registry_mutex_);
+        pimpl_->static_plugins_.erase(plugin.name);
+        return false;
+    }
+
+    std::vector<std::string> PluginManager::LoadStaticPlugins(const StaticPluginEntry* plugins, size_t count) {
+        std::vector<std::string> failures;
+        for (size_t i = 0; i < count; ++i) {
+            std::string err;
+            if (!LoadStaticPlugin(plugins[i], err)) {
+                failures.push_back(std::string(plugins[i].name ? plugins[i].name : "") + ": " + err);
             }
         }
-        LibHandle handle = PlatformLoadLibrary(file_path);
-        if (!handle) {
-            out_error_message = "LoadLibrary failed: " + z3y::utils::GetLastSystemError();
-            if (bus) bus->FireGlobal<event::PluginLoadFailureEvent>(path_str, out_error_message);
-            return false;
+        return failures;
+    }
+
+    bool PluginManager::CommitDeferredPlugin(PluginLoadJob& job, const std::string& init_func_name, std::string& out_error_message) {
+        {
+            std::unique_lock lock(pimpl_->registry_mutex_);
+            if (pimpl_->deferred_plugins_.count(job.path_str)) return true;
+            if (pimpl_->IsLibraryLoaded(job.path_str, job.has_file_info ? &job.file_info : nullptr)) return true;
+            // 先登记再发布条目：条目可见时一定能找到加载参数
+            pimpl_->deferred_plugins_[job.path_str] = { job.file_path, init_func_name };
         }
-        PluginInitFunc* init_func = (PluginInitFunc*)PlatformGetFunction(handle, init_func_name.c_str());
-        if (!init_func) {
-            out_error_message = "Entry point not found: " + init_func_name;
-            if (bus) bus->FireGlobal<event::PluginLoadFailureEvent>(path_str, out_error_message);
-            PlatformUnloadLibrary(handle);
-            return false;
+        job.timing.plugin_path = job.path_str;
+        std::vector<PendingRegistration> batch;
+        batch.reserve(job.manifest->components.size());
+        for (const auto& c : job.manifest->components) {
+            batch.push_back({ c.clsid, FactoryFunction(), c.is_singleton, c.alias, InterfaceList(c.interfaces), c.is_default, false, true });
         }
-        std::vector<ClassId> added;
+        job.timing.start_ns = MetricsNowNs();
+        job.timing.thread_index = StartupThreadIndex();
+        job.timing.deferred = true;
         try {
-            {
-                std::unique_lock lock(pimpl_->registry_mutex_);
-                pimpl_->current_loading_plugin_path_ = path_str;
-                pimpl_->current_added_components_ = &added;
-            }
-            init_func(this);
-            {
-                std::unique_lock lock(pimpl_->registry_mutex_);
-                pimpl_->current_loading_plugin_path_ = "";
-                pimpl_->current_added_components_ = nullptr;
-                pimpl_->loaded_libs_.push_back({ path_str, handle });
-            }
-            if (bus) bus->FireGlobal<event::PluginLoadSuccessEvent>(path_str);
+            (void)CommitRegistrations(job.path_str, nullptr, batch, &job.timing);
+            job.timing.success = true;
+            RecordLoadTiming(pimpl_.get(), job.timing);
             return true;
         } catch (const std::exception& e) {
             {
                 std::unique_lock lock(pimpl_->registry_mutex_);
-                pimpl_->current_loading_plugin_path_ = "";
-                pimpl_->current_added_components_ = nullptr;
+                pimpl_->deferred_plugins_.erase(job.path_str);
             }
-            RollbackRegistrations(added);
+            RecordLoadTiming(pimpl_.get(), job.timing);
             out_error_message = "Init exception: " + std::string(e.what());
-            if (bus) bus->FireGlobal<event::PluginLoadFailureEvent>(path_str, out_error_message);
-            PlatformUnloadLibrary(handle);
-            return false;
-        } catch (...) {
-            {
-                std::unique_lock lock(pimpl_->registry_mutex_);
-                pimpl_->current_loading_plugin_path_ = "";
-                pimpl_->current_added_components_ = nullptr;
-            }
-            RollbackRegistrations(added);
-            out_error_message = "Init unknown exception";
-            if (bus) bus->FireGlobal<event::PluginLoadFailureEvent>(path_str, out_error_message);
-            PlatformUnloadLibrary(handle);
             return false;
         }
     }
 
+    void PluginManager::LoadDeferredPlugin(const ClassId& clsid) {
+        std::string path;
+        {
+            std::shared_lock lock(pimpl_->registry_mutex_);
+            const auto* record = pimpl_->FindComponent(clsid);
+            if (!record || !record->info.deferred) return;
+            path = record->info.source_plugin_path;
+        }
+        std::lock_guard<std::mutex> load_lock(pimpl_->deferred_load_mutex_);
+        PluginLoadJob job;
+        std::string init_func_name;
+        {
+            std::unique_lock lock(pimpl_->registry_mutex_);
+            auto it = pimpl_->deferred_plugins_.find(path);
+            if (it == pimpl_->deferred_plugins_.end()) return;  // 已被其他线程加载，或之前加载失败
+            job.file_path = it->second.file_path;
+            init_func_name = it->second.init_func_name;
+            pimpl_->deferred_plugins_.erase(it);  // 只尝试一次
+        }
+        job.path_str = path;
+        PreparePluginLoad(job, init_func_name);
+        std::string error;
+        (void)CommitPluginLoad(job, error);  // 失败已通过 PluginLoadFailureEvent 报告，条目保持延迟状态
+    }
+
+    void PluginManager::SetPluginManifestCache(const std::filesystem::path& cache_file) {
+        std::unique_lock lock(pimpl_->registry_mutex_);
+        pimpl_->manifest_cache_path_ = cache_file;
+    }
+
+    void PluginManager::SetCheckpointDirectory(const std::filesystem::path& dir) {
+        std::unique_lock lock(pimpl_->registry_mutex_);
+        pimpl_->checkpoint_dir_ = dir;
+    }
+
+    bool PluginManager::StartPluginDirectoryWatch(const std::filesystem::path& dir, const std::string& init_func_name) {
+        std::lock_guard<std::mutex> lock(pimpl_->dir_watch_mutex_);
+        if (pimpl_->dir_watch_thread_.joinable()) return false;
+        if (!PlatformOpenDirectoryWatch(dir)) return false;
+        auto stopped = std::make_shared<std::atomic<bool>>(false);
+        pimpl_->dir_watch_stopped_ = stopped;
+        pimpl_->dir_watch_thread_ = std::thread([this, init_func_name, stopped]() {
+            if (const ThreadPlacement* placement = FindThreadPlacement(thread_role::kDirectoryWatch)) {
+                (void)ApplyThreadPlacement(*placement);
+            }
+            BindCurrentThread(pimpl_->InternalThreadBinding());
+            std::vector<std::filesystem::path> changed;
+            // 等待期间 *this 一定存活：析构会先唤醒并 join 本线程
+            while (PlatformWaitDirectoryChanges(changed)) {
+                auto self = weak_from_this().lock();  // 加载期间保活
+                if (!self) return;
+                // 一次写入可能产生多条通知：同一文件只处理一次
+                std::sort(changed.begin(), changed.end());
+                changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+                for (const auto& file : changed) {
+                    if (!IsPluginFile(file)) continue;
+                    std::string err;  // 结果已通过 PluginLoadSuccessEvent / PluginLoadFailureEvent 报告
+                    (void)LoadPluginInternal(file, init_func_name, err);
+                }
+                changed.clear();
+                self.reset();  // 可能是最后一个引用：此后只能访问自己持有的 stopped
+                if (stopped->load(std::memory_order_acquire)) return;
+            }
+            });
+        return true;
+    }
+
+    void PluginManager::StopPluginDirectoryWatch() {
+        std::lock_guard<std::mutex> lock(pimpl_->dir_watch_mutex_);
+        if (!pimpl_->dir_watch_thread_.joinable()) return;
+        pimpl_->dir_watch_stopped_->store(true, std::memory_order_release);
+        PlatformWakeDirectoryWatch();
+        // 监视线程可能恰好持有最后一个引用 (析构发生在它自己身上)：此时不能 join 自身
+        if (pimpl_->dir_watch_thread_.get_id() == std::this_thread::get_id()) pimpl_->dir_watch_thread_.detach();
+        else pimpl_->dir_watch_thread_.join();
+        pimpl_->dir_watch_.reset();
+    }
+
     bool PluginManager::IsPluginFile(const std::filesystem::path& path) const {
         return std::filesystem::is_regular_file(path) && path.extension() == z3y::utils::GetSharedLibraryExtension();
     }
 
-    std::vector<std::string> PluginManager::LoadPluginsFromDirectory(const std::filesystem::path& dir, bool recursive, const std::string& init_func_name) {
+    std::vector<std::string> PluginManager::LoadPluginsFromDirectory(const std::filesystem::path& dir, bool recursive, const std::string& init_func_name, size_t threads) {
         std::vector<std::string> failures;
         if (!std::filesystem::exists(dir) || !std::filesystem::is_directory(dir)) {
             failures.push_back("Invalid dir: " + z3y::utils::PathToUtf8(dir));
             return failures;
         }
-        auto try_load = [&](const std::filesystem::path& p) {
-            if (IsPluginFile(p)) {
-                std::string err;
-                if (!LoadPluginInternal(p, init_func_name, err)) failures.push_back(z3y::utils::PathToUtf8(p) + ": " + err);
-            }
+        std::vector<PluginLoadJob> jobs;
+        auto collect = [&](const std::filesystem::path& p) {
+            if (!IsPluginFile(p)) return;
+            jobs.emplace_back();
+            jobs.back().file_path = p;
+            jobs.back().path_str = z3y::utils::PathToUtf8(p);
             };
         if (recursive) {
-            for (const auto& e : std::filesystem::recursive_directory_iterator(dir)) try_load(e.path());
+            for (const auto& e : std::filesystem::recursive_directory_iterator(dir)) collect(e.path());
         } else {
-            for (const auto& e : std::filesystem::directory_iterator(dir)) try_load(e.path());
+            for (const auto& e : std::filesystem::directory_iterator(dir)) collect(e.path());
         }
-        return failures;
+        // 按路径排序：提交顺序 (以及默认实现冲突时谁胜出) 与遍历顺序和线程数无关
+        std::sort(jobs.begin(), jobs.end(), [](const PluginLoadJob& a, const PluginLoadJob& b) {
+            return a.path_str < b.path_str;
+            });
+
+        // 清单缓存：大小与修改时间都未变化的插件只注册延迟条目
+        std::filesystem::path cache_path;
+        {
+            std::shared_lock lock(pimpl_->registry_mutex_);
+            cache_path = pimpl_->manifest_cache_path_;
+        }
+        // 每个文件只 stat 一次：同时得到清单校验键 (大小、修改时间) 与已加载判断用的文件身份
+        PluginManifestCache manifest;
+        if (!cache_path.empty()) manifest.Load(cache_path);
+        for (auto& job : jobs) {
+            job.has_file_info = QueryPluginFileInfo(job.file_path, job.file_info);
+            if (job.has_file_info && !cache_path.empty()) {
+                job.manifest = manifest.Find(job.path_str, job.file_info.size, job.file_info.mtime);
+            }
+        }
+        bool manifest_dirty = false;
+
+        if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+        threads = std::min(threads, std::max<size_t>(jobs.size(), 1));
+        auto prepare = [&](PluginLoadJob& job) {
+            if (!job.manifest) PreparePluginLoad(job, init_func_name);
+            };
+        auto commit = [&](PluginLoadJob& job) {
+            std::string err;
+            if (job.manifest) {
+                if (!CommitDeferredPlugin(job, init_func_name, err)) failures.push_back(job.path_str + ": " + err);
+                return;
+            }
+            // 发布之前记下清单 (提交会移走注册信息)
+            PluginManifestEntry entry{ job.file_info.size, job.file_info.mtime, {} };
+            const bool record = !cache_path.empty() && !job.already_loaded && job.error.empty() && job.has_file_info;
+            if (record) {
+                for (const auto& reg : job.registrations) {
+                    entry.components.push_back({ reg.clsid, reg.alias, reg.is_singleton, reg.is_default,
+                        std::vector<InterfaceDetails>(reg.implemented_interfaces.begin(), reg.implemented_interfaces.end()) });
+                }
+            }
+            if (!CommitPluginLoad(job, err)) {
+                failures.push_back(job.path_str + ": " + err);
+            } else if (record) {
+                manifest.Put(job.path_str, std::move(entry));
+                manifest_dirty = true;
+            }
+            };
+        auto finish = [&]() {
+            if (manifest_dirty) (void)manifest.Save(cache_path);
+            return failures;
+            };
+        if (threads <= 1) {
+            for (size_t i = 0; i < jobs.size(); ++i) {
+                prepare(jobs[i]);
+                commit(jobs[i]);
+            }
+            return finish();
+        }
+
+        // 并行准备：加载库、解析入口、执行入口函数 (注册写入各自的 job)
+        std::atomic<size_t> next{ 0 };
+        auto work = [&]() {
+            for (size_t i = next.fetch_add(1, std::memory_order_relaxed); i < jobs.size();
+                i = next.fetch_add(1, std::memory_order_relaxed)) {
+                prepare(jobs[i]);
+            }
+            };
+        std::vector<std::thread> pool;
+        for (size_t t = 1; t < threads; ++t) pool.emplace_back(work);
+        work();
+        for (auto& t : pool) t.join();
+
+        // 串行提交：每个插件在一次写锁内整体发布
+        for (auto& job : jobs) commit(job);
+        return finish();
     }
 
     bool PluginManager::LoadPlugin(const std::filesystem::path& file_path, std::string& out_error_message, const std::string& init_func_name) {
@@ -412,15 +1436,19 @@ namespace z3y {
 
     void PluginManager::UnloadAllPlugins() {
         ClearAllRegistries();
-        auto factory = []() -> PluginPtr<IComponent> {
-            if (auto m = PluginManager::GetActiveInstance()) {
+        auto factory = [owner = pimpl_->owner_]() -> PluginPtr<IComponent> {
+            if (auto m = owner.lock()) {
                 InstanceError err; return PluginCast<IComponent>(m, err);
             }
             return nullptr;
             };
-        auto iids = PluginManager::GetInterfaceDetails();
+        const auto iids = PluginManager::GetInterfaceDescriptors();
         RegisterComponent(clsid::kEventBus, factory, true, "z3y.core.eventbus", iids, true);
         RegisterComponent(clsid::kPluginQuery, factory, true, "z3y.core.pluginquery", iids, false);
+        RegisterComponent(clsid::kExecutor, factory, true, "z3y.core.executor", iids, false);
+        RegisterComponent(clsid::kBufferPool, factory, true, "z3y.core.bufferpool", iids, false);
+        RegisterComponent(clsid::kTimerService, factory, true, "z3y.core.timer", iids, false);
+        RegisterComponent(clsid::kAllocator, factory, true, "z3y.core.allocator", iids, false);
         RegisterComponent(PluginManager::kClsid, factory, true, "z3y.core.manager", iids, false);
         try {
             auto bus = GetService<IEventBus>(clsid::kEventBus);
@@ -428,22 +1456,165 @@ namespace z3y {
         } catch (...) {}
     }
 
+    bool PluginManager::UnloadPlugin(const std::filesystem::path& file_path, std::string& out_error_message) {
+        if (PluginManagerPimpl::IsDispatchThread()) {
+            out_error_message = "UnloadPlugin cannot be called from an event dispatch thread";
+            return false;
+        }
+        const std::string path_str = z3y::utils::PathToUtf8(file_path);
+        // 0. 先让所有 ServiceHandle 缓存失效，再逆序 Shutdown 本插件已构造的单例
+        BumpServiceGeneration();
+        std::vector<PluginPtr<IComponent>> shutdown_list;
+        std::shared_ptr<AllocationAccount> account;
+        std::vector<CheckpointItem> checkpoints;
+        std::filesystem::path checkpoint_dir;
+        {
+            std::shared_lock lock(pimpl_->registry_mutex_);
+            checkpoint_dir = pimpl_->checkpoint_dir_;
+            if (!pimpl_->loaded_lib_paths_.count(path_str) && pimpl_->deferred_plugins_.count(path_str) == 0) {
+                out_error_message = "Plugin not loaded: " + path_str;
+                return false;
+            }
+            auto index_it = pimpl_->plugin_path_index_.find(path_str);
+            if (index_it != pimpl_->plugin_path_index_.end()) {
+                for (auto it = index_it->second.rbegin(); it != index_it->second.rend(); ++it) {
+                    auto* record = pimpl_->FindComponent(*it);
+                    if (record && record->singleton.instance) shutdown_list.push_back(record->singleton.instance);
+                    if (record && !checkpoint_dir.empty()) CollectCheckpointItem(checkpoints, *it, *record);
+                }
+            }
+            if (auto account_it = pimpl_->plugin_accounts_.find(path_str); account_it != pimpl_->plugin_accounts_.end()) {
+                account = account_it->second;
+            }
+        }
+        SaveCheckpoints(pimpl_.get(), checkpoint_dir, checkpoints);
+        checkpoints.clear();
+        for (const auto& instance : shutdown_list) {
+            const CpuChargeScope charge = CpuChargeScope::Lifecycle(account.get());
+            try { instance->Shutdown(); } catch (const std::exception& e) { ReportException(pimpl_.get(), e); } catch (...) { ReportUnknownException(pimpl_.get()); }
+        }
+
+        // 1. 只移除这些单例的订阅；等正在进行的 Fire 离开旧列表，再排空已入队、可能指向插件代码的任务
+        for (const auto& instance : shutdown_list) Unsubscribe(instance);
+        // 被撕票的订阅只有 GC 才会物理移除，而回调的析构代码在插件中：在本线程把待回收项处理完
+        while (pimpl_->HasPendingGC()) PerformGCPass();
+        pimpl_->rcu_.Synchronize();
+        DrainEventWorkers();
+
+        // 2. 在一次写锁内摘下本插件的全部条目 (条目在锁外、卸载库之前析构)
+        std::vector<std::unique_ptr<PluginManagerPimpl::ComponentRecord>> removed;
+        std::vector<ClassId> removed_ids;
+        LibHandle handle = nullptr;
+        PluginPtr<IEventBus> bus;
+        {
+            std::unique_lock lock(pimpl_->registry_mutex_);
+            auto index_it = pimpl_->plugin_path_index_.find(path_str);
+            if (index_it != pimpl_->plugin_path_index_.end()) {
+                removed_ids = std::move(index_it->second);
+                pimpl_->plugin_path_index_.erase(index_it);
+            }
+            pimpl_->plugin_accounts_.erase(path_str);
+            for (ClassId clsid : removed_ids) {
+                auto* slot = pimpl_->components_.Find(clsid);
+                if (!slot) continue;
+                const auto& info = (*slot)->info;
+                if (!info.alias.empty()) pimpl_->alias_map_.Erase(info.alias, ConstexprHash(info.alias));
+                for (const auto& iface : info.implemented_interfaces) {
+                    if (auto* def = pimpl_->default_map_.Find(iface.iid); def && *def == clsid) pimpl_->default_map_.Erase(iface.iid);
+                    if (auto* ids = pimpl_->interface_index_.Find(iface.iid)) {
+                        ids->erase(std::remove(ids->begin(), ids->end(), clsid), ids->end());
+                        if (ids->empty()) pimpl_->interface_index_.Erase(iface.iid);
+                    }
+                }
+                removed.push_back(std::move(*slot));
+                pimpl_->components_.Erase(clsid);
+            }
+            handle = pimpl_->RemoveLoadedLibrary(path_str);
+            pimpl_->deferred_plugins_.erase(path_str);
+            pimpl_->registry_version_.fetch_add(1, std::memory_order_release);
+            if (pimpl_->running_) { InstanceError err; bus = PluginCast<IEventBus>(shared_from_this(), err); }
+        }
+        BumpServiceGeneration();
+        shutdown_list.clear();
+        removed.clear();  // 单例实例与工厂的代码都在插件中：必须先于卸载库释放
+        // 只丢弃类型来自本插件的保留值 (其余插件的状态保持不变)；本插件的单例已销毁，它作为发送者的条目随之移除
+        if (handle) {
+            pimpl_->ClearRetainedEventsFrom([this, handle](const void* type) { return PlatformAddressInLibrary(handle, type); });
+        }
+        // 析构中断开的 Connection / ScopedConnection 刚刚才撕票：卸载库之前再回收一轮
+        while (pimpl_->HasPendingGC()) PerformGCPass();
+        pimpl_->rcu_.Synchronize();
+        DrainEventWorkers();
+        if (handle) PlatformUnloadLibrary(handle);
+
+        if (bus) bus->FireGlobal<event::PluginUnloadEvent>(path_str, std::move(removed_ids));
+        return true;
+    }
+
+    bool PluginManager::ReloadPlugin(const std::filesystem::path& file_path, std::string& out_error_message, const std::string& init_func_name) {
+        if (!UnloadPlugin(file_path, out_error_message)) return false;
+        return LoadPlugin(file_path, out_error_message, init_func_name);
+    }
+
     // ... (GetAllComponents 等查询接口实现保持不变，此处为完整性应包含) ...
+    /**
+     * @details 双重检查：快照版本与注册表版本一致时直接返回。注册表版本只在写锁内递增，
+     * 因此在读锁内读到的版本与此时的注册表内容一一对应。
+     */
+    std::shared_ptr<const RegistrySnapshot> PluginManager::GetRegistrySnapshot() const {
+        const PluginManagerPimpl* impl = GetImpl();
+        auto current = std::atomic_load_explicit(&impl->registry_snapshot_, std::memory_order_acquire);
+        if (current && current->version == impl->registry_version_.load(std::memory_order_acquire)) return current;
+
+        std::lock_guard build_lock(impl->snapshot_build_mutex_);
+        current = std::atomic_load_explicit(&impl->registry_snapshot_, std::memory_order_acquire);
+        if (current && current->version == impl->registry_version_.load(std::memory_order_acquire)) return current;
+
+        auto next = std::make_shared<RegistrySnapshot>();
+        {
+            std::shared_lock lock(impl->registry_mutex_);
+            next->version = impl->registry_version_.load(std::memory_order_relaxed);
+            next->components.reserve(impl->components_.size());
+            next->by_clsid.reserve(impl->components_.size());
+            impl->components_.ForEach([&next](ClassId clsid, const auto& record) {
+                next->components.push_back(record->details);
+                next->by_clsid.emplace(clsid, record->details);
+                });
+            // 索引按注册顺序取自 interface_index_ / plugin_path_index_
+            auto resolve = [&next](const std::vector<ClassId>& ids) {
+                std::vector<RegistrySnapshot::ComponentPtr> out;
+                out.reserve(ids.size());
+                for (ClassId id : ids) {
+                    auto it = next->by_clsid.find(id);
+                    if (it != next->by_clsid.end()) out.push_back(it->second);
+                }
+                return out;
+                };
+            impl->interface_index_.ForEach([&](InterfaceId iid, const std::vector<ClassId>& ids) {
+                next->by_interface.emplace(iid, resolve(ids));
+                });
+            for (const auto& entry : impl->plugin_path_index_) {
+                next->by_plugin.emplace(entry.first, resolve(entry.second));
+            }
+        }
+        std::shared_ptr<const RegistrySnapshot> published = std::move(next);
+        std::atomic_store_explicit(&impl->registry_snapshot_, published, std::memory_order_release);
+        return published;
+    }
+
     std::vector<ComponentDetails> PluginManager::GetAllComponents() const {
-        std::shared_lock lock(GetImpl()->registry_mutex_);
+        auto snapshot = GetRegistrySnapshot();
         std::vector<ComponentDetails> ret;
-        ret.reserve(GetImpl()->components_.size());
-        for (const auto& kv : GetImpl()->components_) {
-            ret.push_back({ kv.first, kv.second.alias, kv.second.is_singleton, kv.second.source_plugin_path, kv.second.is_default_registration, kv.second.implemented_interfaces });
-        }
+        ret.reserve(snapshot->components.size());
+        for (const auto& details : snapshot->components) ret.push_back(*details);
         return ret;
     }
 
     bool PluginManager::GetComponentDetails(ClassId clsid, ComponentDetails& out) const {
         std::shared_lock lock(GetImpl()->registry_mutex_);
-        auto it = GetImpl()->components_.find(clsid);
-        if (it == GetImpl()->components_.end()) return false;
-        out = { it->first, it->second.alias, it->second.is_singleton, it->second.source_plugin_path, it->second.is_default_registration, it->second.implemented_interfaces };
+        const auto* record = GetImpl()->FindComponent(clsid);
+        if (!record) return false;
+        out = *record->details;
         return true;
     }
 
@@ -454,17 +1625,9 @@ namespace z3y {
     }
 
     std::vector<ComponentDetails> PluginManager::FindComponentsImplementing(InterfaceId iid) const {
-        std::shared_lock lock(GetImpl()->registry_mutex_);
+        auto snapshot = GetRegistrySnapshot();
         std::vector<ComponentDetails> ret;
-        auto it = GetImpl()->interface_index_.find(iid);
-        if (it != GetImpl()->interface_index_.end()) {
-            for (auto id : it->second) {
-                auto cit = GetImpl()->components_.find(id);
-                if (cit != GetImpl()->components_.end()) {
-                    ret.push_back({ cit->first, cit->second.alias, cit->second.is_singleton, cit->second.source_plugin_path, cit->second.is_default_registration, cit->second.implemented_interfaces });
-                }
-            }
-        }
+        for (const auto& details : snapshot->FindImplementing(iid)) ret.push_back(*details);
         return ret;
     }
 
@@ -476,17 +1639,77 @@ namespace z3y {
     }
 
     std::vector<ComponentDetails> PluginManager::GetComponentsFromPlugin(const std::string& path) const {
-        std::shared_lock lock(GetImpl()->registry_mutex_);
+        auto snapshot = GetRegistrySnapshot();
         std::vector<ComponentDetails> ret;
-        auto it = GetImpl()->plugin_path_index_.find(path);
-        if (it != GetImpl()->plugin_path_index_.end()) {
-            for (auto id : it->second) {
-                auto cit = GetImpl()->components_.find(id);
-                if (cit != GetImpl()->components_.end()) {
-                    ret.push_back({ cit->first, cit->second.alias, cit->second.is_singleton, cit->second.source_plugin_path, cit->second.is_default_registration, cit->second.implemented_interfaces });
-                }
+        auto it = snapshot->by_plugin.find(path);
+        if (it != snapshot->by_plugin.end()) {
+            for (const auto& details : it->second) ret.push_back(*details);
+        }
+        return ret;
+    }
+
+    StartupReport PluginManager::GetStartupReport() const {
+        StartupReport report;
+        {
+            std::lock_guard<std::mutex> lock(pimpl_->startup_mutex_);
+            report.plugins = pimpl_->load_timings_;
+        }
+        {
+            std::shared_lock lock(pimpl_->registry_mutex_);
+            pimpl_->components_.ForEach([&report](ClassId clsid, const auto& record) {
+                const auto& holder = record->singleton;
+                if (!record->info.is_singleton || !holder.initialized.load(std::memory_order_acquire)) return;
+                report.services.push_back({ clsid, record->info.alias, holder.init_start_ns, holder.init_ns,
+                    holder.init_thread, holder.error == InstanceError::kSuccess });
+                });
+        }
+        std::sort(report.services.begin(), report.services.end(), [](const ServiceInitTiming& a, const ServiceInitTiming& b) {
+            return a.start_ns < b.start_ns;
+            });
+        return report;
+    }
+
+    std::vector<PluginMemoryUsage> PluginManager::GetPluginMemoryUsage() const {
+        std::vector<PluginMemoryUsage> ret;
+        if (!pimpl_->memory_accounting_) return ret;  // 只启用 CPU 记账时账户同样存在
+        {
+            std::shared_lock lock(pimpl_->registry_mutex_);
+            ret.reserve(pimpl_->plugin_accounts_.size());
+            for (const auto& entry : pimpl_->plugin_accounts_) {
+                const AllocationAccount& account = *entry.second;
+                ret.push_back({ entry.first,
+                    account.component_bytes.load(std::memory_order_relaxed),
+                    account.component_count.load(std::memory_order_relaxed),
+                    account.subscription_bytes.load(std::memory_order_relaxed),
+                    account.subscription_count.load(std::memory_order_relaxed),
+                    account.pool_bytes.load(std::memory_order_relaxed),
+                    account.pool_allocations.load(std::memory_order_relaxed) });
             }
         }
+        std::sort(ret.begin(), ret.end(), [](const PluginMemoryUsage& a, const PluginMemoryUsage& b) {
+            return a.plugin_path < b.plugin_path;
+            });
+        return ret;
+    }
+
+    std::vector<PluginCpuUsage> PluginManager::GetPluginCpuUsage() const {
+        std::vector<PluginCpuUsage> ret;
+        if (!pimpl_->cpu_accounting_) return ret;
+        {
+            std::shared_lock lock(pimpl_->registry_mutex_);
+            ret.reserve(pimpl_->plugin_accounts_.size());
+            for (const auto& entry : pimpl_->plugin_accounts_) {
+                const AllocationAccount& account = *entry.second;
+                ret.push_back({ entry.first,
+                    account.callback_cpu_ns.load(std::memory_order_relaxed),
+                    account.callback_calls.load(std::memory_order_relaxed),
+                    account.lifecycle_cpu_ns.load(std::memory_order_relaxed),
+                    account.lifecycle_calls.load(std::memory_order_relaxed) });
+            }
+        }
+        std::sort(ret.begin(), ret.end(), [](const PluginCpuUsage& a, const PluginCpuUsage& b) {
+            return a.plugin_path < b.plugin_path;
+            });
         return ret;
     }
 
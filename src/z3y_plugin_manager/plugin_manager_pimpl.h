@@ -31,21 +31,39 @@
 
 #include <algorithm>
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <cstdint>
+#include <deque>
 #include <exception>
 #include <filesystem>
+#include <functional>
 #include <map>
 #include <mutex>
 #include <optional>
 #include <queue>
 #include <set>
 #include <shared_mutex> 
+#include <thread>
+#include <typeinfo>
 #include <unordered_map>
 #include <unordered_set> 
 #include <utility>
 #include <vector>
 
 #include "framework/plugin_manager.h"
+#include "framework/profiled_mutex.h"
+#include "event_metrics.h"
+#include "event_trace_recorder.h"
+#include "lock_free_queue.h"
+#include "rcu_domain.h"
+#include "flat_id_map.h"
+#include "plugin_manifest.h"
+#include "task_executor.h"
+#include "allocator_service.h"
+#include "connection_slot.h"
+#include "buffer_pool.h"
+#include "timer_wheel.h"
 
 #ifdef _WIN32
 #include <Windows.h>
@@ -55,10 +73,99 @@
 
 namespace z3y {
 
+    /**
+     * @brief [进程级] 为 EventId 分配 (或查找) 稠密槽号。
+     * @details 槽号在整个进程生命周期内稳定，跨 PluginManager 实例有效，
+     * 因此 `IEventBus` 可以把它缓存在每个事件类型的函数局部静态变量中。
+     * @throw std::length_error 事件类型数量超过 `PluginManagerPimpl::kMaxEventSlots`。
+     */
+    EventSlotIndex ResolveEventSlotIndex(EventId event_id);
+
+    /** @brief [进程级] 只查找不分配。未分配过返回 false。 */
+    bool FindEventSlotIndex(EventId event_id, EventSlotIndex& out_slot);
+
+    /**
+     * @brief 按组件的声明式处理函数表为新实例订阅 (实现见 event_bus_impl.cpp)。
+     * @details 在一次订阅表写锁内完成：同一 EventId 的多个条目只复制、发布一次订阅列表。
+     * 调用方应处于实例所属插件的记账作用域内，订阅才会记入该插件。
+     */
+    void SubscribeEventHandlers(PluginManagerPimpl* pimpl, const PluginPtr<IComponent>& instance,
+        const std::vector<EventHandlerEntry>& handlers);
+
+    /**
+     * @brief [进程级] 事件族前缀的 ID。
+     * @details 与 EventId 处于不同的哈希空间 (带固定前缀)，不会与事件 UUID 冲突。
+     * 末尾的 `/` 会被忽略；空前缀返回 0。
+     */
+    EventId EventFamilyIdOf(const char* family);
+
+    /**
+     * @brief [进程级] 登记事件所属的事件族 (连同它的每一级前缀)。
+     * @return 本次是否为新登记 (之前未登记过该事件的事件族)。
+     */
+    bool RegisterEventFamily(EventId event_id, const char* family);
+
+    /** @brief [进程级] 事件所属的全部事件族 ID (每一级前缀各一个)。未登记时为空。 */
+    std::vector<EventId> EventFamiliesOf(EventId event_id);
+
+    /** @brief [进程级] 已登记到事件族 (含其子族) 的全部事件。 */
+    std::vector<EventId> EventFamilyMembers(EventId family_id);
+
+    /** @brief 线程绑定的框架实例 (`PluginManagerScope` 或独立实例的内部线程)。 */
+    struct ThreadBinding {
+        std::weak_ptr<PluginManager> manager;
+        bool bound = false;
+        uint64_t id = 0;  //!< 实例的线程绑定编号 (见 PluginManager::GetThreadBindingId)
+    };
+
+    /** @brief 读取当前线程的绑定 (框架自己的临时线程据此继承调用方的实例)。 */
+    ThreadBinding CaptureThreadBinding() noexcept;
+
+    /** @brief 在线程的剩余生命周期内绑定到 binding (未绑定时无操作)。只应在线程入口调用。 */
+    void BindCurrentThread(const ThreadBinding& binding);
+
+    /**
+     * @struct PendingRegistration
+     * @brief 一次尚未发布的组件注册 (即 `RegisterComponent` 的参数)。
+     */
+    struct PendingRegistration {
+        ClassId clsid;
+        FactoryFunction factory;
+        bool is_singleton;
+        std::string alias;
+        InterfaceList implemented_interfaces;
+        bool is_default;
+        bool factory_initializes;
+        bool deferred = false;  //!< 来自清单缓存的延迟条目 (没有工厂)
+        std::vector<EventHandlerEntry> event_handlers;  //!< 声明式事件处理函数 (按 event_id 排序)
+    };
+
+    /**
+     * @struct PluginLoadJob
+     * @brief 单个插件的加载上下文。
+     * @details 准备阶段由任意线程填写 (线程之间不共享)，提交阶段由调用线程串行读取。
+     * 入口函数执行期间，本线程的 `RegisterComponent` 调用只追加到 `registrations`。
+     */
+    struct PluginLoadJob {
+        std::filesystem::path file_path;
+        std::string path_str;
+        PluginManager::LibHandle handle = nullptr;
+        bool already_loaded = false;                    //!< 该路径此前已加载 (幂等成功)
+        std::vector<PendingRegistration> registrations; //!< 入口函数注册的组件 (尚未发布)
+        std::string error;                              //!< 准备阶段的错误；非空表示失败
+        const PluginManifestEntry* manifest = nullptr;  //!< 命中清单缓存时非空：只注册延迟条目，不加载库
+        PluginFileInfo file_info;                       //!< 文件身份与版本 (只 stat 一次)
+        bool has_file_info = false;                     //!< file_info 是否已填写 (stat 失败时为 false)
+        PluginLoadTiming timing;                        //!< 各阶段耗时 (启动报告)
+    };
+
     /**
      * @struct PluginManagerPimpl
      * @brief PluginManager 的“肚子”。存放所有实际的数据。
      */
+    /** @brief [平台实现] 目录监视句柄 (inotify / ReadDirectoryChangesW)。定义在 platform_*.cpp 中。 */
+    struct PlatformDirectoryWatch;
+
     struct PluginManagerPimpl {
     public:
         // --- 内部类型定义 ---
@@ -72,8 +179,14 @@ namespace z3y {
             bool is_singleton;                  //!< true=单例服务, false=瞬态组件
             std::string alias;                  //!< 别名 (如 "Demo.Logger")
             std::string source_plugin_path;     //!< 来源 DLL 的路径
-            std::vector<InterfaceDetails> implemented_interfaces; //!< 实现了哪些接口
+            InterfaceList implemented_interfaces; //!< 实现了哪些接口
             bool is_default_registration;       //!< 是否是默认实现
+            bool factory_initializes = false;   //!< 工厂返回已初始化的对象 (池化组件)，跳过 Initialize()
+            FactoryFunctionPtr factory_ptr = nullptr; //!< factory 包装的是无状态函数指针时的快捷方式
+            bool deferred = false;              //!< 清单缓存生成的延迟条目：库尚未加载，factory 为空
+            std::shared_ptr<AllocationAccount> account; //!< 来源插件的内存账户 (未启用记账时为空)
+            /** @brief 声明式事件处理函数表 (按 event_id 排序)。没有时为空，创建实例时只多一次判空。 */
+            std::shared_ptr<const std::vector<EventHandlerEntry>> event_handlers;
         };
 
         /**
@@ -82,9 +195,50 @@ namespace z3y {
          */
         struct SingletonHolder {
             std::once_flag flag;                //!< 保证初始化只执行一次 (std::call_once)
-            FactoryFunction factory;            //!< 构造函数
             PluginPtr<IComponent> instance;     //!< 缓存的单例指针
             std::exception_ptr e_ptr;           //!< 如果构造失败，捕获异常以便再次抛出
+            InstanceError error = InstanceError::kSuccess; //!< 构造失败时的错误码 (供非抛出路径使用)
+            uint64_t init_ns = 0;               //!< 工厂 + Initialize 的耗时
+            std::vector<ClassId> dependencies;  //!< Initialize 期间获取的其他单例 (由初始化线程写入)
+            uint64_t init_start_ns = 0;         //!< 开始构造的时间点 (启动报告用)
+            uint32_t init_thread = 0;           //!< 执行构造的线程编号
+            std::atomic<bool> initialized{ false }; //!< call_once 已完成 (release)，之后上述字段只读
+        };
+
+        /**
+         * @brief 注册表条目：组件信息与单例持有者放在同一块内存中，一次查找即可拿到两者。
+         * @details 通过 unique_ptr 存放在 FlatIdMap 中：地址在表扩容时保持不变
+         * (`GetServiceImpl` 在释放注册表锁之后仍使用 holder 上的 once_flag)。
+         * 成员按声明逆序析构：单例实例先于工厂释放。
+         */
+        struct ComponentRecord {
+            ComponentInfo info;
+            std::shared_ptr<const ComponentDetails> details; //!< 注册时生成一次，供注册表快照共享
+            SingletonHolder singleton;          //!< 仅当 info.is_singleton 时使用
+        };
+
+        /**
+         * @brief kQueuedCoalesced 订阅的“信箱”：最多保存一个待投递的事件。
+         * @details `pending` 非空即表示已有一个派发任务在队列中、尚未取走负载。
+         * 所有列表副本 (COW) 共享同一个信箱。
+         */
+        struct CoalesceMailbox {
+            std::mutex mutex;
+            PluginPtr<Event> pending;
+
+            /** @brief 放入最新事件。@return 需要新排一个派发任务时返回 true。 */
+            bool Post(const PluginPtr<Event>& e) {
+                std::lock_guard<std::mutex> lock(mutex);
+                bool was_empty = !pending;
+                pending = e;
+                return was_empty;
+            }
+
+            /** @brief 取走最新事件 (派发线程调用)。 */
+            PluginPtr<Event> Take() {
+                std::lock_guard<std::mutex> lock(mutex);
+                return std::move(pending);
+            }
         };
 
         /**
@@ -94,41 +248,318 @@ namespace z3y {
         struct Subscription {
             std::weak_ptr<void> subscriber_id;  //!< 订阅者 ID (弱引用，防止循环引用)
             std::weak_ptr<void> sender_id;      //!< 关注的发送者 (可选)
-            std::function<void(const Event&)> callback; //!< 回调闭包
+            EventDelegate callback;             //!< 回调 (以订阅者裸指针调用，调用前须固定订阅者)
             ConnectionType connection_type;     //!< 同步还是异步
-            std::shared_ptr<std::atomic<bool>> active_token; //!< 原子票据 (核心机制)
+            ConnectionTicket ticket;            //!< 票据槽引用 (原子票据，核心机制)
+            std::uintptr_t shard_key;           //!< 订阅者身份 (对象地址)，决定 kQueued 回调落在哪个派发线程
+            std::shared_ptr<CoalesceMailbox> mailbox; //!< 仅 kQueuedCoalesced 订阅使用
+            EventPriority priority;             //!< 异步回调进入哪条优先级通道
+            std::shared_ptr<SubscriptionStats> stats; //!< 回调统计 (列表的各个副本共享同一份)
+            std::shared_ptr<IEventExecutor> executor; //!< 非空时异步回调投递给它，而不是框架派发线程
+            bool receives_batch;                //!< 回调期望 EventBatchView (SubscribeGlobalBatch)
+            EventFilter filter;                 //!< 非空时在发布线程上、入队之前求值 (SubscribeGlobalFiltered)
 
             Subscription(std::weak_ptr<void> sub, std::weak_ptr<void> snd,
-                std::function<void(const Event&)> cb, ConnectionType type,
-                std::shared_ptr<std::atomic<bool>> token)
+                EventDelegate cb, ConnectionType type,
+                ConnectionTicket token, EventPriority prio,
+                std::shared_ptr<IEventExecutor> exec, EventFilter filt = EventFilter())
                 : subscriber_id(std::move(sub)), sender_id(std::move(snd)),
                 callback(std::move(cb)), connection_type(type),
-                active_token(std::move(token)) {
+                ticket(std::move(token)),
+                shard_key(reinterpret_cast<std::uintptr_t>(subscriber_id.lock().get())),
+                mailbox(type == ConnectionType::kQueuedCoalesced ? std::make_shared<CoalesceMailbox>() : nullptr),
+                priority(prio), stats(std::make_shared<SubscriptionStats>(sizeof(Subscription))), executor(std::move(exec)),
+                receives_batch(callback.ReceivesBatch()), filter(std::move(filt)) {
             }
         };
 
         // 订阅列表。使用 shared_ptr 包装，为了实现 COW (Copy-On-Write)。
         // 当遍历列表发布事件时，如果有人修改列表，我们修改的是新副本，不影响遍历。
-        using SubList = std::vector<Subscription>;
+        // 元素从 `framework_resource_` 分配 (见 NewSubList)；拷贝沿用原列表的资源。
+        using SubList = std::vector<Subscription, ResourceAllocator<Subscription>>;
         using SubListPtr = std::shared_ptr<const SubList>;
 
         // 事件 ID -> 订阅列表
         using EventMap = std::unordered_map<EventId, SubListPtr>;
+
+        /**
+         * @brief 全局事件的读侧发布槽 (每个 EventSlotIndex 一个，地址稳定)。
+         * @details
+         * `published` 指向一个不可变的 SubListPtr 节点，通过 `rcu_` 发布与回收。
+         * Fire 在 RCU 读临界区内直接读取它：不加锁，也不碰 shared_ptr 的引用计数。
+         */
+        struct EventSlot {
+            std::atomic<const SubListPtr*> published{ nullptr };
+            ~EventSlot() { delete published.load(std::memory_order_relaxed); }
+        };
+
+        /**
+         * @brief 类型化通道 (`EventChannel<TEvent>`) 的读侧状态，每条总线每个事件一份，地址稳定。
+         * @details 对外以 `internal::EventChannelCore*` 的不透明指针交给句柄。
+         * 两份列表都由 `PublishGlobal` 在写锁下发布、经 `rcu_` 回收：
+         * `subscribers` 是通道自己的订阅，`bus_subscribers` 是同一事件的其余订阅 (全局 + 事件族)。
+         * 槽表里发布的合并列表额外包含通道订阅，因此 `FireGlobal` 同样投递给它们。
+         */
+        struct ChannelState {
+            explicit ChannelState(EventId id) : event_id(id) {}
+            ~ChannelState() {
+                delete subscribers.load(std::memory_order_relaxed);
+                delete bus_subscribers.load(std::memory_order_relaxed);
+            }
+            const EventId event_id;
+            std::atomic<const SubListPtr*> subscribers{ nullptr };
+            std::atomic<const SubListPtr*> bus_subscribers{ nullptr };
+        };
+
+        // 稠密槽表：两级定长数组 (块按需分配，分配后直到析构都不移动)
+        static constexpr uint32_t kSlotChunkBits = 8;
+        static constexpr uint32_t kSlotChunkSize = 1u << kSlotChunkBits;
+        static constexpr uint32_t kMaxSlotChunks = 256;
+        static constexpr uint32_t kMaxEventSlots = kSlotChunkSize * kMaxSlotChunks;
         using SenderEventMap = std::unordered_map<EventId, SubListPtr>;
-        // 发送者 ID -> (事件 ID -> 订阅列表)
-        // 使用 owner_less 来比较 weak_ptr
-        using SenderMap = std::map<std::weak_ptr<void>, SenderEventMap, std::owner_less<std::weak_ptr<void>>>;
+
+        /**
+         * @brief 特定发送者的订阅记录 (写侧权威数据)。
+         * @details 以发送者对象地址为哈希键。地址可能在发送者销毁后被新对象复用，
+         * 因此每条记录还保存 `owner`，查找时用 owner 等价性 (同一控制块) 再确认一次。
+         */
+        struct SenderRecord {
+            std::weak_ptr<void> owner;  //!< 发送者身份 (控制块)
+            SenderEventMap events;      //!< 事件 ID -> 订阅列表 (不含空列表)
+        };
+        // 发送者地址 -> 订阅记录
+        using SenderMap = std::unordered_map<std::uintptr_t, SenderRecord>;
+
+        /** @brief [读侧] 不可变的发送者条目，由 SenderBucket 共享持有。 */
+        struct SenderEntry {
+            std::weak_ptr<void> owner;
+            std::uintptr_t key;
+            SenderEventMap events;
+        };
+        using SenderEntryPtr = std::shared_ptr<const SenderEntry>;
+
+        /** @brief [读侧] 不可变的哈希桶。写侧只复制被修改的那一个桶。 */
+        struct SenderBucket {
+            std::vector<SenderEntryPtr> entries;
+        };
+
+        /**
+         * @brief [读侧] 发送者哈希表 (桶数组)。
+         * @details 桶节点通过 `rcu_` 单独替换；扩容时整表重建并整体退役，
+         * 表析构时一并释放它当时持有的桶节点。
+         */
+        struct SenderTable {
+            explicit SenderTable(size_t bucket_count)
+                : mask(bucket_count - 1), buckets(new std::atomic<const SenderBucket*>[bucket_count]) {
+                for (size_t i = 0; i < bucket_count; ++i) buckets[i].store(nullptr, std::memory_order_relaxed);
+            }
+            ~SenderTable() {
+                for (size_t i = 0; i <= mask; ++i) delete buckets[i].load(std::memory_order_relaxed);
+            }
+            size_t mask;
+            std::unique_ptr<std::atomic<const SenderBucket*>[]> buckets;
+        };
+
+        static constexpr size_t kInitialSenderBuckets = 64;
+
+        /** @brief 取发送者的哈希键 (对象地址)。已销毁的发送者返回 0。 */
+        static std::uintptr_t SenderKeyOf(const std::weak_ptr<void>& sender) {
+            return reinterpret_cast<std::uintptr_t>(sender.lock().get());
+        }
+
+        /** @brief 两个 weak_ptr 是否指向同一个控制块 (与 owner_less 的等价关系一致)。 */
+        static bool SameOwner(const std::weak_ptr<void>& lhs, const std::weak_ptr<void>& rhs) {
+            return !lhs.owner_before(rhs) && !rhs.owner_before(lhs);
+        }
+
+        static size_t SenderBucketOf(std::uintptr_t key, size_t mask) {
+            // 对象地址的低位通常是对齐填充，先打散再取模
+            return std::hash<std::uintptr_t>{}(key >> 4) & mask;
+        }
+
+        /**
+         * @brief kDropOldest 策略下可丢弃任务的墓碑。
+         * @details 丢弃时只把状态从 kQueued 改为 kDropped，任务留在原位，派发线程取到后跳过；
+         * 与派发线程取走任务 (kQueued -> kClaimed) 之间由 CAS 决出唯一的赢家。
+         */
+        struct DropTicket {
+            static constexpr uint8_t kQueued = 0;
+            static constexpr uint8_t kClaimed = 1;
+            static constexpr uint8_t kDropped = 2;
+            std::atomic<uint8_t> state{ kQueued };
+            EventId event_id = 0;
+        };
 
         /**
          * @brief 异步任务包。
          */
         struct EventTask {
-            std::function<void()> func; //!< 要在工作线程执行的闭包
+            PooledTask func;            //!< 要在工作线程执行的闭包 (大闭包从 framework_resource_ 分配)
             EventId event_id = 0;       //!< 调试用的事件 ID
+            bool droppable = true;      //!< 是否受积压上限约束 (GC、高优先级事件为 false)
+            EventPriority priority = EventPriority::kNormal; //!< 进入哪条优先级通道
+            uint64_t enqueue_ns = 0;    //!< 入队时刻 (用于入队 -> 执行延迟指标)
+            std::shared_ptr<DropTicket> ticket; //!< 仅 kDropOldest 策略下的可丢弃任务携带
+
+            /** @brief 取走任务准备执行；已被 kDropOldest 丢弃时返回 false。 */
+            bool Claim() {
+                if (!ticket) return true;
+                uint8_t expected = DropTicket::kQueued;
+                return ticket->state.compare_exchange_strong(expected, DropTicket::kClaimed, std::memory_order_acq_rel);
+            }
+        };
+
+        /**
+         * @brief 异步派发线程。
+         * @details
+         * 每个派发线程拥有 *独立* 的无锁队列和 EventCount。
+         * 投递只需一次 CAS；只有当派发线程真的睡着时才会触发系统调用唤醒它。
+         * 每个优先级一条队列：kNormal 使用配置的容量，
+         * kRealtime / kBackground 通常流量很小，环形区按 1/16 分配 (环满时仍会进入溢出区，不会丢失)。
+         */
+        struct DispatchWorker {
+            explicit DispatchWorker(size_t queue_capacity)
+                : lanes{ BoundedTaskQueue<EventTask>(SideLaneCapacity(queue_capacity)),
+                         BoundedTaskQueue<EventTask>(queue_capacity),
+                         BoundedTaskQueue<EventTask>(SideLaneCapacity(queue_capacity)) } {}
+
+            static size_t SideLaneCapacity(size_t queue_capacity) {
+                return std::max<size_t>(queue_capacity / 16, 64);
+            }
+
+            BoundedTaskQueue<EventTask>& Lane(EventPriority priority) {
+                return lanes[static_cast<size_t>(priority)];
+            }
+
+            /** @brief 按优先级从高到低取出一个任务。 */
+            bool TryPop(EventTask& out) {
+                for (auto& lane : lanes) {
+                    if (lane.TryPop(out)) return true;
+                }
+                return false;
+            }
+
+            /** @brief 丢弃所有通道中尚未执行的任务。@return 丢弃数 (不含已计为丢弃的墓碑)。 */
+            size_t Clear() {
+                size_t discarded = 0;
+                EventTask task;
+                for (auto& lane : lanes) {
+                    while (lane.TryPop(task)) {
+                        if (task.Claim()) ++discarded;
+                        task = EventTask();
+                    }
+                    discarded += lane.Clear();
+                }
+                std::lock_guard<std::mutex> lock(drop_mutex);
+                for (auto& order : drop_order) order.clear();
+                return discarded;
+            }
+
+            /**
+             * @brief [kDropOldest] 登记一个可丢弃任务的墓碑 (按入队顺序)。
+             * @details 顺带弹出队首已被取走的墓碑，队列长度不超过积压中的可丢弃任务数 (加上并发入队的少量错位)。
+             */
+            void RegisterDroppable(const EventTask& task) {
+                std::lock_guard<std::mutex> lock(drop_mutex);
+                auto& order = drop_order[static_cast<size_t>(task.priority)];
+                while (!order.empty() && order.front()->state.load(std::memory_order_acquire) != DropTicket::kQueued) {
+                    order.pop_front();
+                }
+                order.push_back(task.ticket);
+            }
+
+            /**
+             * @brief [kDropOldest] 从最低优先级通道开始，把最旧的仍在排队的可丢弃任务标记为已丢弃。
+             * @return 被丢弃任务的事件 ID；没有可丢弃的任务时返回 std::nullopt。
+             * @details 不移动队列中的任何任务 (不可丢弃的任务保持原有顺序)，均摊 O(1)。
+             */
+            std::optional<EventId> DropOldest() {
+                std::lock_guard<std::mutex> lock(drop_mutex);
+                for (size_t lane = kEventPriorityCount; lane-- > 0;) {
+                    auto& order = drop_order[lane];
+                    while (!order.empty()) {
+                        std::shared_ptr<DropTicket> ticket = std::move(order.front());
+                        order.pop_front();
+                        uint8_t expected = DropTicket::kQueued;
+                        if (ticket->state.compare_exchange_strong(expected, DropTicket::kDropped, std::memory_order_acq_rel)) {
+                            return ticket->event_id;
+                        }
+                    }
+                }
+                return std::nullopt;
+            }
+
+            std::thread thread;                 //!< 派发线程
+            BoundedTaskQueue<EventTask> lanes[kEventPriorityCount];  //!< 每个优先级一条私有任务队列 (多生产者，无锁)
+            EventCount wakeup;                  //!< 仅在消费者休眠时才需要的唤醒原语
+            EventCount space;                   //!< kBlock 策略下等待队列腾出空间的发布者
+            std::atomic<size_t> pending{ 0 };   //!< 近似积压数 (已投递、尚未取出)
+            std::atomic<size_t> high_water{ 0 }; //!< pending 曾达到的最大值
+            EventLatencyShard latency;          //!< 本线程的入队延迟直方图 (只有本线程写入)
+            std::atomic<bool> running{ true };  //!< 线程运行标志
+            std::mutex drop_mutex;              //!< [kDropOldest] 保护 drop_order
+            std::deque<std::shared_ptr<DropTicket>> drop_order[kEventPriorityCount]; //!< [kDropOldest] 每条通道可丢弃任务的墓碑，按入队顺序
+        };
+
+        /**
+         * @brief 订阅者反查表 (用于批量 Unsubscribe)：订阅者 -> 它订阅过的键 (事件 ID 或 {发送者, 事件 ID})。
+         * @details
+         * 扁平有序数组：条目按订阅者控制块 (owner_less) 排序、二分查找，每个条目的键也是有序数组。
+         * 比 `map<weak_ptr, set<...>>` 少了每个节点一次分配，遍历一个订阅者的键是连续内存。
+         * 不以对象地址做哈希：订阅与取消订阅可能经由不同的基类指针转换成 `shared_ptr<void>`，
+         * 地址并不相同；而 C++20 的 weak_ptr 没有可移植的控制块哈希。
+         */
+        template <typename Key, typename KeyLess = std::less<Key>>
+        class SubscriberLookup {
+        public:
+            /** @brief 登记订阅者的一个键 (已登记则忽略)。 */
+            void Insert(const std::weak_ptr<void>& subscriber, Key key) {
+                auto it = LowerBound(subscriber);
+                if (it == entries_.end() || !SameOwner(it->subscriber, subscriber)) {
+                    it = entries_.insert(it, Entry{ subscriber, {} });
+                }
+                auto& keys = it->keys;
+                auto key_it = std::lower_bound(keys.begin(), keys.end(), key, KeyLess());
+                if (key_it == keys.end() || KeyLess()(key, *key_it)) keys.insert(key_it, std::move(key));
+            }
+
+            /** @brief 注销订阅者的一个键；订阅者没有剩余的键时移除整个条目。 */
+            void Erase(const std::weak_ptr<void>& subscriber, const Key& key) {
+                auto it = LowerBound(subscriber);
+                if (it == entries_.end() || !SameOwner(it->subscriber, subscriber)) return;
+                auto& keys = it->keys;
+                auto key_it = std::lower_bound(keys.begin(), keys.end(), key, KeyLess());
+                if (key_it == keys.end() || KeyLess()(key, *key_it)) return;
+                keys.erase(key_it);
+                if (keys.empty()) entries_.erase(it);
+            }
+
+            /** @brief 取走订阅者的全部键 (条目随之移除)。 */
+            std::vector<Key> Take(const std::weak_ptr<void>& subscriber) {
+                auto it = LowerBound(subscriber);
+                if (it == entries_.end() || !SameOwner(it->subscriber, subscriber)) return {};
+                std::vector<Key> keys = std::move(it->keys);
+                entries_.erase(it);
+                return keys;
+            }
+
+            void clear() noexcept { entries_.clear(); }
+            [[nodiscard]] size_t size() const noexcept { return entries_.size(); }
+
+        private:
+            struct Entry {
+                std::weak_ptr<void> subscriber;
+                std::vector<Key> keys;  //!< 有序、无重复
+            };
+
+            typename std::vector<Entry>::iterator LowerBound(const std::weak_ptr<void>& subscriber) {
+                return std::lower_bound(entries_.begin(), entries_.end(), subscriber,
+                    [](const Entry& entry, const std::weak_ptr<void>& sub) { return entry.subscriber.owner_before(sub); });
+            }
+
+            std::vector<Entry> entries_;
         };
 
-        // 反向查找表类型定义 (用于快速 Unsubscribe)
-        using SubscriberLookupMapG = std::map<std::weak_ptr<void>, std::set<EventId>, std::owner_less<std::weak_ptr<void>>>;
         using SenderLookupKey = std::pair<std::weak_ptr<void>, EventId>;
         struct SenderLookupKeyLess {
             bool operator()(const SenderLookupKey& lhs, const SenderLookupKey& rhs) const {
@@ -137,59 +568,629 @@ namespace z3y {
                 return lhs.second < rhs.second;
             }
         };
-        using SubscriberLookupMapS = std::map<std::weak_ptr<void>, std::set<SenderLookupKey, SenderLookupKeyLess>, std::owner_less<std::weak_ptr<void>>>;
+        using SubscriberLookupMapG = SubscriberLookup<EventId>;
+        using SubscriberLookupMapS = SubscriberLookup<SenderLookupKey, SenderLookupKeyLess>;
 
         // --- 成员变量 (Data) ---
 
-        /** @brief 注册表读写锁。保护 components_, singletons_ 等。 */
-        mutable std::shared_mutex registry_mutex_;
+        /**
+         * @brief 分配服务 (IAllocatorService)。声明在所有容器之前：订阅列表与派发任务可能从它分配，必须最后析构。
+         */
+        std::unique_ptr<AllocatorService> allocator_ = std::make_unique<AllocatorService>();
+        /** @brief 框架热点容器的内存来源 (`framework_pool_allocations` 时为分级内存池，Create 时设置，之后只读)。 */
+        std::pmr::memory_resource* framework_resource_ = std::pmr::new_delete_resource();
+
+        /** @brief 注册表读写锁。保护 components_, default_map_ 等。 */
+        mutable ProfiledMutex<std::shared_mutex> registry_mutex_{ "PluginManager.registry_mutex_" };
 
-        /** @brief 组件信息表 (ClassId -> Info)。 */
-        std::unordered_map<ClassId, ComponentInfo> components_;
-        /** @brief 单例缓存表 (ClassId -> Holder)。 */
-        std::unordered_map<ClassId, SingletonHolder> singletons_;
+        /** @brief 组件表 (ClassId -> {Info, 单例 Holder})。 */
+        FlatIdMap<std::unique_ptr<ComponentRecord>> components_;
         /** @brief 已加载的 DLL 列表 (路径 -> 句柄)。 */
         std::vector<std::pair<std::string, PluginManager::LibHandle>> loaded_libs_;
+        /** @brief loaded_libs_ 的路径索引：“是否已加载” 只需一次哈希查找。与 loaded_libs_ 同步维护。 */
+        std::unordered_set<std::string> loaded_lib_paths_;
+        /** @brief 已加载文件的身份 -> 路径：同一文件经不同路径加载时视为已加载。 */
+        std::unordered_map<PluginFileKey, std::string, PluginFileKeyHash> loaded_file_ids_;
+
+        /** @brief [注册表锁内] 路径或文件身份是否已加载。 */
+        bool IsLibraryLoaded(const std::string& path, const PluginFileInfo* file_info) const {
+            if (loaded_lib_paths_.count(path)) return true;
+            return file_info && loaded_file_ids_.count(PluginFileKey{ file_info->device, file_info->file_id });
+        }
+
+        /** @brief [注册表写锁内] 登记一个已加载的库。 */
+        void AddLoadedLibrary(const std::string& path, PluginManager::LibHandle handle, const PluginFileInfo* file_info) {
+            loaded_libs_.push_back({ path, handle });
+            loaded_lib_paths_.insert(path);
+            if (file_info) loaded_file_ids_[PluginFileKey{ file_info->device, file_info->file_id }] = path;
+        }
+
+        /** @brief [注册表写锁内] 注销一个已加载的库。@return 其句柄；未加载时返回 nullptr。 */
+        PluginManager::LibHandle RemoveLoadedLibrary(const std::string& path) {
+            if (!loaded_lib_paths_.erase(path)) return nullptr;
+            for (auto it = loaded_file_ids_.begin(); it != loaded_file_ids_.end();) {
+                it = it->second == path ? loaded_file_ids_.erase(it) : std::next(it);
+            }
+            auto lib_it = std::find_if(loaded_libs_.begin(), loaded_libs_.end(),
+                [&](const auto& pair) { return pair.first == path; });
+            PluginManager::LibHandle handle = lib_it->second;
+            loaded_libs_.erase(lib_it);
+            return handle;
+        }
         /** @brief 别名索引 (Alias -> ClassId)。 */
-        std::unordered_map<std::string, ClassId> alias_map_;
+        AliasIndex alias_map_;
         /** @brief 默认实现索引 (InterfaceId -> ClassId)。 */
-        std::unordered_map<InterfaceId, ClassId> default_map_;
+        FlatIdMap<ClassId> default_map_;
         /** @brief 接口反查表 (InterfaceId -> [ClassId, ClassId...])。 */
-        std::unordered_map<InterfaceId, std::vector<ClassId>> interface_index_;
+        FlatIdMap<std::vector<ClassId>> interface_index_;
         /** @brief 插件来源索引 (DLL路径 -> [ClassId...])。用于卸载时清理。 */
         std::unordered_map<std::string, std::vector<ClassId>> plugin_path_index_;
+        /** @brief 插件账户 (DLL路径 -> 账户)。仅在启用内存或 CPU 记账时填充，受 registry_mutex_ 保护。 */
+        std::unordered_map<std::string, std::shared_ptr<AllocationAccount>> plugin_accounts_;
+        bool memory_accounting_ = false;  //!< 是否启用按插件内存记账 (Create 时设置)
+        bool cpu_accounting_ = false;     //!< 是否启用按插件 CPU 记账 (Create 时设置)
+
+        /** @brief 延迟加载的插件 (仅有清单条目、尚未 dlopen)。 */
+        struct DeferredPlugin {
+            std::filesystem::path file_path;
+            std::string init_func_name;
+        };
+        /** @brief 插件清单缓存文件。为空表示不使用缓存。受 registry_mutex_ 保护。 */
+        std::filesystem::path manifest_cache_path_;
+        /** @brief 单例检查点目录。为空表示不保存也不恢复。受 registry_mutex_ 保护。 */
+        std::filesystem::path checkpoint_dir_;
+        /** @brief 尚未加载的延迟插件 (路径 -> 加载参数)。受 registry_mutex_ 保护。 */
+        std::unordered_map<std::string, DeferredPlugin> deferred_plugins_;
+        /** @brief 已加载 (或正在加载) 的静态插件名。受 registry_mutex_ 保护。 */
+        std::unordered_set<std::string> static_plugins_;
+        /** @brief 启动报告：插件加载耗时 (按提交顺序)。受 startup_mutex_ 保护。 */
+        std::vector<PluginLoadTiming> load_timings_;
+        mutable std::mutex startup_mutex_;
+        /** @brief 串行化延迟插件的实际加载 (同一个库只加载一次)。 */
+        std::mutex deferred_load_mutex_;
+
+        /** @brief 插件目录监视：后台线程与平台句柄。受 dir_watch_mutex_ 保护 (线程运行期间句柄不变)。 */
+        std::mutex dir_watch_mutex_;
+        std::thread dir_watch_thread_;
+        std::shared_ptr<PlatformDirectoryWatch> dir_watch_;
+        std::shared_ptr<std::atomic<bool>> dir_watch_stopped_;  //!< 监视线程自己也持有一份 (见 StopPluginDirectoryWatch)
 
-        /** @brief 加载上下文变量：当前正在加载哪个 DLL。 */
-        std::string current_loading_plugin_path_;
-        /** @brief 加载上下文变量：当前 DLL 注册了哪些组件 (失败回滚用)。 */
-        std::vector<ClassId>* current_added_components_ = nullptr;
+        /** @brief 注册表版本。在 registry_mutex_ 写锁内递增，与 registry_snapshot_->version 比较判断快照是否过期。 */
+        std::atomic<uint64_t> registry_version_{ 1 };
+        /** @brief 最近一次发布的注册表快照。通过 std::atomic_load/store 无锁替换。 */
+        mutable std::shared_ptr<const RegistrySnapshot> registry_snapshot_;
+        /** @brief 串行化快照重建 (避免多个读者同时重建同一版本)。 */
+        mutable std::mutex snapshot_build_mutex_;
+
+        /** @brief 按 ClassId 查找注册表条目 (需持有 registry_mutex_)。不存在返回 nullptr。 */
+        ComponentRecord* FindComponent(ClassId clsid) const {
+            const auto* record = components_.Find(clsid);
+            return record ? record->get() : nullptr;
+        }
 
         // --- 事件总线数据 ---
 
         /** @brief 订阅表互斥锁。保护 global_subscribers_ 等。 */
-        mutable std::mutex subscriber_map_mutex_;
+        mutable ProfiledMutex<std::mutex> subscriber_map_mutex_{ "PluginManager.subscriber_map_mutex_" };
 
-        EventMap global_subscribers_;   //!< 全局订阅表
-        SenderMap sender_subscribers_;  //!< 特定发送者订阅表
+        EventMap global_subscribers_;   //!< 全局订阅表 (写侧权威数据，受 subscriber_map_mutex_ 保护)
+        SenderMap sender_subscribers_;  //!< 特定发送者订阅表 (写侧，按发送者地址哈希)
+        /** @brief 发送者 -> 哈希键。仅写侧使用：发送者销毁后仍能找回它的记录以便清理。 */
+        std::map<std::weak_ptr<void>, std::uintptr_t, std::owner_less<std::weak_ptr<void>>> sender_keys_;
+        /** @brief 新增发送者记录使表达到该规模时，先批量回收已销毁发送者的记录 (见 SweepExpiredSenders)。 */
+        size_t sender_prune_at_ = 64;
         SubscriberLookupMapG global_sub_lookup_; //!< 反查表：谁订阅了什么全局事件
+        /**
+         * @brief 事件族订阅表 (事件族 ID -> 订阅列表，写侧权威数据)。
+         * @details 读侧没有独立的事件族表：`PublishGlobal` 把成员事件的精确订阅与其所属
+         * 各级事件族的订阅合并成一张列表发布，Fire 时不做任何模式匹配。
+         */
+        EventMap family_subscribers_;
+        SubscriberLookupMapG family_sub_lookup_; //!< 反查表：谁订阅了什么事件族
+        EventMap channel_subscribers_;           //!< 类型化通道的订阅表 (事件 ID -> 订阅列表，写侧权威数据)
+        SubscriberLookupMapG channel_sub_lookup_; //!< 反查表：谁订阅了什么通道
+        /** @brief 已取得过的通道 (只增不减：句柄在总线存活期间一直指向同一个状态)。 */
+        std::unordered_map<EventId, std::unique_ptr<ChannelState>> channels_;
         SubscriberLookupMapS sender_sub_lookup_; //!< 反查表：谁订阅了什么 Sender 事件
 
         // --- 异步线程与 GC ---
-        std::thread event_loop_thread_; //!< 事件循环线程
-        std::queue<EventTask> event_queue_; //!< 任务队列
-        mutable std::mutex queue_mutex_; //!< 保护队列的锁
-        std::condition_variable queue_cv_; //!< 条件变量，用于唤醒线程
-        bool running_ = true; //!< 线程运行标志
+        /**
+         * @brief 派发线程池。
+         * @details 在 `Create()` 中一次性建好，之后直到析构都不再增删 (线程只读取自己的下标)。
+         */
+        std::vector<std::unique_ptr<DispatchWorker>> dispatch_workers_;
+        /** @brief 各线程角色的放置策略 (Create 时写入，之后只读)。 */
+        std::unordered_map<std::string, ThreadPlacement> thread_placements_;
+        std::atomic<bool> running_{ true }; //!< 框架运行标志
+
+        /**
+         * @brief 按分片键选择派发线程。
+         * @details 同一个 key 永远映射到同一个线程，从而保证同一订阅者的回调顺序。
+         */
+        std::size_t WorkerIndexOf(std::uintptr_t shard_key) const {
+            // 对象地址的低位通常是对齐填充，先打散再取模
+            std::size_t h = std::hash<std::uintptr_t>{}(shard_key >> 4);
+            return h % dispatch_workers_.size();
+        }
+
+        // --- 队列积压上限 (在 Create() 中、派发线程启动前设置，之后只读) ---
+        size_t queue_max_pending_ = 0;  //!< 0 表示不限制
+        EventQueueOverflowPolicy queue_overflow_policy_ = EventQueueOverflowPolicy::kBlock;
+        std::unordered_set<EventId> queue_priority_events_;
+        std::atomic<size_t> queue_dropped_count_{ 0 };  //!< 累计丢弃数
+
+        /** @brief 当前线程是否是派发线程 (kBlock 策略下派发线程不能阻塞在自己或其他派发线程上)。 */
+        static bool& IsDispatchThread() {
+            thread_local bool is_dispatch_thread = false;
+            return is_dispatch_thread;
+        }
+
+        /** @brief 本线程正在执行的异步任务的入队等待时长 (纳秒)，不在任务中时为 0。 */
+        static uint64_t& CurrentTaskWaitNs() {
+            thread_local uint64_t wait_ns = 0;
+            return wait_ns;
+        }
+
+        /** @brief 该事件的投递是否受积压上限约束。 */
+        bool IsDroppableEvent(EventId event_id) const {
+            return queue_max_pending_ == 0 || queue_priority_events_.count(event_id) == 0;
+        }
+
+        void ReportDropped(EventId event_id, const char* reason) {
+            queue_dropped_count_.fetch_add(1, std::memory_order_relaxed);
+            Trace(EventTracePoint::kQueuedDropped, event_id, nullptr, 0, reason);
+        }
+
+        /**
+         * @brief 触发一个追踪埋点。
+         * @details 钩子与记录器都未开启时只有一次 relaxed 原子读和一个几乎总是命中的分支，
+         * 参数构造也都被内联消除。
+         */
+        void Trace(EventTracePoint point, EventId event_id, const void* subscriber, uint32_t queue_depth, const char* label) {
+            if (trace_flags_.load(std::memory_order_relaxed) == 0) return;
+            TraceSlow(point, event_id, subscriber, queue_depth, label);
+        }
+
+        /** @brief 追踪的慢路径：写记录器，并调用钩子 (钩子的快照在调用期间保持存活)。 */
+        void TraceSlow(EventTracePoint point, EventId event_id, const void* subscriber, uint32_t queue_depth, const char* label) {
+            const uint32_t flags = trace_flags_.load(std::memory_order_acquire);
+            if (flags & kTraceRecorder) trace_recorder_.Record(point, event_id, subscriber, queue_depth);
+            if (flags & kTraceHook) {
+                auto hook = std::atomic_load_explicit(&event_trace_hook_, std::memory_order_acquire);
+                if (hook && *hook) (*hook)(point, event_id, const_cast<void*>(subscriber), label);
+            }
+        }
+
+        /**
+         * @brief 按溢出策略决定新任务能否入队。
+         * @return false 表示新任务被丢弃 (kDropNewest)。
+         * @details 积压计数是近似值：多个发布者并发时可能短暂超出上限几个任务。
+         */
+        bool AdmitTask(DispatchWorker& worker, const EventTask& task) {
+            if (worker.pending.load(std::memory_order_relaxed) < queue_max_pending_) return true;
+
+            switch (queue_overflow_policy_) {
+            case EventQueueOverflowPolicy::kDropNewest:
+                ReportDropped(task.event_id, "QueueDropNewest");
+                return false;
+
+            case EventQueueOverflowPolicy::kDropOldest:
+                // 只给最旧的可丢弃任务立墓碑，队列中的任务 (包括不可丢弃的) 都不移动，通道保持 FIFO
+                if (std::optional<EventId> victim = worker.DropOldest()) {
+                    worker.pending.fetch_sub(1, std::memory_order_relaxed);
+                    ReportDropped(*victim, "QueueDropOldest");
+                }
+                return true;
+
+
+            case EventQueueOverflowPolicy::kBlock:
+            default:
+                if (IsDispatchThread()) return true;
+                while (worker.pending.load(std::memory_order_acquire) >= queue_max_pending_ &&
+                    worker.running.load(std::memory_order_acquire)) {
+                    uint64_t key = worker.space.PrepareWait();
+                    if (worker.pending.load(std::memory_order_acquire) < queue_max_pending_ ||
+                        !worker.running.load(std::memory_order_acquire)) {
+                        worker.space.CancelWait();
+                        break;
+                    }
+                    worker.space.Wait(key);
+                }
+                return true;
+            }
+        }
+
+        /** @brief 将任务投递到下标为 worker_index 的派发线程。 */
+        void EnqueueTo(std::size_t worker_index, EventTask task) {
+            DispatchWorker& worker = *dispatch_workers_[worker_index];
+            if (queue_max_pending_ != 0 && task.droppable && !AdmitTask(worker, task)) return;
+            task.enqueue_ns = MetricsNowNs();
+            const size_t depth = worker.pending.fetch_add(1, std::memory_order_relaxed) + 1;
+            // 只有刷新水位时才写共享变量，稳态下只是一次读
+            size_t high = worker.high_water.load(std::memory_order_relaxed);
+            while (depth > high && !worker.high_water.compare_exchange_weak(high, depth, std::memory_order_relaxed)) {}
+            if (queue_max_pending_ != 0 && task.droppable &&
+                queue_overflow_policy_ == EventQueueOverflowPolicy::kDropOldest) {
+                task.ticket = std::make_shared<DropTicket>();
+                task.ticket->event_id = task.event_id;
+                worker.RegisterDroppable(task);
+            }
+            BoundedTaskQueue<EventTask>& lane = worker.Lane(task.priority);
+            lane.Push(std::move(task));
+            worker.wakeup.Notify();
+        }
+
+        /** @brief 将任务投递到 shard_key 对应的派发线程。 */
+        void Enqueue(std::uintptr_t shard_key, EventTask task) {
+            if (dispatch_workers_.empty()) return;
+            EnqueueTo(WorkerIndexOf(shard_key), std::move(task));
+        }
+
+        // --- 全局订阅表的读侧 (RCU + 稠密槽表) ---
+        RcuDomain rcu_;  //!< 订阅表旧版本的延迟回收域
+        std::atomic<EventSlot*> slot_chunks_[kMaxSlotChunks] = {};  //!< 读侧无锁访问；写侧在 subscriber_map_mutex_ 下分配
+        std::atomic<SenderTable*> sender_table_{ nullptr };          //!< 特定发送者订阅表的读侧哈希表
+
+        ~PluginManagerPimpl() {
+            for (auto& chunk : slot_chunks_) {
+                delete[] chunk.load(std::memory_order_relaxed);
+            }
+            delete sender_table_.load(std::memory_order_relaxed);
+        }
+
+        /** @brief [读侧] 按槽号取槽；所在块尚未分配 (从未有人订阅) 时返回 nullptr。 */
+        const EventSlot* SlotAt(EventSlotIndex slot) const {
+            if (slot >= kMaxEventSlots) return nullptr;
+            const EventSlot* chunk = slot_chunks_[slot >> kSlotChunkBits].load(std::memory_order_acquire);
+            return chunk ? &chunk[slot & (kSlotChunkSize - 1)] : nullptr;
+        }
+
+        /**
+         * @brief [写侧] 把 `global_subscribers_[event_id]` 的当前值发布给读者。
+         * @details 调用者必须持有 `subscriber_map_mutex_`。旧版本交给 `rcu_` 延迟释放。
+         */
+        void PublishGlobal(EventId event_id) {
+            auto list_it = global_subscribers_.find(event_id);
+            SubListPtr list = (list_it != global_subscribers_.end()) ? list_it->second : nullptr;
+            if (!family_subscribers_.empty()) list = MergeFamilySubscribers(event_id, std::move(list));
+            if (!channels_.empty()) list = PublishChannel(event_id, std::move(list));
+
+            EventSlotIndex slot = ResolveEventSlotIndex(event_id);
+            std::atomic<EventSlot*>& chunk_ref = slot_chunks_[slot >> kSlotChunkBits];
+            EventSlot* chunk = chunk_ref.load(std::memory_order_relaxed);
+            if (!chunk) {
+                if (!list) return;  // 从未发布过且仍为空，无需分配
+                chunk = new EventSlot[kSlotChunkSize];
+                chunk_ref.store(chunk, std::memory_order_release);
+            }
+
+            PublishList(chunk[slot & (kSlotChunkSize - 1)].published, std::move(list));
+            rcu_.TryAdvance();
+        }
+
+        /** @brief [写侧] 把 `list` (空列表视为没有) 发布到 `target`，旧版本交给 `rcu_`。 */
+        void PublishList(std::atomic<const SubListPtr*>& target, SubListPtr list) {
+            const SubListPtr* node = (list && !list->empty()) ? new SubListPtr(std::move(list)) : nullptr;
+            const SubListPtr* old_node = target.exchange(node, std::memory_order_acq_rel);
+            rcu_.Retire(std::shared_ptr<const SubListPtr>(old_node));
+        }
+
+        /**
+         * @brief [写侧] 发布事件的通道状态，并返回追加了通道订阅的总线列表 (调用者持有 `subscriber_map_mutex_`)。
+         * @param bus 全局 + 事件族订阅 (可为空)。
+         */
+        SubListPtr PublishChannel(EventId event_id, SubListPtr bus) {
+            auto channel_it = channels_.find(event_id);
+            if (channel_it == channels_.end()) return bus;
+            auto own_it = channel_subscribers_.find(event_id);
+            SubListPtr own = (own_it != channel_subscribers_.end()) ? own_it->second : nullptr;
+            PublishList(channel_it->second->subscribers, own);
+            PublishList(channel_it->second->bus_subscribers, bus);
+            if (!own || own->empty()) return bus;
+            auto merged = bus ? NewSubList(*bus) : NewSubList();
+            merged->insert(merged->end(), own->begin(), own->end());
+            return merged;
+        }
+
+        /**
+         * @brief 为新订阅取一个票据槽。
+         * @details 返回的引用放进订阅记录；`Connection` 句柄另取一个 (`ConnectionTicket::Share`)。
+         */
+        ConnectionTicket NewTicket(std::weak_ptr<void> subscriber, EventId event_id, std::weak_ptr<void> sender_key) const {
+            return ConnectionTicket(internal::ConnectionSlot::Acquire(owner_, std::move(subscriber), event_id,
+                std::move(sender_key)));
+        }
+
+        /** @brief 新建一个空的订阅列表 (列表对象、控制块与元素都从 `framework_resource_` 分配)。 */
+        std::shared_ptr<SubList> NewSubList() const {
+            return std::allocate_shared<SubList>(ResourceAllocator<SubList>(framework_resource_),
+                ResourceAllocator<Subscription>(framework_resource_));
+        }
+
+        /** @brief 写时复制：`NewSubList` 的拷贝版本。 */
+        std::shared_ptr<SubList> NewSubList(const SubList& copy) const {
+            return std::allocate_shared<SubList>(ResourceAllocator<SubList>(framework_resource_), copy);
+        }
+
+        /**
+         * @brief [写侧] 把事件所属各级事件族的订阅追加到精确订阅之后 (调用者持有 `subscriber_map_mutex_`)。
+         * @details 订阅对象按值复制，但与写侧共享票据、信箱与统计，断开连接对所有副本立即生效。
+         */
+        SubListPtr MergeFamilySubscribers(EventId event_id, SubListPtr exact) {
+            std::shared_ptr<SubList> merged;
+            for (EventId family_id : EventFamiliesOf(event_id)) {
+                auto family_it = family_subscribers_.find(family_id);
+                if (family_it == family_subscribers_.end() || !family_it->second) continue;
+                if (!merged) merged = exact ? NewSubList(*exact) : NewSubList();
+                merged->insert(merged->end(), family_it->second->begin(), family_it->second->end());
+            }
+            return merged ? SubListPtr(std::move(merged)) : exact;
+        }
+
+        /** @brief [写侧] 事件族订阅变化后，重新发布它覆盖的每个事件 (调用者持有 `subscriber_map_mutex_`)。 */
+        void PublishFamily(EventId family_id) {
+            for (EventId event_id : EventFamilyMembers(family_id)) PublishGlobal(event_id);
+        }
+
+        /**
+         * @brief [写侧] 把 `sender_subscribers_[key]` 的当前值发布给读者。
+         * @details 调用者必须持有 `subscriber_map_mutex_`。只复制 key 所在的桶 (O(桶大小))；
+         * 记录数超过桶数的 2 倍时整表扩容重建。
+         */
+        void PublishSender(std::uintptr_t key) {
+            SenderTable* table = sender_table_.load(std::memory_order_relaxed);
+            if (!table || sender_subscribers_.size() > 2 * (table->mask + 1)) {
+                size_t bucket_count = table ? (table->mask + 1) : kInitialSenderBuckets;
+                while (sender_subscribers_.size() > 2 * bucket_count) bucket_count <<= 1;
+                if (!table || bucket_count != table->mask + 1) {
+                    RebuildSenderTable(bucket_count);
+                    return;
+                }
+            }
+
+            size_t b = SenderBucketOf(key, table->mask);
+            const SenderBucket* old_bucket = table->buckets[b].load(std::memory_order_relaxed);
+            auto new_bucket = std::make_unique<SenderBucket>();
+            if (old_bucket) {
+                new_bucket->entries.reserve(old_bucket->entries.size() + 1);
+                for (const auto& entry : old_bucket->entries) {
+                    if (entry->key != key) new_bucket->entries.push_back(entry);
+                }
+            }
+            auto rec_it = sender_subscribers_.find(key);
+            if (rec_it != sender_subscribers_.end() && !rec_it->second.events.empty()) {
+                new_bucket->entries.push_back(std::make_shared<const SenderEntry>(
+                    SenderEntry{ rec_it->second.owner, key, rec_it->second.events }));
+            }
+
+            const SenderBucket* published = new_bucket->entries.empty() ? nullptr : new_bucket.release();
+            table->buckets[b].store(published, std::memory_order_release);
+            rcu_.Retire(std::shared_ptr<const SenderBucket>(old_bucket));
+            rcu_.TryAdvance();
+        }
+
+        /** @brief [写侧] 以 bucket_count 个桶重建整张读侧发送者表，旧表整体退役。 */
+        void RebuildSenderTable(size_t bucket_count) {
+            std::vector<std::unique_ptr<SenderBucket>> staged(bucket_count);
+            for (const auto& [key, record] : sender_subscribers_) {
+                if (record.events.empty()) continue;
+                auto& bucket = staged[SenderBucketOf(key, bucket_count - 1)];
+                if (!bucket) bucket = std::make_unique<SenderBucket>();
+                bucket->entries.push_back(std::make_shared<const SenderEntry>(
+                    SenderEntry{ record.owner, key, record.events }));
+            }
+            auto table = std::make_unique<SenderTable>(bucket_count);
+            for (size_t i = 0; i < bucket_count; ++i) {
+                table->buckets[i].store(staged[i].release(), std::memory_order_relaxed);
+            }
+            SenderTable* old_table = sender_table_.exchange(table.release(), std::memory_order_acq_rel);
+            rcu_.Retire(std::shared_ptr<const SenderTable>(old_table));
+            rcu_.TryAdvance();
+        }
+
+        /** @brief [写侧] 撤下整张读侧发送者表 (用于清空)。 */
+        void UnpublishAllSenders() {
+            SenderTable* old_table = sender_table_.exchange(nullptr, std::memory_order_acq_rel);
+            rcu_.Retire(std::shared_ptr<const SenderTable>(old_table));
+        }
+
+        /**
+         * @brief [读侧] 查找某发送者某事件当前发布的订阅列表 (O(1))。
+         * @details 必须在 `RcuDomain::ReadGuard` 作用域内调用。
+         * @param[out] out_key 发送者的哈希键 (供调用者调度 GC)。
+         * @param[out] out_stale 命中同地址但控制块不同的旧记录 (发送者已销毁、地址被复用) 时置 true。
+         */
+        const SubListPtr* FindPublishedSender(const std::weak_ptr<void>& sender, EventId event_id,
+            std::uintptr_t& out_key, bool& out_stale) const {
+            out_stale = false;
+            out_key = SenderKeyOf(sender);
+            if (!out_key) return nullptr;
+            const SenderTable* table = sender_table_.load(std::memory_order_acquire);
+            if (!table) return nullptr;
+            const SenderBucket* bucket = table->buckets[SenderBucketOf(out_key, table->mask)].load(std::memory_order_acquire);
+            if (!bucket) return nullptr;
+            for (const auto& entry : bucket->entries) {
+                if (entry->key != out_key) continue;
+                if (!SameOwner(entry->owner, sender)) {
+                    out_stale = true;
+                    return nullptr;
+                }
+                auto it = entry->events.find(event_id);
+                return it != entry->events.end() ? &it->second : nullptr;
+            }
+            return nullptr;
+        }
+
+        /**
+         * @brief [读侧] 查找全局事件当前发布的订阅列表。
+         * @details 必须在 `RcuDomain::ReadGuard` 作用域内调用；返回的指针在 Guard 结束前有效。
+         * @return 没有订阅者时返回 nullptr。
+         */
+        const SubListPtr* FindPublishedGlobal(EventSlotIndex slot) const {
+            const EventSlot* s = SlotAt(slot);
+            return s ? s->published.load(std::memory_order_acquire) : nullptr;
+        }
+
+        /** @brief [读侧] 同上，按 EventId 查找 (需要先查进程级槽号注册表)。 */
+        const SubListPtr* FindPublishedGlobalById(EventId event_id) const {
+            EventSlotIndex slot = 0;
+            if (!FindEventSlotIndex(event_id, slot)) return nullptr;
+            return FindPublishedGlobal(slot);
+        }
+
+        /**
+         * @brief 请求/应答的处理者记录 (每个请求 EventId 至多一个)。
+         * @details 断开或处理者销毁后记录仍留在表里，直到下一次注册同一请求时被替换；
+         * 查找时按 ticket 与弱引用判断是否有效。
+         */
+        struct RequestHandlerEntry {
+            std::weak_ptr<void> handler;
+            detail::RequestInvoker invoker;
+            std::string response_type;  //!< 拷贝一份：处理者模块卸载后 typeid 名字的内存也随之失效
+            ConnectionType type = ConnectionType::kQueued;
+            std::shared_ptr<IEventExecutor> executor;
+            ConnectionTicket ticket;
+
+            [[nodiscard]] bool IsAlive() const {
+                return ticket.Active() && !handler.expired();
+            }
+        };
+        mutable std::shared_mutex request_handlers_mutex_;
+        std::unordered_map<EventId, std::shared_ptr<const RequestHandlerEntry>> request_handlers_;
+
+        /**
+         * @brief 保留事件 (last-value cache) 的最新值。
+         * @details 发送者表以 owner 为键：发送者销毁后键仍可比较，不会与复用同一地址的新对象混淆。
+         * 已销毁发送者的条目在表规模翻倍时批量清理。锁顺序：subscriber_map_mutex_ → retained_mutex_。
+         */
+        mutable std::mutex retained_mutex_;
+        std::unordered_map<EventId, PluginPtr<Event>> retained_global_;
+        std::map<std::weak_ptr<void>, std::unordered_map<EventId, PluginPtr<Event>>,
+            std::owner_less<std::weak_ptr<void>>> retained_sender_;
+        size_t retained_sender_prune_at_ = 64;
+
+        /**
+         * @brief 丢弃全部保留事件 (在锁外析构)。
+         * @details 卸载全部插件前调用：事件可能由插件模块构造，析构函数与虚表都在插件中。
+         */
+        void ClearRetainedEvents() {
+            std::unordered_map<EventId, PluginPtr<Event>> global;
+            std::map<std::weak_ptr<void>, std::unordered_map<EventId, PluginPtr<Event>>,
+                std::owner_less<std::weak_ptr<void>>> sender;
+            std::lock_guard<std::mutex> lock(retained_mutex_);
+            global.swap(retained_global_);
+            sender.swap(retained_sender_);
+            retained_sender_prune_at_ = 64;
+        }
+
+        /**
+         * @brief 只丢弃动态类型来自某个模块的保留事件，以及发送者已销毁的条目 (在锁外析构)。
+         * @details 卸载单个插件、库尚未释放时调用。`in_module(type_info 地址)` 判断事件的
+         * 类型信息是否位于该插件中；它可能调用 dladdr 等加载器接口，因此在锁外求值，
+         * 以免与正在加载库、并在静态初始化中发布保留事件的线程互相等待。
+         * 发送者已销毁的条目连同键一起移除：键的控制块可能也由插件分配。
+         */
+        template <typename InModule>
+        void ClearRetainedEventsFrom(InModule&& in_module) {
+            using SenderMap = std::map<std::weak_ptr<void>, std::unordered_map<EventId, PluginPtr<Event>>,
+                std::owner_less<std::weak_ptr<void>>>;
+            std::vector<const std::type_info*> types;
+            {
+                std::lock_guard<std::mutex> lock(retained_mutex_);
+                for (const auto& [id, e] : retained_global_) if (e) types.push_back(&typeid(*e));
+                for (const auto& [sender, events] : retained_sender_) {
+                    for (const auto& [id, e] : events) if (e) types.push_back(&typeid(*e));
+                }
+            }
+            std::sort(types.begin(), types.end());
+            types.erase(std::unique(types.begin(), types.end()), types.end());
+            types.erase(std::remove_if(types.begin(), types.end(),
+                [&](const std::type_info* type) { return !in_module(static_cast<const void*>(type)); }), types.end());
+            const auto from_module = [&types](const PluginPtr<Event>& e) {
+                return e && std::binary_search(types.begin(), types.end(), &typeid(*e));
+            };
+
+            std::vector<PluginPtr<Event>> released;
+            SenderMap released_senders;
+            std::lock_guard<std::mutex> lock(retained_mutex_);
+            for (auto it = retained_global_.begin(); it != retained_global_.end();) {
+                if (!from_module(it->second)) { ++it; continue; }
+                released.push_back(std::move(it->second));
+                it = retained_global_.erase(it);
+            }
+            for (auto it = retained_sender_.begin(); it != retained_sender_.end();) {
+                auto& events = it->second;
+                for (auto e_it = events.begin(); e_it != events.end();) {
+                    if (!from_module(e_it->second)) { ++e_it; continue; }
+                    released.push_back(std::move(e_it->second));
+                    e_it = events.erase(e_it);
+                }
+                if (events.empty() || it->first.expired()) released_senders.insert(retained_sender_.extract(it++));
+                else ++it;
+            }
+        }
 
         // GC 状态
         mutable std::mutex gc_status_mutex_;
         std::unordered_set<EventId> pending_gc_events_; //!< 哪些事件需要进行垃圾回收
+        std::unordered_set<std::uintptr_t> pending_sender_gc_; //!< 哪些发送者 (哈希键) 需要进行垃圾回收
+        bool gc_pass_scheduled_ = false; //!< 是否已有 GC 批处理任务在队列中
+
+        /** @brief 是否还有登记了、尚未处理的待回收列表。 */
+        bool HasPendingGC() const {
+            std::lock_guard<std::mutex> lock(gc_status_mutex_);
+            return !pending_gc_events_.empty() || !pending_sender_gc_.empty();
+        }
+        std::chrono::microseconds gc_pass_budget_{ 1000 }; //!< 每轮 GC 的时间预算 (Create 时设置)
+
+        // 卸载插件 (ClearAllRegistries)
+        size_t shutdown_threads_ = 1;                       //!< 并行 Shutdown 的线程数 (Create 时设置)
+        std::chrono::nanoseconds shutdown_service_timeout_{ 0 }; //!< 单个 Shutdown 的超时，0 为不限 (Create 时设置)
+        bool shutdown_skip_unload_ = false;                 //!< 快速退出：不卸载插件库 (Create 时设置)
+
+        /** @brief 所属的 PluginManager。投递给外部执行器的任务据此判断框架是否仍然存活。 */
+        std::weak_ptr<PluginManager> owner_;
+        bool isolated_ = false;  //!< 独立实例：内部线程与组件生命周期调用绑定到 owner_ (Create 时设置)
+        uint64_t binding_id_ = 0; //!< 线程绑定编号 (Create 时分配，进程内唯一)
+
+        /** @brief 独立实例内部线程的绑定；默认实例返回未绑定 (线程沿用全局默认实例)。 */
+        ThreadBinding InternalThreadBinding() const {
+            return isolated_ ? ThreadBinding{ owner_, true, binding_id_ } : ThreadBinding{};
+        }
+
+        // 运行指标
+        bool metrics_time_direct_calls_ = false;              //!< 是否为 kDirect 回调计时 (Create 时设置)
+        bool time_direct_calls_ = false;                      //!< 指标或看门狗需要 kDirect 回调耗时 (Create 时设置)
+        uint64_t slow_handler_threshold_ns_ = 0;              //!< 慢回调阈值，0 为关闭 (Create 时设置)
+        uint64_t slow_handler_demote_after_ = 0;              //!< 降级前允许的慢调用次数，0 为不降级 (Create 时设置)
+        PluginSymbolBinding symbol_binding_ = PluginSymbolBinding::kEager; //!< 默认符号绑定策略 (Create 时设置)
+        std::unordered_map<std::string, PluginSymbolBinding> symbol_binding_overrides_; //!< 文件名 -> 策略 (Create 时设置)
+        std::atomic<uint64_t> exception_count_{ 0 };          //!< ReportException 看到的异常总数
+        std::atomic<uint64_t> unknown_exception_count_{ 0 };  //!< 其中非 std::exception 的数量
 
         // Hooks
-        EventTraceHook event_trace_hook_ = nullptr;
+        static constexpr uint32_t kTraceHook = 1u << 0;     //!< trace_flags_：已设置 event_trace_hook_
+        static constexpr uint32_t kTraceRecorder = 1u << 1; //!< trace_flags_：记录器开启
+        std::atomic<uint32_t> trace_flags_{ 0 }; //!< 任一位被置位时埋点才会走慢路径
+        std::shared_ptr<const EventTraceHook> event_trace_hook_; //!< 通过 std::atomic_load/store 无锁替换
+        /** @brief 接口调用拦截规则 (见 SetCallInterception)。受 interception_mutex_ 保护。 */
+        std::unordered_set<std::string> intercepted_names_;  //!< 接口名或组件别名
+        std::unordered_set<ClassId> intercepted_classes_;
+        mutable std::mutex interception_mutex_;
+        EventTraceRecorder trace_recorder_;
         using ExceptionCallback = std::function<void(const std::exception&)>;
         std::shared_ptr<ExceptionCallback> exception_handler_ = nullptr;
         mutable std::mutex exception_handler_mutex_;
+        std::shared_ptr<PluginManager::SlowEventHandlerCallback> slow_handler_callback_; //!< 受 exception_handler_mutex_ 保护
+
+        /** @brief 共享执行器 (IExecutorService)。Create 时构造，析构时在清理注册表之后停止。 */
+        std::shared_ptr<TaskExecutor> executor_;
+
+        /** @brief 共享缓冲区池 (IBufferPool)。随 Pimpl 析构清空缓存；仍在外的缓冲区释放时直接归还系统。 */
+        std::unique_ptr<BufferPool> buffer_pool_;
+
+        /** @brief 定时器服务 (ITimerService) 的时间轮。由 executor_ 驱动，先于它析构。 */
+        std::unique_ptr<TimerWheel> timer_wheel_;
     };
 
 }  // namespace z3y
@@ -0,0 +1,200 @@
+﻿/*
+* Copyright [2025] [Yue Liu]
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/**
+ * @file plugin_manifest.h
+ * @brief [私有头文件] 插件清单缓存：记录每个插件上次加载时注册了什么。
+ *
+ * @details
+ * [受众：框架维护者]
+ *
+ * 启动时 `LoadPluginsFromDirectory` 先对每个文件做一次 stat (`QueryPluginFileInfo`)：
+ * 路径、大小、修改时间都与缓存一致的插件不再 dlopen，而是按清单注册“延迟条目”；
+ * 同一次 stat 得到的文件身份 (设备 + 文件号) 也用于判断该文件是否已经加载过。
+ * 直到第一次 `GetService` / `CreateInstance` 命中其中某个组件时才真正加载该库。
+ *
+ * 文件是按行的文本格式 (字段以制表符分隔)，损坏或版本不符时整体视为空缓存：
+ * \code
+ * z3y-plugin-manifest  2
+ * P  <size>  <mtime>  <path>
+ * C  <clsid>  <is_singleton>  <is_default>  <alias>
+ * I  <iid>  <major>  <minor>  <name>
+ * \endcode
+ */
+
+#pragma once
+
+#ifndef Z3Y_SRC_PLUGIN_MANAGER_PLUGIN_MANIFEST_H_
+#define Z3Y_SRC_PLUGIN_MANAGER_PLUGIN_MANIFEST_H_
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "framework/i_plugin_query.h"
+
+namespace z3y {
+
+    /**
+     * @brief 一次系统调用 (stat / GetFileInformationByHandle) 得到的插件文件信息。
+     * @details (device, file_id) 标识文件本身：经符号链接或不同的相对路径访问同一文件时相同。
+     * (size, mtime) 标识文件版本，用作清单缓存的校验键。mtime 的单位由平台决定，只用于比较相等。
+     */
+    struct PluginFileInfo {
+        uint64_t device = 0;
+        uint64_t file_id = 0;
+        uint64_t size = 0;
+        int64_t mtime = 0;
+    };
+
+    /** @brief (device, file_id) 作为已加载文件索引的键。 */
+    struct PluginFileKey {
+        uint64_t device = 0;
+        uint64_t file_id = 0;
+        bool operator==(const PluginFileKey& other) const noexcept {
+            return device == other.device && file_id == other.file_id;
+        }
+    };
+
+    struct PluginFileKeyHash {
+        size_t operator()(const PluginFileKey& key) const noexcept {
+            return static_cast<size_t>(key.file_id * 0x9E3779B97F4A7C15ull ^ key.device);
+        }
+    };
+
+    /** @brief [平台实现] 读取文件信息。失败返回 false。定义在 platform_*.cpp 中。 */
+    bool QueryPluginFileInfo(const std::filesystem::path& file, PluginFileInfo& out_info);
+
+    /** @brief 清单中的一个组件 (足以注册延迟条目并回答内省查询)。 */
+    struct PluginManifestComponent {
+        ClassId clsid = 0;
+        std::string alias;
+        bool is_singleton = false;
+        bool is_default = false;
+        std::vector<InterfaceDetails> interfaces;
+    };
+
+    /** @brief 一个插件文件的清单。 */
+    struct PluginManifestEntry {
+        uint64_t file_size = 0;
+        int64_t mtime = 0;
+        std::vector<PluginManifestComponent> components;
+    };
+
+    /**
+     * @class PluginManifestCache
+     * @brief 清单缓存文件的内存表示 (路径 -> 清单)。不是线程安全的，由单次目录加载独占使用。
+     */
+    class PluginManifestCache {
+    public:
+        static constexpr const char* kMagic = "z3y-plugin-manifest";
+        static constexpr int kVersion = 2;  //!< 2: mtime 改为平台原生单位 (取自 QueryPluginFileInfo)
+
+        /** @brief 从文件读取。文件缺失、损坏或版本不符时得到空缓存。 */
+        void Load(const std::filesystem::path& cache_file) {
+            entries_.clear();
+            std::ifstream in(cache_file, std::ios::binary);
+            if (!in) return;
+            std::string line;
+            if (!std::getline(in, line) || line != std::string(kMagic) + '\t' + std::to_string(kVersion)) return;
+            PluginManifestEntry* entry = nullptr;
+            PluginManifestComponent* component = nullptr;
+            std::vector<std::string> f;
+            try {
+                while (std::getline(in, line)) {
+                    if (line.empty()) continue;
+                    f = Split(line, 5);
+                    if (f[0] == "P" && f.size() == 4) {
+                        entry = &entries_[f[3]];
+                        *entry = PluginManifestEntry{ std::stoull(f[1]), std::stoll(f[2]), {} };
+                        component = nullptr;
+                    } else if (f[0] == "C" && f.size() == 5 && entry) {
+                        entry->components.push_back({ std::stoull(f[1]), f[4], f[2] == "1", f[3] == "1", {} });
+                        component = &entry->components.back();
+                    } else if (f[0] == "I" && f.size() == 5 && component) {
+                        component->interfaces.push_back({ std::stoull(f[1]), f[4],
+                            { static_cast<uint32_t>(std::stoul(f[2])), static_cast<uint32_t>(std::stoul(f[3])) } });
+                    } else {
+                        entries_.clear();
+                        return;
+                    }
+                }
+            } catch (const std::exception&) {
+                entries_.clear();  // 数字字段损坏
+            }
+        }
+
+        /** @brief 写回文件 (先写临时文件再改名)。失败返回 false。 */
+        bool Save(const std::filesystem::path& cache_file) const {
+            std::filesystem::path tmp = cache_file;
+            tmp += ".tmp";
+            {
+                std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+                if (!out) return false;
+                out << kMagic << '\t' << kVersion << '\n';
+                for (const auto& [path, entry] : entries_) {
+                    out << "P\t" << entry.file_size << '\t' << entry.mtime << '\t' << path << '\n';
+                    for (const auto& c : entry.components) {
+                        out << "C\t" << c.clsid << '\t' << (c.is_singleton ? 1 : 0) << '\t'
+                            << (c.is_default ? 1 : 0) << '\t' << c.alias << '\n';
+                        for (const auto& i : c.interfaces) {
+                            out << "I\t" << i.iid << '\t' << i.version.major << '\t' << i.version.minor
+                                << '\t' << i.name << '\n';
+                        }
+                    }
+                }
+                if (!out) return false;
+            }
+            std::error_code ec;
+            std::filesystem::rename(tmp, cache_file, ec);
+            return !ec;
+        }
+
+        /** @brief 查找与当前文件状态一致的清单。 */
+        [[nodiscard]] const PluginManifestEntry* Find(const std::string& path, uint64_t size, int64_t mtime) const {
+            auto it = entries_.find(path);
+            if (it == entries_.end() || it->second.file_size != size || it->second.mtime != mtime) return nullptr;
+            return &it->second;
+        }
+
+        void Put(const std::string& path, PluginManifestEntry entry) { entries_[path] = std::move(entry); }
+
+    private:
+        /** @brief 按制表符切分，最多切出 max_fields 段 (最后一段保留其余内容)。 */
+        static std::vector<std::string> Split(const std::string& line, size_t max_fields) {
+            std::vector<std::string> out;
+            size_t begin = 0;
+            while (out.size() + 1 < max_fields) {
+                const size_t tab = line.find('\t', begin);
+                if (tab == std::string::npos) break;
+                out.push_back(line.substr(begin, tab - begin));
+                begin = tab + 1;
+            }
+            out.push_back(line.substr(begin));
+            return out;
+        }
+
+        std::map<std::string, PluginManifestEntry> entries_;
+    };
+
+}  // namespace z3y
+
+#endif  // Z3Y_SRC_PLUGIN_MANAGER_PLUGIN_MANIFEST_H_
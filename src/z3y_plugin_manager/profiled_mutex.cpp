@@ -0,0 +1,67 @@
+﻿/*
+* Copyright [2025] [Yue Liu]
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/**
+ * @file profiled_mutex.cpp
+ * @brief [内部] 全局锁竞争采样钩子的安装与分发。
+ */
+
+#include "framework/profiled_mutex.h"
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+namespace z3y {
+
+    namespace {
+        /** @brief 已安装的钩子。整体替换，读者拿到的指针在 in_flight 归零前不会被释放。 */
+        struct HookSlot {
+            LockProfileHook hook;
+            void* context;
+        };
+
+        std::atomic<const HookSlot*> g_lock_hook{ nullptr };
+        std::atomic<uint32_t> g_lock_hook_calls{ 0 };  //!< 进行中的钩子调用数
+        thread_local bool tls_in_lock_hook = false;   //!< 钩子内部再次加锁时不递归上报
+    }  // namespace
+
+    void SetLockProfileHook(LockProfileHook hook, void* context) {
+        static std::mutex install_mutex;  // 串行化安装：否则两个安装者可能释放同一个旧钩子
+        std::lock_guard<std::mutex> lock(install_mutex);
+        const HookSlot* next = hook ? new HookSlot{ hook, context } : nullptr;
+        const HookSlot* old = g_lock_hook.exchange(next, std::memory_order_seq_cst);
+        // 与 ReportLockSample 的 seq_cst 计数配对：观察到 0 之后新的调用只能看到新钩子
+        while (g_lock_hook_calls.load(std::memory_order_seq_cst) != 0) std::this_thread::yield();
+        delete old;
+    }
+
+    bool IsLockProfileHookInstalled() noexcept {
+        return g_lock_hook.load(std::memory_order_relaxed) != nullptr;
+    }
+
+    void ReportLockSample(const LockContentionSample& sample) noexcept {
+        if (tls_in_lock_hook) return;
+        g_lock_hook_calls.fetch_add(1, std::memory_order_seq_cst);
+        if (const HookSlot* slot = g_lock_hook.load(std::memory_order_seq_cst)) {
+            tls_in_lock_hook = true;
+            slot->hook(sample, slot->context);
+            tls_in_lock_hook = false;
+        }
+        g_lock_hook_calls.fetch_sub(1, std::memory_order_seq_cst);
+    }
+
+}  // namespace z3y
@@ -0,0 +1,168 @@
+﻿/*
+* Copyright [2025] [Yue Liu]
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/**
+ * @file rcu_domain.h
+ * @brief [私有头文件] 事件总线读侧使用的轻量级 RCU (Read-Copy-Update) 域。
+ *
+ * @details
+ * [受众：框架维护者]
+ *
+ * **为什么需要它?**
+ * 订阅表是“读多写少”的典型场景：每次 Fire 都要读，Subscribe/Unsubscribe 很少发生。
+ * 原实现每次 Fire 都要加 `subscriber_map_mutex_` 复制 `SubListPtr`，
+ * 所有发布线程在这把锁 (以及 shared_ptr 控制块的引用计数) 上串行化。
+ *
+ * **算法 (两阶段纪元，类似 SRCU):**
+ * - 读者进入临界区时，在 *自己线程对应的* 计数槽上为当前纪元的奇偶位 +1，
+ * 离开时 -1。不同线程落在不同缓存行上，读者之间没有共享写。
+ * - 写者 (持有外部写锁) 发布新版本后，把旧版本 `Retire()` 到当前纪元的回收桶。
+ * - `TryAdvance()` 在上一个纪元的读者全部离开后推进纪元，并释放该纪元退役的对象。
+ * 它 *从不阻塞*，因此可以安全地在事件回调 (读临界区内) 中订阅/取消订阅。
+ */
+
+#pragma once
+
+#ifndef Z3Y_SRC_PLUGIN_MANAGER_RCU_DOMAIN_H_
+#define Z3Y_SRC_PLUGIN_MANAGER_RCU_DOMAIN_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace z3y {
+
+    /**
+     * @class RcuDomain
+     * @brief 读侧无锁、写侧延迟回收的 RCU 域。
+     */
+    class RcuDomain {
+        /** @brief 每个槽独占一条缓存行，两个计数分别对应纪元的奇偶位。 */
+        struct alignas(64) ReaderSlot {
+            std::atomic<int64_t> count[2] = { {0}, {0} };
+        };
+
+    public:
+        /** @brief 读计数槽数量。线程按轮转方式分配到槽上，槽越多读者越不容易共享缓存行。 */
+        static constexpr size_t kReaderSlots = 64;
+
+        /**
+         * @class ReadGuard
+         * @brief 读临界区 (RAII)。可以嵌套。
+         * @details 在 Guard 存活期间，通过本域发布的任何指针都不会被释放。
+         */
+        class ReadGuard {
+        public:
+            explicit ReadGuard(const RcuDomain& domain) : slot_(domain.SlotForThisThread()) {
+                for (;;) {
+                    uint64_t epoch = domain.epoch_.load(std::memory_order_seq_cst);
+                    parity_ = static_cast<unsigned>(epoch & 1);
+                    slot_.count[parity_].fetch_add(1, std::memory_order_seq_cst);
+                    // 复查：确保计数是在该奇偶位仍然有效时登记的，否则写者可能漏看
+                    if ((domain.epoch_.load(std::memory_order_seq_cst) & 1) == parity_) break;
+                    slot_.count[parity_].fetch_sub(1, std::memory_order_relaxed);
+                }
+            }
+
+            ~ReadGuard() { slot_.count[parity_].fetch_sub(1, std::memory_order_release); }
+
+            ReadGuard(const ReadGuard&) = delete;
+            ReadGuard& operator=(const ReadGuard&) = delete;
+
+        private:
+            ReaderSlot& slot_;
+            unsigned parity_ = 0;
+        };
+
+        RcuDomain() = default;
+        RcuDomain(const RcuDomain&) = delete;
+        RcuDomain& operator=(const RcuDomain&) = delete;
+
+        /**
+         * @brief 登记一个已经 *不再可达* (已从发布位置摘下) 的旧版本。
+         * @param retired 持有旧对象的所有权；释放时机由本域决定。
+         */
+        void Retire(std::shared_ptr<const void> retired) {
+            if (!retired) return;
+            std::lock_guard<std::mutex> lock(mutex_);
+            buckets_[epoch_.load(std::memory_order_relaxed) & 1].push_back(std::move(retired));
+        }
+
+        /**
+         * @brief 尝试推进纪元并回收旧版本 (非阻塞)。
+         * @return 成功推进返回 true；仍有旧读者未离开返回 false。
+         */
+        bool TryAdvance() {
+            std::vector<std::shared_ptr<const void>> reclaim;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (buckets_[0].empty() && buckets_[1].empty()) return true;
+
+                uint64_t epoch = epoch_.load(std::memory_order_relaxed);
+                unsigned previous = static_cast<unsigned>((epoch + 1) & 1);
+                if (ActiveReaders(previous) != 0) return false;
+
+                // 上一个纪元的读者已全部离开：它之前退役的对象可以释放了
+                reclaim.swap(buckets_[previous]);
+                epoch_.store(epoch + 1, std::memory_order_seq_cst);
+            }
+            return true;  // reclaim 在锁外析构
+        }
+
+        /**
+         * @brief 阻塞直到所有已退役的对象都被释放。
+         * @warning 不能在 ReadGuard 作用域内调用 (会自我等待)。
+         */
+        void Synchronize() {
+            for (;;) {
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    if (buckets_[0].empty() && buckets_[1].empty()) return;
+                }
+                if (!TryAdvance()) std::this_thread::yield();
+            }
+        }
+
+    private:
+        ReaderSlot& SlotForThisThread() const {
+            static std::atomic<size_t> next_slot{ 0 };
+            thread_local const size_t slot_index = next_slot.fetch_add(1, std::memory_order_relaxed) % kReaderSlots;
+            return slots_[slot_index];
+        }
+
+        int64_t ActiveReaders(unsigned parity) const {
+            int64_t total = 0;
+            for (const auto& slot : slots_) {
+                total += slot.count[parity].load(std::memory_order_acquire);
+            }
+            return total;
+        }
+
+        mutable ReaderSlot slots_[kReaderSlots];
+        std::atomic<uint64_t> epoch_{ 0 };
+
+        std::mutex mutex_;
+        std::vector<std::shared_ptr<const void>> buckets_[2];
+    };
+
+}  // namespace z3y
+
+#endif  // Z3Y_SRC_PLUGIN_MANAGER_RCU_DOMAIN_H_
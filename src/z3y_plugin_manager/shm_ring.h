@@ -0,0 +1,195 @@
+﻿/*
+* Copyright [2025] [Yue Liu]
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/**
+ * @file shm_ring.h
+ * @brief [内部] `IpcEventBridge` 的共享内存段布局与跨进程单生产者/单消费者环。
+ *
+ * @details
+ * [受众：框架维护者]
+ *
+ * 段布局：`ShmSegmentHeader` (含两个环的读写位置) 之后依次是「创建者 → 对端」与「对端 → 创建者」两个数据区。
+ *
+ * 环内记录：`ShmRecordHeader` (16 字节) + 载荷，整体按 8 字节对齐。
+ * 读写位置是单调递增的 64 位计数，取模容量 (2 的幂) 得到偏移。
+ * 记录不跨越环尾：尾部剩余空间不足时写入一个回绕标记 (剩余不足 16 字节时读端直接跳过)，再从偏移 0 写入。
+ *
+ * 每个环只有一个生产者进程和一个消费者进程；生产者进程内的多个线程由调用方加锁串行化。
+ * 位置计数必须是免锁原子量，否则无法跨进程共享 (由 static_assert 保证)。
+ */
+
+#pragma once
+
+#ifndef Z3Y_SRC_PLUGIN_MANAGER_SHM_RING_H_
+#define Z3Y_SRC_PLUGIN_MANAGER_SHM_RING_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace z3y {
+
+    /**
+     * @struct SharedMemoryRegion
+     * @brief [平台实现] 一段命名共享内存的映射。
+     */
+    struct SharedMemoryRegion {
+        void* base = nullptr;
+        size_t size = 0;
+        void* native_handle = nullptr;  //!< Windows: 文件映射句柄；POSIX: 未使用
+        std::string native_name;        //!< POSIX: shm_open 名称 (创建者析构时 unlink)
+        bool owner = false;
+    };
+
+    /**
+     * @brief [平台实现] 创建 (`create = true`，同名已存在则失败) 或打开命名共享内存并映射。
+     * @param size 创建时的大小；打开时忽略，映射大小取自系统。
+     */
+    bool PlatformOpenSharedMemory(const std::string& name, size_t size, bool create,
+        SharedMemoryRegion& out, std::string& out_error_message);
+
+    /** @brief [平台实现] 解除映射；创建者同时删除段名。 */
+    void PlatformCloseSharedMemory(SharedMemoryRegion& region);
+
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "IPC ring positions must be lock-free atomics");
+    static_assert(std::atomic<uint32_t>::is_always_lock_free, "IPC segment flags must be lock-free atomics");
+
+    struct alignas(64) ShmRingPositions {
+        std::atomic<uint64_t> head;  //!< 读位置 (消费者写)
+        char pad_[64 - sizeof(std::atomic<uint64_t>)];
+        std::atomic<uint64_t> tail;  //!< 写位置 (生产者写)
+    };
+
+    struct alignas(64) ShmSegmentHeader {
+        static constexpr uint32_t kMagic = 0x5A335949;  // "Z3YI"
+        static constexpr uint32_t kVersion = 1;
+
+        std::atomic<uint32_t> magic;     //!< 创建者初始化完毕后最后写入
+        uint32_t version;
+        uint64_t ring_bytes;             //!< 每个数据区的容量 (2 的幂)
+        std::atomic<uint32_t> attached[2];  //!< [0] 创建者，[1] 对端
+        ShmRingPositions rings[2];       //!< [0] 创建者 → 对端，[1] 对端 → 创建者
+    };
+
+    struct ShmRecordHeader {
+        static constexpr uint32_t kWrap = 1;  //!< 回绕标记：跳到环首继续读
+
+        uint32_t size;  //!< 载荷字节数
+        uint32_t flags;
+        uint64_t event_id;
+    };
+    static_assert(sizeof(ShmRecordHeader) == 16, "ShmRecordHeader layout must be stable across processes");
+
+    /**
+     * @class ShmRing
+     * @brief 映射在共享内存上的一个方向的环 (不拥有内存)。
+     */
+    class ShmRing {
+    public:
+        ShmRing() = default;
+        ShmRing(ShmRingPositions* pos, char* data, size_t capacity) noexcept
+            : pos_(pos), data_(data), capacity_(capacity), mask_(capacity - 1) {}
+
+        static constexpr size_t AlignRecord(size_t n) noexcept { return (n + 7) & ~size_t(7); }
+
+        /** @brief 单条记录 (含头) 的上限：环容量的一半，保证回绕后总能放下。 */
+        [[nodiscard]] size_t MaxPayload() const noexcept { return capacity_ / 2 - sizeof(ShmRecordHeader); }
+
+        /**
+         * @brief [生产者] 写入一条记录。
+         * @return 空间不足或载荷过大时返回 false (不阻塞)。
+         */
+        bool TryWrite(uint64_t event_id, const void* payload, size_t size) noexcept {
+            if (size > MaxPayload()) return false;
+            const size_t record = AlignRecord(sizeof(ShmRecordHeader) + size);
+            uint64_t tail = pos_->tail.load(std::memory_order_relaxed);
+            const uint64_t head = pos_->head.load(std::memory_order_acquire);
+            const size_t offset = static_cast<size_t>(tail & mask_);
+            const size_t contiguous = capacity_ - offset;
+            const size_t needed = contiguous < record ? contiguous + record : record;
+            if ((tail - head) + needed > capacity_) return false;
+
+            size_t at = offset;
+            if (contiguous < record) {
+                if (contiguous >= sizeof(ShmRecordHeader)) {
+                    const ShmRecordHeader wrap{ 0, ShmRecordHeader::kWrap, 0 };
+                    std::memcpy(data_ + offset, &wrap, sizeof(wrap));
+                }
+                tail += contiguous;
+                at = 0;
+            }
+            const ShmRecordHeader header{ static_cast<uint32_t>(size), 0, event_id };
+            std::memcpy(data_ + at, &header, sizeof(header));
+            if (size != 0) std::memcpy(data_ + at + sizeof(header), payload, size);
+            pos_->tail.store(tail + record, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * @brief [消费者] 依次把当前所有记录交给 `fn(event_id, payload, size)`，载荷直接指向共享内存。
+         * @details 每条记录处理完才推进读位置，`fn` 返回前载荷不会被生产者覆盖。
+         * @return 处理的记录数。
+         */
+        template <typename Fn>
+        size_t Drain(Fn&& fn) {
+            uint64_t head = pos_->head.load(std::memory_order_relaxed);
+            const uint64_t tail = pos_->tail.load(std::memory_order_acquire);
+            size_t count = 0;
+            while (head != tail) {
+                const size_t offset = static_cast<size_t>(head & mask_);
+                const size_t contiguous = capacity_ - offset;
+                ShmRecordHeader header;
+                if (contiguous < sizeof(ShmRecordHeader)) {
+                    head += contiguous;
+                    continue;
+                }
+                std::memcpy(&header, data_ + offset, sizeof(header));
+                if (header.flags & ShmRecordHeader::kWrap) {
+                    head += contiguous;
+                    continue;
+                }
+                const size_t record = AlignRecord(sizeof(ShmRecordHeader) + header.size);
+                if (record > contiguous) {
+                    // 对端写坏了环 (或版本不符)：丢弃剩余内容，避免越界
+                    pos_->head.store(tail, std::memory_order_release);
+                    return count;
+                }
+                fn(header.event_id, data_ + offset + sizeof(header), static_cast<size_t>(header.size));
+                head += record;
+                pos_->head.store(head, std::memory_order_release);
+                ++count;
+            }
+            return count;
+        }
+
+        /** @brief 尚未被消费者取走的字节数 (含记录头与填充)。 */
+        [[nodiscard]] size_t UsedBytes() const noexcept {
+            return static_cast<size_t>(pos_->tail.load(std::memory_order_acquire) -
+                pos_->head.load(std::memory_order_acquire));
+        }
+
+    private:
+        ShmRingPositions* pos_ = nullptr;
+        char* data_ = nullptr;
+        size_t capacity_ = 0;
+        size_t mask_ = 0;
+    };
+
+}  // namespace z3y
+
+#endif  // Z3Y_SRC_PLUGIN_MANAGER_SHM_RING_H_
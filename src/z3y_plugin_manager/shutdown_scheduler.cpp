@@ -0,0 +1,224 @@
+﻿/*
+* Copyright [2025] [Yue Liu]
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/**
+ * @file shutdown_scheduler.cpp
+ * @brief [内部] 依赖感知的并行 Shutdown 调度 (见 shutdown_scheduler.h)。
+ */
+
+#include "shutdown_scheduler.h"
+#include "event_metrics.h"
+#include "plugin_manager_pimpl.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+namespace z3y {
+
+    namespace {
+        using Clock = std::chrono::steady_clock;
+
+        enum class NodeState { kWaiting, kReady, kRunning, kDone };
+
+        struct Node {
+            ShutdownItem item;
+            std::vector<size_t> releases;  //!< 本服务结束后少等一个依赖者的服务 (即它的依赖)
+            size_t waiting = 0;            //!< 尚未结束的依赖者数量
+            NodeState state = NodeState::kWaiting;
+            bool abandoned = false;        //!< 已超时：调度不再等待它
+            Clock::time_point deadline;
+            std::thread::id worker;        //!< 执行它的线程
+        };
+
+        /** @brief 调度状态。工作线程与调用线程共享；超时被分离的线程也持有一份引用。 */
+        struct Plan {
+            std::mutex mutex;
+            std::condition_variable work_cv;  //!< 工作线程：有就绪项或调度结束
+            std::condition_variable done_cv;  //!< 调用线程：有服务结束
+            std::vector<Node> nodes;          //!< 构造后不再扩容
+            std::set<size_t> ready;           //!< 就绪服务的下标 (小下标 = 原顺序靠前，先取)
+            size_t remaining = 0;             //!< 尚未结束 (不含已超时) 的服务数
+            size_t running = 0;               //!< 正在执行且未超时的服务数
+            bool stop = false;
+            ShutdownOutcome outcome;
+
+            void MakeReady_UNLOCKED(size_t index) {
+                nodes[index].state = NodeState::kReady;
+                ready.insert(index);
+            }
+
+            /** @brief 服务结束 (或超时)：释放它的依赖。 */
+            void Finish_UNLOCKED(size_t index) {
+                --remaining;
+                for (size_t dep : nodes[index].releases) {
+                    if (--nodes[dep].waiting == 0 && nodes[dep].state == NodeState::kWaiting) MakeReady_UNLOCKED(dep);
+                }
+                BreakCycle_UNLOCKED();
+            }
+
+            /** @brief 没有就绪也没有运行中的服务却仍有剩余：依赖图有环，按原顺序强行放出一个。 */
+            void BreakCycle_UNLOCKED() {
+                if (!ready.empty() || running != 0 || remaining == 0) return;
+                for (size_t i = 0; i < nodes.size(); ++i) {
+                    if (nodes[i].state == NodeState::kWaiting) {
+                        MakeReady_UNLOCKED(i);
+                        return;
+                    }
+                }
+            }
+
+            size_t PopReady_UNLOCKED() {
+                const size_t index = *ready.begin();
+                ready.erase(ready.begin());
+                return index;
+            }
+        };
+
+        std::exception_ptr Execute(Node& node) {
+            try {
+                const CpuChargeScope charge = CpuChargeScope::Lifecycle(node.item.account.get());
+                node.item.instance->Shutdown();
+            } catch (...) {
+                return std::current_exception();
+            }
+            return nullptr;
+        }
+
+        void WorkerLoop(const std::shared_ptr<Plan>& plan, std::chrono::nanoseconds timeout) {
+            std::unique_lock<std::mutex> lock(plan->mutex);
+            while (true) {
+                plan->work_cv.wait(lock, [&plan]() { return plan->stop || !plan->ready.empty(); });
+                if (plan->ready.empty()) return;
+                const size_t index = plan->PopReady_UNLOCKED();
+                Node& node = plan->nodes[index];
+                node.state = NodeState::kRunning;
+                node.worker = std::this_thread::get_id();
+                if (timeout.count() > 0) node.deadline = Clock::now() + timeout;
+                ++plan->running;
+                plan->done_cv.notify_all();  // 新的截止时间
+                lock.unlock();
+
+                std::exception_ptr error = Execute(node);
+
+                lock.lock();
+                node.state = NodeState::kDone;
+                // 超时的服务已由调用线程结算，并补了一个线程：迟到的线程直接退出
+                if (node.abandoned) return;
+                --plan->running;
+                if (error) plan->outcome.errors.push_back(std::move(error));
+                plan->Finish_UNLOCKED(index);
+                plan->work_cv.notify_all();
+                plan->done_cv.notify_all();
+            }
+        }
+    }  // namespace
+
+    ShutdownOutcome RunShutdownPlan(std::vector<ShutdownItem> items, size_t threads, std::chrono::nanoseconds timeout) {
+        auto plan = std::make_shared<Plan>();
+        plan->nodes.resize(items.size());
+        std::unordered_map<ClassId, size_t> index_of;
+        for (size_t i = 0; i < items.size(); ++i) {
+            index_of.emplace(items[i].clsid, i);
+            plan->nodes[i].item = std::move(items[i]);
+        }
+        for (size_t i = 0; i < plan->nodes.size(); ++i) {
+            for (ClassId dep : plan->nodes[i].item.dependencies) {
+                auto it = index_of.find(dep);
+                if (it == index_of.end() || it->second == i) continue;
+                plan->nodes[i].releases.push_back(it->second);
+                ++plan->nodes[it->second].waiting;
+            }
+        }
+        plan->remaining = plan->nodes.size();
+        for (size_t i = 0; i < plan->nodes.size(); ++i) {
+            if (plan->nodes[i].waiting == 0) plan->MakeReady_UNLOCKED(i);
+        }
+        plan->BreakCycle_UNLOCKED();
+
+        // 单线程且不限时：直接在调用线程上按序执行
+        threads = std::min(std::max<size_t>(threads, 1), std::max<size_t>(plan->nodes.size(), 1));
+        if (threads == 1 && timeout.count() <= 0) {
+            while (plan->remaining > 0) {
+                const size_t index = plan->PopReady_UNLOCKED();
+                if (std::exception_ptr error = Execute(plan->nodes[index])) plan->outcome.errors.push_back(std::move(error));
+                plan->nodes[index].state = NodeState::kDone;
+                plan->Finish_UNLOCKED(index);
+            }
+            return std::move(plan->outcome);
+        }
+
+        // Shutdown 在临时线程上执行：继承调用方绑定的框架实例 (独立实例)
+        const ThreadBinding binding = CaptureThreadBinding();
+        std::vector<std::thread> workers;
+        auto spawn = [&workers, &plan, &binding, timeout]() {
+            workers.emplace_back([plan, binding, timeout]() {
+                BindCurrentThread(binding);
+                WorkerLoop(plan, timeout);
+            });
+        };
+        std::unique_lock<std::mutex> lock(plan->mutex);
+        for (size_t t = 0; t < threads; ++t) spawn();
+        while (plan->remaining > 0) {
+            if (timeout.count() <= 0) {
+                plan->done_cv.wait(lock, [&plan]() { return plan->remaining == 0; });
+                break;
+            }
+            // 等到最早的截止时间；到期的服务视为结束，并补一个线程顶替被卡住的那个
+            Clock::time_point earliest = Clock::time_point::max();
+            for (const Node& node : plan->nodes) {
+                if (node.state == NodeState::kRunning && !node.abandoned) earliest = std::min(earliest, node.deadline);
+            }
+            if (earliest == Clock::time_point::max()) {
+                plan->done_cv.wait(lock);
+                continue;
+            }
+            plan->done_cv.wait_until(lock, earliest);
+            const Clock::time_point now = Clock::now();
+            for (size_t i = 0; i < plan->nodes.size(); ++i) {
+                Node& node = plan->nodes[i];
+                if (node.state != NodeState::kRunning || node.abandoned || node.deadline > now) continue;
+                node.abandoned = true;
+                --plan->running;
+                plan->outcome.timed_out.push_back(node.item.clsid);
+                plan->Finish_UNLOCKED(i);
+                spawn();
+            }
+            plan->work_cv.notify_all();
+        }
+        plan->stop = true;
+        plan->work_cv.notify_all();
+
+        // 仍卡在超时服务里的线程被分离 (它们持有 plan)；其余线程已空闲，可以 join
+        std::vector<std::thread::id> stuck;
+        for (const Node& node : plan->nodes) {
+            if (node.abandoned && node.state == NodeState::kRunning) stuck.push_back(node.worker);
+        }
+        ShutdownOutcome outcome = std::move(plan->outcome);
+        lock.unlock();
+        for (auto& worker : workers) {
+            if (std::find(stuck.begin(), stuck.end(), worker.get_id()) != stuck.end()) worker.detach();
+            else worker.join();
+        }
+        return outcome;
+    }
+
+}  // namespace z3y
@@ -0,0 +1,81 @@
+﻿/*
+* Copyright [2025] [Yue Liu]
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/**
+ * @file shutdown_scheduler.h
+ * @brief [内部] 卸载全部插件时按依赖图调度单例的 `Shutdown()`。
+ *
+ * @details
+ * [受众：框架维护者]
+ *
+ * - 依赖图取自单例构造时记录的 `SingletonHolder::dependencies` (Initialize 期间获取的其他单例)：
+ * 一个服务只有在所有依赖它的服务都 Shutdown 之后才会 Shutdown。
+ * 依赖关系来自嵌套构造，被依赖者总是先完成构造，因此图中不会有环；万一出现，按原顺序强行推进。
+ * - 同时就绪的服务按传入顺序 (逆序加载的库) 取出。单线程且不限时时直接在调用线程上执行，
+ * 与旧版串行 Shutdown 的线程语义一致。
+ * - 多线程或设置了超时时，Shutdown 在临时工作线程上执行 (不使用共享执行器：Shutdown 常常要等待自己投递给它的任务)。
+ * 超时的服务视为已结束：释放它的依赖、补一个工作线程，它所在的线程最终被分离。
+ * 调度状态由共享指针持有，分离的线程晚些返回也不会访问已释放的内存。
+ */
+
+#pragma once
+
+#ifndef Z3Y_SRC_PLUGIN_MANAGER_SHUTDOWN_SCHEDULER_H_
+#define Z3Y_SRC_PLUGIN_MANAGER_SHUTDOWN_SCHEDULER_H_
+
+#include <chrono>
+#include <exception>
+#include <memory>
+#include <string>
+#include <vector>
+#include "framework/allocation_account.h"
+#include "framework/class_id.h"
+#include "framework/i_component.h"
+
+namespace z3y {
+
+    /**
+     * @struct ShutdownItem
+     * @brief [内部] 待 Shutdown 的一个单例。
+     */
+    struct ShutdownItem {
+        ClassId clsid = 0;
+        std::string alias;
+        PluginPtr<IComponent> instance;
+        std::vector<ClassId> dependencies;  //!< 它在 Initialize 期间获取的其他单例 (不在本批中的被忽略)
+        std::shared_ptr<AllocationAccount> account;  //!< 所属插件的账户 (Shutdown 的 CPU 时间记入其中，可为空)
+    };
+
+    /**
+     * @struct ShutdownOutcome
+     * @brief [内部] 一次调度的结果。异常与超时由调用方 (在调用线程上) 上报。
+     */
+    struct ShutdownOutcome {
+        std::vector<std::exception_ptr> errors;  //!< 按完成顺序收集的 Shutdown 异常
+        std::vector<ClassId> timed_out;          //!< 超时后仍未返回的服务
+    };
+
+    /**
+     * @brief 按依赖图执行 `items` 的 Shutdown。
+     * @param threads 并行线程数 (至少 1)。
+     * @param timeout 单个服务的超时；0 表示一直等待。
+     * @details 返回时所有服务要么已经返回，要么记入 `timed_out` (其线程已被分离)。
+     */
+    ShutdownOutcome RunShutdownPlan(std::vector<ShutdownItem> items, size_t threads, std::chrono::nanoseconds timeout);
+
+}  // namespace z3y
+
+#endif  // Z3Y_SRC_PLUGIN_MANAGER_SHUTDOWN_SCHEDULER_H_
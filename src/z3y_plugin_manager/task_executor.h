@@ -0,0 +1,467 @@
+﻿/*
+* Copyright [2025] [Yue Liu]
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/**
+ * @file task_executor.h
+ * @brief [私有头文件] `IExecutorService` 背后的共享线程池。
+ *
+ * @details
+ * [受众：框架维护者]
+ *
+ * **结构:**
+ * - 每个优先级一条就绪队列，由一把互斥锁保护。投递的多是落盘、整理之类的粗粒度任务，
+ * 中心队列足够，不做工作窃取；细粒度、高频的事件派发仍走派发线程各自的无锁队列。
+ * - 定时器是一个按到期时间排序的 multimap。不单独起定时线程：空闲的工作线程中
+ * 恰好有一个 (`timer_waiter_`) 以最早到期时间做 `wait_until`，其余的普通等待；
+ * 到期的定时器在锁内转入就绪队列。
+ * - 串行队列 (`Strand`) 自己保存任务，同一时刻只有一个 “排空” 任务在池上运行，
+ * 每轮最多执行 `kSerialBatch` 个后重新入队，避免长队列霸占一个线程。投递端无锁，
+ * 具名队列与 `MakeStrand` 的匿名 strand 是同一种对象，只是前者常驻在名字表里。
+ * - 工作线程在第一次投递时才创建，从不使用执行器的宿主不会多出任何线程。
+ */
+
+#pragma once
+
+#ifndef Z3Y_SRC_PLUGIN_MANAGER_TASK_EXECUTOR_H_
+#define Z3Y_SRC_PLUGIN_MANAGER_TASK_EXECUTOR_H_
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "framework/i_executor_service.h"
+
+namespace z3y {
+
+    /**
+     * @class TaskExecutor
+     * @brief 优先级就绪队列 + 定时器 + 串行队列 (strand)。必须由 `std::shared_ptr` 持有。
+     */
+    class TaskExecutor : public std::enable_shared_from_this<TaskExecutor> {
+    public:
+        using Clock = std::chrono::steady_clock;
+        /** @brief 任务异常的上报通道。参数为 nullptr 表示非 std::exception。 */
+        using ExceptionSink = std::function<void(const std::exception*)>;
+
+        /** @brief 串行队列每轮排空最多执行的任务数。 */
+        static constexpr size_t kSerialBatch = 64;
+
+        /** @brief 工作线程启动时在该线程上调用 (参数为线程序号)，用于线程放置。 */
+        using ThreadStartHook = std::function<void(size_t worker_index)>;
+
+        TaskExecutor(size_t worker_count, ExceptionSink sink, ThreadStartHook on_thread_start = {})
+            : worker_count_(worker_count > 0 ? worker_count
+                : std::max<size_t>(2, std::thread::hardware_concurrency())),
+            sink_(std::move(sink)), on_thread_start_(std::move(on_thread_start)) {}
+
+        ~TaskExecutor() { Stop(); }
+
+        TaskExecutor(const TaskExecutor&) = delete;
+        TaskExecutor& operator=(const TaskExecutor&) = delete;
+
+        bool Post(std::function<void()> task, TaskPriority priority) {
+            return Enqueue(std::move(task), priority, nullptr);
+        }
+
+        TimerId PostDelayed(std::chrono::nanoseconds delay, std::function<void()> task,
+            TaskPriority priority) {
+            if (!task) return 0;
+            const auto due = Clock::now() + std::max(delay, std::chrono::nanoseconds(0));
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (stopped_) return 0;
+            EnsureStarted_UNLOCKED();
+            const TimerId id = next_timer_++;
+            const bool earliest = timer_queue_.empty() || due < timer_queue_.begin()->first;
+            auto pos = timer_queue_.emplace(due, id);
+            timers_.emplace(id, Timer{ std::move(task), priority, pos });
+            if (!earliest) return id;  // 等待中的线程醒来的时间不受影响
+            // 正在定时等待的线程必须按新的最早时间重新等待；普通等待者醒来后会再睡回去
+            if (timer_waiter_) cv_.notify_all();
+            else cv_.notify_one();
+            return id;
+        }
+
+        bool CancelTimer(TimerId id) {
+            std::function<void()> discarded;  // 在锁外析构：闭包里可能持有任意对象
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                auto it = timers_.find(id);
+                if (it == timers_.end()) return false;
+                discarded = std::move(it->second.func);
+                timer_queue_.erase(it->second.position);
+                timers_.erase(it);
+            }
+            return true;
+        }
+
+        std::shared_ptr<IEventExecutor> GetSerialQueue(const std::string& name) {
+            std::lock_guard<std::mutex> lock(serial_mutex_);
+            auto& queue = serial_queues_[name];
+            if (!queue) queue = std::make_shared<Strand>(weak_from_this());
+            return queue;
+        }
+
+        std::shared_ptr<IEventExecutor> MakeStrand() {
+            return std::make_shared<Strand>(weak_from_this());
+        }
+
+        [[nodiscard]] size_t WorkerCount() const { return worker_count_; }
+
+        [[nodiscard]] ExecutorStats Stats() const {
+            ExecutorStats stats;
+            stats.worker_count = worker_count_;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stats.queued_tasks = ready_count_;
+                stats.pending_timers = timers_.size();
+            }
+            {
+                std::lock_guard<std::mutex> lock(serial_mutex_);
+                stats.serial_queues = serial_queues_.size();
+            }
+            stats.active_tasks = active_.load(std::memory_order_relaxed);
+            stats.executed_tasks = executed_.load(std::memory_order_relaxed);
+            stats.failed_tasks = failed_.load(std::memory_order_relaxed);
+            stats.max_queue_wait_ns = max_wait_ns_.load(std::memory_order_relaxed);
+            return stats;
+        }
+
+        /** @brief 当前线程是否是本执行器的工作线程。 */
+        [[nodiscard]] bool IsWorkerThread() const {
+            std::lock_guard<std::mutex> lock(mutex_);
+            const auto self = std::this_thread::get_id();
+            return std::any_of(workers_.begin(), workers_.end(),
+                [&](const std::thread& t) { return t.get_id() == self; });
+        }
+
+        /**
+         * @brief 丢弃所有尚未开始的任务 (含定时器与所有串行队列中的积压)，并等待正在执行的任务结束。
+         * @details 卸载插件库之前调用：排队的闭包可能指向即将卸载的代码。执行器继续可用。
+         * 在工作线程上调用时只丢弃、不等待。
+         */
+        void DiscardPendingAndWait() {
+            const bool on_worker = IsWorkerThread();
+            // 正在执行的任务可能又投递了新任务：等它们结束后再丢弃一轮
+            for (int pass = 0; pass < 2; ++pass) {
+                DiscardPending();
+                if (on_worker) return;
+                std::unique_lock<std::mutex> lock(mutex_);
+                idle_cv_.wait(lock, [this] { return running_tasks_ == 0; });
+            }
+        }
+
+        /** @brief 停止并 join 所有工作线程。未开始的任务与定时器被丢弃，之后的投递全部失败。 */
+        void Stop() {
+            std::vector<std::thread> workers;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (stopped_) return;
+                stopped_ = true;
+                workers.swap(workers_);
+            }
+            cv_.notify_all();
+            const auto self = std::this_thread::get_id();
+            for (auto& worker : workers) {
+                if (worker.get_id() == self) worker.detach();  // 不能 join 自己
+                else if (worker.joinable()) worker.join();
+            }
+            DiscardPending();
+        }
+
+    private:
+        class Strand;
+
+        struct ReadyTask {
+            std::function<void()> func;
+            Clock::time_point ready_at;
+            /** @brief 非空表示这是该串行队列的排空任务：不计入统计 (其中的每个任务单独计数) */
+            Strand* serial = nullptr;
+        };
+        struct Timer {
+            std::function<void()> func;
+            TaskPriority priority;
+            std::multimap<Clock::time_point, TimerId>::iterator position;
+        };
+
+        /**
+         * @class Strand
+         * @brief 串行队列：任务在池上一次一个、按投递顺序执行，由取到排空任务的任意工作线程执行。
+         *
+         * @details
+         * - 投递端无锁：任务节点以 CAS 压入原子单链表 `inbox_` (后进先出)；
+         * 排空端一次取走整条链并反转到 `pending_` (只有排空者访问)，恢复投递顺序。
+         * - `scheduled_` 保证同一时刻最多一个排空任务在池上。排空者发现没有任务时先清标记再复查 `inbox_`，
+         * 与并发投递者之间由 `exchange` 决出唯一的调度者，任务不会被遗漏。
+         * - 节点记下投递时执行器的丢弃纪元；`DiscardPending` 递增纪元后，旧任务在排空时直接析构而不执行，
+         * 因此丢弃积压不需要与排空者同步。
+         */
+        class Strand : public IEventExecutor,
+            public std::enable_shared_from_this<Strand> {
+        public:
+            explicit Strand(std::weak_ptr<TaskExecutor> owner) : owner_(std::move(owner)) {}
+
+            ~Strand() override {
+                FreeList(inbox_.exchange(nullptr));
+                FreeList(pending_);
+            }
+
+            void Post(std::function<void()> task) override {
+                if (!task) return;
+                auto owner = owner_.lock();
+                if (!owner) return;
+                Node* node = new Node{ std::move(task), owner->discard_epoch_.load(std::memory_order_acquire), nullptr };
+                Node* head = inbox_.load(std::memory_order_relaxed);
+                do {
+                    node->next = head;
+                } while (!inbox_.compare_exchange_weak(head, node));
+                if (!scheduled_.exchange(true)) Schedule(*owner);
+            }
+
+            /** @brief 本队列排队中的排空任务被执行器丢弃：调度标记仍归本队列，重新调度一次以清理积压。 */
+            void OnDrainDiscarded() {
+                if (auto owner = owner_.lock()) Schedule(*owner);
+            }
+
+        private:
+            struct Node {
+                std::function<void()> func;
+                uint64_t epoch;
+                Node* next;
+            };
+
+            static void FreeList(Node* node) {
+                while (node) {
+                    Node* next = node->next;
+                    delete node;
+                    node = next;
+                }
+            }
+
+            static Node* Reverse(Node* node) {
+                Node* out = nullptr;
+                while (node) {
+                    Node* next = node->next;
+                    node->next = out;
+                    out = node;
+                    node = next;
+                }
+                return out;
+            }
+
+            void Schedule(TaskExecutor& owner) {
+                // 执行器已停止时投递失败：标记保持置位，之后的投递也不再调度，节点随队列析构释放
+                owner.Enqueue([self = shared_from_this()] { self->Drain(); }, TaskPriority::kNormal, this);
+            }
+
+            void Drain() {
+                auto owner = owner_.lock();
+                if (!owner) return;
+                for (size_t executed = 0; executed < kSerialBatch;) {
+                    if (!pending_) {
+                        pending_ = Reverse(inbox_.exchange(nullptr));
+                        if (!pending_) {
+                            scheduled_.store(false);
+                            // 清标记之前到达的任务：若投递者没能抢到调度权，由本排空者继续
+                            if (!inbox_.load() || scheduled_.exchange(true)) return;
+                            continue;
+                        }
+                    }
+                    Node* node = pending_;
+                    pending_ = node->next;
+                    if (node->epoch == owner->discard_epoch_.load(std::memory_order_acquire)) {
+                        owner->Invoke(node->func);
+                        ++executed;
+                    }
+                    delete node;  // 闭包在这里析构 (被丢弃的任务也一样)
+                }
+                Schedule(*owner);  // 还有积压：让出线程，排到就绪队列末尾
+            }
+
+            std::weak_ptr<TaskExecutor> owner_;
+            std::atomic<Node*> inbox_{ nullptr };
+            Node* pending_ = nullptr;             //!< 已按投递顺序排好的任务 (只有排空者访问)
+            std::atomic<bool> scheduled_{ false }; //!< 是否已有排空任务在池上 (排队或执行中)
+        };
+
+        bool Enqueue(std::function<void()> task, TaskPriority priority, Strand* serial) {
+            if (!task) return false;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (stopped_) return false;
+                EnsureStarted_UNLOCKED();
+                ready_[static_cast<size_t>(priority)].push_back(
+                    ReadyTask{ std::move(task), Clock::now(), serial });
+                ++ready_count_;
+            }
+            cv_.notify_one();
+            return true;
+        }
+
+        void EnsureStarted_UNLOCKED() {
+            if (!workers_.empty()) return;
+            workers_.reserve(worker_count_);
+            for (size_t i = 0; i < worker_count_; ++i) {
+                workers_.emplace_back(&TaskExecutor::WorkerLoop, this, i);
+            }
+        }
+
+        /** @brief 把已到期的定时器转入就绪队列。须持有 mutex_。 */
+        void PromoteDueTimers_UNLOCKED(Clock::time_point now) {
+            while (!timer_queue_.empty() && timer_queue_.begin()->first <= now) {
+                auto node = timer_queue_.begin();
+                auto it = timers_.find(node->second);
+                ready_[static_cast<size_t>(it->second.priority)].push_back(
+                    ReadyTask{ std::move(it->second.func), node->first, nullptr });
+                ++ready_count_;
+                timers_.erase(it);
+                timer_queue_.erase(node);
+            }
+        }
+
+        void WorkerLoop(size_t worker_index) {
+            if (on_thread_start_) on_thread_start_(worker_index);
+            std::unique_lock<std::mutex> lock(mutex_);
+            for (;;) {
+                if (stopped_) return;
+                PromoteDueTimers_UNLOCKED(Clock::now());
+                if (ready_count_ == 0) {
+                    if (!timer_queue_.empty() && !timer_waiter_) {
+                        timer_waiter_ = true;
+                        cv_.wait_until(lock, timer_queue_.begin()->first);
+                        timer_waiter_ = false;
+                    } else {
+                        cv_.wait(lock);
+                    }
+                    continue;
+                }
+
+                ReadyTask task;
+                for (auto& queue : ready_) {
+                    if (queue.empty()) continue;
+                    task = std::move(queue.front());
+                    queue.pop_front();
+                    break;
+                }
+                --ready_count_;
+                ++running_tasks_;
+                // 本线程要去执行任务了：仍有未到期的定时器时，把定时等待的职责交给一个空闲线程
+                if (!timer_queue_.empty() && !timer_waiter_) cv_.notify_one();
+                lock.unlock();
+
+                Run(task);
+
+                lock.lock();
+                if (--running_tasks_ == 0) idle_cv_.notify_all();
+            }
+        }
+
+        void Run(ReadyTask& task) {
+            const auto start = Clock::now();
+            const uint64_t wait_ns = static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(start - task.ready_at).count());
+            uint64_t prev = max_wait_ns_.load(std::memory_order_relaxed);
+            while (wait_ns > prev &&
+                !max_wait_ns_.compare_exchange_weak(prev, wait_ns, std::memory_order_relaxed)) {
+            }
+            active_.fetch_add(1, std::memory_order_relaxed);
+            if (task.serial) {
+                task.func();  // 排空任务自己逐个 Invoke，不会抛出
+            } else {
+                Invoke(task.func);
+            }
+            task.func = nullptr;  // 闭包在计数归还之前析构
+            active_.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        /** @brief 执行一个用户任务：捕获并上报异常，更新计数。 */
+        void Invoke(std::function<void()>& func) {
+            try {
+                func();
+            } catch (const std::exception& e) {
+                failed_.fetch_add(1, std::memory_order_relaxed);
+                if (sink_) sink_(&e);
+            } catch (...) {
+                failed_.fetch_add(1, std::memory_order_relaxed);
+                if (sink_) sink_(nullptr);
+            }
+            executed_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void DiscardPending() {
+            // 先递增纪元：此前投递到任何串行队列 (具名或匿名) 的任务都不会再执行
+            discard_epoch_.fetch_add(1, std::memory_order_acq_rel);
+            std::deque<ReadyTask> ready[kTaskPriorityCount];
+            std::unordered_map<TimerId, Timer> timers;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                for (size_t i = 0; i < kTaskPriorityCount; ++i) ready[i].swap(ready_[i]);
+                ready_count_ = 0;
+                timers.swap(timers_);
+                timer_queue_.clear();
+            }
+            // 被丢弃的排空任务永远不会执行：交还给各自的串行队列重新调度，由它析构纪元已过期的积压
+            // (闭包持有队列的 shared_ptr，期间队列一定存活)
+            for (auto& queue : ready) {
+                for (auto& task : queue) {
+                    if (task.serial) task.serial->OnDrainDiscarded();
+                }
+            }
+        }
+
+        const size_t worker_count_;
+        const ExceptionSink sink_;
+        const ThreadStartHook on_thread_start_;
+
+        mutable std::mutex mutex_;
+        std::condition_variable cv_;       //!< 有新任务、定时器提前或停止
+        std::condition_variable idle_cv_;  //!< running_tasks_ 归零
+        bool stopped_ = false;
+        bool timer_waiter_ = false;        //!< 是否已有线程在按最早到期时间定时等待
+        std::vector<std::thread> workers_;
+        std::deque<ReadyTask> ready_[kTaskPriorityCount];
+        size_t ready_count_ = 0;
+        size_t running_tasks_ = 0;
+        std::multimap<Clock::time_point, TimerId> timer_queue_;
+        std::unordered_map<TimerId, Timer> timers_;
+        TimerId next_timer_ = 1;
+
+        mutable std::mutex serial_mutex_;
+        std::unordered_map<std::string, std::shared_ptr<Strand>> serial_queues_;
+        std::atomic<uint64_t> discard_epoch_{ 0 };  //!< `DiscardPending` 的次数，串行队列据此丢弃旧任务
+
+        std::atomic<size_t> active_{ 0 };
+        std::atomic<uint64_t> executed_{ 0 };
+        std::atomic<uint64_t> failed_{ 0 };
+        std::atomic<uint64_t> max_wait_ns_{ 0 };
+    };
+
+}  // namespace z3y
+
+#endif  // Z3Y_SRC_PLUGIN_MANAGER_TASK_EXECUTOR_H_
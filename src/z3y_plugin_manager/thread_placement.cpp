@@ -0,0 +1,133 @@
+﻿/*
+* Copyright [2025] [Yue Liu]
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/**
+ * @file thread_placement.cpp
+ * @brief [内部] 线程放置策略与 NUMA 拓扑查询的平台无关部分，以及 `PluginManager::FindThreadPlacement`。
+ */
+
+#include "framework/thread_placement.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include "platform_threads.h"
+#include "plugin_manager_pimpl.h"
+
+namespace z3y {
+
+    namespace {
+        /** @brief 进程内只读取一次的 NUMA 拓扑。 */
+        struct NumaTopology {
+            std::vector<std::vector<int>> nodes;  //!< 节点 -> 逻辑 CPU (至少一个节点)
+            std::vector<uint16_t> node_of_cpu;    //!< 逻辑 CPU -> 节点
+        };
+
+        const NumaTopology& Topology() {
+            static const NumaTopology topology = [] {
+                NumaTopology t;
+                t.nodes = PlatformReadNumaTopology();
+                if (t.nodes.empty()) {
+                    // 拓扑不可读：单节点，包含所有 CPU
+                    t.nodes.emplace_back();
+                    const unsigned cpus = std::max(1u, std::thread::hardware_concurrency());
+                    for (unsigned cpu = 0; cpu < cpus; ++cpu) t.nodes[0].push_back(static_cast<int>(cpu));
+                }
+                for (size_t node = 0; node < t.nodes.size(); ++node) {
+                    std::sort(t.nodes[node].begin(), t.nodes[node].end());
+                    for (int cpu : t.nodes[node]) {
+                        if (cpu < 0) continue;
+                        if (static_cast<size_t>(cpu) >= t.node_of_cpu.size()) t.node_of_cpu.resize(cpu + 1, 0);
+                        t.node_of_cpu[cpu] = static_cast<uint16_t>(node);
+                    }
+                }
+                return t;
+            }();
+            return topology;
+        }
+    }  // namespace
+
+    bool ApplyThreadPlacement(const ThreadPlacement& placement, size_t thread_index) {
+        bool ok = true;
+        std::vector<int> candidates;
+        bool restrict_cpus = false;
+        size_t pin_slot = thread_index;  // 同一节点上的线程依次分到不同的 CPU
+        if (!placement.numa_nodes.empty()) {
+            const int node = placement.numa_nodes[thread_index % placement.numa_nodes.size()];
+            pin_slot = thread_index / placement.numa_nodes.size();
+            if (node >= 0) candidates = GetNumaNodeCpus(static_cast<size_t>(node));
+            if (!placement.cpus.empty()) {
+                candidates.erase(std::remove_if(candidates.begin(), candidates.end(), [&](int cpu) {
+                    return std::find(placement.cpus.begin(), placement.cpus.end(), cpu) == placement.cpus.end();
+                    }), candidates.end());
+            }
+            restrict_cpus = true;
+        } else if (!placement.cpus.empty()) {
+            candidates = placement.cpus;
+            restrict_cpus = true;
+        }
+        if (restrict_cpus) {
+            if (candidates.empty()) {
+                ok = false;  // 节点不存在，或与 cpus 没有交集
+            } else {
+                if (placement.pin_each_thread) candidates = { candidates[pin_slot % candidates.size()] };
+                ok = PlatformSetThreadAffinity(candidates);
+            }
+        }
+        if (placement.priority != ThreadPriority::kDefault &&
+            !PlatformSetThreadPriority(placement.priority, placement.realtime_priority)) {
+            ok = false;
+        }
+        return ok;
+    }
+
+    bool PlaceCurrentThread(std::string_view role, size_t thread_index) {
+        auto manager = PluginManager::GetActiveInstance();
+        if (!manager) return true;
+        const ThreadPlacement* placement = manager->FindThreadPlacement(role);
+        return !placement || ApplyThreadPlacement(*placement, thread_index);
+    }
+
+    size_t GetNumaNodeCount() noexcept {
+        return Topology().nodes.size();
+    }
+
+    std::vector<int> GetNumaNodeCpus(size_t node) {
+        const NumaTopology& topology = Topology();
+        return node < topology.nodes.size() ? topology.nodes[node] : std::vector<int>();
+    }
+
+    int GetCurrentCpu() noexcept {
+        return PlatformCurrentCpu();
+    }
+
+    size_t GetCurrentNumaNode() noexcept {
+        const NumaTopology& topology = Topology();
+        if (topology.nodes.size() == 1) return 0;
+        const int cpu = PlatformCurrentCpu();
+        if (cpu < 0 || static_cast<size_t>(cpu) >= topology.node_of_cpu.size()) return 0;
+        return topology.node_of_cpu[cpu];
+    }
+
+    // --- PluginManager: 线程放置配置 (Create 时写入，之后只读) ---
+
+    const ThreadPlacement* PluginManager::FindThreadPlacement(std::string_view role) const {
+        auto it = pimpl_->thread_placements_.find(std::string(role));
+        return it != pimpl_->thread_placements_.end() ? &it->second : nullptr;
+    }
+
+}  // namespace z3y
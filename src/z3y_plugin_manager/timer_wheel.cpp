@@ -0,0 +1,384 @@
+﻿/*
+* Copyright [2025] [Yue Liu]
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/**
+ * @file timer_wheel.cpp
+ * @brief [内部] 分层时间轮的实现，以及 `PluginManager` 中关于 `ITimerService` 的部分。
+ */
+
+#include "timer_wheel.h"
+
+#include <algorithm>
+#include <utility>
+#include "plugin_manager_pimpl.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace z3y {
+
+    namespace {
+        constexpr uint64_t kSlotMask = TimerWheel::kSlotsPerLevel - 1;
+        /** @brief 整个时间轮能直接表示的最远距离 (刻度)。 */
+        constexpr uint64_t kWheelSpan = uint64_t(1) << (TimerWheel::kLevelBits * TimerWheel::kLevels);
+
+        int CountTrailingZeros(uint64_t bits) {
+#if defined(_MSC_VER)
+            unsigned long index = 0;
+            _BitScanForward64(&index, bits);
+            return static_cast<int>(index);
+#else
+            return __builtin_ctzll(bits);
+#endif
+        }
+
+        TimerId MakeTimerId(uint32_t generation, uint32_t index) {
+            return (static_cast<uint64_t>(generation) << 32) | (static_cast<uint64_t>(index) + 1);
+        }
+    }  // namespace
+
+    TimerWheel::TimerWheel(TaskExecutor* executor, std::chrono::nanoseconds tick, TaskExecutor::ExceptionSink sink)
+        : executor_(executor),
+        tick_(std::max(tick, std::chrono::nanoseconds(std::chrono::microseconds(1)))),
+        epoch_(Clock::now()),
+        sink_(std::move(sink)) {
+        for (auto& level : heads_) std::fill(std::begin(level), std::end(level), kNil);
+    }
+
+    TimerWheel::~TimerWheel() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (wake_timer_ != 0) executor_->CancelTimer(wake_timer_);
+    }
+
+    uint64_t TimerWheel::TickAtOrAfter(Clock::time_point t) const {
+        const auto d = t - epoch_;
+        if (d <= Clock::duration::zero()) return 0;
+        const uint64_t ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(d).count());
+        const uint64_t tick = static_cast<uint64_t>(tick_.count());
+        return (ns + tick - 1) / tick;
+    }
+
+    uint64_t TimerWheel::TickBefore(Clock::time_point t) const {
+        const auto d = t - epoch_;
+        if (d <= Clock::duration::zero()) return 0;
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(d).count()) /
+            static_cast<uint64_t>(tick_.count());
+    }
+
+    uint64_t TimerWheel::AlignExpire(uint64_t expire, uint64_t align) const {
+        if (align <= 1) return expire;
+        return (expire + align - 1) & ~(align - 1);
+    }
+
+    void TimerWheel::Link_UNLOCKED(uint32_t index, uint64_t min_expire) {
+        Node& n = nodes_[index];
+        n.expire = std::max(n.expire, min_expire);
+        const uint64_t delta = n.expire - current_;
+        int level = 0;
+        while (level < kLevels - 1 && delta >= (uint64_t(1) << (kLevelBits * (level + 1)))) ++level;
+        // 超出整个时间轮的定时器先放在最高层最远的槽，降级时按真实到期刻度重新放置
+        const uint64_t slot_tick = delta >= kWheelSpan ? current_ + kWheelSpan - 1 : n.expire;
+        const uint32_t slot = static_cast<uint32_t>((slot_tick >> (kLevelBits * level)) & kSlotMask);
+
+        n.prev = kNil;
+        n.next = heads_[level][slot];
+        if (n.next != kNil) nodes_[n.next].prev = index;
+        heads_[level][slot] = index;
+        occupied_[level][slot >> 6] |= uint64_t(1) << (slot & 63);
+        n.level = static_cast<uint16_t>(level);
+        n.slot = static_cast<uint16_t>(slot);
+        n.linked = true;
+    }
+
+    void TimerWheel::Unlink_UNLOCKED(uint32_t index) {
+        Node& n = nodes_[index];
+        if (n.prev != kNil) nodes_[n.prev].next = n.next;
+        else heads_[n.level][n.slot] = n.next;
+        if (n.next != kNil) nodes_[n.next].prev = n.prev;
+        if (heads_[n.level][n.slot] == kNil) {
+            occupied_[n.level][n.slot >> 6] &= ~(uint64_t(1) << (n.slot & 63));
+        }
+        n.prev = n.next = kNil;
+        n.linked = false;
+    }
+
+    void TimerWheel::Free_UNLOCKED(uint32_t index, Expired& discarded) {
+        Node& n = nodes_[index];
+        discarded.once = std::move(n.once);
+        discarded.repeating = std::move(n.repeating);
+        discarded.executor = std::move(n.executor);
+        n.once = nullptr;
+        n.linked = false;
+        if (++n.generation == 0) n.generation = 1;  // 句柄中代数为 0 的值保留给“无效”
+        free_nodes_.push_back(index);
+        --active_;
+    }
+
+    TimerWheel::Node* TimerWheel::Find_UNLOCKED(TimerId id) {
+        const uint64_t low = id & 0xFFFFFFFFu;
+        if (low == 0 || low > nodes_.size()) return nullptr;
+        Node& n = nodes_[static_cast<size_t>(low - 1)];
+        if (!n.linked || n.generation != static_cast<uint32_t>(id >> 32)) return nullptr;
+        return &n;
+    }
+
+    bool TimerWheel::NextOccupied_UNLOCKED(uint64_t from, uint64_t to, uint64_t& tick) const {
+        if (from > to) return false;
+        const uint32_t first = static_cast<uint32_t>(from & kSlotMask);
+        const uint32_t last = static_cast<uint32_t>(to & kSlotMask);
+        for (uint32_t word = first >> 6; word <= (last >> 6); ++word) {
+            uint64_t bits = occupied_[0][word];
+            if (word == (first >> 6)) bits &= ~uint64_t(0) << (first & 63);
+            if (word == (last >> 6) && (last & 63) != 63) bits &= (uint64_t(1) << ((last & 63) + 1)) - 1;
+            if (bits != 0) {
+                tick = (from & ~kSlotMask) + word * 64 + static_cast<uint64_t>(CountTrailingZeros(bits));
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void TimerWheel::Cascade_UNLOCKED() {
+        for (int level = 1; level < kLevels; ++level) {
+            const uint32_t slot = static_cast<uint32_t>((current_ >> (kLevelBits * level)) & kSlotMask);
+            uint32_t index = heads_[level][slot];
+            heads_[level][slot] = kNil;
+            occupied_[level][slot >> 6] &= ~(uint64_t(1) << (slot & 63));
+            while (index != kNil) {
+                const uint32_t next = nodes_[index].next;
+                Link_UNLOCKED(index, current_);
+                ++cascaded_;
+                index = next;
+            }
+            if (slot != 0) break;  // 上一层的边界还没到
+        }
+    }
+
+    void TimerWheel::CollectSlot_UNLOCKED(uint32_t slot, uint64_t target, std::vector<Expired>& expired) {
+        uint32_t index = heads_[0][slot];
+        while (index != kNil) {
+            const uint32_t next = nodes_[index].next;
+            Node& n = nodes_[index];
+            Unlink_UNLOCKED(index);
+            ++fired_;
+            if (n.period != 0) {
+                expired.push_back(Expired{ nullptr, n.repeating, n.executor, n.priority });
+                // 按计划时间推进；落后 (唤醒迟到) 时跳过错过的周期，不在同一次推进中补发
+                uint64_t due = n.expire + n.period;
+                if (due <= target) due += ((target - due) / n.period + 1) * n.period;
+                n.expire = due;
+                Link_UNLOCKED(index, current_ + 1);
+            } else {
+                Expired e{ nullptr, nullptr, nullptr, n.priority };
+                Free_UNLOCKED(index, e);
+                expired.push_back(std::move(e));
+            }
+            index = next;
+        }
+    }
+
+    void TimerWheel::Advance_UNLOCKED(uint64_t target, std::vector<Expired>& expired) {
+        while (current_ < target) {
+            const uint64_t boundary = (current_ | kSlotMask) + 1;
+            uint64_t next = 0;
+            if (NextOccupied_UNLOCKED(current_ + 1, std::min(target, boundary - 1), next)) {
+                current_ = next;
+            } else {
+                current_ = std::min(target, boundary);
+            }
+            if ((current_ & kSlotMask) == 0) Cascade_UNLOCKED();
+            CollectSlot_UNLOCKED(static_cast<uint32_t>(current_ & kSlotMask), target, expired);
+        }
+    }
+
+    void TimerWheel::Arm_UNLOCKED() {
+        if (active_ == 0) return;  // 残留的唤醒任务到期后发现无事可做，不再续挂
+        const uint64_t boundary = (current_ | kSlotMask) + 1;
+        uint64_t next = boundary;  // 本圈没有到期的，就在圈边界处降级高层轮
+        NextOccupied_UNLOCKED(current_ + 1, boundary - 1, next);
+        if (wake_timer_ != 0 && wake_tick_ <= next) return;
+        if (wake_timer_ != 0) executor_->CancelTimer(wake_timer_);  // 失败说明它已在执行，多唤醒一次无妨
+        const Clock::time_point at = epoch_ + std::chrono::duration_cast<Clock::duration>(tick_ * next);
+        wake_timer_ = executor_->PostDelayed(at - Clock::now(), [this] { OnWake(); }, TaskPriority::kHigh);
+        wake_tick_ = next;
+    }
+
+    TimerId TimerWheel::Start(Clock::time_point due, std::chrono::nanoseconds period,
+        std::function<void()> callback, const TimerOptions& options) {
+        if (!callback) return 0;
+        uint64_t period_ticks = 0;
+        if (period > std::chrono::nanoseconds::zero()) {
+            period_ticks = std::max<uint64_t>(1, static_cast<uint64_t>((period.count() + tick_.count() - 1) / tick_.count()));
+        }
+        uint64_t align = 1;
+        const uint64_t slack_ticks = options.slack > std::chrono::nanoseconds::zero()
+            ? static_cast<uint64_t>(options.slack.count() / tick_.count()) : 0;
+        while (align * 2 <= slack_ticks) align *= 2;
+        std::shared_ptr<std::function<void()>> repeating;
+        if (period_ticks != 0) repeating = std::make_shared<std::function<void()>>(std::move(callback));
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        uint32_t index;
+        if (!free_nodes_.empty()) {
+            index = free_nodes_.back();
+            free_nodes_.pop_back();
+        } else {
+            index = static_cast<uint32_t>(nodes_.size());
+            nodes_.emplace_back();
+        }
+        Node& n = nodes_[index];
+        n.expire = AlignExpire(TickAtOrAfter(due), align);
+        n.period = period_ticks;
+        n.align = align;
+        n.priority = options.priority;
+        n.executor = options.executor;
+        if (repeating) n.repeating = std::move(repeating);
+        else n.once = std::move(callback);
+        Link_UNLOCKED(index, current_ + 1);
+        ++active_;
+        ++started_;
+        Arm_UNLOCKED();
+        return MakeTimerId(n.generation, index);
+    }
+
+    bool TimerWheel::Restart(TimerId id, std::chrono::nanoseconds delay) {
+        const Clock::time_point due = Clock::now() + std::max(delay, std::chrono::nanoseconds::zero());
+        std::lock_guard<std::mutex> lock(mutex_);
+        Node* n = Find_UNLOCKED(id);
+        if (!n) return false;
+        const uint32_t index = static_cast<uint32_t>((id & 0xFFFFFFFFu) - 1);
+        Unlink_UNLOCKED(index);
+        n->expire = AlignExpire(TickAtOrAfter(due), n->align);
+        Link_UNLOCKED(index, current_ + 1);
+        Arm_UNLOCKED();
+        return true;
+    }
+
+    bool TimerWheel::Stop(TimerId id) {
+        Expired discarded{ nullptr, nullptr, nullptr, TaskPriority::kNormal };  // 在锁外析构：闭包里可能持有任意对象
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!Find_UNLOCKED(id)) return false;
+        const uint32_t index = static_cast<uint32_t>((id & 0xFFFFFFFFu) - 1);
+        Unlink_UNLOCKED(index);
+        Free_UNLOCKED(index, discarded);
+        return true;
+    }
+
+    void TimerWheel::Clear() {
+        std::vector<Expired> discarded;
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (uint32_t index = 0; index < nodes_.size(); ++index) {
+            if (!nodes_[index].linked) continue;
+            Unlink_UNLOCKED(index);
+            discarded.push_back(Expired{ nullptr, nullptr, nullptr, TaskPriority::kNormal });
+            Free_UNLOCKED(index, discarded.back());
+        }
+        if (wake_timer_ != 0) executor_->CancelTimer(wake_timer_);
+        wake_timer_ = 0;
+    }
+
+    void TimerWheel::OnWake() {
+        std::vector<Expired> expired;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            wake_timer_ = 0;
+            ++wakeups_;
+            Advance_UNLOCKED(TickBefore(Clock::now()), expired);
+            Arm_UNLOCKED();
+        }
+        Dispatch(expired);
+    }
+
+    void TimerWheel::Dispatch(std::vector<Expired>& expired) {
+        if (expired.empty()) return;
+        std::vector<std::function<void()>> lanes[kTaskPriorityCount];
+        for (Expired& e : expired) {
+            std::function<void()> fn = e.once
+                ? std::move(e.once)
+                : std::function<void()>([repeating = std::move(e.repeating)] { (*repeating)(); });
+            if (e.executor) {
+                e.executor->Post(std::move(fn));
+            } else {
+                lanes[static_cast<size_t>(e.priority)].push_back(std::move(fn));
+            }
+        }
+        // 同一刻度到期、同一优先级的回调合并为一个执行器任务
+        for (size_t p = 0; p < kTaskPriorityCount; ++p) {
+            if (lanes[p].empty()) continue;
+            const TaskPriority priority = static_cast<TaskPriority>(p);
+            if (lanes[p].size() == 1) {
+                executor_->Post(std::move(lanes[p].front()), priority);
+                continue;
+            }
+            executor_->Post([this, batch = std::move(lanes[p])]() {
+                for (const auto& fn : batch) {
+                    try {
+                        fn();
+                    } catch (const std::exception& e) {
+                        sink_(&e);
+                    } catch (...) {
+                        sink_(nullptr);
+                    }
+                }
+                }, priority);
+        }
+    }
+
+    TimerServiceStats TimerWheel::Stats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        TimerServiceStats stats;
+        stats.active_timers = active_;
+        stats.started_timers = started_;
+        stats.fired_timers = fired_;
+        stats.wakeups = wakeups_;
+        stats.cascaded_timers = cascaded_;
+        stats.tick_ns = static_cast<uint64_t>(tick_.count());
+        return stats;
+    }
+
+    // --- PluginManager: ITimerService 接口实现 (转发给 Pimpl 持有的 TimerWheel) ---
+
+    TimerId PluginManager::StartOneShot(std::chrono::nanoseconds delay,
+        std::function<void()> callback, const TimerOptions& options) {
+        const auto due = TimerWheel::Clock::now() + std::max(delay, std::chrono::nanoseconds::zero());
+        return pimpl_->timer_wheel_->Start(due, std::chrono::nanoseconds::zero(), std::move(callback), options);
+    }
+
+    TimerId PluginManager::StartPeriodic(std::chrono::nanoseconds period,
+        std::function<void()> callback, const TimerOptions& options) {
+        if (period <= std::chrono::nanoseconds::zero()) return 0;
+        return pimpl_->timer_wheel_->Start(TimerWheel::Clock::now() + period, period, std::move(callback), options);
+    }
+
+    TimerId PluginManager::StartDeadline(std::chrono::steady_clock::time_point deadline,
+        std::function<void()> callback, const TimerOptions& options) {
+        return pimpl_->timer_wheel_->Start(deadline, std::chrono::nanoseconds::zero(), std::move(callback), options);
+    }
+
+    bool PluginManager::RestartTimer(TimerId timer, std::chrono::nanoseconds delay) {
+        return pimpl_->timer_wheel_->Restart(timer, delay);
+    }
+
+    bool PluginManager::StopTimer(TimerId timer) {
+        return pimpl_->timer_wheel_->Stop(timer);
+    }
+
+    TimerServiceStats PluginManager::GetTimerStats() const {
+        return pimpl_->timer_wheel_->Stats();
+    }
+
+}  // namespace z3y
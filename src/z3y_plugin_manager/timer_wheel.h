@@ -0,0 +1,148 @@
+﻿/*
+* Copyright [2025] [Yue Liu]
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/**
+ * @file timer_wheel.h
+ * @brief [内部] `ITimerService` 的实现：由共享执行器驱动的分层时间轮。
+ *
+ * @details
+ * [受众：框架维护者]
+ *
+ * - 4 层 × 256 槽，每层覆盖上一层的 256 倍 (1 ms 刻度时约 49 天)；更远的定时器先放在最高层，
+ * 降级时再按真实到期刻度重新放置。
+ * - 定时器节点放在一个按下标寻址的数组里，槽内是下标串起的双向链表；句柄 = (代数 << 32) | (下标 + 1)，
+ * 因此启动、停止、重新计时都是 O(1)，过期句柄因代数不符而失效。
+ * - 每层一张 256 位占用位图。推进时直接跳到下一个非空槽，空闲时不会逐刻度空转。
+ * - 时间轮自己不占线程：只在共享执行器上挂一个指向“下一个需要处理的刻度”的延迟任务，
+ * 到期的回调按 (执行器, 优先级) 合并投递。
+ *
+ * 所有状态由一把互斥锁保护；回调总是在锁外执行 (或投递)。
+ */
+
+#pragma once
+
+#ifndef Z3Y_SRC_PLUGIN_MANAGER_TIMER_WHEEL_H_
+#define Z3Y_SRC_PLUGIN_MANAGER_TIMER_WHEEL_H_
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "framework/i_timer_service.h"
+#include "task_executor.h"
+
+namespace z3y {
+
+    class TimerWheel {
+    public:
+        using Clock = std::chrono::steady_clock;
+        static constexpr int kLevelBits = 8;
+        static constexpr uint32_t kSlotsPerLevel = 1u << kLevelBits;
+        static constexpr int kLevels = 4;
+
+        /** @param executor 驱动时间轮、执行回调的共享执行器 (生命周期长于本对象)。 */
+        TimerWheel(TaskExecutor* executor, std::chrono::nanoseconds tick, TaskExecutor::ExceptionSink sink);
+        ~TimerWheel();
+        TimerWheel(const TimerWheel&) = delete;
+        TimerWheel& operator=(const TimerWheel&) = delete;
+
+        /** @param period 0 表示一次性定时器。 */
+        TimerId Start(Clock::time_point due, std::chrono::nanoseconds period,
+            std::function<void()> callback, const TimerOptions& options);
+        bool Restart(TimerId id, std::chrono::nanoseconds delay);
+        bool Stop(TimerId id);
+
+        /** @brief 丢弃所有定时器 (卸载全部插件时：回调可能引用即将卸载的代码)。 */
+        void Clear();
+
+        TimerServiceStats Stats() const;
+
+    private:
+        static constexpr uint32_t kNil = UINT32_MAX;
+
+        struct Node {
+            uint64_t expire = 0;        //!< 到期刻度
+            uint64_t period = 0;        //!< 周期 (刻度)，0 = 一次性
+            uint64_t align = 1;         //!< slack 对齐粒度 (刻度，2 的幂)
+            uint32_t generation = 1;
+            uint32_t prev = kNil;
+            uint32_t next = kNil;
+            uint16_t level = 0;
+            uint16_t slot = 0;
+            bool linked = false;
+            TaskPriority priority = TaskPriority::kNormal;
+            std::function<void()> once;                       //!< 一次性回调 (到期时移出)
+            std::shared_ptr<std::function<void()>> repeating; //!< 周期回调 (每次触发共享)
+            std::shared_ptr<IEventExecutor> executor;
+        };
+
+        /** @brief 一次到期：要么移出的一次性回调，要么共享的周期回调。 */
+        struct Expired {
+            std::function<void()> once;
+            std::shared_ptr<std::function<void()>> repeating;
+            std::shared_ptr<IEventExecutor> executor;
+            TaskPriority priority;
+        };
+
+        uint64_t TickAtOrAfter(Clock::time_point t) const;
+        uint64_t TickBefore(Clock::time_point t) const;
+        uint64_t AlignExpire(uint64_t expire, uint64_t align) const;
+
+        void Link_UNLOCKED(uint32_t index, uint64_t min_expire);
+        void Unlink_UNLOCKED(uint32_t index);
+        /** @brief 回收节点；回调移入 discarded，由调用方在锁外析构。 */
+        void Free_UNLOCKED(uint32_t index, Expired& discarded);
+        Node* Find_UNLOCKED(TimerId id);
+
+        /** @brief 把高层轮当前槽降级 (current_ 刚跨过第 0 层的圈边界)。 */
+        void Cascade_UNLOCKED();
+        /** @brief 推进到 target 刻度，收集到期的回调。 */
+        void Advance_UNLOCKED(uint64_t target, std::vector<Expired>& expired);
+        /** @brief 触发第 0 层一个槽里的定时器；周期定时器按 target 跳过错过的周期后重新放置。 */
+        void CollectSlot_UNLOCKED(uint32_t slot, uint64_t target, std::vector<Expired>& expired);
+        /** @brief 在 [from, to] 范围内查找第 0 层下一个非空槽对应的刻度 (不跨 256 边界)。 */
+        bool NextOccupied_UNLOCKED(uint64_t from, uint64_t to, uint64_t& tick) const;
+        /** @brief 确保执行器上有一个不晚于下一个需要处理的刻度的唤醒任务。 */
+        void Arm_UNLOCKED();
+
+        void OnWake();
+        void Dispatch(std::vector<Expired>& expired);
+
+        TaskExecutor* executor_;
+        const std::chrono::nanoseconds tick_;
+        const Clock::time_point epoch_;
+        TaskExecutor::ExceptionSink sink_;
+
+        mutable std::mutex mutex_;
+        std::vector<Node> nodes_;
+        std::vector<uint32_t> free_nodes_;
+        uint32_t heads_[kLevels][kSlotsPerLevel];
+        uint64_t occupied_[kLevels][kSlotsPerLevel / 64] = {};
+        uint64_t current_ = 0;       //!< 已处理到的刻度 (到期刻度 <= current_ 的都已触发)
+        size_t active_ = 0;
+        TimerId wake_timer_ = 0;     //!< 执行器上挂着的唤醒任务
+        uint64_t wake_tick_ = 0;     //!< 它对应的刻度
+        uint64_t started_ = 0;
+        uint64_t fired_ = 0;
+        uint64_t wakeups_ = 0;
+        uint64_t cascaded_ = 0;
+    };
+
+}  // namespace z3y
+
+#endif  // Z3Y_SRC_PLUGIN_MANAGER_TIMER_WHEEL_H_
@@ -0,0 +1,179 @@
+﻿/*
+ * Copyright [2025] [Yue Liu]
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file socket_common.cpp
+ * @brief socket_common.h 的平台实现。
+ */
+
+#include "z3y_socket_common/socket_common.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#endif
+
+#include <cstring>
+
+namespace z3y {
+namespace net {
+
+namespace {
+
+#ifdef _WIN32
+/** @brief Winsock 需要进程内先调用 WSAStartup；随所在模块一起初始化与清理。 */
+struct WinsockGuard {
+  bool ok = false;
+  WinsockGuard() {
+    WSADATA data;
+    ok = WSAStartup(MAKEWORD(2, 2), &data) == 0;
+  }
+  ~WinsockGuard() {
+    if (ok) WSACleanup();
+  }
+};
+
+SOCKET Native(SocketHandle s) { return static_cast<SOCKET>(s); }
+#else
+int Native(SocketHandle s) { return s; }
+#endif
+
+}  // namespace
+
+#ifdef _WIN32
+static_assert(kInvalidSocket == static_cast<SocketHandle>(INVALID_SOCKET),
+              "kInvalidSocket must match INVALID_SOCKET");
+
+bool EnsureSockets() {
+  static WinsockGuard guard;
+  return guard.ok;
+}
+
+std::string LastSocketError() { return "WSA error " + std::to_string(WSAGetLastError()); }
+
+bool WouldBlock() {
+  const int err = WSAGetLastError();
+  return err == WSAEWOULDBLOCK || err == WSAEINPROGRESS;
+}
+
+void CloseSocket(SocketHandle s) {
+  if (s != kInvalidSocket) ::closesocket(Native(s));
+}
+
+bool SetNonBlocking(SocketHandle s) {
+  u_long non_blocking = 1;
+  return ::ioctlsocket(Native(s), FIONBIO, &non_blocking) == 0;
+}
+
+bool WaitSocket(SocketHandle s, bool for_write, int timeout_ms) {
+  WSAPOLLFD pfd{};
+  pfd.fd = Native(s);
+  pfd.events = for_write ? POLLWRNORM : POLLRDNORM;
+  return WSAPoll(&pfd, 1, timeout_ms) > 0;
+}
+#else
+bool EnsureSockets() { return true; }
+
+std::string LastSocketError() { return std::strerror(errno); }
+
+bool WouldBlock() {
+  return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINPROGRESS ||
+         errno == EINTR;
+}
+
+void CloseSocket(SocketHandle s) {
+  if (s != kInvalidSocket) ::close(s);
+}
+
+bool SetNonBlocking(SocketHandle s) {
+  const int flags = ::fcntl(s, F_GETFL, 0);
+  return flags >= 0 && ::fcntl(s, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+bool WaitSocket(SocketHandle s, bool for_write, int timeout_ms) {
+  pollfd pfd{};
+  pfd.fd = s;
+  pfd.events = for_write ? POLLOUT : POLLIN;
+  int rc;
+  do {
+    rc = ::poll(&pfd, 1, timeout_ms);
+  } while (rc < 0 && errno == EINTR);
+  return rc > 0;
+}
+#endif
+
+bool SplitHostPort(const std::string& target, std::string& host,
+                   std::string& port) {
+  size_t colon = target.rfind(':');
+  if (colon == std::string::npos || colon == 0 || colon + 1 == target.size()) {
+    return false;
+  }
+  host = target.substr(0, colon);
+  port = target.substr(colon + 1);
+  if (host.size() > 2 && host.front() == '[' && host.back() == ']') {
+    host = host.substr(1, host.size() - 2);
+  }
+  return true;
+}
+
+bool ConnectSucceeded(SocketHandle s) {
+  int err = 0;
+  socklen_t len = sizeof(err);
+  if (::getsockopt(Native(s), SOL_SOCKET, SO_ERROR,
+                   reinterpret_cast<char*>(&err), &len) != 0) {
+    return false;
+  }
+  return err == 0;
+}
+
+long SendBytes(SocketHandle s, const char* data, size_t size) {
+#ifdef _WIN32
+  const int n = ::send(Native(s), data, static_cast<int>(size), 0);
+#else
+  const ssize_t n = ::send(s, data, size, MSG_NOSIGNAL);
+#endif
+  return n >= 0 ? static_cast<long>(n) : -1;
+}
+
+long ReceiveBytes(SocketHandle s, char* buf, size_t size) {
+#ifdef _WIN32
+  const int n = ::recv(Native(s), buf, static_cast<int>(size), 0);
+#else
+  const ssize_t n = ::recv(s, buf, size, 0);
+#endif
+  return n >= 0 ? static_cast<long>(n) : -1;
+}
+
+std::string LocalHostName(const char* fallback) {
+  char name[256] = {};
+  if (!EnsureSockets() || ::gethostname(name, sizeof(name) - 1) != 0 || name[0] == '\0') {
+    return fallback;
+  }
+  return name;
+}
+
+}  // namespace net
+}  // namespace z3y
@@ -0,0 +1,91 @@
+﻿/*
+ * Copyright [2025] [Yue Liu]
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file socket_common.h
+ * @brief [内部] 网络插件共用的套接字平台层（BSD Socket 与 Winsock 通用）。
+ *
+ * @details
+ * 指标导出、事件桥与网络日志 Sink 都要做的几件事集中在这里：进程内初始化 Winsock、
+ * 拆分 "host:port"、切换非阻塞、带超时等待就绪，以及屏蔽两个平台 send / recv 的
+ * 参数类型差异 (POSIX 上附带 MSG_NOSIGNAL，对端关闭时不触发 SIGPIPE)。
+ * 各插件在此之上只保留自己的协议逻辑。
+ *
+ * 本头文件不包含任何系统网络头文件；编成静态库 `z3y_socket_common`，
+ * 链接进各个插件模块 (每个模块各有一份 Winsock 初始化，WSAStartup 本身按引用计数)。
+ */
+
+#pragma once
+
+#ifndef Z3Y_SOCKET_COMMON_SOCKET_COMMON_H_
+#define Z3Y_SOCKET_COMMON_SOCKET_COMMON_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace z3y {
+namespace net {
+
+#ifdef _WIN32
+using SocketHandle = uintptr_t;  ///< 与 Winsock 的 SOCKET 同宽
+inline constexpr SocketHandle kInvalidSocket = ~SocketHandle{0};  ///< INVALID_SOCKET
+#else
+using SocketHandle = int;
+inline constexpr SocketHandle kInvalidSocket = -1;
+#endif
+
+/** @brief 确保套接字库可用 (Windows 上首次调用时执行 WSAStartup)。 */
+bool EnsureSockets();
+
+/** @brief 最近一次套接字调用的错误描述。 */
+std::string LastSocketError();
+
+/** @brief 最近一次失败只是 "暂时无法完成" (非阻塞的读写 / 连接进行中)。 */
+bool WouldBlock();
+
+/** @brief 关闭一个套接字（kInvalidSocket 时无操作）。 */
+void CloseSocket(SocketHandle s);
+
+/** @brief 把套接字切换为非阻塞模式。 */
+bool SetNonBlocking(SocketHandle s);
+
+/** @brief 拆分 "host:port"；host 可以是 "[::1]" 形式的 IPv6 地址。 */
+bool SplitHostPort(const std::string& target, std::string& host,
+                   std::string& port);
+
+/**
+ * @brief 等待至多 timeout_ms，直到套接字可读 / 可写 (出错或挂断也算就绪，
+ * 由随后的读写或 `ConnectSucceeded` 报告失败)。
+ */
+bool WaitSocket(SocketHandle s, bool for_write, int timeout_ms);
+
+/** @brief 查询非阻塞连接的结果 (SO_ERROR)。 */
+bool ConnectSucceeded(SocketHandle s);
+
+/** @brief send 的跨平台封装。@return 已发送字节数，失败时返回 -1。 */
+long SendBytes(SocketHandle s, const char* data, size_t size);
+
+/** @brief recv 的跨平台封装。@return 读到的字节数，对端关闭为 0，失败时返回 -1。 */
+long ReceiveBytes(SocketHandle s, char* buf, size_t size);
+
+/** @brief 本机主机名；取不到时返回 fallback。 */
+std::string LocalHostName(const char* fallback);
+
+}  // namespace net
+}  // namespace z3y
+
+#endif  // Z3Y_SOCKET_COMMON_SOCKET_COMMON_H_
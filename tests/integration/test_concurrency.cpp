@@ -28,8 +28,13 @@
   */
 
 #include "common/plugin_test_base.h"
+#include "framework/i_executor_service.h"
+#include "framework/i_timer_service.h"
+#include "framework/pipeline.h"
 #include "framework/z3y_define_impl.h"
 #include "interfaces_demo/i_demo_logger.h"
+#include <condition_variable>
+#include <mutex>
 #include <thread>
 #include <vector>
 #include <set>
@@ -108,3 +113,576 @@ TEST_F(ConcurrencyTest, ConcurrentCreateInstance) {
 
     EXPECT_EQ(success_count, kThreadCount) << "所有并发创建请求都应成功";
 }
+
+/**
+ * @test 单例读取与 Create/Destroy 并发
+ * @brief GetActiveInstance 是无锁读：读者要么拿到一个完整可用的实例，要么拿到 nullptr，
+ * Destroy 在读者离开之前不会释放实例。
+ */
+TEST_F(ConcurrencyTest, GetActiveInstanceDuringRecreate) {
+    const int kReaderCount = 4;
+    const int kRounds = 20;
+    manager_.reset();
+
+    std::atomic<bool> stop{ false };
+    std::atomic<int> seen_live{ 0 };
+    std::vector<std::thread> readers;
+    for (int i = 0; i < kReaderCount; ++i) {
+        readers.emplace_back([&]() {
+            while (!stop.load(std::memory_order_relaxed)) {
+                if (auto m = PluginManager::GetActiveInstance()) {
+                    // 拿到的实例必须可用 (Create 尚未注册完内置服务时允许查不到)
+                    try {
+                        if (m->GetService<IEventBus>(clsid::kEventBus)) seen_live++;
+                    } catch (const PluginException&) {}
+                }
+            }
+            });
+    }
+
+    for (int round = 0; round < kRounds; ++round) {
+        PluginManager::Destroy();
+        auto m = PluginManager::Create();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        if (round + 1 == kRounds) manager_ = m;
+    }
+
+    stop = true;
+    for (auto& t : readers) t.join();
+
+    EXPECT_GT(seen_live.load(), 0);
+    EXPECT_EQ(PluginManager::GetActiveInstance(), manager_);
+}
+
+/**
+ * @test 共享执行器：普通任务、定时器取消、串行队列顺序与统计。
+ * @brief 多个线程并发向同一个串行队列投递，队列内任务必须一个接一个按各线程的投递顺序执行。
+ */
+TEST_F(ConcurrencyTest, SharedExecutorTasksTimersAndSerialQueues) {
+    auto executor = manager_->GetService<IExecutorService>(clsid::kExecutor);
+    ASSERT_TRUE(executor);
+    EXPECT_GE(executor->GetWorkerCount(), 2u);
+
+    std::mutex mtx;
+    std::condition_variable cv;
+    int done = 0;
+    auto finish = [&] {
+        std::lock_guard<std::mutex> lock(mtx);
+        done++;
+        cv.notify_all();
+    };
+
+    // 1. 普通任务与延迟任务；被取消的定时器永远不会执行
+    std::atomic<bool> cancelled_ran{ false };
+    ASSERT_TRUE(executor->Post(finish, TaskPriority::kHigh));
+    ASSERT_NE(executor->PostDelayed(std::chrono::milliseconds(5), finish), 0u);
+    TimerId doomed = executor->PostDelayed(std::chrono::seconds(30), [&] { cancelled_ran = true; });
+    ASSERT_NE(doomed, 0u);
+    EXPECT_TRUE(executor->CancelTimer(doomed));
+    EXPECT_FALSE(executor->CancelTimer(doomed));
+
+    // 2. 串行队列：同名同队列，任务互不重叠且保持每个生产者的顺序
+    auto strand = executor->GetSerialQueue("test.strand");
+    ASSERT_TRUE(strand);
+    EXPECT_EQ(strand, executor->GetSerialQueue("test.strand"));
+
+    const int kProducers = 4;
+    const int kPerProducer = 200;
+    std::vector<int> last_seen(kProducers, -1);
+    std::atomic<int> in_flight{ 0 };
+    std::atomic<int> overlaps{ 0 };
+    std::atomic<int> out_of_order{ 0 };
+    std::vector<std::thread> producers;
+    for (int p = 0; p < kProducers; ++p) {
+        producers.emplace_back([&, p] {
+            for (int i = 0; i < kPerProducer; ++i) {
+                strand->Post([&, p, i] {
+                    if (in_flight.fetch_add(1) != 0) overlaps++;
+                    if (last_seen[p] != i - 1) out_of_order++;
+                    last_seen[p] = i;
+                    in_flight.fetch_sub(1);
+                    finish();
+                    });
+            }
+            });
+    }
+    for (auto& t : producers) t.join();
+
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        ASSERT_TRUE(cv.wait_for(lock, std::chrono::seconds(5),
+            [&] { return done == 2 + kProducers * kPerProducer; }));
+    }
+    EXPECT_EQ(overlaps.load(), 0);
+    EXPECT_EQ(out_of_order.load(), 0);
+    EXPECT_FALSE(cancelled_ran.load());
+
+    // 3. 任务异常交给异常处理器，统计里记为失败
+    std::atomic<int> reported{ 0 };
+    manager_->SetExceptionHandler([&](const std::exception&) { reported++; });
+    executor->Post([] { throw std::runtime_error("executor task failure"); });
+    for (int i = 0; i < 200 && reported.load() == 0; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    EXPECT_EQ(reported.load(), 1);
+
+    // 计数在任务返回后才累加，稍等片刻让它追上
+    const uint64_t kExpected = 3 + kProducers * kPerProducer;
+    ExecutorStats stats = executor->GetExecutorStats();
+    for (int i = 0; i < 200 && stats.executed_tasks < kExpected; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        stats = executor->GetExecutorStats();
+    }
+    EXPECT_EQ(stats.pending_timers, 0u);
+    EXPECT_GE(stats.serial_queues, 1u);
+    EXPECT_GE(stats.executed_tasks, kExpected);
+    EXPECT_EQ(stats.failed_tasks, 1u);
+}
+
+/** @brief strand 测试：带发布线程编号与序号的事件。 */
+struct StrandTestEvent : public z3y::Event {
+    Z3Y_DEFINE_EVENT(StrandTestEvent, "z3y-test-evt-strand-002");
+    int producer;
+    int seq;
+    StrandTestEvent(int p, int s) : producer(p), seq(s) {}
+};
+
+/** @brief 不加锁的订阅者：只靠自己的 strand 保证回调互不重入、按序执行。 */
+class StrandSink : public std::enable_shared_from_this<StrandSink> {
+public:
+    StrandSink(int producers, std::atomic<int>& running, std::atomic<int>& max_running)
+        : last_seen(producers, -1), running_(running), max_running_(max_running) {}
+
+    void OnEvent(const StrandTestEvent& e) {
+        if (in_flight.fetch_add(1) != 0) overlaps++;
+        const int now = ++running_;
+        int seen = max_running_.load();
+        while (now > seen && !max_running_.compare_exchange_weak(seen, now)) {}
+        if (last_seen[e.producer] != e.seq - 1) out_of_order++;
+        last_seen[e.producer] = e.seq;  // 普通 vector，没有任何锁
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+        --running_;
+        in_flight.fetch_sub(1);
+        received++;
+    }
+
+    std::vector<int> last_seen;
+    std::atomic<int> in_flight{ 0 };
+    std::atomic<int> overlaps{ 0 };
+    std::atomic<int> out_of_order{ 0 };
+    std::atomic<int> received{ 0 };
+
+private:
+    std::atomic<int>& running_;
+    std::atomic<int>& max_running_;
+};
+
+/**
+ * @test 匿名 strand：每个订阅者一个，回调在共享线程池上执行；同一订阅者的回调互不重叠、
+ * 保持各发布线程的顺序，不同订阅者之间则并行。卸载插件时积压的 strand 任务被丢弃，strand 之后照常可用。
+ */
+TEST_F(ConcurrencyTest, StrandsSerializePerSubscriberAndRunInParallel) {
+    auto executor = manager_->GetService<IExecutorService>(clsid::kExecutor);
+    auto bus = manager_->GetService<IEventBus>(clsid::kEventBus);
+    ASSERT_TRUE(executor && bus);
+    EXPECT_NE(executor->MakeStrand(), executor->MakeStrand());
+
+    const int kSinks = 6;
+    const int kProducers = 3;
+    const int kPerProducer = 100;
+    std::atomic<int> running{ 0 };
+    std::atomic<int> max_running{ 0 };
+    std::vector<std::shared_ptr<StrandSink>> sinks;
+    std::vector<ScopedConnection> conns;
+    for (int i = 0; i < kSinks; ++i) {
+        sinks.push_back(std::make_shared<StrandSink>(kProducers, running, max_running));
+        conns.emplace_back(bus->SubscribeGlobal<StrandTestEvent>(sinks.back(), &StrandSink::OnEvent,
+            executor->MakeStrand()));
+    }
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < kProducers; ++p) {
+        producers.emplace_back([&, p] {
+            for (int i = 0; i < kPerProducer; ++i) bus->FireGlobal<StrandTestEvent>(p, i);
+            });
+    }
+    for (auto& t : producers) t.join();
+
+    const int kExpected = kProducers * kPerProducer;
+    for (int i = 0; i < 1000; ++i) {
+        bool all = true;
+        for (const auto& sink : sinks) all = all && sink->received.load() == kExpected;
+        if (all) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    for (const auto& sink : sinks) {
+        EXPECT_EQ(sink->received.load(), kExpected);
+        EXPECT_EQ(sink->overlaps.load(), 0);
+        EXPECT_EQ(sink->out_of_order.load(), 0);
+    }
+    EXPECT_GE(max_running.load(), 2);  // 不同 strand 确实并行执行
+
+    // 丢弃积压：第一个任务阻塞住 strand，其后的任务在卸载插件时被丢弃
+    auto strand = executor->MakeStrand();
+    std::atomic<bool> entered{ false };
+    std::atomic<bool> release{ false };
+    std::atomic<int> backlog_ran{ 0 };
+    strand->Post([&] {
+        entered = true;
+        while (!release) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        });
+    for (int i = 0; i < 10; ++i) strand->Post([&] { backlog_ran++; });
+    for (int i = 0; i < 1000 && !entered; ++i) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    ASSERT_TRUE(entered.load());
+    std::thread releaser([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(30));
+        release = true;
+        });
+    conns.clear();
+    manager_->UnloadAllPlugins();  // 等待正在执行的任务结束，丢弃尚未开始的任务
+    releaser.join();
+    EXPECT_EQ(backlog_ran.load(), 0);
+
+    std::atomic<int> after{ 0 };
+    strand->Post([&] { after++; });
+    for (int i = 0; i < 1000 && after.load() == 0; ++i) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    EXPECT_EQ(after.load(), 1);
+    EXPECT_EQ(backlog_ran.load(), 0);
+}
+
+/** @brief 定时器服务测试：由 FireGlobalAfter 发布的事件。 */
+struct TimerTestEvent : public z3y::Event {
+    Z3Y_DEFINE_EVENT(TimerTestEvent, "z3y-test-evt-timer-001");
+    int value;
+    explicit TimerTestEvent(int v) : value(v) {}
+};
+
+class TimerEventSink : public std::enable_shared_from_this<TimerEventSink> {
+public:
+    void OnTimer(const TimerTestEvent& e) { last_value = e.value; received++; }
+    std::atomic<int> received{ 0 };
+    std::atomic<int> last_value{ 0 };
+};
+
+/**
+ * @test 定时器服务：一次性 / 周期 / 截止时间定时器、停止与重新计时、发布事件，
+ * 以及大量定时器在同一刻度合并唤醒、远期定时器经高层轮降级后按时触发。
+ */
+TEST_F(ConcurrencyTest, TimerServiceWheelFiresCoalescesAndScales) {
+    auto timers = manager_->GetService<ITimerService>(clsid::kTimerService);
+    ASSERT_TRUE(timers);
+    auto wait_until = [](auto pred, int timeout_ms = 2000) {
+        for (int i = 0; i < timeout_ms && !pred(); ++i) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        return pred();
+    };
+
+    // 1. 一次性与截止时间定时器；停止的不触发，重新计时的推迟触发
+    std::atomic<int> one_shot{ 0 }, deadline{ 0 }, stopped{ 0 }, restarted{ 0 };
+    const auto t0 = std::chrono::steady_clock::now();
+    std::atomic<int64_t> restarted_after_ms{ 0 };
+    EXPECT_NE(timers->StartOneShot(std::chrono::milliseconds(5), [&] { one_shot++; }), 0u);
+    EXPECT_NE(timers->StartDeadline(t0 - std::chrono::seconds(1), [&] { deadline++; }), 0u);  // 已过期：尽快触发
+    TimerId doomed = timers->StartOneShot(std::chrono::milliseconds(5), [&] { stopped++; });
+    EXPECT_TRUE(timers->StopTimer(doomed));
+    EXPECT_FALSE(timers->StopTimer(doomed));
+    TimerId watchdog = timers->StartOneShot(std::chrono::milliseconds(5), [&] {
+        restarted_after_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - t0).count();
+        restarted++;
+        });
+    EXPECT_TRUE(timers->RestartTimer(watchdog, std::chrono::milliseconds(60)));
+    EXPECT_EQ(timers->StartOneShot(std::chrono::milliseconds(1), nullptr), 0u);
+    EXPECT_EQ(timers->StartPeriodic(std::chrono::nanoseconds(0), [] {}), 0u);
+
+    ASSERT_TRUE(wait_until([&] { return restarted.load() == 1; }));
+    EXPECT_EQ(one_shot.load(), 1);
+    EXPECT_EQ(deadline.load(), 1);
+    EXPECT_EQ(stopped.load(), 0);
+    EXPECT_GE(restarted_after_ms.load(), 60);
+    EXPECT_FALSE(timers->RestartTimer(watchdog, std::chrono::milliseconds(1)));  // 已触发
+
+    // 2. 周期定时器 (投递到串行队列)，停止后不再有新的触发
+    auto executor = manager_->GetService<IExecutorService>(clsid::kExecutor);
+    std::atomic<int> ticks{ 0 };
+    TimerOptions serial;
+    serial.executor = executor->GetSerialQueue("test.timer.periodic");
+    TimerId periodic = timers->StartPeriodic(std::chrono::milliseconds(2), [&] { ticks++; }, serial);
+    ASSERT_TRUE(wait_until([&] { return ticks.load() >= 5; }));
+    EXPECT_TRUE(timers->StopTimer(periodic));
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));  // 已投递的那一次可能仍在执行
+    const int ticks_after_stop = ticks.load();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(ticks.load(), ticks_after_stop);
+
+    // 3. 到期时发布事件
+    auto bus = manager_->GetService<IEventBus>(clsid::kEventBus);
+    auto sink = std::make_shared<TimerEventSink>();
+    ScopedConnection conn = bus->SubscribeGlobal<TimerTestEvent>(sink, &TimerEventSink::OnTimer);
+    FireGlobalAfter(*timers, bus, std::chrono::milliseconds(3), TimerTestEvent(77));
+    ASSERT_TRUE(wait_until([&] { return sink->received.load() == 1; }));
+    EXPECT_EQ(sink->last_value.load(), 77);
+
+    // 4. 大量定时器：slack 让它们对齐到同一刻度，唤醒次数远小于定时器数；停止一半
+    const TimerServiceStats before = timers->GetTimerStats();
+    constexpr int kTimers = 100000;
+    std::atomic<int> mass_fired{ 0 };
+    TimerOptions coalesced;
+    coalesced.slack = std::chrono::milliseconds(16);
+    std::vector<TimerId> ids;
+    ids.reserve(kTimers);
+    for (int i = 0; i < kTimers; ++i) {
+        ids.push_back(timers->StartOneShot(std::chrono::milliseconds(300), [&] { mass_fired++; }, coalesced));
+    }
+    for (int i = 0; i < kTimers; i += 2) EXPECT_TRUE(timers->StopTimer(ids[static_cast<size_t>(i)]));
+    EXPECT_EQ(timers->GetTimerStats().active_timers, static_cast<size_t>(kTimers / 2));
+    ASSERT_TRUE(wait_until([&] { return mass_fired.load() == kTimers / 2; }, 5000));
+
+    const TimerServiceStats after = timers->GetTimerStats();
+    EXPECT_EQ(after.active_timers, 0u);
+    EXPECT_EQ(after.fired_timers - before.fired_timers, static_cast<uint64_t>(kTimers / 2));
+    EXPECT_GT(after.cascaded_timers, before.cascaded_timers);  // 300 个刻度之外：先进第 1 层
+    EXPECT_LT(after.wakeups - before.wakeups, 50u);
+    EXPECT_EQ(after.tick_ns, 1000000u);
+}
+
+/** @brief 线程放置测试：回调记录自己运行时所在的 CPU。 */
+struct PlacementTestEvent : public z3y::Event {
+    Z3Y_DEFINE_EVENT(PlacementTestEvent, "z3y-test-evt-placement-003");
+};
+
+class PlacementSink : public std::enable_shared_from_this<PlacementSink> {
+public:
+    void OnEvent(const PlacementTestEvent&) {
+        cpu = GetCurrentCpu();
+        received++;
+    }
+    std::atomic<int> cpu{ -2 };
+    std::atomic<int> received{ 0 };
+};
+
+/**
+ * @test 线程放置：派发线程与共享执行器按 PluginManagerOptions::thread_placements 绑定到指定 CPU；
+ * 不存在的 NUMA 节点被拒绝，没有配置的角色保持默认放置。
+ */
+TEST_F(ConcurrencyTest, ThreadPlacementPinsDispatchAndExecutorThreads) {
+    ASSERT_GE(GetNumaNodeCount(), 1u);
+    EXPECT_FALSE(GetNumaNodeCpus(0).empty());
+    const int cpu = GetCurrentCpu();
+    if (cpu < 0) GTEST_SKIP() << "current CPU is not observable on this platform";
+
+    manager_.reset();
+    PluginManager::Destroy();
+    PluginManagerOptions options;
+    options.event_dispatch_threads = 2;
+    ThreadPlacement pinned;
+    pinned.cpus = { cpu };
+    options.thread_placements[thread_role::kEventDispatch] = pinned;
+    options.thread_placements[thread_role::kExecutor] = pinned;
+    manager_ = PluginManager::Create(options);
+    ASSERT_TRUE(LoadPlugin("plugin_demo_core_services"));
+    ASSERT_NE(manager_->FindThreadPlacement(thread_role::kExecutor), nullptr);
+    EXPECT_EQ(manager_->FindThreadPlacement("test.unknown"), nullptr);
+
+    // 1. 排队订阅的回调在被绑定的派发线程上执行
+    auto bus = manager_->GetService<IEventBus>(clsid::kEventBus);
+    auto sink = std::make_shared<PlacementSink>();
+    ScopedConnection conn = bus->SubscribeGlobal<PlacementTestEvent>(
+        sink, &PlacementSink::OnEvent, ConnectionType::kQueued);
+    bus->FireGlobal<PlacementTestEvent>();
+    for (int i = 0; i < 2000 && sink->received.load() == 0; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    ASSERT_EQ(sink->received.load(), 1);
+    EXPECT_EQ(sink->cpu.load(), cpu);
+
+    // 2. 共享执行器的每个工作线程都被绑定
+    auto executor = manager_->GetService<IExecutorService>(clsid::kExecutor);
+    ASSERT_TRUE(executor);
+    constexpr int kTasks = 64;
+    std::atomic<int> done{ 0 };
+    std::atomic<int> elsewhere{ 0 };
+    for (int i = 0; i < kTasks; ++i) {
+        ASSERT_TRUE(executor->Post([&] {
+            if (GetCurrentCpu() != cpu) elsewhere++;
+            done++;
+        }));
+    }
+    for (int i = 0; i < 2000 && done.load() < kTasks; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    ASSERT_EQ(done.load(), kTasks);
+    EXPECT_EQ(elsewhere.load(), 0);
+
+    // 3. 非法节点被拒绝；未配置的角色什么都不做并视为成功
+    ThreadPlacement bogus;
+    bogus.numa_nodes = { 9999 };
+    EXPECT_FALSE(ApplyThreadPlacement(bogus));
+    EXPECT_TRUE(ApplyThreadPlacement(ThreadPlacement{}));
+    EXPECT_TRUE(PlaceCurrentThread("test.unknown"));
+}
+
+// =============================================================================
+// 数据流管线
+// =============================================================================
+
+namespace {
+
+    /** @brief 把 n 拆成 2n 与 2n+1；n 为负时抛出。 */
+    class SplitStage : public z3y::PluginImpl<SplitStage, IPipelineStage> {
+    public:
+        Z3Y_DEFINE_COMPONENT_ID("z3y-test-pipeline-split-IMPL");
+        void Process(PipelineItem& item, PipelineEmitter& out) override {
+            const int n = *item.As<int>();
+            if (n < 0) throw std::runtime_error("negative input");
+            out.Emit(PipelineItem::Make<int>(2 * n));
+            out.Emit(PipelineItem::Make<int>(2 * n + 1));
+        }
+    };
+
+    /** @brief 闸门关闭时阻塞，用来制造下游积压。 */
+    class GateStage : public z3y::PluginImpl<GateStage, IPipelineStage> {
+    public:
+        Z3Y_DEFINE_COMPONENT_ID("z3y-test-pipeline-gate-IMPL");
+        static inline std::mutex mutex;
+        static inline std::condition_variable cv;
+        static inline bool open = true;
+
+        static void SetOpen(bool value) {
+            std::lock_guard<std::mutex> lock(mutex);
+            open = value;
+            cv.notify_all();
+        }
+        void Process(PipelineItem& item, PipelineEmitter& out) override {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [] { return open; });
+            out.Emit(std::move(item));
+        }
+    };
+
+    /** @brief 只放行偶数。 */
+    class EvenFilterStage : public z3y::PluginImpl<EvenFilterStage, IPipelineStage> {
+    public:
+        Z3Y_DEFINE_COMPONENT_ID("z3y-test-pipeline-even-IMPL");
+        void Process(PipelineItem& item, PipelineEmitter& out) override {
+            if (*item.As<int>() % 2 == 0) out.Emit(std::move(item));
+        }
+    };
+
+    struct PipelineTraceCounts {
+        std::atomic<int> begin{ 0 }, stage_start{ 0 }, stage_end{ 0 }, end{ 0 };
+        static void OnSample(const PipelineTraceSample& sample, void* context) {
+            auto* self = static_cast<PipelineTraceCounts*>(context);
+            switch (sample.point) {
+            case PipelineTracePoint::kItemBegin: self->begin++; break;
+            case PipelineTracePoint::kStageStart: self->stage_start++; break;
+            case PipelineTracePoint::kStageEnd: self->stage_end++; break;
+            case PipelineTracePoint::kItemEnd: self->end++; break;
+            }
+        }
+    };
+
+}  // namespace
+
+/**
+ * @test 数据流管线
+ * @brief 三级管线 (拆分 -> 闸门 -> 过滤)：下游阻塞时背压一直传回生产者，各级通道不超过容量；
+ * 放开后全部条目流出且统计一致；阶段异常只丢弃该条目；追踪钩子按帧成对上报。
+ */
+TEST_F(ConcurrencyTest, PipelineBackpressureStatsAndTracing) {
+    auto registry = dynamic_cast<IPluginRegistry*>(manager_.get());
+    ASSERT_NE(registry, nullptr);
+    z3y::RegisterComponent<SplitStage>(registry, "Test.Pipeline.Split");
+    z3y::RegisterComponent<GateStage>(registry, "Test.Pipeline.Gate");
+    z3y::RegisterComponent<EvenFilterStage>(registry, "Test.Pipeline.Even");
+    auto executor = manager_->GetService<IExecutorService>(clsid::kExecutor);
+    ASSERT_TRUE(executor);
+
+    std::mutex sink_mutex;
+    std::multiset<int> delivered;
+    std::atomic<int> errors{ 0 };
+    PipelineOptions options;
+    options.name = "TestPipeline";
+    options.stages = {
+        { "Split", SplitStage::kClsid, 2, 4 },
+        { "Gate", GateStage::kClsid, 1, 2 },
+        { "Even", 0, 1, 8, z3y::CreateInstance<IPipelineStage>(EvenFilterStage::kClsid) },
+    };
+    options.sink = [&](PipelineItem item) {
+        std::lock_guard<std::mutex> lock(sink_mutex);
+        delivered.insert(*item.As<int>());
+    };
+    options.error_handler = [&](const std::string& stage, std::exception_ptr) {
+        if (stage == "Split") errors++;
+    };
+    std::string err;
+    EXPECT_FALSE(Pipeline::Create(PipelineOptions{}, executor, err));
+    EXPECT_FALSE(err.empty());
+    auto pipeline = Pipeline::Create(std::move(options), executor, err);
+    ASSERT_TRUE(pipeline) << err;
+
+    // 1. 闸门关闭：TryPush 最终因第一级已满而失败，积压停在各级通道与暂存区中
+    GateStage::SetOpen(false);
+    int accepted = 0;
+    for (int i = 0; i < 1000 && pipeline->TryPush(PipelineItem::Make<int>(accepted)); ++i) {
+        ++accepted;
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    ASSERT_LT(accepted, 1000);
+    PipelineStats stats;
+    for (int i = 0; i < 2000; ++i) {
+        stats = pipeline->GetStats();
+        if (stats.stages[1].queue_depth == 2 && stats.stages[0].stalled_items > 0) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_EQ(stats.stages[1].queue_depth, 2u);
+    EXPECT_GT(stats.stages[0].stalled_items, 0u);
+    EXPECT_GT(stats.stages[0].backpressure_stalls, 0u);
+    for (const auto& stage : stats.stages) EXPECT_LE(stage.max_queue_depth, stage.capacity);
+    EXPECT_FALSE(pipeline->PushFor(PipelineItem::Make<int>(-2), std::chrono::milliseconds(5)));
+
+    // 2. 放开闸门：全部条目流出，偶数各一份
+    GateStage::SetOpen(true);
+    ASSERT_TRUE(pipeline->WaitFor(std::chrono::seconds(10)));
+    stats = pipeline->GetStats();
+    EXPECT_EQ(stats.pushed, uint64_t(accepted));
+    EXPECT_EQ(stats.delivered, uint64_t(accepted));
+    EXPECT_EQ(stats.in_flight, 0u);
+    EXPECT_EQ(stats.stages[0].processed, uint64_t(accepted));
+    EXPECT_EQ(stats.stages[0].emitted, uint64_t(2 * accepted));
+    EXPECT_EQ(stats.stages[1].processed, uint64_t(2 * accepted));
+    EXPECT_EQ(stats.stages[2].emitted, uint64_t(accepted));
+    EXPECT_GT(stats.ItemsPerSecond(0), 0.0);
+    {
+        std::lock_guard<std::mutex> lock(sink_mutex);
+        std::multiset<int> expected;
+        for (int n = 0; n < accepted; ++n) expected.insert(2 * n);
+        EXPECT_EQ(delivered, expected);
+    }
+
+    // 3. 阶段抛出异常：该条目被丢弃，管线继续运行
+    ASSERT_TRUE(pipeline->Push(PipelineItem::Make<int>(-1)));
+    ASSERT_TRUE(pipeline->Push(PipelineItem::Make<int>(1000)));
+    ASSERT_TRUE(pipeline->WaitFor(std::chrono::seconds(10)));
+    stats = pipeline->GetStats();
+    EXPECT_EQ(stats.stages[0].failed, 1u);
+    EXPECT_EQ(stats.dropped, 1u);
+    EXPECT_EQ(errors.load(), 1);
+    EXPECT_EQ(stats.delivered, uint64_t(accepted) + 1);
+
+    // 4. 追踪钩子：每帧一对 Begin / End，每级一对 Start / End
+    PipelineTraceCounts counts;
+    SetPipelineTraceHook(&PipelineTraceCounts::OnSample, &counts);
+    EXPECT_TRUE(IsPipelineTraceHookInstalled());
+    for (int n = 0; n < 3; ++n) ASSERT_TRUE(pipeline->Push(PipelineItem::Make<int>(n)));
+    ASSERT_TRUE(pipeline->WaitFor(std::chrono::seconds(10)));
+    SetPipelineTraceHook(nullptr, nullptr);
+    EXPECT_EQ(counts.begin.load(), 3);
+    EXPECT_EQ(counts.end.load(), 3);
+    EXPECT_EQ(counts.stage_start.load(), 3 + 6 + 6);  // 拆分后第二、三级各 6 个条目
+    EXPECT_EQ(counts.stage_end.load(), counts.stage_start.load());
+
+    // 5. 关闭后不再接受新条目
+    pipeline->Close();
+    EXPECT_FALSE(pipeline->Push(PipelineItem::Make<int>(1)));
+    EXPECT_FALSE(pipeline->TryPush(PipelineItem::Make<int>(1)));
+}
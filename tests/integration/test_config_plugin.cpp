@@ -21,10 +21,18 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
 #include <filesystem>
 #include <fstream>
+#include <functional>
+#include <limits>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <thread>
 #include <vector>
 
@@ -32,6 +40,7 @@
 
 // 包含暴露给业务的纯虚接口和类型定义
 #include "interfaces_core/i_config_service.h"
+#include "interfaces_core/i_config_shared_view.h"
 
 using namespace z3y;
 using namespace z3y::interfaces::core;
@@ -57,14 +66,17 @@ class ConfigProviderTest : public PluginTestBase {
   }
 
   void TearDown() override { 
-    // 2. 清理产生的临时测试文件
-    std::error_code ec;
-    std::filesystem::remove(test_db_path_, ec);
-    std::filesystem::remove(test_db_path_ + ".tmp", ec);
-
     config_.reset();
 
     PluginTestBase::TearDown();
+
+    // 2. 清理产生的临时测试文件 (卸载时服务会把变更日志压实成快照，须在其后清理)
+    std::error_code ec;
+    std::filesystem::remove(test_db_path_, ec);
+    std::filesystem::remove(test_db_path_ + ".tmp", ec);
+    std::filesystem::remove(test_db_path_ + ".journal", ec);
+    std::filesystem::remove(test_db_path_ + ".bin", ec);
+    std::filesystem::remove(test_db_path_ + ".history", ec);
   }
 
   // 必须使用框架专属的智能指针，保障跨 DLL 的内存 ABI 安全！
@@ -194,6 +206,43 @@ TEST_F(ConfigProviderTest, BoundaryValidation) {
   EXPECT_EQ(trigger_count, 2);
 }
 
+TEST_F(ConfigProviderTest, LargeArrayValidation) {
+  // 【场景】大数组按块向量化扫描：越界元素在末尾附近也能定位到准确下标；
+  // 浮点数组的 NaN / Inf 一律拒绝 (即使没有设置边界)
+  std::vector<int64_t> ints(5000, 7);
+  config_->Builder<std::vector<int64_t>>("Big.Ints").Default(ints).Min(0).Max(100).RegisterOnly();
+  config_->Builder<std::vector<double>>("Big.Curve").Default({0.0}).Min(-1.0).Max(1.0).RegisterOnly();
+  config_->Builder<std::vector<double>>("Big.Free").Default({0.0}).RegisterOnly();
+
+  ints[4998] = 101;
+  auto errors = config_->ApplyChanges({{"Big.Ints", ints}});
+  ASSERT_EQ(errors.size(), 1u);
+  EXPECT_NE(errors[0].find("index 4998 exceeds"), std::string::npos) << errors[0];
+  ints[4998] = 7;
+  ints[1025] = -1;
+  errors = config_->ApplyChanges({{"Big.Ints", ints}});
+  ASSERT_EQ(errors.size(), 1u);
+  EXPECT_NE(errors[0].find("index 1025 is below"), std::string::npos) << errors[0];
+  ints[1025] = 100;
+  EXPECT_TRUE(config_->SetValueSafe<std::vector<int64_t>>("Big.Ints", ints));
+
+  std::vector<double> curve(4099, 0.5);
+  curve.back() = 1.0;
+  EXPECT_TRUE(config_->SetValueSafe<std::vector<double>>("Big.Curve", curve));
+  curve[4097] = std::nan("");
+  errors = config_->ApplyChanges({{"Big.Curve", curve}});
+  ASSERT_EQ(errors.size(), 1u);
+  EXPECT_NE(errors[0].find("index 4097 is not a finite number"), std::string::npos) << errors[0];
+  curve[4097] = 1.5;
+  EXPECT_FALSE(config_->SetValueSafe<std::vector<double>>("Big.Curve", curve));
+
+  EXPECT_TRUE(config_->SetValueSafe<std::vector<double>>("Big.Free", {1e300, -1e300}));
+  EXPECT_FALSE(config_->SetValueSafe<std::vector<double>>(
+      "Big.Free", {0.0, std::numeric_limits<double>::infinity()}));
+  EXPECT_EQ(config_->GetValueSafe<std::vector<double>>("Big.Free"),
+            (std::vector<double>{1e300, -1e300}));
+}
+
 TEST_F(ConfigProviderTest, ReadOnlyAndPermission) {
   // 【场景】验证只读属性和权限令牌功能
 
@@ -255,6 +304,29 @@ TEST_F(ConfigProviderTest, TypeSafetyMismatch) {
       std::invalid_argument);
 }
 
+TEST_F(ConfigProviderTest, ReRegistrationTypeMismatch) {
+  // 【场景】同一路径被再次注册：类型不同属于类型错误 (invalid_argument)，
+  // 类型相同只是重复注册 (logic_error)，调用方可以分开捕获
+  config_->Builder<double>("Param.ReRegister").Default(1.5).RegisterOnly();
+
+  EXPECT_THROW(
+      config_->Builder<int>("Param.ReRegister").Default(1).RegisterOnly(),
+      std::invalid_argument);
+
+  bool duplicate_is_type_error = false;
+  try {
+    config_->Builder<double>("Param.ReRegister").Default(2.5).RegisterOnly();
+    ADD_FAILURE() << "duplicate registration must throw";
+  } catch (const std::invalid_argument&) {
+    duplicate_is_type_error = true;
+  } catch (const std::logic_error&) {
+  }
+  EXPECT_FALSE(duplicate_is_type_error);
+
+  // 失败的重新注册不能改动已定型节点
+  EXPECT_DOUBLE_EQ(config_->GetValueSafe<double>("Param.ReRegister", 0.0), 1.5);
+}
+
 // ============================================================================
 // 测试组 3：高级交互机制 (Phantom Node, RAII, Transactions)
 // ============================================================================
@@ -759,15 +831,15 @@ TEST_F(ConfigProviderTest, AuditTrailEventPublication) {
 
   // 验证动作 A 的审计事件
   EXPECT_EQ(receiver->received_events[0].path, "Audit.Param");
-  EXPECT_EQ(receiver->received_events[0].old_value, "100");
-  EXPECT_EQ(receiver->received_events[0].new_value, "200");
+  EXPECT_EQ(receiver->received_events[0].OldValueJson(), "100");
+  EXPECT_EQ(receiver->received_events[0].NewValueJson(), "200");
   EXPECT_EQ(receiver->received_events[0].operator_role, "Maintainer");
   EXPECT_GT(receiver->received_events[0].timestamp_ms, 0);  // 时间戳必须有效
 
   // 验证动作 B 的审计事件
   EXPECT_EQ(receiver->received_events[1].path, "Audit.Param");
-  EXPECT_EQ(receiver->received_events[1].old_value, "200");
-  EXPECT_EQ(receiver->received_events[1].new_value, "300");
+  EXPECT_EQ(receiver->received_events[1].OldValueJson(), "200");
+  EXPECT_EQ(receiver->received_events[1].NewValueJson(), "300");
   EXPECT_EQ(receiver->received_events[1].operator_role, "Operator");
 }
 
@@ -864,6 +936,1276 @@ TEST_F(ConfigProviderTest, GetAllGroupKeysQuery) {
   EXPECT_FALSE(has_empty) << "致命错误：空字符串被作为一个 GroupKey 返回了！";
 }
 
+TEST_F(ConfigProviderTest, JournalAppendReplayAndCompaction) {
+  // 【场景】快照存在后，稳态修改只追加变更日志；日志在加载时重放；Reload 后压实
+  const std::string journal_path = test_db_path_ + ".journal";
+  auto read_json = [](const std::string& file) {
+    std::ifstream ifs(file);
+    nlohmann::json root;
+    if (ifs.is_open()) ifs >> root;
+    return root;
+  };
+  auto read_lines = [](const std::string& file) {
+    std::vector<nlohmann::json> lines;
+    std::ifstream ifs(file);
+    std::string line;
+    while (std::getline(ifs, line)) lines.push_back(nlohmann::json::parse(line));
+    return lines;
+  };
+
+  // 1. 快照 + 日志 (末行断电截断)：日志按顺序覆盖快照
+  {
+    std::ofstream(test_db_path_) << R"({ "Journal.A": 1, "Journal.B": 2 })";
+    std::ofstream(journal_path)
+        << R"({"p":"Journal.A","v":10,"t":1})" "\n"
+        << R"({"p":"Journal.A","v":11,"t":2})" "\n"
+        << R"({"p":"Journal.B","v":)";
+  }
+  config_->SetStoragePath(test_db_path_);
+  config_->Builder<int>("Journal.A").Default(0).RegisterOnly();
+  config_->Builder<int>("Journal.B").Default(0).RegisterOnly();
+  config_->Builder<std::string>("Journal.Name").Default("cam").RegisterOnly();
+  EXPECT_EQ(config_->GetValueSafe<int>("Journal.A"), 11);
+  EXPECT_EQ(config_->GetValueSafe<int>("Journal.B"), 2);
+
+  // 2. 高频修改：防抖后只追加变化过的节点，快照不重写
+  std::filesystem::remove(journal_path);
+  const auto snapshot_before = std::filesystem::last_write_time(test_db_path_);
+  for (int i = 0; i < 50; ++i) config_->SetValueSafe<int>("Journal.A", 100 + i);
+  config_->CreateBatch().Set("Journal.B", 7).Set("Journal.Name", std::string("left")).Commit();
+  std::this_thread::sleep_for(std::chrono::milliseconds(800));
+
+  auto lines = read_lines(journal_path);
+  ASSERT_EQ(lines.size(), 3u) << "one record per changed path";
+  std::map<std::string, nlohmann::json> journaled;
+  for (const auto& record : lines) journaled[record["p"]] = record["v"];
+  EXPECT_EQ(journaled["Journal.A"], 149);
+  EXPECT_EQ(journaled["Journal.B"], 7);
+  EXPECT_EQ(journaled["Journal.Name"], "left");
+  EXPECT_EQ(std::filesystem::last_write_time(test_db_path_), snapshot_before);
+  EXPECT_EQ(read_json(test_db_path_)["Journal.A"], 1);
+
+  // 3. Reload 引起变化后压实：快照是最新全量，日志被清空
+  {
+    nlohmann::json edited = read_json(test_db_path_);
+    edited["Journal.B"] = 8;
+    std::ofstream(test_db_path_) << edited.dump();
+  }
+  ASSERT_TRUE(config_->ReloadFromFile());
+  std::this_thread::sleep_for(std::chrono::milliseconds(800));
+  EXPECT_FALSE(std::filesystem::exists(journal_path));
+  auto compacted = read_json(test_db_path_);
+  EXPECT_EQ(compacted["Journal.B"], 8);
+  EXPECT_EQ(compacted["Journal.Name"], "left");
+}
+
+TEST_F(ConfigProviderTest, BinarySnapshotRoundTripAndJsonFallback) {
+  // 【场景】完整快照旁写 config.json.bin；重启后各类型值经二进制快照原样恢复，
+  // 未认领的孤儿 (含 ConfigValue 无法表达的 JSON) 写回时不丢；手改 JSON 后以 JSON 为准
+  const std::string bin_path = test_db_path_ + ".bin";
+  auto restart = [&] {
+    config_.reset();
+    manager_->UnloadAllPlugins();  // Shutdown 时压实并写二进制快照
+    ASSERT_TRUE(LoadPlugin("plugin_config_manager"));
+    config_ = z3y::GetDefaultService<IConfigService>();
+    ASSERT_NE(config_, nullptr);
+    config_->SetStoragePath(test_db_path_);
+  };
+  auto register_all = [&] {
+    config_->Builder<int>("Bin.Int").Default(0).RegisterOnly();
+    config_->Builder<double>("Bin.Double").Default(0.0).RegisterOnly();
+    config_->Builder<bool>("Bin.Bool").Default(false).RegisterOnly();
+    config_->Builder<std::string>("Bin.Text").Default("").RegisterOnly();
+    config_->Builder<std::vector<int>>("Bin.Ints").Default({9}).RegisterOnly();
+    config_->Builder<std::vector<double>>("Bin.Doubles").Default({9.0}).RegisterOnly();
+    config_->Builder<std::vector<std::string>>("Bin.Names").Default({"x"}).RegisterOnly();
+    config_->Builder<std::vector<int>>("Bin.Empty").Default({9}).RegisterOnly();
+  };
+
+  {
+    std::ofstream(test_db_path_) << R"({ "Orphan.Obj": {"x": 1}, "Orphan.Null": null,
+        "Orphan.Big": 18446744073709551615, "Orphan.Num": 3 })";
+  }
+  config_->SetStoragePath(test_db_path_);
+  register_all();
+  EXPECT_TRUE(config_->SetValueSafe<int>("Bin.Int", -7));
+  EXPECT_TRUE(config_->SetValueSafe<double>("Bin.Double", 2.5));
+  EXPECT_TRUE(config_->SetValueSafe<bool>("Bin.Bool", true));
+  EXPECT_TRUE(config_->SetValueSafe<std::string>("Bin.Text", "相机 A"));
+  EXPECT_TRUE(config_->SetValueSafe<std::vector<int>>("Bin.Ints", {1, 2, 3}));
+  EXPECT_TRUE(config_->SetValueSafe<std::vector<double>>("Bin.Doubles", {0.5, 1.5}));
+  EXPECT_TRUE(config_->SetValueSafe<std::vector<std::string>>("Bin.Names", {"a", "b"}));
+  EXPECT_TRUE(config_->SetValueSafe<std::vector<int>>("Bin.Empty", {}));
+
+  restart();
+  ASSERT_TRUE(std::filesystem::exists(bin_path));
+  register_all();
+  EXPECT_EQ(config_->GetValueSafe<int>("Bin.Int"), -7);
+  EXPECT_EQ(config_->GetValueSafe<double>("Bin.Double"), 2.5);
+  EXPECT_TRUE(config_->GetValueSafe<bool>("Bin.Bool"));
+  EXPECT_EQ(config_->GetValueSafe<std::string>("Bin.Text"), "相机 A");
+  EXPECT_EQ(config_->GetValueSafe<std::vector<int>>("Bin.Ints"), (std::vector<int>{1, 2, 3}));
+  EXPECT_EQ(config_->GetValueSafe<std::vector<double>>("Bin.Doubles"),
+            (std::vector<double>{0.5, 1.5}));
+  EXPECT_EQ(config_->GetValueSafe<std::vector<std::string>>("Bin.Names"),
+            (std::vector<std::string>{"a", "b"}));
+  EXPECT_TRUE(config_->GetValueSafe<std::vector<int>>("Bin.Empty").empty());
+  // 整数可按浮点类型认领，与 JSON 加载规则一致
+  config_->Builder<double>("Orphan.Num").Default(0.0).RegisterOnly();
+  EXPECT_EQ(config_->GetValueSafe<double>("Orphan.Num"), 3.0);
+
+  // 再次压实：剩余孤儿从二进制快照写回 JSON
+  EXPECT_TRUE(config_->SetValueSafe<int>("Bin.Int", 5));
+  restart();
+  {
+    std::ifstream ifs(test_db_path_);
+    nlohmann::json root;
+    ifs >> root;
+    EXPECT_EQ(root["Orphan.Obj"], nlohmann::json({{"x", 1}}));
+    EXPECT_TRUE(root.contains("Orphan.Null") && root["Orphan.Null"].is_null());
+    EXPECT_EQ(root["Orphan.Big"].get<uint64_t>(), 18446744073709551615ull);
+    EXPECT_EQ(root["Bin.Int"], 5);
+
+    // 运维在停机时手改 JSON：二进制快照不再同源，以 JSON 为准
+    root["Bin.Int"] = 99;
+    config_.reset();
+    manager_->UnloadAllPlugins();
+    std::ofstream(test_db_path_) << root.dump(2);
+  }
+  ASSERT_TRUE(LoadPlugin("plugin_config_manager"));
+  config_ = z3y::GetDefaultService<IConfigService>();
+  config_->SetStoragePath(test_db_path_);
+  register_all();
+  EXPECT_EQ(config_->GetValueSafe<int>("Bin.Int"), 99);
+  EXPECT_EQ(config_->GetValueSafe<std::string>("Bin.Text"), "相机 A");
+}
+
+// ============================================================================
+// 测试组：强类型句柄 (ConfigHandle) 的无锁读取
+// ============================================================================
+
+TEST_F(ConfigProviderTest, TypedHandleLockFreeReads) {
+  // 【场景】算法逐帧读取参数：句柄获取一次，之后的修改、重置、占位节点转正都能读到
+  auto exposure = config_->Builder<int>("Handle.Exposure")
+                      .Default(1000)
+                      .Min(0)
+                      .Max(100000)
+                      .BindHandle();
+  auto roi_names = config_->Builder<std::vector<std::string>>("Handle.Rois")
+                       .Default({"left", "right"})
+                       .BindHandle();
+  ASSERT_TRUE(exposure.IsValid());
+  EXPECT_EQ(exposure.Get(), 1000);
+  EXPECT_EQ(roi_names.Read([](const auto& v) { return v.size(); }), 2u);
+
+  EXPECT_TRUE(config_->SetValueSafe<int>("Handle.Exposure", 2000));
+  EXPECT_TRUE(config_->SetValueSafe<std::vector<std::string>>(
+      "Handle.Rois", {"top", "bottom", "center"}));
+  EXPECT_EQ(exposure.Get(), 2000);
+  EXPECT_EQ(roi_names.Get(), (std::vector<std::string>{"top", "bottom", "center"}));
+
+  // 被拦截的非法值与类型不匹配的写入不影响句柄
+  EXPECT_FALSE(config_->SetValueSafe<int>("Handle.Exposure", -1));
+  EXPECT_FALSE(config_->SetValue("Handle.Exposure", std::string("oops")));
+  EXPECT_EQ(exposure.Get(), 2000);
+  EXPECT_TRUE(config_->ResetToDefault("Handle.Exposure"));
+  EXPECT_EQ(exposure.Get(), 1000);
+
+  // 消费者先到：占位期间返回 fallback，生产者注册后切换为真实值
+  auto gain = config_->SubscribeHandle<double>("Handle.Gain", -1.0);
+  EXPECT_EQ(gain.Get(), -1.0);
+  config_->Builder<double>("Handle.Gain").Default(2.5).RegisterOnly();
+  EXPECT_EQ(gain.Get(), 2.5);
+
+  // 并发：写线程不断修改，读线程读到的快照必须完整 (大小与内容一致)
+  ASSERT_TRUE(config_->SetValueSafe<std::vector<std::string>>("Handle.Rois", {"1"}));
+  std::atomic<bool> stop{false};
+  std::atomic<int> torn{0};
+  std::vector<std::thread> readers;
+  for (int t = 0; t < 4; ++t) {
+    readers.emplace_back([&] {
+      while (!stop.load()) {
+        roi_names.Read([&](const std::vector<std::string>& v) {
+          for (const auto& name : v) {
+            if (name != std::to_string(v.size())) torn++;
+          }
+        });
+        if (exposure.Get() < 0) torn++;
+      }
+    });
+  }
+  for (int i = 1; i <= 200; ++i) {
+    EXPECT_TRUE(config_->SetValueSafe<std::vector<std::string>>(
+        "Handle.Rois", std::vector<std::string>(i % 7 + 1, std::to_string(i % 7 + 1))));
+    config_->SetValueSafe<int>("Handle.Exposure", i);
+  }
+  stop = true;
+  for (auto& th : readers) th.join();
+  EXPECT_EQ(torn.load(), 0);
+  EXPECT_EQ(exposure.Get(), 200);
+  EXPECT_EQ(roi_names.Get().size(), 200u % 7 + 1);
+}
+
+TEST_F(ConfigProviderTest, ConfigBlockSnapshotReads) {
+  // 【场景】算法每帧读取一组相关参数：整体快照，事务内的多项修改一次可见
+  struct RoiParams {
+    int x = -1;
+    int y = -1;
+    double scale = 0.0;
+    std::string label = "none";
+  };
+  config_->Builder<int>("Block.X").Default(10).RegisterOnly();
+  config_->Builder<int>("Block.Y").Default(20).RegisterOnly();
+  config_->Builder<double>("Block.Scale").Default(1.5).RegisterOnly();
+
+  auto roi = config_->Block<RoiParams>()
+                 .Field("Block.X", &RoiParams::x)
+                 .Field("Block.Y", &RoiParams::y)
+                 .Field("Block.Scale", &RoiParams::scale)
+                 .Field("Block.Label", &RoiParams::label)
+                 .Bind();
+  ASSERT_TRUE(roi.IsValid());
+  EXPECT_EQ(roi.Version(), 1u);
+  RoiParams p = roi.Get();
+  EXPECT_EQ(p.x, 10);
+  EXPECT_EQ(p.y, 20);
+  EXPECT_DOUBLE_EQ(p.scale, 1.5);
+  EXPECT_EQ(p.label, "none") << "未注册的路径保持初始值";
+
+  // 事务修改两项：只组装、发布一次
+  ASSERT_TRUE(config_->CreateBatch().Set("Block.X", 11).Set("Block.Y", 21).Commit().empty());
+  EXPECT_EQ(roi.Version(), 2u);
+  EXPECT_EQ(roi.Read([](const RoiParams& v) { return v.x * 100 + v.y; }), 1121);
+
+  // 占位节点转正后成员切换为真实值
+  config_->Builder<std::string>("Block.Label").Default("left").RegisterOnly();
+  EXPECT_EQ(roi.Get().label, "left");
+
+  // 并发：读者看到的 x、y 总是同一次事务写入的一对
+  std::atomic<bool> stop{false};
+  std::atomic<int> torn{0};
+  std::vector<std::thread> readers;
+  for (int t = 0; t < 4; ++t) {
+    readers.emplace_back([&] {
+      while (!stop.load()) {
+        roi.Read([&](const RoiParams& v) {
+          if (v.y != v.x + 10) torn++;
+        });
+      }
+    });
+  }
+  for (int i = 0; i < 200; ++i) {
+    config_->CreateBatch().Set("Block.X", i).Set("Block.Y", i + 10).Commit();
+  }
+  stop = true;
+  for (auto& th : readers) th.join();
+  EXPECT_EQ(torn.load(), 0);
+  EXPECT_EQ(roi.Get().x, 199);
+
+  // 析构即退订
+  const uint64_t version = roi.Version();
+  { auto moved = std::move(roi); }
+  ASSERT_TRUE(config_->SetValueSafe<int>("Block.X", 5));
+  EXPECT_EQ(roi.Version(), 0u);
+  EXPECT_EQ(version, 203u) << "每次事务只发布一次";
+}
+
+TEST_F(ConfigProviderTest, PersistencePolicyAndFlush) {
+  // 【场景】防抖窗口可配；Flush 跳过剩余等待；持续修改受最大延迟约束；组提交立即落盘
+  using Clock = std::chrono::steady_clock;
+  auto read_value = [this](const std::string& key) {
+    std::ifstream ifs(test_db_path_);
+    nlohmann::json root;
+    if (ifs.is_open()) ifs >> root;
+    return root.contains(key) ? root[key] : nlohmann::json();
+  };
+  auto persisted = [&](const std::string& key, int expected) {
+    // 日志中的后写记录覆盖快照
+    nlohmann::json v = read_value(key);
+    std::ifstream ifs(test_db_path_ + ".journal");
+    std::string line;
+    while (std::getline(ifs, line)) {
+      auto record = nlohmann::json::parse(line);
+      if (record["p"] == key) v = record["v"];
+    }
+    return v == expected;
+  };
+  config_->Builder<int>("Persist.A").Default(0).RegisterOnly();
+
+  // 1. 没有待落盘修改时 Flush 立即成功
+  EXPECT_TRUE(config_->Flush(0));
+
+  // 2. 长防抖窗口下 Flush 不等满窗口，返回时值已在盘上
+  ConfigPersistencePolicy policy;
+  policy.debounce_ms = 5000;
+  policy.max_latency_ms = 10000;
+  config_->SetPersistencePolicy(policy);
+  config_->SetValueSafe<int>("Persist.A", 1);
+  auto start = Clock::now();
+  EXPECT_TRUE(config_->Flush());
+  EXPECT_LT(Clock::now() - start, std::chrono::milliseconds(2000));
+  EXPECT_TRUE(persisted("Persist.A", 1));
+
+  // 3. 持续修改不会无限推迟：max_latency_ms 到期即提交
+  policy.debounce_ms = 200;
+  policy.max_latency_ms = 300;
+  policy.fsync = false;
+  config_->SetPersistencePolicy(policy);
+  start = Clock::now();
+  bool seen = false;
+  for (int i = 2; Clock::now() - start < std::chrono::milliseconds(1500); ++i) {
+    config_->SetValueSafe<int>("Persist.A", i);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    if (!persisted("Persist.A", 1) && !read_value("Persist.A").is_null()) {
+      seen = true;
+      break;
+    }
+  }
+  EXPECT_TRUE(seen) << "changes every 20ms must still be committed within max latency";
+
+  // 4. 组提交：无需 Flush，不等防抖窗口即落盘
+  policy.debounce_ms = 5000;
+  policy.max_latency_ms = 5000;
+  policy.group_commit = true;
+  config_->SetPersistencePolicy(policy);
+  config_->SetValueSafe<int>("Persist.A", 4242);
+  start = Clock::now();
+  while (!persisted("Persist.A", 4242) &&
+         Clock::now() - start < std::chrono::milliseconds(2000)) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  EXPECT_TRUE(persisted("Persist.A", 4242));
+  EXPECT_LT(Clock::now() - start, std::chrono::milliseconds(1000));
+  EXPECT_TRUE(config_->Flush());
+}
+
+TEST_F(ConfigProviderTest, ShardedDictionaryConcurrentRegistration) {
+  // 【场景】多个插件并发 Bind / 订阅 / 读写不同路径；占位节点与注册交错也不丢回调
+  {
+    nlohmann::json root;
+    for (int i = 0; i < 400; ++i) root["Shard.P" + std::to_string(i)] = i * 10 + 5;
+    std::ofstream(test_db_path_) << root.dump();
+  }
+  config_->SetStoragePath(test_db_path_);
+
+  constexpr int kThreads = 8;
+  constexpr int kPerThread = 50;
+  std::atomic<int> notified{0};
+  std::vector<z3y::interfaces::core::ScopedConnection> connections(kThreads * kPerThread);
+  std::vector<std::thread> workers;
+  for (int t = 0; t < kThreads; ++t) {
+    workers.emplace_back([&, t] {
+      for (int k = 0; k < kPerThread; ++k) {
+        const int i = t * kPerThread + k;
+        const std::string path = "Shard.P" + std::to_string(i);
+        // 偶数路径先订阅后注册 (占位节点转正)，奇数路径先注册后订阅
+        if (i % 2 == 0) {
+          connections[i] = config_->Subscribe<int>(
+              path, [&notified](const int&) { notified++; });
+        }
+        config_->Builder<int>(path).Default(-1).RegisterOnly();
+        if (i % 2 == 1) {
+          connections[i] = config_->Subscribe<int>(
+              path, [&notified](const int&) { notified++; });
+        }
+        EXPECT_EQ(config_->GetValueSafe<int>(path), i * 10 + 5);
+        EXPECT_TRUE(config_->SetValueSafe<int>(path, i));
+      }
+    });
+  }
+  for (auto& th : workers) th.join();
+
+  // 偶数路径：转正通知 + SetValue；奇数路径：SetValue
+  EXPECT_EQ(notified.load(), kThreads * kPerThread / 2 * 3);
+  EXPECT_EQ(config_->GetAllConfigs().size(), static_cast<size_t>(kThreads * kPerThread));
+  for (int i = 0; i < kThreads * kPerThread; ++i) {
+    EXPECT_EQ(config_->GetValueSafe<int>("Shard.P" + std::to_string(i)), i);
+  }
+  EXPECT_THROW(config_->Builder<int>("Shard.P0").Default(0).RegisterOnly(),
+               std::logic_error);
+}
+
+TEST_F(ConfigProviderTest, GroupIndexFollowsRegistration) {
+  // 【场景】分组索引只收录已注册节点：占位节点不出现，转正后出现；隐藏节点参与重置但不展示
+  auto conn = config_->Subscribe<int>("Index.Early", [](const int&) {});
+  EXPECT_TRUE(config_->GetConfigsByGroup("TAB_INDEX").empty());
+  EXPECT_TRUE(config_->GetAllGroupKeys().empty());
+
+  config_->Builder<int>("Index.Hidden").GroupKey("TAB_INDEX").Hidden(true).Default(3).RegisterOnly();
+  EXPECT_TRUE(config_->GetAllGroupKeys().empty()) << "hidden-only group must stay invisible";
+
+  config_->Builder<int>("Index.Early").GroupKey("TAB_INDEX").SubGroupKey("B").Default(1).RegisterOnly();
+  config_->Builder<int>("Index.Late").GroupKey("TAB_INDEX").SubGroupKey("A").Default(2).RegisterOnly();
+  config_->Builder<int>("Other.X").GroupKey("TAB_OTHER").Default(9).RegisterOnly();
+
+  auto group = config_->GetConfigsByGroup("TAB_INDEX");
+  ASSERT_EQ(group.size(), 2u);
+  EXPECT_EQ(group.at("Index.Early").meta.subgroup_key, "B");
+  EXPECT_EQ(std::get<int64_t>(group.at("Index.Late").default_value), 2);
+  EXPECT_EQ(config_->GetAllGroupKeys(), (std::vector<std::string>{"TAB_INDEX", "TAB_OTHER"}));
+
+  config_->SetValueSafe<int>("Index.Hidden", 30);
+  config_->SetValueSafe<int>("Index.Late", 20);
+  config_->SetValueSafe<int>("Other.X", 90);
+  config_->ResetGroupToDefault("TAB_INDEX");
+  EXPECT_EQ(config_->GetValueSafe<int>("Index.Hidden"), 3);
+  EXPECT_EQ(config_->GetValueSafe<int>("Index.Late"), 2);
+  EXPECT_EQ(config_->GetValueSafe<int>("Other.X"), 90);
+}
+
+TEST_F(ConfigProviderTest, GroupIndexSummaryAndLazySubgroupEntries) {
+  // 【场景】导航树骨架只取计数；展开二级分组时才取参数的路径、名称与高级标记
+  config_->Builder<int>("Nav.A1").GroupKey("TAB_NAV").SubGroupKey("A").NameKey("a1").Default(0).RegisterOnly();
+  config_->Builder<int>("Nav.A2").GroupKey("TAB_NAV").SubGroupKey("A").Advanced(true).Default(0).RegisterOnly();
+  config_->Builder<int>("Nav.AH").GroupKey("TAB_NAV").SubGroupKey("A").Hidden(true).Default(0).RegisterOnly();
+  config_->Builder<int>("Nav.H").GroupKey("TAB_NAV").SubGroupKey("H").Hidden(true).Default(0).RegisterOnly();
+  config_->Builder<int>("Nav.B").GroupKey("TAB_NAV").Default(0).RegisterOnly();
+  config_->Builder<int>("Nav.None").Default(0).RegisterOnly();
+
+  const auto index = config_->GetGroupIndex();
+  ASSERT_EQ(index.size(), 1u);
+  EXPECT_EQ(index[0].group_key, "TAB_NAV");
+  ASSERT_EQ(index[0].subgroups.size(), 2u) << "hidden-only subgroup must stay invisible";
+  EXPECT_EQ(index[0].subgroups[0].subgroup_key, "");
+  EXPECT_EQ(index[0].subgroups[0].visible_count, 1u);
+  EXPECT_EQ(index[0].subgroups[1].subgroup_key, "A");
+  EXPECT_EQ(index[0].subgroups[1].visible_count, 2u);
+  EXPECT_EQ(index[0].subgroups[1].advanced_count, 1u);
+
+  const auto entries = config_->GetSubgroupEntries("TAB_NAV", "A");
+  ASSERT_EQ(entries.size(), 2u);
+  EXPECT_EQ(entries[0].path, "Nav.A1");
+  EXPECT_EQ(entries[0].name_key, "a1");
+  EXPECT_FALSE(entries[0].is_advanced);
+  EXPECT_EQ(entries[1].path, "Nav.A2");
+  EXPECT_TRUE(entries[1].is_advanced);
+  EXPECT_TRUE(config_->GetSubgroupEntries("TAB_NAV", "Missing").empty());
+}
+
+TEST_F(ConfigProviderTest, QueuedAndCoalescedSubscriptionDelivery) {
+  // 【场景】慢订阅者不再拖慢 SetValue：排队投递在派发线程执行，合并投递只处理最新值
+  using Clock = std::chrono::steady_clock;
+  config_->Builder<int>("Notify.Slider").Default(0).RegisterOnly();
+  const auto caller = std::this_thread::get_id();
+
+  std::mutex mutex;
+  std::vector<int> queued_values;
+  std::vector<int> coalesced_values;
+  std::atomic<bool> off_thread{true};
+  auto queued = config_->Subscribe<int>(
+      "Notify.Slider",
+      [&](const int& v) {
+        if (std::this_thread::get_id() == caller) off_thread = false;
+        std::lock_guard<std::mutex> lock(mutex);
+        queued_values.push_back(v);
+      },
+      ConnectionType::kQueued);
+  auto coalesced = config_->Subscribe<int>(
+      "Notify.Slider",
+      [&](const int& v) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));  // 慢订阅者
+        std::lock_guard<std::mutex> lock(mutex);
+        coalesced_values.push_back(v);
+      },
+      ConnectionType::kQueuedCoalesced);
+
+  const auto start = Clock::now();
+  for (int i = 1; i <= 100; ++i) config_->SetValueSafe<int>("Notify.Slider", i);
+  EXPECT_LT(Clock::now() - start, std::chrono::milliseconds(500))
+      << "SetValue must not wait for the slow subscriber";
+
+  const auto deadline = Clock::now() + std::chrono::seconds(5);
+  for (;;) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (!coalesced_values.empty() && coalesced_values.back() == 100 &&
+          queued_values.size() == 100) {
+        break;
+      }
+    }
+    ASSERT_LT(Clock::now(), deadline) << "queued deliveries did not drain";
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (int i = 0; i < 100; ++i) EXPECT_EQ(queued_values[i], i + 1) << "kQueued keeps order";
+    EXPECT_LT(coalesced_values.size(), 20u) << "coalesced delivery must skip stale values";
+  }
+  EXPECT_TRUE(off_thread.load());
+
+  // 自定义执行器 + Builder.Delivery：回调只在执行器排空时运行
+  struct ManualExecutor : z3y::IEventExecutor {
+    std::vector<std::function<void()>> tasks;
+    void Post(std::function<void()> task) override { tasks.push_back(std::move(task)); }
+  };
+  auto executor = std::make_shared<ManualExecutor>();
+  int bound = -1;
+  int bound_calls = 0;
+  auto bind_conn = config_->Builder<int>("Notify.Bound")
+                       .Default(7)
+                       .Delivery(ConnectionType::kQueuedCoalesced, executor)
+                       .Bind([&](const int& v) {
+                         bound = v;
+                         ++bound_calls;
+                       });
+  EXPECT_EQ(bound, 7) << "initial value is still delivered synchronously";
+  config_->SetValueSafe<int>("Notify.Bound", 8);
+  config_->SetValueSafe<int>("Notify.Bound", 9);
+  ASSERT_EQ(executor->tasks.size(), 1u);
+  EXPECT_EQ(bound, 7);
+  executor->tasks[0]();
+  EXPECT_EQ(bound, 9);
+  EXPECT_EQ(bound_calls, 2);
+
+  // 退订后尚未执行的投递作废
+  config_->SetValueSafe<int>("Notify.Bound", 10);
+  ASSERT_EQ(executor->tasks.size(), 2u);
+  bind_conn = z3y::interfaces::core::ScopedConnection();
+  executor->tasks[1]();
+  EXPECT_EQ(bound, 9);
+
+  EXPECT_THROW(
+      (void)config_->Subscribe<int>("Notify.Slider", [](const int&) {},
+                                    ConnectionType::kDirect, executor),
+      std::invalid_argument);
+}
+
+TEST_F(ConfigProviderTest, InternedSchemaAndCompactValues) {
+  // 【场景】批量参数共享同一条驻留的 Schema；修改其中一个的枚举不影响兄弟节点；
+  // 字符串与数组值经紧凑存储往返不失真
+  for (int i = 0; i < 4; ++i) {
+    config_->Builder<std::string>("Cell.Mode" + std::to_string(i))
+        .GroupKey("TAB_CELL")
+        .Enum({"a", "b"}, {"A", "B"})
+        .Default("a")
+        .RegisterOnly();
+  }
+  ASSERT_TRUE(config_->UpdateEnumSchema("Cell.Mode0", {"a", "b", "c"}, {"A", "B", "C"}));
+  auto group = config_->GetConfigsByGroup("TAB_CELL");
+  ASSERT_EQ(group.size(), 4u);
+  EXPECT_EQ(group.at("Cell.Mode0").meta.enum_values.size(), 3u);
+  for (int i = 1; i < 4; ++i) {
+    EXPECT_EQ(group.at("Cell.Mode" + std::to_string(i)).meta.enum_values,
+              (std::vector<std::string>{"a", "b"}))
+        << "sibling sharing the interned schema must be untouched";
+  }
+  EXPECT_TRUE(config_->SetValueSafe<std::string>("Cell.Mode0", "c"));
+  EXPECT_EQ(config_->GetValueSafe<std::string>("Cell.Mode0"), "c");
+  EXPECT_EQ(config_->GetValueSafe<std::string>("Cell.Mode1"), "a");
+
+  const std::vector<double> curve{0.5, 1.5, 2.5};
+  config_->Builder<std::vector<double>>("Cell.Curve").Default(curve).RegisterOnly();
+  EXPECT_EQ(config_->GetValueSafe<std::vector<double>>("Cell.Curve"), curve);
+  EXPECT_TRUE(config_->SetValueSafe<std::vector<double>>("Cell.Curve", {3.0}));
+  EXPECT_EQ(config_->GetValueSafe<std::vector<double>>("Cell.Curve"), (std::vector<double>{3.0}));
+  EXPECT_TRUE(config_->ResetToDefault("Cell.Curve"));
+  EXPECT_EQ(config_->GetValueSafe<std::vector<double>>("Cell.Curve"), curve);
+
+  config_->Builder<std::string>("Cell.Name").Default(std::string(64, 'x')).RegisterOnly();
+  EXPECT_TRUE(config_->SetValueSafe<std::string>("Cell.Name", std::string(64, 'x')))
+      << "equal heap payloads compare by value";
+  EXPECT_EQ(config_->GetValueSafe<std::string>("Cell.Name"), std::string(64, 'x'));
+}
+
+TEST_F(ConfigProviderTest, FlatBatchCommitsRecipeAtOnce) {
+  // 【场景】配方切换：上千项扁平批量修改整体生效或整体驳回；重复路径以最后一项为准；
+  // 大批量只压实一次完整快照，不写变更日志
+  const int kCount = 1000;
+  for (int i = 0; i < kCount; ++i) {
+    config_->Builder<int>("Recipe.P" + std::to_string(i)).Default(0).Min(0).Max(10000).RegisterOnly();
+  }
+  int notified = 0;
+  auto conn = config_->Subscribe<int>("Recipe.P7", [&](const int&) { ++notified; });
+  notified = 0;
+
+  // 1. 任一项越界：整体驳回，一个都不生效
+  auto rejected = config_->CreateBatch();
+  rejected.Reserve(kCount);
+  for (int i = 0; i < kCount; ++i) rejected.Set("Recipe.P" + std::to_string(i), i == 500 ? -1 : 1);
+  EXPECT_EQ(rejected.Commit("Admin").size(), 1u);
+  EXPECT_EQ(config_->GetValueSafe<int>("Recipe.P0"), 0);
+
+  // 2. 全部合法：重复的 P7 取最后一次，订阅者只收到一次通知
+  std::vector<ConfigChange> changes;
+  changes.reserve(kCount + 1);
+  for (int i = 0; i < kCount; ++i) changes.push_back({"Recipe.P" + std::to_string(i), ConfigValue(int64_t(i + 1))});
+  changes.push_back({"Recipe.P7", ConfigValue(int64_t(77))});
+  EXPECT_TRUE(config_->ApplyChanges(changes, "Admin").empty());
+  EXPECT_EQ(config_->GetValueSafe<int>("Recipe.P0"), 1);
+  EXPECT_EQ(config_->GetValueSafe<int>("Recipe.P999"), 1000);
+  EXPECT_EQ(config_->GetValueSafe<int>("Recipe.P7"), 77);
+  EXPECT_EQ(notified, 1);
+
+  // 3. 未知路径：整体驳回
+  EXPECT_FALSE(config_->ApplyChanges({{"Recipe.Missing", ConfigValue(int64_t(1))}}).empty());
+
+  ASSERT_TRUE(config_->Flush());
+  std::ifstream ifs(test_db_path_);
+  nlohmann::json root;
+  ifs >> root;
+  EXPECT_EQ(root["Recipe.P999"], 1000);
+  EXPECT_EQ(root["Recipe.P7"], 77);
+  std::error_code ec;
+  const auto journal_size = std::filesystem::file_size(test_db_path_ + ".journal", ec);
+  EXPECT_TRUE(ec || journal_size == 0)
+      << "a large batch must compact to a snapshot instead of journaling every entry";
+}
+
+TEST_F(ConfigProviderTest, PrecompiledOverlaySwitchesOnlyDiffs) {
+  // 【场景】配方覆盖层：预编译时校验，切换时只写入并通知与当前值不同的节点
+  config_->Builder<int>("Overlay.Speed").Default(100).Min(0).Max(1000).RegisterOnly();
+  config_->Builder<std::string>("Overlay.Mode").Default("idle").RegisterOnly();
+  config_->Builder<double>("Overlay.Gain").Default(1.0).RegisterOnly();
+  std::map<std::string, int> notified;
+  auto c1 = config_->Subscribe<int>("Overlay.Speed", [&](const int&) { ++notified["Speed"]; });
+  auto c2 = config_->Subscribe<std::string>("Overlay.Mode", [&](const std::string&) { ++notified["Mode"]; });
+  auto c3 = config_->Subscribe<double>("Overlay.Gain", [&](const double&) { ++notified["Gain"]; });
+  notified.clear();
+
+  // 1. 预编译阶段即拦截非法值与未知路径，不登记
+  EXPECT_FALSE(config_->PrepareOverlay("bad", {{"Overlay.Speed", ConfigValue(int64_t(5000))}}).empty());
+  EXPECT_FALSE(config_->PrepareOverlay("bad", {{"Overlay.Missing", ConfigValue(int64_t(1))}}).empty());
+  EXPECT_TRUE(config_->GetOverlayNames().empty());
+
+  // 2. 两个配方只在 Speed 上不同
+  ASSERT_TRUE(config_->PrepareOverlay("A", {{"Overlay.Speed", ConfigValue(int64_t(200))},
+                                            {"Overlay.Mode", ConfigValue(std::string("run"))},
+                                            {"Overlay.Gain", ConfigValue(1.0)}})
+                  .empty());
+  const std::string recipe_file = "test_overlay_recipe_B.json";
+  {
+    std::ofstream ofs(recipe_file);
+    ofs << R"({"Overlay.Speed": 300, "Overlay.Mode": "run", "Overlay.Gain": 1.0})";
+  }
+  ASSERT_TRUE(config_->PrepareOverlayFromFile("B", recipe_file).empty());
+  std::filesystem::remove(recipe_file);
+  EXPECT_EQ(config_->GetOverlayNames(), (std::vector<std::string>{"A", "B"}));
+
+  EXPECT_TRUE(config_->ActivateOverlay("A").empty());
+  EXPECT_EQ(config_->GetValueSafe<int>("Overlay.Speed"), 200);
+  EXPECT_EQ(config_->GetValueSafe<std::string>("Overlay.Mode"), "run");
+  EXPECT_EQ(notified, (std::map<std::string, int>{{"Speed", 1}, {"Mode", 1}}))
+      << "Gain already equals the overlay value";
+
+  notified.clear();
+  EXPECT_TRUE(config_->ActivateOverlay("B").empty());
+  EXPECT_EQ(config_->GetValueSafe<int>("Overlay.Speed"), 300);
+  EXPECT_EQ(notified, (std::map<std::string, int>{{"Speed", 1}}));
+
+  // 3. 覆盖层之外的修改不影响下一次切换
+  config_->SetValueSafe<std::string>("Overlay.Mode", "manual");
+  notified.clear();
+  EXPECT_TRUE(config_->ActivateOverlay("A").empty());
+  EXPECT_EQ(config_->GetValueSafe<std::string>("Overlay.Mode"), "run");
+  EXPECT_EQ(notified, (std::map<std::string, int>{{"Speed", 1}, {"Mode", 1}}));
+
+  EXPECT_TRUE(config_->RemoveOverlay("A"));
+  EXPECT_FALSE(config_->RemoveOverlay("A"));
+  EXPECT_FALSE(config_->ActivateOverlay("A").empty());
+}
+
+class AuditBatchReceiver : public z3y::PluginImpl<AuditBatchReceiver> {
+ public:
+  Z3Y_DEFINE_COMPONENT_ID("z3y-test-audit-batch-receiver-UUID");
+
+  std::vector<size_t> batch_sizes;
+  std::vector<z3y::interfaces::core::ConfigChangedEvent> events;
+
+  void OnBatch(const z3y::EventBatch<z3y::interfaces::core::ConfigChangedEvent>& batch) {
+    batch_sizes.push_back(batch.size());
+    for (const auto& e : batch) events.push_back(e);
+  }
+};
+
+TEST_F(ConfigProviderTest, TypedAuditEventsFireOncePerTransaction) {
+  // 【场景】审计事件携带强类型值、按需渲染 JSON；一次事务只回调批订阅者一次
+  auto event_bus = z3y::GetDefaultService<z3y::IEventBus>();
+  ASSERT_NE(event_bus, nullptr);
+  auto receiver = std::make_shared<AuditBatchReceiver>();
+  z3y::ScopedConnection conn =
+      event_bus->SubscribeGlobalBatch<z3y::interfaces::core::ConfigChangedEvent>(
+          receiver, &AuditBatchReceiver::OnBatch);
+
+  config_->Builder<int>("Typed.A").Default(1).RegisterOnly();
+  config_->Builder<std::string>("Typed.B").Default("x").RegisterOnly();
+  config_->Builder<double>("Typed.C").Default(0.5).RegisterOnly();
+
+  auto batch = config_->CreateBatch();
+  batch.Set("Typed.A", 2).Set("Typed.B", std::string("y \"q\"")).Set("Typed.C", 0.5);
+  ASSERT_TRUE(batch.Commit("Operator").empty());
+  config_->SetValueSafe("Typed.A", 3, "Maintainer");
+
+  ASSERT_EQ(receiver->batch_sizes, (std::vector<size_t>{2, 1}))
+      << "unchanged Typed.C must not be reported; the batch arrives as one callback";
+  std::map<std::string, z3y::interfaces::core::ConfigChangedEvent> by_path;
+  for (int i = 0; i < 2; ++i) by_path[receiver->events[i].path] = receiver->events[i];
+  ASSERT_TRUE(by_path.at("Typed.A").new_value);
+  EXPECT_EQ(std::get<int64_t>(*by_path.at("Typed.A").new_value), 2);
+  EXPECT_EQ(std::get<std::string>(*by_path.at("Typed.B").old_value), "x");
+  EXPECT_EQ(by_path.at("Typed.B").NewValueJson(), "\"y \\\"q\\\"\"");
+  EXPECT_EQ(by_path.at("Typed.B").operator_role, "Operator");
+  EXPECT_EQ(receiver->events[2].OldValueJson(), "2");
+  EXPECT_EQ(receiver->events[2].operator_role, "Maintainer");
+}
+
+TEST_F(ConfigProviderTest, StreamingJsonImportExport) {
+  // 【场景】导入导出与重载逐条流式处理：输出与 dump(4) 逐字节一致，孤儿 (含嵌套对象)
+  // 原样写回；语法损坏的文件在应用任何值之前被拒绝
+  {
+    std::ofstream(test_db_path_) << R"({"Stream.Orphan": {"a": [1, {"b": null}]}, "Stream.Int": 4})";
+  }
+  config_->SetStoragePath(test_db_path_);
+  config_->Builder<int>("Stream.Int").Default(0).RegisterOnly();
+  config_->Builder<std::vector<std::string>>("Stream.Names").Default({"a"}).RegisterOnly();
+  EXPECT_EQ(config_->GetValueSafe<int>("Stream.Int"), 4);
+  EXPECT_TRUE(config_->SetValueSafe<std::vector<std::string>>("Stream.Names", {"x", "\"y\""}));
+
+  const std::string export_file = "test_stream_export.json";
+  ASSERT_TRUE(config_->ExportToFile(export_file));
+  std::string text;
+  {
+    std::ifstream ifs(export_file);
+    text.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+  }
+  const nlohmann::json root = nlohmann::json::parse(text);
+  EXPECT_EQ(root.dump(4), text);
+  EXPECT_EQ(root["Stream.Orphan"], nlohmann::json::parse(R"({"a": [1, {"b": null}]})"));
+  EXPECT_EQ(root["Stream.Names"], nlohmann::json({"x", "\"y\""}));
+
+  // 截断的文件：一个值都不应用
+  {
+    std::ofstream(test_db_path_) << R"({"Stream.Int": 7, "Stream.Names": ["z")";
+  }
+  EXPECT_FALSE(config_->ReloadFromFile());
+  EXPECT_EQ(config_->GetValueSafe<int>("Stream.Int"), 4);
+
+  std::filesystem::remove(test_db_path_ + ".journal");
+  ASSERT_TRUE(config_->ImportFromFile(export_file, false));
+  {
+    std::ofstream(export_file) << R"({"Stream.Int": 8, "Stream.New": "later"})";
+  }
+  ASSERT_TRUE(config_->ImportFromFile(export_file, true));
+  EXPECT_EQ(config_->GetValueSafe<int>("Stream.Int"), 8);
+  config_->Builder<std::string>("Stream.New").Default("").RegisterOnly();
+  EXPECT_EQ(config_->GetValueSafe<std::string>("Stream.New"), "later");
+
+  // 顶层不是对象的覆盖层文件被拒绝
+  {
+    std::ofstream(export_file) << "[1, 2]";
+  }
+  EXPECT_FALSE(config_->PrepareOverlayFromFile("bad", export_file).empty());
+  std::filesystem::remove(export_file);
+}
+
+TEST_F(ConfigProviderTest, CompiledSchemaChecks) {
+  // 【场景】校验规则在驻留 Schema 时编译：字符串下拉框按字典集合校验 (字典刷新后随之更新)，
+  // 磁盘旧值认领时不按字典拒绝；数值边界与自定义校验照常生效
+  {
+    std::ofstream(test_db_path_) << R"({"Check.Mode": "legacy"})";
+  }
+  config_->SetStoragePath(test_db_path_);
+  config_->Builder<std::string>("Check.Mode").Enum({"a", "b"}, {"A", "B"}).Default("a").RegisterOnly();
+  EXPECT_EQ(config_->GetValueSafe<std::string>("Check.Mode"), "legacy")
+      << "the dictionary may not be refreshed yet when the saved value is claimed";
+
+  EXPECT_FALSE(config_->SetValueSafe<std::string>("Check.Mode", "c"));
+  EXPECT_TRUE(config_->SetValueSafe<std::string>("Check.Mode", "b"));
+  ASSERT_TRUE(config_->UpdateEnumSchema("Check.Mode", {"a", "b", "c"}, {"A", "B", "C"}));
+  EXPECT_TRUE(config_->SetValueSafe<std::string>("Check.Mode", "c"));
+  EXPECT_FALSE(config_->ApplyChanges({{"Check.Mode", ConfigValue(std::string("z"))}}).empty());
+
+  // 整型枚举的 enum_values 只用于显示
+  config_->Builder<int>("Check.Index").Enum({"0", "1"}, {"Off", "On"}).Default(0).RegisterOnly();
+  EXPECT_TRUE(config_->SetValueSafe<int>("Check.Index", 5));
+
+  config_->Builder<std::vector<double>>("Check.Curve")
+      .Default({0.5})
+      .Min(0.0)
+      .Max(1.0)
+      .Validator([](const std::vector<double>& v) {
+        return v.size() > 3 ? std::string("too many points") : std::string();
+      })
+      .RegisterOnly();
+  EXPECT_TRUE(config_->SetValueSafe<std::vector<double>>("Check.Curve", {0.0, 1.0}));
+  EXPECT_FALSE(config_->SetValueSafe<std::vector<double>>("Check.Curve", {0.2, 1.5}));
+  auto errors = config_->ApplyChanges(
+      {{"Check.Curve", ConfigValue(std::vector<double>{0.1, 0.2, 0.3, 0.4})}});
+  ASSERT_EQ(errors.size(), 1u);
+  EXPECT_NE(errors[0].find("too many points"), std::string::npos);
+}
+
+TEST_F(ConfigProviderTest, PersistenceStatsCountCommits) {
+  // 【场景】性能面板低频拉取落盘统计：每次 Flush 触发的提交都被计数并计时
+  config_->Builder<int>("Stats.A").Default(0).RegisterOnly();
+  const ConfigPersistenceStats before = config_->GetPersistenceStats();
+
+  for (int i = 1; i <= 3; ++i) {
+    config_->SetValueSafe<int>("Stats.A", i);
+    ASSERT_TRUE(config_->Flush());
+  }
+  const ConfigPersistenceStats after = config_->GetPersistenceStats();
+  EXPECT_GE(after.commits, before.commits + 3);
+  EXPECT_EQ(after.failures, before.failures);
+  EXPECT_GE(after.snapshot_writes, 1u) << "the first commit has no snapshot to append to";
+  EXPECT_GE(after.max_commit_ms, after.last_commit_ms);
+  EXPECT_GE(after.max_commit_ms, after.avg_commit_ms);
+  EXPECT_GT(after.avg_commit_ms, 0.0);
+}
+
+TEST_F(ConfigProviderTest, SchemaBatchRegistersAndSubscribesAtOnce) {
+  // 【场景】插件启动期一次注册上千个参数：认领磁盘旧值、回填、订阅与逐个 Bind 一致
+  constexpr int kCount = 1000;  // 超过并行校验阈值
+  {
+    nlohmann::json root;
+    for (int i = 0; i < kCount; ++i) root["Batch.P" + std::to_string(i)] = i + 1;
+    root["Batch.P7"] = 100000;  // 越界，回退默认值
+    std::ofstream(test_db_path_) << root.dump();
+  }
+  config_->SetStoragePath(test_db_path_);
+
+  std::atomic<int> phantom_notified{0};
+  auto early = config_->Subscribe<int>("Batch.P3", [&](const int&) { phantom_notified++; });
+
+  std::vector<int> seen(kCount, -1);
+  auto batch = config_->CreateSchemaBatch();
+  batch.Reserve(kCount + 1);
+  for (int i = 0; i < kCount; ++i) {
+    batch.Bind(config_->Builder<int>("Batch.P" + std::to_string(i))
+                   .GroupKey("TAB_BATCH")
+                   .Default(-1)
+                   .Max(kCount),
+               [&seen, i](const int& v) { seen[i] = v; });
+  }
+  batch.RegisterOnly(config_->Builder<bool>("Batch.Flag").Default(true));
+  ASSERT_EQ(batch.Size(), static_cast<size_t>(kCount + 1));
+  z3y::interfaces::core::ScopedConnection conn = batch.Commit();
+  EXPECT_EQ(batch.Size(), 0u);
+
+  for (int i = 0; i < kCount; ++i) {
+    ASSERT_EQ(seen[i], i == 7 ? -1 : i + 1) << i;
+  }
+  EXPECT_EQ(phantom_notified.load(), 1);
+  EXPECT_TRUE(config_->GetValueSafe<bool>("Batch.Flag"));
+  EXPECT_EQ(config_->GetConfigsByGroup("TAB_BATCH").size(), static_cast<size_t>(kCount));
+
+  EXPECT_TRUE(config_->SetValueSafe<int>("Batch.P10", 42));
+  EXPECT_EQ(seen[10], 42);
+
+  // 任一项冲突时整批不注册
+  auto conflicting = config_->CreateSchemaBatch();
+  conflicting.RegisterOnly(config_->Builder<int>("Batch.New").Default(0));
+  conflicting.RegisterOnly(config_->Builder<int>("Batch.P0").Default(0));
+  EXPECT_THROW((void)conflicting.Commit(), std::logic_error);
+  EXPECT_EQ(config_->GetAllConfigs().count("Batch.New"), 0u);
+
+  // 整批退订
+  conn = z3y::interfaces::core::ScopedConnection();
+  EXPECT_TRUE(config_->SetValueSafe<int>("Batch.P10", 43));
+  EXPECT_EQ(seen[10], 42);
+}
+
+TEST_F(ConfigProviderTest, FileWatchAppliesOnlyExternallyChangedKeys) {
+  // 【场景】运维手工改 config.json：只应用被改动的键；服务自己的写盘不触发重载
+#if defined(__linux__) || defined(_WIN32)
+  std::atomic<int> a_calls{0};
+  std::atomic<int> b_calls{0};
+  auto conn_a = config_->Builder<int>("Watch.A").Default(1).Max(100).Bind(
+      [&a_calls](const int&) { a_calls++; });
+  auto conn_b = config_->Builder<int>("Watch.B").Default(1).Bind(
+      [&b_calls](const int&) { b_calls++; });
+  ASSERT_TRUE(config_->SetFileWatch(true, 20));
+
+  // 首次提交写完整快照 (自身的原子重命名)，监视线程应识别并忽略
+  ASSERT_TRUE(config_->SetValueSafe<int>("Watch.A", 5));
+  ASSERT_TRUE(config_->SetValueSafe<int>("Watch.B", 5));
+  ASSERT_TRUE(config_->Flush());
+  auto wait_until = [](const std::function<bool()>& pred) {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(3);
+    while (!pred() && std::chrono::steady_clock::now() < deadline) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return pred();
+  };
+  EXPECT_TRUE(wait_until([this] { return config_->GetPersistenceStats().external_ignored >= 1; }));
+  EXPECT_EQ(config_->GetPersistenceStats().external_reloads, 0u);
+
+  // 第二次小提交只追加变更日志：config.json 里 B 仍是 5，内存里是 9
+  ASSERT_TRUE(config_->SetValueSafe<int>("Watch.B", 9));
+  ASSERT_TRUE(config_->Flush());
+  const int b_before = b_calls.load();
+
+  // 外部编辑 (写临时文件再重命名)：只改 A
+  nlohmann::json root;
+  {
+    std::ifstream ifs(test_db_path_);
+    ifs >> root;
+  }
+  ASSERT_EQ(root["Watch.B"], 5);
+  root["Watch.A"] = 42;
+  {
+    std::ofstream(test_db_path_ + ".edit") << root.dump(4);
+  }
+  std::filesystem::rename(test_db_path_ + ".edit", test_db_path_);
+
+  EXPECT_TRUE(wait_until([this] { return config_->GetValueSafe<int>("Watch.A") == 42; }));
+  EXPECT_EQ(config_->GetValueSafe<int>("Watch.B"), 9) << "untouched keys keep the in-memory value";
+  EXPECT_EQ(b_calls.load(), b_before);
+  EXPECT_GE(config_->GetPersistenceStats().external_reloads, 1u);
+
+  // 越界的外部修改被校验拦下
+  root["Watch.A"] = 1000;
+  {
+    std::ofstream(test_db_path_ + ".edit") << root.dump(4);
+  }
+  std::filesystem::rename(test_db_path_ + ".edit", test_db_path_);
+  EXPECT_TRUE(wait_until([this] { return config_->GetPersistenceStats().external_reloads >= 2; }));
+  EXPECT_EQ(config_->GetValueSafe<int>("Watch.A"), 42);
+
+  EXPECT_TRUE(config_->SetFileWatch(false));
+#else
+  EXPECT_FALSE(config_->SetFileWatch(true));
+#endif
+}
+
+TEST_F(ConfigProviderTest, SharedArrayReadsAvoidCopies) {
+  // 【场景】标定表上万个元素：多个读者共享同一缓冲，修改时整体换上新缓冲
+  std::vector<double> table(10000);
+  for (size_t i = 0; i < table.size(); ++i) table[i] = static_cast<double>(i);
+  config_->Builder<std::vector<double>>("Shared.Table").Default(table).RegisterOnly();
+
+  auto first = config_->GetShared<std::vector<double>>("Shared.Table");
+  auto second = config_->GetShared<std::vector<double>>("Shared.Table");
+  ASSERT_TRUE(first);
+  EXPECT_EQ(first.get(), second.get()) << "reads share the node's buffer";
+  EXPECT_EQ(*first, table);
+
+  EXPECT_EQ(config_->GetShared<std::string>("Shared.Table"), nullptr) << "type mismatch";
+  EXPECT_EQ(config_->GetShared<std::vector<double>>("Shared.Missing"), nullptr);
+
+  std::vector<double> updated = table;
+  updated[0] = -1.0;
+  ASSERT_TRUE(config_->SetValueSafe("Shared.Table", updated));
+
+  // 旧读者手里的缓冲保持不变，新读取拿到新缓冲
+  EXPECT_EQ((*first)[0], 0.0);
+  auto third = config_->GetShared<std::vector<double>>("Shared.Table");
+  ASSERT_TRUE(third);
+  EXPECT_NE(third.get(), first.get());
+  EXPECT_EQ((*third)[0], -1.0);
+  EXPECT_EQ(config_->GetValueSafe<std::vector<double>>("Shared.Table"), updated);
+
+  // 标量每次包装一份
+  config_->Builder<int>("Shared.Scalar").Default(5).RegisterOnly();
+  auto scalar = config_->GetValueShared("Shared.Scalar");
+  ASSERT_TRUE(scalar);
+  EXPECT_EQ(std::get<int64_t>(*scalar), 5);
+}
+
+TEST_F(ConfigProviderTest, ChangeHistoryIndexedByPathAndTime) {
+  // 【场景】质检系统查询“这个班次改了什么”，不依赖任何审计事件订阅者
+  using z3y::interfaces::core::ConfigHistoryQuery;
+  const std::string spill_path = test_db_path_ + ".history";
+  config_->SetHistoryPolicy({4, spill_path});
+  config_->Builder<int>("History.A").Default(0).RegisterOnly();
+  config_->Builder<int>("History.B").Default(0).RegisterOnly();
+
+  ASSERT_TRUE(config_->SetValueSafe<int>("History.A", 1, "Operator"));
+  ASSERT_TRUE(config_->SetValueSafe<int>("History.A", 1, "Operator"));  // 值未变，不留记录
+  ASSERT_TRUE(config_->ApplyBatch({{"History.A", int64_t{2}}, {"History.B", int64_t{5}}},
+                                  "Admin")
+                  .empty());
+
+  auto all = config_->QueryHistory({});
+  ASSERT_EQ(all.size(), 3u);
+  EXPECT_EQ(all[0].path, "History.A");
+  EXPECT_EQ(all[0].operator_role, "Operator");
+  EXPECT_EQ(std::get<int64_t>(*all[0].old_value), 0);
+  EXPECT_EQ(std::get<int64_t>(*all[0].new_value), 1);
+  EXPECT_EQ(all[1].sequence + 1, all[2].sequence) << "one transaction, consecutive sequences";
+  EXPECT_EQ(all[1].timestamp_ms, all[2].timestamp_ms);
+
+  ConfigHistoryQuery by_path;
+  by_path.path = "History.A";
+  auto a = config_->QueryHistory(by_path);
+  ASSERT_EQ(a.size(), 2u);
+  EXPECT_EQ(std::get<int64_t>(*a[1].new_value), 2);
+  EXPECT_EQ(a[1].operator_role, "Admin");
+  by_path.limit = 1;
+  ASSERT_EQ(config_->QueryHistory(by_path).size(), 1u);
+  EXPECT_EQ(config_->QueryHistory(by_path)[0].sequence, a[1].sequence) << "limit keeps newest";
+
+  ConfigHistoryQuery by_time;
+  by_time.from_ms = all.back().timestamp_ms + 1;
+  EXPECT_TRUE(config_->QueryHistory(by_time).empty());
+  by_time.from_ms = all.front().timestamp_ms;
+  by_time.to_ms = all.back().timestamp_ms;
+  EXPECT_EQ(config_->QueryHistory(by_time).size(), 3u);
+
+  // 超过容量后淘汰最旧的记录，并由后台提交追加到归档文件
+  for (int v = 10; v < 14; ++v) ASSERT_TRUE(config_->SetValueSafe<int>("History.B", v));
+  all = config_->QueryHistory({});
+  ASSERT_EQ(all.size(), 4u);
+  EXPECT_EQ(std::get<int64_t>(*all.front().new_value), 10);
+  EXPECT_EQ(config_->QueryHistory(by_path).size(), 0u) << "A's records were evicted";
+  EXPECT_EQ(all.back().operator_role, "System_API");
+
+  ASSERT_TRUE(config_->Flush());
+  std::ifstream spill(spill_path);
+  std::vector<nlohmann::json> spilled;
+  for (std::string line; std::getline(spill, line);) spilled.push_back(nlohmann::json::parse(line));
+  ASSERT_EQ(spilled.size(), 3u);
+  EXPECT_EQ(spilled[0]["p"], "History.A");
+  EXPECT_EQ(spilled[0]["o"], 0);
+  EXPECT_EQ(spilled[0]["n"], 1);
+  EXPECT_EQ(spilled[2]["r"], "Admin");
+
+  config_->SetHistoryPolicy({0, ""});
+  ASSERT_TRUE(config_->SetValueSafe<int>("History.B", 99));
+  EXPECT_TRUE(config_->QueryHistory({}).empty());
+}
+
+TEST_F(ConfigProviderTest, MonitorCellBypassesNotifications) {
+  // 【场景】高频监视参数：写入只落到无锁单元，不触发回调与审计事件，界面按版本号拉取
+  auto event_bus = z3y::GetDefaultService<z3y::IEventBus>();
+  auto receiver = std::make_shared<AuditEventReceiver>();
+  z3y::ScopedConnection audit_conn =
+      event_bus->SubscribeGlobal<z3y::interfaces::core::ConfigChangedEvent>(
+          receiver, &AuditEventReceiver::OnConfigChanged, z3y::ConnectionType::kDirect);
+
+  int callbacks = 0;
+  auto conn = config_->Builder<double>("Monitor.Progress")
+                  .Default(0.0)
+                  .Max(100.0)
+                  .Monitor()
+                  .Bind([&callbacks](double) { ++callbacks; });
+  ASSERT_EQ(callbacks, 1);  // 只有绑定时的初始回调
+
+  auto cell = config_->GetMonitorCell("Monitor.Progress");
+  ASSERT_NE(cell, nullptr);
+  EXPECT_EQ(cell->Version(), 0u);
+
+  // 1. 采集线程直接发布：整数按单元类型转换
+  cell->Publish(42);
+  EXPECT_EQ(cell->Version(), 1u);
+  EXPECT_DOUBLE_EQ(config_->GetValueSafe<double>("Monitor.Progress"), 42.0);
+
+  // 2. SetValue 仍按 Schema 校验，通过后存入单元
+  EXPECT_TRUE(config_->SetValueSafe<double>("Monitor.Progress", 55.5));
+  EXPECT_FALSE(config_->SetValueSafe<double>("Monitor.Progress", 150.0));
+  EXPECT_EQ(cell->Version(), 2u);
+  EXPECT_DOUBLE_EQ(std::get<double>(cell->Load()), 55.5);
+  EXPECT_DOUBLE_EQ(
+      std::get<double>(config_->GetAllConfigs().at("Monitor.Progress").current_value), 55.5);
+
+  EXPECT_EQ(callbacks, 1);
+  EXPECT_TRUE(receiver->received_events.empty());
+
+  // 3. 普通参数没有单元；非标量不能声明为监视参数
+  config_->Builder<int>("Monitor.Plain").Default(1).RegisterOnly();
+  EXPECT_EQ(config_->GetMonitorCell("Monitor.Plain"), nullptr);
+  EXPECT_THROW(config_->Builder<std::string>("Monitor.Text").Default("x").Monitor().RegisterOnly(),
+               std::invalid_argument);
+  EXPECT_TRUE(config_->GetValue("Monitor.Text").index() == 0);
+}
+
+TEST_F(ConfigProviderTest, VolatileParametersSkipPersistence) {
+  // 【场景】易失的运行时参数：照常回调，但不认领旧值、不进修改历史、不落盘、不进配方
+  const std::string journal_path = test_db_path_ + ".journal";
+  std::ofstream(test_db_path_) << R"({ "Volatile.Status": 5, "Volatile.Keep": 1 })";
+  config_->SetStoragePath(test_db_path_);
+
+  int callbacks = 0;
+  auto conn = config_->Builder<int>("Volatile.Status")
+                  .Default(0)
+                  .Volatile()
+                  .Bind([&callbacks](int) { ++callbacks; });
+  config_->Builder<int>("Volatile.Keep").Default(0).RegisterOnly();
+  EXPECT_EQ(config_->GetValueSafe<int>("Volatile.Status"), 0) << "stale value not claimed";
+  EXPECT_EQ(config_->GetValueSafe<int>("Volatile.Keep"), 1);
+
+  const uint64_t commits_before = config_->GetPersistenceStats().commits;
+  for (int i = 1; i <= 100; ++i) ASSERT_TRUE(config_->SetValueSafe<int>("Volatile.Status", i));
+  config_->CreateBatch().Set("Volatile.Status", 200).Commit();
+  EXPECT_EQ(callbacks, 102);
+  EXPECT_EQ(config_->GetValueSafe<int>("Volatile.Status"), 200);
+  ASSERT_TRUE(config_->Flush());
+  EXPECT_EQ(config_->GetPersistenceStats().commits, commits_before) << "nothing to save";
+  EXPECT_FALSE(std::filesystem::exists(journal_path));
+
+  ConfigHistoryQuery by_path;
+  by_path.path = "Volatile.Status";
+  EXPECT_TRUE(config_->QueryHistory(by_path).empty());
+
+  // 导出的配方里没有易失参数
+  const std::string recipe_path = test_db_path_ + ".recipe";
+  ASSERT_TRUE(config_->ExportToFile(recipe_path));
+  nlohmann::json recipe;
+  std::ifstream(recipe_path) >> recipe;
+  std::filesystem::remove(recipe_path);
+  EXPECT_FALSE(recipe.contains("Volatile.Status"));
+  EXPECT_TRUE(recipe.contains("Volatile.Keep"));
+}
+
+TEST_F(ConfigProviderTest, SharedViewPublishesToOtherReaders) {
+  // 【场景】主进程发布共享视图，工作进程免锁读取 (此处读者与发布端在同一进程，走的仍是共享内存)
+  config_->Builder<int>("Shared.Count").Default(7).RegisterOnly();
+  config_->Builder<double>("Shared.Gain").Default(1.5).RegisterOnly();
+  config_->Builder<std::string>("Shared.Name").Default("cam").RegisterOnly();
+  config_->Builder<std::vector<std::string>>("Shared.Tags")
+      .Default(std::vector<std::string>{"a", "bc"})
+      .RegisterOnly();
+  config_->Builder<int>("Shared.Monitor").Default(0).Monitor().RegisterOnly();
+
+  const std::string name =
+      "test-view-" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count());
+  ConfigSharedViewOptions options;
+  options.name = name;
+  std::string err;
+  ASSERT_TRUE(config_->PublishSharedView(options, err)) << err;
+  EXPECT_FALSE(config_->PublishSharedView(options, err)) << "already publishing";
+
+  auto view = z3y::CreateDefaultInstance<IConfigSharedView>();
+  ASSERT_NE(view, nullptr);
+  ASSERT_TRUE(view->Open(name, err)) << err;
+  int64_t count = 0;
+  EXPECT_TRUE(view->TryGet<int64_t>("Shared.Count", count));
+  EXPECT_EQ(count, 7);
+  double gain = 0.0;
+  EXPECT_TRUE(view->TryGet<double>("Shared.Gain", gain));
+  EXPECT_DOUBLE_EQ(gain, 1.5);
+  EXPECT_EQ(std::get<std::string>(view->GetValue("Shared.Name")), "cam");
+  EXPECT_EQ(std::get<std::vector<std::string>>(view->GetValue("Shared.Tags")),
+            (std::vector<std::string>{"a", "bc"}));
+  EXPECT_TRUE(std::holds_alternative<std::monostate>(view->GetValue("Shared.Monitor")))
+      << "monitor parameters are not published";
+  EXPECT_TRUE(std::holds_alternative<std::monostate>(view->GetValue("Shared.Missing")));
+
+  // 修改、事务与发布之后才注册的键都同步写入；代数推进，变化的键可以列出
+  const uint64_t seen = view->GetGeneration();
+  ASSERT_TRUE(config_->SetValueSafe<int>("Shared.Count", 8));
+  EXPECT_TRUE(config_->CreateBatch()
+                  .Set("Shared.Name", std::string("camera-01"))
+                  .Set("Shared.Gain", 2.5)
+                  .Commit()
+                  .empty());
+  config_->Builder<bool>("Shared.Late").Default(true).RegisterOnly();
+  EXPECT_EQ(view->GetGeneration(), seen + 4);
+  EXPECT_TRUE(view->TryGet<int64_t>("Shared.Count", count));
+  EXPECT_EQ(count, 8);
+  EXPECT_EQ(std::get<std::string>(view->GetValue("Shared.Name")), "camera-01");
+  EXPECT_TRUE(std::get<bool>(view->GetValue("Shared.Late")));
+  std::vector<std::string> changed = view->GetChangedSince(seen);
+  std::sort(changed.begin(), changed.end());
+  EXPECT_EQ(changed, (std::vector<std::string>{"Shared.Count", "Shared.Gain", "Shared.Late",
+                                               "Shared.Name"}));
+
+  // 等待者被下一次修改唤醒
+  const uint64_t before_wait = view->GetGeneration();
+  std::atomic<uint64_t> woke_with{0};
+  const auto wait_start = std::chrono::steady_clock::now();
+  std::thread waiter([&] { woke_with = view->WaitForChange(before_wait, 5000); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  ASSERT_TRUE(config_->SetValueSafe<int>("Shared.Count", 9));
+  waiter.join();
+  EXPECT_EQ(woke_with.load(), before_wait + 1);
+  EXPECT_LT(std::chrono::steady_clock::now() - wait_start, std::chrono::seconds(4));
+  EXPECT_EQ(view->WaitForChange(view->GetGeneration(), 10), view->GetGeneration()) << "timeout";
+
+  // 并发改写变长字符串：读者只会看到完整的新值或旧值
+  std::atomic<bool> stop{false};
+  std::atomic<int> torn{0};
+  std::vector<std::thread> readers;
+  for (int r = 0; r < 3; ++r) {
+    readers.emplace_back([&] {
+      while (!stop.load()) {
+        const ConfigValue v = view->GetValue("Shared.Name");
+        const auto* s = std::get_if<std::string>(&v);
+        if (!s || (*s != "short" && *s != std::string(300, 'x'))) ++torn;
+      }
+    });
+  }
+  for (int i = 0; i < 2000; ++i) {
+    config_->SetValueSafe<std::string>("Shared.Name", i % 2 ? std::string(300, 'x') : "short");
+  }
+  stop = true;
+  for (auto& t : readers) t.join();
+  EXPECT_EQ(torn.load(), 0);
+
+  // 停止发布：读者保留最后的值；内容区放不下的值读作空并计数
+  config_->StopSharedView();
+  EXPECT_FALSE(view->GetStats().publisher_attached);
+  EXPECT_TRUE(view->TryGet<int64_t>("Shared.Count", count));
+  EXPECT_EQ(count, 9);
+
+  options.data_bytes = 64;
+  ASSERT_TRUE(config_->PublishSharedView(options, err)) << err;
+  ASSERT_TRUE(view->Open(name, err)) << err;
+  EXPECT_TRUE(view->GetStats().publisher_attached);
+  ASSERT_TRUE(config_->SetValueSafe<std::string>("Shared.Name", std::string(200, 'y')));
+  ConfigValue too_large;
+  EXPECT_FALSE(view->TryGetValue("Shared.Name", too_large));
+  EXPECT_GT(config_->GetSharedViewStats().dropped, 0u);
+  EXPECT_TRUE(view->TryGet<int64_t>("Shared.Count", count));
+  view->Close();
+  config_->StopSharedView();
+}
+
+TEST_F(ConfigProviderTest, AsyncSetValueCoalescesQueuedWrites) {
+  // 【场景】实时线程发布状态值：调用线程只压队列，回调在写入线程上执行，积压的同一路径写入合并
+  std::mutex gate_mutex;
+  std::condition_variable gate_cv;
+  bool gate_open = false;
+  bool first_entered = false;
+  std::vector<int> seen;
+  std::thread::id callback_thread;
+  auto conn = config_->Builder<int>("Async.Status")
+                  .Default(0)
+                  .Min(0)
+                  .Max(1000)
+                  .Bind([&](int v) {
+                    std::unique_lock<std::mutex> lock(gate_mutex);
+                    seen.push_back(v);
+                    callback_thread = std::this_thread::get_id();
+                    if (v == 1) {
+                      // 第一次写入卡住写入线程，让后面的写入在队列中积压
+                      first_entered = true;
+                      gate_cv.notify_all();
+                      gate_cv.wait(lock, [&] { return gate_open; });
+                    }
+                  });
+  seen.clear();  // Bind 时以初始值回调一次
+
+  std::future<bool> first = config_->SetValueSafeAsync<int>("Async.Status", 1);
+  {
+    std::unique_lock<std::mutex> lock(gate_mutex);
+    ASSERT_TRUE(gate_cv.wait_for(lock, std::chrono::seconds(5), [&] { return first_entered; }));
+  }
+  std::vector<std::future<bool>> queued;
+  for (int i = 2; i <= 100; ++i) queued.push_back(config_->SetValueSafeAsync<int>("Async.Status", i));
+  std::future<bool> invalid = config_->SetValueAsync("Async.Other", int64_t{5});
+  {
+    std::lock_guard<std::mutex> lock(gate_mutex);
+    gate_open = true;
+  }
+  gate_cv.notify_all();
+
+  EXPECT_TRUE(first.get());
+  for (auto& f : queued) EXPECT_TRUE(f.get()) << "coalesced writes share the final result";
+  EXPECT_FALSE(invalid.get()) << "unknown path";
+  EXPECT_EQ(config_->GetValueSafe<int>("Async.Status"), 100);
+  {
+    std::lock_guard<std::mutex> lock(gate_mutex);
+    EXPECT_EQ(seen, (std::vector<int>{1, 100})) << "queued writes to one path run once";
+    EXPECT_NE(callback_thread, std::this_thread::get_id());
+  }
+
+  // 校验失败的值同样经 future 报告；同一线程的后续写入按顺序生效
+  EXPECT_FALSE(config_->SetValueSafeAsync<int>("Async.Status", 5000).get());
+  config_->SetValueSafeAsync<int>("Async.Status", 7);
+  EXPECT_TRUE(config_->SetValueSafeAsync<int>("Async.Status", 8).get());
+  EXPECT_EQ(config_->GetValueSafe<int>("Async.Status"), 8);
+}
+
 // ============================================================================
 // GTest Main 引导入口
 // ============================================================================
@@ -0,0 +1,183 @@
+﻿/**
+ * @file test_config_replication.cpp
+ * @brief 多节点配置复制插件 (plugin_config_replication) 的集成测试。
+ * * @details
+ * 【面向测试与维护人员】
+ * 复制器不接桥，远端节点由测试直接在总线上发布增量 / 同步请求来模拟；
+ * 复制器发出的增量由订阅者截获。网络传输本身由事件桥的测试覆盖。
+ */
+
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "common/plugin_test_base.h"
+#include "framework/z3y_service_locator.h"
+#include "interfaces_core/i_config_replication.h"
+#include "interfaces_core/i_config_service.h"
+
+using namespace z3y;
+using namespace z3y::interfaces::core;
+
+namespace {
+
+constexpr uint64_t kLocalNode = 1;
+constexpr uint64_t kRemoteNode = 2;
+
+/** @brief 截获本节点发出的增量。 */
+class DeltaCapture : public std::enable_shared_from_this<DeltaCapture> {
+ public:
+  std::mutex mutex;
+  std::vector<ConfigReplicaDeltaEvent> deltas;
+
+  void OnDelta(const ConfigReplicaDeltaEvent& e) {
+    if (e.sender != kLocalNode) return;
+    std::lock_guard<std::mutex> lock(mutex);
+    deltas.push_back(e);
+  }
+  size_t Count() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return deltas.size();
+  }
+  ConfigReplicaDeltaEvent Last() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return deltas.back();
+  }
+};
+
+}  // namespace
+
+/**
+ * @brief 加载配置服务与复制插件的测试固件。
+ */
+class ConfigReplicationTest : public PluginTestBase {
+ protected:
+  void SetUp() override {
+    PluginTestBase::SetUp();
+    ASSERT_TRUE(LoadPlugin("plugin_config_manager"));
+    ASSERT_TRUE(LoadPlugin("plugin_config_replication"));
+    config_ = z3y::GetDefaultService<IConfigService>();
+    config_->SetStoragePath(db_path_);
+    bus_ = z3y::GetService<z3y::IEventBus>(z3y::clsid::kEventBus);
+  }
+
+  void TearDown() override {
+    bus_.reset();
+    config_.reset();
+    PluginTestBase::TearDown();
+    std::error_code ec;
+    for (const char* suffix : {"", ".tmp", ".journal", ".bin", ".history"}) {
+      std::filesystem::remove(db_path_ + suffix, ec);
+    }
+  }
+
+  /** @brief 以远端节点身份发布一条增量。 */
+  void FireRemote(const std::string& path, ConfigValue value,
+                  std::vector<std::pair<uint64_t, uint64_t>> version, uint64_t timestamp_ms) {
+    ConfigReplicaDeltaEvent delta;
+    delta.sender = kRemoteNode;
+    delta.entries.push_back(
+        {path, std::move(value), std::move(version), timestamp_ms, kRemoteNode, ""});
+    bus_->FireGlobal<ConfigReplicaDeltaEvent>(delta);
+  }
+
+  PluginPtr<IConfigService> config_;
+  PluginPtr<z3y::IEventBus> bus_;
+  const std::string db_path_ = "test_config_replication.json";
+};
+
+/**
+ * @brief 本机修改按前缀发出增量；较新的远端版本被写入且不再回传；重复与过期的增量被忽略；
+ * 并发修改按时间戳决出胜者；校验失败的远端值被拒绝；同步请求按摘要回送。
+ */
+TEST_F(ConfigReplicationTest, Verify_Delta_Merge_Conflicts_And_Sync) {
+  config_->Builder<int>("Line.Speed").Default(10).Max(100).RegisterOnly();
+  config_->Builder<int>("Local.Only").Default(0).RegisterOnly();
+
+  auto replicator = z3y::CreateDefaultInstance<IConfigReplicator>();
+  ASSERT_TRUE(replicator);
+  auto capture = std::make_shared<DeltaCapture>();
+  z3y::ScopedConnection conn =
+      bus_->SubscribeGlobal<ConfigReplicaDeltaEvent>(capture, &DeltaCapture::OnDelta);
+
+  ConfigReplicationOptions options;
+  options.node_id = kLocalNode;
+  options.path_prefixes = {"Line."};
+  std::string err;
+  ASSERT_TRUE(replicator->Start(options, nullptr, err)) << err;
+  EXPECT_EQ(replicator->GetNodeId(), kLocalNode);
+
+  // 1. 本机修改：只有匹配前缀的键发出增量，版本只含本节点分量
+  ASSERT_TRUE(config_->SetValue("Line.Speed", int64_t{20}));
+  ASSERT_TRUE(config_->SetValue("Local.Only", int64_t{5}));
+  ASSERT_EQ(capture->Count(), 1u);
+  const ConfigReplicaDeltaEvent first = capture->Last();
+  EXPECT_EQ(first.target, 0u);
+  ASSERT_EQ(first.entries.size(), 1u);
+  EXPECT_EQ(first.entries[0].path, "Line.Speed");
+  EXPECT_EQ(std::get<int64_t>(first.entries[0].value), 20);
+  ASSERT_EQ(first.entries[0].version.size(), 1u);
+  EXPECT_EQ(first.entries[0].version[0].first, kLocalNode);
+  const uint64_t c1 = first.entries[0].version[0].second;
+
+  // 2. 覆盖本机版本的远端修改被写入，且不会作为本机修改再发出
+  FireRemote("Line.Speed", int64_t{30}, {{kLocalNode, c1}, {kRemoteNode, 1}}, 1);
+  EXPECT_EQ(std::get<int64_t>(config_->GetValue("Line.Speed")), 30);
+  EXPECT_EQ(capture->Count(), 1u);
+
+  // 3. 重复送达：版本相同，忽略
+  FireRemote("Line.Speed", int64_t{31}, {{kLocalNode, c1}, {kRemoteNode, 1}}, 1);
+  EXPECT_EQ(std::get<int64_t>(config_->GetValue("Line.Speed")), 30);
+
+  // 4. 并发修改，远端时间戳更早：本地胜出，合并后的版本回送给远端
+  ASSERT_TRUE(config_->SetValue("Line.Speed", int64_t{40}));
+  ASSERT_EQ(capture->Count(), 2u);
+  FireRemote("Line.Speed", int64_t{50}, {{kLocalNode, c1}, {kRemoteNode, 2}}, 1);
+  EXPECT_EQ(std::get<int64_t>(config_->GetValue("Line.Speed")), 40);
+  ASSERT_EQ(capture->Count(), 3u);
+  const ConfigReplicaDeltaEvent answer = capture->Last();
+  EXPECT_EQ(answer.target, kRemoteNode);
+  ASSERT_EQ(answer.entries.size(), 1u);
+  EXPECT_EQ(std::get<int64_t>(answer.entries[0].value), 40);
+  ASSERT_EQ(answer.entries[0].version.size(), 2u);
+  EXPECT_EQ(answer.entries[0].version[1], std::make_pair(kRemoteNode, uint64_t{2}));
+
+  // 5. 并发修改，远端时间戳更晚：远端胜出
+  FireRemote("Line.Speed", int64_t{60}, {{kLocalNode, c1}, {kRemoteNode, 3}}, UINT64_MAX);
+  EXPECT_EQ(std::get<int64_t>(config_->GetValue("Line.Speed")), 60);
+
+  // 6. 越界的远端值被配置服务拒绝，不记入版本
+  FireRemote("Line.Speed", int64_t{1000}, {{kLocalNode, UINT64_MAX}, {kRemoteNode, 9}}, 1);
+  EXPECT_EQ(std::get<int64_t>(config_->GetValue("Line.Speed")), 60);
+
+  const ConfigReplicationStats stats = replicator->GetStats();
+  EXPECT_EQ(stats.local_changes, 2u);
+  EXPECT_EQ(stats.remote_applied, 2u);
+  EXPECT_EQ(stats.remote_stale, 1u);
+  EXPECT_EQ(stats.conflicts_local_won, 1u);
+  EXPECT_EQ(stats.remote_rejected, 1u);
+
+  // 7. 同步请求：摘要已覆盖本机版本时无需回送；全量请求回送全部键
+  const size_t before_sync = capture->Count();
+  ConfigReplicaSyncRequestEvent up_to_date;
+  up_to_date.sender = kRemoteNode;
+  up_to_date.summary = {{kLocalNode, UINT64_MAX}, {kRemoteNode, 3}};
+  bus_->FireGlobal<ConfigReplicaSyncRequestEvent>(up_to_date);
+  EXPECT_EQ(capture->Count(), before_sync);
+
+  ConfigReplicaSyncRequestEvent full;
+  full.sender = kRemoteNode;
+  bus_->FireGlobal<ConfigReplicaSyncRequestEvent>(full);
+  ASSERT_EQ(capture->Count(), before_sync + 1);
+  const ConfigReplicaDeltaEvent snapshot = capture->Last();
+  EXPECT_EQ(snapshot.target, kRemoteNode);
+  ASSERT_EQ(snapshot.entries.size(), 1u);
+  EXPECT_EQ(std::get<int64_t>(snapshot.entries[0].value), 60);
+  EXPECT_EQ(snapshot.entries[0].origin, kRemoteNode);
+  EXPECT_EQ(replicator->GetStats().sync_entries_sent, 1u);
+
+  replicator->Stop();
+  ASSERT_TRUE(config_->SetValue("Line.Speed", int64_t{70}));
+  EXPECT_EQ(capture->Count(), before_sync + 1);
+}
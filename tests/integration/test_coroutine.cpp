@@ -0,0 +1,256 @@
+﻿/*
+* Copyright [2025] [Yue Liu]
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+ /**
+  * @file test_coroutine.cpp
+  * @brief [集成测试] C++20 协程辅助 (framework/coroutine_task.h)
+  * * @details
+  * 覆盖：Task 的嵌套等待、返回值与异常传播；Schedule / ScheduleAfter 切换到执行器线程；
+  * NextEvent 在发布者线程上恢复并断开订阅；执行器丢弃任务时协程收到 TaskCancelled；
+  * AwaitRequest 的同步完成、异步回复与失败。
+  * 工程按 C++17 编译时 (未开启 Z3Y_ENABLE_COROUTINES) 只保留一个跳过的占位测试。
+  */
+
+#include "common/plugin_test_base.h"
+#include "framework/coroutine_task.h"
+#include "framework/z3y_define_impl.h"
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <string>
+#include <thread>
+
+#if Z3Y_HAS_COROUTINES
+
+using namespace z3y;
+
+/** @brief 测试事件：携带一个整数负载。 */
+struct CoroutineTestEvent : public z3y::Event {
+    Z3Y_DEFINE_EVENT(CoroutineTestEvent, "z3y-test-evt-coroutine-001");
+    int value;
+    explicit CoroutineTestEvent(int v) : value(v) {}
+};
+
+class CoroutineTest : public PluginTestBase {
+protected:
+    void SetUp() override {
+        PluginTestBase::SetUp();
+        bus_ = manager_->GetService<IEventBus>(clsid::kEventBus);
+        executor_ = manager_->GetService<IExecutorService>(clsid::kExecutor);
+    }
+    void TearDown() override {
+        bus_.reset();
+        executor_.reset();
+        PluginTestBase::TearDown();
+    }
+
+    /** @brief 启动协程并阻塞等待其结束，返回它抛出的异常 (无异常为空)。 */
+    static std::exception_ptr RunToCompletion(Task<void> task) {
+        auto done = std::make_shared<std::promise<std::exception_ptr>>();
+        auto future = done->get_future();
+        Spawn(std::move(task), [done](std::exception_ptr e) { done->set_value(e); });
+        if (future.wait_for(std::chrono::seconds(5)) != std::future_status::ready) {
+            ADD_FAILURE() << "coroutine did not finish";
+            return nullptr;
+        }
+        return future.get();
+    }
+
+    PluginPtr<IEventBus> bus_;
+    PluginPtr<IExecutorService> executor_;
+};
+
+namespace {
+    Task<int> Twice(int v) { co_return v * 2; }
+    Task<int> SumOfTwice(int a, int b) { co_return co_await Twice(a) + co_await Twice(b); }
+    Task<int> Fails() {
+        throw std::runtime_error("inner failure");
+        co_return 0;
+    }
+}  // namespace
+
+/**
+ * @test Task 的嵌套等待与异常传播。
+ * @brief 没有任何挂起点的协程链在当前线程上同步跑完；内层异常在外层 co_await 处重新抛出。
+ */
+TEST_F(CoroutineTest, TaskChainsValuesAndExceptions) {
+    int result = 0;
+    bool caught = false;
+    std::thread::id ran_on;
+    auto body = [&]() -> Task<void> {
+        result = co_await SumOfTwice(3, 4);
+        try {
+            co_await Fails();
+        } catch (const std::runtime_error& e) {
+            caught = std::string(e.what()) == "inner failure";
+        }
+        ran_on = std::this_thread::get_id();
+    };
+    EXPECT_EQ(RunToCompletion(body()), nullptr);
+    EXPECT_EQ(result, 14);
+    EXPECT_TRUE(caught);
+    EXPECT_EQ(ran_on, std::this_thread::get_id());
+
+    auto failing = []() -> Task<void> { co_await Fails(); };
+    EXPECT_NE(RunToCompletion(failing()), nullptr);
+}
+
+/**
+ * @test Schedule / ScheduleAfter / 串行队列 把协程的后续部分转移到池线程上。
+ */
+TEST_F(CoroutineTest, ScheduleResumesOnExecutorThreads) {
+    const std::thread::id caller = std::this_thread::get_id();
+    std::thread::id after_post, after_delay, after_strand;
+    std::chrono::steady_clock::duration waited{};
+    auto executor = executor_;
+    auto body = [executor, &after_post, &after_delay, &after_strand, &waited]() -> Task<void> {
+        co_await Schedule(executor, TaskPriority::kHigh);
+        after_post = std::this_thread::get_id();
+        auto start = std::chrono::steady_clock::now();
+        co_await ScheduleAfter(executor, std::chrono::milliseconds(20));
+        waited = std::chrono::steady_clock::now() - start;
+        after_delay = std::this_thread::get_id();
+        co_await Schedule(executor->GetSerialQueue("test.coroutine"));
+        after_strand = std::this_thread::get_id();
+    };
+    EXPECT_EQ(RunToCompletion(body()), nullptr);
+    EXPECT_NE(after_post, caller);
+    EXPECT_NE(after_delay, caller);
+    EXPECT_NE(after_strand, caller);
+    EXPECT_GE(waited, std::chrono::milliseconds(20));
+}
+
+/**
+ * @test NextEvent 在发布者线程上直接恢复，收到事件副本，订阅随之断开。
+ */
+TEST_F(CoroutineTest, NextEventResumesInlineAndDisconnects) {
+    std::atomic<bool> finished{ false };
+    int first = 0;
+    int second = 0;
+    std::thread::id resumed_on;
+    auto bus = bus_;
+    auto body = [bus, &first, &second, &resumed_on]() -> Task<void> {
+        first = (co_await NextEvent<CoroutineTestEvent>(bus)).value;
+        resumed_on = std::this_thread::get_id();
+        second = (co_await NextEvent<CoroutineTestEvent>(bus)).value;
+    };
+    Spawn(body(), [&finished](std::exception_ptr) { finished = true; });
+
+    EXPECT_FALSE(finished.load());
+    EXPECT_TRUE(bus_->IsGlobalSubscribed(CoroutineTestEvent::kEventId));
+
+    std::thread publisher([this] { bus_->FireGlobal<CoroutineTestEvent>(7); });
+    const std::thread::id publisher_id = publisher.get_id();
+    publisher.join();
+    EXPECT_EQ(first, 7);
+    EXPECT_EQ(resumed_on, publisher_id);
+    EXPECT_FALSE(finished.load());
+
+    bus_->FireGlobal<CoroutineTestEvent>(8);
+    EXPECT_TRUE(finished.load());
+    EXPECT_EQ(second, 8);
+    // 断开只撕票据，订阅列表由 GC 稍后压缩
+    for (int i = 0; i < 200 && bus_->IsGlobalSubscribed(CoroutineTestEvent::kEventId); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    EXPECT_FALSE(bus_->IsGlobalSubscribed(CoroutineTestEvent::kEventId));
+    bus_->FireGlobal<CoroutineTestEvent>(9);
+    EXPECT_EQ(second, 8);
+}
+
+/**
+ * @test GetServiceAsync 在执行器上获取服务；执行器丢弃的协程收到 TaskCancelled 而不是泄漏。
+ */
+TEST_F(CoroutineTest, AsyncServiceAndCancellation) {
+    PluginPtr<IEventBus> fetched;
+    auto executor = executor_;
+    auto body = [executor, &fetched]() -> Task<void> {
+        fetched = co_await GetServiceAsync<IEventBus>(executor, clsid::kEventBus);
+    };
+    EXPECT_EQ(RunToCompletion(body()), nullptr);
+    EXPECT_EQ(fetched, bus_);
+
+    std::atomic<bool> cancelled{ false };
+    auto sleeper = [executor, &cancelled]() -> Task<void> {
+        try {
+            co_await ScheduleAfter(executor, std::chrono::seconds(30));
+        } catch (const TaskCancelled&) {
+            cancelled = true;
+        }
+    };
+    Spawn(sleeper());
+    EXPECT_FALSE(cancelled.load());
+    // 卸载全部插件时执行器丢弃未到期的定时器，协程随之恢复并展开
+    manager_->UnloadAllPlugins();
+    EXPECT_TRUE(cancelled.load());
+}
+
+/** @brief AwaitRequest 测试用的请求与处理者。 */
+struct CoroutineQuery : public z3y::Event {
+    Z3Y_DEFINE_EVENT(CoroutineQuery, "z3y-test-evt-coroutine-query-002");
+    int value;
+    explicit CoroutineQuery(int v) : value(v) {}
+};
+
+class CoroutineQueryHandler : public std::enable_shared_from_this<CoroutineQueryHandler> {
+public:
+    std::string OnQuery(const CoroutineQuery& q) { return std::to_string(q.value); }
+};
+
+/**
+ * @test AwaitRequest：kDirect 处理者同步完成时不挂起；kQueued 处理者在线程池上回复后恢复；
+ * 没有处理者时 RequestError 从 co_await 处抛出。
+ */
+TEST_F(CoroutineTest, AwaitRequestResumesWithReply) {
+    auto handler = std::make_shared<CoroutineQueryHandler>();
+    auto bus = bus_;
+    std::string direct, queued;
+    RequestErrorCode failure = RequestErrorCode::kRejected;
+    {
+        ScopedConnection conn = bus_->HandleRequests<CoroutineQuery>(
+            handler, &CoroutineQueryHandler::OnQuery, ConnectionType::kDirect);
+        auto body = [bus, &direct]() -> Task<void> {
+            direct = co_await AwaitRequest<CoroutineQuery, std::string>(bus, CoroutineQuery(1));
+        };
+        EXPECT_EQ(RunToCompletion(body()), nullptr);
+    }
+    {
+        ScopedConnection conn = bus_->HandleRequests<CoroutineQuery>(handler, &CoroutineQueryHandler::OnQuery);
+        auto body = [bus, &queued]() -> Task<void> {
+            queued = co_await AwaitRequest<CoroutineQuery, std::string>(bus, CoroutineQuery(2));
+        };
+        EXPECT_EQ(RunToCompletion(body()), nullptr);
+    }
+    auto missing = [bus, &failure]() -> Task<void> {
+        try {
+            (void)co_await AwaitRequest<CoroutineQuery, std::string>(bus, CoroutineQuery(3));
+        } catch (const RequestError& e) {
+            failure = e.code();
+        }
+    };
+    EXPECT_EQ(RunToCompletion(missing()), nullptr);
+    EXPECT_EQ(direct, "1");
+    EXPECT_EQ(queued, "2");
+    EXPECT_EQ(failure, RequestErrorCode::kNoHandler);
+}
+
+#else  // !Z3Y_HAS_COROUTINES
+
+TEST(CoroutineTest, RequiresCpp20) {
+    GTEST_SKIP() << "coroutine helpers need Z3Y_ENABLE_COROUTINES (C++20)";
+}
+
+#endif  // Z3Y_HAS_COROUTINES
@@ -28,13 +28,22 @@
  * 5. 异常处理 (OOB Handler)
  * 6. 事件追踪钩子 (Trace Hook)
  * 7. 重入安全性 (Reentrancy)
+ * 8. 多线程派发池 (Sharded Dispatch Workers)
  */
 
 #include "common/plugin_test_base.h"
 #include "framework/z3y_define_impl.h" 
+#include "framework/event_channel.h"
+#include "framework/event_window.h"
+#include <algorithm>
+#include <array>
+#include <filesystem>
+#include <memory_resource>
+#include <fstream>
 #include <thread>
 #include <vector>
 #include <atomic>
+#include <mutex>
 
 using namespace z3y;
 
@@ -62,6 +71,24 @@ struct TestRecursiveEvent : public z3y::Event {
     explicit TestRecursiveEvent(int d) : depth(d) {}
 };
 
+/** @brief 测试事件：池化构造 (高频小事件)。 */
+struct TestPooledEvent : public z3y::Event {
+    Z3Y_DEFINE_POOLED_EVENT(TestPooledEvent, "z3y-test-evt-pooled-004");
+    int id;
+    explicit TestPooledEvent(int i) : id(i) {}
+};
+
+/** @brief 测试事件：事件族订阅 (父族、子族、名字相近但无关的族)。 */
+struct TestFamilyEventA : public z3y::Event {
+    Z3Y_DEFINE_EVENT_IN_FAMILY(TestFamilyEventA, "z3y-test-evt-family-a-005", "z3y-test/family")
+};
+struct TestFamilyEventB : public z3y::Event {
+    Z3Y_DEFINE_EVENT_IN_FAMILY(TestFamilyEventB, "z3y-test-evt-family-b-006", "z3y-test/family/child/")
+};
+struct TestFamilyEventOther : public z3y::Event {
+    Z3Y_DEFINE_EVENT_IN_FAMILY(TestFamilyEventOther, "z3y-test-evt-family-x-007", "z3y-test/familyx")
+};
+
 /** @brief Mock 发送者组件。 */
 class MockSender : public z3y::PluginImpl<MockSender> {
 public:
@@ -88,11 +115,58 @@ public:
         last_thread_id = std::this_thread::get_id();
     }
 
+    void OnPooled(const TestPooledEvent& e) {
+        received_count++;
+        last_received_id = e.id;
+    }
+
     void OnThrowingEvent(const TestPayloadEvent& e) {
         throw std::runtime_error("Intentional Test Exception");
     }
 };
 
+/**
+ * @brief 派发线程阻塞器：在派发线程上执行一个一直等待的 kQueued 回调，
+ * 让之后投递到该线程的任务只能积压在队列中。
+ */
+class QueueBlocker : public std::enable_shared_from_this<QueueBlocker> {
+public:
+    std::atomic<bool> entered{ false };
+    std::atomic<bool> release{ false };
+
+    void OnSignal(const TestSignalEvent&) {
+        entered = true;
+        while (!release.load()) std::this_thread::yield();
+    }
+
+    /** @brief 订阅并触发一次信号，返回时派发线程已被占住。 */
+    z3y::Connection Block(const z3y::PluginPtr<z3y::IEventBus>& bus) {
+        z3y::Connection conn = bus->SubscribeGlobal<TestSignalEvent>(
+            shared_from_this(), &QueueBlocker::OnSignal, ConnectionType::kQueued);
+        bus->FireGlobal<TestSignalEvent>();
+        while (!entered.load()) std::this_thread::yield();
+        return conn;
+    }
+};
+
+/** @brief 有序接收者：记录收到的事件序号，用于验证派发顺序。 */
+class OrderedReceiver : public z3y::PluginImpl<OrderedReceiver> {
+public:
+    Z3Y_DEFINE_COMPONENT_ID("z3y-test-ordered-receiver-UUID");
+
+    std::mutex mtx;
+    std::vector<int> sequence;
+    std::atomic<int> received_count{ 0 };
+
+    void OnEvent(const TestPayloadEvent& e) {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            sequence.push_back(e.id);
+        }
+        received_count++;
+    }
+};
+
 /** @brief 辅助类：用于测试重入（在回调中操作总线）。 */
 class ReentrancyHelper : public z3y::PluginImpl<ReentrancyHelper> {
 public:
@@ -294,6 +368,8 @@ TEST_F(EventSystemTest, Debug_EventTracing) {
         EXPECT_TRUE(fired_found);
         EXPECT_TRUE(call_found);
     }
+    // 钩子按引用捕获了局部 traces：离开作用域前必须摘除，卸载阶段仍会触发追踪点
+    manager_->SetEventTraceHook(nullptr);
 }
 
 TEST_F(EventSystemTest, Reentrancy_UnsubscribeSelf) {
@@ -345,3 +421,1860 @@ TEST_F(EventSystemTest, UnsubscribeAll_ForSubscriber) {
     bus_->FireToSender<TestPayloadEvent>(sender1_, 1, "msg");
     EXPECT_EQ(receiver_->received_count, 0);
 }
+
+TEST_F(EventSystemTest, UnsubscribeAll_RevokesAtOnceAndCompactsInOneGCPass) {
+    // 放宽每轮 GC 的时间预算，单轮能否做完不取决于机器快慢 (Debug 构建下 1ms 不够)
+    manager_.reset();
+    z3y::PluginManager::Destroy();
+    z3y::PluginManagerOptions options;
+    options.gc_pass_budget = std::chrono::seconds(10);
+    manager_ = z3y::PluginManager::Create(options);
+    bus_ = z3y::GetDefaultService<IEventBus>();
+
+    // 堵住派发线程：批量取消订阅只撕票，列表的压缩必须由 (一个) GC 批处理完成
+    auto blocker = std::make_shared<QueueBlocker>();
+    z3y::ScopedConnection block_conn = blocker->Block(bus_);
+    constexpr int kSenders = 200;
+    std::vector<std::shared_ptr<MockSender>> senders;
+    std::vector<z3y::Connection> conns;
+    auto bystander = std::make_shared<MockReceiver>();
+    bystander->Initialize();
+    for (int i = 0; i < kSenders; ++i) {
+        senders.push_back(std::make_shared<MockSender>());
+        conns.push_back(bus_->SubscribeToSender<TestPayloadEvent>(senders.back(), receiver_, &MockReceiver::OnEvent));
+    }
+    conns.push_back(bus_->SubscribeGlobal<TestSignalEvent>(receiver_, &MockReceiver::OnSignal));
+    z3y::ScopedConnection bystander_conn = bus_->SubscribeGlobal<TestSignalEvent>(bystander, &MockReceiver::OnSignal);
+
+    std::atomic<int> gc_tasks{ 0 };
+    manager_->SetEventTraceHook([&gc_tasks](EventTracePoint point, EventId id, void*, const char*) {
+        if (point == EventTracePoint::kQueuedExecuteStart && id != TestSignalEvent::kEventId) gc_tasks++;
+        });
+
+    bus_->Unsubscribe(receiver_);
+    for (const auto& conn : conns) EXPECT_FALSE(conn.IsConnected());
+    for (auto& sender : senders) bus_->FireToSender<TestPayloadEvent>(sender, 1, "revoked");
+    bus_->FireGlobal<TestSignalEvent>();
+    EXPECT_EQ(receiver_->received_count.load(), 0);
+    EXPECT_EQ(bystander->received_count.load(), 1);
+
+    blocker->release = true;
+    for (int i = 0; i < 200 && bus_->IsSenderSubscribed(senders.back(), TestPayloadEvent::kEventId); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    manager_->SetEventTraceHook(nullptr);
+
+    EXPECT_EQ(gc_tasks.load(), 1);
+    for (auto& sender : senders) {
+        EXPECT_FALSE(bus_->IsSenderSubscribed(sender, TestPayloadEvent::kEventId));
+    }
+    EXPECT_TRUE(bus_->IsGlobalSubscribed(TestSignalEvent::kEventId));
+
+    // 反查表已清空：重新订阅后再次批量取消依然完整生效
+    z3y::Connection again = bus_->SubscribeToSender<TestPayloadEvent>(senders[0], receiver_, &MockReceiver::OnEvent);
+    bus_->FireToSender<TestPayloadEvent>(senders[0], 2, "again");
+    EXPECT_EQ(receiver_->received_count.load(), 1);
+    bus_->Unsubscribe(receiver_);
+    bus_->FireToSender<TestPayloadEvent>(senders[0], 3, "gone");
+    EXPECT_EQ(receiver_->received_count.load(), 1);
+}
+
+TEST_F(EventSystemTest, QueuedDispatch_MultiWorkerPreservesPerSubscriberOrder) {
+    // 使用 4 个派发线程重建框架
+    manager_.reset();
+    z3y::PluginManager::Destroy();
+    z3y::PluginManagerOptions options;
+    options.event_dispatch_threads = 4;
+    manager_ = z3y::PluginManager::Create(options);
+    bus_ = z3y::GetDefaultService<IEventBus>();
+    ASSERT_EQ(manager_->GetEventDispatchThreadCount(), 4u);
+
+    constexpr int kSubscriberCount = 8;
+    constexpr int kEventCount = 500;
+    std::vector<std::shared_ptr<OrderedReceiver>> receivers;
+    std::vector<z3y::ScopedConnection> conns;
+    for (int i = 0; i < kSubscriberCount; ++i) {
+        auto r = std::make_shared<OrderedReceiver>();
+        r->Initialize();
+        conns.emplace_back(bus_->SubscribeGlobal<TestPayloadEvent>(
+            r, &OrderedReceiver::OnEvent, ConnectionType::kQueued));
+        receivers.push_back(r);
+    }
+
+    for (int i = 0; i < kEventCount; ++i) {
+        bus_->FireGlobal<TestPayloadEvent>(i, "seq");
+    }
+
+    for (auto& r : receivers) {
+        int retries = 2000;
+        while (r->received_count < kEventCount && retries-- > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        ASSERT_EQ(r->received_count, kEventCount);
+        std::lock_guard<std::mutex> lock(r->mtx);
+        // 每个订阅者都必须按发布顺序收到事件
+        for (int i = 0; i < kEventCount; ++i) {
+            ASSERT_EQ(r->sequence[i], i);
+        }
+    }
+}
+
+TEST_F(EventSystemTest, QueuedDispatch_RingOverflowKeepsProducerFifo) {
+    // 故意把环形队列设得极小，迫使大量任务走溢出区
+    manager_.reset();
+    z3y::PluginManager::Destroy();
+    z3y::PluginManagerOptions options;
+    options.event_queue_capacity = 4;
+    manager_ = z3y::PluginManager::Create(options);
+    bus_ = z3y::GetDefaultService<IEventBus>();
+
+    auto r = std::make_shared<OrderedReceiver>();
+    r->Initialize();
+    z3y::ScopedConnection conn = bus_->SubscribeGlobal<TestPayloadEvent>(
+        r, &OrderedReceiver::OnEvent, ConnectionType::kQueued);
+
+    constexpr int kProducers = 4;
+    constexpr int kPerProducer = 1000;
+    std::vector<std::thread> producers;
+    for (int p = 0; p < kProducers; ++p) {
+        producers.emplace_back([this, p] {
+            for (int i = 0; i < kPerProducer; ++i) {
+                bus_->FireGlobal<TestPayloadEvent>(p * kPerProducer + i, "spill");
+            }
+        });
+    }
+    for (auto& t : producers) t.join();
+
+    int retries = 5000;
+    while (r->received_count < kProducers * kPerProducer && retries-- > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    ASSERT_EQ(r->received_count, kProducers * kPerProducer);
+
+    // 同一生产者的事件必须保持发布顺序
+    std::vector<int> last_seen(kProducers, -1);
+    std::lock_guard<std::mutex> lock(r->mtx);
+    for (int id : r->sequence) {
+        int p = id / kPerProducer;
+        int seq = id % kPerProducer;
+        ASSERT_GT(seq, last_seen[p]);
+        last_seen[p] = seq;
+    }
+}
+
+TEST_F(EventSystemTest, QueuedDispatch_SingleFireIsOneBatchPerWorker) {
+    std::atomic<int> exec_batches{ 0 };
+    manager_->SetEventTraceHook([&](EventTracePoint pt, EventId id, void*, const char*) {
+        if (pt == EventTracePoint::kQueuedExecuteStart && id == TestPayloadEvent::kEventId) exec_batches++;
+        });
+
+    // 第一个订阅者抛异常，不应影响同批中的其他订阅者
+    z3y::ScopedConnection throwing_conn = bus_->SubscribeGlobal<TestPayloadEvent>(
+        receiver_, &MockReceiver::OnThrowingEvent, ConnectionType::kQueued);
+
+    constexpr int kListeners = 50;
+    std::vector<std::shared_ptr<MockReceiver>> receivers;
+    std::vector<z3y::ScopedConnection> conns;
+    for (int i = 0; i < kListeners; ++i) {
+        auto r = std::make_shared<MockReceiver>();
+        r->Initialize();
+        conns.emplace_back(bus_->SubscribeGlobal<TestPayloadEvent>(
+            r, &MockReceiver::OnEvent, ConnectionType::kQueued));
+        receivers.push_back(r);
+    }
+
+    bus_->FireGlobal<TestPayloadEvent>(7, "batch");
+
+    auto all_received = [&] {
+        for (const auto& r : receivers) if (r->received_count != 1) return false;
+        return true;
+    };
+    int retries = 1000;
+    while (!all_received() && retries-- > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    ASSERT_TRUE(all_received());
+
+    // 默认只有一个派发线程：51 个 kQueued 订阅者只应产生一个批任务
+    EXPECT_EQ(exec_batches.load(), 1);
+    manager_->SetEventTraceHook(nullptr);
+}
+
+TEST_F(EventSystemTest, PooledEvent_SteadyStateReusesBlocks) {
+    // 预热：第一次构造需要向堆申请一个块
+    { auto warmup = z3y::MakeEvent<TestPooledEvent>(0); }
+    z3y::EventPoolStats before = z3y::GetEventPoolStats();
+
+    constexpr int kIterations = 1000;
+    for (int i = 1; i <= kIterations; ++i) {
+        auto e = z3y::MakeEvent<TestPooledEvent>(i);
+        ASSERT_EQ(e->id, i);
+    }
+    z3y::EventPoolStats after = z3y::GetEventPoolStats();
+
+    // 稳态下不应再访问全局堆
+    EXPECT_EQ(after.heap_allocations, before.heap_allocations);
+    EXPECT_EQ(after.pool_hits - before.pool_hits, static_cast<size_t>(kIterations));
+}
+
+TEST_F(EventSystemTest, DirectOnlyFire_PromotesToHeapOnlyForQueued) {
+    z3y::ScopedConnection direct_conn = bus_->SubscribeGlobal<TestPooledEvent>(
+        receiver_, &MockReceiver::OnPooled, ConnectionType::kDirect);
+
+    // 1. 纯 kDirect：事件在栈上构造，完全不经过池/堆
+    z3y::EventPoolStats before = z3y::GetEventPoolStats();
+    for (int i = 1; i <= 100; ++i) {
+        bus_->FireGlobal<TestPooledEvent>(i);
+    }
+    z3y::EventPoolStats after = z3y::GetEventPoolStats();
+    EXPECT_EQ(receiver_->received_count, 100);
+    EXPECT_EQ(receiver_->last_received_id, 100);
+    EXPECT_EQ(after.heap_allocations + after.pool_hits, before.heap_allocations + before.pool_hits);
+
+    // 2. 出现 kQueued 订阅者后，每次 Fire 恰好提升一次
+    auto queued_receiver = std::make_shared<MockReceiver>();
+    queued_receiver->Initialize();
+    z3y::ScopedConnection queued_conn = bus_->SubscribeGlobal<TestPooledEvent>(
+        queued_receiver, &MockReceiver::OnPooled, ConnectionType::kQueued);
+
+    before = z3y::GetEventPoolStats();
+    bus_->FireGlobal<TestPooledEvent>(101);
+    after = z3y::GetEventPoolStats();
+    EXPECT_EQ(after.heap_allocations + after.pool_hits, before.heap_allocations + before.pool_hits + 1);
+
+    int retries = 1000;
+    while (queued_receiver->received_count == 0 && retries-- > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_EQ(queued_receiver->received_count, 1);
+    EXPECT_EQ(queued_receiver->last_received_id, 101);
+    EXPECT_EQ(receiver_->last_received_id, 101);
+}
+
+TEST_F(EventSystemTest, ConcurrentFireWithSubscriptionChurn) {
+    // 常驻订阅者：必须收到每一次 Fire
+    z3y::ScopedConnection stable_conn = bus_->SubscribeGlobal<TestSignalEvent>(
+        receiver_, &MockReceiver::OnSignal, ConnectionType::kDirect);
+
+    constexpr int kFirers = 4;
+    constexpr int kFiresPerThread = 20000;
+    std::atomic<bool> firing{ true };
+    std::vector<std::thread> firers;
+    for (int t = 0; t < kFirers; ++t) {
+        firers.emplace_back([this] {
+            for (int i = 0; i < kFiresPerThread; ++i) {
+                bus_->FireGlobal<TestSignalEvent>();
+            }
+            });
+    }
+
+    // 发布期间不断增删订阅，迫使读侧列表被反复替换与回收
+    std::thread churn([this, &firing] {
+        while (firing.load()) {
+            auto r = std::make_shared<MockReceiver>();
+            r->Initialize();
+            z3y::ScopedConnection conn = bus_->SubscribeGlobal<TestSignalEvent>(
+                r, &MockReceiver::OnSignal, ConnectionType::kDirect);
+            std::this_thread::yield();
+        }
+        });
+
+    for (auto& t : firers) t.join();
+    firing = false;
+    churn.join();
+
+    EXPECT_EQ(receiver_->received_count, kFirers * kFiresPerThread);
+}
+
+TEST_F(EventSystemTest, EventSlot_CachedSlotSurvivesManagerRecreation) {
+    // 第一次 Fire 会为 TestRecursiveEvent 解析并缓存槽号 (此时无人订阅)
+    bus_->FireGlobal<TestRecursiveEvent>(0);
+    EXPECT_FALSE(bus_->IsGlobalSubscribed(TestRecursiveEvent::kEventId));
+
+    // 重建管理器：缓存的槽号是进程级的，必须在新实例上依然有效
+    bus_.reset();
+    manager_.reset();
+    z3y::PluginManager::Destroy();
+    manager_ = z3y::PluginManager::Create();
+    bus_ = z3y::GetDefaultService<IEventBus>();
+
+    std::atomic<int> depth_sum{ 0 };
+    struct Probe : std::enable_shared_from_this<Probe> {
+        std::atomic<int>* sum = nullptr;
+        void OnRecursive(const TestRecursiveEvent& e) { *sum += e.depth; }
+    };
+    auto probe = std::make_shared<Probe>();
+    probe->sum = &depth_sum;
+    z3y::ScopedConnection conn = bus_->SubscribeGlobal<TestRecursiveEvent>(probe, &Probe::OnRecursive);
+
+    EXPECT_TRUE(bus_->IsGlobalSubscribed(TestRecursiveEvent::kEventId));
+    bus_->FireGlobal<TestRecursiveEvent>(5);
+    bus_->FireGlobal<TestRecursiveEvent>(7);
+    EXPECT_EQ(depth_sum.load(), 12);
+}
+
+TEST_F(EventSystemTest, SenderSpecific_ManySendersStayIsolatedAcrossAddressReuse) {
+    // 足够多的发送者，迫使读侧哈希表扩容重建
+    constexpr int kSenders = 300;
+    std::vector<std::shared_ptr<MockSender>> senders;
+    std::vector<std::shared_ptr<MockReceiver>> receivers;
+    std::vector<z3y::ScopedConnection> conns;
+    for (int i = 0; i < kSenders; ++i) {
+        senders.push_back(std::make_shared<MockSender>());
+        receivers.push_back(std::make_shared<MockReceiver>());
+        receivers.back()->Initialize();
+        conns.emplace_back(bus_->SubscribeToSender<TestPayloadEvent>(
+            senders.back(), receivers.back(), &MockReceiver::OnEvent));
+    }
+
+    for (int i = 0; i < kSenders; ++i) {
+        bus_->FireToSender<TestPayloadEvent>(senders[i], i, "to-one");
+    }
+    for (int i = 0; i < kSenders; ++i) {
+        EXPECT_EQ(receivers[i]->received_count, 1);
+        EXPECT_EQ(receivers[i]->last_received_id, i);
+        EXPECT_TRUE(bus_->IsSenderSubscribed(senders[i], TestPayloadEvent::kEventId));
+    }
+
+    // 发送者销毁后，新对象很可能落在同一地址上：不得继承旧发送者的订阅
+    std::weak_ptr<MockSender> old_sender = senders[0];
+    senders[0].reset();
+    ASSERT_TRUE(old_sender.expired());
+    auto reused = std::make_shared<MockSender>();
+    EXPECT_FALSE(bus_->IsSenderSubscribed(reused, TestPayloadEvent::kEventId));
+    bus_->FireToSender<TestPayloadEvent>(reused, -1, "reused");
+    EXPECT_EQ(receivers[0]->received_count, 1);
+
+    // 新发送者可以正常订阅
+    z3y::ScopedConnection reused_conn = bus_->SubscribeToSender<TestPayloadEvent>(
+        reused, receiver_, &MockReceiver::OnEvent);
+    bus_->FireToSender<TestPayloadEvent>(reused, 42, "reused");
+    EXPECT_EQ(receiver_->received_count, 1);
+    EXPECT_EQ(receiver_->last_received_id, 42);
+    EXPECT_EQ(receivers[0]->received_count, 1);
+}
+
+TEST_F(EventSystemTest, SenderSpecific_ExpiredSendersReclaimedWithoutUnsubscribe) {
+    // 长寿命订阅者订阅大量短寿命发送者且从不退订：发送者销毁后不会再有人向它发布
+    auto count_sender_subs = [this]() {
+        size_t n = 0;
+        for (const auto& sub : manager_->GetEventDispatchMetrics().subscribers) {
+            if (sub.event_id == TestPayloadEvent::kEventId) ++n;
+        }
+        return n;
+    };
+    (void)bus_->SubscribeToSender<TestPayloadEvent>(sender1_, receiver_, &MockReceiver::OnEvent);
+    constexpr int kJobs = 5000;
+    // 保留弱引用：make_shared 的内存块要等弱引用也释放才归还，新发送者不会复用旧地址
+    std::vector<std::weak_ptr<MockSender>> finished_jobs;
+    for (int i = 0; i < kJobs; ++i) {
+        auto job_sender = std::make_shared<MockSender>();
+        (void)bus_->SubscribeToSender<TestPayloadEvent>(job_sender, receiver_, &MockReceiver::OnEvent);
+        finished_jobs.push_back(job_sender);
+    }
+
+    // 表规模翻倍时批量回收，记录数与存活发送者数成正比，而不是随历史发送者数增长
+    EXPECT_LT(count_sender_subs(), 200u);
+
+    // 存活发送者的订阅不受影响；回收后按订阅者退订仍然正常
+    bus_->FireToSender<TestPayloadEvent>(sender1_, 7, "live");
+    EXPECT_EQ(receiver_->received_count, 1);
+    EXPECT_EQ(receiver_->last_received_id, 7);
+    bus_->Unsubscribe(receiver_);
+    bus_->FireToSender<TestPayloadEvent>(sender1_, 8, "after-unsubscribe");
+    EXPECT_EQ(receiver_->received_count, 1);
+}
+
+TEST_F(EventSystemTest, QueuedCoalesced_DeliversOnlyLatestPendingPayload) {
+    // 先用一个 kQueued 回调堵住 (唯一的) 派发线程，让后续事件只能积压
+    auto blocker = std::make_shared<QueueBlocker>();
+    z3y::ScopedConnection block_conn = blocker->Block(bus_);
+    z3y::ScopedConnection conn = bus_->SubscribeGlobal<TestPayloadEvent>(
+        receiver_, &MockReceiver::OnEvent, ConnectionType::kQueuedCoalesced);
+
+    constexpr int kFires = 100;
+    for (int i = 0; i < kFires; ++i) {
+        bus_->FireGlobal<TestPayloadEvent>(i, "state");
+    }
+    blocker->release = true;
+
+    for (int i = 0; i < 200 && receiver_->received_count == 0; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(receiver_->received_count, 1);
+    EXPECT_EQ(receiver_->last_received_id, kFires - 1);
+
+    // 信箱被取空后，下一次 Fire 重新排队投递
+    bus_->FireGlobal<TestPayloadEvent>(kFires, "state");
+    for (int i = 0; i < 200 && receiver_->received_count < 2; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    EXPECT_EQ(receiver_->received_count, 2);
+    EXPECT_EQ(receiver_->last_received_id, kFires);
+}
+
+TEST_F(EventSystemTest, QueuedOverflow_DropNewestSparesPriorityEvents) {
+    manager_.reset();
+    z3y::PluginManager::Destroy();
+    z3y::PluginManagerOptions options;
+    options.event_queue_max_pending = 4;
+    options.event_queue_overflow_policy = z3y::EventQueueOverflowPolicy::kDropNewest;
+    options.event_queue_priority_events.insert(TestSignalEvent::kEventId);
+    manager_ = z3y::PluginManager::Create(options);
+    bus_ = z3y::GetDefaultService<IEventBus>();
+
+    std::atomic<int> traced_drops{ 0 };
+    manager_->SetEventTraceHook([&traced_drops](EventTracePoint point, EventId, void*, const char*) {
+        if (point == EventTracePoint::kQueuedDropped) traced_drops++;
+        });
+
+    auto blocker = std::make_shared<QueueBlocker>();
+    z3y::ScopedConnection block_conn = blocker->Block(bus_);
+    auto signal_receiver = std::make_shared<MockReceiver>();
+    signal_receiver->Initialize();
+    z3y::ScopedConnection payload_conn = bus_->SubscribeGlobal<TestPayloadEvent>(
+        receiver_, &MockReceiver::OnEvent, ConnectionType::kQueued);
+    z3y::ScopedConnection signal_conn = bus_->SubscribeGlobal<TestSignalEvent>(
+        signal_receiver, &MockReceiver::OnSignal, ConnectionType::kQueued);
+
+    constexpr int kFires = 50;
+    for (int i = 0; i < kFires; ++i) {
+        bus_->FireGlobal<TestPayloadEvent>(i, "burst");
+    }
+    for (int i = 0; i < 10; ++i) {
+        bus_->FireGlobal<TestSignalEvent>(); // 高优先级：不受上限约束
+    }
+    blocker->release = true;
+
+    for (int i = 0; i < 200 && signal_receiver->received_count < 10; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    // 只有最先进入的 4 个普通任务被保留，之后的全部丢弃
+    EXPECT_EQ(receiver_->received_count, 4);
+    EXPECT_EQ(receiver_->last_received_id, 3);
+    EXPECT_EQ(signal_receiver->received_count, 10);
+    EXPECT_EQ(manager_->GetEventQueueDropCount(), static_cast<size_t>(kFires - 4));
+    EXPECT_EQ(traced_drops.load(), kFires - 4);
+    manager_->SetEventTraceHook(nullptr);
+}
+
+TEST_F(EventSystemTest, QueuedOverflow_DropOldestKeepsNewestTasks) {
+    manager_.reset();
+    z3y::PluginManager::Destroy();
+    z3y::PluginManagerOptions options;
+    options.event_queue_max_pending = 4;
+    options.event_queue_overflow_policy = z3y::EventQueueOverflowPolicy::kDropOldest;
+    manager_ = z3y::PluginManager::Create(options);
+    bus_ = z3y::GetDefaultService<IEventBus>();
+
+    auto ordered = std::make_shared<OrderedReceiver>();
+    ordered->Initialize();
+    auto blocker = std::make_shared<QueueBlocker>();
+    z3y::ScopedConnection block_conn = blocker->Block(bus_);
+    z3y::ScopedConnection conn = bus_->SubscribeGlobal<TestPayloadEvent>(
+        ordered, &OrderedReceiver::OnEvent, ConnectionType::kQueued);
+
+    constexpr int kFires = 50;
+    for (int i = 0; i < kFires; ++i) {
+        bus_->FireGlobal<TestPayloadEvent>(i, "burst");
+    }
+    blocker->release = true;
+
+    for (int i = 0; i < 200 && ordered->received_count < 4; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    std::lock_guard<std::mutex> lock(ordered->mtx);
+    EXPECT_EQ(ordered->sequence, (std::vector<int>{ kFires - 4, kFires - 3, kFires - 2, kFires - 1 }));
+    EXPECT_EQ(manager_->GetEventQueueDropCount(), static_cast<size_t>(kFires - 4));
+}
+
+/**
+ * @test 测试 kDropOldest 只给被丢弃的任务立墓碑：排在它前面的不可丢弃任务 (高优先级事件)
+ * 保持原位，不会被挪到更新的任务之后。
+ */
+TEST_F(EventSystemTest, QueuedOverflow_DropOldestKeepsNonDroppableInOrder) {
+    manager_.reset();
+    z3y::PluginManager::Destroy();
+    z3y::PluginManagerOptions options;
+    options.event_queue_max_pending = 4;
+    options.event_queue_overflow_policy = z3y::EventQueueOverflowPolicy::kDropOldest;
+    options.event_queue_priority_events.insert(TestRecursiveEvent::kEventId);
+    manager_ = z3y::PluginManager::Create(options);
+    bus_ = z3y::GetDefaultService<IEventBus>();
+
+    struct TraceProbe : std::enable_shared_from_this<TraceProbe> {
+        std::mutex mtx;
+        std::vector<int> trace;  // 高优先级事件记为 -1
+        void OnPayload(const TestPayloadEvent& e) {
+            std::lock_guard<std::mutex> lock(mtx);
+            trace.push_back(e.id);
+        }
+        void OnPriority(const TestRecursiveEvent&) {
+            std::lock_guard<std::mutex> lock(mtx);
+            trace.push_back(-1);
+        }
+    };
+    auto probe = std::make_shared<TraceProbe>();
+    auto blocker = std::make_shared<QueueBlocker>();
+    z3y::ScopedConnection block_conn = blocker->Block(bus_);
+    z3y::ScopedConnection payload_conn = bus_->SubscribeGlobal<TestPayloadEvent>(
+        probe, &TraceProbe::OnPayload, ConnectionType::kQueued);
+    z3y::ScopedConnection priority_conn = bus_->SubscribeGlobal<TestRecursiveEvent>(
+        probe, &TraceProbe::OnPriority, ConnectionType::kQueued);
+
+    constexpr int kFires = 10;
+    bus_->FireGlobal<TestRecursiveEvent>(0);
+    for (int i = 0; i < kFires; ++i) {
+        bus_->FireGlobal<TestPayloadEvent>(i, "burst");
+    }
+    bus_->FireGlobal<TestRecursiveEvent>(0);
+    blocker->release = true;
+
+    const std::vector<int> expected{ -1, kFires - 3, kFires - 2, kFires - 1, -1 };
+    for (int i = 0; i < 200; ++i) {
+        {
+            std::lock_guard<std::mutex> lock(probe->mtx);
+            if (probe->trace.size() >= expected.size()) break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    std::lock_guard<std::mutex> lock(probe->mtx);
+    EXPECT_EQ(probe->trace, expected);
+    EXPECT_EQ(manager_->GetEventQueueDropCount(), static_cast<size_t>(kFires - 3));
+}
+
+TEST_F(EventSystemTest, PriorityLanes_HigherLanesDrainFirst) {
+    struct LaneProbe : std::enable_shared_from_this<LaneProbe> {
+        char label = '?';
+        std::mutex* mtx = nullptr;
+        std::string* trace = nullptr;
+        void OnEvent(const TestPayloadEvent&) {
+            std::lock_guard<std::mutex> lock(*mtx);
+            trace->push_back(label);
+        }
+    };
+    std::mutex mtx;
+    std::string trace;
+    auto make_probe = [&](char label) {
+        auto probe = std::make_shared<LaneProbe>();
+        probe->label = label;
+        probe->mtx = &mtx;
+        probe->trace = &trace;
+        return probe;
+    };
+    auto background = make_probe('B');
+    auto normal = make_probe('N');
+    auto realtime = make_probe('R');
+
+    auto blocker = std::make_shared<QueueBlocker>();
+    z3y::ScopedConnection block_conn = blocker->Block(bus_);
+    z3y::ScopedConnection bg_conn = bus_->SubscribeGlobal<TestPayloadEvent>(
+        background, &LaneProbe::OnEvent, ConnectionType::kQueued, EventPriority::kBackground);
+    z3y::ScopedConnection normal_conn = bus_->SubscribeGlobal<TestPayloadEvent>(
+        normal, &LaneProbe::OnEvent, ConnectionType::kQueued, EventPriority::kNormal);
+    z3y::ScopedConnection rt_conn = bus_->SubscribeGlobal<TestPayloadEvent>(
+        realtime, &LaneProbe::OnEvent, ConnectionType::kQueued, EventPriority::kRealtime);
+
+    constexpr int kFires = 10;
+    for (int i = 0; i < kFires; ++i) {
+        bus_->FireGlobal<TestPayloadEvent>(i, "lane");
+    }
+    blocker->release = true;
+
+    for (int i = 0; i < 200; ++i) {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (trace.size() == 3 * kFires) break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    std::lock_guard<std::mutex> lock(mtx);
+    EXPECT_EQ(trace, std::string(kFires, 'R') + std::string(kFires, 'N') + std::string(kFires, 'B'));
+}
+
+TEST_F(EventSystemTest, LazyGC_ManyDirtyListsCompactInOnePass) {
+    // 放宽每轮 GC 的时间预算：本用例验证批处理合并，而非 1ms 预算内能做完多少
+    manager_.reset();
+    z3y::PluginManager::Destroy();
+    z3y::PluginManagerOptions options;
+    options.gc_pass_budget = std::chrono::seconds(10);
+    manager_ = z3y::PluginManager::Create(options);
+    bus_ = z3y::GetDefaultService<IEventBus>();
+
+    constexpr int kSenders = 200;
+    std::vector<std::shared_ptr<MockSender>> senders;
+    std::vector<z3y::Connection> conns;
+    {
+        std::vector<std::shared_ptr<MockReceiver>> doomed;
+        for (int i = 0; i < kSenders; ++i) {
+            senders.push_back(std::make_shared<MockSender>());
+            doomed.push_back(std::make_shared<MockReceiver>());
+            doomed.back()->Initialize();
+            conns.push_back(bus_->SubscribeToSender<TestPayloadEvent>(
+                senders.back(), doomed.back(), &MockReceiver::OnEvent));
+        }
+    } // 订阅者全部死亡，但未断开
+
+    // 堵住派发线程，让所有 GC 请求先累积
+    auto blocker = std::make_shared<QueueBlocker>();
+    z3y::ScopedConnection block_conn = blocker->Block(bus_);
+
+    std::atomic<int> gc_tasks{ 0 };
+    manager_->SetEventTraceHook([&gc_tasks](EventTracePoint point, EventId id, void*, const char*) {
+        if (point == EventTracePoint::kQueuedExecuteStart && id != TestSignalEvent::kEventId) gc_tasks++;
+        });
+
+    for (auto& sender : senders) {
+        bus_->FireToSender<TestPayloadEvent>(sender, 1, "dirty"); // 每次都发现失效订阅
+    }
+    blocker->release = true;
+
+    for (int i = 0; i < 200 && bus_->IsSenderSubscribed(senders.back(), TestPayloadEvent::kEventId); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    manager_->SetEventTraceHook(nullptr);
+
+    // 200 个脏列表由同一个批处理任务清理
+    EXPECT_EQ(gc_tasks.load(), 1);
+    for (auto& sender : senders) {
+        EXPECT_FALSE(bus_->IsSenderSubscribed(sender, TestPayloadEvent::kEventId));
+    }
+}
+
+/**
+ * @test 测试 Disconnect 只撕票据 (O(1))：回调立即停止，列表由 GC 批处理稍后压缩。
+ */
+TEST_F(EventSystemTest, Disconnect_TombstonesImmediatelyAndCompactsLater) {
+    constexpr int kReceivers = 100;
+    auto sender = std::make_shared<MockSender>();
+    std::vector<std::shared_ptr<MockReceiver>> receivers;
+    std::vector<z3y::Connection> global_conns;
+    std::vector<z3y::Connection> sender_conns;
+    for (int i = 0; i < kReceivers; ++i) {
+        receivers.push_back(std::make_shared<MockReceiver>());
+        receivers.back()->Initialize();
+        global_conns.push_back(bus_->SubscribeGlobal<TestPayloadEvent>(receivers.back(), &MockReceiver::OnEvent));
+        sender_conns.push_back(bus_->SubscribeToSender<TestPayloadEvent>(sender, receivers.back(), &MockReceiver::OnEvent));
+    }
+
+    for (auto& conn : global_conns) conn.Disconnect();
+    for (auto& conn : sender_conns) conn.Disconnect();
+
+    // 断开后立即失效，不依赖 GC 何时执行
+    bus_->FireGlobal<TestPayloadEvent>(1, "after-disconnect");
+    bus_->FireToSender<TestPayloadEvent>(sender, 2, "after-disconnect");
+    for (auto& r : receivers) {
+        EXPECT_EQ(r->received_count.load(), 0);
+    }
+
+    for (int i = 0; i < 200 && (bus_->IsGlobalSubscribed(TestPayloadEvent::kEventId) ||
+        bus_->IsSenderSubscribed(sender, TestPayloadEvent::kEventId)); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    EXPECT_FALSE(bus_->IsGlobalSubscribed(TestPayloadEvent::kEventId));
+    EXPECT_FALSE(bus_->IsSenderSubscribed(sender, TestPayloadEvent::kEventId));
+}
+
+/**
+ * @test 测试 EventDelegate：超出内联缓冲区的 lambda 回调在订阅列表写时复制后依然完好。
+ */
+TEST_F(EventSystemTest, Delegate_LargeCallableSurvivesListCopies) {
+    auto receiver = std::make_shared<MockReceiver>();
+    receiver->Initialize();
+    std::array<int, 32> payload{};
+    payload.back() = 7;  // 捕获 128 字节，强制落到堆上
+    auto big = [payload](MockReceiver* self, const TestPayloadEvent& e) {
+        self->received_count += payload.back();
+        self->last_received_id = e.id;
+    };
+    z3y::ScopedConnection c1 = bus_->SubscribeGlobal<TestPayloadEvent>(receiver, big);
+
+    // 再订阅几次，迫使列表被复制
+    std::vector<std::shared_ptr<MockReceiver>> others;
+    std::vector<z3y::ScopedConnection> conns;
+    for (int i = 0; i < 4; ++i) {
+        others.push_back(std::make_shared<MockReceiver>());
+        others.back()->Initialize();
+        conns.emplace_back(bus_->SubscribeGlobal<TestPayloadEvent>(others.back(), &MockReceiver::OnEvent));
+    }
+
+    bus_->FireGlobal<TestPayloadEvent>(42, "delegate");
+    EXPECT_EQ(receiver->received_count.load(), 7);
+    EXPECT_EQ(receiver->last_received_id, 42);
+    for (auto& r : others) EXPECT_EQ(r->received_count.load(), 1);
+}
+
+/**
+ * @test 测试内置追踪记录器：记录结构化埋点，并能导出为 Chrome Trace JSON。
+ */
+TEST_F(EventSystemTest, TraceRecorder_RecordsStructuredPointsAndDumpsJson) {
+    auto direct = std::make_shared<MockReceiver>();
+    auto queued = std::make_shared<MockReceiver>();
+    direct->Initialize();
+    queued->Initialize();
+    z3y::ScopedConnection c1 = bus_->SubscribeGlobal<TestPayloadEvent>(direct, &MockReceiver::OnEvent);
+    z3y::ScopedConnection c2 = bus_->SubscribeGlobal<TestPayloadEvent>(
+        queued, &MockReceiver::OnEvent, z3y::ConnectionType::kQueued);
+
+    manager_->StartEventTraceRecording(1024);
+    bus_->FireGlobal<TestPayloadEvent>(5, "traced");
+    for (int i = 0; i < 200 && queued->received_count.load() == 0; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10)); // 等待 kQueuedExecuteEnd 写入
+    manager_->StopEventTraceRecording();
+    bus_->FireGlobal<TestPayloadEvent>(6, "not-traced");
+
+    auto records = manager_->GetEventTraceRecords();
+    auto count = [&records](EventTracePoint point) {
+        return std::count_if(records.begin(), records.end(), [point](const z3y::EventTraceRecord& r) {
+            return r.point == point && r.event_id == TestPayloadEvent::kEventId;
+            });
+    };
+    EXPECT_EQ(count(EventTracePoint::kEventFired), 1);
+    EXPECT_EQ(count(EventTracePoint::kDirectCallStart), 1);
+    EXPECT_EQ(count(EventTracePoint::kQueuedEntry), 1);
+    EXPECT_EQ(count(EventTracePoint::kQueuedExecuteStart), 1);
+    EXPECT_EQ(count(EventTracePoint::kQueuedExecuteEnd), 1);
+    for (const auto& r : records) {
+        if (r.point == EventTracePoint::kDirectCallStart) {
+            EXPECT_EQ(r.subscriber, reinterpret_cast<std::uintptr_t>(direct.get()));
+        }
+    }
+
+    auto path = std::filesystem::temp_directory_path() / "z3y_event_trace_test.json";
+    ASSERT_TRUE(manager_->DumpEventTrace(path));
+    std::ifstream in(path);
+    std::string json((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    EXPECT_EQ(json.rfind("{\"traceEvents\":[", 0), 0u);
+    EXPECT_NE(json.find("\"ph\":\"B\""), std::string::npos);
+    EXPECT_NE(json.find("\"ph\":\"E\""), std::string::npos);
+    in.close();
+    std::filesystem::remove(path);
+}
+
+/**
+ * @test 测试常驻运行指标：入队延迟直方图、订阅者耗时、异常计数与队列水位。
+ */
+TEST_F(EventSystemTest, Metrics_ReportQueueLatencyCallbackTimeAndExceptions) {
+    manager_->SetExceptionHandler([](const std::exception&) {}); // 静默
+    auto receiver = std::make_shared<MockReceiver>();
+    auto thrower = std::make_shared<MockReceiver>();
+    receiver->Initialize();
+    thrower->Initialize();
+    z3y::ScopedConnection c1 = bus_->SubscribeGlobal<TestPayloadEvent>(
+        receiver, &MockReceiver::OnEvent, z3y::ConnectionType::kQueued);
+    z3y::ScopedConnection c2 = bus_->SubscribeGlobal<TestPayloadEvent>(
+        thrower, &MockReceiver::OnThrowingEvent, z3y::ConnectionType::kQueued);
+    manager_->ResetEventDispatchMetrics();
+
+    constexpr int kFires = 20;
+    for (int i = 0; i < kFires; ++i) bus_->FireGlobal<TestPayloadEvent>(i, "metrics");
+    for (int i = 0; i < 200 && manager_->GetEventDispatchMetrics().exceptions < kFires; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+
+    auto metrics = manager_->GetEventDispatchMetrics();
+    EXPECT_EQ(receiver->received_count.load(), kFires);
+    EXPECT_EQ(metrics.exceptions, static_cast<uint64_t>(kFires));
+    EXPECT_EQ(metrics.unknown_exceptions, 0u);
+    EXPECT_GE(metrics.queue_high_water, 1u);
+    EXPECT_EQ(metrics.worker_queue_depth.size(), manager_->GetEventDispatchThreadCount());
+
+    auto latency_it = metrics.queue_latency.find(TestPayloadEvent::kEventId);
+    ASSERT_NE(latency_it, metrics.queue_latency.end());
+    EXPECT_EQ(latency_it->second.count, static_cast<uint64_t>(kFires));
+    EXPECT_LE(latency_it->second.PercentileNs(0.5), latency_it->second.max_ns);
+
+    bool saw_receiver = false, saw_thrower = false;
+    for (const auto& sub : metrics.subscribers) {
+        if (sub.event_id != TestPayloadEvent::kEventId) continue;
+        if (sub.subscriber == reinterpret_cast<std::uintptr_t>(receiver.get())) {
+            saw_receiver = true;
+            EXPECT_EQ(sub.callback_time.count, static_cast<uint64_t>(kFires));
+            EXPECT_EQ(sub.exceptions, 0u);
+        }
+        if (sub.subscriber == reinterpret_cast<std::uintptr_t>(thrower.get())) {
+            saw_thrower = true;
+            EXPECT_EQ(sub.exceptions, static_cast<uint64_t>(kFires));
+        }
+    }
+    EXPECT_TRUE(saw_receiver);
+    EXPECT_TRUE(saw_thrower);
+}
+
+/** @brief 测试用执行器：只收集任务，由测试决定在哪个线程上执行。 */
+class ManualExecutor : public z3y::IEventExecutor {
+public:
+    void Post(std::function<void()> task) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.push_back(std::move(task));
+    }
+
+    size_t RunAll() {
+        std::vector<std::function<void()>> tasks;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            tasks.swap(tasks_);
+        }
+        for (auto& task : tasks) task();
+        return tasks.size();
+    }
+
+private:
+    std::mutex mutex_;
+    std::vector<std::function<void()>> tasks_;
+};
+
+/**
+ * @test 测试执行器订阅：事件直接投递给订阅者指定的执行器，并在执行器的线程上回调。
+ */
+TEST_F(EventSystemTest, Executor_DeliversOnSubscriberProvidedExecutor) {
+    auto executor = std::make_shared<ManualExecutor>();
+    auto receiver = std::make_shared<MockReceiver>();
+    auto sender = std::make_shared<MockSender>();
+    receiver->Initialize();
+    z3y::ScopedConnection c1 = bus_->SubscribeGlobal<TestPayloadEvent>(receiver, &MockReceiver::OnEvent, executor);
+    z3y::ScopedConnection c2 = bus_->SubscribeToSender<TestPayloadEvent>(
+        sender, receiver, &MockReceiver::OnEvent, executor);
+
+    bus_->FireGlobal<TestPayloadEvent>(1, "executor");
+    bus_->FireGlobal<TestPayloadEvent>(2, "executor");
+    bus_->FireToSender<TestPayloadEvent>(sender, 3, "executor");
+    EXPECT_EQ(receiver->received_count.load(), 0); // 尚未执行
+
+    std::thread::id runner_id;
+    std::thread runner([&] {
+        runner_id = std::this_thread::get_id();
+        EXPECT_EQ(executor->RunAll(), 3u);
+        });
+    runner.join();
+    EXPECT_EQ(receiver->received_count.load(), 3);
+    EXPECT_EQ(receiver->last_received_id, 3);
+    EXPECT_EQ(receiver->last_thread_id, runner_id);
+
+    // 断开后，已投递但尚未执行的任务会验票失败
+    bus_->FireGlobal<TestPayloadEvent>(4, "executor");
+    c1.Disconnect();
+    EXPECT_EQ(executor->RunAll(), 1u);
+    EXPECT_EQ(receiver->received_count.load(), 3);
+
+    EXPECT_THROW((void)bus_->SubscribeGlobal<TestPayloadEvent>(receiver, &MockReceiver::OnEvent,
+        std::shared_ptr<z3y::IEventExecutor>(), z3y::ConnectionType::kQueued), std::invalid_argument);
+    EXPECT_THROW((void)bus_->SubscribeGlobal<TestPayloadEvent>(receiver, &MockReceiver::OnEvent,
+        executor, z3y::ConnectionType::kDirect), std::invalid_argument);
+}
+
+/** @brief 批订阅者：记录每次回调收到的批大小与事件 ID。 */
+class BatchReceiver : public std::enable_shared_from_this<BatchReceiver> {
+public:
+    std::mutex mutex;
+    std::vector<size_t> batch_sizes;
+    std::vector<int> ids;
+    std::atomic<int> calls{ 0 };
+
+    void OnBatch(const z3y::EventBatch<TestPayloadEvent>& batch) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            batch_sizes.push_back(batch.size());
+            for (const TestPayloadEvent& e : batch) ids.push_back(e.id);
+        }
+        calls++;
+    }
+};
+
+/**
+ * @test 测试批量发布：普通订阅者逐个收到事件，批订阅者每次发布只回调一次，
+ * 普通 FireGlobal 时批订阅者收到只含一个事件的批。
+ */
+TEST_F(EventSystemTest, FireGlobalBatch_FansOutOncePerSubscriber) {
+    auto queued_receiver = std::make_shared<MockReceiver>();
+    queued_receiver->Initialize();
+    auto direct_batch = std::make_shared<BatchReceiver>();
+    auto queued_batch = std::make_shared<BatchReceiver>();
+
+    z3y::ScopedConnection c1 = bus_->SubscribeGlobal<TestPayloadEvent>(receiver_, &MockReceiver::OnEvent);
+    z3y::ScopedConnection c2 = bus_->SubscribeGlobal<TestPayloadEvent>(
+        queued_receiver, &MockReceiver::OnEvent, ConnectionType::kQueued);
+    z3y::ScopedConnection c3 = bus_->SubscribeGlobalBatch<TestPayloadEvent>(direct_batch, &BatchReceiver::OnBatch);
+    z3y::ScopedConnection c4 = bus_->SubscribeGlobalBatch<TestPayloadEvent>(
+        queued_batch, &BatchReceiver::OnBatch, ConnectionType::kQueued);
+
+    std::vector<TestPayloadEvent> events;
+    for (int i = 1; i <= 5; ++i) events.emplace_back(i, "batch");
+    bus_->FireGlobalBatch(events);
+    events.clear(); // 调用返回后发布者即可释放数组
+    bus_->FireGlobal<TestPayloadEvent>(6, "single");
+
+    EXPECT_EQ(receiver_->received_count.load(), 6);
+    EXPECT_EQ(receiver_->last_received_id, 6);
+    {
+        std::lock_guard<std::mutex> lock(direct_batch->mutex);
+        EXPECT_EQ(direct_batch->batch_sizes, (std::vector<size_t>{ 5, 1 }));
+        EXPECT_EQ(direct_batch->ids, (std::vector<int>{ 1, 2, 3, 4, 5, 6 }));
+    }
+
+    for (int i = 0; i < 200 && (queued_receiver->received_count.load() < 6 || queued_batch->calls.load() < 2); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_EQ(queued_receiver->received_count.load(), 6);
+    EXPECT_EQ(queued_receiver->last_received_id, 6);
+    std::lock_guard<std::mutex> lock(queued_batch->mutex);
+    EXPECT_EQ(queued_batch->batch_sizes, (std::vector<size_t>{ 5, 1 }));
+    EXPECT_EQ(queued_batch->ids, (std::vector<int>{ 1, 2, 3, 4, 5, 6 }));
+}
+
+/** @brief 事件族订阅者：按动态类型统计收到的事件。 */
+class FamilyMonitor : public std::enable_shared_from_this<FamilyMonitor> {
+public:
+    int a = 0;
+    int b = 0;
+    int other = 0;
+
+    void OnAny(const z3y::Event& e) {
+        if (dynamic_cast<const TestFamilyEventA*>(&e)) a++;
+        else if (dynamic_cast<const TestFamilyEventB*>(&e)) b++;
+        else other++;
+    }
+};
+
+/**
+ * @test 测试事件族订阅：匹配前缀及其子族 (包括订阅之后才首次发布的事件类型)，
+ * 不匹配名字相近的族；断开连接后不再投递。
+ */
+TEST_F(EventSystemTest, Family_SubscribesToPrefixAndLaterEventTypes) {
+    bus_->FireGlobal<TestFamilyEventA>();  // 订阅之前已登记的事件类型
+
+    auto monitor = std::make_shared<FamilyMonitor>();
+    z3y::ScopedConnection conn = bus_->SubscribeFamily(monitor, "z3y-test/family/", &FamilyMonitor::OnAny);
+    z3y::ScopedConnection exact = bus_->SubscribeGlobal<TestFamilyEventA>(
+        std::static_pointer_cast<FamilyMonitor>(monitor), &FamilyMonitor::OnAny);
+    EXPECT_TRUE(bus_->IsGlobalSubscribed(TestFamilyEventA::kEventId));
+
+    bus_->FireGlobal<TestFamilyEventA>();
+    bus_->FireGlobal<TestFamilyEventB>();      // 首次发布：此时才登记进事件族
+    bus_->FireGlobal<TestFamilyEventOther>();  // "z3y-test/familyx" 不属于 "z3y-test/family"
+    EXPECT_EQ(monitor->a, 2);                  // 精确订阅 + 事件族订阅各一次
+    EXPECT_EQ(monitor->b, 1);
+    EXPECT_EQ(monitor->other, 0);
+
+    conn.Disconnect();
+    bus_->FireGlobal<TestFamilyEventA>();
+    bus_->FireGlobal<TestFamilyEventB>();
+    EXPECT_EQ(monitor->a, 3);
+    EXPECT_EQ(monitor->b, 1);
+
+    for (int i = 0; i < 200 && bus_->IsGlobalSubscribed(TestFamilyEventB::kEventId); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_FALSE(bus_->IsGlobalSubscribed(TestFamilyEventB::kEventId)); // GC 后撤下合并列表
+
+    EXPECT_THROW((void)bus_->SubscribeFamily(monitor, "/", &FamilyMonitor::OnAny), std::invalid_argument);
+}
+
+/** @brief 携带池化缓冲区的大负载事件。 */
+struct TestFrameEvent : public z3y::Event {
+    Z3Y_DEFINE_EVENT(TestFrameEvent, "z3y-test-evt-frame-008");
+    z3y::BufferRef pixels;
+    explicit TestFrameEvent(z3y::BufferRef p) : pixels(std::move(p)) {}
+};
+
+/** @brief 帧接收者：记录收到的数据地址与首字节，并保留最后一帧的句柄。 */
+class FrameReceiver : public std::enable_shared_from_this<FrameReceiver> {
+public:
+    std::atomic<int> received{ 0 };
+    std::atomic<const std::byte*> last_data{ nullptr };
+    std::atomic<int> first_byte{ -1 };
+
+    void OnFrame(const TestFrameEvent& e) {
+        last_data = e.pixels.Data();
+        first_byte = static_cast<int>(e.pixels.Data()[0]);
+        received++;
+    }
+};
+
+/**
+ * @test 测试缓冲区池：kQueued 投递只传递句柄 (订阅者看到同一块内存)，
+ * 最后一个引用释放后缓冲区回到池中，下一次同级别的申请直接复用。
+ */
+TEST_F(EventSystemTest, BufferPool_QueuedFramesShareAndRecycleBuffers) {
+    auto pool = manager_->GetService<IBufferPool>(clsid::kBufferPool);
+    ASSERT_TRUE(pool);
+
+    constexpr size_t kFrameBytes = 3 * 1024 * 1024 + 17;  // 落在 4 MB 级别
+    z3y::BufferRef frame = pool->AcquireBuffer(kFrameBytes);
+    ASSERT_TRUE(frame);
+    EXPECT_EQ(frame.Size(), kFrameBytes);
+    EXPECT_EQ(frame.Capacity(), size_t(4) << 20);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(frame.Data()) % 4096, 0u);  // 按页对齐
+    frame.Data()[0] = std::byte{ 42 };
+    const std::byte* original = frame.Data();
+
+    z3y::BufferRef small = pool->AcquireBuffer(100);
+    EXPECT_EQ(small.Capacity(), 256u);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(small.Data()) % 64, 0u);  // 按缓存行对齐
+    z3y::BufferRef copy = small;
+    EXPECT_EQ(small.UseCount(), 2u);
+    small.Reset();
+    EXPECT_EQ(copy.UseCount(), 1u);
+    copy.Reset();
+
+    auto receiver = std::make_shared<FrameReceiver>();
+    z3y::ScopedConnection conn = bus_->SubscribeGlobal<TestFrameEvent>(
+        receiver, &FrameReceiver::OnFrame, ConnectionType::kQueued);
+    const BufferPoolStats before = pool->GetBufferPoolStats();
+    bus_->FireGlobal<TestFrameEvent>(std::move(frame));
+    EXPECT_FALSE(frame);
+    for (int i = 0; i < 200 && receiver->received.load() == 0; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    ASSERT_EQ(receiver->received.load(), 1);
+    EXPECT_EQ(receiver->last_data.load(), original);
+    EXPECT_EQ(receiver->first_byte.load(), 42);
+
+    // 派发线程释放事件后，缓冲区回到池中
+    BufferPoolStats after = pool->GetBufferPoolStats();
+    for (int i = 0; i < 200 && after.outstanding_buffers != 0; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        after = pool->GetBufferPoolStats();
+    }
+    EXPECT_EQ(after.outstanding_buffers, 0u);
+    EXPECT_EQ(after.cached_buffers, before.cached_buffers + 1);
+
+    z3y::BufferRef reused = pool->AcquireBuffer(4 << 20);
+    EXPECT_EQ(reused.Data(), original);
+    EXPECT_GT(pool->GetBufferPoolStats().pool_hits, after.pool_hits);
+
+    // Trim 把空闲缓冲区全部归还系统
+    reused.Reset();
+    pool->TrimBufferPool();
+    EXPECT_EQ(pool->GetBufferPoolStats().cached_bytes, 0u);
+}
+
+/**
+ * @test 测试分配服务：线程帧内存按作用域整体回收并复用同一块内存 (可嵌套)；
+ * 分级内存池跨线程可用并统计借出字节；开启 framework_pool_allocations 后订阅列表与派发闭包也计入池中。
+ */
+TEST_F(EventSystemTest, Allocator_FrameArenasRewindAndFrameworkContainersUsePool) {
+    manager_.reset();
+    z3y::PluginManager::Destroy();
+    z3y::PluginManagerOptions options;
+    options.framework_pool_allocations = true;
+    manager_ = z3y::PluginManager::Create(options);
+    bus_ = z3y::GetDefaultService<IEventBus>();
+    auto alloc = manager_->GetService<IAllocatorService>(clsid::kAllocator);
+    ASSERT_TRUE(alloc);
+
+    // 1. 线程帧内存：第二帧拿到与第一帧相同的地址，嵌套作用域只回收自己的部分
+    const void* first_frame = nullptr;
+    for (int frame = 0; frame < 2; ++frame) {
+        z3y::FrameArenaScope scope(*alloc);
+        std::pmr::vector<int> values(scope.Resource());
+        values.reserve(1000);
+        if (frame == 0) first_frame = values.data();
+        else EXPECT_EQ(values.data(), first_frame);
+        const size_t outer_used = alloc->GetAllocatorStats().arena_used_bytes;
+        EXPECT_GE(outer_used, 1000 * sizeof(int));
+        {
+            z3y::FrameArenaScope inner(*alloc);
+            std::pmr::string big(200 * 1024, 'x', inner.Resource());  // 超过首个块，迫使 arena 增加新块
+            EXPECT_GT(alloc->GetAllocatorStats().arena_used_bytes, outer_used + 200 * 1024);
+        }
+        EXPECT_EQ(alloc->GetAllocatorStats().arena_used_bytes, outer_used);
+    }
+    AllocatorStats stats = alloc->GetAllocatorStats();
+    EXPECT_EQ(stats.arena_used_bytes, 0u);
+    EXPECT_GE(stats.arena_threads, 1u);
+    EXPECT_GE(stats.arena_rewinds, 4u);
+    EXPECT_GT(stats.arena_reserved_bytes, 200u * 1024);
+    EXPECT_GT(stats.arena_peak_bytes, 200u * 1024);
+
+    // 2. 分级内存池：另一个线程释放，借出字节归零
+    const size_t pool_before = stats.pool_bytes;
+    auto* pool_values = new std::pmr::vector<double>(256, 1.0, alloc->GetPoolResource());
+    EXPECT_GE(alloc->GetAllocatorStats().pool_bytes, pool_before + 256 * sizeof(double));
+    std::thread([pool_values] { delete pool_values; }).join();
+    EXPECT_EQ(alloc->GetAllocatorStats().pool_bytes, pool_before);
+    EXPECT_GT(alloc->GetAllocatorStats().pool_upstream_bytes, 0u);
+
+    // 3. 框架热点容器：订阅列表快照与 kQueued 派发闭包来自池
+    const size_t framework_before = alloc->GetAllocatorStats().framework_bytes;
+    auto receiver = std::make_shared<MockReceiver>();
+    receiver->Initialize();
+    z3y::ScopedConnection conn = bus_->SubscribeGlobal<TestPayloadEvent>(receiver, &MockReceiver::OnEvent,
+        ConnectionType::kQueued);
+    EXPECT_GT(alloc->GetAllocatorStats().framework_bytes, framework_before);
+    const uint64_t allocations_before = alloc->GetAllocatorStats().pool_allocations;
+    for (int i = 0; i < 10; ++i) bus_->FireGlobal<TestPayloadEvent>(i, "pooled");
+    for (int i = 0; i < 500 && receiver->received_count.load() < 10; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_EQ(receiver->received_count.load(), 10);
+    EXPECT_GE(alloc->GetAllocatorStats().pool_allocations, allocations_before + 10);
+}
+
+/** @brief 可跨进程桥接的测试事件。 */
+struct TestIpcPingEvent : public z3y::Event {
+    Z3Y_DEFINE_SERIALIZABLE_EVENT(TestIpcPingEvent, "z3y-test-evt-ipc-ping-009");
+    int32_t seq = 0;
+    std::string text;
+    TestIpcPingEvent(int32_t s, std::string t) : seq(s), text(std::move(t)) {}
+
+    void Serialize(z3y::EventWriter& w) const {
+        w.Write(seq);
+        w.WriteString(text);
+    }
+    static TestIpcPingEvent Deserialize(z3y::EventReader& r) {
+        const int32_t s = r.Read<int32_t>();
+        return TestIpcPingEvent(s, r.ReadString());
+    }
+};
+
+/** @brief 记录收到的 Ping 事件。 */
+class IpcPingReceiver : public std::enable_shared_from_this<IpcPingReceiver> {
+public:
+    std::mutex mutex;
+    std::vector<std::pair<int32_t, std::string>> pings;
+
+    void OnPing(const TestIpcPingEvent& e) {
+        std::lock_guard<std::mutex> lock(mutex);
+        pings.emplace_back(e.seq, e.text);
+    }
+    size_t Count() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return pings.size();
+    }
+};
+
+/**
+ * @test 测试跨进程事件桥 (两端在同一进程内、共用一条总线)：
+ * 创建者 Export、对端 Import，本地订阅者先收到原事件，再收到经共享内存回来的副本；
+ * 导入的事件不会被任何一端再次导出，也就不会来回打转。
+ */
+TEST_F(EventSystemTest, Connection_PointerSizedHandlesAndGroupBulkDisconnect) {
+    static_assert(sizeof(z3y::Connection) == sizeof(void*), "Connection 应只是一个槽指针");
+
+    // 1. 丢弃普通 Connection 句柄不会断开订阅
+    auto keeper = std::make_shared<MockReceiver>();
+    keeper->Initialize();
+    {
+        z3y::Connection dropped = bus_->SubscribeGlobal<TestSignalEvent>(keeper, &MockReceiver::OnSignal);
+        EXPECT_TRUE(dropped.IsConnected());
+    }
+    bus_->FireGlobal<TestSignalEvent>();
+    EXPECT_EQ(keeper->received_count.load(), 1);
+
+    // 2. 一组连接一次性断开：之后不再收到事件，订阅列表由一次 GC 清空
+    constexpr int kReceivers = 200;
+    std::vector<std::shared_ptr<MockReceiver>> receivers;
+    z3y::EventConnectionGroup group;
+    for (int i = 0; i < kReceivers; ++i) {
+        receivers.push_back(std::make_shared<MockReceiver>());
+        receivers.back()->Initialize();
+        group += bus_->SubscribeGlobal<TestPayloadEvent>(receivers.back(), &MockReceiver::OnEvent);
+    }
+    EXPECT_EQ(group.Size(), static_cast<size_t>(kReceivers));
+    bus_->FireGlobal<TestPayloadEvent>(1, "grouped");
+    for (auto& r : receivers) EXPECT_EQ(r->received_count.load(), 1);
+
+    group.DisconnectAll();
+    EXPECT_TRUE(group.Empty());
+    bus_->FireGlobal<TestPayloadEvent>(2, "after");
+    for (auto& r : receivers) EXPECT_EQ(r->received_count.load(), 1);
+    for (int i = 0; i < 200 && bus_->IsGlobalSubscribed(TestPayloadEvent::kEventId); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    EXPECT_FALSE(bus_->IsGlobalSubscribed(TestPayloadEvent::kEventId));
+
+    // 3. 断开后槽位被回收复用，新订阅照常工作
+    {
+        z3y::EventConnectionGroup again;
+        again += bus_->SubscribeGlobal<TestPayloadEvent>(receivers[0], &MockReceiver::OnEvent);
+        bus_->FireGlobal<TestPayloadEvent>(3, "reused");
+        EXPECT_EQ(receivers[0]->received_count.load(), 2);
+    }
+    bus_->FireGlobal<TestPayloadEvent>(4, "scoped");
+    EXPECT_EQ(receivers[0]->received_count.load(), 2);
+}
+
+TEST_F(EventSystemTest, IpcBridge_ForwardsSerializableEventsThroughSharedMemory) {
+    static_assert(z3y::IsSerializableEvent<TestIpcPingEvent>::value, "ping must be serializable");
+    static_assert(!z3y::IsSerializableEvent<TestPayloadEvent>::value, "plain events are not serializable");
+
+    const std::string name = "z3y-test-" + std::to_string(static_cast<long long>(
+        std::chrono::steady_clock::now().time_since_epoch().count() & 0xFFFFFF));
+    std::string err;
+    auto host = z3y::IpcEventBridge::Create(name, bus_, err, 1);  // 取整到最小 64 KB
+    ASSERT_TRUE(host) << err;
+    EXPECT_FALSE(host->IsPeerAttached());
+    auto child = z3y::IpcEventBridge::Open(name, bus_, err);
+    ASSERT_TRUE(child) << err;
+    EXPECT_TRUE(host->IsPeerAttached());
+    EXPECT_FALSE(z3y::IpcEventBridge::Open(name, bus_, err));  // 只允许一个对端
+    EXPECT_FALSE(z3y::IpcEventBridge::Create(name, bus_, err)); // 同名段已存在
+
+    host->Export<TestIpcPingEvent>();
+    host->Export<TestIpcPingEvent>();  // 重复导出无效
+    child->Import<TestIpcPingEvent>();
+    child->Export<TestIpcPingEvent>(); // 创建者没有 Import：到达后计为未知事件
+
+    auto receiver = std::make_shared<IpcPingReceiver>();
+    z3y::ScopedConnection conn = bus_->SubscribeGlobal<TestIpcPingEvent>(receiver, &IpcPingReceiver::OnPing);
+    bus_->FireGlobal<TestIpcPingEvent>(7, "hello over shm");
+    for (int i = 0; i < 500 && (receiver->Count() < 2 || host->GetStats().unknown_events == 0); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));  // 若有回环，这段时间内会出现更多副本
+
+    ASSERT_EQ(receiver->Count(), 2u);
+    EXPECT_EQ(receiver->pings[0], std::make_pair(int32_t(7), std::string("hello over shm")));
+    EXPECT_EQ(receiver->pings[1], receiver->pings[0]);
+    const z3y::IpcBridgeStats host_stats = host->GetStats();
+    const z3y::IpcBridgeStats child_stats = child->GetStats();
+    EXPECT_EQ(host_stats.sent_events, 1u);
+    EXPECT_EQ(child_stats.received_events, 1u);
+    EXPECT_EQ(child_stats.sent_events, 1u);
+    EXPECT_EQ(host_stats.unknown_events, 1u);
+    EXPECT_EQ(child_stats.decode_failures, 0u);
+
+    // 超过环容量一半的事件直接丢弃，不阻塞发布者
+    bus_->FireGlobal<TestIpcPingEvent>(8, std::string(40 * 1024, 'x'));
+    EXPECT_EQ(host->GetStats().dropped_events, 1u);
+
+    child.reset();
+    EXPECT_FALSE(host->IsPeerAttached());
+}
+
+/** @brief 录制/回放测试用的无负载事件 (只还原“发生过”)。 */
+struct TestReplayTickEvent : public z3y::Event {
+    Z3Y_DEFINE_EVENT(TestReplayTickEvent, "z3y-test-evt-replay-tick-011");
+};
+
+/** @brief 统计回放出来的 Tick 与通用 ReplayedEvent。 */
+class ReplayMonitor : public std::enable_shared_from_this<ReplayMonitor> {
+public:
+    std::atomic<int> ticks{ 0 };
+    std::vector<z3y::EventId> raw_ids;
+
+    void OnTick(const TestReplayTickEvent&) { ++ticks; }
+    void OnRaw(const z3y::event::ReplayedEvent& e) { raw_ids.push_back(e.original_id_); }
+};
+
+/**
+ * @test 测试事件录制与回放：可序列化事件带负载录制，普通事件只录 ID；
+ * 回放时按注册类型还原，未注册的 ID 可以通用事件发布；1 倍速保持原有间隔，N 倍速按比例压缩；
+ * 文件末尾不完整的记录被忽略。
+ */
+TEST_F(EventSystemTest, Recorder_RecordsAndReplaysTrafficAtChosenSpeed) {
+    const std::filesystem::path path = std::filesystem::temp_directory_path() /
+        ("z3y-test-" + std::to_string(static_cast<long long>(
+            std::chrono::steady_clock::now().time_since_epoch().count() & 0xFFFFFF)) + ".z3yrec");
+    std::string err;
+    auto recorder = z3y::EventRecorder::Create(path, bus_, err, 64);  // 很小的阈值：录制期间多次写文件
+    ASSERT_TRUE(recorder) << err;
+    recorder->Record<TestIpcPingEvent>();
+    recorder->Record<TestReplayTickEvent>();
+    recorder->Record<TestIpcPingEvent>();  // 重复录制无效
+
+    bus_->FireGlobal<TestIpcPingEvent>(1, "first");
+    bus_->FireGlobal<TestReplayTickEvent>();
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    bus_->FireGlobal<TestIpcPingEvent>(2, std::string(100, 'p'));
+    recorder->Stop();
+    bus_->FireGlobal<TestReplayTickEvent>();  // 停止之后不再录制
+
+    const z3y::EventRecorderStats rec_stats = recorder->GetStats();
+    EXPECT_EQ(rec_stats.recorded_events, 3u);
+    EXPECT_EQ(rec_stats.payload_bytes, (4u + 4u + 5u) + (4u + 4u + 100u));
+    EXPECT_EQ(rec_stats.write_failures, 0u);
+    EXPECT_EQ(rec_stats.written_bytes, std::filesystem::file_size(path));
+    {
+        std::ofstream tail(path, std::ios::binary | std::ios::app);
+        tail.write("\x05\x01\x02", 3);  // 模拟崩溃留下的半条记录
+    }
+
+    EXPECT_FALSE(z3y::EventReplayer::Open(path.string() + ".missing", bus_, err));
+    auto replayer = z3y::EventReplayer::Open(path, bus_, err);
+    ASSERT_TRUE(replayer) << err;
+    EXPECT_EQ(replayer->GetEventCount(), 3u);
+    EXPECT_GT(replayer->GetStartTimeNs(), 0u);
+
+    auto pings = std::make_shared<IpcPingReceiver>();
+    auto monitor = std::make_shared<ReplayMonitor>();
+    z3y::ScopedConnection c1 = bus_->SubscribeGlobal<TestIpcPingEvent>(pings, &IpcPingReceiver::OnPing);
+    z3y::ScopedConnection c2 = bus_->SubscribeGlobal<TestReplayTickEvent>(monitor, &ReplayMonitor::OnTick);
+    z3y::ScopedConnection c3 = bus_->SubscribeGlobal<z3y::event::ReplayedEvent>(monitor, &ReplayMonitor::OnRaw);
+
+    // 1. 没有注册任何类型：全部计为未知
+    z3y::ReplayOptions fast;
+    fast.speed = 0;
+    z3y::ReplayStats stats = replayer->Run(fast);
+    EXPECT_EQ(stats.unknown_events, 3u);
+    EXPECT_EQ(pings->Count(), 0u);
+
+    // 2. 只注册 Ping，Tick 以通用事件发布
+    replayer->Register<TestIpcPingEvent>();
+    fast.raw_fallback = true;
+    stats = replayer->Run(fast);
+    EXPECT_EQ(stats.replayed_events, 2u);
+    EXPECT_EQ(stats.raw_events, 1u);
+    ASSERT_EQ(monitor->raw_ids.size(), 1u);
+    EXPECT_EQ(monitor->raw_ids[0], TestReplayTickEvent::kEventId);
+    ASSERT_EQ(pings->Count(), 2u);
+    EXPECT_EQ(pings->pings[0], std::make_pair(int32_t(1), std::string("first")));
+    EXPECT_EQ(pings->pings[1], std::make_pair(int32_t(2), std::string(100, 'p')));
+    EXPECT_GE(stats.recorded_ns, 30000000u);
+    EXPECT_LT(stats.elapsed_ns, stats.recorded_ns);
+
+    // 3. 全部注册，1 倍速：保持录制时的间隔
+    replayer->Register<TestReplayTickEvent>();
+    stats = replayer->Run();
+    EXPECT_EQ(stats.replayed_events, 3u);
+    EXPECT_EQ(monitor->ticks.load(), 1);
+    EXPECT_GE(stats.elapsed_ns, stats.recorded_ns);
+
+    // 4. 10 倍速重复两轮：每轮耗时约为录制时长的 1/10
+    z3y::ReplayOptions ten_x;
+    ten_x.speed = 10.0;
+    ten_x.repeat = 2;
+    stats = replayer->Run(ten_x);
+    EXPECT_EQ(stats.replayed_events, 6u);
+    EXPECT_EQ(monitor->ticks.load(), 3);
+    EXPECT_GE(stats.elapsed_ns, stats.recorded_ns / 5);
+    EXPECT_LT(stats.elapsed_ns, stats.recorded_ns);
+    EXPECT_GT(stats.EventsPerSecond(), 0.0);
+
+    replayer.reset();
+    std::filesystem::remove(path);
+}
+
+/** @brief 保留事件测试：描述“当前状态”的事件。 */
+struct TestStateEvent : public z3y::Event {
+    Z3Y_DEFINE_RETAINED_EVENT(TestStateEvent, "z3y-test-evt-state-012");
+    int value;
+    explicit TestStateEvent(int v) : value(v) {}
+};
+
+/** @brief 记录收到的状态值。 */
+class StateWatcher : public std::enable_shared_from_this<StateWatcher> {
+public:
+    void OnState(const TestStateEvent& e) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        values_.push_back(e.value);
+    }
+    std::vector<int> Values() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return values_;
+    }
+
+private:
+    std::mutex mutex_;
+    std::vector<int> values_;
+};
+
+/**
+ * @test 测试保留事件：没有订阅者时的发布也会被保留；迟到的订阅者在订阅时收到最新值
+ * (kDirect 在订阅调用内同步收到，kQueued 经派发线程收到)；按发送者分别保留；
+ * ClearRetained 之后不再补发，卸载全部插件时全部丢弃。
+ */
+TEST_F(EventSystemTest, Retained_LateSubscribersReceiveLastValue) {
+    static_assert(z3y::detail::IsRetainedEvent<TestStateEvent>::value, "state event must be retained");
+    static_assert(!z3y::detail::IsRetainedEvent<TestPayloadEvent>::value, "plain events are not retained");
+
+    EXPECT_EQ(bus_->GetRetained<TestStateEvent>(), nullptr);
+    bus_->FireGlobal<TestStateEvent>(1);  // 此时还没有任何订阅者
+    bus_->FireGlobal<TestStateEvent>(2);
+    ASSERT_NE(bus_->GetRetained<TestStateEvent>(), nullptr);
+    EXPECT_EQ(bus_->GetRetained<TestStateEvent>()->value, 2);
+
+    auto direct = std::make_shared<StateWatcher>();
+    z3y::ScopedConnection c1 = bus_->SubscribeGlobal<TestStateEvent>(direct, &StateWatcher::OnState);
+    EXPECT_EQ(direct->Values(), std::vector<int>({ 2 }));  // 订阅返回前已收到
+    bus_->FireGlobal<TestStateEvent>(3);
+    EXPECT_EQ(direct->Values(), std::vector<int>({ 2, 3 }));
+
+    auto queued = std::make_shared<StateWatcher>();
+    z3y::ScopedConnection c2 = bus_->SubscribeGlobal<TestStateEvent>(queued, &StateWatcher::OnState,
+        z3y::ConnectionType::kQueued);
+    bus_->FireGlobal<TestStateEvent>(4);
+    for (int i = 0; i < 500 && queued->Values().size() < 2; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_EQ(queued->Values(), std::vector<int>({ 3, 4 }));  // 补发的旧值先于之后的发布
+
+    // 按发送者分别保留，互不影响，也不影响全局值
+    bus_->FireToSender<TestStateEvent>(sender1_, 10);
+    bus_->FireToSender<TestStateEvent>(sender2_, 20);
+    auto per_sender = std::make_shared<StateWatcher>();
+    z3y::ScopedConnection c3 = bus_->SubscribeToSender<TestStateEvent>(sender2_, per_sender, &StateWatcher::OnState);
+    EXPECT_EQ(per_sender->Values(), std::vector<int>({ 20 }));
+    EXPECT_EQ(bus_->GetRetained<TestStateEvent>(sender1_)->value, 10);
+    EXPECT_EQ(bus_->GetRetained<TestStateEvent>()->value, 4);
+    bus_->ClearRetained<TestStateEvent>(sender1_);
+    EXPECT_EQ(bus_->GetRetained<TestStateEvent>(sender1_), nullptr);
+    EXPECT_EQ(bus_->GetRetained<TestStateEvent>(sender2_)->value, 20);
+
+    bus_->ClearRetained<TestStateEvent>();
+    auto after_clear = std::make_shared<StateWatcher>();
+    z3y::ScopedConnection c4 = bus_->SubscribeGlobal<TestStateEvent>(after_clear, &StateWatcher::OnState);
+    EXPECT_TRUE(after_clear->Values().empty());
+
+    bus_->FireGlobal<TestStateEvent>(5);
+    manager_->UnloadAllPlugins();  // 保留值可能来自插件模块：卸载时全部丢弃
+    EXPECT_EQ(bus_->GetRetained<TestStateEvent>(), nullptr);
+    EXPECT_EQ(bus_->GetRetained<TestStateEvent>(sender2_), nullptr);
+}
+
+/**
+ * @test 测试卸载单个插件只丢弃类型来自该插件的保留值：宿主 (及其余插件) 发布的保留值保持不变。
+ */
+TEST_F(EventSystemTest, Retained_UnloadPluginKeepsOtherModulesValues) {
+    ASSERT_TRUE(LoadPlugin("plugin_demo_core_services"));
+    bus_->FireGlobal<TestStateEvent>(7);
+    bus_->FireToSender<TestStateEvent>(sender1_, 70);
+
+    std::string plugin_path;
+    for (const auto& file : z3y::GetService<IPluginQuery>(clsid::kPluginQuery)->GetLoadedPluginFiles()) {
+        if (file.find("plugin_demo_core_services") != std::string::npos) plugin_path = file;
+    }
+    ASSERT_FALSE(plugin_path.empty());
+    std::string err;
+    ASSERT_TRUE(manager_->UnloadPlugin(z3y::utils::Utf8ToPath(plugin_path), err)) << err;
+
+    ASSERT_NE(bus_->GetRetained<TestStateEvent>(), nullptr);
+    EXPECT_EQ(bus_->GetRetained<TestStateEvent>()->value, 7);
+    ASSERT_NE(bus_->GetRetained<TestStateEvent>(sender1_), nullptr);
+    EXPECT_EQ(bus_->GetRetained<TestStateEvent>(sender1_)->value, 70);
+    auto late = std::make_shared<StateWatcher>();
+    z3y::ScopedConnection conn = bus_->SubscribeGlobal<TestStateEvent>(late, &StateWatcher::OnState);
+    EXPECT_EQ(late->Values(), std::vector<int>({ 7 }));
+}
+
+/** @brief 请求/应答测试：请求事件与回复类型 (回复不需要是事件)。 */
+struct TestQueryRequest : public z3y::Event {
+    Z3Y_DEFINE_EVENT(TestQueryRequest, "z3y-test-evt-query-010");
+    int value;
+    explicit TestQueryRequest(int v) : value(v) {}
+};
+struct TestQueryReply {
+    int doubled;
+    std::thread::id handled_on;
+};
+
+/** @brief 请求处理者：记录并发度，可注入延迟与异常。 */
+class QueryHandler : public std::enable_shared_from_this<QueryHandler> {
+public:
+    TestQueryReply OnQuery(const TestQueryRequest& req) {
+        const int now = ++active;
+        int seen = max_active.load();
+        while (now > seen && !max_active.compare_exchange_weak(seen, now)) {}
+        if (delay.count() > 0) std::this_thread::sleep_for(delay);
+        --active;
+        ++calls;
+        if (req.value < 0) throw std::runtime_error("negative query");
+        return { req.value * 2, std::this_thread::get_id() };
+    }
+
+    std::atomic<int> active{ 0 };
+    std::atomic<int> max_active{ 0 };
+    std::atomic<int> calls{ 0 };
+    std::chrono::milliseconds delay{ 0 };
+};
+
+/**
+ * @test 请求只交给唯一的处理者，回复直接写回 future；覆盖无处理者、重复注册、处理者异常、
+ * 类型不符、串行队列上的处理者 (并发度为 1) 与超时。
+ */
+TEST_F(EventSystemTest, Request_RoutesToSingleHandlerWithTimeouts) {
+    auto error_code = [](auto future) {
+        try {
+            future.get();
+        } catch (const z3y::RequestError& e) {
+            return e.code();
+        }
+        ADD_FAILURE() << "request did not fail";
+        return z3y::RequestErrorCode::kRejected;
+    };
+    EXPECT_EQ(error_code(bus_->Request<TestQueryRequest, TestQueryReply>(TestQueryRequest(1))),
+        z3y::RequestErrorCode::kNoHandler);
+
+    auto handler = std::make_shared<QueryHandler>();
+    {
+        z3y::ScopedConnection conn = bus_->HandleRequests<TestQueryRequest>(
+            handler, &QueryHandler::OnQuery, z3y::ConnectionType::kDirect);
+        auto reply = bus_->Request<TestQueryRequest, TestQueryReply>(TestQueryRequest(21));
+        ASSERT_EQ(reply.wait_for(std::chrono::seconds(0)), std::future_status::ready);  // kDirect 同步完成
+        const TestQueryReply r = reply.get();
+        EXPECT_EQ(r.doubled, 42);
+        EXPECT_EQ(r.handled_on, std::this_thread::get_id());
+
+        auto other = std::make_shared<QueryHandler>();
+        EXPECT_THROW((void)bus_->HandleRequests<TestQueryRequest>(other, &QueryHandler::OnQuery), std::logic_error);
+        EXPECT_THROW((void)bus_->HandleRequests<TestQueryRequest>(
+            other, &QueryHandler::OnQuery, z3y::ConnectionType::kQueuedCoalesced), std::invalid_argument);
+
+        EXPECT_THROW((bus_->Request<TestQueryRequest, TestQueryReply>(TestQueryRequest(-1)).get()), std::runtime_error);
+        EXPECT_EQ(error_code(bus_->Request<TestQueryRequest, int>(TestQueryRequest(1))),
+            z3y::RequestErrorCode::kTypeMismatch);
+
+        std::promise<int> async_reply;
+        bus_->RequestAsync<TestQueryRequest, TestQueryReply>(TestQueryRequest(5), std::chrono::seconds(1),
+            [&async_reply](TestQueryReply* reply, std::exception_ptr error) {
+                async_reply.set_value(reply && !error ? reply->doubled : -1);
+            });
+        EXPECT_EQ(async_reply.get_future().get(), 10);
+    }
+    EXPECT_EQ(error_code(bus_->Request<TestQueryRequest, TestQueryReply>(TestQueryRequest(1))),
+        z3y::RequestErrorCode::kNoHandler);
+
+    // 断开后可以重新注册：处理者放到串行队列上，并发请求被逐个执行
+    auto executor = z3y::GetService<IExecutorService>(z3y::clsid::kExecutor);
+    handler->delay = std::chrono::milliseconds(2);
+    z3y::ScopedConnection conn = bus_->HandleRequests<TestQueryRequest>(
+        handler, &QueryHandler::OnQuery, executor->GetSerialQueue("test.request.serial"));
+    const int calls_before = handler->calls.load();
+    std::vector<std::future<TestQueryReply>> replies;
+    std::vector<std::thread> requesters;
+    std::mutex replies_mutex;
+    for (int t = 0; t < 4; ++t) {
+        requesters.emplace_back([&, t] {
+            for (int i = 0; i < 4; ++i) {
+                auto f = bus_->Request<TestQueryRequest, TestQueryReply>(TestQueryRequest(t * 10 + i));
+                std::lock_guard<std::mutex> lock(replies_mutex);
+                replies.push_back(std::move(f));
+            }
+        });
+    }
+    for (auto& th : requesters) th.join();
+    int sum = 0;
+    for (auto& f : replies) {
+        const TestQueryReply r = f.get();
+        EXPECT_NE(r.handled_on, std::this_thread::get_id());
+        sum += r.doubled;
+    }
+    EXPECT_EQ(sum, 2 * (4 * (0 + 10 + 20 + 30) + 4 * (0 + 1 + 2 + 3)));
+    EXPECT_EQ(handler->calls.load() - calls_before, 16);
+    EXPECT_EQ(handler->max_active.load(), 1);
+
+    // 处理者太慢：请求者先收到超时，迟到的回复被丢弃
+    handler->delay = std::chrono::milliseconds(200);
+    auto slow = bus_->Request<TestQueryRequest, TestQueryReply>(TestQueryRequest(3), std::chrono::milliseconds(20));
+    ASSERT_EQ(slow.wait_for(std::chrono::seconds(2)), std::future_status::ready);
+    EXPECT_EQ(error_code(std::move(slow)), z3y::RequestErrorCode::kTimeout);
+    for (int i = 0; i < 500 && handler->calls.load() - calls_before < 17; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    EXPECT_EQ(handler->calls.load() - calls_before, 17);
+}
+
+TEST_F(EventSystemTest, Channel_TypedFireInteropsWithGlobalBus) {
+    std::vector<EventTracePoint> traces;
+    manager_->SetEventTraceHook([&](EventTracePoint pt, EventId id, void*, const char*) {
+        if (id == TestPayloadEvent::kEventId) traces.push_back(pt);
+        });
+
+    z3y::EventChannel<TestPayloadEvent> channel = bus_->GetChannel<TestPayloadEvent>();
+    ASSERT_TRUE(channel);
+    // 同一事件只有一个通道：再取一次得到同一个通道状态
+    z3y::EventChannel<TestPayloadEvent> again = bus_->GetChannel<TestPayloadEvent>();
+
+    auto channel_receiver = std::make_shared<MockReceiver>();
+    auto queued_receiver = std::make_shared<MockReceiver>();
+    z3y::Connection channel_conn = channel.Subscribe(channel_receiver, &MockReceiver::OnEvent);
+    z3y::ScopedConnection direct_conn = bus_->SubscribeGlobal<TestPayloadEvent>(receiver_, &MockReceiver::OnEvent);
+    z3y::ScopedConnection queued_conn = bus_->SubscribeGlobal<TestPayloadEvent>(
+        queued_receiver, &MockReceiver::OnEvent, ConnectionType::kQueued);
+    EXPECT_TRUE(bus_->IsGlobalSubscribed(TestPayloadEvent::kEventId));
+
+    // 通道发布：通道订阅者同步收到，总线上的 kDirect / kQueued 订阅者照常收到
+    channel.Fire(TestPayloadEvent(1, "channel"));
+    EXPECT_EQ(channel_receiver->received_count, 1);
+    EXPECT_EQ(channel_receiver->last_received_id, 1);
+    EXPECT_EQ(channel_receiver->last_thread_id, std::this_thread::get_id());
+    EXPECT_EQ(receiver_->received_count, 1);
+    for (int i = 0; i < 500 && queued_receiver->received_count < 1; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_EQ(queued_receiver->received_count, 1);
+
+    // 总线发布：通道订阅者同样收到，且每个订阅者只收到一次
+    bus_->FireGlobal<TestPayloadEvent>(2, "bus");
+    again.Emit(3, "emit");
+    EXPECT_EQ(channel_receiver->received_count, 3);
+    EXPECT_EQ(channel_receiver->last_received_id, 3);
+    EXPECT_EQ(receiver_->received_count, 3);
+
+    // 追踪钩子看到通道订阅者的同步调用
+    EXPECT_GE(std::count(traces.begin(), traces.end(), EventTracePoint::kDirectCallStart), 6);
+    manager_->SetEventTraceHook(nullptr);
+
+    // 断开后两条发布路径都不再投递给它；总线订阅者不受影响
+    channel_conn.Disconnect();
+    EXPECT_FALSE(channel_conn.IsConnected());
+    channel.Fire(TestPayloadEvent(4, "after"));
+    bus_->FireGlobal<TestPayloadEvent>(5, "after");
+    EXPECT_EQ(channel_receiver->received_count, 3);
+    EXPECT_EQ(receiver_->received_count, 5);
+
+    // Unsubscribe(subscriber) 同样撤销通道订阅；订阅者销毁后自动失效
+    z3y::Connection second = channel.Subscribe(channel_receiver, &MockReceiver::OnEvent);
+    auto transient = std::make_shared<MockReceiver>();
+    z3y::Connection transient_conn = channel.Subscribe(transient, &MockReceiver::OnEvent);
+    channel.Fire(TestPayloadEvent(6, "again"));
+    EXPECT_EQ(channel_receiver->received_count, 4);
+    EXPECT_EQ(transient->received_count, 1);
+    bus_->Unsubscribe(channel_receiver);
+    transient.reset();
+    channel.Fire(TestPayloadEvent(7, "gone"));
+    EXPECT_EQ(channel_receiver->received_count, 4);
+    EXPECT_FALSE(transient_conn.IsConnected());
+}
+
+TEST_F(EventSystemTest, Filter_EvaluatedOnFiringThreadBeforeEnqueue) {
+    std::atomic<int> queued_entries{ 0 };
+    manager_->SetEventTraceHook([&](EventTracePoint pt, EventId id, void*, const char*) {
+        if (id == TestPayloadEvent::kEventId && pt == EventTracePoint::kQueuedEntry) queued_entries++;
+        });
+
+    // 按字段过滤的异步订阅：不匹配的事件不入队
+    auto by_id = std::make_shared<OrderedReceiver>();
+    z3y::ScopedConnection id_conn = bus_->SubscribeGlobalFiltered<TestPayloadEvent>(
+        by_id, &OrderedReceiver::OnEvent, z3y::MatchField(&TestPayloadEvent::id, 7), ConnectionType::kQueued);
+    // 按前缀过滤的同步订阅
+    z3y::ScopedConnection prefix_conn = bus_->SubscribeGlobalFiltered<TestPayloadEvent>(
+        receiver_, &MockReceiver::OnEvent, z3y::MatchPrefix(&TestPayloadEvent::msg, "Camera."));
+
+    for (int i = 0; i < 20; ++i) {
+        bus_->FireGlobal<TestPayloadEvent>(i % 10, i % 4 == 0 ? "Camera.Exposure" : "Light.Level");
+    }
+    for (int i = 0; i < 500 && by_id->received_count < 2; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_EQ(by_id->received_count, 2);
+    EXPECT_EQ(queued_entries.load(), 2);
+    EXPECT_EQ(receiver_->received_count, 5);
+
+    // 批量发布：整批都不匹配时不入队；匹配的元素逐个投递
+    const std::vector<TestPayloadEvent> misses = { { 1, "a" }, { 2, "b" } };
+    bus_->FireGlobalBatch(misses);
+    const std::vector<TestPayloadEvent> hits = { { 7, "x" }, { 3, "y" }, { 7, "z" } };
+    bus_->FireGlobalBatch(hits);
+    for (int i = 0; i < 500 && by_id->received_count < 4; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_EQ(by_id->received_count, 4);
+    EXPECT_EQ(queued_entries.load(), 3);
+    manager_->SetEventTraceHook(nullptr);
+
+    // 特定发送者 + 自定义谓词；谓词抛出异常视为不匹配
+    auto sender_receiver = std::make_shared<MockReceiver>();
+    z3y::ScopedConnection sender_conn = bus_->SubscribeToSenderFiltered<TestPayloadEvent>(
+        sender1_, sender_receiver, &MockReceiver::OnEvent, [](const TestPayloadEvent& e) {
+            if (e.id < 0) throw std::runtime_error("bad id");
+            return e.id % 2 == 0;
+        });
+    bus_->FireToSender<TestPayloadEvent>(sender1_, 2, "even");
+    bus_->FireToSender<TestPayloadEvent>(sender1_, 3, "odd");
+    bus_->FireToSender<TestPayloadEvent>(sender1_, -2, "throws");
+    EXPECT_EQ(sender_receiver->received_count, 1);
+    EXPECT_EQ(sender_receiver->last_received_id, 2);
+}
+
+/** @brief 慢订阅者：每次回调睡眠一段时间，并记录执行线程。 */
+class SlowReceiver : public z3y::PluginImpl<SlowReceiver> {
+public:
+    Z3Y_DEFINE_COMPONENT_ID("z3y-test-slow-receiver-UUID");
+
+    std::atomic<int> received_count{ 0 };
+    std::mutex mtx;
+    std::vector<std::thread::id> threads;
+
+    void OnEvent(const TestPayloadEvent&) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            threads.push_back(std::this_thread::get_id());
+        }
+        received_count++;
+    }
+};
+
+TEST_F(EventSystemTest, SlowHandler_ReportedWithClsidAndDemotedToQueued) {
+    manager_.reset();
+    z3y::PluginManager::Destroy();
+    z3y::PluginManagerOptions options;
+    options.event_slow_handler_threshold = std::chrono::milliseconds(5);
+    options.event_slow_handler_demote_after = 2;
+    manager_ = z3y::PluginManager::Create(options);
+    bus_ = z3y::GetDefaultService<IEventBus>();
+
+    std::mutex report_mtx;
+    std::vector<z3y::SlowEventHandlerReport> reports;
+    manager_->SetSlowEventHandlerCallback([&](const z3y::SlowEventHandlerReport& r) {
+        std::lock_guard<std::mutex> lock(report_mtx);
+        reports.push_back(r);
+        });
+
+    auto slow = std::make_shared<SlowReceiver>();
+    z3y::ScopedConnection slow_conn = bus_->SubscribeGlobal<TestPayloadEvent>(slow, &SlowReceiver::OnEvent);
+    z3y::ScopedConnection fast_conn = bus_->SubscribeGlobal<TestPayloadEvent>(receiver_, &MockReceiver::OnEvent);
+
+    // 前两次在发布线程上同步执行；第二次超时后被降级，第三次改由派发线程执行
+    for (int i = 0; i < 3; ++i) bus_->FireGlobal<TestPayloadEvent>(i, "slow");
+    for (int i = 0; i < 500 && slow->received_count < 3; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    ASSERT_EQ(slow->received_count, 3);
+    EXPECT_EQ(receiver_->received_count, 3);
+    {
+        std::lock_guard<std::mutex> lock(slow->mtx);
+        EXPECT_EQ(slow->threads[0], std::this_thread::get_id());
+        EXPECT_EQ(slow->threads[1], std::this_thread::get_id());
+        EXPECT_NE(slow->threads[2], std::this_thread::get_id());
+    }
+
+    for (int i = 0; i < 500; ++i) {
+        {
+            std::lock_guard<std::mutex> lock(report_mtx);
+            if (reports.size() >= 3) break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    {
+        std::lock_guard<std::mutex> lock(report_mtx);
+        ASSERT_EQ(reports.size(), 3u);  // 快速订阅者不会被报告
+        for (size_t i = 0; i < reports.size(); ++i) {
+            EXPECT_EQ(reports[i].event_id, TestPayloadEvent::kEventId);
+            EXPECT_EQ(reports[i].subscriber, reinterpret_cast<std::uintptr_t>(slow.get()));
+            EXPECT_EQ(reports[i].subscriber_clsid, SlowReceiver::kClsid);
+            EXPECT_TRUE(reports[i].plugin_path.empty());  // 未经插件注册
+            EXPECT_GE(reports[i].duration_ns, 5000000u);
+            EXPECT_GE(reports[i].max_ns, reports[i].duration_ns);
+            EXPECT_EQ(reports[i].slow_calls, i + 1);
+        }
+        EXPECT_FALSE(reports[0].demoted);
+        EXPECT_TRUE(reports[1].demoted);
+    }
+
+    auto metrics = manager_->GetEventDispatchMetrics();
+    bool found = false;
+    for (const auto& m : metrics.subscribers) {
+        if (m.subscriber != reinterpret_cast<std::uintptr_t>(slow.get())) continue;
+        found = true;
+        EXPECT_EQ(m.subscriber_clsid, SlowReceiver::kClsid);
+        EXPECT_EQ(m.slow_calls, 3u);
+        EXPECT_TRUE(m.demoted);
+        EXPECT_GE(m.average_ns, 5000000u);
+        EXPECT_GE(m.max_ns, m.average_ns);
+    }
+    EXPECT_TRUE(found);
+}
+
+namespace {
+    struct WindowSampleEvent : public z3y::Event {
+        Z3Y_DEFINE_EVENT(WindowSampleEvent, "z3y-test-evt-window-sample");
+        double value;
+        explicit WindowSampleEvent(double v) : value(v) {}
+    };
+    struct TumblingSummaryEvent : public z3y::EventWindowSummary {
+        Z3Y_DEFINE_EVENT(TumblingSummaryEvent, "z3y-test-evt-window-tumbling");
+    };
+    struct SlidingSummaryEvent : public z3y::EventWindowSummary {
+        Z3Y_DEFINE_EVENT(SlidingSummaryEvent, "z3y-test-evt-window-sliding");
+    };
+
+    class WindowSummaryCapture : public std::enable_shared_from_this<WindowSummaryCapture> {
+    public:
+        std::vector<z3y::EventWindowSummary> tumbling;
+        std::vector<z3y::EventWindowSummary> sliding;
+        void OnTumbling(const TumblingSummaryEvent& e) { tumbling.push_back(e); }
+        void OnSliding(const SlidingSummaryEvent& e) { sliding.push_back(e); }
+    };
+}
+
+/**
+ * @test 窗口聚合算子
+ * @brief 验证滚动窗口与滑动窗口的 count / sum / min / max / mean 与分位数 (相对误差 1% 以内)，
+ * 空窗口默认不发布，NaN 不计入，Detach 之后不再聚合。窗口由测试手动推进。
+ */
+TEST_F(EventSystemTest, Window_TumblingAndSlidingSummaries) {
+    auto timers = manager_->GetService<ITimerService>(clsid::kTimerService);
+    auto capture = std::make_shared<WindowSummaryCapture>();
+    z3y::ScopedConnection tumbling_conn =
+        bus_->SubscribeGlobal<TumblingSummaryEvent>(capture, &WindowSummaryCapture::OnTumbling);
+    z3y::ScopedConnection sliding_conn =
+        bus_->SubscribeGlobal<SlidingSummaryEvent>(capture, &WindowSummaryCapture::OnSliding);
+
+    // 定时器周期足够长：只由 Advance 推进
+    z3y::EventWindowOptions tumbling_options;
+    tumbling_options.window = std::chrono::hours(1);
+    tumbling_options.percentiles = { 0.5, 0.99 };
+    auto tumbling = z3y::EventWindow<WindowSampleEvent, TumblingSummaryEvent>::Attach(bus_, timers,
+        tumbling_options, [](const WindowSampleEvent& e) { return e.value; });
+    z3y::EventWindowOptions sliding_options;
+    sliding_options.window = std::chrono::hours(3);
+    sliding_options.step = std::chrono::hours(1);
+    auto sliding = z3y::EventWindow<WindowSampleEvent, SlidingSummaryEvent>::Attach(bus_, timers,
+        sliding_options, [](const WindowSampleEvent& e) { return e.value; });
+    EXPECT_THROW((z3y::EventWindow<WindowSampleEvent, SlidingSummaryEvent>::Attach(bus_, timers,
+        { std::chrono::hours(3), std::chrono::hours(2) }, [](const WindowSampleEvent& e) { return e.value; })),
+        std::invalid_argument);
+
+    // 1. 第一个窗口：1..1000 与一个 NaN
+    for (int i = 1; i <= 1000; ++i) bus_->FireGlobal<WindowSampleEvent>(static_cast<double>(i));
+    bus_->FireGlobal<WindowSampleEvent>(std::nan(""));
+    EXPECT_TRUE(capture->tumbling.empty());
+    tumbling->Advance();
+    sliding->Advance();
+    ASSERT_EQ(capture->tumbling.size(), 1u);
+    const z3y::EventWindowSummary& first = capture->tumbling[0];
+    EXPECT_EQ(first.count, 1000u);
+    EXPECT_DOUBLE_EQ(first.sum, 500500.0);
+    EXPECT_DOUBLE_EQ(first.min, 1.0);
+    EXPECT_DOUBLE_EQ(first.max, 1000.0);
+    EXPECT_DOUBLE_EQ(first.mean, 500.5);
+    ASSERT_EQ(first.percentiles.size(), 2u);
+    EXPECT_NEAR(first.percentiles[0], 500.0, 500.0 * 0.01);
+    EXPECT_NEAR(first.percentiles[1], 990.0, 990.0 * 0.01);
+    EXPECT_LE(first.window_start_ns, first.window_end_ns);
+
+    // 2. 第二个窗口：滚动窗口只看到新事件，滑动窗口覆盖两步
+    for (int i = 0; i < 10; ++i) bus_->FireGlobal<WindowSampleEvent>(-5.0);
+    tumbling->Advance();
+    sliding->Advance();
+    ASSERT_EQ(capture->tumbling.size(), 2u);
+    EXPECT_EQ(capture->tumbling[1].count, 10u);
+    EXPECT_DOUBLE_EQ(capture->tumbling[1].min, -5.0);
+    EXPECT_NEAR(capture->tumbling[1].percentiles[0], -5.0, 0.05);
+    ASSERT_EQ(capture->sliding.size(), 2u);
+    EXPECT_EQ(capture->sliding[1].count, 1010u);
+    EXPECT_DOUBLE_EQ(capture->sliding[1].min, -5.0);
+    EXPECT_DOUBLE_EQ(capture->sliding[1].max, 1000.0);
+    EXPECT_EQ(capture->sliding[1].window_start_ns, capture->sliding[0].window_start_ns);
+
+    // 3. 空步：滚动窗口不发布；滑动窗口仍含前两步。再过一步，最早的一步移出窗口
+    tumbling->Advance();
+    sliding->Advance();
+    EXPECT_EQ(capture->tumbling.size(), 2u);
+    ASSERT_EQ(capture->sliding.size(), 3u);
+    EXPECT_EQ(capture->sliding[2].count, 1010u);
+    sliding->Advance();
+    ASSERT_EQ(capture->sliding.size(), 4u);
+    EXPECT_EQ(capture->sliding[3].count, 10u);
+    EXPECT_DOUBLE_EQ(capture->sliding[3].max, -5.0);
+
+    // 4. Detach 之后不再聚合
+    tumbling->Detach();
+    bus_->FireGlobal<WindowSampleEvent>(1.0);
+    tumbling->Advance();
+    EXPECT_EQ(capture->tumbling.size(), 2u);
+}
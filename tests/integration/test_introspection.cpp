@@ -24,9 +24,14 @@
   * 3. **元数据验证**: 检查别名、单例标志、来源插件路径等信息是否准确。
   */
 
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+
 #include "common/plugin_test_base.h"
 #include "framework/i_plugin_query.h"
 #include "interfaces_demo/i_demo_logger.h"
+#include "interfaces_demo/i_demo_simple.h"
 
 using namespace z3y;
 
@@ -108,3 +113,171 @@ TEST_F(IntrospectionTest, GetDetailsByAlias) {
     EXPECT_TRUE(details.is_registered_as_default); // 它是默认实现
     EXPECT_TRUE(details.is_singleton);
 }
+
+/**
+ * @test 接口列表共享
+ * @brief 验证接口列表与编译期描述符一致，多次查询共享同一份数组，且插件卸载后仍然可读。
+ */
+TEST_F(IntrospectionTest, InterfaceList_SharedAcrossQueries) {
+    using namespace z3y::demo;
+    ComponentDetails first;
+    ComponentDetails second;
+    ASSERT_TRUE(query_->GetComponentDetailsByAlias("Demo.Logger.Default", first));
+    ASSERT_TRUE(query_->GetComponentDetailsByAlias("Demo.Logger.Default", second));
+
+    ASSERT_GE(first.implemented_interfaces.size(), 2u);
+    EXPECT_EQ(first.implemented_interfaces[0].iid, IComponent::kIid) << "IComponent 总在首位";
+    EXPECT_EQ(first.implemented_interfaces.begin(), second.implemented_interfaces.begin())
+        << "查询结果应共享注册时生成的列表，而不是各自复制";
+    EXPECT_TRUE(std::any_of(first.implemented_interfaces.begin(), first.implemented_interfaces.end(),
+        [](const InterfaceDetails& i) { return i.iid == IDemoLogger::kIid && i.name == IDemoLogger::kName; }));
+
+    manager_->UnloadAllPlugins();
+    EXPECT_EQ(first.implemented_interfaces[0].name, IComponent::kName) << "名称由框架持有，卸载后仍然有效";
+}
+
+/**
+ * @test 注册表快照
+ * @brief 验证快照在注册表不变时被复用、变化后重建且共享未变化组件的详情，
+ * 旧快照在插件卸载后依旧可以安全读取。
+ */
+TEST_F(IntrospectionTest, RegistrySnapshot_VersionedAndShared) {
+    using namespace z3y::demo;
+
+    auto first = manager_->GetRegistrySnapshot();
+    ASSERT_NE(first, nullptr);
+    EXPECT_EQ(manager_->GetRegistrySnapshot(), first) << "注册表未变化时应返回同一个快照";
+    EXPECT_GE(first->FindImplementing(IDemoLogger::kIid).size(), 2u);
+    EXPECT_EQ(first->components.size(), query_->GetAllComponents().size());
+
+    const ClassId extra = z3y::ConstexprHash("z3y-test-snapshot-extra");
+    auto registry = dynamic_cast<z3y::IPluginRegistry*>(manager_.get());
+    ASSERT_NE(registry, nullptr);
+    registry->RegisterComponent(extra, []() -> PluginPtr<IComponent> { return nullptr; }, false,
+        "Snapshot.Extra", {}, false);
+
+    auto second = manager_->GetRegistrySnapshot();
+    ASSERT_NE(second, first);
+    EXPECT_GT(second->version, first->version);
+    EXPECT_EQ(second->components.size(), first->components.size() + 1);
+    ASSERT_NE(second->Find(extra), nullptr);
+    EXPECT_EQ(second->Find(extra)->alias, "Snapshot.Extra");
+    EXPECT_EQ(first->Find(extra), nullptr) << "旧快照不可变";
+
+    // 未变化的组件详情在两个版本之间共享
+    const auto& loggers = first->FindImplementing(IDemoLogger::kIid);
+    EXPECT_EQ(second->Find(loggers.front()->clsid), loggers.front().get());
+
+    manager_->UnloadAllPlugins();
+    EXPECT_EQ(manager_->GetRegistrySnapshot()->Find(extra), nullptr);
+    EXPECT_FALSE(first->Find(loggers.front()->clsid)->alias.empty()) << "卸载后旧快照仍然可读";
+}
+
+/**
+ * @test 启动耗时报告
+ * @brief 验证报告包含已加载插件的各阶段耗时与已构造单例的初始化耗时，并能导出为 Chrome Trace。
+ */
+TEST_F(IntrospectionTest, StartupReport_PluginPhasesAndServiceInit) {
+    using namespace z3y::demo;
+    auto logger = z3y::GetDefaultService<IDemoLogger>();
+    ASSERT_NE(logger, nullptr);
+
+    const StartupReport report = query_->GetStartupReport();
+    ASSERT_EQ(report.plugins.size(), 1u);
+    const PluginLoadTiming& plugin = report.plugins.front();
+    EXPECT_TRUE(plugin.success);
+    EXPECT_FALSE(plugin.deferred);
+    EXPECT_GT(plugin.load_library_ns, 0u);
+    EXPECT_GT(plugin.component_count, 0u);
+    EXPECT_EQ(plugin.component_count, query_->GetComponentsFromPlugin(plugin.plugin_path).size());
+
+    ComponentDetails details;
+    ASSERT_TRUE(query_->GetComponentDetailsByAlias("Demo.Logger.Default", details));
+    auto it = std::find_if(report.services.begin(), report.services.end(),
+        [&](const ServiceInitTiming& s) { return s.clsid == details.clsid; });
+    ASSERT_NE(it, report.services.end()) << "已构造的单例应出现在报告中";
+    EXPECT_TRUE(it->success);
+    EXPECT_GE(it->start_ns, plugin.start_ns);
+
+    const auto trace = std::filesystem::temp_directory_path() / "z3y_startup_trace_test.json";
+    ASSERT_TRUE(manager_->DumpStartupTrace(trace));
+    std::ifstream in(trace);
+    const std::string json((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    EXPECT_NE(json.find("\"load_library\""), std::string::npos);
+    EXPECT_NE(json.find("z3y.startup.service"), std::string::npos);
+    in.close();
+    std::filesystem::remove(trace);
+}
+
+/**
+ * @test 按插件的内存记账
+ * @brief 验证默认关闭；启用后组件实例的字节数与个数随创建 / 释放增减。
+ */
+TEST_F(IntrospectionTest, PluginMemoryUsage_TracksLiveComponents) {
+    using namespace z3y::demo;
+    EXPECT_TRUE(query_->GetPluginMemoryUsage().empty()) << "默认不启用记账";
+
+    query_.reset();
+    manager_.reset();
+    z3y::PluginManager::Destroy();
+    z3y::PluginManagerOptions options;
+    options.enable_memory_accounting = true;
+    manager_ = z3y::PluginManager::Create(options);
+    ASSERT_TRUE(LoadPlugin("plugin_demo_core_services"));
+    const IPluginQuery& query = *manager_;
+
+    auto usage = query.GetPluginMemoryUsage();
+    ASSERT_EQ(usage.size(), 1u);
+    EXPECT_EQ(usage[0].live_components, 0);
+    EXPECT_EQ(usage[0].component_bytes, 0);
+
+    auto a = z3y::CreateInstance<IDemoSimple>("Demo.Simple.A");
+    auto b = z3y::CreateInstance<IDemoSimple>("Demo.Simple.A");
+    usage = query.GetPluginMemoryUsage();
+    ASSERT_EQ(usage.size(), 1u);
+    EXPECT_EQ(usage[0].live_components, 2);
+    EXPECT_GT(usage[0].component_bytes, 0);
+
+    a.reset();
+    b.reset();
+    usage = query.GetPluginMemoryUsage();
+    EXPECT_EQ(usage[0].live_components, 0);
+    EXPECT_EQ(usage[0].component_bytes, 0);
+}
+
+/**
+ * @test 按插件的 CPU 记账
+ * @brief 验证默认关闭；只启用 CPU 记账时不报告内存；组件与单例的构造 / Initialize 记入所属插件。
+ */
+TEST_F(IntrospectionTest, PluginCpuUsage_ChargesLifecycle) {
+    using namespace z3y::demo;
+    EXPECT_TRUE(query_->GetPluginCpuUsage().empty()) << "默认不启用记账";
+
+    query_.reset();
+    manager_.reset();
+    z3y::PluginManager::Destroy();
+    z3y::PluginManagerOptions options;
+    options.enable_cpu_accounting = true;
+    manager_ = z3y::PluginManager::Create(options);
+    ASSERT_TRUE(LoadPlugin("plugin_demo_core_services"));
+    const IPluginQuery& query = *manager_;
+    EXPECT_TRUE(query.GetPluginMemoryUsage().empty());
+
+    auto usage = query.GetPluginCpuUsage();
+    ASSERT_EQ(usage.size(), 1u);
+    EXPECT_EQ(usage[0].lifecycle_calls, 0u);
+    EXPECT_EQ(usage[0].callback_calls, 0u);
+
+    auto a = z3y::CreateInstance<IDemoSimple>("Demo.Simple.A");
+    auto b = z3y::CreateInstance<IDemoSimple>("Demo.Simple.A");
+    usage = query.GetPluginCpuUsage();
+    ASSERT_EQ(usage.size(), 1u);
+    EXPECT_EQ(usage[0].lifecycle_calls, 2u);
+    EXPECT_EQ(usage[0].callback_calls, 0u);
+    EXPECT_EQ(usage[0].callback_cpu_ns, 0u);
+
+    auto logger = z3y::GetDefaultService<IDemoLogger>();
+    ASSERT_TRUE(logger);
+    logger.reset();
+    EXPECT_EQ(query.GetPluginCpuUsage()[0].lifecycle_calls, 3u) << "单例的构造与 Initialize 记一次";
+}
@@ -22,12 +22,24 @@
   * 1. **非法文件**: 加载不存在的文件或非 DLL 文件。
   * 2. **重复加载**: 多次加载同一个插件的幂等性。
   * 3. **卸载清理**: 验证 UnloadAllPlugins 是否彻底清理了状态。
+  * 4. **并行加载**: 并行加载目录的结果与串行一致。
   */
 
 #include "common/plugin_test_base.h"
 #include "framework/plugin_manager.h"
+#include "interfaces_core/i_config_service.h"
+#include "interfaces_demo/demo_events.h"
+#include "interfaces_demo/i_demo_event_sender.h"
 #include "interfaces_demo/i_demo_logger.h"
+#include <algorithm>
+#include <chrono>
 #include <fstream>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#ifndef _WIN32
+#include <dlfcn.h>
+#endif
 
 using namespace z3y;
 
@@ -116,3 +128,287 @@ TEST_F(LoaderRobustnessTest, StateCleanupAfterUnload) {
         z3y::GetDefaultService<z3y::demo::IDemoLogger>();
         }, z3y::PluginException);
 }
+
+/**
+ * @test 并行加载目录
+ * @brief 验证多线程 LoadPluginsFromDirectory 与串行加载得到相同的插件、组件与失败列表。
+ */
+TEST_F(LoaderRobustnessTest, ParallelDirectoryLoadMatchesSerial) {
+    auto snapshot = [&](size_t threads) {
+        auto failures = manager_->LoadPluginsFromDirectory(bin_dir_, false, "z3yPluginInit", threads);
+        auto query = z3y::GetService<IPluginQuery>(clsid::kPluginQuery);
+        std::vector<ClassId> clsids;
+        for (const auto& c : query->GetAllComponents()) clsids.push_back(c.clsid);
+        std::sort(clsids.begin(), clsids.end());
+        auto files = query->GetLoadedPluginFiles();
+        query.reset();
+        manager_->UnloadAllPlugins();
+        return std::make_tuple(failures, clsids, files);
+    };
+
+    const auto serial = snapshot(1);
+    const auto parallel = snapshot(4);
+    EXPECT_FALSE(std::get<2>(serial).empty());
+    EXPECT_EQ(std::get<0>(serial), std::get<0>(parallel));
+    EXPECT_EQ(std::get<1>(serial), std::get<1>(parallel));
+    EXPECT_EQ(std::get<2>(serial), std::get<2>(parallel));
+}
+
+/**
+ * @test 插件清单缓存
+ * @brief 验证第二次启动时未变化的插件只注册延迟条目 (不加载库)，
+ * 内省结果与真实加载一致，首次 GetService 时才加载对应的库。
+ */
+TEST_F(LoaderRobustnessTest, ManifestCacheDefersLoading) {
+    const auto cache = std::filesystem::temp_directory_path() / "z3y_manifest_cache_test.txt";
+    std::filesystem::remove(cache);
+    manager_->SetPluginManifestCache(cache);
+
+    const auto failures = manager_->LoadPluginsFromDirectory(bin_dir_, false);
+    auto query = z3y::GetService<IPluginQuery>(clsid::kPluginQuery);
+    const size_t component_count = query->GetAllComponents().size();
+    ASSERT_FALSE(query->GetLoadedPluginFiles().empty());
+    query.reset();
+    manager_->UnloadAllPlugins();
+    ASSERT_TRUE(std::filesystem::exists(cache));
+
+    EXPECT_EQ(manager_->LoadPluginsFromDirectory(bin_dir_, false), failures);
+    query = z3y::GetService<IPluginQuery>(clsid::kPluginQuery);
+    EXPECT_EQ(query->GetAllComponents().size(), component_count);
+    EXPECT_TRUE(query->GetLoadedPluginFiles().empty()) << "未变化的插件不应被加载";
+
+    auto logger = z3y::GetDefaultService<z3y::demo::IDemoLogger>();
+    ASSERT_NE(logger, nullptr);
+    EXPECT_EQ(query->GetLoadedPluginFiles().size(), 1u) << "只加载提供该服务的插件";
+
+    query.reset();
+    logger.reset();
+    manager_->UnloadAllPlugins();
+    std::filesystem::remove(cache);
+}
+
+/**
+ * @test 延迟符号绑定
+ * @brief 验证以 kLazy 策略加载的插件功能正常。
+ */
+TEST_F(LoaderRobustnessTest, LazySymbolBindingLoadsPlugins) {
+    manager_.reset();
+    z3y::PluginManager::Destroy();
+    z3y::PluginManagerOptions options;
+    options.plugin_symbol_binding = z3y::PluginSymbolBinding::kLazy;
+    manager_ = z3y::PluginManager::Create(options);
+    ASSERT_TRUE(LoadPlugin("plugin_demo_core_services"));
+    auto logger = z3y::GetDefaultService<z3y::demo::IDemoLogger>();
+    ASSERT_NE(logger, nullptr);
+    logger->Log("lazy binding");
+}
+
+/** @brief 记录收到的插件卸载事件。 */
+class UnloadMonitor : public std::enable_shared_from_this<UnloadMonitor> {
+public:
+    std::vector<std::string> unloaded;
+    void OnUnload(const z3y::event::PluginUnloadEvent& e) { unloaded.push_back(e.plugin_path_); }
+};
+
+/**
+ * @test 单独卸载 / 热重载
+ * @brief 验证 UnloadPlugin 只移除目标插件的组件 (其他插件的单例保持原实例)，
+ * 触发 PluginUnloadEvent，之后 ReloadPlugin 可以重新提供服务。
+ */
+TEST_F(LoaderRobustnessTest, UnloadSinglePluginKeepsOthersWarm) {
+    ASSERT_TRUE(LoadPlugin("plugin_demo_core_services"));
+    ASSERT_TRUE(LoadPlugin("plugin_config_manager"));
+    auto monitor = std::make_shared<UnloadMonitor>();
+    z3y::ScopedConnection conn = manager_->SubscribeGlobal<z3y::event::PluginUnloadEvent>(
+        monitor, &UnloadMonitor::OnUnload);
+
+    auto logger = z3y::GetDefaultService<z3y::demo::IDemoLogger>();
+    ASSERT_NE(z3y::GetDefaultService<z3y::interfaces::core::IConfigService>(), nullptr);
+    std::string config_path;
+    for (const auto& file : z3y::GetService<IPluginQuery>(clsid::kPluginQuery)->GetLoadedPluginFiles()) {
+        if (file.find("plugin_config_manager") != std::string::npos) config_path = file;
+    }
+    ASSERT_FALSE(config_path.empty());
+
+    std::string err;
+    ASSERT_TRUE(manager_->UnloadPlugin(z3y::utils::Utf8ToPath(config_path), err)) << err;
+    EXPECT_EQ(monitor->unloaded, std::vector<std::string>{ config_path });
+    EXPECT_EQ(z3y::GetDefaultService<z3y::demo::IDemoLogger>(), logger) << "其他插件的单例不应被重建";
+    EXPECT_THROW((void)z3y::GetDefaultService<z3y::interfaces::core::IConfigService>(), z3y::PluginException);
+    EXPECT_EQ(z3y::GetService<IPluginQuery>(clsid::kPluginQuery)->GetLoadedPluginFiles().size(), 1u);
+    EXPECT_FALSE(manager_->UnloadPlugin(z3y::utils::Utf8ToPath(config_path), err)) << "重复卸载应失败";
+
+    // 卸载后的插件可以重新加载
+    ASSERT_TRUE(LoadPlugin("plugin_config_manager"));
+    ASSERT_TRUE(manager_->ReloadPlugin(z3y::utils::Utf8ToPath(config_path), err)) << err;
+    EXPECT_NE(z3y::GetDefaultService<z3y::interfaces::core::IConfigService>(), nullptr);
+    EXPECT_EQ(monitor->unloaded.size(), 2u);
+}
+
+/**
+ * @test 析构中断开的订阅
+ * @brief 验证单例在析构中才断开的 ScopedConnection (订阅者是它持有的辅助对象)
+ * 在卸载库之前被回收：之后的发布与 GC 不会再调用已卸载模块中的代码。
+ */
+TEST_F(LoaderRobustnessTest, UnloadReclaimsSubscriptionsReleasedInDestructor) {
+    ASSERT_TRUE(LoadPlugin("plugin_demo_core_services"));
+    ASSERT_TRUE(LoadPlugin("plugin_demo_module_events"));
+    {
+        auto sender = z3y::GetService<z3y::demo::IDemoEventSender>("Demo.EventSender");
+        sender->FireGlobal();  // 首次调用时订阅 EchoListener
+    }
+    ASSERT_TRUE(manager_->IsGlobalSubscribed(z3y::demo::DemoGlobalEvent::kEventId));
+    std::string events_path;
+    for (const auto& file : z3y::GetService<IPluginQuery>(clsid::kPluginQuery)->GetLoadedPluginFiles()) {
+        if (file.find("plugin_demo_module_events") != std::string::npos) events_path = file;
+    }
+    ASSERT_FALSE(events_path.empty());
+
+    std::string err;
+    ASSERT_TRUE(manager_->UnloadPlugin(z3y::utils::Utf8ToPath(events_path), err)) << err;
+    // 被撕票的订阅若留到卸载之后才回收，之后的发布与 GC 会调用已卸载的析构代码
+    EXPECT_FALSE(manager_->IsGlobalSubscribed(z3y::demo::DemoGlobalEvent::kEventId))
+        << "析构中断开的订阅应在卸载库之前被压缩";
+    z3y::FireGlobalEvent<z3y::demo::DemoGlobalEvent>("after unload");
+    EXPECT_THROW((void)z3y::GetService<z3y::demo::IDemoEventSender>("Demo.EventSender"), z3y::PluginException);
+}
+
+/** @brief 记录目录监视触发的加载结果 (回调在监视线程上执行)。 */
+class LoadResultMonitor : public std::enable_shared_from_this<LoadResultMonitor> {
+public:
+    std::mutex mutex;
+    std::vector<std::string> loaded;
+    std::vector<std::string> failed;
+    void OnSuccess(const z3y::event::PluginLoadSuccessEvent& e) {
+        std::lock_guard<std::mutex> lock(mutex);
+        loaded.push_back(e.plugin_path_);
+    }
+    void OnFailure(const z3y::event::PluginLoadFailureEvent& e) {
+        std::lock_guard<std::mutex> lock(mutex);
+        failed.push_back(e.plugin_path_);
+    }
+};
+
+/**
+ * @test 插件目录监视
+ * @brief 验证放入监视目录的插件被后台线程增量加载，损坏的文件通过 PluginLoadFailureEvent 报告。
+ */
+TEST_F(LoaderRobustnessTest, DirectoryWatchLoadsDroppedPlugins) {
+    std::filesystem::path source;
+    for (const auto& entry : std::filesystem::directory_iterator(bin_dir_)) {
+        const std::string name = entry.path().filename().string();
+        if (name.find("plugin_config_manager") != std::string::npos &&
+            entry.path().extension() == z3y::utils::GetSharedLibraryExtension()) {
+            source = entry.path();
+        }
+    }
+    ASSERT_FALSE(source.empty());
+    const auto watch_dir = std::filesystem::temp_directory_path() / "z3y_plugin_watch_test";
+    std::filesystem::remove_all(watch_dir);
+    std::filesystem::create_directories(watch_dir);
+
+    auto monitor = std::make_shared<LoadResultMonitor>();
+    z3y::ScopedConnection c1 = manager_->SubscribeGlobal<z3y::event::PluginLoadSuccessEvent>(
+        monitor, &LoadResultMonitor::OnSuccess);
+    z3y::ScopedConnection c2 = manager_->SubscribeGlobal<z3y::event::PluginLoadFailureEvent>(
+        monitor, &LoadResultMonitor::OnFailure);
+    if (!manager_->StartPluginDirectoryWatch(watch_dir)) {
+        GTEST_SKIP() << "Directory watch is not supported on this platform";
+    }
+    EXPECT_FALSE(manager_->StartPluginDirectoryWatch(watch_dir)) << "重复启动应失败";
+
+    const std::string ext = z3y::utils::GetSharedLibraryExtension();
+    { std::ofstream(watch_dir / ("broken" + ext)) << "not a shared library"; }
+    std::filesystem::copy_file(source, watch_dir / ("plugin.tmp"));
+    std::filesystem::rename(watch_dir / "plugin.tmp", watch_dir / source.filename());
+
+    auto done = [&] {
+        std::lock_guard<std::mutex> lock(monitor->mutex);
+        return !monitor->loaded.empty() && !monitor->failed.empty();
+    };
+    for (int i = 0; i < 500 && !done(); ++i) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    manager_->StopPluginDirectoryWatch();
+    {
+        std::lock_guard<std::mutex> lock(monitor->mutex);
+        ASSERT_EQ(monitor->loaded.size(), 1u);
+        EXPECT_NE(monitor->loaded[0].find(source.filename().string()), std::string::npos);
+        ASSERT_EQ(monitor->failed.size(), 1u);
+        EXPECT_NE(monitor->failed[0].find("broken"), std::string::npos);
+    }
+    EXPECT_NE(z3y::GetDefaultService<z3y::interfaces::core::IConfigService>(), nullptr);
+
+    manager_->UnloadAllPlugins();
+    std::filesystem::remove_all(watch_dir);
+}
+
+/**
+ * @test 按文件身份判断已加载
+ * @brief 验证经符号链接 (不同路径) 再次加载同一个插件文件时视为已加载，不会重复注册。
+ */
+TEST_F(LoaderRobustnessTest, SameFileThroughDifferentPathIsLoadedOnce) {
+    ASSERT_TRUE(LoadPlugin("plugin_demo_core_services"));
+    auto query = z3y::GetService<IPluginQuery>(clsid::kPluginQuery);
+    const auto files = query->GetLoadedPluginFiles();
+    ASSERT_EQ(files.size(), 1u);
+    const size_t component_count = query->GetAllComponents().size();
+
+    const auto link_dir = std::filesystem::temp_directory_path() / "z3y_plugin_identity_test";
+    std::filesystem::remove_all(link_dir);
+    std::filesystem::create_directories(link_dir);
+    const auto original = z3y::utils::Utf8ToPath(files[0]);
+    const auto link = link_dir / original.filename();
+    std::error_code ec;
+    std::filesystem::create_symlink(std::filesystem::absolute(original), link, ec);
+    if (ec) {
+        std::filesystem::remove_all(link_dir);
+        GTEST_SKIP() << "Cannot create symlink: " << ec.message();
+    }
+
+    std::string err;
+    EXPECT_TRUE(manager_->LoadPlugin(link, err)) << err;
+    EXPECT_EQ(query->GetLoadedPluginFiles(), files);
+    EXPECT_EQ(query->GetAllComponents().size(), component_count);
+
+    query.reset();
+    manager_->UnloadAllPlugins();
+    std::filesystem::remove_all(link_dir);
+}
+
+/**
+ * @test 并行 Shutdown 与快速退出
+ * @brief 验证多线程、带超时的卸载能完成所有 Shutdown 而不报告超时；
+ * 开启 `shutdown_skip_library_unload` 时插件库在卸载后仍留在内存中，再次加载照常可用。
+ */
+TEST_F(LoaderRobustnessTest, ParallelShutdownAndFastExitKeepLibrariesMapped) {
+    manager_.reset();
+    z3y::PluginManager::Destroy();
+    z3y::PluginManagerOptions options;
+    options.shutdown_threads = 4;
+    options.shutdown_service_timeout = std::chrono::seconds(10);
+    options.shutdown_skip_library_unload = true;
+    manager_ = z3y::PluginManager::Create(options);
+    std::atomic<int> reported{ 0 };
+    manager_->SetExceptionHandler([&reported](const std::exception&) { reported++; });
+
+    ASSERT_TRUE(LoadPlugin("plugin_demo_core_services"));
+    ASSERT_TRUE(LoadPlugin("plugin_config_manager"));
+    // 配置服务在 Initialize 中获取事件总线与执行器 (框架内置服务不参与排序)
+    ASSERT_NE(z3y::GetDefaultService<z3y::interfaces::core::IConfigService>(), nullptr);
+    ASSERT_NE(z3y::GetDefaultService<z3y::demo::IDemoLogger>(), nullptr);
+    std::vector<std::string> files = z3y::GetService<IPluginQuery>(clsid::kPluginQuery)->GetLoadedPluginFiles();
+    ASSERT_EQ(files.size(), 2u);
+
+    manager_->UnloadAllPlugins();
+    EXPECT_EQ(reported.load(), 0) << "不应有 Shutdown 异常或超时";
+    EXPECT_TRUE(z3y::GetService<IPluginQuery>(clsid::kPluginQuery)->GetLoadedPluginFiles().empty());
+#ifndef _WIN32
+    for (const auto& file : files) {
+        void* handle = ::dlopen(file.c_str(), RTLD_NOW | RTLD_NOLOAD);
+        EXPECT_NE(handle, nullptr) << file << " 不应被卸载";
+        if (handle) ::dlclose(handle);
+    }
+#endif
+
+    ASSERT_TRUE(LoadPlugin("plugin_config_manager"));
+    EXPECT_NE(z3y::GetDefaultService<z3y::interfaces::core::IConfigService>(), nullptr);
+}
@@ -0,0 +1,262 @@
+﻿/**
+ * @file test_metrics_exporter.cpp
+ * @brief 指标导出插件 (plugin_metrics_exporter) 的集成测试。
+ * * @details
+ * 【面向测试与维护人员】
+ * 覆盖：已输出报告与在途快照的合并、OpenMetrics 文本格式、HTTP `/metrics` 端点，
+ * 以及机群汇总的增量数据报与 FleetAggregator 的合并。
+ */
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include "common/plugin_test_base.h"
+#include "framework/z3y_service_locator.h"
+#include "interfaces_core/i_config_service.h"
+#include "interfaces_profiler/fleet_snapshot.h"
+#include "interfaces_profiler/i_metrics_exporter.h"
+#include "interfaces_profiler/profiler_macros.h"
+
+using namespace z3y;
+using z3y::interfaces::profiler::IMetricsExporter;
+using z3y::interfaces::profiler::IProfilerService;
+
+/**
+ * @brief 加载日志、配置、Profiler 与指标导出插件的测试固件。
+ */
+class MetricsExporterTest : public PluginTestBase {
+ protected:
+  void SetUp() override {
+    PluginTestBase::SetUp();
+    ASSERT_TRUE(LoadPlugin("plugin_spdlog_logger"));
+    ASSERT_TRUE(LoadPlugin("plugin_config_manager"));
+    ASSERT_TRUE(LoadPlugin("plugin_profiler"));
+    ASSERT_TRUE(LoadPlugin("plugin_metrics_exporter"));
+
+    if (auto [cfg_svc, err] =
+            TryGetDefaultService<z3y::interfaces::core::IConfigService>();
+        err == z3y::InstanceError::kSuccess) {
+      cfg_svc->SetValue("System.Profiler.Enable", true);
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+  }
+
+  void TearDown() override {
+    z3y::interfaces::profiler::ResetProfilerCache();
+    // 先断开导出器与 Profiler 的连接，再让框架卸载插件
+    if (auto [exporter, err] = TryGetDefaultService<IMetricsExporter>();
+        err == z3y::InstanceError::kSuccess) {
+      exporter->Shutdown();
+    }
+    if (auto [svc, err] = TryGetDefaultService<IProfilerService>();
+        err == z3y::InstanceError::kSuccess) {
+      svc->Shutdown();
+    }
+    PluginTestBase::TearDown();
+  }
+};
+
+/**
+ * @brief 已输出的周期报告与尚未输出的在途数据合并为一条累计计数器。
+ */
+TEST_F(MetricsExporterTest, Verify_Reported_And_Live_Data_Are_Merged) {
+  auto [profiler, err] = TryGetDefaultService<IProfilerService>();
+  ASSERT_EQ(err, z3y::InstanceError::kSuccess);
+  auto [exporter, exp_err] = TryGetDefaultService<IMetricsExporter>();
+  ASSERT_EQ(exp_err, z3y::InstanceError::kSuccess);
+
+  // 周期为 3：前 3 次进入报告（根节点随后清零），后 2 次仍在途
+  for (int i = 0; i < 5; ++i) {
+    Z3Y_PROFILE_ROOT("Metrics_Export_Root", 3, 0.0);
+    {
+      Z3Y_PROFILE_NAMED("Decode");
+    }
+    Z3Y_PROFILE_VALUE("Queue_Depth", 2.0 + i);
+  }
+  profiler->FlushReports();
+  exporter->Refresh();
+
+  std::string text = exporter->RenderOpenMetrics();
+  EXPECT_NE(text.find("# TYPE z3y_profile_calls counter"), std::string::npos);
+  EXPECT_NE(text.find("z3y_profile_calls_total{path=\"Metrics_Export_Root/"
+                      "Decode\",type=\"timer\"} 5"),
+            std::string::npos)
+      << text;
+  EXPECT_NE(text.find("z3y_profile_value_sum_total{path=\"Metrics_Export_Root/"
+                      "Queue_Depth\",type=\"value\"} 20"),
+            std::string::npos)
+      << text;
+  EXPECT_NE(text.find("z3y_profile_time_ms_total{path=\"Metrics_Export_Root\""),
+            std::string::npos);
+  ASSERT_GE(text.size(), 6u);
+  EXPECT_EQ(text.substr(text.size() - 6), "# EOF\n");
+
+  // 快照不重置数据：再刷新一次计数不变
+  exporter->Refresh();
+  EXPECT_NE(exporter->RenderOpenMetrics().find(
+                "z3y_profile_calls_total{path=\"Metrics_Export_Root/"
+                "Decode\",type=\"timer\"} 5"),
+            std::string::npos);
+}
+
+/**
+ * @brief HTTP 端点返回与 RenderOpenMetrics 相同的文本。
+ */
+TEST_F(MetricsExporterTest, Verify_Http_Endpoint) {
+#ifdef _WIN32
+  GTEST_SKIP() << "HTTP client in this test is POSIX-only.";
+#else
+  auto [exporter, exp_err] = TryGetDefaultService<IMetricsExporter>();
+  ASSERT_EQ(exp_err, z3y::InstanceError::kSuccess);
+  auto [cfg_svc, cfg_err] =
+      TryGetDefaultService<z3y::interfaces::core::IConfigService>();
+  ASSERT_EQ(cfg_err, z3y::InstanceError::kSuccess);
+
+  const int port = 39217;
+  cfg_svc->SetValue("System.Metrics.HttpPort", port);
+  for (int i = 0; i < 100 && exporter->GetHttpPort() == 0; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  if (exporter->GetHttpPort() == 0) {
+    GTEST_SKIP() << "Port " << port << " is unavailable in this environment.";
+  }
+
+  {
+    Z3Y_PROFILE_ROOT("Http_Export_Root", 1000, 0.0);
+  }
+  exporter->Refresh();
+
+  int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+  ASSERT_GE(fd, 0);
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(static_cast<uint16_t>(port));
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  ASSERT_EQ(::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), 0);
+  const std::string request = "GET /metrics HTTP/1.1\r\nHost: localhost\r\n\r\n";
+  ASSERT_EQ(::send(fd, request.data(), request.size(), 0),
+            static_cast<ssize_t>(request.size()));
+  std::string response;
+  char buf[4096];
+  ssize_t n;
+  while ((n = ::recv(fd, buf, sizeof(buf), 0)) > 0) response.append(buf, n);
+  ::close(fd);
+
+  EXPECT_EQ(response.rfind("HTTP/1.1 200 OK", 0), 0u) << response;
+  EXPECT_NE(response.find("application/openmetrics-text"), std::string::npos);
+  EXPECT_NE(response.find("path=\"Http_Export_Root\""), std::string::npos);
+  EXPECT_NE(response.find("# EOF"), std::string::npos);
+
+  cfg_svc->SetValue("System.Metrics.HttpPort", 0);
+#endif
+}
+
+/**
+ * @brief 机群模式：导出器只发送增量，汇总端合并两台机器后给出机群分位数与离群机器。
+ */
+TEST_F(MetricsExporterTest, Verify_Fleet_Deltas_Merge_Across_Machines) {
+#ifdef _WIN32
+  GTEST_SKIP() << "UDP receiver in this test is POSIX-only.";
+#else
+  using namespace z3y::interfaces::profiler::fleet;
+  auto [exporter, exp_err] = TryGetDefaultService<IMetricsExporter>();
+  ASSERT_EQ(exp_err, z3y::InstanceError::kSuccess);
+  auto [cfg_svc, cfg_err] =
+      TryGetDefaultService<z3y::interfaces::core::IConfigService>();
+  ASSERT_EQ(cfg_err, z3y::InstanceError::kSuccess);
+
+  int fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+  ASSERT_GE(fd, 0);
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  ASSERT_EQ(::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), 0);
+  socklen_t len = sizeof(addr);
+  ASSERT_EQ(::getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len), 0);
+
+  cfg_svc->SetValue("System.Profiler.HistogramPrecision", 3);
+  cfg_svc->SetValue("System.Metrics.FleetNode", std::string("node-a"));
+  cfg_svc->SetValue("System.Metrics.FleetTarget",
+                    "127.0.0.1:" + std::to_string(ntohs(addr.sin_port)));
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+  FleetAggregator fleet;
+  // 收下本轮刷新发出的全部数据报，返回个数
+  auto drain = [&]() {
+    int received = 0;
+    char buf[65536];
+    pollfd pfd{fd, POLLIN, 0};
+    while (::poll(&pfd, 1, 200) > 0) {
+      ssize_t n = ::recv(fd, buf, sizeof(buf), 0);
+      if (n <= 0) break;
+      EXPECT_TRUE(fleet.Ingest(std::string_view(buf, static_cast<size_t>(n))));
+      ++received;
+    }
+    return received;
+  };
+  auto work = [](int calls) {
+    for (int i = 0; i < calls; ++i) {
+      Z3Y_PROFILE_ROOT("Fleet_Export_Root", 1000, 0.0);
+      Z3Y_PROFILE_NAMED("Work");
+    }
+  };
+
+  work(20);
+  exporter->Refresh();
+  EXPECT_GE(drain(), 1);
+  // 没有新调用时不发送任何数据报
+  exporter->Refresh();
+  EXPECT_EQ(drain(), 0);
+  work(5);
+  exporter->Refresh();
+  EXPECT_GE(drain(), 1);
+
+  // 另一台机器：同一路径 20 次，每次 50ms
+  constexpr uint64_t kSlowNs = 50'000'000;
+  FleetSeries slow;
+  slow.count = 20;
+  slow.total_ns = 20 * kSlowNs;
+  slow.histogram_bits = 3;
+  slow.histogram[static_cast<uint32_t>(
+      z3y::interfaces::profiler::LogHistogram::IndexOf(3, kSlowNs))] = 20;
+  FleetEncoder remote("node-b", 7);
+  for (const std::string& datagram :
+       remote.Encode({{"Fleet_Export_Root/Work", slow}})) {
+    ASSERT_TRUE(fleet.Ingest(datagram));
+  }
+
+  const FleetPathSummary* row = nullptr;
+  const auto rows = fleet.Summarize(2.0);
+  for (const FleetPathSummary& r : rows) {
+    if (r.path == "Fleet_Export_Root/Work") row = &r;
+  }
+  ASSERT_NE(row, nullptr);
+  EXPECT_EQ(row->count, 45u);
+  ASSERT_EQ(row->machines.size(), 2u);
+  EXPECT_TRUE(row->has_percentiles);
+  EXPECT_NEAR(row->percentiles[3], 50.0, 5.0);  // p999 落在慢机器上
+  EXPECT_EQ(row->machines[0].node, "node-b");
+  EXPECT_TRUE(row->machines[0].outlier);
+  EXPECT_EQ(row->machines[1].node, "node-a");
+  EXPECT_EQ(row->machines[1].count, 25u);
+  EXPECT_FALSE(row->machines[1].outlier);
+
+  for (const FleetMachineStatus& m : fleet.GetMachines()) {
+    EXPECT_EQ(m.lost, 0u) << m.node;
+  }
+  EXPECT_EQ(fleet.GetMalformed(), 0u);
+
+  cfg_svc->SetValue("System.Metrics.FleetTarget", std::string());
+  cfg_svc->SetValue("System.Profiler.HistogramPrecision", 0);
+  ::close(fd);
+#endif
+}
@@ -0,0 +1,158 @@
+﻿/**
+ * @file test_network_plugin.cpp
+ * @brief 跨主机事件桥插件 (plugin_net_event_bridge) 的集成测试。
+ * * @details
+ * 【面向测试与维护人员】
+ * 两个桥在同一进程内通过回环 TCP 互连、共用一条事件总线：
+ * 覆盖订阅通告驱动的按需导出、批量转发、回环抑制与断线后的订阅撤销。
+ * 组播依赖网卡与路由配置，不在这里覆盖。
+ */
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common/plugin_test_base.h"
+#include "framework/z3y_service_locator.h"
+#include "interfaces_core/i_net_event_bridge.h"
+
+using namespace z3y;
+using z3y::interfaces::core::INetEventBridge;
+
+namespace {
+
+/** @brief 可跨主机转发的测试事件。 */
+struct NetSampleEvent : public z3y::Event {
+  Z3Y_DEFINE_SERIALIZABLE_EVENT(NetSampleEvent, "z3y-test-evt-net-sample-001");
+  uint32_t seq = 0;
+  std::string station;
+  NetSampleEvent(uint32_t s, std::string st) : seq(s), station(std::move(st)) {}
+
+  void Serialize(z3y::EventWriter& w) const {
+    w.Write(seq);
+    w.WriteString(station);
+  }
+  static NetSampleEvent Deserialize(z3y::EventReader& r) {
+    const uint32_t s = r.Read<uint32_t>();
+    return NetSampleEvent(s, r.ReadString());
+  }
+};
+
+class SampleReceiver : public std::enable_shared_from_this<SampleReceiver> {
+ public:
+  std::mutex mutex;
+  std::vector<uint32_t> seqs;
+
+  void OnSample(const NetSampleEvent& e) {
+    std::lock_guard<std::mutex> lock(mutex);
+    seqs.push_back(e.seq);
+  }
+  size_t Count() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return seqs.size();
+  }
+};
+
+template <typename Pred>
+bool WaitUntil(Pred pred, int timeout_ms = 3000) {
+  const auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+  while (!pred()) {
+    if (std::chrono::steady_clock::now() > deadline) return false;
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return true;
+}
+
+}  // namespace
+
+/**
+ * @brief 加载事件桥插件的测试固件。
+ */
+class NetworkPluginTest : public PluginTestBase {
+ protected:
+  void SetUp() override {
+    PluginTestBase::SetUp();
+    ASSERT_TRUE(LoadPlugin("plugin_net_event_bridge"));
+    bus_ = z3y::GetService<z3y::IEventBus>(z3y::clsid::kEventBus);
+  }
+
+  void TearDown() override {
+    bus_.reset();
+    PluginTestBase::TearDown();
+  }
+
+  PluginPtr<z3y::IEventBus> bus_;
+};
+
+/**
+ * @brief 只有远端导入后才订阅本地总线；转发按批进行，导入的事件不会被再次导出；
+ * 连接断开后订阅随之撤销。
+ */
+TEST_F(NetworkPluginTest, Verify_Subscription_Aware_Batched_Forwarding) {
+  auto sender = z3y::CreateDefaultInstance<INetEventBridge>();
+  auto receiver_node = z3y::CreateDefaultInstance<INetEventBridge>();
+  ASSERT_TRUE(sender);
+  ASSERT_TRUE(receiver_node);
+  ASSERT_NE(sender.get(), receiver_node.get());  // 组件而非单例
+
+  // 1. 只登记导出时不订阅本地总线，事件不上线
+  sender->Export<NetSampleEvent>();
+  receiver_node->Export<NetSampleEvent>();  // 对端没人导入：永远不会激活
+  bus_->FireGlobal<NetSampleEvent>(0u, "nobody");
+  EXPECT_FALSE(bus_->IsGlobalSubscribed(NetSampleEvent::kEventId));
+
+  std::string err;
+  const uint16_t port = sender->ListenTcp("127.0.0.1", 0, err);
+  ASSERT_NE(port, 0) << err;
+  ASSERT_TRUE(receiver_node->ConnectTcp("127.0.0.1:" + std::to_string(port), err)) << err;
+  ASSERT_TRUE(WaitUntil([&] {
+    return sender->GetStats().connected_peers == 1 &&
+           receiver_node->GetStats().connected_peers == 1;
+  }));
+  EXPECT_FALSE(sender->IsRemoteSubscribed(NetSampleEvent::kEventId));
+
+  // 2. 远端导入后，发送端在本地总线上订阅
+  receiver_node->Import<NetSampleEvent>();
+  ASSERT_TRUE(WaitUntil([&] { return sender->IsRemoteSubscribed(NetSampleEvent::kEventId); }));
+  EXPECT_TRUE(bus_->IsGlobalSubscribed(NetSampleEvent::kEventId));
+  EXPECT_FALSE(receiver_node->IsRemoteSubscribed(NetSampleEvent::kEventId));
+
+  // 3. 连续发布：本地订阅者收到原事件与接收端转发回来的副本
+  auto local = std::make_shared<SampleReceiver>();
+  z3y::ScopedConnection conn =
+      bus_->SubscribeGlobal<NetSampleEvent>(local, &SampleReceiver::OnSample);
+  constexpr uint32_t kCount = 1000;
+  for (uint32_t i = 1; i <= kCount; ++i) bus_->FireGlobal<NetSampleEvent>(i, "cell-1");
+  ASSERT_TRUE(WaitUntil([&] { return local->Count() >= 2 * kCount; }));
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));  // 若有回环，会继续出现副本
+  EXPECT_EQ(local->Count(), 2 * kCount);
+
+  const auto sent = sender->GetStats();
+  const auto recv = receiver_node->GetStats();
+  EXPECT_EQ(sent.sent_events, kCount);
+  EXPECT_LT(sent.sent_frames, sent.sent_events);  // 合并成批
+  EXPECT_EQ(recv.received_events, kCount);
+  EXPECT_EQ(recv.sent_events, 0u);  // 导入的事件没有被再次导出
+  EXPECT_EQ(recv.decode_failures, 0u);
+  {
+    // 转发的副本保持发布顺序
+    std::lock_guard<std::mutex> lock(local->mutex);
+    std::vector<uint32_t> remote;
+    for (uint32_t seq : local->seqs) {
+      if (remote.size() < kCount && seq == remote.size() + 1) remote.push_back(seq);
+    }
+    EXPECT_EQ(remote.size(), kCount);
+  }
+
+  // 4. 接收端停止后，发送端撤销订阅
+  conn.Disconnect();
+  receiver_node->Stop();
+  ASSERT_TRUE(WaitUntil([&] { return !sender->IsRemoteSubscribed(NetSampleEvent::kEventId); }));
+  EXPECT_EQ(sender->GetStats().connected_peers, 0u);
+  ASSERT_TRUE(WaitUntil([&] { return !bus_->IsGlobalSubscribed(NetSampleEvent::kEventId); }));
+
+  sender->Stop();
+}
@@ -13,13 +13,27 @@
  * 如果产生死锁或一直 Pending，极大可能是修改破坏了 LCRS 树的并发控制状态机。
  */
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cstdio>
 #include <filesystem>
 #include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
 #include <string>
 #include <thread>
+#include <utility>
+#include <vector>
 
 #include "common/plugin_test_base.h"
+#include "framework/allocation_hook.h"
+#include "framework/pipeline.h"
+#include "framework/profiled_mutex.h"
+#include "framework/z3y_define_impl.h"
 #include "framework/z3y_service_locator.h"
 #include "interfaces_core/i_config_service.h"
 #include "interfaces_core/i_log_service.h"
@@ -28,12 +42,72 @@
 
 using namespace z3y;
 
+/** @brief 事件总线钩子测试用的事件。 */
+struct ProfiledBusEvent : public z3y::Event {
+  Z3Y_DEFINE_EVENT(ProfiledBusEvent, "z3y-test-evt-profiled-bus-001");
+};
+
+/** @brief 事件总线钩子测试用的订阅者：每次回调耗时约 200 微秒。 */
+class ProfiledBusReceiver : public z3y::PluginImpl<ProfiledBusReceiver> {
+ public:
+  Z3Y_DEFINE_COMPONENT_ID("z3y-test-profiled-bus-receiver-UUID");
+  std::atomic<int> received{0};
+  void OnEvent(const ProfiledBusEvent&) {
+    std::this_thread::sleep_for(std::chrono::microseconds(200));
+    ++received;
+  }
+};
+
+/** @brief 接口代理测试用的接口：代理描述紧跟在接口定义之后。 */
+class IProxiedCalc : public virtual z3y::IComponent {
+ public:
+  Z3Y_DEFINE_INTERFACE(IProxiedCalc, "z3y-test-IProxiedCalc-IID-001", 1, 0)
+  virtual int Add(int a, int b) = 0;
+  virtual std::string Name() const = 0;
+};
+
+Z3Y_INTERFACE_PROXY_BEGIN(IProxiedCalc, z3y::interfaces::profiler::ProxyCallTimer)
+Z3Y_PROXY_METHOD(int, Add, (int a, int b), (a, b))
+Z3Y_PROXY_CONST_METHOD(std::string, Name, (), ())
+Z3Y_INTERFACE_PROXY_END()
+
+/** @brief 接口代理测试用的实现 (模拟无法插桩的第三方组件)。 */
+class ProxiedCalc : public z3y::PluginImpl<ProxiedCalc, IProxiedCalc> {
+ public:
+  Z3Y_DEFINE_COMPONENT_ID("z3y-test-proxied-calc-UUID");
+  int Add(int a, int b) override {
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+    return a + b;
+  }
+  std::string Name() const override { return "calc"; }
+};
+
+namespace {
+
+/** @brief 收集全部报告的汇出端 (回调在 Profiler 的报告线程上执行，读取前加锁或先 FlushReports)。 */
+struct CaptureSink : z3y::interfaces::profiler::IProfilerReportSink {
+  void OnReport(
+      const z3y::interfaces::profiler::ProfileReport& report) override {
+    std::lock_guard<std::mutex> lock(mutex);
+    reports.push_back(report);
+    thread = std::this_thread::get_id();
+  }
+  std::mutex mutex;
+  std::vector<z3y::interfaces::profiler::ProfileReport> reports;
+  std::thread::id thread;  //!< 最近一次回调所在的线程
+};
+
+}  // namespace
+
 /**
  * @brief 性能插件专用的测试固件，提供安全沙盒式的文件 IO 管理与上下文加载。
  */
 class ProfilerPluginTest : public PluginTestBase {
  protected:
   std::string current_log_file_;
+  //! SetUp 中取得的服务 (TearDown 在卸载插件前释放)
+  z3y::PluginPtr<z3y::interfaces::profiler::IProfilerService> profiler_;
+  z3y::PluginPtr<z3y::interfaces::core::IConfigService> config_;
 
   /**
    * @brief 在每个测试开启前建立独立的日志文件路径，清空历史遗留污染。
@@ -101,15 +175,16 @@ class ProfilerPluginTest : public PluginTestBase {
     auto [profiler_svc, profiler_err] =
         TryGetDefaultService<z3y::interfaces::profiler::IProfilerService>();
     ASSERT_EQ(profiler_err, z3y::InstanceError::kSuccess);
+    profiler_ = profiler_svc;
+    auto [cfg_svc, cfg_err] =
+        TryGetDefaultService<z3y::interfaces::core::IConfigService>();
+    ASSERT_EQ(cfg_err, z3y::InstanceError::kSuccess);
+    config_ = cfg_svc;
 
     // 强行将配置设置为 true，打破本地配置文件的“永久封印”
-    if (auto [cfg_svc, cfg_err] =
-            TryGetDefaultService<z3y::interfaces::core::IConfigService>();
-        cfg_err == z3y::InstanceError::kSuccess) {
-      cfg_svc->SetValue("System.Profiler.Enable", true);
-      // 让事件总线飞一会儿，确保 Profiler 同步开启
-      std::this_thread::sleep_for(std::chrono::milliseconds(10));
-    }
+    config_->SetValue("System.Profiler.Enable", true);
+    // 让事件总线飞一会儿，确保 Profiler 同步开启
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
   }
 
   void TearDown() override {
@@ -117,11 +192,10 @@ class ProfilerPluginTest : public PluginTestBase {
     // 【关键修复】：在底层框架强杀 DLL 之前，主动通知 Profiler
     // 断开与其他组件的连接。 防止因为 PluginManager 乱序卸载导致调用到已卸载
     // DLL 的虚函数。
-    if (auto [svc, err] =
-            TryGetDefaultService<z3y::interfaces::profiler::IProfilerService>();
-        err == z3y::InstanceError::kSuccess) {
-      svc->Shutdown();
-    }
+    if (profiler_) profiler_->Shutdown();
+    // 先放开对插件单例的引用，再由基类卸载插件
+    profiler_.reset();
+    config_.reset();
 
     PluginTestBase::TearDown();
     try {
@@ -134,6 +208,8 @@ class ProfilerPluginTest : public PluginTestBase {
    * @brief 测试完成后，用于验证断言读取日志结果。
    */
   std::string ReadAllLogs() {
+    // 报告由 Profiler 的后台线程输出，先等它把已提交的报告写完
+    profiler_->FlushReports();
     if (auto [log_svc, err] =
             TryGetDefaultService<z3y::interfaces::core::ILogManagerService>();
         err == z3y::InstanceError::kSuccess) {
@@ -283,26 +359,1095 @@ TEST_F(ProfilerPluginTest, Verify_Async_Pipeline) {
   EXPECT_TRUE(logs.find("Cross_Thread_Worker") != std::string::npos);
 }
 
+/**
+ * @brief 验证分片聚合：各 Worker 写入独占影子树，提交时合并且计数不丢失。
+ */
+TEST_F(ProfilerPluginTest, Verify_Sharded_Async_Aggregation) {
+  config_->SetValue("System.Profiler.ShardedAggregation", true);
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+  const uint64_t frame_id = 9527;
+  const int kWorkers = 4;
+  const int kIterations = 1000;
+  Z3Y_PROFILE_ASYNC_BEGIN("Sharded_Workflow", frame_id, 1, 0.0);
+
+  std::mutex commit_mutex;  // 串行提交，使每份报告恰好对应一个 Worker 的影子树
+  std::vector<std::thread> workers;
+  for (int t = 0; t < kWorkers; ++t) {
+    workers.emplace_back([&]() {
+      Z3Y_PROFILE_ASYNC_ATTACH(frame_id);
+      for (int i = 0; i < kIterations; ++i) {
+        Z3Y_PROFILE_NAMED("Shard_Worker");
+      }
+      std::lock_guard<std::mutex> lock(commit_mutex);
+      Z3Y_PROFILE_ASYNC_COMMIT(frame_id);
+    });
+  }
+  for (auto& w : workers) w.join();
+  Z3Y_PROFILE_ASYNC_COMMIT(frame_id);
+  config_->SetValue("System.Profiler.ShardedAggregation", false);
+
+  std::vector<std::string> counts;
+  for (int retry = 0; retry < 20 && counts.size() < kWorkers; ++retry) {
+    counts.clear();
+    std::istringstream lines(ReadAllLogs());
+    std::string line;
+    while (std::getline(lines, line)) {
+      if (line.find("Shard_Worker") == std::string::npos) continue;
+      std::istringstream tokens(line);
+      std::string bar, name, count;
+      tokens >> bar >> name >> count;
+      counts.push_back(count);
+    }
+  }
+  ASSERT_EQ(counts.size(), static_cast<size_t>(kWorkers));
+  for (const auto& count : counts) {
+    EXPECT_EQ(count, std::to_string(kIterations));
+  }
+}
+
+/**
+ * @brief 验证追踪模式：各阶段按线程记录起止时间，并能导出带 flow 箭头的 Chrome Trace。
+ */
+TEST_F(ProfilerPluginTest, Verify_Async_Trace_Flow_Events) {
+  config_->SetValue("System.Profiler.TraceRingSize", 256);
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+  using z3y::interfaces::profiler::TracePhase;
+  const uint64_t frame_id = 4242;
+  Z3Y_PROFILE_ASYNC_BEGIN("Traced_Frame", frame_id, 1000000, 0.0);
+  auto stage = [frame_id]() {
+    Z3Y_PROFILE_ASYNC_ATTACH(frame_id);
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    Z3Y_PROFILE_ASYNC_COMMIT(frame_id);
+  };
+  std::thread(stage).join();
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));  // 阶段之间排队
+  std::thread(stage).join();
+  Z3Y_PROFILE_ASYNC_COMMIT(frame_id);
+
+  const auto trace = profiler_->CollectTrace(true);
+  config_->SetValue("System.Profiler.TraceRingSize", 0);
+
+  std::vector<z3y::interfaces::profiler::TraceEvent> events;
+  for (const auto& e : trace.events) {
+    if (e.frame_id == frame_id) events.push_back(e);
+  }
+  ASSERT_EQ(events.size(), 6u);
+  const TracePhase expected[] = {TracePhase::FrameBegin, TracePhase::StageBegin,
+                                 TracePhase::StageEnd,   TracePhase::StageBegin,
+                                 TracePhase::StageEnd,   TracePhase::FrameEnd};
+  for (size_t i = 0; i < events.size(); ++i) {
+    EXPECT_EQ(events[i].phase, expected[i]) << "event " << i;
+    EXPECT_EQ(events[i].name, "Traced_Frame");
+  }
+  EXPECT_EQ(events[1].thread_id, events[2].thread_id);
+  EXPECT_NE(events[1].thread_id, events[3].thread_id);
+  EXPECT_EQ(events[0].thread_id, events[5].thread_id);
+  EXPECT_GE(events[2].timestamp_us - events[1].timestamp_us, 1500.0);
+  EXPECT_GE(events[3].timestamp_us - events[2].timestamp_us, 8000.0);
+  EXPECT_EQ(trace.overwritten, 0u);
+
+  std::ostringstream json;
+  z3y::interfaces::profiler::WriteChromeTrace(json, trace);
+  const std::string text = json.str();
+  EXPECT_EQ(text.rfind("{\"displayTimeUnit\"", 0), 0u);
+  for (const char* ph : {"s", "t", "f", "B", "E", "b", "e"}) {
+    EXPECT_NE(text.find(std::string("{\"ph\":\"") + ph + "\""),
+              std::string::npos)
+        << "missing phase " << ph << " in " << text;
+  }
+  EXPECT_NE(text.find("\"id\":4242"), std::string::npos);
+  EXPECT_TRUE(profiler_->CollectTrace(false).events.empty());
+}
+
+/**
+ * @brief 验证飞行记录器：SLA 超时自动冻结最近窗口内的作用域进出记录，手动冻结与关闭后拒绝冻结。
+ */
+TEST_F(ProfilerPluginTest, Verify_Flight_Recorder_Freezes_On_Sla) {
+  EXPECT_FALSE(profiler_->FreezeFlightRecorder("disabled"));
+  config_->SetValue("System.Profiler.FlightRecorderRingSize", 1024);
+  config_->SetValue("System.Profiler.FlightRecorderWindowMs", 5000);
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+  {
+    Z3Y_PROFILE_ROOT("Flight_Root", 1000000, 0.001);
+    {
+      Z3Y_PROFILE_NAMED("Flight_Inner");
+      std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+  }
+  profiler_->FlushReports();
+
+  using z3y::interfaces::profiler::TracePhase;
+  auto recordings = profiler_->TakeFlightRecordings();
+  ASSERT_EQ(recordings.size(), 1u);
+  EXPECT_NE(recordings[0].reason.find("SLA"), std::string::npos);
+  EXPECT_EQ(recordings[0].window_ms, 5000.0);
+  std::vector<std::pair<TracePhase, std::string>> seen;
+  for (const auto& e : recordings[0].trace.events) {
+    if (e.name == "Flight_Root" || e.name == "Flight_Inner") {
+      seen.emplace_back(e.phase, e.name);
+    }
+  }
+  const std::vector<std::pair<TracePhase, std::string>> expected = {
+      {TracePhase::ScopeBegin, "Flight_Root"},
+      {TracePhase::ScopeBegin, "Flight_Inner"},
+      {TracePhase::ScopeEnd, "Flight_Inner"},
+      {TracePhase::ScopeEnd, "Flight_Root"}};
+  EXPECT_EQ(seen, expected);
+
+  // 同一窗口内再次超时不会重复冻结，手动冻结不受限制
+  {
+    Z3Y_PROFILE_ROOT("Flight_Root", 1000000, 0.001);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_TRUE(profiler_->TakeFlightRecordings().empty());
+  EXPECT_TRUE(profiler_->FreezeFlightRecorder("manual"));
+  recordings = profiler_->TakeFlightRecordings();
+  ASSERT_EQ(recordings.size(), 1u);
+  EXPECT_EQ(recordings[0].reason, "manual");
+  EXPECT_EQ(recordings[0].sequence, 2u);
+
+  std::ostringstream json;
+  z3y::interfaces::profiler::WriteChromeTrace(json, recordings[0].trace);
+  EXPECT_NE(json.str().find("{\"ph\":\"B\""), std::string::npos);
+  EXPECT_NE(json.str().find("Flight_Inner"), std::string::npos);
+
+  config_->SetValue("System.Profiler.FlightRecorderRingSize", 0);
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_FALSE(profiler_->FreezeFlightRecorder("disabled"));
+}
+
+namespace {
+
+/**
+ * @brief 模拟一条设备队列：设备时钟比主机快 kOffsetNs，Launch 排入的工作在下一个标记前执行完；
+ * ready 置位之前所有标记都查询不到（设备尚未执行）。
+ */
+class FakeDeviceQueue : public z3y::interfaces::profiler::IDeviceTimestampSource {
+ public:
+  static constexpr uint64_t kOffsetNs = 5000000000ull;
+
+  const char* DeviceName() const override { return "fake:0"; }
+  uint64_t Mark() override {
+    std::lock_guard<std::mutex> lock(mutex);
+    const auto now = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch())
+            .count());
+    device_ns = std::max(device_ns + work_ns, now + kOffsetNs);
+    work_ns = 0;
+    marks[++last_marker] = device_ns;
+    return last_marker;
+  }
+  bool Query(uint64_t marker, uint64_t* out) override {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!ready) return false;
+    *out = marks.at(marker);
+    return true;
+  }
+  void Release(uint64_t marker) override {
+    std::lock_guard<std::mutex> lock(mutex);
+    marks.erase(marker);
+  }
+  void Launch(uint64_t ns) {
+    std::lock_guard<std::mutex> lock(mutex);
+    work_ns += ns;
+  }
+
+  std::mutex mutex;
+  std::map<uint64_t, uint64_t> marks;  ///< 未释放的标记 -> 设备时刻
+  uint64_t last_marker = 0;
+  uint64_t device_ns = 0;
+  uint64_t work_ns = 0;
+  bool ready = false;
+};
+
+}  // namespace
+
+/**
+ * @brief 验证设备区间：设备完成之前不阻塞、不记录；完成后由轮询线程记入 Devices 根，
+ * 耗时取设备时间而不是主机时间，追踪中出现以设备名命名的轨道，标记全部释放。
+ */
+TEST_F(ProfilerPluginTest, Verify_Device_Spans_Resolve_Asynchronously) {
+  config_->SetValue("System.Profiler.TraceRingSize", 256);
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+  using z3y::interfaces::profiler::ReportNode;
+  using z3y::interfaces::profiler::TracePhase;
+  auto queue = std::make_shared<FakeDeviceQueue>();
+  for (int i = 0; i < 3; ++i) {
+    Z3Y_PROFILE_DEVICE("Device_Kernel", queue);
+    queue->Launch(4000000);  // 设备上执行 4ms，主机侧立即返回
+  }
+  EXPECT_EQ(profiler_->FlushDeviceSpans(20), 3u);  // 设备尚未执行：仍在等待
+  {
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    queue->ready = true;
+  }
+  ASSERT_EQ(profiler_->FlushDeviceSpans(5000), 0u);
+
+  const ReportNode* kernel = nullptr;
+  const ReportNode* device = nullptr;
+  const auto reports = profiler_->SnapshotLiveRoots();
+  for (const auto& report : reports) {
+    if (report.nodes.empty() || report.nodes[0].name != "Devices") continue;
+    for (const auto& node : report.nodes) {
+      if (node.name == "[Device] fake:0") device = &node;
+      if (node.name == "Device_Kernel") kernel = &node;
+    }
+  }
+  ASSERT_NE(device, nullptr);
+  ASSERT_NE(kernel, nullptr);
+  EXPECT_EQ(kernel->depth, 2u);
+  EXPECT_EQ(kernel->count, 3u);
+  EXPECT_NEAR(kernel->max_ms, 4.0, 0.5);
+  EXPECT_TRUE(queue->marks.empty());
+
+  const auto trace = profiler_->CollectTrace(true);
+  config_->SetValue("System.Profiler.TraceRingSize", 0);
+  size_t begins = 0;
+  bool named = false;
+  for (const auto& e : trace.events) {
+    if (e.phase == TracePhase::TrackName && e.name == "[Device] fake:0") named = true;
+    if (e.phase == TracePhase::ScopeBegin && e.name == "Device_Kernel") ++begins;
+  }
+  EXPECT_TRUE(named);
+  EXPECT_EQ(begins, 3u);
+  std::ostringstream json;
+  z3y::interfaces::profiler::WriteChromeTrace(json, trace);
+  EXPECT_NE(json.str().find("\"thread_name\""), std::string::npos);
+}
+
+/**
+ * @brief 验证事件总线钩子：按 EventId / 订阅者聚合同步回调、异步执行与排队等待的耗时。
+ */
+TEST_F(ProfilerPluginTest, Verify_Event_Bus_Hook_Times_Handlers) {
+  config_->SetValue("System.Profiler.EventBusHook", true);
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+  auto bus = z3y::GetDefaultService<IEventBus>();
+  auto direct = std::make_shared<ProfiledBusReceiver>();
+  auto queued = std::make_shared<ProfiledBusReceiver>();
+  z3y::ScopedConnection c1 = bus->SubscribeGlobal<ProfiledBusEvent>(
+      direct, &ProfiledBusReceiver::OnEvent);
+  z3y::ScopedConnection c2 = bus->SubscribeGlobal<ProfiledBusEvent>(
+      queued, &ProfiledBusReceiver::OnEvent, z3y::ConnectionType::kQueued);
+  const int kFires = 10;
+  for (int i = 0; i < kFires; ++i) bus->FireGlobal<ProfiledBusEvent>();
+
+  char event_name[64];
+  std::snprintf(event_name, sizeof(event_name), "Event 0x%016llx",
+                static_cast<unsigned long long>(ProfiledBusEvent::kEventId));
+  char direct_name[64];
+  std::snprintf(direct_name, sizeof(direct_name), "[Direct] 0x%llx",
+                static_cast<unsigned long long>(
+                    reinterpret_cast<uintptr_t>(direct.get())));
+  // 找到 EventBus 根下本事件的各个叶子（kQueuedExecuteEnd 在回调返回之后才记录，需要重试）
+  std::vector<z3y::interfaces::profiler::ReportNode> leaves;
+  for (int retry = 0; retry < 200; ++retry) {
+    leaves.clear();
+    for (const auto& report : profiler_->SnapshotLiveRoots()) {
+      if (report.nodes.empty() || report.nodes[0].name != "EventBus") continue;
+      for (size_t i = 0; i < report.nodes.size(); ++i) {
+        if (report.nodes[i].name != event_name) continue;
+        for (const auto& node : report.nodes) {
+          if (node.parent == static_cast<int32_t>(i)) leaves.push_back(node);
+        }
+      }
+    }
+    bool complete = leaves.size() == 3;
+    for (const auto& leaf : leaves) complete = complete && leaf.count == kFires;
+    if (complete) break;
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  config_->SetValue("System.Profiler.EventBusHook", false);
+
+  ASSERT_EQ(leaves.size(), 3u);
+  std::vector<std::string> names;
+  for (const auto& leaf : leaves) {
+    names.push_back(leaf.name);
+    EXPECT_EQ(leaf.count, static_cast<uint64_t>(kFires)) << leaf.name;
+    if (leaf.name != "[QueueWait]") {
+      EXPECT_GE(leaf.total_ms, kFires * 0.2 * 0.9) << leaf.name;
+    }
+  }
+  std::sort(names.begin(), names.end());
+  EXPECT_EQ(names, (std::vector<std::string>{direct_name, "[QueueWait]",
+                                             "[Queued]"}));
+  EXPECT_EQ(queued->received.load(), kFires);
+}
+
+namespace {
+/** @brief 把整数翻倍的管线阶段。 */
+class ProfiledDoubleStage
+    : public z3y::PluginImpl<ProfiledDoubleStage, z3y::IPipelineStage> {
+ public:
+  Z3Y_DEFINE_COMPONENT_ID("z3y-test-profiled-double-stage-IMPL");
+  void Process(z3y::PipelineItem& item, z3y::PipelineEmitter& out) override {
+    std::this_thread::sleep_for(std::chrono::microseconds(200));
+    *item.As<int>() *= 2;
+    out.Emit(std::move(item));
+  }
+};
+}  // namespace
+
+/**
+ * @brief 验证管线钩子：阶段耗时与通道等待计入 Pipelines 根，采样到的条目映射为以管线名命名的异步帧。
+ */
+TEST_F(ProfilerPluginTest, Verify_Pipeline_Hook_Maps_Frames) {
+  auto registry = dynamic_cast<z3y::IPluginRegistry*>(manager_.get());
+  ASSERT_NE(registry, nullptr);
+  z3y::RegisterComponent<ProfiledDoubleStage>(registry, "Test.ProfiledDouble");
+  config_->SetValue("System.Profiler.PipelinePeriod", 1);
+  config_->SetValue("System.Profiler.PipelineHook", true);
+  ASSERT_TRUE(z3y::IsPipelineTraceHookInstalled());
+  auto sink = std::make_shared<CaptureSink>();
+  profiler_->AddReportSink(sink);
+
+  z3y::PipelineOptions options;
+  options.name = "ProfiledPipeline";
+  options.stages = {{"Double", ProfiledDoubleStage::kClsid, 2, 4}};
+  std::string error;
+  auto pipeline = z3y::Pipeline::Create(
+      std::move(options), manager_->GetService<z3y::IExecutorService>(z3y::clsid::kExecutor),
+      error);
+  ASSERT_TRUE(pipeline) << error;
+  const int kItems = 5;
+  for (int i = 0; i < kItems; ++i) {
+    ASSERT_TRUE(pipeline->Push(z3y::PipelineItem::Make<int>(i)));
+  }
+  ASSERT_TRUE(pipeline->WaitFor(std::chrono::seconds(10)));
+  pipeline.reset();
+  profiler_->FlushReports();
+  profiler_->RemoveReportSink(sink);
+  config_->SetValue("System.Profiler.PipelineHook", false);
+  config_->SetValue("System.Profiler.PipelinePeriod", 1000);
+  EXPECT_FALSE(z3y::IsPipelineTraceHookInstalled());
+
+  // 周期为 1：每次阶段结束一份 Pipelines 报告，每帧的阶段节点出现在以管线名命名的帧报告中
+  std::lock_guard<std::mutex> lock(sink->mutex);
+  int shared_reports = 0;
+  int frame_stage_nodes = 0;
+  for (const auto& report : sink->reports) {
+    if (report.nodes.empty()) continue;
+    if (report.nodes[0].name == "Pipelines") {
+      ++shared_reports;
+      std::vector<std::string> names;
+      for (const auto& node : report.nodes) names.push_back(node.name);
+      EXPECT_EQ(names, (std::vector<std::string>{"Pipelines", "ProfiledPipeline",
+                                                 "Double", "[QueueWait]"}));
+    } else if (report.nodes[0].name == "ProfiledPipeline") {
+      for (const auto& node : report.nodes) {
+        if (node.name == "Double") {
+          ++frame_stage_nodes;
+          EXPECT_GE(node.total_ms, 0.2 * 0.9);
+        }
+      }
+    }
+  }
+  EXPECT_EQ(shared_reports, kItems);
+  EXPECT_EQ(frame_stage_nodes, kItems);
+}
+
+/**
+ * @brief 验证接口调用拦截：按接口名或组件别名开启后 CreateInstance 返回代理，
+ * 每个方法计入 "接口::方法" 节点；关闭后重新返回真实对象。
+ */
+TEST_F(ProfilerPluginTest, Verify_Interface_Proxy_Times_Calls) {
+  auto registry = dynamic_cast<z3y::IPluginRegistry*>(manager_.get());
+  ASSERT_NE(registry, nullptr);
+  z3y::RegisterComponent<ProxiedCalc>(registry, "Test.ProxiedCalc");
+
+  auto plain = z3y::CreateInstance<IProxiedCalc>("Test.ProxiedCalc");
+  EXPECT_NE(dynamic_cast<ProxiedCalc*>(plain.get()), nullptr);
+  EXPECT_FALSE(z3y::PluginManager::IsCallInterceptionActive().load());
+
+  config_->SetValue("System.Profiler.InterceptedCalls", std::string("IProxiedCalc"));
+  auto proxied = z3y::CreateInstance<IProxiedCalc>("Test.ProxiedCalc");
+  ASSERT_NE(proxied, nullptr);
+  EXPECT_EQ(dynamic_cast<ProxiedCalc*>(proxied.get()), nullptr);
+  z3y::InstanceError cast_err = z3y::InstanceError::kSuccess;
+  EXPECT_EQ(z3y::PluginCast<IProxiedCalc>(proxied, cast_err).get(), proxied.get());
+  {
+    Z3Y_PROFILE_ROOT("Proxy_Root", 1, 0.0);
+    for (int i = 0; i < 3; ++i) EXPECT_EQ(proxied->Add(i, 2), i + 2);
+    EXPECT_EQ(proxied->Name(), "calc");
+  }
+  std::string logs = ReadAllLogs();
+  EXPECT_NE(logs.find("IProxiedCalc::Add"), std::string::npos);
+  EXPECT_NE(logs.find("IProxiedCalc::Name"), std::string::npos);
+
+  // 按组件别名开启同样命中；清空后恢复为真实对象
+  config_->SetValue("System.Profiler.InterceptedCalls", std::string(" Test.ProxiedCalc "));
+  EXPECT_EQ(dynamic_cast<ProxiedCalc*>(
+                z3y::CreateInstance<IProxiedCalc>("Test.ProxiedCalc").get()),
+            nullptr);
+  config_->SetValue("System.Profiler.InterceptedCalls", std::string());
+  EXPECT_FALSE(z3y::PluginManager::IsCallInterceptionActive().load());
+  EXPECT_NE(dynamic_cast<ProxiedCalc*>(
+                z3y::CreateInstance<IProxiedCalc>("Test.ProxiedCalc").get()),
+            nullptr);
+}
+
+/**
+ * @brief 验证锁竞争钩子：采样按 (锁, 调用点) 排名并计入 Locks 根；以 Z3Y_LOCK_PROFILING
+ * 构建时，框架的 ProfiledMutex 在真实竞争下上报等待与持有时间。
+ */
+TEST_F(ProfilerPluginTest, Verify_Lock_Contention_Ranks_Call_Sites) {
+  config_->SetValue("System.Profiler.LockContention", true);
+  ASSERT_TRUE(z3y::IsLockProfileHookInstalled());
+
+  // 1. 两个调用点：等待更久的排在前面，持有时间与竞争次数分别累计
+  static const char kLockName[] = "Test.lock_contention";
+  static int site_a = 0;
+  static int site_b = 0;
+  z3y::LockContentionSample sample;
+  sample.lock_name = kLockName;
+  for (int i = 0; i < 4; ++i) {
+    sample.call_site = &site_a;
+    sample.wait_ns = 1000000;  // 1ms
+    sample.hold_ns = 2000000;
+    sample.contended = true;
+    z3y::ReportLockSample(sample);
+    sample.call_site = &site_b;
+    sample.wait_ns = 0;
+    sample.hold_ns = 5000000;
+    sample.contended = false;
+    z3y::ReportLockSample(sample);
+  }
+  std::vector<z3y::interfaces::profiler::LockContentionEntry> ranked;
+  for (const auto& entry : profiler_->GetLockContention(0)) {
+    if (entry.lock_name == kLockName) ranked.push_back(entry);
+  }
+  ASSERT_EQ(ranked.size(), 2u);
+  EXPECT_EQ(ranked[0].acquisitions, 4u);
+  EXPECT_EQ(ranked[0].contended, 4u);
+  EXPECT_NEAR(ranked[0].total_wait_ms, 4.0, 1e-9);
+  EXPECT_NEAR(ranked[0].max_hold_ms, 2.0, 1e-9);
+  EXPECT_EQ(ranked[1].contended, 0u);
+  EXPECT_NEAR(ranked[1].total_hold_ms, 20.0, 1e-9);
+  EXPECT_FALSE(ranked[0].module.empty());  // 调用点落在测试程序里
+  EXPECT_LE(profiler_->GetLockContention(1).size(), 1u);
+
+  // 2. 同样的数据出现在 Locks 根下：锁名节点，其下各调用点的 [Wait] / [Hold]
+  size_t site_leaves = 0;
+  for (const auto& report : profiler_->SnapshotLiveRoots()) {
+    if (report.nodes.empty() || report.nodes[0].name != "Locks") continue;
+    for (size_t i = 0; i < report.nodes.size(); ++i) {
+      if (report.nodes[i].name != kLockName) continue;
+      EXPECT_EQ(report.nodes[i].count, 8u);
+      for (const auto& node : report.nodes) {
+        if (node.parent == static_cast<int32_t>(i)) ++site_leaves;
+      }
+    }
+  }
+  EXPECT_EQ(site_leaves, 4u);
+
+  // 3. 插桩构建：真实的 ProfiledMutex 在两个线程争抢时记录到竞争
+  if (z3y::kLockProfilingCompiled) {
+    static const char kRealLock[] = "Test.profiled_mutex";
+    z3y::ProfiledMutex<std::mutex> mutex{kRealLock};
+    std::atomic<bool> held{false};
+    std::thread holder([&] {
+      std::lock_guard lock(mutex);
+      held = true;
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    });
+    while (!held.load()) std::this_thread::yield();
+    { std::lock_guard lock(mutex); }
+    holder.join();
+
+    uint64_t contended = 0;
+    double max_wait_ms = 0.0;
+    double max_hold_ms = 0.0;
+    for (const auto& entry : profiler_->GetLockContention(0)) {
+      if (entry.lock_name != kRealLock) continue;
+      contended += entry.contended;
+      max_wait_ms = std::max(max_wait_ms, entry.max_wait_ms);
+      max_hold_ms = std::max(max_hold_ms, entry.max_hold_ms);
+    }
+    EXPECT_EQ(contended, 1u);
+    EXPECT_GT(max_wait_ms, 5.0);
+    EXPECT_GT(max_hold_ms, 15.0);
+  }
+
+  // 4. 关闭后不再计入
+  config_->SetValue("System.Profiler.LockContention", false);
+  EXPECT_FALSE(z3y::IsLockProfileHookInstalled());
+  sample.call_site = &site_a;
+  z3y::ReportLockSample(sample);
+  for (const auto& entry : profiler_->GetLockContention(0)) {
+    if (entry.lock_name == kLockName && entry.contended > 0) {
+      EXPECT_EQ(entry.acquisitions, 4u);
+    }
+  }
+}
+
+/**
+ * @brief 验证子节点查找缓存：报告回收子树后，缓存失效且数据写入新节点而非已回收节点。
+ */
+TEST_F(ProfilerPluginTest, Verify_Child_Cache_Invalidated_After_Report) {
+  for (int pass = 0; pass < 2; ++pass) {
+    Z3Y_PROFILE_ROOT("Child_Cache_Root", 1, 0.0);  // 每个周期都出报告并回收子树
+    for (int i = 0; i < 100; ++i) {
+      { Z3Y_PROFILE_NAMED("Cache_Child_A"); }
+      { Z3Y_PROFILE_NAMED("Cache_Child_B"); }
+    }
+  }
+
+  std::vector<std::string> counts;
+  for (int retry = 0; retry < 20 && counts.size() < 2; ++retry) {
+    counts.clear();
+    std::istringstream lines(ReadAllLogs());
+    std::string line;
+    while (std::getline(lines, line)) {
+      if (line.find("Cache_Child_A") == std::string::npos) continue;
+      std::istringstream tokens(line);
+      std::string bar, name, count;
+      tokens >> bar >> name >> count;
+      counts.push_back(count);
+    }
+  }
+  ASSERT_EQ(counts.size(), 2u);
+  EXPECT_EQ(counts[0], "100");
+  EXPECT_EQ(counts[1], "100");
+}
+
+/**
+ * @brief 验证开启直方图后，报告中输出耗时与数值的分位数。
+ */
+TEST_F(ProfilerPluginTest, Verify_Percentiles_In_Report) {
+  config_->SetValue("System.Profiler.HistogramPrecision", 2);
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+  {
+    Z3Y_PROFILE_ROOT("Percentile_Root", 1, 0.0);
+    for (int i = 0; i < 50; ++i) {
+      Z3Y_PROFILE_NAMED("Percentile_Step");
+      Z3Y_PROFILE_VALUE("Percentile_Value", i);
+    }
+  }
+  config_->SetValue("System.Profiler.HistogramPrecision", 0);
+
+  std::string logs = ReadAllLogs();
+  EXPECT_TRUE(logs.find("Percentile_Step") != std::string::npos) << logs;
+  EXPECT_TRUE(logs.find("[Pct] p50:") != std::string::npos) << logs;
+  EXPECT_TRUE(logs.find("p999:") != std::string::npos);
+  EXPECT_TRUE(logs.find("p95:") != std::string::npos);
+}
+
+/**
+ * @brief 验证结构化报告接收器：在后台线程收到快照，并可导出 JSON 与折叠栈。
+ */
+TEST_F(ProfilerPluginTest, Verify_Report_Sink_Structured_Export) {
+  auto sink = std::make_shared<CaptureSink>();
+  profiler_->AddReportSink(sink);
+  {
+    Z3Y_PROFILE_ROOT("Sink_Root", 1, 0.0);
+    Z3Y_PROFILE_TAG("Lot", "A\"1");
+    for (int i = 0; i < 3; ++i) {
+      Z3Y_PROFILE_NAMED("Sink_Child");
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      Z3Y_PROFILE_EVENT("Sink_Event");
+    }
+  }
+  profiler_->FlushReports();
+  profiler_->RemoveReportSink(sink);
+
+  std::lock_guard<std::mutex> lock(sink->mutex);
+  ASSERT_EQ(sink->reports.size(), 1u);
+  EXPECT_NE(sink->thread, std::this_thread::get_id());  // 输出发生在后台线程
+  const auto& report = sink->reports.front();
+  ASSERT_EQ(report.nodes.size(), 3u);
+  EXPECT_EQ(report.nodes[0].name, "Sink_Root");
+  EXPECT_EQ(report.nodes[1].name, "Sink_Child");
+  EXPECT_EQ(report.nodes[1].parent, 0);
+  EXPECT_EQ(report.nodes[1].count, 3u);
+  EXPECT_EQ(report.nodes[2].name, "Sink_Event");
+  EXPECT_EQ(report.nodes[2].depth, 2u);
+
+  std::ostringstream json;
+  z3y::interfaces::profiler::WriteJson(json, report);
+  EXPECT_NE(json.str().find("\"name\":\"Sink_Child\",\"type\":\"timer\","
+                            "\"count\":3"),
+            std::string::npos)
+      << json.str();
+  EXPECT_NE(json.str().find("\"children\":[{\"name\":\"Sink_Event\""),
+            std::string::npos);
+  EXPECT_NE(json.str().find("\"Lot\":\"A\\\"1\""), std::string::npos);
+  // 探针位置随导出，供 tool_profile_diff 对齐节点
+  EXPECT_NE(report.nodes[1].file.find("test_profiler_plugin.cpp"),
+            std::string::npos);
+  EXPECT_GT(report.nodes[1].line, 0u);
+  EXPECT_NE(json.str().find("\"line\":" + std::to_string(report.nodes[1].line)),
+            std::string::npos);
+  EXPECT_EQ(json.str().back(), '}');
+
+  std::ostringstream folded;
+  z3y::interfaces::profiler::WriteCollapsedStacks(folded, report);
+  EXPECT_NE(folded.str().find("Sink_Root;Sink_Child "), std::string::npos)
+      << folded.str();
+}
+
+/**
+ * @brief 验证开销补偿：报告中的累计耗时扣除了标定出的探针开销，且不会过度扣除。
+ */
+TEST_F(ProfilerPluginTest, Verify_Overhead_Compensation) {
+  auto sink = std::make_shared<CaptureSink>();
+  profiler_->AddReportSink(sink);
+
+  const int kEmptyScopes = 20000;
+  for (bool compensate : {false, true}) {
+    config_->SetValue("System.Profiler.OverheadCompensation", compensate);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    {
+      Z3Y_PROFILE_ROOT("Compensation_Root", 1, 0.0);
+      Z3Y_PROFILE_NAMED("Compensation_Parent");
+      std::this_thread::sleep_for(std::chrono::milliseconds(2));
+      for (int i = 0; i < kEmptyScopes; ++i) {
+        Z3Y_PROFILE_NAMED("Compensation_Empty");
+      }
+    }
+    profiler_->FlushReports();
+  }
+  profiler_->RemoveReportSink(sink);
+
+  std::lock_guard<std::mutex> lock(sink->mutex);
+  ASSERT_EQ(sink->reports.size(), 2u);
+  EXPECT_EQ(sink->reports[0].probe_overhead_ns, 0.0);
+
+  const auto& report = sink->reports[1];
+  ASSERT_EQ(report.nodes.size(), 3u);
+  EXPECT_GT(report.probe_overhead_ns, 0.0);
+  EXPECT_LE(report.probe_self_ns, report.probe_overhead_ns);
+
+  // 父节点只调用一次，原始累计耗时等于 max_ms
+  const auto& parent = report.nodes[1];
+  ASSERT_EQ(parent.name, "Compensation_Parent");
+  const double removed_ms =
+      (report.probe_self_ns + kEmptyScopes * report.probe_overhead_ns) / 1e6;
+  EXPECT_NEAR(parent.total_ms, std::max(0.0, parent.max_ms - removed_ms), 1e-6);
+  // 真实的业务耗时不能被扣掉；开销是标定出的估计值，每个空探针 ns 级的误差
+  // 乘以 kEmptyScopes 可能多扣几十微秒，这里留 0.5ms 余量
+  EXPECT_GE(parent.total_ms, 1.5);
+  EXPECT_GE(report.nodes[2].total_ms, 0.0);
+}
+
+/**
+ * @brief 验证探针注册表：按名字 / 模块启停探针，规则对之后才登记的探针同样生效。
+ */
+TEST_F(ProfilerPluginTest, Verify_Probe_Registry_Toggle) {
+  using z3y::interfaces::profiler::ProbeMatch;
+
+  auto run_frame = []() {
+    Z3Y_PROFILE_ROOT("Registry_Root", 1, 0.0);
+    { Z3Y_PROFILE_NAMED("Registry_Kept"); }
+    { Z3Y_PROFILE_NAMED("Registry_Disabled"); }
+  };
+  auto count_of = [](const std::string& text, const std::string& word) {
+    size_t n = 0;
+    for (size_t pos = text.find(word); pos != std::string::npos;
+         pos = text.find(word, pos + word.size())) {
+      ++n;
+    }
+    return n;
+  };
+
+  // 规则先于探针登记设置：尚无命中，但之后登记的探针按规则禁用
+  EXPECT_EQ(profiler_->SetProbesEnabled(ProbeMatch::Name, "Registry_Disabled", false),
+            0u);
+  run_frame();
+  std::string logs = ReadAllLogs();
+  EXPECT_EQ(count_of(logs, "Registry_Kept"), 1u) << logs;
+  EXPECT_EQ(count_of(logs, "Registry_Disabled"), 0u);
+
+  bool found = false;
+  for (const auto& probe : profiler_->GetProbes()) {
+    if (probe.name != "Registry_Disabled") continue;
+    found = true;
+    EXPECT_FALSE(probe.enabled);
+    EXPECT_NE(probe.file.find("test_profiler_plugin.cpp"), std::string::npos);
+    EXPECT_NE(probe.module.find("z3y_integration_tests"), std::string::npos)
+        << probe.module;
+  }
+  EXPECT_TRUE(found);
+
+  EXPECT_EQ(profiler_->SetProbesEnabled(ProbeMatch::Name, "Registry_Disabled", true),
+            1u);
+  run_frame();
+  logs = ReadAllLogs();
+  EXPECT_EQ(count_of(logs, "Registry_Kept"), 2u);
+  EXPECT_EQ(count_of(logs, "Registry_Disabled"), 1u);
+
+  // 整个模块禁用：连 ROOT 也不再生效，不会产生新报告
+  EXPECT_GE(profiler_->SetProbesEnabled(ProbeMatch::Module, "z3y_integration_tests",
+                                  false),
+            3u);
+  run_frame();
+  logs = ReadAllLogs();
+  EXPECT_EQ(count_of(logs, "Registry_Kept"), 2u);
+  profiler_->SetProbesEnabled(ProbeMatch::Module, "z3y_integration_tests", true);
+}
+
+/** @brief 每层递归一个计时探针，用于撑深影子栈。 */
+static void ProfiledRecursion(size_t depth) {
+  Z3Y_PROFILE_NAMED("Recursion_Level");
+  if (depth > 1) ProfiledRecursion(depth - 1);
+}
+
+/**
+ * @brief 验证线程状态按需扩容：深递归超过内联影子栈仍被完整记录，
+ * 超过深度上限的层级计入 depth_overflows；独立根节点数也不再受固定数组限制。
+ */
+TEST_F(ProfilerPluginTest, Verify_Deep_Recursion_And_Many_Roots) {
+  using z3y::interfaces::profiler::ProfileReport;
+  using z3y::interfaces::profiler::ProfilerThreadState;
+  auto max_depth = [](const ProfileReport& report) {
+    uint32_t depth = 0;
+    for (const auto& node : report.nodes) depth = std::max(depth, node.depth);
+    return depth;
+  };
+
+  auto sink = std::make_shared<CaptureSink>();
+  profiler_->AddReportSink(sink);
+
+  const size_t kMax = ProfilerThreadState::kMaxStackDepth;
+  std::thread worker([] {
+    {
+      Z3Y_PROFILE_ROOT("Deep_Root", 1, 0.0);
+      ProfiledRecursion(300);
+    }
+    {
+      Z3Y_PROFILE_ROOT("Deep_Root", 1, 0.0);
+      ProfiledRecursion(kMax + 50);
+    }
+    { Z3Y_PROFILE_ROOT("Many_Root_1", 1, 0.0); }
+    { Z3Y_PROFILE_ROOT("Many_Root_2", 1, 0.0); }
+    { Z3Y_PROFILE_ROOT("Many_Root_3", 1, 0.0); }
+    { Z3Y_PROFILE_ROOT("Many_Root_4", 1, 0.0); }
+    { Z3Y_PROFILE_ROOT("Many_Root_5", 1, 0.0); }
+    { Z3Y_PROFILE_ROOT("Many_Root_6", 1, 0.0); }
+  });
+  worker.join();
+  profiler_->FlushReports();
+  profiler_->RemoveReportSink(sink);
+
+  std::lock_guard<std::mutex> lock(sink->mutex);
+  ASSERT_EQ(sink->reports.size(), 8u);
+  EXPECT_EQ(max_depth(sink->reports[0]), 300u);
+  EXPECT_EQ(sink->reports[0].depth_overflows, 0u);
+  // 根节点占用栈底一层，其余层级用满上限
+  EXPECT_EQ(max_depth(sink->reports[1]), kMax - 1);
+  EXPECT_EQ(sink->reports[1].depth_overflows, 50u + 1u);
+  for (size_t i = 2; i < 8; ++i) {
+    ASSERT_FALSE(sink->reports[i].nodes.empty());
+    EXPECT_EQ(sink->reports[i].nodes[0].name,
+              "Many_Root_" + std::to_string(i - 1));
+    EXPECT_EQ(sink->reports[i].depth_overflows, 0u);
+  }
+}
+
+/**
+ * @brief 验证分块节点池：多线程同时创建大量新路径，节点在线程退出后回到全局池被复用，
+ * 内存占用可以通过 GetMemoryStats 查询。
+ */
+TEST_F(ProfilerPluginTest, Verify_Node_Pool_Reuse_And_Stats) {
+  const int kThreads = 8;
+  const size_t kDepth = 500;  // 每层递归都是一个新节点
+  auto run_round = [&]() {
+    std::atomic<int> built{0};
+    std::vector<std::thread> workers;
+    for (int t = 0; t < kThreads; ++t) {
+      workers.emplace_back([&] {
+        Z3Y_PROFILE_ROOT("Pool_Root", 1000000, 0.0);
+        ProfiledRecursion(kDepth);
+        // 等所有线程都建好各自的树再退出，保证各线程的节点同时在用
+        built.fetch_add(1);
+        while (built.load() < kThreads) std::this_thread::yield();
+      });
+    }
+    for (auto& w : workers) w.join();
+    return profiler_->GetMemoryStats();
+  };
+
+  const auto first = run_round();
+  EXPECT_GE(first.nodes_carved, kThreads * (kDepth + 1));
+  EXPECT_GT(first.node_slabs, 0u);
+  EXPECT_EQ(first.node_bytes,
+            first.node_slabs * 1024 *
+                sizeof(z3y::interfaces::profiler::AggregatorNode));
+  // 线程退出时根树与线程缓存都已交回全局栈
+  EXPECT_GE(first.nodes_free_global, kThreads * (kDepth + 1));
+
+  const auto second = run_round();
+  // 第二轮几乎完全复用第一轮归还的节点，只允许每个线程多切出至多一批
+  EXPECT_LE(second.nodes_carved, first.nodes_carved + kThreads * 64);
+}
+
+/**
+ * @brief 验证冷热分离：纯计时节点不分配冷数据块，数值与标签按需挂上且结果不变。
+ */
+TEST_F(ProfilerPluginTest, Verify_Cold_Stats_Attached_On_Demand) {
+  const auto before = profiler_->GetMemoryStats();
+  {
+    Z3Y_PROFILE_ROOT("Cold_Timer_Root", 1, 0.0);
+    for (int i = 0; i < 10; ++i) {
+      Z3Y_PROFILE_NAMED("Cold_Timer_Child");
+    }
+  }
+  const auto timers_only = profiler_->GetMemoryStats();
+  EXPECT_EQ(timers_only.cold_blocks, before.cold_blocks);
+
+  {
+    Z3Y_PROFILE_ROOT("Cold_Value_Root", 1, 0.0);
+    Z3Y_PROFILE_TAG("Lot", "C-42");
+    for (double v : {2.5, 4.5}) {
+      Z3Y_PROFILE_VALUE("Cold_Value", v);
+    }
+  }
+  const auto with_values = profiler_->GetMemoryStats();
+  // 根节点 (标签) + 数值节点，节点复用时可能沿用已有的块
+  EXPECT_LE(with_values.cold_blocks, timers_only.cold_blocks + 2);
+  EXPECT_EQ(with_values.cold_bytes,
+            with_values.cold_blocks *
+                sizeof(z3y::interfaces::profiler::NodeColdStats));
+
+  std::string logs = ReadAllLogs();
+  EXPECT_NE(logs.find("C-42"), std::string::npos);
+  EXPECT_NE(logs.find("Cold_Value"), std::string::npos);
+  EXPECT_NE(logs.find("Max: 4.50"), std::string::npos);
+}
+
+/**
+ * @brief 验证类型化标签：多个线程在同一节点上打标签时按值分别计数，字符串驻留后解析回原文。
+ */
+TEST_F(ProfilerPluginTest, Verify_Typed_Tags_Counted_By_Value) {
+  enum class GrabMode { Free = 1, Trigger = 2 };
+
+  auto sink = std::make_shared<CaptureSink>();
+  profiler_->AddReportSink(sink);
+
+  const uint64_t frame_id = 4242;
+  const int kWorkers = 4;
+  const int kIterations = 500;
+  Z3Y_PROFILE_ASYNC_BEGIN("Typed_Tag_Workflow", frame_id, 1, 0.0);
+  std::atomic<int> finished{0};
+  std::vector<std::thread> workers;
+  for (int t = 0; t < kWorkers; ++t) {
+    workers.emplace_back([&, t]() {
+      Z3Y_PROFILE_ASYNC_ATTACH(frame_id);
+      for (int i = 0; i < kIterations; ++i) {
+        Z3Y_PROFILE_NAMED("Camera_Grab");
+        Z3Y_PROFILE_TAG_INT("Camera", t);
+        Z3Y_PROFILE_TAG("Lot", t % 2 ? "odd" : "even");  // 并发争抢 2 个字符串槽位
+      }
+      // 中途的 Commit 会换代出报告，仍在旧代上计时的作用域写入会落在已出报告之后；
+      // 等所有 Worker 写完再提交，计数才能精确比对
+      finished.fetch_add(1);
+      while (finished.load() < kWorkers) std::this_thread::yield();
+      Z3Y_PROFILE_ASYNC_COMMIT(frame_id);
+    });
+  }
+  for (auto& w : workers) w.join();
+  Z3Y_PROFILE_ASYNC_COMMIT(frame_id);
+
+  const uint32_t line_id = profiler_->InternTagString("Line-B");
+  EXPECT_NE(line_id, 0u);
+  EXPECT_EQ(profiler_->InternTagString("Line-B"), line_id);
+  {
+    Z3Y_PROFILE_ROOT("Typed_Tag_Root", 1, 0.0);
+    for (int i = 0; i < 12; ++i) {
+      Z3Y_PROFILE_NAMED("Tagged_Step");
+      Z3Y_PROFILE_TAG_NAME("Line", "A");
+      Z3Y_PROFILE_TAG_ID("Line", line_id);
+      Z3Y_PROFILE_TAG_ENUM("Mode", i < 4 ? GrabMode::Free : GrabMode::Trigger);
+      Z3Y_PROFILE_TAG_INT("Seq", i);  // 12 个不同的值，超出每节点的槽位上限
+    }
+  }
+  profiler_->FlushReports();
+  profiler_->RemoveReportSink(sink);
+
+  using z3y::interfaces::profiler::ReportNode;
+  auto count_of = [](const ReportNode& node, const std::string& key,
+                     const std::string& value) -> uint64_t {
+    uint64_t sum = 0;
+    for (const auto& tag : node.tag_values) {
+      if (tag.key == key && tag.value == value) sum += tag.count;
+    }
+    return sum;
+  };
+  std::lock_guard<std::mutex> lock(sink->mutex);
+  // Worker 每次提交都可能先出一份报告，Camera_Grab 的计数分散在几份报告里
+  std::vector<const ReportNode*> grabs;
+  const ReportNode* step = nullptr;
+  for (const auto& report : sink->reports) {
+    for (const auto& node : report.nodes) {
+      if (node.name == "Camera_Grab") grabs.push_back(&node);
+      if (node.name == "Tagged_Step") step = &node;
+    }
+  }
+  ASSERT_FALSE(grabs.empty());
+  ASSERT_NE(step, nullptr);
+  for (int t = 0; t < kWorkers; ++t) {
+    uint64_t total = 0;
+    for (const ReportNode* grab : grabs) {
+      total += count_of(*grab, "Camera", std::to_string(t));
+    }
+    EXPECT_EQ(total, static_cast<uint64_t>(kIterations));
+  }
+  for (const ReportNode* grab : grabs) {
+    EXPECT_LE(grab->tags.size(), 2u);
+    for (const auto& tag : grab->tags) {
+      EXPECT_EQ(tag.first, "Lot");
+      EXPECT_TRUE(tag.second == "odd" || tag.second == "even") << tag.second;
+    }
+  }
+
+  EXPECT_EQ(count_of(*step, "Line", "A"), 12u);
+  EXPECT_EQ(count_of(*step, "Line", "Line-B"), 12u);
+  EXPECT_EQ(count_of(*step, "Mode", "1"), 4u);
+  EXPECT_EQ(count_of(*step, "Mode", "2"), 8u);
+  // Line x2 + Mode x2 占去 4 个槽位，Seq 只有 4 个值单独计数
+  uint64_t seq_counted = 0;
+  for (const auto& tag : step->tag_values) {
+    if (tag.key == "Seq") seq_counted += tag.count;
+  }
+  EXPECT_EQ(seq_counted + step->tag_value_overflow, 12u);
+  EXPECT_EQ(step->tag_value_overflow, 8u);
+
+  std::ostringstream json;
+  z3y::interfaces::profiler::WriteJson(json, sink->reports.back());
+  EXPECT_NE(json.str().find("{\"key\":\"Line\",\"value\":\"Line-B\",\"count\":12}"),
+            std::string::npos)
+      << json.str();
+
+  std::string logs = ReadAllLogs();
+  EXPECT_NE(logs.find("[Tag] Mode: 2 x8 1 x4"), std::string::npos);
+}
+
+/**
+ * @brief 验证采样模式：无需探针，CPU 密集的代码会被采到并归属到模块、线程。
+ */
+TEST_F(ProfilerPluginTest, Verify_Sampling_Mode) {
+  config_->SetValue("System.Profiler.SamplingHz", 1000);
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  if (profiler_->GetSamplingProfile(0).rate_hz == 0) {
+    config_->SetValue("System.Profiler.SamplingHz", 0);
+    GTEST_SKIP() << "Sampling mode is not supported on this platform";
+  }
+
+  // 纯 CPU 忙循环，不含任何探针
+  volatile uint64_t sink = 0;
+  const auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::milliseconds(300);
+  while (std::chrono::steady_clock::now() < deadline) {
+    for (int i = 0; i < 10000; ++i) sink = sink + static_cast<uint64_t>(i);
+  }
+
+  const auto profile = profiler_->GetSamplingProfile(16);
+  config_->SetValue("System.Profiler.SamplingHz", 0);
+
+  EXPECT_EQ(profile.rate_hz, 1000u);
+  EXPECT_GT(profile.total_samples, 10u);
+  ASSERT_FALSE(profile.modules.empty());
+  ASSERT_FALSE(profile.threads.empty());
+  EXPECT_LE(profile.symbols.size(), 16u);
+
+  uint64_t module_total = 0;
+  for (const auto& module : profile.modules) module_total += module.samples;
+  EXPECT_EQ(module_total, profile.total_samples);
+  for (size_t i = 1; i < profile.modules.size(); ++i) {
+    EXPECT_GE(profile.modules[i - 1].samples, profile.modules[i].samples);
+  }
+
+  // 关闭后开始新的会话，之前的样本被清空
+  EXPECT_EQ(profiler_->GetSamplingProfile(16).total_samples, 0u);
+}
+
+/**
+ * @brief 验证硬件计数器：ROOT 作用域读到的增量累加到根节点并出现在报表中。
+ */
+TEST_F(ProfilerPluginTest, Verify_Hardware_Counters_On_Root) {
+  z3y::interfaces::profiler::HardwareCounterSample probe;
+  EXPECT_FALSE(profiler_->ReadHardwareCounters(probe));  // 默认关闭
+  config_->SetValue("System.Profiler.HardwareCounters", true);
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  if (!profiler_->ReadHardwareCounters(probe)) {
+    config_->SetValue("System.Profiler.HardwareCounters", false);
+    GTEST_SKIP() << "Hardware counters are unavailable in this environment";
+  }
+
+  {
+    Z3Y_PROFILE_ROOT("HW_Root", 1, 0.0);
+    volatile uint64_t sink = 0;
+    for (int i = 0; i < 100000; ++i) sink = sink + static_cast<uint64_t>(i);
+  }
+  config_->SetValue("System.Profiler.HardwareCounters", false);
+
+  std::string logs = ReadAllLogs();
+  EXPECT_NE(logs.find("HW_Root"), std::string::npos);
+  EXPECT_NE(logs.find("[HW] IPC:"), std::string::npos) << logs;
+}
+
+/**
+ * @brief 验证分配统计：z3y_alloc_interposer 上报的分配计入最内层作用域，并出现在报表与 JSON 中。
+ */
+TEST_F(ProfilerPluginTest, Verify_Allocation_Tracking_Per_Scope) {
+  config_->SetValue("System.Profiler.AllocationTracking", true);
+  for (int retry = 0; retry < 50 && !z3y::IsAllocationHookInstalled(); ++retry) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  ASSERT_TRUE(z3y::IsAllocationHookInstalled());
+
+  auto sink = std::make_shared<CaptureSink>();
+  profiler_->AddReportSink(sink);
+  std::vector<std::unique_ptr<char[]>> blocks;
+  blocks.reserve(16);  // 容器自身的分配发生在被统计的作用域之外
+  {
+    Z3Y_PROFILE_ROOT("Alloc_Root", 1, 0.0);
+    {
+      Z3Y_PROFILE_NAMED("Alloc_Child");
+      for (int i = 0; i < 10; ++i) blocks.emplace_back(new char[1000]);
+    }
+    Z3Y_PROFILE_NAMED("Alloc_Free_Child");
+  }
+  profiler_->FlushReports();
+  profiler_->RemoveReportSink(sink);
+  config_->SetValue("System.Profiler.AllocationTracking", false);
+
+  std::lock_guard<std::mutex> lock(sink->mutex);
+  ASSERT_EQ(sink->reports.size(), 1u);
+  const auto& report = sink->reports.front();
+  ASSERT_EQ(report.nodes.size(), 3u);
+  EXPECT_EQ(report.nodes[1].name, "Alloc_Child");
+  EXPECT_EQ(report.nodes[1].alloc_count, 10u);
+  EXPECT_EQ(report.nodes[1].alloc_bytes, 10000u);
+  EXPECT_EQ(report.nodes[2].name, "Alloc_Free_Child");
+  EXPECT_EQ(report.nodes[2].alloc_count, 0u);
+
+  std::ostringstream json;
+  z3y::interfaces::profiler::WriteJson(json, report);
+  EXPECT_NE(json.str().find("\"alloc\":{\"count\":10,\"bytes\":10000}"),
+            std::string::npos)
+      << json.str();
+  std::string logs = ReadAllLogs();
+  EXPECT_NE(logs.find("Allocs    Bytes"), std::string::npos) << logs;
+}
+
 /**
  * @brief 验证 Profiler 配置选项能否实时动态介入（热阻断）。
  */
 TEST_F(ProfilerPluginTest, Verify_Config_Dynamic_Disable) {
-  auto [cfg_svc, err] =
-      TryGetDefaultService<z3y::interfaces::core::IConfigService>();
-  ASSERT_EQ(err, z3y::InstanceError::kSuccess);
-
   // 将控制变量动态设为 false，测试引擎是否能够立即屏蔽探针注入
-  cfg_svc->SetValue("System.Profiler.Enable", false);
+  config_->SetValue("System.Profiler.Enable", false);
 
   int retry = 50;
   bool is_enabled = true;
   while (is_enabled && retry-- > 0) {
     std::this_thread::sleep_for(std::chrono::milliseconds(10));
-    if (auto [svc, err2] =
-            TryGetDefaultService<z3y::interfaces::profiler::IProfilerService>();
-        err2 == z3y::InstanceError::kSuccess) {
-      is_enabled = svc->IsEnabled();
-    }
+    is_enabled = profiler_->IsEnabled();
   }
 
   {
@@ -322,6 +1467,8 @@ TEST_F(ProfilerPluginTest, Verify_Config_Dynamic_Disable) {
  */
 TEST(ProfilerConcurrencyTest, LockFreeDoubleAccumulation) {
   z3y::interfaces::profiler::AggregatorNode node;
+  z3y::interfaces::profiler::NodeColdStats cold;
+  node.cold.store(&cold);
   node.Reset();
 
   const int num_threads = 20;
@@ -331,15 +1478,15 @@ TEST(ProfilerConcurrencyTest, LockFreeDoubleAccumulation) {
   std::vector<std::thread> workers;
 
   for (int t = 0; t < num_threads; ++t) {
-    workers.emplace_back([&node, iterations, val_to_add]() {
+    workers.emplace_back([&node, &cold, iterations, val_to_add]() {
       for (int i = 0; i < iterations; ++i) {
         // 并发写入调用次数
         node.call_count.fetch_add(1, std::memory_order_relaxed);
         // 并发累加 Double
-        z3y::interfaces::profiler::AtomicAddDouble(node.sum_value_bits,
+        z3y::interfaces::profiler::AtomicAddDouble(cold.sum_value_bits,
                                                    val_to_add);
         // 并发抢占最大值
-        z3y::interfaces::profiler::AtomicUpdateMax(node.max_value_bits,
+        z3y::interfaces::profiler::AtomicUpdateMax(cold.max_value_bits,
                                                    val_to_add * (i % 100));
       }
     });
@@ -361,12 +1508,61 @@ TEST(ProfilerConcurrencyTest, LockFreeDoubleAccumulation) {
   EXPECT_NEAR(node.GetMaxValue(), val_to_add * 99, 1e-4);
 }
 
+/**
+ * @brief 时钟校准测试：探针记录的原始 tick 换算回毫秒后应与 steady_clock 吻合
+ */
+TEST(ProfilerConcurrencyTest, TickClock_ConvertsToWallTime) {
+  using z3y::interfaces::profiler::ProfilerClock;
+  z3y::interfaces::profiler::AggregatorNode node;
+  node.Reset();
+  EXPECT_DOUBLE_EQ(node.GetMinTimeMs(), 0.0);  // 未记录时不暴露哨兵值
+
+  for (int i = 0; i < 2; ++i) {
+    const uint64_t start = ProfilerClock::Now();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    node.RecordTicks(ProfilerClock::Now() - start);
+  }
+
+  EXPECT_EQ(node.call_count.load(), 2u);
+  EXPECT_GE(node.GetTotalTimeMs(), 36.0);
+  EXPECT_LT(node.GetTotalTimeMs(), 1000.0);
+  EXPECT_GE(node.GetMinTimeMs(), 18.0);
+  EXPECT_LE(node.GetMinTimeMs(), node.GetMaxTimeMs());
+}
+
+/**
+ * @brief 对数分桶直方图：分位数误差在精度范围内，且多线程分片可以无损合并
+ */
+TEST(ProfilerConcurrencyTest, LogHistogram_PercentilesAndMerge) {
+  using z3y::interfaces::profiler::LogHistogram;
+  LogHistogram a(3), b(3);  // 3 bit 精度：相对误差 <= 12.5%
+  for (uint64_t v = 1; v <= 10000; ++v) (v % 2 ? a : b).Record(v * 1000);
+  a.Merge(b);
+
+  EXPECT_NEAR(static_cast<double>(a.Percentile(0.50)), 5000000.0, 5000000.0 * 0.07);
+  EXPECT_NEAR(static_cast<double>(a.Percentile(0.99)), 9900000.0, 9900000.0 * 0.07);
+  EXPECT_LE(a.Percentile(0.50), a.Percentile(0.95));
+  EXPECT_LE(a.Percentile(0.95), a.Percentile(0.999));
+
+  LogHistogram small(2);
+  small.Record(0);
+  small.Record(3);  // 线性区间内精确计数
+  EXPECT_EQ(small.Percentile(0.5), 0u);
+  EXPECT_EQ(small.Percentile(1.0), 3u);
+  small.Reset();
+  EXPECT_EQ(small.Percentile(0.99), 0u);
+}
+
 /**
  * @brief 满载熔断降级测试：验证 1024 个槽位被僵尸耗尽时，系统触发 Circuit
  * Breaker 且不崩溃
  */
 TEST_F(ProfilerPluginTest, Verify_CircuitBreaker_On_Exhaustion) {
-  // 故意占据全部 1024 个物理槽位，且不调用 COMMIT (模拟全部卡死)
+  // 把在途帧上限收紧到 1024
+  config_->SetValue("System.Profiler.MaxAsyncFrames", 1024);
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+  // 故意占据全部 1024 个槽位，且不调用 COMMIT (模拟全部卡死)
   for (uint64_t i = 1; i <= 1024; ++i) {
     Z3Y_PROFILE_ASYNC_BEGIN("Zombie_Slot", i, 1, 0.0);
   }
@@ -397,8 +1593,44 @@ TEST_F(ProfilerPluginTest, Verify_CircuitBreaker_On_Exhaustion) {
   for (uint64_t i = 1; i <= 1024; ++i) {
     Z3Y_PROFILE_ASYNC_COMMIT(i);
   }
+  config_->SetValue("System.Profiler.MaxAsyncFrames", 65536);
+}
+
+/**
+ * @brief 验证帧表可以同时容纳远超 1024 个在途帧，且提交后槽位被回收复用。
+ */
+TEST_F(ProfilerPluginTest, Verify_Thousands_Of_Inflight_Frames) {
+  const uint64_t kFrames = 5000;
+  for (uint64_t i = 1; i < kFrames; ++i) {
+    Z3Y_PROFILE_ASYNC_BEGIN("Inflight_Frame", 100000 + i, 1000000, 0.0);
+  }
+  Z3Y_PROFILE_ASYNC_BEGIN("Inflight_Frame", 100000 + kFrames, 1, 0.0);
+
+  // 最后一帧由 Worker 写入数据并完成提交，报告中必须能看到它
+  std::thread worker([]() {
+    Z3Y_PROFILE_ASYNC_ATTACH(100000 + 5000);
+    { Z3Y_PROFILE_NAMED("Inflight_Last_Step"); }
+    Z3Y_PROFILE_ASYNC_COMMIT(100000 + 5000);
+  });
+  worker.join();
+
+  for (uint64_t i = 1; i < kFrames; ++i) {
+    Z3Y_PROFILE_ASYNC_COMMIT(100000 + i);
+  }
+  // 重新开启同一批帧号：若旧槽位未被回收，这里会触发熔断
+  for (uint64_t i = 1; i < kFrames; ++i) {
+    Z3Y_PROFILE_ASYNC_BEGIN("Inflight_Frame", 100000 + i, 1000000, 0.0);
+    Z3Y_PROFILE_ASYNC_COMMIT(100000 + i);
+  }
+
+  Z3Y_PROFILE_ASYNC_COMMIT(100000 + 5000);  // 最后一个引用：收尾出报告
+
+  std::string logs = ReadAllLogs();
+  EXPECT_TRUE(logs.find("Circuit breaker") == std::string::npos);
+  EXPECT_TRUE(logs.find("Inflight_Last_Step") != std::string::npos);
 }
 
+
 /**
  * @brief 僵尸线程 UAF 防御测试：验证侵入式引用计数与就地超度法则
  */
@@ -451,3 +1683,283 @@ TEST_F(ProfilerPluginTest, Verify_Zombie_UAF_Protection) {
   EXPECT_TRUE(logs.find("Zombie_Step") != std::string::npos);
   EXPECT_TRUE(logs.find("Zombie_Value") != std::string::npos);
 }
+
+/**
+ * @brief 验证探针热路径只依赖纪元：纪元未变时正常记录；作用域内纪元变化 (注册表变化、插件重载)
+ * 时已打开的探针放弃写入，之后新开的探针重新查找服务并恢复记录。
+ */
+TEST_F(ProfilerPluginTest, Verify_Epoch_Change_Skips_Stale_Scopes) {
+  {
+    Z3Y_PROFILE_ROOT("Epoch_Stale_Root", 1, 0.0);
+    {
+      Z3Y_PROFILE_NAMED("Epoch_Stale_Step");
+      auto* registry = dynamic_cast<z3y::IPluginRegistry*>(manager_.get());
+      ASSERT_NE(registry, nullptr);
+      registry->RegisterComponent(
+          z3y::ConstexprHash("z3y-test-epoch-dummy"),
+          []() { return z3y::PluginPtr<z3y::IComponent>(); }, false,
+          "Epoch.Dummy", {}, false);
+    }
+  }
+  {
+    Z3Y_PROFILE_ROOT("Epoch_Fresh_Root", 1, 0.0);
+    for (int i = 0; i < 1000; ++i) {
+      Z3Y_PROFILE_NAMED("Epoch_Hot_Scope");
+    }
+  }
+  std::string logs = ReadAllLogs();
+  EXPECT_TRUE(logs.find("Epoch_Stale_Root") == std::string::npos);
+  EXPECT_TRUE(logs.find("Epoch_Fresh_Root") != std::string::npos);
+  EXPECT_TRUE(logs.find("Epoch_Hot_Scope") != std::string::npos);
+}
+
+/**
+ * @brief 验证报告换代：工作线程每次出报告时摘下旧代，另一个线程同时不停地读实时快照，
+ * 旧代要等快照结束才回收，报告内容与快照都不会被破坏。
+ */
+TEST_F(ProfilerPluginTest, Verify_Report_Swaps_Generation_Under_Live_Snapshots) {
+  struct CountSink : z3y::interfaces::profiler::IProfilerReportSink {
+    void OnReport(
+        const z3y::interfaces::profiler::ProfileReport& report) override {
+      for (const auto& node : report.nodes) {
+        if (node.name == "Swap_Child") child_calls += node.count;
+      }
+      ++reports;
+    }
+    std::atomic<uint64_t> child_calls{0};
+    std::atomic<uint64_t> reports{0};
+  };
+
+  auto sink = std::make_shared<CountSink>();
+  profiler_->AddReportSink(sink);
+
+  constexpr int kRounds = 2000;
+  std::atomic<bool> done{false};
+  auto* profiler = profiler_.get();  // C++17 的 lambda 不能捕获结构化绑定
+  std::thread worker([&] {
+    for (int i = 0; i < kRounds; ++i) {
+      {
+        Z3Y_PROFILE_ROOT("Swap_Root", 1, 0.0);  // 每次都出报告并换代
+        Z3Y_PROFILE_NAMED("Swap_Child");
+      }
+      if (i % 32 == 31) profiler->FlushReports();  // 不超过报告队列上限，避免丢弃
+    }
+    done = true;
+  });
+  size_t snapshots = 0;
+  while (!done) {
+    for (const auto& report : profiler_->SnapshotLiveRoots()) {
+      if (!report.nodes.empty() && report.nodes[0].name == "Swap_Root") {
+        EXPECT_LE(report.nodes[0].count, 1u);  // 快照里只会是尚未报告的新一代
+      }
+    }
+    ++snapshots;
+  }
+  worker.join();
+  profiler_->FlushReports();
+  profiler_->RemoveReportSink(sink);
+
+  EXPECT_GT(snapshots, 0u);
+  EXPECT_EQ(sink->reports.load(), static_cast<uint64_t>(kRounds));
+  EXPECT_EQ(sink->child_calls.load(), static_cast<uint64_t>(kRounds));
+}
+
+/**
+ * @brief 验证分组根：同一个调用点按键拆成独立的树，多线程共享同一个键的根，超出上限时按 LRU 淘汰。
+ */
+TEST_F(ProfilerPluginTest, Verify_Keyed_Roots_Group_And_Evict) {
+  config_->SetValue("System.Profiler.KeyedRootCapacity", 2);
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  auto sink = std::make_shared<CaptureSink>();
+  profiler_->AddReportSink(sink);
+
+  auto run_recipe = [](int recipe) {
+    Z3Y_PROFILE_ROOT_KEYED("Recipe_Root", recipe, 1000000, 0.0);
+    Z3Y_PROFILE_NAMED("Recipe_Step");
+  };
+  run_recipe(1);
+  run_recipe(2);
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  run_recipe(1);  // 2 成为最久未用的键
+  run_recipe(3);  // 表已满：淘汰 2 并输出它
+  EXPECT_EQ(profiler_->GetMemoryStats().keyed_roots, 2u);
+  EXPECT_EQ(profiler_->GetMemoryStats().keyed_root_evictions, 1u);
+
+  constexpr int kWorkers = 4;
+  constexpr int kIterations = 300;
+  std::vector<std::thread> workers;
+  for (int t = 0; t < kWorkers; ++t) {
+    workers.emplace_back([&, t]() {
+      for (int i = 0; i < kIterations; ++i) run_recipe(t % 2 ? 3 : 1);
+    });
+  }
+  for (auto& w : workers) w.join();
+
+  const uint32_t line_id = profiler_->InternTagString("Line-B");
+  config_->SetValue("System.Profiler.KeyedRootCapacity", 64);
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  {
+    Z3Y_PROFILE_ROOT_KEYED_ID("Recipe_Root", line_id, 1000000, 0.0);
+  }
+
+  std::map<std::string, uint64_t> live;
+  std::map<std::string, uint64_t> live_steps;
+  for (const auto& report : profiler_->SnapshotLiveRoots()) {
+    live[report.nodes.front().name] = report.nodes.front().count;
+    for (const auto& node : report.nodes) {
+      if (node.name == "Recipe_Step") live_steps[report.nodes.front().name] += node.count;
+    }
+  }
+  EXPECT_EQ(live["Recipe_Root [1]"], 2u + kWorkers / 2 * kIterations);
+  EXPECT_EQ(live_steps["Recipe_Root [1]"], 2u + kWorkers / 2 * kIterations);
+  EXPECT_EQ(live["Recipe_Root [3]"], 1u + kWorkers / 2 * kIterations);
+  EXPECT_EQ(live["Recipe_Root [Line-B]"], 1u);
+  EXPECT_EQ(live.count("Recipe_Root [2]"), 0u);
+
+  profiler_->FlushReports();
+  profiler_->RemoveReportSink(sink);
+  std::lock_guard<std::mutex> lock(sink->mutex);
+  ASSERT_EQ(sink->reports.size(), 1u);
+  EXPECT_EQ(sink->reports[0].reason, "Evicted (LRU)");
+  EXPECT_EQ(sink->reports[0].nodes.front().name, "Recipe_Root [2]");
+  EXPECT_EQ(sink->reports[0].nodes.front().count, 1u);
+}
+
+/** @brief 每个 N 是一个独立的调用点，其下挂一条 900 层的递归路径。 */
+template <int N>
+static void BudgetBranch() {
+  Z3Y_PROFILE_NAMED("Budget_Branch");
+  ProfiledRecursion(900);
+}
+
+template <int... N>
+static void RunBudgetBranches(std::integer_sequence<int, N...>,
+                              const std::function<void()>& after_each) {
+  ((
+       [&] {
+         Z3Y_PROFILE_ROOT("Budget_Root", 1000000, 0.0);
+         BudgetBranch<N>();
+       }(),
+       after_each()),
+   ...);
+}
+
+/**
+ * @brief 验证节点内存预算：长期不出报告的根不断长出新路径时，常驻节点内存不超过预算；
+ * 进入压力状态后根提前换代输出，旧代回收后整块空闲的块交还给操作系统，压力解除后照常记录。
+ */
+TEST_F(ProfilerPluginTest, Verify_Node_Memory_Budget_Evicts_And_Releases) {
+  config_->SetValue("System.Profiler.NodeMemoryBudgetMB", 1);  // 8192 个节点
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  auto sink = std::make_shared<CaptureSink>();
+  profiler_->AddReportSink(sink);
+
+  // 16 个调用点 x 901 个节点，一代装不下；周期足够大，只有内存压力会让根换代。
+  // 每个根之后等报告线程处理完 (输出、回收、整理)，单核机器上也按实际节奏交替进行。
+  // 工作线程退出时交出最后一代，整块空闲的块随后交还
+  uint64_t peak_bytes = 0;
+  std::thread worker([&] {
+    const auto after_each = [&] {
+      peak_bytes = std::max(peak_bytes, profiler_->GetMemoryStats().node_bytes);
+      profiler_->FlushReports();
+    };
+    for (int round = 0; round < 3; ++round) {
+      RunBudgetBranches(std::make_integer_sequence<int, 16>{}, after_each);
+    }
+  });
+  worker.join();
+  profiler_->FlushReports();
+
+  auto stats = profiler_->GetMemoryStats();
+  EXPECT_EQ(stats.node_budget_bytes, 1u << 20);
+  EXPECT_LE(peak_bytes, stats.node_budget_bytes);
+  EXPECT_GT(stats.budget_evictions, 0u);
+  EXPECT_GT(stats.node_slabs_released, 0u);
+  EXPECT_FALSE(stats.memory_pressure);
+  EXPECT_LT(stats.nodes_in_use, 4096u);
+  {
+    std::lock_guard<std::mutex> lock(sink->mutex);
+    ASSERT_FALSE(sink->reports.empty());
+    EXPECT_EQ(sink->reports[0].reason, "Memory Budget (Limit: 1 MB)");
+  }
+
+  // 压力解除后，交还的块被复用，新路径照常完整记录
+  const uint64_t failures = stats.node_acquire_failures;
+  {
+    Z3Y_PROFILE_ROOT("Budget_Tail", 1, 0.0);
+    BudgetBranch<0>();
+  }
+  profiler_->FlushReports();
+  stats = profiler_->GetMemoryStats();
+  EXPECT_EQ(stats.node_acquire_failures, failures);
+  EXPECT_LE(stats.node_bytes, stats.node_budget_bytes);
+  profiler_->RemoveReportSink(sink);
+  std::lock_guard<std::mutex> lock(sink->mutex);
+  EXPECT_EQ(sink->reports.back().reason, "Periodic Tick (Period: 1)");
+}
+
+/**
+ * @brief 验证节拍根：按 5ms 节拍运行 40 帧，第 20 帧多花 15ms。报告给出间隔统计与抖动直方图，
+ * 最差帧是第 20 帧，且能看出拖慢节拍的是哪一个阶段。
+ */
+TEST_F(ProfilerPluginTest, Verify_Paced_Root_Jitter_And_Worst_Frames) {
+  using z3y::interfaces::profiler::FramePacing;
+  auto sink = std::make_shared<CaptureSink>();
+  profiler_->AddReportSink(sink);
+
+  constexpr int kFrames = 40;
+  constexpr auto kCadence = std::chrono::milliseconds(5);
+  auto next = std::chrono::steady_clock::now();
+  for (int frame = 1; frame <= kFrames; ++frame) {
+    std::this_thread::sleep_until(next);
+    next += kCadence;
+    Z3Y_PROFILE_ROOT_PACED("Paced_Loop", kFrames, 0.0, 5.0);
+    {
+      Z3Y_PROFILE_NAMED("Pace_Grab");
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    if (frame == 20) {
+      Z3Y_PROFILE_NAMED("Pace_Stall");
+      std::this_thread::sleep_for(std::chrono::milliseconds(15));
+      next = std::chrono::steady_clock::now();  // 晚到之后重新对齐，不连续补帧
+    }
+  }
+  profiler_->FlushReports();
+  profiler_->RemoveReportSink(sink);
+
+  std::lock_guard<std::mutex> lock(sink->mutex);
+  ASSERT_EQ(sink->reports.size(), 1u);
+  const FramePacing& pacing = sink->reports[0].pacing;
+  EXPECT_DOUBLE_EQ(pacing.cadence_ms, 5.0);
+  EXPECT_DOUBLE_EQ(pacing.tolerance, 0.10);
+  EXPECT_EQ(pacing.intervals, static_cast<uint64_t>(kFrames - 1));
+  EXPECT_GE(pacing.deadline_misses, 1u);
+  EXPECT_GE(pacing.max_interval_ms, 15.0);
+  EXPECT_LE(pacing.min_interval_ms, pacing.mean_interval_ms);
+  EXPECT_GT(pacing.jitter_rms_ms, 0.0);
+  uint64_t histogram_total = 0;
+  for (uint64_t count : pacing.jitter_histogram) histogram_total += count;
+  EXPECT_EQ(histogram_total, pacing.intervals);
+  EXPECT_GE(pacing.jitter_histogram.back(), 1u);  // 第 20 帧偏离节拍 100% 以上
+
+  ASSERT_FALSE(pacing.worst_frames.empty());
+  EXPECT_LE(pacing.worst_frames.size(), FramePacing::kMaxWorstFrames);
+  const auto& worst = pacing.worst_frames.front();
+  EXPECT_EQ(worst.frame, 20u);
+  EXPECT_DOUBLE_EQ(worst.interval_ms, pacing.max_interval_ms);
+  EXPECT_GE(worst.frame_ms, 15.0);
+  EXPECT_NEAR(worst.frame_ms + worst.gap_ms, worst.interval_ms, 1e-6);
+  ASSERT_EQ(worst.stages.size(), 2u);
+  EXPECT_EQ(worst.stages[0].first, "Pace_Stall");
+  EXPECT_GE(worst.stages[0].second, 14.0);
+  EXPECT_EQ(worst.stages[1].first, "Pace_Grab");
+  for (size_t i = 1; i < pacing.worst_frames.size(); ++i) {
+    EXPECT_GE(pacing.worst_frames[i - 1].interval_ms, pacing.worst_frames[i].interval_ms);
+  }
+
+  std::ostringstream json;
+  z3y::interfaces::profiler::WriteJson(json, sink->reports[0]);
+  EXPECT_NE(json.str().find("\"pacing\":{\"cadence_ms\":5"), std::string::npos) << json.str();
+  EXPECT_NE(json.str().find("\"frame\":20,"), std::string::npos);
+  EXPECT_NE(ReadAllLogs().find("Worst Frame #20:"), std::string::npos);
+}
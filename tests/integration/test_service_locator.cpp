@@ -26,11 +26,20 @@
  * 5. **类型约束**: 验证 Service 和 Component 不能混用（类型安全）。
  * 6. **手动注册 (Manual Registration)**: [新增] 验证在运行时手动注册本地类的能力。
  * 7. **依赖链 (Dependency Chain)**: [新增] 验证服务 A 依赖 B，B 依赖 C 的递归初始化能力。
+ * 8. **独立实例 (Isolated)**: 同一进程中多个 PluginManager 各自解析自己的服务。
  */
 
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <future>
+#include <thread>
+#include <vector>
+
 #include "common/plugin_test_base.h"
 #include "framework/z3y_define_impl.h"
  // 引入测试所需的 Demo 接口
+#include "interfaces_demo/demo_events.h"
 #include "interfaces_demo/i_demo_logger.h" 
 #include "interfaces_demo/i_demo_simple.h"
 
@@ -67,6 +76,13 @@ public:
     int GetValue() override { return 10; }
 };
 
+// 非虚基类实现 (DirectPluginImpl)，用于验证 GetLocalService
+class DirectChainServiceC final : public z3y::DirectPluginImpl<DirectChainServiceC, IChainServiceC> {
+public:
+    Z3Y_DEFINE_COMPONENT_ID("z3y-test-chain-C-DIRECT-IMPL");
+    int GetValue() override { return 42; }
+};
+
 class ChainServiceB : public z3y::PluginImpl<ChainServiceB, IChainServiceB> {
 public:
     Z3Y_DEFINE_COMPONENT_ID("z3y-test-chain-B-IMPL");
@@ -269,3 +285,609 @@ TEST_F(ServiceLocatorTest, ManualRegistration_Component) {
     EXPECT_NE(ptr1.get(), ptr2.get()) << "手动注册的组件应每次返回新实例";
     EXPECT_EQ(ptr1->GetValue(), 10);
 }
+
+// =============================================================================
+// 4. 缓存句柄 (ServiceHandle)
+// =============================================================================
+
+/**
+ * @test 缓存句柄的命中与失效
+ * @brief 验证 ServiceHandle 返回与 GetDefaultService 相同的实例，
+ * “未找到” 的结果在注册新服务后失效，插件卸载后不会返回悬空指针。
+ */
+TEST_F(ServiceLocatorTest, ServiceHandle_CachesUntilRegistryChanges) {
+    IDemoLogger* cached = z3y::ServiceHandle<IDemoLogger>::TryGet();
+    ASSERT_NE(cached, nullptr);
+    EXPECT_EQ(cached, z3y::GetDefaultService<IDemoLogger>().get());
+    EXPECT_EQ(z3y::ServiceHandle<IDemoLogger>::TryGet(), cached);
+
+    // 未注册：返回 nullptr，Get() 抛出与 GetDefaultService 相同的错误码
+    EXPECT_EQ(z3y::ServiceHandle<IChainServiceC>::TryGet(), nullptr);
+    try {
+        (void)z3y::ServiceHandle<IChainServiceC>::Get();
+        ADD_FAILURE() << "Get() should throw when the service is missing";
+    } catch (const z3y::PluginException& e) {
+        EXPECT_EQ(e.GetError(), InstanceError::kErrorAliasNotFound);
+    }
+
+    // 注册之后，缓存的 “未找到” 立即失效
+    auto registry = dynamic_cast<z3y::IPluginRegistry*>(manager_.get());
+    ASSERT_NE(registry, nullptr);
+    z3y::RegisterService<ChainServiceC>(registry, "Handle.C", true);
+    ASSERT_NE(z3y::ServiceHandle<IChainServiceC>::TryGet(), nullptr);
+    EXPECT_EQ(z3y::ServiceHandle<IChainServiceC>::Get().GetValue(), 10);
+
+    // 卸载插件后，缓存不能再返回旧实例
+    manager_->UnloadAllPlugins();
+    EXPECT_EQ(z3y::ServiceHandle<IDemoLogger>::TryGet(), nullptr);
+    ASSERT_TRUE(LoadPlugin("plugin_demo_core_services"));
+    IDemoLogger* reloaded = z3y::ServiceHandle<IDemoLogger>::TryGet();
+    ASSERT_NE(reloaded, nullptr);
+    EXPECT_EQ(reloaded, z3y::GetDefaultService<IDemoLogger>().get());
+}
+
+/**
+ * @test 非抛出查找路径
+ * @brief 验证 PluginManager 的 TryGet* 成员直接返回错误码，错误码与抛出版本一致。
+ */
+TEST_F(ServiceLocatorTest, TryGet_ReturnsErrorWithoutThrowing) {
+    InstanceError err = InstanceError::kSuccess;
+    EXPECT_EQ(manager_->TryGetDefaultService<IChainServiceC>(err), nullptr);
+    EXPECT_EQ(err, InstanceError::kErrorAliasNotFound);
+
+    err = InstanceError::kSuccess;
+    EXPECT_EQ(manager_->TryGetService<IDemoSimple>("Demo.Simple.A", err), nullptr);
+    EXPECT_EQ(err, InstanceError::kErrorNotAService);
+
+    err = InstanceError::kErrorInternal;
+    auto logger = manager_->TryGetDefaultService<IDemoLogger>(err);
+    EXPECT_EQ(err, InstanceError::kSuccess);
+    EXPECT_EQ(logger, z3y::GetDefaultService<IDemoLogger>());
+
+    auto [missing, missing_err] = z3y::TryGetDefaultService<IChainServiceC>();
+    EXPECT_EQ(missing, nullptr);
+    EXPECT_EQ(missing_err, InstanceError::kErrorAliasNotFound);
+}
+
+// =============================================================================
+// 5. 大规模注册表
+// =============================================================================
+
+/**
+ * @test 上千个组件的注册与查找
+ * @brief 验证注册表在多次扩容后，按 CLSID / 别名 / 接口的查找结果仍然完整正确。
+ */
+TEST_F(ServiceLocatorTest, Registry_ManyComponents) {
+    const int kCount = 1500;
+    auto registry = dynamic_cast<z3y::IPluginRegistry*>(manager_.get());
+    ASSERT_NE(registry, nullptr);
+
+    auto query = z3y::GetService<IPluginQuery>(clsid::kPluginQuery);
+    ASSERT_NE(query, nullptr);
+
+    std::vector<ClassId> ids;
+    for (int i = 0; i < kCount; ++i) {
+        const std::string name = "z3y-test-bulk-" + std::to_string(i);
+        ids.push_back(z3y::ConstexprHash(name.c_str()));
+        registry->RegisterComponent(ids.back(),
+            []() -> PluginPtr<IComponent> { return std::make_shared<ChainServiceC>(); },
+            i % 2 == 0, "Bulk." + std::to_string(i), ChainServiceC::GetInterfaceDescriptors(), false);
+    }
+
+    EXPECT_EQ(query->FindComponentsImplementing(IChainServiceC::kIid).size(), static_cast<size_t>(kCount));
+    for (int i = 0; i < kCount; ++i) {
+        ComponentDetails details;
+        ASSERT_TRUE(query->GetComponentDetails(ids[i], details));
+        EXPECT_EQ(details.alias, "Bulk." + std::to_string(i));
+        if (i % 2 == 0) {
+            EXPECT_EQ(z3y::GetService<IChainServiceC>(ids[i])->GetValue(), 10);
+        } else {
+            EXPECT_EQ(z3y::CreateInstance<IChainServiceC>(ids[i])->GetValue(), 10);
+        }
+    }
+    ComponentDetails missing;
+    EXPECT_FALSE(query->GetComponentDetails(z3y::ConstexprHash("z3y-test-bulk-missing"), missing));
+}
+
+/**
+ * @test 别名查找键
+ * @brief 验证字面量、std::string、std::string_view 与编译期 Alias 常量解析到同一个服务，
+ * 且 string_view 版本的哈希与 C 字符串版本一致。
+ */
+TEST_F(ServiceLocatorTest, Alias_AllKeyFormsResolve) {
+    static constexpr z3y::Alias kAlias{ "Demo.Logger.Default" };
+    static_assert(kAlias.hash == z3y::ConstexprHash("Demo.Logger.Default"), "hash must match ConstexprHash");
+
+    auto by_literal = z3y::GetService<IDemoLogger>("Demo.Logger.Default");
+    ASSERT_NE(by_literal, nullptr);
+    EXPECT_EQ(z3y::GetService<IDemoLogger>(kAlias), by_literal);
+    EXPECT_EQ(z3y::GetService<IDemoLogger>(std::string("Demo.Logger.Default")), by_literal);
+
+    // 不以 '\0' 结尾的 string_view 也能正确查找
+    const std::string padded = "Demo.Logger.Default#suffix";
+    const std::string_view view(padded.data(), std::string_view("Demo.Logger.Default").size());
+    EXPECT_EQ(z3y::GetService<IDemoLogger>(view), by_literal);
+
+    auto [missing, err] = z3y::TryGetService<IDemoLogger>(std::string_view("Demo.Logger"));
+    EXPECT_EQ(missing, nullptr);
+    EXPECT_EQ(err, InstanceError::kErrorAliasNotFound);
+}
+
+/**
+ * @test 并行预热单例
+ * @brief 验证 WarmUpServices 构造所有单例、发现 Initialize 中的依赖，
+ * 并且之后的 GetService 直接返回预热好的实例。
+ */
+TEST_F(ServiceLocatorTest, WarmUpServices_InitializesAllWithDependencies) {
+    auto registry = dynamic_cast<z3y::IPluginRegistry*>(manager_.get());
+    ASSERT_NE(registry, nullptr);
+    z3y::RegisterService<ChainServiceC>(registry, "Chain.C", true);
+    z3y::RegisterService<ChainServiceB>(registry, "Chain.B", true);
+    z3y::RegisterService<ChainServiceA>(registry, "Chain.A", true);
+
+    ServiceWarmUpReport report = manager_->WarmUpServices(4);
+    EXPECT_GE(report.threads, 1u);
+
+    const ServiceWarmUpResult* a = nullptr;
+    const ServiceWarmUpResult* b = nullptr;
+    for (const auto& result : report.services) {
+        EXPECT_EQ(result.error, InstanceError::kSuccess) << result.alias;
+        if (result.clsid == ChainServiceA::kClsid) a = &result;
+        if (result.clsid == ChainServiceB::kClsid) b = &result;
+    }
+    ASSERT_NE(a, nullptr);
+    ASSERT_NE(b, nullptr);
+    EXPECT_EQ(a->dependencies, std::vector<ClassId>{ ChainServiceB::kClsid });
+    EXPECT_EQ(b->dependencies, std::vector<ClassId>{ ChainServiceC::kClsid });
+    EXPECT_GT(a->init_ns, 0u);
+
+    EXPECT_EQ(z3y::GetDefaultService<IChainServiceA>()->GetTotalValue(), 25);
+
+    // 再次预热不会重新构造
+    auto logger = z3y::GetDefaultService<IDemoLogger>();
+    manager_->WarmUpServices(2);
+    EXPECT_EQ(z3y::GetDefaultService<IDemoLogger>(), logger);
+}
+
+// =============================================================================
+// 8. 池化组件 (RegisterPooledComponent)
+// =============================================================================
+
+class IPooledBuffer : public virtual z3y::IComponent {
+public:
+    Z3Y_DEFINE_INTERFACE(IPooledBuffer, "z3y-test-pooled-buffer-IID", 1, 0);
+    virtual std::vector<int>& Data() = 0;
+};
+
+class PooledBuffer : public z3y::PluginImpl<PooledBuffer, IPooledBuffer> {
+public:
+    Z3Y_DEFINE_COMPONENT_ID("z3y-test-pooled-buffer-IMPL");
+    static inline std::atomic<int> initialize_count{ 0 };
+    static inline std::atomic<int> recycle_count{ 0 };
+
+    void Initialize() override { ++initialize_count; }
+    void OnRecycle() { data_.clear(); ++recycle_count; }
+    std::vector<int>& Data() override { return data_; }
+private:
+    std::vector<int> data_;
+};
+
+/**
+ * @test 池化组件的复用
+ * @brief 验证释放的实例经 OnRecycle 重置后被下一次 CreateInstance 复用，
+ * Initialize 只在首次构造时调用，同时存活的实例互不相同。
+ */
+TEST_F(ServiceLocatorTest, PooledComponent_ReusesReleasedInstances) {
+    auto registry = dynamic_cast<z3y::IPluginRegistry*>(manager_.get());
+    ASSERT_NE(registry, nullptr);
+    PooledBuffer::initialize_count = 0;
+    PooledBuffer::recycle_count = 0;
+    z3y::RegisterPooledComponent<PooledBuffer>(registry, "Pooled.Buffer", false, 1);
+
+    const IPooledBuffer* first_addr = nullptr;
+    {
+        auto buf = z3y::CreateInstance<IPooledBuffer>("Pooled.Buffer");
+        ASSERT_NE(buf, nullptr);
+        buf->Data().push_back(42);
+        first_addr = buf.get();
+    }
+    EXPECT_EQ(PooledBuffer::recycle_count.load(), 1);
+
+    auto again = z3y::CreateInstance<IPooledBuffer>("Pooled.Buffer");
+    EXPECT_EQ(again.get(), first_addr) << "释放的实例应被复用";
+    EXPECT_TRUE(again->Data().empty()) << "OnRecycle 应已重置状态";
+
+    auto second = z3y::CreateInstance<IPooledBuffer>("Pooled.Buffer");
+    EXPECT_NE(second.get(), again.get());
+    EXPECT_EQ(PooledBuffer::initialize_count.load(), 2) << "Initialize 只在新建对象时调用";
+
+    // max_idle = 1：两个实例同时释放，只保留一个
+    again.reset();
+    second.reset();
+    EXPECT_EQ(PooledBuffer::recycle_count.load(), 3);
+    auto third = z3y::CreateInstance<IPooledBuffer>("Pooled.Buffer");
+    auto fourth = z3y::CreateInstance<IPooledBuffer>("Pooled.Buffer");
+    EXPECT_EQ(PooledBuffer::initialize_count.load(), 3);
+}
+
+// =============================================================================
+// 9. 批量注册 (RegisterComponents)
+// =============================================================================
+
+/** @brief 记录收到的合并注册事件。 */
+class RegistrationMonitor : public std::enable_shared_from_this<RegistrationMonitor> {
+public:
+    int single_events = 0;
+    std::vector<std::vector<ClassId>> batches;
+
+    void OnSingle(const z3y::event::ComponentRegisterEvent&) { ++single_events; }
+    void OnBatch(const z3y::event::ComponentsRegisteredEvent& e) { batches.push_back(e.clsids_); }
+};
+
+/**
+ * @test 批量注册
+ * @brief 验证 RegisterComponents 整批发布 (只触发一次合并事件)，
+ * 且批内冲突时整批不注册。
+ */
+TEST_F(ServiceLocatorTest, RegisterComponents_PublishesBatchWithOneCoalescedEvent) {
+    auto registry = dynamic_cast<z3y::IPluginRegistry*>(manager_.get());
+    ASSERT_NE(registry, nullptr);
+    auto monitor = std::make_shared<RegistrationMonitor>();
+    z3y::ScopedConnection c1 = manager_->SubscribeGlobal<z3y::event::ComponentRegisterEvent>(
+        monitor, &RegistrationMonitor::OnSingle);
+    z3y::ScopedConnection c2 = manager_->SubscribeGlobal<z3y::event::ComponentsRegisteredEvent>(
+        monitor, &RegistrationMonitor::OnBatch);
+
+    z3y::internal::BatchingRegistry batch;
+    z3y::RegisterService<ChainServiceC>(&batch, "Batch.C", true);
+    z3y::RegisterService<ChainServiceB>(&batch, "Batch.B", true);
+    z3y::RegisterService<ChainServiceA>(&batch, "Batch.A", true);
+    const z3y::IPluginQuery& query = *manager_;
+    ComponentDetails details;
+    EXPECT_FALSE(query.GetComponentDetails(ChainServiceA::kClsid, details)) << "提交前不应可见";
+    batch.CommitTo(registry);
+
+    EXPECT_EQ(monitor->single_events, 3);
+    ASSERT_EQ(monitor->batches.size(), 1u);
+    EXPECT_EQ(monitor->batches[0],
+        (std::vector<ClassId>{ ChainServiceC::kClsid, ChainServiceB::kClsid, ChainServiceA::kClsid }));
+    EXPECT_EQ(z3y::GetService<IChainServiceA>("Batch.A")->GetTotalValue(), 25);
+
+    // 批内重复 ClassId：整批拒绝，PooledBuffer 也不应被注册
+    z3y::internal::BatchingRegistry conflicting;
+    z3y::RegisterComponent<PooledBuffer>(&conflicting, "Batch.Pooled");
+    z3y::RegisterService<ChainServiceC>(&conflicting, "Batch.C2");
+    EXPECT_THROW(conflicting.CommitTo(registry), std::runtime_error);
+    EXPECT_FALSE(query.GetComponentDetails(PooledBuffer::kClsid, details));
+    EXPECT_EQ(monitor->batches.size(), 1u);
+}
+
+// =============================================================================
+// 10. 静态链接插件 (LoadStaticPlugins)
+// =============================================================================
+
+namespace {
+    int g_static_entry_calls = 0;
+
+    /** @brief 模拟静态链接模式下 Z3Y_DEFINE_PLUGIN_ENTRY 生成的入口 (先收集，再整批提交)。 */
+    void StaticChainPluginInit(z3y::IPluginRegistry* registry) {
+        ++g_static_entry_calls;
+        z3y::internal::BatchingRegistry batch;
+        z3y::RegisterService<ChainServiceC>(&batch, "Static.C", true);
+        z3y::RegisterService<ChainServiceB>(&batch, "Static.B", true);
+        z3y::RegisterService<ChainServiceA>(&batch, "Static.A", true);
+        batch.CommitTo(registry);
+    }
+
+    void StaticFailingPluginInit(z3y::IPluginRegistry*) {
+        throw std::runtime_error("static init failed");
+    }
+}
+
+/**
+ * @test 静态插件表
+ * @brief 验证静态插件不经 dlopen 即可注册 (来源路径为 "static:<name>")，重复加载是幂等的，
+ * 入口失败的插件被报告且不留下名字占用。
+ */
+TEST_F(ServiceLocatorTest, LoadStaticPlugins_RegistersFromConstexprTable) {
+    static constexpr z3y::StaticPluginEntry kPlugins[] = {
+        { "static_chain", &StaticChainPluginInit },
+        { "static_failing", &StaticFailingPluginInit },
+    };
+    g_static_entry_calls = 0;
+    auto failures = manager_->LoadStaticPlugins(kPlugins);
+    ASSERT_EQ(failures.size(), 1u);
+    EXPECT_EQ(failures[0].rfind("static_failing: ", 0), 0u) << failures[0];
+    EXPECT_EQ(z3y::GetService<IChainServiceA>("Static.A")->GetTotalValue(), 25);
+
+    const z3y::IPluginQuery& query = *manager_;
+    ComponentDetails details;
+    ASSERT_TRUE(query.GetComponentDetails(ChainServiceA::kClsid, details));
+    EXPECT_EQ(details.source_plugin_path, "static:static_chain");
+
+    failures = manager_->LoadStaticPlugins(kPlugins);
+    EXPECT_EQ(failures.size(), 1u) << "失败的静态插件可以重试";
+    EXPECT_EQ(g_static_entry_calls, 1) << "已加载的静态插件不再执行入口";
+
+    manager_->UnloadAllPlugins();
+    std::string err;
+    EXPECT_TRUE(manager_->LoadStaticPlugin(kPlugins[0], err)) << err;
+    EXPECT_EQ(g_static_entry_calls, 2) << "UnloadAllPlugins 之后可以重新加载";
+}
+
+/**
+ * @test 同模块直连路径
+ * @brief 验证 DirectPluginImpl 组件可正常经接口查找，GetLocalService 返回同一对象的
+ * 具体类型指针，未注册时返回 nullptr 而不抛出。
+ */
+TEST_F(ServiceLocatorTest, GetLocalService_ReturnsConcreteImplFromSameModule) {
+    EXPECT_EQ(z3y::GetLocalService<DirectChainServiceC>(), nullptr);
+
+    auto registry = dynamic_cast<z3y::IPluginRegistry*>(manager_.get());
+    ASSERT_NE(registry, nullptr);
+    z3y::RegisterService<DirectChainServiceC>(registry, "Direct.C", true);
+
+    auto by_interface = z3y::GetService<IChainServiceC>("Direct.C");
+    EXPECT_EQ(by_interface->GetValue(), 42);
+
+    auto local = z3y::GetLocalService<DirectChainServiceC>();
+    ASSERT_NE(local, nullptr);
+    EXPECT_EQ(static_cast<IChainServiceC*>(local.get()), by_interface.get());
+    EXPECT_EQ(local->GetValue(), 42);
+
+    // 伪 IID 不会被当成真正的接口暴露出去
+    InstanceError err = InstanceError::kSuccess;
+    EXPECT_EQ(by_interface->QueryInterfaceRaw(IChainServiceA::kIid, 1, 0, err), nullptr);
+}
+
+// =============================================================================
+// 11. 声明式事件处理函数 (Z3Y_EVENT_HANDLER)
+// =============================================================================
+
+namespace {
+    /** @brief 手动注册的组件：声明两个处理函数 (同一事件)。 */
+    class HandlerComponent : public z3y::PluginImpl<HandlerComponent, IDemoSimple> {
+    public:
+        Z3Y_DEFINE_COMPONENT_ID("z3y-test-event-handler-IMPL");
+        std::string GetSimpleString() override { return std::to_string(calls.load()); }
+        void OnFirst(const DemoGlobalEvent&) { calls.fetch_add(1); }
+        void OnSecond(const DemoGlobalEvent&) { calls.fetch_add(10); }
+        std::atomic<int> calls{ 0 };
+    };
+}
+
+/**
+ * @test 声明式事件处理函数
+ * @brief 验证插件以 Z3Y_EVENT_HANDLER 声明的处理函数随每个实例创建自动订阅、随实例释放失效，
+ * 并出现在 ComponentDetails 中；手动注册的组件可追加处理函数，未注册的 ClassId 被拒绝。
+ */
+TEST_F(ServiceLocatorTest, EventHandler_SubscribesEachInstance) {
+    const z3y::IPluginQuery& query = *manager_;
+    ComponentDetails details;
+    ASSERT_TRUE(query.GetComponentDetails(z3y::ConstexprHash("z3y-demo-DemoSimpleImplB-UUID-B6ED7068"), details));
+    ASSERT_EQ(details.event_handlers.size(), 1u);
+    EXPECT_EQ(details.event_handlers[0].event_id, DemoGlobalEvent::kEventId);
+    EXPECT_EQ(details.event_handlers[0].event_name, "DemoGlobalEvent");
+    EXPECT_EQ(details.event_handlers[0].connection_type, ConnectionType::kDirect);
+
+    // 1. 插件中声明的处理函数：每个实例各自订阅
+    auto b1 = z3y::CreateInstance<IDemoSimple>("Demo.Simple.B");
+    auto b2 = z3y::CreateInstance<IDemoSimple>("Demo.Simple.B");
+    manager_->FireGlobal<DemoGlobalEvent>("tick");
+    EXPECT_EQ(b1->GetSimpleString(), "Hello from DemoSimpleImplB (global events: 1)");
+    b2.reset();
+    manager_->FireGlobal<DemoGlobalEvent>("tick");
+    EXPECT_EQ(b1->GetSimpleString(), "Hello from DemoSimpleImplB (global events: 2)");
+
+    // 2. 手动注册后追加：同一事件的两个处理函数按声明顺序都被调用，已存在的实例不受影响
+    auto registry = dynamic_cast<z3y::IPluginRegistry*>(manager_.get());
+    ASSERT_NE(registry, nullptr);
+    z3y::RegisterComponent<HandlerComponent>(registry, "Test.Handler");
+    auto before = z3y::CreateInstance<IDemoSimple>("Test.Handler");
+    static constexpr z3y::EventHandlerEntry kFirst = z3y::internal::MakeEventHandler<HandlerComponent,
+        DemoGlobalEvent, &HandlerComponent::OnFirst>(ConnectionType::kDirect);
+    static constexpr z3y::EventHandlerEntry kSecond = z3y::internal::MakeEventHandler<HandlerComponent,
+        DemoGlobalEvent, &HandlerComponent::OnSecond>(ConnectionType::kDirect);
+    registry->RegisterEventHandler(HandlerComponent::kClsid, kFirst);
+    registry->RegisterEventHandler(HandlerComponent::kClsid, kSecond);
+    ASSERT_TRUE(query.GetComponentDetails(HandlerComponent::kClsid, details));
+    EXPECT_EQ(details.event_handlers.size(), 2u);
+
+    auto after = z3y::CreateInstance<IDemoSimple>("Test.Handler");
+    manager_->FireGlobal<DemoGlobalEvent>("tick");
+    EXPECT_EQ(before->GetSimpleString(), "0");
+    EXPECT_EQ(after->GetSimpleString(), "11");
+
+    EXPECT_THROW(registry->RegisterEventHandler(z3y::ConstexprHash("z3y-test-missing"), kFirst), std::runtime_error);
+}
+
+// =============================================================================
+// 12. 单例热状态检查点 (ICheckpointable)
+// =============================================================================
+
+namespace {
+    class ICheckpointCounter : public virtual z3y::IComponent {
+    public:
+        Z3Y_DEFINE_INTERFACE(ICheckpointCounter, "z3y-test-ICheckpointCounter-IID", 1, 0);
+        virtual int GetCount() = 0;
+        virtual void Add(int n) = 0;
+        virtual bool InitializedFromCheckpoint() = 0;
+    };
+
+    std::atomic<uint32_t> g_counter_state_version{ 1 };
+
+    /** @brief 手动注册的单例：计数值作为热状态保存。 */
+    class CheckpointCounter : public z3y::PluginImpl<CheckpointCounter, ICheckpointCounter, z3y::ICheckpointable> {
+    public:
+        Z3Y_DEFINE_COMPONENT_ID("z3y-test-checkpoint-counter-IMPL");
+        int GetCount() override { return count_; }
+        void Add(int n) override { count_ += n; }
+        bool InitializedFromCheckpoint() override { return warm_at_initialize_; }
+        void Initialize() override { warm_at_initialize_ = restored_; }
+
+        uint32_t GetCheckpointVersion() const override { return g_counter_state_version.load(); }
+        bool SaveCheckpoint(std::vector<uint8_t>& out) override {
+            out.resize(sizeof(count_));
+            std::memcpy(out.data(), &count_, sizeof(count_));
+            return true;
+        }
+        bool RestoreCheckpoint(const uint8_t* data, size_t size) override {
+            if (size != sizeof(count_)) return false;
+            std::memcpy(&count_, data, sizeof(count_));
+            restored_ = true;
+            return true;
+        }
+
+    private:
+        int count_ = 0;
+        bool restored_ = false;
+        bool warm_at_initialize_ = false;
+    };
+}
+
+/**
+ * @test 单例热状态检查点
+ * @brief 验证实现 ICheckpointable 的单例在 Shutdown 前保存状态、下次构造时在 Initialize 之前恢复；
+ * 状态版本变化后旧检查点被删除，服务冷启动。
+ */
+TEST_F(ServiceLocatorTest, Checkpoint_RestoresWarmStateBeforeInitialize) {
+    const std::filesystem::path dir = std::filesystem::temp_directory_path() / "z3y_checkpoint_test";
+    std::filesystem::remove_all(dir);
+    manager_->SetCheckpointDirectory(dir);
+    g_counter_state_version = 1;
+    auto register_counter = [this]() {
+        auto registry = dynamic_cast<z3y::IPluginRegistry*>(manager_.get());
+        ASSERT_NE(registry, nullptr);
+        z3y::RegisterService<CheckpointCounter>(registry, "Test.CheckpointCounter");
+    };
+
+    // 1. 冷启动：没有检查点
+    register_counter();
+    auto counter = z3y::GetService<ICheckpointCounter>("Test.CheckpointCounter");
+    EXPECT_FALSE(counter->InitializedFromCheckpoint());
+    counter->Add(42);
+    counter.reset();
+
+    // 2. 卸载时保存；重新注册后首次构造即恢复 (Initialize 已看到恢复的状态)
+    manager_->UnloadAllPlugins();
+    bool has_checkpoint_file = false;
+    for (const auto& entry : std::filesystem::directory_iterator(dir)) {
+        has_checkpoint_file |= entry.path().extension() == ".z3yckpt";
+    }
+    EXPECT_TRUE(has_checkpoint_file);
+    register_counter();
+    counter = z3y::GetService<ICheckpointCounter>("Test.CheckpointCounter");
+    EXPECT_TRUE(counter->InitializedFromCheckpoint());
+    EXPECT_EQ(counter->GetCount(), 42);
+    counter.reset();
+
+    // 3. 状态版本变化：旧检查点被丢弃 (文件删除)，服务冷启动
+    manager_->UnloadAllPlugins();
+    g_counter_state_version = 2;
+    register_counter();
+    counter = z3y::GetService<ICheckpointCounter>("Test.CheckpointCounter");
+    EXPECT_FALSE(counter->InitializedFromCheckpoint());
+    EXPECT_EQ(counter->GetCount(), 0);
+    EXPECT_TRUE(std::filesystem::is_empty(dir));
+    counter.reset();
+
+    manager_->SetCheckpointDirectory({});
+    std::filesystem::remove_all(dir);
+}
+
+// =============================================================================
+// 13. 独立实例 (PluginManagerOptions::isolated)
+// =============================================================================
+
+/**
+ * @test 两条独立业务线与默认实例并存
+ * @brief 服务定位函数按线程绑定解析：独立实例的 Initialize、执行器线程与
+ * PluginManagerScope 绑定的线程都只看到自己实例的注册表。
+ */
+TEST_F(ServiceLocatorTest, IsolatedManagers_ResolveServicesPerLane) {
+    // 默认实例只再创建一次会失败；独立实例不受限制
+    EXPECT_THROW((void)z3y::PluginManager::Create(), std::runtime_error);
+    z3y::PluginManagerOptions options;
+    options.isolated = true;
+    auto lane_a = z3y::PluginManager::Create(options);
+    auto lane_b = z3y::PluginManager::Create(options);
+    ASSERT_TRUE(lane_a->IsIsolated());
+    EXPECT_FALSE(manager_->IsIsolated());
+    EXPECT_EQ(z3y::PluginManager::GetActiveInstance(), manager_);
+
+    // A: C=42 (DirectChainServiceC)，B 依赖 C；B: C=10；默认实例没有 C
+    z3y::RegisterService<DirectChainServiceC>(lane_a.get(), "Chain.C", true);
+    z3y::RegisterService<ChainServiceB>(lane_a.get(), "Chain.B", true);
+    z3y::RegisterService<ChainServiceC>(lane_b.get(), "Chain.C", true);
+
+    // 1. 在未绑定的线程上首次构造：B::Initialize 里的 GetDefaultService 解析到 lane_a
+    EXPECT_EQ(lane_a->GetDefaultService<IChainServiceB>()->GetValue(), 84);
+    EXPECT_NE(z3y::TryGetDefaultService<IChainServiceC>().second, InstanceError::kSuccess);
+
+    // 2. 独立实例的执行器线程绑定在它自己身上
+    auto executor = lane_a->GetService<z3y::IExecutorService>(z3y::clsid::kExecutor);
+    std::promise<int> from_executor;
+    ASSERT_TRUE(executor->Post([&from_executor] {
+        from_executor.set_value(z3y::GetDefaultService<IChainServiceC>()->GetValue());
+    }));
+    EXPECT_EQ(from_executor.get_future().get(), 42);
+
+    // 3. 业务线程用 PluginManagerScope 绑定；ServiceHandle 缓存随绑定切换
+    std::thread worker([&lane_b]() {
+        {
+            z3y::PluginManagerScope scope(lane_b);
+            EXPECT_EQ(z3y::PluginManager::GetActiveInstance(), lane_b);
+            EXPECT_EQ(z3y::GetDefaultService<IChainServiceC>()->GetValue(), 10);
+            IChainServiceC* cached = z3y::ServiceHandle<IChainServiceC>::TryGet();
+            ASSERT_NE(cached, nullptr);
+            EXPECT_EQ(cached->GetValue(), 10);
+        }
+        EXPECT_EQ(z3y::ServiceHandle<IChainServiceC>::TryGet(), nullptr);
+    });
+    worker.join();
+
+    // 4. 销毁独立实例：默认实例不受影响，仍绑定在已销毁实例上的线程得到空指针
+    std::weak_ptr<z3y::PluginManager> weak_a = lane_a;
+    executor.reset();
+    z3y::PluginManager::Destroy(lane_a);
+    EXPECT_EQ(lane_a, nullptr);
+    EXPECT_TRUE(weak_a.expired());
+    {
+        z3y::PluginManagerScope scope(weak_a);
+        EXPECT_EQ(z3y::PluginManager::GetActiveInstance(), nullptr);
+    }
+    z3y::PluginManager::Destroy(lane_b);
+    EXPECT_EQ(z3y::PluginManager::GetActiveInstance(), manager_);
+    EXPECT_NE(z3y::GetDefaultService<IDemoLogger>(), nullptr);
+}
+
+/**
+ * @test 切换线程绑定不影响其他线程的缓存
+ * @brief PluginManagerScope 与独立实例的临时绑定 (在未绑定线程上构造它的组件) 只改变本线程的
+ * 绑定编号，不递增全局服务代数；ServiceHandle 仍按绑定解析到各自实例的服务。
+ */
+TEST_F(ServiceLocatorTest, IsolatedManagers_BindingSwitchKeepsGeneration) {
+    z3y::PluginManagerOptions options;
+    options.isolated = true;
+    auto lane = z3y::PluginManager::Create(options);
+    z3y::RegisterService<DirectChainServiceC>(lane.get(), "Chain.C", true);
+    z3y::RegisterService<ChainServiceB>(lane.get(), "Chain.B", true);
+    z3y::RegisterService<ChainServiceC>(manager_.get(), "Chain.C", true);
+    ASSERT_EQ(z3y::ServiceHandle<IChainServiceC>::Get().GetValue(), 10);
+
+    const uint64_t generation = z3y::PluginManager::GetServiceGeneration().load();
+    EXPECT_EQ(z3y::PluginManager::GetThreadBindingId(), 0u);
+    // B::Initialize 在临时绑定到 lane 的本线程上运行
+    EXPECT_EQ(lane->GetDefaultService<IChainServiceB>()->GetValue(), 84);
+    {
+        z3y::PluginManagerScope scope(lane);
+        EXPECT_NE(z3y::PluginManager::GetThreadBindingId(), 0u);
+        EXPECT_EQ(z3y::ServiceHandle<IChainServiceC>::Get().GetValue(), 42);
+    }
+    EXPECT_EQ(z3y::PluginManager::GetThreadBindingId(), 0u);
+    EXPECT_EQ(z3y::ServiceHandle<IChainServiceC>::Get().GetValue(), 10);
+    EXPECT_EQ(z3y::PluginManager::GetServiceGeneration().load(), generation)
+        << "切换绑定不应让其他线程的 ServiceHandle 缓存失效";
+
+    z3y::PluginManager::Destroy(lane);
+}
@@ -28,16 +28,50 @@
  * 3. 宏调用安全性
  * 4. 动态调级 (SetLevel) 及其持久化特性
  * 5. 强制刷盘 (Flush)
+ * 6. 有效级别 (Sink 门槛 / 观察者) 的短路
+ * 7. 延迟格式化 (Z3Y_LOG_DEFERRED_*)
+ * 8. 具名线程池 (Rule / Sink 绑定)
+ * 9. 观察者的写时复制 (并发注册 / 注销)
+ * 10. 批量观察者 (AddLogBatchObserver)
+ * 11. GetLogger 的无锁缓存与 Rule 最长前缀匹配
+ * 12. 内存映射二进制 Sink (mmap_binary_sink) 的记录格式与分段滚动
+ * 13. 轮转文件的 LZ4 压缩 (归档压缩 / 活动段流式压缩)
+ * 14. 调用方限流 (Rule 的 rate_limit / SetRateLimit / 去重窗口)
+ * 15. 结构化日志 (文本渲染 / JSON Lines / 二进制字段 / 观察者字段)
+ * 16. 崩溃环 (子进程崩溃后，下次启动恢复最近的日志)
+ * 17. 网络 Sink (UDP GELF / TCP + LZ4 批量发送 / 收集端不可达时丢弃计数)
+ * 18. Rule 的投递方式 (sync / priority 绕过积压的异步队列)
+ * 19. 线程环入队后端 (async_backend = "thread_rings")
+ * 20. 合并写入的轮转文件 Sink (coalescing_file_sink)
  */
 
+#include <algorithm>
 #include <atomic>
+#include <mutex>
 #include <thread>
 #include <chrono>
+#include <map>
+#include <set>
+#include <vector>
 
 #include "common/plugin_test_base.h"
 #include "interfaces_core/i_log_service.h"
 #include "interfaces_core/z3y_log_macros.h" // 用于测试宏调用
+#include "plugin_spdlog_logger/lz4_frame.h"          // 解压归档
+#include "plugin_spdlog_logger/mmap_binary_format.h" // 解码二进制段
+#include <csignal>
+#include <cstdio>
+#include <cstring>
 #include <fstream> // 用于写入配置文件
+#include <nlohmann/json.hpp> // 解析 JSON Lines 输出
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
 
 #ifdef _WIN32
 #include <Windows.h>
@@ -209,6 +243,18 @@ TEST_F(SpdlogPluginTest, DynamicSetLevel_Persistence) {
     // "Business" 模块不匹配 "Network" 前缀，应该保持默认 (Info)，即 Trace 不可用
     auto logger_biz = log_mgr->GetLogger("Business.Order");
     EXPECT_FALSE(logger_biz->IsEnabled(LogLevel::Trace)) << "Other modules should not be affected";
+
+    // 6. [测试点 D] 更深的前缀只影响自己的子树
+    log_mgr->SetLevel("Network.Tcp", LogLevel::Info);
+    EXPECT_FALSE(logger_net->IsEnabled(LogLevel::Trace));
+    EXPECT_TRUE(logger_new->IsEnabled(LogLevel::Trace));
+
+    // 7. [测试点 E] 后设置的较短前缀 (按字符匹配，不要求在 '.' 处断开) 覆盖子树里更早的覆写，
+    // 对已有与之后创建的 Logger 都成立
+    log_mgr->SetLevel("Net", LogLevel::Trace);
+    EXPECT_TRUE(logger_net->IsEnabled(LogLevel::Trace)) << "Later shorter prefix wins";
+    EXPECT_TRUE(log_mgr->GetLogger("Network.Tcp.Session")->IsEnabled(LogLevel::Trace));
+    EXPECT_FALSE(logger_biz->IsEnabled(LogLevel::Trace));
 }
 
 /**
@@ -348,6 +394,9 @@ TEST_F(SpdlogPluginTest, UIObserver_ReceivesCompleteLogRecord) {
   // 用于将异步回调中的数据提取到主线程进行断言
   struct ExtractedData {
     uint32_t struct_size = 0;
+    uint32_t version = 0;
+    uint32_t logger_name_length = 0;
+    uint32_t message_length = 0;
     std::string logger_name;
     std::string message;
     std::string file_name;
@@ -363,6 +412,9 @@ TEST_F(SpdlogPluginTest, UIObserver_ReceivesCompleteLogRecord) {
   log_mgr->AddLogObserver("TestUI", [&](const LogRecord& record) {
     // [极其重要的演示] UI 拿到指针后，必须立刻深拷贝为 std::string!
     captured.struct_size = record.struct_size;
+    captured.version = record.version;
+    captured.logger_name_length = record.logger_name_length;
+    captured.message_length = record.message_length;
     captured.logger_name = record.logger_name;
     captured.message = record.message;
     captured.file_name = record.file_name;
@@ -394,6 +446,9 @@ TEST_F(SpdlogPluginTest, UIObserver_ReceivesCompleteLogRecord) {
 
   // 验证 ABI 防御机制 (struct_size 必须严格等于 sizeof(LogRecord))
   EXPECT_EQ(captured.struct_size, sizeof(LogRecord));
+  EXPECT_GE(captured.version, 2u);
+  EXPECT_EQ(captured.logger_name_length, captured.logger_name.size());
+  EXPECT_EQ(captured.message_length, captured.message.size());
 
   // 验证内容透传完整性
   EXPECT_EQ(captured.level, LogLevel::Error);
@@ -452,3 +507,1265 @@ TEST_F(SpdlogPluginTest, UIObserver_RemoveStopsCallback) {
   EXPECT_EQ(call_count.load(), 1)
       << "Callback count should not increase after removal";
 }
+
+/**
+ * @test 验证有效级别：没有任何 Sink 接收的级别在 IsEnabled 处即被拦截
+ * @brief Sink 为 Info 时 Debug 不应开启；注册观察者后放开，注销后恢复。
+ */
+TEST_F(SpdlogPluginTest, EffectiveLevel_FollowsSinksAndObservers) {
+  auto log_mgr = z3y::GetDefaultService<ILogManagerService>();
+
+  const char* config_content = R"({
+      "global_settings": { "format_pattern": "%v" },
+      "sinks": {
+          "info_file": {
+              "type": "rotating_file_sink",
+              "base_name": "effective_level_test.log",
+              "level": "info"
+          }
+      },
+      "default_rule": { "sinks": ["info_file"] }
+  })";
+  std::filesystem::path config_path = bin_dir_ / "effective_level_config.json";
+  {
+    std::ofstream out(config_path);
+    out << config_content;
+  }
+  ASSERT_TRUE(log_mgr->InitializeService(
+      z3y::utils::PathToUtf8(config_path),
+      z3y::utils::PathToUtf8(bin_dir_ / "logs")));
+
+  auto logger = log_mgr->GetLogger("Vision.Grabber");
+  EXPECT_TRUE(logger->IsEnabled(LogLevel::Info));
+  EXPECT_FALSE(logger->IsEnabled(LogLevel::Debug))
+      << "No sink accepts Debug, IsEnabled must short-circuit";
+
+  // SetLevel 只能收紧，不能低于 Sink 门槛
+  log_mgr->SetLevel("Vision", LogLevel::Trace);
+  EXPECT_FALSE(logger->IsEnabled(LogLevel::Trace));
+  log_mgr->SetLevel("Vision", LogLevel::Warn);
+  EXPECT_FALSE(logger->IsEnabled(LogLevel::Info));
+  log_mgr->SetLevel("Vision", LogLevel::Trace);
+
+  // 观察者接收全部级别：注册后放开，新旧 Logger 都生效
+  std::atomic<int> debug_count{0};
+  log_mgr->AddLogObserver("LevelUI", [&](const LogRecord& record) {
+    if (record.level == LogLevel::Debug) debug_count++;
+  });
+  EXPECT_TRUE(logger->IsEnabled(LogLevel::Trace));
+  EXPECT_TRUE(log_mgr->GetLogger("Vision.Other")->IsEnabled(LogLevel::Debug));
+
+  Z3Y_LOG_DEBUG(logger, "debug for observer");
+  log_mgr->Flush();
+  for (int i = 0; i < 100 && debug_count.load() == 0; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_EQ(debug_count.load(), 1);
+
+  // 注销后恢复到 Sink 门槛
+  log_mgr->RemoveLogObserver("LevelUI");
+  EXPECT_FALSE(logger->IsEnabled(LogLevel::Debug));
+}
+
+/**
+ * @test 验证延迟格式化：参数在调用时拷贝，后台格式化结果与 fmt 一致
+ * @brief 临时字符串在调用返回后即销毁，Flush 后观察者应收到完整文本与调用线程的 ID。
+ */
+TEST_F(SpdlogPluginTest, DeferredLog_FormatsOnBackendWithCallerContext) {
+  auto log_mgr = z3y::GetDefaultService<ILogManagerService>();
+  std::string config_file = GenerateTestConfig();
+  ASSERT_TRUE(log_mgr->InitializeService(
+      z3y::utils::PathToUtf8((bin_dir_ / config_file).string()),
+      z3y::utils::PathToUtf8((bin_dir_ / "logs").string())));
+
+  auto logger = log_mgr->GetLogger("Vision.Deferred");
+
+  std::mutex mutex;
+  std::vector<std::string> messages;
+  std::vector<uint32_t> thread_ids;
+  log_mgr->AddLogObserver("DeferredUI", [&](const LogRecord& record) {
+    std::lock_guard<std::mutex> lock(mutex);
+    messages.emplace_back(record.message);
+    thread_ids.push_back(record.thread_id);
+  });
+
+  enum class Mode { Fast = 7 };
+  {
+    std::string cam = "cam_01";
+    Z3Y_LOG_DEFERRED_INFO(logger, "frame={} score={:.2f} cam={} ok={} c={} mode={} name={}",
+                          42, 0.125, cam, true, 'x', Mode::Fast,
+                          std::string_view("view"));
+    cam.assign("overwritten");
+  }
+  Z3Y_LOG_DEFERRED_WARN(logger, "no args");
+  Z3Y_LOG_DEFERRED_ERROR(logger, "bad {} {}", 1);  // 参数不足：不崩溃，输出原始格式串
+  Z3Y_LOG_INFO(logger, "sync reference");          // 调用线程 ID 的参照
+
+  // 多线程并发提交，条数与内容都不应丢失或串行
+  constexpr int kThreads = 4;
+  constexpr int kPerThread = 500;
+  std::vector<std::thread> workers;
+  for (int t = 0; t < kThreads; ++t) {
+    workers.emplace_back([&, t] {
+      for (int i = 0; i < kPerThread; ++i) {
+        Z3Y_LOG_DEFERRED_DEBUG(logger, "worker {} seq {}", t, i);
+      }
+    });
+  }
+  for (auto& w : workers) w.join();
+
+  log_mgr->Flush();
+  for (int i = 0; i < 100; ++i) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (messages.size() >= 4 + kThreads * kPerThread) break;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  log_mgr->RemoveLogObserver("DeferredUI");
+
+  std::lock_guard<std::mutex> lock(mutex);
+  ASSERT_EQ(messages.size(), 4u + kThreads * kPerThread);
+
+  auto find = [&](const std::string& text) {
+    return std::find(messages.begin(), messages.end(), text) - messages.begin();
+  };
+  const auto formatted =
+      find("frame=42 score=0.12 cam=cam_01 ok=true c=x mode=7 name=view");
+  ASSERT_LT(formatted, static_cast<ptrdiff_t>(messages.size()));
+  EXPECT_LT(find("no args"), static_cast<ptrdiff_t>(messages.size()));
+  const auto sync = find("sync reference");
+  ASSERT_LT(sync, static_cast<ptrdiff_t>(messages.size()));
+  EXPECT_EQ(thread_ids[formatted], thread_ids[sync])
+      << "Deferred records must keep the caller's thread id";
+
+  bool saw_format_error = false;
+  for (const auto& m : messages) {
+    saw_format_error |= m.find("[format error") != std::string::npos &&
+                        m.find("bad {} {}") != std::string::npos;
+  }
+  EXPECT_TRUE(saw_format_error);
+
+  for (int t = 0; t < kThreads; ++t) {
+    EXPECT_LT(find(fmt::format("worker {} seq {}", t, kPerThread - 1)),
+              static_cast<ptrdiff_t>(messages.size()));
+  }
+}
+
+/**
+ * @test 验证未初始化时的延迟格式化 (Fallback Logger 在调用线程同步格式化)
+ */
+TEST_F(SpdlogPluginTest, DeferredLog_FallbackFormatsSynchronously) {
+  auto log_mgr = z3y::GetDefaultService<ILogManagerService>();
+  auto logger = log_mgr->GetLogger("Test.DeferredFallback");
+  ASSERT_NE(logger, nullptr);
+  Z3Y_LOG_DEFERRED_ERROR(logger, "fallback deferred {}", 1);
+}
+
+/**
+ * @test 验证具名线程池：绑定到独立线程池的 Rule / Sink 都能正常落盘
+ * @brief 一个 Sink 绑定专属线程池，一个 Rule 绑定另一个线程池；引用未定义线程池时初始化失败。
+ */
+TEST_F(SpdlogPluginTest, ThreadPools_PinnedSinksAndRulesDeliver) {
+  auto log_mgr = z3y::GetDefaultService<ILogManagerService>();
+
+  std::filesystem::path log_dir = bin_dir_ / "logs";
+  std::filesystem::remove(log_dir / "pool_main.log");
+  std::filesystem::remove(log_dir / "pool_device.log");
+
+  const char* config_content = R"({
+      "global_settings": { "format_pattern": "%n|%v", "async_thread_count": 2, "flush_on_level": "off" },
+      "thread_pools": {
+          "device_pool": { "threads": 1, "queue_size": 1024 },
+          "vision_pool": { "threads": 1 }
+      },
+      "sinks": {
+          "main_file":   { "type": "rotating_file_sink", "base_name": "pool_main.log", "level": "info" },
+          "device_file": { "type": "rotating_file_sink", "base_name": "pool_device.log",
+                           "level": "info", "thread_pool": "device_pool" }
+      },
+      "rules": [ { "matcher": "Vision", "sinks": ["device_file"], "thread_pool": "vision_pool" } ],
+      "default_rule": { "sinks": ["main_file", "device_file"] }
+  })";
+  std::filesystem::path config_path = bin_dir_ / "thread_pool_config.json";
+  {
+    std::ofstream out(config_path);
+    out << config_content;
+  }
+  ASSERT_TRUE(log_mgr->InitializeService(z3y::utils::PathToUtf8(config_path),
+                                         z3y::utils::PathToUtf8(log_dir)));
+
+  auto sys = log_mgr->GetLogger("System.Core");
+  auto vision = log_mgr->GetLogger("Vision.Grab");
+  // 专属线程池上的 Sink 仍参与有效级别计算
+  EXPECT_FALSE(sys->IsEnabled(LogLevel::Debug));
+  EXPECT_TRUE(vision->IsEnabled(LogLevel::Info));
+
+  Z3Y_LOG_INFO(sys, "sys message");
+  Z3Y_LOG_INFO(vision, "vision message");
+  Z3Y_LOG_DEFERRED_INFO(vision, "vision deferred {}", 7);
+
+  auto read_all = [](const std::filesystem::path& p) {
+    std::ifstream f(p);
+    return std::string((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+  };
+  std::string main_text, device_text;
+  for (int i = 0; i < 100; ++i) {
+    log_mgr->Flush();  // 刷盘请求沿 Logger 线程池 -> 设备线程池传递，轮询等待
+    main_text = read_all(log_dir / "pool_main.log");
+    device_text = read_all(log_dir / "pool_device.log");
+    if (main_text.find("sys message") != std::string::npos &&
+        device_text.find("Vision.Grab|vision deferred 7") != std::string::npos &&
+        device_text.find("Vision.Grab|vision message") != std::string::npos &&
+        device_text.find("System.Core|sys message") != std::string::npos) {
+      break;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  }
+  EXPECT_NE(main_text.find("System.Core|sys message"), std::string::npos);
+  EXPECT_EQ(main_text.find("vision"), std::string::npos)
+      << "Vision rule routes only to device_file";
+  EXPECT_NE(device_text.find("System.Core|sys message"), std::string::npos)
+      << "Pinned sink must keep the original logger name";
+  EXPECT_NE(device_text.find("Vision.Grab|vision message"), std::string::npos);
+  EXPECT_NE(device_text.find("Vision.Grab|vision deferred 7"), std::string::npos);
+}
+
+/**
+ * @test 验证引用未定义的线程池时初始化失败
+ */
+TEST_F(SpdlogPluginTest, ThreadPools_UndefinedPoolFailsInit) {
+  auto log_mgr = z3y::GetDefaultService<ILogManagerService>();
+  std::filesystem::path config_path = bin_dir_ / "bad_pool_config.json";
+  {
+    std::ofstream out(config_path);
+    out << R"({ "sinks": { "f": { "type": "rotating_file_sink", "base_name": "bad_pool.log",
+                                   "thread_pool": "missing" } },
+                 "default_rule": { "sinks": ["f"] } })";
+  }
+  EXPECT_FALSE(log_mgr->InitializeService(z3y::utils::PathToUtf8(config_path),
+                                          z3y::utils::PathToUtf8(bin_dir_ / "logs")));
+}
+
+/**
+ * @test 验证观察者表写时复制：日志线程持续写入时反复注册 / 注销，不死锁、不丢失已注册观察者
+ * @brief 注销返回后回调不再被调用 (等待旧快照上的回调结束)。
+ */
+TEST_F(SpdlogPluginTest, UIObserver_ChurnWhileLogging) {
+  auto log_mgr = z3y::GetDefaultService<ILogManagerService>();
+  // 只写文件：写入线程会产生大量日志，不输出到控制台
+  std::filesystem::path config_path = bin_dir_ / "observer_churn_config.json";
+  {
+    std::ofstream out(config_path);
+    out << R"({ "sinks": { "f": { "type": "rotating_file_sink", "base_name": "observer_churn.log",
+                                   "max_size": 1048576, "max_files": 1, "level": "info" } },
+                 "default_rule": { "sinks": ["f"] } })";
+  }
+  ASSERT_TRUE(log_mgr->InitializeService(z3y::utils::PathToUtf8(config_path),
+                                         z3y::utils::PathToUtf8(bin_dir_ / "logs")));
+  auto logger = log_mgr->GetLogger("Observer.Churn");
+
+  std::atomic<int> stable_calls{0};
+  log_mgr->AddLogObserver("Stable", [&](const LogRecord&) { stable_calls++; });
+
+  std::atomic<bool> stop{false};
+  std::thread writer([&] {
+    while (!stop.load()) Z3Y_LOG_DEFERRED_ERROR(logger, "churn {}", 1);
+  });
+
+  for (int i = 0; i < 200; ++i) {
+    auto alive = std::make_shared<std::atomic<int>>(0);
+    log_mgr->AddLogObserver("Temp", [alive](const LogRecord&) { (*alive)++; });
+    log_mgr->RemoveLogObserver("Temp");
+    const int after_remove = alive->load();
+    std::this_thread::sleep_for(std::chrono::microseconds(50));
+    EXPECT_EQ(alive->load(), after_remove) << "callback ran after RemoveLogObserver returned";
+  }
+  stop = true;
+  writer.join();
+  log_mgr->Flush();
+
+  EXPECT_GT(stable_calls.load(), 0);
+  log_mgr->RemoveLogObserver("Stable");
+  const int final_calls = stable_calls.load();
+  Z3Y_LOG_ERROR(logger, "after removal");
+  log_mgr->Flush();
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_EQ(stable_calls.load(), final_calls);
+}
+
+/**
+ * @test 验证批量观察者：按 max_batch 攒批投递，内容完整，注销时投递剩余记录
+ */
+TEST_F(SpdlogPluginTest, BatchObserver_DeliversBatchesAndDrainsOnRemove) {
+  auto log_mgr = z3y::GetDefaultService<ILogManagerService>();
+  std::filesystem::path config_path = bin_dir_ / "batch_observer_config.json";
+  {
+    std::ofstream out(config_path);
+    out << R"({ "sinks": { "f": { "type": "rotating_file_sink", "base_name": "batch_observer.log",
+                                   "max_size": 1048576, "max_files": 1, "level": "info" } },
+                 "default_rule": { "sinks": ["f"] } })";
+  }
+  ASSERT_TRUE(log_mgr->InitializeService(z3y::utils::PathToUtf8(config_path),
+                                         z3y::utils::PathToUtf8(bin_dir_ / "logs")));
+  auto logger = log_mgr->GetLogger("Viewer.Source");
+
+  std::mutex mutex;
+  std::vector<std::string> messages;
+  std::vector<uint64_t> batch_sizes;
+  uint64_t dropped = 0;
+  bool names_ok = true;
+
+  LogBatchOptions options;
+  options.interval_ms = 10000;  // 只靠 max_batch 与注销触发投递
+  options.max_batch = 16;
+  options.capacity = 64;
+  log_mgr->AddLogBatchObserver("Viewer", [&](const LogBatch& batch) {
+    std::lock_guard<std::mutex> lock(mutex);
+    EXPECT_EQ(batch.struct_size, sizeof(LogBatch));
+    batch_sizes.push_back(batch.count);
+    dropped += batch.dropped;
+    for (uint64_t i = 0; i < batch.count; ++i) {
+      const LogRecord& r = batch.records[i];
+      names_ok &= std::string(r.logger_name) == "Viewer.Source" &&
+                  std::string(r.file_name).find("test_spdlog_plugin.cpp") != std::string::npos;
+      messages.emplace_back(r.message, r.message_length);
+    }
+  }, options);
+  // 批量观察者同样放开有效级别
+  EXPECT_TRUE(logger->IsEnabled(LogLevel::Debug));
+
+  for (int i = 0; i < 40; ++i) Z3Y_LOG_INFO(logger, "line {}", i);
+  log_mgr->Flush();
+  for (int i = 0; i < 200; ++i) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (messages.size() >= 32) break;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    ASSERT_GE(messages.size(), 32u) << "two full batches should be delivered by size";
+    for (uint64_t n : batch_sizes) EXPECT_LE(n, options.max_batch);
+  }
+
+  // 注销：剩余不足一批的记录也要投递，之后不再回调
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));  // 等后台线程写完剩余日志
+  log_mgr->RemoveLogObserver("Viewer");
+  std::lock_guard<std::mutex> lock(mutex);
+  EXPECT_EQ(messages.size() + dropped, 40u);
+  EXPECT_EQ(dropped, 0u);
+  EXPECT_TRUE(names_ok);
+  for (size_t i = 0; i < messages.size(); ++i) {
+    EXPECT_EQ(messages[i], "line " + std::to_string(i));
+  }
+  EXPECT_FALSE(logger->IsEnabled(LogLevel::Debug));
+}
+
+/**
+ * @test 验证 GetLogger：Rule 按最长前缀匹配；并发获取同名 Logger 得到同一实例 (跨越查找表扩容)
+ */
+TEST_F(SpdlogPluginTest, GetLogger_LongestRuleAndConcurrentCache) {
+  auto log_mgr = z3y::GetDefaultService<ILogManagerService>();
+  std::filesystem::path config_path = bin_dir_ / "logger_lookup_config.json";
+  {
+    std::ofstream out(config_path);
+    out << R"({ "sinks": {
+                  "base":   { "type": "rotating_file_sink", "base_name": "lookup_base.log",
+                              "max_size": 1048576, "max_files": 1, "level": "error" },
+                  "algo":   { "type": "rotating_file_sink", "base_name": "lookup_algo.log",
+                              "max_size": 1048576, "max_files": 1, "level": "info" },
+                  "vision": { "type": "rotating_file_sink", "base_name": "lookup_vision.log",
+                              "max_size": 1048576, "max_files": 1, "level": "warn" } },
+                "rules": [ { "matcher": "Algo", "sinks": ["algo"] },
+                           { "matcher": "Algo.Vision", "sinks": ["vision"] } ],
+                "default_rule": { "sinks": ["base"] } })";
+  }
+  ASSERT_TRUE(log_mgr->InitializeService(z3y::utils::PathToUtf8(config_path),
+                                         z3y::utils::PathToUtf8(bin_dir_ / "logs")));
+
+  // 有效级别跟随所匹配 Rule 的 Sink 级别
+  EXPECT_TRUE(log_mgr->GetLogger("Algo.Other")->IsEnabled(LogLevel::Info));
+  EXPECT_FALSE(log_mgr->GetLogger("Algo.Vision.Grab")->IsEnabled(LogLevel::Info));
+  EXPECT_TRUE(log_mgr->GetLogger("Algo.Vision.Grab")->IsEnabled(LogLevel::Warn));
+  EXPECT_FALSE(log_mgr->GetLogger("Alg")->IsEnabled(LogLevel::Warn));  // 走 default_rule
+
+  constexpr int kNames = 600;
+  constexpr int kThreads = 4;
+  std::vector<std::vector<ILogger*>> seen(kThreads, std::vector<ILogger*>(kNames));
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&, t] {
+      for (int i = 0; i < kNames; ++i) {
+        // 各线程按不同顺序访问，创建与无锁查找交错进行
+        const int n = (i * (t + 1) * 7) % kNames;
+        seen[t][n] = log_mgr->GetLogger("Job." + std::to_string(n)).get();
+      }
+    });
+  }
+  for (auto& th : threads) th.join();
+  for (int i = 0; i < kNames; ++i) {
+    ILogger* expected = log_mgr->GetLogger("Job." + std::to_string(i)).get();
+    ASSERT_NE(expected, nullptr);
+    for (int t = 0; t < kThreads; ++t) {
+      if (seen[t][i]) EXPECT_EQ(seen[t][i], expected) << "Job." << i;
+    }
+  }
+}
+
+/**
+ * @test 验证 mmap_binary_sink：记录无需 Flush 即可从映射文件解码，按 max_size 滚动并只保留 max_files 段
+ */
+TEST_F(SpdlogPluginTest, MmapBinarySink_DecodesAndRollsSegments) {
+  namespace binlog = z3y::plugins::log::binlog;
+  auto log_mgr = z3y::GetDefaultService<ILogManagerService>();
+  const std::filesystem::path log_dir = bin_dir_ / "logs" / "binlog_test";
+  std::filesystem::remove_all(log_dir);
+  std::filesystem::path config_path = bin_dir_ / "mmap_binary_config.json";
+  {
+    std::ofstream out(config_path);
+    out << R"({ "sinks": { "bin": { "type": "mmap_binary_sink", "base_name": "binlog_test/app.blog",
+                                     "max_size": 65536, "max_files": 2, "level": "debug" } },
+                 "default_rule": { "sinks": ["bin"] } })";
+  }
+  ASSERT_TRUE(log_mgr->InitializeService(z3y::utils::PathToUtf8(config_path),
+                                         z3y::utils::PathToUtf8(bin_dir_ / "logs")));
+  auto vision = log_mgr->GetLogger("Algorithm.Vision");
+  auto motion = log_mgr->GetLogger("Algorithm.Motion");
+
+  constexpr int kCount = 3000;  // 约 190KB 记录，64KB 一段 -> 滚动多次
+  for (int i = 0; i < kCount; ++i) {
+    Z3Y_LOG_INFO(i % 2 ? motion : vision, "record {} payload", i);
+  }
+  Z3Y_LOG_TRACE(vision, "below sink level");
+
+  struct Decoded {
+    uint64_t sequence;
+    std::vector<std::pair<std::string, std::string>> records;
+  };
+  auto decode_all = [&] {
+    std::vector<Decoded> segments;
+    for (const auto& entry : std::filesystem::directory_iterator(log_dir)) {
+      std::ifstream f(entry.path(), std::ios::binary);
+      std::string bytes((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+      if (!binlog::IsSegment(bytes.data(), bytes.size())) continue;
+      Decoded d;
+      d.sequence = reinterpret_cast<const binlog::FileHeader*>(bytes.data())->sequence;
+      binlog::ForEachRecord(bytes.data(), bytes.size(),
+                            [&](const binlog::RecordHeader& r, std::string_view name,
+                                std::string_view msg) {
+                              EXPECT_EQ(r.level, 2u);  // info
+                              d.records.emplace_back(std::string(name), std::string(msg));
+                            });
+      segments.push_back(std::move(d));
+    }
+    std::sort(segments.begin(), segments.end(),
+              [](const Decoded& a, const Decoded& b) { return a.sequence < b.sequence; });
+    return segments;
+  };
+
+  // 不调用 Flush：只等异步线程把记录写进映射区
+  std::vector<Decoded> segments;
+  for (int i = 0; i < 200; ++i) {
+    segments = decode_all();
+    if (!segments.empty() && !segments.back().records.empty() &&
+        segments.back().records.back().second ==
+            "record " + std::to_string(kCount - 1) + " payload") {
+      break;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  ASSERT_EQ(segments.size(), 2u) << "only max_files segments are kept";
+  EXPECT_EQ(segments[1].sequence, segments[0].sequence + 1);
+  EXPECT_GT(segments[0].sequence, 1u) << "older segments were rolled away";
+
+  // 保留的两段内记录连续、名字按段字典正确还原
+  int expected = -1;
+  for (const auto& segment : segments) {
+    for (const auto& [name, message] : segment.records) {
+      const int index = std::stoi(message.substr(7));
+      if (expected >= 0) EXPECT_EQ(index, expected);
+      expected = index + 1;
+      EXPECT_EQ(name, index % 2 ? "Algorithm.Motion" : "Algorithm.Vision");
+      EXPECT_EQ(message, "record " + std::to_string(index) + " payload");
+    }
+  }
+  EXPECT_EQ(expected, kCount);
+}
+
+/**
+ * @test 验证 rotating_file_sink 的 LZ4 压缩：滚动出的段在后台压缩为可解压的帧，只保留 max_files 个；
+ * compress_active 时活动段本身就是 LZ4 帧，Flush 后可解出全部内容
+ */
+TEST_F(SpdlogPluginTest, CompressedRotatingSink_ArchivesAndActiveStream) {
+  namespace lz4 = z3y::plugins::log::lz4;
+  auto log_mgr = z3y::GetDefaultService<ILogManagerService>();
+  const std::filesystem::path log_dir = bin_dir_ / "logs" / "lz4_test";
+  std::filesystem::remove_all(log_dir);
+  std::filesystem::path config_path = bin_dir_ / "lz4_sink_config.json";
+  {
+    std::ofstream out(config_path);
+    out << R"({ "global_settings": { "format_pattern": "%n|%v" },
+                "sinks": {
+                  "rolled": { "type": "rotating_file_sink", "base_name": "lz4_test/rolled.log",
+                              "max_size": 8192, "max_files": 2, "level": "info",
+                              "compression": "lz4", "compression_level": 9,
+                              "compression_cpu_percent": 50 },
+                  "stream": { "type": "rotating_file_sink", "base_name": "lz4_test/stream.log",
+                              "max_size": 10485760, "max_files": 2, "level": "info",
+                              "compression": "lz4", "compress_active": true } },
+                "rules": [ { "matcher": "Rolled", "sinks": ["rolled"] },
+                           { "matcher": "Stream", "sinks": ["stream"] } ],
+                "default_rule": { "sinks": [] } })";
+  }
+  ASSERT_TRUE(log_mgr->InitializeService(z3y::utils::PathToUtf8(config_path),
+                                         z3y::utils::PathToUtf8(bin_dir_ / "logs")));
+  auto rolled = log_mgr->GetLogger("Rolled");
+  auto stream = log_mgr->GetLogger("Stream");
+  constexpr int kCount = 1500;  // 约 40KB 明文 -> rolled 滚动约 5 次
+  for (int i = 0; i < kCount; ++i) {
+    Z3Y_LOG_INFO(rolled, "line {:05}", i);
+    Z3Y_LOG_INFO(stream, "line {:05}", i);
+  }
+  log_mgr->Flush();
+
+  auto read_all = [](const std::filesystem::path& p) {
+    std::ifstream f(p, std::ios::binary);
+    return std::string((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+  };
+  auto has_pending = [&] {
+    for (const auto& e : std::filesystem::directory_iterator(log_dir)) {
+      if (e.path().extension() == ".pending") return true;
+    }
+    return false;
+  };
+  const std::string last_line = "line " + fmt::format("{:05}", kCount - 1) + "\n";
+  std::string archive1, archive2, active, stream_text;
+  for (int i = 0; i < 300; ++i) {
+    log_mgr->Flush();
+    archive1.clear();
+    archive2.clear();
+    stream_text.clear();
+    const bool ok1 = lz4::DecompressFrame(read_all(log_dir / "rolled.1.log.lz4"), archive1);
+    const bool ok2 = lz4::DecompressFrame(read_all(log_dir / "rolled.2.log.lz4"), archive2);
+    lz4::DecompressFrame(read_all(log_dir / "stream.log.lz4"), stream_text);
+    active = read_all(log_dir / "rolled.log");
+    if (ok1 && ok2 && !has_pending() && active.find("Rolled|" + last_line) != std::string::npos &&
+        stream_text.find("Stream|" + last_line) != std::string::npos) {
+      break;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_FALSE(std::filesystem::exists(log_dir / "rolled.3.log.lz4")) << "max_files = 2";
+
+  // 归档 2 -> 归档 1 -> 活动文件 首尾相接，每段不超过 max_size
+  const std::string joined = archive2 + archive1 + active;
+  ASSERT_FALSE(archive2.empty());
+  EXPECT_LE(archive1.size(), 8192u);
+  EXPECT_LT(read_all(log_dir / "rolled.1.log.lz4").size(), archive1.size() / 2)
+      << "repetitive log text should compress well";
+  const size_t first = joined.find("line ");
+  ASSERT_NE(first, std::string::npos);
+  int expected = std::stoi(joined.substr(first + 5, 5));
+  for (size_t pos = first; pos != std::string::npos; pos = joined.find("line ", pos + 1)) {
+    EXPECT_EQ(std::stoi(joined.substr(pos + 5, 5)), expected++);
+  }
+  EXPECT_EQ(expected, kCount);
+
+  // 流式压缩的活动段 (尚无 EndMark) 包含全部记录
+  std::string expected_stream;
+  for (int i = 0; i < kCount; ++i) expected_stream += fmt::format("Stream|line {:05}\n", i);
+  EXPECT_EQ(stream_text, expected_stream);
+}
+
+/**
+ * @test 验证限流：按调用点的令牌桶只放行 burst 条并补报丢弃条数；SetRateLimit 的去重窗口即时生效，可复位
+ */
+TEST_F(SpdlogPluginTest, RateLimit_TokenBucketDedupAndRuntimeOverride) {
+  auto log_mgr = z3y::GetDefaultService<ILogManagerService>();
+  std::filesystem::path config_path = bin_dir_ / "rate_limit_config.json";
+  {
+    std::ofstream out(config_path);
+    out << R"({ "sinks": { "f": { "type": "rotating_file_sink", "base_name": "rate_limit.log",
+                                   "max_size": 1048576, "max_files": 1, "level": "info" } },
+                 "rules": [ { "matcher": "Flood", "sinks": ["f"],
+                              "rate_limit": { "per_second": 10, "burst": 5, "per_call_site": true } } ],
+                 "default_rule": { "sinks": ["f"] } })";
+  }
+  ASSERT_TRUE(log_mgr->InitializeService(z3y::utils::PathToUtf8(config_path),
+                                         z3y::utils::PathToUtf8(bin_dir_ / "logs")));
+
+  std::mutex mutex;
+  std::map<std::string, std::vector<std::string>> messages;  // Logger 名字 -> 消息
+  log_mgr->AddLogObserver("RateLimit", [&](const LogRecord& r) {
+    std::lock_guard<std::mutex> lock(mutex);
+    messages[r.logger_name].emplace_back(r.message, r.message_length);
+  });
+  auto count_of = [&](const std::string& name) {
+    log_mgr->Flush();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    std::lock_guard<std::mutex> lock(mutex);
+    return messages[name].size();
+  };
+
+  // 1. 两个调用点各有自己的桶：各放行 burst 条 (循环若跨过 100ms 可能多补一个令牌)
+  auto flood = log_mgr->GetLogger("Flood.Sensor");
+  auto site_a = [&](const std::string& text) { Z3Y_LOG_INFO(flood, "site A {}", text); };
+  for (int i = 0; i < 1000; ++i) {
+    site_a(std::to_string(i));
+    Z3Y_LOG_WARN(flood, "site B {}", i);
+  }
+  const size_t admitted = count_of("Flood.Sensor");
+  EXPECT_GE(admitted, 10u);
+  EXPECT_LE(admitted, 16u);
+
+  // 2. 令牌恢复后放行的第一条之前补报此前丢弃的条数
+  std::this_thread::sleep_for(std::chrono::milliseconds(150));
+  site_a("after pause");
+  count_of("Flood.Sensor");
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    const auto& flood_messages = messages["Flood.Sensor"];
+    ASSERT_GE(flood_messages.size(), 2u);
+    EXPECT_EQ(flood_messages.back(), "site A after pause");
+    const std::string& notice = flood_messages[flood_messages.size() - 2];
+    EXPECT_NE(notice.find("[rate limit]"), std::string::npos) << notice;
+    EXPECT_NE(notice.find("suppressed from this call site"), std::string::npos) << notice;
+  }
+
+  // 3. 运行时去重：已创建与之后创建的 Logger 都生效，同一调用点 1s 内只放行一条
+  auto chatty = log_mgr->GetLogger("Chatty.A");
+  LogRateLimit dedup;
+  dedup.dedup_window_ms = 1000;
+  log_mgr->SetRateLimit("Chatty", dedup);
+  auto chatty_b = log_mgr->GetLogger("Chatty.B");
+  for (int i = 0; i < 100; ++i) {
+    Z3Y_LOG_INFO(chatty, "repeat {}", i);
+    Z3Y_LOG_INFO(chatty_b, "repeat {}", i);
+  }
+  EXPECT_EQ(count_of("Chatty.A"), 1u);
+  EXPECT_EQ(count_of("Chatty.B"), 1u);
+
+  // 4. 默认参数即不限流
+  log_mgr->SetRateLimit("Chatty", LogRateLimit{});
+  for (int i = 0; i < 100; ++i) Z3Y_LOG_INFO(chatty, "free {}", i);
+  EXPECT_EQ(count_of("Chatty.A"), 101u);
+  log_mgr->RemoveLogObserver("RateLimit");
+}
+
+/**
+ * @test 验证异步队列统计：容量按配置合计，Logger 缓存按名称计数，刷盘后积压归零，阻塞策略下不丢日志
+ */
+TEST_F(SpdlogPluginTest, QueueStats_ReportsCapacityAndDrains) {
+  auto log_mgr = z3y::GetDefaultService<ILogManagerService>();
+  std::filesystem::path config_path = bin_dir_ / "queue_stats_config.json";
+  {
+    std::ofstream out(config_path);
+    out << R"({ "global_settings": { "async_queue_size": 2048 },
+                 "thread_pools": { "stats_pool": { "threads": 1, "queue_size": 256 } },
+                 "sinks": { "f": { "type": "rotating_file_sink", "base_name": "queue_stats.log",
+                                   "level": "info", "thread_pool": "stats_pool" } },
+                 "default_rule": { "sinks": ["f"] } })";
+  }
+  ASSERT_TRUE(log_mgr->InitializeService(z3y::utils::PathToUtf8(config_path),
+                                         z3y::utils::PathToUtf8(bin_dir_ / "logs")));
+
+  LogQueueStats stats = log_mgr->GetQueueStats();
+  EXPECT_EQ(stats.pools, 2u);  // 全局线程池 + stats_pool
+  EXPECT_EQ(stats.capacity, 2048u + 256u);
+
+  // Logger 缓存按名称计数，重复获取同名 Logger 不增长
+  auto logger = log_mgr->GetLogger("QueueStats");
+  const uint64_t loggers = log_mgr->GetQueueStats().loggers;
+  EXPECT_EQ(loggers, stats.loggers + 1);
+  log_mgr->GetLogger("QueueStats");
+  EXPECT_EQ(log_mgr->GetQueueStats().loggers, loggers);
+
+  for (int i = 0; i < 500; ++i) Z3Y_LOG_INFO(logger, "message {}", i);
+  for (int i = 0; i < 100; ++i) {
+    log_mgr->Flush();
+    stats = log_mgr->GetQueueStats();
+    if (stats.queued == 0) break;
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_EQ(stats.queued, 0u);
+  EXPECT_EQ(stats.overrun, 0u);
+  EXPECT_EQ(stats.discarded, 0u);
+}
+
+/**
+ * @test 验证结构化日志：文本 Sink 得到渲染后的消息，JSON Sink 与二进制 Sink 保留字段的原始类型，
+ * 观察者从 LogRecord v3 读到字段；普通日志不带字段
+ */
+TEST_F(SpdlogPluginTest, StructuredLog_RendersTextAndKeepsTypedFields) {
+  namespace binlog = z3y::plugins::log::binlog;
+  auto log_mgr = z3y::GetDefaultService<ILogManagerService>();
+  const std::filesystem::path log_dir = bin_dir_ / "logs" / "structured_test";
+  std::filesystem::remove_all(log_dir);
+  std::filesystem::path config_path = bin_dir_ / "structured_log_config.json";
+  {
+    std::ofstream out(config_path);
+    out << R"({ "sinks": {
+                  "json": { "type": "rotating_file_sink", "base_name": "structured_test/app.jsonl",
+                            "format": "json", "level": "info" },
+                  "bin": { "type": "mmap_binary_sink", "base_name": "structured_test/app.blog",
+                           "level": "info" } },
+                "default_rule": { "sinks": ["json", "bin"] } })";
+  }
+  ASSERT_TRUE(log_mgr->InitializeService(z3y::utils::PathToUtf8(config_path),
+                                         z3y::utils::PathToUtf8(bin_dir_ / "logs")));
+  auto logger = log_mgr->GetLogger("Trade.Orders");
+
+  struct Seen {
+    std::string message;
+    std::string tmpl;
+    std::vector<std::pair<std::string, LogArgType>> fields;
+    std::string venue;
+  };
+  std::mutex mutex;
+  std::vector<Seen> seen;
+  log_mgr->AddLogObserver("StructuredUI", [&](const LogRecord& record) {
+    ASSERT_GE(record.version, 3u);
+    Seen s;
+    s.message.assign(record.message, record.message_length);
+    if (record.message_template) s.tmpl = record.message_template;
+    for (uint32_t i = 0; i < record.field_count; ++i) {
+      const LogField& f = record.fields[i];
+      s.fields.emplace_back(f.key, f.value.type);
+      if (f.value.type == LogArgType::String) s.venue.assign(f.value.str, f.value.size);
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    seen.push_back(std::move(s));
+  });
+
+  {
+    std::string venue = "XS\"HG";
+    Z3Y_LOG_STRUCTURED_INFO(logger, "order {order} filled at {price:.2f}",
+                            Z3Y_LOG_KV("order", 42), Z3Y_LOG_KV("price", 101.5),
+                            Z3Y_LOG_KV("venue", venue), Z3Y_LOG_KV("ok", true));
+    venue.assign("overwritten");
+  }
+  Z3Y_LOG_INFO(logger, "plain {}", 1);
+  log_mgr->Flush();
+  for (int i = 0; i < 200; ++i) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (seen.size() >= 2) break;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  log_mgr->RemoveLogObserver("StructuredUI");
+  log_mgr->Flush();
+
+  const std::string rendered = "order 42 filled at 101.50 venue=XS\"HG ok=true";
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    ASSERT_EQ(seen.size(), 2u);
+    const auto structured = std::find_if(seen.begin(), seen.end(),
+                                         [](const Seen& s) { return !s.fields.empty(); });
+    ASSERT_NE(structured, seen.end());
+    EXPECT_EQ(structured->message, rendered);
+    EXPECT_EQ(structured->tmpl, "order {order} filled at {price:.2f}");
+    ASSERT_EQ(structured->fields.size(), 4u);
+    EXPECT_EQ(structured->fields[0], std::make_pair(std::string("order"), LogArgType::Int64));
+    EXPECT_EQ(structured->fields[1], std::make_pair(std::string("price"), LogArgType::Double));
+    EXPECT_EQ(structured->fields[3], std::make_pair(std::string("ok"), LogArgType::Bool));
+    EXPECT_EQ(structured->venue, "XS\"HG");
+  }
+
+  // JSON Lines：字段保持原始类型
+  std::vector<nlohmann::json> lines;
+  {
+    std::ifstream in(log_dir / "app.jsonl");
+    for (std::string line; std::getline(in, line);) lines.push_back(nlohmann::json::parse(line));
+  }
+  ASSERT_EQ(lines.size(), 2u);
+  const auto& order = lines[0].contains("fields") ? lines[0] : lines[1];
+  const auto& plain = lines[0].contains("fields") ? lines[1] : lines[0];
+  EXPECT_EQ(order["msg"], rendered);
+  EXPECT_EQ(order["level"], "info");
+  EXPECT_EQ(order["logger"], "Trade.Orders");
+  EXPECT_EQ(order["fields"]["order"], 42);
+  EXPECT_EQ(order["fields"]["price"], 101.5);
+  EXPECT_EQ(order["fields"]["venue"], "XS\"HG");
+  EXPECT_EQ(order["fields"]["ok"], true);
+  EXPECT_EQ(plain["msg"], "plain 1");
+  EXPECT_FALSE(plain.contains("template"));
+
+  // 二进制段：字段区按类型解码
+  std::map<std::string, std::string> decoded;
+  size_t plain_records = 0;
+  for (const auto& entry : std::filesystem::directory_iterator(log_dir)) {
+    if (entry.path().extension() != ".blog") continue;
+    std::ifstream f(entry.path(), std::ios::binary);
+    std::string bytes((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+    binlog::ForEachRecord(
+        bytes.data(), bytes.size(),
+        [&](const binlog::RecordHeader&, std::string_view, std::string_view message,
+            std::string_view fields) {
+          if (fields.empty()) {
+            ++plain_records;
+            return;
+          }
+          EXPECT_EQ(message, rendered);
+          EXPECT_TRUE(binlog::ForEachField(
+              fields, [&](std::string_view key, binlog::FieldType type, uint64_t raw,
+                          std::string_view text) {
+                std::string value;
+                if (type == binlog::FieldType::kInt64) value = std::to_string(raw);
+                if (type == binlog::FieldType::kDouble) {
+                  double d;
+                  std::memcpy(&d, &raw, sizeof(d));
+                  value = std::to_string(d);
+                }
+                if (type == binlog::FieldType::kString) value = text;
+                if (type == binlog::FieldType::kBool) value = raw ? "true" : "false";
+                decoded[std::string(key)] = value;
+              }));
+        });
+  }
+  EXPECT_EQ(plain_records, 1u);
+  EXPECT_EQ(decoded["order"], "42");
+  EXPECT_EQ(decoded["price"], std::to_string(101.5));
+  EXPECT_EQ(decoded["venue"], "XS\"HG");
+  EXPECT_EQ(decoded["ok"], "true");
+}
+
+#if GTEST_HAS_DEATH_TEST
+/**
+ * @test 验证崩溃环：子进程写日志后未经 Flush 直接 abort，
+ * 下次以同一配置初始化时恢复出可解码的二进制段，末尾记录终止信号；正常关闭后不再恢复
+ */
+TEST_F(SpdlogPluginTest, CrashRing_RecoversRecordsAfterAbort) {
+  namespace binlog = z3y::plugins::log::binlog;
+  const std::filesystem::path ring_dir = bin_dir_ / "logs" / "crash_ring_test";
+  std::filesystem::path config_path = bin_dir_ / "crash_ring_config.json";
+  {
+    std::ofstream out(config_path);
+    out << R"({ "global_settings": {
+                  "crash_ring": { "base_name": "crash_ring_test/app.ring", "size_kb": 64,
+                                  "level": "debug" } },
+                "sinks": {}, "default_rule": { "sinks": [] } })";
+  }
+  auto init = [&]() {
+    return z3y::GetDefaultService<ILogManagerService>()->InitializeService(
+        z3y::utils::PathToUtf8(config_path), z3y::utils::PathToUtf8(bin_dir_ / "logs"));
+  };
+
+  GTEST_FLAG_SET(death_test_style, "threadsafe");
+  EXPECT_DEATH(
+      {
+        std::filesystem::remove_all(ring_dir);
+        if (!init()) std::exit(1);
+        auto logger = z3y::GetDefaultService<ILogManagerService>()->GetLogger("Motion.Axis");
+        // 写满几圈，环中只剩最近的记录。与结构化记录同走线程环，
+        // 两者在同一线程内保序 (普通 Z3Y_LOG_* 与线程环之间不保证先后)
+        for (int i = 0; i < 2000; ++i) Z3Y_LOG_DEFERRED_DEBUG(logger, "step {}", i);
+        Z3Y_LOG_STRUCTURED_INFO(logger, "axis {axis} fault", Z3Y_LOG_KV("axis", 3));
+        // 等待后台线程写入 Sink (不调用 Flush)
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        std::abort();
+      },
+      "");
+
+  ASSERT_TRUE(init());
+  std::vector<std::filesystem::path> recovered;
+  for (const auto& entry : std::filesystem::directory_iterator(ring_dir)) {
+    if (entry.path().extension() == ".blog") recovered.push_back(entry.path());
+  }
+  ASSERT_EQ(recovered.size(), 1u);
+  EXPECT_EQ(recovered[0].filename().string().rfind("app.crash-", 0), 0u);
+
+  std::string bytes;
+  {
+    std::ifstream f(recovered[0], std::ios::binary);
+    bytes.assign(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+  }
+  std::vector<std::string> messages;
+  std::vector<std::string> names;
+  std::string fields;
+  binlog::ForEachRecord(bytes.data(), bytes.size(),
+                        [&](const binlog::RecordHeader&, std::string_view name,
+                            std::string_view message, std::string_view f) {
+                          names.emplace_back(name);
+                          messages.emplace_back(message);
+                          if (!f.empty()) fields.assign(f);
+                        });
+  ASSERT_GE(messages.size(), 3u);
+  EXPECT_LT(messages.size(), 2000u);  // 64KB 环放不下全部，最旧的已被覆盖
+  EXPECT_EQ(messages[messages.size() - 3], "step 1999");
+  EXPECT_EQ(messages[messages.size() - 2], "axis 3 fault");
+  EXPECT_EQ(names[messages.size() - 2], "Motion.Axis");
+  EXPECT_FALSE(fields.empty());
+  EXPECT_EQ(names.back(), "crash_ring");
+  EXPECT_EQ(messages.back(), "previous run terminated by signal " + std::to_string(SIGABRT));
+  // 连续的记录没有缺口：环中保留的是最近的一段
+  const int first = std::stoi(messages.front().substr(5));
+  EXPECT_EQ(static_cast<size_t>(1999 - first + 1), messages.size() - 2);
+}
+#endif
+
+#ifndef _WIN32
+namespace {
+
+/** @brief 绑定 127.0.0.1 的临时端口，返回套接字与端口。 */
+int BindLoopback(int type, uint16_t& port) {
+  int fd = ::socket(AF_INET, type, 0);
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t len = sizeof(addr);
+  if (fd < 0 || ::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+      (type == SOCK_STREAM && ::listen(fd, 1) != 0) ||
+      ::getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len) != 0) {
+    if (fd >= 0) ::close(fd);
+    return -1;
+  }
+  port = ntohs(addr.sin_port);
+  return fd;
+}
+
+bool WaitReadable(int fd, int timeout_ms) {
+  pollfd pfd{fd, POLLIN, 0};
+  return ::poll(&pfd, 1, timeout_ms) > 0;
+}
+
+/** @brief 解压首尾相接的 LZ4 帧序列 (每批一帧)。 */
+std::string DecompressFrames(const std::string& stream) {
+  namespace lz4 = z3y::plugins::log::lz4;
+  std::string text;
+  size_t pos = 0;
+  while (pos + 7 <= stream.size()) {
+    size_t p = pos + 7;  // 帧头 (无内容长度 / 字典 ID)
+    while (p + 4 <= stream.size()) {
+      uint32_t word;
+      std::memcpy(&word, stream.data() + p, 4);
+      p += 4;
+      if (word == 0) break;
+      p += word & 0x7FFFFFFFu;
+    }
+    if (!lz4::DecompressFrame(std::string_view(stream).substr(pos, p - pos), text)) break;
+    pos = p;
+  }
+  return text;
+}
+
+}  // namespace
+
+/**
+ * @test 验证网络 Sink：UDP 上每个数据报一条 GELF 消息 (结构化字段为 _key)；TCP 上按批压缩为
+ * LZ4 帧、按行分隔；收集端不可达时写入方不阻塞，丢弃计入 GetQueueStats
+ */
+TEST_F(SpdlogPluginTest, NetworkSink_BatchesCompressesAndDropsWhenUnreachable) {
+  uint16_t udp_port = 0, tcp_port = 0, dead_port = 0;
+  const int udp_fd = BindLoopback(SOCK_DGRAM, udp_port);
+  const int listen_fd = BindLoopback(SOCK_STREAM, tcp_port);
+  const int dead_fd = BindLoopback(SOCK_STREAM, dead_port);
+  ASSERT_GE(udp_fd, 0);
+  ASSERT_GE(listen_fd, 0);
+  ASSERT_GE(dead_fd, 0);
+  ::close(dead_fd);  // 端口已关闭：连接立即被拒绝
+
+  auto log_mgr = z3y::GetDefaultService<ILogManagerService>();
+  std::filesystem::path config_path = bin_dir_ / "network_sink_config.json";
+  {
+    std::ofstream out(config_path);
+    out << R"({ "global_settings": { "format_pattern": "%n|%v" },
+                "sinks": {
+                  "gelf": { "type": "network_sink", "target": "127.0.0.1:)" << udp_port
+        << R"(", "format": "gelf" },
+                  "tcp": { "type": "network_sink", "protocol": "tcp", "compression": "lz4",
+                           "target": "127.0.0.1:)" << tcp_port << R"(" },
+                  "dead": { "type": "network_sink", "protocol": "tcp", "queue_size": 4,
+                            "target": "127.0.0.1:)" << dead_port << R"(" } },
+                "rules": [ { "matcher": "Net.Down", "sinks": ["dead"] } ],
+                "default_rule": { "sinks": ["gelf", "tcp"] } })";
+  }
+  ASSERT_TRUE(log_mgr->InitializeService(z3y::utils::PathToUtf8(config_path),
+                                         z3y::utils::PathToUtf8(bin_dir_ / "logs")));
+
+  auto logger = log_mgr->GetLogger("Net.Line");
+  for (int i = 0; i < 10; ++i) Z3Y_LOG_INFO(logger, "part {}", i);
+  Z3Y_LOG_STRUCTURED_WARN(logger, "spindle {id} hot", Z3Y_LOG_KV("id", 2),
+                          Z3Y_LOG_KV("temp", 81.5));
+
+  auto down = log_mgr->GetLogger("Net.Down");
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < 200; ++i) Z3Y_LOG_INFO(down, "lost {}", i);
+  log_mgr->Flush();
+  EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+
+  // UDP：每个数据报一条 GELF
+  std::vector<nlohmann::json> gelf;
+  char buf[65536];
+  while (gelf.size() < 11 && WaitReadable(udp_fd, 3000)) {
+    const ssize_t n = ::recv(udp_fd, buf, sizeof(buf), 0);
+    ASSERT_GT(n, 0);
+    gelf.push_back(nlohmann::json::parse(std::string(buf, static_cast<size_t>(n))));
+  }
+  ASSERT_EQ(gelf.size(), 11u);
+  // 结构化日志经延迟格式化线程写出，与普通日志之间不保证顺序
+  const auto structured = std::stable_partition(
+      gelf.begin(), gelf.end(), [](const nlohmann::json& j) { return j["level"] == 6; });
+  ASSERT_EQ(structured, gelf.begin() + 10);
+  EXPECT_EQ(gelf[0]["version"], "1.1");
+  EXPECT_EQ(gelf[0]["short_message"], "part 0");
+  EXPECT_EQ(gelf[0]["_logger"], "Net.Line");
+  EXPECT_EQ(gelf[10]["short_message"], "spindle 2 hot temp=81.5");
+  EXPECT_EQ(gelf[10]["level"], 4);
+  EXPECT_FALSE(gelf[10].contains("_id"));  // 保留字段改名
+  EXPECT_EQ(gelf[10]["_id_"], 2);
+  EXPECT_EQ(gelf[10]["_temp"], 81.5);
+
+  // TCP：LZ4 帧序列，解压后按行分隔
+  ASSERT_TRUE(WaitReadable(listen_fd, 3000));
+  const int conn = ::accept(listen_fd, nullptr, nullptr);
+  ASSERT_GE(conn, 0);
+  std::string stream, text;
+  while (std::count(text.begin(), text.end(), '\n') < 11 && WaitReadable(conn, 3000)) {
+    const ssize_t n = ::recv(conn, buf, sizeof(buf), 0);
+    if (n <= 0) break;
+    stream.append(buf, static_cast<size_t>(n));
+    text = DecompressFrames(stream);
+  }
+  EXPECT_NE(text.find("Net.Line|part 0\n"), std::string::npos) << text;
+  EXPECT_NE(text.find("Net.Line|part 9\n"), std::string::npos) << text;
+  EXPECT_NE(text.find("Net.Line|spindle 2 hot temp=81.5\n"), std::string::npos);
+
+  // 收集端不可达：最多保留 queue_size 条，其余丢弃
+  EXPECT_GE(log_mgr->GetQueueStats().discarded, 196u);
+
+  ::close(conn);
+  ::close(listen_fd);
+  ::close(udp_fd);
+}
+#endif
+
+/**
+ * @test 验证 Rule 的 delivery：后台线程被卡住、队列积压数千条时，
+ * priority 通道的 Fatal 与 sync 通道的日志仍在调用线程上写完才返回，低于门槛的照常入队
+ */
+TEST_F(SpdlogPluginTest, Delivery_CriticalBypassesBackedUpQueue) {
+  auto log_mgr = z3y::GetDefaultService<ILogManagerService>();
+  std::filesystem::path config_path = bin_dir_ / "delivery_config.json";
+  std::filesystem::path log_path = bin_dir_ / "logs" / "delivery.log";
+  std::filesystem::remove(log_path);
+  {
+    std::ofstream out(config_path);
+    out << R"({ "global_settings": { "format_pattern": "%n|%v", "async_queue_size": 8192 },
+                 "sinks": { "f": { "type": "rotating_file_sink", "base_name": "delivery.log",
+                                   "level": "info" } },
+                 "rules": [ { "matcher": "Safety", "sinks": ["f"], "delivery": "priority",
+                              "priority_level": "error" },
+                            { "matcher": "Audit", "sinks": ["f"], "delivery": "sync" } ],
+                 "default_rule": { "sinks": ["f"] } })";
+  }
+  ASSERT_TRUE(log_mgr->InitializeService(z3y::utils::PathToUtf8(config_path),
+                                         z3y::utils::PathToUtf8(bin_dir_ / "logs")));
+
+  // 观察者在 "gate" 上卡住后台线程，之后入队的日志全部积压
+  std::atomic<bool> release{false};
+  std::mutex seen_mutex;
+  std::vector<std::string> seen;
+  log_mgr->AddLogObserver("Gate", [&](const LogRecord& record) {
+    const std::string message(record.message, record.message_length);
+    if (message == "gate") {
+      while (!release.load()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    std::lock_guard<std::mutex> lock(seen_mutex);
+    seen.push_back(std::string(record.logger_name, record.logger_name_length) + "|" + message);
+  });
+  auto seen_contains = [&](const std::string& line) {
+    std::lock_guard<std::mutex> lock(seen_mutex);
+    return std::find(seen.begin(), seen.end(), line) != seen.end();
+  };
+  auto file_contains = [&](const std::string& text) {
+    std::ifstream in(log_path);
+    std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    return content.find(text) != std::string::npos;
+  };
+
+  auto bulk = log_mgr->GetLogger("Bulk");
+  auto safety = log_mgr->GetLogger("Safety.Reactor");
+  auto audit = log_mgr->GetLogger("Audit");
+
+  Z3Y_LOG_INFO(bulk, "gate");
+  for (int i = 0; i < 3000; ++i) Z3Y_LOG_INFO(bulk, "backlog {}", i);
+  EXPECT_GE(log_mgr->GetQueueStats().queued, 2900u);
+
+  // 低于 priority_level：照常排在积压之后
+  Z3Y_LOG_WARN(safety, "pressure rising");
+  EXPECT_FALSE(seen_contains("Safety.Reactor|pressure rising"));
+
+  // 达到 priority_level：绕过队列，返回时已写入 Sink 并按 flush_on_level 刷盘
+  const auto start = std::chrono::steady_clock::now();
+  Z3Y_LOG_FATAL(safety, "overpressure, shutting down");
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  EXPECT_LT(elapsed, std::chrono::milliseconds(200));
+  EXPECT_TRUE(seen_contains("Safety.Reactor|overpressure, shutting down"));
+  EXPECT_TRUE(file_contains("Safety.Reactor|overpressure, shutting down"));
+  EXPECT_FALSE(file_contains("Safety.Reactor|pressure rising"));
+
+  // sync：所有级别都在调用线程写入
+  Z3Y_LOG_INFO(audit, "operator {} logged in", 7);
+  EXPECT_TRUE(seen_contains("Audit|operator 7 logged in"));
+
+  // 放开后台线程，积压的日志照常写完
+  release = true;
+  LogQueueStats stats;
+  for (int i = 0; i < 200; ++i) {
+    log_mgr->Flush();
+    stats = log_mgr->GetQueueStats();
+    if (stats.queued == 0) break;
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_EQ(stats.queued, 0u);
+  log_mgr->RemoveLogObserver("Gate");
+  for (int i = 0; i < 100 && !file_contains("Bulk|backlog 2999"); ++i) {
+    log_mgr->Flush();
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_TRUE(file_contains("Bulk|backlog 2999"));
+  EXPECT_TRUE(file_contains("Safety.Reactor|pressure rising"));
+}
+
+/**
+ * @test 验证线程环后端：多线程的普通日志经各自的环写出，不丢、不乱序 (同一线程内)，
+ * 保留调用线程 ID；环很小时 block 策略让提交方等待而不是丢弃
+ */
+TEST_F(SpdlogPluginTest, ThreadRings_DeliversAllInPerThreadOrder) {
+  auto log_mgr = z3y::GetDefaultService<ILogManagerService>();
+  std::filesystem::path config_path = bin_dir_ / "thread_rings_config.json";
+  {
+    std::ofstream out(config_path);
+    out << R"({ "global_settings": { "format_pattern": "%v", "async_backend": "thread_rings",
+                                     "deferred_ring_kb": 4, "async_overflow_policy": "block" },
+                 "sinks": { "f": { "type": "rotating_file_sink", "base_name": "thread_rings.log",
+                                   "level": "info" } },
+                 "default_rule": { "sinks": ["f"] } })";
+  }
+  ASSERT_TRUE(log_mgr->InitializeService(z3y::utils::PathToUtf8(config_path),
+                                         z3y::utils::PathToUtf8(bin_dir_ / "logs")));
+
+  std::mutex mutex;
+  std::map<int, std::vector<int>> sequences;  // 线程序号 -> 按到达顺序的 seq
+  std::map<int, std::set<uint32_t>> thread_ids;
+  log_mgr->AddLogObserver("Rings", [&](const LogRecord& record) {
+    int t = -1, seq = -1;
+    if (std::sscanf(record.message, "ring worker %d seq %d", &t, &seq) != 2) return;
+    std::lock_guard<std::mutex> lock(mutex);
+    sequences[t].push_back(seq);
+    thread_ids[t].insert(record.thread_id);
+  });
+
+  auto logger = log_mgr->GetLogger("Rings.Bench");
+  constexpr int kThreads = 4;
+  constexpr int kPerThread = 2000;
+  std::vector<std::thread> workers;
+  for (int t = 0; t < kThreads; ++t) {
+    workers.emplace_back([&, t] {
+      for (int i = 0; i < kPerThread; ++i) Z3Y_LOG_INFO(logger, "ring worker {} seq {}", t, i);
+    });
+  }
+  for (auto& w : workers) w.join();
+  log_mgr->Flush();
+  log_mgr->RemoveLogObserver("Rings");
+
+  const LogQueueStats stats = log_mgr->GetQueueStats();
+  EXPECT_EQ(stats.queued, 0u);
+  EXPECT_EQ(stats.discarded, 0u);
+
+  std::lock_guard<std::mutex> lock(mutex);
+  ASSERT_EQ(sequences.size(), static_cast<size_t>(kThreads));
+  std::set<uint32_t> distinct;
+  for (int t = 0; t < kThreads; ++t) {
+    const auto& seq = sequences[t];
+    ASSERT_EQ(seq.size(), static_cast<size_t>(kPerThread)) << "thread " << t;
+    EXPECT_TRUE(std::is_sorted(seq.begin(), seq.end())) << "thread " << t;
+    ASSERT_EQ(thread_ids[t].size(), 1u) << "每条记录保留调用线程的 ID";
+    distinct.insert(*thread_ids[t].begin());
+  }
+  EXPECT_EQ(distinct.size(), static_cast<size_t>(kThreads));
+}
+
+/**
+ * @test 验证线程环后端配合 overrun_oldest 时普通日志退回 spdlog 队列：
+ * 4KB 的线程环放不下 2000 条，但 8192 深的 spdlog 队列能全部收下，一条都不丢
+ */
+TEST_F(SpdlogPluginTest, ThreadRings_OverrunOldestKeepsTextOnSpdlogQueue) {
+  auto log_mgr = z3y::GetDefaultService<ILogManagerService>();
+  std::filesystem::path config_path = bin_dir_ / "thread_rings_overrun_config.json";
+  {
+    std::ofstream out(config_path);
+    out << R"({ "global_settings": { "format_pattern": "%v", "async_backend": "thread_rings",
+                                     "deferred_ring_kb": 4,
+                                     "async_overflow_policy": "overrun_oldest" },
+                 "sinks": { "f": { "type": "rotating_file_sink",
+                                   "base_name": "thread_rings_overrun.log", "level": "info" } },
+                 "default_rule": { "sinks": ["f"] } })";
+  }
+  ASSERT_TRUE(log_mgr->InitializeService(z3y::utils::PathToUtf8(config_path),
+                                         z3y::utils::PathToUtf8(bin_dir_ / "logs")));
+
+  std::atomic<int> received{0};
+  log_mgr->AddLogObserver("Overrun", [&](const LogRecord& record) {
+    if (std::string_view(record.message).rfind("overrun seq ", 0) == 0) ++received;
+  });
+  auto logger = log_mgr->GetLogger("Rings.Overrun");
+  constexpr int kCount = 2000;
+  for (int i = 0; i < kCount; ++i) Z3Y_LOG_INFO(logger, "overrun seq {}", i);
+  log_mgr->Flush();
+  for (int i = 0; i < 200 && received.load() < kCount; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  log_mgr->RemoveLogObserver("Overrun");
+
+  EXPECT_EQ(received.load(), kCount);
+  EXPECT_EQ(log_mgr->GetQueueStats().discarded, 0u);
+}
+
+/**
+ * @test 验证 coalescing_file_sink：按块写盘、按 max_size 轮转，历史文件与活动文件
+ * 依次拼接后与写入顺序完全一致
+ */
+TEST_F(SpdlogPluginTest, CoalescingFileSink_RollsAndKeepsOrder) {
+  auto log_mgr = z3y::GetDefaultService<ILogManagerService>();
+  const std::filesystem::path log_dir = bin_dir_ / "logs" / "coalesce_test";
+  std::filesystem::remove_all(log_dir);
+  std::filesystem::path config_path = bin_dir_ / "coalesce_sink_config.json";
+  {
+    std::ofstream out(config_path);
+    out << R"({ "global_settings": { "format_pattern": "%v" },
+                "sinks": { "c": { "type": "coalescing_file_sink",
+                                  "base_name": "coalesce_test/app.log", "max_size": 16384,
+                                  "max_files": 3, "buffer_kb": 4, "level": "info" } },
+                "default_rule": { "sinks": ["c"] } })";
+  }
+  ASSERT_TRUE(log_mgr->InitializeService(z3y::utils::PathToUtf8(config_path),
+                                         z3y::utils::PathToUtf8(bin_dir_ / "logs")));
+  auto logger = log_mgr->GetLogger("Coalesce");
+  constexpr int kCount = 3000;  // 每行 11 字节，约 33KB -> 轮转两次
+  std::string expected;
+  for (int i = 0; i < kCount; ++i) {
+    Z3Y_LOG_INFO(logger, "line {:05}", i);
+    expected += fmt::format("line {:05}\n", i);
+  }
+
+  auto read_all = [](const std::filesystem::path& p) {
+    std::ifstream f(p, std::ios::binary);
+    return std::string((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+  };
+  std::string joined;
+  for (int attempt = 0; attempt < 300 && joined != expected; ++attempt) {
+    log_mgr->Flush();
+    joined = read_all(log_dir / "app.2.log") + read_all(log_dir / "app.1.log") +
+             read_all(log_dir / "app.log");
+    if (joined != expected) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_EQ(joined, expected);
+  EXPECT_FALSE(std::filesystem::exists(log_dir / "app.3.log"));
+  for (const char* name : {"app.log", "app.1.log", "app.2.log"}) {
+    EXPECT_LE(std::filesystem::file_size(log_dir / name), 16384u) << name;
+  }
+}
@@ -108,3 +108,71 @@ TEST_F(TypeSystemTest, VersionMismatch_Major) {
             << "期望捕获主版本不匹配错误";
     }
 }
+
+// [内部 Mock] 实现多个接口的组件，用于验证有序接口表的查找
+class ITableA : public virtual z3y::IComponent {
+public:
+    Z3Y_DEFINE_INTERFACE(ITableA, "z3y-test-ITableA", 1, 0);
+    virtual int A() = 0;
+};
+class ITableB : public virtual z3y::IComponent {
+public:
+    Z3Y_DEFINE_INTERFACE(ITableB, "z3y-test-ITableB", 1, 2);
+    virtual int B() = 0;
+};
+class ITableC : public virtual z3y::IComponent {
+public:
+    Z3Y_DEFINE_INTERFACE(ITableC, "z3y-test-ITableC", 3, 0);
+    virtual int C() = 0;
+};
+class ITableD : public virtual z3y::IComponent {
+public:
+    Z3Y_DEFINE_INTERFACE(ITableD, "z3y-test-ITableD", 1, 0);
+    virtual int D() = 0;
+};
+
+class TableComponent : public z3y::PluginImpl<TableComponent, ITableD, ITableB, ITableA, ITableC> {
+public:
+    Z3Y_DEFINE_COMPONENT_ID("z3y-test-TableComponent");
+    int A() override { return 1; }
+    int B() override { return 2; }
+    int C() override { return 3; }
+    int D() override { return 4; }
+};
+
+/**
+ * @test 多接口组件的查找与借用式转换
+ * @brief 验证每个接口 (与声明顺序无关) 都能被找到、指针正确，版本检查仍然生效；
+ * PluginCastNoRef 不增加引用计数。
+ */
+TEST_F(TypeSystemTest, MultiInterface_TableLookupAndNoRef) {
+    PluginPtr<IComponent> component = std::make_shared<TableComponent>();
+    const long use_count = component.use_count();
+    InstanceError err;
+
+    ITableA* a = z3y::PluginCastNoRef<ITableA>(component, err);
+    ASSERT_NE(a, nullptr);
+    EXPECT_EQ(a->A(), 1);
+    ITableB* b = z3y::PluginCastNoRef<ITableB>(component, err);
+    ASSERT_NE(b, nullptr);
+    EXPECT_EQ(b->B(), 2);
+    ITableC* c = z3y::PluginCastNoRef<ITableC>(component.get(), err);
+    ASSERT_NE(c, nullptr);
+    EXPECT_EQ(c->C(), 3);
+    auto d = z3y::PluginCast<ITableD>(component, err);
+    ASSERT_NE(d, nullptr);
+    EXPECT_EQ(d->D(), 4);
+    EXPECT_EQ(z3y::PluginCastNoRef<IComponent>(component, err), component.get());
+    EXPECT_EQ(component.use_count(), use_count + 1) << "只有 PluginCast 的结果持有引用";
+
+    EXPECT_EQ(z3y::PluginCastNoRef<IDemoSimple>(component, err), nullptr);
+    EXPECT_EQ(err, InstanceError::kErrorInterfaceNotImpl);
+
+    // 次版本过高 / 主版本不一致
+    void* raw = component->QueryInterfaceRaw(ITableB::kIid, 1, 3, err);
+    EXPECT_EQ(raw, nullptr);
+    EXPECT_EQ(err, InstanceError::kErrorVersionMinorTooLow);
+    raw = component->QueryInterfaceRaw(ITableC::kIid, 2, 0, err);
+    EXPECT_EQ(raw, nullptr);
+    EXPECT_EQ(err, InstanceError::kErrorVersionMajorMismatch);
+}
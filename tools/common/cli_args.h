@@ -0,0 +1,64 @@
+﻿/*
+* Copyright [2025] [Yue Liu]
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/**
+ * @file cli_args.h
+ * @brief 各命令行工具共用的参数解析辅助 (`--name=value` 风格)。
+ * @details 每个工具仍各自定义 `Arguments` 与选项表，这里只提供逐个处理参数的循环与前缀匹配：
+ * \code{.cpp}
+ * return z3y::tools::ForEachArgument(argc, argv, [&args](const std::string& arg) {
+ *     std::string value;
+ *     if (z3y::tools::StartsWith(arg, "--rounds=", value)) args.rounds = std::atoi(value.c_str());
+ *     else return false;  // 无法识别的参数
+ *     return true;
+ * });
+ * \endcode
+ */
+
+#pragma once
+
+#ifndef Z3Y_TOOLS_COMMON_CLI_ARGS_H_
+#define Z3Y_TOOLS_COMMON_CLI_ARGS_H_
+
+#include <string>
+
+namespace z3y::tools {
+
+    /**
+     * @brief s 以 prefix 开头时返回 true，并把其后的部分写入 rest (例如 "--out=" 之后的路径)。
+     */
+    inline bool StartsWith(const std::string& s, const char* prefix, std::string& rest) {
+        const size_t n = std::char_traits<char>::length(prefix);
+        if (s.compare(0, n, prefix) != 0) return false;
+        rest = s.substr(n);
+        return true;
+    }
+
+    /**
+     * @brief 依次把 argv[1..argc) 交给 handler；handler 返回 false (无法识别或取值非法) 时立即失败。
+     * @return 全部参数都被接受时返回 true。参数之间的一致性由调用方在之后自行检查。
+     */
+    template <typename Handler>
+    bool ForEachArgument(int argc, char* argv[], Handler&& handler) {
+        for (int i = 1; i < argc; ++i) {
+            if (!handler(std::string(argv[i]))) return false;
+        }
+        return true;
+    }
+
+}  // namespace z3y::tools
+
+#endif  // Z3Y_TOOLS_COMMON_CLI_ARGS_H_
@@ -0,0 +1,498 @@
+﻿/*
+* Copyright [2025] [Yue Liu]
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/**
+ * @file main.cpp
+ * @brief 配置服务 (IConfigService) 性能与争用压测工具
+ * @details
+ * [测试覆盖]
+ * 1. 读取: GetValueSafe 与 ConfigHandle::Get，1 / 2 / 4 / 8 个读线程并发读取随机路径。
+ * 2. 写入: SetValue，目标节点挂 0 / 1 / 10 / 100 个 kDirect 订阅者。
+ * 3. 写争用: 4 个写线程 + 4 个读线程同时访问同一批节点。
+ * 4. 事务: ApplyChanges / ApplyBatch 一次提交 10k 项，以及 ActivateOverlay 切换 10k 项配方。
+ * 5. 注册: RegisterSchema (Builder::RegisterOnly) 连续注册 50k 项，逐次计时。
+ * 6. 重载: 50k 项文件上的 ReloadFromFile / ImportFromFile / PrepareOverlayFromFile。
+ * 7. 落盘: 后台线程每次提交写入的字节数 (变更日志每条修改、完整快照大小)。
+ *
+ * 每个场景输出逐次调用延迟分位数 (p50 / p99 / p99.9 / max)，结果同时写成 JSON，
+ * 便于在锁与持久化改动前后对比。
+ *
+ * 用法:
+ *   tool_config_benchmark [--json out.json] [--scale F]
+ *     F 缩放所有场景的调用次数与数据规模 (缺省 1.0，冒烟验证可用 0.05)；
+ *     未指定 --json 时写入 <exe 目录>/config_benchmark_result.json。
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "framework/z3y_framework.h"
+#include "interfaces_core/i_config_service.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <climits>
+#include <unistd.h>
+#endif
+
+using z3y::PluginPtr;
+using z3y::interfaces::core::ConfigChange;
+using z3y::interfaces::core::ConfigPersistencePolicy;
+using z3y::interfaces::core::ConfigValue;
+using z3y::interfaces::core::IConfigService;
+
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+double g_scale = 1.0;
+
+/** @brief 按 --scale 缩放次数 / 规模，至少为 min_value。 */
+int Scaled(int base, int min_value = 1) {
+    return std::max(min_value, static_cast<int>(base * g_scale));
+}
+
+uint64_t ElapsedNs(Clock::time_point begin) {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - begin).count());
+}
+
+// --- 路径辅助函数 (Windows UTF-8 兼容) ---
+std::filesystem::path GetExePath() {
+#ifdef _WIN32
+    wchar_t buffer[MAX_PATH];
+    if (GetModuleFileNameW(NULL, buffer, MAX_PATH) > 0) {
+        return std::filesystem::path(buffer);
+    }
+    return std::filesystem::current_path();
+#else
+    char buffer[PATH_MAX];
+    ssize_t count = readlink("/proc/self/exe", buffer, PATH_MAX);
+    if (count > 0) return std::filesystem::path(std::string(buffer, count));
+    return std::filesystem::current_path();
+#endif
+}
+
+uintmax_t FileSize(const std::filesystem::path& path) {
+    std::error_code ec;
+    const uintmax_t size = std::filesystem::file_size(path, ec);
+    return ec ? 0 : size;
+}
+
+void PrintSeparator(const std::string& title) {
+    std::cout << "\n=============================================================\n"
+        << " " << title << "\n"
+        << "=============================================================" << std::endl;
+}
+
+double Percentile(const std::vector<uint64_t>& sorted, double q) {
+    if (sorted.empty()) return 0.0;
+    const size_t index = std::min(sorted.size() - 1, static_cast<size_t>(q * (sorted.size() - 1) + 0.5));
+    return static_cast<double>(sorted[index]);
+}
+
+/**
+ * @brief 把一组逐次耗时 (ns) 汇总为结果条目并打印一行。
+ * @param ops_per_sample 每个样本包含的操作数 (批量场景为批大小)，用于计算吞吐。
+ * @param wall_s 场景的墙钟时间；多线程场景吞吐按墙钟计算，单线程场景传 0 表示按样本累加。
+ */
+nlohmann::json Report(const std::string& group, const std::string& name, std::vector<uint64_t> samples,
+                      double ops_per_sample = 1.0, double wall_s = 0.0, nlohmann::json extra = {}) {
+    std::sort(samples.begin(), samples.end());
+    double sum = 0;
+    for (uint64_t v : samples) sum += static_cast<double>(v);
+    const double count = static_cast<double>(samples.size());
+    const double seconds = wall_s > 0 ? wall_s : sum / 1e9;
+    nlohmann::json entry = {
+        {"group", group},
+        {"name", name},
+        {"samples", samples.size()},
+        {"throughput_ops_per_s", seconds > 0 ? count * ops_per_sample / seconds : 0.0},
+        {"latency_ns", {
+            {"mean", count > 0 ? sum / count : 0.0},
+            {"p50", Percentile(samples, 0.50)},
+            {"p99", Percentile(samples, 0.99)},
+            {"p999", Percentile(samples, 0.999)},
+            {"max", samples.empty() ? 0.0 : static_cast<double>(samples.back())}}}};
+    if (extra.is_object()) entry.update(extra);
+
+    std::cout << std::left << std::setw(14) << group << std::setw(34) << name
+        << std::right << std::fixed << std::setprecision(0)
+        << " ops/s=" << std::setw(11) << entry["throughput_ops_per_s"].get<double>()
+        << " p50=" << std::setw(9) << entry["latency_ns"]["p50"].get<double>()
+        << " p99=" << std::setw(10) << entry["latency_ns"]["p99"].get<double>()
+        << " p99.9=" << std::setw(10) << entry["latency_ns"]["p999"].get<double>()
+        << " max=" << std::setw(11) << entry["latency_ns"]["max"].get<double>() << " ns";
+    if (extra.is_object()) std::cout << "  " << extra.dump();
+    std::cout << std::endl;
+    return entry;
+}
+
+/** @brief 注册 count 个整数节点 prefix0 .. prefix{count-1}，返回路径列表。 */
+std::vector<std::string> RegisterInts(IConfigService* config, const std::string& prefix, int count) {
+    std::vector<std::string> paths;
+    paths.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        paths.push_back(prefix + std::to_string(i));
+        config->Builder<int>(paths.back()).GroupKey("Bench").Default(0).Min(0).RegisterOnly();
+    }
+    return paths;
+}
+
+/** @brief 轻量伪随机数 (各线程独立，不引入 <random> 的分配与锁)。 */
+uint32_t NextRandom(uint32_t& state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+// ============================================================================
+// 场景
+// ============================================================================
+
+void BenchReads(IConfigService* config, nlohmann::json& cases) {
+    PrintSeparator("1. 并发读取 (GetValueSafe / ConfigHandle)");
+    const auto paths = RegisterInts(config, "Read.K", 1000);
+    const int reads = Scaled(200000, 1000);
+
+    for (const bool use_handle : {false, true}) {
+        std::vector<z3y::interfaces::core::ConfigHandle<int>> handles;
+        if (use_handle) {
+            for (const auto& p : paths) handles.push_back(config->SubscribeHandle<int>(p, 0));
+        }
+        for (const int threads : {1, 2, 4, 8}) {
+            std::vector<std::vector<uint64_t>> latencies(threads);
+            std::atomic<int> ready{0};
+            std::atomic<bool> go{false};
+            std::atomic<int64_t> sink{0};
+            std::vector<std::thread> workers;
+            for (int t = 0; t < threads; ++t) {
+                workers.emplace_back([&, t]() {
+                    auto& samples = latencies[t];
+                    samples.resize(reads);  // 预分配，不计入被测区间
+                    uint32_t rng = 2463534242u + t;
+                    int64_t local = 0;
+                    ready++;
+                    while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+                    for (int i = 0; i < reads; ++i) {
+                        const size_t k = NextRandom(rng) % paths.size();
+                        const auto begin = Clock::now();
+                        local += use_handle ? handles[k].Get() : config->GetValueSafe<int>(paths[k]);
+                        samples[i] = ElapsedNs(begin);
+                    }
+                    sink += local;
+                });
+            }
+            while (ready.load() < threads) std::this_thread::yield();
+            const auto start = Clock::now();
+            go.store(true, std::memory_order_release);
+            for (auto& w : workers) w.join();
+            const double wall = ElapsedNs(start) / 1e9;
+
+            std::vector<uint64_t> all;
+            for (auto& l : latencies) all.insert(all.end(), l.begin(), l.end());
+            cases.push_back(Report("read", std::string(use_handle ? "ConfigHandle::Get" : "GetValueSafe") +
+                                   " threads=" + std::to_string(threads),
+                                   std::move(all), 1.0, wall, {{"threads", threads}}));
+        }
+    }
+}
+
+void BenchWrites(IConfigService* config, nlohmann::json& cases) {
+    PrintSeparator("2. 写入与订阅者扇出 (SetValue)");
+    const int writes = Scaled(50000, 500);
+    for (const int subscribers : {0, 1, 10, 100}) {
+        const std::string path = "Write.S" + std::to_string(subscribers);
+        config->Builder<int>(path).Default(0).RegisterOnly();
+        std::atomic<int64_t> sink{0};
+        std::vector<z3y::interfaces::core::ScopedConnection> conns;
+        for (int s = 0; s < subscribers; ++s) {
+            conns.push_back(config->Subscribe<int>(path, [&sink](const int& v) {
+                sink.fetch_add(v, std::memory_order_relaxed);
+            }));
+        }
+        std::vector<uint64_t> samples(writes);
+        for (int i = 0; i < writes; ++i) {
+            const auto begin = Clock::now();
+            config->SetValueSafe<int>(path, i + 1);
+            samples[i] = ElapsedNs(begin);
+        }
+        cases.push_back(Report("write", "SetValue subscribers=" + std::to_string(subscribers),
+                               std::move(samples), 1.0, 0.0, {{"subscribers", subscribers}}));
+    }
+
+    // 写争用：写线程与读线程同时访问同一批节点
+    const auto paths = RegisterInts(config, "Contend.K", 64);
+    const int ops = Scaled(50000, 500);
+    const int writers = 4;
+    const int readers = 4;
+    std::vector<std::vector<uint64_t>> write_lat(writers), read_lat(readers);
+    std::atomic<bool> go{false};
+    std::vector<std::thread> workers;
+    for (int t = 0; t < writers + readers; ++t) {
+        workers.emplace_back([&, t]() {
+            const bool writer = t < writers;
+            auto& samples = writer ? write_lat[t] : read_lat[t - writers];
+            samples.resize(ops);
+            uint32_t rng = 88172645u + t;
+            while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+            for (int i = 0; i < ops; ++i) {
+                const auto& path = paths[NextRandom(rng) % paths.size()];
+                const auto begin = Clock::now();
+                if (writer) {
+                    config->SetValueSafe<int>(path, i);
+                } else {
+                    (void)config->GetValueSafe<int>(path);
+                }
+                samples[i] = ElapsedNs(begin);
+            }
+        });
+    }
+    const auto start = Clock::now();
+    go.store(true, std::memory_order_release);
+    for (auto& w : workers) w.join();
+    const double wall = ElapsedNs(start) / 1e9;
+    std::vector<uint64_t> w_all, r_all;
+    for (auto& l : write_lat) w_all.insert(w_all.end(), l.begin(), l.end());
+    for (auto& l : read_lat) r_all.insert(r_all.end(), l.begin(), l.end());
+    cases.push_back(Report("contention", "SetValue 4w+4r on 64 keys", std::move(w_all), 1.0, wall));
+    cases.push_back(Report("contention", "GetValueSafe 4w+4r on 64 keys", std::move(r_all), 1.0, wall));
+}
+
+void BenchBatches(IConfigService* config, nlohmann::json& cases) {
+    PrintSeparator("3. 批量事务与配方切换 (10k 项)");
+    const int keys = Scaled(10000, 100);
+    const int rounds = Scaled(20, 3);
+    const auto paths = RegisterInts(config, "Batch.K", keys);
+
+    std::vector<uint64_t> flat_samples, map_samples, overlay_samples;
+    for (int r = 0; r < rounds; ++r) {
+        std::vector<ConfigChange> changes;
+        changes.reserve(keys);
+        for (int i = 0; i < keys; ++i) changes.push_back({paths[i], ConfigValue(int64_t(r * 2 + 1))});
+        auto begin = Clock::now();
+        config->ApplyChanges(changes, "Bench");
+        flat_samples.push_back(ElapsedNs(begin));
+
+        std::map<std::string, ConfigValue> map_changes;
+        for (int i = 0; i < keys; ++i) map_changes[paths[i]] = ConfigValue(int64_t(r * 2 + 2));
+        begin = Clock::now();
+        config->ApplyBatch(map_changes, "Bench");
+        map_samples.push_back(ElapsedNs(begin));
+    }
+    cases.push_back(Report("batch", "ApplyChanges " + std::to_string(keys) + " keys",
+                           std::move(flat_samples), keys, 0.0, {{"keys", keys}}));
+    cases.push_back(Report("batch", "ApplyBatch(map) " + std::to_string(keys) + " keys",
+                           std::move(map_samples), keys, 0.0, {{"keys", keys}}));
+
+    // 两个配方只有一半节点不同
+    std::vector<ConfigChange> recipe_a, recipe_b;
+    for (int i = 0; i < keys; ++i) {
+        recipe_a.push_back({paths[i], ConfigValue(int64_t(1000))});
+        recipe_b.push_back({paths[i], ConfigValue(int64_t(i % 2 ? 1000 : 2000))});
+    }
+    config->PrepareOverlay("bench_a", recipe_a, "Bench");
+    config->PrepareOverlay("bench_b", recipe_b, "Bench");
+    for (int r = 0; r < rounds; ++r) {
+        const auto begin = Clock::now();
+        config->ActivateOverlay(r % 2 ? "bench_b" : "bench_a");
+        overlay_samples.push_back(ElapsedNs(begin));
+    }
+    cases.push_back(Report("batch", "ActivateOverlay " + std::to_string(keys) + " keys (50% diff)",
+                           std::move(overlay_samples), keys, 0.0, {{"keys", keys}}));
+    config->RemoveOverlay("bench_a");
+    config->RemoveOverlay("bench_b");
+}
+
+void BenchRegistration(IConfigService* config, nlohmann::json& cases, const std::filesystem::path& dir) {
+    PrintSeparator("4. 注册与重载 (50k 项)");
+    const int keys = Scaled(50000, 500);
+    std::vector<uint64_t> samples(keys);
+    for (int i = 0; i < keys; ++i) {
+        const std::string path = "Reg.K" + std::to_string(i);
+        const auto begin = Clock::now();
+        config->Builder<int>(path).GroupKey("Reg").Default(i).RegisterOnly();
+        samples[i] = ElapsedNs(begin);
+    }
+    cases.push_back(Report("register", "RegisterSchema " + std::to_string(keys) + " entries",
+                           std::move(samples), 1.0, 0.0, {{"keys", keys}}));
+
+    // 准备一个完整配方文件：全部节点的当前值
+    const auto recipe = dir / "bench_recipe.json";
+    const std::string recipe_utf8 = z3y::utils::PathToUtf8(recipe);
+    config->ExportToFile(recipe_utf8);
+    config->Flush();
+    const uintmax_t recipe_bytes = FileSize(recipe);
+    const int rounds = Scaled(5, 2);
+
+    std::vector<uint64_t> reload, import, prepare;
+    for (int r = 0; r < rounds; ++r) {
+        auto begin = Clock::now();
+        config->ReloadFromFile();
+        reload.push_back(ElapsedNs(begin));
+
+        begin = Clock::now();
+        config->ImportFromFile(recipe_utf8, true);
+        import.push_back(ElapsedNs(begin));
+
+        begin = Clock::now();
+        config->PrepareOverlayFromFile("bench_file", recipe_utf8, "Bench");
+        prepare.push_back(ElapsedNs(begin));
+    }
+    config->RemoveOverlay("bench_file");
+    const nlohmann::json extra = {{"file_bytes", recipe_bytes}};
+    cases.push_back(Report("reload", "ReloadFromFile", std::move(reload), 1.0, 0.0, extra));
+    cases.push_back(Report("reload", "ImportFromFile", std::move(import), 1.0, 0.0, extra));
+    cases.push_back(Report("reload", "PrepareOverlayFromFile", std::move(prepare), 1.0, 0.0, extra));
+}
+
+void BenchPersistence(IConfigService* config, nlohmann::json& cases, const std::filesystem::path& db) {
+    PrintSeparator("5. 落盘字节数 (每次提交)");
+    // 组提交：每次修改后 Flush，逐次统计日志增长量与提交耗时
+    ConfigPersistencePolicy policy;
+    policy.group_commit = true;
+    policy.fsync = false;
+    config->SetPersistencePolicy(policy);
+    config->Builder<int>("Persist.Value").Default(0).RegisterOnly();
+    config->Builder<std::string>("Persist.Text").Default("").RegisterOnly();
+    config->Flush();
+
+    const std::filesystem::path journal = db.string() + ".journal";
+    const int changes = Scaled(2000, 50);
+    for (const bool text : {false, true}) {
+        std::vector<uint64_t> samples;
+        uintmax_t journal_bytes = 0;
+        int journal_commits = 0;
+        for (int i = 0; i < changes; ++i) {
+            const uintmax_t before = FileSize(journal);
+            const auto begin = Clock::now();
+            if (text) {
+                config->SetValueSafe<std::string>("Persist.Text", "value-" + std::to_string(i));
+            } else {
+                config->SetValueSafe<int>("Persist.Value", i + 1);
+            }
+            config->Flush();
+            samples.push_back(ElapsedNs(begin));
+            const uintmax_t after = FileSize(journal);
+            // 日志被压实为快照时大小回落，这一次不计入日志字节
+            if (after > before) {
+                journal_bytes += after - before;
+                ++journal_commits;
+            }
+        }
+        const double per_change = journal_commits ? static_cast<double>(journal_bytes) / journal_commits : 0.0;
+        cases.push_back(Report("persist", std::string("SetValue+Flush ") + (text ? "string" : "int"),
+                               std::move(samples), 1.0, 0.0,
+                               {{"journal_bytes_per_change", per_change},
+                                {"snapshot_bytes", FileSize(db)}}));
+    }
+    config->SetPersistencePolicy(ConfigPersistencePolicy{});
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+#ifdef _WIN32
+    system("chcp 65001 > nul");
+#endif
+
+    std::filesystem::path json_path;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--json" && i + 1 < argc) {
+            json_path = z3y::utils::Utf8ToPath(argv[++i]);
+        } else if (arg == "--scale" && i + 1 < argc) {
+            g_scale = std::max(0.001, std::atof(argv[++i]));
+        } else {
+            std::cerr << "Usage: tool_config_benchmark [--json out.json] [--scale F]" << std::endl;
+            return 2;
+        }
+    }
+
+    try {
+        const std::filesystem::path exe_dir = GetExePath().parent_path();
+        if (json_path.empty()) json_path = exe_dir / "config_benchmark_result.json";
+        const auto work_dir = exe_dir / "bench_config";
+        std::filesystem::remove_all(work_dir);
+        std::filesystem::create_directories(work_dir);
+        const auto db = work_dir / "config.json";
+
+        auto manager = z3y::PluginManager::Create();
+        // 目录中的框架库本身不是插件，加载失败列表不影响压测
+        static_cast<void>(manager->LoadPluginsFromDirectory(exe_dir, true));
+        auto config = z3y::GetDefaultService<IConfigService>();
+        config->SetStoragePath(z3y::utils::PathToUtf8(db));
+
+        nlohmann::json result;
+        result["schema"] = "z3y.config_benchmark/1";
+        result["framework_version"] = Z3Y_BENCH_FRAMEWORK_VERSION;
+#ifdef Z3Y_IS_DEBUG_BUILD
+        result["build_type"] = "Debug";
+#else
+        result["build_type"] = "Release";
+#endif
+#ifdef _WIN32
+        result["platform"] = "windows";
+#else
+        result["platform"] = "linux";
+#endif
+        result["hardware_threads"] = std::thread::hardware_concurrency();
+        result["timestamp"] = static_cast<int64_t>(std::time(nullptr));
+        result["scale"] = g_scale;
+        result["cases"] = nlohmann::json::array();
+
+        auto& cases = result["cases"];
+        BenchReads(config.get(), cases);
+        BenchWrites(config.get(), cases);
+        BenchBatches(config.get(), cases);
+        BenchRegistration(config.get(), cases, work_dir);
+        BenchPersistence(config.get(), cases, db);
+
+        PrintSeparator("Shutting Down");
+        config->Flush();
+        config.reset();
+        manager->UnloadAllPlugins();
+        manager.reset();
+        z3y::PluginManager::Destroy();
+
+        std::ofstream out(json_path);
+        if (!out) {
+            std::cerr << "[Fatal] 无法写入结果文件: " << z3y::utils::PathToUtf8(json_path) << std::endl;
+            return 1;
+        }
+        out << result.dump(2) << std::endl;
+        std::cout << "[Exit] 结果已写入: " << z3y::utils::PathToUtf8(json_path) << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "[Fatal Exception] " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,444 @@
+﻿/*
+* Copyright [2025] [Yue Liu]
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/**
+ * @file main.cpp
+ * @brief 事件总线吞吐量 / 延迟 / 分配次数压测工具
+ * @details
+ * [测试覆盖]
+ * 1. FireGlobal (kDirect): 0 / 1 / 10 / 100 个订阅者，1 / 2 / 4 / 8 个发布线程。
+ * 2. 事件提升分配: kDirect + kQueued 订阅下，普通事件与池化事件的 allocs/fire。
+ * 3. kQueued 扇出: 1 / 10 / 100 个订阅者，1 / 4 个派发线程，
+ *    统计发布端 ns/fire 以及 Fire -> 回调的投递延迟 p50 / p99 / p999。
+ * 4. FireToSender: 1 / 100 / 10000 个发送者轮流发布 (每个发送者 1 个订阅者)。
+ * 5. 订阅抖动: 发布线程持续 Fire 的同时，另一个线程不断订阅 / 断开。
+ * 6. GC 开销: 大量订阅者失效后，一轮 GC 批处理在派发线程上的耗时。
+ *
+ * 本工具替换了全局 `operator new`，统计测量区间内的堆分配次数 (所有线程合计)。
+ *
+ * 用法: tool_event_benchmark [fires]   (fires 缺省为 200000，用于缩放所有场景)
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "framework/z3y_framework.h"
+#include "framework/z3y_define_impl.h"
+
+// --- 全局分配计数 ---
+namespace {
+    std::atomic<size_t> g_alloc_count{ 0 };
+}
+
+void* operator new(std::size_t size) {
+    g_alloc_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void* operator new[](std::size_t size) { return ::operator new(size); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+// --- 压测参数配置 ---
+const int kWarmupFires = 10000;
+int g_measured_fires = 200000;  // 可由命令行覆盖
+
+using Clock = std::chrono::steady_clock;
+
+int64_t NowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+struct PlainTickEvent : public z3y::Event {
+    Z3Y_DEFINE_EVENT(PlainTickEvent, "z3y-bench-plain-tick-event-UUID")
+    explicit PlainTickEvent(uint64_t f) : frame(f) {}
+    uint64_t frame;
+};
+
+struct PooledTickEvent : public z3y::Event {
+    Z3Y_DEFINE_POOLED_EVENT(PooledTickEvent, "z3y-bench-pooled-tick-event-UUID")
+    explicit PooledTickEvent(uint64_t f) : frame(f) {}
+    uint64_t frame;
+};
+
+/** @brief 携带发布时间戳的事件，用于测量投递延迟。 */
+struct StampEvent : public z3y::Event {
+    Z3Y_DEFINE_EVENT(StampEvent, "z3y-bench-stamp-event-UUID")
+    explicit StampEvent(int64_t t) : fired_ns(t) {}
+    int64_t fired_ns;
+};
+
+/** @brief 最简订阅者：只累加帧号 (线程本地)，避免回调本身成为瓶颈或产生数据竞争。 */
+thread_local uint64_t t_sink_sum = 0;
+class TickSink : public std::enable_shared_from_this<TickSink> {
+public:
+    void OnPlain(const PlainTickEvent& e) { t_sink_sum += e.frame; }
+    void OnPooled(const PooledTickEvent& e) { t_sink_sum += e.frame; }
+};
+
+/**
+ * @brief 延迟采样订阅者。
+ * @details 同一订阅者的 kQueued 回调固定在一个派发线程上执行，因此 samples 无需加锁。
+ */
+class LatencySink : public std::enable_shared_from_this<LatencySink> {
+public:
+    explicit LatencySink(std::atomic<size_t>* delivered, size_t expected) : delivered_(delivered) {
+        samples.reserve(expected);
+    }
+    void OnStamp(const StampEvent& e) {
+        samples.push_back(NowNs() - e.fired_ns);
+        delivered_->fetch_add(1, std::memory_order_release);
+    }
+    std::vector<int64_t> samples;
+
+private:
+    std::atomic<size_t>* delivered_;
+};
+
+/** @brief 作为 FireToSender 发送者的最简组件。 */
+class BenchSender : public z3y::PluginImpl<BenchSender> {
+public:
+    Z3Y_DEFINE_COMPONENT_ID("z3y-bench-sender-UUID");
+};
+
+/** @brief 一次压测会话：按给定参数创建框架，离开作用域时销毁。 */
+class BusSession {
+public:
+    explicit BusSession(const z3y::PluginManagerOptions& options = z3y::PluginManagerOptions())
+        : manager(z3y::PluginManager::Create(options)),
+        bus(z3y::GetDefaultService<z3y::IEventBus>()) {
+    }
+    ~BusSession() {
+        bus.reset();
+        manager.reset();
+        z3y::PluginManager::Destroy();
+    }
+    z3y::PluginPtr<z3y::PluginManager> manager;
+    z3y::PluginPtr<z3y::IEventBus> bus;
+};
+
+void PrintSeparator(const std::string& title) {
+    std::cout << "\n=============================================================\n"
+        << " " << title << "\n"
+        << "=============================================================" << std::endl;
+}
+
+/** @brief 一段测量区间的结果。 */
+struct Measurement {
+    double ns_per_op = 0;
+    double allocs_per_op = 0;
+};
+
+/**
+ * @brief 用 thread_count 个线程并发执行 body(thread_index)，每个线程执行 ops_per_thread 次操作。
+ * @return 墙钟时间折算的 ns/op 与所有线程合计的 allocs/op。
+ */
+template <typename Body>
+Measurement MeasureParallel(int thread_count, int ops_per_thread, Body&& body) {
+    std::atomic<int> ready{ 0 };
+    std::atomic<bool> go{ false };
+    std::vector<std::thread> threads;
+    threads.reserve(thread_count);
+    for (int t = 0; t < thread_count; ++t) {
+        threads.emplace_back([&, t] {
+            ready.fetch_add(1);
+            while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+            body(t);
+            });
+    }
+    while (ready.load() != thread_count) std::this_thread::yield();
+
+    size_t allocs_before = g_alloc_count.load(std::memory_order_relaxed);
+    auto start_time = Clock::now();
+    go.store(true, std::memory_order_release);
+    for (auto& t : threads) t.join();
+    auto end_time = Clock::now();
+    size_t allocs = g_alloc_count.load(std::memory_order_relaxed) - allocs_before;
+
+    const double total_ops = static_cast<double>(thread_count) * ops_per_thread;
+    Measurement m;
+    m.ns_per_op = std::chrono::duration<double, std::nano>(end_time - start_time).count() / total_ops;
+    m.allocs_per_op = static_cast<double>(allocs) / total_ops;
+    return m;
+}
+
+void PrintMeasurement(const std::string& label, const Measurement& m) {
+    std::cout << std::left << std::setw(34) << label
+        << " ns/op: " << std::right << std::setw(9) << std::fixed << std::setprecision(1) << m.ns_per_op
+        << "    allocs/op: " << std::setw(7) << std::setprecision(3) << m.allocs_per_op << std::endl;
+}
+
+/** @brief 输出 p50 / p99 / p999 (单位 us)。 */
+void PrintLatency(std::vector<int64_t>& samples) {
+    if (samples.empty()) {
+        std::cout << "    latency: (no samples)" << std::endl;
+        return;
+    }
+    std::sort(samples.begin(), samples.end());
+    auto pct = [&samples](double p) {
+        size_t index = static_cast<size_t>(p * static_cast<double>(samples.size() - 1));
+        return static_cast<double>(samples[index]) / 1000.0;
+    };
+    std::cout << "    latency(us) p50: " << std::setprecision(2) << pct(0.50)
+        << "  p99: " << pct(0.99) << "  p999: " << pct(0.999)
+        << "  max: " << static_cast<double>(samples.back()) / 1000.0
+        << "  (samples " << samples.size() << ")" << std::endl;
+}
+
+// =============================================================================
+// 1. FireGlobal (kDirect) 订阅者数量 × 发布线程数
+// =============================================================================
+void RunDirectFanoutBenchmark() {
+    PrintSeparator("1. FireGlobal kDirect: 订阅者数量 x 发布线程数");
+    std::cout << "配置: 每组合计 " << g_measured_fires << " 次 Fire" << std::endl;
+
+    for (int subscribers : { 0, 1, 10, 100 }) {
+        BusSession session;
+        std::vector<std::shared_ptr<TickSink>> sinks;
+        std::vector<z3y::ScopedConnection> conns;
+        for (int i = 0; i < subscribers; ++i) {
+            sinks.push_back(std::make_shared<TickSink>());
+            conns.emplace_back(session.bus->SubscribeGlobal<PlainTickEvent>(sinks.back(), &TickSink::OnPlain));
+        }
+        for (int i = 0; i < kWarmupFires; ++i) session.bus->FireGlobal<PlainTickEvent>(static_cast<uint64_t>(i));
+
+        for (int threads : { 1, 2, 4, 8 }) {
+            const int per_thread = g_measured_fires / threads;
+            Measurement m = MeasureParallel(threads, per_thread, [&](int) {
+                for (int i = 0; i < per_thread; ++i) session.bus->FireGlobal<PlainTickEvent>(static_cast<uint64_t>(i));
+                });
+            PrintMeasurement("subs=" + std::to_string(subscribers) + " threads=" + std::to_string(threads), m);
+        }
+    }
+}
+
+// =============================================================================
+// 2. 事件提升分配 (kDirect + kQueued)
+// =============================================================================
+template <typename TEvent>
+void RunPromotionCase(const z3y::PluginPtr<z3y::IEventBus>& bus, const char* label, int fires) {
+    for (int i = 0; i < kWarmupFires; ++i) bus->FireGlobal<TEvent>(static_cast<uint64_t>(i));
+    Measurement m = MeasureParallel(1, fires, [&](int) {
+        for (int i = 0; i < fires; ++i) bus->FireGlobal<TEvent>(static_cast<uint64_t>(i));
+        });
+    PrintMeasurement(label, m);
+}
+
+void RunPromotionBenchmark() {
+    PrintSeparator("2. 事件提升分配: kDirect 与 kDirect + kQueued");
+    BusSession session;
+    auto sink = std::make_shared<TickSink>();
+    auto queued_sink = std::make_shared<TickSink>();
+    const int fires = std::max(1, g_measured_fires / 2);
+
+    z3y::ScopedConnection plain_conn = session.bus->SubscribeGlobal<PlainTickEvent>(sink, &TickSink::OnPlain);
+    z3y::ScopedConnection pooled_conn = session.bus->SubscribeGlobal<PooledTickEvent>(sink, &TickSink::OnPooled);
+    RunPromotionCase<PlainTickEvent>(session.bus, "direct-only plain", fires);
+    RunPromotionCase<PooledTickEvent>(session.bus, "direct-only pooled", fires);
+
+    z3y::ScopedConnection plain_queued = session.bus->SubscribeGlobal<PlainTickEvent>(
+        queued_sink, &TickSink::OnPlain, z3y::ConnectionType::kQueued);
+    z3y::ScopedConnection pooled_queued = session.bus->SubscribeGlobal<PooledTickEvent>(
+        queued_sink, &TickSink::OnPooled, z3y::ConnectionType::kQueued);
+    RunPromotionCase<PlainTickEvent>(session.bus, "direct+queued plain", fires);
+    RunPromotionCase<PooledTickEvent>(session.bus, "direct+queued pooled", fires);
+
+    z3y::EventPoolStats stats = z3y::GetEventPoolStats();
+    std::cout << "池统计: heap_allocations=" << stats.heap_allocations
+        << ", pool_hits=" << stats.pool_hits << std::endl;
+}
+
+// =============================================================================
+// 3. kQueued 扇出与投递延迟
+// =============================================================================
+void RunQueuedFanoutBenchmark() {
+    PrintSeparator("3. kQueued 扇出: 订阅者数量 x 派发线程数 (含投递延迟)");
+
+    for (size_t workers : { 1u, 4u }) {
+        for (int subscribers : { 1, 10, 100 }) {
+            // 保持每组的总回调数大致相同
+            const int fires = std::max(100, g_measured_fires / 10 / subscribers);
+            const size_t expected = static_cast<size_t>(fires) * subscribers;
+
+            z3y::PluginManagerOptions options;
+            options.event_dispatch_threads = workers;
+            BusSession session(options);
+
+            std::atomic<size_t> delivered{ 0 };
+            std::vector<std::shared_ptr<LatencySink>> sinks;
+            std::vector<z3y::ScopedConnection> conns;
+            for (int i = 0; i < subscribers; ++i) {
+                sinks.push_back(std::make_shared<LatencySink>(&delivered, static_cast<size_t>(fires)));
+                conns.emplace_back(session.bus->SubscribeGlobal<StampEvent>(
+                    sinks.back(), &LatencySink::OnStamp, z3y::ConnectionType::kQueued));
+            }
+
+            Measurement m = MeasureParallel(1, fires, [&](int) {
+                for (int i = 0; i < fires; ++i) session.bus->FireGlobal<StampEvent>(NowNs());
+                });
+            while (delivered.load(std::memory_order_acquire) < expected) std::this_thread::yield();
+
+            PrintMeasurement("workers=" + std::to_string(workers) + " subs=" + std::to_string(subscribers)
+                + " (publish)", m);
+            std::vector<int64_t> all;
+            all.reserve(expected);
+            for (auto& sink : sinks) all.insert(all.end(), sink->samples.begin(), sink->samples.end());
+            PrintLatency(all);
+        }
+    }
+}
+
+// =============================================================================
+// 4. FireToSender: 大量发送者
+// =============================================================================
+void RunSenderBenchmark() {
+    PrintSeparator("4. FireToSender: 发送者数量 (每个发送者 1 个 kDirect 订阅者)");
+
+    for (int sender_count : { 1, 100, 10000 }) {
+        BusSession session;
+        auto sink = std::make_shared<TickSink>();
+        std::vector<std::shared_ptr<BenchSender>> senders;
+        std::vector<z3y::ScopedConnection> conns;
+        senders.reserve(sender_count);
+        for (int i = 0; i < sender_count; ++i) {
+            senders.push_back(std::make_shared<BenchSender>());
+            conns.emplace_back(session.bus->SubscribeToSender<PlainTickEvent>(senders.back(), sink, &TickSink::OnPlain));
+        }
+
+        for (int threads : { 1, 4 }) {
+            const int per_thread = g_measured_fires / threads;
+            Measurement m = MeasureParallel(threads, per_thread, [&](int t) {
+                size_t index = static_cast<size_t>(t) % senders.size();
+                for (int i = 0; i < per_thread; ++i) {
+                    session.bus->FireToSender<PlainTickEvent>(senders[index], static_cast<uint64_t>(i));
+                    if (++index == senders.size()) index = 0;
+                }
+                });
+            PrintMeasurement("senders=" + std::to_string(sender_count) + " threads=" + std::to_string(threads), m);
+        }
+    }
+}
+
+// =============================================================================
+// 5. 订阅抖动下的发布
+// =============================================================================
+void RunChurnBenchmark() {
+    PrintSeparator("5. 订阅抖动: 持续 Subscribe/Disconnect 期间的 FireGlobal");
+
+    for (int threads : { 1, 4 }) {
+        BusSession session;
+        auto stable = std::make_shared<TickSink>();
+        z3y::ScopedConnection stable_conn = session.bus->SubscribeGlobal<PlainTickEvent>(stable, &TickSink::OnPlain);
+
+        std::atomic<bool> churning{ true };
+        std::atomic<size_t> churn_ops{ 0 };
+        std::thread churn([&] {
+            auto churner = std::make_shared<TickSink>();
+            while (churning.load(std::memory_order_relaxed)) {
+                z3y::ScopedConnection conn = session.bus->SubscribeGlobal<PlainTickEvent>(churner, &TickSink::OnPlain);
+                churn_ops.fetch_add(1, std::memory_order_relaxed);
+            }
+            });
+
+        const int per_thread = g_measured_fires / threads;
+        auto start_time = Clock::now();
+        Measurement m = MeasureParallel(threads, per_thread, [&](int) {
+            for (int i = 0; i < per_thread; ++i) session.bus->FireGlobal<PlainTickEvent>(static_cast<uint64_t>(i));
+            });
+        double seconds = std::chrono::duration<double>(Clock::now() - start_time).count();
+        churning = false;
+        churn.join();
+
+        PrintMeasurement("fire threads=" + std::to_string(threads), m);
+        std::cout << "    churn: " << std::setprecision(0) << churn_ops.load() / seconds
+            << " subscribe+disconnect/s (allocs/op 含抖动线程)" << std::endl;
+    }
+}
+
+// =============================================================================
+// 6. GC 开销
+// =============================================================================
+void RunGcBenchmark() {
+    PrintSeparator("6. GC: 订阅者失效后单次 GC 任务耗时");
+
+    for (int subscribers : { 100, 1000, 10000 }) {
+        BusSession session;
+        std::atomic<int64_t> gc_start{ 0 };
+        std::atomic<int64_t> gc_ns{ -1 };
+        // 本场景没有 kQueued 订阅者，派发线程上执行的任务只有 GC 批处理
+        session.manager->SetEventTraceHook([&](z3y::EventTracePoint point, z3y::EventId, void*, const char*) {
+            if (point == z3y::EventTracePoint::kQueuedExecuteStart) gc_start = NowNs();
+            if (point == z3y::EventTracePoint::kQueuedExecuteEnd) gc_ns = NowNs() - gc_start.load();
+            });
+
+        std::vector<std::shared_ptr<TickSink>> sinks;
+        std::vector<z3y::Connection> conns;
+        for (int i = 0; i < subscribers; ++i) {
+            sinks.push_back(std::make_shared<TickSink>());
+            conns.push_back(session.bus->SubscribeGlobal<PlainTickEvent>(sinks.back(), &TickSink::OnPlain));
+        }
+        // 一半订阅者死亡 (不主动断开)，留给惰性 GC 清理
+        for (size_t i = 0; i < sinks.size(); i += 2) sinks[i].reset();
+
+        auto fire_start = Clock::now();
+        session.bus->FireGlobal<PlainTickEvent>(1);  // 发现失效订阅 -> 调度 GC
+        double dirty_fire_us = std::chrono::duration<double, std::micro>(Clock::now() - fire_start).count();
+        for (int i = 0; i < 2000 && gc_ns.load() < 0; ++i) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+        fire_start = Clock::now();
+        session.bus->FireGlobal<PlainTickEvent>(2);
+        double clean_fire_us = std::chrono::duration<double, std::micro>(Clock::now() - fire_start).count();
+
+        std::cout << std::left << std::setw(14) << ("subs=" + std::to_string(subscribers))
+            << std::fixed << std::setprecision(2)
+            << " GC pass(us): " << static_cast<double>(gc_ns.load()) / 1000.0
+            << "    fire before GC(us): " << dirty_fire_us
+            << "    fire after GC(us): " << clean_fire_us << std::endl;
+        session.manager->SetEventTraceHook(nullptr);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1) {
+        int fires = std::atoi(argv[1]);
+        if (fires > 0) g_measured_fires = fires;
+    }
+    try {
+        std::cout << "tool_event_benchmark: fires=" << g_measured_fires
+            << ", hardware threads=" << std::thread::hardware_concurrency() << std::endl;
+        RunDirectFanoutBenchmark();
+        RunPromotionBenchmark();
+        RunQueuedFanoutBenchmark();
+        RunSenderBenchmark();
+        RunChurnBenchmark();
+        RunGcBenchmark();
+    } catch (const std::exception& e) {
+        std::cerr << "[Fatal Exception] " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
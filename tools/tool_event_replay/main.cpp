@@ -0,0 +1,221 @@
+﻿/*
+* Copyright [2025] [Yue Liu]
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/**
+ * @file main.cpp
+ * @brief 事件录制文件 (`EventRecorder` 生成) 的查看与回放压测工具
+ * @details
+ * 1. `--info`：按事件 ID 汇总条数与负载字节，并给出录制时长与开始时刻。
+ * 2. 回放 (默认)：创建一个 `PluginManager`，可选加载插件目录，按 1 倍速 / N 倍速 / 尽可能快
+ *    (`--speed=max`) 重新发布录制的流量，输出实际发布速率与相对计划的最大落后。
+ *
+ * 本工具不认识录制中的具体事件类型，所有记录都以通用的 `event::ReplayedEvent` 发布
+ * (携带原始 ID 与负载)；`--subscribers=N` 挂上 N 个 kDirect 订阅者模拟扇出。
+ * 要让插件收到原类型的事件，请在宿主中用 `EventReplayer::Register<TEvent>()` 注册还原方式后回放。
+ *
+ * 用法: tool_event_replay <录制文件> [--info] [--speed=<倍数>|max] [--repeat=<N>]
+ *                         [--subscribers=<N>] [--plugins=<目录>]
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "common/cli_args.h"
+#include "framework/z3y_framework.h"
+
+namespace {
+
+    using z3y::tools::ForEachArgument;
+    using z3y::tools::StartsWith;
+
+    struct Arguments {
+        std::string file;
+        bool info = false;
+        double speed = 1.0;
+        uint32_t repeat = 1;
+        int subscribers = 1;
+        std::string plugins;
+    };
+
+    void PrintUsage() {
+        std::cerr << "Usage: tool_event_replay <recording> [--info] [--speed=<factor>|max] [--repeat=<N>]\n"
+            << "                         [--subscribers=<N>] [--plugins=<dir>]" << std::endl;
+    }
+
+    bool ParseArguments(int argc, char* argv[], Arguments& args) {
+        const bool accepted = ForEachArgument(argc, argv, [&args](const std::string& arg) {
+            std::string value;
+            if (arg == "--info") {
+                args.info = true;
+            } else if (StartsWith(arg, "--speed=", value)) {
+                args.speed = value == "max" ? 0.0 : std::atof(value.c_str());
+                if (value != "max" && args.speed <= 0.0) return false;
+            } else if (StartsWith(arg, "--repeat=", value)) {
+                args.repeat = static_cast<uint32_t>(std::max(1, std::atoi(value.c_str())));
+            } else if (StartsWith(arg, "--subscribers=", value)) {
+                args.subscribers = std::max(0, std::atoi(value.c_str()));
+            } else if (StartsWith(arg, "--plugins=", value)) {
+                args.plugins = value;
+            } else if (!arg.empty() && arg[0] != '-' && args.file.empty()) {
+                args.file = arg;
+            } else {
+                return false;
+            }
+            return true;
+        });
+        return accepted && !args.file.empty();
+    }
+
+    /** @brief 统计每种原始事件 ID 的条数与负载字节。 */
+    class RecordingSummary : public std::enable_shared_from_this<RecordingSummary> {
+    public:
+        struct Entry {
+            uint64_t count = 0;
+            uint64_t payload_bytes = 0;
+            bool has_payload = false;
+        };
+        std::map<z3y::EventId, Entry> entries;
+
+        void OnEvent(const z3y::event::ReplayedEvent& e) {
+            Entry& entry = entries[e.original_id_];
+            ++entry.count;
+            entry.payload_bytes += e.payload_.size();
+            entry.has_payload = entry.has_payload || e.has_payload_;
+        }
+    };
+
+    /** @brief 模拟扇出的最简订阅者。 */
+    class CountingSink : public std::enable_shared_from_this<CountingSink> {
+    public:
+        std::atomic<uint64_t> received{ 0 };
+        void OnEvent(const z3y::event::ReplayedEvent&) { received.fetch_add(1, std::memory_order_relaxed); }
+    };
+
+    /** @brief 一次会话：创建框架，离开作用域时销毁。 */
+    class BusSession {
+    public:
+        BusSession()
+            : manager(z3y::PluginManager::Create()),
+            bus(z3y::GetDefaultService<z3y::IEventBus>()) {
+        }
+        ~BusSession() {
+            bus.reset();
+            manager.reset();
+            z3y::PluginManager::Destroy();
+        }
+        z3y::PluginPtr<z3y::PluginManager> manager;
+        z3y::PluginPtr<z3y::IEventBus> bus;
+    };
+
+    int PrintInfo(const Arguments& args) {
+        BusSession session;
+        std::string err;
+        auto replayer = z3y::EventReplayer::Open(args.file, session.bus, err);
+        if (!replayer) {
+            std::cerr << err << std::endl;
+            return 1;
+        }
+        auto summary = std::make_shared<RecordingSummary>();
+        z3y::ScopedConnection conn =
+            session.bus->SubscribeGlobal<z3y::event::ReplayedEvent>(summary, &RecordingSummary::OnEvent);
+        z3y::ReplayOptions options;
+        options.speed = 0;
+        options.raw_fallback = true;
+        const z3y::ReplayStats stats = replayer->Run(options);
+
+        std::cout << "file:        " << args.file << "\n"
+            << "events:      " << replayer->GetEventCount() << "\n"
+            << "duration(ms): " << std::fixed << std::setprecision(3) << stats.recorded_ns / 1e6 << "\n"
+            << "start(unix ns): " << replayer->GetStartTimeNs() << "\n\n"
+            << std::left << std::setw(20) << "event id" << std::right << std::setw(12) << "count"
+            << std::setw(16) << "payload bytes" << std::setw(12) << "avg bytes" << "\n";
+        for (const auto& [id, entry] : summary->entries) {
+            std::cout << "0x" << std::hex << std::setw(16) << std::setfill('0') << id
+                << std::dec << std::setfill(' ') << "  " << std::setw(12) << entry.count;
+            if (entry.has_payload) {
+                std::cout << std::setw(16) << entry.payload_bytes << std::setw(12) << std::setprecision(1)
+                    << double(entry.payload_bytes) / double(entry.count);
+            } else {
+                std::cout << std::setw(16) << "-" << std::setw(12) << "-";
+            }
+            std::cout << "\n";
+        }
+        std::cout << std::flush;
+        return 0;
+    }
+
+    int Replay(const Arguments& args) {
+        BusSession session;
+        if (!args.plugins.empty()) {
+            const auto failures = session.manager->LoadPluginsFromDirectory(args.plugins);
+            for (const auto& failure : failures) std::cerr << "[plugin] " << failure << std::endl;
+        }
+        std::string err;
+        auto replayer = z3y::EventReplayer::Open(args.file, session.bus, err);
+        if (!replayer) {
+            std::cerr << err << std::endl;
+            return 1;
+        }
+        std::vector<std::shared_ptr<CountingSink>> sinks;
+        std::vector<z3y::ScopedConnection> connections;
+        for (int i = 0; i < args.subscribers; ++i) {
+            sinks.push_back(std::make_shared<CountingSink>());
+            connections.emplace_back(
+                session.bus->SubscribeGlobal<z3y::event::ReplayedEvent>(sinks.back(), &CountingSink::OnEvent));
+        }
+
+        z3y::ReplayOptions options;
+        options.speed = args.speed;
+        options.repeat = args.repeat;
+        options.raw_fallback = true;
+        std::cout << "tool_event_replay: " << replayer->GetEventCount() << " events x " << args.repeat
+            << " at speed " << (args.speed > 0 ? std::to_string(args.speed) + "x" : std::string("max"))
+            << ", subscribers=" << args.subscribers << std::endl;
+        const z3y::ReplayStats stats = replayer->Run(options);
+
+        std::cout << std::fixed << std::setprecision(3)
+            << "    fired:          " << stats.raw_events + stats.replayed_events << "\n"
+            << "    failures:       " << stats.decode_failures << "\n"
+            << "    recorded(ms):   " << stats.recorded_ns / 1e6 << " per round\n"
+            << "    elapsed(ms):    " << stats.elapsed_ns / 1e6 << "\n"
+            << "    events/s:       " << std::setprecision(0) << stats.EventsPerSecond() << "\n"
+            << "    max lag(us):    " << std::setprecision(1) << stats.max_lag_ns / 1e3 << std::endl;
+        return 0;
+    }
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    Arguments args;
+    if (!ParseArguments(argc, argv, args)) {
+        PrintUsage();
+        return 2;
+    }
+    try {
+        return args.info ? PrintInfo(args) : Replay(args);
+    } catch (const std::exception& e) {
+        std::cerr << "[Fatal Exception] " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -23,15 +23,35 @@
  * 2. 高级路由: 验证不同模块 (System, Business, Algo) 的日志是否按配置分流到了不同文件。
  * 3. 动态运维: 验证 SetLevel 是否能精确控制指定命名空间的日志等级。
  * 4. 性能压测: 模拟多业务线程并发写入，计算 QPS。
+ * 5. 回归套件 (--suite): 线程数 / 消息长度 / 级别关闭 / 观察者 / 延迟格式化 / 满载策略 /
+ *    入队后端 (spdlog 队列 vs 线程环) 的参数扫描，输出逐次调用延迟分位数 (p50/p99/p99.9/max) 与每条日志的堆分配次数，
+ *    结果写成 JSON，便于跨框架版本对比。
+ *
+ * 用法:
+ *   tool_log_benchmark                              功能验证 + 混合压测 (人工查看)
+ *   tool_log_benchmark --suite [--json out.json] [--logs N]
+ *     N 为每个线程的日志条数 (缺省 20000)；未指定 --json 时写入 <exe 目录>/log_benchmark_result.json。
+ *
+ * 堆分配统计通过替换本进程的全局 operator new 实现，只统计调用线程上的分配
+ * (后台线程的分配不计入)。Linux 下插件中的 new 同样解析到这里；Windows 上每个 DLL
+ * 使用自己的 CRT new，只能统计到本工具与框架头文件内联代码中的分配。
  */
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
+#include <cstdlib>
+#include <ctime>
 #include <filesystem>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <new>
+#include <string>
 #include <thread>
 #include <vector>
-#include <iomanip>
+
+#include <nlohmann/json.hpp>
 
  // 引入框架和日志接口
 #include "framework/z3y_framework.h"
@@ -40,12 +60,32 @@
 
 #ifdef _WIN32
 #include <Windows.h>
+#else
+#include <climits>
+#include <unistd.h>
 #endif
 
 using z3y::interfaces::core::ILogger;
 using z3y::interfaces::core::ILogManagerService;
 using z3y::interfaces::core::LogLevel;
 using z3y::PluginPtr;
+using z3y::interfaces::core::LogRecord;
+
+// --- 堆分配计数 (仅调用线程) ---
+namespace {
+thread_local uint64_t t_alloc_count = 0;
+}  // namespace
+
+void* operator new(std::size_t size) {
+    ++t_alloc_count;
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t size) { return operator new(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
 
 // --- 压测参数配置 ---
 const int kThreadCount = 8;           // 总并发线程数
@@ -131,8 +171,9 @@ void RunDetailedFunctionalTest(PluginPtr<ILogManagerService> log_mgr) {
 /**
  * @brief [混合性能压测] 模拟真实场景下的多模块并发写入
  */
-void RunMixedPerformanceTest(PluginPtr<ILogManagerService> log_mgr) {
-    PrintSeparator("2. 混合负载压测 (Mixed Workload Benchmark)");
+void RunMixedPerformanceTest(PluginPtr<ILogManagerService> log_mgr, bool deferred) {
+    PrintSeparator(deferred ? "2b. 混合负载压测 - 延迟格式化 (Z3Y_LOG_DEFERRED_INFO)"
+                            : "2a. 混合负载压测 (Mixed Workload Benchmark)");
 
     // 提前获取 Logger，避免计入压测耗时
     auto logger_sys = log_mgr->GetLogger(kLogNameSys);
@@ -157,7 +198,11 @@ void RunMixedPerformanceTest(PluginPtr<ILogManagerService> log_mgr) {
 
             for (int j = 0; j < kLogsPerThread; ++j) {
                 // 带参数格式化，模拟真实开销
-                Z3Y_LOG_INFO(target_logger, "Bench thread {}, seq {}, payload data 1234567890", i, j);
+                if (deferred) {
+                    Z3Y_LOG_DEFERRED_INFO(target_logger, "Bench thread {}, seq {}, payload data 1234567890", i, j);
+                } else {
+                    Z3Y_LOG_INFO(target_logger, "Bench thread {}, seq {}, payload data 1234567890", i, j);
+                }
             }
             finished_threads++;
             });
@@ -181,17 +226,274 @@ void RunMixedPerformanceTest(PluginPtr<ILogManagerService> log_mgr) {
     std::cout << "-------------------------------------------------------------" << std::endl;
 }
 
+
+// =============================================================
+// 回归套件 (--suite)
+// =============================================================
+
+/** @brief 一个压测场景。未列出的维度取基准值 (4 线程 / 64 字节 / 启用 / 无观察者 / 同步格式化)。 */
+struct SuiteCase {
+    std::string group;       // 所属扫描维度
+    int threads = 4;
+    size_t message_bytes = 64;
+    bool enabled = true;     // false: 以低于有效级别的 Debug 调用 (IsEnabled 短路)
+    bool observer = false;   // 挂一个空的逐条观察者
+    bool deferred = false;   // Z3Y_LOG_DEFERRED_INFO
+};
+
+std::vector<SuiteCase> BuildSuiteCases() {
+    std::vector<SuiteCase> cases;
+    for (int threads : {1, 2, 4, 8}) {
+        SuiteCase c;
+        c.group = "thread_sweep";
+        c.threads = threads;
+        cases.push_back(c);
+    }
+    for (size_t bytes : {16, 256, 1024}) {  // 64 字节即 thread_sweep 中 4 线程的基准
+        SuiteCase c;
+        c.group = "message_size_sweep";
+        c.message_bytes = bytes;
+        cases.push_back(c);
+    }
+    SuiteCase disabled;
+    disabled.group = "level_disabled";
+    disabled.enabled = false;
+    cases.push_back(disabled);
+
+    SuiteCase observed;
+    observed.group = "observer";
+    observed.observer = true;
+    cases.push_back(observed);
+
+    SuiteCase deferred;
+    deferred.group = "deferred_format";
+    deferred.deferred = true;
+    cases.push_back(deferred);
+    return cases;
+}
+
+/** @brief 套件的一组全局设置 (每组使用一个新的 PluginManager)。 */
+struct SuiteBackend {
+    std::string policy;   // async_overflow_policy
+    std::string backend;  // async_backend
+};
+
+/** @brief 生成套件配置：唯一的文件 Sink (Info)，满载策略与入队后端可选。 */
+std::filesystem::path WriteSuiteConfig(const std::filesystem::path& dir, const SuiteBackend& setup) {
+    const std::string tag = setup.policy + "_" + setup.backend;
+    nlohmann::json config = {
+        {"global_settings", {
+            {"format_pattern", "[%Y-%m-%d %H:%M:%S.%e] [%t] [%n] [%-5l] %v"},
+            {"async_queue_size", 32768},
+            {"async_overflow_policy", setup.policy},
+            {"async_backend", setup.backend},
+            {"deferred_ring_kb", 1024},
+            {"flush_on_level", "error"}}},
+        {"sinks", {{"suite_file", {
+            {"type", "rotating_file_sink"},
+            {"base_name", "suite_" + tag + ".log"},
+            {"max_size", 104857600},
+            {"max_files", 1},
+            {"level", "Info"}}}}},
+        {"default_rule", {{"sinks", {"suite_file"}}}}};
+    std::filesystem::create_directories(dir);
+    auto path = dir / ("suite_config_" + tag + ".json");
+    std::ofstream(path) << config.dump(2);
+    return path;
+}
+
+double Percentile(const std::vector<uint32_t>& sorted, double q) {
+    if (sorted.empty()) return 0.0;
+    const size_t index = std::min(sorted.size() - 1, static_cast<size_t>(q * (sorted.size() - 1) + 0.5));
+    return sorted[index];
+}
+
+nlohmann::json RunSuiteCase(PluginPtr<ILogManagerService> log_mgr, const SuiteCase& c,
+                            const SuiteBackend& setup, int logs_per_thread) {
+    auto logger = log_mgr->GetLogger("Bench.Suite");
+    if (c.observer) {
+        log_mgr->AddLogObserver("bench_observer", [](const LogRecord&) {});
+    }
+    const std::string payload(c.message_bytes, 'x');
+
+    std::vector<std::vector<uint32_t>> latencies(c.threads);
+    std::vector<uint64_t> allocs(c.threads, 0);
+    std::atomic<int> ready{0};
+    std::atomic<bool> go{false};
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < c.threads; ++t) {
+        threads.emplace_back([&, t]() {
+            auto& samples = latencies[t];
+            samples.resize(logs_per_thread);  // 预分配，不计入被测区间
+            ready++;
+            while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+
+            const uint64_t allocs_before = t_alloc_count;
+            for (int j = 0; j < logs_per_thread; ++j) {
+                const auto begin = std::chrono::steady_clock::now();
+                if (!c.enabled) {
+                    Z3Y_LOG_DEBUG(logger, "Bench thread {}, seq {}, {}", t, j, payload);
+                } else if (c.deferred) {
+                    Z3Y_LOG_DEFERRED_INFO(logger, "Bench thread {}, seq {}, {}", t, j, payload.c_str());
+                } else {
+                    Z3Y_LOG_INFO(logger, "Bench thread {}, seq {}, {}", t, j, payload);
+                }
+                const auto end = std::chrono::steady_clock::now();
+                samples[j] = static_cast<uint32_t>(std::min<long long>(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count(), UINT32_MAX));
+            }
+            allocs[t] = t_alloc_count - allocs_before;
+        });
+    }
+    while (ready.load() < c.threads) std::this_thread::yield();
+    const auto start_time = std::chrono::steady_clock::now();
+    go.store(true, std::memory_order_release);
+    for (auto& th : threads) th.join();
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+
+    if (c.observer) log_mgr->RemoveLogObserver("bench_observer");
+    // 让后台线程排空，避免积压影响下一个场景
+    log_mgr->Flush();
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    std::vector<uint32_t> all;
+    all.reserve(static_cast<size_t>(c.threads) * logs_per_thread);
+    uint64_t total_allocs = 0;
+    double sum = 0;
+    for (int t = 0; t < c.threads; ++t) {
+        all.insert(all.end(), latencies[t].begin(), latencies[t].end());
+        total_allocs += allocs[t];
+    }
+    for (uint32_t v : all) sum += v;
+    std::sort(all.begin(), all.end());
+    const double total = static_cast<double>(all.size());
+
+    return {
+        {"group", c.group},
+        {"policy", setup.policy},
+        {"backend", setup.backend},
+        {"threads", c.threads},
+        {"message_bytes", c.message_bytes},
+        {"enabled", c.enabled},
+        {"observer", c.observer},
+        {"api", c.deferred ? "deferred" : "sync"},
+        {"total_logs", all.size()},
+        {"elapsed_s", elapsed},
+        {"throughput_logs_per_s", total / elapsed},
+        {"latency_ns", {
+            {"mean", sum / total},
+            {"p50", Percentile(all, 0.50)},
+            {"p99", Percentile(all, 0.99)},
+            {"p999", Percentile(all, 0.999)},
+            {"max", all.empty() ? 0.0 : static_cast<double>(all.back())}}},
+        {"allocs_per_log", static_cast<double>(total_allocs) / total}};
+}
+
+/**
+ * @brief 运行回归套件。每组满载策略 / 入队后端使用一个新的 PluginManager
+ * (二者只能在 InitializeService 时设置)。
+ */
+int RunSuite(const std::filesystem::path& exe_dir, const std::filesystem::path& json_path, int logs_per_thread) {
+    nlohmann::json result;
+    result["schema"] = "z3y.log_benchmark/1";
+    result["framework_version"] = Z3Y_BENCH_FRAMEWORK_VERSION;
+#ifdef Z3Y_IS_DEBUG_BUILD
+    result["build_type"] = "Debug";
+#else
+    result["build_type"] = "Release";
+#endif
+#ifdef _WIN32
+    result["platform"] = "windows";
+#else
+    result["platform"] = "linux";
+#endif
+    result["hardware_threads"] = std::thread::hardware_concurrency();
+    result["timestamp"] = static_cast<int64_t>(std::time(nullptr));
+    result["logs_per_thread"] = logs_per_thread;
+    result["cases"] = nlohmann::json::array();
+
+    const auto cases = BuildSuiteCases();
+    const auto log_root = exe_dir / "bench_logs";
+    // thread_rings 只支持 block (overrun_oldest 会退回 spdlog 队列)
+    const std::vector<SuiteBackend> setups = {
+        {"block", "spdlog"}, {"overrun_oldest", "spdlog"}, {"block", "thread_rings"}};
+    for (const auto& setup : setups) {
+        PrintSeparator("Suite: async_overflow_policy = " + setup.policy +
+                       ", async_backend = " + setup.backend);
+        auto manager = z3y::PluginManager::Create();
+        // 目录中的框架库本身不是插件，加载失败列表不影响套件
+        static_cast<void>(manager->LoadPluginsFromDirectory(exe_dir, true));
+        auto log_mgr = z3y::GetDefaultService<ILogManagerService>();
+        const auto config_path = WriteSuiteConfig(log_root, setup);
+        if (!log_mgr->InitializeService(z3y::utils::PathToUtf8(config_path), z3y::utils::PathToUtf8(log_root))) {
+            std::cerr << "[Fatal] 套件配置初始化失败: " << z3y::utils::PathToUtf8(config_path) << std::endl;
+            return 1;
+        }
+        for (const auto& c : cases) {
+            auto entry = RunSuiteCase(log_mgr, c, setup, logs_per_thread);
+            std::cout << std::left << std::setw(20) << c.group
+                << " threads=" << std::setw(2) << c.threads
+                << " bytes=" << std::setw(5) << c.message_bytes
+                << std::right << std::fixed << std::setprecision(0)
+                << " qps=" << std::setw(10) << entry["throughput_logs_per_s"].get<double>()
+                << " p50=" << std::setw(6) << entry["latency_ns"]["p50"].get<double>()
+                << " p99=" << std::setw(7) << entry["latency_ns"]["p99"].get<double>()
+                << " p99.9=" << std::setw(8) << entry["latency_ns"]["p999"].get<double>()
+                << " max=" << std::setw(9) << entry["latency_ns"]["max"].get<double>()
+                << std::setprecision(2)
+                << " allocs/log=" << entry["allocs_per_log"].get<double>() << std::endl;
+            result["cases"].push_back(std::move(entry));
+        }
+        log_mgr.reset();
+        manager->UnloadAllPlugins();
+        manager.reset();
+        z3y::PluginManager::Destroy();
+    }
+
+    std::ofstream out(json_path);
+    if (!out) {
+        std::cerr << "[Fatal] 无法写入结果文件: " << z3y::utils::PathToUtf8(json_path) << std::endl;
+        return 1;
+    }
+    out << result.dump(2) << std::endl;
+    std::cout << "\n[Suite] 结果已写入: " << z3y::utils::PathToUtf8(json_path) << std::endl;
+    return 0;
+}
+
 int main(int argc, char* argv[]) {
 #ifdef _WIN32
     system("chcp 65001 > nul");
 #endif
 
-    try {
-        auto manager = z3y::PluginManager::Create();
+    bool suite = false;
+    int logs_per_thread = 20000;
+    std::filesystem::path json_path;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--suite") {
+            suite = true;
+        } else if (arg == "--json" && i + 1 < argc) {
+            json_path = z3y::utils::Utf8ToPath(argv[++i]);
+        } else if (arg == "--logs" && i + 1 < argc) {
+            logs_per_thread = std::max(1, std::atoi(argv[++i]));
+        } else {
+            std::cerr << "Usage: tool_log_benchmark [--suite [--json out.json] [--logs N]]" << std::endl;
+            return 2;
+        }
+    }
 
+    try {
         std::filesystem::path exe_path = GetExePath();
         std::filesystem::path exe_dir = exe_path.parent_path();
 
+        if (suite) {
+            if (json_path.empty()) json_path = exe_dir / "log_benchmark_result.json";
+            return RunSuite(exe_dir, json_path, logs_per_thread);
+        }
+
+        auto manager = z3y::PluginManager::Create();
+
         std::cout << "[Init] 插件目录: " << z3y::utils::PathToUtf8(exe_dir) << std::endl;
         manager->LoadPluginsFromDirectory(exe_dir, true);
 
@@ -211,8 +513,10 @@ int main(int argc, char* argv[]) {
 
         std::this_thread::sleep_for(std::chrono::seconds(1));
 
-        // 2. 性能压测
-        RunMixedPerformanceTest(log_mgr);
+        // 2. 性能压测 (调用线程格式化 vs 后台线程格式化)
+        RunMixedPerformanceTest(log_mgr, false);
+        log_mgr->Flush();
+        RunMixedPerformanceTest(log_mgr, true);
 
         // 3. [清理]
         PrintSeparator("Shutting Down");
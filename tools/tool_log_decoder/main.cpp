@@ -0,0 +1,195 @@
+﻿/*
+* Copyright [2025] [Yue Liu]
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/**
+ * @file main.cpp
+ * @brief mmap_binary_sink 段文件解码工具
+ * @details
+ * 把一个或多个二进制段 (文件或目录) 还原为与默认 pattern 相近的文本：
+ * `[2025-11-21 10:00:00.123] [I] [Logger.Name] [tid] message`
+ * 段按文件头中的序号排序输出；不是段文件的输入会被跳过并提示。
+ * 进程崩溃后留下的段同样可以解码，末尾未写完的记录会被忽略。
+ * 指定 --fields 时，结构化日志在行尾追加带类型还原的字段 ` | key=value ...`
+ * (字符串加引号，便于与文本中渲染的值区分)。
+ *
+ * 用法: tool_log_decoder <段文件或目录>... [-o 输出文件] [--fields]
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "plugin_spdlog_logger/mmap_binary_format.h"
+
+namespace fs = std::filesystem;
+namespace binlog = z3y::plugins::log::binlog;
+
+namespace {
+
+struct Segment {
+  fs::path path;
+  std::string bytes;
+  uint64_t sequence = 0;
+};
+
+bool LoadSegment(const fs::path& path, Segment& out) {
+  std::ifstream f(path, std::ios::binary);
+  if (!f) return false;
+  out.bytes.assign(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+  if (!binlog::IsSegment(out.bytes.data(), out.bytes.size())) return false;
+  out.path = path;
+  out.sequence = reinterpret_cast<const binlog::FileHeader*>(out.bytes.data())->sequence;
+  return true;
+}
+
+// u8string() 在 C++20 下返回 std::u8string，统一转回 UTF-8 编码的 std::string
+std::string PathToUtf8(const fs::path& path) {
+  const auto utf8 = path.u8string();
+  return std::string(utf8.begin(), utf8.end());
+}
+
+void WriteTimestamp(std::ostream& os, int64_t time_ns) {
+  const std::time_t seconds = static_cast<std::time_t>(time_ns / 1000000000);
+  const int millis = static_cast<int>((time_ns / 1000000) % 1000);
+  std::tm tm{};
+#ifdef _WIN32
+  localtime_s(&tm, &seconds);
+#else
+  localtime_r(&seconds, &tm);
+#endif
+  char buffer[40];
+  const size_t n = std::strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", &tm);
+  std::snprintf(buffer + n, sizeof(buffer) - n, ".%03d", millis);
+  os << buffer;
+}
+
+void WriteFields(std::ostream& os, std::string_view fields) {
+  os << " |";
+  binlog::ForEachField(fields, [&os](std::string_view key, binlog::FieldType type,
+                                     uint64_t raw, std::string_view text) {
+    os << ' ' << key << '=';
+    switch (type) {
+      case binlog::FieldType::kInt64:
+        os << static_cast<int64_t>(raw);
+        break;
+      case binlog::FieldType::kDouble: {
+        double value;
+        std::memcpy(&value, &raw, sizeof(value));
+        os << value;
+        break;
+      }
+      case binlog::FieldType::kBool:
+        os << (raw ? "true" : "false");
+        break;
+      case binlog::FieldType::kChar:
+        os << '\'' << static_cast<char>(raw) << '\'';
+        break;
+      case binlog::FieldType::kPointer:
+        os << "0x" << std::hex << raw << std::dec;
+        break;
+      case binlog::FieldType::kString:
+        os << '"' << text << '"';
+        break;
+      default:
+        os << raw;
+    }
+  });
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  std::vector<fs::path> inputs;
+  fs::path output_path;
+  bool show_fields = false;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    if (arg == "-o" && i + 1 < argc) {
+      output_path = fs::u8path(argv[++i]);
+    } else if (arg == "--fields") {
+      show_fields = true;
+    } else {
+      inputs.push_back(fs::u8path(arg));
+    }
+  }
+  if (inputs.empty()) {
+    std::cerr << "Usage: tool_log_decoder <segment file or directory>... [-o output] "
+                 "[--fields]\n";
+    return 2;
+  }
+
+  // 1. 收集并加载段文件 (目录只看第一层)
+  std::vector<Segment> segments;
+  for (const auto& input : inputs) {
+    std::vector<fs::path> candidates;
+    std::error_code ec;
+    if (fs::is_directory(input, ec)) {
+      for (const auto& entry : fs::directory_iterator(input, ec)) {
+        if (entry.is_regular_file(ec)) candidates.push_back(entry.path());
+      }
+    } else {
+      candidates.push_back(input);
+    }
+    for (const auto& path : candidates) {
+      Segment segment;
+      if (LoadSegment(path, segment)) {
+        segments.push_back(std::move(segment));
+      } else if (!fs::is_directory(input, ec)) {
+        std::cerr << "Skip (not a binary log segment): " << PathToUtf8(path) << "\n";
+      }
+    }
+  }
+  std::sort(segments.begin(), segments.end(),
+            [](const Segment& a, const Segment& b) { return a.sequence < b.sequence; });
+
+  // 2. 逐段解码
+  std::ofstream file_out;
+  if (!output_path.empty()) {
+    file_out.open(output_path, std::ios::binary);
+    if (!file_out) {
+      std::cerr << "Cannot open output: " << PathToUtf8(output_path) << "\n";
+      return 1;
+    }
+  }
+  std::ostream& os = output_path.empty() ? std::cout : file_out;
+
+  size_t total = 0;
+  for (const auto& segment : segments) {
+    total += binlog::ForEachRecord(
+        segment.bytes.data(), segment.bytes.size(),
+        [&os, show_fields](const binlog::RecordHeader& record, std::string_view name,
+                           std::string_view message, std::string_view fields) {
+          os << '[';
+          WriteTimestamp(os, record.time_ns);
+          os << "] [" << binlog::LevelLetter(record.level) << "] [" << name << "] ["
+             << record.thread_id << "] " << message;
+          if (show_fields && !fields.empty()) WriteFields(os, fields);
+          os << '\n';
+        });
+  }
+  std::cerr << "Decoded " << total << " records from " << segments.size()
+            << " segment(s).\n";
+  return 0;
+}
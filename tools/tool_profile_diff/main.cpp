@@ -0,0 +1,358 @@
+﻿/*
+* Copyright [2025] [Yue Liu]
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/**
+ * @file main.cpp
+ * @brief Profiler 结构化导出 (`WriteJson`) 的基线 / 候选对比工具
+ * @details
+ * 1. 输入：两个文件，每个文件含一份或多份 `WriteJson` 报告（逐行追加的 JSON Lines、
+ *    顶层数组或单个对象均可）。同一份文件里的多份报告视为同一版本的多次测量。
+ * 2. 对齐：节点按「从根开始的路径」对齐，路径的每一级由名字与 `file:line`
+ *    （即 `ProfileNodeData` 的静态信息）组成；旧的导出没有位置信息时只用名字。
+ * 3. 比较：对每个节点的 mean（单次平均耗时）与 p50 / p95 / p99 / p999 分别计算
+ *    相对变化。变化同时超过相对阈值与绝对下限才算数；两侧各有 >= 2 份报告时，
+ *    另外要求 Welch t 检验的 |t| 达到临界值，只有一份报告时仅按阈值判断。
+ * 4. 退出码：存在耗时回归时返回 1，可直接作为插件发布流水线的门禁；
+ *    用法 / 文件错误返回 2。Value 节点只报告变化，不参与门禁；Event 节点不比较。
+ *
+ * 用法: tool_profile_diff <基线> <候选> [--threshold=<百分比>] [--tail-threshold=<百分比>]
+ *                         [--min-delta=<绝对值>] [--t=<临界值>] [--all]
+ */
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "common/cli_args.h"
+
+namespace {
+
+    using z3y::tools::ForEachArgument;
+    using z3y::tools::StartsWith;
+
+    using nlohmann::json;
+
+    constexpr size_t kMetricCount = 5;  // mean, p50, p95, p99, p999
+    const char* const kMetricNames[kMetricCount] = { "mean", "p50", "p95", "p99", "p999" };
+    const char* const kPercentileKeys[4] = { "p50", "p95", "p99", "p999" };
+
+    struct Arguments {
+        std::string baseline;
+        std::string candidate;
+        double threshold = 0.05;       ///< mean / p50 的相对阈值
+        double tail_threshold = 0.10;  ///< p95 及以上的相对阈值（尾部天然更抖）
+        double min_delta = 0.01;       ///< 绝对变化下限（Timer 为毫秒）
+        double t_critical = 2.0;
+        bool all = false;
+    };
+
+    void PrintUsage() {
+        std::cerr << "Usage: tool_profile_diff <baseline.json> <candidate.json> [--threshold=<pct>]\n"
+            << "                         [--tail-threshold=<pct>] [--min-delta=<abs>] [--t=<critical>] [--all]"
+            << std::endl;
+    }
+
+    bool ParseArguments(int argc, char* argv[], Arguments& args) {
+        const bool accepted = ForEachArgument(argc, argv, [&args](const std::string& arg) {
+            std::string value;
+            if (arg == "--all") {
+                args.all = true;
+            } else if (StartsWith(arg, "--threshold=", value)) {
+                args.threshold = std::atof(value.c_str()) / 100.0;
+            } else if (StartsWith(arg, "--tail-threshold=", value)) {
+                args.tail_threshold = std::atof(value.c_str()) / 100.0;
+            } else if (StartsWith(arg, "--min-delta=", value)) {
+                args.min_delta = std::atof(value.c_str());
+            } else if (StartsWith(arg, "--t=", value)) {
+                args.t_critical = std::atof(value.c_str());
+            } else if (!arg.empty() && arg[0] != '-' && args.baseline.empty()) {
+                args.baseline = arg;
+            } else if (!arg.empty() && arg[0] != '-' && args.candidate.empty()) {
+                args.candidate = arg;
+            } else {
+                return false;
+            }
+            return true;
+        });
+        return accepted && !args.candidate.empty() && args.threshold >= 0 && args.tail_threshold >= 0 &&
+            args.min_delta >= 0 && args.t_critical >= 0;
+    }
+
+    /** @brief 一个节点在一份报告中的测量值（下标同 kMetricNames）。 */
+    struct Sample {
+        double total = 0.0;  ///< 耗时 (Timer / Linear) 或数值累加 (Value)
+        uint64_t count = 0;
+        std::array<double, kMetricCount> metrics{};
+        bool has_percentiles = false;
+    };
+
+    /** @brief 一个对齐键在某一侧所有报告中的测量序列。 */
+    struct Series {
+        std::string path;      ///< 仅由名字组成的路径，用于显示
+        std::string location;  ///< 叶子的 file:line
+        bool is_value = false;
+        std::vector<Sample> samples;
+    };
+
+    struct Profile {
+        size_t reports = 0;
+        std::map<std::string, Series> nodes;  ///< 对齐键 -> 序列
+    };
+
+    std::string BaseName(const std::string& path) {
+        const size_t slash = path.find_last_of("/\\");
+        return slash == std::string::npos ? path : path.substr(slash + 1);
+    }
+
+    void CollectNode(const json& node, const std::string& parent_key, const std::string& parent_path,
+                     std::map<std::string, Series>& out, std::map<std::string, Sample>& report) {
+        const std::string name = node.value("name", std::string());
+        const std::string file = node.value("file", std::string());
+        std::string location;
+        if (!file.empty()) location = BaseName(file) + ":" + std::to_string(node.value("line", 0u));
+        // 键里保留完整路径，显示时只用文件名
+        const std::string segment = file.empty() ? name : name + "@" + file + ":" +
+            std::to_string(node.value("line", 0u));
+        const std::string key = parent_key.empty() ? segment : parent_key + ";" + segment;
+        const std::string path = parent_path.empty() ? name : parent_path + ";" + name;
+
+        const std::string type = node.value("type", std::string("timer"));
+        const uint64_t count = node.value("count", uint64_t{ 0 });
+        if (type != "event" && count > 0) {
+            Series& series = out[key];
+            if (series.path.empty()) {
+                series.path = path;
+                series.location = location;
+                series.is_value = type == "value";
+            }
+            // 同一份报告中重复出现的键（动态节点同名）合并计数，分位数取第一次出现的
+            Sample& sample = report[key];
+            sample.total += node.value(type == "value" ? "sum" : "total_ms", 0.0);
+            sample.count += count;
+            if (!sample.has_percentiles && node.contains("p50")) {
+                sample.has_percentiles = true;
+                for (size_t i = 0; i < 4; ++i) sample.metrics[i + 1] = node.value(kPercentileKeys[i], 0.0);
+            }
+        }
+        if (node.contains("children")) {
+            for (const json& child : node["children"]) CollectNode(child, key, path, out, report);
+        }
+    }
+
+    void CollectReport(const json& report, Profile& profile) {
+        if (report.is_array()) {
+            for (const json& item : report) CollectReport(item, profile);
+            return;
+        }
+        if (!report.is_object() || !report.contains("tree")) {
+            throw std::runtime_error("not a profiler report (missing \"tree\")");
+        }
+        ++profile.reports;
+        if (report["tree"].is_null()) return;
+        std::map<std::string, Sample> samples;
+        CollectNode(report["tree"], std::string(), std::string(), profile.nodes, samples);
+        for (auto& [key, sample] : samples) {
+            sample.metrics[0] = sample.total / static_cast<double>(sample.count);
+            profile.nodes[key].samples.push_back(sample);
+        }
+    }
+
+    bool LoadProfile(const std::string& file, Profile& profile) {
+        std::ifstream in(file, std::ios::binary);
+        if (!in) {
+            std::cerr << "cannot open " << file << std::endl;
+            return false;
+        }
+        try {
+            // 逐个读取顶层 JSON 值：兼容 Sink 逐行追加的 JSON Lines
+            while (in >> std::ws, in.peek() != std::char_traits<char>::eof()) {
+                json report;
+                in >> report;
+                CollectReport(report, profile);
+            }
+        } catch (const std::exception& e) {
+            std::cerr << file << ": " << e.what() << std::endl;
+            return false;
+        }
+        if (profile.reports == 0) {
+            std::cerr << file << ": no reports" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    enum class Verdict { Unchanged, Regressed, Improved, Changed };
+
+    /** @brief 一个指标在两侧之间的比较结果。 */
+    struct MetricDiff {
+        bool available = false;
+        double baseline = 0.0;
+        double candidate = 0.0;
+        double relative = 0.0;
+        double t = 0.0;
+        bool tested = false;  ///< 两侧样本数都 >= 2，做了 t 检验
+        bool significant = false;
+    };
+
+    void MeanAndVariance(const std::vector<double>& v, double& mean, double& variance) {
+        mean = 0.0;
+        for (double x : v) mean += x;
+        mean /= static_cast<double>(v.size());
+        variance = 0.0;
+        if (v.size() < 2) return;
+        for (double x : v) variance += (x - mean) * (x - mean);
+        variance /= static_cast<double>(v.size() - 1);
+    }
+
+    MetricDiff CompareMetric(const Series& base, const Series& cand, size_t metric, const Arguments& args) {
+        MetricDiff diff;
+        std::vector<double> b, c;
+        for (const Sample& s : base.samples) {
+            if (metric == 0 || s.has_percentiles) b.push_back(s.metrics[metric]);
+        }
+        for (const Sample& s : cand.samples) {
+            if (metric == 0 || s.has_percentiles) c.push_back(s.metrics[metric]);
+        }
+        if (b.empty() || c.empty()) return diff;
+        diff.available = true;
+        double vb = 0.0, vc = 0.0;
+        MeanAndVariance(b, diff.baseline, vb);
+        MeanAndVariance(c, diff.candidate, vc);
+        const double delta = diff.candidate - diff.baseline;
+        diff.relative = diff.baseline > 0.0 ? delta / diff.baseline : (delta != 0.0 ? INFINITY : 0.0);
+
+        const double threshold = metric >= 2 ? args.tail_threshold : args.threshold;
+        const bool beyond = std::fabs(diff.relative) >= threshold && std::fabs(delta) >= args.min_delta;
+        bool significant = true;
+        if (b.size() >= 2 && c.size() >= 2) {
+            // Welch t 检验：两侧方差不假定相等
+            diff.tested = true;
+            const double se = std::sqrt(vb / static_cast<double>(b.size()) + vc / static_cast<double>(c.size()));
+            diff.t = se > 0.0 ? delta / se : (delta != 0.0 ? INFINITY : 0.0);
+            significant = std::fabs(diff.t) >= args.t_critical;
+        }
+        diff.significant = beyond && significant;
+        return diff;
+    }
+
+    const char* VerdictName(Verdict v) {
+        switch (v) {
+            case Verdict::Regressed: return "REGRESSED";
+            case Verdict::Improved: return "improved";
+            case Verdict::Changed: return "changed";
+            case Verdict::Unchanged: break;
+        }
+        return "unchanged";
+    }
+
+    void PrintNode(Verdict verdict, const Series& series, const std::array<MetricDiff, kMetricCount>& diffs) {
+        std::cout << "[" << VerdictName(verdict) << "] " << series.path;
+        if (!series.location.empty()) std::cout << "  (" << series.location << ")";
+        std::cout << "\n    " << std::left << std::setw(6) << "metric" << std::right << std::setw(14) << "baseline"
+            << std::setw(14) << "candidate" << std::setw(11) << "delta" << std::setw(9) << "t" << "\n";
+        for (size_t m = 0; m < kMetricCount; ++m) {
+            const MetricDiff& d = diffs[m];
+            if (!d.available) continue;
+            std::cout << "    " << std::left << std::setw(6) << kMetricNames[m] << std::right << std::fixed
+                << std::setprecision(4) << std::setw(14) << d.baseline << std::setw(14) << d.candidate
+                << std::setw(10) << std::showpos << std::setprecision(1) << d.relative * 100.0 << std::noshowpos
+                << "%";
+            if (d.tested) {
+                std::cout << std::setw(9) << std::setprecision(2) << d.t;
+            } else {
+                std::cout << std::setw(9) << "-";
+            }
+            std::cout << (d.significant ? "  *" : "") << "\n";
+        }
+    }
+
+    int Diff(const Arguments& args) {
+        Profile base, cand;
+        if (!LoadProfile(args.baseline, base) || !LoadProfile(args.candidate, cand)) return 2;
+
+        std::cout << "tool_profile_diff: baseline " << args.baseline << " (" << base.reports << " reports), candidate "
+            << args.candidate << " (" << cand.reports << " reports)\n"
+            << std::fixed << std::setprecision(1) << "thresholds: mean/p50 " << args.threshold * 100.0
+            << "%, p95+ " << args.tail_threshold * 100.0 << "%, min delta " << std::setprecision(3)
+            << args.min_delta << ", |t| >= " << std::setprecision(2) << args.t_critical
+            << (base.reports < 2 || cand.reports < 2 ? " (t test needs >= 2 reports per side)" : "") << "\n\n";
+
+        size_t counts[4] = {};
+        std::vector<std::string> added, removed;
+        for (const auto& [key, series] : base.nodes) {
+            auto it = cand.nodes.find(key);
+            if (it == cand.nodes.end()) {
+                removed.push_back(series.path);
+                continue;
+            }
+            std::array<MetricDiff, kMetricCount> diffs;
+            bool slower = false, faster = false;
+            for (size_t m = 0; m < kMetricCount; ++m) {
+                diffs[m] = CompareMetric(series, it->second, m, args);
+                if (!diffs[m].significant) continue;
+                (diffs[m].candidate > diffs[m].baseline ? slower : faster) = true;
+            }
+            Verdict verdict = Verdict::Unchanged;
+            if (series.is_value) {
+                if (slower || faster) verdict = Verdict::Changed;
+            } else if (slower) {
+                verdict = Verdict::Regressed;
+            } else if (faster) {
+                verdict = Verdict::Improved;
+            }
+            ++counts[static_cast<size_t>(verdict)];
+            if (verdict != Verdict::Unchanged || args.all) PrintNode(verdict, series, diffs);
+        }
+        for (const auto& [key, series] : cand.nodes) {
+            if (!base.nodes.count(key)) added.push_back(series.path);
+        }
+        for (const std::string& path : removed) std::cout << "[removed] " << path << "\n";
+        for (const std::string& path : added) std::cout << "[added] " << path << "\n";
+
+        const size_t regressed = counts[static_cast<size_t>(Verdict::Regressed)];
+        std::cout << "\n" << regressed << " regressed, " << counts[static_cast<size_t>(Verdict::Improved)]
+            << " improved, " << counts[static_cast<size_t>(Verdict::Changed)] << " value changes, "
+            << counts[static_cast<size_t>(Verdict::Unchanged)] << " unchanged, " << added.size() << " added, "
+            << removed.size() << " removed" << std::endl;
+        return regressed > 0 ? 1 : 0;
+    }
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    Arguments args;
+    if (!ParseArguments(argc, argv, args)) {
+        PrintUsage();
+        return 2;
+    }
+    try {
+        return Diff(args);
+    } catch (const std::exception& e) {
+        std::cerr << "[Fatal Exception] " << e.what() << std::endl;
+        return 2;
+    }
+}
@@ -0,0 +1,247 @@
+﻿/*
+* Copyright [2025] [Yue Liu]
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/**
+ * @file main.cpp
+ * @brief 机群 Profiler 汇总端
+ * @details
+ * 1. 输入：各进程的指标导出插件按 `System.Metrics.FleetTarget` 推送的 UDP 数据报
+ *    （格式见 interfaces_profiler/fleet_snapshot.h），每个数据报是一台机器若干路径的增量。
+ * 2. 汇总：FleetAggregator 按节点路径合并各机器的树，直方图逐桶相加得到机群分位数。
+ * 3. 输出：每隔 --interval 秒打印一次表格：每个路径的机群调用数与 p50 / p99 / p999，
+ *    以及 p99 超过各机器中位数 --outlier 倍的机器；末尾列出各机器收到 / 丢失的数据报数。
+ *    --duration 到期后打印最后一次并退出（0 表示一直运行）。
+ *
+ * 用法: tool_profile_fleet [--port=<端口>] [--bind=<地址>] [--interval=<秒>]
+ *                          [--outlier=<倍数>] [--top=<行数>] [--duration=<秒>]
+ */
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "common/cli_args.h"
+#include "interfaces_profiler/fleet_snapshot.h"
+
+namespace {
+
+    using z3y::tools::ForEachArgument;
+    using z3y::tools::StartsWith;
+
+    using namespace z3y::interfaces::profiler;
+    using namespace z3y::interfaces::profiler::fleet;
+
+    struct Arguments {
+        int port = 9470;
+        std::string bind = "0.0.0.0";
+        double interval = 10.0;  ///< 打印周期（秒）
+        double outlier = 2.0;    ///< 离群倍数
+        size_t top = 30;         ///< 按机群累计量排序后打印的路径数
+        double duration = 0.0;   ///< 运行时长（秒），0 表示一直运行
+    };
+
+    void PrintUsage() {
+        std::cerr << "Usage: tool_profile_fleet [--port=<port>] [--bind=<address>] [--interval=<sec>]\n"
+            << "                          [--outlier=<ratio>] [--top=<rows>] [--duration=<sec>]"
+            << std::endl;
+    }
+
+    bool ParseArguments(int argc, char* argv[], Arguments& args) {
+        const bool accepted = ForEachArgument(argc, argv, [&args](const std::string& arg) {
+            std::string value;
+            if (StartsWith(arg, "--port=", value)) {
+                args.port = std::atoi(value.c_str());
+            } else if (StartsWith(arg, "--bind=", value)) {
+                args.bind = value;
+            } else if (StartsWith(arg, "--interval=", value)) {
+                args.interval = std::atof(value.c_str());
+            } else if (StartsWith(arg, "--outlier=", value)) {
+                args.outlier = std::atof(value.c_str());
+            } else if (StartsWith(arg, "--top=", value)) {
+                args.top = static_cast<size_t>(std::atoi(value.c_str()));
+            } else if (StartsWith(arg, "--duration=", value)) {
+                args.duration = std::atof(value.c_str());
+            } else {
+                return false;
+            }
+            return true;
+        });
+        return accepted && args.port > 0 && args.port <= 65535 && args.interval > 0 && args.outlier > 1.0 &&
+            args.duration >= 0;
+    }
+
+#ifdef _WIN32
+    using Socket = SOCKET;
+    const Socket kInvalid = INVALID_SOCKET;
+    void CloseSocket(Socket s) { ::closesocket(s); }
+#else
+    using Socket = int;
+    const Socket kInvalid = -1;
+    void CloseSocket(Socket s) { ::close(s); }
+#endif
+
+    /** @brief 绑定 IPv4 的 UDP 端口；失败返回 kInvalid。 */
+    Socket OpenReceiver(const Arguments& args) {
+        Socket s = ::socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        if (s == kInvalid) return kInvalid;
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(static_cast<uint16_t>(args.port));
+        if (::inet_pton(AF_INET, args.bind.c_str(), &addr.sin_addr) != 1 ||
+            ::bind(s, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0) {
+            CloseSocket(s);
+            return kInvalid;
+        }
+        return s;
+    }
+
+    /** @brief 等待至多 timeout_ms 接收一个数据报；超时返回 false。 */
+    bool Receive(Socket s, int timeout_ms, std::string& out) {
+#ifdef _WIN32
+        WSAPOLLFD pfd{};
+        pfd.fd = s;
+        pfd.events = POLLRDNORM;
+        if (::WSAPoll(&pfd, 1, timeout_ms) <= 0) return false;
+#else
+        pollfd pfd{};
+        pfd.fd = s;
+        pfd.events = POLLIN;
+        if (::poll(&pfd, 1, timeout_ms) <= 0) return false;
+#endif
+        char buffer[65536];
+        const auto n = ::recv(s, buffer, static_cast<int>(sizeof(buffer)), 0);
+        if (n <= 0) return false;
+        out.assign(buffer, static_cast<size_t>(n));
+        return true;
+    }
+
+    /** @brief 排序用的累计量：耗时节点按总耗时，其余按次数。 */
+    double Weight(const FleetPathSummary& row) {
+        return row.type == NodeType::Timer || row.type == NodeType::Linear
+            ? row.total_ms : static_cast<double>(row.count);
+    }
+
+    void PrintTable(const FleetAggregator& fleet, const Arguments& args) {
+        std::vector<FleetPathSummary> rows = fleet.Summarize(args.outlier);
+        std::sort(rows.begin(), rows.end(), [](const FleetPathSummary& a, const FleetPathSummary& b) {
+            return Weight(a) > Weight(b);
+        });
+        if (rows.size() > args.top) rows.resize(args.top);
+
+        std::cout << "\n" << std::left << std::setw(48) << "Path" << std::right
+            << std::setw(12) << "Calls" << std::setw(8) << "Hosts"
+            << std::setw(12) << "p50" << std::setw(12) << "p99" << std::setw(12) << "p999"
+            << "  Outliers (p99)\n";
+        std::cout << std::fixed << std::setprecision(3);
+        for (const FleetPathSummary& row : rows) {
+            std::cout << std::left << std::setw(48) << row.path << std::right
+                << std::setw(12) << row.count << std::setw(8) << row.machines.size();
+            if (row.has_percentiles) {
+                std::cout << std::setw(12) << row.percentiles[0] << std::setw(12) << row.percentiles[2]
+                    << std::setw(12) << row.percentiles[3];
+            } else {
+                std::cout << std::setw(12) << "-" << std::setw(12) << "-" << std::setw(12) << "-";
+            }
+            std::cout << " ";
+            for (const FleetMachineRow& machine : row.machines) {
+                if (machine.outlier) {
+                    std::cout << " " << machine.node << "=" << machine.p99 << " (x"
+                        << std::setprecision(1) << machine.p99 / row.median_p99 << ")"
+                        << std::setprecision(3);
+                }
+            }
+            std::cout << "\n";
+        }
+        std::cout << "Hosts:";
+        for (const FleetMachineStatus& m : fleet.GetMachines()) {
+            std::cout << " " << m.node << " (" << m.datagrams << " datagrams, " << m.lost << " lost"
+                << (m.restarts ? ", " + std::to_string(m.restarts) + " restarts" : std::string()) << ")";
+        }
+        if (fleet.GetMalformed()) std::cout << "  malformed: " << fleet.GetMalformed();
+        std::cout << std::endl;
+    }
+
+    int Run(const Arguments& args) {
+#ifdef _WIN32
+        WSADATA data;
+        if (::WSAStartup(MAKEWORD(2, 2), &data) != 0) {
+            std::cerr << "WSAStartup failed" << std::endl;
+            return 2;
+        }
+#endif
+        const Socket s = OpenReceiver(args);
+        if (s == kInvalid) {
+            std::cerr << "Cannot bind UDP " << args.bind << ":" << args.port << std::endl;
+            return 2;
+        }
+        std::cout << "Listening on udp://" << args.bind << ":" << args.port << std::endl;
+
+        using Clock = std::chrono::steady_clock;
+        const auto start = Clock::now();
+        const auto period = std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(args.interval));
+        auto next_print = start + period;
+        FleetAggregator fleet;
+        std::string datagram;
+        while (true) {
+            const auto now = Clock::now();
+            if (args.duration > 0 && now - start >= std::chrono::duration<double>(args.duration)) break;
+            if (now >= next_print) {
+                PrintTable(fleet, args);
+                next_print = now + period;
+            }
+            const auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(next_print - now);
+            if (Receive(s, static_cast<int>(std::clamp<int64_t>(wait.count(), 1, 200)), datagram)) {
+                fleet.Ingest(datagram);
+            }
+        }
+        PrintTable(fleet, args);
+        CloseSocket(s);
+#ifdef _WIN32
+        ::WSACleanup();
+#endif
+        return 0;
+    }
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    Arguments args;
+    if (!ParseArguments(argc, argv, args)) {
+        PrintUsage();
+        return 2;
+    }
+    return Run(args);
+}
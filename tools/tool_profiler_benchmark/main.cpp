@@ -0,0 +1,485 @@
+﻿/*
+* Copyright [2025] [Yue Liu]
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/**
+ * @file main.cpp
+ * @brief Profiler 探针开销压测工具
+ * @details
+ * [测试覆盖]
+ * 对 Z3Y_PROFILE / Z3Y_PROFILE_VALUE / Z3Y_PROFILE_LINEAR / Z3Y_PROFILE_ASYNC_* 分别测量：
+ * 1. 服务缺失: 尚未加载 plugin_profiler。
+ * 2. 配置关闭: System.Profiler.Enable = false。
+ * 3. 冷树: 每次操作都在一个新的异步帧里执行，节点需要重新分配 (已扣除异步帧本身的耗时)。
+ * 4. 热树: 在一个长期存在的 ROOT 下反复执行，节点与查找缓存全部命中。
+ * 5. 多线程争用: 1 / 2 / 4 / 8 个线程挂载同一个异步帧，分别测试共享树与分片聚合。
+ * 6. 自身开销补偿: 读取服务标定出的探针开销，对比补偿前后报告中的耗时。
+ *
+ * 所有 ns/op 均已扣除空循环的基线。Linux 下通过 perf_event_open 统计 cache-misses/op，
+ * 无权限 (perf_event_paranoid) 或其它平台输出 n/a。
+ *
+ * 用法: tool_profiler_benchmark [ops]   (ops 缺省为 200000，用于缩放所有场景)
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "framework/z3y_framework.h"
+#include "interfaces_core/i_config_service.h"
+#include "interfaces_profiler/i_profiler_service.h"
+#include "interfaces_profiler/profiler_macros.h"
+#include "interfaces_profiler/profiler_report.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <climits>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+using z3y::interfaces::core::IConfigService;
+using z3y::interfaces::profiler::IProfilerService;
+using z3y::interfaces::profiler::ProfileReport;
+
+// --- 压测参数配置 ---
+int g_measured_ops = 200000;  // 可由命令行覆盖
+const int kWarmupOps = 10000;
+
+using Clock = std::chrono::steady_clock;
+
+// --- 路径辅助函数 (Windows UTF-8 兼容) ---
+std::filesystem::path GetExePath() {
+#ifdef _WIN32
+    wchar_t buffer[MAX_PATH];
+    if (GetModuleFileNameW(NULL, buffer, MAX_PATH) > 0) {
+        return std::filesystem::path(buffer);
+    }
+    return std::filesystem::current_path();
+#else
+    char buffer[PATH_MAX];
+    ssize_t count = readlink("/proc/self/exe", buffer, PATH_MAX);
+    if (count > 0) return std::filesystem::path(std::string(buffer, count));
+    return std::filesystem::current_path();
+#endif
+}
+
+/**
+ * @brief 当前线程的硬件 cache-miss 计数器。打不开 (无权限 / 非 Linux) 时 Valid() 为 false。
+ */
+class CacheMissCounter {
+public:
+    CacheMissCounter() {
+#if defined(__linux__)
+        perf_event_attr attr{};
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd_ = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+    }
+    ~CacheMissCounter() {
+#if defined(__linux__)
+        if (fd_ >= 0) close(fd_);
+#endif
+    }
+    CacheMissCounter(const CacheMissCounter&) = delete;
+    CacheMissCounter& operator=(const CacheMissCounter&) = delete;
+
+    bool Valid() const { return fd_ >= 0; }
+
+    void Start() {
+#if defined(__linux__)
+        if (fd_ < 0) return;
+        ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+    }
+
+    uint64_t Stop() {
+        uint64_t value = 0;
+#if defined(__linux__)
+        if (fd_ < 0) return 0;
+        ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(fd_, &value, sizeof(value)) != static_cast<ssize_t>(sizeof(value))) value = 0;
+#endif
+        return value;
+    }
+
+private:
+    int fd_ = -1;
+};
+
+/** @brief 一段测量区间的结果。 */
+struct Measurement {
+    double ns_per_op = 0;
+    double misses_per_op = -1;  //!< 负数表示计数器不可用
+};
+
+/**
+ * @brief 用 thread_count 个线程并发执行 body(thread_index)，每个线程执行 ops_per_thread 次操作。
+ * @return 墙钟时间折算的 ns/op 与所有线程合计的 cache-misses/op。
+ */
+template <typename Body>
+Measurement MeasureParallel(int thread_count, int ops_per_thread, Body&& body) {
+    std::atomic<int> ready{ 0 };
+    std::atomic<bool> go{ false };
+    std::atomic<uint64_t> misses{ 0 };
+    std::atomic<bool> counted{ true };
+    std::vector<std::thread> threads;
+    threads.reserve(thread_count);
+    for (int t = 0; t < thread_count; ++t) {
+        threads.emplace_back([&, t] {
+            CacheMissCounter counter;
+            if (!counter.Valid()) counted = false;
+            ready.fetch_add(1);
+            while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+            counter.Start();
+            body(t);
+            misses.fetch_add(counter.Stop(), std::memory_order_relaxed);
+            });
+    }
+    while (ready.load() != thread_count) std::this_thread::yield();
+
+    auto start_time = Clock::now();
+    go.store(true, std::memory_order_release);
+    for (auto& t : threads) t.join();
+    auto end_time = Clock::now();
+
+    const double total_ops = static_cast<double>(thread_count) * ops_per_thread;
+    Measurement m;
+    m.ns_per_op = std::chrono::duration<double, std::nano>(end_time - start_time).count() / total_ops;
+    if (counted) m.misses_per_op = static_cast<double>(misses.load()) / total_ops;
+    return m;
+}
+
+/** @brief 单线程测量，body(ops) 自己循环 ops 次。 */
+template <typename Body>
+Measurement Measure(int ops, Body&& body) {
+    return MeasureParallel(1, ops, [&](int) { body(ops); });
+}
+
+Measurement g_baseline;  // 空循环基线，由 RunBaseline 测得
+
+/** @brief 扣除基线并打印一行。 */
+void PrintMeasurement(const std::string& label, Measurement m, const Measurement& baseline = g_baseline) {
+    m.ns_per_op = std::max(0.0, m.ns_per_op - baseline.ns_per_op);
+    if (m.misses_per_op >= 0 && baseline.misses_per_op >= 0) {
+        m.misses_per_op = std::max(0.0, m.misses_per_op - baseline.misses_per_op);
+    }
+    std::cout << std::left << std::setw(36) << label
+        << " ns/op: " << std::right << std::setw(9) << std::fixed << std::setprecision(1) << m.ns_per_op
+        << "    cache-misses/op: ";
+    if (m.misses_per_op < 0) {
+        std::cout << "    n/a" << std::endl;
+    } else {
+        std::cout << std::setw(7) << std::setprecision(3) << m.misses_per_op << std::endl;
+    }
+}
+
+void PrintSeparator(const std::string& title) {
+    std::cout << "\n=============================================================\n"
+        << " " << title << "\n"
+        << "=============================================================" << std::endl;
+}
+
+// =============================================================================
+// 被测操作 (每个函数执行 n 次对应的探针)
+// =============================================================================
+void OpEmpty(int n) {
+    for (int i = 0; i < n; ++i) std::atomic_signal_fence(std::memory_order_seq_cst);
+}
+
+void OpScope(int n) {
+    for (int i = 0; i < n; ++i) {
+        Z3Y_PROFILE();
+    }
+}
+
+void OpValue(int n) {
+    for (int i = 0; i < n; ++i) {
+        Z3Y_PROFILE_VALUE("Bench_Value", i);
+    }
+}
+
+void OpLinear(int n) {
+    for (int i = 0; i < n; ++i) {
+        Z3Y_PROFILE_LINEAR("Bench_Linear");
+        Z3Y_PROFILE_NEXT("Bench_Step_A");
+        Z3Y_PROFILE_NEXT("Bench_Step_B");
+    }
+}
+
+/** @brief 完整的异步帧生命周期：BEGIN -> ATTACH -> (op) -> COMMIT (Worker) -> COMMIT (发起者)。 */
+template <typename Op>
+void OpAsyncFrame(int n, uint64_t base_id, Op&& op) {
+    for (int i = 0; i < n; ++i) {
+        const uint64_t id = base_id + static_cast<uint64_t>(i);
+        Z3Y_PROFILE_ASYNC_BEGIN("Bench_Async", id, 0, 0.0);
+        Z3Y_PROFILE_ASYNC_ATTACH(id);
+        op(1);
+        Z3Y_PROFILE_ASYNC_COMMIT(id);
+        Z3Y_PROFILE_ASYNC_COMMIT(id);
+    }
+}
+
+void OpAsync(int n) { OpAsyncFrame(n, 1, OpEmpty); }
+
+/** @brief 在一个从不输出报告的长期 ROOT 下执行 op (period = 0，SLA = 0)。 */
+template <typename Op>
+void InHotRoot(int n, Op&& op) {
+    Z3Y_PROFILE_ROOT("Bench_Root", 0, 0.0);
+    op(n);
+}
+
+struct MacroCase {
+    const char* name;
+    void (*op)(int);
+};
+
+const MacroCase kMacroCases[] = {
+    { "Z3Y_PROFILE", &OpScope },
+    { "Z3Y_PROFILE_VALUE", &OpValue },
+    { "Z3Y_PROFILE_LINEAR (+2 NEXT)", &OpLinear },
+};
+
+// =============================================================================
+// 框架会话
+// =============================================================================
+/** @brief 只加载本工具需要的插件 (配置中心 + Profiler)，不加载日志，避免报告写入干扰计时。 */
+bool LoadProfilerPlugins(z3y::PluginPtr<z3y::PluginManager>& manager, const std::filesystem::path& dir) {
+    const std::string extension = z3y::utils::GetSharedLibraryExtension();
+    bool profiler_loaded = false;
+    for (const char* base : { "plugin_config_manager", "plugin_profiler" }) {
+        for (const auto& entry : std::filesystem::directory_iterator(dir)) {
+            const std::string file = z3y::utils::PathToUtf8(entry.path().filename());
+            if (entry.path().extension().string() != extension || file.find(base) == std::string::npos) continue;
+            std::string err;
+            if (!manager->LoadPlugin(entry.path(), err)) {
+                std::cerr << "[Warn] 加载 " << file << " 失败: " << err << std::endl;
+                continue;
+            }
+            std::cout << "[Init] 已加载 " << file << std::endl;
+            if (std::string(base) == "plugin_profiler") profiler_loaded = true;
+            break;
+        }
+    }
+    return profiler_loaded;
+}
+
+void SetConfig(const std::string& key, bool value) {
+    if (auto [cfg, err] = z3y::TryGetDefaultService<IConfigService>(); err == z3y::InstanceError::kSuccess) {
+        cfg->SetValue(key, value);
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));  // 等待配置事件送达 Profiler
+    }
+}
+
+// =============================================================================
+// 0. 基线
+// =============================================================================
+void RunBaseline() {
+    OpEmpty(kWarmupOps);
+    g_baseline = Measure(g_measured_ops, OpEmpty);
+    std::cout << "空循环基线: " << std::fixed << std::setprecision(2) << g_baseline.ns_per_op
+        << " ns/op (以下结果均已扣除)" << std::endl;
+}
+
+// =============================================================================
+// 1 / 2. 服务缺失 与 配置关闭
+// =============================================================================
+void RunInactiveBenchmark(const std::string& state) {
+    PrintSeparator(state);
+    for (const auto& c : kMacroCases) {
+        InHotRoot(kWarmupOps, c.op);
+        PrintMeasurement(c.name, Measure(g_measured_ops, [&](int n) { InHotRoot(n, c.op); }));
+    }
+    OpAsync(kWarmupOps);
+    PrintMeasurement("Z3Y_PROFILE_ASYNC_* (frame)", Measure(g_measured_ops, OpAsync));
+}
+
+// =============================================================================
+// 3. 冷树
+// =============================================================================
+void RunColdBenchmark() {
+    PrintSeparator("3. 启用 + 冷树 (每次操作一个新异步帧，已扣除帧本身)");
+    const int ops = std::max(1, g_measured_ops / 4);
+    OpAsync(kWarmupOps);
+    Measurement frame = Measure(ops, OpAsync);
+    PrintMeasurement("Z3Y_PROFILE_ASYNC_* (frame)", frame);
+    frame.ns_per_op += g_baseline.ns_per_op;  // 帧测量本身已含基线，整体作为新基线
+    for (const auto& c : kMacroCases) {
+        OpAsyncFrame(kWarmupOps, 1, c.op);
+        PrintMeasurement(c.name, Measure(ops, [&](int n) { OpAsyncFrame(n, 1, c.op); }), frame);
+    }
+}
+
+// =============================================================================
+// 4. 热树
+// =============================================================================
+void RunHotBenchmark() {
+    PrintSeparator("4. 启用 + 热树 (长期 ROOT 下反复执行)");
+    for (const auto& c : kMacroCases) {
+        InHotRoot(kWarmupOps, c.op);  // ROOT 从不输出报告，预热出的节点留到测量区间
+        PrintMeasurement(c.name, Measure(g_measured_ops, [&](int n) { InHotRoot(n, c.op); }));
+    }
+}
+
+// =============================================================================
+// 5. 多线程争用
+// =============================================================================
+void RunContentionBenchmark() {
+    for (bool sharded : { false, true }) {
+        SetConfig("System.Profiler.ShardedAggregation", sharded);
+        PrintSeparator(std::string("5. 多线程争用: 同一异步帧内的 Z3Y_PROFILE (") +
+            (sharded ? "分片聚合" : "共享树") + ")");
+        for (int threads : { 1, 2, 4, 8 }) {
+            const uint64_t frame_id = 7000000u + static_cast<uint64_t>(threads) + (sharded ? 100u : 0u);
+            const int per_thread = g_measured_ops / threads;
+            Z3Y_PROFILE_ASYNC_BEGIN("Bench_Contention", frame_id, 0, 0.0);
+            Measurement m = MeasureParallel(threads, per_thread, [&](int) {
+                Z3Y_PROFILE_ASYNC_ATTACH(frame_id);
+                OpScope(per_thread);
+                Z3Y_PROFILE_ASYNC_COMMIT(frame_id);
+                });
+            Z3Y_PROFILE_ASYNC_COMMIT(frame_id);
+            PrintMeasurement("threads=" + std::to_string(threads), m);
+        }
+    }
+    SetConfig("System.Profiler.ShardedAggregation", false);
+}
+
+// =============================================================================
+// 6. 自身开销补偿
+// =============================================================================
+/** @brief 只保留最近一份报告的接收器。 */
+class LastReportSink : public z3y::interfaces::profiler::IProfilerReportSink {
+public:
+    void OnReport(const ProfileReport& report) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        last_ = report;
+    }
+    ProfileReport Take() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return last_;
+    }
+
+private:
+    std::mutex mutex_;
+    ProfileReport last_;
+};
+
+/** @brief 报告中 OpScope 节点的平均耗时 (ns)。 */
+double ReportedScopeNs(const ProfileReport& report) {
+    for (const auto& node : report.nodes) {
+        if (node.name == "OpScope" && node.count > 0) return node.total_ms * 1e6 / static_cast<double>(node.count);
+    }
+    return 0.0;
+}
+
+void RunCompensationReport(const z3y::PluginPtr<IProfilerService>& profiler) {
+    PrintSeparator("6. 自身开销补偿 (System.Profiler.OverheadCompensation)");
+    auto sink = std::make_shared<LastReportSink>();
+    profiler->AddReportSink(sink);
+
+    auto run = [&]() {
+        {
+            Z3Y_PROFILE_ROOT("Bench_Compensation", 1, 0.0);  // period = 1：每次都输出
+            OpScope(g_measured_ops / 10);
+        }
+        profiler->FlushReports();
+        return sink->Take();
+    };
+
+    SetConfig("System.Profiler.OverheadCompensation", false);
+    const ProfileReport raw = run();
+    SetConfig("System.Profiler.OverheadCompensation", true);
+    const ProfileReport compensated = run();
+    profiler->RemoveReportSink(sink);
+
+    std::cout << std::fixed << std::setprecision(1)
+        << "标定结果: 父节点开销 " << compensated.probe_overhead_ns << " ns/探针, 自身开销 "
+        << compensated.probe_self_ns << " ns/探针\n"
+        << "空作用域 OpScope 报告平均耗时: 补偿前 " << ReportedScopeNs(raw) << " ns, 补偿后 "
+        << ReportedScopeNs(compensated) << " ns\n"
+        << "ROOT 报告总耗时: 补偿前 " << std::setprecision(3) << raw.root_ms << " ms, 补偿后 "
+        << compensated.root_ms << " ms" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+#ifdef _WIN32
+    system("chcp 65001 > nul");
+#endif
+    if (argc > 1) {
+        int ops = std::atoi(argv[1]);
+        if (ops > 0) g_measured_ops = ops;
+    }
+
+    try {
+        std::cout << "tool_profiler_benchmark: ops=" << g_measured_ops
+            << ", hardware threads=" << std::thread::hardware_concurrency() << std::endl;
+        auto manager = z3y::PluginManager::Create();
+
+        RunBaseline();
+        RunInactiveBenchmark("1. 服务缺失 (未加载 plugin_profiler)");
+
+        const std::filesystem::path exe_dir = GetExePath().parent_path();
+        if (!LoadProfilerPlugins(manager, exe_dir)) {
+            std::cerr << "[Fatal] 在 " << z3y::utils::PathToUtf8(exe_dir) << " 中找不到 plugin_profiler" << std::endl;
+            return 1;
+        }
+        auto profiler = z3y::GetDefaultService<IProfilerService>();
+
+        SetConfig("System.Profiler.Enable", false);
+        RunInactiveBenchmark("2. 配置关闭 (System.Profiler.Enable = false)");
+        SetConfig("System.Profiler.Enable", true);
+
+        RunColdBenchmark();
+        RunHotBenchmark();
+        RunContentionBenchmark();
+        RunCompensationReport(profiler);
+
+        PrintSeparator("Shutting Down");
+        z3y::interfaces::profiler::ResetProfilerCache();
+        profiler->Shutdown();
+        profiler.reset();
+        manager->UnloadAllPlugins();
+        manager.reset();
+        z3y::PluginManager::Destroy();
+        std::cout << "[Exit] 测试结束。" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "[Fatal Exception] " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,282 @@
+﻿/*
+* Copyright [2025] [Yue Liu]
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/**
+ * @file main.cpp
+ * @brief 服务定位 API 的 ns/op 与多线程扩展曲线压测工具
+ * @details
+ * [测试覆盖] 每项在 1 / 2 / 4 / 8 / 16 / 32 / 64 个线程下测量：
+ * 1. GetService<T>(ClassId) 与 GetService<T>(Alias) (constexpr 别名，哈希已预先算好)
+ * 2. GetDefaultService<T>()，以及作为对照的 ServiceHandle<T>::TryGet() (线程本地缓存)
+ * 3. TryGetDefaultService<T>()：没有任何实现的接口 (未命中路径)
+ * 4. CreateInstance<T>(ClassId)：瞬态组件，含构造与析构
+ * 5. PluginCast：组件实现 1 / 4 / 16 个接口，转换到第一个与最后一个接口
+ * 6. PluginManager::GetActiveInstance()
+ *
+ * 表中数值为每个线程看到的 ns/op (墙钟时间 / 每线程操作数)：完美扩展时各列相同，
+ * 数值随线程数上升说明存在共享争用 (锁、共享引用计数)。线程数超过 CPU 数时的列同时包含调度开销。
+ * 被测组件直接在工具内定义，通过 IPluginRegistry 手动注册，不需要加载插件。
+ *
+ * 用法: tool_service_benchmark [ops]   (ops 为每个线程的操作数，缺省为 200000；CreateInstance 取 1/10)
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "framework/z3y_define_impl.h"
+#include "framework/z3y_framework.h"
+
+// --- 被测接口与组件 ---
+namespace bench {
+
+/** @brief 生成一个只有一个纯虚函数的接口 IBench<N>。 */
+#define Z3Y_BENCH_INTERFACE(N)                                                    \
+    class IBench##N : public virtual z3y::IComponent {                            \
+    public:                                                                       \
+        Z3Y_DEFINE_INTERFACE(IBench##N, "z3y-bench-IBench" #N "-IID", 1, 0);      \
+        virtual int Value##N() const = 0;                                         \
+    };
+    Z3Y_BENCH_INTERFACE(0) Z3Y_BENCH_INTERFACE(1) Z3Y_BENCH_INTERFACE(2) Z3Y_BENCH_INTERFACE(3)
+    Z3Y_BENCH_INTERFACE(4) Z3Y_BENCH_INTERFACE(5) Z3Y_BENCH_INTERFACE(6) Z3Y_BENCH_INTERFACE(7)
+    Z3Y_BENCH_INTERFACE(8) Z3Y_BENCH_INTERFACE(9) Z3Y_BENCH_INTERFACE(10) Z3Y_BENCH_INTERFACE(11)
+    Z3Y_BENCH_INTERFACE(12) Z3Y_BENCH_INTERFACE(13) Z3Y_BENCH_INTERFACE(14) Z3Y_BENCH_INTERFACE(15)
+#undef Z3Y_BENCH_INTERFACE
+
+    /** @brief 没有任何实现的接口，用于测量未命中路径。 */
+    class IBenchMissing : public virtual z3y::IComponent {
+    public:
+        Z3Y_DEFINE_INTERFACE(IBenchMissing, "z3y-bench-IBenchMissing-IID", 1, 0);
+    };
+
+#define Z3Y_BENCH_VALUE(N) int Value##N() const override { return N; }
+
+    class BenchService : public z3y::PluginImpl<BenchService, IBench0> {
+    public:
+        Z3Y_DEFINE_COMPONENT_ID("z3y-bench-BenchService-UUID");
+        Z3Y_BENCH_VALUE(0)
+    };
+
+    class BenchComponent : public z3y::PluginImpl<BenchComponent, IBench1> {
+    public:
+        Z3Y_DEFINE_COMPONENT_ID("z3y-bench-BenchComponent-UUID");
+        Z3Y_BENCH_VALUE(1)
+    };
+
+    class Cast1 : public z3y::PluginImpl<Cast1, IBench0> {
+    public:
+        Z3Y_DEFINE_COMPONENT_ID("z3y-bench-Cast1-UUID");
+        Z3Y_BENCH_VALUE(0)
+    };
+
+    class Cast4 : public z3y::PluginImpl<Cast4, IBench0, IBench1, IBench2, IBench3> {
+    public:
+        Z3Y_DEFINE_COMPONENT_ID("z3y-bench-Cast4-UUID");
+        Z3Y_BENCH_VALUE(0) Z3Y_BENCH_VALUE(1) Z3Y_BENCH_VALUE(2) Z3Y_BENCH_VALUE(3)
+    };
+
+    class Cast16 : public z3y::PluginImpl<Cast16, IBench0, IBench1, IBench2, IBench3, IBench4, IBench5, IBench6,
+        IBench7, IBench8, IBench9, IBench10, IBench11, IBench12, IBench13, IBench14, IBench15> {
+    public:
+        Z3Y_DEFINE_COMPONENT_ID("z3y-bench-Cast16-UUID");
+        Z3Y_BENCH_VALUE(0) Z3Y_BENCH_VALUE(1) Z3Y_BENCH_VALUE(2) Z3Y_BENCH_VALUE(3)
+        Z3Y_BENCH_VALUE(4) Z3Y_BENCH_VALUE(5) Z3Y_BENCH_VALUE(6) Z3Y_BENCH_VALUE(7)
+        Z3Y_BENCH_VALUE(8) Z3Y_BENCH_VALUE(9) Z3Y_BENCH_VALUE(10) Z3Y_BENCH_VALUE(11)
+        Z3Y_BENCH_VALUE(12) Z3Y_BENCH_VALUE(13) Z3Y_BENCH_VALUE(14) Z3Y_BENCH_VALUE(15)
+    };
+#undef Z3Y_BENCH_VALUE
+
+    constexpr z3y::Alias kServiceAlias{ "Bench.Service" };
+
+}  // namespace bench
+
+// --- 压测参数配置 ---
+int g_ops_per_thread = 200000;  // 可由命令行覆盖
+const int kThreadCounts[] = { 1, 2, 4, 8, 16, 32, 64 };
+
+using Clock = std::chrono::steady_clock;
+
+/** @brief 防止编译器把被测调用的结果优化掉。 */
+std::atomic<uintptr_t> g_sink{ 0 };
+
+void PrintSeparator(const std::string& title) {
+    std::cout << "\n=============================================================\n"
+        << " " << title << "\n"
+        << "=============================================================" << std::endl;
+}
+
+/**
+ * @brief 用 thread_count 个线程并发执行 ops_per_thread 次 op()。
+ * @return 每个线程看到的 ns/op (墙钟时间 / ops_per_thread)。
+ */
+template <typename Op>
+double MeasureScaling(int thread_count, int ops_per_thread, const Op& op) {
+    std::atomic<int> ready{ 0 };
+    std::atomic<bool> go{ false };
+    std::vector<std::thread> threads;
+    threads.reserve(thread_count);
+    for (int t = 0; t < thread_count; ++t) {
+        threads.emplace_back([&] {
+            uintptr_t local = 0;
+            for (int i = 0; i < 1000; ++i) local += op();  // 预热 (含线程本地缓存)
+            ready.fetch_add(1);
+            while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+            for (int i = 0; i < ops_per_thread; ++i) local += op();
+            g_sink.fetch_add(local, std::memory_order_relaxed);
+            });
+    }
+    while (ready.load() != thread_count) std::this_thread::yield();
+
+    auto start_time = Clock::now();
+    go.store(true, std::memory_order_release);
+    for (auto& t : threads) t.join();
+    auto end_time = Clock::now();
+    return std::chrono::duration<double, std::nano>(end_time - start_time).count() / ops_per_thread;
+}
+
+void PrintHeader() {
+    std::cout << std::left << std::setw(36) << "ns/op per thread  (threads ->)" << std::right;
+    for (int threads : kThreadCounts) std::cout << std::setw(9) << threads;
+    std::cout << std::endl;
+}
+
+/** @brief 测一行：op 返回任意整数 (通常是取到的指针值)。 */
+template <typename Op>
+void RunRow(const std::string& label, int ops_per_thread, const Op& op) {
+    std::cout << std::left << std::setw(36) << label << std::right << std::fixed << std::setprecision(1)
+        << std::flush;
+    for (int threads : kThreadCounts) {
+        std::cout << std::setw(9) << MeasureScaling(threads, ops_per_thread, op) << std::flush;
+    }
+    std::cout << std::endl;
+}
+
+template <typename T>
+uintptr_t Addr(const z3y::PluginPtr<T>& p) {
+    return reinterpret_cast<uintptr_t>(p.get());
+}
+
+// =============================================================================
+// 1. 服务查找
+// =============================================================================
+void RunLookupBenchmark() {
+    PrintSeparator("1. 服务查找: GetService / GetDefaultService / 未命中");
+    PrintHeader();
+    const int ops = g_ops_per_thread;
+    RunRow("GetService(ClassId)", ops, [] {
+        return Addr(z3y::GetService<bench::IBench0>(bench::BenchService::kClsid));
+        });
+    RunRow("GetService(Alias)", ops, [] {
+        return Addr(z3y::GetService<bench::IBench0>(bench::kServiceAlias));
+        });
+    RunRow("GetDefaultService", ops, [] {
+        return Addr(z3y::GetDefaultService<bench::IBench0>());
+        });
+    RunRow("ServiceHandle::TryGet (baseline)", ops, [] {
+        return reinterpret_cast<uintptr_t>(z3y::ServiceHandle<bench::IBench0>::TryGet());
+        });
+    RunRow("TryGetDefaultService (missing)", ops, [] {
+        auto [service, err] = z3y::TryGetDefaultService<bench::IBenchMissing>();
+        return Addr(service) + static_cast<uintptr_t>(err);
+        });
+}
+
+// =============================================================================
+// 2. 瞬态组件创建
+// =============================================================================
+void RunCreateBenchmark() {
+    PrintSeparator("2. CreateInstance(ClassId): 构造 + 析构");
+    PrintHeader();
+    RunRow("CreateInstance(ClassId)", std::max(1000, g_ops_per_thread / 10), [] {
+        return Addr(z3y::CreateInstance<bench::IBench1>(bench::BenchComponent::kClsid));
+        });
+}
+
+// =============================================================================
+// 3. PluginCast
+// =============================================================================
+template <typename TImpl, typename TLast>
+void RunCastRows(const std::string& label) {
+    // 所有线程转换同一个对象：同时反映共享控制块引用计数的争用
+    const z3y::PluginPtr<z3y::IComponent> object = std::make_shared<TImpl>();
+    RunRow(label + " -> first", g_ops_per_thread, [&object] {
+        z3y::InstanceError err;
+        return Addr(z3y::PluginCast<bench::IBench0>(object, err));
+        });
+    RunRow(label + " -> last", g_ops_per_thread, [&object] {
+        z3y::InstanceError err;
+        return Addr(z3y::PluginCast<TLast>(object, err));
+        });
+    RunRow(label + " -> last (NoRef)", g_ops_per_thread, [&object] {
+        z3y::InstanceError err;
+        return reinterpret_cast<uintptr_t>(z3y::PluginCastNoRef<TLast>(object.get(), err));
+        });
+}
+
+void RunCastBenchmark() {
+    PrintSeparator("3. PluginCast: 组件实现的接口数量");
+    PrintHeader();
+    RunCastRows<bench::Cast1, bench::IBench0>("1 interface");
+    RunCastRows<bench::Cast4, bench::IBench3>("4 interfaces");
+    RunCastRows<bench::Cast16, bench::IBench15>("16 interfaces");
+}
+
+// =============================================================================
+// 4. GetActiveInstance
+// =============================================================================
+void RunActiveInstanceBenchmark() {
+    PrintSeparator("4. PluginManager::GetActiveInstance");
+    PrintHeader();
+    RunRow("GetActiveInstance", g_ops_per_thread, [] {
+        return Addr(z3y::PluginManager::GetActiveInstance());
+        });
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1) {
+        g_ops_per_thread = std::max(1000, std::atoi(argv[1]));
+    }
+    std::cout << "tool_service_benchmark: " << g_ops_per_thread << " ops per thread, "
+        << std::thread::hardware_concurrency() << " hardware threads" << std::endl;
+
+    try {
+        auto manager = z3y::PluginManager::Create();
+        auto* registry = static_cast<z3y::IPluginRegistry*>(manager.get());
+        z3y::RegisterService<bench::BenchService>(registry, "Bench.Service", true);
+        z3y::RegisterComponent<bench::BenchComponent>(registry, "Bench.Component", true);
+
+        RunLookupBenchmark();
+        RunCreateBenchmark();
+        RunCastBenchmark();
+        RunActiveInstanceBenchmark();
+
+        manager->UnloadAllPlugins();
+        manager.reset();
+        z3y::PluginManager::Destroy();
+    } catch (const std::exception& e) {
+        std::cerr << "[Fatal Exception] " << e.what() << std::endl;
+        return 1;
+    }
+    std::cout << "\n(checksum " << g_sink.load() % 1000 << ")" << std::endl;
+    return 0;
+}
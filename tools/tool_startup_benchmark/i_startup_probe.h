@@ -0,0 +1,48 @@
+﻿/*
+* Copyright [2025] [Yue Liu]
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/**
+ * @file i_startup_probe.h
+ * @brief tool_startup_benchmark 合成插件实现的接口。
+ */
+
+#pragma once
+
+#ifndef Z3Y_TOOLS_STARTUP_BENCHMARK_I_STARTUP_PROBE_H_
+#define Z3Y_TOOLS_STARTUP_BENCHMARK_I_STARTUP_PROBE_H_
+
+#include <cstdint>
+#include "framework/z3y_define_interface.h"
+
+namespace z3y {
+    namespace startup_bench {
+
+        /**
+         * @class IStartupProbe
+         * @brief 合成服务：只返回编号，用于确认 GetService 拿到的是目标插件里的实现。
+         */
+        class IStartupProbe : public virtual IComponent {
+        public:
+            Z3Y_DEFINE_INTERFACE(IStartupProbe, "z3y-tools-IStartupProbe-IID-5B7C0001", 1, 0);
+
+            /** @brief 插件编号 * 65536 + 服务编号。 */
+            virtual uint32_t GetProbeId() const = 0;
+        };
+
+    }  // namespace startup_bench
+}  // namespace z3y
+
+#endif  // Z3Y_TOOLS_STARTUP_BENCHMARK_I_STARTUP_PROBE_H_
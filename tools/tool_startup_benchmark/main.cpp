@@ -0,0 +1,254 @@
+﻿/*
+* Copyright [2025] [Yue Liu]
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/**
+ * @file main.cpp
+ * @brief 框架冷启动压测工具
+ * @details
+ * 构建时生成 N 个合成插件 (每个注册 M 个实现 IStartupProbe 的服务，见本目录 CMakeLists.txt)。
+ * 每一轮在同一进程内完整走一遍宿主的启动 / 退出路径并计时：
+ * 1. `PluginManager::Create`
+ * 2. `LoadPluginsFromDirectory`，并从 `GetStartupReport` 拆出 dlopen、注册 (入口函数 + 提交)
+ *    与注册事件各自的累计耗时
+ * 3. 首次 `GetService`：第一个插件的第一个服务，以及逐个插件各取一个服务的总耗时
+ * 4. `UnloadAllPlugins`，以及 `Destroy`
+ *
+ * 四种模式分别测量：串行 / 并行加载 × 是否启用插件清单缓存 (`SetPluginManifestCache`)。
+ * 清单缓存模式先跑一轮不计时的预热写出缓存，之后的轮次命中缓存：加载阶段只登记延迟条目，
+ * 库在首次 `GetService` 时才真正加载，因此这部分耗时会转移到首次 GetService 上。
+ * 同一进程内反复 dlopen 时文件已在页缓存中，测到的是“热盘”冷启动。
+ *
+ * 结果以 JSON 写到标准输出 (或 `--out` 指定的文件)，进度写到标准错误。
+ *
+ * 用法: tool_startup_benchmark [--rounds=<N>] [--threads=<N>] [--plugins=<目录>] [--out=<文件>]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "common/cli_args.h"
+#include "framework/z3y_framework.h"
+#include "i_startup_probe.h"
+
+namespace {
+
+    using z3y::tools::ForEachArgument;
+    using z3y::tools::StartsWith;
+
+    using Clock = std::chrono::steady_clock;
+    using z3y::startup_bench::IStartupProbe;
+
+    struct Arguments {
+        uint32_t rounds = 5;
+        size_t threads = 0;  ///< 并行模式的线程数，0 为 hardware_concurrency
+        std::string plugins = Z3Y_STARTUP_BENCH_PLUGIN_DIR;
+        std::string out;
+    };
+
+    void PrintUsage() {
+        std::cerr << "Usage: tool_startup_benchmark [--rounds=<N>] [--threads=<N>] [--plugins=<dir>] [--out=<file>]"
+            << std::endl;
+    }
+
+    bool ParseArguments(int argc, char* argv[], Arguments& args) {
+        return ForEachArgument(argc, argv, [&args](const std::string& arg) {
+            std::string value;
+            if (StartsWith(arg, "--rounds=", value)) {
+                args.rounds = static_cast<uint32_t>(std::max(1, std::atoi(value.c_str())));
+            } else if (StartsWith(arg, "--threads=", value)) {
+                args.threads = static_cast<size_t>(std::max(0, std::atoi(value.c_str())));
+            } else if (StartsWith(arg, "--plugins=", value)) {
+                args.plugins = value;
+            } else if (StartsWith(arg, "--out=", value)) {
+                args.out = value;
+            } else {
+                return false;
+            }
+            return true;
+        });
+    }
+
+    double MsSince(Clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    struct Mode {
+        const char* name;
+        size_t threads;
+        bool manifest_cache;
+    };
+
+    /** @brief 一轮的测量结果：指标名 -> 毫秒。 */
+    struct Round {
+        std::map<std::string, double> ms;
+        size_t loaded = 0;
+        size_t deferred = 0;
+        size_t failures = 0;
+        size_t probe_errors = 0;  ///< GetService 失败或拿到的编号不对
+    };
+
+    Round RunRound(const Arguments& args, const Mode& mode, const std::filesystem::path& cache_file) {
+        Round round;
+        auto start = Clock::now();
+        auto manager = z3y::PluginManager::Create();
+        round.ms["create"] = MsSince(start);
+        if (mode.manifest_cache) manager->SetPluginManifestCache(cache_file);
+
+        start = Clock::now();
+        const auto failures = manager->LoadPluginsFromDirectory(args.plugins, false, "z3yPluginInit", mode.threads);
+        round.ms["load_directory"] = MsSince(start);
+        round.failures = failures.size();
+        for (const auto& failure : failures) std::cerr << "[plugin] " << failure << std::endl;
+
+        uint64_t library_ns = 0, registration_ns = 0, event_ns = 0;
+        auto query = manager->GetService<z3y::IPluginQuery>(z3y::clsid::kPluginQuery);
+        for (const z3y::PluginLoadTiming& t : query->GetStartupReport().plugins) {
+            if (!t.success) continue;
+            ++round.loaded;
+            if (t.deferred) ++round.deferred;
+            library_ns += t.load_library_ns;
+            registration_ns += t.entry_point_ns + t.commit_ns;
+            event_ns += t.event_ns;
+        }
+        round.ms["load_library_sum"] = library_ns / 1e6;
+        round.ms["registration_sum"] = registration_ns / 1e6;
+        round.ms["register_events_sum"] = event_ns / 1e6;
+        query.reset();
+
+        // 首次 GetService：第一个插件单独计时，其余插件各取一个服务累计
+        const auto probe = [&](uint32_t plugin) {
+            const std::string alias = "StartupBench.P" + std::to_string(plugin) + ".C0";
+            z3y::InstanceError err = z3y::InstanceError::kSuccess;
+            auto service = manager->TryGetService<IStartupProbe>(z3y::Alias(alias), err);
+            if (!service || service->GetProbeId() != plugin * 65536u) ++round.probe_errors;
+        };
+        start = Clock::now();
+        probe(0);
+        round.ms["first_get_service"] = MsSince(start);
+        start = Clock::now();
+        for (uint32_t p = 1; p < Z3Y_STARTUP_BENCH_PLUGINS; ++p) probe(p);
+        round.ms["first_get_service_rest"] = MsSince(start);
+
+        start = Clock::now();
+        manager->UnloadAllPlugins();
+        round.ms["unload_all"] = MsSince(start);
+
+        start = Clock::now();
+        manager.reset();
+        z3y::PluginManager::Destroy();
+        round.ms["destroy"] = MsSince(start);
+        return round;
+    }
+
+    nlohmann::json Summarize(std::vector<double> values) {
+        std::sort(values.begin(), values.end());
+        double sum = 0.0;
+        for (double v : values) sum += v;
+        const size_t n = values.size();
+        const double median = n % 2 ? values[n / 2] : (values[n / 2 - 1] + values[n / 2]) / 2.0;
+        return { { "min", values.front() }, { "median", median }, { "mean", sum / n }, { "max", values.back() } };
+    }
+
+    nlohmann::json RunMode(const Arguments& args, const Mode& mode) {
+        const std::filesystem::path cache_file =
+            std::filesystem::temp_directory_path() / "z3y_startup_bench_manifest.json";
+        std::error_code ec;
+        std::filesystem::remove(cache_file, ec);
+        if (mode.manifest_cache) {
+            std::cerr << "[" << mode.name << "] priming manifest cache" << std::endl;
+            RunRound(args, mode, cache_file);
+        }
+
+        std::vector<Round> rounds;
+        for (uint32_t r = 0; r < args.rounds; ++r) {
+            rounds.push_back(RunRound(args, mode, cache_file));
+            std::cerr << "[" << mode.name << "] round " << r + 1 << "/" << args.rounds
+                << ": load_directory " << rounds.back().ms["load_directory"] << " ms" << std::endl;
+        }
+        std::filesystem::remove(cache_file, ec);
+
+        nlohmann::json metrics = nlohmann::json::object();
+        for (const auto& entry : rounds.front().ms) {
+            std::vector<double> values;
+            for (const Round& round : rounds) values.push_back(round.ms.at(entry.first));
+            metrics[entry.first + "_ms"] = Summarize(std::move(values));
+        }
+        const Round& last = rounds.back();
+        return {
+            { "name", mode.name },
+            { "threads", mode.threads },
+            { "manifest_cache", mode.manifest_cache },
+            { "plugins_loaded", last.loaded },
+            { "plugins_deferred", last.deferred },
+            { "load_failures", last.failures },
+            { "probe_errors", last.probe_errors },
+            { "metrics", metrics },
+        };
+    }
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    Arguments args;
+    if (!ParseArguments(argc, argv, args)) {
+        PrintUsage();
+        return 2;
+    }
+    try {
+        const size_t parallel = args.threads ? args.threads : std::max(1u, std::thread::hardware_concurrency());
+        const Mode modes[] = {
+            { "serial", 1, false },
+            { "parallel", parallel, false },
+            { "serial+manifest_cache", 1, true },
+            { "parallel+manifest_cache", parallel, true },
+        };
+        nlohmann::json result = {
+            { "plugin_dir", args.plugins },
+            { "plugins", Z3Y_STARTUP_BENCH_PLUGINS },
+            { "components_per_plugin", Z3Y_STARTUP_BENCH_COMPONENTS },
+            { "rounds", args.rounds },
+            { "modes", nlohmann::json::array() },
+        };
+        bool ok = true;
+        for (const Mode& mode : modes) {
+            nlohmann::json m = RunMode(args, mode);
+            ok = ok && m["load_failures"] == 0 && m["probe_errors"] == 0;
+            result["modes"].push_back(std::move(m));
+        }
+
+        if (args.out.empty()) {
+            std::cout << result.dump(2) << std::endl;
+        } else {
+            std::ofstream out(args.out);
+            out << result.dump(2) << std::endl;
+        }
+        return ok ? 0 : 1;
+    } catch (const std::exception& e) {
+        std::cerr << "[Fatal Exception] " << e.what() << std::endl;
+        return 1;
+    }
+}